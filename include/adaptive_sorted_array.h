@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "sorted_array.h"
+
+// Sorted set of unique IDs, stored either as a FOR compressed `sorted_array` or, when the IDs are dense enough for
+// it to be smaller, as a bitmap. The representation is re-evaluated as IDs are added and removed, so dense sets
+// (e.g. the IDs of a boolean value matching a large part of a collection) get O(1) membership and inserts.
+class adaptive_sorted_array {
+private:
+    sorted_array array;
+
+    // bit `i` of the bitmap represents the ID `base + i`; `base` is always a multiple of 64
+    uint64_t* words = nullptr;
+    uint32_t num_words = 0;
+    uint32_t base = 0;
+    uint32_t bitmap_length = 0;
+    bool is_bitmap = false;
+
+    static size_t array_size_bytes(uint32_t length, uint32_t min, uint32_t max);
+
+    static size_t bitmap_size_bytes(uint32_t min, uint32_t max);
+
+    void load_bitmap(const uint32_t* sorted_ids, uint32_t length);
+
+    void free_bitmap();
+
+    void grow_bitmap(uint32_t value);
+
+    void adapt();
+
+    uint32_t bitmap_min() const;
+
+    uint32_t bitmap_max() const;
+
+    uint32_t bitmap_rank(uint32_t value) const;
+
+public:
+    // sets smaller than this are always stored as arrays, to avoid flipping between the representations
+    static constexpr uint32_t MIN_BITMAP_LENGTH = 64;
+
+    adaptive_sorted_array() = default;
+
+    ~adaptive_sorted_array();
+
+    void load(const uint32_t* sorted_ids, uint32_t length);
+
+    uint32_t at(uint32_t index);
+
+    uint32_t last();
+
+    bool contains(uint32_t value);
+
+    uint32_t indexOf(uint32_t value);
+
+    // returns the index at which the value was inserted
+    size_t append(uint32_t value);
+
+    void remove_value(uint32_t value);
+
+    // len determines length of output buffer (default: length of input)
+    uint32_t* uncompress(uint32_t len = 0) const;
+
+    uint32_t getLength() const;
+
+    uint32_t getSizeInBytes();
+
+    bool bitmap() const {
+        return is_bitmap;
+    }
+};
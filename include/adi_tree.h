@@ -1,5 +1,8 @@
 #pragma once
+#include <atomic>
+#include <mutex>
 #include <string>
+#include <vector>
 #include "sparsepp.h"
 
 struct adi_node_t;
@@ -11,6 +14,15 @@ private:
     spp::sparse_hash_map<uint32_t, std::string> id_keys;
     adi_node_t* root = nullptr;
 
+    // Rank of every id, indexed by the id (0 when not indexed), so that sorting on a string costs an array lookup
+    // instead of a walk down the tree. The array is dropped on every write and rebuilt only once as many ranks have
+    // been asked for since the last write as there are keys, so that interleaved writes cost at most twice as many
+    // walks. Ranks are looked up concurrently, but never while the tree is written to.
+    std::vector<uint32_t> id_ranks;
+    std::atomic<bool> id_ranks_valid = false;
+    std::atomic<size_t> stale_rank_lookups = 0;
+    std::mutex id_ranks_mutex;
+
     static void add_node(adi_node_t* node, const std::string& key, size_t key_index);
 
     static bool rank_aggregate(adi_node_t* node, const std::string& key, size_t key_index, size_t& rank);
@@ -20,6 +32,12 @@ private:
 
     void remove_node(adi_node_t* node, const std::string& key, const size_t key_index);
 
+    size_t walk_rank(uint32_t id);
+
+    void invalidate_ranks();
+
+    void build_ranks();
+
 public:
     static constexpr size_t NOT_FOUND = INT64_MAX;
 
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Limits the number of searches that are queued or running at the same time. Searches beyond the limit are rejected
+// up front, instead of waiting in the thread pool queue until they time out.
+//
+// The limit adapts to the latency of the searches, in the style of the gradient concurrency limits: it grows while the
+// smoothed latency stays within a tolerance of the lowest recent latency, and shrinks once searches start queueing up
+// and the smoothed latency moves away from it. Searches of a high priority are allowed beyond the limit, up to
+// `HIGH_PRIORITY_HEADROOM` times the limit.
+class AdmissionController {
+private:
+    mutable std::mutex mutex;
+
+    std::atomic<bool> enabled = false;
+    std::atomic<size_t> in_flight = 0;
+    std::atomic<size_t> limit = 0;
+
+    size_t min_limit = 0;
+    size_t max_limit = 0;
+
+    // fractional limit, so that small adjustments accumulate
+    double estimated_limit = 0;
+
+    // latencies in microseconds
+    double smoothed_latency_us = 0;
+    double min_latency_us = 0;
+    size_t num_samples = 0;
+
+    AdmissionController() {}
+
+    ~AdmissionController() {}
+
+public:
+
+    // smoothed latency can be this many times the lowest latency before the limit is reduced
+    static constexpr double LATENCY_TOLERANCE = 2.0;
+
+    // weight of a new sample on the smoothed latency
+    static constexpr double LATENCY_SMOOTHING = 0.1;
+
+    // weight of a new limit on the limit
+    static constexpr double LIMIT_SMOOTHING = 0.2;
+
+    // the lowest latency is forgotten after these many samples, so that it follows changes in the workload
+    static constexpr size_t MIN_LATENCY_WINDOW = 1000;
+
+    static constexpr double HIGH_PRIORITY_HEADROOM = 2.0;
+
+    static AdmissionController& get_instance() {
+        static AdmissionController instance;
+        return instance;
+    }
+
+    AdmissionController(AdmissionController const&) = delete;
+
+    void operator=(AdmissionController const&) = delete;
+
+    // starts admission control with a limit of `min_limit`, which then adapts within [min_limit, max_limit]
+    void init(size_t min_limit, size_t max_limit);
+
+    void disable();
+
+    bool is_enabled() const;
+
+    // Returns true when the search is admitted, in which case `release()` must be called once it completes.
+    bool try_admit(bool high_priority);
+
+    void release(uint64_t latency_us);
+
+    size_t get_limit() const;
+
+    size_t get_in_flight() const;
+
+    // seconds after which a rejected search can be retried
+    uint32_t get_retry_after_s() const;
+
+    // searches in flight, as a percentage of the limit, 0 when admission control is disabled
+    size_t get_load_percent() const;
+
+    static constexpr size_t NUM_DEGRADATION_LEVELS = 4;
+
+    // Returns how many steps of the degradation ladder a search should take, up to `NUM_DEGRADATION_LEVELS`. The
+    // steps are spread evenly over loads from `threshold_percent` to 100%. A search that has already spent half of its
+    // cutoff time waiting takes all of them.
+    static size_t get_degradation_level(size_t load_percent, size_t threshold_percent,
+                                        uint64_t waited_ms, uint64_t search_cutoff_ms);
+};
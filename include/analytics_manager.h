@@ -6,6 +6,8 @@
 #include <string>
 #include <unordered_map>
 #include <shared_mutex>
+#include <array>
+#include <thread>
 #include "lru/lru.hpp"
 
 struct event_type_collection {
@@ -106,6 +108,7 @@ private:
         size_t limit;
         std::string rule_type;
         bool expand_query = false;
+        bool top_k_sketch = false;
         nlohmann::json events;
         std::string counter_field;
 
@@ -121,6 +124,10 @@ private:
                 obj["params"]["expand_query"] = expand_query;
             }
 
+            if(top_k_sketch) {
+                obj["params"]["top_k_sketch"] = top_k_sketch;
+            }
+
             if(!events.empty()) {
                 obj["params"]["source"]["events"] = events;
                 obj["params"]["destination"]["counter_field"] = counter_field;
@@ -152,6 +159,36 @@ private:
     // per_ip cache for rate limiting
     LRU::Cache<std::string, event_cache_t> events_cache;
 
+    // a search query to be aggregated as a popular or a no hits query
+    struct query_event_t {
+        std::string query_collection;
+        std::string query;
+        std::string expanded_query;
+        bool live_query;
+        std::string user_id;
+        uint64_t timestamp_us;
+        bool nohits;
+    };
+
+    // Queries of searches are buffered in shards, picked by the thread of the search, so that searches do not wait on
+    // `mutex`. They are aggregated by the `run()` loop, or when the aggregations are read.
+    struct query_events_shard_t {
+        std::mutex mutex;
+        std::vector<query_event_t> events;
+    };
+
+    static constexpr size_t NUM_QUERY_EVENT_SHARDS = 16;
+
+    // queries beyond these many per shard are dropped until the shard is aggregated
+    static constexpr size_t MAX_QUERY_EVENTS_PER_SHARD = 64 * 1024;
+
+    std::array<query_events_shard_t, NUM_QUERY_EVENT_SHARDS> query_event_shards;
+
+    void buffer_query_event(query_event_t&& query_event);
+
+    // lock is held by caller
+    void aggregate_query_events();
+
     Store* store = nullptr;
     std::ofstream  analytics_logs;
 
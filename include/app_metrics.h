@@ -4,6 +4,9 @@
 #include "json.hpp"
 #include "logger.h"
 #include "tsconfig.h"
+#include "latency_histogram.h"
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <shared_mutex>
@@ -25,6 +28,25 @@ private:
     std::string access_log_path;
     std::ofstream access_log;
 
+    // written by every http event loop
+    std::mutex access_log_mutex;
+
+    struct latency_series_t {
+        latency_histogram_t histogram;
+
+        // bucket counts of the histogram at the start of the current window and within the last complete window
+        std::vector<uint64_t> window_start_counts;
+        std::vector<uint64_t> last_window_counts;
+    };
+
+    // guards the map below, while the histograms themselves are updated without locking
+    mutable std::shared_mutex latency_mutex;
+
+    // label => collection name => series. The series of a label across all collections has an empty collection name.
+    std::map<std::string, std::map<std::string, std::unique_ptr<latency_series_t>>> latency_series;
+
+    latency_series_t* get_latency_series(const std::string& label, const std::string& collection);
+
     AppMetrics() {
         current_counts = new spp::sparse_hash_map<std::string, uint64_t>();
         counts = new spp::sparse_hash_map<std::string, uint64_t>();
@@ -52,6 +74,10 @@ public:
     static inline const std::string IMPORT_LABEL = "import";
     static inline const std::string DOC_DELETE_LABEL = "delete";
     static inline const std::string OVERLOADED_LABEL = "overloaded";
+    static inline const std::string MULTI_SEARCH_LABEL = "multi_search";
+    static inline const std::string INDEX_READ_LOCK_WAIT_LABEL = "index_read_lock_wait";
+    static inline const std::string INDEX_WRITE_LOCK_WAIT_LABEL = "index_write_lock_wait";
+    static inline const std::string FORWARDED_WRITE_LABEL = "forwarded_write";
 
     static const uint64_t METRICS_REFRESH_INTERVAL_MS = 10 * 1000;
 
@@ -75,6 +101,31 @@ public:
 
     void increment_write_metrics(uint64_t route_hash, uint64_t duration);
 
+    // Records the latency in the histograms of the label, overall and for the collection (when not empty).
+    void record_latency(const std::string& label, const std::string& collection, uint64_t duration_us);
+
+    // Records the latency of search, multi search, import and document write and delete requests.
+    void record_request_latency(uint64_t route_hash, const std::string& collection, uint64_t duration_us);
+
+    // Records the time for which a search (read) or a write waited to acquire the lock of a collection's index.
+    void record_index_lock_wait(bool is_write, uint64_t wait_us) {
+        record_latency(is_write ? INDEX_WRITE_LOCK_WAIT_LABEL : INDEX_READ_LOCK_WAIT_LABEL, "", wait_us);
+    }
+
+    // Records the round trip of a write that a follower forwarded to the leader.
+    void record_forwarded_write(uint64_t duration_us) {
+        record_latency(FORWARDED_WRITE_LABEL, "", duration_us);
+    }
+
+    // Adds the latency percentiles of the last complete window.
+    void get_latency_percentiles(nlohmann::json& result) const;
+
+    // Writes the latency histograms in the Prometheus text exposition format.
+    void get_prometheus_metrics(std::string& result) const;
+
+    // Writes the depth and oldest wait of the per collection write queues in the Prometheus text exposition format.
+    static void append_write_queue_metrics(const nlohmann::json& coll_queue_stats, std::string& result);
+
     void write_access_log(const uint64_t epoch_millis, const char* remote_ip, const std::string& path);
 
     void flush_access_log();
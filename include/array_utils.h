@@ -9,14 +9,40 @@
  */
 class ArrayUtils {
 public:
+  // the `*_simd` routines look up the values of the smaller input in the larger one once it is this many times larger
+  static constexpr size_t GALLOPING_SIZE_RATIO = 32;
+
   // Fast scalar scheme designed by N. Kurz. Returns the size of out (intersected set)
   static size_t and_scalar(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t **out);
 
+  // Vectorized intersection of sorted arrays of unique values (AVX2 or SSE2 on x86, NEON through sse2neon on ARM),
+  // chosen at runtime, or by galloping when one of them is much larger. `out` must have room for min(lenA, lenB)
+  // values. Returns the size of out.
+  static size_t and_simd(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out);
+
   static size_t or_scalar(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t **out);
 
+  // Vectorized union of sorted arrays of unique values (SSE4.1 on x86, NEON through sse2neon on ARM), chosen at
+  // runtime, or by galloping when one of them is much larger. `out` must have room for lenA + lenB values. Returns
+  // the size of out.
+  static size_t or_simd(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out);
+
+  // Union of sorted arrays of unique values through a bitmap over their combined range. Faster than a merge when
+  // the values are dense. `out` must have room for lenA + lenB values. Returns the size of out.
+  static size_t or_bitmap(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out);
+
+  // Sorted values of the bits set in `words`, with the first bit standing for `base`. Allocates `out`. Returns the
+  // size of out.
+  static size_t bitmap_to_array(const uint64_t *words, const size_t num_words, const uint32_t base, uint32_t **out);
+
   static size_t exclude_scalar(const uint32_t *src, const size_t lenSrc, const uint32_t *filter, const size_t lenFilter,
                               uint32_t **out);
 
+  // Vectorized difference (A - B) of sorted arrays of unique values, or by galloping when one of them is much larger.
+  // `out` must have room for lenA values. Returns the size of out.
+  static size_t exclude_simd(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB,
+                             uint32_t *out);
+
   /// Performs binary search to find the index of id. If id is not found, curr_index is set to the index of next bigger
   /// number than id in the array.
   /// \return Whether or not id was found in array.
@@ -117,12 +117,16 @@ struct token_leaf {
     }
 };
 
+struct art_node_pool;
+
 /**
  * Main struct, points to root.
  */
 typedef struct {
     art_node *root;
     uint64_t size;
+    // the nodes and leaves of the tree are allocated from here
+    struct art_node_pool *pool;
 } art_tree;
 
 /*
@@ -199,6 +203,14 @@ void* art_insert(art_tree *t, const unsigned char *key, int key_len, art_documen
 void* art_inserts(art_tree *t, const unsigned char *key, int key_len, const int64_t docs_max_score,
                   std::vector<art_document>& documents);
 
+/**
+ * Inserts the documents of many keys at once, e.g. all the tokens of a batch of documents. Like in the rest of the
+ * index, a key is stored with its terminating \0 byte, so no key is a prefix of another. The keys are sorted in
+ * place. An empty tree is built bottom-up in a single pass, otherwise the keys are inserted in sorted order.
+ */
+void art_bulk_insert(art_tree *t, std::vector<std::pair<std::string, std::vector<art_document>>>& keys_documents,
+                     const int64_t docs_max_score);
+
 /**
  * Deletes a value from the ART tree
  * @arg t The tree
@@ -272,6 +284,66 @@ int art_fuzzy_search_i(art_tree *t, const unsigned char *term, const int term_le
                      filter_result_iterator_t* const filter_result_iterator,
                      std::vector<art_leaf *> &results, std::set<std::string>& exclude_leaves);
 
+/**
+ * Collects the top leaves of `term` from `nodes`, the nodes matched by a fuzzy traversal of the tree at costs
+ * starting from `min_cost`, as found by `art_fuzzy_search_batch`. `art_fuzzy_search_i` is a traversal followed by
+ * this call.
+ */
+int art_fuzzy_search_nodes(art_tree *t, const std::vector<const art_node*>& nodes,
+                           const unsigned char *term, const int term_len, const int min_cost,
+                           const size_t max_words, const token_ordering token_order,
+                           const bool prefix, bool last_token, const std::string& prev_token,
+                           filter_result_iterator_t* const filter_result_iterator,
+                           std::vector<art_leaf *> &results, std::set<std::string>& exclude_leaves);
+
+/**
+ * Term to be fuzzy searched by `art_fuzzy_search_batch` at every cost in [min_cost, max_cost].
+ */
+struct art_fuzzy_query_t {
+    const unsigned char* term;
+    int term_len;
+    int min_cost;
+    int max_cost;
+    bool prefix;
+};
+
+/**
+ * Fuzzy traversal of the tree for several terms and costs at once: the tree is walked once, and a subtree is only
+ * visited while at least one of the terms can still match in it. `nodes[i][cost - queries[i].min_cost]` receives
+ * the nodes that a traversal for `queries[i]` at exactly `cost` matches, to be passed to `art_fuzzy_search_nodes`.
+ */
+void art_fuzzy_search_batch(art_tree *t, const std::vector<art_fuzzy_query_t>& queries,
+                            std::vector<std::vector<std::vector<const art_node*>>>& nodes);
+
+/**
+ * Where a fuzzy prefix search stood on entering the nodes whose chars are not all a little before the end of its
+ * term: past those nodes, the walk depends on the chars at the end of the term, while up to them, it is the same
+ * for every term that the searched term is a prefix of.
+ */
+struct art_fuzzy_frontier_t {
+    struct entry_t {
+        const art_node* node;
+        // char that leads to `node`, not walked yet
+        unsigned char c;
+        // depth of the walk before `c`, -1 when `node` is the root
+        int depth;
+        // chars walked from the root up to `c`
+        std::string walked_chars;
+    };
+
+    int term_len = 0;
+    std::vector<entry_t> entries;
+};
+
+/**
+ * Fuzzy traversal of `art_fuzzy_search_i` for a prefix `term` at exactly `cost`, which also saves the `frontier` of
+ * the walk. When `prev_frontier` is given, it must have been saved by a search of a prefix of `term` at the same
+ * cost, on the tree as it is now: the walk then resumes from it instead of starting from the root.
+ */
+void art_fuzzy_search_prefix(art_tree *t, const unsigned char *term, const int term_len, const int cost,
+                             const art_fuzzy_frontier_t* prev_frontier,
+                             std::vector<const art_node*>& nodes, art_fuzzy_frontier_t& frontier);
+
 void encode_int32(int32_t n, unsigned char *chars);
 
 void encode_int64(int64_t n, unsigned char *chars);
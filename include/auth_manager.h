@@ -6,6 +6,7 @@
 #include <mutex>
 #include <shared_mutex>
 #include <tsl/htrie_map.h>
+#include "lru/lru.hpp"
 #include "json.hpp"
 #include "option.h"
 #include "store.h"
@@ -120,6 +121,22 @@ private:
 
     static std::string fmt_error(std::string&& error, const std::string& key);
 
+    // a scoped API key whose digest was verified against its parent key
+    struct verified_scoped_key_t {
+        std::string parent_key;
+        // of the scoped key, which can not outlive its parent key
+        uint64_t expires_at;
+        nlohmann::json embedded_params;
+    };
+
+    static constexpr const size_t VERIFIED_SCOPED_KEYS_CACHE_SIZE = 8192;
+
+    // Scoped keys verified before, so that a scoped key used again does not decode and verify its digest and parse
+    // its embedded params again. Cleared when a key is removed.
+    mutable std::mutex verified_scoped_keys_mutex;
+    mutable LRU::Cache<std::string, std::shared_ptr<const verified_scoped_key_t>>
+            verified_scoped_keys{VERIFIED_SCOPED_KEYS_CACHE_SIZE};
+
     Option<bool> authenticate_parse_params(const collection_key_t& scoped_api_key, const std::string& action,
                                            nlohmann::json& embedded_params) const ;
 
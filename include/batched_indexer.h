@@ -2,6 +2,7 @@
 
 #include <unordered_map>
 #include <deque>
+#include <set>
 #include "store.h"
 #include "http_data.h"
 #include "threadpool.h"
@@ -21,6 +22,26 @@ private:
         uint32_t next_chunk_index;   // index where next read must begin
         bool is_complete;           //  whether the req has been written to store fully
 
+        // collection under which the raft log index of the request is tracked till it is indexed
+        std::string watermark_coll;
+
+        // Chunks of a request of up to `queued-request-memory-max-bytes`, which are held here instead of in the store
+        // while it waits to be indexed, as the raft log already has them. Once a request is spilled to the store, all
+        // of its chunks are there.
+        std::vector<std::string> mem_chunks;
+        size_t mem_chunks_bytes = 0;
+        bool spilled = false;
+
+        // An import is indexed chunk by chunk while it is uploaded, each chunk at its own position in the log,
+        // instead of once it is complete. The chunks are indexed on a request and a response of their own, as the
+        // http thread reads the next chunk into the live request meanwhile.
+        bool streamed = false;
+        std::shared_ptr<http_req> stream_req;
+        std::shared_ptr<http_res> stream_res;
+
+        // the upload waits for the indexing to catch up before its next chunk is read
+        bool proceed_deferred = false;
+
         req_res_t(uint64_t start_ts, const std::string& prev_req_body,
                   const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res,
                   uint64_t last_updated, uint32_t num_chunks, uint32_t next_chunk_index, bool is_complete):
@@ -39,12 +60,35 @@ private:
     };
 
     struct refq_entry {
-        uint64_t queue_id;
+        std::string coll_name;
         uint64_t start_ts;
 
-        refq_entry(uint64_t qid, uint64_t sts): queue_id(qid), start_ts(sts) {
+        refq_entry(const std::string& coll_name, uint64_t sts): coll_name(coll_name), start_ts(sts) {
+
+        }
+    };
+
+    // Logical write queue of a collection. Requests of a collection are applied in order, by one worker at a time.
+    struct coll_queue_t {
+        // ID of each queued request along with the time (in microseconds) at which it was queued
+        std::deque<std::pair<uint64_t, uint64_t>> reqs;
+
+        // whether a worker thread is currently applying a request of this collection
+        bool in_service = false;
+    };
+
+    // Hands the collection back to the scheduler when the turn of a worker on it ends.
+    struct coll_turn_t {
+        BatchedIndexer& indexer;
+        const std::string coll_name;
+
+        coll_turn_t(BatchedIndexer& indexer, const std::string& coll_name): indexer(indexer), coll_name(coll_name) {
 
         }
+
+        ~coll_turn_t() {
+            indexer.end_coll_turn(coll_name);
+        }
     };
 
     HttpServer* server;
@@ -53,8 +97,13 @@ private:
 
     const size_t num_threads;
 
-    await_t* qmutuxes;
-    std::vector<std::deque<uint64_t>> queues;
+    // guards `coll_queues` and `ready_colls`
+    await_t queue_wait;
+    std::unordered_map<std::string, coll_queue_t> coll_queues;
+
+    // Collections that have queued requests and are not being served, in the order in which workers pick them up.
+    // A collection goes to the back after each turn, so that a long import can't hold back the other collections.
+    std::deque<std::string> ready_colls;
 
     std::unordered_map<std::string, std::unordered_set<std::string>> coll_to_references;
     await_t refq_wait;
@@ -70,14 +119,39 @@ private:
 
     /* ------------------------------------------------------- */
 
+    // bytes of the chunks held in memory across all the requests
+    std::atomic<size_t> mem_chunks_bytes_total = 0;
+
     std::chrono::high_resolution_clock::time_point last_gc_run;
 
+    // Raft log indices of the complete requests that are yet to be indexed, so that a read can wait for the writes
+    // that were committed before it. They are also kept per collection, as the collections are indexed in parallel:
+    // a read of one collection waits only for the writes of that collection (and for those of no collection, like
+    // alias changes), instead of for a long import into another one.
+    std::mutex indexed_mutex;
+    std::condition_variable indexed_cv;
+    std::multiset<int64_t> unindexed_log_indices;
+    std::unordered_map<std::string, std::multiset<int64_t>> unindexed_coll_log_indices;
+
+    void mark_indexed(const std::string& watermark_coll, int64_t log_index);
+
+    // whether every write of the collection up to `log_index` is indexed (`indexed_mutex` must be held)
+    bool is_indexed(const std::string& watermark_coll, int64_t log_index) const;
+
     std::atomic<bool> quit;
     std::shared_mutex pause_mutex;
 
     // Used to skip over a bad raft log entry which previously triggered a crash
     const static int64_t UNSET_SKIP_INDEX = -9999;
     std::atomic<int64_t> skip_index = UNSET_SKIP_INDEX;
+
+    // Log indices of a coalesced batch that previously triggered a crash: its writes are replayed one at a time, so
+    // that the one which crashes is marked to be skipped on its own
+    std::atomic<int64_t> replay_begin_index = UNSET_SKIP_INDEX;
+    std::atomic<int64_t> replay_end_index = UNSET_SKIP_INDEX;
+
+    // the collections are indexed in parallel, and any of their workers can move on to the next skip index
+    std::mutex skip_index_mutex;
     rocksdb::Iterator* skip_index_iter = nullptr;
     static constexpr const char* SKIP_INDICES_PREFIX = "$XP";
 
@@ -92,10 +166,64 @@ private:
     static const size_t GC_INTERVAL_SECONDS = 60;
     static const size_t GC_PRUNE_MAX_SECONDS = 3600;
 
+    // maximum number of queued single document writes that are indexed together as one batch
+    static const size_t MAX_COALESCED_REQS = 64;
+
+    // requests are spilled to the store regardless of their size once the chunks in memory add up to this
+    static const size_t MAX_MEM_CHUNKS_BYTES = 256 * 1024 * 1024;
+
+    // chunks of a streamed import that can wait to be indexed before the upload is paused
+    static const size_t STREAM_WINDOW_CHUNKS = 4;
+
     static std::string get_req_prefix_key(uint64_t req_id);
 
     static std::string get_req_suffix_key(uint64_t req_id);
 
+    // Holds the chunk of the request in memory or writes it to the store, along with the chunks held so far when
+    // the request outgrows the memory. Requires `mutex` to be held, and returns the chunks to be written to the store
+    // in `spilled_chunks`.
+    void buffer_req_chunk(req_res_t& req_res, uint32_t chunk_sequence, std::string&& chunk,
+                          std::vector<std::pair<uint32_t, std::string>>& spilled_chunks);
+
+    // Reads the chunk of the request at `next_chunk_index` into `chunk`, from memory or from `iter` over the store,
+    // which a streamed request reads without. Returns false when there are no chunks left. Requires `pause_mutex` to
+    // be held.
+    bool read_req_chunk(req_res_t& req_res, rocksdb::Iterator* iter, const std::string& req_key_prefix,
+                        std::string& chunk);
+
+    // removes what is left of the request from the store and from memory, before it is erased from `req_res_map`
+    void release_req_chunks(const req_res_t& req_res);
+
+    // Whether the request is indexed chunk by chunk as it arrives: imports, unless the collection references other
+    // collections, as such writes wait for those of the referenced collections. Requires `mutex` to be held.
+    bool is_streamable(const std::shared_ptr<http_req>& req, const std::string& coll_name);
+
+    // Moves a streamed request past the chunk that was indexed, and lets its upload go on when it was paused.
+    // Returns whether the request is complete and fully indexed, as it must not be touched after this otherwise.
+    bool end_stream_chunk(req_res_t& req_res);
+
+    // Sends the response of the request, or of the chunk of a streamed request that was indexed.
+    void send_response(req_res_t& req_res);
+
+    // Returns a key shared by the requests that can be indexed as one batch, i.e. single document writes to the same
+    // collection with the same parameters, or an empty string when the request can't be coalesced.
+    std::string get_coalesce_key(const req_res_t& req_res);
+
+    bool can_coalesce();
+
+    // Moves the requests at the front of the queue which have the given coalesce key to `req_ids`.
+    void pop_coalescable_reqs(const std::string& coll_name, const std::string& coalesce_key,
+                              std::vector<uint64_t>& req_ids);
+
+    void index_coalesced_reqs(const std::vector<uint64_t>& req_ids);
+
+    // requires `queue_wait.mcv` to be held
+    void push_coll_req(const std::string& coll_name, uint64_t req_id);
+
+    void enqueue_coll_req(const std::string& coll_name, uint64_t req_id);
+
+    void end_coll_turn(const std::string& coll_name);
+
 public:
 
     static const constexpr char* RAFT_REQ_LOG_PREFIX = "$RL_";
@@ -109,6 +237,17 @@ public:
 
     int64_t get_queued_writes();
 
+    // Waits until every request of the raft log up to `log_index` that was enqueued is indexed, for at most
+    // `timeout_ms`. The entries up to the index must have been applied already. When a collection is given, only
+    // its own requests and those of no collection are waited for.
+    bool wait_until_indexed(int64_t log_index, uint64_t timeout_ms, const std::string& collection = "");
+
+    // name under which the writes of a collection, or of an alias of it, are tracked till they are indexed
+    static std::string get_watermark_coll(const std::string& coll_name);
+
+    // Populates the depth and the wait time of the oldest request of each collection that has queued writes.
+    void get_queued_writes(nlohmann::json& coll_queue_stats);
+
     void run();
 
     void stop();
@@ -15,11 +15,13 @@ public:
     };
 
 private:
-    const static size_t REFRESH_INTERVAL_SECS = 5;
+    // The status is refreshed in the background along with the system metrics, and by a check itself only when
+    // there has been no refresh for this long, e.g. before the server runs.
+    const static size_t REFRESH_INTERVAL_SECS = 15;
     std::atomic<uint64_t> last_checked_ts = 0;
     std::mutex m;
 
-    resource_check_t resource_status = OK;
+    std::atomic<resource_check_t> resource_status = OK;
 
     cached_resource_stat_t() = default;
 
@@ -39,4 +41,7 @@ public:
     resource_check_t has_enough_resources(const std::string& data_dir_path,
                                           const int disk_used_max_percentage,
                                           const int memory_used_max_percentage);
+
+    void refresh(const std::string& data_dir_path, const int disk_used_max_percentage,
+                 const int memory_used_max_percentage);
 };
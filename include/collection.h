@@ -8,6 +8,8 @@
 #include <mutex>
 #include <condition_variable>
 #include <shared_mutex>
+#include <functional>
+#include <memory>
 #include "art.h"
 #include "index.h"
 #include "number.h"
@@ -20,6 +22,9 @@
 #include "tokenizer.h"
 #include "synonym_index.h"
 #include "vq_model_manager.h"
+#include "thread_local_vars.h"
+#include "lru/lru.hpp"
+#include "doc_id_index.h"
 
 struct doc_seq_id_t {
     uint32_t seq_id;
@@ -39,6 +44,24 @@ struct highlight_field_t {
     }
 };
 
+// Top level keys of a stored document that are decoded when the document is fetched. A key is decoded when it is a
+// prefix of one of `include_names` (or when that is empty) and is not one of `exclude_names`, mirroring `prune_doc`.
+struct doc_projection_t {
+    tsl::htrie_set<char> include_names;
+    tsl::htrie_set<char> exclude_names;
+
+    bool wants(const std::string& key) const {
+        if(!include_names.empty()) {
+            auto prefix_it = include_names.equal_prefix_range(key);
+            if(prefix_it.first == prefix_it.second) {
+                return false;
+            }
+        }
+
+        return exclude_names.count(key) == 0;
+    }
+};
+
 struct reference_pair {
     std::string collection;
     std::string field;
@@ -50,18 +73,71 @@ struct reference_pair {
     }
 };
 
+// Documents of referenced collections, keyed by collection name and sequence ID, that are fetched while the hits of a
+// search are hydrated. The cache is in effect on the current thread while it is in scope.
+struct ref_doc_cache_t {
+    std::unordered_map<std::string, std::unordered_map<uint32_t, nlohmann::json>> collection_docs;
+    ref_doc_cache_t* const parent_cache;
+
+    ref_doc_cache_t(): parent_cache(ref_doc_cache) {
+        ref_doc_cache = this;
+    }
+
+    ~ref_doc_cache_t() {
+        ref_doc_cache = parent_cache;
+    }
+};
+
 class Collection {
 private:
 
     mutable std::shared_mutex mutex;
 
+    // serializes the in-memory indexing of documents and the changes to the schema: a batch is validated and
+    // embedded with `mutex` held only in shared mode, and is then indexed with it held exclusively, as searches
+    // read the index after the index has released its own lock. So searches wait for the indexing of a batch,
+    // but not for its validation and embedding.
+    std::mutex write_mutex;
+
     // ensures that a Collection* is not destructed while in use by multiple threads
     mutable std::shared_mutex lifecycle_mutex;
 
+    // Held in shared mode by a write from its in-memory indexing to its write to the store, and exclusively by each
+    // batch of a backfill, so that a backfill reads documents from the store as they are indexed.
+    std::shared_mutex backfill_mutex;
+
+    // an alter whose new fields are indexed on the existing documents in the background
+    struct alter_backfill_t {
+        std::vector<field> fields;
+        nlohmann::json alter_payload;
+
+        // the schema with the new fields, on which writes are indexed until the fields are switched on
+        tsl::htrie_map<char, field> search_schema;
+        tsl::htrie_map<char, field> embedding_fields;
+        tsl::htrie_map<char, field> schema_additions;
+        bool has_embedding_field = false;
+
+        // documents per second, unlimited when 0
+        uint32_t rate = 0;
+        size_t num_documents = 0;
+        uint64_t started_at = 0;
+
+        std::atomic<size_t> num_backfilled = 0;
+        std::atomic<size_t> num_failed = 0;
+        std::atomic<bool> stop = false;
+    };
+
+    std::shared_ptr<alter_backfill_t> alter_backfill;
+
+    std::thread backfill_thread;
+
     const uint8_t CURATED_RECORD_IDENTIFIER = 100;
 
     const size_t DEFAULT_TOPSTER_SIZE = 250;
 
+    // hits of a page prepared by each thread when the hits are prepared in parallel
+    const size_t PARALLEL_HITS_PER_TASK = 8;
+
     struct highlight_t {
         size_t field_index;
         std::string field;
@@ -98,6 +174,45 @@ private:
         }
     };
 
+    // a token of a highlighted text, with the byte offsets of its first and last character
+    struct highlight_token_t {
+        std::string token;
+        size_t index;
+        size_t start;
+        size_t end;
+    };
+
+    // texts longer than this are tokenized afresh for every highlight
+    static constexpr size_t HIGHLIGHT_TOKENS_MAX_TEXT_LEN = 16 * 1024;
+
+    // tokens of recently highlighted texts, keyed on the text and the tokenizer settings
+    mutable LRU::Cache<uint64_t, std::shared_ptr<const std::vector<highlight_token_t>>> highlight_tokens_cache{1024};
+    mutable std::mutex highlight_tokens_cache_mutex;
+
+    // hits ranked by a search, which are reused by searches that differ only in which of the hits they return
+    // and how they render them
+    struct ranked_hits_t {
+        std::unique_ptr<Topster> topster;
+        // the hits are ranked up to this many
+        size_t fetch_size = 0;
+        size_t all_result_ids_len = 0;
+        // the queries searched as tokens, and the matched query tokens without their leaves: the leaves of the index
+        // that the hits were ranked with may be freed by a later write
+        std::vector<std::vector<std::string>> searched_queries;
+        tsl::htrie_map<char, token_leaf> qtoken_set;
+    };
+
+    // ranked hits of recent searches, keyed on `get_ranked_hits_key`
+    mutable LRU::Cache<std::string, std::shared_ptr<const ranked_hits_t>> ranked_hits_cache{128};
+    mutable std::mutex ranked_hits_cache_mutex;
+
+    // moves forward whenever a field is added to or removed from `search_schema`
+    std::atomic<uint64_t> schema_version = 0;
+
+    // facets parsed from recently seen `facet_by` expressions, keyed on the expression and the schema version
+    mutable LRU::Cache<std::string, std::shared_ptr<const std::vector<facet>>> parsed_facets_cache{256};
+    mutable std::mutex parsed_facets_cache_mutex;
+
     const std::string name;
 
     const std::atomic<uint32_t> collection_id;
@@ -109,8 +224,23 @@ private:
     // Auto incrementing record ID used internally for indexing - not exposed to the client
     std::atomic<uint32_t> next_seq_id;
 
+    // Moves forward on every write that can change search results. Values are drawn from a process-wide
+    // counter so that a collection that is dropped and re-created never repeats an older generation.
+    std::atomic<uint64_t> write_generation;
+
+    static std::atomic<uint64_t> write_generation_counter;
+
+    // seconds since epoch of the last lookup of the collection through the collection manager
+    std::atomic<uint64_t> last_accessed_s;
+
+    // time taken to load the collection from the store, -1 when it was created after the start
+    std::atomic<int64_t> load_time_ms = -1;
+
     Store* store;
 
+    // resolves the ids of documents without reading the store, see `doc-id-index`
+    doc_id_index_t doc_ids;
+
     std::vector<field> fields;
 
     tsl::htrie_map<char, field> search_schema;
@@ -120,6 +250,15 @@ private:
     // maps tag name => override_ids
     std::map<std::string, std::set<std::string>> override_tags;
 
+    // Overrides that can apply to a search without override tags, by what their rule matches on, so that such a
+    // search only evaluates the overrides that can match its query: exact rules by their query, contains rules by
+    // the first token of their query, and the rest (rules without a query, dynamic filters) in any query.
+    std::unordered_map<std::string, std::set<std::string>> exact_rule_override_ids;
+    std::unordered_map<std::string, std::set<std::string>> contains_rule_override_ids;
+    std::set<std::string> any_query_override_ids;
+
+    std::set<std::string>* get_override_rule_ids(const override_t& override);
+
     std::string default_sorting_field;
 
     const float max_memory_ratio;
@@ -134,6 +273,9 @@ private:
 
     bool enable_nested_fields;
 
+    // format in which documents are written to the store: `json` or `msgpack`
+    const std::string storage_format;
+
     std::vector<char> symbols_to_index;
 
     std::vector<char> token_separators;
@@ -159,6 +301,10 @@ private:
 
     std::string get_doc_id_key(const std::string & doc_id) const;
 
+    // Sequence id of the document with the given id, from the in-memory index of ids when it knows the answer,
+    // otherwise from the store.
+    StoreStatus get_doc_seq_id(const std::string& doc_id, uint32_t& seq_id) const;
+
     std::string get_seq_id_key(uint32_t seq_id) const;
 
     void highlight_result(const std::string& h_obj,
@@ -181,6 +327,12 @@ private:
 
     void remove_document(const nlohmann::json & document, const uint32_t seq_id, bool remove_from_store);
 
+    // cascades the removal of a document to the documents of other collections that reference it
+    void remove_referencing_docs(const std::string& id);
+
+    // decodes the `id` and the indexed fields of a stored document, which are all that its removal needs
+    doc_projection_t get_removal_projection() const;
+
     void process_remove_field_for_embedding_fields(const field& del_field, std::vector<field>& garbage_embed_fields);
 
     bool does_override_match(const override_t& override, std::string& query,
@@ -265,6 +417,22 @@ private:
                                   const std::vector<field>& del_fields,
                                   const std::string& this_fallback_field_type);
 
+    void run_backfill(std::shared_ptr<alter_backfill_t> backfill, std::function<void()> on_done);
+
+    // asks a running background alter to stop and waits for it
+    void stop_backfill();
+
+    // Indexes up to `batch_size` documents from `next_seq_id` on the fields of the backfill. Returns the number of
+    // documents that were read.
+    size_t backfill_batch(alter_backfill_t& backfill, uint32_t& next_seq_id, size_t batch_size);
+
+    // switches on the fields of the backfill
+    void finish_backfill();
+
+    static void hide_alter_credentials(nlohmann::json& alter_payload);
+
+    static nlohmann::json backfill_status(const alter_backfill_t& backfill);
+
     Option<bool> validate_alter_payload(nlohmann::json& schema_changes,
                                         std::vector<field>& addition_fields,
                                         std::vector<field>& reindex_fields,
@@ -373,6 +541,15 @@ public:
     static constexpr const char* COLLECTION_VOICE_QUERY_MODEL = "voice_query_model";
 
     static constexpr const char* COLLECTION_METADATA = "metadata";
+    static constexpr const char* COLLECTION_ALTER_BACKFILL = "alter_backfill";
+
+    static constexpr const char* COLLECTION_STORAGE_FORMAT = "storage_format";
+    static constexpr const char* STORAGE_FORMAT_JSON = "json";
+    static constexpr const char* STORAGE_FORMAT_MSGPACK = "msgpack";
+
+    // Documents stored as MessagePack are prefixed with this byte, so that they can be told apart from JSON documents
+    // (which always begin with `{`) written before the collection's format was switched.
+    static constexpr char STORED_DOC_MSGPACK_MARKER = '\0';
 
     // methods
 
@@ -384,7 +561,8 @@ public:
                const float max_memory_ratio, const std::string& fallback_field_type,
                const std::vector<std::string>& symbols_to_index, const std::vector<std::string>& token_separators,
                const bool enable_nested_fields, std::shared_ptr<VQModel> vq_model = nullptr,
-               spp::sparse_hash_map<std::string, std::string> referenced_in = spp::sparse_hash_map<std::string, std::string>());
+               spp::sparse_hash_map<std::string, std::string> referenced_in = spp::sparse_hash_map<std::string, std::string>(),
+               const std::string& storage_format = STORAGE_FORMAT_JSON);
 
     ~Collection();
 
@@ -404,10 +582,33 @@ public:
 
     uint32_t get_next_seq_id();
 
+    uint64_t get_write_generation() const;
+
+    void advance_write_generation();
+
+    void touch() {
+        last_accessed_s = std::time(nullptr);
+    }
+
+    uint64_t get_last_accessed_s() const {
+        return last_accessed_s;
+    }
+
+    void set_load_time_ms(int64_t time_ms) {
+        load_time_ms = time_ms;
+    }
+
+    int64_t get_load_time_ms() const {
+        return load_time_ms;
+    }
+
     Option<uint32_t> doc_id_to_seq_id_with_lock(const std::string & doc_id) const;
 
     Option<uint32_t> doc_id_to_seq_id(const std::string & doc_id) const;
 
+    // adds the ids of the documents that were read from the store while the collection is loaded
+    void add_doc_ids(const std::vector<index_record>& index_records);
+
     std::vector<std::string> get_facet_fields();
 
     std::vector<field> get_sort_fields();
@@ -443,17 +644,44 @@ public:
 
     static uint32_t get_seq_id_from_key(const std::string & key);
 
-    Option<bool> get_document_from_store(const std::string & seq_id_key, nlohmann::json & document, bool raw_doc = false) const;
+    Option<bool> get_document_from_store(const std::string & seq_id_key, nlohmann::json & document, bool raw_doc = false,
+                                         const doc_projection_t* projection = nullptr) const;
 
     Option<bool> get_document_from_store(const uint32_t& seq_id, nlohmann::json & document, bool raw_doc = false) const;
 
+    // Parses a document that was fetched from the store with `json_doc_status`, as `get_document_from_store` does.
+    Option<bool> parse_document_from_store(const std::string& seq_id_key, const StoreStatus& json_doc_status,
+                                           const std::string& json_doc_str, nlohmann::json& document,
+                                           bool raw_doc = false, const doc_projection_t* projection = nullptr) const;
+
+    // Serializes a document in the storage format of the collection.
+    std::string serialize_document(const nlohmann::json& document) const;
+
+    // Parses a document read from the store, in either of the storage formats. Throws like `nlohmann::json::parse`.
+    // With a projection, values of the top level keys it does not want are skipped over without being built.
+    static nlohmann::json parse_stored_document(const std::string& stored_doc,
+                                                const doc_projection_t* projection = nullptr);
+
     Option<uint32_t> index_in_memory(nlohmann::json & document, uint32_t seq_id,
                                      const index_operation_t op, const DIRTY_VALUES& dirty_values);
 
     static void remove_flat_fields(nlohmann::json& document);
 
+    // Builds the merge patch (RFC 7386) that turns the stored form of `old_doc` into `new_doc`. Returns false when
+    // the change can not be expressed as a merge patch, i.e. when `new_doc` holds a null value.
+    static bool get_stored_doc_patch(const nlohmann::json& old_doc, const nlohmann::json& new_doc,
+                                     nlohmann::json& patch);
+
     static void remove_reference_helper_fields(nlohmann::json& document);
 
+    // Fetches a document of this collection that is included in a referencing hit, via the cache of referenced
+    // documents when one is in scope.
+    Option<bool> get_ref_document(const uint32_t& seq_id, nlohmann::json& document) const;
+
+    // Fetches the documents of this collection that the hits reference through a join filter into the cache of
+    // referenced documents, with a single batched store lookup.
+    void prefetch_ref_documents(const std::vector<const KV*>& kvs) const;
+
     static Option<bool> prune_ref_doc(nlohmann::json& doc,
                                       const reference_filter_result_t& references,
                                       const tsl::htrie_set<char>& ref_include_fields_full,
@@ -481,7 +709,8 @@ public:
 
     static void populate_result_kvs(Topster *topster, std::vector<std::vector<KV *>> &result_kvs, 
                     const spp::sparse_hash_map<uint64_t, uint32_t>& groups_processed, 
-                    const std::vector<sort_by>& sort_by_fields);
+                    const std::vector<sort_by>& sort_by_fields,
+                    ThreadPool* thread_pool = nullptr, size_t concurrency = 1);
 
     void batch_index(std::vector<index_record>& index_records, std::vector<std::string>& json_out, size_t &num_indexed,
                      const bool& return_doc, const bool& return_id, const size_t remote_embedding_batch_size = 200,
@@ -525,6 +754,8 @@ public:
 
     void do_housekeeping();
 
+    size_t compact_vector_indices();
+
     Option<nlohmann::json> search(std::string query, const std::vector<std::string> & search_fields,
                                   const std::string & filter_query, const std::vector<std::string> & facet_fields,
                                   const std::vector<sort_by> & sort_fields, const std::vector<uint32_t>& num_typos,
@@ -585,7 +816,17 @@ public:
                                   const std::string& override_tags_str = "",
                                   const std::string& voice_query = "",
                                   bool enable_typos_for_numerical_tokens = true,
-                                  bool enable_lazy_filter = false) const;
+                                  bool enable_lazy_filter = false,
+                                  bool profile = false,
+                                  bool approximate_facets = false,
+                                  const std::string& search_after = "",
+                                  total_hits_t total_hits = total_hits_t::exact,
+                                  const nlohmann::json& filter_params = nlohmann::json::object()) const;
+
+    // A `search_after` cursor holds the sort scores and the seq id of the last hit of a page.
+    static std::string encode_search_after(const KV* kv);
+
+    static Option<bool> decode_search_after(const std::string& search_after, int64_t* scores, uint64_t& key);
 
     Option<bool> get_filter_ids(const std::string & filter_query, filter_result_t& filter_result) const;
 
@@ -599,8 +840,37 @@ public:
 
     Option<bool> remove_if_found(uint32_t seq_id, bool remove_from_store = true);
 
+    // Removes the documents of `seq_ids` that still exist, reading only their indexed fields from the store and
+    // unindexing them under a single lock. Returns the number of documents removed.
+    Option<size_t> remove_batch(const uint32_t* seq_ids, size_t num_ids, bool remove_from_store = true);
+
+    // Applies the numeric updates of `json_lines`, e.g. `{"id": "1", "increment": {"views": 1}, "set": {"stock": 4}}`,
+    // in place: the values are updated in the index without reading the documents, and written to the store as merge
+    // patches. Each line is replaced by its result.
+    nlohmann::json update_numeric_fields(std::vector<std::string>& json_lines);
+
+    // Unindexes the documents that were deleted since the last purge. Returns the number of documents purged.
+    size_t purge_deleted_docs();
+
     size_t get_num_documents() const;
 
+    // bytes held by each in-memory structure of the collection's index
+    nlohmann::json get_memory_stats_json() const;
+
+    // Persists the in-memory structures that can be restored without replaying documents.
+    Option<bool> save_index_image(const std::string& image_dir, nlohmann::json& image_meta) const;
+
+    Option<bool> load_index_image(const std::string& image_dir, const nlohmann::json& image_meta);
+
+    void clear_preloaded_index_state();
+
+    // sizes the vector indices for the documents that are about to be loaded from the store
+    void reserve_index_capacity();
+
+    // Copies the stored documents of `source`, which must have the same schema, and indexes them in batches.
+    // Documents keep their sequence ids. Returns the number of documents copied.
+    Option<size_t> copy_documents(Collection* source, size_t batch_size);
+
     DIRTY_VALUES parse_dirty_values_option(std::string& dirty_values) const;
 
     std::vector<char> get_symbols_to_index();
@@ -611,10 +881,15 @@ public:
 
     bool get_enable_nested_fields();
 
+    std::string get_storage_format() const;
+
     std::shared_ptr<VQModel> get_vq_model();
 
     Option<bool> parse_facet(const std::string& facet_field, std::vector<facet>& facets) const;
 
+    // Same as `parse_facet`, but reuses the facets of an expression that was parsed against the same schema.
+    Option<bool> parse_facet_cached(const std::string& facet_field, std::vector<facet>& facets) const;
+
     // Override operations
 
     Option<uint32_t> add_override(const override_t & override, bool write_to_store = true);
@@ -642,6 +917,9 @@ public:
 
     spp::sparse_hash_map<std::string, reference_pair> get_reference_fields();
 
+    // whether the collection references another collection or is referenced by one
+    bool has_references() const;
+
     // highlight ops
 
     static void highlight_text(const std::string& highlight_start_tag, const std::string& highlight_end_tag,
@@ -670,6 +948,15 @@ public:
 
     Option<bool> alter(nlohmann::json& alter_payload);
 
+    // Adds the fields of `alter_payload` and indexes the existing documents on them in the background, at up to
+    // `backfill_rate` documents per second (unlimited when 0), while reads and writes go on. The fields are switched
+    // on once all the documents are indexed on them. `on_done` is called when the backfill ends.
+    Option<bool> alter_in_background(nlohmann::json& alter_payload, uint32_t backfill_rate,
+                                     const std::function<void()>& on_done);
+
+    // progress of a background alter, or null when there is none
+    nlohmann::json get_alter_status() const;
+
     void process_search_field_weights(const std::vector<search_field_t>& search_fields,
                                       std::vector<uint32_t>& query_by_weights,
                                       std::vector<search_field_t>& weighted_search_fields) const;
@@ -678,7 +965,7 @@ public:
 
     void reference_populate_sort_mapping(int* sort_order, std::vector<size_t>& geopoint_indices,
                                          std::vector<sort_by>& sort_fields_std,
-                                         std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values) const;
+                                         std::array<sort_column_t*, 3>& field_values) const;
 
     int64_t reference_string_sort_score(const std::string& field_name, const uint32_t& seq_id) const;
 
@@ -703,9 +990,21 @@ public:
 
     std::shared_mutex& get_lifecycle_mutex();
 
-    void expand_search_query(const std::string& raw_query, size_t offset, size_t total, const search_args* search_params,
+    // Frees the per-field structures of the index of a dropped collection one at a time, pausing in between, so that
+    // a large collection does not hold the allocator busy in one go. Deleting the collection frees the rest.
+    void release_index_in_chunks(const std::chrono::milliseconds& pause);
+
+    void expand_search_query(const std::string& raw_query, size_t offset, size_t total,
+                             const std::vector<std::vector<std::string>>& searched_queries,
                              const std::vector<std::vector<KV*>>& result_group_kvs,
                              const std::vector<std::string>& raw_search_fields, std::string& first_q) const;
+
+    // Key of the hits ranked by a search: everything that decides which documents match and how they are ranked,
+    // along with the write generation. Empty when the hits can't be reused, e.g. when they are faceted, grouped or
+    // curated.
+    std::string get_ranked_hits_key(const search_args* search_params, const std::string& query,
+                                    const std::string& vector_query_str,
+                                    bool enable_typos_for_numerical_tokens) const;
 };
 
 template<class T>
@@ -2,6 +2,9 @@
 
 #include <iostream>
 #include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <sparsepp.h>
 #include "store.h"
 #include "field.h"
@@ -58,6 +61,9 @@ private:
     Store *store;
     ThreadPool* thread_pool;
 
+    // pool used for in-memory indexing of writes, which is the same as `thread_pool` unless configured otherwise
+    ThreadPool* indexing_thread_pool = nullptr;
+
     AuthManager auth_manager;
 
     spp::sparse_hash_map<std::string, Collection*> collections;
@@ -66,6 +72,9 @@ private:
 
     spp::sparse_hash_map<std::string, std::string> collection_symlinks;
 
+    // sharded alias name => names of the collections it spans
+    spp::sparse_hash_map<std::string, std::vector<std::string>> sharded_aliases;
+
     spp::sparse_hash_map<std::string, nlohmann::json> preset_configs;
 
     // Auto incrementing ID assigned to each collection
@@ -81,9 +90,95 @@ private:
     // All the references to a particular collection are stored until it is created.
     std::map<std::string, std::set<reference_pair>> referenced_in_backlog;
 
+    // directory holding the index images of the snapshot being loaded (empty when there are none)
+    std::string index_image_dir;
+
+    // collection name => load state, while the collections are being loaded from the store
+    mutable std::mutex load_states_mutex;
+    std::map<std::string, std::string> collection_load_states;
+    std::atomic<bool> loading_collections = false;
+
+    void set_collection_load_state(const std::string& collection_name, const std::string& state);
+
+    // documents indexed at a time when a collection is loaded from the store
+    std::atomic<size_t> load_document_batch_size = 1000;
+
+    // collections that are loaded before the others when the store is loaded, in this order
+    std::vector<std::string> hot_collections;
+
+    // Collections that have not been looked up for a while are evicted from memory and loaded again from the store on
+    // their next lookup. Their summary is kept to list them meanwhile.
+    struct evicted_collection_t {
+        uint32_t collection_id = 0;
+        uint64_t write_generation = 0;
+        nlohmann::json summary;
+
+        // vector graphs saved when the collection was evicted
+        nlohmann::json index_image_meta;
+    };
+
+    // name => evicted collection
+    std::map<std::string, evicted_collection_t> evicted_collections;
+
+    // directory of the index images of evicted collections, none are saved when it is empty
+    std::string evicted_image_dir;
+
+    // evictions and restores happen one at a time
+    mutable std::mutex eviction_mutex;
+
+    // name and state of an evicted collection, or of the one an alias points to
+    const std::pair<const std::string, evicted_collection_t>*
+    get_evicted_collection_unsafe(const std::string& collection_name) const;
+
+    bool evict_collection(const std::string& collection_name, uint64_t idle_since_s);
+
+    // Loads an evicted collection, or the one an alias points to, back into memory. Returns false when it is not
+    // evicted or could not be loaded.
+    bool restore_evicted_collection(const std::string& collection_name);
+
+    // Dropped collections are deleted and their key range compacted on `drop_thread`, so that a drop, e.g. of the
+    // collection an alias pointed to before a swap, does not wait for their memory to be freed.
+    struct dropped_collection_t {
+        Collection* collection = nullptr;
+
+        // empty when the store is not compacted
+        std::string compact_begin;
+        std::string compact_end;
+    };
+
+    // pause between the index structures of a dropped collection that are freed
+    static constexpr std::chrono::milliseconds DROP_RELEASE_PAUSE{2};
+
+    std::mutex drop_mutex;
+    std::deque<dropped_collection_t> dropped_collections;
+    std::thread drop_thread;
+    bool drop_thread_running = false;
+
+    void schedule_drop(dropped_collection_t&& dropped_collection);
+
+    void run_drops();
+
     CollectionManager();
 
-    ~CollectionManager() = default;
+    ~CollectionManager() {
+        wait_for_drops();
+    }
+
+    // documents read from the store that are ready to be indexed
+    struct parsed_batch_t {
+        std::vector<index_record> index_records;
+        Option<bool> status = Option<bool>(true);
+    };
+
+    static parsed_batch_t parse_stored_docs(const std::vector<std::pair<uint32_t, std::string>>& raw_docs,
+                                            const bool enable_nested_fields,
+                                            const tsl::htrie_map<char, field>& nested_fields,
+                                            std::atomic<uint64_t>& parse_time_us);
+
+    static Option<bool> do_sharded_search(std::map<std::string, std::string>& req_params,
+                                          const std::vector<std::string>& collection_names,
+                                          nlohmann::json& search_result,
+                                          uint64_t start_ts);
 
     static Option<std::string> get_first_index_error(const std::vector<index_record>& index_records) {
         for(const auto & index_record: index_records) {
@@ -98,10 +193,21 @@ private:
 public:
     static constexpr const size_t DEFAULT_NUM_MEMORY_SHARDS = 4;
 
+    // documents copied from the source of a clone per batch
+    static constexpr const size_t CLONE_BATCH_SIZE = 1000;
+
     static constexpr const char* NEXT_COLLECTION_ID_KEY = "$CI";
     static constexpr const char* SYMLINK_PREFIX = "$SL";
+    static constexpr const char* SHARDED_ALIAS_PREFIX = "$SH";
     static constexpr const char* PRESET_PREFIX = "$PS";
 
+    static constexpr const char* LOAD_STATE_PENDING = "pending";
+    static constexpr const char* LOAD_STATE_LOADING = "loading";
+    static constexpr const char* LOAD_STATE_READY = "ready";
+
+    static constexpr const char* INDEX_IMAGE_META_FILE = "index_image.json";
+    static constexpr const uint32_t INDEX_IMAGE_VERSION = 1;
+
     static CollectionManager & get_instance() {
         static CollectionManager instance;
         return instance;
@@ -129,7 +235,9 @@ public:
                                         const size_t batch_size,
                                         const StoreStatus& next_coll_id_status,
                                         const std::atomic<bool>& quit,
-                                        spp::sparse_hash_map<std::string, std::string>& referenced_in);
+                                        spp::sparse_hash_map<std::string, std::string>& referenced_in,
+                                        const nlohmann::json& index_image_meta = nlohmann::json(),
+                                        const std::string& image_dir = "");
 
     Option<Collection*> clone_collection(const std::string& existing_name, const nlohmann::json& req_json);
 
@@ -141,19 +249,49 @@ public:
 
     Collection* get_collection_unsafe(const std::string & collection_name) const;
 
+    // true while `load()` is loading the collections from the store
+    bool is_loading_collections() const;
+
+    // whether the collection, or the collection an alias points to, has been loaded and can be searched
+    bool is_collection_loaded(const std::string& collection_name) const;
+
+    // collection name => load state, which is empty once all the collections are loaded
+    nlohmann::json get_collection_load_states() const;
+
     // PUBLICLY EXPOSED API
 
     void init(Store *store, ThreadPool* thread_pool, const float max_memory_ratio,
-              const std::string & auth_key, std::atomic<bool>& quit);
+              const std::string & auth_key, std::atomic<bool>& quit,
+              ThreadPool* indexing_thread_pool = nullptr);
 
     // only for tests!
     void init(Store *store, const float max_memory_ratio, const std::string & auth_key, std::atomic<bool>& exit);
 
     Option<bool> load(const size_t collection_batch_size, const size_t document_batch_size);
 
+    // Writes the index images of all collections into `image_dir`: must be called while writes are paused.
+    Option<bool> save_index_images(const std::string& image_dir) const;
+
+    void set_index_image_dir(const std::string& image_dir);
+
+    // Evicts the collections that have not been looked up for `idle_secs` and that were last loaded from the store
+    // within `restore_budget_ms`, so that the lookup that loads one again does not wait much longer than that.
+    // Collections that take part in references are kept. Returns the number of evicted collections.
+    size_t evict_idle_collections(uint64_t idle_secs, uint64_t restore_budget_ms);
+
+    bool is_collection_evicted(const std::string& collection_name) const;
+
+    void set_evicted_image_dir(const std::string& image_dir);
+
+    // Collections (or aliases) that are loaded first, so that they are served while the others are still loading.
+    void set_hot_collections(const std::vector<std::string>& collection_names);
+
     // frees in-memory data structures when server is shutdown - helps us run a memory leak detector properly
     void dispose();
 
+    // waits until the collections that were dropped have been deleted
+    void wait_for_drops();
+
     bool auth_key_matches(const string& req_auth_key, const string& action,
                           const std::vector<collection_key_t>& collection_keys,
                           std::map<std::string, std::string>& params,
@@ -169,12 +307,16 @@ public:
                                           const std::vector<std::string>& symbols_to_index = {},
                                           const std::vector<std::string>& token_separators = {},
                                           const bool enable_nested_fields = false, std::shared_ptr<VQModel> model = nullptr,
-                                          const nlohmann::json& metadata = {});
+                                          const nlohmann::json& metadata = {},
+                                          const std::string& storage_format = Collection::STORAGE_FORMAT_JSON);
 
     locked_resource_view_t<Collection> get_collection(const std::string & collection_name) const;
 
     locked_resource_view_t<Collection> get_collection_with_id(uint32_t collection_id) const;
 
+    // returns 0 when the collection does not exist
+    uint64_t get_collection_write_generation(const std::string& collection_name) const;
+
     Option<nlohmann::json> get_collection_summaries(uint32_t limit = 0 , uint32_t offset = 0) const;
 
     Option<nlohmann::json> drop_collection(const std::string& collection_name,
@@ -185,12 +327,16 @@ public:
 
     static std::string get_symlink_key(const std::string & symlink_name);
 
+    static std::string get_sharded_alias_key(const std::string & alias_name);
+
     static std::string get_preset_key(const std::string & preset_name);
 
     Store* get_store();
 
     ThreadPool* get_thread_pool() const;
 
+    ThreadPool* get_indexing_thread_pool() const;
+
     AuthManager& getAuthManager();
 
     static Option<bool> do_search(std::map<std::string, std::string>& req_params,
@@ -198,6 +344,13 @@ public:
                                   std::string& results_json_str,
                                   uint64_t start_ts);
 
+    // Same as above, but hands over the results as a JSON object, for in-process callers that would otherwise
+    // have to parse the serialized results again.
+    static Option<bool> do_search(std::map<std::string, std::string>& req_params,
+                                  nlohmann::json& embedded_params,
+                                  nlohmann::json& search_result,
+                                  uint64_t start_ts);
+
     static bool parse_sort_by_str(std::string sort_by_str, std::vector<sort_by>& sort_fields);
 
     // symlinks
@@ -209,6 +362,16 @@ public:
 
     Option<bool> delete_symlink(const std::string & symlink_name);
 
+    // Sharded aliases: a search on one of them runs on each of its collections and their results are merged.
+    // Documents are written to the collections themselves.
+    std::vector<std::string> get_sharded_alias(const std::string & alias_name) const;
+
+    spp::sparse_hash_map<std::string, std::vector<std::string>> get_sharded_aliases() const;
+
+    Option<bool> upsert_sharded_alias(const std::string & alias_name, const std::vector<std::string>& collection_names);
+
+    Option<bool> delete_sharded_alias(const std::string & alias_name);
+
     // presets
     spp::sparse_hash_map<std::string, nlohmann::json> get_presets() const;
 
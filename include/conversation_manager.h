@@ -2,6 +2,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <shared_mutex>
 #include <mutex>
 #include <json.hpp>
@@ -25,6 +26,10 @@ class ConversationManager {
         Option<nlohmann::json> get_conversation(const std::string& conversation_id);
         Option<bool> append_conversation(const std::string& conversation_id, const nlohmann::json& message);
         Option<nlohmann::json> truncate_conversation(nlohmann::json conversation, size_t limit);
+        // The last messages of a conversation that `truncate_conversation()` would keep for `limit`, which are found
+        // from the sizes of the messages kept along with the conversation, so that a long history is neither copied
+        // nor serialized to read its window.
+        Option<nlohmann::json> get_conversation_window(const std::string& conversation_id, size_t limit);
         Option<nlohmann::json> update_conversation(nlohmann::json conversation);
         Option<nlohmann::json> delete_conversation(const std::string& conversation_id);
         Option<nlohmann::json> get_all_conversations();
@@ -39,6 +44,8 @@ class ConversationManager {
     private:
         ConversationManager() {}
         std::unordered_map<std::string, nlohmann::json> conversations;
+        // the `dump(0)` size of every message of a conversation, which grows as messages are appended
+        std::unordered_map<std::string, std::vector<size_t>> conversation_message_bytes;
         std::mutex conversations_mutex;
 
         static constexpr char* CONVERSATION_RPEFIX = "$CNVP";
@@ -47,6 +54,11 @@ class ConversationManager {
 
         static const std::string get_conversation_key(const std::string& conversation_id);
 
+        static std::vector<size_t> get_message_bytes(const nlohmann::json& messages);
+
+        // index of the first of the last messages whose array fits in `limit` bytes when written with `dump(0)`
+        static size_t get_window_start(const std::vector<size_t>& message_bytes, size_t limit);
+
         static constexpr size_t CONVERSATION_TTL = 60 * 60 * 24;
         size_t TTL_OFFSET = 0;
 
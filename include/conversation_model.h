@@ -2,7 +2,9 @@
 
 #include <string>
 #include <condition_variable>
+#include <functional>
 #include <mutex>
+#include <unordered_map>
 #include <json.hpp>
 #include "option.h"
 
@@ -16,14 +18,30 @@ struct async_conversation_t {
 
 class ConversationModel {
     public:
+        // receives each part of an answer as the model streams it, and returns false to stop the stream
+        typedef std::function<bool(const std::string&)> answer_chunk_cb_t;
+
         virtual ~ConversationModel() {};
-        static Option<std::string> get_answer(const std::string& context, const std::string& prompt, const nlohmann::json& model_config);
+        // When `on_chunk` is given, the answer is streamed by the model and handed over part by part as it arrives.
+        static Option<std::string> get_answer(const std::string& context, const std::string& prompt, const nlohmann::json& model_config,
+                                              const answer_chunk_cb_t& on_chunk = nullptr);
         static Option<bool> validate_model(const nlohmann::json& model_config);
         static Option<std::string> get_standalone_question(const nlohmann::json& conversation_history, const std::string& question, const nlohmann::json& model_config);
         static Option<nlohmann::json> format_question(const std::string& message, const nlohmann::json& model_config);
         static Option<nlohmann::json> format_answer(const std::string& message, const nlohmann::json& model_config);
         static Option<size_t> get_minimum_required_bytes(const nlohmann::json& model_config);
+        // Appends `chunk` to `buffer` and hands the data of every complete `data:` line of the server-sent events in it
+        // to `on_data`, skipping the closing `[DONE]`. A partial line is left in the buffer for the next chunk.
+        static bool parse_stream_events(std::string& buffer, const std::string& chunk,
+                                        const std::function<bool(const std::string&)>& on_data);
     protected:
+        // Posts a request for a streamed answer, which is handed to `on_chunk` as the text that `get_event_text` finds
+        // in each event. The request is sent from this node rather than through the proxy of the leader, since the
+        // proxy only returns once the whole response is in. The raw body is left in `res` for error messages.
+        static long stream_answer(const std::string& url, const std::string& req_body,
+                                  const std::unordered_map<std::string, std::string>& headers,
+                                  const std::function<std::string(const nlohmann::json&)>& get_event_text,
+                                  const answer_chunk_cb_t& on_chunk, std::string& answer, std::string& res);
         static const inline std::string CONVERSATION_HISTORY = "\n\n<Conversation history>\n";
         static const inline std::string QUESTION = "\n\n<Question>\n";
         static const inline std::string STANDALONE_QUESTION_PROMPT = "\n\n<Standalone question>\n";
@@ -31,7 +49,8 @@ class ConversationModel {
 
 class OpenAIConversationModel : public ConversationModel {
     public:
-        static Option<std::string> get_answer(const std::string& context, const std::string& prompt, const std::string& system_prompt, const nlohmann::json& model_config);
+        static Option<std::string> get_answer(const std::string& context, const std::string& prompt, const std::string& system_prompt, const nlohmann::json& model_config,
+                                              const answer_chunk_cb_t& on_chunk = nullptr);
         static Option<bool> validate_model(const nlohmann::json& model_config);
         static Option<std::string> get_standalone_question(const nlohmann::json& conversation_history, const std::string& question, const nlohmann::json& model_config);
         static Option<nlohmann::json> format_question(const std::string& message);
@@ -55,7 +74,8 @@ class OpenAIConversationModel : public ConversationModel {
 
 class CFConversationModel : public ConversationModel {
     public:
-        static Option<std::string> get_answer(const std::string& context, const std::string& prompt, const std::string& system_prompt, const nlohmann::json& model_config);
+        static Option<std::string> get_answer(const std::string& context, const std::string& prompt, const std::string& system_prompt, const nlohmann::json& model_config,
+                                              const answer_chunk_cb_t& on_chunk = nullptr);
         static Option<bool> validate_model(const nlohmann::json& model_config);
         static Option<std::string> get_standalone_question(const nlohmann::json& conversation_history, const std::string& question, const nlohmann::json& model_config);
         static Option<nlohmann::json> format_question(const std::string& message);
@@ -81,7 +101,8 @@ class CFConversationModel : public ConversationModel {
 
 class vLLMConversationModel : public ConversationModel {
     public:
-        static Option<std::string> get_answer(const std::string& context, const std::string& prompt, const std::string& system_prompt, const nlohmann::json& model_config);
+        static Option<std::string> get_answer(const std::string& context, const std::string& prompt, const std::string& system_prompt, const nlohmann::json& model_config,
+                                              const answer_chunk_cb_t& on_chunk = nullptr);
         static Option<bool> validate_model(const nlohmann::json& model_config);
         static Option<std::string> get_standalone_question(const nlohmann::json& conversation_history, const std::string& question, const nlohmann::json& model_config);
         static Option<nlohmann::json> format_question(const std::string& message);
@@ -35,12 +35,19 @@ bool get_export_documents(const std::shared_ptr<http_req>& req, const std::share
 
 bool post_add_document(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+// Writes the single documents of a run of `post_add_document` requests to the same collection, with the same
+// parameters, in one batch and sets the response of each request as `post_add_document` would.
+void add_coalesced_documents(const std::vector<std::shared_ptr<http_req>>& reqs,
+                             const std::vector<std::shared_ptr<http_res>>& res_vec);
+
 bool patch_update_document(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
 bool patch_update_documents(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
 bool post_import_documents(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+bool post_numeric_updates(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
 bool get_fetch_document(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
 bool del_remove_document(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
@@ -111,6 +118,8 @@ bool del_key(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_re
 
 bool get_debug(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+bool get_debug_cpu_profile(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
 bool get_health(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
 bool get_health_with_resource_usage(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
@@ -119,10 +128,24 @@ bool post_health(const std::shared_ptr<http_req>& req, const std::shared_ptr<htt
 
 bool get_metrics_json(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+bool get_metrics_prometheus(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
 bool get_stats_json(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+bool get_search_fingerprint_stats(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
 bool get_status(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+// replication to learners and to other clusters
+
+bool get_replication_log(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
+bool get_replication_snapshot(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
+bool get_replication_snapshot_file(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
+bool get_replication_changes(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
 // operations
 
 bool post_snapshot(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
@@ -137,6 +160,10 @@ bool post_compact_db(const std::shared_ptr<http_req>& req, const std::shared_ptr
 
 bool post_reset_peers(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+bool get_housekeeping_tasks(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
+bool post_cancel_housekeeping_task(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
 // Rate Limiting
 
 bool get_rate_limits(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
@@ -153,6 +180,8 @@ bool get_active_throttles(const std::shared_ptr<http_req>& req, const std::share
 
 bool get_limit_exceed_counts(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+bool get_limit_usage(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
 bool del_throttle(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
 bool del_exceed(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
@@ -178,6 +207,10 @@ void get_collections_for_auth(std::map<std::string, std::string>& req_params, co
                               std::vector<collection_key_t>& collections,
                               std::vector<nlohmann::json>& embedded_params_vec);
 
+bool is_search_route(uint64_t route_hash);
+
+bool is_multi_search_route(uint64_t route_hash);
+
 bool is_doc_import_route(uint64_t route_hash);
 
 bool is_coll_create_route(uint64_t route_hash);
@@ -190,7 +223,7 @@ bool is_doc_del_route(uint64_t route_hash);
 
 Option<std::pair<std::string,std::string>> get_api_key_and_ip(const std::string& metadata);
 
-void init_api(uint32_t cache_num_entries);
+void init_api(uint32_t cache_num_entries, size_t cache_max_memory_bytes = 0, size_t cache_compress_min_bytes = 0);
 
 
 bool post_proxy(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdlib>
+#include <functional>
 #include <vector>
 #include "collection.h"
 #include "http_data.h"
@@ -27,6 +28,13 @@ struct export_state_t: public req_state_t {
     size_t export_batch_size = 100;
     std::string* res_body;
 
+    // number of partitions of a batch that are serialized in parallel
+    size_t parallelism = 1;
+
+    // when set, the export is sent as a single gzip stream that is fed batch by batch
+    bool compress = false;
+    z_stream zs;
+
     bool filtered_export = false;
 
     rocksdb::Iterator* it = nullptr;
@@ -40,8 +48,35 @@ struct export_state_t: public req_state_t {
 
         delete iter_upper_bound;
         delete it;
+
+        if(compress) {
+            deflateEnd(&zs);
+        }
     }
 };
 
+struct search_stream_state_t: public req_state_t {
+    // hits of a result page larger than a batch are sent in batches
+    static constexpr size_t BATCH_SIZE = 100;
+
+    nlohmann::json hits;
+    std::string hits_key;
+    size_t offset = 0;
+
+    // rest of the serialized results, written out after the last hit
+    std::string results_tail;
+};
+
+// documents removed under a single acquisition of the write locks of a collection
+constexpr size_t REMOVE_CHUNK_SIZE = 256;
+
 Option<bool> stateful_remove_docs(deletion_state_t* deletion_state, size_t batch_size, bool& done);
+
+// Serializes `num_docs` documents into `res_body` by calling `serialize_doc` on up to `parallelism` contiguous
+// partitions in parallel. The partitions are appended to `res_body` in order.
+void serialize_export_docs(size_t num_docs, size_t parallelism, std::string& res_body,
+                           const std::function<void(size_t, std::string&)>& serialize_doc);
+
+// Compresses a chunk of the export in place, finishing the gzip stream on the last chunk.
+Option<bool> compress_export_chunk(export_state_t* export_state, std::string& body, bool last_chunk);
 Option<bool> stateful_export_docs(export_state_t* export_state, size_t batch_size, bool& done);
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "option.h"
+
+// Samples the stacks of the threads that are on the CPU, from a SIGPROF handler driven by a timer on the CPU time of
+// the process, so that it needs no privileges to attach to the process like `perf` does.
+class CpuProfiler {
+public:
+    static constexpr size_t MAX_FRAMES = 64;
+    static constexpr size_t MAX_SAMPLES = 50 * 1000;
+
+    static constexpr uint32_t MAX_SECONDS = 60;
+    static constexpr uint32_t MAX_FREQUENCY = 1000;
+
+    // resolves an address into the name of its function
+    typedef std::function<std::string(void*)> symbolizer_t;
+
+private:
+    struct sample_t {
+        void* frames[MAX_FRAMES];
+        int num_frames;
+    };
+
+    std::mutex mutex;
+    symbolizer_t symbolizer;
+    bool handler_installed = false;
+
+    // read by the signal handler
+    static std::atomic<bool> sampling;
+    static sample_t* samples;
+    static size_t samples_capacity;
+    static std::atomic<size_t> next_sample;
+
+    CpuProfiler() {}
+
+    ~CpuProfiler() {}
+
+    static void on_sigprof(int sig);
+
+    static std::string default_symbolizer(void* addr);
+
+public:
+
+    static CpuProfiler& get_instance() {
+        static CpuProfiler instance;
+        return instance;
+    }
+
+    CpuProfiler(CpuProfiler const&) = delete;
+
+    void operator=(CpuProfiler const&) = delete;
+
+    void set_symbolizer(const symbolizer_t& symbolizer);
+
+    // Samples the process `frequency` times per second of CPU time for `seconds` seconds and returns the stacks in the
+    // folded format of flame graphs: one line per distinct stack, with its frames from the root and separated by `;`,
+    // followed by the number of samples. Only one profile can run at a time.
+    Option<std::string> profile(uint32_t seconds, uint32_t frequency);
+
+    // folds stacks that are ordered from the leaf, as captured, into lines of the folded format
+    static std::string fold_stacks(const std::vector<std::vector<std::string>>& stacks);
+};
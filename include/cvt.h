@@ -16,94 +16,150 @@
   BASIC DESIGN
   ============
 
-  * All nodes in the tree level in the same block.
-  * Pointer to ONLY FIRST child node of each sibling.
-  * Each sibling node's children represented by their character/byte
-  * For root there are no siblings, so pointer only to `a` child.
-  * Each node can be a single-char prefix, multi-char prefix or leaf.
+  * Every node is a single heap block holding its compressed path, its value and the bytes and pointers of its
+    children, so a node costs one allocation and there are no separate leaves.
+  * Paths are compressed: a node holds all the chars up to the next branching or key end, e.g. `to` above.
+  * Children are sorted by their byte, so that a walk visits the keys in lexicographic (unsigned byte) order.
 
-  ROOT -> [0|PTRA][3][a][b][t]
-  PTRA -> [0|PTRS] [2|PTRU] [4|PTRK] [2][s][t] [2][u][t] [2][k][o]
-  PTRS -> [0|PTRØ][1|PTRE][1][Ø][2][e][Ø]
-  PTRT -> [0|L_PTRE][3|PTRØ][3][e][s][Ø][1][Ø]  (path compression)
-  PTRØ -> [0|LEAF]
+  [FLAGS][PREFIX_LEN][NUM_CHILDREN][PREFIX..][VALUE][CHAR_1..CHAR_N][PTR_1..PTR_N]
+  [  1  ][    1     ][     2      ][   x    ][0|8  ][      N       ][    8*N     ]
 
-  [OFFSET][PTR][TYPE]..[NUM_CHILDREN][A][B]..[X]
-  [  16  ][45][  3  ]  (64 bits)
+  The value is present only when a key ends at the node (FLAGS & HAS_VALUE). Paths longer than 255 bytes are split
+  into a chain of nodes. Fields are read and written with memcpy, as they are not aligned.
 
-  2 bytes for type+offset
-  6 bytes for address
-  1 byte for num_children
-  x bytes for bytes
+  Compared to ART, a leaf costs 12 bytes besides its suffix, instead of a leaf with a copy of the whole key and a
+  slot in an inner node that is sized for up to 4, 16, 48 or 256 children.
 
-  Actual offset to the Nth node's children: (8*NUM_CHILDREN) + N + offset
+  Writes rebuild the blocks of the nodes they change and are not thread safe.
 
-  if num_children >= 32:
-    Use bitset to represent children present
-    Read 32 bytes and do bitset operations to extract matched index
-  else:
-    Use array to represent children
-    Read `num_children` bytes and do sequential search
+  Removal of [but]
 
-  Multi-char node (COMPRESSED node) will be packed as:
-  [num_prefix][prefixes][num_children][children]
+  1. Free the node of `ut` after clearing its value, as it has no children left
+  2. Rebuild ROOT without the child `b`
 
-  Removal of [be]
+  STATUS
+  ======
 
-  1. Realloc contents of PTR1 by removing "e" from the nodes list
-  2. Free PTR3
-  3. Realloc contents of ROOT by removing "b" from the nodes list
+  The index does not use the trie yet: only the benchmark suite builds it, to compare its memory and latency with
+  those of ART. A field can't select it until the search path stops depending on `art_leaf`, i.e. on the max score
+  ordering of `art_topk_iter`, on `token_leaf` and on the batched fuzzy walkers.
 
 */
 
 #include <cstdint>
 #include <cstddef>
-#include "logger.h"
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
 
-struct cvt_leaf_t {
-    size_t value;
-};
-
-enum CVT_NODE {
-    INTERNAL = 0,
-    LEAF = 1,
-    COMPRESSED = 2,
-};
+class levenshtein_automaton_t;
 
 class CVTrie {
-private:
-    size_t size;
-    uint8_t* root;
-
-    const uintptr_t PTR_MASK = ~(1ULL << 48ULL);
-
 public:
+    // return false to stop the iteration
+    typedef std::function<bool(const std::string& key, void* value)> cvt_callback;
 
-    CVTrie(): root(nullptr) {
-
+private:
+    static constexpr uint8_t HAS_VALUE = 1;
+    static constexpr size_t HEADER_SIZE = 4;
+    static constexpr size_t MAX_PREFIX_LEN = 255;
+
+    size_t num_keys = 0;
+    uint8_t* root = nullptr;
+
+    // unpacked copy of a node that is being changed
+    struct node_view_t {
+        bool has_value = false;
+        void* value = nullptr;
+        std::string prefix;
+        std::vector<uint8_t> chars;
+        std::vector<uint8_t*> children;
+    };
+
+    static bool has_value(const uint8_t* node) {
+        return node[0] & HAS_VALUE;
     }
 
-    inline void* get_ptr(const void* tagged_ptr) {
-        // Right shift of signed integer for sign extension is implementation-defined but works on major compilers
-        return (void*)( ((intptr_t)((uintptr_t)tagged_ptr << 16ULL) >> 16ULL) & ~3 );
+    static size_t prefix_len(const uint8_t* node) {
+        return node[1];
     }
 
-    inline void* tag_ptr(const void* ptr, const uint16_t offset, const CVT_NODE node_type) {
-        return (void*)(((uintptr_t)ptr & PTR_MASK) | (uint64_t(offset) << 48ULL) | uint64_t(node_type));
+    static size_t num_children(const uint8_t* node) {
+        uint16_t n;
+        std::memcpy(&n, node + 2, sizeof(n));
+        return n;
     }
 
-    inline uint8_t get_node_type(const void* tagged_ptr) {
-        return (uintptr_t)(tagged_ptr) & 3;
+    static const uint8_t* prefix(const uint8_t* node) {
+        return node + HEADER_SIZE;
     }
 
-    inline uint16_t get_offset(const void* ptr) {
-        return (uintptr_t)(ptr) >> 48ULL;
-    }
+    static void* value(const uint8_t* node);
 
-    void* find(const char* key, const uint8_t length);
+    static const uint8_t* chars(const uint8_t* node);
 
-    bool add(const char* key, const uint8_t length, void* value);
+    static uint8_t* child(const uint8_t* node, size_t index);
 
-};
+    static void set_child(uint8_t* node, size_t index, uint8_t* child_node);
+
+    // index of the child for `c`, or the number of children when there is none
+    static size_t find_child(const uint8_t* node, uint8_t c);
+
+    static size_t block_size(const uint8_t* node);
+
+    static node_view_t unpack(const uint8_t* node);
+
+    static uint8_t* pack(const node_view_t& view);
+
+    // a chain of nodes that holds `key` and ends with `value`
+    static uint8_t* new_chain(const uint8_t* key, size_t length, void* value);
+
+    // merges a node that has no value and a single child into that child, when their paths fit in one node
+    static uint8_t* merge_with_child(uint8_t* node);
+
+    static void destroy(uint8_t* node);
 
+    static bool iterate(const uint8_t* node, std::string& key, const cvt_callback& callback);
 
+    static bool fuzzy_walk(const uint8_t* node, std::string& key, levenshtein_automaton_t& automaton,
+                           uint32_t state, size_t max_words,
+                           std::vector<std::pair<std::string, void*>>& results);
+
+    // replaces the pointer to the node at the end of `path` in its parent, or the root
+    void replace_in_parent(const std::vector<std::pair<uint8_t*, size_t>>& path, uint8_t* node);
+
+public:
+
+    CVTrie() = default;
+
+    ~CVTrie();
+
+    CVTrie(const CVTrie&) = delete;
+
+    CVTrie& operator=(const CVTrie&) = delete;
+
+    void* find(const char* key, uint32_t length) const;
+
+    // Adds `key` or replaces its value. Returns true when the key is new.
+    bool add(const char* key, uint32_t length, void* value);
+
+    // Returns the value of the removed key, or nullptr when the key was not found.
+    void* remove(const char* key, uint32_t length);
+
+    // Calls `callback` on the keys that start with `prefix`, in lexicographic order.
+    void iter_prefix(const char* prefix, uint32_t length, const cvt_callback& callback) const;
+
+    // Collects up to `max_words` keys that are within `min_cost` to `max_cost` edits of `term`, in lexicographic
+    // order, with the same matching as `art_fuzzy_search`: in the `prefix` mode, a key matches when a prefix of it
+    // does.
+    void fuzzy_search(const char* term, uint32_t term_len, int min_cost, int max_cost, bool prefix,
+                      size_t max_words, std::vector<std::pair<std::string, void*>>& results) const;
+
+    size_t size() const {
+        return num_keys;
+    }
+
+    // bytes of the node blocks, without the overhead of the allocator
+    size_t memory_used() const;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// In-memory index of the ids of the documents of a collection, so that resolving an id to its sequence id, which
+// every upsert, update and delete by id does, need not be a point read of the store.
+//
+// In the `MAP` mode, the ids are held in a single arena along with an open addressing table of their sequence ids,
+// which costs about 34 bytes per document on top of the id itself. In the `BLOOM` mode, only a bloom filter of the
+// ids is held, at about 10 bits per document: it tells that an id is new, which is what most documents of an import
+// are, while the sequence ids of the ids that it may contain are still read from the store.
+class doc_id_index_t {
+public:
+    enum mode_t {
+        OFF,
+        MAP,
+        BLOOM
+    };
+
+    enum lookup_t {
+        NOT_FOUND,
+        FOUND,
+        // the store must be read to know
+        UNKNOWN
+    };
+
+    // bloom filters are added in layers of twice the capacity of the previous one as the ids grow
+    static constexpr size_t MIN_BLOOM_CAPACITY = 64 * 1024;
+    static constexpr size_t BLOOM_BITS_PER_ID = 10;
+    static constexpr size_t BLOOM_NUM_HASHES = 7;
+
+private:
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+    static constexpr uint32_t DELETED_SLOT = UINT32_MAX - 1;
+
+    struct slot_t {
+        uint64_t hash;
+        uint64_t id_offset;
+        uint32_t id_len = EMPTY_SLOT;
+        uint32_t seq_id;
+    };
+
+    struct bloom_layer_t {
+        std::vector<uint64_t> bits;
+        size_t capacity;
+        size_t num_ids = 0;
+    };
+
+    const mode_t mode;
+
+    mutable std::shared_mutex mutex;
+
+    std::string id_arena;
+    size_t id_arena_garbage = 0;
+    std::vector<slot_t> slots;
+    size_t num_ids = 0;
+    size_t num_deleted_slots = 0;
+
+    std::vector<bloom_layer_t> bloom_layers;
+
+    static uint64_t hash_id(const std::string& doc_id);
+
+    size_t find_slot(const std::string& doc_id, uint64_t hash) const;
+
+    void insert_slot(uint64_t hash, uint64_t id_offset, uint32_t id_len, uint32_t seq_id);
+
+    // rehashes the live ids into a table of `num_slots` slots, dropping the deleted ids from the arena
+    void rebuild(size_t num_slots);
+
+    static bool bloom_contains(const bloom_layer_t& layer, uint64_t hash);
+
+    void bloom_add(uint64_t hash);
+
+public:
+
+    explicit doc_id_index_t(mode_t mode): mode(mode) {
+
+    }
+
+    // `off`, `map` or `bloom`, where an unknown mode is taken as `off`
+    static mode_t parse_mode(const std::string& mode);
+
+    mode_t get_mode() const {
+        return mode;
+    }
+
+    void add(const std::string& doc_id, uint32_t seq_id);
+
+    // Ids can't be removed from a bloom filter, so a removed id is only found to be new again when the filter is
+    // built anew on the next load.
+    void remove(const std::string& doc_id);
+
+    lookup_t find(const std::string& doc_id, uint32_t& seq_id) const;
+
+    void clear();
+
+    size_t size() const;
+
+    size_t memory_used() const;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <filesystem>
 #include <mutex>
@@ -56,14 +58,23 @@ public:
     const std::string get_query_prefix(const nlohmann::json& model_config);
     static void set_model_dir(const std::string& dir);
     static const std::string& get_model_dir();
+    static void set_query_batch_window_ms(uint32_t window_ms);
+    static std::chrono::microseconds get_query_batch_window();
+    static void set_remote_embedding_concurrency(size_t concurrency);
+    static size_t get_remote_embedding_concurrency();
 
     ~EmbedderManager();
 
     inline static const std::string MODELS_REPO_URL = "https://models.typesense.org/public/";
     inline static const std::string MODEL_CONFIG_FILE = "config.json";
     inline static std::string model_dir = "";
+    // how long concurrent query embeddings of a local model are collected for a batch
+    inline static std::atomic<uint32_t> query_batch_window_ms = 0;
+    // how many batches of documents are sent to a remote model at a time while indexing
+    inline static std::atomic<size_t> remote_embedding_concurrency = 4;
 
     static const std::string get_absolute_model_path(const std::string& model_name);
+    static const std::string get_absolute_quantized_model_path(const std::string& model_name);
     static const std::string get_absolute_vocab_path(const std::string& model_name, const std::string& vocab_file_name);
     static const std::string get_absolute_config_path(const std::string& model_name);
     static const std::string get_model_url(const text_embedding_model& model);
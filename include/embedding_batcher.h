@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "text_embedder_remote.h"
+
+// Coalesces the embeddings of queries that are asked for concurrently into batches, so that a model runs once for
+// many of them instead of once for each.
+//
+// There is no thread of its own: the first caller to find no batch running becomes the leader, waits for the
+// window (if any) to collect more requests, runs the batch and hands the results to the others, which wait for
+// them. Requests that arrive while a batch runs form the next batch, so that under load batches form even without
+// a window.
+class embedding_batcher_t {
+public:
+    typedef std::function<std::vector<embedding_res_t>(const std::vector<std::string>&)> batch_func_t;
+
+    static constexpr size_t MAX_BATCH_SIZE = 32;
+
+private:
+    struct request_t {
+        const std::string& text;
+        embedding_res_t result;
+        bool done = false;
+
+        explicit request_t(const std::string& text): text(text) {}
+    };
+
+    const batch_func_t batch_func;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<request_t*> pending;
+    bool running = false;
+
+    size_t num_batches = 0;
+
+public:
+    explicit embedding_batcher_t(batch_func_t batch_func);
+
+    embedding_res_t embed(const std::string& text, std::chrono::microseconds window);
+
+    size_t get_num_batches();
+};
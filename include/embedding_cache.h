@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "json.hpp"
+
+// Caches the embeddings of search queries of a model, keyed on the text sent to the model (the query prefix of the
+// model followed by the query), so that a query that is searched again does not run the model or call the remote
+// API again. Each embedder has its own cache, which goes away with the model.
+//
+// Bounded by a number of entries per model, set for all models with `set_max_entries()`. Counters are for all
+// models too.
+class embedding_cache_t {
+private:
+    mutable std::mutex mutex;
+
+    // most recently used entry is at the front
+    std::list<std::pair<std::string, std::vector<float>>> entries;
+    std::unordered_map<std::string, std::list<std::pair<std::string, std::vector<float>>>::iterator> entry_index;
+
+    void erase(std::list<std::pair<std::string, std::vector<float>>>::iterator it);
+
+    static std::atomic<size_t> max_entries;
+
+    static std::atomic<uint64_t> hits;
+    static std::atomic<uint64_t> misses;
+    static std::atomic<uint64_t> evictions;
+    static std::atomic<uint64_t> num_entries;
+
+public:
+    static constexpr size_t DEFAULT_MAX_ENTRIES = 1000;
+
+    embedding_cache_t() = default;
+
+    ~embedding_cache_t();
+
+    bool get(const std::string& text, std::vector<float>& embedding);
+
+    void insert(const std::string& text, const std::vector<float>& embedding);
+
+    void clear();
+
+    size_t size() const;
+
+    // A `max_entries` of 0 disables the cache.
+    static void set_max_entries(size_t max_entries);
+
+    static void get_metrics(nlohmann::json& result);
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Sequence ids as a bitmap, so that a document is tested for membership in constant time.
+struct id_bitmap_t {
+    std::vector<uint64_t> words;
+    size_t num_ids = 0;
+
+    id_bitmap_t() = default;
+
+    // `ids` must be sorted
+    id_bitmap_t(const uint32_t* ids, size_t num_ids);
+
+    bool contains(uint32_t seq_id) const {
+        const size_t word = seq_id / 64;
+        return word < words.size() && (words[word] & (uint64_t(1) << (seq_id % 64))) != 0;
+    }
+
+    size_t num_bytes() const {
+        return words.size() * sizeof(uint64_t);
+    }
+};
+
+// Caches the ids matched by the filters of `_eval()` sort expressions as bitmaps, keyed on the filter tree, since the
+// same expressions are usually sent with every search of a collection, e.g. by merchandising rules.
+//
+// Entries are stamped with the write generation of the index they were computed at, and an entry of an older
+// generation is never returned.
+class eval_bitmap_cache_t {
+public:
+    typedef std::shared_ptr<const id_bitmap_t> bitmap_t;
+
+private:
+    struct entry_t {
+        bitmap_t bitmap;
+        uint64_t write_generation;
+    };
+
+    mutable std::mutex mutex;
+
+    // most recently used entry is at the front
+    std::list<std::pair<std::string, entry_t>> entries;
+    std::unordered_map<std::string, std::list<std::pair<std::string, entry_t>>::iterator> entry_index;
+
+    size_t max_entries;
+    size_t max_bytes;
+    size_t num_bytes = 0;
+
+    void erase(std::list<std::pair<std::string, entry_t>>::iterator it);
+
+public:
+    static constexpr size_t DEFAULT_MAX_ENTRIES = 64;
+
+    // bitmaps of more bytes than this, in total, are not held
+    static constexpr size_t DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+    explicit eval_bitmap_cache_t(size_t max_entries = DEFAULT_MAX_ENTRIES, size_t max_bytes = DEFAULT_MAX_BYTES);
+
+    bitmap_t get(const std::string& key, uint64_t write_generation);
+
+    void insert(const std::string& key, uint64_t write_generation, bitmap_t bitmap);
+
+    void clear();
+
+    size_t size() const;
+};
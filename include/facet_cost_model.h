@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Measured cost of counting the facet values of a field with its hash index and with its value index, so that
+// the strategy of a query is picked on how long each one actually took on results of about the same size,
+// instead of only on a heuristic of the result and the value counts.
+//
+// Costs are moving averages of wall time, kept per field and per power of two of the number of results. Until
+// both strategies have been measured on results of a size, the heuristic decides and the strategy that lacks
+// samples is tried every `EXPLORE_INTERVAL` choices. Once both are known, the cheaper one is picked, and the
+// other is tried again every `REEXPLORE_INTERVAL` choices unless it was a lot slower, so that the costs follow
+// the data as it changes.
+class facet_cost_model_t {
+public:
+    enum basis_t: uint8_t {
+        HEURISTIC,
+        MEASURED,
+        EXPLORATION
+    };
+
+    static constexpr size_t NUM_BUCKETS = 32;
+    static constexpr uint32_t MIN_SAMPLES = 3;
+    static constexpr uint32_t EXPLORE_INTERVAL = 8;
+    static constexpr uint32_t REEXPLORE_INTERVAL = 64;
+    static constexpr double MAX_REEXPLORE_COST_RATIO = 4.0;
+    static constexpr double COST_WEIGHT = 0.2;
+
+    // Returns whether the value index should be used for `num_results` results of the field, with the
+    // strategy the heuristic picked as the fallback.
+    bool choose(const std::string& field_name, size_t num_results, bool heuristic_use_value_index,
+                basis_t& basis);
+
+    void record(const std::string& field_name, size_t num_results, bool used_value_index, uint64_t duration_us);
+
+    // Average cost of the strategy on results of about `num_results`, false until it has been measured enough.
+    bool get_cost_us(const std::string& field_name, size_t num_results, bool value_index, double& cost_us) const;
+
+    void remove_field(const std::string& field_name);
+
+    static const char* basis_name(basis_t basis);
+
+private:
+    struct bucket_t {
+        // indexed by whether the value index was used
+        double costs_us[2] = {0, 0};
+        uint32_t num_samples[2] = {0, 0};
+        uint32_t num_choices = 0;
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::array<bucket_t, NUM_BUCKETS>> field_buckets;
+
+    static size_t get_bucket(size_t num_results);
+};
@@ -6,7 +6,10 @@
 #include <posting_list.h>
 #include <num_tree.h>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <field.h>
+#include "facet_value_sketch.h"
 
 struct facet_value_id_t {
     std::string facet_value;
@@ -37,6 +40,8 @@ struct facet_value_id_t {
 struct docid_count_t {
     uint32_t doc_id;
     uint32_t count;
+    // half width of the 95% confidence interval of an approximate count
+    uint32_t error_bound = 0;
 };
 
 class facet_index_t {
@@ -68,6 +73,10 @@ private:
         void* seq_ids;
         uint32_t facet_id;
         std::list<facet_count_t>::iterator facet_count_it;
+        // of the value in the ordinal column, 0 when the field has no ordinal column
+        uint16_t ordinal = 0;
+        // only for a value with more ids than the sample size
+        facet_value_sketch_t* sketch = nullptr;
 
         facet_id_seq_ids_t() {
             seq_ids = nullptr;
@@ -77,6 +86,11 @@ private:
         ~facet_id_seq_ids_t() {};
     };
     
+    // token of the values of a field => those values, which are keys of `fvalue_seq_ids`
+    struct value_token_index_t {
+        std::map<std::string, std::vector<const std::string*>> token_values;
+    };
+
     struct facet_doc_ids_list_t {
         std::map<std::string, facet_id_seq_ids_t> fvalue_seq_ids;
         std::list<facet_count_t> counts;
@@ -87,6 +101,23 @@ private:
         bool has_value_index = true;
         bool has_hash_index = true;
 
+        // seq_id => ordinal of its value, 0 for a document without a value. Only kept for a field whose documents
+        // have at most one value each and that has fewer than MAX_ORDINALS values, so that the values of a result
+        // set are counted in one pass over it instead of an intersection per value.
+        std::vector<uint16_t> seq_id_ordinals;
+        uint16_t num_ordinals = 0;
+        std::vector<uint16_t> free_ordinals;
+        bool has_ordinal_index = true;
+
+        // seq_id => facet id of its value, NO_FACET_ID for a document without a value. Only kept while the
+        // documents of the field have at most one value each, so that the group key of a document is an array load.
+        std::vector<uint32_t> seq_id_facet_ids;
+        bool has_facet_id_column = true;
+
+        // built by the first facet query after a value is added or removed, so that a facet query only visits the
+        // values that have tokens with the searched prefixes
+        std::shared_ptr<const value_token_index_t> value_token_index;
+
         facet_doc_ids_list_t() {
             fvalue_seq_ids.clear();
             counts.clear();
@@ -100,6 +131,8 @@ private:
                 if(it->second.seq_ids) {
                     ids_t::destroy_list(it->second.seq_ids);
                 }
+
+                delete it->second.sketch;
             }
     
             fvalue_seq_ids.clear();
@@ -114,6 +147,41 @@ private:
     // auto incrementing ID that is assigned to each unique facet value string
     std::atomic_uint32_t next_facet_id = 0;
 
+    // facet queries run concurrently, so the value token indices are built and replaced under this lock
+    std::mutex value_token_index_mutex;
+
+    static constexpr size_t MAX_ORDINALS = UINT16_MAX;
+
+    // result sets smaller than this are intersected with the value lists
+    static constexpr size_t ORDINAL_COUNT_MIN_RESULTS = 1024;
+
+    static void drop_ordinal_index(facet_doc_ids_list_t& facet_index);
+
+    static void set_seq_id_ordinal(facet_doc_ids_list_t& facet_index, uint32_t seq_id, uint16_t ordinal);
+
+    static void drop_facet_id_column(facet_doc_ids_list_t& facet_index);
+
+    static void set_seq_id_facet_id(facet_doc_ids_list_t& facet_index, uint32_t seq_id, uint32_t facet_id);
+
+    static void sketch_insert(facet_id_seq_ids_t& facet_id_seq_ids, const std::vector<uint32_t>& seq_ids);
+
+    static void sketch_erase(facet_id_seq_ids_t& facet_id_seq_ids, uint32_t seq_id);
+
+    static void count_ordinals(const facet_doc_ids_list_t& facet_index, const uint32_t* result_ids,
+                               size_t result_ids_len, std::vector<uint32_t>& ordinal_counts);
+
+    static void invalidate_value_token_index(facet_doc_ids_list_t& facet_index, std::mutex& mutex);
+
+    std::shared_ptr<const value_token_index_t> get_value_token_index(facet_doc_ids_list_t& facet_index,
+                                                                     const field& facet_field,
+                                                                     const std::vector<char>& symbols_to_index,
+                                                                     const std::vector<char>& token_separators);
+
+    // values that have a token with each of the prefixes `searched_tokens`, in no particular order
+    static void get_prefixed_values(const value_token_index_t& token_index,
+                                    const std::vector<std::string>& searched_tokens,
+                                    std::vector<const std::string*>& values);
+
     void get_stringified_value(const nlohmann::json& value, const field& afield,
                                std::vector<std::string>& values);
 
@@ -122,6 +190,8 @@ private:
 
 public:
 
+    static constexpr uint32_t NO_FACET_ID = UINT32_MAX;
+
     facet_index_t() = default;
 
     ~facet_index_t();
@@ -147,7 +217,8 @@ public:
                      const std::vector<char>& symbols_to_index, const std::vector<char>& token_separators,
                      const uint32_t* result_ids, size_t result_id_len,
                      size_t max_facet_count, std::map<std::string, docid_count_t>& found,
-                     bool is_wildcard_no_filter_query, const std::string& sort_order = "");
+                     bool is_wildcard_no_filter_query, const std::string& sort_order = "",
+                     bool approximate = false);
     
     size_t get_facet_indexes(const std::string& field, 
         std::map<uint32_t, std::vector<uint32_t>>& seqid_countIndexes);
@@ -163,8 +234,13 @@ public:
 
     bool has_value_index(const std::string& field_name);
 
+    bool has_ordinal_index(const std::string& field_name);
+
     posting_list_t* get_facet_hash_index(const std::string& field_name);
 
+    // nullptr when a document of the field has more than one value
+    const std::vector<uint32_t>* get_facet_id_column(const std::string& field_name);
+
     //get fhash=>int64 map for stats
     const spp::sparse_hash_map<uint32_t, int64_t>& get_fhash_int64_map(const std::string& field_name);
 
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "field.h"
+
+// Caches the facet counts of a result set, so that the pages of a query after the first one, which match the same
+// documents, reuse the facets of the first page instead of counting them again.
+//
+// The key holds a fingerprint of the IDs of the result set along with the facet spec, so queries that differ only in
+// their paging, sorting or highlighting share an entry, and so do different queries or filters that happen to match
+// the same documents. Entries are stamped with the write generation of the index they were computed at, and an
+// entry of an older generation is never returned.
+class facet_result_cache_t {
+public:
+    typedef std::shared_ptr<const std::vector<facet>> facets_t;
+
+private:
+    struct entry_t {
+        facets_t facets;
+        uint64_t write_generation;
+        size_t num_values;
+    };
+
+    mutable std::mutex mutex;
+
+    // most recently used entry is at the front
+    std::list<std::pair<std::string, entry_t>> entries;
+    std::unordered_map<std::string, std::list<std::pair<std::string, entry_t>>::iterator> entry_index;
+
+    size_t max_entries;
+    size_t max_values;
+    size_t num_values = 0;
+
+    void erase(std::list<std::pair<std::string, entry_t>>::iterator it);
+
+public:
+    static constexpr size_t DEFAULT_MAX_ENTRIES = 64;
+
+    // facets with more counted values than this, in total, are not held
+    static constexpr size_t DEFAULT_MAX_VALUES = 1024 * 1024;
+
+    explicit facet_result_cache_t(size_t max_entries = DEFAULT_MAX_ENTRIES, size_t max_values = DEFAULT_MAX_VALUES);
+
+    // `params` are the search parameters that the facet counts depend on besides the facet spec and the result set.
+    // A result set of `all_documents` is keyed by its size alone instead of a hash of its ids, since the write
+    // generation of an entry already tells whether the documents changed.
+    static std::string get_key(const std::vector<facet>& facets, const std::string& params,
+                               const uint32_t* result_ids, size_t result_ids_len, bool all_documents = false);
+
+    // number of values counted by the facets, which is what an entry costs to hold
+    static size_t num_facet_values(const std::vector<facet>& facets);
+
+    // copies what was counted for `from` into `to`, a facet of the same spec
+    static void copy_counts(const facet& from, facet& to);
+
+    facets_t get(const std::string& key, uint64_t write_generation);
+
+    void insert(const std::string& key, uint64_t write_generation, facets_t facets);
+
+    void clear();
+
+    size_t size() const;
+};
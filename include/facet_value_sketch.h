@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Sample of the ids of a facet value: the SAMPLE_SIZE ids with the smallest hashes. All values hash ids the same
+// way, so the samples of the values of a field are of the same ids, and the fraction of the sample of a value that
+// is in a result set estimates the fraction of all the ids of the value that are in it, without going over them.
+//
+// Approximate faceting of a large result set checks SAMPLE_SIZE ids per value instead of intersecting the result set
+// with every value. Values with at most SAMPLE_SIZE ids do not need a sample, their ids are counted exactly.
+class facet_value_sketch_t {
+private:
+    // (hash, seq_id), sorted on the hash
+    std::vector<std::pair<uint32_t, uint32_t>> samples;
+
+public:
+    static constexpr size_t SAMPLE_SIZE = 256;
+
+    static uint32_t hash(uint32_t seq_id);
+
+    // builds the sample of all the ids of a value
+    void build(const std::vector<uint32_t>& seq_ids);
+
+    void insert(uint32_t seq_id);
+
+    // Returns true when `seq_id` was sampled: the sample then lacks the id of the next smallest hash and has to be
+    // built again from the ids of the value.
+    bool erase(uint32_t seq_id);
+
+    size_t size() const {
+        return samples.size();
+    }
+
+    // number of sampled ids found in the sorted `result_ids`
+    size_t count_in(const uint32_t* result_ids, size_t result_ids_len) const;
+
+    // Estimate of how many of the `num_ids` ids of the value are in a result set that has `num_sampled` of the
+    // sampled ids, along with the half width of its 95% confidence interval.
+    static uint32_t estimate(size_t num_ids, size_t num_samples, size_t num_sampled, uint32_t& error_bound);
+};
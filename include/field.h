@@ -14,6 +14,7 @@
 #include "vector_query_ops.h"
 #include <mutex>
 #include "stemmer_manager.h"
+#include "eval_bitmap_cache.h"
 
 namespace field_types {
     // first field value indexed will determine the type
@@ -65,12 +66,19 @@ namespace fields {
     static const std::string model_name = "model_name";
     static const std::string range_index = "range_index";
     static const std::string stem = "stem";
+    static const std::string exact_match_index = "exact_match_index";
 
     // Some models require additional parameters to be passed to the model during indexing/querying
     // For e.g. e5-small model requires prefix "passage:" for indexing and "query:" for querying
     static const std::string indexing_prefix = "indexing_prefix";
     static const std::string query_prefix = "query_prefix";
     static const std::string api_key = "api_key";
+
+    // Options of the onnxruntime session of a local model
+    static const std::string intra_op_threads = "intra_op_threads";
+    static const std::string inter_op_threads = "inter_op_threads";
+    static const std::string execution_provider = "execution_provider";
+    static const std::string quantized = "quantized";
     static const std::string model_config = "model_config";
 
     static const std::string reference_helper_fields = ".ref";
@@ -119,6 +127,9 @@ struct field {
 
     bool stem = false;
     std::shared_ptr<Stemmer> stemmer;
+
+    // index the hashes of whole values, so that a query that equals a value is answered without a fuzzy search
+    bool exact_match_index = false;
   
     nlohmann::json hnsw_params;
 
@@ -383,6 +394,10 @@ struct field {
                 field_val[fields::reference] = field.reference;
             }
 
+            if(field.exact_match_index) {
+                field_val[fields::exact_match_index] = true;
+            }
+
             fields_json.push_back(field_val);
 
             if(!field.has_valid_type()) {
@@ -579,8 +594,8 @@ struct sort_by {
 
     struct eval_t {
         filter_node_t* filter_trees = nullptr;
-        std::vector<uint32_t*> eval_ids_vec;
-        std::vector<uint32_t> eval_ids_count_vec;
+        // ids matched by each of the filter trees
+        std::vector<std::shared_ptr<const id_bitmap_t>> eval_bitmaps;
         std::vector<int64_t> scores;
     };
 
@@ -674,8 +689,12 @@ public:
 
     // distance in meters
     static int64_t distance(const S2LatLng& a, const S2LatLng& b) {
-        double rdist = a.GetDistance(b).radians();
-        double dist = EARTH_RADIUS * rdist;
+        return distance(a.GetDistance(b));
+    }
+
+    // distance in meters spanned by an angle on the earth's surface
+    static int64_t distance(const S1Angle& angle) {
+        double dist = EARTH_RADIUS * angle.radians();
         return dist * METER_CONVERT;
     }
 };
@@ -691,6 +710,8 @@ struct facet_count_t {
     uint32_t array_pos = 0;
     //for sorting based on other field
     int64_t sort_field_val;
+    // half width of the 95% confidence interval of an approximate count
+    uint32_t error_bound = 0;
 };
 
 struct facet_stats_t {
@@ -730,10 +751,16 @@ struct facet {
 
     bool sampled = false;
 
+    // counts may be estimated from the samples of the facet values, see `facet_value_sketch_t`
+    bool approximate = false;
+
     bool is_wildcard_match = false;
     
     bool is_intersected = false;
 
+    // how the strategy of the facet was picked: "heuristic", "measured" or "exploration"
+    std::string strategy_basis;
+
     bool is_sort_by_alpha = false;
 
     std::string sort_order="";
@@ -777,7 +804,14 @@ struct facet_info_t {
     std::vector<std::vector<std::string>> fvalue_searched_tokens;
     bool use_facet_query = false;
     bool should_compute_stats = false;
+    // result set has every document, so stats are those of the whole field
+    bool use_stats_totals = false;
     bool use_value_index = false;
+    // when both strategies could count the facet, their costs are measured on the results of the query
+    bool measure_cost = false;
+    bool approximate = false;
+    size_t num_results = 0;
+    std::string strategy_basis;
     field facet_field{"", "", false};
 };
 
@@ -792,47 +826,5 @@ struct facet_value_t {
     uint32_t count;
     int64_t sort_field_val;
     nlohmann::json parent;
+    uint32_t count_error = 0;
 };
-
-struct facet_hash_values_t {
-    uint32_t length = 0;
-    std::vector<uint32_t> hashes;
-
-    facet_hash_values_t() {
-        length = 0;
-    }
-
-    facet_hash_values_t(facet_hash_values_t&& hash_values) noexcept {
-        length = hash_values.length;
-        hashes = hash_values.hashes;
-
-        hash_values.length = 0;
-        hash_values.hashes.clear();
-    }
-
-    facet_hash_values_t& operator=(facet_hash_values_t&& other) noexcept {
-        if (this != &other) {
-            hashes.clear();
-
-            hashes = other.hashes;
-            length = other.length;
-
-            other.hashes.clear();
-            other.length = 0;
-        }
-
-        return *this;
-    }
-
-    ~facet_hash_values_t() {
-        hashes.clear();
-    }
-
-    uint64_t size() const {
-        return length;
-    }
-
-    uint64_t back() const {
-        return hashes.back();
-    }
-};
\ No newline at end of file
@@ -63,11 +63,14 @@ struct filter {
                                                     const std::string& format_err_msg,
                                                     filter& filter_exp);
 
+    // The value of an expression can be a `{{name}}` placeholder, e.g. `id:={{ids}}`, which is bound to
+    // `filter_params[name]`. Filters with placeholders are tokenized once and then reused for other values.
     static Option<bool> parse_filter_query(const std::string& filter_query,
                                            const tsl::htrie_map<char, field>& search_schema,
                                            const Store* store,
                                            const std::string& doc_id_prefix,
-                                           filter_node_t*& root);
+                                           filter_node_t*& root,
+                                           const nlohmann::json& filter_params = nlohmann::json::object());
 };
 
 struct filter_node_t {
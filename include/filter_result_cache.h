@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "filter.h"
+
+// Caches the materialized IDs of filter sub-expressions of a collection, keyed on a canonical form of the filter
+// tree, so that the same `filter_by` sent with different queries is not recomputed each time.
+//
+// Entries are stamped with the write generation of the index they were computed at, and an entry of an older
+// generation is never returned.
+class filter_result_cache_t {
+public:
+    typedef std::shared_ptr<const std::vector<uint32_t>> ids_t;
+
+private:
+    struct entry_t {
+        ids_t ids;
+        uint64_t write_generation;
+    };
+
+    mutable std::mutex mutex;
+
+    // most recently used entry is at the front
+    std::list<std::pair<std::string, entry_t>> entries;
+    std::unordered_map<std::string, std::list<std::pair<std::string, entry_t>>::iterator> entry_index;
+
+    size_t max_entries;
+    size_t max_ids;
+    size_t num_ids = 0;
+
+    void erase(std::list<std::pair<std::string, entry_t>>::iterator it);
+
+    static std::string node_key(const filter_node_t* node, bool& is_cacheable);
+
+    static void collect_operand_keys(const filter_node_t* node, FILTER_OPERATOR filter_operator,
+                                     std::vector<std::string>& operand_keys, bool& is_cacheable);
+
+public:
+    static constexpr size_t DEFAULT_MAX_ENTRIES = 128;
+
+    // results with more IDs than this, in total, are not held
+    static constexpr size_t DEFAULT_MAX_IDS = 4 * 1024 * 1024;
+
+    explicit filter_result_cache_t(size_t max_entries = DEFAULT_MAX_ENTRIES, size_t max_ids = DEFAULT_MAX_IDS);
+
+    // Returns a key that is the same for equivalent filter trees (operands of a chain of the same operator are
+    // order independent), or an empty string when the result of the tree can't be cached, e.g. when it filters on a
+    // referenced collection.
+    static std::string get_key(const filter_node_t* filter_node);
+
+    ids_t get(const std::string& key, uint64_t write_generation);
+
+    void insert(const std::string& key, uint64_t write_generation, ids_t ids);
+
+    void clear();
+
+    size_t size() const;
+};
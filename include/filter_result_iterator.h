@@ -9,6 +9,7 @@
 #include "option.h"
 #include "posting_list.h"
 #include "id_list.h"
+#include "json.hpp"
 
 class Index;
 struct filter_node_t;
@@ -205,6 +206,9 @@ struct filter_result_t {
         delete[] coll_to_references;
     }
 
+    // Results spanning less than `DENSE_UNION_MAX_RANGE_FACTOR` IDs per matched document are unioned through a bitmap.
+    static constexpr size_t DENSE_UNION_MAX_RANGE_FACTOR = 32;
+
     static void and_filter_results(const filter_result_t& a, const filter_result_t& b, filter_result_t& result);
 
     static void or_filter_results(const filter_result_t& a, const filter_result_t& b, filter_result_t& result);
@@ -222,6 +226,10 @@ struct filter_result_t {
     constexpr uint16_t bool_filter_ids_threshold = 20'000;
 #endif
 
+/// An AND is computed by probing the larger subtree with the ids of the smaller one only when the estimate of the
+/// larger one is at least these many times the size of the smaller result.
+constexpr uint16_t lazy_and_min_ratio = 8;
+
 struct filter_result_iterator_timeout_info {
     filter_result_iterator_timeout_info(uint64_t search_begin_us, uint64_t search_stop_us);
 
@@ -267,9 +275,26 @@ private:
 
     std::unique_ptr<filter_result_iterator_timeout_info> timeout_info;
 
+    /// Key of this node in the index's filter result cache. Empty if the result can't be cached or already is.
+    std::string cache_key;
+
     /// Initializes the state of iterator node after it's creation.
     void init();
 
+    /// Loads the result of the node from the index's filter result cache.
+    /// \return Whether the result was found in the cache.
+    bool load_cached_filter_result();
+
+    /// Holds the materialized result of the node in the index's filter result cache.
+    void cache_filter_result();
+
+    /// Returns true if, in case of an AND, intersecting the materialized left subtree with the right subtree by
+    /// skipping the latter to each id of the former is estimated to be cheaper than materializing the right subtree.
+    [[nodiscard]] bool should_probe_right_subtree() const;
+
+    /// Collects the ids of left_result that are matched by the right subtree into result.
+    void probe_right_subtree(const filter_result_t& left_result, filter_result_t& result);
+
     /// Performs AND on the subtrees of operator.
     void and_filter_iterators();
 
@@ -330,6 +355,10 @@ public:
     /// Recursively computes the result of each node and stores the final result in the root node.
     void compute_iterators();
 
+    /// Describes the iterator tree: the operators, the fields filtered on and the estimated number of matches of each
+    /// node, and which nodes have already been materialized.
+    [[nodiscard]] nlohmann::json get_plan() const;
+
     /// Returns a tri-state:
     ///     0: id is not valid
     ///     1: id is valid
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include "option.h"
+
+// Scores the rows of a flat vector search on a GPU through cuBLAS, as a matrix product of the query vectors and the
+// candidate rows. The CUDA runtime and cuBLAS are loaded at runtime, like the CUDA provider of the embedding models,
+// so that the server does not depend on them when there is no GPU.
+//
+// Rows have to be copied to the device for each batch, so only batches with enough work to pay for the copy are
+// offloaded, see `should_offload()`.
+class GpuVectorScorer {
+public:
+    // batches with fewer multiply-adds than this are scored faster on the CPU than they are copied to the device
+    static constexpr size_t MIN_OFFLOAD_MULTIPLY_ADDS = 16 * 1024 * 1024;
+
+    // ids of a flat search are collected in batches of this size when they are scored on the GPU
+    static constexpr size_t BATCH_SIZE = 64 * 1024;
+
+private:
+    typedef int (*cuda_malloc_t)(void**, size_t);
+    typedef int (*cuda_free_t)(void*);
+    typedef int (*cuda_memcpy_t)(void*, const void*, size_t, int);
+    typedef int (*cuda_get_device_count_t)(int*);
+    typedef int (*cublas_create_t)(void**);
+    typedef int (*cublas_destroy_t)(void*);
+    typedef int (*cublas_sgemm_t)(void*, int, int, int, int, int, const float*, const float*, int,
+                                  const float*, int, const float*, float*, int);
+
+    void* cudart_lib = nullptr;
+    void* cublas_lib = nullptr;
+
+    cuda_malloc_t cuda_malloc = nullptr;
+    cuda_free_t cuda_free = nullptr;
+    cuda_memcpy_t cuda_memcpy = nullptr;
+    cublas_destroy_t cublas_destroy = nullptr;
+    cublas_sgemm_t cublas_sgemm = nullptr;
+
+    // a single handle and set of device buffers, which are grown as needed and shared by the searches in turn
+    std::mutex mutex;
+    void* cublas_handle = nullptr;
+    float* device_queries = nullptr;
+    float* device_rows = nullptr;
+    float* device_products = nullptr;
+    size_t queries_capacity = 0;
+    size_t rows_capacity = 0;
+    size_t products_capacity = 0;
+
+    std::atomic<bool> available = false;
+
+    GpuVectorScorer() = default;
+
+    ~GpuVectorScorer() = default;
+
+    bool reserve(float*& buffer, size_t& capacity, size_t size);
+
+public:
+
+    static GpuVectorScorer& get_instance() {
+        static GpuVectorScorer instance;
+        return instance;
+    }
+
+    GpuVectorScorer(GpuVectorScorer const&) = delete;
+
+    void operator=(GpuVectorScorer const&) = delete;
+
+    // Loads the CUDA runtime and cuBLAS, and checks that there is a device.
+    Option<bool> init();
+
+    bool is_available() const {
+        return available;
+    }
+
+    bool should_offload(size_t num_queries, size_t num_rows, size_t num_dim) const {
+        return available && num_queries * num_rows * num_dim >= MIN_OFFLOAD_MULTIPLY_ADDS;
+    }
+
+    // Inner products of the `num_queries` query vectors and the `num_rows` rows, which are laid out one after the
+    // other, into `products[row * num_queries + query]`. Returns false when the device fails, so that the batch is
+    // scored on the CPU instead.
+    bool inner_products(const float* queries, size_t num_queries, const float* rows, size_t num_rows,
+                        size_t num_dim, float* products);
+
+    void dispose();
+};
@@ -1,8 +1,96 @@
 #pragma once
 #include <mutex>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "option.h"
 
+class housekeeping_ctx_t;
+
+// A background task of the housekeeper, which is run again every `get_interval_s()` seconds.
+struct housekeeping_task_t {
+    enum priority_t {
+        HIGH,
+        NORMAL,
+        LOW
+    };
+
+    std::string name;
+    priority_t priority = NORMAL;
+
+    // read on every pass, so that the interval can follow the config, where 0 disables the task
+    std::function<uint32_t()> get_interval_s;
+
+    std::function<void(housekeeping_ctx_t&)> run;
+
+    // state of the task, which is guarded by the mutex of the housekeeper
+    uint64_t last_run_s = 0;
+    uint64_t last_duration_ms = 0;
+    uint64_t num_runs = 0;
+    uint64_t num_cancelled = 0;
+    uint64_t num_deferred = 0;
+    bool running = false;
+    // left over by the previous pass
+    bool deferred = false;
+    size_t progress_done = 0;
+    size_t progress_total = 0;
+    std::string last_result;
+
+    std::atomic<bool> cancel_requested = false;
+};
+
+// Handed to a running task, which reports its progress through it and stops between its units of work once
+// `should_stop()`. A task that stops with work left calls `set_unfinished()`: it's then run again first on the next
+// pass, without waiting for its interval, so it should resume where it left off.
+class housekeeping_ctx_t {
+private:
+    housekeeping_task_t& task;
+    const std::atomic<bool>& quit;
+    const std::chrono::steady_clock::time_point deadline;
+    std::mutex& mutex;
+    bool unfinished = false;
+
+public:
+    housekeeping_ctx_t(housekeeping_task_t& task, const std::atomic<bool>& quit,
+                       std::chrono::steady_clock::time_point deadline, std::mutex& mutex):
+                       task(task), quit(quit), deadline(deadline), mutex(mutex) {
+
+    }
+
+    // true when the server is stopping, the task was cancelled or the pass has spent its budget
+    bool should_stop() const {
+        return quit || task.cancel_requested || std::chrono::steady_clock::now() >= deadline;
+    }
+
+    void set_progress(size_t done, size_t total) {
+        std::unique_lock lock(mutex);
+        task.progress_done = done;
+        task.progress_total = total;
+    }
+
+    void set_result(const std::string& result) {
+        std::unique_lock lock(mutex);
+        task.last_result = result;
+    }
+
+    void set_unfinished() {
+        unfinished = true;
+    }
+
+    bool is_unfinished() const {
+        return unfinished;
+    }
+};
+
+// Runs the low priority background tasks of the server on a single thread. A pass wakes up every minute and runs
+// the tasks that are due, from the highest priority to the lowest, until it has spent `housekeeping-budget-ms`:
+// the tasks that are left over are run first on the next pass. The I/O of compactions is budgeted by the rate
+// limiter of the store.
 class HouseKeeper {
 private:
     mutable std::mutex mutex;
@@ -11,13 +99,20 @@ private:
     std::atomic<bool> quit = false;
     std::atomic<uint32_t> hnsw_repair_interval_s = 1800;
 
+    // guards the tasks and their state
+    mutable std::mutex tasks_mutex;
+    std::vector<std::shared_ptr<housekeeping_task_t>> tasks;
+
     HouseKeeper() {}
 
     ~HouseKeeper() {}
 
+    void run_task(housekeeping_task_t& task, uint64_t now_s, std::chrono::steady_clock::time_point deadline);
 
 public:
 
+    static constexpr uint32_t PASS_INTERVAL_S = 60;
+
     static HouseKeeper &get_instance() {
         static HouseKeeper instance;
         return instance;
@@ -27,9 +122,23 @@ public:
 
     void operator=(HouseKeeper const &) = delete;
 
+    // adds the built-in tasks
     void init(uint32_t interval_seconds);
 
     void run();
 
     void stop();
+
+    // A task is first due `get_interval_s()` seconds after it is added. A task of the same name is replaced.
+    void add_task(const std::shared_ptr<housekeeping_task_t>& task);
+
+    void remove_task(const std::string& name);
+
+    // Asks the task to stop its current run.
+    Option<bool> cancel_task(const std::string& name);
+
+    // Runs the tasks that are due at `now_s`, returning the number of tasks that were run.
+    size_t run_due_tasks(uint64_t now_s, uint64_t budget_ms);
+
+    nlohmann::json get_tasks_json() const;
 };
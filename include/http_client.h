@@ -2,6 +2,7 @@
 
 #include <string>
 #include <map>
+#include <atomic>
 #include <curl/curl.h>
 #include "http_data.h"
 #include "http_server.h"
@@ -14,6 +15,19 @@ private:
     static std::string api_key;
     static std::string ca_cert_path;
 
+    // Connections, DNS lookups and TLS sessions are shared by the handles of blocking requests, so that a request
+    // to a host that was recently called (the leader, a remote embedding API) reuses an idle connection to it
+    // instead of repeating the TCP and TLS handshakes.
+    static CURLSH* share;
+
+    static std::atomic<uint64_t> num_requests;
+    static std::atomic<uint64_t> num_new_connections;
+
+    static void set_shared_options(CURL* curl);
+
+    // counts whether the request of `curl` opened a new connection
+    static void record_connection(CURL* curl);
+
     HttpClient() = default;
 
     ~HttpClient() = default;
@@ -52,6 +66,10 @@ public:
 
     void init(const std::string & api_key);
 
+    void dispose();
+
+    static void get_metrics(nlohmann::json& result);
+
     static long download_file(const std::string& url, const std::string& file_path);
 
     static long get_response(const std::string& url, std::string& response,
@@ -4,6 +4,7 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <functional>
 #include <future>
 #include <chrono>
 #include <iomanip>
@@ -21,6 +22,8 @@ extern "C" {
 
 using TimePoint = std::chrono::high_resolution_clock::time_point;
 
+struct http_event_loop_t;
+
 struct h2o_custom_timer_t {
     h2o_timer_t timer;
     void *data;
@@ -51,6 +54,9 @@ struct http_res {
     // indicates whether follower is proxying this response stream from leader
     bool proxied_stream = false;
 
+    // when set, `body` is already encoded, e.g. a gzip compressed response from the cache
+    std::string content_encoding;
+
     std::mutex mcv;
     std::condition_variable cv;
     bool ready;
@@ -177,6 +183,13 @@ struct cached_res_t {
     uint32_t ttl;
     uint64_t hash;
 
+    // write generations of the collections that the response was computed from
+    std::vector<std::pair<std::string, uint64_t>> collection_generations;
+
+    // when set, `body` holds the gzip compressed response of `uncompressed_size` bytes
+    bool compressed = false;
+    size_t uncompressed_size = 0;
+
     bool operator == (const cached_res_t& res) const {
         return hash == res.hash;
     }
@@ -194,6 +207,13 @@ struct cached_res_t {
         this->ttl = ttl;
         this->hash = hash;
     }
+
+    void load(uint32_t status_code, const std::string& content_type_header, const std::string& body,
+              const TimePoint created_at, const uint32_t ttl, uint64_t hash,
+              const std::vector<std::pair<std::string, uint64_t>>& collection_generations) {
+        load(status_code, content_type_header, body, created_at, ttl, hash);
+        this->collection_generations = collection_generations;
+    }
 };
 
 struct ip_addr_str_t {
@@ -222,18 +242,21 @@ public:
     h2o_iovec_t res_buff;
 
     std::string res_content_type;
+    std::string res_content_encoding;
     int status = 0;
     const char* reason = nullptr;
 
     h2o_generator_t* generator = nullptr;
 
-    void set_response(uint32_t status_code, const std::string& content_type, std::string& body) {
+    void set_response(uint32_t status_code, const std::string& content_type, std::string& body,
+                      const std::string& content_encoding) {
         std::string().swap(res_body);
         res_body = std::move(body);
         res_buff = h2o_iovec_t{.base = res_body.data(), .len = res_body.size()};
 
         if(is_res_start) {
             res_content_type = std::move(content_type);
+            res_content_encoding = content_encoding;
             status = (int)status_code;
             reason = http_res::get_status_reason(status_code);
             is_res_start = false;
@@ -252,7 +275,13 @@ public:
 struct http_req {
     static constexpr const char* AUTH_HEADER = "x-typesense-api-key";
     static constexpr const char* USER_HEADER = "x-typesense-user-id";
+    // `strong` makes a read wait for the writes that the leader had committed when it began
+    static constexpr const char* READ_CONSISTENCY_HEADER = "x-typesense-read-consistency";
     static constexpr const char* AGENT_HEADER = "user-agent";
+    // `high` lets a search through admission control beyond its concurrency limit
+    static constexpr const char* PRIORITY_HEADER = "x-typesense-priority";
+    // search results are encoded as MessagePack when this header asks for `application/msgpack`
+    static constexpr const char* ACCEPT_HEADER = "accept";
 
     h2o_req_t* _req;
     std::string http_method;
@@ -275,6 +304,12 @@ struct http_req {
     // for deffered processing of async handlers
     h2o_custom_timer_t defer_timer;
 
+    // event loop that owns the connection of the request: not set for requests replayed from the raft log
+    http_event_loop_t* event_loop = nullptr;
+
+    // whether the `accept-encoding` header of the client allows a gzip compressed response
+    bool accepts_gzip = false;
+
     uint64_t start_ts;
 
     // timestamp from the underlying http library
@@ -345,6 +380,11 @@ struct http_req {
             AppMetrics::get_instance().increment_duration(metric_identifier, ms_since_start);
             AppMetrics::get_instance().increment_write_metrics(route_hash, ms_since_start);
 
+            const auto collection_it = params.find("collection");
+            AppMetrics::get_instance().record_request_latency(route_hash,
+                                                              collection_it == params.end() ? "" : collection_it->second,
+                                                              now - start_ts);
+
             bool log_slow_searches = config.get_log_slow_searches_time_ms() >= 0 &&
                                      int(ms_since_start) >= config.get_log_slow_searches_time_ms() &&
                                      (path_without_query == "/multi_search" ||
@@ -546,6 +586,8 @@ struct http_message_dispatcher {
 
 struct async_stream_response_t {
     std::vector<std::string> response_chunks;
+    // when set, is called with every chunk as it is received, and returns false to abort the transfer
+    std::function<bool(const std::string&)> on_chunk;
     std::mutex mutex;
     std::condition_variable cv;
     bool ready = false;
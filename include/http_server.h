@@ -83,7 +83,7 @@ public:
         res_state.is_req_early_exit = (res_generator->rpath->async_req && res->final && !req->last_chunk_aggregate);
         res_state.send_state = res->final ? H2O_SEND_STATE_FINAL : H2O_SEND_STATE_IN_PROGRESS;
         res_state.generator = (res_generator == nullptr) ? nullptr : &res_generator->h2o_generator;
-        res_state.set_response(res->status_code, res->content_type_header, res->body);
+        res_state.set_response(res->status_code, res->content_type_header, res->body, res->content_encoding);
     }
 
     bool is_alive() {
@@ -115,25 +115,33 @@ struct defer_processing_t {
 
 };
 
+// An event loop accepts the connections of its own listener and serves the requests of those connections. Since an
+// h2o request must only be touched from the loop of its connection, messages about a request go to that loop.
+struct http_event_loop_t {
+    h2o_context_t ctx{};
+    h2o_accept_ctx_t accept_ctx{};
+    h2o_socket_t* listener_socket = nullptr;
+    http_message_dispatcher* message_dispatcher = nullptr;
+    h2o_custom_timer_t ssl_refresh_timer;
+    HttpServer* server = nullptr;
+};
+
 class HttpServer {
 private:
     h2o_globalconf_t config;
     h2o_compress_args_t compress_args;
-    h2o_context_t ctx;
-    h2o_accept_ctx_t* accept_ctx;
     h2o_hostconf_t *hostconf;
-    h2o_socket_t* listener_socket;
+
+    // the first loop runs on the thread that calls `run()` and also owns the server wide timers
+    std::vector<http_event_loop_t*> event_loops;
 
     static const size_t ACTIVE_STREAM_WINDOW_SIZE = 196605;
     static const size_t REQ_TIMEOUT_MS = 60000;
 
     const uint64_t SSL_REFRESH_INTERVAL_MS;
 
-    h2o_custom_timer_t ssl_refresh_timer;
     h2o_custom_timer_t metrics_refresh_timer;
 
-    http_message_dispatcher* message_dispatcher;
-
     ReplicationState* replication_state;
 
     std::atomic<bool> exit_loop;
@@ -162,6 +170,9 @@ private:
 
     ThreadPool* meta_thread_pool;
 
+    // a sample of the system metrics that is still being taken
+    std::atomic<bool> metrics_sampling = false;
+
     bool (*auth_handler)(std::map<std::string, std::string>& params,
                          std::vector<nlohmann::json>& embedded_params_vec,
                          const std::string& body, const route_path& rpath,
@@ -169,7 +180,7 @@ private:
 
     static void on_accept(h2o_socket_t *listener, const char *err);
 
-    int setup_ssl(const char *cert_file, const char *key_file);
+    int setup_ssl(http_event_loop_t* event_loop, const char *cert_file, const char *key_file);
 
     static bool initialize_ssl_ctx(const char *cert_file, const char *key_file, h2o_accept_ctx_t* accept_ctx);
 
@@ -179,7 +190,11 @@ private:
 
     static void on_metrics_refresh_timeout(h2o_timer_t *entry);
 
-    int create_listener();
+    int create_listener(http_event_loop_t* event_loop);
+
+    void run_event_loop(http_event_loop_t* event_loop);
+
+    http_event_loop_t* get_event_loop(const std::shared_ptr<http_req>& req) const;
 
     h2o_pathconf_t *register_handler(h2o_hostconf_t *hostconf, const char *path,
                                      int (*on_req)(h2o_handler_t *, h2o_req_t *));
@@ -207,11 +222,13 @@ public:
                const std::string & ssl_cert_key_path,
                const uint64_t ssl_refresh_interval_ms,
                bool cors_enabled, const std::set<std::string>& cors_domains,
-               ThreadPool* thread_pool);
+               ThreadPool* thread_pool, size_t num_event_loops = 1);
 
     ~HttpServer();
 
-    http_message_dispatcher* get_message_dispatcher() const;
+    // dispatcher of the loop that serves `req`, or of the first loop for a request that is not tied to a connection,
+    // e.g. a write that is replayed from the raft log
+    http_message_dispatcher* get_message_dispatcher(const std::shared_ptr<http_req>& req) const;
 
     ReplicationState* get_replication_state() const;
 
@@ -293,5 +310,8 @@ public:
 
     int64_t get_num_queued_writes();
 
+    // depth and wait time of the write queue of each collection
+    void get_num_queued_writes(nlohmann::json& coll_queue_stats);
+
     void decr_pending_writes();
 };
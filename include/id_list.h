@@ -2,7 +2,7 @@
 
 #include <map>
 #include <unordered_map>
-#include "sorted_array.h"
+#include "adaptive_sorted_array.h"
 
 typedef uint32_t last_id_t;
 
@@ -13,9 +13,9 @@ typedef uint32_t last_id_t;
 class id_list_t {
 public:
 
-    // A block stores a sorted list of Document IDs compactly
+    // A block stores a sorted list of Document IDs compactly (as a bitmap when they are dense)
     struct block_t {
-        sorted_array ids;
+        adaptive_sorted_array ids;
 
         // link to next block
         block_t* next = nullptr;
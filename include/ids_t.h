@@ -4,6 +4,7 @@
 #include <vector>
 #include "id_list.h"
 #include "threadpool.h"
+#include "search_profile.h"
 
 #define IS_COMPACT_IDS(x) (((uintptr_t)(x) & 1))
 #define SET_COMPACT_IDS(x) ((void*)((uintptr_t)(x) | 1))
@@ -50,6 +51,15 @@ public:
         ThreadPool* thread_pool;
         size_t parallelize_min_ids;
 
+        // intersections that are running in parallel, which share the threads of the pool
+        static inline std::atomic<size_t> num_parallel_intersections = 0;
+
+        static constexpr size_t PARTITIONS_PER_WORKER = 4;
+        static constexpr size_t SKEWED_PARTITIONS_PER_WORKER = 16;
+
+        // ratio of the number of blocks of the largest list to that of the smallest, from which lists are skewed
+        static constexpr size_t SKEW_RATIO = 8;
+
         block_intersector_t(const std::vector<void*>& raw_id_lists,
                             id_list_t::result_iter_state_t& iter_state,
                             ThreadPool* thread_pool,
@@ -88,6 +98,8 @@ public:
 
     static uint32_t first_id(const void* obj);
 
+    static uint32_t last_id(const void* obj);
+
     static bool contains(const void* obj, uint32_t id);
 
     static void merge(const std::vector<void*>& id_lists, std::vector<uint32_t>& result_ids);
@@ -109,17 +121,21 @@ public:
 
 template<class T>
 bool ids_t::block_intersector_t::intersect(T func, size_t concurrency) {
-    // Split id lists into N chunks and intersect them in-parallel
+    // Split id lists into partitions and intersect them in-parallel
     // 1. Sort id lists by number of blocks
-    // 2. Iterate on the id list with least number of blocks on N-block windows
+    // 2. Iterate on the id list with least number of blocks on windows of an equal number of blocks
     // 3. On each window, pick the last block's last ID and identify blocks from other lists containing that ID
-    // 4. Construct N groups of iterators this way (the last block must overlap on both sides of the window)
+    // 4. Construct a group of iterators per window this way (the last block must overlap on both sides of the window)
+    //
+    // There are several partitions per worker, which the workers claim in order as they finish the previous one, so
+    // that a window which spans many more blocks of the other lists than the rest does not hold up the others. `func`
+    // is called with `iter_state.index` set to the worker, which is below `concurrency`.
 
     if(id_lists.empty()) {
         return true;
     }
 
-    if(id_lists[0]->num_ids() < parallelize_min_ids) {
+    if(id_lists[0]->num_ids() < parallelize_min_ids || concurrency <= 1 || thread_pool == nullptr) {
         std::vector<id_list_t::iterator_t> its;
         its.reserve(id_lists.size());
 
@@ -131,35 +147,104 @@ bool ids_t::block_intersector_t::intersect(T func, size_t concurrency) {
         return true;
     }
 
-    std::vector<std::vector<id_list_t::iterator_t>> partial_its_vec(concurrency);
-    split_lists(concurrency, partial_its_vec);
+    // intersections share the threads of the pool, so that a few large ones do not take up all of them
+    struct parallel_guard_t {
+        parallel_guard_t() {
+            num_parallel_intersections++;
+        }
+
+        ~parallel_guard_t() {
+            num_parallel_intersections--;
+        }
+    } parallel_guard;
+
+    const size_t pool_share = std::max<size_t>(1, thread_pool->num_threads() / num_parallel_intersections.load());
+    const size_t num_workers = std::min(concurrency, pool_share);
+
+    // when the largest list has many more blocks than the smallest, the windows differ more in cost
+    const bool is_skewed = id_lists.back()->num_blocks() >= id_lists[0]->num_blocks() * SKEW_RATIO;
+    const size_t partitions_per_worker = is_skewed ? SKEWED_PARTITIONS_PER_WORKER : PARTITIONS_PER_WORKER;
+    const size_t num_partitions = std::max<size_t>(1, std::min<size_t>(id_lists[0]->num_blocks(),
+                                                                       num_workers * partitions_per_worker));
+
+    // helpers can start running after this call has returned, so they only hold on to shared state and touch
+    // `func` only after claiming a partition, which this call waits for
+    struct state_t {
+        std::vector<std::vector<id_list_t::iterator_t>> partial_its_vec;
+        std::vector<id_list_t::result_iter_state_t> worker_iter_states;
+        std::vector<uint64_t> worker_busy_us;
+        std::atomic<size_t> next_partition{0};
+        size_t num_done = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    auto state = std::make_shared<state_t>();
+    state->partial_its_vec.resize(num_partitions);
+    split_lists(num_partitions, state->partial_its_vec);
+
+    for(size_t i = 0; i < num_workers; i++) {
+        state->worker_iter_states.push_back(iter_state);
+        state->worker_iter_states.back().index = i;
+    }
+
+    state->worker_busy_us.resize(num_workers, 0);
+    auto* func_ptr = &func;
+
+    auto run_partitions = [state, func_ptr, num_partitions](size_t worker_index) {
+        size_t partition;
+        while((partition = state->next_partition++) < num_partitions) {
+            auto& partial_its = state->partial_its_vec[partition];
+            auto begin = std::chrono::steady_clock::now();
+            std::exception_ptr error;
+
+            try {
+                if(!partial_its.empty()) {
+                    id_list_t::block_intersect<T>(partial_its, state->worker_iter_states[worker_index], *func_ptr);
+                }
+            } catch(...) {
+                error = std::current_exception();
+            }
 
-    size_t num_processed = 0;
-    std::mutex m_process;
-    std::condition_variable cv_process;
-    size_t num_non_empty = 0;
+            state->worker_busy_us[worker_index] += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - begin).count();
 
-    for(size_t i = 0; i < partial_its_vec.size(); i++) {
-        auto& partial_its = partial_its_vec[i];
+            std::unique_lock<std::mutex> lock(state->mutex);
+            if(error && !state->error) {
+                state->error = error;
+            }
 
-        if(partial_its.empty()) {
-            continue;
+            if(++state->num_done == num_partitions) {
+                state->cv.notify_one();
+            }
         }
+    };
 
-        num_non_empty++;
+    for(size_t i = 1; i < num_workers; i++) {
+        thread_pool->enqueue_with_priority(ThreadPool::HIGH_PRIORITY, run_partitions, i);
+    }
 
-        thread_pool->enqueue([this, i, &func, &partial_its, &num_processed, &m_process, &cv_process]() {
-            auto iter_state_copy = iter_state;
-            iter_state_copy.index = i;
-            id_list_t::block_intersect<T>(partial_its, iter_state_copy, func);
-            std::unique_lock<std::mutex> lock(m_process);
-            num_processed++;
-            cv_process.notify_one();
-        });
+    run_partitions(0);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&state, num_partitions]() { return state->num_done == num_partitions; });
+
+    if(search_profile != nullptr) {
+        // time of the busiest worker over the mean time of the workers, which is 1 when the work is even
+        uint64_t total_busy_us = 0, max_busy_us = 0;
+        for(auto busy_us: state->worker_busy_us) {
+            total_busy_us += busy_us;
+            max_busy_us = std::max(max_busy_us, busy_us);
+        }
+
+        const double imbalance = (total_busy_us == 0) ? 1.0 : (double(max_busy_us) * num_workers / total_busy_us);
+        search_profile->add_intersection_split(num_partitions, num_workers, imbalance);
     }
 
-    std::unique_lock<std::mutex> lock_process(m_process);
-    cv_process.wait(lock_process, [&](){ return num_processed == num_non_empty; });
+    if(state->error) {
+        std::rethrow_exception(state->error);
+    }
 
     return true;
 }
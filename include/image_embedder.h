@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <mutex>
@@ -21,6 +22,8 @@ class ImageEmbedder {
 };
 
 
+// Images of a batch are decoded and resized on the threads of the collection manager's pool, while the images that
+// are ready already run through the model, `INFERENCE_BATCH_SIZE` at a time.
 class CLIPImageEmbedder : public ImageEmbedder {
     private:
         // use shared session with text embedder
@@ -28,11 +31,24 @@ class CLIPImageEmbedder : public ImageEmbedder {
         std::shared_ptr<Ort::Env> env_;
         std::mutex mutex_;
         CLIPImageProcessor image_processor_;     
+
+        // counters of all the image models
+        static std::atomic<uint64_t> num_images_embedded;
+        static std::atomic<uint64_t> num_images_failed;
+        static std::atomic<uint64_t> process_time_us;
+        static std::atomic<uint64_t> inference_time_us;
+
+        std::vector<embedding_res_t> run_inference(std::vector<processed_image_t>& images);
     public:
+        // larger batches barely raise the throughput of the CPU, and hold back the first results for longer
+        static constexpr size_t INFERENCE_BATCH_SIZE = 16;
+
         CLIPImageEmbedder(const std::shared_ptr<Ort::Session>& session, const std::shared_ptr<Ort::Env>& env, const std::string& model_path);
         embedding_res_t embed(const std::string& image_encoded) override;
         std::vector<embedding_res_t> batch_embed(const std::vector<std::string>& inputs) override;
         virtual ImageEmbedderType get_image_embedder_type() override {
             return ImageEmbedderType::clip;
         }
+
+        static void get_metrics(nlohmann::json& result);
 };
\ No newline at end of file
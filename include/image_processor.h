@@ -16,11 +16,12 @@ class ImageProcessor {
 };
 
 
+// Decodes, resizes and normalizes an image with the pre-processing model of CLIP. Images can be processed from several
+// threads at once, since running a session is thread safe.
 class CLIPImageProcessor : public ImageProcessor {
     private:
         Ort::Env env_;
         std::unique_ptr<Ort::Session> session_;
-        std::mutex mutex_;
 
     public:
         CLIPImageProcessor(const std::string& model_path);
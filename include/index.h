@@ -2,9 +2,11 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <mutex>
 #include <shared_mutex>
+#include <atomic>
 #include <condition_variable>
 #include <art.h>
 #include <number.h>
@@ -29,19 +31,27 @@
 #include "override.h"
 #include "vector_query_ops.h"
 #include "hnswlib/hnswlib.h"
+#include "vector_quantizer.h"
+#include "vector_column.h"
+#include "vector_file.h"
 #include "filter.h"
 #include "facet_index.h"
 #include "numeric_range_trie.h"
-
-static constexpr size_t ARRAY_FACET_DIM = 4;
-using facet_map_t = spp::sparse_hash_map<uint32_t, facet_hash_values_t>;
-using single_val_facet_map_t = spp::sparse_hash_map<uint32_t, uint32_t>;
-using array_mapped_facet_t = std::array<facet_map_t*, ARRAY_FACET_DIM>;
-using array_mapped_single_val_facet_t = std::array<single_val_facet_map_t*, ARRAY_FACET_DIM>;
+#include "filter_result_cache.h"
+#include "eval_bitmap_cache.h"
+#include "typo_candidate_cache.h"
+#include "memory_accounting.h"
+#include "facet_result_cache.h"
+#include "trigram_index.h"
+#include "facet_cost_model.h"
+#include "sort_column.h"
 
 static constexpr size_t ARRAY_INFIX_DIM = 4;
 using array_mapped_infix_t = std::vector<tsl::htrie_set<char>*>;
 
+// hash of a normalized value => sorted ids of the documents having that value
+using exact_match_index_t = spp::sparse_hash_map<uint64_t, std::vector<uint32_t>>;
+
 struct token_t {
     size_t position;
     std::string value;
@@ -111,6 +121,13 @@ enum drop_tokens_mode_t {
     both_sides,
 };
 
+// how the number of matches is reported as `found`
+enum class total_hits_t {
+    exact,
+    approx,
+    none,
+};
+
 struct drop_tokens_param_t {
     drop_tokens_mode_t mode = right_to_left;
     size_t token_limit = 1000;
@@ -265,6 +282,13 @@ struct index_record {
 
     }
 
+    index_record(size_t record_pos, uint32_t seq_id, nlohmann::json&& doc, index_operation_t operation,
+                 const DIRTY_VALUES& dirty_values):
+            position(record_pos), seq_id(seq_id), doc(std::move(doc)), operation(operation), is_update(false),
+            indexed(false), dirty_values(dirty_values) {
+
+    }
+
     index_record(index_record&& rhs) = default;
 
     index_record& operator=(index_record&& mE) = default;
@@ -309,18 +333,58 @@ public:
     }
 };
 
+// Sets or increments the value of a numeric field of a document in place
+struct numeric_update_t {
+    std::string field_name;
+    bool is_increment = false;
+    nlohmann::json value;
+};
+
+struct numeric_doc_update_t {
+    uint32_t seq_id = 0;
+    std::vector<numeric_update_t> updates;
+
+    // values of the updated fields after the update
+    Option<nlohmann::json> result = Option<nlohmann::json>(nlohmann::json::object());
+};
+
 struct hnsw_index_t {
+    // distances of float vectors
     hnswlib::InnerProductSpace* space;
+    // space of the graph when its vectors are quantized
+    sq8_space_t* quantized_space;
     hnswlib::HierarchicalNSW<float>* vecdex;
+    // float vectors of a quantized graph that are kept on disk, to rank candidates on their exact distances
+    vector_file_t* full_vectors = nullptr;
+    // float vectors laid out by seq_id, for flat searches over the ids of filters
+    vector_column_t* column = nullptr;
     size_t num_dim;
     vector_distance_type_t distance_type;
 
+    // neighbours of a quantized graph are searched among this many times as many candidates, which are then ranked
+    // on their distances to the float query
+    static constexpr size_t RERANK_FACTOR = 4;
+
     // ensures that this index is not dropped when it's being repaired
     std::mutex repair_m;
 
-    hnsw_index_t(size_t num_dim, size_t init_size, vector_distance_type_t distance_type, size_t M = 16, size_t ef_construction = 200) :
+    // adds and removes of points, so that a compacted graph is not swapped in after a write it missed
+    std::atomic<uint64_t> num_writes = 0;
+
+    // a graph is compacted once at least this many of its points, and this fraction of them, are deleted
+    static constexpr size_t MIN_COMPACTION_DELETED = 1000;
+    static constexpr float COMPACTION_DELETED_FRACTION = 0.25;
+
+    // Graphs start with room for this many points and grow as points are added, as the space of each point is
+    // allocated up front: a graph sized for a thousand points of a few hundred dimensions would cost megabytes in
+    // every one of the many collections that hold only a few documents.
+    static constexpr size_t INITIAL_CAPACITY = 16;
+
+    hnsw_index_t(size_t num_dim, size_t init_size, vector_distance_type_t distance_type, size_t M = 16, size_t ef_construction = 200,
+                 vector_quantization_t quantization = no_quantization) :
         space(new hnswlib::InnerProductSpace(num_dim)),
-        vecdex(new hnswlib::HierarchicalNSW<float>(space, init_size, M, ef_construction, 100, true)),
+        quantized_space(quantization == sq8 ? new sq8_space_t(num_dim) : nullptr),
+        vecdex(new hnswlib::HierarchicalNSW<float>(graph_space(), init_size, M, ef_construction, 100, true)),
         num_dim(num_dim), distance_type(distance_type) {
 
     }
@@ -328,9 +392,82 @@ struct hnsw_index_t {
     ~hnsw_index_t() {
         std::lock_guard lk(repair_m);
         delete vecdex;
+        delete full_vectors;
+        delete column;
+        delete quantized_space;
         delete space;
     }
 
+    hnswlib::SpaceInterface<float>* graph_space() const {
+        if(quantized_space != nullptr) {
+            return quantized_space;
+        }
+
+        return space;
+    }
+
+    static vector_quantization_t get_quantization(const nlohmann::json& hnsw_params) {
+        vector_quantization_t quantization = no_quantization;
+        if(hnsw_params.is_object() && hnsw_params.count("quantization") != 0 &&
+           hnsw_params["quantization"].is_string()) {
+            parse_vector_quantization(hnsw_params["quantization"].get<std::string>(), quantization);
+        }
+
+        return quantization;
+    }
+
+    static vector_storage_t get_storage(const nlohmann::json& hnsw_params) {
+        vector_storage_t storage = memory_storage;
+        if(hnsw_params.is_object() && hnsw_params.count("storage") != 0 && hnsw_params["storage"].is_string()) {
+            parse_vector_storage(hnsw_params["storage"].get<std::string>(), storage);
+        }
+
+        return storage;
+    }
+
+    static bool get_vector_column(const nlohmann::json& hnsw_params) {
+        return hnsw_params.is_object() && hnsw_params.count("vector_column") != 0 &&
+               hnsw_params["vector_column"].is_boolean() && hnsw_params["vector_column"].get<bool>();
+    }
+
+    // keeps the float vectors of a quantized graph in a file in `dir_path`
+    Option<bool> store_full_vectors(const std::string& dir_path);
+
+    void add_point(const float* values, size_t seq_id);
+
+    void remove_point(size_t seq_id);
+
+    bool needs_compaction() const;
+
+    // A new graph of the points that are not deleted, inserted in parallel on `thread_pool`. Points are copied as
+    // they are stored in this graph, so quantized points are not encoded again.
+    hnswlib::HierarchicalNSW<float>* build_compacted_graph(ThreadPool* thread_pool) const;
+
+    // Smallest distances of the `num_queries` query vectors to the vectors of `seq_ids`, which are infinite for the
+    // ids that have no vector. Large batches of a vector column are scored on the GPU when there is one.
+    void flat_distances(const float* const* queries, size_t num_queries, const uint32_t* seq_ids, size_t num_ids,
+                        std::vector<float>& distances) const;
+
+    // values of the vector of `seq_id`, decoded when the graph is quantized and its float vectors are not kept;
+    // throws when there is no such vector
+    std::vector<float> get_vector(size_t seq_id) const;
+
+    // nearest neighbours of `query`, closest first
+    std::vector<std::pair<float, size_t>> search_knn(const float* query, size_t k, size_t ef,
+                                                     hnswlib::BaseFilterFunctor* filter) const;
+
+    // the ef of a filtered walk is raised up to this many times the ef of the query
+    static constexpr size_t MAX_FILTERED_EF_FACTOR = 16;
+
+    // Whether the `num_filtered` points of a filter are better scored one by one than searched for in the graph. A
+    // walk that keeps a fraction of the points visits about `ef / fraction` nodes and scores the M neighbours of
+    // each of them, while a flat search scores each point of the filter once.
+    bool prefer_flat_search(size_t num_filtered, size_t k, size_t ef) const;
+
+    // ef of a walk that keeps `num_filtered` of the points, so that it finds about as many of them as an unfiltered
+    // walk of `ef` finds points
+    size_t get_filtered_ef(size_t num_filtered, size_t k, size_t ef) const;
+
     // needed for cosine similarity
     static void normalize_vector(const std::vector<float>& src, std::vector<float>& norm_dest) {
         float norm = 0.0f;
@@ -348,6 +485,8 @@ struct group_by_field_it_t {
     std::string field_name;
     posting_list_t::iterator_t it;
     bool is_array;
+    // seq_id => facet id, when the field has one value per document
+    const std::vector<uint32_t>* facet_ids = nullptr;
 };
 
 struct Hasher32 {
@@ -377,6 +516,9 @@ private:
 
     ThreadPool* thread_pool;
 
+    // in-memory indexing of writes runs here, so that it can be kept off the threads that serve searches
+    ThreadPool* indexing_thread_pool;
+
     size_t num_documents;
 
     tsl::htrie_map<char, field> search_schema;
@@ -385,6 +527,10 @@ private:
 
     spp::sparse_hash_map<std::string, num_tree_t*> numerical_index;
 
+    // numeric facet field => sum and count of the values of all the documents, so that the stats of a result set
+    // that has every document are not computed over it. Min and max are those of `numerical_index`.
+    spp::sparse_hash_map<std::string, facet_stats_t> numeric_facet_totals;
+
     // reference_helper_field => (seq_id => ref_seq_ids)
     // Only used when the reference field is an array type otherwise sort_index is used.
     spp::sparse_hash_map<std::string, num_tree_t*> reference_index;
@@ -403,9 +549,9 @@ private:
     facet_index_t* facet_index_v4 = nullptr;
   
     // sort_field => (seq_id => value)
-    spp::sparse_hash_map<std::string, spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*> sort_index;
+    spp::sparse_hash_map<std::string, sort_column_t*> sort_index;
     typedef spp::sparse_hash_map<std::string, 
-        spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*>::iterator sort_index_iterator;
+        sort_column_t*>::iterator sort_index_iterator;
 
     // str_sort_field => adi_tree_t
     spp::sparse_hash_map<std::string, adi_tree_t*> str_sort_index;
@@ -413,12 +559,56 @@ private:
     // infix field => value
     spp::sparse_hash_map<std::string, array_mapped_infix_t> infix_index;
 
+    // infix field => trigrams of its tokens, when the trigram index is enabled
+    spp::sparse_hash_map<std::string, trigram_index_t*> infix_trigram_index;
+
+    // string field => hashes of its whole values, when its `exact_match_index` is enabled
+    spp::sparse_hash_map<std::string, exact_match_index_t*> exact_match_index;
+
     // vector field => vector index
     spp::sparse_hash_map<std::string, hnsw_index_t*> vector_index;
 
+    // vector fields whose graphs were restored from an index image: points must not be re-inserted during load
+    std::set<std::string> preloaded_vector_fields;
+
     // this is used for wildcard queries
     id_list_t* seq_ids;
 
+    // bytes held by each of the structures above
+    index_memory_stats_t memory_stats;
+
+    static memory_structure_t get_memory_structure(const field& afield);
+
+    // materialized results of filter expressions, valid only for the `write_generation` they were computed at
+    mutable filter_result_cache_t filter_result_cache;
+
+    // nodes matched by fuzzy traversals of the token trees, valid only for the `write_generation` they were found at
+    mutable typo_candidate_cache_t typo_candidate_cache;
+
+    // facet counts of result sets, valid only for the `write_generation` they were computed at
+    mutable facet_result_cache_t facet_result_cache;
+
+    // ids matched by the filters of `_eval()` sort expressions, valid only for the `write_generation` they were
+    // computed at
+    mutable eval_bitmap_cache_t eval_bitmap_cache;
+
+    // facet field => costs of the facet strategies
+    mutable facet_cost_model_t facet_cost_model;
+
+    // Fields that are added by a background alter: documents from `backfill_end` on are indexed on them by the
+    // backfill, so writes leave them out until the backfill has passed them.
+    std::unordered_set<std::string> backfill_fields;
+    std::atomic<uint32_t> backfill_end = 0;
+
+    // advanced on every write, while holding the exclusive lock
+    std::atomic<uint64_t> write_generation = 0;
+
+    // Documents deleted by a request are only marked here, and searches skip them until they are unindexed in a
+    // batch by `purge_deleted()`. Holds the indexed fields of each document, which are needed to unindex it. Its
+    // lock is taken after all the other locks of the index.
+    mutable std::shared_mutex deleted_mutex;
+    std::map<uint32_t, nlohmann::json> deleted_docs;
+
     std::vector<char> symbols_to_index;
 
     std::vector<char> token_separators;
@@ -427,13 +617,13 @@ private:
 
     // used as sentinels
 
-    static spp::sparse_hash_map<uint32_t, int64_t, Hasher32> text_match_sentinel_value;
-    static spp::sparse_hash_map<uint32_t, int64_t, Hasher32> seq_id_sentinel_value;
-    static spp::sparse_hash_map<uint32_t, int64_t, Hasher32> eval_sentinel_value;
-    static spp::sparse_hash_map<uint32_t, int64_t, Hasher32> geo_sentinel_value;
-    static spp::sparse_hash_map<uint32_t, int64_t, Hasher32> str_sentinel_value;
-    static spp::sparse_hash_map<uint32_t, int64_t, Hasher32> vector_distance_sentinel_value;
-    static spp::sparse_hash_map<uint32_t, int64_t, Hasher32> vector_query_sentinel_value;
+    static sort_column_t text_match_sentinel_value;
+    static sort_column_t seq_id_sentinel_value;
+    static sort_column_t eval_sentinel_value;
+    static sort_column_t geo_sentinel_value;
+    static sort_column_t str_sentinel_value;
+    static sort_column_t vector_distance_sentinel_value;
+    static sort_column_t vector_query_sentinel_value;
 
     // Internal utility functions
 
@@ -506,10 +696,11 @@ private:
                                        const size_t max_candidates,
                                        int syn_orig_num_tokens,
                                        const int* sort_order,
-                                       std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values,
+                                       std::array<sort_column_t*, 3>& field_values,
                                        const std::vector<size_t>& geopoint_indices,
                                        std::set<uint64>& query_hashes,
-                                       std::vector<uint32_t>& id_buff, const std::string& collection_name = "") const;
+                                       std::vector<uint32_t>& id_buff, const std::string& collection_name = "",
+                                       const size_t concurrency = 1) const;
 
     static void popular_fields_of_token(const spp::sparse_hash_map<std::string, art_tree*>& search_index,
                                         const std::string& previous_token,
@@ -531,6 +722,15 @@ private:
                                       const std::vector<char>& token_separators,
                                       std::unordered_map<std::string, std::vector<uint32_t>>& token_to_offsets);
 
+    // Hash of a value made of `tokens`, with which its documents are found in the exact match index.
+    static uint64_t exact_match_hash(const std::vector<std::string>& tokens);
+
+    // Hashes of the values of `a_field` in the document, whose tokens are normalized like those of a query.
+    static void get_exact_match_hashes(const nlohmann::json& document, const field& a_field,
+                                       const std::vector<char>& symbols_to_index,
+                                       const std::vector<char>& token_separators,
+                                       std::vector<uint64_t>& hashes);
+
     void collate_included_ids(const std::vector<token_t>& q_included_tokens,
                               const std::map<size_t, std::map<size_t, uint32_t>> & included_ids_map,
                               Topster* curated_topster, std::vector<std::vector<art_leaf*>> & searched_queries) const;
@@ -540,6 +740,15 @@ private:
 
     static void compute_facet_stats(facet &a_facet, const int64_t raw_value, const std::string & field_type);
 
+    // the distinct values of a document that the stats of a facet are computed over
+    static void get_numeric_facet_values(const nlohmann::json& document, const field& afield,
+                                         std::vector<double>& values);
+
+    void update_numeric_facet_totals(const nlohmann::json& document, const field& afield, bool is_insert);
+
+    // adds the totals of every document to the stats of the facets that skipped computing them
+    void add_numeric_facet_totals(std::vector<facet>& facets, const std::vector<facet_info_t>& facet_infos) const;
+
     static void handle_doc_ops(const tsl::htrie_map<char, field>& search_schema,
                                nlohmann::json& update_doc, const nlohmann::json& old_doc);
 
@@ -556,6 +765,19 @@ private:
 
     std::vector<group_by_field_it_t> get_group_by_field_iterators(const std::vector<std::string>&, bool is_reverse=false) const;
 
+    // nearest `k` of the points of a filter, closest first, by scoring each of them
+    std::vector<std::pair<float, size_t>> flat_search_knn(const hnsw_index_t* field_vector_index,
+                                                          const std::vector<const float*>& queries,
+                                                          size_t k, filter_result_iterator_t* filter_result_iterator,
+                                                          const uint32_t* excluded_ids, size_t excluded_ids_length) const;
+
+    // Nearest neighbours of the vector query of a hybrid search as (seq_id, distance), closest first, without those
+    // beyond the distance threshold of the query
+    void hybrid_vector_search(const vector_query_t& vector_query, size_t fetch_size,
+                              filter_result_iterator_t* filter_result_iterator, bool no_filters_provided,
+                              const uint32_t* excluded_result_ids, size_t excluded_result_ids_size,
+                              std::vector<std::pair<uint32_t, float>>& vec_results, bool& search_cutoff) const;
+
     static void batch_embed_fields(std::vector<index_record*>& documents,
                                    const tsl::htrie_map<char, field>& embedding_fields,
                                    const tsl::htrie_map<char, field> & search_schema, const size_t remote_embedding_batch_size = 200,
@@ -581,6 +803,20 @@ public:
     // in the query that have the least individual hits one by one until enough results are found.
     static const int DROP_TOKENS_THRESHOLD = 1;
 
+    // Text match candidates of a single query are scored across threads only when the shortest posting list of
+    // the query has at least these many documents. Below that, the cost of fanning out outweighs the gain.
+    static const size_t PARALLEL_SCORING_MIN_CANDIDATES = 20000;
+
+    // Deleted documents are purged from the index as soon as there are these many of them, besides the periodic
+    // purge, so that the exclusion of the deleted documents stays cheap for searches.
+    static const size_t MAX_DELETED_DOCS = 1000;
+
+    // A wildcard query sorted on a numerical field is answered by walking the values of the field in sort order
+    // only when it has at least these many matches, and the estimated number of documents visited by the walk is
+    // at least `WILDCARD_SORT_ORDER_MIN_GAIN` times smaller than the number of matches scored otherwise.
+    static const size_t WILDCARD_SORT_ORDER_MIN_MATCHES = 10000;
+    static const size_t WILDCARD_SORT_ORDER_MIN_GAIN = 8;
+
     Index() = delete;
 
     Index(const std::string& name,
@@ -590,12 +826,18 @@ public:
           ThreadPool* thread_pool,
           const tsl::htrie_map<char, field>& search_schema,
           const std::vector<char>& symbols_to_index,
-          const std::vector<char>& token_separators);
+          const std::vector<char>& token_separators,
+          ThreadPool* indexing_thread_pool = nullptr);
 
     ~Index();
 
     static void concat_topster_ids(Topster* topster, spp::sparse_hash_map<uint64_t, std::vector<KV*>>& topster_ids);
 
+    // Upper bound of the aggregated text match score of a document that matches `max_tokens` tokens with a typo
+    // cost of `total_cost`: only the proximity, verbatim and offset bytes of its field score are left unknown.
+    static uint64_t max_text_match_score(const text_match_type_t match_type, const uint32_t total_cost,
+                                         const size_t max_tokens, const size_t max_field_weight);
+
     int64_t score_results2(const std::vector<sort_by> & sort_fields, const uint16_t & query_index,
                            const size_t field_id, const bool field_is_array, const uint32_t total_cost,
                            int64_t& match_score,
@@ -612,7 +854,7 @@ public:
                        Topster *topster, const std::vector<art_leaf *> &query_suggestion,
                        spp::sparse_hash_map<uint64_t, uint32_t>& groups_processed,
                        const uint32_t seq_id, const int sort_order[3],
-                       std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> field_values,
+                       std::array<sort_column_t*, 3> field_values,
                        const std::vector<size_t>& geopoint_indices,
                        const size_t group_limit,
                        const std::vector<std::string> &group_by_fields,
@@ -633,10 +875,14 @@ public:
 
     const spp::sparse_hash_map<std::string, array_mapped_infix_t>& _get_infix_index() const;
 
+    const spp::sparse_hash_map<std::string, trigram_index_t*>& _get_infix_trigram_index() const;
+
     const spp::sparse_hash_map<std::string, hnsw_index_t*>& _get_vector_index() const;
 
     facet_index_t* _get_facet_index() const;
 
+    const facet_result_cache_t& _get_facet_result_cache() const;
+
     static int get_bounded_typo_cost(const size_t max_cost, const std::string& token, const size_t token_len,
                                      size_t min_len_1typo, size_t min_len_2typo,  bool enable_typos_for_numerical_tokens=true);
 
@@ -644,8 +890,8 @@ public:
 
     static float int64_t_to_float(int64_t n);
 
-    void get_distinct_id(posting_list_t::iterator_t& facet_index_it, const uint32_t seq_id,
-                         const bool is_array, const bool group_missing_values, uint64_t& distinct_id,
+    void get_distinct_id(group_by_field_it_t& group_by_field_it, const uint32_t seq_id,
+                         const bool group_missing_values, uint64_t& distinct_id,
                          bool is_reverse=false) const;
 
     static void compute_token_offsets_facets(index_record& record,
@@ -699,9 +945,36 @@ public:
     void remove_field(uint32_t seq_id, const nlohmann::json& document, const std::string& field_name,
                       const bool is_update);
 
+    // removes a document from the index, the caller must hold `mutex` exclusively
+    void remove_unsafe(const uint32_t seq_id, const nlohmann::json& document,
+                       const std::vector<field>& del_fields, const bool is_update);
+
     Option<uint32_t> remove(const uint32_t seq_id, const nlohmann::json & document,
                             const std::vector<field>& del_fields, const bool is_update);
 
+    // Removes the documents of a batch with a single acquisition of the locks of the index.
+    void remove_batch(const std::vector<std::pair<uint32_t, nlohmann::json>>& seq_id_docs);
+
+    // Frees one of the per-field structures of the index, so that a dropped index can be torn down in chunks.
+    // Returns false when none is left. The caller must hold `mutex` exclusively.
+    bool release_next_structure();
+
+    // Updates single valued numeric fields that have sorting enabled directly in their numeric and sort indices,
+    // with a single acquisition of the locks of the index. Current values are read from the sort index, so the
+    // stored documents are not needed. All the fields of a document are updated, or none when one of them fails.
+    void update_numeric_values(std::vector<numeric_doc_update_t>& doc_updates);
+
+    // Marks a document as deleted without unindexing it. `document` must hold the values of its indexed fields.
+    void mark_deleted(const uint32_t seq_id, const nlohmann::json& document);
+
+    // Unindexes the documents marked as deleted. Returns the number of documents purged.
+    size_t purge_deleted();
+
+    size_t num_deleted() const;
+
+    // sorted ids of the documents marked as deleted
+    std::vector<uint32_t> get_deleted_ids() const;
+
     static void validate_and_preprocess(Index *index, std::vector<index_record>& iter_batch,
                                           const size_t batch_start_index, const size_t batch_size,
                                           const std::string & default_sorting_field,
@@ -727,6 +1000,24 @@ public:
                                      const bool use_addition_fields = false,
                                      const tsl::htrie_map<char, field>& addition_fields = tsl::htrie_map<char, field>());
 
+    // Validates the records of a batch and generates their embeddings, without changing the index: the caller only has
+    // to keep the schema and the writers of the collection out, while searches can go on.
+    static void preprocess_batch(Index *index,
+                                 std::vector<index_record>& iter_batch,
+                                 const std::string& default_sorting_field,
+                                 const tsl::htrie_map<char, field>& search_schema,
+                                 const tsl::htrie_map<char, field> & embedding_fields,
+                                 const std::string& fallback_field_type,
+                                 const std::vector<char>& token_separators,
+                                 const std::vector<char>& symbols_to_index,
+                                 const bool do_validation, const size_t remote_embedding_batch_size = 200,
+                                 const size_t remote_embedding_timeout_ms = 60000,
+                                 const size_t remote_embedding_num_tries = 2, const bool generate_embeddings = true);
+
+    // Indexes the records of a batch that has been preprocessed, returning the number of documents added.
+    static size_t index_preprocessed_batch(Index *index, std::vector<index_record>& iter_batch,
+                                           const tsl::htrie_map<char, field>& indexable_schema);
+
     void index_field_in_memory(const field& afield, std::vector<index_record>& iter_batch);
 
     template<class T>
@@ -755,6 +1046,18 @@ public:
 
     void refresh_schemas(const std::vector<field>& new_fields, const std::vector<field>& del_fields);
 
+    // Adds `new_fields` to the schema, without indexing the existing documents on them, which is left to the
+    // backfill of a background alter: writes index them only on documents that the backfill has passed.
+    void start_backfill(const std::vector<field>& new_fields);
+
+    // The backfill has indexed the documents before `seq_id`. Set only while writes are held off.
+    void set_backfill_end(uint32_t seq_id);
+
+    void finish_backfill();
+
+    // seq id from which the documents are not indexed on the field yet
+    uint32_t get_backfill_end(const std::string& field_name) const;
+
     // the following methods are not synchronized because their parent calls are synchronized or they are const/static
 
     Option<bool> search_wildcard(filter_node_t const* const& filter_tree_root,
@@ -770,10 +1073,26 @@ public:
                                  filter_result_iterator_t* const filter_result_iterator,
                                  const size_t concurrency,
                                  const int* sort_order,
-                                 std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values,
+                                 std::array<sort_column_t*, 3>& field_values,
                                  const std::vector<size_t>& geopoint_indices,
+                                 const bool collect_result_ids = true,
                                  const std::string& collection_name = "") const;
 
+    /// Finds the top wildcard hits by walking the values of the first sort field in sort order, stopping once the
+    /// topster is full, instead of scoring every filter match. Sets `walked` to false when the query does not
+    /// qualify, or when a value ties more documents than the topster holds, in which case the results are untouched.
+    Option<bool> search_wildcard_in_sort_order(filter_node_t const* const& filter_tree_root,
+                                               const std::vector<sort_by>& sort_fields, Topster* topster,
+                                               std::vector<std::vector<art_leaf*>>& searched_queries,
+                                               const size_t group_limit, const uint32_t* exclude_token_ids,
+                                               size_t exclude_token_ids_size,
+                                               uint32_t*& all_result_ids, size_t& all_result_ids_len,
+                                               filter_result_iterator_t* const filter_result_iterator,
+                                               const int* sort_order,
+                                               std::array<sort_column_t*, 3>& field_values,
+                                               const std::vector<size_t>& geopoint_indices,
+                                               const std::string& collection_name, bool& walked) const;
+
     Option<bool> search_infix(const std::string& query, const std::string& field_name, std::vector<uint32_t>& ids,
                               size_t max_extra_prefix, size_t max_extra_suffix) const;
 
@@ -783,11 +1102,11 @@ public:
 
     void populate_sort_mapping(int* sort_order, std::vector<size_t>& geopoint_indices,
                                std::vector<sort_by>& sort_fields_std,
-                               std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values) const;
+                               std::array<sort_column_t*, 3>& field_values) const;
 
     void populate_sort_mapping_with_lock(int* sort_order, std::vector<size_t>& geopoint_indices,
                                          std::vector<sort_by>& sort_fields_std,
-                                         std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values) const;
+                                         std::array<sort_column_t*, 3>& field_values) const;
 
     int64_t reference_string_sort_score(const std::string& field_name, const uint32_t& seq_id) const;
 
@@ -802,11 +1121,20 @@ public:
                              std::vector<facet_info_t>& facet_infos, facet_index_type_t facet_index_type
                              ) const;
 
+    // Stops early without resolving the query once `cancelled` is set.
     void resolve_space_as_typos(std::vector<std::string>& qtokens, const std::string& field_name,
-                                std::vector<std::vector<std::string>>& resolved_queries) const;
+                                std::vector<std::vector<std::string>>& resolved_queries,
+                                const std::atomic<bool>* cancelled = nullptr) const;
+
+    // Whether a search of the tokens on the field is likely to find fewer than `min_results` documents, going by the
+    // number of documents of the verbatim tokens.
+    bool likely_sparse_results(const std::vector<token_t>& tokens, const std::string& field_name,
+                               size_t min_results) const;
 
     size_t num_seq_ids() const;
 
+    const index_memory_stats_t& get_memory_stats() const;
+
     void handle_exclusion(const size_t num_search_fields, std::vector<query_tokens_t>& field_query_tokens,
                           const std::vector<search_field_t>& search_fields, uint32_t*& exclude_token_ids,
                           size_t& exclude_token_ids_size) const;
@@ -821,7 +1149,7 @@ public:
                                  const size_t max_extra_suffix, const std::vector<token_t>& query_tokens, Topster* actual_topster,
                                  filter_result_iterator_t* const filter_result_iterator,
                                  const int sort_order[3],
-                                 std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> field_values,
+                                 std::array<sort_column_t*, 3> field_values,
                                  const std::vector<size_t>& geopoint_indices,
                                  const std::vector<uint32_t>& curated_ids_sorted,
                                  const std::unordered_set<uint32_t>& excluded_group_ids,
@@ -829,6 +1157,32 @@ public:
                                  spp::sparse_hash_map<uint64_t, uint32_t>& groups_processed,
                                  const std::string& collection_name = "") const;
 
+    // Finds the documents with a value that is made of exactly the query tokens in the fields with an exact match
+    // index, which are scored as a verbatim match of every token in that field.
+    Option<bool> search_exact_match_index(const size_t num_search_fields, const std::vector<search_field_t>& the_fields,
+                                          const text_match_type_t match_type,
+                                          const std::vector<token_t>& query_tokens,
+                                          const std::vector<sort_by>& sort_fields,
+                                          std::vector<std::vector<art_leaf*>>& searched_queries,
+                                          tsl::htrie_map<char, token_leaf>& qtoken_set,
+                                          const size_t group_limit,
+                                          const std::vector<std::string>& group_by_fields,
+                                          const bool group_missing_values,
+                                          const bool prioritize_exact_match,
+                                          const bool prioritize_token_position,
+                                          const bool prioritize_num_matching_fields,
+                                          Topster* actual_topster,
+                                          filter_result_iterator_t* const filter_result_iterator,
+                                          const uint32_t* exclude_token_ids, size_t exclude_token_ids_size,
+                                          const int sort_order[3],
+                                          std::array<sort_column_t*, 3> field_values,
+                                          const std::vector<size_t>& geopoint_indices,
+                                          const std::vector<uint32_t>& curated_ids_sorted,
+                                          const std::unordered_set<uint32_t>& excluded_group_ids,
+                                          uint32_t*& all_result_ids, size_t& all_result_ids_len,
+                                          spp::sparse_hash_map<uint64_t, uint32_t>& groups_processed,
+                                          const std::string& collection_name = "") const;
+
     [[nodiscard]] Option<bool> do_synonym_search(const std::vector<search_field_t>& the_fields,
                                                  const text_match_type_t match_type,
                                                  filter_node_t const* const& filter_tree_root,
@@ -857,7 +1211,7 @@ public:
                                                  filter_result_iterator_t* const filter_result_iterator,
                                                  std::set<uint64>& query_hashes,
                                                  const int* sort_order,
-                                                 std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values,
+                                                 std::array<sort_column_t*, 3>& field_values,
                                                  const std::vector<size_t>& geopoint_indices,
                                                  tsl::htrie_map<char, token_leaf>& qtoken_set,
                                                  const std::string& collection_name = "") const;
@@ -870,7 +1224,7 @@ public:
                                   const bool group_missing_values,
                                   Topster* actual_topster,
                                   const int sort_order[3],
-                                  std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> field_values,
+                                  std::array<sort_column_t*, 3> field_values,
                                   const std::vector<size_t>& geopoint_indices,
                                   const std::vector<uint32_t>& curated_ids_sorted,
                                   filter_result_iterator_t*& filter_result_iterator,
@@ -913,10 +1267,20 @@ public:
                                                    size_t min_len_2typo,
                                                    int syn_orig_num_tokens,
                                                    const int* sort_order,
-                                                   std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values,
+                                                   std::array<sort_column_t*, 3>& field_values,
                                                    const std::vector<size_t>& geopoint_indices,
                                                    const std::string& collection_name = "",
-                                                   bool enable_typos_for_numerical_tokens = true) const;
+                                                   bool enable_typos_for_numerical_tokens = true,
+                                                   const size_t concurrency = 1) const;
+
+    // Fuzzy searches the tokens in every field at all of their costs above 0, with one traversal of the tree of a
+    // field for all tokens and costs. Prefix tokens are left out. Fields are searched in parallel. The nodes matched by token `t` at cost `c` in
+    // field `f` go to `typo_nodes[f][t][c - 1]`.
+    void fuzzy_search_typo_nodes(const std::vector<search_field_t>& the_fields, const size_t num_search_fields,
+                                 const std::vector<token_t>& query_tokens,
+                                 const std::vector<std::vector<int>>& token_to_costs,
+                                 const size_t concurrency,
+                                 std::vector<std::vector<std::vector<std::vector<const art_node*>>>>& typo_nodes) const;
 
     void find_across_fields(const token_t& previous_token,
                             const std::string& previous_token_str,
@@ -953,11 +1317,12 @@ public:
                                       size_t exclude_token_ids_size,
                                       const std::unordered_set<uint32_t>& excluded_group_ids,
                                       const int* sort_order,
-                                      std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values,
+                                      std::array<sort_column_t*, 3>& field_values,
                                       const std::vector<size_t>& geopoint_indices,
                                       std::vector<uint32_t>& id_buff,
                                       uint32_t*& all_result_ids, size_t& all_result_ids_len,
-                                      const std::string& collection_name = "") const;
+                                      const std::string& collection_name = "",
+                                      const size_t concurrency = 1) const;
 
     void
     search_fields(const std::vector<filter>& filters,
@@ -990,15 +1355,22 @@ public:
                                   bool enable_typos_for_numerical_tokens) const;
 
     Option<bool> compute_sort_scores(const std::vector<sort_by>& sort_fields, const int* sort_order,
-                                     std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> field_values,
+                                     std::array<sort_column_t*, 3> field_values,
                                      const std::vector<size_t>& geopoint_indices, uint32_t seq_id,
                                      const std::map<basic_string<char>, reference_filter_result_t>& references,
-                                     std::vector<uint32_t>& filter_indexes,
                                      int64_t max_field_match_score,
                                      int64_t* scores,
                                      int64_t& match_score_index, float vector_distance = 0,
                                      const std::string& collection_name = "") const;
 
+    // Adds the `fetch_size` documents nearest to the reference point of a geo sort to the topster by walking the
+    // cells of the geo index outwards, instead of scoring every document.
+    Option<bool> search_nearest_geopoints(const std::vector<sort_by>& sort_fields, const int* sort_order,
+                                          const std::array<sort_column_t*, 3>& field_values,
+                                          const std::vector<size_t>& geopoint_indices, size_t fetch_size,
+                                          Topster* topster, size_t num_searched_queries,
+                                          const std::string& collection_name) const;
+
     void process_curated_ids(const std::vector<std::pair<uint32_t, uint32_t>>& included_ids,
                              const std::vector<uint32_t>& excluded_ids,
                              const std::vector<std::string>& group_by_fields,
@@ -1031,13 +1403,33 @@ public:
 
     void repair_hnsw_index();
 
+    // Rebuilds the graphs in which many points are deleted from their live points, and swaps them in. Returns
+    // the number of graphs that were compacted.
+    size_t compact_vector_indices();
+
+    // Writes the HNSW graph of each vector field into `image_dir`. Names of the written files are returned
+    // in `vector_images` as field name => file name.
+    Option<bool> save_vector_index_images(const std::string& image_dir, const std::string& file_prefix,
+                                          nlohmann::json& vector_images) const;
+
+    // Replaces the graphs of the vector fields found in `vector_images` with the ones persisted on disk.
+    Option<bool> load_vector_index_images(const std::string& image_dir, const nlohmann::json& vector_images);
+
+    void clear_preloaded_vector_fields();
+
+    // Sizes the graphs of the vector fields that are indexed from documents for `num_points` points, so that
+    // loading many documents does not grow them batch by batch.
+    void reserve_vector_capacity(size_t num_points);
+
     void aggregate_facet(const size_t group_limit, facet& this_facet, facet& acc_facet) const;
 };
 
 template<class T>
 void Index::iterate_and_index_numerical_field(std::vector<index_record>& iter_batch, const field& afield, T func) {
+    const uint32_t backfill_end = get_backfill_end(afield.name);
+
     for(auto& record: iter_batch) {
-        if(!record.indexed.ok()) {
+        if(!record.indexed.ok() || record.seq_id >= backfill_end) {
             continue;
         }
 
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <mutex>
+#include <vector>
 
 class JapaneseLocalizer {
 private:
@@ -11,8 +12,20 @@ private:
 
     static void write_data_file(const std::string& base64_data, const std::string& file_name);
 
+    // kakasi keeps its state in globals, so it runs one text at a time
     std::mutex m;
 
+    // normalizations of short texts (i.e. words) are cached per thread, so that the frequent words of a language skip
+    // the lock of kakasi altogether
+    static constexpr size_t MAX_CACHED_TEXT_SIZE = 64;
+    static constexpr size_t MAX_CACHED_NORMALIZATIONS = 16 * 1024;
+
+    static bool get_cached(const std::string& text, std::string& normalized);
+
+    static void cache(const std::string& text, const std::string& normalized);
+
+    void normalize_uncached(const std::string& text, std::string& normalized);
+
 public:
 
     static JapaneseLocalizer & get_instance() {
@@ -22,5 +35,11 @@ public:
 
     bool init();
 
+    // returns a string allocated with malloc, which the caller frees
     char* normalize(const std::string& text);
+
+    void normalize(const std::string& text, std::string& normalized);
+
+    // Normalizes all of `texts` into `normalized`, taking the lock of kakasi once for the texts that are not cached.
+    void normalize_batch(const std::vector<std::string>& texts, std::vector<std::string>& normalized);
 };
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// HDR style histogram of latencies in microseconds. Every power of two range of values is split into
+// `SUB_BUCKETS` equally sized buckets, so a value is reported with an error of at most 1/32 (~3%), from 1 us up to
+// ~19 hours. Recording a value is lock-free and can be done concurrently from any thread.
+class latency_histogram_t {
+public:
+    static constexpr size_t SUB_BUCKET_BITS = 5;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+
+    // values at or beyond 2^(MAX_VALUE_BITS) are held in the last bucket
+    static constexpr size_t MAX_VALUE_BITS = 36;
+    static constexpr size_t NUM_BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+private:
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> counts{};
+    std::atomic<uint64_t> total_count = 0;
+    std::atomic<uint64_t> total_sum = 0;
+
+public:
+    static size_t bucket_index(uint64_t value);
+
+    // largest value that falls in the bucket
+    static uint64_t bucket_upper_bound(size_t index);
+
+    // Returns the (upper bound of the) value below which `percentile` percent of the counted values fall.
+    static uint64_t value_at_percentile(const std::vector<uint64_t>& bucket_counts, double percentile);
+
+    void record(uint64_t value);
+
+    // copies the current count of every bucket into `bucket_counts`
+    void snapshot(std::vector<uint64_t>& bucket_counts) const;
+
+    uint64_t count() const {
+        return total_count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t sum() const {
+        return total_sum.load(std::memory_order_relaxed);
+    }
+};
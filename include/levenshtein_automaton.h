@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Automaton of the fuzzy matching of a query token against keys, as done by `art_fuzzy_search` for a given cost
+// range and prefix flag.
+//
+// A state stands for the last two rows of the (transposition aware) edit distance matrix of a key prefix, along
+// with the length of the prefix and its last char. Rows only tell apart costs up to a small cap, and chars only
+// matter by which char of the token they are equal to, so keys that share a prefix walk the same states and a
+// walk needs a single table lookup per key char instead of the computation of a row.
+//
+// States and transitions are computed the first time they are reached, so an automaton only holds the part that
+// the keys it was walked on needed. Not thread safe.
+class levenshtein_automaton_t {
+public:
+    enum action_t: int8_t {
+        REJECT = -1,
+        CONTINUE = 0,
+        ACCEPT = 1
+    };
+
+    static constexpr uint32_t INITIAL_STATE = 0;
+
+    levenshtein_automaton_t(const unsigned char* term, int term_len, int min_cost, int max_cost, bool prefix);
+
+    // Consumes `c` from `state`. On CONTINUE, `state` is moved to the state after `c`.
+    action_t step(uint32_t& state, unsigned char c);
+
+    // Action for a key that ends right after `state`, without its terminating char being consumed.
+    action_t end(uint32_t state);
+
+    size_t num_states() const {
+        return state_depths.size();
+    }
+
+private:
+    // transition entries that are not states
+    static constexpr int32_t NOT_COMPUTED = -3;
+    static constexpr int32_t ACCEPTED = -2;
+    static constexpr int32_t REJECTED = -1;
+
+    // class 0 is for chars that are not in the term, class 1 for '\0'
+    static constexpr uint8_t OTHER_CLASS = 0;
+    static constexpr uint8_t NULL_CLASS = 1;
+
+    const std::string term;
+    const int min_cost;
+    const int max_cost;
+    const bool prefix;
+
+    // costs above this are all the same to the matching, so row values are capped to it
+    const int cost_cap;
+
+    uint8_t char_classes[256];
+    // a char of every class
+    std::vector<unsigned char> class_chars;
+
+    std::vector<int> state_depths;
+    std::vector<uint8_t> state_prev_classes;
+    // the previous and the current row of every state, each of `term.size() + 1` values
+    std::vector<uint8_t> state_rows;
+    std::vector<int32_t> transitions;
+    std::vector<int8_t> end_actions;
+
+    std::unordered_map<std::string, uint32_t> state_ids;
+
+    uint32_t add_state(int depth, uint8_t prev_class, const int* prev_row, const int* row);
+
+    int32_t compute_transition(uint32_t state, uint8_t char_class);
+};
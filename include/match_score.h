@@ -75,38 +75,15 @@ struct Match {
         }
     }
 
-    template<typename T>
-    void sort2(std::vector<T>& a) {
-        if(a[0] < a[1]) {
-            std::swap(a[0], a[1]);
+    // Inserts `token_offset` into a window that is sorted on offset, descending, after the offsets equal to it.
+    static void insert_sorted(TokenOffset* window, size_t& window_size, const TokenOffset& token_offset) {
+        size_t i = window_size++;
+        while(i > 0 && window[i - 1].offset < token_offset.offset) {
+            window[i] = window[i - 1];
+            i--;
         }
-    }
 
-    template<typename T>
-    void sort3(std::vector<T>& a) {
-        if (a[0] > a[1]) {
-            if (a[1] > a[2]) {
-                return;
-            } else if (a[0] > a[2]) {
-                std::swap(a[1], a[2]);
-            } else {
-                T tmp = std::move(a[0]);
-                a[0] = std::move(a[2]);
-                a[2] = std::move(a[1]);
-                a[1] = std::move(tmp);
-            }
-        } else {
-            if (a[0] > a[2]) {
-                std::swap(a[0], a[1]);
-            } else if (a[2] > a[1]) {
-                std::swap(a[0], a[2]);
-            } else {
-                T tmp = std::move(a[0]);
-                a[0] = std::move(a[1]);
-                a[1] = std::move(a[2]);
-                a[2] = std::move(tmp);
-            }
-        }
+        window[i] = token_offset;
     }
 
     /*
@@ -116,13 +93,15 @@ struct Match {
 
         How it works:
         ------------
-        Create vector with first offset from each token.
-        Sort vector descending.
+        Create window with first offset from each token, sorted descending.
         Calculate distance, use only tokens within max window size from lowest offset.
         Reassign best window and distance if found.
-        Pop end of vector (smallest offset).
-        Push to vector next offset of token just popped.
-        Until queue size is 1.
+        Pop end of window (smallest offset).
+        Insert into window the next offset of token just popped.
+        Until window size is 1.
+
+        The window holds at most `WINDOW_SIZE` offsets, so it lives on the stack. As it is sorted, the tokens within
+        max window size from the lowest offset are a suffix of it, and their distance is the span of that suffix.
     */
 
     Match(uint32_t doc_id, const std::vector<token_positions_t>& token_offsets,
@@ -130,14 +109,16 @@ struct Match {
         // in case if number of tokens in query is greater than max window
         const size_t tokens_size = std::min(token_offsets.size(), WINDOW_SIZE);
 
-        std::vector<TokenOffset> window(tokens_size);
-        for (size_t token_id = 0; token_id < tokens_size; token_id++) {
-            window[token_id] = TokenOffset{static_cast<uint8_t>(token_id), token_offsets[token_id].positions[0], 0};
-        }
+        TokenOffset window[WINDOW_SIZE];
+        size_t window_size = 0;
 
-        std::vector<TokenOffset> best_window;
-        if(populate_window) {
-            best_window = window;
+        // indexed by token id
+        TokenOffset best_window[WINDOW_SIZE];
+
+        for (size_t token_id = 0; token_id < tokens_size; token_id++) {
+            const TokenOffset token_offset{static_cast<uint8_t>(token_id), token_offsets[token_id].positions[0], 0};
+            insert_sorted(window, window_size, token_offset);
+            best_window[token_id] = token_offset;
         }
 
         size_t best_num_match = 1;
@@ -145,20 +126,8 @@ struct Match {
 
         int prev_min_offset = -1;
 
-        while (window.size() > 1) {
-            switch(window.size()) {
-                case 2:
-                    sort2<TokenOffset>(window);
-                    break;
-                case 3:
-                    sort3<TokenOffset>(window);
-                    break;
-                default:
-                    // descending comparator
-                    std::sort(window.begin(), window.end(), std::greater<TokenOffset>());
-            }
-
-            size_t min_offset = window.back().offset;
+        while (window_size > 1) {
+            const size_t min_offset = window[window_size - 1].offset;
 
             if(int(min_offset) < prev_min_offset) {
                 // indicates that one of the offsets are wrapping around (e.g. long document)
@@ -167,50 +136,39 @@ struct Match {
 
             prev_min_offset = min_offset;
 
-            size_t this_displacement = 0;
-            size_t this_num_match = 0;
-            std::vector<TokenOffset> this_window(tokens_size);
-
-            uint16_t prev_offset = window[0].offset;
-            bool all_offsets_are_same = true;
-
-            for (size_t i = 0; i < window.size(); i++) {
-                if(populate_window) {
-                    this_window[window[i].token_id] = window[i];
-                    this_window[window[i].token_id].offset = MAX_DISPLACEMENT;
-                }
-
-                if ((window[i].offset - min_offset) <= WINDOW_SIZE) {
-                    uint16_t next_offset = (i == window.size() - 1) ? window[i].offset : window[i + 1].offset;
-                    this_displacement += window[i].offset - next_offset;
-                    this_num_match++;
-
-                    if(populate_window) {
-                        this_window[window[i].token_id].offset = window[i].offset;
-                    }
-                }
-
-                all_offsets_are_same = all_offsets_are_same && (window[i].offset == prev_offset);
+            size_t first_match = window_size - 1;
+            while (first_match > 0 && (window[first_match - 1].offset - min_offset) <= WINDOW_SIZE) {
+                first_match--;
             }
 
+            const size_t this_num_match = window_size - first_match;
+            const size_t this_displacement = window[first_match].offset - min_offset;
+
             if ( ((this_num_match > best_num_match) ||
                  (this_num_match == best_num_match && this_displacement < best_displacement))) {
                 best_displacement = this_displacement;
                 best_num_match = this_num_match;
-                max_offset = std::min((uint16_t)255, window.front().offset);
+                max_offset = std::min((uint16_t)255, window[0].offset);
+
                 if(populate_window) {
-                    best_window = this_window;
+                    // tokens that have run out of offsets, or that are outside the window, have no offset
+                    std::fill(best_window, best_window + tokens_size, TokenOffset{});
+                    for (size_t i = 0; i < window_size; i++) {
+                        best_window[window[i].token_id] = window[i];
+                        if(i < first_match) {
+                            best_window[window[i].token_id].offset = MAX_DISPLACEMENT;
+                        }
+                    }
                 }
             }
 
-            if (best_num_match == tokens_size && best_displacement == (window.size() - 1)) {
+            if (best_num_match == tokens_size && best_displacement == (window_size - 1)) {
                 // this is the best we can get, so quit early!
                 break;
             }
 
             // fill window with next possible smallest offset across available token this_token_offsets
-            const TokenOffset &smallest_offset = window.back();
-            window.pop_back();
+            const TokenOffset smallest_offset = window[--window_size];
 
             const uint8_t token_id = smallest_offset.token_id;
             const std::vector<uint16_t>& this_token_offsets = token_offsets[token_id].positions;
@@ -222,8 +180,8 @@ struct Match {
 
             // Push next offset of same token popped
             uint32_t next_offset_index = (smallest_offset.offset_index + 1);
-            TokenOffset token_offset{token_id, this_token_offsets[next_offset_index], next_offset_index};
-            window.emplace_back(token_offset);
+            insert_sorted(window, window_size,
+                          TokenOffset{token_id, this_token_offsets[next_offset_index], next_offset_index});
         }
 
         if (best_displacement == MAX_DISPLACEMENT) {
@@ -233,7 +191,7 @@ struct Match {
         words_present = best_num_match;
         distance = uint8_t(best_displacement);
         if(populate_window) {
-            offsets = best_window;
+            offsets.assign(best_window, best_window + tokens_size);
         }
 
         exact_match = 0;
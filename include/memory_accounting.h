@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <json.hpp>
+
+// the in-memory structures of an index that memory is accounted to
+enum memory_structure_t {
+    MEMORY_TEXT = 0,        // ART and posting lists of string fields
+    MEMORY_FACET,
+    MEMORY_NUMERIC,
+    MEMORY_SORT,
+    MEMORY_STRING_SORT,
+    MEMORY_INFIX,
+    MEMORY_GEO,
+    MEMORY_VECTOR,
+    MEMORY_REFERENCE,
+    MEMORY_IDS,
+    NUM_MEMORY_STRUCTURES
+};
+
+// Bytes held by each structure of an index, kept up to date as documents are indexed and removed.
+class index_memory_stats_t {
+private:
+    std::array<std::atomic<int64_t>, NUM_MEMORY_STRUCTURES> bytes{};
+
+public:
+    static const char* get_name(memory_structure_t structure);
+
+    void add(memory_structure_t structure, int64_t delta) {
+        bytes[structure].fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    int64_t get(memory_structure_t structure) const;
+
+    int64_t total() const;
+
+    void clear();
+
+    nlohmann::json to_json() const;
+};
+
+// Accounts the memory that the current thread allocates and frees while the scope is alive to a structure, from the
+// allocation counters that jemalloc keeps per thread. Memory that is freed before the scope ends, like temporary
+// buffers, nets out. Scopes nest: the memory of an inner scope is accounted only to the inner structure.
+class memory_accounting_scope_t {
+private:
+    index_memory_stats_t& stats;
+    memory_structure_t structure;
+    int64_t begin_bytes;
+    memory_accounting_scope_t* parent;
+
+    static thread_local memory_accounting_scope_t* current;
+
+public:
+    memory_accounting_scope_t(index_memory_stats_t& stats, memory_structure_t structure);
+
+    ~memory_accounting_scope_t();
+
+    memory_accounting_scope_t(const memory_accounting_scope_t&) = delete;
+
+    memory_accounting_scope_t& operator=(const memory_accounting_scope_t&) = delete;
+
+    // bytes allocated minus bytes freed by this thread so far, 0 when the counters are not available
+    static int64_t thread_net_allocated();
+};
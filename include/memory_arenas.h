@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <json.hpp>
+
+// Controls how jemalloc lays out and returns memory.
+//
+// With arenas enabled, the indexing and the search threads allocate from arenas of their own, so that the short-lived
+// scratch memory of searches doesn't end up on the same pages as the long-lived structures of the index and keep
+// those pages from being returned after large deletes. The decay times of all arenas are tuned from the config, and
+// large deletes ask the housekeeper for an explicit purge of the pages that were freed.
+class MemoryArenas {
+public:
+    enum subsystem_t {
+        INDEXING = 0,
+        SEARCH,
+        NUM_SUBSYSTEMS
+    };
+
+    // documents that a delete has to remove before it asks for a purge
+    static constexpr size_t PURGE_MIN_DELETED_DOCS = 10 * 1000;
+
+private:
+    std::atomic<bool> enabled = false;
+    std::atomic<bool> purge_requested = false;
+
+    // jemalloc arena index of each subsystem
+    std::array<unsigned, NUM_SUBSYSTEMS> arena_ids{};
+
+    MemoryArenas() {}
+
+    ~MemoryArenas() {}
+
+public:
+
+    static MemoryArenas& get_instance() {
+        static MemoryArenas instance;
+        return instance;
+    }
+
+    MemoryArenas(MemoryArenas const&) = delete;
+
+    void operator=(MemoryArenas const&) = delete;
+
+    static const char* get_name(subsystem_t subsystem);
+
+    // Sets the decay times of all arenas and, when `create_arenas` is true, creates an arena for every subsystem.
+    // Returns false when jemalloc is not available.
+    bool init(bool create_arenas, int64_t dirty_decay_ms, int64_t muzzy_decay_ms);
+
+    // Makes the allocations of the calling thread come from the arena of the subsystem.
+    void bind_thread(subsystem_t subsystem) const;
+
+    // Large deletes ask for a purge, which the housekeeper then does outside of the write path.
+    void request_purge();
+
+    // Returns the purged arenas to the OS, if a purge was asked for.
+    bool purge_if_requested();
+
+    static void purge();
+
+    void get_metrics(nlohmann::json& result) const;
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Recycles small, fixed size allocations (e.g. the nodes of a node based container that has entries erased and
+// inserted over and over) through a free list, carving new ones out of geometrically growing blocks. All of the
+// memory is released when the pool is destroyed. Not thread safe.
+template<size_t SLOT_SIZE = 32>
+class node_pool_t {
+private:
+    struct free_slot_t {
+        free_slot_t* next;
+    };
+
+    static_assert(SLOT_SIZE >= sizeof(free_slot_t), "Slot must be able to hold a free list pointer.");
+    // every slot of a block is then as aligned as the block itself
+    static_assert(SLOT_SIZE % alignof(std::max_align_t) == 0, "Slot size must be a multiple of max alignment.");
+
+    static constexpr size_t MAX_BLOCK_SLOTS = 4096;
+
+    std::vector<void*> blocks;
+    free_slot_t* free_list = nullptr;
+
+    char* block_pos = nullptr;
+    size_t block_slots_left = 0;
+    size_t next_block_slots = 16;
+
+public:
+    node_pool_t() = default;
+
+    node_pool_t(const node_pool_t&) = delete;
+
+    node_pool_t& operator=(const node_pool_t&) = delete;
+
+    ~node_pool_t() {
+        for(void* block: blocks) {
+            ::operator delete(block);
+        }
+    }
+
+    static constexpr bool fits(size_t size) {
+        return size <= SLOT_SIZE;
+    }
+
+    void* allocate() {
+        if(free_list != nullptr) {
+            void* slot = free_list;
+            free_list = free_list->next;
+            return slot;
+        }
+
+        if(block_slots_left == 0) {
+            block_pos = static_cast<char*>(::operator new(SLOT_SIZE * next_block_slots));
+            blocks.push_back(block_pos);
+            block_slots_left = next_block_slots;
+            next_block_slots = std::min(next_block_slots * 2, MAX_BLOCK_SLOTS);
+        }
+
+        void* slot = block_pos;
+        block_pos += SLOT_SIZE;
+        block_slots_left--;
+        return slot;
+    }
+
+    void deallocate(void* slot) {
+        auto free_slot = static_cast<free_slot_t*>(slot);
+        free_slot->next = free_list;
+        free_list = free_slot;
+    }
+};
+
+// Allocator that takes single objects that fit a slot from a `node_pool_t` and anything else (e.g. the bucket array
+// of a hash map) from the heap. The pool must outlive every container that uses it.
+template<class T, size_t SLOT_SIZE = 32>
+struct node_pool_allocator_t {
+    typedef T value_type;
+
+    template<class U>
+    struct rebind {
+        typedef node_pool_allocator_t<U, SLOT_SIZE> other;
+    };
+
+    node_pool_t<SLOT_SIZE>* pool;
+
+    explicit node_pool_allocator_t(node_pool_t<SLOT_SIZE>* pool): pool(pool) {
+
+    }
+
+    template<class U>
+    node_pool_allocator_t(const node_pool_allocator_t<U, SLOT_SIZE>& other): pool(other.pool) {
+
+    }
+
+    T* allocate(size_t n) {
+        if(n == 1 && node_pool_t<SLOT_SIZE>::fits(sizeof(T))) {
+            return static_cast<T*>(pool->allocate());
+        }
+
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        if(n == 1 && node_pool_t<SLOT_SIZE>::fits(sizeof(T))) {
+            pool->deallocate(p);
+            return ;
+        }
+
+        ::operator delete(p);
+    }
+
+    template<class U>
+    bool operator==(const node_pool_allocator_t<U, SLOT_SIZE>& other) const {
+        return pool == other.pool;
+    }
+
+    template<class U>
+    bool operator!=(const node_pool_allocator_t<U, SLOT_SIZE>& other) const {
+        return pool != other.pool;
+    }
+};
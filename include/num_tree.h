@@ -1,7 +1,9 @@
 #pragma once
 
+#include <functional>
 #include <map>
 #include "sparsepp.h"
+#include "sorted_block_map.h"
 #include "sorted_array.h"
 #include "array_utils.h"
 #include "ids_t.h"
@@ -9,17 +11,17 @@
 
 class num_tree_t {
 private:
-    std::map<int64_t, void*> int64map;
+    sorted_block_map_t<int64_t, void*> int64map;
 
     [[nodiscard]] bool range_inclusive_contains(const int64_t& start, const int64_t& end, const uint32_t& id) const;
 
     [[nodiscard]] bool contains(const int64_t& value, const uint32_t& id) const {
-        if (int64map.count(value) == 0) {
+        auto it = int64map.find(value);
+        if (it == int64map.end()) {
             return false;
         }
 
-        auto ids = int64map.at(value);
-        return ids_t::contains(ids, id);
+        return ids_t::contains(it->second, id);
     }
 
 public:
@@ -28,6 +30,10 @@ public:
 
     void insert(int64_t value, uint32_t id, bool is_facet=false);
 
+    /// Inserts a batch of (value, id) pairs, e.g. all the values of a field in a batch of documents. The pairs are
+    /// sorted in place. When the batch brings in many new values, the tree is rebuilt in one pass.
+    void insert_many(std::vector<std::pair<int64_t, uint32_t>>& values_ids);
+
     void range_inclusive_search(int64_t start, int64_t end, uint32_t** ids, size_t& ids_len);
 
     void approx_range_inclusive_search_count(int64_t start, int64_t end, uint32_t& ids_len);
@@ -50,6 +56,16 @@ public:
 
     void seq_ids_outside_top_k(size_t k, std::vector<uint32_t>& seq_ids);
 
+    /// Visits the values in sorted order (largest first when `descending`), passing the ids of each value to
+    /// `visit_value` until it returns false.
+    void visit_values_in_order(bool descending,
+                               const std::function<bool(int64_t value, const std::vector<uint32_t>& ids)>& visit_value);
+
+    /// Visits the ids of each of the sorted `values` that is present in the tree, along with the position of the value.
+    /// Few values are looked up one by one, while many values are merged with a single ordered pass over the tree.
+    void visit_ids_of_values(const uint32_t* values, size_t values_len,
+                             const std::function<void(size_t value_index, const std::vector<uint32_t>& ids)>& visit_ids);
+
     void contains(const NUM_COMPARATOR& comparator, const int64_t& value,
                   const uint32_t& context_ids_length,
                   uint32_t* const& context_ids,
@@ -58,6 +74,9 @@ public:
 
     std::pair<int64_t, int64_t> get_min_max(const uint32_t* result_ids, size_t result_ids_len);
 
+    /// Min and max of all the values, false when the tree is empty.
+    bool get_min_max(int64_t& min, int64_t& max) const;
+
     class iterator_t {
         /// If true, `id_list_array` is initialized otherwise `id_list_iterator` is.
         bool is_compact_id_list = true;
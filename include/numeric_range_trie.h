@@ -1,6 +1,9 @@
 #pragma once
 
+#include <functional>
 #include <ids_t.h>
+#include <s2/s2point.h>
+#include <s2/s1chord_angle.h>
 
 constexpr short EXPANSE = 256;
 
@@ -54,12 +57,24 @@ class NumericTrie {
 
         void delete_geopoint(const uint64_t& cell_id, uint32_t id, const char& max_level);
 
+        void search_nearest_geopoints(const S2Point& point, const char& max_level,
+                                      const std::function<bool(const S1ChordAngle&,
+                                                               const std::vector<uint32_t>&)>& visit_cell);
+
         void get_all_ids(uint32_t*& ids, uint32_t& ids_length);
 
         void get_all_ids(std::vector<uint32_t>& result);
 
         uint32_t get_ids_length();
 
+        void* get_seq_ids() const {
+            return seq_ids;
+        }
+
+        // Unions the ids of `matches` into `ids`: through a bitmap when they are dense relative to their span, and
+        // with a lazy k-way merge of the node lists otherwise, so that the ids are never sorted.
+        static void merge_ids(const std::vector<Node*>& matches, uint32_t*& ids, uint32_t& ids_length);
+
         void search_range(const int64_t& low, const int64_t& high, const char& max_level,
                           uint32_t*& ids, uint32_t& ids_length);
 
@@ -95,30 +110,31 @@ public:
         delete positive_trie;
     }
 
+    // Lazily unions the id lists of the matched nodes with a k-way merge over a min-heap of the list iterators.
     class iterator_t {
-        struct match_state {
-            uint32_t* ids = nullptr;
-            uint32_t ids_length = 0;
-            uint32_t index = 0;
+        std::vector<id_list_t*> id_lists;
 
-            explicit match_state(uint32_t*& ids, uint32_t& ids_length) : ids(ids), ids_length(ids_length) {}
+        // full copies of the compact lists, owned by the iterator
+        std::vector<id_list_t*> expanded_id_lists;
 
-            ~match_state() {
-                delete [] ids;
-            }
-        };
+        std::vector<id_list_t::iterator_t> its;
+
+        // indices of the valid `its`, as a min-heap on their current id
+        std::vector<uint32_t> heap;
 
-        std::vector<match_state*> matches;
+        void build_heap();
 
         void set_seq_id();
 
     public:
 
-        explicit iterator_t(std::vector<Node*>& matches);
+        explicit iterator_t(const std::vector<Node*>& matches);
+
+        iterator_t(iterator_t&& rhs) noexcept;
 
         ~iterator_t() {
-            for (auto& match: matches) {
-                delete match;
+            for (auto& expanded_id_list: expanded_id_lists) {
+                delete expanded_id_list;
             }
         }
 
@@ -142,6 +158,12 @@ public:
 
     void delete_geopoint(const uint64_t& cell_id, uint32_t id);
 
+    /// Visits the leaf cells of the geopoint index in the increasing order of their distance from `point`, handing
+    /// over the ids indexed in each cell. The walk stops once `visit_cell` returns false.
+    void search_nearest_geopoints(const S2Point& point,
+                                  const std::function<bool(const S1ChordAngle& cell_distance,
+                                                           const std::vector<uint32_t>& ids)>& visit_cell);
+
     void search_range(const int64_t& low, const bool& low_inclusive,
                       const int64_t& high, const bool& high_inclusive,
                       uint32_t*& ids, uint32_t& ids_length);
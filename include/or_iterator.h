@@ -9,10 +9,14 @@
  */
 class or_iterator_t {
 private:
+    // a min-heap on the ids of the iterators, so that a step costs O(log n) instead of a scan of all the iterators
     std::vector<posting_list_t::iterator_t> its;
-    int curr_index = 0;
 
-    void advance_smallest();
+    static bool greater_id(const posting_list_t::iterator_t& a, const posting_list_t::iterator_t& b);
+
+    // advances the iterator at the top of the heap with `advance` and restores the heap
+    template<class T>
+    void advance_top(T advance);
 
 public:
     explicit or_iterator_t(std::vector<posting_list_t::iterator_t>& its);
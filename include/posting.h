@@ -78,6 +78,9 @@ public:
 
     static void upsert(void*& obj, uint32_t id, const std::vector<uint32_t>& offsets);
 
+    // Upserts a batch of postings in the order of their IDs. When an ID repeats, its last posting wins.
+    static void upsert_many(void*& obj, std::vector<id_offsets_t>& postings);
+
     static void erase(void*& obj, uint32_t id);
 
     static void destroy_list(void*& obj);
@@ -8,6 +8,9 @@
 #include "thread_local_vars.h"
 
 typedef uint32_t last_id_t;
+
+// a posting of a batch: the document ID and the offsets of the token in it
+typedef std::pair<uint32_t, const std::vector<uint32_t>*> id_offsets_t;
 class filter_result_iterator_t;
 
 struct result_iter_state_t {
@@ -84,11 +87,16 @@ public:
         bool auto_destroy;
         uint32_t field_id;
 
+        // offsets are only needed for scoring the candidates that survive an intersection, so they are
+        // decompressed lazily, on first access within the current block
+        mutable uint32_t* offset_index = nullptr;
+        mutable uint32_t* offsets = nullptr;
+
+        void decompress_offsets() const;
+
     public:
         // uncompressed data structures for performance
         uint32_t* ids = nullptr;
-        uint32_t* offset_index = nullptr;
-        uint32_t* offsets = nullptr;
 
         explicit iterator_t(const std::map<last_id_t, block_t*>* id_block_map,
                             block_t* start, block_t* end, bool auto_destroy = true, uint32_t field_id = 0, bool reverse = false);
@@ -110,6 +118,8 @@ public:
         [[nodiscard]] inline uint32_t index() const;
         [[nodiscard]] inline block_t* block() const;
         [[nodiscard]] uint32_t get_field_id() const;
+        [[nodiscard]] const uint32_t* get_offset_index() const;
+        [[nodiscard]] const uint32_t* get_offsets() const;
 
         posting_list_t::iterator_t clone() const;
     };
@@ -155,8 +165,15 @@ public:
 
     static void merge_adjacent_blocks(block_t* block1, block_t* block2, size_t num_block2_ids_to_move);
 
+    // loads `num_ids` IDs with their offset indices and the offsets from `offsets_begin` to `offsets_end` into `block`
+    static void load_block(block_t* block, const uint32_t* ids, const uint32_t* offset_index, uint32_t num_ids,
+                           const uint32_t* offsets, uint32_t offsets_begin, uint32_t offsets_end);
+
     void upsert(uint32_t id, const std::vector<uint32_t>& offsets);
 
+    // Upserts postings that are sorted on unique IDs, decompressing and recompressing each affected block once.
+    void upsert_sorted(const id_offsets_t* postings, size_t num_postings);
+
     void erase(uint32_t id);
 
     void dump();
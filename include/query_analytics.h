@@ -6,6 +6,43 @@
 #include <json.hpp>
 #include <atomic>
 #include <shared_mutex>
+#include <set>
+#include <unordered_map>
+
+// Space-Saving heavy hitters summary: tracks at most `capacity` keys. When full, the key with the smallest count is
+// replaced by the new key, which inherits that count as its over-estimation error.
+class space_saving_sketch_t {
+public:
+    struct counter_t {
+        uint32_t count;
+        uint32_t error;
+    };
+
+private:
+    size_t capacity;
+    std::unordered_map<std::string, counter_t> counters;
+
+    // (count, key) ordered by smallest count first
+    std::set<std::pair<uint32_t, std::string>> min_counts;
+
+public:
+
+    explicit space_saving_sketch_t(size_t capacity);
+
+    void add(const std::string& key, uint32_t count = 1);
+
+    // merges counts of another summary into this one
+    void merge(const space_saving_sketch_t& other);
+
+    // keys with the largest estimated counts, in descending order of count
+    std::vector<std::pair<std::string, uint32_t>> top(size_t k) const;
+
+    const std::unordered_map<std::string, counter_t>& get_counters() const;
+
+    size_t size() const;
+
+    void clear();
+};
 
 class QueryAnalytics {
 public:
@@ -25,8 +62,12 @@ private:
 
     bool expand_query = false;
 
+    // when enabled, counts are aggregated in `top_k_sketch` instead of `local_counts`
+    bool enable_top_k_sketch = false;
+
     // counts aggregated within the current node
     tsl::htrie_map<char, uint32_t> local_counts;
+    space_saving_sketch_t top_k_sketch;
     std::shared_mutex lmutex;
 
     std::unordered_map<std::string, std::vector<QWithTimestamp>> user_prefix_queries;
@@ -52,4 +93,6 @@ public:
     tsl::htrie_map<char, uint32_t> get_local_counts();
 
     void set_expand_query(bool expand_query);
+
+    void set_enable_top_k_sketch(bool enable_top_k_sketch);
 };
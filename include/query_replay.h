@@ -0,0 +1,47 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <json.hpp>
+#include "option.h"
+
+// A request to be replayed against a node.
+struct replay_request_t {
+    std::string method;
+    // path and query string, already URL encoded
+    std::string path;
+    std::string body;
+};
+
+struct query_replay_t {
+    static constexpr const char* SEARCH_LOG_EVENT = "event=search_request";
+
+    // Parses a line that is either a search log line (logged when `enable-search-logging` is on) or a JSON object
+    // of the form {"method": "GET", "path": "/collections/c/documents/search", "params": {"q": "a"}, "body": ...}.
+    // Returns an error for lines that are neither, e.g. the other lines of a server log.
+    static Option<replay_request_t> parse_line(const std::string& line);
+
+    static std::string url_encode(const std::string& text);
+};
+
+// Latencies and outcomes of replayed requests: can be added to from many threads.
+class replay_stats_t {
+private:
+    mutable std::mutex mutex;
+    std::vector<uint64_t> latencies_us;
+    std::map<long, size_t> status_counts;
+    size_t num_errors = 0;
+
+public:
+    // `status_code` of 0 means that no response was received
+    void add(long status_code, uint64_t latency_us);
+
+    size_t size() const;
+
+    // `percentile` within [0, 100]
+    static uint64_t get_percentile(const std::vector<uint64_t>& sorted_values, double percentile);
+
+    nlohmann::json to_json(double elapsed_s) const;
+};
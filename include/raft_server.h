@@ -7,7 +7,10 @@
 #include <braft/util.h>                  // braft::AsyncClosureGuard
 #include <braft/protobuf_file.h>         // braft::ProtoBufFile
 #include <rocksdb/db.h>
+#include <deque>
 #include <future>
+#include <thread>
+#include <unordered_map>
 
 #include "http_data.h"
 #include "threadpool.h"
@@ -44,6 +47,24 @@ public:
     void Run();
 };
 
+// Closure of a log entry that carries several writes coalesced together
+class WriteBatchClosure : public braft::Closure {
+private:
+    const std::vector<std::pair<std::shared_ptr<http_req>, std::shared_ptr<http_res>>> req_res;
+
+public:
+    explicit WriteBatchClosure(std::vector<std::pair<std::shared_ptr<http_req>, std::shared_ptr<http_res>>>&& req_res):
+                               req_res(std::move(req_res)) {
+
+    }
+
+    const std::vector<std::pair<std::shared_ptr<http_req>, std::shared_ptr<http_res>>>& get_req_res() const {
+        return req_res;
+    }
+
+    void Run();
+};
+
 // Closure that fires when refresh nodes operation finishes
 class RefreshNodesClosure : public braft::Closure {
 public:
@@ -100,8 +121,17 @@ class ReplicationState : public braft::StateMachine {
 private:
     static constexpr const char* db_snapshot_name = "db_snapshot";
     static constexpr const char* analytics_db_snapshot_name = "analytics_db_snapshot";
+    static constexpr const char* index_image_name = "index_image";
     static constexpr const char* BATCHED_INDEXER_STATE_KEY = "$BI";
 
+    // prefix of log entries that carry several writes: it can't start a serialized request, which is a JSON object
+    static constexpr const char* WRITE_BATCH_MAGIC = "\x01TWB";
+    static constexpr size_t WRITE_BATCH_MAGIC_SIZE = 4;
+
+    // prefix of zlib compressed log entries, which is followed by the size of the uncompressed entry
+    static constexpr const char* LOG_COMPRESSION_MAGIC = "\x02TZL";
+    static constexpr size_t LOG_COMPRESSION_MAGIC_SIZE = 4;
+
     mutable std::shared_mutex node_mutex;
 
     braft::Node* volatile node;
@@ -114,7 +144,6 @@ private:
     Store* analytics_store;
 
     ThreadPool* thread_pool;
-    http_message_dispatcher* message_dispatcher;
 
     const bool api_uses_ssl;
 
@@ -140,6 +169,21 @@ private:
     std::atomic<bool> shutting_down;
     std::atomic<size_t> pending_writes;
 
+    // writes waiting to be coalesced into a single log entry, along with their serialized form
+    std::mutex write_batch_mutex;
+    std::condition_variable write_batch_cv;
+    std::vector<std::pair<std::shared_ptr<http_req>, std::shared_ptr<http_res>>> write_batch;
+    std::vector<std::string> write_batch_data;
+    size_t write_batch_bytes = 0;
+    bool write_batch_quit = false;
+    std::thread write_batch_thread;
+
+    // Single document writes that a follower forwards to the leader while an earlier forward to the same url is in
+    // flight. They are sent together, as a single import, once that forward returns.
+    std::mutex forward_batch_mutex;
+    std::unordered_map<std::string,
+                       std::vector<std::pair<std::shared_ptr<http_req>, std::shared_ptr<http_res>>>> forward_batches;
+
     std::atomic<size_t> snapshot_in_progress;
 
     const uint64_t snapshot_interval_s;     // frequency of actual snapshotting
@@ -147,15 +191,50 @@ private:
 
     butil::EndPoint peering_endpoint;
 
+    // Log entries applied by this node, as they were appended, for the learners and the change streams to follow.
+    // The feed has every entry that was applied from `log_feed_first_index` on, and is trimmed to
+    // `learner-feed-max-bytes`.
+    std::mutex log_feed_mutex;
+    std::condition_variable log_feed_cv;
+    std::deque<std::pair<int64_t, std::string>> log_feed;
+    size_t log_feed_bytes = 0;
+    int64_t log_feed_first_index = 0;
+    int64_t log_feed_last_index = 0;
+
+    // A learner has no raft node: it pulls the entries applied by one of the voters, the `learner_source`, after
+    // bootstrapping from a snapshot of it, and applies them like a follower does.
+    std::mutex learner_mutex;
+    std::string learner_source;
+    size_t learner_source_pos = 0;
+    std::atomic<int64_t> learner_applied_index = 0;
+    std::atomic<int64_t> learner_lag = -1;
+
 public:
 
     static constexpr const char* log_dir_name = "log";
     static constexpr const char* meta_dir_name = "meta";
     static constexpr const char* snapshot_dir_name = "snapshot";
 
+    static constexpr uint64_t STRONG_READ_TIMEOUT_MS = 5000;
+    static constexpr uint64_t READ_INDEX_POLL_INTERVAL_MS = 2;
+
+    static constexpr const char* learner_snapshot_dir_name = "learner_snapshot";
+
+    // log entries sent to a learner in one pull, and size of the chunks of the snapshot files it downloads
+    static constexpr size_t LEARNER_PULL_MAX_BYTES = 8 * 1024 * 1024;
+    static constexpr size_t LEARNER_SNAPSHOT_CHUNK_BYTES = 4 * 1024 * 1024;
+
+    // snapshots that are triggered for learners are at least this far apart
+    static constexpr uint64_t LEARNER_SNAPSHOT_MIN_INTERVAL_S = 60;
+
+    // longest wait of a change stream request for new writes
+    static constexpr uint64_t CHANGES_MAX_WAIT_MS = 10 * 1000;
+
+    // forwarded writes beyond this many, that wait for an earlier forward to the same url, are sent on their own
+    static constexpr size_t FORWARD_BATCH_MAX_WRITES = 1000;
+
     ReplicationState(HttpServer* server, BatchedIndexer* batched_indexer, Store* store, Store* analytics_store,
-                     ThreadPool* thread_pool, http_message_dispatcher* message_dispatcher,
-                     bool api_uses_ssl, const Config* config,
+                     ThreadPool* thread_pool, bool api_uses_ssl, const Config* config,
                      size_t num_collections_parallel_load, size_t num_documents_parallel_load);
 
     // Starts this node
@@ -167,8 +246,46 @@ public:
     // Generic write method for synchronizing all writes
     void write(const std::shared_ptr<http_req>& request, const std::shared_ptr<http_res>& response);
 
-    // Generic read method for consistent reads, not used for now
-    void read(const std::shared_ptr<http_res>& response);
+    // Waits until this node has applied and indexed the writes up to the committed index of the leader when the
+    // read began, so that a read served by a follower sees every write that was acknowledged before it. Leadership
+    // is not confirmed with a quorum for each read: a leader that loses its quorum steps down within an election
+    // timeout, which bounds how long a stale leader can hand out its committed index. A read of a collection waits
+    // only for the writes of that collection to be indexed.
+    Option<bool> wait_for_read_index(uint64_t timeout_ms, const std::string& collection = "");
+
+    // Starts this node as a learner of the voters in `nodes`: it does not join their raft group.
+    int start_learner(const std::string& raft_dir);
+
+    // Pulls the entries that one of the voters applied since the last pull, after bootstrapping from a snapshot of
+    // the voter when this learner has no state or has fallen behind the entries that the voter keeps.
+    void follow_voters(const std::string& nodes);
+
+    bool is_learner() const {
+        return config->get_learner();
+    }
+
+    // Entries applied by this voter after `after_index`, for a learner, encoded by `encode_log_feed()`.
+    Option<bool> get_learner_log_entries(int64_t after_index, std::string& feed);
+
+    // Name, index and files of the latest snapshot of this voter, which a learner bootstraps from. A snapshot is
+    // triggered when the latest one is older than the entries that the voter keeps for learners.
+    Option<nlohmann::json> get_learner_snapshot_manifest();
+
+    Option<bool> read_learner_snapshot_file(const std::string& snapshot_name, const std::string& file_path,
+                                            size_t offset, std::string& chunk);
+
+    // Writes applied after the log entry at `after_index`, in the order of their entries, for another cluster to
+    // apply: waits up to `wait_ms` for one when there is none yet. Each change has the `index` of its entry, the
+    // `method`, `path` and `params` of the write and its `body`. The body of a large import spans the changes of
+    // several entries, from the one with `first_chunk` to the one with `last_chunk`, which share a `request_id`.
+    Option<nlohmann::json> get_changes(int64_t after_index, uint64_t wait_ms);
+
+    // The committed index of the voter, followed by the index, size and data of each entry.
+    static std::string encode_log_feed(int64_t committed_index,
+                                       const std::vector<std::pair<int64_t, std::string>>& entries);
+
+    static bool decode_log_feed(const std::string& feed, int64_t& committed_index,
+                                std::vector<std::pair<int64_t, std::string>>& entries);
 
     // updates cluster membership
     void refresh_nodes(const std::string & nodes, const size_t raft_counter,
@@ -192,6 +309,10 @@ public:
         return write_caught_up;
     }
 
+    // While the collections are loaded, reads of a collection are served as soon as it is loaded, even though the
+    // node as a whole is not caught up yet.
+    bool is_collection_read_ready(const std::string& collection_name) const;
+
     bool is_alive() const;
 
     uint64_t node_state() const;
@@ -220,7 +341,8 @@ public:
 
     void persist_applying_index();
 
-    http_message_dispatcher* get_message_dispatcher() const;
+    // dispatcher of the http event loop that serves `req`
+    http_message_dispatcher* get_message_dispatcher(const std::shared_ptr<http_req>& req) const;
 
     void wait() {
         auto lk = std::unique_lock<std::mutex>(mcv);
@@ -238,6 +360,8 @@ public:
 
     int64_t get_num_queued_writes();
 
+    void get_num_queued_writes(nlohmann::json& coll_queue_stats);
+
     bool is_leader();
 
     nlohmann::json get_status();
@@ -248,6 +372,29 @@ public:
 
     void decr_pending_writes();
 
+    // Log entry of several serialized writes: the magic prefix followed by each write, prefixed by its length.
+    static std::string encode_write_batch(const std::vector<std::string>& serialized_reqs);
+
+    // Returns false when `data` is not a log entry of several writes.
+    static bool decode_write_batch(const std::string& data, std::vector<std::string>& serialized_reqs);
+
+    // Returns false when the entry does not get any smaller, in which case it is appended as it is.
+    static bool compress_log_entry(const std::string& data, std::string& compressed_data);
+
+    // Returns false when `data` is not a compressed log entry.
+    static Option<bool> decompress_log_entry(const std::string& data, std::string& uncompressed_data);
+
+    // Whether a write can be forwarded to the leader along with others, as a line of an import.
+    static bool is_batchable_forward(const std::string& method, const std::string& path, const std::string& body);
+
+    // url of the import that carries a batch of the single document writes to `url`
+    static std::string get_forward_batch_url(const std::string& url);
+
+    // Splits the response of the import of a forwarded batch into the status and body of each write, as they would
+    // have been returned for the write alone. Returns false when there is no result for each of the writes.
+    static bool split_forward_batch_response(const std::string& import_res, size_t num_writes,
+                                             std::vector<std::pair<long, std::string>>& results);
+
 private:
 
     friend class ReplicationClosure;
@@ -255,12 +402,41 @@ private:
     // actual application of writes onto the WAL
     void on_apply(braft::Iterator& iter);
 
+    void apply_write(const std::string& serialized_req, braft::Closure* done);
+
+    // hands the writes of a log entry that was appended by another node to the batched indexer
+    void enqueue_log_entry(int64_t index, const std::string& data);
+
+    void record_log_feed_entry(int64_t index, std::string&& data);
+
+    // whether the feed misses entries after `after_index` (`log_feed_mutex` must be held)
+    bool log_feed_has_gap(int64_t after_index, int64_t known_applied_index) const;
+
+    // entries of the feed after `after_index`, up to `max_bytes` (`log_feed_mutex` must be held)
+    void get_log_feed_entries(int64_t after_index, size_t max_bytes,
+                              std::vector<std::pair<int64_t, std::string>>& entries) const;
+
+    void append_changes(int64_t index, const std::string& data, nlohmann::json& changes);
+
+    // replaces the stores and the collections with those of the snapshot at `snapshot_path`
+    int load_snapshot(const std::string& snapshot_path);
+
+    Option<bool> bootstrap_learner(const std::string& source_addr);
+
+    // applies the writes that were coalesced as a single log entry (`write_batch_mutex` must be held)
+    void flush_write_batch();
+
+    void write_batch_loop();
+
     struct SnapshotArg {
         ReplicationState* replication_state;
         braft::SnapshotWriter* writer;
         std::string state_dir_path;
         std::string db_snapshot_path;
         std::string analytics_db_snapshot_path;
+        std::map<std::string, std::string> db_sst_file_ids;
+        std::map<std::string, std::string> analytics_db_sst_file_ids;
+        std::string index_image_path;
         std::string ext_snapshot_path;
         braft::Closure* done;
     };
@@ -304,6 +480,13 @@ private:
 
     void write_to_leader(const std::shared_ptr<http_req>& request, const std::shared_ptr<http_res>& response);
 
+    // proxies the write to `url` and sends back the response of the leader
+    void forward_write(const std::shared_ptr<http_req>& request, const std::shared_ptr<http_res>& response,
+                       HttpServer* server, const std::string& path, const std::string& url);
+
+    // sends the writes that queued up for `url` as batches, until none are left
+    void forward_write_batches(const std::string& url, HttpServer* server, const std::string& path);
+
     void do_dummy_write();
 
     std::string get_node_url_path(const std::string& node_addr, const std::string& path,
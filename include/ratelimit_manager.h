@@ -2,6 +2,7 @@
 
 #include <string>
 #include <vector>
+#include <array>
 #include <tuple>
 #include <unordered_map>
 #include <mutex>
@@ -11,6 +12,7 @@
 #include "lru/lru.hpp"
 #include "option.h"
 #include "store.h"
+#include "request_cost.h"
 
 
 
@@ -45,6 +47,19 @@ struct rate_limit_max_requests_t {
 
 };
 
+// Max cost struct for rate limit rules: the CPU time and the bytes scanned by the requests of a rule's entities
+struct rate_limit_max_cost_t {
+    int64_t cpu_ms_minute_threshold = -1;
+    int64_t cpu_ms_hour_threshold = -1;
+    int64_t bytes_scanned_minute_threshold = -1;
+    int64_t bytes_scanned_hour_threshold = -1;
+
+    bool empty() const {
+        return cpu_ms_minute_threshold < 0 && cpu_ms_hour_threshold < 0 &&
+               bytes_scanned_minute_threshold < 0 && bytes_scanned_hour_threshold < 0;
+    }
+};
+
 // Entry struct for rate limit rule pointer hash map as key
 struct rate_limit_entity_t {
     RateLimitedEntityType entity_type;
@@ -62,6 +77,7 @@ struct rate_limit_rule_t {
     RateLimitAction action;
     std::vector<rate_limit_entity_t> entities;
     rate_limit_max_requests_t max_requests;
+    rate_limit_max_cost_t max_cost;
     int64_t auto_ban_1m_threshold = -1;
     int64_t auto_ban_1m_duration_hours = -1;
     bool apply_limit_per_entity = false;
@@ -81,12 +97,25 @@ struct request_counter_t {
     time_t last_reset_time_minute = 0;
     time_t last_reset_time_hour = 0;
 
+    // cost of the requests made in the current and the previous sampling period
+    uint64_t current_cpu_us_minute = 0;
+    uint64_t current_cpu_us_hour = 0;
+    uint64_t previous_cpu_us_minute = 0;
+    uint64_t previous_cpu_us_hour = 0;
+    uint64_t current_bytes_scanned_minute = 0;
+    uint64_t current_bytes_scanned_hour = 0;
+    uint64_t previous_bytes_scanned_minute = 0;
+    uint64_t previous_bytes_scanned_hour = 0;
+
     void reset() {
         current_requests_count_minute = 0;
         current_requests_count_hour = 0;
         threshold_exceed_count_minute = 0;
         previous_requests_count_minute = 0;
         previous_requests_count_hour = 0;
+        current_cpu_us_minute = current_cpu_us_hour = previous_cpu_us_minute = previous_cpu_us_hour = 0;
+        current_bytes_scanned_minute = current_bytes_scanned_hour = 0;
+        previous_bytes_scanned_minute = previous_bytes_scanned_hour = 0;
         last_reset_time_minute = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
         last_reset_time_hour = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
     }
@@ -142,6 +171,22 @@ struct rate_limit_exceed_t {
 };
 
 
+// Struct to aggregate the cost of the requests made with an API key on a collection
+struct request_usage_t {
+    std::string api_key;
+    std::string collection;
+    uint64_t num_requests = 0;
+    uint64_t cpu_us = 0;
+    uint64_t posting_bytes_scanned = 0;
+    uint64_t num_docs_hydrated = 0;
+    uint64_t doc_bytes_hydrated = 0;
+    uint64_t max_peak_scratch_bytes = 0;
+
+    void add(const request_cost_t& cost);
+
+    const nlohmann::json to_json() const;
+};
+
 // Hash function for rate_limit_entity_t
 namespace std {
     template <>
@@ -172,6 +217,14 @@ class RateLimitManager
         // Check if request is rate limited for given entities
         bool is_rate_limited(const rate_limit_entity_t& api_key_entity, const rate_limit_entity_t& ip_entity);
 
+        // Add the cost of a finished request to the usage of its API key and collection, and to the cost counted
+        // against the `max_cost` of the throttle rule of its entities, which limits the requests that follow
+        void add_request_cost(const rate_limit_entity_t& api_key_entity, const rate_limit_entity_t& ip_entity,
+                              const std::string& collection, const request_cost_t& cost);
+
+        // Get the usage of API keys per collection as JSON
+        const nlohmann::json get_usage_json();
+
         // Add rule by JSON
         Option<nlohmann::json> add_rule(const nlohmann::json &rule_json);
 
@@ -214,7 +267,9 @@ class RateLimitManager
     private:    
 
         RateLimitManager() {
-            rate_limit_request_counts.capacity(10000);
+            for(auto& shard: request_counter_shards) {
+                shard.counters.capacity(MAX_REQUEST_COUNTERS / NUM_REQUEST_COUNTER_SHARDS);
+            }
         }
 
         // Store for rate limit rules
@@ -245,8 +300,46 @@ class RateLimitManager
         // Store for rate_limit_rule_t
         std::unordered_map<uint64_t,rate_limit_rule_t> rule_store;
 
-        // LRU Cache to store rate limit and request counts for entities
-        LRU::Cache<std::string, request_counter_t> rate_limit_request_counts;
+        // LRU Caches to store request counts for entities, sharded on the counter key so that requests of different
+        // entities update their counters under different locks
+        struct request_counter_shard_t {
+            std::mutex mutex;
+            LRU::Cache<std::string, request_counter_t> counters;
+        };
+
+        static constexpr size_t MAX_REQUEST_COUNTERS = 10000;
+        static constexpr size_t NUM_REQUEST_COUNTER_SHARDS = 16;
+
+        std::array<request_counter_shard_t, NUM_REQUEST_COUNTER_SHARDS> request_counter_shards;
+
+        request_counter_shard_t& get_request_counter_shard(const std::string& key);
+
+        // Usage of API keys per collection, keyed on the API key and the collection
+        static constexpr size_t MAX_REQUEST_USAGES = 10000;
+
+        std::mutex request_usages_mutex;
+        LRU::Cache<std::string, request_usage_t> request_usages{MAX_REQUEST_USAGES};
+
+        // Moves the counts to the previous sampling period once the current one is over
+        void roll_over_request_counts(request_counter_t& request_counts);
+
+        // Get the rule of the highest priority for the given entities, nullptr if there is none
+        rate_limit_rule_t* get_top_rule(const rate_limit_entity_t& api_key_entity, const rate_limit_entity_t& ip_entity);
+
+        // Check if the cost of the requests counted for a rule is over its limits
+        bool is_cost_exceeded(const rate_limit_rule_t& rule, const request_counter_t& request_counts);
+
+        enum class rate_limit_check_t {
+            allowed,
+            limited,
+            // the check has to change the rules, throttles or exceeds, so must be made again under the exclusive lock
+            needs_exclusive_lock
+        };
+
+        // Checks a request against the rules: with `exclusive` false, only the request counters are changed, so that
+        // requests can be checked concurrently under the shared lock.
+        rate_limit_check_t check_rate_limit(const rate_limit_entity_t& api_key_entity,
+                                            const rate_limit_entity_t& ip_entity, const bool exclusive);
 
         // Unordered map to point rules from rule store for entities
         std::unordered_map<rate_limit_entity_t, std::vector<rate_limit_rule_t*>> rate_limit_entities;
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "json.hpp"
+#include "thread_local_vars.h"
+
+// Resources used by a search request, summed over the threads that work on it. Bytes scanned are those of the
+// posting list blocks decompressed and of the documents read from the store. The peak scratch memory is the largest
+// amount of memory that any one thread of the request allocated on top of what it held when it began its work.
+struct request_cost_t {
+    std::atomic<uint64_t> cpu_us = 0;
+    std::atomic<uint64_t> posting_bytes_scanned = 0;
+    std::atomic<uint64_t> num_docs_hydrated = 0;
+    std::atomic<uint64_t> doc_bytes_hydrated = 0;
+    std::atomic<uint64_t> peak_scratch_bytes = 0;
+
+    uint64_t bytes_scanned() const {
+        return posting_bytes_scanned.load(std::memory_order_relaxed) +
+               doc_bytes_hydrated.load(std::memory_order_relaxed);
+    }
+
+    void add_doc_hydrated(uint64_t num_bytes) {
+        num_docs_hydrated.fetch_add(1, std::memory_order_relaxed);
+        doc_bytes_hydrated.fetch_add(num_bytes, std::memory_order_relaxed);
+    }
+
+    void update_peak_scratch_bytes(uint64_t num_bytes);
+
+    nlohmann::json to_json() const;
+};
+
+// Makes `cost` the request cost of the current thread until the scope ends, and adds the CPU time and the peak memory
+// of the thread within the scope to it. A scope of the cost that is already being measured on the thread, as when a
+// forked task is run by the thread of the search itself, is not measured again. The peak memory of a scope that is
+// nested in one of another cost is folded into the peak of the outer scope when it ends.
+class request_cost_scope_t {
+private:
+    request_cost_t* prev_cost;
+    request_cost_t* measured_cost = nullptr;
+    uint64_t begin_cpu_us = 0;
+
+    // bytes allocated minus bytes freed by the thread when the scope began, and the most that they have been since
+    int64_t begin_net_bytes = 0;
+    int64_t peak_net_bytes = 0;
+    request_cost_scope_t* outer_scope = nullptr;
+
+    // the innermost scope that is measuring on the current thread
+    static thread_local request_cost_scope_t* measuring_scope;
+
+public:
+    explicit request_cost_scope_t(request_cost_t* cost);
+
+    ~request_cost_scope_t();
+
+    request_cost_scope_t(const request_cost_scope_t&) = delete;
+
+    request_cost_scope_t& operator=(const request_cost_scope_t&) = delete;
+
+    // CPU time used by the current thread so far
+    static uint64_t thread_cpu_us();
+};
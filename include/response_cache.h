@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "json.hpp"
+#include "http_data.h"
+
+// Search response cache that is split into independently locked LRU shards, selected by the request hash,
+// so that concurrent lookups of different requests do not contend on a single lock.
+//
+// Each shard is bounded by a number of entries and, optionally, by the memory held by its entries. Large
+// response bodies can be stored compressed.
+class response_cache_t {
+private:
+    struct shard_t {
+        std::mutex mutex;
+
+        // most recently used entry is at the front
+        std::list<std::pair<uint64_t, cached_res_t>> entries;
+        std::unordered_map<uint64_t, std::list<std::pair<uint64_t, cached_res_t>>::iterator> entry_index;
+
+        size_t max_entries = 128;
+        size_t max_bytes = 0;
+        size_t mem_bytes = 0;
+
+        std::atomic<uint64_t> hits = 0;
+        std::atomic<uint64_t> misses = 0;
+        std::atomic<uint64_t> evictions = 0;
+        std::atomic<uint64_t> invalidations = 0;
+
+        void erase(std::list<std::pair<uint64_t, cached_res_t>>::iterator it);
+
+        void evict();
+    };
+
+    std::vector<std::unique_ptr<shard_t>> shards;
+
+    std::atomic<size_t> compress_min_bytes = 0;
+
+    // window bits that make zlib read and write the gzip format
+    static constexpr int GZIP_WINDOW_BITS = 15 + 16;
+
+    shard_t& get_shard(uint64_t hash) const {
+        return *shards[hash % shards.size()];
+    }
+
+    static size_t entry_size(const cached_res_t& value);
+
+    static bool compress(cached_res_t& value);
+
+    static bool decompress(cached_res_t& value);
+
+public:
+    static constexpr size_t DEFAULT_NUM_SHARDS = 16;
+
+    explicit response_cache_t(size_t num_shards = DEFAULT_NUM_SHARDS);
+
+    // Limits are for the whole cache and are spread evenly across the shards. A `max_bytes` of 0 limits only
+    // the number of entries.
+    void capacity(size_t max_entries, size_t max_bytes = 0);
+
+    // Bodies of at least this size are gzip compressed before being cached. A value of 0 disables compression.
+    void set_compress_min_bytes(size_t min_bytes);
+
+    // Copies a cached response into `value`. The `is_fresh` check is run outside of the shard lock, and a
+    // response that fails it is evicted and counted as a miss. With `keep_compressed`, a compressed body is
+    // returned as it is, to be sent with the gzip encoding.
+    bool get(uint64_t hash, cached_res_t& value, const std::function<bool(const cached_res_t&)>& is_fresh,
+             bool keep_compressed = false);
+
+    void insert(uint64_t hash, cached_res_t value);
+
+    void clear();
+
+    size_t size() const;
+
+    size_t mem_bytes() const;
+
+    size_t num_shards() const {
+        return shards.size();
+    }
+
+    void get_metrics(nlohmann::json& result) const;
+};
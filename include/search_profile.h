@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "thread_local_vars.h"
+
+// Breakdown of where a search request spent its time and of the choices made while processing it. Collected only
+// when the `profile` search parameter is set and returned as the `profile` key of the response.
+struct search_profile_t {
+private:
+    mutable std::mutex mutex;
+
+    // phases are reported in the order they were first seen
+    std::vector<std::pair<std::string, uint64_t>> phase_durations_us;
+
+    // typo cost => number of candidate tokens found with that cost
+    std::map<uint32_t, size_t> typo_candidates;
+
+    nlohmann::json filter_plan;
+    nlohmann::json facet_strategies = nlohmann::json::object();
+    // field => whether its strategy was picked by the heuristic or on measured costs
+    nlohmann::json facet_strategy_bases = nlohmann::json::object();
+
+    // parallel intersections of id lists
+    size_t num_intersection_splits = 0;
+    size_t num_intersection_partitions = 0;
+    size_t max_intersection_workers = 0;
+    double max_intersection_imbalance = 0;
+
+public:
+    std::atomic<uint64_t> num_blocks_decompressed = 0;
+
+    void add_phase_duration(const std::string& phase, uint64_t duration_us);
+
+    void add_typo_candidates(uint32_t cost, size_t num_candidates);
+
+    void set_filter_plan(nlohmann::json plan);
+
+    void set_facet_strategy(const std::string& field_name, const std::string& strategy,
+                            const std::string& basis = "");
+
+    // `imbalance` is the time of the busiest worker over the mean time of the workers
+    void add_intersection_split(size_t num_partitions, size_t num_workers, double imbalance);
+
+    nlohmann::json to_json() const;
+};
+
+// Makes `profile` the search profile of the current thread until the scope ends.
+class search_profile_scope_t {
+private:
+    search_profile_t* prev_profile;
+
+public:
+    explicit search_profile_scope_t(search_profile_t* profile): prev_profile(search_profile) {
+        search_profile = profile;
+    }
+
+    ~search_profile_scope_t() {
+        search_profile = prev_profile;
+    }
+};
+
+// Adds the time elapsed between its construction and `stop()` (or its destruction) to a phase of the search profile of
+// the current thread. Does nothing when the search is not being profiled.
+class search_profile_timer_t {
+private:
+    search_profile_t* profile;
+    const char* phase;
+    std::chrono::steady_clock::time_point begin;
+
+public:
+    explicit search_profile_timer_t(const char* phase): profile(search_profile), phase(phase) {
+        if(profile != nullptr) {
+            begin = std::chrono::steady_clock::now();
+        }
+    }
+
+    void stop() {
+        if(profile == nullptr) {
+            return ;
+        }
+
+        auto duration_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - begin).count();
+        profile->add_phase_duration(phase, duration_us);
+        profile = nullptr;
+    }
+
+    ~search_profile_timer_t() {
+        stop();
+    }
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include "store.h"
+
+// Keeps a sample of each of the most frequent searches and replays them after a start, before the node reports
+// healthy, so that the first searches that it serves do not pay for cold caches, e.g. the block cache of the store
+// and the ranked hits of the collections.
+class SearchWarmup {
+public:
+    // at most this many searches are saved and replayed
+    static constexpr size_t MAX_SEARCHES = 100;
+
+    static constexpr const char* SEARCHES_KEY = "$WS";
+
+private:
+    Store* meta_store = nullptr;
+    size_t time_budget_ms = 0;
+
+    std::atomic<bool> started = false;
+    std::atomic<bool> done = true;
+    std::atomic<bool> quit = false;
+    std::thread warmup_thread;
+
+    SearchWarmup() = default;
+
+    ~SearchWarmup() = default;
+
+    void replay_searches();
+
+public:
+
+    static SearchWarmup& get_instance() {
+        static SearchWarmup instance;
+        return instance;
+    }
+
+    SearchWarmup(SearchWarmup const&) = delete;
+
+    void operator=(SearchWarmup const&) = delete;
+
+    // The node is not healthy from here on until the warm-up is over, when `time_budget_ms` is not 0.
+    void init(Store* meta_store, size_t time_budget_ms);
+
+    // Replays the saved searches on a thread of its own, only on the first call.
+    void start();
+
+    // Saves the frequent searches of the search log, once the warm-up is over and the log is not empty.
+    void persist_searches();
+
+    bool is_done() const {
+        return done;
+    }
+
+    void stop();
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <json.hpp>
+#include "field.h"
+
+// Merges the results of a search that was run on each of the collections of a sharded alias into the results of
+// the search on all of them, as if their documents were in one collection.
+//
+// Each shard must be searched for the first `offset + limit` hits (or groups) of the request. Hits are merged on
+// the values they were sorted on, as they appear in the hits: their text match (or rank fusion) score, vector and
+// geo distances, and the sorted fields of their documents. Sort expressions that leave no trace in the hits, like
+// `_eval()` or `_seq_id`, are ties that keep the hits in the order of the shards. Facet counts of the same value
+// are summed up and ordered on their counts, so a value that is outside of the top values of a shard is
+// undercounted: shards should be asked for more facet values than are returned.
+class shard_merger_t {
+public:
+    enum sort_key_kind_t {
+        TEXT_MATCH,
+        VECTOR_DISTANCE,
+        // geo distance of the field when the hit has one, otherwise the value of the field in the document
+        FIELD_VALUE,
+        UNSORTED
+    };
+
+    struct sort_key_t {
+        sort_key_kind_t kind;
+        std::string field_name;
+        bool desc;
+    };
+
+    // Keys of the sort the shards apply for `sort_fields`, which are completed with the defaults of a search.
+    static std::vector<sort_key_t> get_sort_keys(const std::vector<sort_by>& sort_fields, bool is_wildcard_query,
+                                                 bool is_vector_query, const std::string& default_sorting_field);
+
+    // Negative when `a` is ranked before `b`, positive when after and 0 on a tie.
+    static int compare_hits(const nlohmann::json& a, const nlohmann::json& b, const std::vector<sort_key_t>& keys);
+
+    static nlohmann::json merge(const std::vector<nlohmann::json>& shard_results,
+                                const std::vector<sort_key_t>& sort_keys,
+                                size_t offset, size_t limit, size_t max_facet_values, size_t group_limit);
+
+private:
+    static const nlohmann::json* get_sort_value(const nlohmann::json& hit, const sort_key_t& key);
+
+    static void merge_facet_counts(const std::vector<nlohmann::json>& shard_results, size_t max_facet_values,
+                                   nlohmann::json& facet_counts);
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include "json.hpp"
+#include "latency_histogram.h"
+
+// Groups searches by their fingerprint, i.e. their parameters with the literals stripped, to find the shapes of queries
+// that are worth optimizing, and logs a structured record of the searches that are slower than
+// `log-slow-searches-time-ms`.
+class SlowSearchLog {
+public:
+    // the fingerprints beyond this many are counted, but not tracked
+    static constexpr size_t MAX_FINGERPRINTS = 500;
+
+private:
+    struct fingerprint_stats_t {
+        std::string collection;
+        std::string fingerprint;
+        latency_histogram_t latencies_us;
+        std::atomic<uint64_t> num_slow = 0;
+        // parameters of the first search with the fingerprint, which is replayed to warm up a restarted node
+        std::map<std::string, std::string> sample_params;
+    };
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<uint64_t, std::unique_ptr<fingerprint_stats_t>> fingerprint_stats;
+    std::atomic<uint64_t> num_untracked = 0;
+
+    SlowSearchLog() = default;
+
+    ~SlowSearchLog() = default;
+
+public:
+
+    static SlowSearchLog& get_instance() {
+        static SlowSearchLog instance;
+        return instance;
+    }
+
+    SlowSearchLog(SlowSearchLog const&) = delete;
+
+    void operator=(SlowSearchLog const&) = delete;
+
+    // Replaces the literals of a filter expression with `?`, keeping its fields, operators and structure, e.g.
+    // `(price:>100 && tags:[a,b]) || title:=`foo`` => `(price:>? && tags:[?]) || title:=?`.
+    static std::string normalize_filter(const std::string& filter_query);
+
+    // Parameters that shape a search are kept, `filter_by` is normalized, and the values of all other parameters are
+    // replaced with `?`, except that a wildcard `q` is kept apart from a text query.
+    static std::string fingerprint(const std::map<std::string, std::string>& req_params);
+
+    static uint64_t fingerprint_id(const std::string& collection, const std::string& fingerprint);
+
+    void record(const std::string& collection, const std::string& fingerprint, uint64_t latency_us, bool slow,
+                const std::map<std::string, std::string>& req_params = {});
+
+    // Builds the record logged for a slow search from the profile of the search and its results.
+    static nlohmann::json slow_search_record(const std::string& collection, const std::string& fingerprint,
+                                             uint64_t time_ms, const nlohmann::json& result,
+                                             const nlohmann::json& profile);
+
+    // stats of the fingerprints, ordered by the total time spent on their searches
+    nlohmann::json get_stats(size_t limit) const;
+
+    // a sample search, as `{"collection": ..., "params": {...}}`, of each of the most frequent fingerprints
+    nlohmann::json get_frequent_searches(size_t limit) const;
+
+    void clear();
+};
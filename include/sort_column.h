@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <sparsepp.h>
+
+// Values of a numeric sort field, keyed on the seq_id of the document.
+//
+// Sorting looks up the value of every candidate, so once most documents have a value, the values are kept in an
+// array indexed on seq_id (with a bitmap of the seq_ids that have one), which is both smaller than the hash map and
+// a single, cache friendly load per lookup. A field that only few documents have stays in a hash map.
+//
+// The array packs the values in the narrowest of 1, 2, 4 or 8 bytes that fits all of them, so that bool, int32 and
+// float fields (whose values are all within 32 bits) take a half or less of the space of int64 values. The array is
+// widened when a value that does not fit comes in.
+//
+// The interface is the subset of the hash map interface that the index uses.
+class sort_column_t {
+public:
+    struct entry_t {
+        uint32_t first;
+        int64_t second;
+    };
+
+    class const_iterator {
+    private:
+        entry_t entry{};
+        bool is_end = true;
+
+    public:
+        const_iterator() = default;
+
+        const_iterator(uint32_t seq_id, int64_t value): entry{seq_id, value}, is_end(false) {
+
+        }
+
+        const entry_t& operator*() const {
+            return entry;
+        }
+
+        const entry_t* operator->() const {
+            return &entry;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return is_end == other.is_end && (is_end || entry.first == other.entry.first);
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+private:
+    struct hasher_t {
+        // same spreading of the key as the hasher that the sort index used to be keyed with
+        size_t operator()(uint32_t k) const { return (k ^ 2166136261U)  * 16777619UL; }
+    };
+
+    spp::sparse_hash_map<uint32_t, int64_t, hasher_t> sparse_values;
+
+    // `dense_size` values of `dense_width` bytes each
+    std::vector<uint8_t> dense_values;
+    std::vector<uint64_t> dense_present;
+    size_t dense_size = 0;
+    size_t dense_width = 1;
+
+    size_t num_values = 0;
+    bool is_dense = false;
+
+    // A dense value takes its width and 1 bit per seq_id up to the largest one, while a hash map entry takes roughly
+    // 20 bytes, so for int64 values the switch happens once about 40% of the seq_ids in range have a value.
+    static constexpr size_t SPARSE_ENTRY_BYTES = 20;
+
+    // columns smaller than this are never made dense
+    static constexpr size_t MIN_DENSE_VALUES = 1024;
+
+    static size_t value_width(int64_t value) {
+        if(value >= INT8_MIN && value <= INT8_MAX) {
+            return 1;
+        } else if(value >= INT16_MIN && value <= INT16_MAX) {
+            return 2;
+        } else if(value >= INT32_MIN && value <= INT32_MAX) {
+            return 4;
+        }
+
+        return 8;
+    }
+
+    bool has_dense_value(uint32_t seq_id) const {
+        return seq_id < dense_size && ((dense_present[seq_id / 64] >> (seq_id % 64)) & 1);
+    }
+
+    int64_t get_dense_value(uint32_t seq_id) const {
+        const uint8_t* value = dense_values.data() + size_t(seq_id) * dense_width;
+
+        switch(dense_width) {
+            case 1: {
+                return int8_t(*value);
+            }
+            case 2: {
+                int16_t v;
+                std::memcpy(&v, value, sizeof(v));
+                return v;
+            }
+            case 4: {
+                int32_t v;
+                std::memcpy(&v, value, sizeof(v));
+                return v;
+            }
+            default: {
+                int64_t v;
+                std::memcpy(&v, value, sizeof(v));
+                return v;
+            }
+        }
+    }
+
+    void store_dense_value(uint32_t seq_id, int64_t value);
+
+    void set_dense_value(uint32_t seq_id, int64_t value);
+
+    void widen(size_t width);
+
+    void make_dense(uint32_t max_seq_id, size_t width);
+
+public:
+    sort_column_t() = default;
+
+    const_iterator find(uint32_t seq_id) const {
+        if(is_dense) {
+            return has_dense_value(seq_id) ? const_iterator(seq_id, get_dense_value(seq_id)) : const_iterator();
+        }
+
+        auto it = sparse_values.find(seq_id);
+        return (it == sparse_values.end()) ? const_iterator() : const_iterator(seq_id, it->second);
+    }
+
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    size_t count(uint32_t seq_id) const {
+        return is_dense ? size_t(has_dense_value(seq_id)) : sparse_values.count(seq_id);
+    }
+
+    int64_t at(uint32_t seq_id) const {
+        if(is_dense) {
+            if(!has_dense_value(seq_id)) {
+                throw std::out_of_range("sort_column_t::at");
+            }
+
+            return get_dense_value(seq_id);
+        }
+
+        return sparse_values.at(seq_id);
+    }
+
+    // like the hash map, an existing value is not overwritten: returns false in that case
+    bool emplace(uint32_t seq_id, int64_t value);
+
+    size_t erase(uint32_t seq_id);
+
+    size_t size() const {
+        return num_values;
+    }
+
+    bool dense() const {
+        return is_dense;
+    }
+
+    // bytes per value of a dense column
+    size_t width() const {
+        return dense_width;
+    }
+};
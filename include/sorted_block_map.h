@@ -0,0 +1,315 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Ordered map of `K -> V` kept as a list of sorted blocks of up to `BLOCK_SIZE` entries, with the last key of
+// every block held in a separate array that is binary searched to find the block of a key.
+//
+// Compared to a red-black tree, entries sit next to each other in memory (a range scan is a linear walk) and there
+// are no per entry node pointers: an entry takes sizeof(std::pair<K, V>) plus the slack of its block.
+//
+// The interface is the subset of the std::map interface that the numerical index uses. Iterators are invalidated
+// by any insert or erase.
+template<class K, class V, size_t BLOCK_SIZE = 128>
+class sorted_block_map_t {
+public:
+    typedef std::pair<K, V> value_type;
+
+private:
+    typedef std::vector<value_type> block_t;
+
+    static_assert(BLOCK_SIZE >= 4, "Block must hold at least 4 entries.");
+
+    std::vector<block_t> blocks;
+    std::vector<K> block_last_keys;
+    size_t num_entries = 0;
+
+    // a bulk load leaves room in every block, so that the inserts that follow don't split the blocks right away
+    static constexpr size_t BULK_LOAD_BLOCK_SIZE = BLOCK_SIZE * 3 / 4;
+
+    template<bool IS_CONST>
+    class iterator_base_t {
+    private:
+        typedef std::conditional_t<IS_CONST, const sorted_block_map_t, sorted_block_map_t> map_t;
+
+        map_t* map = nullptr;
+        size_t block = 0;
+        size_t pos = 0;
+
+        friend class sorted_block_map_t;
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef sorted_block_map_t::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef std::conditional_t<IS_CONST, const value_type*, value_type*> pointer;
+        typedef std::conditional_t<IS_CONST, const value_type&, value_type&> reference;
+
+        iterator_base_t() = default;
+
+        iterator_base_t(map_t* map, size_t block, size_t pos): map(map), block(block), pos(pos) {
+
+        }
+
+        // a mutable iterator converts to a const one
+        template<bool OTHER_IS_CONST, class = std::enable_if_t<IS_CONST && !OTHER_IS_CONST>>
+        iterator_base_t(const iterator_base_t<OTHER_IS_CONST>& other):
+                map(other.map), block(other.block), pos(other.pos) {
+
+        }
+
+        reference operator*() const {
+            return map->blocks[block][pos];
+        }
+
+        pointer operator->() const {
+            return &map->blocks[block][pos];
+        }
+
+        iterator_base_t& operator++() {
+            if(++pos == map->blocks[block].size()) {
+                block++;
+                pos = 0;
+            }
+
+            return *this;
+        }
+
+        iterator_base_t operator++(int) {
+            auto prev = *this;
+            ++(*this);
+            return prev;
+        }
+
+        iterator_base_t& operator--() {
+            if(pos == 0) {
+                block--;
+                pos = map->blocks[block].size() - 1;
+            } else {
+                pos--;
+            }
+
+            return *this;
+        }
+
+        iterator_base_t operator--(int) {
+            auto prev = *this;
+            --(*this);
+            return prev;
+        }
+
+        bool operator==(const iterator_base_t& other) const {
+            return block == other.block && pos == other.pos;
+        }
+
+        bool operator!=(const iterator_base_t& other) const {
+            return !(*this == other);
+        }
+
+        template<bool B> friend class iterator_base_t;
+    };
+
+public:
+    typedef iterator_base_t<false> iterator;
+    typedef iterator_base_t<true> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+private:
+    // index of the first block whose last key is >= key, or the number of blocks when there is none
+    size_t find_block(const K& key) const {
+        return std::lower_bound(block_last_keys.begin(), block_last_keys.end(), key) - block_last_keys.begin();
+    }
+
+    size_t find_pos(size_t block, const K& key) const {
+        const auto& entries = blocks[block];
+        return std::lower_bound(entries.begin(), entries.end(), key,
+                                [](const value_type& entry, const K& k) { return entry.first < k; }) - entries.begin();
+    }
+
+    void split_block(size_t block) {
+        block_t& entries = blocks[block];
+        const size_t mid = entries.size() / 2;
+
+        block_t upper_half(std::make_move_iterator(entries.begin() + mid), std::make_move_iterator(entries.end()));
+        entries.erase(entries.begin() + mid, entries.end());
+
+        block_last_keys[block] = entries.back().first;
+        block_last_keys.insert(block_last_keys.begin() + block + 1, upper_half.back().first);
+        blocks.insert(blocks.begin() + block + 1, std::move(upper_half));
+    }
+
+    // merges the block into a neighbour when both fit into one block
+    void merge_block(size_t block) {
+        if(block + 1 < blocks.size() && blocks[block].size() + blocks[block + 1].size() <= BLOCK_SIZE) {
+            auto& next = blocks[block + 1];
+            blocks[block].insert(blocks[block].end(), next.begin(), next.end());
+            block_last_keys[block] = block_last_keys[block + 1];
+            blocks.erase(blocks.begin() + block + 1);
+            block_last_keys.erase(block_last_keys.begin() + block + 1);
+        } else if(block > 0 && blocks[block - 1].size() + blocks[block].size() <= BLOCK_SIZE) {
+            auto& prev = blocks[block - 1];
+            prev.insert(prev.end(), blocks[block].begin(), blocks[block].end());
+            block_last_keys[block - 1] = block_last_keys[block];
+            blocks.erase(blocks.begin() + block);
+            block_last_keys.erase(block_last_keys.begin() + block);
+        }
+    }
+
+public:
+    sorted_block_map_t() = default;
+
+    bool empty() const {
+        return num_entries == 0;
+    }
+
+    size_t size() const {
+        return num_entries;
+    }
+
+    iterator begin() {
+        return iterator(this, 0, 0);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0, 0);
+    }
+
+    iterator end() {
+        return iterator(this, blocks.size(), 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, blocks.size(), 0);
+    }
+
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+
+    iterator lower_bound(const K& key) {
+        const size_t block = find_block(key);
+        return (block == blocks.size()) ? end() : iterator(this, block, find_pos(block, key));
+    }
+
+    const_iterator lower_bound(const K& key) const {
+        const size_t block = find_block(key);
+        return (block == blocks.size()) ? end() : const_iterator(this, block, find_pos(block, key));
+    }
+
+    iterator find(const K& key) {
+        auto it = lower_bound(key);
+        return (it == end() || key < it->first) ? end() : it;
+    }
+
+    const_iterator find(const K& key) const {
+        auto it = lower_bound(key);
+        return (it == end() || key < it->first) ? end() : it;
+    }
+
+    size_t count(const K& key) const {
+        return find(key) != end();
+    }
+
+    // like std::map, an existing value is not overwritten: the returned flag is false in that case
+    std::pair<iterator, bool> emplace(const K& key, V value) {
+        if(blocks.empty()) {
+            blocks.emplace_back();
+            blocks.back().emplace_back(key, std::move(value));
+            block_last_keys.push_back(key);
+            num_entries++;
+            return {begin(), true};
+        }
+
+        size_t block = find_block(key);
+        if(block == blocks.size()) {
+            // larger than every key: goes at the end of the last block
+            block--;
+        }
+
+        block_t& entries = blocks[block];
+        size_t pos = find_pos(block, key);
+
+        if(pos < entries.size() && !(key < entries[pos].first)) {
+            return {iterator(this, block, pos), false};
+        }
+
+        entries.emplace(entries.begin() + pos, key, std::move(value));
+        block_last_keys[block] = entries.back().first;
+        num_entries++;
+
+        if(entries.size() > BLOCK_SIZE) {
+            split_block(block);
+            if(pos >= blocks[block].size()) {
+                pos -= blocks[block].size();
+                block++;
+            }
+        }
+
+        return {iterator(this, block, pos), true};
+    }
+
+    size_t erase(const K& key) {
+        auto it = find(key);
+        if(it == end()) {
+            return 0;
+        }
+
+        const size_t block = it.block;
+        block_t& entries = blocks[block];
+        entries.erase(entries.begin() + it.pos);
+        num_entries--;
+
+        if(entries.empty()) {
+            blocks.erase(blocks.begin() + block);
+            block_last_keys.erase(block_last_keys.begin() + block);
+            return 1;
+        }
+
+        block_last_keys[block] = entries.back().first;
+
+        if(entries.size() < BLOCK_SIZE / 4) {
+            merge_block(block);
+        }
+
+        return 1;
+    }
+
+    void clear() {
+        blocks.clear();
+        block_last_keys.clear();
+        num_entries = 0;
+    }
+
+    // Replaces the contents with `entries`, which must be sorted on key with no duplicate keys.
+    void bulk_load(std::vector<value_type>&& entries) {
+        clear();
+
+        for(size_t i = 0; i < entries.size(); i += BULK_LOAD_BLOCK_SIZE) {
+            const size_t block_end = std::min(i + BULK_LOAD_BLOCK_SIZE, entries.size());
+            blocks.emplace_back(std::make_move_iterator(entries.begin() + i),
+                                std::make_move_iterator(entries.begin() + block_end));
+            block_last_keys.push_back(blocks.back().back().first);
+        }
+
+        num_entries = entries.size();
+        std::vector<value_type>().swap(entries);
+    }
+};
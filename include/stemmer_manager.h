@@ -5,19 +5,53 @@
 #include <vector>
 #include <memory>
 #include <mutex>
+#include <atomic>
 #include <libstemmer.h>
 #include "lru/lru.hpp"
+#include "json.hpp"
 
 
+// Stems the words of a language. Stems are cached in shards that each have their own lock, so that concurrent
+// indexing threads rarely wait on each other. Snowball stemmers are not thread safe, so a word that is not cached
+// is stemmed by one of a pool of stemmers, which grows to the number of threads stemming at the same time.
+//
+// Bounded by a number of entries per language, set for all languages with `set_max_entries()`. Counters are for all
+// languages too.
 class Stemmer {
     private:
-        sb_stemmer * stemmer = nullptr;
-        LRU::Cache<std::string, std::string> cache;
-        std::mutex mutex;
+        struct shard_t {
+            std::mutex mutex;
+            LRU::Cache<std::string, std::string> cache;
+        };
+
+        static constexpr size_t NUM_SHARDS = 16;
+
+        std::string language;
+        shard_t shards[NUM_SHARDS];
+        bool cache_enabled = false;
+
+        std::mutex stemmers_mutex;
+        std::vector<sb_stemmer*> free_stemmers;
+
+        static std::atomic<size_t> max_entries;
+
+        static std::atomic<uint64_t> hits;
+        static std::atomic<uint64_t> misses;
+
+        sb_stemmer* acquire_stemmer();
+        void release_stemmer(sb_stemmer* stemmer);
+
     public:
+        static constexpr size_t DEFAULT_MAX_ENTRIES = 64 * 1024;
+
         Stemmer(const char * language);
         ~Stemmer();
         std::string stem(const std::string & word);
+
+        // Applies to the stemmers created afterwards. A `max_entries` of 0 disables the cache.
+        static void set_max_entries(size_t max_entries);
+
+        static void get_metrics(nlohmann::json& result);
 };
 
 
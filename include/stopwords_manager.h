@@ -6,11 +6,49 @@
 #include "shared_mutex"
 #include "mutex"
 #include "store.h"
+#include "string_utils.h"
+#include <memory>
+#include <string_view>
+
+// Immutable set of the stopwords of a config, built once on upsert and shared by the searches that use it. The words
+// sit in a single buffer, and an open addressed table of at most half full slots holds their indices along with
+// their hashes, so that a token is looked up without allocating and mostly with a single comparison.
+class compiled_stopwords_t {
+private:
+    std::string words;
+    // `words` of index i span [offsets[i], offsets[i+1])
+    std::vector<uint32_t> offsets;
+    // index + 1 of the word in each slot, 0 when empty
+    std::vector<uint32_t> slots;
+    std::vector<uint32_t> slot_hashes;
+    size_t slot_mask = 0;
+
+public:
+    explicit compiled_stopwords_t(const spp::sparse_hash_set<std::string>& stopwords);
+
+    size_t size() const {
+        return offsets.size() - 1;
+    }
+
+    bool contains(std::string_view token) const {
+        const uint64_t hash = StringUtils::hash_wy(token.data(), token.size());
+        for(size_t slot = hash & slot_mask; slots[slot] != 0; slot = (slot + 1) & slot_mask) {
+            const uint32_t index = slots[slot] - 1;
+            if(slot_hashes[slot] == uint32_t(hash) &&
+               std::string_view(words.data() + offsets[index], offsets[index + 1] - offsets[index]) == token) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
 
 struct stopword_struct_t {
     std::string id;
     spp::sparse_hash_set<std::string> stopwords;
     std::string locale;
+    std::shared_ptr<const compiled_stopwords_t> compiled_stopwords;
 
     nlohmann::json to_json() const {
         nlohmann::json doc;
@@ -57,6 +95,9 @@ public:
 
     Option<bool> get_stopword(const std::string&, stopword_struct_t&) const;
 
+    // the compiled set of the stopwords of a config, without copying them, or nullptr when there is no such config
+    std::shared_ptr<const compiled_stopwords_t> get_compiled_stopwords(const std::string& stopword_name) const;
+
     Option<bool> upsert_stopword(const std::string&, const nlohmann::json&, bool write_to_store=false);
 
     Option<bool> delete_stopword(const std::string&);
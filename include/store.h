@@ -2,8 +2,12 @@
 
 #include <stdint.h>
 #include <cstdlib>
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <vector>
 #include <sstream>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -12,6 +16,10 @@
 #include <rocksdb/db.h>
 #include <rocksdb/write_batch.h>
 #include <rocksdb/options.h>
+#include <rocksdb/cache.h>
+#include <rocksdb/filter_policy.h>
+#include <rocksdb/table.h>
+#include <rocksdb/rate_limiter.h>
 #include <rocksdb/merge_operator.h>
 #include <rocksdb/transaction_log.h>
 #include <butil/file_util.h>
@@ -22,20 +30,29 @@
 #include "logger.h"
 #include "file_utils.h"
 
-class UInt64AddOperator : public rocksdb::AssociativeMergeOperator {
+// Merges the operands written with `Store::increment()`, which add to a 4 byte counter, and the merge patches
+// (RFC 7386) written for partial updates of documents, which are applied in order to the stored document.
+// Merge patches are not associative, so operands are only ever merged onto the full value.
+class StoreMergeOperator : public rocksdb::MergeOperator {
 public:
-    virtual bool Merge(const rocksdb::Slice& key, const rocksdb::Slice* existing_value, const rocksdb::Slice& value,
-                       std::string* new_value, rocksdb::Logger* logger) const override {
-        uint64_t existing = 0;
-        if (existing_value) {
-            existing = StringUtils::deserialize_uint32_t(existing_value->ToString());
-        }
-        *new_value = StringUtils::serialize_uint32_t(existing + StringUtils::deserialize_uint32_t(value.ToString()));
-        return true;
+    static constexpr char DOC_PATCH_MARKER = '\x1e';
+
+    static bool is_doc_patch(const rocksdb::Slice& operand) {
+        return operand.size() != sizeof(uint32_t) && operand.size() > 1 && operand[0] == DOC_PATCH_MARKER;
     }
 
-    virtual const char* Name() const override {
-        return "UInt64AddOperator";
+    static std::string doc_patch_operand(const std::string& patch_json) {
+        return DOC_PATCH_MARKER + patch_json;
+    }
+
+    // Applies merge patches to a stored document, keeping the format (JSON or MessagePack) it was stored in.
+    static bool merge_doc_patches(const rocksdb::Slice* existing_value, const std::vector<rocksdb::Slice>& patches,
+                                  std::string& new_value);
+
+    bool FullMergeV2(const MergeOperationInput& merge_in, MergeOperationOutput* merge_out) const override;
+
+    const char* Name() const override {
+        return "StoreMergeOperator";
     }
 };
 
@@ -45,6 +62,25 @@ enum StoreStatus {
     ERROR
 };
 
+// Tuning of the table format and the caches of a store, RocksDB's defaults when left unset
+struct store_tuning_t {
+    // stores that are given the same block cache share it
+    std::shared_ptr<rocksdb::Cache> block_cache;
+    size_t bloom_bits_per_key = 0;
+    size_t row_cache_mb = 0;
+    bool direct_io_for_compaction = false;
+
+    // I/O budget of flushes and compactions, shared by the stores that are given the same limiter
+    std::shared_ptr<rocksdb::RateLimiter> rate_limiter;
+};
+
+struct compaction_progress_t {
+    bool running = false;
+    size_t ranges_compacted = 0;
+    size_t ranges_total = 0;
+    uint64_t started_at_s = 0;
+};
+
 /*
  *  Abstraction for underlying KV store (RocksDB)
  */
@@ -60,6 +96,65 @@ private:
     // So we use unique lock only for assignment, but shared locks for all other operations on DB
     mutable std::shared_mutex mutex;
 
+    // progress of the manual compaction that is running, or of the last one
+    std::atomic<bool> compaction_running = false;
+    std::atomic<size_t> compaction_ranges_compacted = 0;
+    std::atomic<size_t> compaction_ranges_total = 0;
+    std::atomic<uint64_t> compaction_started_at_s = 0;
+    std::thread compaction_thread;
+
+    // Compacts the [begin, end) key ranges one after the other, or the whole store when there are none. The caller
+    // must have set `compaction_running`.
+    rocksdb::Status run_compaction(const std::vector<std::pair<std::string, std::string>>& ranges) {
+        compaction_started_at_s = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        compaction_ranges_compacted = 0;
+        compaction_ranges_total = std::max<size_t>(1, ranges.size());
+
+        // automatic compactions keep running alongside
+        rocksdb::CompactRangeOptions compact_options;
+        compact_options.exclusive_manual_compaction = false;
+
+        rocksdb::Status status;
+
+        if(ranges.empty()) {
+            std::shared_lock lock(mutex);
+            status = db->CompactRange(compact_options, nullptr, nullptr);
+            compaction_ranges_compacted = status.ok() ? 1 : 0;
+        }
+
+        for(const auto& range: ranges) {
+            std::shared_lock lock(mutex);
+            rocksdb::Slice begin_key(range.first);
+            rocksdb::Slice end_key(range.second);
+            status = db->CompactRange(compact_options, &begin_key, &end_key);
+            if(!status.ok()) {
+                break;
+            }
+
+            compaction_ranges_compacted++;
+        }
+
+        compaction_running = false;
+        return status;
+    }
+
+    // aborts a compaction running in the background, before the DB handle is released
+    void stop_compaction() {
+        if(!compaction_thread.joinable()) {
+            return ;
+        }
+
+        {
+            std::shared_lock lock(mutex);
+            if(db != nullptr) {
+                db->DisableManualCompaction();
+            }
+        }
+
+        compaction_thread.join();
+    }
+
     rocksdb::Status init_db() {
         LOG(INFO) << "Initializing DB by opening state dir: " << state_dir_path;
 
@@ -84,7 +179,8 @@ public:
 
     Store(const std::string & state_dir_path,
           const size_t wal_ttl_secs = 24*60*60,
-          const size_t wal_size_mb = 1024, bool disable_wal = true): state_dir_path(state_dir_path) {
+          const size_t wal_size_mb = 1024, bool disable_wal = true,
+          const store_tuning_t& tuning = store_tuning_t()): state_dir_path(state_dir_path) {
         // Optimize RocksDB
         options.IncreaseParallelism();
         options.OptimizeLevelStyleCompaction();
@@ -92,9 +188,33 @@ public:
         options.create_if_missing = true;
         options.write_buffer_size = 4*1048576;
         options.max_write_buffer_number = 2;
-        options.merge_operator.reset(new UInt64AddOperator);
+        options.merge_operator.reset(new StoreMergeOperator);
         options.compression = rocksdb::CompressionType::kSnappyCompression;
 
+        rocksdb::BlockBasedTableOptions table_options;
+        if(tuning.block_cache) {
+            table_options.block_cache = tuning.block_cache;
+
+            // index and filter blocks are accounted in the shared cache, but are kept ahead of the data blocks
+            table_options.cache_index_and_filter_blocks = true;
+            table_options.cache_index_and_filter_blocks_with_high_priority = true;
+            table_options.pin_l0_filter_and_index_blocks_in_cache = true;
+        }
+
+        // full key filters let point lookups skip the files that do not have the key
+        if(tuning.bloom_bits_per_key != 0) {
+            table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(tuning.bloom_bits_per_key, false));
+        }
+
+        options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+
+        if(tuning.row_cache_mb != 0) {
+            options.row_cache = rocksdb::NewLRUCache(tuning.row_cache_mb * 1024 * 1024);
+        }
+
+        options.use_direct_io_for_flush_and_compaction = tuning.direct_io_for_compaction;
+        options.rate_limiter = tuning.rate_limiter;
+
         options.max_log_file_size = 4*1048576;
         options.keep_log_file_num = 5;
 
@@ -166,15 +286,40 @@ public:
         return StoreStatus::ERROR;
     }
 
+    // Fetches the values of many keys with a single batched lookup.
+    void multi_get(const std::vector<std::string>& keys, std::vector<std::string>& values,
+                   std::vector<StoreStatus>& statuses) const {
+        std::shared_lock lock(mutex);
+        std::vector<rocksdb::Slice> key_slices(keys.begin(), keys.end());
+        std::vector<rocksdb::Status> key_statuses = db->MultiGet(rocksdb::ReadOptions(), key_slices, &values);
+
+        statuses.clear();
+        for(size_t i = 0; i < key_statuses.size(); i++) {
+            if(key_statuses[i].ok()) {
+                statuses.push_back(StoreStatus::FOUND);
+            } else if(key_statuses[i].IsNotFound()) {
+                statuses.push_back(StoreStatus::NOT_FOUND);
+            } else {
+                LOG(ERROR) << "Error while fetching the key: " << keys[i] << " - status is: "
+                           << key_statuses[i].ToString();
+                statuses.push_back(StoreStatus::ERROR);
+            }
+        }
+    }
+
     bool remove(const std::string& key) {
         std::shared_lock lock(mutex);
         rocksdb::Status status = db->Delete(write_options, key);
         return status.ok();
     }
 
-    rocksdb::Iterator* scan(const std::string & prefix, const rocksdb::Slice* iterate_upper_bound) {
+    // Full scans over documents should not fill the block cache: they would evict the blocks of the small, frequently
+    // looked up keys (such as the doc id to seq id mappings) that share the keyspace with the documents.
+    rocksdb::Iterator* scan(const std::string & prefix, const rocksdb::Slice* iterate_upper_bound,
+                            bool fill_cache = true) {
         std::shared_lock lock(mutex);
         rocksdb::ReadOptions read_opts;
+        read_opts.fill_cache = fill_cache;
         if(iterate_upper_bound) {
             read_opts.iterate_upper_bound = iterate_upper_bound;
         }
@@ -278,12 +423,14 @@ public:
     }
 
     void close() {
+        stop_compaction();
         std::unique_lock lock(mutex);
         delete db;
         db = nullptr;
     }
 
     int reload(bool clear_state_dir, const std::string& snapshot_path) {
+        stop_compaction();
         std::unique_lock lock(mutex);
 
         // we don't use close() to avoid nested lock and because lock is required until db is re-initialized
@@ -332,8 +479,45 @@ public:
     }
 
     rocksdb::Status compact_all() {
-        std::shared_lock lock(mutex);
-        return db->CompactRange(rocksdb::CompactRangeOptions(), nullptr, nullptr);
+        return compact_ranges({});
+    }
+
+    // Compacts the [begin, end) key ranges, or the whole store when there are none.
+    rocksdb::Status compact_ranges(const std::vector<std::pair<std::string, std::string>>& ranges) {
+        if(compaction_running.exchange(true)) {
+            return rocksdb::Status::Busy("A compaction is already running.");
+        }
+
+        return run_compaction(ranges);
+    }
+
+    // Starts compacting the key ranges on a background thread, false when a compaction is already running.
+    bool compact_ranges_async(const std::vector<std::pair<std::string, std::string>>& ranges) {
+        if(compaction_running.exchange(true)) {
+            return false;
+        }
+
+        if(compaction_thread.joinable()) {
+            compaction_thread.join();
+        }
+
+        compaction_thread = std::thread([this, ranges]() {
+            rocksdb::Status status = run_compaction(ranges);
+            if(!status.ok()) {
+                LOG(ERROR) << "Error while compacting the store: " << status.ToString();
+            }
+        });
+
+        return true;
+    }
+
+    compaction_progress_t get_compaction_progress() const {
+        compaction_progress_t progress;
+        progress.running = compaction_running;
+        progress.ranges_compacted = compaction_ranges_compacted;
+        progress.ranges_total = compaction_ranges_total;
+        progress.started_at_s = compaction_started_at_s;
+        return progress;
     }
 
     rocksdb::Status create_check_point(rocksdb::Checkpoint** checkpoint_ptr, const std::string& db_snapshot_path) {
@@ -354,6 +538,28 @@ public:
         return status;
     }
 
+    // Identity of each live SST file by its file name. SST files are never modified, and the session that wrote a
+    // file tells it apart from a file of the same number written by another DB, e.g. on another node.
+    void get_sst_file_ids(std::map<std::string, std::string>& file_ids) {
+        std::shared_lock lock(mutex);
+        rocksdb::TablePropertiesCollection table_props;
+        rocksdb::Status status = db->GetPropertiesOfAllTables(&table_props);
+        if(!status.ok()) {
+            LOG(WARNING) << "Unable to get the properties of SST files, msg: " << status.ToString();
+            return;
+        }
+
+        for(const auto& kv: table_props) {
+            if(kv.second == nullptr || kv.second->db_session_id.empty()) {
+                // files written before sessions were recorded
+                continue;
+            }
+
+            const std::string file_name = kv.first.substr(kv.first.rfind('/') + 1);
+            file_ids.emplace(file_name, kv.second->db_session_id);
+        }
+    }
+
     rocksdb::Status delete_range(const std::string& begin_key, const std::string& end_key) {
         std::shared_lock lock(mutex);
         return db->DeleteRange(rocksdb::WriteOptions(), db->DefaultColumnFamily(), begin_key, end_key);
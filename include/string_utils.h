@@ -49,7 +49,7 @@ struct StringUtils {
             }
 
             if (keep_empty || !temp.empty()) {
-                result.push_back(temp);
+                result.push_back(std::move(temp));
             }
 
             if(result.size() == max_values) {
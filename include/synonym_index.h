@@ -1,6 +1,8 @@
 #pragma once
 
 #include <set>
+#include <memory>
+#include <unordered_map>
 #include "sparsepp.h"
 #include "json.hpp"
 #include "string_utils.h"
@@ -52,6 +54,19 @@ private:
     spp::sparse_hash_map<std::string, synonym_t> synonym_definitions;
     spp::sparse_hash_map<uint64_t, std::vector<std::string>> synonym_index;
 
+    // Trie of the token hashes of the keys of `synonym_index`, so that the windows of a query that are keys are
+    // found by walking the trie from every token, instead of hashing and looking up every window of the query.
+    struct key_trie_node_t {
+        std::unordered_map<uint64_t, std::unique_ptr<key_trie_node_t>> children;
+        bool is_key = false;
+    };
+
+    key_trie_node_t key_trie;
+
+    void add_key(const std::vector<std::string>& tokens);
+
+    void remove_key(const std::vector<std::string>& tokens);
+
     void synonym_reduction_internal(const std::vector<std::string>& tokens,
                                     size_t start_window_size,
                                     size_t start_index_pos,
@@ -1,9 +1,15 @@
+#pragma once
+
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <thread>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include <sys/stat.h>
 #include "json.hpp"
+#include "threadpool.h"
 
 const int NUM_CPU_STATES = 10;
 const int NUM_NETWORK_STATS = 16;
@@ -38,6 +44,26 @@ private:
     static uint64_t non_proc_mem_last_access;
     static uint64_t non_proc_mem_bytes;
 
+    struct thread_pool_sample_t {
+        std::string name;
+        ThreadPool* pool;
+        uint64_t prev_busy_time_us;
+        std::chrono::steady_clock::time_point prev_sampled_at;
+    };
+
+    // serializes the samples, and guards the CPU times of the previous sample
+    static std::mutex sample_mutex;
+    static std::vector<cpu_data_t> prev_cpu_data;
+
+    static std::mutex thread_pools_mutex;
+    static std::vector<thread_pool_sample_t> thread_pools;
+
+    // the last sample, which is swapped as a whole so that readers never wait for a sample to be taken
+    static std::shared_ptr<const nlohmann::json> snapshot;
+    static std::atomic<float> cpu_active_percentage;
+
+    static void get_thread_pool_metrics(nlohmann::json& result);
+
     size_t _get_idle_time(const cpu_data_t &e) {
         // we will consider iowait as cpu being idle
         return e.times[S_IDLE] +
@@ -91,7 +117,7 @@ private:
         return stats;
     }
 
-    std::string format_dp(float value) const {
+    static std::string format_dp(float value) {
         std::stringstream active_ss;
         active_ss.setf(std::ios::fixed, std::ios::floatfield);
         active_ss.precision(2);
@@ -154,8 +180,25 @@ public:
 
     static void linux_get_network_data(const std::string & stat_path, uint64_t& received_bytes, uint64_t& sent_bytes);
 
+    // Reads the metrics of the system, where the CPU usage is the one since the previous call.
     void get(const std::string & data_dir_path, nlohmann::json& result);
 
+    // Samples the metrics of the system and of the registered thread pools into a snapshot, so that endpoints do
+    // not read `/proc` and the disk stats on the request thread.
+    static void sample(const std::string& data_dir_path);
+
+    // Copies the last snapshot into `result`, sampling once when there is none yet.
+    static void get_snapshot(const std::string& data_dir_path, nlohmann::json& result);
+
+    // usage of all the CPUs as of the last sample, negative when there is none yet
+    static float get_cpu_active_percentage() {
+        return cpu_active_percentage;
+    }
+
+    static void register_thread_pool(const std::string& name, ThreadPool* pool);
+
+    static void unregister_thread_pools();
+
     static float used_memory_ratio();
 
     std::vector<cpu_stat_t> get_cpu_stats() {
@@ -7,18 +7,39 @@
 #include "option.h"
 #include "text_embedder_tokenizer.h"
 #include "text_embedder_remote.h"
+#include "embedding_batcher.h"
+#include "embedding_cache.h"
 
 
+// Options of the onnxruntime session of a local model, from its model config. They are set when the model is
+// loaded, so the fields that embed with a model share the options of the field that loaded it.
+struct local_model_options_t {
+    // 0 leaves the number of threads to onnxruntime, which uses all cores
+    size_t intra_op_threads = 0;
+    size_t inter_op_threads = 0;
+
+    // empty picks CUDA when it is available, CPU otherwise
+    std::string execution_provider;
+
+    // loads the INT8 variant of the model, `model_quantized.onnx`, from the directory of the model
+    bool quantized = false;
+
+    static Option<local_model_options_t> parse(const nlohmann::json& model_config);
+};
+
 class TextEmbedder {
     public:
         // Constructor for local or public models
-        TextEmbedder(const std::string& model_path);
+        TextEmbedder(const std::string& model_path, const local_model_options_t& options = {});
         // Constructor for remote models
         TextEmbedder(const nlohmann::json& model_config, size_t num_dims, const bool has_custom_dims = false);
         ~TextEmbedder();
         embedding_res_t Embed(const std::string& text, const size_t remote_embedder_timeout_ms = 30000, const size_t remote_embedding_num_tries = 2);
         std::vector<embedding_res_t> batch_embed(const std::vector<std::string>& inputs, const size_t remote_embedding_batch_size = 200,
                                                  const size_t remote_embedding_timeout_ms = 60000, const size_t remote_embedding_num_tries = 2);
+        // Embeds a search query: embeddings of queries are cached, and with a local model, the queries of concurrent
+        // searches are run as one batch.
+        embedding_res_t embed_query(const std::string& text, const size_t remote_embedder_timeout_ms = 30000, const size_t remote_embedding_num_tries = 2);
         const std::string& get_vocab_file_name() const;
         const size_t get_num_dim() const;
         bool is_remote() {
@@ -41,7 +62,9 @@ class TextEmbedder {
         std::shared_ptr<Ort::Session> session_;
         std::shared_ptr<Ort::Env> env_;
         encoded_input_t Encode(const std::string& text);
-        batch_encoded_input_t batch_encode(const std::vector<std::string>& inputs);
+        static batch_encoded_input_t batch_encode(const std::vector<const encoded_input_t*>& inputs);
+        std::vector<embedding_res_t> remote_batch_embed(const std::vector<std::string>& inputs, const size_t remote_embedding_batch_size,
+                                                        const size_t remote_embedding_timeout_ms, const size_t remote_embedding_num_tries);
         std::unique_ptr<TextEmbeddingTokenizer> tokenizer_;
         std::unique_ptr<RemoteEmbedder> remote_embedder_;
         std::string vocab_file_name;
@@ -49,4 +72,6 @@ class TextEmbedder {
         std::string output_tensor_name;
         size_t num_dim;
         std::mutex mutex_;
+        std::unique_ptr<embedding_batcher_t> query_batcher_;
+        embedding_cache_t query_cache_;
 };
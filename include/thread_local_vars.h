@@ -1,9 +1,88 @@
+#pragma once
+
 #include <chrono>
+#include <atomic>
+#include <cstdint>
 
 extern thread_local int64_t write_log_index;
 
+// First log index of the coalesced writes that are applied together, up to `write_log_index`, or -1 when a single
+// write is applied. Like `write_log_index`, it has to be carried into the threads that index a batch.
+extern thread_local int64_t write_log_first_index;
+
 // These are used for circuit breaking search requests
-// NOTE: if you fork off main search thread, care must be taken to initialize these from parent thread values
+// NOTE: if you fork off main search thread, care must be taken to initialize these from parent thread values, e.g.
+// with a `search_deadline_scope_t`
 extern thread_local uint64_t search_begin_us;
 extern thread_local uint64_t search_stop_us;
-extern thread_local bool search_cutoff;
\ No newline at end of file
+extern thread_local bool search_cutoff;
+
+// Deadline of the search that is running on the current thread.
+struct search_deadline_t {
+    uint64_t begin_us;
+    uint64_t stop_us;
+
+    static search_deadline_t current() {
+        return search_deadline_t{search_begin_us, search_stop_us};
+    }
+
+    // Returns true, and marks the search as cut off, when the search on the current thread is past its deadline.
+    // Meant to be called at phase boundaries and every few thousand iterations of long loops.
+    static bool check_expired() {
+        const uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+
+        if(now_us - search_begin_us > search_stop_us) {
+            search_cutoff = true;
+            return true;
+        }
+
+        return false;
+    }
+};
+
+// Carries the deadline of a search into a task forked off to a thread pool, for the lifetime of the scope: the task
+// starts with a fresh cutoff flag, which is folded into `cutoff` (when given) at the end of the scope. The previous
+// state of the thread is restored then, since the task can also run on the thread of the search itself.
+class search_deadline_scope_t {
+private:
+    uint64_t prev_begin_us;
+    uint64_t prev_stop_us;
+    bool prev_cutoff;
+    std::atomic<bool>* cutoff;
+
+public:
+    explicit search_deadline_scope_t(const search_deadline_t& deadline, std::atomic<bool>* cutoff = nullptr):
+            prev_begin_us(search_begin_us), prev_stop_us(search_stop_us), prev_cutoff(search_cutoff), cutoff(cutoff) {
+        search_begin_us = deadline.begin_us;
+        search_stop_us = deadline.stop_us;
+        search_cutoff = false;
+    }
+
+    ~search_deadline_scope_t() {
+        if(cutoff != nullptr && search_cutoff) {
+            *cutoff = true;
+        }
+
+        search_begin_us = prev_begin_us;
+        search_stop_us = prev_stop_us;
+        search_cutoff = prev_cutoff;
+    }
+};
+
+// Set only while a search with the `profile` parameter is being processed
+// NOTE: like the circuit breaking vars above, has to be copied into threads forked off the main search thread
+struct search_profile_t;
+extern thread_local search_profile_t* search_profile;
+
+// Set while a search request is processed, to account the resources that it uses to its API key and collection
+// NOTE: like the search profile, has to be carried into threads forked off the main search thread
+struct request_cost_t;
+extern thread_local request_cost_t* request_cost;
+
+// Set while the searches of a warm-up are replayed, which are kept out of the search log and the analytics
+extern thread_local bool is_warmup_search;
+
+// Set only while the hits of a search are hydrated, to fetch each referenced document once per page of hits
+struct ref_doc_cache_t;
+extern thread_local ref_doc_cache_t* ref_doc_cache;
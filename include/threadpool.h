@@ -1,68 +1,288 @@
-// https://github.com/jhasse/ThreadPool
+// Originally based on https://github.com/jhasse/ThreadPool
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <future>
-#include <queue>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "timsort.hpp"
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Each worker owns a deque of tasks per priority. A task enqueued from a worker goes on that worker's own deque and
+// other tasks are spread across the workers. A worker that runs out of tasks steals from the other deques, so that a
+// burst of small tasks (e.g. the facet batches of a query) doesn't contend on a single lock. Tasks of a higher
+// priority are always picked before the rest.
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t);
+    enum priority_t {
+        HIGH_PRIORITY = 0,
+        NORMAL_PRIORITY = 1
+    };
+
+    // `thread_init` is called on each worker thread before it picks up any task
+    explicit ThreadPool(size_t, const std::function<void()>& thread_init = nullptr);
+
     template<class F, class... Args>
     decltype(auto) enqueue(F&& f, Args&&... args);
+
+    template<class F, class... Args>
+    decltype(auto) enqueue_with_priority(priority_t priority, F&& f, Args&&... args);
+
+    // Splits [begin, end) into at most `num_chunks` contiguous chunks, calls `func(chunk_begin, chunk_end)` on each of
+    // them in parallel and returns when all are done. The calling thread processes chunks too, so this is safe to call
+    // from a worker of the same pool. An exception thrown by `func` is rethrown here.
+    template<class F>
+    void parallel_for(size_t begin, size_t end, size_t num_chunks, F&& func,
+                      priority_t priority = NORMAL_PRIORITY);
+
+    // ranges smaller than this are sorted on the calling thread, as handing them out costs more than it saves
+    static constexpr size_t PARALLEL_SORT_MIN_SIZE = 16 * 1024;
+
+    // Stable sort of [first, last) with up to `num_chunks` threads: contiguous runs are sorted in parallel and then
+    // merged pairwise, each level of merges also in parallel. Like `parallel_for`, it can be called from a worker.
+    template<class RandomIt, class Compare>
+    void parallel_sort(RandomIt first, RandomIt last, Compare comp, size_t num_chunks,
+                       priority_t priority = NORMAL_PRIORITY);
+
+    size_t num_threads() const;
+
+    // workers that are running a task
+    size_t num_busy_threads() const;
+
+    size_t num_pending_tasks() const;
+
+    // time spent by the workers on tasks since the pool started, which gives the utilisation of the pool over an
+    // interval from two readings
+    uint64_t get_busy_time_us() const;
+
+    // Restricts the workers to the given CPU cores. Returns false when that is not supported on the platform or
+    // the cores are not valid.
+    bool set_cpu_affinity(const std::vector<size_t>& cpu_ids);
+
     void shutdown();
+
 private:
+    static constexpr size_t NUM_PRIORITIES = 2;
+
+    struct worker_queue_t {
+        std::mutex mutex;
+        std::deque<std::packaged_task<void()>> tasks[NUM_PRIORITIES];
+    };
+
     // need to keep track of threads so we can join them
     std::vector< std::thread > workers;
-    // the task queue
-    std::queue< std::packaged_task<void()> > tasks;
+    std::vector<std::unique_ptr<worker_queue_t>> queues;
+
+    // number of tasks sitting in the queues, per priority, updated under the lock of the queue
+    std::atomic<size_t> num_pending[NUM_PRIORITIES];
+    std::atomic<size_t> next_queue;
+
+    std::atomic<size_t> num_busy;
+    std::atomic<uint64_t> busy_time_us;
 
-    // synchronization
+    // synchronization of idle workers
     std::mutex queue_mutex;
     std::condition_variable condition;
     std::condition_variable condition_producers;
-    bool stop;
+    std::atomic<bool> stop;
+
+    // the pool and queue index of the worker running on this thread, if any
+    static inline thread_local ThreadPool* current_pool = nullptr;
+    static inline thread_local size_t current_queue = 0;
+
+    size_t total_pending() const;
+
+    void push_task(priority_t priority, std::packaged_task<void()>&& task);
+
+    bool pop_task(size_t queue_index, std::packaged_task<void()>& task);
+
+    void on_task_popped(bool was_last);
 };
 
 // the constructor just launches some amount of workers
-inline ThreadPool::ThreadPool(size_t threads)
-        :   stop(false)
+inline ThreadPool::ThreadPool(size_t threads, const std::function<void()>& thread_init)
+        :   next_queue(0), num_busy(0), busy_time_us(0), stop(false)
 {
+    for(size_t p = 0; p < NUM_PRIORITIES; p++) {
+        num_pending[p] = 0;
+    }
+
+    threads = std::max<size_t>(threads, 1);
+
+    for(size_t i = 0; i < threads; ++i) {
+        queues.emplace_back(new worker_queue_t());
+    }
+
     for(size_t i = 0;i<threads;++i)
         workers.emplace_back(
-                [this]
+                [this, i, thread_init]
                 {
+                    current_pool = this;
+                    current_queue = i;
+
+                    if(thread_init) {
+                        thread_init();
+                    }
+
                     for(;;)
                     {
                         std::packaged_task<void()> task;
-                        {
+
+                        if(!pop_task(i, task)) {
                             std::unique_lock<std::mutex> lock(this->queue_mutex);
                             this->condition.wait(lock,
-                                                 [this]{ return this->stop || !this->tasks.empty(); });
+                                                 [this]{ return this->stop || this->total_pending() != 0; });
                             if(this->stop) {
                                 return;
                             }
 
-                            if(this->tasks.empty()) {
-                                continue;
-                            }
-                            task = std::move(this->tasks.front());
-                            this->tasks.pop();
-                            if (tasks.empty()) {
-                                condition_producers.notify_one(); // notify the destructor that the queue is empty
-                            }
+                            continue;
                         }
 
+                        // a popped task always runs, since its waiter would otherwise get a broken promise
+                        this->num_busy++;
+                        const auto task_start = std::chrono::steady_clock::now();
+
                         task();
+
+                        this->busy_time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - task_start).count();
+                        this->num_busy--;
                     }
                 }
         );
 }
 
+inline size_t ThreadPool::num_threads() const {
+    return workers.size();
+}
+
+inline size_t ThreadPool::num_busy_threads() const {
+    return num_busy;
+}
+
+inline size_t ThreadPool::num_pending_tasks() const {
+    return total_pending();
+}
+
+inline uint64_t ThreadPool::get_busy_time_us() const {
+    return busy_time_us;
+}
+
+inline bool ThreadPool::set_cpu_affinity(const std::vector<size_t>& cpu_ids) {
+#ifdef __linux__
+    if(cpu_ids.empty()) {
+        return false;
+    }
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for(auto cpu_id: cpu_ids) {
+        if(cpu_id >= CPU_SETSIZE) {
+            return false;
+        }
+
+        CPU_SET(cpu_id, &cpu_set);
+    }
+
+    for(std::thread& worker: workers) {
+        if(pthread_setaffinity_np(worker.native_handle(), sizeof(cpu_set_t), &cpu_set) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+inline size_t ThreadPool::total_pending() const {
+    size_t total = 0;
+    for(size_t p = 0; p < NUM_PRIORITIES; p++) {
+        total += num_pending[p].load();
+    }
+
+    return total;
+}
+
+inline void ThreadPool::push_task(priority_t priority, std::packaged_task<void()>&& task) {
+    const size_t queue_index = (current_pool == this) ? current_queue : (next_queue++ % queues.size());
+    worker_queue_t& queue = *queues[queue_index];
+
+    {
+        std::unique_lock<std::mutex> lock(queue.mutex);
+
+        // don't allow enqueueing after stopping the pool
+        if(stop) {
+            return ;
+        }
+
+        queue.tasks[priority].push_back(std::move(task));
+        num_pending[priority]++;
+    }
+
+    {
+        // taken to not lose the wake up of a worker that is about to wait
+        std::unique_lock<std::mutex> lock(queue_mutex);
+    }
+
+    condition.notify_one();
+}
+
+inline void ThreadPool::on_task_popped(bool was_last) {
+    if(was_last && total_pending() == 0) {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        condition_producers.notify_all(); // notify shutdown() that the queues are empty
+    }
+}
+
+inline bool ThreadPool::pop_task(size_t queue_index, std::packaged_task<void()>& task) {
+    for(size_t p = 0; p < NUM_PRIORITIES; p++) {
+        if(num_pending[p] == 0) {
+            continue;
+        }
+
+        // own queue first, then steal from the other workers
+        for(size_t offset = 0; offset < queues.size(); offset++) {
+            worker_queue_t& queue = *queues[(queue_index + offset) % queues.size()];
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            if(!queue.tasks[p].empty()) {
+                task = std::move(queue.tasks[p].front());
+                queue.tasks[p].pop_front();
+                const bool was_last = (--num_pending[p] == 0);
+                lock.unlock();
+                on_task_popped(was_last);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 // add new work item to the pool
 template<class F, class... Args>
 decltype(auto) ThreadPool::enqueue(F&& f, Args&&... args)
+{
+    return enqueue_with_priority(NORMAL_PRIORITY, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template<class F, class... Args>
+decltype(auto) ThreadPool::enqueue_with_priority(priority_t priority, F&& f, Args&&... args)
 {
     using return_type = std::invoke_result_t<F, Args...>;
 
@@ -71,22 +291,113 @@ decltype(auto) ThreadPool::enqueue(F&& f, Args&&... args)
     );
 
     std::future<return_type> res = task.get_future();
-    {
-        std::unique_lock<std::mutex> lock(queue_mutex);
 
-        // don't allow enqueueing after stopping the pool
-        if(!stop) {
-            tasks.emplace(std::move(task));
+    push_task(priority, std::packaged_task<void()>(std::move(task)));
+
+    return res;
+}
+
+template<class F>
+void ThreadPool::parallel_for(size_t begin, size_t end, size_t num_chunks, F&& func, priority_t priority) {
+    if(begin >= end) {
+        return ;
+    }
+
+    const size_t len = end - begin;
+    num_chunks = std::max<size_t>(1, std::min(num_chunks, len));
+    const size_t chunk_size = (len + num_chunks - 1) / num_chunks;
+    num_chunks = (len + chunk_size - 1) / chunk_size;
+
+    // helpers can start running after this call has returned, so they only hold on to shared state and touch
+    // `func` only after claiming a chunk, which this call waits for
+    struct state_t {
+        std::atomic<size_t> next_chunk{0};
+        size_t num_done = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    auto state = std::make_shared<state_t>();
+    auto* func_ptr = &func;
+
+    auto run_chunks = [state, func_ptr, begin, end, chunk_size, num_chunks]() {
+        size_t chunk;
+        while((chunk = state->next_chunk++) < num_chunks) {
+            const size_t chunk_begin = begin + chunk * chunk_size;
+            const size_t chunk_end = std::min(end, chunk_begin + chunk_size);
+            std::exception_ptr error;
+
+            try {
+                (*func_ptr)(chunk_begin, chunk_end);
+            } catch(...) {
+                error = std::current_exception();
+            }
+
+            std::unique_lock<std::mutex> lock(state->mutex);
+            if(error && !state->error) {
+                state->error = error;
+            }
+
+            if(++state->num_done == num_chunks) {
+                state->cv.notify_one();
+            }
         }
+    };
+
+    for(size_t i = 1; i < num_chunks; i++) {
+        enqueue_with_priority(priority, run_chunks);
+    }
+
+    run_chunks();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&state, num_chunks]() { return state->num_done == num_chunks; });
+
+    if(state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+template<class RandomIt, class Compare>
+void ThreadPool::parallel_sort(RandomIt first, RandomIt last, Compare comp, size_t num_chunks, priority_t priority) {
+    const size_t len = std::distance(first, last);
+    num_chunks = std::min(num_chunks, len / (PARALLEL_SORT_MIN_SIZE / 2));
+
+    if(num_chunks <= 1) {
+        std::stable_sort(first, last, comp);
+        return ;
+    }
+
+    const size_t run_size = (len + num_chunks - 1) / num_chunks;
+    const size_t num_runs = (len + run_size - 1) / run_size;
+
+    // runs are sorted with timsort, which is quick on the partially ordered runs that results are often made of
+    parallel_for(0, num_runs, num_runs, [&](size_t run_begin, size_t run_end) {
+        for(size_t run = run_begin; run < run_end; run++) {
+            gfx::timsort(first + run * run_size, first + std::min(len, (run + 1) * run_size), comp);
+        }
+    }, priority);
+
+    for(size_t width = run_size; width < len; width *= 2) {
+        const size_t num_merges = (len + 2 * width - 1) / (2 * width);
+        parallel_for(0, num_merges, num_merges, [&](size_t merge_begin, size_t merge_end) {
+            for(size_t merge = merge_begin; merge < merge_end; merge++) {
+                const size_t lo = merge * 2 * width;
+                const size_t mid = std::min(len, lo + width);
+                const size_t hi = std::min(len, lo + 2 * width);
+                if(mid < hi) {
+                    std::inplace_merge(first + lo, first + mid, first + hi, comp);
+                }
+            }
+        }, priority);
     }
-    condition.notify_one();
-    return res;
 }
 
 inline void ThreadPool::shutdown() {
     {
         std::unique_lock<std::mutex> lock(queue_mutex);
-        condition_producers.wait(lock, [this] { return tasks.empty(); });
+        condition_producers.wait(lock, [this] { return total_pending() == 0; });
         stop = true;
     }
     condition.notify_all();
@@ -94,3 +405,78 @@ inline void ThreadPool::shutdown() {
         worker.join();
     }
 }
+
+// A task started on a pool that the thread waiting for its result runs itself when no worker has picked it up by
+// then, so that waiting on it is safe from a worker of the same pool and never waits on a busy pool. An exception
+// thrown by the task is rethrown by `wait()`. The task must be waited for before what it refers to goes away, which
+// the destructor does if it has not been.
+class pool_task_t {
+private:
+    struct state_t {
+        std::atomic<bool> claimed{false};
+        bool done = false;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::function<void()> func;
+    };
+
+    std::shared_ptr<state_t> state;
+
+    static void run(state_t& state) {
+        std::exception_ptr error;
+
+        try {
+            state.func();
+        } catch(...) {
+            error = std::current_exception();
+        }
+
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.error = error;
+        state.done = true;
+        state.cv.notify_all();
+    }
+
+public:
+    pool_task_t(ThreadPool* pool, std::function<void()> func,
+                ThreadPool::priority_t priority = ThreadPool::NORMAL_PRIORITY): state(std::make_shared<state_t>()) {
+        state->func = std::move(func);
+
+        pool->enqueue_with_priority(priority, [state = state]() {
+            if(!state->claimed.exchange(true)) {
+                run(*state);
+            }
+        });
+    }
+
+    pool_task_t(const pool_task_t&) = delete;
+
+    pool_task_t& operator=(const pool_task_t&) = delete;
+
+    ~pool_task_t() {
+        try {
+            wait();
+        } catch(...) {
+        }
+    }
+
+    void wait() {
+        if(state == nullptr) {
+            return;
+        }
+
+        auto task_state = std::move(state);
+
+        if(!task_state->claimed.exchange(true)) {
+            run(*task_state);
+        } else {
+            std::unique_lock<std::mutex> lock(task_state->mutex);
+            task_state->cv.wait(lock, [&task_state]() { return task_state->done; });
+        }
+
+        if(task_state->error) {
+            std::rethrow_exception(task_state->error);
+        }
+    }
+};
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <iconv.h>
 #include <unicode/brkiter.h>
 #include <unicode/normalizer2.h>
@@ -23,8 +24,8 @@ private:
     static const size_t SEPARATE = 1;
     static const size_t SKIP = 2;
 
-    uint8_t index_symbols[256] = {};
-    uint8_t separator_symbols[256] = {};
+    // stream mode of every byte, derived from the symbols to index and the separators of the tokenizer
+    uint8_t stream_modes[256] = {};
 
     std::string out;
 
@@ -40,6 +41,7 @@ private:
     int32_t end_pos = 0;
 
     char* normalized_text = nullptr;
+    std::string normalized_ja_text;
 
     // non-deletable singletons
     const icu::Normalizer2* nfkd = nullptr;
@@ -47,14 +49,30 @@ private:
 
     icu::Transliterator* transliterator = nullptr;
 
-    inline size_t get_stream_mode(char c) {
-        return (std::isalnum(c) || index_symbols[uint8_t(c)] == 1) ? INDEX : (
-            (c == ' ' || c == '\n' || separator_symbols[uint8_t(c)] == 1) ? SEPARATE : SKIP
-        );
+    // settings of the tokenizer, used to return it to the pool of tokenizers with the same settings
+    std::string pool_key;
+
+    static const size_t MAX_POOLED_TOKENIZERS = 64;
+
+    static std::string get_pool_key(bool normalize, bool no_op, const std::string& locale,
+                                    const std::vector<char>& symbols_to_index, const std::vector<char>& separators);
+
+    inline size_t get_stream_mode(char c) const {
+        return stream_modes[uint8_t(c)];
     }
 
+    // Appends the run of ASCII alphanumeric characters that starts at `start` to `out`, lowercasing them when
+    // normalizing. Returns the index of the first character past the run.
+    size_t append_ascii_alnum_run(size_t start);
+
 public:
 
+    struct pool_releaser_t {
+        void operator()(Tokenizer* tokenizer) const;
+    };
+
+    typedef std::unique_ptr<Tokenizer, pool_releaser_t> pooled_ptr_t;
+
     explicit Tokenizer(const std::string& input,
                        bool normalize=true, bool no_op=false,
                        const std::string& locale = "",
@@ -68,7 +86,16 @@ public:
         delete transliterator;
     }
 
-    void init(const std::string& input);
+    // `is_normalized` tells that a Japanese input was normalized already, e.g. by `JapaneseLocalizer::normalize_batch()`
+    void init(const std::string& input, bool is_normalized = false);
+
+    // Returns a tokenizer initialized with `input`, which goes back to a pool of the calling thread when released, so
+    // that its iconv handle, break iterator and transliterator are reused by the next tokenizer with the same settings.
+    static pooled_ptr_t acquire(const std::string& input,
+                                bool normalize=true, bool no_op=false,
+                                const std::string& locale = "",
+                                const std::vector<char>& symbols_to_index = {},
+                                const std::vector<char>& separators = {});
 
     bool next(std::string& token, size_t& token_index, size_t& start_index, size_t& end_index);
 
@@ -5,10 +5,16 @@
 #include <cstdio>
 #include <algorithm>
 #include <unordered_map>
+#include <map>
+#include <memory>
 #include <field.h>
 #include "filter_result_iterator.h"
+#include "node_pool.h"
+#include "threadpool.h"
 
 struct KV {
+    typedef std::map<std::string, reference_filter_result_t> reference_filter_results_t;
+
     int8_t match_score_index{};
     uint16_t query_index{};
     uint16_t array_index{};
@@ -23,12 +29,14 @@ struct KV {
     // to be used only in final aggregation
     uint64_t* query_indices = nullptr;
 
-    std::map<std::string, reference_filter_result_t> reference_filter_results;
+    // Only set when the hit carries references from a join. Topster entries are copied around on every add, so in
+    // the common case without joins they stay small and no map is ever built, copied or destroyed.
+    std::unique_ptr<reference_filter_results_t> reference_filter_results;
 
     KV(uint16_t queryIndex, uint64_t key, uint64_t distinct_key, int8_t match_score_index, const int64_t *scores,
-       std::map<std::string, reference_filter_result_t>  reference_filter_results = {}):
+       reference_filter_results_t reference_filter_results = {}):
             match_score_index(match_score_index), query_index(queryIndex), array_index(0), key(key),
-            distinct_key(distinct_key), reference_filter_results(std::move(reference_filter_results)) {
+            distinct_key(distinct_key) {
         this->scores[0] = scores[0];
         this->scores[1] = scores[1];
         this->scores[2] = scores[2];
@@ -36,11 +44,26 @@ struct KV {
         if(match_score_index >= 0){
             this->text_match_score = scores[match_score_index];
         }
+
+        if(!reference_filter_results.empty()) {
+            this->reference_filter_results = std::make_unique<reference_filter_results_t>(
+                    std::move(reference_filter_results));
+        }
     }
 
     KV() = default;
 
-    KV(KV& kv) = default;
+    KV(KV& kv): match_score_index(kv.match_score_index),
+                query_index(kv.query_index), array_index(kv.array_index),
+                key(kv.key), distinct_key(kv.distinct_key),
+                vector_distance(kv.vector_distance), text_match_score(kv.text_match_score),
+                query_indices(kv.query_indices) {
+        scores[0] = kv.scores[0];
+        scores[1] = kv.scores[1];
+        scores[2] = kv.scores[2];
+
+        copy_reference_filter_results(kv);
+    }
 
     KV(KV&& kv) noexcept : match_score_index(kv.match_score_index),
                  query_index(kv.query_index), array_index(kv.array_index),
@@ -103,11 +126,7 @@ struct KV {
             vector_distance = kv.vector_distance;
             text_match_score = kv.text_match_score;
 
-            reference_filter_results.clear();
-
-            for (const auto& item: kv.reference_filter_results) {
-                reference_filter_results[item.first] = item.second;
-            }
+            copy_reference_filter_results(kv);
         }
 
         return *this;
@@ -117,6 +136,22 @@ struct KV {
         delete [] query_indices;
         query_indices = nullptr;
     }
+
+    const reference_filter_results_t& get_reference_filter_results() const {
+        static const reference_filter_results_t empty_reference_filter_results;
+        return reference_filter_results == nullptr ? empty_reference_filter_results : *reference_filter_results;
+    }
+
+private:
+    void copy_reference_filter_results(const KV& kv) {
+        if(kv.reference_filter_results == nullptr) {
+            reference_filter_results.reset();
+        } else if(reference_filter_results == nullptr) {
+            reference_filter_results = std::make_unique<reference_filter_results_t>(*kv.reference_filter_results);
+        } else {
+            *reference_filter_results = *kv.reference_filter_results;
+        }
+    }
 };
 
 /*
@@ -129,17 +164,39 @@ struct Topster {
     KV *data;
     KV** kvs;
 
-    std::unordered_map<uint64_t, KV*> kv_map;
+    typedef node_pool_allocator_t<std::pair<const uint64_t, KV*>> kv_map_allocator_t;
+
+    // An add that displaces an entry erases and inserts a node of `kv_map`, so its nodes are recycled through a pool
+    // instead of going through malloc every time. Group topsters share the pool of their parent topster, which is
+    // why a topster must only be added to by one thread at a time.
+    std::unique_ptr<node_pool_t<>> own_kv_pool;
+    node_pool_t<>* kv_pool;
+
+    std::unordered_map<uint64_t, KV*, std::hash<uint64_t>, std::equal_to<uint64_t>, kv_map_allocator_t> kv_map;
 
     spp::sparse_hash_set<uint64_t> group_doc_seq_ids;
 
     spp::sparse_hash_map<uint64_t, Topster*> group_kv_map;
     size_t distinct;
 
+    // groups in the order of their first hit, and how many of the leading ones hold `distinct` hits
+    std::vector<Topster*> groups_in_order;
+    size_t num_leading_full_groups = 0;
+
+    // With a `search_after` cursor, only hits that rank below the cursor are kept.
+    bool has_search_after = false;
+    int64_t search_after_scores[3]{};
+    uint64_t search_after_key = 0;
+
     explicit Topster(size_t capacity): Topster(capacity, 0) {
     }
 
-    explicit Topster(size_t capacity, size_t distinct): MAX_SIZE(capacity), size(0), distinct(distinct) {
+    explicit Topster(size_t capacity, size_t distinct, node_pool_t<>* shared_kv_pool = nullptr):
+            MAX_SIZE(capacity), size(0),
+            own_kv_pool(shared_kv_pool == nullptr ? std::make_unique<node_pool_t<>>() : nullptr),
+            kv_pool(shared_kv_pool == nullptr ? own_kv_pool.get() : shared_kv_pool),
+            kv_map(0, std::hash<uint64_t>(), std::equal_to<uint64_t>(), kv_map_allocator_t(kv_pool)),
+            distinct(distinct) {
         // we allocate data first to get a memory block whose indices are then assigned to `kvs`
         // we use separate **kvs for easier pointer swaps
         data = new KV[capacity];
@@ -185,7 +242,11 @@ struct Topster {
         }*/
 
         int ret = 1;
-       
+
+        if(has_search_after && !is_after_cursor(kv)) {
+            return 0;
+        }
+
         bool less_than_min_heap = (size >= MAX_SIZE) && is_smaller(kv, kvs[0]);
         size_t heap_op_index = 0;
 
@@ -210,9 +271,10 @@ struct Topster {
             if(kvs_it != group_kv_map.end()) {
                 kvs_it->second->add(kv);
             } else {
-                Topster* g_topster = new Topster(distinct, 0);
+                Topster* g_topster = new Topster(distinct, 0, kv_pool);
                 g_topster->add(kv);
                 group_kv_map.insert({kv->distinct_key, g_topster});
+                groups_in_order.push_back(g_topster);
             }
             
             return ret;
@@ -313,14 +375,51 @@ struct Topster {
                std::tie(j->scores[0], j->scores[1], j->scores[2], j->key);
     }
 
+    void set_search_after(const int64_t* scores, uint64_t key) {
+        has_search_after = true;
+        search_after_scores[0] = scores[0];
+        search_after_scores[1] = scores[1];
+        search_after_scores[2] = scores[2];
+        search_after_key = key;
+    }
+
+    // for the topsters whose hits end up in this one
+    void copy_search_after(const Topster& other) {
+        if(other.has_search_after) {
+            set_search_after(other.search_after_scores, other.search_after_key);
+        }
+    }
+
+    bool is_after_cursor(const struct KV* kv) const {
+        return std::tie(kv->scores[0], kv->scores[1], kv->scores[2], kv->key) <
+               std::tie(search_after_scores[0], search_after_scores[1], search_after_scores[2], search_after_key);
+    }
+
     static bool is_greater_kv_group(const std::vector<KV*>& i, const std::vector<KV*>& j) {
         return std::tie(i[0]->scores[0], i[0]->scores[1], i[0]->scores[2], i[0]->key) >
                std::tie(j[0]->scores[0], j[0]->scores[1], j[0]->scores[2], j[0]->key);
     }
 
+    // When hits are added in the order of their sort, the first `num_groups` groups are the top ones, and once each
+    // of them holds `distinct` hits no later hit can change them.
+    bool are_top_groups_full(size_t num_groups) {
+        while(num_leading_full_groups < groups_in_order.size() &&
+              groups_in_order[num_leading_full_groups]->size >= distinct) {
+            num_leading_full_groups++;
+        }
+
+        return num_leading_full_groups >= num_groups;
+    }
+
     // topster must be sorted before iterated upon to remove dead array entries
-    void sort() {
-        if(!distinct) {
+    void sort(ThreadPool* thread_pool = nullptr, size_t concurrency = 1) {
+        if(distinct) {
+            return ;
+        }
+
+        if(thread_pool != nullptr && concurrency > 1 && size >= ThreadPool::PARALLEL_SORT_MIN_SIZE) {
+            thread_pool->parallel_sort(kvs, kvs + size, is_greater, concurrency, ThreadPool::HIGH_PRIORITY);
+        } else {
             std::stable_sort(kvs, kvs + size, is_greater);
         }
     }
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "sparsepp.h"
+#include "ids_t.h"
+
+// Index of the trigrams of the tokens of an infix field, so that an infix search intersects the token lists of the
+// trigrams of the query and only checks the tokens that contain all of them, instead of scanning every token.
+//
+// Tokens get ids in the order they are inserted and ids are not reused, so ids are always appended to the end of
+// the trigram lists. Trigrams are of bytes, not of code points: a query is a substring of a token only if its byte
+// trigrams are all in the token.
+//
+// Built for the infix fields of indices created while `set_enabled(true)` is in effect.
+class trigram_index_t {
+private:
+    uint32_t next_token_id = 0;
+
+    spp::sparse_hash_map<std::string, uint32_t> token_ids;
+    spp::sparse_hash_map<uint32_t, std::string> id_tokens;
+
+    // trigram packed into the low 3 bytes => token ids
+    spp::sparse_hash_map<uint32_t, void*> trigram_token_ids;
+
+    static std::atomic<bool> enabled;
+
+    static void get_trigrams(const std::string& token, std::vector<uint32_t>& trigrams);
+
+public:
+    static constexpr size_t TRIGRAM_LEN = 3;
+
+    trigram_index_t() = default;
+
+    ~trigram_index_t();
+
+    trigram_index_t(const trigram_index_t&) = delete;
+
+    trigram_index_t& operator=(const trigram_index_t&) = delete;
+
+    // no-op for a token that is already in the index
+    void insert(const std::string& token);
+
+    void erase(const std::string& token);
+
+    // Appends the tokens that contain `query` at most `max_extra_prefix` bytes from their start and
+    // `max_extra_suffix` bytes from their end, judged on the first occurrence of `query` in the token.
+    // Returns false without looking up anything if `query` is shorter than a trigram.
+    bool search(const std::string& query, size_t max_extra_prefix, size_t max_extra_suffix,
+                std::vector<std::string>& tokens) const;
+
+    size_t size() const {
+        return token_ids.size();
+    }
+
+    size_t num_trigrams() const {
+        return trigram_token_ids.size();
+    }
+
+    static void set_enabled(bool enable) {
+        enabled = enable;
+    }
+
+    static bool is_enabled() {
+        return enabled;
+    }
+};
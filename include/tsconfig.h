@@ -42,6 +42,22 @@ private:
     int snapshot_interval_seconds;
     int snapshot_max_byte_count_per_rpc;
 
+    // writes arriving within this window are coalesced into a single raft log entry (0 disables it)
+    uint32_t write_batch_window_us;
+    uint32_t write_batch_max_bytes;
+
+    // log entries of at least this many bytes are compressed (0 disables it)
+    uint32_t log_compression_min_bytes;
+
+    // follows the nodes of `nodes` as a non-voting read replica, instead of joining their raft group
+    bool learner;
+
+    // bytes of the applied log entries that a voter keeps for its learners and change streams (0 disables it)
+    uint32_t learner_feed_max_bytes;
+
+    // writes up to this size are held in memory while they wait to be indexed, instead of in the store
+    uint32_t queued_request_memory_max_bytes;
+
     std::atomic<size_t> healthy_read_lag;
     std::atomic<size_t> healthy_write_lag;
 
@@ -55,6 +71,29 @@ private:
 
     uint32_t thread_pool_size;
 
+    // number of event loops that accept and parse the HTTP requests, each with its own listener
+    uint32_t num_http_event_loops;
+
+    uint32_t indexing_thread_pool_size;
+    std::string indexing_cpu_affinity;
+
+    // number of threads that validate and tokenize the documents of an import batch
+    uint32_t index_batch_concurrency;
+
+    // maximum number of the searches of a multi search request that run at the same time
+    uint32_t multi_search_concurrency;
+
+    // pages with at least these many hits have the documents of their hits prepared in parallel, never when 0
+    uint32_t hits_parallel_threshold;
+
+    // searches give up some features once the searches in flight reach this percentage of the admission limit,
+    // never when 0
+    uint32_t search_degradation_load_percent;
+
+    int memory_dirty_decay_ms;
+
+    int memory_muzzy_decay_ms;
+
     bool enable_access_logging;
 
     int disk_used_max_percentage;
@@ -62,10 +101,50 @@ private:
 
     std::atomic<uint32_t> cache_num_entries = 1000;
 
+    uint32_t cache_max_memory_mb;
+    uint32_t cache_compress_min_bytes;
+
+    // responses of at least this size are compressed for the clients that accept it
+    uint32_t http_compress_min_bytes;
+
+    uint32_t typo_cache_num_entries;
+
+    uint32_t embedding_query_batch_window_ms;
+
+    uint32_t embedding_cache_num_entries;
+
+    uint32_t stem_cache_num_entries;
+
+    uint32_t remote_embedding_concurrency;
+
     std::atomic<bool> skip_writes;
 
     std::atomic<int> log_slow_searches_time_ms;
 
+    // time spent on replaying the frequent searches before a started node reports healthy
+    uint32_t search_warmup_time_ms;
+
+    // collections that are not looked up for this long are evicted from memory, none when 0
+    uint32_t collection_idle_eviction_secs;
+
+    // only collections that were loaded from the store within this time are evicted
+    uint32_t collection_restore_budget_ms;
+
+    // comma separated names of the collections that are loaded first when the node starts
+    std::string hot_collections;
+
+    // in-memory index of the document ids of each collection: `off`, `map` or `bloom`
+    std::string doc_id_index;
+
+    // voice queries that a voice query model transcribes at the same time, each with its own decoder state
+    uint32_t voice_query_parallelism;
+
+    // voice queries longer than this are rejected
+    uint32_t voice_query_max_audio_secs;
+
+    // flat vector searches are scored on a CUDA device through cuBLAS when one is found
+    bool enable_vector_gpu_scoring;
+
     std::atomic<bool> reset_peers_on_error;
 
     bool enable_search_analytics;
@@ -74,12 +153,36 @@ private:
 
     uint32_t housekeeping_interval;
 
+    // time that a pass of the housekeeper may spend on its tasks before the rest are left to the next pass
+    uint32_t housekeeping_budget_ms;
+
     uint32_t db_compaction_interval;
 
+    // RocksDB tuning: block cache shared by the stores (RocksDB's default per store when 0), bits per key of the
+    // bloom filters (disabled when 0), row cache per store (disabled when 0) and direct I/O for flushes & compactions
+    uint32_t db_block_cache_mb;
+    uint32_t db_bloom_bits_per_key;
+    uint32_t db_row_cache_mb;
+    bool db_compaction_direct_io;
+
+    // I/O budget of RocksDB flushes and compactions in MB/s, unlimited when 0
+    uint32_t db_compaction_rate_limit_mb;
+
     bool enable_lazy_filter;
 
+    bool enable_infix_trigram_index;
+
     bool enable_search_logging;
 
+    bool enable_search_admission_control;
+
+    bool enable_memory_arenas;
+
+    bool enable_index_image;
+
+    // documents deleted by id are only excluded from searches at first, and unindexed in batches later
+    bool enable_deferred_deletes;
+
 protected:
 
     Config() {
@@ -90,29 +193,76 @@ protected:
         this->max_memory_ratio = 1.0f;
         this->snapshot_interval_seconds = 3600;
         this->snapshot_max_byte_count_per_rpc = 4194304;
+        this->write_batch_window_us = 0;
+        this->write_batch_max_bytes = 1048576;
+        this->log_compression_min_bytes = 0;
+        this->learner = false;
+        this->learner_feed_max_bytes = 0;
+        this->queued_request_memory_max_bytes = 1048576;
         this->healthy_read_lag = 1000;
         this->healthy_write_lag = 500;
         this->log_slow_requests_time_ms = -1;
         this->num_collections_parallel_load = 0;  // will be set dynamically if not overridden
         this->num_documents_parallel_load = 1000;
         this->cache_num_entries = 1000;
+        this->cache_max_memory_mb = 0;
+        this->cache_compress_min_bytes = 0;
+        this->http_compress_min_bytes = 256;
+        this->typo_cache_num_entries = 1024;
+        this->embedding_query_batch_window_ms = 0;
+        this->embedding_cache_num_entries = 1000;
+        this->stem_cache_num_entries = 64 * 1024;
+        this->remote_embedding_concurrency = 4;
         this->thread_pool_size = 0; // will be set dynamically if not overridden
+        this->num_http_event_loops = 1;
+        this->indexing_thread_pool_size = 0; // indexing shares the search thread pool by default
+        this->indexing_cpu_affinity = "";
+        this->index_batch_concurrency = 4;
+        this->multi_search_concurrency = 4;
+        this->hits_parallel_threshold = 64;
+        this->search_degradation_load_percent = 0;
+        this->memory_dirty_decay_ms = 10000;
+        this->memory_muzzy_decay_ms = 0;
         this->ssl_refresh_interval_seconds = 8 * 60 * 60;
         this->enable_access_logging = false;
         this->disk_used_max_percentage = 100;
         this->memory_used_max_percentage = 100;
         this->skip_writes = false;
         this->log_slow_searches_time_ms = 30 * 1000;
+        this->search_warmup_time_ms = 0;
+        this->collection_idle_eviction_secs = 0;
+        this->collection_restore_budget_ms = 1000;
+        this->hot_collections = "";
+        this->doc_id_index = "off";
+        this->voice_query_parallelism = 2;
+        this->voice_query_max_audio_secs = 30;
         this->reset_peers_on_error = false;
 
         this->enable_search_analytics = false;
         this->analytics_flush_interval = 3600;  // in seconds
         this->housekeeping_interval = 1800;     // in seconds
+        this->housekeeping_budget_ms = 10000;
         this->db_compaction_interval = 0;     // in seconds, disabled
+        this->db_block_cache_mb = 0;
+        this->db_bloom_bits_per_key = 10;
+        this->db_row_cache_mb = 0;
+        this->db_compaction_direct_io = false;
+        this->db_compaction_rate_limit_mb = 0;
 
         this->enable_lazy_filter = false;
 
+        this->enable_infix_trigram_index = false;
+
         this->enable_search_logging = false;
+
+        this->enable_search_admission_control = false;
+
+        this->enable_memory_arenas = false;
+
+        this->enable_index_image = false;
+
+        this->enable_deferred_deletes = false;
+        this->enable_vector_gpu_scoring = false;
     }
 
     Config(Config const&) {
@@ -290,6 +440,30 @@ public:
         return this->snapshot_max_byte_count_per_rpc;
     }
 
+    uint32_t get_write_batch_window_us() const {
+        return this->write_batch_window_us;
+    }
+
+    uint32_t get_write_batch_max_bytes() const {
+        return this->write_batch_max_bytes;
+    }
+
+    uint32_t get_log_compression_min_bytes() const {
+        return this->log_compression_min_bytes;
+    }
+
+    bool get_learner() const {
+        return this->learner;
+    }
+
+    uint32_t get_learner_feed_max_bytes() const {
+        return this->learner_feed_max_bytes;
+    }
+
+    uint32_t get_queued_request_memory_max_bytes() const {
+        return this->queued_request_memory_max_bytes;
+    }
+
     size_t get_healthy_read_lag() const {
         return this->healthy_read_lag;
     }
@@ -306,6 +480,34 @@ public:
         return this->log_slow_searches_time_ms;
     }
 
+    size_t get_search_warmup_time_ms() const {
+        return this->search_warmup_time_ms;
+    }
+
+    uint32_t get_collection_idle_eviction_secs() const {
+        return this->collection_idle_eviction_secs;
+    }
+
+    uint32_t get_collection_restore_budget_ms() const {
+        return this->collection_restore_budget_ms;
+    }
+
+    std::string get_hot_collections() const {
+        return this->hot_collections;
+    }
+
+    std::string get_doc_id_index() const {
+        return this->doc_id_index;
+    }
+
+    uint32_t get_voice_query_parallelism() const {
+        return this->voice_query_parallelism;
+    }
+
+    uint32_t get_voice_query_max_audio_secs() const {
+        return this->voice_query_max_audio_secs;
+    }
+
     const std::atomic<bool>& get_reset_peers_on_error() const {
         return reset_peers_on_error;
     }
@@ -322,6 +524,38 @@ public:
         return this->cache_num_entries;
     }
 
+    size_t get_cache_max_memory_mb() const {
+        return this->cache_max_memory_mb;
+    }
+
+    size_t get_cache_compress_min_bytes() const {
+        return this->cache_compress_min_bytes;
+    }
+
+    size_t get_http_compress_min_bytes() const {
+        return this->http_compress_min_bytes;
+    }
+
+    size_t get_typo_cache_num_entries() const {
+        return this->typo_cache_num_entries;
+    }
+
+    uint32_t get_embedding_query_batch_window_ms() const {
+        return this->embedding_query_batch_window_ms;
+    }
+
+    size_t get_embedding_cache_num_entries() const {
+        return this->embedding_cache_num_entries;
+    }
+
+    size_t get_stem_cache_num_entries() const {
+        return this->stem_cache_num_entries;
+    }
+
+    size_t get_remote_embedding_concurrency() const {
+        return this->remote_embedding_concurrency;
+    }
+
     size_t get_analytics_flush_interval() const {
         return this->analytics_flush_interval;
     }
@@ -330,14 +564,74 @@ public:
         return this->housekeeping_interval;
     }
 
+    uint32_t get_housekeeping_budget_ms() const {
+        return this->housekeeping_budget_ms;
+    }
+
     size_t get_db_compaction_interval() const {
         return this->db_compaction_interval;
     }
 
+    size_t get_db_block_cache_mb() const {
+        return this->db_block_cache_mb;
+    }
+
+    size_t get_db_bloom_bits_per_key() const {
+        return this->db_bloom_bits_per_key;
+    }
+
+    size_t get_db_row_cache_mb() const {
+        return this->db_row_cache_mb;
+    }
+
+    bool get_db_compaction_direct_io() const {
+        return this->db_compaction_direct_io;
+    }
+
+    size_t get_db_compaction_rate_limit_mb() const {
+        return this->db_compaction_rate_limit_mb;
+    }
+
     size_t get_thread_pool_size() const {
         return this->thread_pool_size;
     }
 
+    size_t get_num_http_event_loops() const {
+        return this->num_http_event_loops;
+    }
+
+    size_t get_indexing_thread_pool_size() const {
+        return this->indexing_thread_pool_size;
+    }
+
+    size_t get_index_batch_concurrency() const {
+        return this->index_batch_concurrency;
+    }
+
+    size_t get_multi_search_concurrency() const {
+        return this->multi_search_concurrency;
+    }
+
+    size_t get_hits_parallel_threshold() const {
+        return this->hits_parallel_threshold;
+    }
+
+    size_t get_search_degradation_load_percent() const {
+        return this->search_degradation_load_percent;
+    }
+
+    int get_memory_dirty_decay_ms() const {
+        return this->memory_dirty_decay_ms;
+    }
+
+    int get_memory_muzzy_decay_ms() const {
+        return this->memory_muzzy_decay_ms;
+    }
+
+    std::string get_indexing_cpu_affinity() const {
+        return this->indexing_cpu_affinity;
+    }
+
     size_t get_ssl_refresh_interval_seconds() const {
         return this->ssl_refresh_interval_seconds;
     }
@@ -354,6 +648,14 @@ public:
         return this->enable_search_logging;
     }
 
+    bool get_enable_search_admission_control() const {
+        return this->enable_search_admission_control;
+    }
+
+    bool get_enable_memory_arenas() const {
+        return this->enable_memory_arenas;
+    }
+
     int get_disk_used_max_percentage() const {
         return this->disk_used_max_percentage;
     }
@@ -374,6 +676,22 @@ public:
         return enable_lazy_filter;
     }
 
+    bool get_enable_infix_trigram_index() const {
+        return enable_infix_trigram_index;
+    }
+
+    bool get_enable_index_image() const {
+        return enable_index_image;
+    }
+
+    bool get_enable_deferred_deletes() const {
+        return enable_deferred_deletes;
+    }
+
+    bool get_enable_vector_gpu_scoring() const {
+        return enable_vector_gpu_scoring;
+    }
+
     const std::atomic<bool>& get_skip_writes() const {
         return skip_writes;
     }
@@ -405,6 +723,10 @@ public:
         this->enable_search_analytics = enable_search_analytics;
     }
 
+    void set_enable_deferred_deletes(bool enable_deferred_deletes) {
+        this->enable_deferred_deletes = enable_deferred_deletes;
+    }
+
     void set_enable_search_logging(bool enable_search_logging) {
         this->enable_search_logging = enable_search_logging;
     }
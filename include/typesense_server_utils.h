@@ -18,6 +18,8 @@ void catch_interrupt(int sig);
 
 bool directory_exists(const std::string& dir_path);
 
+bool parse_cpu_list(const std::string& cpu_list, std::vector<size_t>& cpu_ids);
+
 void init_cmdline_options(cmdline::parser& options, int argc, char **argv);
 
 int init_root_logger(Config& config, const std::string& server_version);
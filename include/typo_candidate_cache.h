@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "json.hpp"
+#include "art.h"
+
+struct typo_candidates_t {
+    std::vector<const art_node*> nodes;
+
+    // for a prefix token, lets the search of the token typed next resume the walk of this one
+    art_fuzzy_frontier_t frontier;
+};
+
+// Caches the nodes matched by fuzzy traversals of the token trees of an index, keyed on the field, the token, the
+// typo cost and whether the token is a prefix, so that the tokens sent over and over by search-as-you-type do not
+// walk the tree on every request.
+//
+// Nodes are what a traversal finds before the filter, the previous token and the candidates already picked are
+// applied to their leaves, so an entry serves every query of the token. Entries are stamped with the write
+// generation of the index they were computed at, and an entry of an older generation is never returned: node
+// pointers are only valid while the index is not written to.
+//
+// Search-as-you-type also looks up the entry of the token without its last char: the frontier of that walk lets
+// the walk of the token resume where the one of the previous keystroke was still the same.
+//
+// Bounded by a number of entries, set for all indices with `set_max_entries()`. Counters are for all indices too.
+class typo_candidate_cache_t {
+public:
+    typedef std::shared_ptr<const typo_candidates_t> candidates_t;
+
+private:
+    struct entry_t {
+        candidates_t candidates;
+        uint64_t write_generation;
+    };
+
+    mutable std::mutex mutex;
+
+    // most recently used entry is at the front
+    std::list<std::pair<std::string, entry_t>> entries;
+    std::unordered_map<std::string, std::list<std::pair<std::string, entry_t>>::iterator> entry_index;
+
+    void erase(std::list<std::pair<std::string, entry_t>>::iterator it);
+
+    static std::atomic<size_t> max_entries;
+
+    static std::atomic<uint64_t> hits;
+    static std::atomic<uint64_t> misses;
+    static std::atomic<uint64_t> invalidations;
+    static std::atomic<uint64_t> evictions;
+    static std::atomic<uint64_t> num_entries;
+
+public:
+    static constexpr size_t DEFAULT_MAX_ENTRIES = 1024;
+
+    // traversals that match more nodes, or have a larger frontier, than this are not held
+    static constexpr size_t MAX_ENTRY_NODES = 4096;
+
+    typo_candidate_cache_t() = default;
+
+    ~typo_candidate_cache_t();
+
+    static std::string get_key(const std::string& field_name, const std::string& token, int cost, bool prefix);
+
+    candidates_t get(const std::string& key, uint64_t write_generation);
+
+    void insert(const std::string& key, uint64_t write_generation, candidates_t candidates);
+
+    void clear();
+
+    size_t size() const;
+
+    // A `max_entries` of 0 disables the cache.
+    static void set_max_entries(size_t max_entries);
+
+    static void get_metrics(nlohmann::json& result);
+};
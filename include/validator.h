@@ -6,9 +6,46 @@
 #include "tsl/htrie_map.h"
 #include "field.h"
 
+// Type of a field that a document value is coerced to, resolved from the name of the type once, so that documents are
+// not checked against it by comparing strings.
+enum class coerce_type_t: uint8_t {
+    STRING,
+    INT32,
+    INT64,
+    FLOAT,
+    BOOL,
+    GEOPOINT,
+    STRING_ARRAY,
+    INT32_ARRAY,
+    INT64_ARRAY,
+    FLOAT_ARRAY,
+    BOOL_ARRAY,
+    GEOPOINT_ARRAY,
+    OTHER_ARRAY,
+    OTHER
+};
+
+// The checks of a schema, compiled once for a batch of documents instead of being worked out from the schema for each
+// document: the fields that are validated, in the order of the schema, with their types resolved.
+struct validator_program_t {
+    struct field_check_t {
+        const field* a_field;
+        coerce_type_t type;
+        bool is_auto_embedding;
+    };
+
+    std::vector<field_check_t> checks;
+
+    // the schema must outlive the program, as the checks point to its fields
+    validator_program_t(const tsl::htrie_map<char, field>& search_schema,
+                        const tsl::htrie_map<char, field>& embedding_fields);
+};
+
 class validator_t {
 public:
 
+    static coerce_type_t get_coerce_type(const field& a_field);
+
     static Option<uint32_t> validate_index_in_memory(nlohmann::json &document, uint32_t seq_id,
                                                      const std::string & default_sorting_field,
                                                      const tsl::htrie_map<char, field> & search_schema,
@@ -18,6 +55,22 @@ public:
                                                      const std::string& fallback_field_type,
                                                      const DIRTY_VALUES& dirty_values, const bool validate_embedding_fields = true);
 
+    // Validates and coerces the document in a single pass over the checks of a compiled schema.
+    static Option<uint32_t> validate_index_in_memory(nlohmann::json &document, uint32_t seq_id,
+                                                     const std::string & default_sorting_field,
+                                                     const validator_program_t& program,
+                                                     const tsl::htrie_map<char, field> & search_schema,
+                                                     const tsl::htrie_map<char, field> & embedding_fields,
+                                                     const index_operation_t op,
+                                                     const bool is_update,
+                                                     const std::string& fallback_field_type,
+                                                     const DIRTY_VALUES& dirty_values,
+                                                     const bool validate_embedding_fields = true);
+
+    static Option<uint32_t> coerce_element(const field& a_field, const coerce_type_t type, nlohmann::json& document,
+                                           nlohmann::json& doc_ele,
+                                           const std::string& fallback_field_type,
+                                           const DIRTY_VALUES& dirty_values);
 
     static Option<uint32_t> coerce_element(const field& a_field, nlohmann::json& document,
                                            nlohmann::json& doc_ele,
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+#include "hnswlib/hnswlib.h"
+
+// Float vectors of a field in one contiguous array indexed by seq_id, each of them on cache lines of its own. A flat
+// search scores the filtered ids in ascending order, so the rows it reads are in the order of the array and the rows
+// of the ids ahead are prefetched while the current ones are scored, instead of each vector being looked up through
+// the label map of the graph.
+//
+// Rows are kept for seq ids up to the largest one that was put, so a column takes the memory of that many vectors.
+class vector_column_t {
+private:
+    mutable std::shared_mutex mutex;
+
+    const size_t num_dim;
+    const size_t row_size;
+
+    float* data = nullptr;
+    size_t capacity = 0;
+
+    std::vector<bool> present;
+    size_t num_vectors = 0;
+
+    void reserve(size_t min_capacity);
+
+public:
+    static constexpr size_t ROW_ALIGNMENT = 64;
+    static constexpr size_t INITIAL_CAPACITY = 1024;
+
+    // rows this far ahead of the one that is scored are prefetched
+    static constexpr size_t PREFETCH_DISTANCE = 8;
+
+    explicit vector_column_t(size_t num_dim);
+
+    ~vector_column_t();
+
+    vector_column_t(const vector_column_t&) = delete;
+
+    vector_column_t& operator=(const vector_column_t&) = delete;
+
+    void put(uint32_t seq_id, const float* values);
+
+    bool get(uint32_t seq_id, std::vector<float>& values) const;
+
+    void remove(uint32_t seq_id);
+
+    size_t size() const;
+
+    // Appends the distances of `query` to the vectors of `seq_ids` to `dist_labels`, skipping the ids that have no
+    // vector.
+    void distances(const float* query, const uint32_t* seq_ids, size_t num_ids,
+                   hnswlib::DISTFUNC<float> dist_func, const void* dist_func_param,
+                   std::vector<std::pair<float, size_t>>& dist_labels) const;
+
+    // Writes the smallest distance of the `num_queries` query vectors to the vector of each of `seq_ids` into
+    // `distances`, leaving the entries of the ids that have no vector as they are. Each row is read once for all the
+    // query vectors.
+    void min_distances(const float* const* queries, size_t num_queries, const uint32_t* seq_ids, size_t num_ids,
+                       hnswlib::DISTFUNC<float> dist_func, const void* dist_func_param, float* distances) const;
+
+    // Appends the vectors of `seq_ids` one after the other to `rows`, and the index in `seq_ids` of each of them to
+    // `row_indices`, skipping the ids that have no vector.
+    void gather(const uint32_t* seq_ids, size_t num_ids, std::vector<float>& rows,
+                std::vector<size_t>& row_indices) const;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include <sparsepp.h>
+#include "option.h"
+
+enum vector_storage_t {
+    memory_storage,
+    disk_storage
+};
+
+bool parse_vector_storage(const std::string& name, vector_storage_t& storage);
+
+// Float vectors of a field held in a file that is mapped into memory, so that the pages of vectors that are not
+// read are left to the operating system instead of taking up the memory of the process. Only the vectors of the
+// candidates of a search are read, to rank them on their exact distances.
+//
+// The file is a scratch file: it is unlinked as soon as it is opened, and its vectors are indexed again from the
+// documents when the process restarts. Slots of removed vectors are reused.
+class vector_file_t {
+private:
+    mutable std::shared_mutex mutex;
+
+    const size_t num_dim;
+    const size_t record_size;
+
+    int fd = -1;
+    char* data = nullptr;
+    size_t capacity = 0;
+    size_t num_slots = 0;
+
+    spp::sparse_hash_map<uint32_t, uint32_t> slots;
+    std::vector<uint32_t> free_slots;
+
+    bool reserve(size_t min_capacity);
+
+public:
+    static constexpr size_t INITIAL_CAPACITY = 1024;
+
+    explicit vector_file_t(size_t num_dim);
+
+    ~vector_file_t();
+
+    Option<bool> open(const std::string& dir_path);
+
+    bool put(uint32_t seq_id, const float* values);
+
+    bool get(uint32_t seq_id, std::vector<float>& values) const;
+
+    void remove(uint32_t seq_id);
+
+    size_t size() const;
+
+    size_t file_size() const;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "hnswlib/hnswlib.h"
+
+enum vector_quantization_t {
+    no_quantization,
+    sq8
+};
+
+// Space of vectors that are scalar quantized to 8 bits, so that a graph holds a quarter of the memory of float
+// vectors. Each vector is quantized on its own range, `lower + scale * code` for `code` in [0, 255], which needs
+// no training on the vectors of the field, and inner products are computed on the codes with integer kernels.
+//
+// A record is `num_dim` codes, padded to 4 bytes, followed by the lower bound and scale of the vector and the sum
+// of its codes.
+class sq8_space_t: public hnswlib::SpaceInterface<float> {
+public:
+    struct params_t {
+        // first, since hnswlib reads the number of values of a record from here
+        size_t record_size;
+        size_t num_dim;
+        size_t meta_offset;
+    };
+
+private:
+    params_t params;
+
+public:
+    explicit sq8_space_t(size_t num_dim);
+
+    size_t get_data_size() override;
+
+    hnswlib::DISTFUNC<float> get_dist_func() override;
+
+    void* get_dist_func_param() override;
+
+    size_t get_num_dim() const {
+        return params.num_dim;
+    }
+
+    void encode(const float* values, std::vector<uint8_t>& record) const;
+
+    void decode(const uint8_t* record, std::vector<float>& values) const;
+
+    // inner product distance, `1 - <a, b>`, of two records
+    static float distance(const void* a, const void* b, const void* params);
+
+    // sum of the products of codes: picks the widest kernel the CPU has
+    static uint32_t dot_codes(const uint8_t* a, const uint8_t* b, size_t num_codes);
+
+    static uint32_t dot_codes_scalar(const uint8_t* a, const uint8_t* b, size_t num_codes);
+
+    // name of the kernel `dot_codes` uses
+    static const char* kernel_name();
+};
+
+bool parse_vector_quantization(const std::string& name, vector_quantization_t& quantization);
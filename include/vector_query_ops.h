@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include "option.h"
@@ -10,11 +11,19 @@ struct vector_query_t {
     std::string field_name;
     size_t k = 0;
     size_t flat_search_cutoff = 0;
+    // otherwise flat search is picked on the selectivity of the filter
+    bool flat_search_cutoff_given = false;
     float distance_threshold = 2.01;
     std::vector<float> values;
 
     uint32_t seq_id = 0;
     bool query_doc_given = false;
+
+    // the vectors and referenced documents of a query of several vectors, after the first ones held in `values`
+    // and `seq_id`: a document is scored on its distance to the nearest of the query vectors
+    std::vector<std::vector<float>> extra_values;
+    std::vector<uint32_t> extra_seq_ids;
+
     float alpha = 0.3;
 
     uint32_t ef = 10;
@@ -30,6 +39,21 @@ struct vector_query_t {
         values.clear();
         seq_id = 0;
         query_doc_given = false;
+        extra_values.clear();
+        extra_seq_ids.clear();
+    }
+
+    size_t num_query_vectors() const {
+        return values.empty() ? 0 : 1 + extra_values.size();
+    }
+
+    const std::vector<float>& get_query_vector(size_t i) const {
+        return i == 0 ? values : extra_values[i - 1];
+    }
+
+    bool is_query_doc(uint32_t id) const {
+        return query_doc_given &&
+               (id == seq_id || std::find(extra_seq_ids.begin(), extra_seq_ids.end(), id) != extra_seq_ids.end());
     }
 };
 
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <string>
 #include <vector>
 #include <mutex>
 #include <shared_mutex>
 #include <whisper.h>
 
+#include "lru/lru.hpp"
 #include "string_utils.h"
 #include "option.h"
 
@@ -14,9 +17,37 @@ class VQModel {
         int collection_ref_count = 0;
         std::shared_mutex collection_ref_count_mutex;
         std::string model_name;
+
+        // transcriptions of recent voice queries, keyed by the hash of their encoded audio
+        LRU::Cache<uint64_t, std::string> transcription_cache{TRANSCRIPTION_CACHE_SIZE};
+        std::mutex transcription_cache_mutex;
+
+        // voice queries that wait for the model, and those that it is transcribing
+        std::atomic<uint64_t> num_queued = 0;
+        std::atomic<uint64_t> num_running = 0;
+        std::atomic<uint64_t> num_transcribed = 0;
+        std::atomic<uint64_t> num_cache_hits = 0;
+        std::atomic<uint64_t> queue_time_us = 0;
+        std::atomic<uint64_t> transcribe_time_us = 0;
+
+        virtual Option<std::string> transcribe_audio(const std::string& audio_base64) = 0;
     public:
+        static constexpr size_t TRANSCRIPTION_CACHE_SIZE = 1024;
+
+        struct metrics_t {
+            uint64_t queued = 0;
+            uint64_t running = 0;
+            uint64_t transcribed = 0;
+            uint64_t cache_hits = 0;
+            uint64_t queue_time_us = 0;
+            uint64_t transcribe_time_us = 0;
+        };
+
         virtual ~VQModel() = default;
-        virtual Option<std::string> transcribe(const std::string& audio) = 0;
+        // Transcribes the audio with the model, unless the same audio was transcribed recently.
+        Option<std::string> transcribe(const std::string& audio_base64);
+        // adds the counters of the model to `metrics`
+        void add_metrics(metrics_t& metrics) const;
         void inc_collection_ref_count() {
             std::unique_lock<std::shared_mutex> lock(collection_ref_count_mutex);
             collection_ref_count++;
@@ -36,16 +67,29 @@ class VQModel {
 };
 
 
+// Voice queries are transcribed on the threads of the searches, each with its own decoder state: the states share
+// the weights of the model, so that concurrent voice queries run side by side rather than one after the other. The
+// states are created as needed, up to `voice-query-parallelism`, and further voice queries wait for one to be free.
 class WhisperModel : public VQModel {
     private:
         whisper_context* ctx = nullptr;
         whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-        bool read_wav(const void* data, size_t size, std::vector<float>& pcmf32);
-        std::mutex mutex;
+        Option<bool> read_wav(const void* data, size_t size, std::vector<float>& pcmf32);
+
+        std::vector<whisper_state*> states;
+        std::vector<whisper_state*> idle_states;
+        size_t max_states;
+        size_t max_audio_frames;
+        std::mutex states_mutex;
+        std::condition_variable states_cv;
+
+        whisper_state* acquire_state();
+        void release_state(whisper_state* state);
+    protected:
+        virtual Option<std::string> transcribe_audio(const std::string& audio_base64) override;
     public:
         WhisperModel() = delete;
         WhisperModel(whisper_context* ctx, const std::string& model_name);
         static whisper_context* validate_and_load_model(const std::string& model_path);
         ~WhisperModel();
-        virtual Option<std::string> transcribe(const std::string& audio_base64) override;
 };
\ No newline at end of file
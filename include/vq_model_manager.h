@@ -36,5 +36,6 @@ class VQModelManager {
         void delete_all_models();
         ~VQModelManager();  
         void clear_unused_models();
+        void get_metrics(nlohmann::json& result);
 };
 
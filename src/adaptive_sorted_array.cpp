@@ -0,0 +1,263 @@
+#include "adaptive_sorted_array.h"
+#include <algorithm>
+
+adaptive_sorted_array::~adaptive_sorted_array() {
+    free_bitmap();
+}
+
+size_t adaptive_sorted_array::array_size_bytes(uint32_t length, uint32_t min, uint32_t max) {
+    const uint32_t range = max - min;
+    const uint32_t bits = (range == 0) ? 0 : 32 - __builtin_clz(range);
+    return (for_compressed_size_bits(length, bits) + 7) / 8 + METADATA_OVERHEAD;
+}
+
+size_t adaptive_sorted_array::bitmap_size_bytes(uint32_t min, uint32_t max) {
+    return (size_t(max - (min & ~63U)) / 64 + 1) * sizeof(uint64_t);
+}
+
+void adaptive_sorted_array::load_bitmap(const uint32_t* sorted_ids, uint32_t length) {
+    free_bitmap();
+
+    base = sorted_ids[0] & ~63U;
+    num_words = (sorted_ids[length - 1] - base) / 64 + 1;
+    words = new uint64_t[num_words]();
+
+    for(uint32_t i = 0; i < length; i++) {
+        const uint32_t bit = sorted_ids[i] - base;
+        words[bit / 64] |= (uint64_t(1) << (bit % 64));
+    }
+
+    bitmap_length = length;
+    is_bitmap = true;
+}
+
+void adaptive_sorted_array::free_bitmap() {
+    delete [] words;
+    words = nullptr;
+    num_words = 0;
+    base = 0;
+    bitmap_length = 0;
+    is_bitmap = false;
+}
+
+void adaptive_sorted_array::grow_bitmap(uint32_t value) {
+    const uint32_t new_base = std::min(base, value & ~63U);
+    const size_t words_before = (base - new_base) / 64;
+    size_t new_num_words = std::max<size_t>(words_before + num_words, size_t(value - new_base) / 64 + 1);
+
+    if(value >= base) {
+        // IDs are mostly appended in increasing order, so leave some room for the next ones
+        new_num_words = std::max<size_t>(new_num_words, num_words * FOR_GROWTH_FACTOR);
+    }
+
+    uint64_t* new_words = new uint64_t[new_num_words]();
+    std::copy(words, words + num_words, new_words + words_before);
+
+    delete [] words;
+    words = new_words;
+    num_words = new_num_words;
+    base = new_base;
+}
+
+uint32_t adaptive_sorted_array::bitmap_min() const {
+    for(uint32_t i = 0; i < num_words; i++) {
+        if(words[i] != 0) {
+            return base + i * 64 + __builtin_ctzll(words[i]);
+        }
+    }
+
+    return base;
+}
+
+uint32_t adaptive_sorted_array::bitmap_max() const {
+    for(uint32_t i = num_words; i > 0; i--) {
+        if(words[i - 1] != 0) {
+            return base + (i - 1) * 64 + (63 - __builtin_clzll(words[i - 1]));
+        }
+    }
+
+    return base;
+}
+
+uint32_t adaptive_sorted_array::bitmap_rank(uint32_t value) const {
+    const uint32_t bit = value - base;
+    uint32_t rank = 0;
+
+    for(uint32_t i = 0; i < bit / 64; i++) {
+        rank += __builtin_popcountll(words[i]);
+    }
+
+    const uint64_t mask = (uint64_t(1) << (bit % 64)) - 1;
+    return rank + __builtin_popcountll(words[bit / 64] & mask);
+}
+
+void adaptive_sorted_array::adapt() {
+    if(!is_bitmap) {
+        const uint32_t length = array.getLength();
+        if(length >= MIN_BITMAP_LENGTH &&
+           bitmap_size_bytes(array.getMin(), array.getMax()) < array_size_bytes(length, array.getMin(), array.getMax())) {
+            uint32_t* ids = array.uncompress();
+            load_bitmap(ids, length);
+            array.load(nullptr, 0);
+            delete [] ids;
+        }
+
+        return ;
+    }
+
+    // switch back only when the bitmap is clearly larger, so that a set near the threshold does not flip-flop
+    const uint32_t min = bitmap_min(), max = bitmap_max();
+    if(bitmap_length < MIN_BITMAP_LENGTH / 2 ||
+       bitmap_size_bytes(min, max) > 2 * array_size_bytes(bitmap_length, min, max)) {
+        uint32_t* ids = uncompress();
+        array.load(ids, bitmap_length);
+        free_bitmap();
+        delete [] ids;
+    }
+}
+
+void adaptive_sorted_array::load(const uint32_t* sorted_ids, uint32_t length) {
+    if(length >= MIN_BITMAP_LENGTH &&
+       bitmap_size_bytes(sorted_ids[0], sorted_ids[length - 1]) <
+       array_size_bytes(length, sorted_ids[0], sorted_ids[length - 1])) {
+        load_bitmap(sorted_ids, length);
+        array.load(nullptr, 0);
+        return ;
+    }
+
+    free_bitmap();
+    array.load(sorted_ids, length);
+}
+
+uint32_t adaptive_sorted_array::at(uint32_t index) {
+    if(!is_bitmap) {
+        return array.at(index);
+    }
+
+    for(uint32_t i = 0; i < num_words; i++) {
+        const uint32_t word_count = __builtin_popcountll(words[i]);
+        if(index < word_count) {
+            uint64_t word = words[i];
+            for(uint32_t j = 0; j < index; j++) {
+                word &= word - 1;
+            }
+
+            return base + i * 64 + __builtin_ctzll(word);
+        }
+
+        index -= word_count;
+    }
+
+    return UINT32_MAX;
+}
+
+uint32_t adaptive_sorted_array::last() {
+    if(!is_bitmap) {
+        return array.last();
+    }
+
+    return bitmap_length == 0 ? UINT32_MAX : bitmap_max();
+}
+
+bool adaptive_sorted_array::contains(uint32_t value) {
+    if(!is_bitmap) {
+        return array.contains(value);
+    }
+
+    if(value < base || (value - base) / 64 >= num_words) {
+        return false;
+    }
+
+    const uint32_t bit = value - base;
+    return (words[bit / 64] >> (bit % 64)) & 1;
+}
+
+uint32_t adaptive_sorted_array::indexOf(uint32_t value) {
+    if(!is_bitmap) {
+        return array.indexOf(value);
+    }
+
+    if(!contains(value)) {
+        return bitmap_length;
+    }
+
+    return bitmap_rank(value);
+}
+
+size_t adaptive_sorted_array::append(uint32_t value) {
+    if(!is_bitmap) {
+        size_t index = array.append(value);
+        adapt();
+        return index;
+    }
+
+    if(contains(value)) {
+        return bitmap_rank(value);
+    }
+
+    if(value < base || (value - base) / 64 >= num_words) {
+        const uint32_t min = std::min(value, bitmap_min());
+        const uint32_t max = std::max(value, bitmap_max());
+
+        if(bitmap_size_bytes(min, max) > 2 * array_size_bytes(bitmap_length + 1, min, max)) {
+            // an outlier would blow up the bitmap, so go back to the array first
+            uint32_t* ids = uncompress();
+            array.load(ids, bitmap_length);
+            free_bitmap();
+            delete [] ids;
+            return array.append(value);
+        }
+
+        grow_bitmap(value);
+    }
+
+    const uint32_t bit = value - base;
+    words[bit / 64] |= (uint64_t(1) << (bit % 64));
+    bitmap_length++;
+
+    return bitmap_rank(value);
+}
+
+void adaptive_sorted_array::remove_value(uint32_t value) {
+    if(!is_bitmap) {
+        array.remove_value(value);
+        return ;
+    }
+
+    if(!contains(value)) {
+        return ;
+    }
+
+    const uint32_t bit = value - base;
+    words[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+    bitmap_length--;
+
+    adapt();
+}
+
+uint32_t* adaptive_sorted_array::uncompress(uint32_t len) const {
+    if(!is_bitmap) {
+        return array.uncompress(len);
+    }
+
+    uint32_t* out = new uint32_t[std::max(len, bitmap_length)];
+    size_t out_index = 0;
+
+    for(uint32_t i = 0; i < num_words; i++) {
+        uint64_t word = words[i];
+        while(word != 0) {
+            out[out_index++] = base + i * 64 + __builtin_ctzll(word);
+            word &= word - 1;
+        }
+    }
+
+    return out;
+}
+
+uint32_t adaptive_sorted_array::getLength() const {
+    return is_bitmap ? bitmap_length : array.getLength();
+}
+
+uint32_t adaptive_sorted_array::getSizeInBytes() {
+    return is_bitmap ? num_words * sizeof(uint64_t) : array.getSizeInBytes();
+}
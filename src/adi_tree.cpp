@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 #include "adi_tree.h"
@@ -111,6 +112,7 @@ void adi_tree_t::index(const uint32_t id, const std::string& key) {
 
     add_node(root, key, 0);
     id_keys.emplace(id, key);
+    invalidate_ranks();
 }
 
 bool adi_tree_t::rank_aggregate(adi_node_t* node, const std::string& key, const size_t key_index, size_t& rank) {
@@ -135,6 +137,50 @@ bool adi_tree_t::rank_aggregate(adi_node_t* node, const std::string& key, const
 }
 
 size_t adi_tree_t::rank(uint32_t id) {
+    if(id_ranks_valid.load(std::memory_order_acquire)) {
+        const uint32_t id_rank = (id < id_ranks.size()) ? id_ranks[id] : 0;
+        return (id_rank == 0) ? NOT_FOUND : id_rank;
+    }
+
+    if(stale_rank_lookups.fetch_add(1, std::memory_order_relaxed) >= id_keys.size()) {
+        build_ranks();
+    }
+
+    return walk_rank(id);
+}
+
+void adi_tree_t::invalidate_ranks() {
+    if(id_ranks_valid) {
+        id_ranks_valid = false;
+        std::vector<uint32_t>().swap(id_ranks);
+    }
+
+    stale_rank_lookups = 0;
+}
+
+void adi_tree_t::build_ranks() {
+    // the other threads looking up ranks meanwhile walk the tree
+    std::unique_lock lock(id_ranks_mutex, std::try_to_lock);
+    if(!lock.owns_lock() || id_ranks_valid) {
+        return ;
+    }
+
+    uint32_t max_id = 0;
+    for(const auto& id_key: id_keys) {
+        max_id = std::max(max_id, id_key.first);
+    }
+
+    id_ranks.assign(id_keys.empty() ? 0 : size_t(max_id) + 1, 0);
+
+    for(const auto& id_key: id_keys) {
+        const size_t id_rank = walk_rank(id_key.first);
+        id_ranks[id_key.first] = (id_rank == NOT_FOUND) ? 0 : id_rank;
+    }
+
+    id_ranks_valid.store(true, std::memory_order_release);
+}
+
+size_t adi_tree_t::walk_rank(uint32_t id) {
     const auto& id_keys_it = id_keys.find(id);
 
     if(id_keys_it == id_keys.end()) {
@@ -256,6 +302,7 @@ void adi_tree_t::remove(uint32_t id) {
     }
 
     id_keys.erase(id);
+    invalidate_ranks();
 }
 
 adi_tree_t::~adi_tree_t() {
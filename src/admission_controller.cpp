@@ -0,0 +1,115 @@
+#include "admission_controller.h"
+#include <algorithm>
+#include <cmath>
+
+void AdmissionController::init(size_t min_limit, size_t max_limit) {
+    std::unique_lock lk(mutex);
+    this->min_limit = std::max<size_t>(min_limit, 1);
+    this->max_limit = std::max(max_limit, this->min_limit);
+    limit = this->min_limit;
+    estimated_limit = this->min_limit;
+    smoothed_latency_us = 0;
+    min_latency_us = 0;
+    num_samples = 0;
+    enabled = true;
+}
+
+void AdmissionController::disable() {
+    enabled = false;
+}
+
+bool AdmissionController::is_enabled() const {
+    return enabled;
+}
+
+bool AdmissionController::try_admit(bool high_priority) {
+    const size_t current_limit = limit.load(std::memory_order_relaxed);
+    const size_t allowed = high_priority ? size_t(current_limit * HIGH_PRIORITY_HEADROOM) : current_limit;
+
+    if(in_flight.fetch_add(1) >= allowed) {
+        in_flight--;
+        return false;
+    }
+
+    return true;
+}
+
+void AdmissionController::release(uint64_t latency_us) {
+    in_flight--;
+
+    std::unique_lock lk(mutex);
+
+    if(num_samples == 0) {
+        smoothed_latency_us = latency_us;
+        min_latency_us = latency_us;
+    } else {
+        smoothed_latency_us += LATENCY_SMOOTHING * (double(latency_us) - smoothed_latency_us);
+        min_latency_us = std::min(min_latency_us, double(latency_us));
+    }
+
+    num_samples++;
+
+    if(num_samples % MIN_LATENCY_WINDOW == 0) {
+        min_latency_us = smoothed_latency_us;
+    }
+
+    if(smoothed_latency_us <= 0) {
+        return ;
+    }
+
+    // the gradient is 1 while latency is within tolerance and falls to 0.5 as searches queue up, while the square
+    // root of the limit is the number of searches allowed to queue
+    const double gradient = std::clamp(LATENCY_TOLERANCE * min_latency_us / smoothed_latency_us, 0.5, 1.0);
+    const double new_limit = estimated_limit * gradient + std::sqrt(estimated_limit);
+
+    estimated_limit += LIMIT_SMOOTHING * (new_limit - estimated_limit);
+    estimated_limit = std::clamp<double>(estimated_limit, min_limit, max_limit);
+    limit = std::lround(estimated_limit);
+}
+
+size_t AdmissionController::get_limit() const {
+    return limit;
+}
+
+size_t AdmissionController::get_in_flight() const {
+    return in_flight;
+}
+
+uint32_t AdmissionController::get_retry_after_s() const {
+    std::unique_lock lk(mutex);
+    const size_t current_limit = std::max<size_t>(limit, 1);
+
+    // time for the searches in flight to drain at the current latency
+    const double drain_time_s = smoothed_latency_us * (double(in_flight) / current_limit) / (1000 * 1000);
+    return std::max<uint32_t>(1, std::ceil(drain_time_s));
+}
+
+size_t AdmissionController::get_load_percent() const {
+    if(!enabled) {
+        return 0;
+    }
+
+    return in_flight * 100 / std::max<size_t>(limit, 1);
+}
+
+size_t AdmissionController::get_degradation_level(size_t load_percent, size_t threshold_percent,
+                                                  uint64_t waited_ms, uint64_t search_cutoff_ms) {
+    if(threshold_percent == 0) {
+        return 0;
+    }
+
+    if(search_cutoff_ms != 0 && waited_ms * 2 >= search_cutoff_ms) {
+        return NUM_DEGRADATION_LEVELS;
+    }
+
+    if(load_percent < threshold_percent) {
+        return 0;
+    }
+
+    if(threshold_percent >= 100) {
+        return NUM_DEGRADATION_LEVELS;
+    }
+
+    const size_t level = 1 + (load_percent - threshold_percent) * NUM_DEGRADATION_LEVELS / (100 - threshold_percent);
+    return std::min(level, NUM_DEGRADATION_LEVELS);
+}
@@ -78,6 +78,15 @@ Option<bool> AnalyticsManager::create_index(nlohmann::json &payload, bool upsert
         expand_query = params["expand_query"].get<bool>();
     }
 
+    bool top_k_sketch = false;
+
+    if(params.contains("top_k_sketch")) {
+        if(!params["top_k_sketch"].is_boolean()) {
+            return Option<bool>(400, "Parameter `top_k_sketch` must be a boolean.");
+        }
+        top_k_sketch = params["top_k_sketch"].get<bool>();
+    }
+
     std::string counter_field;
     std::string suggestion_collection;
 
@@ -85,6 +94,7 @@ Option<bool> AnalyticsManager::create_index(nlohmann::json &payload, bool upsert
     suggestion_config.name = suggestion_config_name;
     suggestion_config.limit = limit;
     suggestion_config.expand_query = expand_query;
+    suggestion_config.top_k_sketch = top_k_sketch;
     suggestion_config.rule_type = payload["type"];
 
     if(is_event_type) {
@@ -192,9 +202,11 @@ Option<bool> AnalyticsManager::create_index(nlohmann::json &payload, bool upsert
     if(payload["type"] == POPULAR_QUERIES_TYPE) {
         QueryAnalytics* popularQueries = new QueryAnalytics(limit);
         popularQueries->set_expand_query(suggestion_config.expand_query);
+        popularQueries->set_enable_top_k_sketch(suggestion_config.top_k_sketch);
         popular_queries.emplace(suggestion_collection, popularQueries);
     } else if(payload["type"] == NOHITS_QUERIES_TYPE) {
         QueryAnalytics *noresultsQueries = new QueryAnalytics(limit);
+        noresultsQueries->set_enable_top_k_sketch(suggestion_config.top_k_sketch);
         nohits_queries.emplace(suggestion_collection, noresultsQueries);
     } else if(payload["type"] == COUNTER_TYPE) {
         if(query_collection_events.count(suggestion_collection) == 0) {
@@ -354,16 +366,48 @@ Option<bool> AnalyticsManager::remove_index(const std::string &name) {
 void AnalyticsManager::add_suggestion(const std::string &query_collection,
                                       const std::string& query, const std::string& expanded_query,
                                       const bool live_query, const std::string& user_id) {
-    // look up suggestion collections for the query collection
-    std::unique_lock lock(mutex);
-    const auto& suggestion_collections_it = query_collection_mapping.find(query_collection);
-    if(suggestion_collections_it != query_collection_mapping.end()) {
-        for(const auto& suggestion_collection: suggestion_collections_it->second) {
-            const auto& popular_queries_it = popular_queries.find(suggestion_collection);
-            if(popular_queries_it != popular_queries.end()) {
-                popular_queries_it->second->add(query, expanded_query, live_query, user_id);
+    uint64_t now_ts_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    buffer_query_event(query_event_t{query_collection, query, expanded_query, live_query, user_id, now_ts_us, false});
+}
+
+void AnalyticsManager::buffer_query_event(query_event_t&& query_event) {
+    auto& shard = query_event_shards[std::hash<std::thread::id>{}(std::this_thread::get_id()) % NUM_QUERY_EVENT_SHARDS];
+    std::unique_lock lock(shard.mutex);
+    if(shard.events.size() < MAX_QUERY_EVENTS_PER_SHARD) {
+        shard.events.push_back(std::move(query_event));
+    }
+}
+
+void AnalyticsManager::aggregate_query_events() {
+    // lock is held by caller
+    std::vector<query_event_t> events;
+
+    for(auto& shard: query_event_shards) {
+        {
+            std::unique_lock lock(shard.mutex);
+            events.swap(shard.events);
+        }
+
+        for(const auto& event: events) {
+            // look up suggestion collections for the query collection
+            const auto& suggestion_collections_it = query_collection_mapping.find(event.query_collection);
+            if(suggestion_collections_it == query_collection_mapping.end()) {
+                continue;
+            }
+
+            auto& query_analytics = event.nohits ? nohits_queries : popular_queries;
+
+            for(const auto& suggestion_collection: suggestion_collections_it->second) {
+                const auto& query_analytics_it = query_analytics.find(suggestion_collection);
+                if(query_analytics_it != query_analytics.end()) {
+                    query_analytics_it->second->add(event.query, event.expanded_query, event.live_query,
+                                                    event.user_id, event.timestamp_us);
+                }
             }
         }
+
+        events.clear();
     }
 }
 
@@ -465,17 +509,9 @@ Option<bool> AnalyticsManager::add_event(const std::string& client_ip, const std
 
 void AnalyticsManager::add_nohits_query(const std::string &query_collection, const std::string &query,
                                         bool live_query, const std::string &user_id) {
-    // look up suggestion collections for the query collection
-    std::unique_lock lock(mutex);
-    const auto& suggestion_collections_it = query_collection_mapping.find(query_collection);
-    if(suggestion_collections_it != query_collection_mapping.end()) {
-        for(const auto& suggestion_collection: suggestion_collections_it->second) {
-            const auto& noresults_queries_it = nohits_queries.find(suggestion_collection);
-            if(noresults_queries_it != nohits_queries.end()) {
-                noresults_queries_it->second->add(query, query, live_query, user_id);
-            }
-        }
-    }
+    uint64_t now_ts_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    buffer_query_event(query_event_t{query_collection, query, query, live_query, user_id, now_ts_us, true});
 }
 
 void AnalyticsManager::run(ReplicationState* raft_server) {
@@ -493,6 +529,8 @@ void AnalyticsManager::run(ReplicationState* raft_server) {
             break;
         }
 
+        aggregate_query_events();
+
         auto now_ts_seconds = std::chrono::duration_cast<std::chrono::seconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count();
 
@@ -686,6 +724,11 @@ void AnalyticsManager::dispose() {
     event_collection_map.clear();
 
     events_cache.clear();
+
+    for(auto& shard: query_event_shards) {
+        std::unique_lock shard_lock(shard.mutex);
+        shard.events.clear();
+    }
 }
 
 void AnalyticsManager::init(Store* store, const std::string& analytics_dir) {
@@ -700,11 +743,13 @@ void AnalyticsManager::init(Store* store, const std::string& analytics_dir) {
 
 std::unordered_map<std::string, QueryAnalytics*> AnalyticsManager::get_popular_queries() {
     std::unique_lock lk(mutex);
+    aggregate_query_events();
     return popular_queries;
 }
 
 std::unordered_map<std::string, QueryAnalytics*> AnalyticsManager::get_nohits_queries() {
     std::unique_lock lk(mutex);
+    aggregate_query_events();
     return nohits_queries;
 }
 
@@ -18,6 +18,197 @@ void AppMetrics::increment_write_metrics(uint64_t route_hash, uint64_t duration)
     }
 }
 
+AppMetrics::latency_series_t* AppMetrics::get_latency_series(const std::string& label, const std::string& collection) {
+    {
+        std::shared_lock lock(latency_mutex);
+        auto label_it = latency_series.find(label);
+        if(label_it != latency_series.end()) {
+            auto series_it = label_it->second.find(collection);
+            if(series_it != label_it->second.end()) {
+                return series_it->second.get();
+            }
+        }
+    }
+
+    std::unique_lock lock(latency_mutex);
+    auto& series = latency_series[label][collection];
+    if(series == nullptr) {
+        series = std::make_unique<latency_series_t>();
+        series->histogram.snapshot(series->window_start_counts);
+        series->histogram.snapshot(series->last_window_counts);
+    }
+
+    return series.get();
+}
+
+void AppMetrics::record_latency(const std::string& label, const std::string& collection, uint64_t duration_us) {
+    get_latency_series(label, "")->histogram.record(duration_us);
+
+    if(!collection.empty()) {
+        get_latency_series(label, collection)->histogram.record(duration_us);
+    }
+}
+
+void AppMetrics::record_request_latency(uint64_t route_hash, const std::string& collection, uint64_t duration_us) {
+    if(is_search_route(route_hash)) {
+        record_latency(SEARCH_LABEL, collection, duration_us);
+    }
+
+    else if(is_multi_search_route(route_hash)) {
+        // the searches of a multi search request may span collections
+        record_latency(MULTI_SEARCH_LABEL, "", duration_us);
+    }
+
+    else if(is_doc_import_route(route_hash)) {
+        record_latency(IMPORT_LABEL, collection, duration_us);
+    }
+
+    else if(is_doc_write_route(route_hash)) {
+        record_latency(DOC_WRITE_LABEL, collection, duration_us);
+    }
+
+    else if(is_doc_del_route(route_hash)) {
+        record_latency(DOC_DELETE_LABEL, collection, duration_us);
+    }
+}
+
+static nlohmann::json latency_percentiles(const std::vector<uint64_t>& bucket_counts) {
+    uint64_t count = 0;
+    for(const auto bucket_count: bucket_counts) {
+        count += bucket_count;
+    }
+
+    nlohmann::json percentiles;
+    percentiles["count"] = count;
+    percentiles["p50"] = latency_histogram_t::value_at_percentile(bucket_counts, 50) / 1000.0;
+    percentiles["p90"] = latency_histogram_t::value_at_percentile(bucket_counts, 90) / 1000.0;
+    percentiles["p99"] = latency_histogram_t::value_at_percentile(bucket_counts, 99) / 1000.0;
+    percentiles["p999"] = latency_histogram_t::value_at_percentile(bucket_counts, 99.9) / 1000.0;
+
+    return percentiles;
+}
+
+void AppMetrics::get_latency_percentiles(nlohmann::json& result) const {
+    std::shared_lock lock(latency_mutex);
+
+    nlohmann::json& percentiles = result["latency_percentiles_ms"];
+    percentiles = nlohmann::json::object();
+    percentiles["collections"] = nlohmann::json::object();
+
+    for(const auto& label_kv: latency_series) {
+        for(const auto& series_kv: label_kv.second) {
+            if(series_kv.first.empty()) {
+                percentiles[label_kv.first] = latency_percentiles(series_kv.second->last_window_counts);
+            } else {
+                percentiles["collections"][series_kv.first][label_kv.first] =
+                        latency_percentiles(series_kv.second->last_window_counts);
+            }
+        }
+    }
+}
+
+static std::string escape_prometheus_label(const std::string& value) {
+    std::string escaped;
+    for(char c: value) {
+        if(c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if(c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+
+    return escaped;
+}
+
+void AppMetrics::get_prometheus_metrics(std::string& result) const {
+    // the fine grained buckets of the histograms are folded into these upper bounds (in seconds)
+    static const std::vector<std::pair<std::string, uint64_t>> bucket_bounds = {
+        {"0.001", 1000}, {"0.0025", 2500}, {"0.005", 5000}, {"0.01", 10000}, {"0.025", 25000}, {"0.05", 50000},
+        {"0.1", 100000}, {"0.25", 250000}, {"0.5", 500000}, {"1", 1000000}, {"2.5", 2500000}, {"5", 5000000},
+        {"10", 10000000},
+    };
+
+    std::shared_lock lock(latency_mutex);
+
+    std::string overall_metrics, collection_metrics, lock_wait_metrics;
+    std::vector<uint64_t> bucket_counts;
+
+    for(const auto& label_kv: latency_series) {
+        const bool is_lock_wait = (label_kv.first == INDEX_READ_LOCK_WAIT_LABEL ||
+                                   label_kv.first == INDEX_WRITE_LOCK_WAIT_LABEL);
+
+        for(const auto& series_kv: label_kv.second) {
+            const bool is_overall = series_kv.first.empty();
+            std::string& metrics = is_lock_wait ? lock_wait_metrics : is_overall ? overall_metrics : collection_metrics;
+            const std::string name = is_lock_wait ? "typesense_index_lock_wait_seconds" :
+                                     is_overall ? "typesense_request_latency_seconds" :
+                                     "typesense_collection_request_latency_seconds";
+            std::string labels = is_lock_wait ?
+                                 std::string("mode=\"") + (label_kv.first == INDEX_WRITE_LOCK_WAIT_LABEL ? "write" : "read") + "\"" :
+                                 "endpoint=\"" + label_kv.first + "\"";
+            if(!is_overall) {
+                labels += ",collection=\"" + escape_prometheus_label(series_kv.first) + "\"";
+            }
+
+            const auto& histogram = series_kv.second->histogram;
+            histogram.snapshot(bucket_counts);
+
+            uint64_t cumulative_count = 0;
+            size_t bucket_index = 0;
+
+            for(const auto& bound: bucket_bounds) {
+                while(bucket_index < bucket_counts.size() &&
+                      latency_histogram_t::bucket_upper_bound(bucket_index) <= bound.second) {
+                    cumulative_count += bucket_counts[bucket_index++];
+                }
+
+                metrics += name + "_bucket{" + labels + ",le=\"" + bound.first + "\"} " +
+                           std::to_string(cumulative_count) + "\n";
+            }
+
+            while(bucket_index < bucket_counts.size()) {
+                cumulative_count += bucket_counts[bucket_index++];
+            }
+
+            metrics += name + "_bucket{" + labels + ",le=\"+Inf\"} " + std::to_string(cumulative_count) + "\n";
+            metrics += name + "_sum{" + labels + "} " + std::to_string(histogram.sum() / 1000000.0) + "\n";
+            metrics += name + "_count{" + labels + "} " + std::to_string(cumulative_count) + "\n";
+        }
+    }
+
+    result += "# HELP typesense_request_latency_seconds Latency of requests by endpoint.\n";
+    result += "# TYPE typesense_request_latency_seconds histogram\n";
+    result += overall_metrics;
+    result += "# HELP typesense_collection_request_latency_seconds Latency of requests by endpoint and collection.\n";
+    result += "# TYPE typesense_collection_request_latency_seconds histogram\n";
+    result += collection_metrics;
+    result += "# HELP typesense_index_lock_wait_seconds Time spent waiting for the lock of a collection's index.\n";
+    result += "# TYPE typesense_index_lock_wait_seconds histogram\n";
+    result += lock_wait_metrics;
+}
+
+void AppMetrics::append_write_queue_metrics(const nlohmann::json& coll_queue_stats, std::string& result) {
+    std::string depth_metrics, wait_metrics;
+
+    for(const auto& stats: coll_queue_stats.items()) {
+        const std::string labels = "{collection=\"" + escape_prometheus_label(stats.key()) + "\"} ";
+        depth_metrics += "typesense_write_queue_depth" + labels +
+                         std::to_string(stats.value()["queue_depth"].get<size_t>()) + "\n";
+        wait_metrics += "typesense_write_queue_oldest_wait_seconds" + labels +
+                        std::to_string(stats.value()["oldest_wait_ms"].get<uint64_t>() / 1000.0) + "\n";
+    }
+
+    result += "# HELP typesense_write_queue_depth Number of writes queued for a collection.\n";
+    result += "# TYPE typesense_write_queue_depth gauge\n";
+    result += depth_metrics;
+    result += "# HELP typesense_write_queue_oldest_wait_seconds Time for which the oldest queued write of a collection has waited.\n";
+    result += "# TYPE typesense_write_queue_oldest_wait_seconds gauge\n";
+    result += wait_metrics;
+}
+
 void AppMetrics::get(const std::string& rps_key, const std::string& latency_key, nlohmann::json& result) const {
     std::shared_lock lock(mutex);
 
@@ -117,16 +308,36 @@ void AppMetrics::window_reset() {
     delete durations;
     durations = current_durations;
     current_durations = new spp::sparse_hash_map<std::string, uint64_t>();
+
+    lock.unlock();
+
+    std::unique_lock latency_lock(latency_mutex);
+    std::vector<uint64_t> bucket_counts;
+
+    for(auto& label_kv: latency_series) {
+        for(auto& series_kv: label_kv.second) {
+            auto& series = *series_kv.second;
+            series.histogram.snapshot(bucket_counts);
+
+            for(size_t i = 0; i < bucket_counts.size(); i++) {
+                series.last_window_counts[i] = bucket_counts[i] - series.window_start_counts[i];
+            }
+
+            series.window_start_counts.swap(bucket_counts);
+        }
+    }
 }
 
 void AppMetrics::write_access_log(const uint64_t epoch_millis, const char* remote_ip, const std::string& path) {
     if(!access_log_path.empty()) {
+        std::unique_lock lock(access_log_mutex);
         access_log << epoch_millis << "\t" << remote_ip << "\t" << path << "\n";
     }
 }
 
 void AppMetrics::flush_access_log() {
     if(!access_log_path.empty()) {
+        std::unique_lock lock(access_log_mutex);
         access_log << std::flush;
     }
 }
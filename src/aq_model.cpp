@@ -1,8 +1,39 @@
 #include "vq_model.h"
+#include <chrono>
 #include <sstream>
+#include "tsconfig.h"
 #define DR_WAV_IMPLEMENTATION
 #include "dr_wav.h"
 
+Option<std::string> VQModel::transcribe(const std::string& audio_base64) {
+    const uint64_t audio_hash = StringUtils::hash_wy(audio_base64.data(), audio_base64.size());
+
+    {
+        std::unique_lock<std::mutex> lock(transcription_cache_mutex);
+        if(transcription_cache.contains(audio_hash)) {
+            num_cache_hits++;
+            return Option<std::string>(transcription_cache.lookup(audio_hash));
+        }
+    }
+
+    auto transcribe_op = transcribe_audio(audio_base64);
+    if(transcribe_op.ok()) {
+        std::unique_lock<std::mutex> lock(transcription_cache_mutex);
+        transcription_cache.insert(audio_hash, transcribe_op.get());
+    }
+
+    return transcribe_op;
+}
+
+void VQModel::add_metrics(metrics_t& metrics) const {
+    metrics.queued += num_queued;
+    metrics.running += num_running;
+    metrics.transcribed += num_transcribed;
+    metrics.cache_hits += num_cache_hits;
+    metrics.queue_time_us += queue_time_us;
+    metrics.transcribe_time_us += transcribe_time_us;
+}
+
 
 whisper_context* WhisperModel::validate_and_load_model(const std::string& model_path) {
     return whisper_init_from_file(model_path.c_str());                                                              
@@ -17,31 +48,85 @@ WhisperModel::WhisperModel(whisper_context* ctx, const std::string& model_name)
         params.language = "auto";
         params.detect_language = true;
     }
+
+    max_states = std::max<size_t>(1, Config::get_instance().get_voice_query_parallelism());
+    max_audio_frames = size_t(Config::get_instance().get_voice_query_max_audio_secs()) * WHISPER_SAMPLE_RATE;
 }
 
 WhisperModel::~WhisperModel() {
+    for(auto state: states) {
+        whisper_free_state(state);
+    }
+
     whisper_free(ctx);
 }
 
-bool WhisperModel::read_wav(const void* data, size_t size, std::vector<float>& pcmf32) {
+whisper_state* WhisperModel::acquire_state() {
+    std::unique_lock<std::mutex> lock(states_mutex);
+
+    if(idle_states.empty() && states.size() < max_states) {
+        whisper_state* state = whisper_init_state(ctx);
+        if(state != nullptr) {
+            states.push_back(state);
+            return state;
+        }
+
+        if(states.empty()) {
+            return nullptr;
+        }
+    }
+
+    if(idle_states.empty()) {
+        const auto wait_start = std::chrono::steady_clock::now();
+        num_queued++;
+        states_cv.wait(lock, [&]() { return !idle_states.empty(); });
+        num_queued--;
+        queue_time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - wait_start).count();
+    }
+
+    whisper_state* state = idle_states.back();
+    idle_states.pop_back();
+    return state;
+}
+
+void WhisperModel::release_state(whisper_state* state) {
+    {
+        std::unique_lock<std::mutex> lock(states_mutex);
+        idle_states.push_back(state);
+    }
+
+    states_cv.notify_one();
+}
+
+Option<bool> WhisperModel::read_wav(const void* data, size_t size, std::vector<float>& pcmf32) {
+    const Option<bool> invalid_format(400, "Invalid audio format. Please provide a 16-bit 16kHz wav file.");
+
     drwav wav;
     if(!drwav_init_memory(&wav, data, size, nullptr)) {
-        return false;
+        return invalid_format;
     }
 
     if(wav.channels != 1 && wav.channels != 2) {
         drwav_uninit(&wav);
-        return false;
+        return invalid_format;
     }
 
     if(wav.bitsPerSample != 16) {
         drwav_uninit(&wav);
-        return false;
+        return invalid_format;
     }
 
     if(wav.sampleRate != 16000) {
         drwav_uninit(&wav);
-        return false;
+        return invalid_format;
+    }
+
+    // the length is known from the header, before any of the samples are read
+    if(wav.totalPCMFrameCount > max_audio_frames) {
+        drwav_uninit(&wav);
+        return Option<bool>(400, "Audio is longer than the maximum of " +
+                                 std::to_string(max_audio_frames / WHISPER_SAMPLE_RATE) + " seconds.");
     }
 
     const uint64_t samples = wav.totalPCMFrameCount * wav.channels;
@@ -49,7 +134,8 @@ bool WhisperModel::read_wav(const void* data, size_t size, std::vector<float>& p
     drwav_read_pcm_frames_s16(&wav, wav.totalPCMFrameCount, pcmi16.data());
     drwav_uninit(&wav);
 
-    pcmf32.resize(samples);
+    // stereo is mixed down to a single channel
+    pcmf32.resize(wav.totalPCMFrameCount);
     if(wav.channels == 1) {
         for (uint64_t i = 0; i < wav.totalPCMFrameCount; i++) {
             pcmf32[i] = float(pcmi16[i]) / 32768.0f;
@@ -60,32 +146,44 @@ bool WhisperModel::read_wav(const void* data, size_t size, std::vector<float>& p
         }
     }
     
-    return true;
+    return Option<bool>(true);
 }
 
-Option<std::string> WhisperModel::transcribe(const std::string& audio_base64) {
+Option<std::string> WhisperModel::transcribe_audio(const std::string& audio_base64) {
     std::vector<float> pcmf32;
     // Decode audio
     auto raw_audio = StringUtils::base64_decode(audio_base64);
 
     // Read wav
-    auto res = read_wav(raw_audio.data(), raw_audio.size(), pcmf32);
-    if(!res) {
-        return Option<std::string>(400, "Invalid audio format. Please provide a 16-bit 16kHz wav file.");
+    auto read_op = read_wav(raw_audio.data(), raw_audio.size(), pcmf32);
+    if(!read_op.ok()) {
+        return Option<std::string>(read_op.code(), read_op.error());
     }
- 
-    {
-        std::unique_lock<std::mutex> lock(mutex);
-        if(whisper_full_parallel(ctx, params, pcmf32.data(), pcmf32.size(), 1) != 0) {
-            return Option<std::string>(400, "Error while transcribing.");
-        }
+
+    whisper_state* state = acquire_state();
+    if(state == nullptr) {
+        return Option<std::string>(500, "Could not allocate the state of the voice query model.");
+    }
+
+    num_running++;
+    const auto transcribe_start = std::chrono::steady_clock::now();
+
+    if(whisper_full_with_state(ctx, state, params, pcmf32.data(), pcmf32.size()) != 0) {
+        num_running--;
+        release_state(state);
+        return Option<std::string>(400, "Error while transcribing.");
     }
 
     std::stringstream ss;
-    for(int i = 0; i < whisper_full_n_segments(ctx); i++) {
-        ss << whisper_full_get_segment_text(ctx, i);
+    for(int i = 0; i < whisper_full_n_segments_from_state(state); i++) {
+        ss << whisper_full_get_segment_text_from_state(state, i);
     }
 
+    transcribe_time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - transcribe_start).count();
+    num_running--;
+    num_transcribed++;
+    release_state(state);
+
     return Option<std::string>(ss.str());
 }
-
@@ -162,6 +162,25 @@ void VQModelManager::clear_unused_models() {
     }
 }
 
+void VQModelManager::get_metrics(nlohmann::json& result) {
+    VQModel::metrics_t metrics;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(models_mutex);
+        for(const auto& kv: models) {
+            kv.second->add_metrics(metrics);
+        }
+    }
+
+    result["typesense_voice_query_queued"] = std::to_string(metrics.queued);
+    result["typesense_voice_query_running"] = std::to_string(metrics.running);
+    result["typesense_voice_query_transcribed"] = std::to_string(metrics.transcribed);
+    result["typesense_voice_query_cache_hits"] = std::to_string(metrics.cache_hits);
+    // summed over the voice queries that are transcribed side by side
+    result["typesense_voice_query_queue_time_ms"] = std::to_string(metrics.queue_time_us / 1000);
+    result["typesense_voice_query_transcribe_time_ms"] = std::to_string(metrics.transcribe_time_us / 1000);
+}
+
 const std::string VQModelManager::get_model_name_without_namespace(const std::string& model_name) {
     if(model_name.find("/") != std::string::npos) {
         return model_name.substr(model_name.find("/") + 1);
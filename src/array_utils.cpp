@@ -1,5 +1,13 @@
 #include "array_utils.h"
 #include <memory.h>
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <sse2neon.h>
+#endif
 
 size_t ArrayUtils::and_scalar(const uint32_t *A, const size_t lenA,
                               const uint32_t *B, const size_t lenB, uint32_t **results) {
@@ -102,6 +110,62 @@ size_t ArrayUtils::or_scalar(const uint32_t *A, const size_t lenA,
   return res_index;
 }
 
+size_t ArrayUtils::or_bitmap(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out) {
+    if(lenA == 0 || lenB == 0) {
+        const uint32_t* src = (lenA == 0) ? B : A;
+        const size_t len = (lenA == 0) ? lenB : lenA;
+        std::copy(src, src + len, out);
+        return len;
+    }
+
+    const uint32_t min = std::min(A[0], B[0]);
+    const uint32_t max = std::max(A[lenA - 1], B[lenB - 1]);
+    std::vector<uint64_t> words(size_t(max - min) / 64 + 1, 0);
+
+    for(size_t i = 0; i < lenA; i++) {
+        const uint32_t bit = A[i] - min;
+        words[bit / 64] |= (uint64_t(1) << (bit % 64));
+    }
+
+    for(size_t i = 0; i < lenB; i++) {
+        const uint32_t bit = B[i] - min;
+        words[bit / 64] |= (uint64_t(1) << (bit % 64));
+    }
+
+    size_t res_index = 0;
+
+    for(size_t i = 0; i < words.size(); i++) {
+        uint64_t word = words[i];
+        while(word != 0) {
+            out[res_index++] = min + i * 64 + __builtin_ctzll(word);
+            word &= word - 1;
+        }
+    }
+
+    return res_index;
+}
+
+size_t ArrayUtils::bitmap_to_array(const uint64_t *words, const size_t num_words, const uint32_t base,
+                                   uint32_t **out) {
+    size_t num_values = 0;
+    for(size_t i = 0; i < num_words; i++) {
+        num_values += __builtin_popcountll(words[i]);
+    }
+
+    *out = new uint32_t[num_values];
+    size_t res_index = 0;
+
+    for(size_t i = 0; i < num_words; i++) {
+        uint64_t word = words[i];
+        while(word != 0) {
+            (*out)[res_index++] = base + i * 64 + __builtin_ctzll(word);
+            word &= word - 1;
+        }
+    }
+
+    return num_values;
+}
+
 size_t ArrayUtils::exclude_scalar(const uint32_t *A, const size_t lenA,
                                  const uint32_t *B, const size_t lenB, uint32_t **out) {
   size_t indexA = 0, indexB = 0, res_index = 0;
@@ -178,4 +242,442 @@ bool ArrayUtils::skip_index_to_id(uint32_t& curr_index, uint32_t const* const ar
 
     curr_index = start;
     return false;
-}
\ No newline at end of file
+}
+
+// merges the remaining elements of the sorted inputs after the vectorized part is done
+static size_t and_scalar_tail(const uint32_t *A, size_t i, const size_t lenA,
+                              const uint32_t *B, size_t j, const size_t lenB, uint32_t *out, size_t k) {
+    while(i < lenA && j < lenB) {
+        if(A[i] < B[j]) {
+            i++;
+        } else if(A[i] > B[j]) {
+            j++;
+        } else {
+            out[k++] = A[i];
+            i++;
+            j++;
+        }
+    }
+
+    return k;
+}
+
+#if defined(__x86_64__) || defined(__aarch64__)
+// Compares a block of 4 values from each input against every rotation of the other, emitting the values of A that
+// are found in B, and then advances the block(s) with the smaller maximum.
+static size_t and_sse(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out) {
+    size_t i = 0, j = 0, k = 0;
+    const size_t st_a = (lenA / 4) * 4;
+    const size_t st_b = (lenB / 4) * 4;
+
+    while(i < st_a && j < st_b) {
+        const __m128i va = _mm_loadu_si128((const __m128i*)(A + i));
+        const __m128i vb = _mm_loadu_si128((const __m128i*)(B + j));
+
+        const __m128i cmp0 = _mm_cmpeq_epi32(va, vb);
+        const __m128i cmp1 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)));
+        const __m128i cmp2 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2)));
+        const __m128i cmp3 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)));
+        const __m128i cmp = _mm_or_si128(_mm_or_si128(cmp0, cmp1), _mm_or_si128(cmp2, cmp3));
+
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(cmp));
+        while(mask != 0) {
+            out[k++] = A[i + __builtin_ctz(mask)];
+            mask &= (mask - 1);
+        }
+
+        const uint32_t a_max = A[i + 3];
+        const uint32_t b_max = B[j + 3];
+
+        if(a_max <= b_max) {
+            i += 4;
+        }
+
+        if(b_max <= a_max) {
+            j += 4;
+        }
+    }
+
+    return and_scalar_tail(A, i, lenA, B, j, lenB, out, k);
+}
+#endif
+
+#if defined(__x86_64__)
+// Same scheme as `and_sse`, on blocks of 8 values.
+__attribute__((target("avx2")))
+static size_t and_avx2(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out) {
+    size_t i = 0, j = 0, k = 0;
+    const size_t st_a = (lenA / 8) * 8;
+    const size_t st_b = (lenB / 8) * 8;
+
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+
+    while(i < st_a && j < st_b) {
+        const __m256i va = _mm256_loadu_si256((const __m256i*)(A + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(B + j));
+
+        __m256i cmp = _mm256_cmpeq_epi32(va, vb);
+        for(size_t r = 1; r < 8; r++) {
+            vb = _mm256_permutevar8x32_epi32(vb, rotate);
+            cmp = _mm256_or_si256(cmp, _mm256_cmpeq_epi32(va, vb));
+        }
+
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(cmp));
+        while(mask != 0) {
+            out[k++] = A[i + __builtin_ctz(mask)];
+            mask &= (mask - 1);
+        }
+
+        const uint32_t a_max = A[i + 7];
+        const uint32_t b_max = B[j + 7];
+
+        if(a_max <= b_max) {
+            i += 8;
+        }
+
+        if(b_max <= a_max) {
+            j += 8;
+        }
+    }
+
+    return and_scalar_tail(A, i, lenA, B, j, lenB, out, k);
+}
+#endif
+
+// Index of the first value from `j` onwards that is not less than `target`, found by an exponential search, so
+// that looking up the values of a much smaller input costs O(small * log(large / small)) instead of a merge.
+static size_t gallop_to(const uint32_t *values, size_t j, const size_t len, const uint32_t target) {
+    if(j == len || values[j] >= target) {
+        return j;
+    }
+
+    // values[lo] < target, and values[hi] >= target when hi is within the input
+    size_t lo = j, hi = j + 1, step = 1;
+    while(hi < len && values[hi] < target) {
+        lo = hi;
+        step <<= 1;
+        hi = j + step;
+    }
+
+    return std::lower_bound(values + lo + 1, values + std::min(hi + 1, len), target) - values;
+}
+
+static size_t and_galloping(const uint32_t *small, const size_t len_small,
+                            const uint32_t *large, const size_t len_large, uint32_t *out) {
+    size_t j = 0, k = 0;
+
+    for(size_t i = 0; i < len_small; i++) {
+        const uint32_t target = small[i];
+
+        j = gallop_to(large, j, len_large, target);
+        if(j == len_large) {
+            break;
+        }
+
+        if(large[j] == target) {
+            out[k++] = target;
+            if(++j == len_large) {
+                break;
+            }
+        }
+    }
+
+    return k;
+}
+
+size_t ArrayUtils::and_simd(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out) {
+    if(lenA == 0 || lenB == 0) {
+        return 0;
+    }
+
+    if(lenA * GALLOPING_SIZE_RATIO < lenB) {
+        return and_galloping(A, lenA, B, lenB, out);
+    }
+
+    if(lenB * GALLOPING_SIZE_RATIO < lenA) {
+        return and_galloping(B, lenB, A, lenA, out);
+    }
+
+#if defined(__x86_64__)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if(has_avx2) {
+        return and_avx2(A, lenA, B, lenB, out);
+    }
+
+    return and_sse(A, lenA, B, lenB, out);
+#elif defined(__aarch64__)
+    return and_sse(A, lenA, B, lenB, out);
+#else
+    return and_scalar_tail(A, 0, lenA, B, 0, lenB, out, 0);
+#endif
+}
+
+// merges the remaining elements of the sorted inputs, skipping the values that were already emitted
+static size_t or_scalar_tail(const uint32_t *A, size_t i, const size_t lenA,
+                             const uint32_t *B, size_t j, const size_t lenB, uint32_t *out, size_t k) {
+    while(i < lenA || j < lenB) {
+        const uint32_t val = (j == lenB || (i < lenA && A[i] < B[j])) ? A[i++] : B[j++];
+        if(k == 0 || out[k - 1] != val) {
+            out[k++] = val;
+        }
+    }
+
+    return k;
+}
+
+#if defined(__x86_64__) || defined(__aarch64__)
+#if defined(__x86_64__)
+__attribute__((target("sse4.1")))
+#endif
+static inline __m128i rotate_lanes(const __m128i v) {
+    return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 3, 2, 1));
+}
+
+// Merges two sorted blocks of 4 values, leaving the 4 smallest values in `lo` and the 4 largest in `hi`, in order.
+#if defined(__x86_64__)
+__attribute__((target("sse4.1")))
+#endif
+static inline void merge_blocks(const __m128i a, const __m128i b, __m128i& lo, __m128i& hi) {
+    __m128i tmp = _mm_min_epu32(a, b);
+    hi = _mm_max_epu32(a, b);
+
+    for(size_t r = 0; r < 3; r++) {
+        tmp = rotate_lanes(tmp);
+        lo = _mm_min_epu32(tmp, hi);
+        hi = _mm_max_epu32(tmp, hi);
+        tmp = lo;
+    }
+
+    lo = rotate_lanes(tmp);
+}
+
+// Emits the values of a sorted block that differ from the value before them.
+#if defined(__x86_64__)
+__attribute__((target("sse4.1")))
+#endif
+static inline size_t emit_unique(const __m128i block, const __m128i prev_block, uint32_t *out, size_t k) {
+    const __m128i shifted = _mm_or_si128(_mm_slli_si128(block, 4), _mm_srli_si128(prev_block, 12));
+    int keep = ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, shifted))) & 0xF;
+    if(k == 0) {
+        keep |= 1;
+    }
+
+    uint32_t values[4];
+    _mm_storeu_si128((__m128i*) values, block);
+
+    while(keep != 0) {
+        out[k++] = values[__builtin_ctz(keep)];
+        keep &= (keep - 1);
+    }
+
+    return k;
+}
+
+// Merges blocks of 4 values through a min/max network, always taking the next block from the input whose next
+// value is smaller, so that the low half of each merge is final.
+#if defined(__x86_64__)
+__attribute__((target("sse4.1")))
+#endif
+static size_t or_sse(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out) {
+    if(lenA < 4 || lenB < 4) {
+        return or_scalar_tail(A, 0, lenA, B, 0, lenB, out, 0);
+    }
+
+    size_t i = 4, j = 4, k = 0;
+    __m128i lo, hi;
+    merge_blocks(_mm_loadu_si128((const __m128i*) A), _mm_loadu_si128((const __m128i*) B), lo, hi);
+    k = emit_unique(lo, _mm_setzero_si128(), out, k);
+    __m128i prev = lo;
+
+    while(i + 4 <= lenA && j + 4 <= lenB) {
+        __m128i next;
+        if(A[i] <= B[j]) {
+            next = _mm_loadu_si128((const __m128i*)(A + i));
+            i += 4;
+        } else {
+            next = _mm_loadu_si128((const __m128i*)(B + j));
+            j += 4;
+        }
+
+        merge_blocks(next, hi, lo, hi);
+        k = emit_unique(lo, prev, out, k);
+        prev = lo;
+    }
+
+    // the pending block is merged with the input that has less than a block left, and then with the other one
+    uint32_t pending[4];
+    _mm_storeu_si128((__m128i*) pending, hi);
+
+    uint32_t merged[8];
+    const bool a_is_short = (i + 4 > lenA);
+    const size_t num_merged = a_is_short ? or_scalar_tail(pending, 0, 4, A, i, lenA, merged, 0) :
+                                           or_scalar_tail(pending, 0, 4, B, j, lenB, merged, 0);
+
+    return a_is_short ? or_scalar_tail(merged, 0, num_merged, B, j, lenB, out, k) :
+                        or_scalar_tail(merged, 0, num_merged, A, i, lenA, out, k);
+}
+#endif
+
+// Copies the runs of the larger input that fall between the values of the smaller one.
+static size_t or_galloping(const uint32_t *small, const size_t len_small,
+                           const uint32_t *large, const size_t len_large, uint32_t *out) {
+    size_t j = 0, k = 0;
+
+    for(size_t i = 0; i < len_small; i++) {
+        const size_t next_j = gallop_to(large, j, len_large, small[i]);
+        std::copy(large + j, large + next_j, out + k);
+        k += next_j - j;
+        j = next_j;
+
+        if(j == len_large || large[j] != small[i]) {
+            out[k++] = small[i];
+        }
+    }
+
+    std::copy(large + j, large + len_large, out + k);
+    return k + (len_large - j);
+}
+
+size_t ArrayUtils::or_simd(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out) {
+    if(lenA * GALLOPING_SIZE_RATIO < lenB) {
+        return or_galloping(A, lenA, B, lenB, out);
+    }
+
+    if(lenB * GALLOPING_SIZE_RATIO < lenA) {
+        return or_galloping(B, lenB, A, lenA, out);
+    }
+
+#if defined(__x86_64__)
+    static const bool has_sse41 = __builtin_cpu_supports("sse4.1");
+    if(has_sse41) {
+        return or_sse(A, lenA, B, lenB, out);
+    }
+
+    return or_scalar_tail(A, 0, lenA, B, 0, lenB, out, 0);
+#elif defined(__aarch64__)
+    return or_sse(A, lenA, B, lenB, out);
+#else
+    return or_scalar_tail(A, 0, lenA, B, 0, lenB, out, 0);
+#endif
+}
+
+// Emits the remaining values of A that are not in B. The bits of `matched` mark values of the block at `i` that were
+// already found in B.
+static size_t exclude_scalar_tail(const uint32_t *A, const size_t i, const size_t lenA,
+                                  const uint32_t *B, size_t j, const size_t lenB, uint32_t *out, size_t k,
+                                  const int matched) {
+    for(size_t index = i; index < lenA; index++) {
+        if(index - i < 4 && (matched & (1 << (index - i))) != 0) {
+            continue;
+        }
+
+        while(j < lenB && B[j] < A[index]) {
+            j++;
+        }
+
+        if(j == lenB || B[j] != A[index]) {
+            out[k++] = A[index];
+        }
+    }
+
+    return k;
+}
+
+#if defined(__x86_64__) || defined(__aarch64__)
+// Same block comparison as `and_sse`. The matches of a block of A are collected until the block is passed, and then
+// the values that were not matched are emitted.
+static size_t exclude_sse(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB, uint32_t *out) {
+    size_t i = 0, j = 0, k = 0;
+    const size_t st_a = (lenA / 4) * 4;
+    const size_t st_b = (lenB / 4) * 4;
+    int matched = 0;
+
+    while(i < st_a && j < st_b) {
+        const __m128i va = _mm_loadu_si128((const __m128i*)(A + i));
+        const __m128i vb = _mm_loadu_si128((const __m128i*)(B + j));
+
+        const __m128i cmp0 = _mm_cmpeq_epi32(va, vb);
+        const __m128i cmp1 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)));
+        const __m128i cmp2 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2)));
+        const __m128i cmp3 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)));
+        const __m128i cmp = _mm_or_si128(_mm_or_si128(cmp0, cmp1), _mm_or_si128(cmp2, cmp3));
+        matched |= _mm_movemask_ps(_mm_castsi128_ps(cmp));
+
+        const uint32_t a_max = A[i + 3];
+        const uint32_t b_max = B[j + 3];
+
+        if(a_max <= b_max) {
+            int unmatched = ~matched & 0xF;
+            while(unmatched != 0) {
+                out[k++] = A[i + __builtin_ctz(unmatched)];
+                unmatched &= (unmatched - 1);
+            }
+
+            i += 4;
+            matched = 0;
+        }
+
+        if(b_max <= a_max) {
+            j += 4;
+        }
+    }
+
+    return exclude_scalar_tail(A, i, lenA, B, j, lenB, out, k, matched);
+}
+#endif
+
+// Copies the runs of A between the values of a much smaller B.
+static size_t exclude_galloping_small(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB,
+                                      uint32_t *out) {
+    size_t i = 0, k = 0;
+
+    for(size_t j = 0; j < lenB && i < lenA; j++) {
+        const size_t next_i = gallop_to(A, i, lenA, B[j]);
+        std::copy(A + i, A + next_i, out + k);
+        k += next_i - i;
+        i = next_i;
+
+        if(i < lenA && A[i] == B[j]) {
+            i++;
+        }
+    }
+
+    std::copy(A + i, A + lenA, out + k);
+    return k + (lenA - i);
+}
+
+// Looks up each value of A in a much larger B.
+static size_t exclude_galloping_large(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB,
+                                      uint32_t *out) {
+    size_t j = 0, k = 0;
+
+    for(size_t i = 0; i < lenA; i++) {
+        j = gallop_to(B, j, lenB, A[i]);
+        if(j == lenB || B[j] != A[i]) {
+            out[k++] = A[i];
+        }
+    }
+
+    return k;
+}
+
+size_t ArrayUtils::exclude_simd(const uint32_t *A, const size_t lenA, const uint32_t *B, const size_t lenB,
+                                uint32_t *out) {
+    if(lenA == 0) {
+        return 0;
+    }
+
+    if(lenB * GALLOPING_SIZE_RATIO < lenA) {
+        return exclude_galloping_small(A, lenA, B, lenB, out);
+    }
+
+    if(lenA * GALLOPING_SIZE_RATIO < lenB) {
+        return exclude_galloping_large(A, lenA, B, lenB, out);
+    }
+
+#if defined(__x86_64__) || defined(__aarch64__)
+    return exclude_sse(A, lenA, B, lenB, out);
+#else
+    return exclude_scalar_tail(A, 0, lenA, B, 0, lenB, out, 0, 0);
+#endif
+}
@@ -24,6 +24,9 @@
 #include "logger.h"
 #include "array_utils.h"
 #include "filter_result_iterator.h"
+#include "node_pool.h"
+#include "levenshtein_automaton.h"
+#include "lru/lru.hpp"
 
 /**
  * Macros to manipulate pointer tags
@@ -42,11 +45,10 @@
 
 #define USE_FREQUENCY_SCORE INT64_MIN
 
-enum recurse_progress { RECURSE, ABORT, ITERATE };
+// number of fuzzy search automata that every thread keeps around
+#define FUZZY_AUTOMATA_CACHE_SIZE 32
 
-static void art_fuzzy_recurse(unsigned char p, unsigned char c, const art_node *n, int depth, const unsigned char *term,
-                              const int term_len, const int* irow, const int* jrow, const int min_cost,
-                              const int max_cost, const bool prefix, std::vector<const art_node *> &results);
+enum recurse_progress { RECURSE, ABORT, ITERATE };
 
 void art_int_fuzzy_recurse(art_node *n, int depth, const unsigned char* int_str, int int_str_len,
                            NUM_COMPARATOR comparator, std::vector<const art_leaf *> &results);
@@ -103,24 +105,46 @@ bool compare_art_node_score_pq(const art_node* a, const art_node* b) {
     return !compare_art_node_score(a, b);
 }
 
+static constexpr size_t art_slot_size(size_t size) {
+    return (size + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+}
+
+/**
+ * Nodes and leaves of a tree are allocated from pools of fixed size slots, one per node type and per leaf
+ * size class. Nodes of a tree are packed together instead of being spread across the heap, and a node that
+ * grows or shrinks into another type hands its slot to the next node of that type instead of going back to the
+ * allocator. Leaves with keys too long for the largest class are allocated from the heap.
+ */
+struct art_node_pool {
+    node_pool_t<art_slot_size(sizeof(art_node4))> node4s;
+    node_pool_t<art_slot_size(sizeof(art_node16))> node16s;
+    node_pool_t<art_slot_size(sizeof(art_node48))> node48s;
+    node_pool_t<art_slot_size(sizeof(art_node256))> node256s;
+
+    node_pool_t<32> leaves32;
+    node_pool_t<48> leaves48;
+    node_pool_t<64> leaves64;
+    node_pool_t<96> leaves96;
+};
+
 /**
  * Allocates a node of the given type,
  * initializes to zero and sets the type.
  */
-static art_node* alloc_node(uint8_t type) {
+static art_node* alloc_node(art_tree *t, uint8_t type) {
     art_node* n;
     switch (type) {
         case NODE4:
-            n = (art_node *) calloc(1, sizeof(art_node4));
+            n = (art_node *) memset(t->pool->node4s.allocate(), 0, sizeof(art_node4));
             break;
         case NODE16:
-            n = (art_node *) calloc(1, sizeof(art_node16));
+            n = (art_node *) memset(t->pool->node16s.allocate(), 0, sizeof(art_node16));
             break;
         case NODE48:
-            n = (art_node *) calloc(1, sizeof(art_node48));
+            n = (art_node *) memset(t->pool->node48s.allocate(), 0, sizeof(art_node48));
             break;
         case NODE256:
-            n = (art_node *) calloc(1, sizeof(art_node256));
+            n = (art_node *) memset(t->pool->node256s.allocate(), 0, sizeof(art_node256));
             break;
         default:
             abort();
@@ -130,6 +154,55 @@ static art_node* alloc_node(uint8_t type) {
     return n;
 }
 
+static void free_node(art_tree *t, art_node *n) {
+    switch (n->type) {
+        case NODE4:
+            t->pool->node4s.deallocate(n);
+            break;
+        case NODE16:
+            t->pool->node16s.deallocate(n);
+            break;
+        case NODE48:
+            t->pool->node48s.deallocate(n);
+            break;
+        case NODE256:
+            t->pool->node256s.deallocate(n);
+            break;
+        default:
+            abort();
+    }
+}
+
+static art_leaf* alloc_leaf(art_tree *t, uint32_t key_len) {
+    const size_t size = sizeof(art_leaf) + key_len;
+    if (size <= 32) {
+        return (art_leaf *) t->pool->leaves32.allocate();
+    } else if (size <= 48) {
+        return (art_leaf *) t->pool->leaves48.allocate();
+    } else if (size <= 64) {
+        return (art_leaf *) t->pool->leaves64.allocate();
+    } else if (size <= 96) {
+        return (art_leaf *) t->pool->leaves96.allocate();
+    }
+
+    return (art_leaf *) malloc(size);
+}
+
+static void free_leaf(art_tree *t, art_leaf *l) {
+    const size_t size = sizeof(art_leaf) + l->key_len;
+    if (size <= 32) {
+        t->pool->leaves32.deallocate(l);
+    } else if (size <= 48) {
+        t->pool->leaves48.deallocate(l);
+    } else if (size <= 64) {
+        t->pool->leaves64.deallocate(l);
+    } else if (size <= 96) {
+        t->pool->leaves96.deallocate(l);
+    } else {
+        free(l);
+    }
+}
+
 /**
  * Initializes an ART tree
  * @return 0 on success.
@@ -137,11 +210,12 @@ static art_node* alloc_node(uint8_t type) {
 int art_tree_init(art_tree *t) {
     t->root = NULL;
     t->size = 0;
+    t->pool = new art_node_pool();
     return 0;
 }
 
 // Recursively destroys the tree
-static void destroy_node(art_node *n) {
+static void destroy_node(art_tree *t, art_node *n) {
     // Break if null
     if (!n) return;
 
@@ -149,7 +223,7 @@ static void destroy_node(art_node *n) {
     if (IS_LEAF(n)) {
         art_leaf *leaf = (art_leaf *) LEAF_RAW(n);
         posting_t::destroy_list(leaf->values);
-        free(leaf);
+        free_leaf(t, leaf);
         return;
     }
 
@@ -165,21 +239,21 @@ static void destroy_node(art_node *n) {
         case NODE4:
             p.p1 = (art_node4*)n;
             for (i=0;i<n->num_children;i++) {
-                destroy_node(p.p1->children[i]);
+                destroy_node(t, p.p1->children[i]);
             }
             break;
 
         case NODE16:
             p.p2 = (art_node16*)n;
             for (i=0;i<n->num_children;i++) {
-                destroy_node(p.p2->children[i]);
+                destroy_node(t, p.p2->children[i]);
             }
             break;
 
         case NODE48:
             p.p3 = (art_node48*)n;
             for (i=0;i<48;i++) {
-                destroy_node(p.p3->children[i]);
+                destroy_node(t, p.p3->children[i]);
             }
             break;
 
@@ -187,7 +261,7 @@ static void destroy_node(art_node *n) {
             p.p4 = (art_node256*)n;
             for (i=0;i<256;i++) {
                 if (p.p4->children[i])
-                    destroy_node(p.p4->children[i]);
+                    destroy_node(t, p.p4->children[i]);
             }
             break;
 
@@ -196,7 +270,7 @@ static void destroy_node(art_node *n) {
     }
 
     // Free ourself on the way up
-    free(n);
+    free_node(t, n);
 }
 
 /**
@@ -204,7 +278,9 @@ static void destroy_node(art_node *n) {
  * @return 0 on success.
  */
 int art_tree_destroy(art_tree *t) {
-    destroy_node(t->root);
+    destroy_node(t, t->root);
+    delete t->pool;
+    t->pool = NULL;
     return 0;
 }
 
@@ -432,8 +508,34 @@ static void add_document_to_leaf(art_document *document, art_leaf *leaf) {
     }
 }
 
-static art_leaf* make_leaf(const unsigned char *key, uint32_t key_len, art_document *document) {
-    art_leaf *l = (art_leaf *) malloc(sizeof(art_leaf) + key_len);
+// Adds the documents from `begin` onwards to the leaf, with one merge per block of its posting list that they touch.
+static void add_documents_to_leaf(std::vector<art_document>& documents, size_t begin, art_leaf *leaf) {
+    if(begin >= documents.size()) {
+        return;
+    }
+
+    if(documents.size() - begin == 1) {
+        add_document_to_leaf(&documents[begin], leaf);
+        return;
+    }
+
+    std::vector<id_offsets_t> postings;
+    postings.reserve(documents.size() - begin);
+
+    for(size_t i = begin; i < documents.size(); i++) {
+        leaf->max_score = MAX(leaf->max_score, documents[i].score);
+        postings.emplace_back(documents[i].id, &documents[i].offsets);
+    }
+
+    posting_t::upsert_many(leaf->values, postings);
+
+    if(documents.back().score == USE_FREQUENCY_SCORE) {
+        leaf->max_score = posting_t::num_ids(leaf->values);
+    }
+}
+
+static art_leaf* make_leaf(art_tree *t, const unsigned char *key, uint32_t key_len, art_document *document) {
+    art_leaf *l = alloc_leaf(t, key_len);
     l->key_len = key_len;
     l->max_score = document->score;
 
@@ -472,14 +574,14 @@ static void copy_header(art_node *dest, art_node *src) {
     memcpy(dest->partial, src->partial, min(MAX_PREFIX_LEN, src->partial_len));
 }
 
-static void add_child256(art_node256 *n, art_node **ref, unsigned char c, void *child) {
+static void add_child256(art_tree *t, art_node256 *n, art_node **ref, unsigned char c, void *child) {
     (void)ref;
     n->n.num_children++;
     n->children[c] = (art_node *) child;
     n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
 }
 
-static void add_child48(art_node48 *n, art_node **ref, unsigned char c, void *child) {
+static void add_child48(art_tree *t, art_node48 *n, art_node **ref, unsigned char c, void *child) {
     if (n->n.num_children < 48) {
         int pos = 0;
         while (n->children[pos]) pos++;
@@ -488,7 +590,7 @@ static void add_child48(art_node48 *n, art_node **ref, unsigned char c, void *ch
         n->n.num_children++;
         n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
     } else {
-        art_node256 *new_n = (art_node256*)alloc_node(NODE256);
+        art_node256 *new_n = (art_node256*)alloc_node(t, NODE256);
         for (int i=0;i<256;i++) {
             if (n->keys[i]) {
                 new_n->children[i] = n->children[n->keys[i] - 1];
@@ -496,12 +598,12 @@ static void add_child48(art_node48 *n, art_node **ref, unsigned char c, void *ch
         }
         copy_header((art_node*)new_n, (art_node*)n);
         *ref = (art_node*)new_n;
-        free(n);
-        add_child256(new_n, ref, c, child);
+        free_node(t, (art_node*)n);
+        add_child256(t, new_n, ref, c, child);
     }
 }
 
-static void add_child16(art_node16 *n, art_node **ref, unsigned char c, void *child) {
+static void add_child16(art_tree *t, art_node16 *n, art_node **ref, unsigned char c, void *child) {
     if (n->n.num_children < 16) {
         __m128i cmp;
 
@@ -530,7 +632,7 @@ static void add_child16(art_node16 *n, art_node **ref, unsigned char c, void *ch
         n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
 
     } else {
-        art_node48 *new_n = (art_node48*)alloc_node(NODE48);
+        art_node48 *new_n = (art_node48*)alloc_node(t, NODE48);
 
         // Copy the child pointers and populate the key map
         memcpy(new_n->children, n->children,
@@ -540,12 +642,12 @@ static void add_child16(art_node16 *n, art_node **ref, unsigned char c, void *ch
         }
         copy_header((art_node*)new_n, (art_node*)n);
         *ref = (art_node*)new_n;
-        free(n);
-        add_child48(new_n, ref, c, child);
+        free_node(t, (art_node*)n);
+        add_child48(t, new_n, ref, c, child);
     }
 }
 
-static void add_child4(art_node4 *n, art_node **ref, unsigned char c, void *child) {
+static void add_child4(art_tree *t, art_node4 *n, art_node **ref, unsigned char c, void *child) {
     if (n->n.num_children < 4) {
         int idx;
         for (idx=0; idx < n->n.num_children; idx++) {
@@ -563,7 +665,7 @@ static void add_child4(art_node4 *n, art_node **ref, unsigned char c, void *chil
         n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
 
     } else {
-        art_node16 *new_n = (art_node16*)alloc_node(NODE16);
+        art_node16 *new_n = (art_node16*)alloc_node(t, NODE16);
 
         // Copy the child pointers and the key map
         memcpy(new_n->children, n->children,
@@ -572,21 +674,21 @@ static void add_child4(art_node4 *n, art_node **ref, unsigned char c, void *chil
                 sizeof(unsigned char)*n->n.num_children);
         copy_header((art_node*)new_n, (art_node*)n);
         *ref = (art_node*)new_n;
-        free(n);
-        add_child16(new_n, ref, c, child);
+        free_node(t, (art_node*)n);
+        add_child16(t, new_n, ref, c, child);
     }
 }
 
-static void add_child(art_node *n, art_node **ref, unsigned char c, void *child) {
+static void add_child(art_tree *t, art_node *n, art_node **ref, unsigned char c, void *child) {
     switch (n->type) {
         case NODE4:
-            return add_child4((art_node4*)n, ref, c, child);
+            return add_child4(t, (art_node4*)n, ref, c, child);
         case NODE16:
-            return add_child16((art_node16*)n, ref, c, child);
+            return add_child16(t, (art_node16*)n, ref, c, child);
         case NODE48:
-            return add_child48((art_node48*)n, ref, c, child);
+            return add_child48(t, (art_node48*)n, ref, c, child);
         case NODE256:
-            return add_child256((art_node256*)n, ref, c, child);
+            return add_child256(t, (art_node256*)n, ref, c, child);
         default:
             abort();
     }
@@ -616,15 +718,13 @@ static int prefix_mismatch(const art_node *n, const unsigned char *key, int key_
     return idx;
 }
 
-static void* recursive_insert(art_node* n, art_node** ref, const unsigned char* key, uint32_t key_len,
+static void* recursive_insert(art_tree *t, art_node* n, art_node** ref, const unsigned char* key, uint32_t key_len,
                               const int64_t docs_max_score, std::vector<art_document>& documents, int depth,
                               std::list<art_node*>& path, int* old) {
     // If we are at a NULL node, inject a leaf
     if (!n) {
-        art_leaf* new_leaf = make_leaf(key, key_len, &documents[0]);
-        for(size_t i = 1; i < documents.size(); i++) {
-            add_document_to_leaf(&documents[i], new_leaf);
-        }
+        art_leaf* new_leaf = make_leaf(t, key, key_len, &documents[0]);
+        add_documents_to_leaf(documents, 1, new_leaf);
 
         *ref = (art_node*)SET_LEAF(new_leaf);
         return NULL;
@@ -637,30 +737,26 @@ static void* recursive_insert(art_node* n, art_node** ref, const unsigned char*
         // Check if we are updating an existing value
         if (!leaf_matches(l, key, key_len, depth)) {
             *old = 1;
-            for(size_t i = 0; i < documents.size(); i++) {
-                add_document_to_leaf(&documents[i], l);
-            }
+            add_documents_to_leaf(documents, 0, l);
             return l->values;
         }
 
         // New value, we must split the leaf into a node4
-        art_node4 *new_n = (art_node4*)alloc_node(NODE4);
+        art_node4 *new_n = (art_node4*)alloc_node(t, NODE4);
 
         // Create a new leaf
-        art_leaf *l2 = make_leaf(key, key_len, &documents[0]);
+        art_leaf *l2 = make_leaf(t, key, key_len, &documents[0]);
 
         uint32_t longest_prefix = longest_common_prefix(l, l2, depth);
         new_n->n.partial_len = longest_prefix;
         memcpy(new_n->n.partial, key+depth, min(MAX_PREFIX_LEN, longest_prefix));
 
-        for(size_t i = 1; i < documents.size(); i++) {
-            add_document_to_leaf(&documents[i], l2);
-        }
+        add_documents_to_leaf(documents, 1, l2);
 
         // Add the leafs to the new node4
         *ref = (art_node*)new_n;
-        add_child4(new_n, ref, l->key[depth+longest_prefix], SET_LEAF(l));
-        add_child4(new_n, ref, l2->key[depth+longest_prefix], SET_LEAF(l2));
+        add_child4(t, new_n, ref, l->key[depth+longest_prefix], SET_LEAF(l));
+        add_child4(t, new_n, ref, l2->key[depth+longest_prefix], SET_LEAF(l2));
         return NULL;
     }
 
@@ -678,32 +774,30 @@ static void* recursive_insert(art_node* n, art_node** ref, const unsigned char*
         }
 
         // Create a new node
-        art_node4 *new_n = (art_node4*)alloc_node(NODE4);
+        art_node4 *new_n = (art_node4*)alloc_node(t, NODE4);
         *ref = (art_node*)new_n;
         new_n->n.partial_len = prefix_diff;
         memcpy(new_n->n.partial, n->partial, min(MAX_PREFIX_LEN, prefix_diff));
 
         // Adjust the prefix of the old node
         if (n->partial_len <= MAX_PREFIX_LEN) {
-            add_child4(new_n, ref, n->partial[prefix_diff], n);
+            add_child4(t, new_n, ref, n->partial[prefix_diff], n);
             n->partial_len -= (prefix_diff+1);
             memmove(n->partial, n->partial+prefix_diff+1,
                     min(MAX_PREFIX_LEN, n->partial_len));
         } else {
             n->partial_len -= (prefix_diff+1);
             art_leaf *l = minimum(n);
-            add_child4(new_n, ref, l->key[depth+prefix_diff], n);
+            add_child4(t, new_n, ref, l->key[depth+prefix_diff], n);
             memcpy(n->partial, l->key+depth+prefix_diff+1,
                    min(MAX_PREFIX_LEN, n->partial_len));
         }
 
         // Insert the new leaf
-        art_leaf *l = make_leaf(key, key_len, &documents[0]);
-        for(size_t i = 1; i < documents.size(); i++) {
-            add_document_to_leaf(&documents[i], l);
-        }
+        art_leaf *l = make_leaf(t, key, key_len, &documents[0]);
+        add_documents_to_leaf(documents, 1, l);
 
-        add_child4(new_n, ref, key[depth+prefix_diff], SET_LEAF(l));
+        add_child4(t, new_n, ref, key[depth+prefix_diff], SET_LEAF(l));
         path.push_back(*ref);
         return NULL;
     }
@@ -713,16 +807,14 @@ static void* recursive_insert(art_node* n, art_node** ref, const unsigned char*
     // Find a child to recurse to
     art_node **child = find_child(n, key[depth]);
     if (child) {
-        return recursive_insert(*child, child, key, key_len, docs_max_score, documents, depth + 1, path, old);
+        return recursive_insert(t, *child, child, key, key_len, docs_max_score, documents, depth + 1, path, old);
     }
 
     // No child, node goes within us
-    art_leaf *l = make_leaf(key, key_len, &documents[0]);
-    for(size_t i = 1; i < documents.size(); i++) {
-        add_document_to_leaf(&documents[i], l);
-    }
+    art_leaf *l = make_leaf(t, key, key_len, &documents[0]);
+    add_documents_to_leaf(documents, 1, l);
 
-    add_child(n, ref, key[depth], SET_LEAF(l));
+    add_child(t, n, ref, key[depth], SET_LEAF(l));
     path.push_back(*ref);
     return NULL;
 }
@@ -747,7 +839,7 @@ void* art_inserts(art_tree *t, const unsigned char *key, int key_len, const int6
 
     std::list<art_node*> path;
     bool frequency_based_ordering = (docs_max_score == USE_FREQUENCY_SCORE);
-    void *old = recursive_insert(t->root, &t->root, key, key_len, docs_max_score, documents, 0, path, &old_val);
+    void *old = recursive_insert(t, t->root, &t->root, key, key_len, docs_max_score, documents, 0, path, &old_val);
     if (!old_val) t->size++;
 
     if(frequency_based_ordering) {
@@ -759,14 +851,118 @@ void* art_inserts(art_tree *t, const unsigned char *key, int key_len, const int6
     return old;
 }
 
-static void remove_child256(art_node256 *n, art_node **ref, unsigned char c) {
+// Builds the subtree of the keys in [begin, end), which share their first `depth` bytes, bottom-up.
+static art_node* build_subtree(art_tree *t, std::vector<std::pair<std::string, std::vector<art_document>>>& keys_documents,
+                               size_t begin, size_t end, uint32_t depth, const int64_t docs_max_score) {
+    if (end - begin == 1) {
+        const std::string& key = keys_documents[begin].first;
+        std::vector<art_document>& documents = keys_documents[begin].second;
+
+        art_leaf* l = make_leaf(t, (const unsigned char *) key.c_str(), key.size() + 1, &documents[0]);
+        add_documents_to_leaf(documents, 1, l);
+
+        return (art_node*)SET_LEAF(l);
+    }
+
+    // the keys are sorted, so the prefix common to the first and the last key is common to all of them
+    const unsigned char* first_key = (const unsigned char *) keys_documents[begin].first.c_str();
+    const unsigned char* last_key = (const unsigned char *) keys_documents[end - 1].first.c_str();
+    uint32_t prefix_len = 0;
+    while (first_key[depth + prefix_len] == last_key[depth + prefix_len]) {
+        prefix_len++;
+    }
+
+    const uint32_t child_depth = depth + prefix_len;
+
+    size_t num_children = 0;
+    for (size_t i = begin; i < end; i++) {
+        if (i == begin || keys_documents[i].first.c_str()[child_depth] != keys_documents[i - 1].first.c_str()[child_depth]) {
+            num_children++;
+        }
+    }
+
+    uint8_t type = (num_children <= 4) ? NODE4 : (num_children <= 16) ? NODE16 : (num_children <= 48) ? NODE48 : NODE256;
+    art_node* n = alloc_node(t, type);
+    n->partial_len = prefix_len;
+    memcpy(n->partial, first_key + depth, min(MAX_PREFIX_LEN, prefix_len));
+    if (docs_max_score != USE_FREQUENCY_SCORE) {
+        n->max_score = docs_max_score;
+    }
+
+    size_t child_begin = begin;
+    int child_index = 0;
+    while (child_begin < end) {
+        const unsigned char c = keys_documents[child_begin].first.c_str()[child_depth];
+        size_t child_end = child_begin + 1;
+        while (child_end < end && (unsigned char) keys_documents[child_end].first.c_str()[child_depth] == c) {
+            child_end++;
+        }
+
+        art_node* child = build_subtree(t, keys_documents, child_begin, child_end, child_depth + 1, docs_max_score);
+        const int64_t child_max_score = IS_LEAF(child) ? ((art_leaf *) LEAF_RAW(child))->max_score : child->max_score;
+        n->max_score = MAX(n->max_score, child_max_score);
+
+        // children are added in key order, which keeps the keys of node4/node16 sorted
+        switch (type) {
+            case NODE4:
+                ((art_node4*)n)->keys[child_index] = c;
+                ((art_node4*)n)->children[child_index] = child;
+                break;
+            case NODE16:
+                ((art_node16*)n)->keys[child_index] = c;
+                ((art_node16*)n)->children[child_index] = child;
+                break;
+            case NODE48:
+                ((art_node48*)n)->keys[c] = child_index + 1;
+                ((art_node48*)n)->children[child_index] = child;
+                break;
+            default:
+                ((art_node256*)n)->children[c] = child;
+                break;
+        }
+
+        child_index++;
+        child_begin = child_end;
+    }
+
+    n->num_children = num_children;
+    return n;
+}
+
+void art_bulk_insert(art_tree *t, std::vector<std::pair<std::string, std::vector<art_document>>>& keys_documents,
+                     const int64_t docs_max_score) {
+    if (keys_documents.empty()) {
+        return;
+    }
+
+    std::sort(keys_documents.begin(), keys_documents.end(),
+              [](const std::pair<std::string, std::vector<art_document>>& a,
+                 const std::pair<std::string, std::vector<art_document>>& b) {
+        return a.first < b.first;
+    });
+
+    if (t->root != NULL) {
+        // inserting in key order keeps the path walked by consecutive keys in cache
+        for (auto& key_documents: keys_documents) {
+            const auto *key = (const unsigned char *) key_documents.first.c_str();
+            art_inserts(t, key, key_documents.first.size() + 1, docs_max_score, key_documents.second);
+        }
+
+        return;
+    }
+
+    t->root = build_subtree(t, keys_documents, 0, keys_documents.size(), 0, docs_max_score);
+    t->size = keys_documents.size();
+}
+
+static void remove_child256(art_tree *t, art_node256 *n, art_node **ref, unsigned char c) {
     n->children[c] = NULL;
     n->n.num_children--;
 
     // Resize to a node48 on underflow, not immediately to prevent
     // trashing if we sit on the 48/49 boundary
     if (n->n.num_children == 37) {
-        art_node48 *new_n = (art_node48*)alloc_node(NODE48);
+        art_node48 *new_n = (art_node48*)alloc_node(t, NODE48);
         *ref = (art_node*)new_n;
         copy_header((art_node*)new_n, (art_node*)n);
 
@@ -778,18 +974,18 @@ static void remove_child256(art_node256 *n, art_node **ref, unsigned char c) {
                 pos++;
             }
         }
-        free(n);
+        free_node(t, (art_node*)n);
     }
 }
 
-static void remove_child48(art_node48 *n, art_node **ref, unsigned char c) {
+static void remove_child48(art_tree *t, art_node48 *n, art_node **ref, unsigned char c) {
     int pos = n->keys[c];
     n->keys[c] = 0;
     n->children[pos-1] = NULL;
     n->n.num_children--;
 
     if (n->n.num_children == 12) {
-        art_node16 *new_n = (art_node16*)alloc_node(NODE16);
+        art_node16 *new_n = (art_node16*)alloc_node(t, NODE16);
         *ref = (art_node*)new_n;
         copy_header((art_node*)new_n, (art_node*)n);
 
@@ -802,27 +998,27 @@ static void remove_child48(art_node48 *n, art_node **ref, unsigned char c) {
                 child++;
             }
         }
-        free(n);
+        free_node(t, (art_node*)n);
     }
 }
 
-static void remove_child16(art_node16 *n, art_node **ref, art_node **l) {
+static void remove_child16(art_tree *t, art_node16 *n, art_node **ref, art_node **l) {
     int pos = l - n->children;
     memmove(n->keys+pos, n->keys+pos+1, n->n.num_children - 1 - pos);
     memmove(n->children+pos, n->children+pos+1, (n->n.num_children - 1 - pos)*sizeof(void*));
     n->n.num_children--;
 
     if (n->n.num_children == 3) {
-        art_node4 *new_n = (art_node4*)alloc_node(NODE4);
+        art_node4 *new_n = (art_node4*)alloc_node(t, NODE4);
         *ref = (art_node*)new_n;
         copy_header((art_node*)new_n, (art_node*)n);
         memcpy(new_n->keys, n->keys, 4);
         memcpy(new_n->children, n->children, 4*sizeof(void*));
-        free(n);
+        free_node(t, (art_node*)n);
     }
 }
 
-static void remove_child4(art_node4 *n, art_node **ref, art_node **l) {
+static void remove_child4(art_tree *t, art_node4 *n, art_node **ref, art_node **l) {
     int pos = l - n->children;
     memmove(n->keys+pos, n->keys+pos+1, n->n.num_children - 1 - pos);
     memmove(n->children+pos, n->children+pos+1, (n->n.num_children - 1 - pos)*sizeof(void*));
@@ -849,26 +1045,26 @@ static void remove_child4(art_node4 *n, art_node **ref, art_node **l) {
             child->partial_len += n->n.partial_len + 1;
         }
         *ref = child;
-        free(n);
+        free_node(t, (art_node*)n);
     }
 }
 
-static void remove_child(art_node *n, art_node **ref, unsigned char c, art_node **l) {
+static void remove_child(art_tree *t, art_node *n, art_node **ref, unsigned char c, art_node **l) {
     switch (n->type) {
         case NODE4:
-            return remove_child4((art_node4*)n, ref, l);
+            return remove_child4(t, (art_node4*)n, ref, l);
         case NODE16:
-            return remove_child16((art_node16*)n, ref, l);
+            return remove_child16(t, (art_node16*)n, ref, l);
         case NODE48:
-            return remove_child48((art_node48*)n, ref, c);
+            return remove_child48(t, (art_node48*)n, ref, c);
         case NODE256:
-            return remove_child256((art_node256*)n, ref, c);
+            return remove_child256(t, (art_node256*)n, ref, c);
         default:
             abort();
     }
 }
 
-static art_leaf* recursive_delete(art_node *n, art_node **ref, const unsigned char *key, int key_len, int depth) {
+static art_leaf* recursive_delete(art_tree *t, art_node *n, art_node **ref, const unsigned char *key, int key_len, int depth) {
     // Search terminated
     if (!n) return NULL;
 
@@ -904,14 +1100,14 @@ static art_leaf* recursive_delete(art_node *n, art_node **ref, const unsigned ch
     if (IS_LEAF(*child)) {
         art_leaf *l = (art_leaf *) LEAF_RAW(*child);
         if (!leaf_matches(l, key, key_len, depth)) {
-            remove_child(n, ref, key[depth], child);
+            remove_child(t, n, ref, key[depth], child);
             return l;
         }
         return NULL;
 
         // Recurse
     } else {
-        return recursive_delete(*child, child, key, key_len, depth+1);
+        return recursive_delete(t, *child, child, key, key_len, depth+1);
     }
 }
 
@@ -924,11 +1120,11 @@ static art_leaf* recursive_delete(art_node *n, art_node **ref, const unsigned ch
  * the value pointer is returned.
  */
 void* art_delete(art_tree *t, const unsigned char *key, int key_len) {
-    art_leaf *l = recursive_delete(t->root, &t->root, key, key_len, 0);
+    art_leaf *l = recursive_delete(t, t->root, &t->root, key, key_len, 0);
     if (l) {
         t->size--;
         void *old = l->values;
-        free(l);
+        free_leaf(t, l);
         return old;
     }
     return NULL;
@@ -1403,38 +1599,9 @@ void print_row(const int* row, const int row_len) {
     printf("\n");
 }
 
-static inline void copyIntArray2(const int *src, int *dest, const int len) {
-    for(int t=0; t<len; t++) {
-        dest[t] = src[t];
-    }
-}
-
-static inline void levenshtein_dist(const int depth, const unsigned char p, const unsigned char c,
-                                    const unsigned char* term, const int term_len,
-                                    const int* irow, const int* jrow, int* krow) {
-    krow[0] = jrow[0] + 1;
-
-    // Calculate levenshtein distance incrementally (term => b, column => j, c => a[i], p => a[i-1], irow => d[i-1]):
-    // https://en.wikipedia.org/wiki/Damerau%E2%80%93Levenshtein_distance#Optimal_string_alignment_distance
-
-    for(int column=1; column<=term_len; column++) {
-        int cost = (c == term[column-1]) ? 0 : 1;  // column-1 used because of zero-based char array
-
-        int delete_cost = jrow[column] + 1;
-        int insert_cost = krow[column - 1] + 1;
-        int substitution_cost = jrow[column - 1] + cost;
-
-        krow[column] = min(min(insert_cost, delete_cost), substitution_cost);
-
-        if(depth > 1 && column > 1 && c == term[column-1-1] && p == term[column-1]) {
-            krow[column] = std::min(krow[column], irow[column-2] + 1);
-        }
-    }
-}
-
-static inline void art_fuzzy_children(unsigned char p, const art_node *n, int depth, const unsigned char *term, const int term_len,
-                                      const int* irow, const int* jrow, const int min_cost, const int max_cost,
-                                      const bool prefix, std::vector<const art_node *> &results) {
+// Calls `visit(child_char, child)` on the children of `n`, from the last one to the first one.
+template<class F>
+static inline void art_fuzzy_children(const art_node *n, F&& visit) {
     char child_char;
     art_node* child;
 
@@ -1443,18 +1610,18 @@ static inline void art_fuzzy_children(unsigned char p, const art_node *n, int de
             printf("\nNODE4\n");
             for (int i=n->num_children-1; i >= 0; i--) {
                 child_char = ((art_node4*)n)->keys[i];
-                printf("4!child_char: %c, %d, depth: %d\n", child_char, child_char, depth);
+                printf("4!child_char: %c, %d\n", child_char, child_char);
                 child = ((art_node4*)n)->children[i];
-                art_fuzzy_recurse(p, child_char, child, depth, term, term_len, irow, jrow, min_cost, max_cost, prefix, results);
+                visit(child_char, child);
             }
             break;
         case NODE16:
             printf("\nNODE16\n");
             for (int i=n->num_children-1; i >= 0; i--) {
                 child_char = ((art_node16*)n)->keys[i];
-                printf("16!child_char: %c, depth: %d\n", child_char, depth);
+                printf("16!child_char: %c\n", child_char);
                 child = ((art_node16*)n)->children[i];
-                art_fuzzy_recurse(p, child_char, child, depth, term, term_len, irow, jrow, min_cost, max_cost, prefix, results);
+                visit(child_char, child);
             }
             break;
         case NODE48:
@@ -1464,8 +1631,8 @@ static inline void art_fuzzy_children(unsigned char p, const art_node *n, int de
                 if (!ix) continue;
                 child = ((art_node48*)n)->children[ix - 1];
                 child_char = (char)i;
-                printf("48!child_char: %c, depth: %d, ix: %d\n", child_char, depth, ix);
-                art_fuzzy_recurse(p, child_char, child, depth, term, term_len, irow, jrow, min_cost, max_cost, prefix, results);
+                printf("48!child_char: %c, ix: %d\n", child_char, ix);
+                visit(child_char, child);
             }
             break;
         case NODE256:
@@ -1473,9 +1640,9 @@ static inline void art_fuzzy_children(unsigned char p, const art_node *n, int de
             for (int i=255; i >= 0; i--) {
                 if (!((art_node256*)n)->children[i]) continue;
                 child_char = (char) i;
-                printf("256!child_char: %c, depth: %d\n", child_char, depth);
+                printf("256!child_char: %c\n", child_char);
                 child = ((art_node256*)n)->children[i];
-                art_fuzzy_recurse(p, child_char, child, depth, term, term_len, irow, jrow, min_cost, max_cost, prefix, results);
+                visit(child_char, child);
             }
             break;
         default:
@@ -1483,156 +1650,39 @@ static inline void art_fuzzy_children(unsigned char p, const art_node *n, int de
     }
 }
 
-static inline void rotate(int &i, int &j, int &k) {
-    int old_i = i;
-    i = j;
-    j = k;
-    k = old_i;
-}
-
-// -1: return without adding, 0 : continue iteration, 1: return after adding
-static inline int fuzzy_search_state(const bool prefix, int key_index, unsigned char p, unsigned char c,
-                                     const unsigned char* query, const int query_len,
-                                     const int* cost_row, int min_cost, int max_cost) {
-
-    // There are 2 scenarios:
-    // a) key_len < query_len: "pltninum" (query) on "pst" (key)
-    // b) query_len < key_len: "pst" (query) on "pltninum" (key)
-
-    bool last_key_char = (c == '\0');
-    int key_len = last_key_char ? key_index : key_index + 1;
-
-    if(last_key_char) {
-        // Last char, so have to return 1 or -1
-        if(cost_row[query_len] >= min_cost && cost_row[query_len] <= max_cost) {
-            return 1;
-        }
-
-        // Special case used to match q=strawberries on key=strawberry (query_len > key_len)
-        // but limit to larger keys to prevent eager matches
-        if(key_len > 5 && query_len > key_len && (query_len - key_len) <= max_cost &&
-           cost_row[key_len] >= min_cost && cost_row[key_len] <= max_cost-1) {
-            return 1;
-        }
-
-        return -1;
-    }
-
-    // `key_len` can't exceed `query_len` since length of `cost_row` is `query_len + 1`
-    int cost = cost_row[std::min(key_len, query_len)];
-
-    if(key_len >= query_len && prefix) {
-        // Case b)
-        // For prefix queries
-        // - we can return early if key_len reaches query_len and cost is within bounds.
-        // - might have to iterate past prefix query length to catch trailing typos.
-        if(cost >= min_cost && cost <= max_cost) {
-            return 1;
-        }
-    }
-
-    /*
-        Terminate the search early or continue iterating on the key?
-        We have to account for the case that `cost` could momentarily exceed max_cost but resolve later.
-        In such cases, we will compare characters in the query with p and/or c to decide.
-    */
-
-    if(cost <= max_cost) {
-        return 0;
-    }
-
-    if(cost == 2 || cost == 3) {
-        /*
-            [1 letter extra]
-            exam ple
-            exZa mple
-
-            [1 letter missing]
-            exam ple
-            exmp le
-
-            [1 letter missing + transpose]
-            dacrycystal gia
-            dacrcyystlg ia
-        */
-        bool letter_more = (key_index+1 < query_len && query[key_index+1] == c);
-        bool letter_less = (key_index > 0 && query[key_index-1] == c);
-        if(letter_more || letter_less) {
-            return 0;
-        }
-    }
-
-    if(cost == 3 || cost == 4) {
-        /*
-            [2 letter extra]
-            exam ple
-            eTxT ample
-
-            abbviat ion
-            abbrevi ation
-        */
-
-        bool extra_matching_letters = (key_index + 1 < query_len && p == query[key_index + 1] &&
-                                       key_index + 2 < query_len && c == query[key_index + 2]);
-
-        if(extra_matching_letters) {
-            return 0;
-        }
-
-        /*
-            [2 letter missing]
-            exam ple
-            expl e
-       */
-
-        bool two_letter_less = (key_index > 1 && query[key_index-2] == c);
-        if(two_letter_less) {
-            return 0;
-        }
-    }
-
-    return -1;
-}
-
-static void art_fuzzy_recurse(unsigned char p, unsigned char c, const art_node *n, int depth, const unsigned char *term,
-                              const int term_len, const int* irow, const int* jrow, const int min_cost,
-                              const int max_cost, const bool prefix, std::vector<const art_node *> &results) {
-
-    if (!n) return ;
+// Fuzzy search of a term that is under way: the state of its automaton after the path walked so far.
+struct art_fuzzy_walker_t {
+    levenshtein_automaton_t* automaton;
+    const unsigned char* term;
+    int term_len;
+    int max_cost;
+    uint32_t state;
+    // -1 when the walk starts on the root node, whose char is not walked
+    int depth;
+    std::vector<const art_node*>* results;
+};
 
-    const int columns = term_len+1;
-    int i=0, j=1, k=2;
-    int row0[columns];
-    int row1[columns];
-    int row2[columns];
-    int* rows[3] = {row0, row1, row2};
-
-    copyIntArray2(irow, rows[i], columns);
-    copyIntArray2(jrow, rows[j], columns);
+// Walks the char `c` that leads to `n` and the chars held by `n`. Returns true when the walk goes on into the
+// children of `n`.
+static inline bool art_fuzzy_walk(unsigned char c, const art_node *n, art_fuzzy_walker_t& walker) {
+    levenshtein_automaton_t& automaton = *walker.automaton;
+    int& depth = walker.depth;
 
     if(depth == -1) {
         // root node
         depth = 0;
     } else {
         // check indexed char first
-        bool last_key_char = (c == '\0');
-
-        if(!prefix || !last_key_char) {
-            levenshtein_dist(depth, p, c, term, term_len, rows[i], rows[j], rows[k]);
-            rotate(i, j, k);
-        }
-
-        int action = fuzzy_search_state(prefix, depth, p, c, term, term_len, rows[j], min_cost, max_cost);
-        if(1 == action) {
-            results.push_back(n);
-            return;
+        auto action = automaton.step(walker.state, c);
+        if(action == levenshtein_automaton_t::ACCEPT) {
+            walker.results->push_back(n);
+            return false;
         }
 
-        if(action == -1) {
-            return;
+        if(action == levenshtein_automaton_t::REJECT) {
+            return false;
         }
 
-        p = c;
         depth++;
     }
 
@@ -1640,103 +1690,181 @@ static void art_fuzzy_recurse(unsigned char p, unsigned char c, const art_node *
     if(IS_LEAF(n)) {
         art_leaf *l = (art_leaf *) LEAF_RAW(n);
 
-        //std::string leaf_str((const char*)l->key, l->key_len-1);
-        //LOG(INFO) << "leaf key: " << leaf_str;
-        /*if(leaf_str == "illustrations") {
-            LOG(INFO) << "here";
-        }*/
-
         // look past term_len to deal with trailing typo, e.g. searching "pltinum" on "platinum" @ max_cost = 1
-        const int iter_len = std::min(int(l->key_len), term_len + max_cost);
+        const int iter_len = std::min(int(l->key_len), walker.term_len + walker.max_cost);
 
         if(depth >= iter_len) {
             // when a preceding partial node completely contains the whole leaf (e.g. "[raspberr]y" on "raspberries")
-            int action = fuzzy_search_state(prefix, depth, '\0', '\0', term, term_len, rows[j], min_cost, max_cost);
-            if(action == 1) {
-                results.push_back(n);
+            if(automaton.end(walker.state) == levenshtein_automaton_t::ACCEPT) {
+                walker.results->push_back(n);
             }
 
-            return;
+            return false;
         }
 
         // we will iterate through remaining leaf characters
         while(depth < iter_len) {
-            c = l->key[depth];
-            bool last_key_char = (c == '\0');
-
-            if(!prefix || !last_key_char) {
-                levenshtein_dist(depth, p, c, term, term_len, rows[i], rows[j], rows[k]);
-
-                printf("leaf char: %c\n", l->key[depth]);
-                printf("cost: %d, depth: %d, term_len: %d\n", temp_cost, depth, term_len);
-
-                rotate(i, j, k);
+            auto action = automaton.step(walker.state, l->key[depth]);
+            if(action == levenshtein_automaton_t::ACCEPT) {
+                walker.results->push_back(n);
+                return false;
             }
 
-            int action = fuzzy_search_state(prefix, depth, p, c, term, term_len, rows[j], min_cost, max_cost);
-            if(action == 1) {
-                results.push_back(n);
-                return;
+            if(action == levenshtein_automaton_t::REJECT) {
+                return false;
             }
 
-            if(action == -1) {
-                return;
-            }
-
-            p = c;
             depth++;
         }
 
-        return ;
+        return false;
     }
 
     // now check compressed prefix
 
     int partial_len = min(MAX_PREFIX_LEN, n->partial_len);
-    //std::string partial_str(reinterpret_cast<const char *>(n->partial), n->partial_len);
 
     for (int idx = 0; idx < partial_len; idx++) {
-        c = n->partial[idx];
+        auto action = automaton.step(walker.state, n->partial[idx]);
+        if(action == levenshtein_automaton_t::ACCEPT) {
+            walker.results->push_back(n);
+            return false;
+        }
 
-        levenshtein_dist(depth, p, c, term, term_len, rows[i], rows[j], rows[k]);
-        rotate(i, j, k);
+        if(action == levenshtein_automaton_t::REJECT) {
+            return false;
+        }
 
-        int action = fuzzy_search_state(prefix, depth, p, c, term, term_len, rows[j], min_cost, max_cost);
-        if(action == 1) {
-            results.push_back(n);
-            return;
+        depth++;
+    }
+
+    // Some intermediate path may have been left out if partial_len is truncated: progress the automaton on the term
+    while(partial_len < n->partial_len && depth < walker.term_len) {
+        auto action = automaton.step(walker.state, walker.term[depth]);
+        if(action == levenshtein_automaton_t::ACCEPT) {
+            walker.results->push_back(n);
+            return false;
         }
 
-        if(action == -1) {
-            return;
+        if(action == levenshtein_automaton_t::REJECT) {
+            return false;
         }
 
-        p = c;
         depth++;
+        partial_len++;
     }
 
-    // Some intermediate path may have been left out if partial_len is truncated: progress the levenshtein matrix
-    while(partial_len < n->partial_len && depth < term_len) {
-        c = term[depth];
-        levenshtein_dist(depth, p, c, term, term_len, rows[i], rows[j], rows[k]);
-        rotate(i, j, k);
+    return true;
+}
 
-        int action = fuzzy_search_state(prefix, depth, p, c, term, term_len, rows[j], min_cost, max_cost);
-        if(action == 1) {
-            results.push_back(n);
-            return;
+static void art_fuzzy_recurse(unsigned char c, const art_node *n, art_fuzzy_walker_t walker) {
+    if (!n) return ;
+
+    if(!art_fuzzy_walk(c, n, walker)) {
+        return ;
+    }
+
+    art_fuzzy_children(n, [&walker](unsigned char child_char, const art_node* child) {
+        art_fuzzy_recurse(child_char, child, walker);
+    });
+}
+
+// Walkers in [begin, end) of `walkers` have walked into `n`: the ones that walk into a child are appended for the
+// recursion into that child and dropped afterwards, so that the vector works as a stack.
+static void art_fuzzy_recurse_batch(const art_node *n, std::vector<art_fuzzy_walker_t>& walkers,
+                                    const size_t begin, const size_t end) {
+    art_fuzzy_children(n, [&](unsigned char child_char, const art_node* child) {
+        if (!child) return ;
+
+        const size_t child_begin = walkers.size();
+
+        for(size_t i = begin; i < end; i++) {
+            art_fuzzy_walker_t walker = walkers[i];
+            if(art_fuzzy_walk(child_char, child, walker)) {
+                walkers.push_back(walker);
+            }
         }
 
-        if(action == -1) {
-            return;
+        if(walkers.size() > child_begin) {
+            art_fuzzy_recurse_batch(child, walkers, child_begin, walkers.size());
         }
 
-        p = c;
-        depth++;
-        partial_len++;
+        walkers.resize(child_begin);
+    });
+}
+
+// Like `art_fuzzy_recurse`, but also saves where the walk stands on entering a node whose chars are not all before
+// `frontier_depth`. `walked_chars` holds the chars that the automaton walked from the root to `n`.
+static void art_fuzzy_recurse_frontier(unsigned char c, const art_node *n, art_fuzzy_walker_t walker,
+                                       const int frontier_depth, std::string& walked_chars,
+                                       std::vector<art_fuzzy_frontier_t::entry_t>& entries) {
+    if (!n) return ;
+
+    const bool is_root = (walker.depth == -1);
+    const int start_depth = is_root ? 0 : walker.depth;
+    const int num_chars = (is_root ? 0 : 1) + (IS_LEAF(n) ? 0 : n->partial_len);
+
+    // leaves and the end of a key are checked against the whole term
+    if(IS_LEAF(n) || (!is_root && c == '\0') || start_depth + num_chars > frontier_depth) {
+        entries.push_back(art_fuzzy_frontier_t::entry_t{n, c, walker.depth, walked_chars});
+        art_fuzzy_recurse(c, n, walker);
+        return ;
+    }
+
+    const size_t walked_len = walked_chars.size();
+    const int partial_len = min(MAX_PREFIX_LEN, n->partial_len);
+
+    if(!is_root) {
+        walked_chars.push_back(c);
+    }
+
+    walked_chars.append((const char*) n->partial, partial_len);
+
+    // chars left out of a truncated partial are walked on the term
+    const int truncated_depth = start_depth + (is_root ? 0 : 1) + partial_len;
+    walked_chars.append((const char*) walker.term + truncated_depth, n->partial_len - partial_len);
+
+    if(art_fuzzy_walk(c, n, walker)) {
+        art_fuzzy_children(n, [&](unsigned char child_char, const art_node* child) {
+            art_fuzzy_recurse_frontier(child_char, child, walker, frontier_depth, walked_chars, entries);
+        });
+    }
+
+    walked_chars.resize(walked_len);
+}
+
+// Walks `walker` on `t`, which must not be empty, from its root.
+static void art_fuzzy_walk_tree(art_tree *t, art_fuzzy_walker_t& walker) {
+    if(IS_LEAF(t->root)) {
+        art_leaf *l = (art_leaf *) LEAF_RAW(t->root);
+        walker.depth = 0;
+        art_fuzzy_recurse(l->key[0], t->root, walker);
+    } else {
+        // depth of -1 indicates that this is a root node
+        walker.depth = -1;
+        art_fuzzy_recurse(0, t->root, walker);
+    }
+}
+
+// Automata are only walked by the thread that built them: every thread keeps the ones of its recent terms, since
+// the tokens of a query are searched over and over, e.g. across fields and when the typo budget is widened.
+static std::shared_ptr<levenshtein_automaton_t> get_fuzzy_automaton(const unsigned char *term, const int term_len,
+                                                                    const int min_cost, const int max_cost,
+                                                                    const bool prefix) {
+    thread_local LRU::Cache<std::string, std::shared_ptr<levenshtein_automaton_t>> automata(FUZZY_AUTOMATA_CACHE_SIZE);
+
+    std::string key((const char*) term, term_len);
+    key.push_back((char) min_cost);
+    key.push_back((char) max_cost);
+    key.push_back((char) prefix);
+
+    if(automata.contains(key)) {
+        return automata.lookup(key);
     }
 
-    art_fuzzy_children(c, n, depth, term, term_len, rows[i], rows[j], min_cost, max_cost, prefix, results);
+    auto automaton = std::make_shared<levenshtein_automaton_t>(term, term_len, min_cost, max_cost, prefix);
+    automata.insert(key, automaton);
+    return automaton;
 }
 
 /**
@@ -1748,26 +1876,18 @@ int art_fuzzy_search(art_tree *t, const unsigned char *term, const int term_len,
                      const uint32_t *filter_ids, const size_t filter_ids_length,
                      std::vector<art_leaf *> &results, std::set<std::string>& exclude_leaves) {
 
-    std::vector<const art_node*> nodes;
-    int irow[term_len + 1];
-    int jrow[term_len + 1];
-    for (int i = 0; i <= term_len; i++){
-        irow[i] = jrow[i] = i;
+    if(t->root == nullptr) {
+        return 0;
     }
 
-    //auto begin = std::chrono::high_resolution_clock::now();
+    std::vector<const art_node*> nodes;
+    auto automaton = get_fuzzy_automaton(term, term_len, min_cost, max_cost, prefix);
+    art_fuzzy_walker_t walker{automaton.get(), term, term_len, max_cost, levenshtein_automaton_t::INITIAL_STATE,
+                              0, &nodes};
 
-    if(IS_LEAF(t->root)) {
-        art_leaf *l = (art_leaf *) LEAF_RAW(t->root);
-        art_fuzzy_recurse(0, l->key[0], t->root, 0, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
-    } else {
-        if(t->root == nullptr) {
-            return 0;
-        }
+    //auto begin = std::chrono::high_resolution_clock::now();
 
-        // send depth as -1 to indicate that this is a root node
-        art_fuzzy_recurse(0, 0, t->root, -1, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
-    }
+    art_fuzzy_walk_tree(t, walker);
 
     //long long int time_micro = microseconds(std::chrono::high_resolution_clock::now() - begin).count();
     //!LOG(INFO) << "Time taken for fuzz: " << time_micro << "us, size of nodes: " << nodes.size();
@@ -1828,30 +1948,33 @@ int art_fuzzy_search_i(art_tree *t, const unsigned char *term, const int term_le
                        filter_result_iterator_t* const filter_result_iterator,
                        std::vector<art_leaf *> &results, std::set<std::string>& exclude_leaves) {
 
-    std::vector<const art_node*> nodes;
-    int irow[term_len + 1];
-    int jrow[term_len + 1];
-    for (int i = 0; i <= term_len; i++){
-        irow[i] = jrow[i] = i;
+    if(t->root == nullptr) {
+        return 0;
     }
 
-    //auto begin = std::chrono::high_resolution_clock::now();
+    std::vector<const art_node*> nodes;
+    auto automaton = get_fuzzy_automaton(term, term_len, min_cost, max_cost, prefix);
+    art_fuzzy_walker_t walker{automaton.get(), term, term_len, max_cost, levenshtein_automaton_t::INITIAL_STATE,
+                              0, &nodes};
 
-    if(IS_LEAF(t->root)) {
-        art_leaf *l = (art_leaf *) LEAF_RAW(t->root);
-        art_fuzzy_recurse(0, l->key[0], t->root, 0, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
-    } else {
-        if(t->root == nullptr) {
-            return 0;
-        }
+    //auto begin = std::chrono::high_resolution_clock::now();
 
-        // send depth as -1 to indicate that this is a root node
-        art_fuzzy_recurse(0, 0, t->root, -1, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
-    }
+    art_fuzzy_walk_tree(t, walker);
 
     //long long int time_micro = microseconds(std::chrono::high_resolution_clock::now() - begin).count();
     //!LOG(INFO) << "Time taken for fuzz: " << time_micro << "us, size of nodes: " << nodes.size();
 
+    return art_fuzzy_search_nodes(t, nodes, term, term_len, min_cost, max_words, token_order, prefix,
+                                  last_token, prev_token, filter_result_iterator, results, exclude_leaves);
+}
+
+int art_fuzzy_search_nodes(art_tree *t, const std::vector<const art_node*>& nodes,
+                           const unsigned char *term, const int term_len, const int min_cost,
+                           const size_t max_words, const token_ordering token_order,
+                           const bool prefix, bool last_token, const std::string& prev_token,
+                           filter_result_iterator_t* const filter_result_iterator,
+                           std::vector<art_leaf *> &results, std::set<std::string>& exclude_leaves) {
+
     //auto begin = std::chrono::high_resolution_clock::now();
 
     size_t key_len = prefix ? term_len + 1 : term_len;
@@ -1893,6 +2016,99 @@ int art_fuzzy_search_i(art_tree *t, const unsigned char *term, const int term_le
     return 0;
 }
 
+void art_fuzzy_search_batch(art_tree *t, const std::vector<art_fuzzy_query_t>& queries,
+                            std::vector<std::vector<std::vector<const art_node*>>>& nodes) {
+    nodes.clear();
+    nodes.resize(queries.size());
+
+    for(size_t i = 0; i < queries.size(); i++) {
+        nodes[i].resize(std::max(0, queries[i].max_cost - queries[i].min_cost + 1));
+    }
+
+    if(t->root == nullptr) {
+        return ;
+    }
+
+    // one walker per query and cost: the walkers that are still under way at a node walk into its children together
+    std::vector<std::shared_ptr<levenshtein_automaton_t>> automata;
+    std::vector<art_fuzzy_walker_t> walkers;
+
+    for(size_t i = 0; i < queries.size(); i++) {
+        const auto& query = queries[i];
+        for(int cost = query.min_cost; cost <= query.max_cost; cost++) {
+            automata.push_back(get_fuzzy_automaton(query.term, query.term_len, cost, cost, query.prefix));
+            walkers.push_back(art_fuzzy_walker_t{automata.back().get(), query.term, query.term_len, cost,
+                                                 levenshtein_automaton_t::INITIAL_STATE, 0,
+                                                 &nodes[i][cost - query.min_cost]});
+        }
+    }
+
+    const bool root_is_leaf = IS_LEAF(t->root);
+    const unsigned char root_char = root_is_leaf ? ((art_leaf *) LEAF_RAW(t->root))->key[0] : 0;
+    const size_t num_walkers = walkers.size();
+
+    for(size_t i = 0; i < num_walkers; i++) {
+        art_fuzzy_walker_t walker = walkers[i];
+        // depth of -1 indicates that this is a root node
+        walker.depth = root_is_leaf ? 0 : -1;
+        if(art_fuzzy_walk(root_char, t->root, walker)) {
+            walkers.push_back(walker);
+        }
+    }
+
+    if(walkers.size() > num_walkers) {
+        art_fuzzy_recurse_batch(t->root, walkers, num_walkers, walkers.size());
+    }
+}
+
+void art_fuzzy_search_prefix(art_tree *t, const unsigned char *term, const int term_len, const int cost,
+                             const art_fuzzy_frontier_t* prev_frontier,
+                             std::vector<const art_node*>& nodes, art_fuzzy_frontier_t& frontier) {
+    frontier.entries.clear();
+    frontier.term_len = term_len;
+
+    if(t->root == nullptr) {
+        return ;
+    }
+
+    auto automaton = get_fuzzy_automaton(term, term_len, cost, cost, true);
+    art_fuzzy_walker_t walker{automaton.get(), term, term_len, cost, levenshtein_automaton_t::INITIAL_STATE,
+                              0, &nodes};
+
+    // The decisions on a key char only look at the term up to 2 chars after it, so up to here, the walk of a term
+    // is the same as the walk of any longer term it is a prefix of.
+    const int frontier_depth = term_len - 2;
+
+    if(prev_frontier == nullptr || prev_frontier->term_len > term_len) {
+        std::string walked_chars;
+
+        if(IS_LEAF(t->root)) {
+            art_leaf *l = (art_leaf *) LEAF_RAW(t->root);
+            walker.depth = 0;
+            art_fuzzy_recurse_frontier(l->key[0], t->root, walker, frontier_depth, walked_chars, frontier.entries);
+        } else {
+            // depth of -1 indicates that this is a root node
+            walker.depth = -1;
+            art_fuzzy_recurse_frontier(0, t->root, walker, frontier_depth, walked_chars, frontier.entries);
+        }
+
+        return ;
+    }
+
+    for(const auto& entry: prev_frontier->entries) {
+        art_fuzzy_walker_t entry_walker = walker;
+        entry_walker.depth = entry.depth;
+
+        for(unsigned char c: entry.walked_chars) {
+            // the walk of the previous term continued on these chars, so does this one
+            entry_walker.automaton->step(entry_walker.state, c);
+        }
+
+        std::string walked_chars = entry.walked_chars;
+        art_fuzzy_recurse_frontier(entry.c, entry.node, entry_walker, frontier_depth, walked_chars, frontier.entries);
+    }
+}
+
 void encode_int32(int32_t n, unsigned char *chars) {
     unsigned char symbols[16] = {
       0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15
@@ -134,6 +134,11 @@ Option<api_key_t> AuthManager::remove_key(uint32_t id) {
     api_key_t&& key = key_op.get();
     api_keys.erase(key.value);
 
+    {
+        std::unique_lock verified_keys_lock(verified_scoped_keys_mutex);
+        verified_scoped_keys.clear();
+    }
+
     return Option<api_key_t>(key.truncate_value());
 }
 
@@ -264,6 +269,26 @@ Option<bool> AuthManager::authenticate_parse_params(const collection_key_t& scop
         return Option<bool>(403, "Forbidden.");
     }
 
+    std::shared_ptr<const verified_scoped_key_t> verified_key;
+
+    {
+        std::unique_lock verified_keys_lock(verified_scoped_keys_mutex);
+        if(verified_scoped_keys.contains(scoped_api_key.api_key)) {
+            verified_key = verified_scoped_keys.lookup(scoped_api_key.api_key);
+        }
+    }
+
+    if(verified_key != nullptr) {
+        // the parent key must still allow the queried collection and neither key must have expired since
+        const auto parent_key_it = api_keys.find(verified_key->parent_key);
+        if(parent_key_it != api_keys.end() &&
+           auth_against_key(scoped_api_key.collection, action, parent_key_it.value(), true) &&
+           uint64_t(std::time(0)) <= verified_key->expires_at) {
+            embedded_params = verified_key->embedded_params;
+            return Option<bool>(true);
+        }
+    }
+
     const std::string& key_payload = StringUtils::base64_decode(scoped_api_key.api_key);
 
     if(key_payload.size() < HMAC_BASE64_LEN + api_key_t::PREFIX_LEN) {
@@ -305,19 +330,29 @@ Option<bool> AuthManager::authenticate_parse_params(const collection_key_t& scop
                 continue;
             }
 
+            uint64_t expiry_ts = root_api_key.expires_at;
+
             if(embedded_params.count("expires_at") != 0) {
                 if(!embedded_params["expires_at"].is_number_integer() || embedded_params["expires_at"].get<int64_t>() < 0) {
                     continue;
                 }
 
                 // if parent key's expiry timestamp is smaller, it takes precedence
-                uint64_t expiry_ts = std::min(root_api_key.expires_at, embedded_params["expires_at"].get<uint64_t>());
+                expiry_ts = std::min(root_api_key.expires_at, embedded_params["expires_at"].get<uint64_t>());
 
                 if(uint64_t(std::time(0)) > expiry_ts) {
                     continue;
                 }
             }
 
+            auto new_verified_key = std::make_shared<verified_scoped_key_t>();
+            new_verified_key->parent_key = root_api_key.value;
+            new_verified_key->expires_at = expiry_ts;
+            new_verified_key->embedded_params = embedded_params;
+
+            std::unique_lock verified_keys_lock(verified_scoped_keys_mutex);
+            verified_scoped_keys.insert(scoped_api_key.api_key, std::move(new_verified_key));
+
             return Option<bool>(true);
         }
     }
@@ -395,6 +430,8 @@ bool AuthManager::add_item_to_params(std::map<std::string, std::string>& req_par
         str_value = std::to_string(item.value().get<float>());
     } else if(item.value().is_boolean()) {
         str_value = item.value().get<bool>() ? "true" : "false";
+    } else if(item.value().is_object() && item.key() == "filter_params") {
+        str_value = item.value().dump();
     } else {
         return false;
     }
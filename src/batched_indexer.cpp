@@ -2,6 +2,7 @@
 #include "core_api.h"
 #include "thread_local_vars.h"
 #include "cached_resource_stat.h"
+#include "memory_arenas.h"
 #include "collection_manager.h"
 
 BatchedIndexer::BatchedIndexer(HttpServer* server, Store* store, Store* meta_store, const size_t num_threads,
@@ -9,8 +10,6 @@ BatchedIndexer::BatchedIndexer(HttpServer* server, Store* store, Store* meta_sto
                                server(server), store(store), meta_store(meta_store), num_threads(num_threads),
                                last_gc_run(std::chrono::high_resolution_clock::now()), quit(false),
                                config(config), skip_writes(skip_writes) {
-    queues.resize(num_threads);
-    qmutuxes = new await_t[num_threads];
     skip_index_iter_upper_bound = new rocksdb::Slice(skip_index_upper_bound_key);
 }
 
@@ -43,6 +42,9 @@ void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::sh
 
     //LOG(INFO) << "BatchedIndexer::enqueue";
     uint32_t chunk_sequence = 0;
+    bool streamed = false;
+    std::string serialized_chunk = req->to_json();
+    std::vector<std::pair<uint32_t, std::string>> spilled_chunks;
 
     {
         uint64_t now = std::chrono::duration_cast<std::chrono::seconds>(
@@ -54,37 +56,93 @@ void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::sh
         if(req_res_map_it == req_res_map.end()) {
             // first chunk
             req_res_t req_res(req->start_ts, "", req, res, now, 1, 0, false);
-            req_res_map.emplace(req->start_ts, req_res);
+            req_res.streamed = is_streamable(req, get_collection_name(req));
+            req_res_map_it = req_res_map.emplace(req->start_ts, req_res).first;
         } else {
             chunk_sequence = req_res_map_it->second.num_chunks;
             req_res_map_it->second.num_chunks += 1;
             req_res_map_it->second.last_updated = now;
         }
+
+        //LOG(INFO) << "request chunk: " << req->start_ts << "_" << chunk_sequence << ", req body: " << req->body;
+        buffer_req_chunk(req_res_map_it->second, chunk_sequence, std::move(serialized_chunk), spilled_chunks);
+        streamed = req_res_map_it->second.streamed;
+
+        if(streamed) {
+            // the chunks of a streamed request are read while it is still being written, so the indexer must find
+            // them in the store as soon as it sees that the request was spilled
+            const std::string& req_key_prefix = get_req_prefix_key(req->start_ts);
+            for(const auto& spilled_chunk: spilled_chunks) {
+                store->insert(req_key_prefix + StringUtils::serialize_uint32_t(spilled_chunk.first),
+                              spilled_chunk.second);
+            }
+            spilled_chunks.clear();
+        }
     }
 
     const std::string& req_key_prefix = get_req_prefix_key(req->start_ts);
-    const std::string& request_chunk_key = req_key_prefix + StringUtils::serialize_uint32_t(chunk_sequence);
-
-    //LOG(INFO) << "request_chunk_key: " << req->start_ts << "_" << chunk_sequence << ", req body: " << req->body;
 
-    store->insert(request_chunk_key, req->to_json());
+    for(const auto& spilled_chunk: spilled_chunks) {
+        store->insert(req_key_prefix + StringUtils::serialize_uint32_t(spilled_chunk.first), spilled_chunk.second);
+    }
 
     bool is_old_serialized_request = (req->start_ts == 0);
     bool read_more_input = (req->_req != nullptr && req->_req->proceed_req);
     bool is_live_req = res->is_alive;
 
-    if(req->last_chunk_aggregate) {
+    if(streamed) {
+        // each chunk is queued on its own, to be indexed at its position in the log
+        const std::string coll_name = get_collection_name(req);
+        queued_writes++;
+
+        if(req->last_chunk_aggregate) {
+            const std::string watermark_coll = get_watermark_coll(coll_name);
+
+            if(req->log_index > 0) {
+                std::lock_guard indexed_lk(indexed_mutex);
+                unindexed_log_indices.insert(req->log_index);
+                unindexed_coll_log_indices[watermark_coll].insert(req->log_index);
+            }
+
+            std::unique_lock lk(mutex);
+            auto& req_res = req_res_map[req->start_ts];
+            req_res.is_complete = true;
+            req_res.watermark_coll = watermark_coll;
+        }
+
+        req->body = "";
+        enqueue_coll_req(coll_name, req->start_ts);
+
+        if(read_more_input) {
+            std::unique_lock lk(mutex);
+            auto req_res_map_it = req_res_map.find(req->start_ts);
+            if(req_res_map_it != req_res_map.end() &&
+               req_res_map_it->second.num_chunks - req_res_map_it->second.next_chunk_index >= STREAM_WINDOW_CHUNKS) {
+                // read on once the indexing catches up, see `end_stream_chunk()`
+                req_res_map_it->second.proceed_deferred = true;
+                read_more_input = false;
+            }
+        }
+    } else if(req->last_chunk_aggregate) {
         //LOG(INFO) << "Last chunk for req_id: " << req->start_ts;
         queued_writes += (chunk_sequence + 1);
 
         {
-            const std::string& coll_name = get_collection_name(req);
-            uint64_t queue_id = StringUtils::hash_wy(coll_name.c_str(), coll_name.size()) % num_threads;
+            const std::string coll_name = get_collection_name(req);
             req->params["collection"] = coll_name;
+            const std::string watermark_coll = get_watermark_coll(coll_name);
+
+            if(req->log_index > 0) {
+                std::lock_guard indexed_lk(indexed_mutex);
+                unindexed_log_indices.insert(req->log_index);
+                unindexed_coll_log_indices[watermark_coll].insert(req->log_index);
+            }
 
             {
                 std::unique_lock lk2(mutex);
-                req_res_map[req->start_ts].is_complete = true;
+                auto& req_res = req_res_map[req->start_ts];
+                req_res.is_complete = true;
+                req_res.watermark_coll = watermark_coll;
             }
 
             bool queue_write = true;
@@ -111,7 +169,7 @@ void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::sh
                         // for the other collection(s) request(s) that arrived before this request to finish by pushing
                         // this request onto a waiting queue.
                         std::unique_lock lk(refq_wait.mcv);
-                        reference_q.emplace_back(queue_id, req->start_ts);
+                        reference_q.emplace_back(coll_name, req->start_ts);
                         lk.unlock();
                         refq_wait.cv.notify_one();
                         queue_write = false;
@@ -123,10 +181,7 @@ void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::sh
             req->body = "";
 
             if(queue_write) {
-                std::unique_lock qlk(qmutuxes[queue_id].mcv);
-                queues[queue_id].emplace_back(req->start_ts);
-                qlk.unlock();
-                qmutuxes[queue_id].cv.notify_one();
+                enqueue_coll_req(coll_name, req->start_ts);
             }
         }
 
@@ -154,7 +209,7 @@ void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::sh
     if(read_more_input) {
         // Tell the http library to read more input data
         deferred_req_res_t* req_res = new deferred_req_res_t(req, res, server, true);
-        server->get_message_dispatcher()->send_message(HttpServer::REQUEST_PROCEED_MESSAGE, req_res);
+        server->get_message_dispatcher(req)->send_message(HttpServer::REQUEST_PROCEED_MESSAGE, req_res);
     }
 }
 
@@ -188,22 +243,29 @@ void BatchedIndexer::run() {
     LOG(INFO) << "BatchedIndexer skip_index: " << skip_index;
 
     for(size_t i = 0; i < num_threads; i++) {
-        std::deque<uint64_t>& queue = queues[i];
-        await_t& queue_mutex = qmutuxes[i];
+        thread_pool->enqueue([this]() {
+            MemoryArenas::get_instance().bind_thread(MemoryArenas::INDEXING);
 
-        thread_pool->enqueue([&queue, &queue_mutex, this, i]() {
             while(!quit) {
-                std::unique_lock<std::mutex> qlk(queue_mutex.mcv);
-                queue_mutex.cv.wait(qlk, [&] { return quit || !queue.empty(); });
+                std::unique_lock<std::mutex> qlk(queue_wait.mcv);
+                queue_wait.cv.wait(qlk, [&] { return quit || !ready_colls.empty(); });
 
                 if(quit) {
                     break;
                 }
 
-                uint64_t req_id = queue.front();
-                queue.pop_front();
+                // take a turn on the collection that has waited the longest for one
+                const std::string coll_name = std::move(ready_colls.front());
+                ready_colls.pop_front();
+
+                coll_queue_t& coll_queue = coll_queues[coll_name];
+                coll_queue.in_service = true;
+                uint64_t req_id = coll_queue.reqs.front().first;
+                coll_queue.reqs.pop_front();
                 qlk.unlock();
 
+                coll_turn_t coll_turn(*this, coll_name);
+
                 std::unique_lock mlk(mutex);
                 auto req_res_map_it = req_res_map.find(req_id);
                 if(req_res_map_it == req_res_map.end()) {
@@ -214,6 +276,18 @@ void BatchedIndexer::run() {
                 req_res_t& orig_req_res = req_res_map_it->second;
                 mlk.unlock();
 
+                const std::string& coalesce_key = can_coalesce() ? get_coalesce_key(orig_req_res) : "";
+
+                if(!coalesce_key.empty()) {
+                    std::vector<uint64_t> coalesced_req_ids = {req_id};
+                    pop_coalescable_reqs(coll_name, coalesce_key, coalesced_req_ids);
+
+                    if(coalesced_req_ids.size() > 1) {
+                        index_coalesced_reqs(coalesced_req_ids);
+                        continue;
+                    }
+                }
+
                 // scan db for all logs associated with request
                 const std::string& req_key_prefix = get_req_prefix_key(req_id);
 
@@ -225,7 +299,11 @@ void BatchedIndexer::run() {
 
                 const std::string& req_key_upper_bound = get_req_suffix_key(req_id);  // cannot inline this
                 rocksdb::Slice upper_bound(req_key_upper_bound);
-                rocksdb::Iterator* iter = store->scan(req_key_start_prefix, &upper_bound);
+                // the chunks of a request that is held in memory are not in the store at all, while a streamed
+                // request reads its chunks one at a time
+                const bool streamed = orig_req_res.streamed;
+                rocksdb::Iterator* iter = (!streamed && orig_req_res.spilled) ?
+                                          store->scan(req_key_start_prefix, &upper_bound) : nullptr;
 
                 // used to handle partial JSON documents caused by chunking
                 std::string& prev_body = orig_req_res.prev_req_body;
@@ -234,17 +312,32 @@ void BatchedIndexer::run() {
                 const std::shared_ptr<http_res>& orig_res = orig_req_res.res;
                 bool is_live_req = orig_res->is_alive;
 
+                if(streamed && orig_req_res.stream_req == nullptr) {
+                    orig_req_res.stream_req = std::make_shared<http_req>();
+                    orig_req_res.stream_req->start_ts = orig_req_res.start_ts;
+                    orig_req_res.stream_res = std::make_shared<http_res>(nullptr);
+                }
+
+                const std::shared_ptr<http_req>& chunk_req = streamed ? orig_req_res.stream_req : orig_req;
+                const std::shared_ptr<http_res>& chunk_res = streamed ? orig_req_res.stream_res : orig_res;
+
                 route_path* found_rpath = nullptr;
                 bool route_found = server->get_route(orig_req->route_hash, &found_rpath);
                 bool async_res = false;
 
-                while(iter->Valid() && iter->key().starts_with(req_key_prefix)) {
+                std::string req_chunk;
+
+                while(true) {
                     std::shared_lock slk(pause_mutex); // used for snapshot
-                    orig_req->body = prev_body;
-                    orig_req->load_from_json(iter->value().ToString());
+                    if(!read_req_chunk(orig_req_res, iter, req_key_prefix, req_chunk)) {
+                        break;
+                    }
+
+                    chunk_req->body = prev_body;
+                    chunk_req->load_from_json(req_chunk);
 
                     // update thread local for reference during a crash
-                    write_log_index = orig_req->log_index;
+                    write_log_index = chunk_req->log_index;
 
                     if(write_log_index == skip_index) {
                         LOG(ERROR) << "Skipping write log index " << write_log_index
@@ -260,46 +353,43 @@ void BatchedIndexer::run() {
                                                                     config.get_memory_used_max_percentage());
 
                         if (resource_check != cached_resource_stat_t::OK &&
-                            orig_req->http_method != "DELETE"  && found_rpath->handler != post_health) {
+                            chunk_req->http_method != "DELETE"  && found_rpath->handler != post_health) {
                             const std::string& err_msg = "Rejecting write: running out of resource type: " +
                                                           std::string(magic_enum::enum_name(resource_check));
                             LOG(ERROR) << err_msg;
-                            orig_res->set_422(err_msg);
-                            orig_res->final = true;
-                            async_req_res_t* async_req_res = new async_req_res_t(orig_req, orig_res, true);
-                            server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+                            chunk_res->set_422(err_msg);
+                            chunk_res->final = true;
+                            send_response(orig_req_res);
                             goto end;
                         }
 
                         else if(route_found) {
                             if(skip_writes && found_rpath->handler != post_config) {
-                                orig_res->set(422, "Skipping write.");
-                                orig_res->final = true;
-                                async_req_res_t* async_req_res = new async_req_res_t(orig_req, orig_res, true);
-                                server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+                                chunk_res->set(422, "Skipping write.");
+                                chunk_res->final = true;
+                                send_response(orig_req_res);
                                 goto end;
                             }
 
                             async_res = found_rpath->async_res;
                             try {
-                                found_rpath->handler(orig_req, orig_res);
+                                found_rpath->handler(chunk_req, chunk_res);
                             } catch(const std::exception& e) {
                                 LOG(ERROR) << "Exception while calling handler " << found_rpath->_get_action();
                                 LOG(ERROR) << "Raw error: " << e.what();
                                 // bad request gets a response immediately
-                                orig_res->set_400("Bad request.");
-                                orig_res->final = true;
+                                chunk_res->set_400("Bad request.");
+                                chunk_res->final = true;
                                 async_res = false;
                             }
-                            prev_body = orig_req->body;
+                            prev_body = chunk_req->body;
                         } else {
-                            orig_res->set_404();
+                            chunk_res->set_404();
                         }
 
-                        if(is_live_req && (!route_found ||!async_res)) {
-                            // sync request gets a response immediately
-                            async_req_res_t* async_req_res = new async_req_res_t(orig_req, orig_res, true);
-                            server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+                        if(is_live_req && (streamed || !route_found || !async_res)) {
+                            // sync request gets a response immediately, as does each chunk of a streamed request
+                            send_response(orig_req_res);
                         }
 
                         if(!route_found) {
@@ -310,8 +400,21 @@ void BatchedIndexer::run() {
                     end:
 
                     queued_writes--;
+
+                    if(write_log_index == replay_end_index) {
+                        // the writes of a coalesced batch that crashed have all been replayed on their own
+                        populate_skip_index();
+                    }
+
+                    if(streamed) {
+                        // the next chunk has an entry of its own in the queue
+                        break;
+                    }
+
                     orig_req_res.next_chunk_index++;
-                    iter->Next();
+                    if(iter != nullptr) {
+                        iter->Next();
+                    }
 
                     if(quit) {
                         break;
@@ -320,10 +423,18 @@ void BatchedIndexer::run() {
 
                 delete iter;
 
+                // the request can be pruned as soon as it moves past its chunk, unless it is complete
+                if(streamed && !end_stream_chunk(orig_req_res)) {
+                    continue;
+                }
+
                 //LOG(INFO) << "Erasing request data from disk and memory for request " << req_id;
 
                 // we can delete the buffered request content
-                store->delete_range(req_key_prefix, req_key_prefix + StringUtils::serialize_uint32_t(UINT32_MAX));
+                release_req_chunks(orig_req_res);
+
+                // the request was last loaded with its last chunk
+                mark_indexed(orig_req_res.watermark_coll, chunk_req->log_index);
 
                 std::unique_lock lk(mutex);
 
@@ -368,10 +479,7 @@ void BatchedIndexer::run() {
                 if(ref_collections.empty()) {
                     // This request is not dependent on any other request. Push this request onto main processing queue
                     // and remove node from queue.
-                    std::unique_lock qlk(qmutuxes[reference_q_it->queue_id].mcv);
-                    queues[reference_q_it->queue_id].emplace_back(reference_q_it->start_ts);
-                    qlk.unlock();
-                    qmutuxes[reference_q_it->queue_id].cv.notify_one();
+                    enqueue_coll_req(reference_q_it->coll_name, reference_q_it->start_ts);
                     reference_q_it = reference_q.erase(reference_q_it);
                     continue;
                 }
@@ -387,10 +495,7 @@ void BatchedIndexer::run() {
                 if(!found_ref_coll) {
                     // All the dependent requests have been completed. Push this request onto main processing queue and
                     // remove node from queue.
-                    std::unique_lock qlk(qmutuxes[reference_q_it->queue_id].mcv);
-                    queues[reference_q_it->queue_id].emplace_back(reference_q_it->start_ts);
-                    qlk.unlock();
-                    qmutuxes[reference_q_it->queue_id].cv.notify_one();
+                    enqueue_coll_req(reference_q_it->coll_name, reference_q_it->start_ts);
                     reference_q_it = reference_q.erase(reference_q_it);
                 } else {
                     reference_q_it++;
@@ -443,16 +548,17 @@ void BatchedIndexer::run() {
                 //LOG(INFO) << "GC checking on req id: " << it->first;
                 //LOG(INFO) << "Seconds since last batch update: " << seconds_since_batch_update;
 
-                if(!it->second.is_complete && seconds_since_batch_update > GC_PRUNE_MAX_SECONDS) {
-                    LOG(INFO) << "Deleting partial upload for req id " << it->second.start_ts;
+                // a streamed request can only go once its queued chunks were indexed
+                bool chunks_queued = it->second.streamed && it->second.next_chunk_index < it->second.num_chunks;
 
-                    const std::string& req_key_prefix = get_req_prefix_key(it->second.start_ts);
-                    store->delete_range(req_key_prefix, req_key_prefix + StringUtils::serialize_uint32_t(UINT32_MAX));
+                if(!it->second.is_complete && !chunks_queued && seconds_since_batch_update > GC_PRUNE_MAX_SECONDS) {
+                    LOG(INFO) << "Deleting partial upload for req id " << it->second.start_ts;
+                    release_req_chunks(it->second);
 
                     if(it->second.res->is_alive) {
                         it->second.res->final = true;
                         async_req_res_t* async_req_res = new async_req_res_t(it->second.req, it->second.res, true);
-                        server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+                        server->get_message_dispatcher(it->second.req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
                     }
 
                     it = req_res_map.erase(it);
@@ -466,10 +572,7 @@ void BatchedIndexer::run() {
     }
 
     LOG(INFO) << "Notifying batch indexer threads about shutdown...";
-    for(size_t i = 0; i < num_threads; i++) {
-        await_t& queue_mutex = qmutuxes[i];
-        queue_mutex.cv.notify_one();
-    }
+    queue_wait.cv.notify_all();
 
     LOG(INFO) << "Notifying reference sequence thread about shutdown...";
     refq_wait.cv.notify_one();
@@ -490,8 +593,359 @@ std::string BatchedIndexer::get_req_suffix_key(uint64_t req_id) {
     return req_key_prefix;
 }
 
+void BatchedIndexer::buffer_req_chunk(req_res_t& req_res, uint32_t chunk_sequence, std::string&& chunk,
+                                      std::vector<std::pair<uint32_t, std::string>>& spilled_chunks) {
+    if(!req_res.spilled &&
+       req_res.mem_chunks_bytes + chunk.size() <= config.get_queued_request_memory_max_bytes() &&
+       mem_chunks_bytes_total + chunk.size() <= MAX_MEM_CHUNKS_BYTES) {
+        req_res.mem_chunks_bytes += chunk.size();
+        mem_chunks_bytes_total += chunk.size();
+        req_res.mem_chunks.push_back(std::move(chunk));
+        return ;
+    }
+
+    if(!req_res.spilled) {
+        // the request outgrew the memory: its chunks so far go to the store along with this one
+        for(size_t i = 0; i < req_res.mem_chunks.size(); i++) {
+            spilled_chunks.emplace_back(i, std::move(req_res.mem_chunks[i]));
+        }
+
+        mem_chunks_bytes_total -= req_res.mem_chunks_bytes;
+        req_res.mem_chunks.clear();
+        req_res.mem_chunks_bytes = 0;
+        req_res.spilled = true;
+    }
+
+    spilled_chunks.emplace_back(chunk_sequence, std::move(chunk));
+}
+
+bool BatchedIndexer::read_req_chunk(req_res_t& req_res, rocksdb::Iterator* iter, const std::string& req_key_prefix,
+                                    std::string& chunk) {
+    // the chunks of a streamed request are still being added, and it can be spilled meanwhile
+    std::unique_lock lk(mutex, std::defer_lock);
+    if(req_res.streamed) {
+        lk.lock();
+    }
+
+    if(req_res.spilled && iter == nullptr) {
+        const std::string& chunk_key = req_key_prefix + StringUtils::serialize_uint32_t(req_res.next_chunk_index);
+        return store->get(chunk_key, chunk) == StoreStatus::FOUND;
+    }
+
+    if(req_res.spilled) {
+        if(!iter->Valid() || !iter->key().starts_with(req_key_prefix)) {
+            return false;
+        }
+
+        chunk = iter->value().ToString();
+        return true;
+    }
+
+    if(req_res.next_chunk_index >= req_res.mem_chunks.size()) {
+        return false;
+    }
+
+    // the chunk is not needed again once it is read, as a snapshot can't be taken before it is applied
+    chunk = std::move(req_res.mem_chunks[req_res.next_chunk_index]);
+    req_res.mem_chunks[req_res.next_chunk_index].clear();
+    req_res.mem_chunks_bytes -= chunk.size();
+    mem_chunks_bytes_total -= chunk.size();
+    return true;
+}
+
+void BatchedIndexer::release_req_chunks(const req_res_t& req_res) {
+    if(req_res.spilled) {
+        const std::string& req_key_prefix = get_req_prefix_key(req_res.start_ts);
+        store->delete_range(req_key_prefix, req_key_prefix + StringUtils::serialize_uint32_t(UINT32_MAX));
+    }
+
+    mem_chunks_bytes_total -= req_res.mem_chunks_bytes;
+}
+
+bool BatchedIndexer::is_streamable(const std::shared_ptr<http_req>& req, const std::string& coll_name) {
+    // requests from versions that did not support batching can't be told apart from one another
+    if(req->start_ts == 0) {
+        return false;
+    }
+
+    route_path* rpath = nullptr;
+    bool route_found = server->get_route(req->route_hash, &rpath);
+
+    if(!route_found || rpath->handler != post_import_documents) {
+        return false;
+    }
+
+    auto ref_colls_it = coll_to_references.find(coll_name);
+    const auto& ref_collections = (ref_colls_it != coll_to_references.end()) ? ref_colls_it->second :
+                                  CollectionManager::get_instance().get_collection_references(coll_name);
+    return ref_collections.empty();
+}
+
+bool BatchedIndexer::end_stream_chunk(req_res_t& req_res) {
+    std::shared_ptr<http_req> req;
+    std::shared_ptr<http_res> res;
+    bool indexed = false;
+
+    {
+        std::unique_lock lk(mutex);
+        const uint32_t chunk_index = req_res.next_chunk_index++;
+
+        if(req_res.spilled) {
+            store->remove(get_req_prefix_key(req_res.start_ts) + StringUtils::serialize_uint32_t(chunk_index));
+        }
+
+        if(req_res.proceed_deferred && req_res.num_chunks - req_res.next_chunk_index < STREAM_WINDOW_CHUNKS) {
+            req_res.proceed_deferred = false;
+            req = req_res.req;
+            res = req_res.res;
+        }
+
+        indexed = req_res.is_complete && req_res.next_chunk_index >= req_res.num_chunks;
+    }
+
+    if(req != nullptr) {
+        // Tell the http library to read more input data
+        deferred_req_res_t* deferred_req_res = new deferred_req_res_t(req, res, server, true);
+        server->get_message_dispatcher(req)->send_message(HttpServer::REQUEST_PROCEED_MESSAGE, deferred_req_res);
+    }
+
+    return indexed;
+}
+
+void BatchedIndexer::send_response(req_res_t& req_res) {
+    const std::shared_ptr<http_req>& req = req_res.req;
+    const std::shared_ptr<http_res>& res = req_res.res;
+
+    if(req_res.streamed) {
+        if(!res->is_alive) {
+            return ;
+        }
+
+        // wait for the response of the previous chunk to be sent
+        res->wait();
+
+        const std::shared_ptr<http_res>& stream_res = req_res.stream_res;
+        res->status_code = stream_res->status_code;
+        res->content_type_header = stream_res->content_type_header;
+        res->body = std::move(stream_res->body);
+        res->final = stream_res->final.load();
+    }
+
+    async_req_res_t* async_req_res = new async_req_res_t(req, res, true);
+    server->get_message_dispatcher(req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+}
+
+std::string BatchedIndexer::get_coalesce_key(const req_res_t& req_res) {
+    // requests from versions that did not support batching (start_ts of 0) are always applied on their own
+    if(!req_res.is_complete || req_res.num_chunks != 1 || req_res.next_chunk_index != 0 || req_res.start_ts == 0) {
+        return "";
+    }
+
+    route_path* rpath = nullptr;
+    bool route_found = server->get_route(req_res.req->route_hash, &rpath);
+
+    if(!route_found || rpath->handler != post_add_document) {
+        return "";
+    }
+
+    std::string coalesce_key;
+
+    for(const char* param: {"collection", "action", "dirty_values",
+                            "remote_embedding_timeout_ms", "remote_embedding_num_tries"}) {
+        auto param_it = req_res.req->params.find(param);
+        if(param_it == req_res.req->params.end()) {
+            coalesce_key += "-";
+        } else {
+            coalesce_key += "=" + std::to_string(param_it->second.size()) + ":" + param_it->second;
+        }
+    }
+
+    return coalesce_key;
+}
+
+bool BatchedIndexer::can_coalesce() {
+    // while a crashing log entry is being looked for, or when writes would be rejected, apply requests one by one
+    if(skip_index != UNSET_SKIP_INDEX || replay_end_index != UNSET_SKIP_INDEX || skip_writes) {
+        return false;
+    }
+
+    auto resource_check = cached_resource_stat_t::get_instance()
+                          .has_enough_resources(config.get_data_dir(),
+                                                config.get_disk_used_max_percentage(),
+                                                config.get_memory_used_max_percentage());
+
+    return resource_check == cached_resource_stat_t::OK;
+}
+
+void BatchedIndexer::pop_coalescable_reqs(const std::string& coll_name, const std::string& coalesce_key,
+                                          std::vector<uint64_t>& req_ids) {
+    while(req_ids.size() < MAX_COALESCED_REQS) {
+        uint64_t next_req_id;
+
+        {
+            std::unique_lock<std::mutex> qlk(queue_wait.mcv);
+            const auto& coll_reqs = coll_queues[coll_name].reqs;
+            if(coll_reqs.empty()) {
+                return ;
+            }
+
+            next_req_id = coll_reqs.front().first;
+        }
+
+        {
+            std::unique_lock mlk(mutex);
+            auto req_res_map_it = req_res_map.find(next_req_id);
+            if(req_res_map_it == req_res_map.end() || get_coalesce_key(req_res_map_it->second) != coalesce_key) {
+                return ;
+            }
+        }
+
+        // the collection is served by this thread alone, so the front is still the same request
+        std::unique_lock<std::mutex> qlk(queue_wait.mcv);
+        coll_queues[coll_name].reqs.pop_front();
+        req_ids.push_back(next_req_id);
+    }
+}
+
+void BatchedIndexer::index_coalesced_reqs(const std::vector<uint64_t>& req_ids) {
+    std::vector<req_res_t*> req_res_vec;
+
+    {
+        // a complete request is removed from the map only by the thread that indexes it
+        std::unique_lock mlk(mutex);
+        for(auto req_id: req_ids) {
+            req_res_vec.push_back(&req_res_map.at(req_id));
+        }
+    }
+
+    {
+        std::shared_lock slk(pause_mutex); // used for snapshot
+
+        std::vector<std::shared_ptr<http_req>> reqs;
+        std::vector<std::shared_ptr<http_res>> res_vec;
+        std::vector<req_res_t*> loaded_req_res_vec;
+
+        for(auto req_res: req_res_vec) {
+            std::string req_chunk;
+
+            if(!req_res->spilled) {
+                if(!read_req_chunk(*req_res, nullptr, "", req_chunk)) {
+                    continue;
+                }
+            } else if(store->get(get_req_prefix_key(req_res->start_ts) + StringUtils::serialize_uint32_t(0),
+                                 req_chunk) != StoreStatus::FOUND) {
+                continue;
+            }
+
+            req_res->req->body = req_res->prev_req_body;
+            req_res->req->load_from_json(req_chunk);
+
+            reqs.push_back(req_res->req);
+            res_vec.push_back(req_res->res);
+            loaded_req_res_vec.push_back(req_res);
+        }
+
+        if(!reqs.empty()) {
+            // update thread locals for reference during a crash: the batch is marked as a whole
+            write_log_first_index = reqs.front()->log_index;
+            write_log_index = reqs.back()->log_index;
+
+            try {
+                add_coalesced_documents(reqs, res_vec);
+            } catch(const std::exception& e) {
+                LOG(ERROR) << "Exception while writing " << reqs.size() << " coalesced documents.";
+                LOG(ERROR) << "Raw error: " << e.what();
+                for(const auto& res: res_vec) {
+                    res->set_400("Bad request.");
+                }
+            }
+
+            write_log_first_index = -1;
+        }
+
+        for(size_t i = 0; i < reqs.size(); i++) {
+            if(res_vec[i]->is_alive) {
+                async_req_res_t* async_req_res = new async_req_res_t(reqs[i], res_vec[i], true);
+                server->get_message_dispatcher(reqs[i])->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+            }
+
+            queued_writes--;
+            loaded_req_res_vec[i]->next_chunk_index++;
+        }
+    }
+
+    for(auto req_res: req_res_vec) {
+        // we can delete the buffered request content
+        release_req_chunks(*req_res);
+    }
+
+    std::unique_lock lk(mutex);
+    for(auto req_id: req_ids) {
+        auto req_res_it = req_res_map.find(req_id);
+        if(req_res_it != req_res_map.end()) {
+            mark_indexed(req_res_it->second.watermark_coll, req_res_it->second.req->log_index);
+            req_res_map.erase(req_res_it);
+        }
+    }
+    lk.unlock();
+    refq_wait.cv.notify_one();
+}
+
+void BatchedIndexer::push_coll_req(const std::string& coll_name, uint64_t req_id) {
+    uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    coll_queue_t& coll_queue = coll_queues[coll_name];
+    coll_queue.reqs.emplace_back(req_id, now_us);
+
+    // a collection being served is put back in line by its worker at the end of the turn
+    if(!coll_queue.in_service && coll_queue.reqs.size() == 1) {
+        ready_colls.push_back(coll_name);
+    }
+}
+
+void BatchedIndexer::enqueue_coll_req(const std::string& coll_name, uint64_t req_id) {
+    std::unique_lock qlk(queue_wait.mcv);
+    push_coll_req(coll_name, req_id);
+    qlk.unlock();
+    queue_wait.cv.notify_one();
+}
+
+void BatchedIndexer::end_coll_turn(const std::string& coll_name) {
+    std::unique_lock qlk(queue_wait.mcv);
+    auto coll_queue_it = coll_queues.find(coll_name);
+    coll_queue_it->second.in_service = false;
+
+    if(coll_queue_it->second.reqs.empty()) {
+        coll_queues.erase(coll_queue_it);
+        return ;
+    }
+
+    ready_colls.push_back(coll_name);
+    qlk.unlock();
+    queue_wait.cv.notify_one();
+}
+
+void BatchedIndexer::get_queued_writes(nlohmann::json& coll_queue_stats) {
+    uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    coll_queue_stats = nlohmann::json::object();
+    std::unique_lock qlk(queue_wait.mcv);
+
+    for(const auto& kv: coll_queues) {
+        const auto& coll_reqs = kv.second.reqs;
+        if(coll_reqs.empty()) {
+            continue;
+        }
+
+        nlohmann::json& stats = coll_queue_stats[kv.first];
+        stats["queue_depth"] = coll_reqs.size();
+        stats["oldest_wait_ms"] = (now_us - std::min(now_us, coll_reqs.front().second)) / 1000;
+    }
+}
+
 BatchedIndexer::~BatchedIndexer() {
-    delete [] qmutuxes;
     delete skip_index_iter_upper_bound;
     delete skip_index_iter;
 }
@@ -504,23 +958,111 @@ int64_t BatchedIndexer::get_queued_writes() {
     return queued_writes;
 }
 
+void BatchedIndexer::mark_indexed(const std::string& watermark_coll, int64_t log_index) {
+    std::unique_lock lk(indexed_mutex);
+    // writes coalesced into one log entry share its index, and each of them is marked on its own
+    auto log_index_it = unindexed_log_indices.find(log_index);
+    if(log_index_it == unindexed_log_indices.end()) {
+        return ;
+    }
+
+    unindexed_log_indices.erase(log_index_it);
+
+    auto coll_indices_it = unindexed_coll_log_indices.find(watermark_coll);
+    if(coll_indices_it != unindexed_coll_log_indices.end()) {
+        auto coll_index_it = coll_indices_it->second.find(log_index);
+        if(coll_index_it != coll_indices_it->second.end()) {
+            coll_indices_it->second.erase(coll_index_it);
+        }
+
+        if(coll_indices_it->second.empty()) {
+            unindexed_coll_log_indices.erase(coll_indices_it);
+        }
+    }
+
+    lk.unlock();
+    indexed_cv.notify_all();
+}
+
+bool BatchedIndexer::is_indexed(const std::string& watermark_coll, int64_t log_index) const {
+    auto coll_indices_it = unindexed_coll_log_indices.find(watermark_coll);
+    return coll_indices_it == unindexed_coll_log_indices.end() || *coll_indices_it->second.begin() > log_index;
+}
+
+bool BatchedIndexer::wait_until_indexed(int64_t log_index, uint64_t timeout_ms, const std::string& collection) {
+    const std::string watermark_coll = collection.empty() ? "" : get_watermark_coll(collection);
+
+    std::unique_lock lk(indexed_mutex);
+    return indexed_cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), [&]() {
+        if(watermark_coll.empty()) {
+            return unindexed_log_indices.empty() || *unindexed_log_indices.begin() > log_index;
+        }
+
+        return is_indexed(watermark_coll, log_index) && is_indexed("", log_index);
+    });
+}
+
+std::string BatchedIndexer::get_watermark_coll(const std::string& coll_name) {
+    if(coll_name.empty()) {
+        return coll_name;
+    }
+
+    auto symlink_op = CollectionManager::get_instance().resolve_symlink(coll_name);
+    return symlink_op.ok() ? symlink_op.get() : coll_name;
+}
+
 void BatchedIndexer::populate_skip_index() {
+    std::lock_guard lock(skip_index_mutex);
+
+    int64_t next_skip_index = UNSET_SKIP_INDEX;
+    int64_t next_replay_begin_index = UNSET_SKIP_INDEX;
+    int64_t next_replay_end_index = UNSET_SKIP_INDEX;
+
     if(skip_index_iter->Valid() && skip_index_iter->key().starts_with(SKIP_INDICES_PREFIX)) {
+        // either the index of a write, or the `first-last` indices of a coalesced batch
         const std::string& index_value = skip_index_iter->value().ToString();
-        if(StringUtils::is_int64_t(index_value)) {
-            skip_index = std::stoll(index_value);
+        const size_t range_sep = index_value.find('-', 1);
+
+        if(range_sep == std::string::npos) {
+            if(StringUtils::is_int64_t(index_value)) {
+                next_skip_index = std::stoll(index_value);
+            }
+        } else {
+            const std::string& begin_value = index_value.substr(0, range_sep);
+            const std::string& end_value = index_value.substr(range_sep + 1);
+            if(StringUtils::is_int64_t(begin_value) && StringUtils::is_int64_t(end_value)) {
+                next_replay_begin_index = std::stoll(begin_value);
+                next_replay_end_index = std::stoll(end_value);
+            }
         }
 
         skip_index_iter->Next();
-    } else {
-        skip_index = UNSET_SKIP_INDEX;
     }
+
+    replay_begin_index = next_replay_begin_index;
+    replay_end_index = next_replay_end_index;
+    skip_index = next_skip_index;
 }
 
 void BatchedIndexer::persist_applying_index() {
-    LOG(INFO) << "Saving currently applying index: " << write_log_index;
-    std::string key = SKIP_INDICES_PREFIX + std::to_string(write_log_index);
-    meta_store->insert(key, std::to_string(write_log_index));
+    // A crash in a coalesced batch marks the whole batch, whose writes are then replayed one at a time. A crash in
+    // that replay replaces the mark of the batch with the index of the write that crashed, which is then skipped.
+    const int64_t replay_begin = replay_begin_index;
+    std::string key, value;
+
+    if(replay_begin != UNSET_SKIP_INDEX && write_log_index >= replay_begin && write_log_index <= replay_end_index) {
+        key = SKIP_INDICES_PREFIX + std::to_string(replay_begin);
+        value = std::to_string(write_log_index);
+    } else if(write_log_first_index >= 0 && write_log_first_index < write_log_index) {
+        key = SKIP_INDICES_PREFIX + std::to_string(write_log_first_index);
+        value = std::to_string(write_log_first_index) + "-" + std::to_string(write_log_index);
+    } else {
+        key = SKIP_INDICES_PREFIX + std::to_string(write_log_index);
+        value = std::to_string(write_log_index);
+    }
+
+    LOG(INFO) << "Saving currently applying index: " << value;
+    meta_store->insert(key, value);
 }
 
 void BatchedIndexer::serialize_state(nlohmann::json& state) {
@@ -542,6 +1084,12 @@ void BatchedIndexer::serialize_state(nlohmann::json& state) {
         req_res["is_complete"] = kv.second.is_complete;
         req_res["req"] = kv.second.req->to_json();
         req_res["prev_req_body"] = kv.second.prev_req_body;
+        req_res["streamed"] = kv.second.streamed;
+
+        if(!kv.second.spilled) {
+            // the chunks that were already applied are left empty
+            req_res["mem_chunks"] = kv.second.mem_chunks;
+        }
         num_reqs_stored++;
 
         //LOG(INFO) << "req_key: " << req_key << ", next_chunk_index: " << kv.second.next_chunk_index;
@@ -550,7 +1098,7 @@ void BatchedIndexer::serialize_state(nlohmann::json& state) {
     state["reference_q"] = nlohmann::json::array();
     for(auto& ref_req: reference_q) {
         nlohmann::json ref_req_obj;
-        ref_req_obj["queue_id"] = ref_req.queue_id;
+        ref_req_obj["collection"] = ref_req.coll_name;
         ref_req_obj["start_ts"] = ref_req.start_ts;
         state["reference_q"].push_back(ref_req_obj);
     }
@@ -562,7 +1110,7 @@ void BatchedIndexer::load_state(const nlohmann::json& state) {
     queued_writes = state["queued_writes"].get<int64_t>();
 
     size_t num_reqs_restored = 0;
-    std::set<uint64_t> queue_ids;
+    std::vector<std::pair<uint64_t, std::string>> complete_reqs;
 
     for(auto& kv: state["req_res_map"].items()) {
         std::shared_ptr<http_req> req = std::make_shared<http_req>();
@@ -576,6 +1124,19 @@ void BatchedIndexer::load_state(const nlohmann::json& state) {
                           kv.value()["next_chunk_index"].get<uint32_t>(),
                           kv.value()["is_complete"].get<bool>());
 
+        req_res.streamed = kv.value().contains("streamed") && kv.value()["streamed"].get<bool>();
+
+        if(kv.value().contains("mem_chunks")) {
+            req_res.mem_chunks = kv.value()["mem_chunks"].get<std::vector<std::string>>();
+            for(const auto& chunk: req_res.mem_chunks) {
+                req_res.mem_chunks_bytes += chunk.size();
+            }
+            mem_chunks_bytes_total += req_res.mem_chunks_bytes;
+        } else {
+            // chunks of snapshots from older versions are always in the store
+            req_res.spilled = true;
+        }
+
         {
             std::unique_lock mlk(mutex);
             req_res_map.emplace(std::stoull(kv.key()), req_res);
@@ -584,15 +1145,22 @@ void BatchedIndexer::load_state(const nlohmann::json& state) {
         // add only completed requests to their respective collection-based queues
         // the rest will be added by enqueue() when raft log is completely read
 
-        if(req_res.is_complete) {
+        if(req_res.streamed) {
+            // each chunk that was applied but not yet indexed had an entry of its own, and a request that was
+            // indexed fully needs one more to be cleaned up
+            uint32_t num_entries = req_res.num_chunks - req_res.next_chunk_index;
+            if(num_entries == 0 && req_res.is_complete) {
+                num_entries = 1;
+            }
+
+            for(uint32_t i = 0; i < num_entries; i++) {
+                complete_reqs.emplace_back(req->start_ts, get_collection_name(req));
+            }
+        } else if(req_res.is_complete) {
             LOG(INFO) << "req_res.start_ts: " <<  req_res.start_ts
                       << ", req_res.next_chunk_index: " << req_res.next_chunk_index;
 
-            const std::string& coll_name = get_collection_name(req);
-            uint64_t queue_id = StringUtils::hash_wy(coll_name.c_str(), coll_name.size()) % num_threads;
-            queue_ids.insert(queue_id);
-            std::unique_lock qlk(qmutuxes[queue_id].mcv);
-            queues[queue_id].emplace_back(req->start_ts);
+            complete_reqs.emplace_back(req->start_ts, get_collection_name(req));
         }
 
         num_reqs_restored++;
@@ -601,18 +1169,33 @@ void BatchedIndexer::load_state(const nlohmann::json& state) {
     if(state.contains("reference_q")) {
         for(const auto& item: state["reference_q"].items()) {
             const nlohmann::json& ref_entry = item.value();
-            reference_q.emplace_back(ref_entry["queue_id"], ref_entry["start_ts"]);
+            const uint64_t start_ts = ref_entry["start_ts"].get<uint64_t>();
+
+            if(ref_entry.contains("collection")) {
+                reference_q.emplace_back(ref_entry["collection"].get<std::string>(), start_ts);
+                continue;
+            }
+
+            // snapshots of older versions identify the queue of the request instead of its collection
+            std::unique_lock mlk(mutex);
+            auto req_res_map_it = req_res_map.find(start_ts);
+            if(req_res_map_it != req_res_map.end()) {
+                reference_q.emplace_back(req_res_map_it->second.req->params["collection"], start_ts);
+            }
         }
 
         refq_wait.cv.notify_one();
     }
 
     // need to sort on `start_ts` to preserve original order before notifying queues
-    for(auto queue_id: queue_ids) {
-        std::unique_lock lk(qmutuxes[queue_id].mcv);
-        std::sort(queues[queue_id].begin(), queues[queue_id].end());
-        qmutuxes[queue_id].cv.notify_one();
+    std::sort(complete_reqs.begin(), complete_reqs.end());
+
+    std::unique_lock qlk(queue_wait.mcv);
+    for(const auto& complete_req: complete_reqs) {
+        push_coll_req(complete_req.second, complete_req.first);
     }
+    qlk.unlock();
+    queue_wait.cv.notify_all();
 
     LOG(INFO) << "Restored " << num_reqs_restored << " in-flight requests from snapshot.";
 }
@@ -622,6 +1205,7 @@ std::shared_mutex& BatchedIndexer::get_pause_mutex() {
 }
 
 void BatchedIndexer::clear_skip_indices() {
+    std::lock_guard lock(skip_index_mutex);
     delete skip_index_iter;
     skip_index_iter = meta_store->scan(SKIP_INDICES_PREFIX, skip_index_iter_upper_bound);
 
@@ -11,8 +11,6 @@ cached_resource_stat_t::has_enough_resources(const std::string& data_dir_path,
         return cached_resource_stat_t::OK;
     }
 
-    std::unique_lock lk(m);
-
     uint64_t now = std::chrono::duration_cast<std::chrono::seconds>(
             std::chrono::system_clock::now().time_since_epoch()).count();
 
@@ -20,11 +18,29 @@ cached_resource_stat_t::has_enough_resources(const std::string& data_dir_path,
         return resource_status;
     }
 
+    // a check that finds a refresh under way goes by the status before it
+    std::unique_lock lk(m, std::try_to_lock);
+    if(!lk.owns_lock()) {
+        return resource_status;
+    }
+
     resource_status = get_resource_status(data_dir_path, disk_used_max_percentage, memory_used_max_percentage);
     last_checked_ts = now;
     return resource_status;
 }
 
+void cached_resource_stat_t::refresh(const std::string& data_dir_path, const int disk_used_max_percentage,
+                                     const int memory_used_max_percentage) {
+    if(disk_used_max_percentage == 100 && memory_used_max_percentage == 100) {
+        return ;
+    }
+
+    std::unique_lock lk(m);
+    resource_status = get_resource_status(data_dir_path, disk_used_max_percentage, memory_used_max_percentage);
+    last_checked_ts = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
 cached_resource_stat_t::resource_check_t
 cached_resource_stat_t::get_resource_status(const std::string& data_dir_path, const int disk_used_max_percentage,
                                             const int memory_used_max_percentage) {
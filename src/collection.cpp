@@ -17,6 +17,8 @@
 #include "topster.h"
 #include "logger.h"
 #include "thread_local_vars.h"
+#include "search_profile.h"
+#include "request_cost.h"
 #include "vector_query_ops.h"
 #include "embedder_manager.h"
 #include "stopwords_manager.h"
@@ -24,6 +26,7 @@
 #include "conversation_manager.h"
 #include "conversation_model_manager.h"
 #include "field.h"
+#include "filter_result_cache.h"
 
 const std::string override_t::MATCH_EXACT = "exact";
 const std::string override_t::MATCH_CONTAINS = "contains";
@@ -33,14 +36,13 @@ struct sort_fields_guard_t {
 
     ~sort_fields_guard_t() {
         for(auto& sort_by_clause: sort_fields_std) {
-            for (auto& eval_ids: sort_by_clause.eval.eval_ids_vec) {
-                delete [] eval_ids;
-            }
             delete [] sort_by_clause.eval.filter_trees;
         }
     }
 };
 
+std::atomic<uint64_t> Collection::write_generation_counter = 0;
+
 Collection::Collection(const std::string& name, const uint32_t collection_id, const uint64_t created_at,
                        const uint32_t next_seq_id, Store *store, const std::vector<field> &fields,
                        const std::string& default_sorting_field,
@@ -48,10 +50,13 @@ Collection::Collection(const std::string& name, const uint32_t collection_id, co
                        const std::vector<std::string>& symbols_to_index,
                        const std::vector<std::string>& token_separators,
                        const bool enable_nested_fields, std::shared_ptr<VQModel> vq_model,
-                       spp::sparse_hash_map<std::string, std::string> referenced_in) :
+                       spp::sparse_hash_map<std::string, std::string> referenced_in,
+                       const std::string& storage_format) :
         name(name), collection_id(collection_id), created_at(created_at),
         next_seq_id(next_seq_id), store(store),
+        doc_ids(doc_id_index_t::parse_mode(Config::get_instance().get_doc_id_index())),
         fields(fields), default_sorting_field(default_sorting_field), enable_nested_fields(enable_nested_fields),
+        storage_format(storage_format),
         max_memory_ratio(max_memory_ratio),
         fallback_field_type(fallback_field_type), dynamic_fields({}),
         symbols_to_index(to_char_array(symbols_to_index)), token_separators(to_char_array(token_separators)),
@@ -62,9 +67,26 @@ Collection::Collection(const std::string& name, const uint32_t collection_id, co
         vq_model->inc_collection_ref_count();
     }
     this->num_documents = 0;
+    this->write_generation = ++write_generation_counter;
+    this->last_accessed_s = std::time(nullptr);
+}
+
+void Collection::stop_backfill() {
+    {
+        std::shared_lock lock(mutex);
+        if(alter_backfill != nullptr) {
+            alter_backfill->stop = true;
+        }
+    }
+
+    if(backfill_thread.joinable()) {
+        backfill_thread.join();
+    }
 }
 
 Collection::~Collection() {
+    stop_backfill();
+
     std::unique_lock lifecycle_lock(lifecycle_mutex);
     std::unique_lock lock(mutex);
     delete index;
@@ -79,12 +101,36 @@ Collection::~Collection() {
     }
 }
 
+void Collection::release_index_in_chunks(const std::chrono::milliseconds& pause) {
+    stop_backfill();
+
+    // waits for the searches that still hold the collection
+    std::unique_lock lifecycle_lock(lifecycle_mutex);
+    std::unique_lock lock(mutex);
+
+    size_t num_released = 0;
+    while(index->release_next_structure()) {
+        num_released++;
+        std::this_thread::sleep_for(pause);
+    }
+
+    LOG(INFO) << "Released " << num_released << " index structures of collection " << name;
+}
+
 uint32_t Collection::get_next_seq_id() {
     std::shared_lock lock(mutex);
     store->increment(get_next_seq_id_key(name), 1);
     return next_seq_id++;
 }
 
+uint64_t Collection::get_write_generation() const {
+    return write_generation.load();
+}
+
+void Collection::advance_write_generation() {
+    write_generation = ++write_generation_counter;
+}
+
 Option<bool> single_value_filter_query(nlohmann::json& document, const std::string& field_name,
                                        const std::string& ref_field_type, bool is_optional, std::string& filter_query) {
     auto const& value = document[field_name];
@@ -394,8 +440,8 @@ Option<doc_seq_id_t> Collection::to_doc(const std::string & json_str, nlohmann::
         const std::string& doc_id = document["id"];
 
         // try to get the corresponding sequence id from disk if present
-        std::string seq_id_str;
-        StoreStatus seq_id_status = store->get(get_doc_id_key(doc_id), seq_id_str);
+        uint32_t seq_id = 0;
+        StoreStatus seq_id_status = get_doc_seq_id(doc_id, seq_id);
 
         if(seq_id_status == StoreStatus::ERROR) {
             return Option<doc_seq_id_t>(500, "Error fetching the sequence key for document with id: " + doc_id);
@@ -409,8 +455,6 @@ Option<doc_seq_id_t> Collection::to_doc(const std::string & json_str, nlohmann::
 
 
             // UPSERT, EMPLACE or UPDATE
-            uint32_t seq_id = (uint32_t) std::stoul(seq_id_str);
-
             return Option<doc_seq_id_t>(doc_seq_id_t{seq_id, false});
 
         } else {
@@ -436,6 +480,7 @@ nlohmann::json Collection::get_summary_json() const {
     json_response["num_documents"] = num_documents.load();
     json_response["created_at"] = created_at.load();
     json_response["enable_nested_fields"] = enable_nested_fields;
+    json_response["storage_format"] = storage_format;
     json_response["token_separators"] = nlohmann::json::array();
     json_response["symbols_to_index"] = nlohmann::json::array();
 
@@ -471,6 +516,10 @@ nlohmann::json Collection::get_summary_json() const {
             field_json[fields::range_index] = coll_field.range_index;
         }
 
+        if(coll_field.exact_match_index) {
+            field_json[fields::exact_match_index] = true;
+        }
+
         // no need to sned hnsw_params for text fields
         if(coll_field.num_dim > 0) {
             field_json[fields::hnsw_params] = coll_field.hnsw_params;
@@ -502,6 +551,10 @@ nlohmann::json Collection::get_summary_json() const {
 
     json_response["fields"] = fields_arr;
     json_response["default_sorting_field"] = default_sorting_field;
+
+    if(alter_backfill != nullptr) {
+        json_response["alter_backfill"] = backfill_status(*alter_backfill);
+    }
     
     if(vq_model) {
         json_response["voice_query_model"] = nlohmann::json::object();
@@ -555,7 +608,9 @@ nlohmann::json Collection::add_many(std::vector<std::string>& json_lines, nlohma
         Option<doc_seq_id_t> doc_seq_id_op = to_doc(json_line, document, operation, dirty_values, id);
 
         const uint32_t seq_id = doc_seq_id_op.ok() ? doc_seq_id_op.get().seq_id : 0;
-        index_record record(i, seq_id, document, operation, dirty_values);
+
+        // `document` is parsed afresh for every line, so it can be handed over to the record
+        index_record record(i, seq_id, std::move(document), operation, dirty_values);
 
         // NOTE: we overwrite the input json_lines with result to avoid memory pressure
 
@@ -585,6 +640,7 @@ nlohmann::json Collection::add_many(std::vector<std::string>& json_lines, nlohma
             // if `fallback_field_type` or `dynamic_fields` is enabled, update schema first before indexing
             if(!fallback_field_type.empty() || !dynamic_fields.empty() || !nested_fields.empty() || !reference_fields.empty()) {
                 std::vector<field> new_fields;
+                std::unique_lock write_lock(write_mutex);
                 std::unique_lock lock(mutex);
 
                 Option<bool> new_fields_op = detect_new_fields(record.doc, dirty_values,
@@ -605,6 +661,7 @@ nlohmann::json Collection::add_many(std::vector<std::string>& json_lines, nlohma
                         if(search_schema.find(new_field.name) == search_schema.end()) {
                             found_new_field = true;
                             search_schema.emplace(new_field.name, new_field);
+                            schema_version++;
                             fields.emplace_back(new_field);
                             if(new_field.nested) {
                                 nested_fields.emplace(new_field.name, new_field);
@@ -684,7 +741,7 @@ Option<nlohmann::json> Collection::update_matching_filter(const std::string& fil
         auto iter_upper_bound = new rocksdb::Slice(iter_upper_bound_key);
         CollectionManager & collectionManager = CollectionManager::get_instance();
         const std::string seq_id_prefix = get_seq_id_collection_prefix();
-        rocksdb::Iterator* it = collectionManager.get_store()->scan(seq_id_prefix, iter_upper_bound);
+        rocksdb::Iterator* it = collectionManager.get_store()->scan(seq_id_prefix, iter_upper_bound, false);
 
         while(it->Valid()) {
             // Generate a batch of documents to be ingested by add_many.
@@ -693,7 +750,7 @@ Option<nlohmann::json> Collection::update_matching_filter(const std::string& fil
                 it->Next();
                 nlohmann::json existing_document;
                 try {
-                    existing_document = nlohmann::json::parse(json_doc_str);
+                    existing_document = parse_stored_document(json_doc_str);
                 } catch(...) {
                     continue; // Don't add into buffer.
                 }
@@ -750,64 +807,78 @@ bool Collection::is_exceeding_memory_threshold() const {
 void Collection::batch_index(std::vector<index_record>& index_records, std::vector<std::string>& json_out,
                              size_t &num_indexed, const bool& return_doc, const bool& return_id, const size_t remote_embedding_batch_size,
                              const size_t remote_embedding_timeout_ms, const size_t remote_embedding_num_tries) {
+    std::shared_lock backfill_lock(backfill_mutex);
 
     batch_index_in_memory(index_records, remote_embedding_batch_size, remote_embedding_timeout_ms, remote_embedding_num_tries, true);
 
-    // store only documents that were indexed in-memory successfully
+    // store only documents that were indexed in-memory successfully, in a single write for the whole batch
+    rocksdb::WriteBatch batch;
+
     for(auto& index_record: index_records) {
-        nlohmann::json res;
+        if(!index_record.indexed.ok()) {
+            continue;
+        }
 
-        if(index_record.indexed.ok()) {
-            if(index_record.is_update) {
-                remove_flat_fields(index_record.new_doc);
-                for(auto& field: fields) {
-                    if(!field.store) {
-                        index_record.new_doc.erase(field.name);
-                    }
-                }
-                const std::string& serialized_json = index_record.new_doc.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+        nlohmann::json& stored_doc = index_record.is_update ? index_record.new_doc : index_record.doc;
+
+        // remove flattened field values before storing on disk
+        remove_flat_fields(stored_doc);
+        for(auto& field: fields) {
+            if(!field.store) {
+                stored_doc.erase(field.name);
+            }
+        }
+
+        if(!index_record.is_update) {
+            batch.Put(get_doc_id_key(index_record.doc["id"]), std::to_string(index_record.seq_id));
+        }
 
-                bool write_ok = store->insert(get_seq_id_key(index_record.seq_id), serialized_json);
+        // a partial update is written as a merge patch of the stored document, so that it is not serialized whole
+        nlohmann::json patch;
+        if(index_record.is_update && index_record.operation != UPSERT && !index_record.old_doc.empty() &&
+           get_stored_doc_patch(index_record.old_doc, stored_doc, patch)) {
+            if(!patch.empty()) {
+                batch.Merge(get_seq_id_key(index_record.seq_id),
+                            StoreMergeOperator::doc_patch_operand(patch.dump(-1, ' ', false,
+                                                                   nlohmann::detail::error_handler_t::ignore)));
+            }
+            continue;
+        }
+
+        batch.Put(get_seq_id_key(index_record.seq_id), serialize_document(stored_doc));
+    }
+
+    const bool write_ok = (batch.Count() == 0) || store->batch_write(batch);
+
+    for(auto& index_record: index_records) {
+        nlohmann::json res;
+        bool is_plain_success = false;
 
-                if(!write_ok) {
+        if(index_record.indexed.ok()) {
+            if(!write_ok) {
+                if(index_record.is_update) {
                     // we will attempt to reindex the old doc on a best-effort basis
                     LOG(ERROR) << "Update to disk failed. Will restore old document";
                     remove_document(index_record.new_doc, index_record.seq_id, false);
                     index_in_memory(index_record.old_doc, index_record.seq_id, index_record.operation, index_record.dirty_values);
-                    index_record.index_failure(500, "Could not write to on-disk storage.");
                 } else {
-                    num_indexed++;
-                    index_record.index_success();
+                    // remove from in-memory store to keep the state synced
+                    LOG(ERROR) << "Write to disk failed. Will restore old document";
+                    remove_document(index_record.doc, index_record.seq_id, false);
                 }
 
+                index_record.index_failure(500, "Could not write to on-disk storage.");
             } else {
-                // remove flattened field values before storing on disk
-                remove_flat_fields(index_record.doc);
-                for(auto& field: fields) {
-                    if(!field.store) {
-                        index_record.doc.erase(field.name);
-                    }
-                }
-                const std::string& seq_id_str = std::to_string(index_record.seq_id);
-                const std::string& serialized_json = index_record.doc.dump(-1, ' ', false,
-                                                                           nlohmann::detail::error_handler_t::ignore);
-
-                rocksdb::WriteBatch batch;
-                batch.Put(get_doc_id_key(index_record.doc["id"]), seq_id_str);
-                batch.Put(get_seq_id_key(index_record.seq_id), serialized_json);
-                bool write_ok = store->batch_write(batch);
+                num_indexed++;
+                index_record.index_success();
 
-                if(!write_ok) {
-                    // remove from in-memory store to keep the state synced
-                    LOG(ERROR) << "Write to disk failed. Will restore old document";
-                    remove_document(index_record.doc, index_record.seq_id, false);
-                    index_record.index_failure(500, "Could not write to on-disk storage.");
-                } else {
-                    num_indexed++;
-                    index_record.index_success();
+                if(!index_record.is_update) {
+                    doc_ids.add(index_record.doc["id"], index_record.seq_id);
                 }
             }
+
             res["success"] = index_record.indexed.ok();
+            is_plain_success = index_record.indexed.ok() && !return_doc && !return_id;
 
             if (return_doc & index_record.indexed.ok()) {
                 res["document"] = index_record.is_update ? index_record.new_doc : index_record.doc;
@@ -837,18 +908,31 @@ void Collection::batch_index(std::vector<index_record>& index_records, std::vect
             res["code"] = index_record.indexed.code();
         }
 
-        json_out[index_record.position] = res.dump(-1, ' ', false,
-                                                   nlohmann::detail::error_handler_t::ignore);
+        if(is_plain_success) {
+            // most results of a large import are this, so skip serializing it each time
+            static const std::string success_json = R"({"success":true})";
+            json_out[index_record.position] = success_json;
+        } else {
+            json_out[index_record.position] = res.dump(-1, ' ', false,
+                                                       nlohmann::detail::error_handler_t::ignore);
+        }
     }
+
+    advance_write_generation();
 }
 
 Option<uint32_t> Collection::index_in_memory(nlohmann::json &document, uint32_t seq_id,
                                              const index_operation_t op, const DIRTY_VALUES& dirty_values) {
-    std::unique_lock lock(mutex);
+    std::unique_lock write_lock(write_mutex);
+    std::shared_lock lock(mutex);
+
+    // while a background alter is running, writes are indexed on its fields too
+    const auto& indexing_schema = alter_backfill ? alter_backfill->search_schema : search_schema;
+    const auto& indexing_embedding_fields = alter_backfill ? alter_backfill->embedding_fields : embedding_fields;
 
     Option<uint32_t> validation_op = validator_t::validate_index_in_memory(document, seq_id, default_sorting_field,
-                                                                     search_schema, embedding_fields, op, false,
-                                                                     fallback_field_type, dirty_values);
+                                                                     indexing_schema, indexing_embedding_fields, op,
+                                                                     false, fallback_field_type, dirty_values);
 
     if(!validation_op.ok()) {
         return validation_op;
@@ -858,20 +942,39 @@ Option<uint32_t> Collection::index_in_memory(nlohmann::json &document, uint32_t
 
     std::vector<index_record> index_batch;
     index_batch.emplace_back(std::move(rec));
-    Index::batch_memory_index(index, index_batch, default_sorting_field, search_schema, embedding_fields,
-                              fallback_field_type, token_separators, symbols_to_index, true);
+    Index::preprocess_batch(index, index_batch, default_sorting_field, indexing_schema, indexing_embedding_fields,
+                            fallback_field_type, token_separators, symbols_to_index, true);
+
+    // searches read the leaves and posting lists of the index after it has released its own lock
+    lock.unlock();
+    std::unique_lock ulock(mutex);
+    Index::index_preprocessed_batch(index, index_batch, indexing_schema);
 
     num_documents += 1;
+    advance_write_generation();
     return Option<>(200);
 }
 
 size_t Collection::batch_index_in_memory(std::vector<index_record>& index_records, const size_t remote_embedding_batch_size,
                                          const size_t remote_embedding_timeout_ms, const size_t remote_embedding_num_tries, const bool generate_embeddings) {
-    std::unique_lock lock(mutex);
-    size_t num_indexed = Index::batch_memory_index(index, index_records, default_sorting_field,
-                                                   search_schema, embedding_fields, fallback_field_type,
-                                                   token_separators, symbols_to_index, true, remote_embedding_batch_size, remote_embedding_timeout_ms, remote_embedding_num_tries, generate_embeddings);
+    std::unique_lock write_lock(write_mutex);
+    std::shared_lock lock(mutex);
+
+    // while a background alter is running, writes are indexed on its fields too
+    const auto& indexing_schema = alter_backfill ? alter_backfill->search_schema : search_schema;
+    const auto& indexing_embedding_fields = alter_backfill ? alter_backfill->embedding_fields : embedding_fields;
+
+    Index::preprocess_batch(index, index_records, default_sorting_field, indexing_schema, indexing_embedding_fields,
+                            fallback_field_type, token_separators, symbols_to_index, true,
+                            remote_embedding_batch_size, remote_embedding_timeout_ms, remote_embedding_num_tries,
+                            generate_embeddings);
+
+    // searches read the leaves and posting lists of the index after it has released its own lock
+    lock.unlock();
+    std::unique_lock ulock(mutex);
+    size_t num_indexed = Index::index_preprocessed_batch(index, index_records, indexing_schema);
     num_documents += num_indexed;
+    advance_write_generation();
     return num_indexed;
 }
 
@@ -1090,9 +1193,35 @@ void Collection::curate_results(string& actual_query, const string& filter_query
                 }
             }
         } else {
-            // no override tags given
-            for(const auto& override_kv: overrides) {
-                const auto& override = override_kv.second;
+            // no override tags given: evaluate the overrides that can match the query, in the order of their ids
+            std::set<std::string> candidate_ids = any_query_override_ids;
+
+            auto add_candidate_ids = [&](const std::string& the_query) {
+                auto exact_ids_it = exact_rule_override_ids.find(the_query);
+                if(exact_ids_it != exact_rule_override_ids.end()) {
+                    candidate_ids.insert(exact_ids_it->second.begin(), exact_ids_it->second.end());
+                }
+
+                std::vector<std::string> query_tokens;
+                StringUtils::split(the_query, query_tokens, " ");
+                for(const auto& query_token: query_tokens) {
+                    auto contains_ids_it = contains_rule_override_ids.find(query_token);
+                    if(contains_ids_it != contains_rule_override_ids.end()) {
+                        candidate_ids.insert(contains_ids_it->second.begin(), contains_ids_it->second.end());
+                    }
+                }
+            };
+
+            add_candidate_ids(query);
+
+            for(auto id_it = candidate_ids.begin(); id_it != candidate_ids.end(); ++id_it) {
+                auto override_it = overrides.find(*id_it);
+                if(override_it == overrides.end()) {
+                    continue;
+                }
+
+                const auto& override = override_it->second;
+                const std::string prev_query = query;
                 bool wildcard_tag = override.rule.tags.size() == 1 && *override.rule.tags.begin() == "*";
                 bool match_found = does_override_match(override, query, excluded_set, actual_query, filter_query,
                                                        already_segmented, false, wildcard_tag,
@@ -1102,6 +1231,11 @@ void Collection::curate_results(string& actual_query, const string& filter_query
                 if(match_found && override.stop_processing) {
                     break;
                 }
+
+                if(query != prev_query) {
+                    // matched tokens were removed: the overrides that come after can match the remaining query
+                    add_candidate_ids(query);
+                }
             }
         }
     }
@@ -1318,7 +1452,7 @@ Option<bool> Collection::validate_and_standardize_sort_fields(const std::vector<
                         }
 
                         std::string embed_query = embedder_manager.get_query_prefix(vector_field_it.value().embed[fields::model_config]) + q;
-                        auto embedding_op = embedder->Embed(embed_query, remote_embedding_timeout_ms, remote_embedding_num_tries);
+                        auto embedding_op = embedder->embed_query(embed_query, remote_embedding_timeout_ms, remote_embedding_num_tries);
 
                         if(!embedding_op.success) {
                             if(!embedding_op.error["error"].get<std::string>().empty()) {
@@ -1373,7 +1507,7 @@ Option<bool> Collection::validate_and_standardize_sort_fields(const std::vector<
                     }
 
                     std::string embed_query = embedder_manager.get_query_prefix(vector_field_it.value().embed[fields::model_config]) + query;
-                    auto embedding_op = embedder->Embed(embed_query, remote_embedding_timeout_ms, remote_embedding_num_tries);
+                    auto embedding_op = embedder->embed_query(embed_query, remote_embedding_timeout_ms, remote_embedding_num_tries);
 
                     if(!embedding_op.success) {
                         if(!embedding_op.error["error"].get<std::string>().empty()) {
@@ -1697,6 +1831,19 @@ Option<bool> Collection::extract_field_name(const std::string& field_name,
     return Option<bool>(true);
 }
 
+static std::vector<std::vector<std::string>> get_searched_query_tokens(
+                                            const std::vector<std::vector<art_leaf*>>& searched_queries) {
+    std::vector<std::vector<std::string>> query_tokens(searched_queries.size());
+
+    for(size_t i = 0; i < searched_queries.size(); i++) {
+        for(const art_leaf* leaf: searched_queries[i]) {
+            query_tokens[i].emplace_back(reinterpret_cast<const char*>(leaf->key), leaf->key_len - 1);
+        }
+    }
+
+    return query_tokens;
+}
+
 Option<nlohmann::json> Collection::search(std::string raw_query,
                                   const std::vector<std::string>& raw_search_fields,
                                   const std::string & filter_query, const std::vector<std::string>& facet_fields,
@@ -1758,7 +1905,12 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
                                   const std::string& override_tags_str,
                                   const std::string& voice_query,
                                   bool enable_typos_for_numerical_tokens,
-                                  bool enable_lazy_filter) const {
+                                  bool enable_lazy_filter,
+                                  bool profile,
+                                  bool approximate_facets,
+                                  const std::string& search_after,
+                                  total_hits_t total_hits,
+                                  const nlohmann::json& filter_params) const {
     std::shared_lock lock(mutex);
 
     // setup thread local vars
@@ -1768,6 +1920,10 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
                            std::chrono::system_clock::now().time_since_epoch()).count();
     search_cutoff = false;
 
+    std::unique_ptr<search_profile_t> search_profile_info(profile ? new search_profile_t() : nullptr);
+    search_profile_scope_t search_profile_scope(search_profile_info.get());
+    search_profile_timer_t parse_timer("parse");
+
     if(raw_query != "*" && raw_search_fields.empty()) {
         return Option<nlohmann::json>(400, "No search fields specified for the query.");
     }
@@ -1860,14 +2016,17 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
             return Option<nlohmann::json>(400, "Conversation ID provided but conversation is not enabled for this collection.");
         }
 
-        auto conversation_history_op = ConversationManager::get_instance().get_conversation(conversation_id);
+        auto conversation_model_op = ConversationModelManager::get_model(conversation_model_id);
+
+        // only the messages that can make it into the prompt of the model are read
+        auto conversation_history_op = ConversationManager::get_instance().get_conversation_window(
+                                            conversation_id, conversation_model_op.get()["max_bytes"].get<size_t>());
         if(!conversation_history_op.ok()) {
             return Option<nlohmann::json>(400, conversation_history_op.error());
         }
 
-        auto conversation_history = conversation_history_op.get();
-
-        auto conversation_model_op = ConversationModelManager::get_model(conversation_model_id);
+        nlohmann::json conversation_history;
+        conversation_history["conversation"] = conversation_history_op.get();
 
         auto standalone_question_op = ConversationModel::get_standalone_question(conversation_history, raw_query, conversation_model_op.get());
         if(!standalone_question_op.ok()) {
@@ -1957,7 +2116,7 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
                 }
 
                 std::string embed_query = embedder_manager.get_query_prefix(search_field.embed[fields::model_config]) + query;
-                auto embedding_op = embedder->Embed(embed_query, remote_embedding_timeout_ms, remote_embedding_num_tries);
+                auto embedding_op = embedder->embed_query(embed_query, remote_embedding_timeout_ms, remote_embedding_num_tries);
                 if(!embedding_op.success) {
                     if(!embedding_op.error["error"].get<std::string>().empty()) {
                         return Option<nlohmann::json>(400, embedding_op.error["error"].get<std::string>());
@@ -2057,7 +2216,7 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
     const std::string doc_id_prefix = std::to_string(collection_id) + "_" + DOC_ID_PREFIX + "_";
     filter_node_t* filter_tree_root = nullptr;
     Option<bool> parse_filter_op = filter::parse_filter_query(filter_query, search_schema,
-                                                              store, doc_id_prefix, filter_tree_root);
+                                                              store, doc_id_prefix, filter_tree_root, filter_params);
     std::unique_ptr<filter_node_t> filter_tree_root_guard(filter_tree_root);
 
     if(!parse_filter_op.ok()) {
@@ -2068,12 +2227,16 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
     // validate facet fields
     for(const std::string & facet_field: facet_fields) {
         
-        const auto& res = parse_facet(facet_field, facets);
+        const auto& res = parse_facet_cached(facet_field, facets);
         if(!res.ok()){
             return Option<nlohmann::json>(res.code(), res.error());
         }
     }
 
+    for(auto& a_facet: facets) {
+        a_facet.approximate = approximate_facets;
+    }
+
     // parse facet query
     facet_query_t facet_query = {"", ""};
 
@@ -2127,6 +2290,24 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
         return Option<nlohmann::json>(422, message);
     }
 
+    int64_t search_after_scores[3] = {0};
+    uint64_t search_after_key = 0;
+
+    if(!search_after.empty()) {
+        if(page > 1 || page_offset != 0) {
+            return Option<nlohmann::json>(400, "Parameter `search_after` can not be used with `page` or `offset`.");
+        }
+
+        if(!raw_group_by_fields.empty()) {
+            return Option<nlohmann::json>(400, "Parameter `search_after` can not be used with `group_by`.");
+        }
+
+        auto decode_op = decode_search_after(search_after, search_after_scores, search_after_key);
+        if(!decode_op.ok()) {
+            return Option<nlohmann::json>(decode_op.code(), decode_op.error());
+        }
+    }
+
     size_t offset = 0;
 
     if(page == 0 && page_offset != 0) {
@@ -2149,7 +2330,10 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
     size_t max_hits = DEFAULT_TOPSTER_SIZE;
 
     // ensure that `max_hits` never exceeds number of documents in collection
-    if(weighted_search_fields.size() <= 1 || query == "*") {
+    if(!search_after.empty()) {
+        // the hits up to the cursor are left out as they are scored, so only this page has to be ranked
+        max_hits = std::min(fetch_size, get_num_documents());
+    } else if(weighted_search_fields.size() <= 1 || query == "*") {
         max_hits = std::min(std::max(fetch_size, max_hits), get_num_documents());
     } else {
         max_hits = std::min(std::max(fetch_size, max_hits), get_num_documents());
@@ -2209,6 +2393,11 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
         filter_curated_hits = bool(filter_curated_hits_option);
     }
 
+    if(!search_after.empty()) {
+        // curated hits have no place in the sort order, so they are only shown on pages without a cursor
+        included_ids.clear();
+    }
+
     /*for(auto& kv: included_ids) {
         LOG(INFO) << "key: " << kv.first;
         for(auto val: kv.second) {
@@ -2271,6 +2460,12 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
         }
     }
 
+    // vector and hybrid scores, and bucketed text match scores, are ranked after the hits are collected
+    if(!search_after.empty() && (is_vector_query || match_score_index >= 0)) {
+        return Option<nlohmann::json>(400, "Parameter `search_after` can not be used with a vector search or "
+                                           "with `text_match` buckets.");
+    }
+
     //LOG(INFO) << "Num indices used for querying: " << indices.size();
     std::vector<query_tokens_t> field_query_tokens;
     std::vector<std::string> q_tokens;  // used for auxillary highlighting
@@ -2349,32 +2544,80 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
 
     std::unique_ptr<search_args> search_params_guard(search_params);
 
-    auto search_op = index->run_search(search_params, name, facet_index_type, enable_typos_for_numerical_tokens);
+    if(!search_after.empty()) {
+        search_params->topster->set_search_after(search_after_scores, search_after_key);
+    }
 
-    // filter_tree_root might be updated in Index::static_filter_query_eval.
-    filter_tree_root_guard.release();
-    filter_tree_root_guard.reset(filter_tree_root);
+    parse_timer.stop();
 
+    // a search that differs from a recent one only in its page, projection or highlighting reuses its ranked hits
+    const std::string ranked_hits_key = get_ranked_hits_key(search_params, query, vector_query_str,
+                                                            enable_typos_for_numerical_tokens);
+    std::shared_ptr<const ranked_hits_t> ranked_hits;
+    std::vector<std::vector<std::string>> searched_query_tokens;
 
-    if (!search_op.ok()) {
-        return Option<nlohmann::json>(search_op.code(), search_op.error());
+    if(!ranked_hits_key.empty()) {
+        std::unique_lock lock(ranked_hits_cache_mutex);
+        if(ranked_hits_cache.contains(ranked_hits_key)) {
+            auto cached_hits = ranked_hits_cache.lookup(ranked_hits_key);
+            if(cached_hits->fetch_size >= fetch_size && cached_hits->topster->MAX_SIZE >= max_hits) {
+                ranked_hits = cached_hits;
+            }
+        }
     }
 
-    // for grouping we have to re-aggregate
-    Topster& topster = *search_params->topster;
-    Topster& curated_topster = *search_params->curated_topster;
+    if(ranked_hits == nullptr) {
+        auto search_op = index->run_search(search_params, name, facet_index_type, enable_typos_for_numerical_tokens);
+
+        // filter_tree_root might be updated in Index::static_filter_query_eval.
+        filter_tree_root_guard.release();
+        filter_tree_root_guard.reset(filter_tree_root);
+
+        if (!search_op.ok()) {
+            return Option<nlohmann::json>(search_op.code(), search_op.error());
+        }
+
+        search_params->topster->sort(CollectionManager::get_instance().get_thread_pool(), search_params->concurrency);
+        search_params->curated_topster->sort();
+        searched_query_tokens = get_searched_query_tokens(search_params->searched_queries);
 
-    topster.sort();
-    curated_topster.sort();
+        if(!ranked_hits_key.empty() && !search_cutoff && search_params->curated_topster->size == 0) {
+            auto new_ranked_hits = std::make_shared<ranked_hits_t>();
+            new_ranked_hits->topster.reset(search_params->topster);
+            search_params->topster = nullptr;
+            new_ranked_hits->fetch_size = fetch_size;
+            new_ranked_hits->all_result_ids_len = search_params->all_result_ids_len;
+            new_ranked_hits->searched_queries = std::move(searched_query_tokens);
+            new_ranked_hits->qtoken_set = search_params->qtoken_set;
+            for(auto it = new_ranked_hits->qtoken_set.begin(); it != new_ranked_hits->qtoken_set.end(); ++it) {
+                it.value().leaf = nullptr;
+            }
+
+            ranked_hits = new_ranked_hits;
+
+            std::unique_lock lock(ranked_hits_cache_mutex);
+            ranked_hits_cache.insert(ranked_hits_key, ranked_hits);
+        }
+    }
+
+    // the ranked hits are shared with other searches from here on, so they are only read
+    Topster* topster = (ranked_hits != nullptr) ? ranked_hits->topster.get() : search_params->topster;
+    const size_t all_result_ids_len = (ranked_hits != nullptr) ? ranked_hits->all_result_ids_len :
+                                      search_params->all_result_ids_len;
+    const auto& searched_queries = (ranked_hits != nullptr) ? ranked_hits->searched_queries : searched_query_tokens;
+    const auto& qtoken_set = (ranked_hits != nullptr) ? ranked_hits->qtoken_set : search_params->qtoken_set;
 
-    populate_result_kvs(&topster, raw_result_kvs, search_params->groups_processed, sort_fields_std);
-    populate_result_kvs(&curated_topster, override_result_kvs, search_params->groups_processed, sort_fields_std);
+    // for grouping we have to re-aggregate
+    populate_result_kvs(topster, raw_result_kvs, search_params->groups_processed, sort_fields_std,
+                        CollectionManager::get_instance().get_thread_pool(), search_params->concurrency);
+    populate_result_kvs(search_params->curated_topster, override_result_kvs, search_params->groups_processed,
+                        sort_fields_std);
 
     // for grouping we have to aggregate group set sizes to a count value
     if(group_limit) {
         total = search_params->groups_processed.size() + override_result_kvs.size();
     } else {
-        total = search_params->all_result_ids_len;
+        total = all_result_ids_len;
     }
     
 
@@ -2488,13 +2731,15 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
     if(query != "*") {
         process_highlight_fields(weighted_search_fields, raw_search_fields, include_fields_full, exclude_fields_full,
                                  highlight_field_names, highlight_full_field_names, infixes, q_tokens,
-                                 search_params->qtoken_set, highlight_items);
+                                 qtoken_set, highlight_items);
     }
 
     nlohmann::json result = nlohmann::json::object();
-    result["found"] = total;
-    if(group_limit != 0) {
-        result["found_docs"] = search_params->all_result_ids_len;
+    if(total_hits != total_hits_t::none) {
+        result["found"] = total;
+        if(group_limit != 0) {
+            result["found_docs"] = all_result_ids_len;
+        }
     }
 
     if(exclude_fields.count("out_of") == 0) {
@@ -2504,6 +2749,18 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
     std::string hits_key = group_limit ? "grouped_hits" : "hits";
     result[hits_key] = nlohmann::json::array();
 
+    // a full page can be followed by a `search_after` search, from its last hit that is not curated
+    const bool can_search_after = !group_limit && !is_vector_query && match_score_index < 0;
+    if(can_search_after && end_result_index - start_result_index + 1 == long(per_page)) {
+        for(long result_kvs_index = end_result_index; result_kvs_index >= start_result_index; result_kvs_index--) {
+            const KV* kv = result_group_kvs[result_kvs_index][0];
+            if(kv->match_score_index != CURATED_RECORD_IDENTIFIER) {
+                result["next_search_after"] = encode_search_after(kv);
+                break;
+            }
+        }
+    }
+
     uint8_t index_symbols[256] = {};
     for(char c: symbols_to_index) {
         index_symbols[uint8_t(c)] = 1;
@@ -2513,258 +2770,416 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
 
     // handle analytics query expansion
     std::string first_q = raw_query;
-    expand_search_query(raw_query, offset, total, search_params, result_group_kvs, raw_search_fields, first_q);
+    expand_search_query(raw_query, offset, total, searched_queries, result_group_kvs, raw_search_fields, first_q);
 
-    // construct results array
-    for(long result_kvs_index = start_result_index; result_kvs_index <= end_result_index; result_kvs_index++) {
-        const std::vector<KV*> & kv_group = result_group_kvs[result_kvs_index];
+    // hits are decoded only to the extent that the response and the highlights need them
+    doc_projection_t hit_projection;
+    const bool project_hits = ref_include_exclude_fields_vec.empty() &&
+                              (!include_fields_full.empty() || !exclude_fields_full.empty());
 
-        nlohmann::json group_hits;
-        if(group_limit) {
-            group_hits["hits"] = nlohmann::json::array();
+    if(project_hits) {
+        std::vector<std::string> needed_names = group_by_fields;
+        for(const auto& highlight_item: highlight_items) {
+            needed_names.push_back(highlight_item.name);
         }
 
-        nlohmann::json& hits_array = group_limit ? group_hits["hits"] : result["hits"];
-        nlohmann::json group_key = nlohmann::json::array();
-
-        for(const KV* field_order_kv: kv_group) {
-            const std::string& seq_id_key = get_seq_id_key((uint32_t) field_order_kv->key);
+        if(!include_fields_full.empty()) {
+            hit_projection.include_names = include_fields_full;
+            hit_projection.include_names.insert("id");
+            for(const auto& needed_name: needed_names) {
+                hit_projection.include_names.insert(needed_name);
+            }
+        }
 
-            nlohmann::json document;
-            const Option<bool> & document_op = get_document_from_store(seq_id_key, document);
+        for(auto it = exclude_fields_full.begin(); it != exclude_fields_full.end(); ++it) {
+            const std::string& exclude_name = it.key();
+            bool is_needed = false;
 
-            if(!document_op.ok()) {
-                LOG(ERROR) << "Document fetch error. " << document_op.error();
-                continue;
+            for(const auto& needed_name: needed_names) {
+                if(needed_name.compare(0, exclude_name.size(), exclude_name) == 0) {
+                    is_needed = true;
+                    break;
+                }
             }
 
-            nlohmann::json highlight_res = nlohmann::json::object();
-
-            if(!highlight_items.empty()) {
-                copy_highlight_doc(highlight_items, enable_nested_fields, document, highlight_res);
-                remove_flat_fields(highlight_res);
-                remove_reference_helper_fields(highlight_res);
-                highlight_res.erase("id");
+            if(!is_needed) {
+                hit_projection.exclude_names.insert(exclude_name);
             }
+        }
+    }
 
-            nlohmann::json wrapper_doc;
+    search_profile_timer_t hits_timer("hits");
+
+    // documents of the referenced collections that are included in the hits are fetched once for the whole page
+    ref_doc_cache_t page_ref_doc_cache;
+    if(!ref_include_exclude_fields_vec.empty()) {
+        std::vector<const KV*> page_kvs;
+        for(long result_kvs_index = start_result_index; result_kvs_index <= end_result_index; result_kvs_index++) {
+            page_kvs.insert(page_kvs.end(), result_group_kvs[result_kvs_index].begin(),
+                            result_group_kvs[result_kvs_index].end());
+        }
 
-            if(enable_highlight_v1) {
-                wrapper_doc["highlights"] = nlohmann::json::array();
+        auto& cm = CollectionManager::get_instance();
+        for(const auto& ref_include_exclude: ref_include_exclude_fields_vec) {
+            auto ref_collection = cm.get_collection(ref_include_exclude.collection_name);
+            if(ref_collection != nullptr) {
+                ref_collection->prefetch_ref_documents(page_kvs);
             }
+        }
+    }
 
-            std::vector<highlight_t> highlights;
-            StringUtils string_utils;
+    std::vector<const KV*> page_hit_kvs;
+    for(long result_kvs_index = start_result_index; result_kvs_index <= end_result_index; result_kvs_index++) {
+        page_hit_kvs.insert(page_hit_kvs.end(), result_group_kvs[result_kvs_index].begin(),
+                            result_group_kvs[result_kvs_index].end());
+    }
 
-            tsl::htrie_set<char> hfield_names;
-            tsl::htrie_set<char> h_full_field_names;
+    // the documents of the page are fetched with a single batched store lookup
+    std::vector<std::string> page_seq_id_keys;
+    for(const KV* field_order_kv: page_hit_kvs) {
+        page_seq_id_keys.push_back(get_seq_id_key((uint32_t) field_order_kv->key));
+    }
 
-            for(size_t i = 0; i < highlight_items.size(); i++) {
-                auto& highlight_item = highlight_items[i];
-                const std::string& field_name = highlight_item.name;
-                if(search_schema.count(field_name) == 0) {
-                    continue;
-                }
+    std::vector<std::string> page_stored_docs;
+    std::vector<StoreStatus> page_doc_statuses;
+    store->multi_get(page_seq_id_keys, page_stored_docs, page_doc_statuses);
 
-                field search_field = search_schema.at(field_name);
+    // The documents of the page are prepared independently of each other, in parallel when the page is large
+    // enough, and then put together in the order of their rank.
+    struct page_hit_t {
+        bool found = false;
+        nlohmann::json wrapper_doc;
+        nlohmann::json group_key = nlohmann::json::array();
+        Option<bool> prune_op = Option<bool>(true);
+    };
 
-                if(query != "*") {
-                    highlight_t highlight;
-                    highlight.field = search_field.name;
+    std::vector<page_hit_t> page_hits(page_seq_id_keys.size());
 
-                    bool found_highlight = false;
-                    bool found_full_highlight = false;
+    auto prepare_hit = [&](size_t page_doc_index, const KV* field_order_kv) {
+        page_hit_t& page_hit = page_hits[page_doc_index];
+        const std::string& seq_id_key = page_seq_id_keys[page_doc_index];
+        std::string stored_doc = std::move(page_stored_docs[page_doc_index]);
+        const StoreStatus stored_doc_status = page_doc_statuses[page_doc_index];
 
-                    highlight_result(raw_query, search_field, i, highlight_item.qtoken_leaves, field_order_kv,
-                                     document, highlight_res,
-                                     string_utils, snippet_threshold,
-                                     highlight_affix_num_tokens, highlight_item.fully_highlighted, highlight_item.infix,
-                                     highlight_start_tag, highlight_end_tag, index_symbols, highlight,
-                                     found_highlight, found_full_highlight);
-                    if(!highlight.snippets.empty()) {
-                        highlights.push_back(highlight);
-                    }
+        nlohmann::json document;
+        const Option<bool> & document_op = parse_document_from_store(seq_id_key, stored_doc_status, stored_doc,
+                                                                     document, false,
+                                                                     project_hits ? &hit_projection : nullptr);
 
-                    if(found_highlight) {
-                        hfield_names.insert(search_field.name);
-                        if(found_full_highlight) {
-                            h_full_field_names.insert(search_field.name);
-                        }
-                    }
-                }
-            }
+        if(!document_op.ok()) {
+            LOG(ERROR) << "Document fetch error. " << document_op.error();
+            return ;
+        }
 
-            // explicit highlight fields could be parent of searched fields, so we will take a pass at that
-            for(auto& hfield_name: highlight_full_field_names) {
-                auto it = h_full_field_names.equal_prefix_range(hfield_name);
-                if(it.first != it.second) {
-                    h_full_field_names.insert(hfield_name);
-                }
-            }
+        // hits prepared after the search has run out of time are returned without highlights and references
+        const bool past_deadline = search_deadline_t::check_expired();
 
-            if(highlight_field_names.empty()) {
-                for(auto& raw_search_field: raw_search_fields) {
-                    auto it = hfield_names.equal_prefix_range(raw_search_field);
-                    if(it.first != it.second) {
-                        hfield_names.insert(raw_search_field);
-                    }
-                }
-            } else {
-                for(auto& hfield_name: highlight_field_names) {
-                    auto it = hfield_names.equal_prefix_range(hfield_name);
-                    if(it.first != it.second) {
-                        hfield_names.insert(hfield_name);
-                    }
-                }
-            }
+        nlohmann::json highlight_res = nlohmann::json::object();
 
-            // remove fields from highlight doc that were not highlighted
-            if(!hfield_names.empty()) {
-                prune_doc(highlight_res, hfield_names, tsl::htrie_set<char>(), "");
-            } else {
-                highlight_res.clear();
-            }
+        if(!highlight_items.empty()) {
+            copy_highlight_doc(highlight_items, enable_nested_fields, document, highlight_res);
+            remove_flat_fields(highlight_res);
+            remove_reference_helper_fields(highlight_res);
+            highlight_res.erase("id");
+        }
 
-            if(enable_highlight_v1) {
-                std::sort(highlights.begin(), highlights.end());
+        nlohmann::json& wrapper_doc = page_hit.wrapper_doc;
 
-                for(const auto & highlight: highlights) {
-                    auto field_it = search_schema.find(highlight.field);
-                    if(field_it == search_schema.end() || field_it->nested) {
-                        // nested field highlighting will be available only in the new highlight structure.
-                        continue;
-                    }
+        if(enable_highlight_v1) {
+            wrapper_doc["highlights"] = nlohmann::json::array();
+        }
 
-                    nlohmann::json h_json = nlohmann::json::object();
-                    h_json["field"] = highlight.field;
+        std::vector<highlight_t> highlights;
+        StringUtils string_utils;
 
-                    if(!highlight.indices.empty()) {
-                        h_json["matched_tokens"] = highlight.matched_tokens;
-                        h_json["indices"] = highlight.indices;
-                        h_json["snippets"] = highlight.snippets;
-                        if(!highlight.values.empty()) {
-                            h_json["values"] = highlight.values;
-                        }
-                    } else {
-                        h_json["matched_tokens"] = highlight.matched_tokens[0];
-                        h_json["snippet"] = highlight.snippets[0];
-                        if(!highlight.values.empty() && !highlight.values[0].empty()) {
-                            h_json["value"] = highlight.values[0];
-                        }
-                    }
+        tsl::htrie_set<char> hfield_names;
+        tsl::htrie_set<char> h_full_field_names;
 
-                    wrapper_doc["highlights"].push_back(h_json);
-                }
+        for(size_t i = 0; i < highlight_items.size(); i++) {
+            auto& highlight_item = highlight_items[i];
+            const std::string& field_name = highlight_item.name;
+            if(search_schema.count(field_name) == 0) {
+                continue;
             }
 
-            //wrapper_doc["seq_id"] = (uint32_t) field_order_kv->key;
+            field search_field = search_schema.at(field_name);
 
-            if(group_limit && group_key.empty()) {
-                for(const auto& field_name: group_by_fields) {
-                    if(document.count(field_name) != 0) {
-                        group_key.push_back(document[field_name]);
+            if(query != "*" && !past_deadline) {
+                highlight_t highlight;
+                highlight.field = search_field.name;
+
+                bool found_highlight = false;
+                bool found_full_highlight = false;
+
+                search_profile_timer_t highlight_timer("highlight");
+                highlight_result(raw_query, search_field, i, highlight_item.qtoken_leaves, field_order_kv,
+                                 document, highlight_res,
+                                 string_utils, snippet_threshold,
+                                 highlight_affix_num_tokens, highlight_item.fully_highlighted, highlight_item.infix,
+                                 highlight_start_tag, highlight_end_tag, index_symbols, highlight,
+                                 found_highlight, found_full_highlight);
+                highlight_timer.stop();
+                if(!highlight.snippets.empty()) {
+                    highlights.push_back(highlight);
+                }
+
+                if(found_highlight) {
+                    hfield_names.insert(search_field.name);
+                    if(found_full_highlight) {
+                        h_full_field_names.insert(search_field.name);
                     }
                 }
             }
+        }
 
-            remove_flat_fields(document);
-            remove_reference_helper_fields(document);
-
-            auto prune_op = prune_doc(document,
-                                      include_fields_full,
-                                      exclude_fields_full,
-                                      "",
-                                      0,
-                                      field_order_kv->reference_filter_results,
-                                      const_cast<Collection *>(this), get_seq_id_from_key(seq_id_key),
-                                      ref_include_exclude_fields_vec);
-            if (!prune_op.ok()) {
-                return Option<nlohmann::json>(prune_op.code(), prune_op.error());
+        // explicit highlight fields could be parent of searched fields, so we will take a pass at that
+        for(auto& hfield_name: highlight_full_field_names) {
+            auto it = h_full_field_names.equal_prefix_range(hfield_name);
+            if(it.first != it.second) {
+                h_full_field_names.insert(hfield_name);
             }
+        }
 
-            if(conversation) {
-                docs_array.push_back(document);
-            }
-
-            wrapper_doc["document"] = document;
-            wrapper_doc["highlight"] = highlight_res;
-
-            if(field_order_kv->match_score_index == CURATED_RECORD_IDENTIFIER) {
-                wrapper_doc["curated"] = true;
-            } else if(field_order_kv->match_score_index >= 0) {
-                wrapper_doc["text_match"] = field_order_kv->text_match_score;
-                wrapper_doc["text_match_info"] = nlohmann::json::object();
-                populate_text_match_info(wrapper_doc["text_match_info"],
-                                        field_order_kv->text_match_score, match_type,
-                                         field_query_tokens[0].q_include_tokens.size());
-                if(!vector_query.field_name.empty()) {
-                    wrapper_doc["hybrid_search_info"] = nlohmann::json::object();
-                    wrapper_doc["hybrid_search_info"]["rank_fusion_score"] = Index::int64_t_to_float(field_order_kv->scores[field_order_kv->match_score_index]);
+        if(highlight_field_names.empty()) {
+            for(auto& raw_search_field: raw_search_fields) {
+                auto it = hfield_names.equal_prefix_range(raw_search_field);
+                if(it.first != it.second) {
+                    hfield_names.insert(raw_search_field);
+                }
+            }
+        } else {
+            for(auto& hfield_name: highlight_field_names) {
+                auto it = hfield_names.equal_prefix_range(hfield_name);
+                if(it.first != it.second) {
+                    hfield_names.insert(hfield_name);
                 }
             }
+        }
+
+        // remove fields from highlight doc that were not highlighted
+        if(!hfield_names.empty()) {
+            prune_doc(highlight_res, hfield_names, tsl::htrie_set<char>(), "");
+        } else {
+            highlight_res.clear();
+        }
+
+        if(enable_highlight_v1) {
+            std::sort(highlights.begin(), highlights.end());
 
-            nlohmann::json geo_distances;
+            for(const auto & highlight: highlights) {
+                auto field_it = search_schema.find(highlight.field);
+                if(field_it == search_schema.end() || field_it->nested) {
+                    // nested field highlighting will be available only in the new highlight structure.
+                    continue;
+                }
 
-            for(size_t sort_field_index = 0; sort_field_index < sort_fields_std.size(); sort_field_index++) {
-                const auto& sort_field = sort_fields_std[sort_field_index];
-                if(sort_field.geopoint != 0) {
-                    geo_distances[sort_field.name] = std::abs(field_order_kv->scores[sort_field_index]);
+                nlohmann::json h_json = nlohmann::json::object();
+                h_json["field"] = highlight.field;
+
+                if(!highlight.indices.empty()) {
+                    h_json["matched_tokens"] = highlight.matched_tokens;
+                    h_json["indices"] = highlight.indices;
+                    h_json["snippets"] = highlight.snippets;
+                    if(!highlight.values.empty()) {
+                        h_json["values"] = highlight.values;
+                    }
+                } else {
+                    h_json["matched_tokens"] = highlight.matched_tokens[0];
+                    h_json["snippet"] = highlight.snippets[0];
+                    if(!highlight.values.empty() && !highlight.values[0].empty()) {
+                        h_json["value"] = highlight.values[0];
+                    }
                 }
-            }
 
-            if(!geo_distances.empty()) {
-                wrapper_doc["geo_distance_meters"] = geo_distances;
+                wrapper_doc["highlights"].push_back(h_json);
             }
+        }
 
-            if(!vector_query.field_name.empty() && field_order_kv->vector_distance >= 0) {
-                wrapper_doc["vector_distance"] = field_order_kv->vector_distance;
+        //wrapper_doc["seq_id"] = (uint32_t) field_order_kv->key;
+
+        if(group_limit) {
+            for(const auto& field_name: group_by_fields) {
+                if(document.count(field_name) != 0) {
+                    page_hit.group_key.push_back(document[field_name]);
+                }
             }
+        }
 
-            hits_array.push_back(wrapper_doc);
+        remove_flat_fields(document);
+        remove_reference_helper_fields(document);
+
+        auto prune_op = prune_doc(document,
+                                  include_fields_full,
+                                  exclude_fields_full,
+                                  "",
+                                  0,
+                                  field_order_kv->get_reference_filter_results(),
+                                  const_cast<Collection *>(this), get_seq_id_from_key(seq_id_key),
+                                  past_deadline ? std::vector<ref_include_exclude_fields>() :
+                                                  ref_include_exclude_fields_vec);
+        if (!prune_op.ok()) {
+            page_hit.prune_op = prune_op;
+            return ;
         }
 
-        if(group_limit) {
-            group_hits["group_key"] = group_key;
+        wrapper_doc["document"] = document;
+        wrapper_doc["highlight"] = highlight_res;
 
-            const auto& itr = search_params->groups_processed.find(kv_group[0]->distinct_key);
-            
-            if(itr != search_params->groups_processed.end()) {
-                group_hits["found"] = itr->second;
+        if(field_order_kv->match_score_index == CURATED_RECORD_IDENTIFIER) {
+            wrapper_doc["curated"] = true;
+        } else if(field_order_kv->match_score_index >= 0) {
+            wrapper_doc["text_match"] = field_order_kv->text_match_score;
+            wrapper_doc["text_match_info"] = nlohmann::json::object();
+            populate_text_match_info(wrapper_doc["text_match_info"],
+                                    field_order_kv->text_match_score, match_type,
+                                     field_query_tokens[0].q_include_tokens.size());
+            if(!vector_query.field_name.empty()) {
+                wrapper_doc["hybrid_search_info"] = nlohmann::json::object();
+                wrapper_doc["hybrid_search_info"]["rank_fusion_score"] = Index::int64_t_to_float(field_order_kv->scores[field_order_kv->match_score_index]);
             }
-            result["grouped_hits"].push_back(group_hits);
         }
-    }
 
-    if(conversation) {
-        result["conversation"] = nlohmann::json::object();
-        result["conversation"]["query"] = raw_query;
+        nlohmann::json geo_distances;
 
-        // remove all fields with vector type from docs_array
-        for(const auto& field : search_schema) {
-            if(field.type == field_types::FLOAT_ARRAY && field.num_dim > 0) {
-                for(auto& doc : docs_array) {
-                    doc.erase(field.name);
-                }
+        for(size_t sort_field_index = 0; sort_field_index < sort_fields_std.size(); sort_field_index++) {
+            const auto& sort_field = sort_fields_std[sort_field_index];
+            if(sort_field.geopoint != 0) {
+                geo_distances[sort_field.name] = std::abs(field_order_kv->scores[sort_field_index]);
             }
         }
 
-        auto conversation_model = ConversationModelManager::get_model(conversation_model_id).get();
-        auto min_required_bytes_op = ConversationModel::get_minimum_required_bytes(conversation_model);
-        if(!min_required_bytes_op.ok()) {
-            return Option<nlohmann::json>(min_required_bytes_op.code(), min_required_bytes_op.error());
+        if(!geo_distances.empty()) {
+            wrapper_doc["geo_distance_meters"] = geo_distances;
         }
-        auto min_required_bytes = min_required_bytes_op.get();
-        if(conversation_model["max_bytes"].get<size_t>() < min_required_bytes + raw_query.size()) { 
-            return Option<nlohmann::json>(400, "`max_bytes` of the conversation model is less than the minimum required bytes(" + std::to_string(min_required_bytes) + ").");
+
+        if(!vector_query.field_name.empty() && field_order_kv->vector_distance >= 0) {
+            wrapper_doc["vector_distance"] = field_order_kv->vector_distance;
         }
-        // remove document with lowest score until total tokens is less than MAX_TOKENS
-        while(docs_array.dump(0).size() > conversation_model["max_bytes"].get<size_t>() - min_required_bytes - raw_query.size()) {
-            try {
-                if(docs_array.empty()) {
-                    break;
-                }
-                docs_array.erase(docs_array.size() - 1);
-            } catch(...) {
+
+        page_hit.found = true;
+    };
+
+    const size_t hits_parallel_threshold = Config::get_instance().get_hits_parallel_threshold();
+    ThreadPool* thread_pool = CollectionManager::get_instance().get_thread_pool();
+    size_t parallelism = 1;
+
+    // the documents of referenced collections included in the hits are cached for this thread only
+    if(hits_parallel_threshold != 0 && page_hit_kvs.size() >= hits_parallel_threshold && thread_pool != nullptr &&
+       ref_include_exclude_fields_vec.empty()) {
+        parallelism = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(),
+                                                           page_hit_kvs.size() / PARALLEL_HITS_PER_TASK));
+    }
+
+    const size_t partition_size = (page_hit_kvs.size() + parallelism - 1) / parallelism;
+    auto prepare_partition = [&](size_t partition) {
+        const size_t end_index = std::min(page_hit_kvs.size(), (partition + 1) * partition_size);
+        for(size_t page_doc_index = partition * partition_size; page_doc_index < end_index; page_doc_index++) {
+            prepare_hit(page_doc_index, page_hit_kvs[page_doc_index]);
+        }
+    };
+
+    const auto parent_deadline = search_deadline_t::current();
+    const auto parent_request_cost = request_cost;
+    std::atomic<bool> tasks_cutoff = false;
+
+    std::vector<std::unique_ptr<pool_task_t>> partition_tasks;
+    for(size_t partition = 1; partition < parallelism; partition++) {
+        partition_tasks.emplace_back(new pool_task_t(thread_pool,
+                                                     [&prepare_partition, &parent_deadline, parent_request_cost,
+                                                      &tasks_cutoff, partition]() {
+            search_deadline_scope_t deadline_scope(parent_deadline, &tasks_cutoff);
+            request_cost_scope_t cost_scope(parent_request_cost);
+            prepare_partition(partition);
+        }));
+    }
+
+    prepare_partition(0);
+
+    for(auto& partition_task: partition_tasks) {
+        partition_task->wait();
+    }
+
+    search_cutoff = search_cutoff || tasks_cutoff;
+
+    size_t page_doc_index = 0;
+
+    // construct results array
+    for(long result_kvs_index = start_result_index; result_kvs_index <= end_result_index; result_kvs_index++) {
+        const std::vector<KV*> & kv_group = result_group_kvs[result_kvs_index];
+
+        nlohmann::json group_hits;
+        if(group_limit) {
+            group_hits["hits"] = nlohmann::json::array();
+        }
+
+        nlohmann::json& hits_array = group_limit ? group_hits["hits"] : result["hits"];
+        nlohmann::json group_key = nlohmann::json::array();
+
+        for(size_t kv_group_index = 0; kv_group_index < kv_group.size(); kv_group_index++) {
+            page_hit_t& page_hit = page_hits[page_doc_index++];
+            if(!page_hit.prune_op.ok()) {
+                return Option<nlohmann::json>(page_hit.prune_op.code(), page_hit.prune_op.error());
+            }
+
+            if(!page_hit.found) {
+                continue;
+            }
+
+            if(group_limit && group_key.empty()) {
+                group_key = std::move(page_hit.group_key);
+            }
+
+            if(conversation) {
+                docs_array.push_back(page_hit.wrapper_doc["document"]);
+            }
+
+            hits_array.push_back(std::move(page_hit.wrapper_doc));
+        }
+
+        if(group_limit) {
+            group_hits["group_key"] = group_key;
+
+            const auto& itr = search_params->groups_processed.find(kv_group[0]->distinct_key);
+            
+            if(itr != search_params->groups_processed.end()) {
+                group_hits["found"] = itr->second;
+            }
+            result["grouped_hits"].push_back(group_hits);
+        }
+    }
+
+    hits_timer.stop();
+
+    if(conversation) {
+        result["conversation"] = nlohmann::json::object();
+        result["conversation"]["query"] = raw_query;
+
+        // remove all fields with vector type from docs_array
+        for(const auto& field : search_schema) {
+            if(field.type == field_types::FLOAT_ARRAY && field.num_dim > 0) {
+                for(auto& doc : docs_array) {
+                    doc.erase(field.name);
+                }
+            }
+        }
+
+        auto conversation_model = ConversationModelManager::get_model(conversation_model_id).get();
+        auto min_required_bytes_op = ConversationModel::get_minimum_required_bytes(conversation_model);
+        if(!min_required_bytes_op.ok()) {
+            return Option<nlohmann::json>(min_required_bytes_op.code(), min_required_bytes_op.error());
+        }
+        auto min_required_bytes = min_required_bytes_op.get();
+        if(conversation_model["max_bytes"].get<size_t>() < min_required_bytes + raw_query.size()) { 
+            return Option<nlohmann::json>(400, "`max_bytes` of the conversation model is less than the minimum required bytes(" + std::to_string(min_required_bytes) + ").");
+        }
+        // remove document with lowest score until total tokens is less than MAX_TOKENS
+        while(docs_array.dump(0).size() > conversation_model["max_bytes"].get<size_t>() - min_required_bytes - raw_query.size()) {
+            try {
+                if(docs_array.empty()) {
+                    break;
+                }
+                docs_array.erase(docs_array.size() - 1);
+            } catch(...) {
                 return Option<nlohmann::json>(400, "Failed to remove document from search results.");
             }
         }
@@ -2825,9 +3240,19 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
     }
 
     result["facet_counts"] = nlohmann::json::array();
-    
+
+    search_profile_timer_t facet_counts_timer("facet_counts");
+
     // populate facets
     for(facet& a_facet: facets) {
+        if(search_profile_info != nullptr) {
+            std::string facet_strategy = a_facet.is_intersected ? "value_index" : "hash";
+            if(a_facet.sampled) {
+                facet_strategy += "_sampled";
+            }
+            search_profile_info->set_facet_strategy(a_facet.field_name, facet_strategy, a_facet.strategy_basis);
+        }
+
         // Don't return zero counts for a wildcard facet.
         if (a_facet.is_wildcard_match &&
                 (((a_facet.is_intersected && a_facet.value_result_map.empty())) ||
@@ -2845,6 +3270,9 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
         nlohmann::json facet_result = nlohmann::json::object();
         facet_result["field_name"] = a_facet.field_name;
         facet_result["sampled"] = a_facet.sampled;
+        if(a_facet.approximate) {
+            facet_result["approximate"] = true;
+        }
         facet_result["counts"] = nlohmann::json::array();
 
         std::vector<facet_value_t> facet_values;
@@ -2990,15 +3418,25 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
 
                 const auto& highlighted_text = highlight.snippets.empty() ? value : highlight.snippets[0];
                 facet_value_t facet_value = {value, highlighted_text, facet_count.count,
-                                             facet_count.sort_field_val, parent};
+                                             facet_count.sort_field_val, parent, facet_count.error_bound};
                 facet_values.emplace_back(facet_value);
             }
         }
 
+        // a facet can ask for thousands of values, which are then sorted side by side
+        auto sort_facet_values = [&](auto compare) {
+            ThreadPool* thread_pool = CollectionManager::get_instance().get_thread_pool();
+            if(thread_pool != nullptr && facet_values.size() >= ThreadPool::PARALLEL_SORT_MIN_SIZE) {
+                thread_pool->parallel_sort(facet_values.begin(), facet_values.end(), compare,
+                                           search_params->concurrency, ThreadPool::HIGH_PRIORITY);
+            } else {
+                std::stable_sort(facet_values.begin(), facet_values.end(), compare);
+            }
+        };
+
         if(a_facet.is_sort_by_alpha) {
             bool is_asc = a_facet.sort_order == "asc";
-            std::stable_sort(facet_values.begin(), facet_values.end(),
-                             [&] (const auto& fv1, const auto& fv2) {
+            sort_facet_values([&] (const facet_value_t& fv1, const facet_value_t& fv2) {
                 if(is_asc) {
                     return fv1.value < fv2.value;
                 }
@@ -3007,8 +3445,7 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
             });
         } else if(!a_facet.sort_field.empty()) {
             bool is_asc = a_facet.sort_order == "asc";
-            std::stable_sort(facet_values.begin(), facet_values.end(),
-                             [&] (const auto& fv1, const auto& fv2) {
+            sort_facet_values([&] (const facet_value_t& fv1, const facet_value_t& fv2) {
                 if(is_asc) {
                     return fv1.sort_field_val < fv2.sort_field_val;
                 }
@@ -3016,7 +3453,7 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
                 return fv1.sort_field_val > fv2.sort_field_val;
             });
         } else {
-            std::stable_sort(facet_values.begin(), facet_values.end(), Collection::facet_count_str_compare);
+            sort_facet_values(Collection::facet_count_str_compare);
         }
 
         for(const auto & facet_count: facet_values) {
@@ -3027,6 +3464,10 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
             facet_value_count["highlighted"] = facet_count.highlighted;
             facet_value_count["count"] = facet_count.count;
 
+            if(a_facet.approximate) {
+                facet_value_count["count_error"] = facet_count.count_error;
+            }
+
             if(!facet_count.parent.empty()) {
                 facet_value_count["parent"] = facet_count.parent;
             }
@@ -3046,8 +3487,14 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
         result["facet_counts"].push_back(facet_result);
     }
 
+    facet_counts_timer.stop();
+
     result["search_cutoff"] = search_cutoff;
 
+    if(search_profile_info != nullptr) {
+        result["profile"] = search_profile_info->to_json();
+    }
+
     result["request_params"] = nlohmann::json::object();
     result["request_params"]["collection_name"] = name;
     result["request_params"]["per_page"] = per_page;
@@ -3068,14 +3515,15 @@ Option<nlohmann::json> Collection::search(std::string raw_query,
     return Option<nlohmann::json>(result);
 }
 
-void Collection::expand_search_query(const string& raw_query, size_t offset, size_t total, const search_args* search_params,
-                                    const std::vector<std::vector<KV*>>& result_group_kvs,
-                                    const std::vector<std::string>& raw_search_fields, string& first_q) const {
+void Collection::expand_search_query(const string& raw_query, size_t offset, size_t total,
+                                     const std::vector<std::vector<std::string>>& searched_queries,
+                                     const std::vector<std::vector<KV*>>& result_group_kvs,
+                                     const std::vector<std::string>& raw_search_fields, string& first_q) const {
     if(!Config::get_instance().get_enable_search_analytics()) {
         return ;
     }
 
-    if(offset == 0 && !raw_search_fields.empty() && !search_params->searched_queries.empty() &&
+    if(offset == 0 && !raw_search_fields.empty() && !searched_queries.empty() &&
         total != 0 && !result_group_kvs.empty()) {
         // we have to map raw_query (which could contain a prefix) back to expanded version
         auto search_field_it = search_schema.find(raw_search_fields[0]);
@@ -3085,19 +3533,18 @@ void Collection::expand_search_query(const string& raw_query, size_t offset, siz
 
         first_q = "";
         auto q_index = result_group_kvs[0][0]->query_index;
-        if(q_index >= search_params->searched_queries.size()) {
+        if(q_index >= searched_queries.size()) {
             return ;
         }
 
-        const auto& qleaves = search_params->searched_queries[q_index];
+        const auto& qtokens = searched_queries[q_index];
         Tokenizer tokenizer(raw_query, true, false, search_field_it->locale, symbols_to_index, token_separators);
         std::string raw_token;
         size_t raw_token_index = 0, tok_start = 0, tok_end = 0;
 
         while(tokenizer.next(raw_token, raw_token_index, tok_start, tok_end)) {
-            if(raw_token_index < qleaves.size()) {
-                auto leaf = qleaves[raw_token_index];
-                std::string tok(reinterpret_cast<char*>(leaf->key), leaf->key_len - 1);
+            if(raw_token_index < qtokens.size()) {
+                const auto& tok = qtokens[raw_token_index];
                 if(StringUtils::begins_with(tok, raw_token)) {
                     first_q += tok + " ";
                 }
@@ -3110,6 +3557,119 @@ void Collection::expand_search_query(const string& raw_query, size_t offset, siz
     }
 }
 
+static void append_key_part(std::string& key, const std::string& part) {
+    key += std::to_string(part.size());
+    key += ':';
+    key += part;
+}
+
+std::string Collection::get_ranked_hits_key(const search_args* search_params, const std::string& query,
+                                            const std::string& vector_query_str,
+                                            bool enable_typos_for_numerical_tokens) const {
+    if(!search_params->facets.empty() || search_params->group_limit != 0 || !search_params->included_ids.empty() ||
+       !search_params->excluded_ids.empty() || search_params->topster->has_search_after) {
+        return "";
+    }
+
+    std::string key = std::to_string(write_generation.load());
+    append_key_part(key, query);
+    append_key_part(key, vector_query_str);
+
+    if(!vector_query_str.empty()) {
+        // the number of nearest neighbors can follow the page size
+        append_key_part(key, std::to_string(search_params->per_page));
+    }
+
+    if(search_params->filter_tree_root != nullptr) {
+        // filters with references depend on the documents of other collections
+        const std::string filter_key = filter_result_cache_t::get_key(search_params->filter_tree_root);
+        if(filter_key.empty()) {
+            return "";
+        }
+
+        append_key_part(key, filter_key);
+    }
+
+    for(const auto& sort_field: search_params->sort_fields_std) {
+        // bucketed text match scores are changed in place while the hits are merged
+        if(sort_field.text_match_buckets != 0 || sort_field.name == sort_field_const::vector_query ||
+           !sort_field.reference_collection_name.empty()) {
+            return "";
+        }
+
+        append_key_part(key, sort_field.name);
+        append_key_part(key, sort_field.order);
+        append_key_part(key, std::to_string(sort_field.geopoint) + "," + std::to_string(sort_field.exclude_radius) +
+                             "," + std::to_string(sort_field.geo_precision) + "," +
+                             std::to_string(sort_field.missing_values));
+
+        for(const auto& eval_expression: sort_field.eval_expressions) {
+            append_key_part(key, eval_expression);
+        }
+
+        for(const auto& eval_score: sort_field.eval.scores) {
+            append_key_part(key, std::to_string(eval_score));
+        }
+    }
+
+    for(const auto& search_field: search_params->search_fields) {
+        append_key_part(key, search_field.name);
+        append_key_part(key, std::to_string(search_field.weight) + "," + std::to_string(search_field.num_typos) +
+                             "," + std::to_string(search_field.prefix) + "," + std::to_string(search_field.infix));
+    }
+
+    // the tokens are those left after stopwords and overrides are applied
+    if(!search_params->field_query_tokens.empty()) {
+        const auto& query_tokens = search_params->field_query_tokens[0];
+        for(const auto& token: query_tokens.q_include_tokens) {
+            append_key_part(key, token.value);
+        }
+
+        key += '-';
+        for(const auto& exclude_tokens: query_tokens.q_exclude_tokens) {
+            append_key_part(key, StringUtils::join(exclude_tokens, " "));
+        }
+
+        key += '"';
+        for(const auto& phrase: query_tokens.q_phrases) {
+            append_key_part(key, StringUtils::join(phrase, " "));
+        }
+    }
+
+    std::string params;
+    for(const auto num_typos: search_params->num_typos) {
+        params += std::to_string(num_typos) + ",";
+    }
+
+    for(const auto prefix: search_params->prefixes) {
+        params += std::to_string(prefix) + ",";
+    }
+
+    for(const auto infix: search_params->infixes) {
+        params += std::to_string(infix) + ",";
+    }
+
+    params += std::to_string(search_params->match_type) + "," + std::to_string(search_params->token_order) + "," +
+              std::to_string(search_params->drop_tokens_threshold) + "," +
+              std::to_string(search_params->typo_tokens_threshold) + "," +
+              std::to_string(search_params->prioritize_exact_match) + "," +
+              std::to_string(search_params->prioritize_token_position) + "," +
+              std::to_string(search_params->prioritize_num_matching_fields) + "," +
+              std::to_string(search_params->exhaustive_search) + "," +
+              std::to_string(search_params->min_len_1typo) + "," + std::to_string(search_params->min_len_2typo) + "," +
+              std::to_string(search_params->max_candidates) + "," + std::to_string(search_params->max_extra_prefix) +
+              "," + std::to_string(search_params->max_extra_suffix) + "," +
+              std::to_string(search_params->split_join_tokens) + "," +
+              std::to_string(search_params->drop_tokens_mode.mode) + "," +
+              std::to_string(search_params->drop_tokens_mode.token_limit) + "," +
+              std::to_string(enable_typos_for_numerical_tokens);
+
+    append_key_part(key, params);
+    append_key_part(key, search_params->default_sorting_field);
+
+    return key;
+}
+
 void Collection::copy_highlight_doc(std::vector<highlight_field_t>& hightlight_items,
                                     const bool nested_fields_enabled,
                                     const nlohmann::json& src, nlohmann::json& dst) {
@@ -3426,11 +3986,11 @@ void Collection::parse_search_query(const std::string &query, std::vector<std::s
         q_include_tokens = {query};
     } else {
         std::vector<std::string> tokens;
-        stopword_struct_t stopwordStruct;
+        std::shared_ptr<const compiled_stopwords_t> stopwords;
         if(!stopwords_set.empty()) {
-            const auto &stopword_op = StopwordsManager::get_instance().get_stopword(stopwords_set, stopwordStruct);
-            if (!stopword_op.ok()) {
-                LOG(ERROR) << stopword_op.error();
+            stopwords = StopwordsManager::get_instance().get_compiled_stopwords(stopwords_set);
+            if(stopwords == nullptr) {
+                LOG(ERROR) << "Stopword `" + stopwords_set + "` not found.";
                 LOG(ERROR) << "Error fetching stopword_list for stopword " << stopwords_set;
             }
         }
@@ -3445,8 +4005,10 @@ void Collection::parse_search_query(const std::string &query, std::vector<std::s
             Tokenizer(query, true, false, locale, custom_symbols, token_separators).tokenize(tokens);
         }
 
-        for (const auto val: stopwordStruct.stopwords) {
-            tokens.erase(std::remove(tokens.begin(), tokens.end(), val), tokens.end());
+        if(stopwords != nullptr) {
+            tokens.erase(std::remove_if(tokens.begin(), tokens.end(), [&](const std::string& token) {
+                return stopwords->contains(token);
+            }), tokens.end());
         }
 
         bool exclude_operator_prior = false;
@@ -3546,7 +4108,8 @@ void Collection::parse_search_query(const std::string &query, std::vector<std::s
 
 void Collection::populate_result_kvs(Topster *topster, std::vector<std::vector<KV *>> &result_kvs,
                                 const spp::sparse_hash_map<uint64_t, uint32_t>& groups_processed, 
-                                const std::vector<sort_by>& sort_by_fields) {
+                                const std::vector<sort_by>& sort_by_fields,
+                                ThreadPool* thread_pool, size_t concurrency) {
     if(topster->distinct) {
         // we have to pick top-K groups
         Topster gtopster(topster->MAX_SIZE);
@@ -3566,8 +4129,27 @@ void Collection::populate_result_kvs(Topster *topster, std::vector<std::vector<K
             }
         }
 
+        // the groups are sorted side by side when together they hold enough hits
+        std::vector<Topster*> group_topsters;
+        size_t num_group_kvs = 0;
+        for(auto& group_topster: topster->group_kv_map) {
+            group_topsters.push_back(group_topster.second);
+            num_group_kvs += group_topster.second->size;
+        }
+
+        auto sort_groups = [&group_topsters](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                group_topsters[i]->sort();
+            }
+        };
+
+        if(thread_pool != nullptr && concurrency > 1 && num_group_kvs >= ThreadPool::PARALLEL_SORT_MIN_SIZE) {
+            thread_pool->parallel_for(0, group_topsters.size(), concurrency, sort_groups, ThreadPool::HIGH_PRIORITY);
+        } else {
+            sort_groups(0, group_topsters.size());
+        }
+
         for(auto& group_topster: topster->group_kv_map) {
-            group_topster.second->sort();
             if(group_topster.second->size != 0) {
                 KV* kv_head = group_topster.second->getKV(0);
                 
@@ -3581,7 +4163,7 @@ void Collection::populate_result_kvs(Topster *topster, std::vector<std::vector<K
             }
         }
 
-        gtopster.sort();
+        gtopster.sort(thread_pool, concurrency);
 
         for(size_t i = 0; i < gtopster.size; i++) {
             KV* kv = gtopster.getKV(i);
@@ -3599,6 +4181,28 @@ void Collection::populate_result_kvs(Topster *topster, std::vector<std::vector<K
     }
 }
 
+std::string Collection::encode_search_after(const KV* kv) {
+    return StringUtils::base64_encode(std::to_string(kv->scores[0]) + "," + std::to_string(kv->scores[1]) + "," +
+                                      std::to_string(kv->scores[2]) + "," + std::to_string(kv->key));
+}
+
+Option<bool> Collection::decode_search_after(const std::string& search_after, int64_t* scores, uint64_t& key) {
+    std::vector<std::string> parts;
+    StringUtils::split(StringUtils::base64_decode(search_after), parts, ",");
+
+    if(parts.size() != 4 || !StringUtils::is_int64_t(parts[0]) || !StringUtils::is_int64_t(parts[1]) ||
+       !StringUtils::is_int64_t(parts[2]) || !StringUtils::is_uint64_t(parts[3])) {
+        return Option<bool>(400, "Parameter `search_after` is malformed.");
+    }
+
+    for(size_t i = 0; i < 3; i++) {
+        scores[i] = std::strtoll(parts[i].c_str(), nullptr, 10);
+    }
+
+    key = std::strtoull(parts[3].c_str(), nullptr, 10);
+    return Option<bool>(true);
+}
+
 Option<bool> Collection::get_filter_ids(const std::string& filter_query, filter_result_t& filter_result) const {
     std::shared_lock lock(mutex);
 
@@ -4072,10 +4676,38 @@ bool Collection::handle_highlight_text(std::string& text, bool normalise, const
 
     const Match& match = match_index.match;
 
-    Tokenizer tokenizer(text, normalise, false, search_field.locale, symbols_to_index, token_separators);
+    // The tokens of a text only depend on the text and the tokenizer settings, so the tokens of a text that
+    // was highlighted before are walked again instead of tokenizing the text anew.
+    std::shared_ptr<const std::vector<highlight_token_t>> cached_tokens;
+    uint64_t tokens_cache_key = 0;
+    const bool cache_tokens = text.size() <= HIGHLIGHT_TOKENS_MAX_TEXT_LEN;
+
+    if(cache_tokens) {
+        tokens_cache_key = StringUtils::hash_combine(StringUtils::hash_wy(text.data(), text.size()),
+                                                     StringUtils::hash_wy(search_field.locale.data(),
+                                                                          search_field.locale.size()));
+        tokens_cache_key = StringUtils::hash_combine(tokens_cache_key, normalise);
+
+        std::unique_lock lock(highlight_tokens_cache_mutex);
+        if(highlight_tokens_cache.contains(tokens_cache_key)) {
+            cached_tokens = highlight_tokens_cache.lookup(tokens_cache_key);
+        }
+    }
+
+    // still needed for its character classes when the tokens are cached: the tokenizer keeps a view of the text,
+    // which must hence outlive it
+    static const std::string no_text;
+    auto tokenizer_ptr = Tokenizer::acquire(cached_tokens == nullptr ? text : no_text, normalise, false,
+                                            search_field.locale, symbols_to_index, token_separators);
+    Tokenizer& tokenizer = *tokenizer_ptr;
+    std::vector<highlight_token_t> tokens;
+    size_t cached_token_i = 0;
+    bool tokenized_fully = true;
 
     // word tokenizer is a secondary tokenizer used for specific languages that requires transliteration
-    Tokenizer word_tokenizer("", true, false, search_field.locale, symbols_to_index, token_separators);
+    auto word_tokenizer_ptr = Tokenizer::acquire("", true, false, search_field.locale,
+                                                 symbols_to_index, token_separators);
+    Tokenizer& word_tokenizer = *word_tokenizer_ptr;
 
     if(search_field.locale == "ko") {
         text = string_utils.unicode_nfkd(text);
@@ -4101,12 +4733,32 @@ bool Collection::handle_highlight_text(std::string& text, bool normalise, const
 
     size_t text_len = Tokenizer::is_ascii_char(text[0]) ? text.size() : StringUtils::get_num_chars(text);
 
-    while(tokenizer.next(raw_token, raw_token_index, tok_start, tok_end)) {
-        if(use_word_tokenizer) {
-            bool found_token = word_tokenizer.tokenize(raw_token);
-            if(!found_token) {
-                tokenizer.decr_token_counter();
-                continue;
+    while(true) {
+        if(cached_tokens != nullptr) {
+            if(cached_token_i == cached_tokens->size()) {
+                break;
+            }
+
+            const auto& cached_token = (*cached_tokens)[cached_token_i++];
+            raw_token = cached_token.token;
+            raw_token_index = cached_token.index;
+            tok_start = cached_token.start;
+            tok_end = cached_token.end;
+        } else {
+            if(!tokenizer.next(raw_token, raw_token_index, tok_start, tok_end)) {
+                break;
+            }
+
+            if(use_word_tokenizer) {
+                bool found_token = word_tokenizer.tokenize(raw_token);
+                if(!found_token) {
+                    tokenizer.decr_token_counter();
+                    continue;
+                }
+            }
+
+            if(cache_tokens) {
+                tokens.push_back({raw_token, raw_token_index, tok_start, tok_end});
             }
         }
 
@@ -4216,10 +4868,17 @@ bool Collection::handle_highlight_text(std::string& text, bool normalise, const
            match_offset_index > last_valid_offset_index &&
            raw_token_index >= last_valid_offset + highlight_affix_num_tokens &&
            !highlight_fully) {
+            tokenized_fully = false;
             break;
         }
     }
 
+    if(cache_tokens && cached_tokens == nullptr && tokenized_fully) {
+        auto all_tokens = std::make_shared<const std::vector<highlight_token_t>>(std::move(tokens));
+        std::unique_lock lock(highlight_tokens_cache_mutex);
+        highlight_tokens_cache.insert(tokens_cache_key, all_tokens);
+    }
+
     if(token_offsets.empty()) {
         return false;
     }
@@ -4320,8 +4979,8 @@ void Collection::highlight_text(const string& highlight_start_tag, const string&
 }
 
 Option<nlohmann::json> Collection::get(const std::string & id) const {
-    std::string seq_id_str;
-    StoreStatus seq_id_status = store->get(get_doc_id_key(id), seq_id_str);
+    uint32_t seq_id = 0;
+    StoreStatus seq_id_status = get_doc_seq_id(id, seq_id);
 
     if(seq_id_status == StoreStatus::NOT_FOUND) {
         return Option<nlohmann::json>(404, "Could not find a document with id: " + id);
@@ -4331,8 +4990,6 @@ Option<nlohmann::json> Collection::get(const std::string & id) const {
         return Option<nlohmann::json>(500, "Error while fetching the document.");
     }
 
-    uint32_t seq_id = (uint32_t) std::stoul(seq_id_str);
-
     std::string parsed_document;
     StoreStatus doc_status = store->get(get_seq_id_key(seq_id), parsed_document);
 
@@ -4347,7 +5004,7 @@ Option<nlohmann::json> Collection::get(const std::string & id) const {
 
     nlohmann::json document;
     try {
-        document = nlohmann::json::parse(parsed_document);
+        document = parse_stored_document(parsed_document);
     } catch(...) {
         return Option<nlohmann::json>(500, "Error while parsing stored document.");
     }
@@ -4361,15 +5018,31 @@ void Collection::remove_document(const nlohmann::json & document, const uint32_t
     {
         std::unique_lock lock(mutex);
 
-        index->remove(seq_id, document, {}, false);
+        if(remove_from_store && Config::get_instance().get_enable_deferred_deletes()) {
+            // searches skip the document from now on, and it is unindexed later along with other deleted documents
+            index->mark_deleted(seq_id, document);
+        } else {
+            index->remove(seq_id, document, {}, false);
+        }
+
         num_documents -= 1;
+        advance_write_generation();
     }
 
     if(remove_from_store) {
         store->remove(get_doc_id_key(id));
         store->remove(get_seq_id_key(seq_id));
+        doc_ids.remove(id);
+
+        if(index->num_deleted() >= Index::MAX_DELETED_DOCS) {
+            index->purge_deleted();
+        }
     }
 
+    remove_referencing_docs(id);
+}
+
+void Collection::remove_referencing_docs(const std::string& id) {
     if (referenced_in.empty()) {
         return;
     }
@@ -4389,8 +5062,10 @@ void Collection::remove_document(const nlohmann::json & document, const uint32_t
 }
 
 Option<std::string> Collection::remove(const std::string & id, const bool remove_from_store) {
-    std::string seq_id_str;
-    StoreStatus seq_id_status = store->get(get_doc_id_key(id), seq_id_str);
+    std::shared_lock backfill_lock(backfill_mutex);
+
+    uint32_t seq_id = 0;
+    StoreStatus seq_id_status = get_doc_seq_id(id, seq_id);
 
     if(seq_id_status == StoreStatus::NOT_FOUND) {
         return Option<std::string>(404, "Could not find a document with id: " + id);
@@ -4400,10 +5075,9 @@ Option<std::string> Collection::remove(const std::string & id, const bool remove
         return Option<std::string>(500, "Error while fetching the document.");
     }
 
-    uint32_t seq_id = (uint32_t) std::stoul(seq_id_str);
-
+    const doc_projection_t& projection = get_removal_projection();
     nlohmann::json document;
-    auto get_doc_op = get_document_from_store(get_seq_id_key(seq_id), document);
+    auto get_doc_op = get_document_from_store(get_seq_id_key(seq_id), document, false, &projection);
 
     if(!get_doc_op.ok()) {
         if(get_doc_op.code() == 404) {
@@ -4419,8 +5093,11 @@ Option<std::string> Collection::remove(const std::string & id, const bool remove
 }
 
 Option<bool> Collection::remove_if_found(uint32_t seq_id, const bool remove_from_store) {
+    std::shared_lock backfill_lock(backfill_mutex);
+
+    const doc_projection_t& projection = get_removal_projection();
     nlohmann::json document;
-    auto get_doc_op = get_document_from_store(get_seq_id_key(seq_id), document);
+    auto get_doc_op = get_document_from_store(get_seq_id_key(seq_id), document, false, &projection);
 
     if(!get_doc_op.ok()) {
         if(get_doc_op.code() == 404) {
@@ -4435,6 +5112,205 @@ Option<bool> Collection::remove_if_found(uint32_t seq_id, const bool remove_from
     return Option<bool>(true);
 }
 
+doc_projection_t Collection::get_removal_projection() const {
+    // only the values of the indexed fields are needed to unindex a document
+    doc_projection_t projection;
+    projection.include_names.insert("id");
+
+    std::shared_lock lock(mutex);
+    const auto& indexing_schema = alter_backfill ? alter_backfill->search_schema : search_schema;
+    for(auto it = indexing_schema.begin(); it != indexing_schema.end(); ++it) {
+        projection.include_names.insert(it.key());
+    }
+
+    return projection;
+}
+
+size_t Collection::purge_deleted_docs() {
+    return index->purge_deleted();
+}
+
+Option<size_t> Collection::remove_batch(const uint32_t* seq_ids, const size_t num_ids, const bool remove_from_store) {
+    std::shared_lock backfill_lock(backfill_mutex);
+
+    const doc_projection_t& projection = get_removal_projection();
+
+    std::vector<std::string> seq_id_keys;
+    for(size_t i = 0; i < num_ids; i++) {
+        seq_id_keys.push_back(get_seq_id_key(seq_ids[i]));
+    }
+
+    std::vector<std::string> stored_docs;
+    std::vector<StoreStatus> statuses;
+    store->multi_get(seq_id_keys, stored_docs, statuses);
+
+    std::vector<std::pair<uint32_t, nlohmann::json>> seq_id_docs;
+
+    for(size_t i = 0; i < num_ids; i++) {
+        nlohmann::json document;
+        auto parse_op = parse_document_from_store(seq_id_keys[i], statuses[i], stored_docs[i], document,
+                                                  false, &projection);
+        if(!parse_op.ok()) {
+            if(parse_op.code() == 404) {
+                // already removed
+                continue;
+            }
+
+            return Option<size_t>(500, "Error while fetching the document with seq id: " +
+                                       std::to_string(seq_ids[i]));
+        }
+
+        seq_id_docs.emplace_back(seq_ids[i], std::move(document));
+    }
+
+    {
+        std::unique_lock lock(mutex);
+
+        index->remove_batch(seq_id_docs);
+        num_documents -= seq_id_docs.size();
+        advance_write_generation();
+    }
+
+    if(remove_from_store) {
+        rocksdb::WriteBatch batch;
+        for(const auto& seq_id_doc: seq_id_docs) {
+            batch.Delete(get_doc_id_key(seq_id_doc.second["id"]));
+            batch.Delete(get_seq_id_key(seq_id_doc.first));
+        }
+
+        if(batch.Count() != 0 && !store->batch_write(batch)) {
+            LOG(ERROR) << "Error while removing a batch of " << seq_id_docs.size() << " documents from the store.";
+        }
+
+        for(const auto& seq_id_doc: seq_id_docs) {
+            doc_ids.remove(seq_id_doc.second["id"]);
+        }
+    }
+
+    for(const auto& seq_id_doc: seq_id_docs) {
+        remove_referencing_docs(seq_id_doc.second["id"]);
+    }
+
+    return Option<size_t>(seq_id_docs.size());
+}
+
+nlohmann::json Collection::update_numeric_fields(std::vector<std::string>& json_lines) {
+    std::shared_lock backfill_lock(backfill_mutex);
+
+    std::vector<numeric_doc_update_t> doc_updates;
+    std::vector<size_t> doc_update_lines;
+    size_t num_updated = 0;
+
+    auto set_line_error = [&json_lines](size_t line_index, uint32_t code, const std::string& error) {
+        nlohmann::json res;
+        res["success"] = false;
+        res["document"] = json_lines[line_index];
+        res["error"] = error;
+        res["code"] = code;
+        json_lines[line_index] = res.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+    };
+
+    for(size_t i = 0; i < json_lines.size(); i++) {
+        const nlohmann::json& line = nlohmann::json::parse(json_lines[i], nullptr, false);
+        if(line.is_discarded() || !line.is_object()) {
+            set_line_error(i, 400, "Bad JSON.");
+            continue;
+        }
+
+        if(line.count("id") == 0 || !line["id"].is_string()) {
+            set_line_error(i, 400, "Document must have a string `id`.");
+            continue;
+        }
+
+        const std::string& id = line["id"].get<std::string>();
+        auto seq_id_op = doc_id_to_seq_id_with_lock(id);
+        if(!seq_id_op.ok()) {
+            set_line_error(i, 404, "Could not find a document with id: " + id);
+            continue;
+        }
+
+        numeric_doc_update_t doc_update;
+        doc_update.seq_id = seq_id_op.get();
+        bool is_valid = true;
+
+        for(const std::string& operation: {"increment", "set"}) {
+            if(line.count(operation) == 0) {
+                continue;
+            }
+
+            if(!line[operation].is_object()) {
+                set_line_error(i, 400, "Parameter `" + operation + "` must be an object.");
+                is_valid = false;
+                break;
+            }
+
+            for(const auto& item: line[operation].items()) {
+                doc_update.updates.push_back({item.key(), operation == "increment", item.value()});
+            }
+        }
+
+        if(is_valid && doc_update.updates.empty()) {
+            set_line_error(i, 400, "Document must have fields to `increment` or `set`.");
+            is_valid = false;
+        }
+
+        if(is_valid) {
+            doc_updates.push_back(std::move(doc_update));
+            doc_update_lines.push_back(i);
+        }
+    }
+
+    rocksdb::WriteBatch batch;
+
+    {
+        std::unique_lock lock(mutex);
+        index->update_numeric_values(doc_updates);
+        advance_write_generation();
+
+        for(const auto& doc_update: doc_updates) {
+            if(!doc_update.result.ok()) {
+                continue;
+            }
+
+            nlohmann::json patch = doc_update.result.get();
+            for(auto it = patch.begin(); it != patch.end();) {
+                it = search_schema.at(it.key()).store ? std::next(it) : patch.erase(it);
+            }
+
+            if(!patch.empty()) {
+                batch.Merge(get_seq_id_key(doc_update.seq_id), StoreMergeOperator::doc_patch_operand(patch.dump()));
+            }
+        }
+    }
+
+    const bool write_ok = (batch.Count() == 0) || store->batch_write(batch);
+    if(!write_ok) {
+        LOG(ERROR) << "Error while writing a batch of " << batch.Count() << " numeric updates to the store.";
+    }
+
+    for(size_t i = 0; i < doc_updates.size(); i++) {
+        const auto& doc_update = doc_updates[i];
+        const size_t line_index = doc_update_lines[i];
+
+        if(!doc_update.result.ok()) {
+            set_line_error(line_index, doc_update.result.code(), doc_update.result.error());
+        } else if(!write_ok) {
+            set_line_error(line_index, 500, "Could not write to on-disk storage.");
+        } else {
+            nlohmann::json res;
+            res["success"] = true;
+            res["values"] = doc_update.result.get();
+            json_lines[line_index] = res.dump();
+            num_updated++;
+        }
+    }
+
+    nlohmann::json resp_summary;
+    resp_summary["num_updated"] = num_updated;
+    resp_summary["success"] = (num_updated == json_lines.size());
+    return resp_summary;
+}
+
 Option<uint32_t> Collection::add_override(const override_t & override, bool write_to_store) {
     if(write_to_store) {
         bool inserted = store->insert(Collection::get_override_key(name, override.id), override.to_json().dump());
@@ -4454,14 +5330,53 @@ Option<uint32_t> Collection::add_override(const override_t & override, bool writ
         }
     }
 
+    if(overrides.count(override.id) != 0) {
+        auto rule_ids = get_override_rule_ids(overrides[override.id]);
+        if(rule_ids != nullptr) {
+            rule_ids->erase(override.id);
+        }
+    }
+
     overrides[override.id] = override;
     for(const auto& tag: override.rule.tags) {
         override_tags[tag].insert(override.id);
     }
 
+    auto rule_ids = get_override_rule_ids(override);
+    if(rule_ids != nullptr) {
+        rule_ids->insert(override.id);
+    }
+
+    advance_write_generation();
     return Option<uint32_t>(200);
 }
 
+std::set<std::string>* Collection::get_override_rule_ids(const override_t& override) {
+    const auto& tags = override.rule.tags;
+    if(!tags.empty() && !(tags.size() == 1 && *tags.begin() == "*")) {
+        // applies only to searches with its tags
+        return nullptr;
+    }
+
+    const auto& rule_query = override.rule.normalized_query;
+
+    // overrides with a filter are collected for dynamic filtering whether their rule matches or not
+    if(!override.filter_by.empty() || override.rule.dynamic_query || rule_query.empty()) {
+        return &any_query_override_ids;
+    }
+
+    if(override.rule.match == override_t::MATCH_EXACT) {
+        return &exact_rule_override_ids[rule_query];
+    }
+
+    if(override.rule.match == override_t::MATCH_CONTAINS) {
+        // a query that contains the words of the rule has the first word of the rule as one of its words
+        return &contains_rule_override_ids[rule_query.substr(0, rule_query.find(' '))];
+    }
+
+    return &any_query_override_ids;
+}
+
 Option<uint32_t> Collection::remove_override(const std::string & id) {
     if(overrides.count(id) != 0) {
         bool removed = store->remove(Collection::get_override_key(name, id));
@@ -4476,7 +5391,13 @@ Option<uint32_t> Collection::remove_override(const std::string & id) {
             }
         }
 
+        auto rule_ids = get_override_rule_ids(overrides[id]);
+        if(rule_ids != nullptr) {
+            rule_ids->erase(id);
+        }
+
         overrides.erase(id);
+        advance_write_generation();
 
         return Option<uint32_t>(200);
     }
@@ -4505,6 +5426,35 @@ std::string Collection::get_doc_id_key(const std::string & doc_id) const {
     return std::to_string(collection_id) + "_" + DOC_ID_PREFIX + "_" + doc_id;
 }
 
+StoreStatus Collection::get_doc_seq_id(const std::string& doc_id, uint32_t& seq_id) const {
+    doc_id_index_t::lookup_t lookup = doc_ids.find(doc_id, seq_id);
+
+    if(lookup == doc_id_index_t::FOUND) {
+        return StoreStatus::FOUND;
+    }
+
+    if(lookup == doc_id_index_t::NOT_FOUND) {
+        return StoreStatus::NOT_FOUND;
+    }
+
+    std::string seq_id_str;
+    StoreStatus status = store->get(get_doc_id_key(doc_id), seq_id_str);
+    if(status == StoreStatus::FOUND) {
+        seq_id = (uint32_t) std::stoul(seq_id_str);
+    }
+
+    return status;
+}
+
+void Collection::add_doc_ids(const std::vector<index_record>& index_records) {
+    for(const auto& index_record: index_records) {
+        auto id_it = index_record.doc.find("id");
+        if(id_it != index_record.doc.end() && id_it->is_string()) {
+            doc_ids.add(id_it->get<std::string>(), index_record.seq_id);
+        }
+    }
+}
+
 std::string Collection::get_name() const {
     std::shared_lock lock(mutex);
     return name;
@@ -4518,20 +5468,124 @@ size_t Collection::get_num_documents() const {
     return num_documents.load();
 }
 
+nlohmann::json Collection::get_memory_stats_json() const {
+    std::shared_lock lock(mutex);
+    return index->get_memory_stats().to_json();
+}
+
 uint32_t Collection::get_collection_id() const {
     return collection_id.load();
 }
 
+Option<bool> Collection::save_index_image(const std::string& image_dir, nlohmann::json& image_meta) const {
+    std::shared_lock lock(mutex);
+
+    image_meta["name"] = name;
+    image_meta["next_seq_id"] = next_seq_id.load();
+    image_meta["num_documents"] = num_documents.load();
+    image_meta["vector_fields"] = nlohmann::json::object();
+
+    return index->save_vector_index_images(image_dir, std::to_string(collection_id), image_meta["vector_fields"]);
+}
+
+Option<bool> Collection::load_index_image(const std::string& image_dir, const nlohmann::json& image_meta) {
+    std::unique_lock lock(mutex);
+
+    // image must have been taken against the same state of the store that is being loaded
+    if(!image_meta.contains("next_seq_id") || !image_meta["next_seq_id"].is_number_unsigned() ||
+       image_meta["next_seq_id"].get<uint32_t>() != next_seq_id) {
+        return Option<bool>(400, "Index image is stale.");
+    }
+
+    if(!image_meta.contains("vector_fields") || !image_meta["vector_fields"].is_object()) {
+        return Option<bool>(400, "Index image has no vector fields.");
+    }
+
+    return index->load_vector_index_images(image_dir, image_meta["vector_fields"]);
+}
+
+void Collection::clear_preloaded_index_state() {
+    std::unique_lock lock(mutex);
+    index->clear_preloaded_vector_fields();
+}
+
+void Collection::reserve_index_capacity() {
+    std::unique_lock lock(mutex);
+
+    // sequence ids are never reused, so the next one bounds the number of stored documents
+    index->reserve_vector_capacity(next_seq_id);
+}
+
+Option<size_t> Collection::copy_documents(Collection* source, const size_t batch_size) {
+    const bool source_nested_fields_enabled = source->get_enable_nested_fields();
+    const tsl::htrie_map<char, field> source_nested_fields = source->get_nested_fields();
+
+    // ids that are allocated after the copy must not collide with those of the copied documents
+    uint32_t copy_next_seq_id = source->next_seq_id;
+    next_seq_id = copy_next_seq_id;
+    reserve_index_capacity();
+
+    const std::string seq_id_prefix = source->get_seq_id_collection_prefix();
+    std::string upper_bound_key = seq_id_prefix + "`";  // cannot inline this
+    rocksdb::Slice upper_bound(upper_bound_key);
+
+    rocksdb::Iterator* iter = store->scan(seq_id_prefix, &upper_bound, false);
+    std::unique_ptr<rocksdb::Iterator> iter_guard(iter);
+
+    std::vector<std::pair<uint32_t, std::string>> raw_docs;
+    std::atomic<uint64_t> parse_time_us = 0;
+    size_t num_copied = 0;
+
+    while(iter->Valid() && iter->key().starts_with(seq_id_prefix)) {
+        raw_docs.emplace_back(get_seq_id_from_key(iter->key().ToString()), iter->value().ToString());
+        iter->Next();
+
+        const bool last_record = !(iter->Valid() && iter->key().starts_with(seq_id_prefix));
+        if(raw_docs.size() < batch_size && !last_record) {
+            continue;
+        }
+
+        auto parsed_batch = CollectionManager::parse_stored_docs(raw_docs, source_nested_fields_enabled,
+                                                                 source_nested_fields, parse_time_us);
+        if(!parsed_batch.status.ok()) {
+            return Option<size_t>(parsed_batch.status.code(), parsed_batch.status.error());
+        }
+
+        // the stored form of the documents is copied as it is
+        rocksdb::WriteBatch batch;
+        for(size_t i = 0; i < raw_docs.size(); i++) {
+            const uint32_t seq_id = raw_docs[i].first;
+            batch.Put(get_doc_id_key(parsed_batch.index_records[i].doc["id"]), std::to_string(seq_id));
+            batch.Put(get_seq_id_key(seq_id), raw_docs[i].second);
+            copy_next_seq_id = std::max(copy_next_seq_id, seq_id + 1);
+        }
+
+        if(!store->batch_write(batch)) {
+            return Option<size_t>(500, "Could not write to on-disk storage.");
+        }
+
+        add_doc_ids(parsed_batch.index_records);
+        next_seq_id = copy_next_seq_id;
+        num_copied += batch_index_in_memory(parsed_batch.index_records, 200, 60000, 2, false);
+        raw_docs.clear();
+    }
+
+    if(!store->insert(get_next_seq_id_key(name), StringUtils::serialize_uint32_t(copy_next_seq_id))) {
+        return Option<size_t>(500, "Could not write to on-disk storage.");
+    }
+
+    return Option<size_t>(num_copied);
+}
+
 Option<uint32_t> Collection::doc_id_to_seq_id_with_lock(const std::string & doc_id) const {
     std::shared_lock lock(mutex);
     return doc_id_to_seq_id(doc_id);
 }
 
 Option<uint32_t> Collection::doc_id_to_seq_id(const std::string & doc_id) const {
-    std::string seq_id_str;
-    StoreStatus status = store->get(get_doc_id_key(doc_id), seq_id_str);
+    uint32_t seq_id = 0;
+    StoreStatus status = get_doc_seq_id(doc_id, seq_id);
     if(status == StoreStatus::FOUND) {
-        uint32_t seq_id = std::stoul(seq_id_str);
         return Option<uint32_t>(seq_id);
     }
 
@@ -4626,10 +5680,16 @@ Option<bool> Collection::get_document_from_store(const uint32_t& seq_id,
 }
 
 Option<bool> Collection::get_document_from_store(const std::string &seq_id_key,
-                                                 nlohmann::json& document, bool raw_doc) const {
+                                                 nlohmann::json& document, bool raw_doc,
+                                                 const doc_projection_t* projection) const {
     std::string json_doc_str;
     StoreStatus json_doc_status = store->get(seq_id_key, json_doc_str);
+    return parse_document_from_store(seq_id_key, json_doc_status, json_doc_str, document, raw_doc, projection);
+}
 
+Option<bool> Collection::parse_document_from_store(const std::string& seq_id_key, const StoreStatus& json_doc_status,
+                                                   const std::string& json_doc_str, nlohmann::json& document,
+                                                   bool raw_doc, const doc_projection_t* projection) const {
     if(json_doc_status != StoreStatus::FOUND) {
         const std::string& seq_id = std::to_string(get_seq_id_from_key(seq_id_key));
         if(json_doc_status == StoreStatus::NOT_FOUND) {
@@ -4639,18 +5699,156 @@ Option<bool> Collection::get_document_from_store(const std::string &seq_id_key,
         return Option<bool>(500, "Error while fetching JSON document for sequence ID: " + seq_id);
     }
 
+    if(request_cost != nullptr) {
+        request_cost->add_doc_hydrated(json_doc_str.size());
+    }
+
     try {
-        document = nlohmann::json::parse(json_doc_str);
+        document = parse_stored_document(json_doc_str, projection);
     } catch(...) {
         return Option<bool>(500, "Error while parsing stored document with sequence ID: " + seq_id_key);
     }
 
-    if(!raw_doc && enable_nested_fields) {
-        std::vector<field> flattened_fields;
-        field::flatten_doc(document, nested_fields, {}, true, flattened_fields);
+    if(!raw_doc && enable_nested_fields) {
+        std::vector<field> flattened_fields;
+        field::flatten_doc(document, nested_fields, {}, true, flattened_fields);
+    }
+
+    return Option<bool>(true);
+}
+
+std::string Collection::serialize_document(const nlohmann::json& document) const {
+    if(storage_format != STORAGE_FORMAT_MSGPACK) {
+        return document.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+    }
+
+    std::string serialized_doc(1, STORED_DOC_MSGPACK_MARKER);
+    nlohmann::json::to_msgpack(document, serialized_doc);
+    return serialized_doc;
+}
+
+// Builds the document like `nlohmann::json::parse` does, except for the values of top level keys not wanted by the
+// projection, whose events are dropped while the parser walks over them.
+class projected_doc_sax_t {
+private:
+    nlohmann::detail::json_sax_dom_parser<nlohmann::json> dom_parser;
+    const doc_projection_t& projection;
+
+    size_t depth = 0;
+    bool skipping = false;
+
+    // whether the event is part of a value that is being skipped; a skipped scalar at the top level ends the skip
+    bool skip_scalar() {
+        if(skipping && depth == 1) {
+            skipping = false;
+            return true;
+        }
+
+        return skipping;
+    }
+
+public:
+    projected_doc_sax_t(nlohmann::json& document, const doc_projection_t& projection):
+            dom_parser(document), projection(projection) {
+
+    }
+
+    bool null() {
+        return skip_scalar() || dom_parser.null();
+    }
+
+    bool boolean(bool val) {
+        return skip_scalar() || dom_parser.boolean(val);
+    }
+
+    bool number_integer(nlohmann::json::number_integer_t val) {
+        return skip_scalar() || dom_parser.number_integer(val);
+    }
+
+    bool number_unsigned(nlohmann::json::number_unsigned_t val) {
+        return skip_scalar() || dom_parser.number_unsigned(val);
+    }
+
+    bool number_float(nlohmann::json::number_float_t val, const nlohmann::json::string_t& s) {
+        return skip_scalar() || dom_parser.number_float(val, s);
+    }
+
+    bool string(nlohmann::json::string_t& val) {
+        return skip_scalar() || dom_parser.string(val);
+    }
+
+    bool binary(nlohmann::json::binary_t& val) {
+        return skip_scalar() || dom_parser.binary(val);
+    }
+
+    bool start_object(std::size_t elements) {
+        depth++;
+        return skipping || dom_parser.start_object(elements);
+    }
+
+    bool key(nlohmann::json::string_t& val) {
+        if(skipping) {
+            return true;
+        }
+
+        if(depth == 1 && !projection.wants(val)) {
+            skipping = true;
+            return true;
+        }
+
+        return dom_parser.key(val);
+    }
+
+    bool end_object() {
+        depth--;
+        if(skipping) {
+            skipping = (depth != 1);
+            return true;
+        }
+
+        return dom_parser.end_object();
+    }
+
+    bool start_array(std::size_t elements) {
+        depth++;
+        return skipping || dom_parser.start_array(elements);
+    }
+
+    bool end_array() {
+        depth--;
+        if(skipping) {
+            skipping = (depth != 1);
+            return true;
+        }
+
+        return dom_parser.end_array();
+    }
+
+    template<class Exception>
+    bool parse_error(std::size_t position, const std::string& last_token, const Exception& ex) {
+        return dom_parser.parse_error(position, last_token, ex);
+    }
+};
+
+nlohmann::json Collection::parse_stored_document(const std::string& stored_doc, const doc_projection_t* projection) {
+    const bool is_msgpack = !stored_doc.empty() && stored_doc[0] == STORED_DOC_MSGPACK_MARKER;
+
+    if(projection == nullptr) {
+        return is_msgpack ? nlohmann::json::from_msgpack(stored_doc.begin() + 1, stored_doc.end()) :
+                            nlohmann::json::parse(stored_doc);
+    }
+
+    nlohmann::json document;
+    projected_doc_sax_t sax(document, *projection);
+
+    if(is_msgpack) {
+        nlohmann::json::sax_parse(stored_doc.begin() + 1, stored_doc.end(), &sax,
+                                  nlohmann::json::input_format_t::msgpack);
+    } else {
+        nlohmann::json::sax_parse(stored_doc, &sax);
     }
 
-    return Option<bool>(true);
+    return document;
 }
 
 const Index* Collection::_get_index() const {
@@ -4731,7 +5929,9 @@ Option<bool> Collection::add_synonym(const nlohmann::json& syn_json, bool write_
         return syn_op;
     }
 
-    return synonym_index->add_synonym(name, synonym, write_to_store);
+    auto add_op = synonym_index->add_synonym(name, synonym, write_to_store);
+    advance_write_generation();
+    return add_op;
 }
 
 bool Collection::get_synonym(const std::string& id, synonym_t& synonym) {
@@ -4741,7 +5941,9 @@ bool Collection::get_synonym(const std::string& id, synonym_t& synonym) {
 
 Option<bool> Collection::remove_synonym(const std::string &id) {
     std::shared_lock lock(mutex);
-    return synonym_index->remove_synonym(name, id);
+    auto remove_op = synonym_index->remove_synonym(name, id);
+    advance_write_generation();
+    return remove_op;
 }
 
 void Collection::synonym_reduction(const std::vector<std::string>& tokens,
@@ -4807,6 +6009,11 @@ spp::sparse_hash_map<std::string, reference_pair> Collection::get_reference_fiel
     return reference_fields;
 }
 
+bool Collection::has_references() const {
+    std::shared_lock lock(mutex);
+    return !reference_fields.empty() || !referenced_in.empty();
+}
+
 Option<bool> Collection::persist_collection_meta() {
     // first compact nested fields (to keep only parents of expanded children)
     field::compact_nested_fields(nested_fields);
@@ -4837,6 +6044,14 @@ Option<bool> Collection::persist_collection_meta() {
     collection_meta[Collection::COLLECTION_DEFAULT_SORTING_FIELD_KEY] = default_sorting_field;
     collection_meta[Collection::COLLECTION_FALLBACK_FIELD_TYPE] = fallback_field_type;
 
+    // a background alter is started again when the collection is loaded
+    if(alter_backfill != nullptr) {
+        collection_meta[COLLECTION_ALTER_BACKFILL]["alter_payload"] = alter_backfill->alter_payload;
+        collection_meta[COLLECTION_ALTER_BACKFILL]["rate"] = alter_backfill->rate;
+    } else {
+        collection_meta.erase(COLLECTION_ALTER_BACKFILL);
+    }
+
     bool persisted = store->insert(Collection::get_meta_key(name), collection_meta.dump());
     if(!persisted) {
         return Option<bool>(500, "Could not persist collection meta to store.");
@@ -4854,6 +6069,7 @@ Option<bool> Collection::batch_alter_data(const std::vector<field>& alter_fields
     std::vector<std::string> nested_field_names;
     bool found_embedding_field = false;
 
+    std::unique_lock write_lock(write_mutex);
     std::unique_lock ulock(mutex);
 
     for(auto& f: alter_fields) {
@@ -4867,6 +6083,7 @@ Option<bool> Collection::batch_alter_data(const std::vector<field>& alter_fields
         } else {
             schema_additions.emplace(f.name, f);
             search_schema.emplace(f.name, f);
+            schema_version++;
             new_fields.push_back(f);
         }
 
@@ -4904,7 +6121,7 @@ Option<bool> Collection::batch_alter_data(const std::vector<field>& alter_fields
     std::string upper_bound_key = get_seq_id_collection_prefix() + "`";  // cannot inline this
     rocksdb::Slice upper_bound(upper_bound_key);
 
-    rocksdb::Iterator* iter = store->scan(seq_id_prefix, &upper_bound);
+    rocksdb::Iterator* iter = store->scan(seq_id_prefix, &upper_bound, false);
     std::unique_ptr<rocksdb::Iterator> iter_guard(iter);
 
     size_t num_found_docs = 0;
@@ -4920,7 +6137,7 @@ Option<bool> Collection::batch_alter_data(const std::vector<field>& alter_fields
         nlohmann::json document;
 
         try {
-            document = nlohmann::json::parse(iter->value().ToString());
+            document = parse_stored_document(iter->value().ToString());
         } catch(const std::exception& e) {
             return Option<bool>(400, "Bad JSON in document: " + document.dump(-1, ' ', false,
                                                                                 nlohmann::detail::error_handler_t::ignore));
@@ -4955,7 +6172,7 @@ Option<bool> Collection::batch_alter_data(const std::vector<field>& alter_fields
                 for(auto& index_record : iter_batch) {
                     if(index_record.indexed.ok()) {
                         remove_flat_fields(index_record.doc);
-                        const std::string& serialized_json = index_record.doc.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+                        const std::string& serialized_json = serialize_document(index_record.doc);
                         bool write_ok = store->insert(get_seq_id_key(index_record.seq_id), serialized_json);
 
                         if(!write_ok) {
@@ -4990,6 +6207,7 @@ Option<bool> Collection::batch_alter_data(const std::vector<field>& alter_fields
     std::vector<field> garbage_embedding_fields_vec;
     for(auto& del_field: del_fields) {
         search_schema.erase(del_field.name);
+        schema_version++;
         auto new_end = std::remove_if(fields.begin(), fields.end(), [&del_field](const field& f) {
             return f.name == del_field.name;
         });
@@ -5036,8 +6254,15 @@ Option<bool> Collection::batch_alter_data(const std::vector<field>& alter_fields
 Option<bool> Collection::alter(nlohmann::json& alter_payload) {
     std::shared_lock shlock(mutex);
 
+    if(alter_backfill != nullptr) {
+        return Option<bool>(409, "The fields of an earlier alter are still being backfilled.");
+    }
+
     LOG(INFO) << "Collection " << name << " is being prepared for alter...";
 
+    // the alter walks the stored documents, so it would miss the deleted ones that are still indexed
+    index->purge_deleted();
+
     // Validate that all stored documents are compatible with the proposed schema changes.
     std::vector<field> del_fields;
     std::vector<field> addition_fields;
@@ -5060,6 +6285,7 @@ Option<bool> Collection::alter(nlohmann::json& alter_payload) {
     shlock.unlock();
 
     if(!this_fallback_field_type.empty() && fallback_field_type.empty()) {
+        std::unique_lock write_lock(write_mutex);
         std::unique_lock ulock(mutex);
         fallback_field_type = this_fallback_field_type;
     }
@@ -5084,6 +6310,13 @@ Option<bool> Collection::alter(nlohmann::json& alter_payload) {
         }
     }
 
+    advance_write_generation();
+    hide_alter_credentials(alter_payload);
+
+    return Option<bool>(true);
+}
+
+void Collection::hide_alter_credentials(nlohmann::json& alter_payload) {
     // hide credentials in the alter payload return
     for(auto& field_json : alter_payload["fields"]) {
         if(field_json[fields::embed].count(fields::model_config) != 0) {
@@ -5095,10 +6328,283 @@ Option<bool> Collection::alter(nlohmann::json& alter_payload) {
             hide_credential(field_json[fields::embed][fields::model_config], "project_id");
         }
     }
+}
+
+Option<bool> Collection::alter_in_background(nlohmann::json& alter_payload, uint32_t backfill_rate,
+                                             const std::function<void()>& on_done) {
+    std::vector<field> del_fields;
+    std::vector<field> addition_fields;
+    std::vector<field> reindex_fields;
+    std::string this_fallback_field_type;
+
+    const nlohmann::json original_payload = alter_payload;
+
+    {
+        std::shared_lock shlock(mutex);
+
+        if(alter_backfill != nullptr) {
+            return Option<bool>(409, "The fields of an earlier alter are still being backfilled.");
+        }
+
+        index->purge_deleted();
+
+        auto validate_op = validate_alter_payload(alter_payload, addition_fields, reindex_fields,
+                                                  del_fields, this_fallback_field_type);
+        if(!validate_op.ok()) {
+            LOG(INFO) << "Alter failed validation: " << validate_op.error();
+            return validate_op;
+        }
+    }
+
+    if(!del_fields.empty() || !reindex_fields.empty() || !this_fallback_field_type.empty()) {
+        return Option<bool>(400, "Only the addition of fields can be altered in the background.");
+    }
+
+    for(const auto& f: addition_fields) {
+        if(f.is_dynamic() || f.nested || f.is_object()) {
+            return Option<bool>(400, "Field `" + f.name + "` can not be added in the background: dynamic and "
+                                     "object fields are added with a regular alter.");
+        }
+    }
+
+    auto backfill = std::make_shared<alter_backfill_t>();
+    backfill->fields = addition_fields;
+    backfill->alter_payload = original_payload;
+    backfill->rate = backfill_rate;
+
+    // a backfill that ended earlier leaves its thread behind
+    if(backfill_thread.joinable()) {
+        backfill_thread.join();
+    }
+
+    std::unique_lock write_lock(write_mutex);
+    std::unique_lock ulock(mutex);
+
+    if(alter_backfill != nullptr) {
+        return Option<bool>(409, "The fields of an earlier alter are still being backfilled.");
+    }
+
+    backfill->search_schema = search_schema;
+    backfill->embedding_fields = embedding_fields;
+
+    for(const auto& f: addition_fields) {
+        if(f.embed.count(fields::from) != 0) {
+            const auto& text_embedders = EmbedderManager::get_instance()._get_text_embedders();
+            const auto& model_name = f.embed[fields::model_config][fields::model_name].get<std::string>();
+            if(text_embedders.count(model_name) == 0) {
+                size_t dummy_num_dim = 0;
+                auto validate_model_res = EmbedderManager::get_instance().validate_and_init_model(
+                                                f.embed[fields::model_config], dummy_num_dim);
+                if(!validate_model_res.ok()) {
+                    return Option<bool>(validate_model_res.code(), validate_model_res.error());
+                }
+            }
+
+            backfill->embedding_fields.emplace(f.name, f);
+            backfill->has_embedding_field = true;
+        }
+
+        backfill->search_schema.emplace(f.name, f);
+        backfill->schema_additions.emplace(f.name, f);
+    }
+
+    backfill->num_documents = num_documents;
+    backfill->started_at = std::chrono::duration_cast<std::chrono::seconds>(
+                                std::chrono::system_clock::now().time_since_epoch()).count();
+
+    index->start_backfill(addition_fields);
+    alter_backfill = backfill;
+
+    auto persist_op = persist_collection_meta();
+    if(!persist_op.ok()) {
+        LOG(ERROR) << "Background alter of collection " << name << " is not persisted: " << persist_op.error();
+    }
+
+    LOG(INFO) << "Backfilling " << addition_fields.size() << " new field(s) of collection " << name
+              << " in the background.";
+
+    backfill_thread = std::thread(&Collection::run_backfill, this, backfill, on_done);
+    hide_alter_credentials(alter_payload);
 
     return Option<bool>(true);
 }
 
+void Collection::run_backfill(std::shared_ptr<alter_backfill_t> backfill, std::function<void()> on_done) {
+    // with a rate, a batch takes about a second
+    const size_t batch_size = backfill->rate == 0 ? 1000 : std::min<size_t>(1000, backfill->rate);
+    uint32_t next_seq_id = 0;
+
+    auto log_begin = std::chrono::steady_clock::now();
+
+    while(!backfill->stop) {
+        const auto batch_begin = std::chrono::steady_clock::now();
+        const size_t num_read = backfill_batch(*backfill, next_seq_id, batch_size);
+
+        if(num_read == 0) {
+            break;
+        }
+
+        if(std::chrono::steady_clock::now() - log_begin > std::chrono::seconds(30)) {
+            log_begin = std::chrono::steady_clock::now();
+            LOG(INFO) << "Backfilled " << backfill->num_backfilled << " of about " << backfill->num_documents
+                      << " document(s) of collection " << name << " so far.";
+        }
+
+        if(backfill->rate != 0) {
+            const auto batch_end = batch_begin + std::chrono::microseconds(num_read * 1000 * 1000 / backfill->rate);
+            while(!backfill->stop && std::chrono::steady_clock::now() < batch_end) {
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                        batch_end - std::chrono::steady_clock::now(), std::chrono::milliseconds(100)));
+            }
+        }
+    }
+
+    if(backfill->stop) {
+        LOG(INFO) << "Stopped the backfill of collection " << name << " after "
+                  << backfill->num_backfilled << " document(s).";
+    } else {
+        finish_backfill();
+        LOG(INFO) << "Finished backfilling " << backfill->num_backfilled << " document(s) of collection " << name
+                  << ", with " << backfill->num_failed << " failure(s).";
+    }
+
+    if(on_done) {
+        on_done();
+    }
+}
+
+size_t Collection::backfill_batch(alter_backfill_t& backfill, uint32_t& next_seq_id, size_t batch_size) {
+    // writes are held off from their in-memory indexing to their write to the store
+    std::unique_lock backfill_lock(backfill_mutex);
+    std::unique_lock write_lock(write_mutex);
+    std::shared_lock lock(mutex);
+
+    const std::string seq_id_prefix = get_seq_id_collection_prefix();
+    std::string upper_bound_key = get_seq_id_collection_prefix() + "`";  // cannot inline this
+    rocksdb::Slice upper_bound(upper_bound_key);
+
+    rocksdb::Iterator* iter = store->scan(get_seq_id_key(next_seq_id), &upper_bound, false);
+    std::unique_ptr<rocksdb::Iterator> iter_guard(iter);
+
+    std::vector<index_record> iter_batch;
+    size_t num_read = 0;
+
+    while(iter->Valid() && iter->key().starts_with(seq_id_prefix) && num_read < batch_size) {
+        num_read++;
+        const uint32_t seq_id = Collection::get_seq_id_from_key(iter->key().ToString());
+        next_seq_id = seq_id + 1;
+
+        nlohmann::json document;
+
+        try {
+            document = parse_stored_document(iter->value().ToString());
+        } catch(const std::exception& e) {
+            LOG(ERROR) << "Backfill skips the document with seq id " << seq_id << ": " << e.what();
+            backfill.num_failed++;
+            iter->Next();
+            continue;
+        }
+
+        if(enable_nested_fields) {
+            std::vector<field> flattened_fields;
+            field::flatten_doc(document, nested_fields, {}, true, flattened_fields);
+        }
+
+        iter_batch.emplace_back(iter_batch.size(), seq_id, document, index_operation_t::CREATE,
+                                DIRTY_VALUES::COERCE_OR_DROP);
+        iter->Next();
+    }
+
+    if(num_read == 0) {
+        return 0;
+    }
+
+    // writes from here on are indexed on the new fields, as the documents before `next_seq_id` are now
+    index->set_backfill_end(next_seq_id);
+
+    Index::preprocess_batch(index, iter_batch, default_sorting_field, backfill.search_schema,
+                            backfill.embedding_fields, fallback_field_type, token_separators, symbols_to_index,
+                            true, 200, 60000, 2, backfill.has_embedding_field);
+
+    lock.unlock();
+    std::unique_lock ulock(mutex);
+    Index::index_preprocessed_batch(index, iter_batch, backfill.schema_additions);
+    ulock.unlock();
+
+    for(auto& index_record: iter_batch) {
+        if(!index_record.indexed.ok()) {
+            backfill.num_failed++;
+            continue;
+        }
+
+        if(backfill.has_embedding_field) {
+            remove_flat_fields(index_record.doc);
+            const std::string& serialized_json = serialize_document(index_record.doc);
+            if(!store->insert(get_seq_id_key(index_record.seq_id), serialized_json)) {
+                LOG(ERROR) << "Inserting doc with new embedding field failed for seq id: " << index_record.seq_id;
+                backfill.num_failed++;
+                continue;
+            }
+        }
+
+        backfill.num_backfilled++;
+    }
+
+    return num_read;
+}
+
+void Collection::finish_backfill() {
+    std::unique_lock write_lock(write_mutex);
+    std::unique_lock ulock(mutex);
+
+    for(const auto& f: alter_backfill->fields) {
+        search_schema.emplace(f.name, f);
+        schema_version++;
+        fields.push_back(f);
+
+        if(f.embed.count(fields::from) != 0) {
+            embedding_fields.emplace(f.name, f);
+        }
+    }
+
+    index->finish_backfill();
+    alter_backfill = nullptr;
+
+    auto persist_op = persist_collection_meta();
+    if(!persist_op.ok()) {
+        LOG(ERROR) << "Fields of the background alter of collection " << name << " are not persisted: "
+                   << persist_op.error();
+    }
+
+    advance_write_generation();
+}
+
+nlohmann::json Collection::get_alter_status() const {
+    std::shared_lock lock(mutex);
+
+    if(alter_backfill == nullptr) {
+        return nullptr;
+    }
+
+    return backfill_status(*alter_backfill);
+}
+
+nlohmann::json Collection::backfill_status(const alter_backfill_t& backfill) {
+    nlohmann::json status;
+    status["fields"] = nlohmann::json::array();
+    for(const auto& f: backfill.fields) {
+        status["fields"].push_back(f.name);
+    }
+
+    status["num_backfilled"] = backfill.num_backfilled.load();
+    status["num_failed"] = backfill.num_failed.load();
+    status["num_documents"] = backfill.num_documents;
+    status["rate"] = backfill.rate;
+    status["started_at"] = backfill.started_at;
+
+    return status;
+}
+
 void Collection::remove_flat_fields(nlohmann::json& document) {
     if(document.count(".flat") != 0) {
         for(const auto& flat_key: document[".flat"].get<std::vector<std::string>>()) {
@@ -5108,6 +6614,69 @@ void Collection::remove_flat_fields(nlohmann::json& document) {
     }
 }
 
+static bool contains_null(const nlohmann::json& value) {
+    if(value.is_null()) {
+        return true;
+    }
+
+    if(value.is_structured()) {
+        for(const auto& item: value) {
+            if(contains_null(item)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static bool merge_patch_diff(const nlohmann::json& old_value, const nlohmann::json& new_value,
+                             const std::unordered_set<std::string>& skipped_keys, nlohmann::json& patch) {
+    patch = nlohmann::json::object();
+
+    for(auto it = new_value.begin(); it != new_value.end(); ++it) {
+        const auto old_it = old_value.find(it.key());
+
+        if(old_it != old_value.end() && *old_it == it.value()) {
+            continue;
+        }
+
+        if(old_it != old_value.end() && old_it->is_object() && it.value().is_object()) {
+            // nested objects are patched key by key, as a patch merges into them instead of replacing them
+            nlohmann::json nested_patch;
+            if(!merge_patch_diff(*old_it, it.value(), {}, nested_patch)) {
+                return false;
+            }
+            patch[it.key()] = nested_patch;
+        } else if(contains_null(it.value())) {
+            return false;
+        } else {
+            patch[it.key()] = it.value();
+        }
+    }
+
+    for(auto it = old_value.begin(); it != old_value.end(); ++it) {
+        if(skipped_keys.count(it.key()) == 0 && !new_value.contains(it.key())) {
+            patch[it.key()] = nullptr;
+        }
+    }
+
+    return true;
+}
+
+bool Collection::get_stored_doc_patch(const nlohmann::json& old_doc, const nlohmann::json& new_doc,
+                                      nlohmann::json& patch) {
+    // flattened values of nested fields are never stored
+    std::unordered_set<std::string> flat_keys = {".flat"};
+    if(old_doc.count(".flat") != 0) {
+        for(const auto& flat_key: old_doc[".flat"]) {
+            flat_keys.insert(flat_key.get<std::string>());
+        }
+    }
+
+    return merge_patch_diff(old_doc, new_doc, flat_keys, patch);
+}
+
 void Collection::remove_reference_helper_fields(nlohmann::json& document) {
     if(document.count(fields::reference_helper_fields) != 0) {
         for(const auto& key: document[fields::reference_helper_fields].get<std::vector<std::string>>()) {
@@ -5117,6 +6686,85 @@ void Collection::remove_reference_helper_fields(nlohmann::json& document) {
     }
 }
 
+Option<bool> Collection::get_ref_document(const uint32_t& seq_id, nlohmann::json& document) const {
+    if(ref_doc_cache == nullptr) {
+        return get_document_from_store(seq_id, document);
+    }
+
+    auto& docs = ref_doc_cache->collection_docs[name];
+    const auto doc_it = docs.find(seq_id);
+    if(doc_it != docs.end()) {
+        document = doc_it->second;
+        return Option<bool>(true);
+    }
+
+    auto get_doc_op = get_document_from_store(seq_id, document);
+    if(get_doc_op.ok()) {
+        docs.emplace(seq_id, document);
+    }
+
+    return get_doc_op;
+}
+
+void Collection::prefetch_ref_documents(const std::vector<const KV*>& kvs) const {
+    if(ref_doc_cache == nullptr) {
+        return ;
+    }
+
+    auto& docs = ref_doc_cache->collection_docs[name];
+    std::set<uint32_t> seq_ids;
+
+    for(const KV* kv: kvs) {
+        const auto& reference_filter_results = kv->get_reference_filter_results();
+        const auto references_it = reference_filter_results.find(name);
+        if(references_it == reference_filter_results.end()) {
+            continue;
+        }
+
+        const auto& references = references_it->second;
+        for(uint32_t i = 0; i < references.count; i++) {
+            if(docs.count(references.docs[i]) == 0) {
+                seq_ids.insert(references.docs[i]);
+            }
+        }
+    }
+
+    if(seq_ids.empty()) {
+        return ;
+    }
+
+    std::vector<std::string> seq_id_keys;
+    for(const auto seq_id: seq_ids) {
+        seq_id_keys.push_back(get_seq_id_key(seq_id));
+    }
+
+    std::vector<std::string> stored_docs;
+    std::vector<StoreStatus> statuses;
+    store->multi_get(seq_id_keys, stored_docs, statuses);
+
+    // documents that could not be fetched or parsed are left to `get_ref_document`, which reports the error
+    auto seq_id_it = seq_ids.begin();
+    for(size_t i = 0; i < seq_id_keys.size(); i++, seq_id_it++) {
+        if(statuses[i] != StoreStatus::FOUND) {
+            continue;
+        }
+
+        nlohmann::json document;
+        try {
+            document = parse_stored_document(stored_docs[i]);
+        } catch(...) {
+            continue;
+        }
+
+        if(enable_nested_fields) {
+            std::vector<field> flattened_fields;
+            field::flatten_doc(document, nested_fields, {}, true, flattened_fields);
+        }
+
+        docs.emplace(*seq_id_it, std::move(document));
+    }
+}
+
 Option<bool> Collection::prune_ref_doc(nlohmann::json& doc,
                                        const reference_filter_result_t& references,
                                        const tsl::htrie_set<char>& ref_include_fields_full,
@@ -5139,7 +6787,7 @@ Option<bool> Collection::prune_ref_doc(nlohmann::json& doc,
         auto ref_doc_seq_id = references.docs[0];
 
         nlohmann::json ref_doc;
-        auto get_doc_op = ref_collection->get_document_from_store(ref_doc_seq_id, ref_doc);
+        auto get_doc_op = ref_collection->get_ref_document(ref_doc_seq_id, ref_doc);
         if (!get_doc_op.ok()) {
             return Option<bool>(get_doc_op.code(), error_prefix + get_doc_op.error());
         }
@@ -5187,7 +6835,7 @@ Option<bool> Collection::prune_ref_doc(nlohmann::json& doc,
         auto ref_doc_seq_id = references.docs[i];
 
         nlohmann::json ref_doc;
-        auto get_doc_op = ref_collection->get_document_from_store(ref_doc_seq_id, ref_doc);
+        auto get_doc_op = ref_collection->get_ref_document(ref_doc_seq_id, ref_doc);
         if (!get_doc_op.ok()) {
             return Option<bool>(get_doc_op.code(), error_prefix + get_doc_op.error());
         }
@@ -5712,7 +7360,7 @@ Option<bool> Collection::validate_alter_payload(nlohmann::json& schema_changes,
     std::string upper_bound_key = get_seq_id_collection_prefix() + "`";  // cannot inline this
     rocksdb::Slice upper_bound(upper_bound_key);
 
-    rocksdb::Iterator* iter = store->scan(seq_id_prefix, &upper_bound);
+    rocksdb::Iterator* iter = store->scan(seq_id_prefix, &upper_bound, false);
     std::unique_ptr<rocksdb::Iterator> iter_guard(iter);
 
     size_t num_found_docs = 0;
@@ -5724,7 +7372,7 @@ Option<bool> Collection::validate_alter_payload(nlohmann::json& schema_changes,
         nlohmann::json document;
 
         try {
-            document = nlohmann::json::parse(iter->value().ToString());
+            document = parse_stored_document(iter->value().ToString());
         } catch(const std::exception& e) {
             return Option<bool>(400, "Bad JSON in document: " + document.dump(-1, ' ', false,
                                                                                 nlohmann::detail::error_handler_t::ignore));
@@ -6030,6 +7678,7 @@ Index* Collection::init_index() {
         }
 
         search_schema.emplace(field.name, field);
+        schema_version++;
 
         if(field.nested) {
             nested_fields.emplace(field.name, field);
@@ -6076,7 +7725,8 @@ Index* Collection::init_index() {
                      synonym_index,
                      CollectionManager::get_instance().get_thread_pool(),
                      search_schema,
-                     symbols_to_index, token_separators);
+                     symbols_to_index, token_separators,
+                     CollectionManager::get_instance().get_indexing_thread_pool());
 }
 
 DIRTY_VALUES Collection::parse_dirty_values_option(std::string& dirty_values) const {
@@ -6123,9 +7773,44 @@ bool Collection::get_enable_nested_fields() {
     return enable_nested_fields;
 }
 
+std::string Collection::get_storage_format() const {
+    return storage_format;
+}
+
+Option<bool> Collection::parse_facet_cached(const std::string& facet_field, std::vector<facet>& facets) const {
+    const std::string cache_key = std::to_string(schema_version.load()) + ":" + facet_field;
+    std::shared_ptr<const std::vector<facet>> parsed_facets;
+
+    {
+        std::unique_lock lock(parsed_facets_cache_mutex);
+        if(parsed_facets_cache.contains(cache_key)) {
+            parsed_facets = parsed_facets_cache.lookup(cache_key);
+        }
+    }
+
+    if(parsed_facets == nullptr) {
+        std::vector<facet> new_facets;
+        auto parse_op = parse_facet(facet_field, new_facets);
+        if(!parse_op.ok()) {
+            return parse_op;
+        }
+
+        parsed_facets = std::make_shared<const std::vector<facet>>(std::move(new_facets));
+        std::unique_lock lock(parsed_facets_cache_mutex);
+        parsed_facets_cache.insert(cache_key, parsed_facets);
+    }
+
+    for(const auto& parsed_facet: *parsed_facets) {
+        facets.push_back(parsed_facet);
+        facets.back().orig_index = facets.size() - 1;
+    }
+
+    return Option<bool>(true);
+}
+
 Option<bool> Collection::parse_facet(const std::string& facet_field, std::vector<facet>& facets) const {
-    const std::regex base_pattern(".+\\(.*\\)");
-    const std::regex range_pattern("[[0-9]*[a-z A-Z]+[0-9]*:\\[([+-]?([0-9]*[.])?[0-9]*)\\,\\s*([+-]?([0-9]*[.])?[0-9]*)\\]");
+    static const std::regex base_pattern(".+\\(.*\\)");
+    static const std::regex range_pattern("[[0-9]*[a-z A-Z]+[0-9]*:\\[([+-]?([0-9]*[.])?[0-9]*)\\,\\s*([+-]?([0-9]*[.])?[0-9]*)\\]");
     const std::string _alpha = "_alpha";
 
    if ((facet_field.find(":") != std::string::npos)
@@ -6471,6 +8156,7 @@ void Collection::process_remove_field_for_embedding_fields(const field& del_fiel
     for(auto& garbage_field: garbage_embed_fields) {
         remove_embedding_field(garbage_field.name);
         search_schema.erase(garbage_field.name);
+        schema_version++;
         fields.erase(std::remove_if(fields.begin(), fields.end(), [&garbage_field](const auto &f) {
             return f.name == garbage_field.name;
         }), fields.end());
@@ -6492,6 +8178,7 @@ void Collection::hide_credential(nlohmann::json& json, const std::string& creden
 
 Option<bool> Collection::truncate_after_top_k(const string &field_name, size_t k) {
     std::shared_lock slock(mutex);
+    index->purge_deleted();
 
     std::vector<uint32_t> seq_ids;
     auto op = index->seq_ids_outside_top_k(field_name, k, seq_ids);
@@ -6514,7 +8201,7 @@ Option<bool> Collection::truncate_after_top_k(const string &field_name, size_t k
 
 void Collection::reference_populate_sort_mapping(int *sort_order, std::vector<size_t> &geopoint_indices,
                                                  std::vector<sort_by> &sort_fields_std,
-                                                 std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32> *, 3> &field_values)
+                                                 std::array<sort_column_t*, 3> &field_values)
                                                  const {
     std::shared_lock lock(mutex);
     index->populate_sort_mapping_with_lock(sort_order, geopoint_indices, sort_fields_std, field_values);
@@ -6595,6 +8282,10 @@ void Collection::do_housekeeping() {
     index->repair_hnsw_index();
 }
 
+size_t Collection::compact_vector_indices() {
+    return index->compact_vector_indices();
+}
+
 Option<bool> Collection::parse_and_validate_vector_query(const std::string& vector_query_str,
                                                          vector_query_t& vector_query,
                                                          const bool is_wildcard_query,
@@ -6647,7 +8338,7 @@ Option<bool> Collection::parse_and_validate_vector_query(const std::string& vect
             }
 
             std::string embed_query = embedder_manager.get_query_prefix(vector_field_it.value().embed[fields::model_config]) + q;
-            auto embedding_op = embedder->Embed(embed_query, remote_embedding_timeout_ms, remote_embedding_num_tries);
+            auto embedding_op = embedder->embed_query(embed_query, remote_embedding_timeout_ms, remote_embedding_num_tries);
 
             if(!embedding_op.success) {
                 if(!embedding_op.error["error"].get<std::string>().empty()) {
@@ -6700,6 +8391,13 @@ Option<bool> Collection::parse_and_validate_vector_query(const std::string& vect
         }
     }
 
+    for(const auto& values: vector_query.extra_values) {
+        if(vector_field_it.value().num_dim != values.size()) {
+            return Option<bool>(400, "Query field `" + vector_query.field_name + "` must have " +
+                                     std::to_string(vector_field_it.value().num_dim) + " dimensions.");
+        }
+    }
+
     return Option<bool>(true);
 }
 
@@ -1,14 +1,21 @@
 #include <string>
+#include <fstream>
+#include <deque>
+#include <thread>
 #include <vector>
 #include <json.hpp>
 #include <app_metrics.h>
 #include <analytics_manager.h>
 #include <event_manager.h>
 #include "collection_manager.h"
+#include "shard_merger.h"
 #include "batched_indexer.h"
+#include "memory_arenas.h"
+#include "slow_search_log.h"
 #include "logger.h"
 #include "magic_enum.hpp"
 #include "stopwords_manager.h"
+#include "admission_controller.h"
 #include "conversation_model.h"
 #include "field.h"
 
@@ -119,6 +126,10 @@ Collection* CollectionManager::init_collection(const nlohmann::json & collection
                 -1, field_obj[fields::infix], field_obj[fields::nested], field_obj[fields::nested_array],
                 field_obj[fields::num_dim], vec_dist_type, field_obj[fields::reference], field_obj[fields::embed], field_obj[fields::range_index], field_obj[fields::store], field_obj[fields::stem], field_obj[fields::hnsw_params]);
 
+        if(field_obj.count(fields::exact_match_index) != 0) {
+            f.exact_match_index = field_obj[fields::exact_match_index].get<bool>();
+        }
+
         // value of `sort` depends on field type
         if(field_obj.count(fields::sort) == 0) {
             f.sort = f.is_num_sort_field();
@@ -146,6 +157,11 @@ Collection* CollectionManager::init_collection(const nlohmann::json & collection
                                  collection_meta[Collection::COLLECTION_ENABLE_NESTED_FIELDS].get<bool>() :
                                  false;
 
+    // collections created before the storage format was configurable hold JSON documents
+    std::string storage_format = collection_meta.count(Collection::COLLECTION_STORAGE_FORMAT) != 0 ?
+                                 collection_meta[Collection::COLLECTION_STORAGE_FORMAT].get<std::string>() :
+                                 Collection::STORAGE_FORMAT_JSON;
+
     std::vector<std::string> symbols_to_index;
     std::vector<std::string> token_separators;
 
@@ -194,7 +210,8 @@ Collection* CollectionManager::init_collection(const nlohmann::json & collection
                                             fallback_field_type,
                                             symbols_to_index,
                                             token_separators,
-                                            enable_nested_fields, model, std::move(referenced_in));
+                                            enable_nested_fields, model, std::move(referenced_in),
+                                            storage_format);
 
     return collection;
 }
@@ -210,11 +227,13 @@ void CollectionManager::add_to_collections(Collection* collection) {
 void CollectionManager::init(Store *store, ThreadPool* thread_pool,
                              const float max_memory_ratio,
                              const std::string & auth_key,
-                             std::atomic<bool>& quit) {
+                             std::atomic<bool>& quit,
+                             ThreadPool* indexing_thread_pool) {
     std::unique_lock lock(mutex);
 
     this->store = store;
     this->thread_pool = thread_pool;
+    this->indexing_thread_pool = (indexing_thread_pool == nullptr) ? thread_pool : indexing_thread_pool;
     this->bootstrap_auth_key = auth_key;
     this->max_memory_ratio = max_memory_ratio;
     this->quit = &quit;
@@ -296,9 +315,37 @@ Option<bool> CollectionManager::load(const size_t collection_batch_size, const s
     }
     delete iter;
 
+    std::string sharded_alias_prefix_key = std::string(SHARDED_ALIAS_PREFIX) + "_";
+    std::string sharded_alias_upper_bound_key = std::string(SHARDED_ALIAS_PREFIX) + "`";  // cannot inline this
+    rocksdb::Slice sharded_alias_upper_bound(sharded_alias_upper_bound_key);
+
+    iter = store->scan(sharded_alias_prefix_key, &sharded_alias_upper_bound);
+    while(iter->Valid() && iter->key().starts_with(sharded_alias_prefix_key)) {
+        const std::string alias_name = iter->key().ToString().substr(sharded_alias_prefix_key.size());
+        nlohmann::json collection_names = nlohmann::json::parse(iter->value().ToString(), nullptr, false);
+
+        if(!collection_names.is_discarded() && collection_names.is_array()) {
+            LOG(INFO) << "Loading sharded alias " << alias_name << " to " << collection_names.dump();
+            sharded_aliases[alias_name] = collection_names.get<std::vector<std::string>>();
+        } else {
+            LOG(ERROR) << "Invalid collection names of sharded alias " << alias_name;
+        }
+
+        iter->Next();
+    }
+    delete iter;
+
     LOG(INFO) << "Loading upto " << collection_batch_size << " collections in parallel, "
               << document_batch_size << " documents at a time.";
 
+    load_document_batch_size = document_batch_size;
+
+    {
+        // all the collections of the store are loaded again
+        std::unique_lock lock(mutex);
+        evicted_collections.clear();
+    }
+
     std::vector<std::string> collection_meta_jsons;
     store->scan_fill(std::string(Collection::COLLECTION_META_PREFIX) + "_",
                      std::string(Collection::COLLECTION_META_PREFIX) + "`",
@@ -315,29 +362,108 @@ Option<bool> CollectionManager::load(const size_t collection_batch_size, const s
         _populate_referenced_ins(collection_meta_json, referenced_ins);
     }
 
-    size_t num_processed = 0;
-    std::mutex m_process;
-    std::condition_variable cv_process;
-    std::string collection_name;
+    // collection id => index image meta
+    nlohmann::json index_images = nlohmann::json::object();
+    if(!index_image_dir.empty()) {
+        std::ifstream image_meta_file(index_image_dir + "/" + INDEX_IMAGE_META_FILE);
+        nlohmann::json image_meta = nlohmann::json::parse(image_meta_file, nullptr, false);
 
-    for(size_t coll_index = 0; coll_index < num_collections; coll_index++) {
-        const auto& collection_meta_json = collection_meta_jsons[coll_index];
+        if(!image_meta.is_discarded() && image_meta.is_object() && image_meta.count("version") != 0 &&
+           image_meta["version"] == INDEX_IMAGE_VERSION && image_meta.count("collections") != 0 &&
+           image_meta["collections"].is_object()) {
+            index_images = image_meta["collections"];
+            LOG(INFO) << "Found index images of " << index_images.size() << " collection(s).";
+        } else {
+            LOG(WARNING) << "Ignoring invalid or incompatible index images at " << index_image_dir;
+        }
+    }
+
+    // The hot collections are loaded first, in the configured order, so that they are served as early as possible.
+    // The largest of the rest are loaded next, so that they don't hold up the load once the smaller ones are
+    // done and each thread of the pool stays busy until the end. Their next seq ids stand for their sizes.
+    std::unordered_map<std::string, size_t> hot_collection_ranks;
+    for(const auto& hot_collection: hot_collections) {
+        const auto symlink_it = collection_symlinks.find(hot_collection);
+        const auto& name = (symlink_it != collection_symlinks.end()) ? symlink_it->second : hot_collection;
+        hot_collection_ranks.emplace(name, hot_collection_ranks.size());
+    }
+
+    std::vector<std::pair<uint32_t, nlohmann::json>> collection_metas;
+
+    for(const auto& collection_meta_json: collection_meta_jsons) {
         nlohmann::json collection_meta = nlohmann::json::parse(collection_meta_json, nullptr, false);
         if(collection_meta.is_discarded()) {
             LOG(ERROR) << "Error while parsing collection meta, json: " << collection_meta_json;
             return Option<bool>(500, "Error while parsing collection meta.");
         }
 
+        uint32_t next_seq_id = 0;
+        if(collection_meta.count(Collection::COLLECTION_NAME_KEY) != 0 &&
+           collection_meta[Collection::COLLECTION_NAME_KEY].is_string()) {
+            std::string next_seq_id_str;
+            const auto& name = collection_meta[Collection::COLLECTION_NAME_KEY].get<std::string>();
+            if(store->get(Collection::get_next_seq_id_key(name), next_seq_id_str) == StoreStatus::FOUND) {
+                next_seq_id = StringUtils::deserialize_uint32_t(next_seq_id_str);
+            }
+        }
+
+        collection_metas.emplace_back(next_seq_id, std::move(collection_meta));
+    }
+
+    auto hot_rank = [&hot_collection_ranks](const nlohmann::json& collection_meta) {
+        const auto name_it = collection_meta.find(Collection::COLLECTION_NAME_KEY);
+        if(name_it == collection_meta.end() || !name_it->is_string()) {
+            return hot_collection_ranks.size();
+        }
+
+        const auto rank_it = hot_collection_ranks.find(name_it->get<std::string>());
+        return (rank_it == hot_collection_ranks.end()) ? hot_collection_ranks.size() : rank_it->second;
+    };
+
+    std::stable_sort(collection_metas.begin(), collection_metas.end(), [&hot_rank](const auto& a, const auto& b) {
+        const size_t a_rank = hot_rank(a.second), b_rank = hot_rank(b.second);
+        return (a_rank != b_rank) ? (a_rank < b_rank) : (a.first > b.first);
+    });
+
+    {
+        std::unique_lock lock(load_states_mutex);
+        collection_load_states.clear();
+        for(const auto& size_meta: collection_metas) {
+            collection_load_states[size_meta.second[Collection::COLLECTION_NAME_KEY].get<std::string>()] =
+                    LOAD_STATE_PENDING;
+        }
+    }
+
+    loading_collections = true;
+
+    size_t num_processed = 0;
+    std::mutex m_process;
+    std::condition_variable cv_process;
+    std::string collection_name;
+
+    for(size_t coll_index = 0; coll_index < num_collections; coll_index++) {
+        const auto& collection_meta = collection_metas[coll_index].second;
         collection_name = collection_meta[Collection::COLLECTION_NAME_KEY].get<std::string>();
 
+        nlohmann::json index_image_meta;
+        if(collection_meta.count(Collection::COLLECTION_ID_KEY) != 0) {
+            const auto& image_it = index_images.find(collection_meta[Collection::COLLECTION_ID_KEY].dump());
+            if(image_it != index_images.end()) {
+                index_image_meta = image_it.value();
+            }
+        }
+
         auto captured_store = store;
         loading_pool.enqueue([captured_store, num_collections, collection_meta, document_batch_size,
                               &m_process, &cv_process, &num_processed, &next_coll_id_status, quit = quit,
-                                     &referenced_ins, collection_name]() {
+                                     &referenced_ins, collection_name, index_image_meta]() {
+
+            auto& cm = CollectionManager::get_instance();
+            cm.set_collection_load_state(collection_name, LOAD_STATE_LOADING);
 
             //auto begin = std::chrono::high_resolution_clock::now();
             Option<bool> res = load_collection(collection_meta, document_batch_size, next_coll_id_status, *quit,
-                                               referenced_ins[collection_name]);
+                                               referenced_ins[collection_name], index_image_meta);
             /*long long int timeMillis =
                     std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - begin).count();
             LOG(INFO) << "Time taken for indexing: " << timeMillis << "ms";*/
@@ -349,10 +475,11 @@ Option<bool> CollectionManager::load(const size_t collection_batch_size, const s
                 exit(1);
             }
 
+            cm.set_collection_load_state(collection_name, LOAD_STATE_READY);
+
             std::unique_lock<std::mutex> lock(m_process);
             num_processed++;
 
-            auto& cm = CollectionManager::get_instance();
             cv_process.notify_one();
 
             size_t progress_modulo = std::max<size_t>(1, (num_collections / 10));  // every 10%
@@ -368,6 +495,13 @@ Option<bool> CollectionManager::load(const size_t collection_batch_size, const s
         return num_processed == num_collections;
     });
 
+    loading_collections = false;
+
+    {
+        std::unique_lock lock(load_states_mutex);
+        collection_load_states.clear();
+    }
+
     // load presets
 
     std::string preset_prefix_key = std::string(PRESET_PREFIX) + "_";
@@ -431,6 +565,8 @@ Option<bool> CollectionManager::load(const size_t collection_batch_size, const s
 
 
 void CollectionManager::dispose() {
+    wait_for_drops();
+
     std::unique_lock lock(mutex);
 
     for(auto & name_collection: collections) {
@@ -439,7 +575,9 @@ void CollectionManager::dispose() {
     }
 
     collections.clear();
+    evicted_collections.clear();
     collection_symlinks.clear();
+    sharded_aliases.clear();
     preset_configs.clear();
     store->close();
 }
@@ -468,7 +606,8 @@ Option<Collection*> CollectionManager::create_collection(const std::string& name
                                                          const std::vector<std::string>& symbols_to_index,
                                                          const std::vector<std::string>& token_separators,
                                                          const bool enable_nested_fields, std::shared_ptr<VQModel> model,
-                                                         const nlohmann::json& metadata) {
+                                                         const nlohmann::json& metadata,
+                                                         const std::string& storage_format) {
     std::unique_lock lock(mutex);
 
     if(store->contains(Collection::get_meta_key(name))) {
@@ -483,6 +622,12 @@ Option<Collection*> CollectionManager::create_collection(const std::string& name
         }
     }
 
+    if(storage_format != Collection::STORAGE_FORMAT_JSON && storage_format != Collection::STORAGE_FORMAT_MSGPACK) {
+        return Option<Collection*>(400, std::string("`") + Collection::COLLECTION_STORAGE_FORMAT + "` should be either `" +
+                                        Collection::STORAGE_FORMAT_JSON + "` or `" +
+                                        Collection::STORAGE_FORMAT_MSGPACK + "`.");
+    }
+
     nlohmann::json fields_json = nlohmann::json::array();;
 
     Option<bool> fields_json_op = field::fields_to_json_fields(fields, default_sorting_field, fields_json);
@@ -505,6 +650,7 @@ Option<Collection*> CollectionManager::create_collection(const std::string& name
     collection_meta[Collection::COLLECTION_SYMBOLS_TO_INDEX] = symbols_to_index;
     collection_meta[Collection::COLLECTION_SEPARATORS] = token_separators;
     collection_meta[Collection::COLLECTION_ENABLE_NESTED_FIELDS] = enable_nested_fields;
+    collection_meta[Collection::COLLECTION_STORAGE_FORMAT] = storage_format;
 
     if(model != nullptr) {
         collection_meta[Collection::COLLECTION_VOICE_QUERY_MODEL] = nlohmann::json::object();
@@ -531,7 +677,8 @@ Option<Collection*> CollectionManager::create_collection(const std::string& name
                                                 default_sorting_field,
                                                 this->max_memory_ratio, fallback_field_type,
                                                 symbols_to_index, token_separators,
-                                                enable_nested_fields, model);
+                                                enable_nested_fields, model,
+                                                spp::sparse_hash_map<std::string, std::string>(), storage_format);
 
     add_to_collections(new_collection);
 
@@ -561,21 +708,94 @@ Collection* CollectionManager::get_collection_unsafe(const std::string & collect
     return nullptr;
 }
 
+const std::pair<const std::string, CollectionManager::evicted_collection_t>*
+CollectionManager::get_evicted_collection_unsafe(const std::string& collection_name) const {
+    auto evicted_it = evicted_collections.find(collection_name);
+
+    if(evicted_it == evicted_collections.end() && collection_symlinks.count(collection_name) != 0) {
+        evicted_it = evicted_collections.find(collection_symlinks.at(collection_name));
+    }
+
+    return evicted_it != evicted_collections.end() ? &(*evicted_it) : nullptr;
+}
+
+bool CollectionManager::is_collection_evicted(const std::string& collection_name) const {
+    std::shared_lock lock(mutex);
+    return get_collection_unsafe(collection_name) == nullptr &&
+           get_evicted_collection_unsafe(collection_name) != nullptr;
+}
+
+bool CollectionManager::is_loading_collections() const {
+    return loading_collections;
+}
+
+bool CollectionManager::is_collection_loaded(const std::string& collection_name) const {
+    std::shared_lock lock(mutex);
+    // collections are added only once all their documents are indexed, while an evicted one is loaded on lookup
+    return get_collection_unsafe(collection_name) != nullptr ||
+           get_evicted_collection_unsafe(collection_name) != nullptr;
+}
+
+nlohmann::json CollectionManager::get_collection_load_states() const {
+    std::unique_lock lock(load_states_mutex);
+    nlohmann::json states = nlohmann::json::object();
+    for(const auto& name_state: collection_load_states) {
+        states[name_state.first] = name_state.second;
+    }
+
+    return states;
+}
+
+void CollectionManager::set_collection_load_state(const std::string& collection_name, const std::string& state) {
+    std::unique_lock lock(load_states_mutex);
+    collection_load_states[collection_name] = state;
+}
+
 locked_resource_view_t<Collection> CollectionManager::get_collection(const std::string & collection_name) const {
     std::shared_lock lock(mutex);
     Collection* coll = get_collection_unsafe(collection_name);
-    return coll != nullptr ? locked_resource_view_t<Collection>(coll->get_lifecycle_mutex(), coll) :
-           locked_resource_view_t<Collection>(noop_coll_mutex, coll);
+
+    if(coll == nullptr && get_evicted_collection_unsafe(collection_name) != nullptr) {
+        lock.unlock();
+        CollectionManager::get_instance().restore_evicted_collection(collection_name);
+        lock.lock();
+        coll = get_collection_unsafe(collection_name);
+    }
+
+    if(coll == nullptr) {
+        return locked_resource_view_t<Collection>(noop_coll_mutex, coll);
+    }
+
+    coll->touch();
+    return locked_resource_view_t<Collection>(coll->get_lifecycle_mutex(), coll);
 }
 
 locked_resource_view_t<Collection> CollectionManager::get_collection_with_id(uint32_t collection_id) const {
-    std::shared_lock lock(mutex);
+    std::string collection_name;
+
+    {
+        std::shared_lock lock(mutex);
+        if(collection_id_names.count(collection_id) == 0) {
+            return locked_resource_view_t<Collection>(noop_coll_mutex, nullptr);
+        }
+
+        collection_name = collection_id_names.at(collection_id);
+    }
+
+    // the collection might have to be restored, which can't happen while the lock is held
+    return get_collection(collection_name);
+}
 
-    if(collection_id_names.count(collection_id) != 0) {
-        return get_collection(collection_id_names.at(collection_id));
+uint64_t CollectionManager::get_collection_write_generation(const std::string& collection_name) const {
+    std::shared_lock lock(mutex);
+    Collection* coll = get_collection_unsafe(collection_name);
+    if(coll != nullptr) {
+        return coll->get_write_generation();
     }
 
-    return locked_resource_view_t<Collection>(mutex, nullptr);
+    // an evicted collection has not been written to since it was evicted
+    auto evicted_collection = get_evicted_collection_unsafe(collection_name);
+    return evicted_collection != nullptr ? evicted_collection->second.write_generation : 0;
 }
 
 Option<std::vector<Collection*>> CollectionManager::get_collections(uint32_t limit, uint32_t offset) const {
@@ -628,6 +848,11 @@ std::vector<std::string> CollectionManager::get_collection_names() const {
 Option<nlohmann::json> CollectionManager::drop_collection(const std::string& collection_name,
                                                           const bool remove_from_store,
                                                           const bool compact_store) {
+    if(is_collection_evicted(collection_name)) {
+        // an evicted collection is dropped like any other once it has been loaded again
+        restore_evicted_collection(collection_name);
+    }
+
     std::shared_lock s_lock(mutex);
     auto collection = get_collection_unsafe(collection_name);
 
@@ -640,14 +865,17 @@ Option<nlohmann::json> CollectionManager::drop_collection(const std::string& col
 
     nlohmann::json collection_json = collection->get_summary_json();
 
+    dropped_collection_t dropped_collection;
+    dropped_collection.collection = collection;
+
     if(remove_from_store) {
         const std::string& del_key_prefix = std::to_string(collection->get_collection_id()) + "_";
         const std::string& del_end_prefix = std::to_string(collection->get_collection_id()) + "`";
         store->delete_range(del_key_prefix, del_end_prefix);
 
         if(compact_store) {
-            store->flush();
-            store->compact_range(del_key_prefix, del_end_prefix);
+            dropped_collection.compact_begin = del_key_prefix;
+            dropped_collection.compact_end = del_end_prefix;
         }
 
         // delete overrides
@@ -698,12 +926,67 @@ Option<nlohmann::json> CollectionManager::drop_collection(const std::string& col
     }
 
 
-    // don't hold any collection manager locks here, since this can take some time
-    delete collection;
+    // the collection can't be found anymore, but searches that already hold it are waited for when it's deleted
+    schedule_drop(std::move(dropped_collection));
 
     return Option<nlohmann::json>(collection_json);
 }
 
+void CollectionManager::schedule_drop(dropped_collection_t&& dropped_collection) {
+    std::unique_lock lock(drop_mutex);
+    dropped_collections.push_back(std::move(dropped_collection));
+
+    if(!drop_thread_running) {
+        // a thread that is not running has already released the lock for the last time
+        if(drop_thread.joinable()) {
+            drop_thread.join();
+        }
+
+        drop_thread_running = true;
+        drop_thread = std::thread(&CollectionManager::run_drops, this);
+    }
+}
+
+void CollectionManager::run_drops() {
+    while(true) {
+        dropped_collection_t dropped_collection;
+
+        {
+            std::unique_lock lock(drop_mutex);
+            if(dropped_collections.empty()) {
+                drop_thread_running = false;
+                return ;
+            }
+
+            dropped_collection = std::move(dropped_collections.front());
+            dropped_collections.pop_front();
+        }
+
+        dropped_collection.collection->release_index_in_chunks(DROP_RELEASE_PAUSE);
+        delete dropped_collection.collection;
+        MemoryArenas::get_instance().request_purge();
+
+        if(!dropped_collection.compact_begin.empty()) {
+            store->flush();
+            store->compact_range(dropped_collection.compact_begin, dropped_collection.compact_end);
+        }
+    }
+}
+
+void CollectionManager::wait_for_drops() {
+    std::thread running_drop_thread;
+
+    {
+        std::unique_lock lock(drop_mutex);
+        running_drop_thread = std::move(drop_thread);
+    }
+
+    // the thread exits once it has deleted all the dropped collections
+    if(running_drop_thread.joinable()) {
+        running_drop_thread.join();
+    }
+}
+
 uint32_t CollectionManager::get_next_collection_id() const {
     return next_collection_id;
 }
@@ -734,6 +1017,10 @@ Option<bool> CollectionManager::upsert_symlink(const std::string & symlink_name,
         return Option<bool>(500, "Name `" + symlink_name + "` conflicts with an existing collection name.");
     }
 
+    if(sharded_aliases.count(symlink_name) != 0) {
+        return Option<bool>(500, "Name `" + symlink_name + "` conflicts with an existing sharded alias name.");
+    }
+
     bool inserted = store->insert(get_symlink_key(symlink_name), collection_name);
     if(!inserted) {
         return Option<bool>(500, "Unable to insert into store.");
@@ -743,6 +1030,69 @@ Option<bool> CollectionManager::upsert_symlink(const std::string & symlink_name,
     return Option<bool>(true);
 }
 
+std::string CollectionManager::get_sharded_alias_key(const std::string & alias_name) {
+    return std::string(SHARDED_ALIAS_PREFIX) + "_" + alias_name;
+}
+
+std::vector<std::string> CollectionManager::get_sharded_alias(const std::string & alias_name) const {
+    std::shared_lock lock(mutex);
+
+    auto alias_it = sharded_aliases.find(alias_name);
+    if(alias_it == sharded_aliases.end()) {
+        return {};
+    }
+
+    return alias_it->second;
+}
+
+spp::sparse_hash_map<std::string, std::vector<std::string>> CollectionManager::get_sharded_aliases() const {
+    std::shared_lock lock(mutex);
+    return sharded_aliases;
+}
+
+Option<bool> CollectionManager::upsert_sharded_alias(const std::string & alias_name,
+                                                     const std::vector<std::string>& collection_names) {
+    std::unique_lock lock(mutex);
+
+    if(collections.count(alias_name) != 0) {
+        return Option<bool>(400, "Name `" + alias_name + "` conflicts with an existing collection name.");
+    }
+
+    if(collection_symlinks.count(alias_name) != 0) {
+        return Option<bool>(400, "Name `" + alias_name + "` conflicts with an existing alias name.");
+    }
+
+    if(collection_names.empty()) {
+        return Option<bool>(400, "A sharded alias must span at least one collection.");
+    }
+
+    for(const auto& collection_name: collection_names) {
+        if(collections.count(collection_name) == 0) {
+            return Option<bool>(404, "Collection `" + collection_name + "` not found.");
+        }
+    }
+
+    bool inserted = store->insert(get_sharded_alias_key(alias_name), nlohmann::json(collection_names).dump());
+    if(!inserted) {
+        return Option<bool>(500, "Unable to insert into store.");
+    }
+
+    sharded_aliases[alias_name] = collection_names;
+    return Option<bool>(true);
+}
+
+Option<bool> CollectionManager::delete_sharded_alias(const std::string & alias_name) {
+    std::unique_lock lock(mutex);
+
+    bool removed = store->remove(get_sharded_alias_key(alias_name));
+    if(!removed) {
+        return Option<bool>(500, "Unable to delete from store.");
+    }
+
+    sharded_aliases.erase(alias_name);
+    return Option<bool>(true);
+}
+
 Option<bool> CollectionManager::delete_symlink(const std::string & symlink_name) {
     std::unique_lock lock(mutex);
 
@@ -1379,10 +1729,70 @@ Option<bool> CollectionManager::_initialize_ref_include_exclude_fields_vec(const
     return Option<bool>(true);
 }
 
+// Gives up the features of a search that are the most expensive relative to their effect on the results, one more
+// of them at every degradation level. The parameters that were changed are added to `degradations`.
+static void degrade_search_params(const size_t degradation_level, size_t& facet_sample_percent,
+                                  size_t& max_candidates, std::vector<uint32_t>& num_typos,
+                                  std::vector<enable_t>& infixes, std::vector<std::string>& degradations) {
+    static const size_t DEGRADED_FACET_SAMPLE_PERCENT = 10;
+
+    if(degradation_level >= 1 && facet_sample_percent > DEGRADED_FACET_SAMPLE_PERCENT) {
+        facet_sample_percent = DEGRADED_FACET_SAMPLE_PERCENT;
+        degradations.emplace_back("facet_sample_percent");
+    }
+
+    if(degradation_level >= 2 && max_candidates > Index::NUM_CANDIDATES_DEFAULT_MIN) {
+        max_candidates = Index::NUM_CANDIDATES_DEFAULT_MIN;
+        degradations.emplace_back("max_candidates");
+    }
+
+    if(degradation_level >= 3) {
+        bool degraded = false;
+        for(auto& field_num_typos: num_typos) {
+            if(field_num_typos > 1) {
+                field_num_typos = 1;
+                degraded = true;
+            }
+        }
+
+        if(degraded) {
+            degradations.emplace_back("num_typos");
+        }
+    }
+
+    if(degradation_level >= 4) {
+        bool degraded = false;
+        for(auto& infix: infixes) {
+            if(infix != off) {
+                infix = off;
+                degraded = true;
+            }
+        }
+
+        if(degraded) {
+            degradations.emplace_back("infix");
+        }
+    }
+}
+
 Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& req_params,
                                           nlohmann::json& embedded_params,
                                           std::string& results_json_str,
                                           uint64_t start_ts) {
+    nlohmann::json search_result;
+    auto search_op = do_search(req_params, embedded_params, search_result, start_ts);
+
+    if(search_op.ok()) {
+        results_json_str = search_result.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+    }
+
+    return search_op;
+}
+
+Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& req_params,
+                                          nlohmann::json& embedded_params,
+                                          nlohmann::json& search_result,
+                                          uint64_t start_ts) {
 
     auto begin = std::chrono::high_resolution_clock::now();
 
@@ -1476,6 +1886,11 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
 
     const char *ENABLE_TYPOS_FOR_NUMERICAL_TOKENS = "enable_typos_for_numerical_tokens";
     const char *ENABLE_LAZY_FILTER = "enable_lazy_filter";
+    const char *PROFILE = "profile";
+    const char *APPROXIMATE_FACETS = "approximate_facets";
+    const char *SEARCH_AFTER = "search_after";
+    const char *TOTAL_HITS = "total_hits";
+    const char *FILTER_PARAMS = "filter_params";
 
     // enrich params with values from embedded params
     for(auto& item: embedded_params.items()) {
@@ -1524,6 +1939,12 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
 
     CollectionManager & collectionManager = CollectionManager::get_instance();
     const std::string& orig_coll_name = req_params["collection"];
+
+    const std::vector<std::string>& shard_names = collectionManager.get_sharded_alias(orig_coll_name);
+    if(!shard_names.empty()) {
+        return do_sharded_search(req_params, shard_names, search_result, start_ts);
+    }
+
     auto collection = collectionManager.get_collection(orig_coll_name);
 
     if(collection == nullptr) {
@@ -1597,6 +2018,8 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
     text_match_type_t match_type = max_score;
     bool enable_typos_for_numerical_tokens = true;
     bool enable_lazy_filter = Config::get_instance().get_enable_lazy_filter();
+    bool profile = false;
+    bool approximate_facets = false;
 
     size_t remote_embedding_timeout_ms = 5000;
     size_t remote_embedding_num_tries = 2;
@@ -1613,6 +2036,9 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
     std::string override_tags;
 
     std::string voice_query;
+    std::string search_after;
+    total_hits_t total_hits = total_hits_t::exact;
+    nlohmann::json filter_params = nlohmann::json::object();
 
 
     std::unordered_map<std::string, size_t*> unsigned_int_values = {
@@ -1656,6 +2082,7 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
         {OVERRIDE_TAGS, &override_tags},
         {CONVERSATION_MODEL_ID, &conversation_model_id},
         {VOICE_QUERY, &voice_query},
+        {SEARCH_AFTER, &search_after},
     };
 
     std::unordered_map<std::string, bool*> bool_values = {
@@ -1670,6 +2097,8 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
         {GROUP_MISSING_VALUES, &group_missing_values},
         {ENABLE_TYPOS_FOR_NUMERICAL_TOKENS, &enable_typos_for_numerical_tokens},
         {ENABLE_LAZY_FILTER, &enable_lazy_filter},
+        {PROFILE, &profile},
+        {APPROXIMATE_FACETS, &approximate_facets},
     };
 
     std::unordered_map<std::string, std::vector<std::string>*> str_list_values = {
@@ -1723,6 +2152,22 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
             }
         }
 
+        else if(key == TOTAL_HITS) {
+            auto total_hits_op = magic_enum::enum_cast<total_hits_t>(val);
+            if(!total_hits_op.has_value()) {
+                return Option<bool>(400, "Parameter `total_hits` must be one of `exact`, `approx` or `none`.");
+            }
+
+            total_hits = total_hits_op.value();
+        }
+
+        else if(key == FILTER_PARAMS) {
+            filter_params = nlohmann::json::parse(val, nullptr, false);
+            if(filter_params.is_discarded() || !filter_params.is_object()) {
+                return Option<bool>(400, "Parameter `filter_params` must be a JSON object.");
+            }
+        }
+
         else {
             auto find_int_it = unsigned_int_values.find(key);
             if(find_int_it != unsigned_int_values.end()) {
@@ -1826,6 +2271,23 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
                           Index::NUM_CANDIDATES_DEFAULT_MIN);
     }
 
+    std::vector<std::string> degradations;
+    const size_t degradation_load_percent = Config::get_instance().get_search_degradation_load_percent();
+
+    if(degradation_load_percent != 0) {
+        uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        const uint64_t waited_ms = (start_ts != 0 && now_us > start_ts) ? (now_us - start_ts) / 1000 : 0;
+
+        const size_t degradation_level = AdmissionController::get_degradation_level(
+                AdmissionController::get_instance().get_load_percent(), degradation_load_percent,
+                waited_ms, search_cutoff_ms);
+
+        degrade_search_params(degradation_level, facet_sample_percent, max_candidates, num_typos, infixes,
+                              degradations);
+    }
+
+    const bool log_slow_searches = Config::get_instance().get_log_slow_searches_time_ms() >= 0;
 
     Option<nlohmann::json> result_op = collection->search(raw_query, search_fields, filter_query, facet_fields,
                                                           sort_fields, num_typos,
@@ -1885,7 +2347,12 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
                                                           override_tags,
                                                           voice_query,
                                                           enable_typos_for_numerical_tokens,
-                                                          enable_lazy_filter);
+                                                          enable_lazy_filter,
+                                                          profile || log_slow_searches,
+                                                          approximate_facets,
+                                                          search_after,
+                                                          total_hits,
+                                                          filter_params);
 
     uint64_t timeMillis = std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::high_resolution_clock::now() - begin).count();
@@ -1899,7 +2366,33 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
 
     nlohmann::json result = result_op.get();
 
-    if(Config::get_instance().get_enable_search_analytics()) {
+    // the profile of the search is collected for the slow search log, even when it was not asked for
+    nlohmann::json search_profile_json;
+    if(!profile && result.contains("profile")) {
+        search_profile_json = std::move(result["profile"]);
+        result.erase("profile");
+    } else if(result.contains("profile")) {
+        search_profile_json = result["profile"];
+    }
+
+    const uint64_t search_time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - begin).count();
+    const bool is_slow_search = log_slow_searches &&
+                                int(search_time_us / 1000) >= Config::get_instance().get_log_slow_searches_time_ms();
+
+    const std::string& search_fingerprint = SlowSearchLog::fingerprint(req_params);
+    if(!is_warmup_search) {
+        SlowSearchLog::get_instance().record(orig_coll_name, search_fingerprint, search_time_us, is_slow_search,
+                                             req_params);
+    }
+
+    if(is_slow_search) {
+        LOG(INFO) << "event=slow_search, record="
+                  << SlowSearchLog::slow_search_record(orig_coll_name, search_fingerprint, search_time_us / 1000,
+                                                       result, search_profile_json).dump();
+    }
+
+    if(Config::get_instance().get_enable_search_analytics() && !is_warmup_search) {
         if(result.contains("found")) {
             std::string analytics_query = Tokenizer::normalize_ascii_no_spaces(raw_query);
             if(result["found"].get<size_t>() != 0) {
@@ -1918,26 +2411,219 @@ Option<bool> CollectionManager::do_search(std::map<std::string, std::string>& re
         result["search_time_ms"] = timeMillis;
     }
 
+    if(!degradations.empty()) {
+        result["degradations"] = degradations;
+    }
+
     if(page == 0 && offset != 0) {
         result["offset"] = offset;
     } else {
         result["page"] = (page == 0) ? 1 : page;
     }
 
-    results_json_str = result.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+    if(profile && result.contains("profile")) {
+        // the response is serialized an extra time to measure the cost of serialization itself
+        auto serialization_begin = std::chrono::high_resolution_clock::now();
+        result.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+        result["profile"]["phases_us"]["serialization"] = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - serialization_begin).count();
+    }
+
+    search_result = std::move(result);
 
     //LOG(INFO) << "Time taken: " << timeMillis << "ms";
 
     return Option<bool>(true);
 }
 
+Option<bool> CollectionManager::do_sharded_search(std::map<std::string, std::string>& req_params,
+                                                  const std::vector<std::string>& collection_names,
+                                                  nlohmann::json& search_result,
+                                                  uint64_t start_ts) {
+    // a search returns this many hits at most
+    static constexpr size_t MAX_FETCH_SIZE = 250;
+
+    auto begin = std::chrono::high_resolution_clock::now();
+
+    size_t per_page = 10;
+    size_t page = 0;
+    size_t offset = 0;
+    size_t max_facet_values = 10;
+    size_t group_limit = 3;
+
+    std::unordered_map<std::string, size_t*> unsigned_int_values = {
+        {"per_page", &per_page},
+        {"limit", &per_page},
+        {"page", &page},
+        {"offset", &offset},
+        {"max_facet_values", &max_facet_values},
+        {"group_limit", &group_limit},
+    };
+
+    for(auto& kv: unsigned_int_values) {
+        auto param_it = req_params.find(kv.first);
+        if(param_it != req_params.end()) {
+            auto op = add_unsigned_int_param(kv.first, param_it->second, kv.second);
+            if(!op.ok()) {
+                return op;
+            }
+        }
+    }
+
+    if(req_params.count("group_by") == 0 || req_params["group_by"].empty()) {
+        group_limit = 0;
+    }
+
+    if(req_params.count("conversation") != 0 && req_params["conversation"] == "true") {
+        return Option<bool>(400, "Conversations are not supported on a sharded alias.");
+    }
+
+    std::vector<sort_by> sort_fields;
+    if(req_params.count("sort_by") != 0 && !parse_sort_by_str(req_params["sort_by"], sort_fields)) {
+        return Option<bool>(400, "Parameter `sort_by` is malformed.");
+    }
+
+    // each shard is searched for all the hits up to the end of the requested page
+    const size_t merged_offset = (page == 0 && offset != 0) ? offset : ((page == 0 ? 1 : page) - 1) * per_page;
+    const size_t fetch_size = merged_offset + per_page;
+
+    if(fetch_size > MAX_FETCH_SIZE) {
+        return Option<bool>(422, "Only the first " + std::to_string(MAX_FETCH_SIZE) +
+                                 " hits of a sharded alias can be fetched.");
+    }
+
+    std::string default_sorting_field;
+    {
+        auto& cm = CollectionManager::get_instance();
+        for(const auto& collection_name: collection_names) {
+            auto collection = cm.get_collection(collection_name);
+            if(collection == nullptr) {
+                return Option<bool>(404, "Collection `" + collection_name + "` of the sharded alias not found.");
+            }
+
+            if(default_sorting_field.empty()) {
+                default_sorting_field = collection->get_default_sorting_field();
+            }
+        }
+    }
+
+    const size_t num_shards = collection_names.size();
+    std::vector<std::map<std::string, std::string>> shard_params(num_shards, req_params);
+    std::vector<nlohmann::json> shard_embedded_params(num_shards, nlohmann::json::object());
+    std::vector<nlohmann::json> shard_results(num_shards);
+    std::vector<Option<bool>> shard_ops(num_shards, Option<bool>(true));
+
+    for(size_t i = 0; i < num_shards; i++) {
+        auto& params = shard_params[i];
+        params["collection"] = collection_names[i];
+        params.erase("offset");
+        params.erase("limit");
+        params.erase("preset");
+        params["page"] = "1";
+        params["per_page"] = std::to_string(fetch_size);
+
+        // more values than are returned, so that the top values of all the shards are counted in full more often
+        params["max_facet_values"] = std::to_string(max_facet_values + max_facet_values / 2 + 10);
+    }
+
+    ThreadPool* thread_pool = CollectionManager::get_instance().get_thread_pool();
+    std::vector<std::unique_ptr<pool_task_t>> shard_tasks;
+
+    for(size_t i = 0; i < num_shards; i++) {
+        auto search_shard = [&, i]() {
+            shard_ops[i] = do_search(shard_params[i], shard_embedded_params[i], shard_results[i], start_ts);
+        };
+
+        if(thread_pool == nullptr || i + 1 == num_shards) {
+            // the last shard is searched on this thread
+            search_shard();
+        } else {
+            shard_tasks.emplace_back(new pool_task_t(thread_pool, search_shard));
+        }
+    }
+
+    for(auto& shard_task: shard_tasks) {
+        shard_task->wait();
+    }
+
+    for(size_t i = 0; i < num_shards; i++) {
+        if(!shard_ops[i].ok()) {
+            return shard_ops[i];
+        }
+    }
+
+    const std::string& raw_query = req_params.count("q") != 0 ? req_params["q"] : "";
+    const bool is_wildcard_query = (raw_query == "*" || raw_query.empty());
+    const bool is_vector_query = req_params.count("vector_query") != 0 && !req_params["vector_query"].empty();
+
+    const auto& sort_keys = shard_merger_t::get_sort_keys(sort_fields, is_wildcard_query, is_vector_query,
+                                                          default_sorting_field);
+
+    nlohmann::json result = shard_merger_t::merge(shard_results, sort_keys, merged_offset, per_page,
+                                                  max_facet_values, group_limit);
+
+    if(result.contains("request_params")) {
+        result["request_params"]["collection_name"] = req_params["collection"];
+        result["request_params"]["per_page"] = per_page;
+    }
+
+    if(shard_results.front().contains("search_time_ms")) {
+        result["search_time_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+    }
+
+    if(page == 0 && offset != 0) {
+        result["offset"] = offset;
+    } else {
+        result["page"] = (page == 0) ? 1 : page;
+    }
+
+    search_result = std::move(result);
+    return Option<bool>(true);
+}
+
 ThreadPool* CollectionManager::get_thread_pool() const {
     return thread_pool;
 }
 
+ThreadPool* CollectionManager::get_indexing_thread_pool() const {
+    return indexing_thread_pool;
+}
+
 Option<nlohmann::json> CollectionManager::get_collection_summaries(uint32_t limit, uint32_t offset) const {
     std::shared_lock lock(mutex);
 
+    if(!evicted_collections.empty()) {
+        // evicted collections are listed with the summary they had when they were evicted, in the order of ids
+        std::vector<std::pair<uint32_t, nlohmann::json>> id_summaries;
+
+        for(const auto& kv: collections) {
+            id_summaries.emplace_back(kv.second->get_collection_id(), kv.second->get_summary_json());
+        }
+
+        for(const auto& kv: evicted_collections) {
+            id_summaries.emplace_back(kv.second.collection_id, kv.second.summary);
+        }
+
+        if(offset > 0 && offset >= id_summaries.size()) {
+            return Option<nlohmann::json>(400, "Invalid offset param.");
+        }
+
+        std::sort(id_summaries.begin(), id_summaries.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first > rhs.first;
+        });
+
+        const size_t end_index = (limit > 0) ? std::min<size_t>(offset + limit, id_summaries.size()) :
+                                 id_summaries.size();
+
+        nlohmann::json json_summaries = nlohmann::json::array();
+        for(size_t i = offset; i < end_index; i++) {
+            json_summaries.push_back(std::move(id_summaries[i].second));
+        }
+
+        return Option<nlohmann::json>(json_summaries);
+    }
+
     auto collections_op = get_collections(limit, offset);
     if(!collections_op.ok()) {
         return Option<nlohmann::json>(collections_op.code(), collections_op.error());
@@ -1962,6 +2648,7 @@ Option<Collection*> CollectionManager::create_collection(nlohmann::json& req_jso
     const char* ENABLE_NESTED_FIELDS = "enable_nested_fields";
     const char* DEFAULT_SORTING_FIELD = "default_sorting_field";
     const char* METADATA = "metadata";
+    const char* STORAGE_FORMAT = Collection::COLLECTION_STORAGE_FORMAT;
 
     // validate presence of mandatory fields
 
@@ -1989,6 +2676,10 @@ Option<Collection*> CollectionManager::create_collection(nlohmann::json& req_jso
         req_json[ENABLE_NESTED_FIELDS] = false;
     }
 
+    if(req_json.count(STORAGE_FORMAT) == 0) {
+        req_json[STORAGE_FORMAT] = Collection::STORAGE_FORMAT_JSON;
+    }
+
     if(req_json.count("fields") == 0) {
         return Option<Collection*>(400, "Parameter `fields` is required.");
     }
@@ -2018,6 +2709,10 @@ Option<Collection*> CollectionManager::create_collection(nlohmann::json& req_jso
         return Option<Collection*>(400, std::string("`") + ENABLE_NESTED_FIELDS + "` should be a boolean.");
     }
 
+    if(!req_json[STORAGE_FORMAT].is_string()) {
+        return Option<Collection*>(400, std::string("`") + STORAGE_FORMAT + "` should be a string.");
+    }
+
     for (auto it = req_json[SYMBOLS_TO_INDEX].begin(); it != req_json[SYMBOLS_TO_INDEX].end(); ++it) {
         if(!it->is_string() || it->get<std::string>().size() != 1 ) {
             return Option<Collection*>(400, std::string("`") + SYMBOLS_TO_INDEX + "` should be an array of character symbols.");
@@ -2100,16 +2795,55 @@ Option<Collection*> CollectionManager::create_collection(nlohmann::json& req_jso
                                                                 req_json[SYMBOLS_TO_INDEX],
                                                                 req_json[TOKEN_SEPARATORS],
                                                                 req_json[ENABLE_NESTED_FIELDS],
-                                                                model, req_json[METADATA]);
+                                                                model, req_json[METADATA],
+                                                                req_json[STORAGE_FORMAT].get<std::string>());
+}
+
+CollectionManager::parsed_batch_t CollectionManager::parse_stored_docs(
+                                                const std::vector<std::pair<uint32_t, std::string>>& raw_docs,
+                                                const bool enable_nested_fields,
+                                                const tsl::htrie_map<char, field>& nested_fields,
+                                                std::atomic<uint64_t>& parse_time_us) {
+    auto parse_begin = std::chrono::high_resolution_clock::now();
+    parsed_batch_t parsed_batch;
+    parsed_batch.index_records.reserve(raw_docs.size());
+
+    for(const auto& raw_doc: raw_docs) {
+        nlohmann::json document;
+
+        try {
+            document = Collection::parse_stored_document(raw_doc.second);
+        } catch(const std::exception& e) {
+            LOG(ERROR) << "JSON error: " << e.what();
+            parsed_batch.status = Option<bool>(400, "Bad JSON.");
+            break;
+        }
+
+        if(enable_nested_fields) {
+            std::vector<field> flattened_fields;
+            field::flatten_doc(document, nested_fields, {}, true, flattened_fields);
+        }
+
+        auto dirty_values = DIRTY_VALUES::COERCE_OR_DROP;
+        parsed_batch.index_records.emplace_back(index_record(0, raw_doc.first, document, CREATE, dirty_values));
+    }
+
+    parse_time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - parse_begin).count();
+
+    return parsed_batch;
 }
 
 Option<bool> CollectionManager::load_collection(const nlohmann::json &collection_meta,
                                                 const size_t batch_size,
                                                 const StoreStatus& next_coll_id_status,
                                                 const std::atomic<bool>& quit,
-                                                spp::sparse_hash_map<std::string, std::string>& referenced_in) {
+                                                spp::sparse_hash_map<std::string, std::string>& referenced_in,
+                                                const nlohmann::json& index_image_meta,
+                                                const std::string& image_dir) {
 
     auto& cm = CollectionManager::get_instance();
+    const auto load_begin = std::chrono::high_resolution_clock::now();
 
     if(!collection_meta.contains(Collection::COLLECTION_NAME_KEY)) {
         return Option<bool>(500, "No collection name in collection meta: " + collection_meta.dump());
@@ -2186,49 +2920,116 @@ Option<bool> CollectionManager::load_collection(const nlohmann::json &collection
         collection->add_synonym(collection_synonym, false);
     }
 
-    // Fetch records from the store and re-create memory index
+    if(index_image_meta.is_object()) {
+        auto image_op = collection->load_index_image(image_dir.empty() ? cm.index_image_dir : image_dir,
+                                                     index_image_meta);
+        if(image_op.ok()) {
+            LOG(INFO) << "Restored index image of collection " << collection->get_name();
+        } else {
+            // documents will be indexed from scratch
+            LOG(WARNING) << "Ignoring index image of collection " << collection->get_name()
+                         << ": " << image_op.error();
+        }
+    }
+
+    collection->reserve_index_capacity();
+
+    // Fetch records from the store and re-create memory index.
+    // Loading is pipelined: this thread iterates the store, a pool of workers parses the documents and a
+    // dedicated thread indexes the parsed batches in the same order in which they were read from the store.
     const std::string seq_id_prefix = collection->get_seq_id_collection_prefix();
     std::string upper_bound_key = collection->get_seq_id_collection_prefix() + "`";  // cannot inline this
     rocksdb::Slice upper_bound(upper_bound_key);
 
-    rocksdb::Iterator* iter = cm.store->scan(seq_id_prefix, &upper_bound);
+    rocksdb::Iterator* iter = cm.store->scan(seq_id_prefix, &upper_bound, false);
     std::unique_ptr<rocksdb::Iterator> iter_guard(iter);
 
-    std::vector<index_record> index_records;
+    const bool enable_nested_fields = collection->get_enable_nested_fields();
+    const tsl::htrie_map<char, field> nested_fields = collection->get_nested_fields();
+
+    const size_t num_parse_workers = std::max<size_t>(1, std::min<size_t>(4, std::thread::hardware_concurrency()));
+    const size_t max_pending_batches = num_parse_workers * 2;
+    ThreadPool parse_pool(num_parse_workers);
+
+    std::mutex m_pending;
+    std::condition_variable cv_pending;
+    std::deque<std::future<parsed_batch_t>> pending_batches;
+    bool iteration_done = false;
+
+    std::atomic<uint64_t> parse_time_us = 0;
+    uint64_t index_time_us = 0;
+    uint64_t iterate_time_us = 0;
 
     size_t num_found_docs = 0;
-    size_t num_valid_docs = 0;
     size_t num_indexed_docs = 0;
-    size_t batch_doc_str_size = 0;
+    Option<bool> load_status(true);
+    std::atomic<bool> load_failed = false;
 
-    auto begin = std::chrono::high_resolution_clock::now();
+    std::thread indexing_thread([&]() {
+        while(true) {
+            std::future<parsed_batch_t> batch_future;
 
-    while(iter->Valid() && iter->key().starts_with(seq_id_prefix)) {
-        num_found_docs++;
-        const uint32_t seq_id = Collection::get_seq_id_from_key(iter->key().ToString());
+            {
+                std::unique_lock<std::mutex> lock(m_pending);
+                cv_pending.wait(lock, [&]() { return !pending_batches.empty() || iteration_done; });
+                if(pending_batches.empty()) {
+                    break;
+                }
 
-        nlohmann::json document;
-        const std::string& doc_string = iter->value().ToString();
+                batch_future = std::move(pending_batches.front());
+                pending_batches.pop_front();
+            }
 
-        try {
-            document = nlohmann::json::parse(doc_string);
-        } catch(const std::exception& e) {
-            LOG(ERROR) << "JSON error: " << e.what();
-            return Option<bool>(400, "Bad JSON.");
-        }
+            // iterator might be waiting for room in the queue
+            cv_pending.notify_all();
 
-        batch_doc_str_size += doc_string.size();
+            parsed_batch_t parsed_batch = batch_future.get();
 
-        if(collection->get_enable_nested_fields()) {
-            std::vector<field> flattened_fields;
-            field::flatten_doc(document, collection->get_nested_fields(), {}, true, flattened_fields);
+            if(!load_status.ok()) {
+                // drain the remaining batches after an error
+                continue;
+            }
+
+            if(!parsed_batch.status.ok()) {
+                load_status = std::move(parsed_batch.status);
+                load_failed = true;
+                continue;
+            }
+
+            auto index_begin = std::chrono::high_resolution_clock::now();
+
+            auto& index_records = parsed_batch.index_records;
+            size_t num_records = index_records.size();
+            size_t num_indexed = collection->batch_index_in_memory(index_records, 200, 60000, 2, false);
+            collection->add_doc_ids(index_records);
+
+            index_time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::high_resolution_clock::now() - index_begin).count();
+
+            if(num_indexed != num_records) {
+                const Option<std::string> & index_error_op = get_first_index_error(index_records);
+                if(!index_error_op.ok()) {
+                    load_status = Option<bool>(400, index_error_op.get());
+                    load_failed = true;
+                    continue;
+                }
+            }
+
+            num_indexed_docs += num_indexed;
         }
+    });
 
-        auto dirty_values = DIRTY_VALUES::COERCE_OR_DROP;
+    std::vector<std::pair<uint32_t, std::string>> raw_docs;
+    size_t batch_doc_str_size = 0;
 
-        num_valid_docs++;
+    auto begin = std::chrono::high_resolution_clock::now();
+    auto iterate_begin = begin;
 
-        index_records.emplace_back(index_record(0, seq_id, document, CREATE, dirty_values));
+    while(iter->Valid() && iter->key().starts_with(seq_id_prefix)) {
+        num_found_docs++;
+        const uint32_t seq_id = Collection::get_seq_id_from_key(iter->key().ToString());
+        raw_docs.emplace_back(seq_id, iter->value().ToString());
+        batch_doc_str_size += raw_docs.back().second.size();
 
         // Peek and check for last record right here so that we handle batched indexing correctly
         // Without doing this, the "last batch" would have to be indexed outside the loop.
@@ -2239,20 +3040,26 @@ Option<bool> CollectionManager::load_collection(const nlohmann::json &collection
         bool exceeds_batch_mem_threshold = ((batch_doc_str_size * 7) > (250 * 1014 * 1024));
 
         // batch must match atleast the number of shards
-         if(exceeds_batch_mem_threshold || (num_valid_docs % batch_size == 0) || last_record) {
-            size_t num_records = index_records.size();
-            size_t num_indexed = collection->batch_index_in_memory(index_records, 200, 60000, 2, false);
+        if(exceeds_batch_mem_threshold || (raw_docs.size() % batch_size == 0) || last_record) {
             batch_doc_str_size = 0;
 
-            if(num_indexed != num_records) {
-                const Option<std::string> & index_error_op = get_first_index_error(index_records);
-                if(!index_error_op.ok()) {
-                    return Option<bool>(400, index_error_op.get());
-                }
-            }
+            iterate_time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::high_resolution_clock::now() - iterate_begin).count();
 
-            index_records.clear();
-            num_indexed_docs += num_indexed;
+            auto batch_future = parse_pool.enqueue([raw_docs = std::move(raw_docs), enable_nested_fields,
+                                                    &nested_fields, &parse_time_us]() {
+                return parse_stored_docs(raw_docs, enable_nested_fields, nested_fields, parse_time_us);
+            });
+
+            raw_docs = std::vector<std::pair<uint32_t, std::string>>();
+
+            std::unique_lock<std::mutex> lock(m_pending);
+            cv_pending.wait(lock, [&]() { return pending_batches.size() < max_pending_batches; });
+            pending_batches.push_back(std::move(batch_future));
+            lock.unlock();
+            cv_pending.notify_all();
+
+            iterate_begin = std::chrono::high_resolution_clock::now();
         }
 
         if(num_found_docs % ((1 << 14)) == 0) {
@@ -2266,19 +3073,240 @@ Option<bool> CollectionManager::load_collection(const nlohmann::json &collection
             }
         }
 
-        if(quit) {
+        if(quit || load_failed) {
             break;
         }
     }
 
+    {
+        std::unique_lock<std::mutex> lock(m_pending);
+        iteration_done = true;
+    }
+
+    cv_pending.notify_all();
+    indexing_thread.join();
+    parse_pool.shutdown();
+
+    if(!load_status.ok()) {
+        return load_status;
+    }
+
+    LOG(INFO) << "Time spent loading collection " << collection->get_name() << ": iterate: "
+              << (iterate_time_us / 1000) << "ms, parse: " << (parse_time_us / 1000) << "ms (across "
+              << num_parse_workers << " workers), index: " << (index_time_us / 1000) << "ms";
+
+    collection->clear_preloaded_index_state();
+    collection->set_load_time_ms(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - load_begin).count());
     cm.add_to_collections(collection);
 
     LOG(INFO) << "Indexed " << num_indexed_docs << "/" << num_found_docs
               << " documents into collection " << collection->get_name();
 
+    if(collection_meta.count(Collection::COLLECTION_ALTER_BACKFILL) != 0) {
+        // the backfill of an alter that was interrupted starts again from the first document
+        nlohmann::json alter_payload = collection_meta[Collection::COLLECTION_ALTER_BACKFILL]["alter_payload"];
+        uint32_t backfill_rate = collection_meta[Collection::COLLECTION_ALTER_BACKFILL]["rate"].get<uint32_t>();
+
+        auto alter_op = collection->alter_in_background(alter_payload, backfill_rate, nullptr);
+        if(!alter_op.ok()) {
+            LOG(ERROR) << "Could not resume the background alter of collection " << collection->get_name()
+                       << ": " << alter_op.error();
+        }
+    }
+
+    return Option<bool>(true);
+}
+
+Option<bool> CollectionManager::save_index_images(const std::string& image_dir) const {
+    std::shared_lock lock(mutex);
+
+    if(!directory_exists(image_dir) && !create_directory(image_dir)) {
+        return Option<bool>(500, "Unable to create index image directory.");
+    }
+
+    nlohmann::json image_meta;
+    image_meta["version"] = INDEX_IMAGE_VERSION;
+    image_meta["collections"] = nlohmann::json::object();
+
+    for(const auto& kv: collections) {
+        nlohmann::json collection_image_meta;
+        auto image_op = kv.second->save_index_image(image_dir, collection_image_meta);
+        if(!image_op.ok()) {
+            // collection will just be loaded from the store
+            LOG(ERROR) << "Skipping index image of collection " << kv.first << ": " << image_op.error();
+            continue;
+        }
+
+        image_meta["collections"][std::to_string(kv.second->get_collection_id())] = collection_image_meta;
+    }
+
+    std::ofstream image_meta_file(image_dir + "/" + INDEX_IMAGE_META_FILE);
+    image_meta_file << image_meta.dump();
+    image_meta_file.close();
+
+    if(image_meta_file.fail()) {
+        return Option<bool>(500, "Unable to write index image meta.");
+    }
+
     return Option<bool>(true);
 }
 
+void CollectionManager::set_index_image_dir(const std::string& image_dir) {
+    std::unique_lock lock(mutex);
+    index_image_dir = image_dir;
+}
+
+void CollectionManager::set_evicted_image_dir(const std::string& image_dir) {
+    std::unique_lock lock(mutex);
+    evicted_image_dir = image_dir;
+}
+
+void CollectionManager::set_hot_collections(const std::vector<std::string>& collection_names) {
+    std::unique_lock lock(mutex);
+    hot_collections = collection_names;
+}
+
+size_t CollectionManager::evict_idle_collections(uint64_t idle_secs, uint64_t restore_budget_ms) {
+    if(idle_secs == 0 || loading_collections) {
+        return 0;
+    }
+
+    const uint64_t idle_since_s = std::time(nullptr) - idle_secs;
+    std::vector<std::string> idle_collection_names;
+
+    {
+        std::shared_lock lock(mutex);
+        for(const auto& kv: collections) {
+            const int64_t load_time_ms = kv.second->get_load_time_ms();
+            if(kv.second->get_last_accessed_s() <= idle_since_s && load_time_ms >= 0 &&
+               uint64_t(load_time_ms) <= restore_budget_ms) {
+                idle_collection_names.push_back(kv.first);
+            }
+        }
+    }
+
+    size_t num_evicted = 0;
+    for(const auto& collection_name: idle_collection_names) {
+        if(evict_collection(collection_name, idle_since_s)) {
+            num_evicted++;
+        }
+    }
+
+    return num_evicted;
+}
+
+bool CollectionManager::evict_collection(const std::string& collection_name, uint64_t idle_since_s) {
+    std::unique_lock eviction_lock(eviction_mutex);
+    std::unique_lock lock(mutex);
+
+    auto collection_it = collections.find(collection_name);
+    if(collection_it == collections.end()) {
+        return false;
+    }
+
+    Collection* collection = collection_it->second;
+
+    // a collection that is in use or was looked up since it was found to be idle is kept
+    std::unique_lock lifecycle_lock(collection->get_lifecycle_mutex(), std::try_to_lock);
+    if(!lifecycle_lock.owns_lock() || collection->get_last_accessed_s() > idle_since_s ||
+       collection->has_references()) {
+        return false;
+    }
+
+    evicted_collection_t evicted_collection;
+    evicted_collection.collection_id = collection->get_collection_id();
+    evicted_collection.write_generation = collection->get_write_generation();
+    evicted_collection.summary = collection->get_summary_json();
+
+    if(evicted_collection.summary.contains(Collection::COLLECTION_ALTER_BACKFILL)) {
+        return false;
+    }
+
+    collections.erase(collection_it);
+    evicted_collections[collection_name] = std::move(evicted_collection);
+    const std::string image_dir = evicted_image_dir;
+    lock.unlock();
+
+    // nothing can look the collection up anymore, so its lifecycle lock is held only to keep it from being restored
+    // before the image is saved
+    if(!image_dir.empty()) {
+        nlohmann::json image_meta;
+        auto image_op = collection->save_index_image(image_dir, image_meta);
+
+        if(image_op.ok()) {
+            lock.lock();
+            evicted_collections[collection_name].index_image_meta = std::move(image_meta);
+            lock.unlock();
+        } else {
+            LOG(WARNING) << "Unable to save the index image of evicted collection " << collection_name << ": "
+                         << image_op.error();
+        }
+    }
+
+    lifecycle_lock.unlock();
+
+    LOG(INFO) << "Evicted idle collection " << collection_name << " from memory.";
+
+    dropped_collection_t dropped_collection;
+    dropped_collection.collection = collection;
+    schedule_drop(std::move(dropped_collection));
+
+    return true;
+}
+
+bool CollectionManager::restore_evicted_collection(const std::string& collection_name) {
+    std::unique_lock eviction_lock(eviction_mutex);
+
+    std::string actual_coll_name;
+    nlohmann::json index_image_meta;
+    std::string image_dir;
+
+    {
+        std::shared_lock lock(mutex);
+        auto evicted_collection = get_evicted_collection_unsafe(collection_name);
+        if(evicted_collection == nullptr) {
+            // e.g. restored by another lookup in the meantime
+            return false;
+        }
+
+        actual_coll_name = evicted_collection->first;
+        index_image_meta = evicted_collection->second.index_image_meta;
+        image_dir = evicted_image_dir;
+    }
+
+    std::string collection_meta_json;
+    if(store->get(Collection::get_meta_key(actual_coll_name), collection_meta_json) != StoreStatus::FOUND) {
+        LOG(ERROR) << "Unable to find the meta of evicted collection " << actual_coll_name;
+        return false;
+    }
+
+    nlohmann::json collection_meta = nlohmann::json::parse(collection_meta_json, nullptr, false);
+    if(collection_meta.is_discarded()) {
+        LOG(ERROR) << "Error while parsing the meta of evicted collection " << actual_coll_name;
+        return false;
+    }
+
+    // collections that take part in references are not evicted
+    spp::sparse_hash_map<std::string, std::string> referenced_in;
+    auto load_op = load_collection(collection_meta, load_document_batch_size, StoreStatus::FOUND, *quit,
+                                   referenced_in, index_image_meta, image_dir);
+
+    if(!load_op.ok()) {
+        LOG(ERROR) << "Unable to restore evicted collection " << actual_coll_name << ": " << load_op.error();
+        return false;
+    }
+
+    std::unique_lock lock(mutex);
+    evicted_collections.erase(actual_coll_name);
+
+    Collection* collection = get_collection_unsafe(actual_coll_name);
+    LOG(INFO) << "Restored evicted collection " << actual_coll_name << " in "
+              << (collection != nullptr ? collection->get_load_time_ms() : 0) << " ms.";
+
+    return true;
+}
+
 spp::sparse_hash_map<std::string, nlohmann::json> CollectionManager::get_presets() const {
     std::shared_lock lock(mutex);
     return preset_configs;
@@ -2325,6 +3353,10 @@ Option<bool> CollectionManager::delete_preset(const string& preset_name) {
 }
 
 Option<Collection*> CollectionManager::clone_collection(const string& existing_name, const nlohmann::json& req_json) {
+    if(is_collection_evicted(existing_name)) {
+        restore_evicted_collection(existing_name);
+    }
+
     std::shared_lock lock(mutex);
 
     if(collections.count(existing_name) == 0) {
@@ -2337,7 +3369,14 @@ Option<Collection*> CollectionManager::clone_collection(const string& existing_n
 
     const std::string& new_name = req_json["name"].get<std::string>();
 
-    if(collections.count(new_name) != 0) {
+    const char* COPY_DOCUMENTS = "copy_documents";
+    if(req_json.count(COPY_DOCUMENTS) != 0 && !req_json[COPY_DOCUMENTS].is_boolean()) {
+        return Option<Collection*>(400, "The `copy_documents` value must be a boolean.");
+    }
+
+    const bool copy_documents = req_json.value(COPY_DOCUMENTS, false);
+
+    if(collections.count(new_name) != 0 || evicted_collections.count(new_name) != 0) {
         return Option<Collection*>(400, "Collection with name `" + new_name + "` already exists.");
     }
 
@@ -2359,7 +3398,8 @@ Option<Collection*> CollectionManager::clone_collection(const string& existing_n
     auto coll_create_op = create_collection(new_name, DEFAULT_NUM_MEMORY_SHARDS, existing_coll->get_fields(),
                               existing_coll->get_default_sorting_field(), static_cast<uint64_t>(std::time(nullptr)),
                               existing_coll->get_fallback_field_type(), symbols_to_index, token_separators,
-                              existing_coll->get_enable_nested_fields(), existing_coll->get_vq_model());
+                              existing_coll->get_enable_nested_fields(), existing_coll->get_vq_model(),
+                              nlohmann::json{}, existing_coll->get_storage_format());
 
     lock.lock();
 
@@ -2381,6 +3421,18 @@ Option<Collection*> CollectionManager::clone_collection(const string& existing_n
         new_coll->add_override(*kv.second);
     }
 
+    if(copy_documents) {
+        // the source can't be dropped while its documents are copied, as the lock is held
+        auto copy_op = new_coll->copy_documents(existing_coll, CLONE_BATCH_SIZE);
+        if(!copy_op.ok()) {
+            lock.unlock();
+            drop_collection(new_name, true);
+            return Option<Collection*>(copy_op.code(), copy_op.error());
+        }
+
+        LOG(INFO) << "Copied " << copy_op.get() << " documents from " << existing_name << " to " << new_name;
+    }
+
     return Option<Collection*>(new_coll);
 }
 
@@ -21,6 +21,7 @@ Option<std::string> ConversationManager::create_conversation(const nlohmann::jso
     }
 
     conversations[conversation_id] = conversation_store_json;
+    conversation_message_bytes[conversation_id] = get_message_bytes(conversation);
 
     return Option<std::string>(conversation_id);
 }
@@ -46,13 +47,19 @@ Option<bool> ConversationManager::append_conversation(const std::string& convers
         return Option<bool>(400, "Message is not an object or array");
     }
 
-    nlohmann::json conversation = conversation_it->second;
+    // messages are appended in place, and are taken out again if the conversation can't be stored
+    nlohmann::json& conversation = conversation_it->second;
+    std::vector<size_t>& message_bytes = conversation_message_bytes[conversation_id];
+    const size_t prev_num_messages = conversation["conversation"].size();
+    const auto prev_last_updated = conversation["last_updated"];
 
     if(!message.is_array()) {
         conversation["conversation"].push_back(message);
+        message_bytes.push_back(message.dump(0).size());
     } else {
         for(auto& m : message) {
             conversation["conversation"].push_back(m);
+            message_bytes.push_back(m.dump(0).size());
         }
     }
 
@@ -61,15 +68,51 @@ Option<bool> ConversationManager::append_conversation(const std::string& convers
     auto conversation_key = get_conversation_key(conversation_id);
     bool insert_op = store->insert(conversation_key, conversation.dump(0));
     if(!insert_op) {
+        auto& messages = conversation["conversation"];
+        messages.erase(messages.begin() + prev_num_messages, messages.end());
+        message_bytes.resize(prev_num_messages);
+        conversation["last_updated"] = prev_last_updated;
         return Option<bool>(500, "Error while inserting conversation into the store");
     }
 
-    conversations[conversation_id] = conversation;
-
     return Option<bool>(true);
 }
 
 
+std::vector<size_t> ConversationManager::get_message_bytes(const nlohmann::json& messages) {
+    std::vector<size_t> message_bytes;
+    if(!messages.is_array()) {
+        return message_bytes;
+    }
+
+    message_bytes.reserve(messages.size());
+    for(const auto& message: messages) {
+        message_bytes.push_back(message.dump(0).size());
+    }
+
+    return message_bytes;
+}
+
+size_t ConversationManager::get_window_start(const std::vector<size_t>& message_bytes, size_t limit) {
+    // `dump(0)` writes an array of k messages as "[\n", the messages separated by ",\n" and then "\n]", and
+    // an empty array as "[]"
+    size_t window_start = message_bytes.size();
+    size_t window_bytes = 0;
+
+    while(window_start > 0) {
+        const size_t num_messages = message_bytes.size() - window_start + 1;
+        const size_t bytes = window_bytes + message_bytes[window_start - 1];
+        if(bytes + 2 * num_messages + 2 > limit) {
+            break;
+        }
+
+        window_bytes = bytes;
+        window_start--;
+    }
+
+    return window_start;
+}
+
 // pop front elements until the conversation is less than MAX_TOKENS
 Option<nlohmann::json> ConversationManager::truncate_conversation(nlohmann::json conversation, size_t limit) {
     if(!conversation.is_array()) {
@@ -78,18 +121,43 @@ Option<nlohmann::json> ConversationManager::truncate_conversation(nlohmann::json
     if(limit <= 0) {
         return Option<nlohmann::json>(400, "Limit must be positive integer");
     }
-    while(conversation.dump(0).size() > limit) {
-        // pop front element from json array
-        try {
-            conversation.erase(0);
-        } catch (std::exception& e) {
-            return Option<nlohmann::json>(400, "Conversation history is not an array");
-        }
+
+    // every message is serialized once, instead of the whole array for every message that is popped
+    const size_t window_start = get_window_start(get_message_bytes(conversation), limit);
+    if(window_start == conversation.size() && limit < 2) {
+        // not even an empty array fits
+        return Option<nlohmann::json>(400, "Conversation history is not an array");
     }
 
+    conversation.erase(conversation.begin(), conversation.begin() + window_start);
     return Option<nlohmann::json>(conversation);
 }
 
+Option<nlohmann::json> ConversationManager::get_conversation_window(const std::string& conversation_id, size_t limit) {
+    if(limit <= 0) {
+        return Option<nlohmann::json>(400, "Limit must be positive integer");
+    }
+
+    std::unique_lock lock(conversations_mutex);
+    auto conversation_it = conversations.find(conversation_id);
+    if(conversation_it == conversations.end()) {
+        return Option<nlohmann::json>(404, "Conversation not found");
+    }
+
+    const auto& messages = conversation_it->second["conversation"];
+    const size_t window_start = get_window_start(conversation_message_bytes[conversation_id], limit);
+    if(window_start == messages.size() && limit < 2) {
+        return Option<nlohmann::json>(400, "Conversation history is not an array");
+    }
+
+    nlohmann::json window = nlohmann::json::array();
+    for(size_t i = window_start; i < messages.size(); i++) {
+        window.push_back(messages[i]);
+    }
+
+    return Option<nlohmann::json>(window);
+}
+
 Option<nlohmann::json> ConversationManager::delete_conversation(const std::string& conversation_id) {
     std::unique_lock lock(conversations_mutex);
     auto conversation = conversations.find(conversation_id);
@@ -108,6 +176,7 @@ Option<nlohmann::json> ConversationManager::delete_conversation(const std::strin
     }
 
     conversations.erase(conversation);
+    conversation_message_bytes.erase(conversation_id);
     return conversation_res;
 } 
 
@@ -143,6 +212,7 @@ Option<int> ConversationManager::init(Store* store) {
             continue;
         }
         conversations[conversation_json["id"]] = conversation_json;
+        conversation_message_bytes[conversation_json["id"]] = get_message_bytes(conversation_json["conversation"]);
         loaded_conversations++;
     }
 
@@ -166,6 +236,7 @@ void ConversationManager::clear_expired_conversations() {
             if(!delete_op) {
                 LOG(ERROR) << "Error while deleting conversation from the store";
             }
+            conversation_message_bytes.erase(conversation_id);
             it = conversations.erase(it);
             cleared_conversations++;
             continue;   
@@ -177,6 +248,7 @@ void ConversationManager::clear_expired_conversations() {
             if(!delete_op) {
                 LOG(ERROR) << "Error while deleting conversation from the store";
             }
+            conversation_message_bytes.erase(conversation_id);
             it = conversations.erase(it);
             cleared_conversations++;
         } else {
@@ -4,6 +4,8 @@
 #include "embedder_manager.h"
 #include "text_embedder_remote.h"
 #include "conversation_manager.h"
+#include "http_client.h"
+#include "http_proxy.h"
 
 
 const std::string get_model_namespace(const std::string& model_name) {
@@ -40,7 +42,8 @@ Option<bool> ConversationModel::validate_model(const nlohmann::json& model_confi
     return Option<bool>(400, "Model namespace `" + model_namespace + "` is not supported.");
 }
 
-Option<std::string> ConversationModel::get_answer(const std::string& context, const std::string& prompt, const nlohmann::json& model_config) {
+Option<std::string> ConversationModel::get_answer(const std::string& context, const std::string& prompt, const nlohmann::json& model_config,
+                                                  const answer_chunk_cb_t& on_chunk) {
     
 
     const std::string& model_namespace = get_model_namespace(model_config["model_name"].get<std::string>());
@@ -50,11 +53,11 @@ Option<std::string> ConversationModel::get_answer(const std::string& context, co
     }
 
     if(model_namespace == "openai") {
-        return OpenAIConversationModel::get_answer(context, prompt, system_prompt, model_config);
+        return OpenAIConversationModel::get_answer(context, prompt, system_prompt, model_config, on_chunk);
     } else if(model_namespace == "cf") {
-        return CFConversationModel::get_answer(context, prompt, system_prompt, model_config);
+        return CFConversationModel::get_answer(context, prompt, system_prompt, model_config, on_chunk);
     } else if(model_namespace == "vllm") {
-        return vLLMConversationModel::get_answer(context, prompt, system_prompt, model_config);
+        return vLLMConversationModel::get_answer(context, prompt, system_prompt, model_config, on_chunk);
     }
 
     return Option<std::string>(400, "Model namespace " + model_namespace + " is not supported.");
@@ -116,6 +119,88 @@ Option<size_t> ConversationModel::get_minimum_required_bytes(const nlohmann::jso
     return Option<size_t>(400, "Model namespace " + model_namespace + " is not supported.");
 }
 
+bool ConversationModel::parse_stream_events(std::string& buffer, const std::string& chunk,
+                                            const std::function<bool(const std::string&)>& on_data) {
+    buffer += chunk;
+    size_t line_start = 0;
+    size_t line_end;
+
+    while((line_end = buffer.find('\n', line_start)) != std::string::npos) {
+        std::string line = buffer.substr(line_start, line_end - line_start);
+        line_start = line_end + 1;
+
+        if(!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if(line.rfind("data:", 0) != 0) {
+            continue;
+        }
+
+        std::string data = line.substr(line.size() > 5 && line[5] == ' ' ? 6 : 5);
+        if(data == "[DONE]") {
+            continue;
+        }
+
+        if(!on_data(data)) {
+            buffer.erase(0, line_start);
+            return false;
+        }
+    }
+
+    buffer.erase(0, line_start);
+    return true;
+}
+
+long ConversationModel::stream_answer(const std::string& url, const std::string& req_body,
+                                      const std::unordered_map<std::string, std::string>& headers,
+                                      const std::function<std::string(const nlohmann::json&)>& get_event_text,
+                                      const answer_chunk_cb_t& on_chunk, std::string& answer, std::string& res) {
+    std::string buffer;
+    async_stream_response_t stream_res;
+
+    stream_res.on_chunk = [&](const std::string& chunk) {
+        return parse_stream_events(buffer, chunk, [&](const std::string& data) {
+            nlohmann::json event = nlohmann::json::parse(data, nullptr, false);
+            if(event.is_discarded()) {
+                return true;
+            }
+
+            std::string text = get_event_text(event);
+            if(text.empty()) {
+                return true;
+            }
+
+            answer += text;
+            return on_chunk(text);
+        });
+    };
+
+    std::map<std::string, std::string> res_headers;
+    long res_code = HttpClient::post_response_stream(url, req_body, stream_res, res_headers, headers,
+                                                     HttpProxy::default_timeout_ms);
+
+    for(const auto& chunk: stream_res.response_chunks) {
+        res += chunk;
+    }
+
+    return res_code;
+}
+
+// text of an event of a streamed chat completion
+static std::string get_chat_completion_delta(const nlohmann::json& event) {
+    if(!event.contains("choices") || !event["choices"].is_array() || event["choices"].empty()) {
+        return "";
+    }
+
+    const auto& choice = event["choices"][0];
+    if(!choice.contains("delta") || !choice["delta"].contains("content") || !choice["delta"]["content"].is_string()) {
+        return "";
+    }
+
+    return choice["delta"]["content"].get<std::string>();
+}
+
 Option<bool> OpenAIConversationModel::validate_model(const nlohmann::json& model_config) {
     if(model_config.count("api_key") == 0) {
         return Option<bool>(400, "API key is not provided");
@@ -202,7 +287,8 @@ Option<bool> OpenAIConversationModel::validate_model(const nlohmann::json& model
 }
 
 Option<std::string> OpenAIConversationModel::get_answer(const std::string& context, const std::string& prompt, 
-                                              const std::string& system_prompt, const nlohmann::json& model_config) {
+                                              const std::string& system_prompt, const nlohmann::json& model_config,
+                                              const answer_chunk_cb_t& on_chunk) {
     const std::string model_name = EmbedderManager::get_model_name_without_namespace(model_config["model_name"].get<std::string>());
     const std::string api_key = model_config["api_key"].get<std::string>();
 
@@ -227,7 +313,16 @@ Option<std::string> OpenAIConversationModel::get_answer(const std::string& conte
     req_body["messages"].push_back(message);
 
     std::string res;
-    auto res_code = RemoteEmbedder::call_remote_api("POST", OPENAI_CHAT_COMPLETION, req_body.dump(), res, res_headers, headers);
+    std::string streamed_answer;
+    long res_code;
+
+    if(on_chunk) {
+        req_body["stream"] = true;
+        res_code = stream_answer(OPENAI_CHAT_COMPLETION, req_body.dump(), headers, get_chat_completion_delta, on_chunk,
+                                 streamed_answer, res);
+    } else {
+        res_code = RemoteEmbedder::call_remote_api("POST", OPENAI_CHAT_COMPLETION, req_body.dump(), res, res_headers, headers);
+    }
 
     if(res_code == 408) {
         throw Option<std::string>(400, "OpenAI API timeout.");
@@ -246,6 +341,10 @@ Option<std::string> OpenAIConversationModel::get_answer(const std::string& conte
         throw Option<std::string>(400, "OpenAI API error: " + nlohmann::json::parse(res)["error"]["message"].get<std::string>());
     }
 
+    if(on_chunk) {
+        return Option<std::string>(streamed_answer);
+    }
+
     nlohmann::json json_res;
     try {
         json_res = nlohmann::json::parse(res);
@@ -435,7 +534,8 @@ Option<bool> CFConversationModel::validate_model(const nlohmann::json& model_con
     return Option<bool>(true);
 }
 
-Option<std::string> CFConversationModel::get_answer(const std::string& context, const std::string& prompt, const std::string& system_prompt, const nlohmann::json& model_config) {
+Option<std::string> CFConversationModel::get_answer(const std::string& context, const std::string& prompt, const std::string& system_prompt, const nlohmann::json& model_config,
+                                                    const answer_chunk_cb_t& on_chunk) {
     const std::string model_name = EmbedderManager::get_model_name_without_namespace(model_config["model_name"].get<std::string>());
     const std::string api_key = model_config["api_key"].get<std::string>();
     const std::string account_id = model_config["account_id"].get<std::string>();
@@ -463,7 +563,25 @@ Option<std::string> CFConversationModel::get_answer(const std::string& context,
 
     std::string res;
     auto url = get_model_url(model_name, account_id);
-    auto res_code = RemoteEmbedder::call_remote_api("POST_STREAM", url, req_body.dump(), res, res_headers, headers);
+
+    std::string streamed_answer;
+    long res_code;
+
+    if(on_chunk) {
+        res_code = stream_answer(url, req_body.dump(), headers, [](const nlohmann::json& event) {
+            return (event.contains("response") && event["response"].is_string()) ?
+                   event["response"].get<std::string>() : std::string();
+        }, on_chunk, streamed_answer, res);
+
+        if(res_code != 200) {
+            // read below like the chunks returned by the proxy
+            nlohmann::json proxy_res;
+            proxy_res["response"] = nlohmann::json::array({res});
+            res = proxy_res.dump();
+        }
+    } else {
+        res_code = RemoteEmbedder::call_remote_api("POST_STREAM", url, req_body.dump(), res, res_headers, headers);
+    }
 
     if(res_code == 408) {
         return Option<std::string>(400, "Cloudflare API timeout.");
@@ -489,6 +607,10 @@ Option<std::string> CFConversationModel::get_answer(const std::string& context,
         return Option<std::string>(400, "Cloudflare API error: " + json_res["message"].get<std::string>());
     }
 
+    if(on_chunk) {
+        return Option<std::string>(streamed_answer);
+    }
+
     return parse_stream_response(res);
 }
 
@@ -714,7 +836,8 @@ Option<bool> vLLMConversationModel::validate_model(const nlohmann::json& model_c
 }
 
 Option<std::string> vLLMConversationModel::get_answer(const std::string& context, const std::string& prompt, 
-                                              const std::string& system_prompt, const nlohmann::json& model_config) {
+                                              const std::string& system_prompt, const nlohmann::json& model_config,
+                                              const answer_chunk_cb_t& on_chunk) {
     const std::string model_name = EmbedderManager::get_model_name_without_namespace(model_config["model_name"].get<std::string>());
     const std::string vllm_url = model_config["vllm_url"].get<std::string>();
 
@@ -738,7 +861,16 @@ Option<std::string> vLLMConversationModel::get_answer(const std::string& context
     req_body["messages"].push_back(message);
 
     std::string res;
-    auto res_code = RemoteEmbedder::call_remote_api("POST", get_chat_completion_url(vllm_url), req_body.dump(), res, res_headers, headers);
+    std::string streamed_answer;
+    long res_code;
+
+    if(on_chunk) {
+        req_body["stream"] = true;
+        res_code = stream_answer(get_chat_completion_url(vllm_url), req_body.dump(), headers, get_chat_completion_delta,
+                                 on_chunk, streamed_answer, res);
+    } else {
+        res_code = RemoteEmbedder::call_remote_api("POST", get_chat_completion_url(vllm_url), req_body.dump(), res, res_headers, headers);
+    }
 
     if(res_code == 408) {
         throw Option<std::string>(400, "vLLM API timeout.");
@@ -757,6 +889,10 @@ Option<std::string> vLLMConversationModel::get_answer(const std::string& context
         return Option<std::string>(400, "vLLM API error: " + nlohmann::json::parse(res)["message"].get<std::string>());
     }
 
+    if(on_chunk) {
+        return Option<std::string>(streamed_answer);
+    }
+
     nlohmann::json json_res;
     try {
         json_res = nlohmann::json::parse(res);
@@ -9,26 +9,38 @@
 #include "collection.h"
 #include "collection_manager.h"
 #include "system_metrics.h"
+#include "memory_arenas.h"
+#include "cpu_profiler.h"
+#include "slow_search_log.h"
 #include "logger.h"
 #include "core_api_utils.h"
-#include "lru/lru.hpp"
+#include "response_cache.h"
+#include "typo_candidate_cache.h"
+#include "embedding_cache.h"
+#include "image_embedder.h"
+#include "stemmer_manager.h"
 #include "ratelimit_manager.h"
 #include "event_manager.h"
 #include "http_proxy.h"
+#include "http_client.h"
+#include "raft_server.h"
 #include "include/stopwords_manager.h"
 #include "conversation_manager.h"
 #include "conversation_model_manager.h"
 #include "conversation_model.h"
+#include "vq_model_manager.h"
+#include "housekeeper.h"
+#include "request_cost.h"
 
 using namespace std::chrono_literals;
 
-std::shared_mutex mutex;
-LRU::Cache<uint64_t, cached_res_t> res_cache;
+response_cache_t res_cache;
 
 std::atomic<bool> alter_in_progress = false;
 
-void init_api(uint32_t cache_num_entries) {
-    res_cache.capacity(cache_num_entries);
+void init_api(uint32_t cache_num_entries, size_t cache_max_memory_bytes, size_t cache_compress_min_bytes) {
+    res_cache.capacity(cache_num_entries, cache_max_memory_bytes);
+    res_cache.set_compress_min_bytes(cache_compress_min_bytes);
 }
 
 void set_alter_in_progress(bool in_progress) {
@@ -82,13 +94,13 @@ void stream_response(const std::shared_ptr<http_req>& req, const std::shared_ptr
     res->wait();
 
     auto req_res = new async_req_res_t(req, res, true);
-    server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+    server->get_message_dispatcher(req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
 }
 
 void defer_processing(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res, size_t timeout_ms) {
     defer_processing_t* defer = new defer_processing_t(req, res, timeout_ms, server);
     //LOG(INFO) << "core_api req " << req.get() << ", use count: " << req.use_count();
-    server->get_message_dispatcher()->send_message(HttpServer::DEFER_PROCESSING_MESSAGE, defer);
+    server->get_message_dispatcher(req)->send_message(HttpServer::DEFER_PROCESSING_MESSAGE, defer);
 }
 
 // we cannot return errors here because that will end up as auth failure and won't convey
@@ -276,6 +288,33 @@ bool patch_update_collection(const std::shared_ptr<http_req>& req, const std::sh
         return false;
     }
 
+    if(req->params.count("background") != 0 && req->params["background"] == "true") {
+        uint32_t backfill_rate = 0;
+        if(req->params.count("backfill_rate") != 0) {
+            if(!StringUtils::is_uint32_t(req->params["backfill_rate"])) {
+                res->set_400("Parameter `backfill_rate` must be an unsigned integer.");
+                alter_in_progress = false;
+                return false;
+            }
+
+            backfill_rate = std::stoul(req->params["backfill_rate"]);
+        }
+
+        // another alter is held off until the backfill ends
+        auto alter_op = collection->alter_in_background(req_json, backfill_rate, []() {
+            alter_in_progress = false;
+        });
+
+        if(!alter_op.ok()) {
+            res->set(alter_op.code(), alter_op.error());
+            alter_in_progress = false;
+            return false;
+        }
+
+        res->set_200(req_json.dump());
+        return true;
+    }
+
     auto alter_op = collection->alter(req_json);
     if(!alter_op.ok()) {
         res->set(alter_op.code(), alter_op.error());
@@ -314,10 +353,47 @@ bool get_debug(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_
     uint64_t state = server->node_state();
     result["state"] = state;
 
+    const compaction_progress_t& compaction_progress =
+            CollectionManager::get_instance().get_store()->get_compaction_progress();
+    result["db_compaction"]["running"] = compaction_progress.running;
+    result["db_compaction"]["ranges_compacted"] = compaction_progress.ranges_compacted;
+    result["db_compaction"]["ranges_total"] = compaction_progress.ranges_total;
+    result["db_compaction"]["started_at"] = compaction_progress.started_at_s;
+
     res->set_200(result.dump());
     return true;
 }
 
+bool get_debug_cpu_profile(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    uint32_t seconds = 30;
+    uint32_t frequency = 99;
+
+    if(req->params.count("seconds") != 0) {
+        if(!StringUtils::is_uint32_t(req->params["seconds"])) {
+            res->set_400("Parameter `seconds` must be an unsigned integer.");
+            return false;
+        }
+        seconds = std::stoul(req->params["seconds"]);
+    }
+
+    if(req->params.count("frequency") != 0) {
+        if(!StringUtils::is_uint32_t(req->params["frequency"])) {
+            res->set_400("Parameter `frequency` must be an unsigned integer.");
+            return false;
+        }
+        frequency = std::stoul(req->params["frequency"]);
+    }
+
+    auto profile_op = CpuProfiler::get_instance().profile(seconds, frequency);
+    if(!profile_op.ok()) {
+        res->set(profile_op.code(), profile_op.error());
+        return false;
+    }
+
+    res->set_content(200, "text/plain; charset=utf-8", profile_op.get(), true);
+    return true;
+}
+
 bool get_health_with_resource_usage(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     nlohmann::json result;
     bool alive = server->is_alive();
@@ -334,10 +410,10 @@ bool get_health_with_resource_usage(const std::shared_ptr<http_req>& req, const
 
     if(req->params.count("cpu_threshold") != 0 && StringUtils::is_float(req->params["cpu_threshold"])) {
         float cpu_threshold = std::stof(req->params["cpu_threshold"]);
-        SystemMetrics sys_metrics;
-        std::vector<cpu_stat_t> cpu_stats = sys_metrics.get_cpu_stats();
-        if(!cpu_stats.empty() && StringUtils::is_float(cpu_stats[0].active)) {
-            alive = alive && (std::stof(cpu_stats[0].active) < cpu_threshold);
+        // as of the last sample of the system metrics
+        float cpu_active_percentage = SystemMetrics::get_cpu_active_percentage();
+        if(cpu_active_percentage >= 0) {
+            alive = alive && (cpu_active_percentage < cpu_threshold);
         }
     }
 
@@ -367,6 +443,10 @@ bool get_health(const std::shared_ptr<http_req>& req, const std::shared_ptr<http
         result["resource_error"] = std::string(magic_enum::enum_name(resource_check));
     }
 
+    if(CollectionManager::get_instance().is_loading_collections()) {
+        result["collections"] = CollectionManager::get_instance().get_collection_load_states();
+    }
+
     if(alive) {
         res->set_body(200, result.dump());
     } else {
@@ -396,13 +476,42 @@ bool get_metrics_json(const std::shared_ptr<http_req>& req, const std::shared_pt
     CollectionManager & collectionManager = CollectionManager::get_instance();
     const std::string & data_dir_path = collectionManager.get_store()->get_state_dir_path();
 
-    SystemMetrics sys_metrics;
-    sys_metrics.get(data_dir_path, result);
+    SystemMetrics::get_snapshot(data_dir_path, result);
+    MemoryArenas::get_instance().get_metrics(result);
+    res_cache.get_metrics(result);
+    HttpClient::get_metrics(result);
+    typo_candidate_cache_t::get_metrics(result);
+    embedding_cache_t::get_metrics(result);
+    CLIPImageEmbedder::get_metrics(result);
+    Stemmer::get_metrics(result);
+    VQModelManager::get_instance().get_metrics(result);
+    AppMetrics::get_instance().get_latency_percentiles(result);
+    server->get_num_queued_writes(result["write_queues"]);
+
+    result["collection_memory_bytes"] = nlohmann::json::object();
+    for(const auto& collection_name: collectionManager.get_collection_names()) {
+        auto collection = collectionManager.get_collection(collection_name);
+        if(collection != nullptr) {
+            result["collection_memory_bytes"][collection_name] = collection->get_memory_stats_json()["total"];
+        }
+    }
 
     res->set_body(200, result.dump(2));
     return true;
 }
 
+bool get_metrics_prometheus(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    std::string result;
+    AppMetrics::get_instance().get_prometheus_metrics(result);
+
+    nlohmann::json coll_queue_stats;
+    server->get_num_queued_writes(coll_queue_stats);
+    AppMetrics::append_write_queue_metrics(coll_queue_stats, result);
+
+    res->set_content(200, "text/plain; version=0.0.4; charset=utf-8", result, true);
+    return true;
+}
+
 bool get_stats_json(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     nlohmann::json result;
     AppMetrics::get_instance().get("requests_per_second", "latency_ms", result);
@@ -412,12 +521,145 @@ bool get_stats_json(const std::shared_ptr<http_req>& req, const std::shared_ptr<
     return true;
 }
 
+bool get_search_fingerprint_stats(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    size_t limit = 100;
+
+    if(req->params.count("limit") != 0) {
+        if(!StringUtils::is_uint32_t(req->params["limit"])) {
+            res->set_400("Parameter `limit` must be an unsigned integer.");
+            return false;
+        }
+        limit = std::stoul(req->params["limit"]);
+    }
+
+    res->set_body(200, SlowSearchLog::get_instance().get_stats(limit).dump());
+    return true;
+}
+
 bool get_status(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     nlohmann::json status = server->node_status();
     res->set_body(200, status.dump());
     return true;
 }
 
+// Sets the results of a search, encoded as MessagePack when the client accepts it: it is more compact than JSON text
+// and is cheaper to encode, since numbers and strings are written out as they are.
+static bool accepts_msgpack(const std::shared_ptr<http_req>& req) {
+    const auto accept_it = req->params.find(http_req::ACCEPT_HEADER);
+    return accept_it != req->params.end() && accept_it->second.find("application/msgpack") != std::string::npos;
+}
+
+void set_search_results(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res,
+                        const nlohmann::json& results) {
+    if(accepts_msgpack(req)) {
+        std::string body;
+        nlohmann::json::to_msgpack(results, nlohmann::detail::output_adapter<char>(body));
+        res->set_content(200, "application/msgpack", body, true);
+        return;
+    }
+
+    res->set_200(results.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore));
+}
+
+static std::string get_stream_event(const nlohmann::json& data) {
+    return "data: " + data.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore) + "\n\n";
+}
+
+// Sends a server-sent event of a streamed response while the handler carries on. The response must be marked as a
+// `proxied_stream` beforehand, so that the sending of an event does not call the handler again.
+static void send_stream_event(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res,
+                              const nlohmann::json& data) {
+    res->set_content(200, "text/event-stream", get_stream_event(data), false);
+    stream_response(req, res);
+}
+
+// Sets the last event of a streamed response, which goes out when the handler returns.
+static void set_last_stream_event(const std::shared_ptr<http_res>& res, const nlohmann::json& data) {
+    // the event sent before must be out first, since the last one is not waited for
+    res->wait();
+    res->set_content(200, "text/event-stream", get_stream_event(data) + "data: [DONE]\n\n", true);
+}
+
+bool get_replication_log(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    const auto after_index_it = req->params.find("after_index");
+    if(after_index_it == req->params.end() || !StringUtils::is_uint64_t(after_index_it->second)) {
+        res->set_400("Parameter `after_index` must be an unsigned integer.");
+        return false;
+    }
+
+    std::string feed;
+    auto feed_op = server->get_replication_state()->get_learner_log_entries(std::stoll(after_index_it->second),
+                                                                            feed);
+    if(!feed_op.ok()) {
+        res->set(feed_op.code(), feed_op.error());
+        return false;
+    }
+
+    res->set_content(200, "application/octet-stream", feed, true);
+    return true;
+}
+
+bool get_replication_snapshot(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    auto manifest_op = server->get_replication_state()->get_learner_snapshot_manifest();
+    if(!manifest_op.ok()) {
+        res->set(manifest_op.code(), manifest_op.error());
+        return false;
+    }
+
+    res->set_200(manifest_op.get().dump());
+    return true;
+}
+
+bool get_replication_snapshot_file(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    const auto offset_it = req->params.find("offset");
+    if(req->params.count("name") == 0 || req->params.count("path") == 0 || offset_it == req->params.end() ||
+       !StringUtils::is_uint64_t(offset_it->second)) {
+        res->set_400("Parameters `name`, `path` and `offset` are required.");
+        return false;
+    }
+
+    std::string chunk;
+    auto read_op = server->get_replication_state()->read_learner_snapshot_file(req->params["name"],
+                                                                               req->params["path"],
+                                                                               std::stoull(offset_it->second), chunk);
+    if(!read_op.ok()) {
+        res->set(read_op.code(), read_op.error());
+        return false;
+    }
+
+    res->set_content(200, "application/octet-stream", chunk, true);
+    return true;
+}
+
+bool get_replication_changes(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    const auto after_index_it = req->params.find("after_index");
+    if(after_index_it == req->params.end() || !StringUtils::is_uint64_t(after_index_it->second)) {
+        res->set_400("Parameter `after_index` must be an unsigned integer.");
+        return false;
+    }
+
+    uint64_t wait_ms = 0;
+    const auto wait_ms_it = req->params.find("wait_ms");
+    if(wait_ms_it != req->params.end()) {
+        if(!StringUtils::is_uint64_t(wait_ms_it->second)) {
+            res->set_400("Parameter `wait_ms` must be an unsigned integer.");
+            return false;
+        }
+
+        wait_ms = std::stoull(wait_ms_it->second);
+    }
+
+    auto changes_op = server->get_replication_state()->get_changes(std::stoll(after_index_it->second), wait_ms);
+    if(!changes_op.ok()) {
+        res->set(changes_op.code(), changes_op.error());
+        return false;
+    }
+
+    // MessagePack is more compact than JSON text, which matters for the bodies of imports
+    set_search_results(req, res, changes_op.get());
+    return true;
+}
+
 uint64_t hash_request(const std::shared_ptr<http_req>& req) {
     std::stringstream ss;
     ss << req->route_hash << req->body;
@@ -432,7 +674,123 @@ uint64_t hash_request(const std::shared_ptr<http_req>& req) {
     return StringUtils::hash_wy(req_str.c_str(), req_str.size());
 }
 
+std::vector<std::pair<std::string, uint64_t>> get_collection_generations(const std::set<std::string>& collection_names) {
+    std::vector<std::pair<std::string, uint64_t>> collection_generations;
+    CollectionManager& collectionManager = CollectionManager::get_instance();
+
+    for(const auto& collection_name: collection_names) {
+        collection_generations.emplace_back(collection_name,
+                                            collectionManager.get_collection_write_generation(collection_name));
+    }
+
+    return collection_generations;
+}
+
+bool get_cached_response(uint64_t req_hash, const std::shared_ptr<http_req>& req,
+                         const std::shared_ptr<http_res>& res) {
+    cached_res_t cached_value;
+
+    // a compressed response is sent as it is to a client that accepts gzip, so that a hit costs no compression
+    bool found = res_cache.get(req_hash, cached_value, [](const cached_res_t& value) {
+        // we still need to check that TTL has not expired
+        uint64_t seconds_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::high_resolution_clock::now() - value.created_at).count();
+
+        if(seconds_elapsed >= value.ttl) {
+            return false;
+        }
+
+        // a write to any of the collections that the result was computed from invalidates the result
+        // (an alias pointed to another collection or a dropped collection also changes the generation)
+        for(const auto& collection_generation: value.collection_generations) {
+            if(CollectionManager::get_instance().get_collection_write_generation(collection_generation.first) !=
+               collection_generation.second) {
+                return false;
+            }
+        }
+
+        return true;
+    }, req->accepts_gzip);
+
+    if(found) {
+        res->set_content(cached_value.status_code, cached_value.content_type_header, cached_value.body, true);
+        if(cached_value.compressed) {
+            res->content_encoding = "gzip";
+        }
+    }
+
+    return found;
+}
+
+void cache_response(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res, uint64_t req_hash,
+                    const std::vector<std::pair<std::string, uint64_t>>& collection_generations) {
+    auto now = std::chrono::high_resolution_clock::now();
+    const auto cache_ttl_it = req->params.find("cache_ttl");
+    uint32_t cache_ttl = 60;
+    if(cache_ttl_it != req->params.end() && StringUtils::is_int32_t(cache_ttl_it->second)) {
+        cache_ttl = std::stoul(cache_ttl_it->second);
+    }
+
+    cached_res_t cached_res;
+    cached_res.load(res->status_code, res->content_type_header, res->body, now, cache_ttl, req_hash,
+                    collection_generations);
+
+    res_cache.insert(req_hash, cached_res);
+}
+
+// Writes the next batch of hits of a streamed search to the response body. The hits are written out as the elements
+// of the hits array that opens the results, and the rest of the results follow the last batch.
+static void set_search_hits_chunk(const std::shared_ptr<http_res>& res, search_stream_state_t* stream_state) {
+    std::string().swap(res->body);
+
+    if(stream_state->offset == 0) {
+        res->body = "{\"" + stream_state->hits_key + "\":[";
+    }
+
+    const size_t end_offset = std::min(stream_state->offset + search_stream_state_t::BATCH_SIZE, stream_state->hits.size());
+
+    for(size_t i = stream_state->offset; i < end_offset; i++) {
+        if(i != 0) {
+            res->body += ",";
+        }
+
+        res->body += stream_state->hits[i].dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+
+        // a hit is not needed once it has been serialized
+        stream_state->hits[i] = nullptr;
+    }
+
+    stream_state->offset = end_offset;
+
+    if(stream_state->offset == stream_state->hits.size()) {
+        res->body += "]";
+        res->body += stream_state->results_tail;
+        res->final = true;
+    } else {
+        res->final = false;
+    }
+
+    res->status_code = 200;
+}
+
+// Accounts the cost of a search to the API key and the IP of the request, for its usage and cost based throttling
+static void add_search_cost(const std::shared_ptr<http_req>& req, const std::string& collection,
+                            const request_cost_t& cost) {
+    RateLimitManager::getInstance()->add_request_cost({RateLimitedEntityType::api_key, req->api_auth_key},
+                                                      {RateLimitedEntityType::ip, req->client_ip},
+                                                      collection, cost);
+}
+
 bool get_search(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    // NOTE: the hits of a large result page are streamed in batches, in which case this handler is called again
+    // for every subsequent batch
+    if(req->data != nullptr) {
+        auto stream_state = dynamic_cast<search_stream_state_t*>(req->data);
+        set_search_hits_chunk(res, stream_state);
+        stream_response(req, res);
+        return true;
+    }
+
     const auto use_cache_it = req->params.find("use_cache");
     bool use_cache = (use_cache_it != req->params.end()) && (use_cache_it->second == "1" || use_cache_it->second == "true");
     uint64_t req_hash = 0;
@@ -443,66 +801,217 @@ bool get_search(const std::shared_ptr<http_req>& req, const std::shared_ptr<http
 
         //LOG(INFO) << "req_hash = " << req_hash;
 
-        std::unique_lock lock(mutex);
-        auto hit_it = res_cache.find(req_hash);
-        if(hit_it != res_cache.end()) {
-            //LOG(INFO) << "Result found in cache.";
-            const auto& cached_value = hit_it.value();
-
-            // we still need to check that TTL has not expired
-            uint32_t ttl = cached_value.ttl;
-            uint64_t seconds_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::high_resolution_clock::now() - cached_value.created_at).count();
-
-            if(seconds_elapsed < cached_value.ttl) {
-                res->set_content(cached_value.status_code, cached_value.content_type_header, cached_value.body, true);
-                return true;
-            }
-
-            // Result found in cache but ttl has lapsed.
-            res_cache.erase(req_hash);
+        if(get_cached_response(req_hash, req, res)) {
+            stream_response(req, res);
+            return true;
         }
     }
 
     if(req->embedded_params_vec.empty()) {
         res->set_500("Embedded params is empty.");
+        stream_response(req, res);
         return false;
     }
 
-    std::string results_json_str;
-    Option<bool> search_op = CollectionManager::do_search(req->params, req->embedded_params_vec[0],
-                                                          results_json_str, req->conn_ts);
+    // generations are read before searching so that a write racing with the search invalidates the entry
+    std::vector<std::pair<std::string, uint64_t>> collection_generations;
+    if(use_cache) {
+        collection_generations = get_collection_generations({req->params["collection"]});
+    }
+
+    nlohmann::json results;
+    request_cost_t search_cost;
+    Option<bool> search_op = Option<bool>(true);
+
+    {
+        request_cost_scope_t cost_scope(&search_cost);
+        search_op = CollectionManager::do_search(req->params, req->embedded_params_vec[0], results, req->conn_ts);
+    }
+
+    add_search_cost(req, req->params["collection"], search_cost);
 
     if(!search_op.ok()) {
         res->set(search_op.code(), search_op.error());
         if(search_op.code() == 408) {
             req->overloaded = true;
         }
+        stream_response(req, res);
         return false;
     }
 
-    res->set_200(results_json_str);
+    const std::string hits_key = results.contains("grouped_hits") ? "grouped_hits" : "hits";
+
+    // a cached response needs the whole body, so only uncached JSON results are streamed
+    if(!use_cache && !accepts_msgpack(req) && results.contains(hits_key) &&
+       results[hits_key].size() > search_stream_state_t::BATCH_SIZE) {
+        auto stream_state = new search_stream_state_t();
+
+        // destruction of data is managed by req destructor
+        req->data = stream_state;
+
+        stream_state->hits_key = hits_key;
+        stream_state->hits = std::move(results[hits_key]);
+        results.erase(hits_key);
+
+        const std::string& results_str = results.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+        stream_state->results_tail = (results_str == "{}") ? "}" : "," + results_str.substr(1);
+
+        set_search_hits_chunk(res, stream_state);
+        stream_response(req, res);
+        return true;
+    }
+
+    set_search_results(req, res, results);
 
     // we will cache only successful requests
     if(use_cache) {
         //LOG(INFO) << "Adding to cache, key = " << req_hash;
-        auto now = std::chrono::high_resolution_clock::now();
-        const auto cache_ttl_it = req->params.find("cache_ttl");
-        uint32_t cache_ttl = 60;
-        if(cache_ttl_it != req->params.end() && StringUtils::is_int32_t(cache_ttl_it->second)) {
-            cache_ttl = std::stoul(cache_ttl_it->second);
+        cache_response(req, res, req_hash, collection_generations);
+    }
+
+    stream_response(req, res);
+    return true;
+}
+
+// Splits a `facet_by` value into its facet expressions, on the commas that are not within parentheses or brackets.
+static void split_facet_exprs(const std::string& facet_by, std::vector<std::string>& facet_exprs) {
+    int depth = 0;
+    std::string facet_expr;
+
+    for(const char c: facet_by) {
+        if(c == '(' || c == '[') {
+            depth++;
+        } else if(c == ')' || c == ']') {
+            depth--;
+        } else if(c == ',' && depth == 0) {
+            if(!StringUtils::trim(facet_expr).empty()) {
+                facet_exprs.push_back(facet_expr);
+            }
+
+            facet_expr.clear();
+            continue;
         }
 
-        cached_res_t cached_res;
-        cached_res.load(res->status_code, res->content_type_header, res->body, now, cache_ttl, req_hash);
+        facet_expr += c;
+    }
+
+    if(!StringUtils::trim(facet_expr).empty()) {
+        facet_exprs.push_back(facet_expr);
+    }
+}
+
+// Searches of a multi search request that differ only in their facet fields and page size are run as one search,
+// with the facet fields of all of them and the largest page size. Their results are then cut down to their own.
+struct shared_search_t {
+    std::vector<size_t> search_indices;
+    std::map<std::string, std::string> params;
 
-        std::unique_lock lock(mutex);
-        res_cache.insert(req_hash, cached_res);
+    // facet field name => facet expression, in the order they were first seen
+    std::vector<std::pair<std::string, std::string>> facet_exprs;
+    size_t per_page = 0;
+
+    nlohmann::json results;
+    Option<bool> search_op = Option<bool>(true);
+};
+
+// Adds the facet expressions to the shared search, unless a field is faceted differently than it already is there.
+static bool add_shared_facet_exprs(shared_search_t& shared_search, const std::vector<std::string>& facet_exprs) {
+    std::vector<std::pair<std::string, std::string>> new_facet_exprs;
+
+    for(const auto& facet_expr: facet_exprs) {
+        std::string field_name = facet_expr.substr(0, facet_expr.find('('));
+        StringUtils::trim(field_name);
+
+        auto existing_it = std::find_if(shared_search.facet_exprs.begin(), shared_search.facet_exprs.end(),
+                                        [&field_name](const auto& kv) { return kv.first == field_name; });
+
+        if(existing_it == shared_search.facet_exprs.end()) {
+            new_facet_exprs.emplace_back(field_name, facet_expr);
+        } else if(existing_it->second != facet_expr) {
+            return false;
+        }
     }
 
+    shared_search.facet_exprs.insert(shared_search.facet_exprs.end(), new_facet_exprs.begin(), new_facet_exprs.end());
     return true;
 }
 
+// Returns the key of the searches that can share their results with this one, or an empty key when the results of the
+// search can't be shared: a page other than the first one can't be derived from a larger first page.
+static std::string get_shared_search_key(const std::map<std::string, std::string>& params,
+                                         const nlohmann::json& embedded_params, size_t& per_page) {
+    const auto page_it = params.find("page");
+    if(params.count("offset") != 0 || params.count("limit") != 0 ||
+       (page_it != params.end() && page_it->second != "1")) {
+        return "";
+    }
+
+    per_page = 10;
+    const auto per_page_it = params.find("per_page");
+    if(per_page_it != params.end()) {
+        if(!StringUtils::is_uint32_t(per_page_it->second)) {
+            return "";
+        }
+
+        per_page = std::stoul(per_page_it->second);
+    }
+
+    nlohmann::json key;
+    key["embedded_params"] = embedded_params;
+    key["params"] = nlohmann::json::object();
+
+    for(const auto& kv: params) {
+        if(kv.first != "facet_by" && kv.first != "per_page" && kv.first != "page") {
+            key["params"][kv.first] = kv.second;
+        }
+    }
+
+    return key.dump();
+}
+
+// Cuts the results of a shared search down to the facet fields and page size of one of its searches.
+static nlohmann::json get_shared_search_results(const nlohmann::json& shared_results,
+                                                const std::map<std::string, std::string>& params,
+                                                const size_t per_page) {
+    nlohmann::json results = shared_results;
+
+    std::set<std::string> facet_fields;
+    const auto facet_by_it = params.find("facet_by");
+    if(facet_by_it != params.end()) {
+        std::vector<std::string> facet_exprs;
+        split_facet_exprs(facet_by_it->second, facet_exprs);
+
+        for(const auto& facet_expr: facet_exprs) {
+            std::string field_name = facet_expr.substr(0, facet_expr.find('('));
+            facet_fields.insert(StringUtils::trim(field_name));
+        }
+    }
+
+    if(results.contains("facet_counts") && results["facet_counts"].is_array()) {
+        nlohmann::json facet_counts = nlohmann::json::array();
+        for(auto& facet_count: results["facet_counts"]) {
+            if(facet_fields.count(facet_count.value("field_name", "")) != 0) {
+                facet_counts.push_back(std::move(facet_count));
+            }
+        }
+
+        results["facet_counts"] = std::move(facet_counts);
+    }
+
+    for(const char* hits_key: {"hits", "grouped_hits"}) {
+        if(results.contains(hits_key) && results[hits_key].is_array() && results[hits_key].size() > per_page) {
+            auto& hits = results[hits_key];
+            hits.erase(hits.begin() + per_page, hits.end());
+        }
+    }
+
+    if(results.contains("request_params") && results["request_params"].is_object()) {
+        results["request_params"]["per_page"] = per_page;
+    }
+
+    return results;
+}
+
 bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     const auto use_cache_it = req->params.find("use_cache");
     bool use_cache = (use_cache_it != req->params.end()) && (use_cache_it->second == "1" || use_cache_it->second == "true");
@@ -514,24 +1023,8 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
 
         //LOG(INFO) << "req_hash = " << req_hash;
 
-        std::unique_lock lock(mutex);
-        auto hit_it = res_cache.find(req_hash);
-        if(hit_it != res_cache.end()) {
-            //LOG(INFO) << "Result found in cache.";
-            const auto& cached_value = hit_it.value();
-
-            // we still need to check that TTL has not expired
-            uint32_t ttl = cached_value.ttl;
-            uint64_t seconds_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::high_resolution_clock::now() - cached_value.created_at).count();
-
-            if(seconds_elapsed < cached_value.ttl) {
-                res->set_content(cached_value.status_code, cached_value.content_type_header, cached_value.body, true);
-                return true;
-            }
-
-            // Result found in cache but ttl has lapsed.
-            res_cache.erase(req_hash);
+        if(get_cached_response(req_hash, req, res)) {
+            return true;
         }
     }
 
@@ -597,6 +1090,21 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
         return false;
     }
 
+    std::vector<std::pair<std::string, uint64_t>> collection_generations;
+    if(use_cache) {
+        std::set<std::string> collection_names;
+        for(const auto& search_params: searches) {
+            if(search_params.is_object() && search_params.count("collection") != 0 &&
+               search_params["collection"].is_string()) {
+                collection_names.insert(search_params["collection"].get<std::string>());
+            } else if(orig_req_params.count("collection") != 0) {
+                collection_names.insert(orig_req_params["collection"]);
+            }
+        }
+
+        collection_generations = get_collection_generations(collection_names);
+    }
+
     // Get API key and IP
     if(!req->metadata.empty()) {
         auto api_key_ip_op = get_api_key_and_ip(req->metadata);
@@ -618,6 +1126,7 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
 
     bool conversation = orig_req_params["conversation"] == "true";
     bool conversation_history = orig_req_params.find("conversation_id") != orig_req_params.end();
+    bool conversation_stream = orig_req_params["conversation_stream"] == "true";
     std::string common_query;
 
     if(!conversation && conversation_history) {
@@ -625,6 +1134,18 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
         return false;
     }
 
+    if(!conversation && conversation_stream) {
+        res->set_400("`conversation_stream` can only be used if `conversation` is enabled.");
+        return false;
+    }
+
+    nlohmann::json conversation_model;
+    nlohmann::json conversation_history_json;
+    Option<std::string> standalone_question_op("");
+
+    // declared after the state that it writes to, so that it is waited for before that state goes out of scope
+    std::unique_ptr<pool_task_t> standalone_question_task;
+
     if(conversation) {
         if(orig_req_params.find("q") == orig_req_params.end()) {
             res->set_400("`q` parameter has to be common for all searches if conversation is enabled. Please set `q` as a query parameter in the request, instead of inside the POST body");
@@ -637,42 +1158,51 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
         }
 
         const std::string& conversation_model_id = orig_req_params["conversation_model_id"];
-        auto conversation_model = ConversationModelManager::get_model(conversation_model_id);
+        auto conversation_model_op = ConversationModelManager::get_model(conversation_model_id);
 
-        if(!conversation_model.ok()) {
+        if(!conversation_model_op.ok()) {
             res->set_400("`conversation_model_id` is invalid.");
             return false;
         }
 
+        conversation_model = conversation_model_op.get();
+
         if(conversation_history) {
             std::string conversation_id = orig_req_params["conversation_id"];
 
-            auto conversation_history = ConversationManager::get_instance().get_conversation(conversation_id);
+            // only the messages that can make it into the prompt of the model are read
+            auto get_conversation_op = ConversationManager::get_instance().get_conversation_window(
+                                            conversation_id, conversation_model["max_bytes"].get<size_t>());
 
-            if(!conversation_history.ok()) {
+            if(!get_conversation_op.ok()) {
                 res->set_400("`conversation_id` is invalid.");
                 return false;
             }
+
+            conversation_history_json["conversation"] = get_conversation_op.get();
         }
 
         common_query = orig_req_params["q"];
 
         if(conversation_history) {
-            const std::string& conversation_model_id = orig_req_params["conversation_model_id"];
-            auto conversation_id = orig_req_params["conversation_id"];
-            auto conversation_model = ConversationModelManager::get_model(conversation_model_id).get();
-            auto conversation_history = ConversationManager::get_instance().get_conversation(conversation_id).get();
-            auto generate_standalone_q = ConversationModel::get_standalone_question(conversation_history, common_query, conversation_model);
-
-            if(!generate_standalone_q.ok()) {
-                res->set_400(generate_standalone_q.error());
-                return false;
+            // the question is rewritten by the model while the parameters of the searches are put together
+            auto generate_standalone_q = [&]() {
+                standalone_question_op = ConversationModel::get_standalone_question(conversation_history_json,
+                                                                                    common_query, conversation_model);
+            };
+
+            ThreadPool* thread_pool = CollectionManager::get_instance().get_thread_pool();
+            if(thread_pool != nullptr) {
+                standalone_question_task.reset(new pool_task_t(thread_pool, generate_standalone_q));
+            } else {
+                generate_standalone_q();
             }
-
-            orig_req_params["q"] = generate_standalone_q.get();
         }
     }
 
+    // the parameters of every search are put together up front, so that the searches can run in parallel
+    std::vector<std::map<std::string, std::string>> search_req_params(searches.size());
+
     for(size_t i = 0; i < searches.size(); i++) {
         auto& search_params = searches[i];
 
@@ -712,36 +1242,167 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
                 return false;
             }
 
+            if(search_item.key() == "conversation_stream") {
+                res->set_400("`conversation_stream` cannot be used in POST body. Please set `conversation_stream` as a query parameter in the request, instead of inside the POST body");
+                return false;
+            }
+
             // overwrite = false since req params will contain embedded params and so has higher priority
             bool populated = AuthManager::add_item_to_params(req->params, search_item, false);
             if(!populated) {
                 res->set_400("One or more search parameters are malformed.");
                 return false;
             }
-        }
+        }
+
+        if(req->params.count("conversation") != 0) {
+            req->params.erase("conversation");
+        }
+
+        if(req->params.count("conversation_id") != 0) {
+            req->params.erase("conversation_id");
+        }
+
+        if(req->params.count("conversation_model_id") != 0) {
+            req->params.erase("conversation_model_id");
+        }
+
+        if(req->params.count("conversation_stream") != 0) {
+            req->params.erase("conversation_stream");
+        }
+
+        search_req_params[i] = req->params;
+    }
+
+    if(standalone_question_task != nullptr) {
+        standalone_question_task->wait();
+    }
+
+    if(conversation_history) {
+        if(!standalone_question_op.ok()) {
+            res->set_400(standalone_question_op.error());
+            return false;
+        }
+
+        orig_req_params["q"] = standalone_question_op.get();
+        for(auto& params: search_req_params) {
+            params["q"] = standalone_question_op.get();
+        }
+    }
+
+    std::vector<shared_search_t> shared_searches;
+    std::unordered_map<std::string, size_t> shared_search_indices;
+    std::vector<size_t> search_per_pages(searches.size(), 0);
+
+    for(size_t i = 0; i < searches.size(); i++) {
+        const auto& params = search_req_params[i];
+        std::string key = get_shared_search_key(params, req->embedded_params_vec[i], search_per_pages[i]);
+
+        std::vector<std::string> facet_exprs;
+        const auto facet_by_it = params.find("facet_by");
+        if(facet_by_it != params.end()) {
+            split_facet_exprs(facet_by_it->second, facet_exprs);
+        }
+
+        auto shared_it = key.empty() ? shared_search_indices.end() : shared_search_indices.find(key);
+        if(shared_it != shared_search_indices.end()) {
+            auto& shared_search = shared_searches[shared_it->second];
+            if(add_shared_facet_exprs(shared_search, facet_exprs)) {
+                shared_search.search_indices.push_back(i);
+                shared_search.per_page = std::max(shared_search.per_page, search_per_pages[i]);
+                continue;
+            }
+        }
+
+        if(!key.empty() && shared_it == shared_search_indices.end()) {
+            shared_search_indices.emplace(key, shared_searches.size());
+        }
+
+        shared_searches.emplace_back();
+        auto& shared_search = shared_searches.back();
+        shared_search.search_indices.push_back(i);
+        shared_search.params = params;
+        shared_search.per_page = search_per_pages[i];
+        add_shared_facet_exprs(shared_search, facet_exprs);
+    }
+
+    for(auto& shared_search: shared_searches) {
+        if(shared_search.search_indices.size() == 1) {
+            continue;
+        }
+
+        std::string facet_by;
+        for(const auto& facet_expr: shared_search.facet_exprs) {
+            facet_by += (facet_by.empty() ? "" : ",") + facet_expr.second;
+        }
+
+        if(facet_by.empty()) {
+            shared_search.params.erase("facet_by");
+        } else {
+            shared_search.params["facet_by"] = facet_by;
+        }
+
+        shared_search.params["per_page"] = std::to_string(shared_search.per_page);
+    }
+
+    // the searches are picked up in order by this thread and by up to `multi_search_concurrency - 1` pool tasks
+    std::atomic<size_t> next_search = 0;
+    auto run_searches = [&]() {
+        size_t i;
+        while((i = next_search++) < shared_searches.size()) {
+            auto& shared_search = shared_searches[i];
+            request_cost_t search_cost;
+
+            {
+                request_cost_scope_t cost_scope(&search_cost);
+                shared_search.search_op = CollectionManager::do_search(shared_search.params,
+                                                                       req->embedded_params_vec[shared_search.search_indices[0]],
+                                                                       shared_search.results, req->conn_ts);
+            }
 
-        if(req->params.count("conversation") != 0) {
-            req->params.erase("conversation");
+            add_search_cost(req, shared_search.params["collection"], search_cost);
         }
+    };
 
-        if(req->params.count("conversation_id") != 0) {
-            req->params.erase("conversation_id");
-        }
+    ThreadPool* thread_pool = CollectionManager::get_instance().get_thread_pool();
+    const size_t concurrency = std::min<size_t>(shared_searches.size(),
+                                                Config::get_instance().get_multi_search_concurrency());
 
-        if(req->params.count("conversation_model_id") != 0) {
-            req->params.erase("conversation_model_id");
+    std::vector<std::unique_ptr<pool_task_t>> search_tasks;
+    for(size_t i = 1; thread_pool != nullptr && i < concurrency; i++) {
+        search_tasks.emplace_back(new pool_task_t(thread_pool, run_searches));
+    }
+
+    run_searches();
+
+    for(auto& search_task: search_tasks) {
+        search_task->wait();
+    }
+
+    std::vector<nlohmann::json> search_results(searches.size());
+    std::vector<Option<bool>> search_ops(searches.size(), Option<bool>(true));
+
+    for(auto& shared_search: shared_searches) {
+        for(const size_t i: shared_search.search_indices) {
+            search_ops[i] = Option<bool>(shared_search.search_op);
+            if(!shared_search.search_op.ok()) {
+                continue;
+            }
+
+            search_results[i] = (shared_search.search_indices.size() == 1) ? std::move(shared_search.results) :
+                                get_shared_search_results(shared_search.results, search_req_params[i],
+                                                          search_per_pages[i]);
         }
+    }
 
-        std::string results_json_str;
-        Option<bool> search_op = CollectionManager::do_search(req->params, req->embedded_params_vec[i],
-                                                              results_json_str, req->conn_ts);
+    for(size_t i = 0; i < searches.size(); i++) {
+        const auto& search_op = search_ops[i];
 
         if(search_op.ok()) {
-            auto results_json = nlohmann::json::parse(results_json_str);
             if(conversation) {
-                results_json["request_params"]["q"] = common_query;
+                search_results[i]["request_params"]["q"] = common_query;
             }
-            response["results"].push_back(results_json);
+            response["results"].push_back(std::move(search_results[i]));
         } else {
             if(search_op.code() == 408) {
                 res->set(search_op.code(), search_op.error());
@@ -804,15 +1465,13 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
             result_docs_arr.push_back(result_docs);
         }
 
-        const std::string& conversation_model_id = orig_req_params["conversation_model_id"];
-        auto conversation_model = ConversationModelManager::get_model(conversation_model_id).get();
         auto min_required_bytes_op = ConversationModel::get_minimum_required_bytes(conversation_model);
         if(!min_required_bytes_op.ok()) {
             res->set_400(min_required_bytes_op.error());
             return false;
         }
         auto min_required_bytes = min_required_bytes_op.get();
-        auto prompt = req->params["q"];
+        auto prompt = orig_req_params["q"];
         if(conversation_model["max_bytes"].get<size_t>() < min_required_bytes + prompt.size()) {
             res->set_400("`max_bytes` of the conversation model is less than the minimum required bytes(" + std::to_string(min_required_bytes) + ").");
             return false;
@@ -839,10 +1498,48 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
             }
         }
 
-        auto answer_op = ConversationModel::get_answer(result_docs.dump(0), prompt, conversation_model);
+        ConversationModel::answer_chunk_cb_t on_answer_chunk;
+
+        if(conversation_stream) {
+            // the results are sent right away and are followed by the answer as the model streams it
+            res->proxied_stream = true;
+            send_stream_event(req, res, response);
+
+            on_answer_chunk = [&req, &res](const std::string& chunk) {
+                if(!res->is_alive) {
+                    return false;
+                }
+
+                nlohmann::json event;
+                event["message"] = chunk;
+                send_stream_event(req, res, event);
+                return true;
+            };
+        }
+
+        // once the response is being streamed, an error can only be sent as its last event
+        auto fail_conversation = [&](const std::string& message) {
+            if(!conversation_stream) {
+                res->set_400(message);
+                return ;
+            }
+
+            nlohmann::json event;
+            event["error"] = message;
+            event["code"] = 400;
+            set_last_stream_event(res, event);
+        };
+
+        Option<std::string> answer_op("");
+        try {
+            answer_op = ConversationModel::get_answer(result_docs.dump(0), prompt, conversation_model, on_answer_chunk);
+        } catch(const Option<std::string>& error_op) {
+            // some of the models throw their errors
+            answer_op = Option<std::string>(error_op);
+        }
 
         if(!answer_op.ok()) {
-            res->set_400(answer_op.error());
+            fail_conversation(answer_op.error());
             return false;
         }
 
@@ -852,13 +1549,13 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
 
         auto formatted_question_op = ConversationModel::format_question(common_query, conversation_model);
         if(!formatted_question_op.ok()) {
-            res->set_400(formatted_question_op.error());
+            fail_conversation(formatted_question_op.error());
             return false;
         }
 
         auto formatted_answer_op = ConversationModel::format_answer(answer_op.get(), conversation_model);
         if(!formatted_answer_op.ok()) {
-            res->set_400(formatted_answer_op.error());
+            fail_conversation(formatted_answer_op.error());
             return false;
         }
 
@@ -872,7 +1569,7 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
             ConversationManager::get_instance().append_conversation(conversation_id, formatted_answer_op.get());
             auto get_conversation_op = ConversationManager::get_instance().get_conversation(conversation_id);
             if(!get_conversation_op.ok()) {
-                res->set_400(get_conversation_op.error());
+                fail_conversation(get_conversation_op.error());
                 return false;
             }
 
@@ -889,13 +1586,13 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
 
             auto create_conversation_op = ConversationManager::get_instance().create_conversation(conversation_history);
             if(!create_conversation_op.ok()) {
-                res->set_400(create_conversation_op.error());
+                fail_conversation(create_conversation_op.error());
                 return false;
             }
 
             auto get_conversation_op = ConversationManager::get_instance().get_conversation(create_conversation_op.get());
             if(!get_conversation_op.ok()) {
-                res->set_400(get_conversation_op.error());
+                fail_conversation(get_conversation_op.error());
                 return false;
             }
             if(!exclude_conversation_history) {
@@ -906,23 +1603,17 @@ bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_p
 
     }
 
-    res->set_200(response.dump());
+    if(conversation_stream) {
+        set_last_stream_event(res, response["conversation"]);
+        return true;
+    }
+
+    set_search_results(req, res, response);
 
     // we will cache only successful requests
     if(use_cache) {
         //LOG(INFO) << "Adding to cache, key = " << req_hash;
-        auto now = std::chrono::high_resolution_clock::now();
-        const auto cache_ttl_it = req->params.find("cache_ttl");
-        uint32_t cache_ttl = 60;
-        if(cache_ttl_it != req->params.end() && StringUtils::is_int32_t(cache_ttl_it->second)) {
-            cache_ttl = std::stoul(cache_ttl_it->second);
-        }
-
-        cached_res_t cached_res;
-        cached_res.load(res->status_code, res->content_type_header, res->body, now, cache_ttl, req_hash);
-
-        std::unique_lock lock(mutex);
-        res_cache.insert(req_hash, cached_res);
+        cache_response(req, res, req_hash, collection_generations);
     }
 
     return true;
@@ -938,6 +1629,7 @@ bool get_collection_summary(const std::shared_ptr<http_req>& req, const std::sha
     }
 
     nlohmann::json json_response = collection->get_summary_json();
+    json_response["memory_bytes"] = collection->get_memory_stats_json();
     res->set_200(json_response.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore));
 
     return true;
@@ -960,6 +1652,8 @@ bool get_export_documents(const std::shared_ptr<http_req>& req, const std::share
     const char* INCLUDE_FIELDS = "include_fields";
     const char* EXCLUDE_FIELDS = "exclude_fields";
     const char* BATCH_SIZE = "batch_size";
+    const char* PARALLELISM = "parallelism";
+    const char* COMPRESS = "compress";
 
     export_state_t* export_state = nullptr;
 
@@ -998,10 +1692,28 @@ bool get_export_documents(const std::shared_ptr<http_req>& req, const std::share
             export_state->export_batch_size = std::stoul(req->params[BATCH_SIZE]);
         }
 
+        if(req->params.count(PARALLELISM) != 0 && StringUtils::is_uint32_t(req->params[PARALLELISM])) {
+            export_state->parallelism = std::max<size_t>(1, std::stoul(req->params[PARALLELISM]));
+        }
+
+        if(req->params.count(COMPRESS) != 0 && (req->params[COMPRESS] == "true" || req->params[COMPRESS] == "1")) {
+            export_state->zs = {};
+            if(deflateInit2(&export_state->zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                            Z_DEFAULT_STRATEGY) != Z_OK) {
+                res->set_500("Error while initializing the compression of the exported documents.");
+                req->last_chunk_aggregate = true;
+                res->final = true;
+                stream_response(req, res);
+                return false;
+            }
+
+            export_state->compress = true;
+        }
+
         if(simple_filter_query.empty()) {
             export_state->iter_upper_bound_key = collection->get_seq_id_collection_prefix() + "`";  // cannot inline this
             export_state->iter_upper_bound = new rocksdb::Slice(export_state->iter_upper_bound_key);
-            export_state->it = collectionManager.get_store()->scan(seq_id_prefix, export_state->iter_upper_bound);
+            export_state->it = collectionManager.get_store()->scan(seq_id_prefix, export_state->iter_upper_bound, false);
         } else {
             filter_result_t filter_result;
             auto filter_ids_op = collection->get_filter_ids(simple_filter_query, filter_result);
@@ -1029,34 +1741,46 @@ bool get_export_documents(const std::shared_ptr<http_req>& req, const std::share
 
     if(export_state->it != nullptr) {
         rocksdb::Iterator* it = export_state->it;
-        size_t batch_counter = 0;
+        auto is_export_key = [&]() {
+            return it->Valid() && it->key().ToString().compare(0, seq_id_prefix.size(), seq_id_prefix) == 0;
+        };
+
+        // the batch is read sequentially, while the documents are parsed and serialized in parallel
+        std::vector<std::string> stored_docs;
+        while(stored_docs.size() < export_state->export_batch_size && is_export_key()) {
+            stored_docs.push_back(it->value().ToString());
+            it->Next();
+        }
+
         std::string().swap(res->body);
 
-        while(it->Valid() && it->key().ToString().compare(0, seq_id_prefix.size(), seq_id_prefix) == 0) {
-            if(export_state->include_fields.empty() && export_state->exclude_fields.empty()) {
-                res->body += it->value().ToString();
+        serialize_export_docs(stored_docs.size(), export_state->parallelism, res->body,
+                              [&](size_t i, std::string& body) {
+            const std::string& stored_doc = stored_docs[i];
+            const bool is_json_doc = stored_doc.empty() || stored_doc[0] != Collection::STORED_DOC_MSGPACK_MARKER;
+
+            if(is_json_doc && export_state->include_fields.empty() && export_state->exclude_fields.empty()) {
+                body.append(stored_doc);
             } else {
-                nlohmann::json doc = nlohmann::json::parse(it->value().ToString());
+                nlohmann::json doc = Collection::parse_stored_document(stored_doc);
                 Collection::prune_doc(doc, export_state->include_fields, export_state->exclude_fields);
-                res->body += doc.dump();
+                body += doc.dump();
             }
 
-            it->Next();
+            body += "\n";
+        });
 
-            // append a new line character if there is going to be one more record to send
-            if(it->Valid() && it->key().ToString().compare(0, seq_id_prefix.size(), seq_id_prefix) == 0) {
-                res->body += "\n";
-                req->last_chunk_aggregate = false;
-                res->final = false;
-            } else {
-                req->last_chunk_aggregate = true;
-                res->final = true;
+        // a new line character separates the records, so the last record of the export is not followed by one
+        if(is_export_key()) {
+            req->last_chunk_aggregate = false;
+            res->final = false;
+        } else {
+            if(!res->body.empty()) {
+                res->body.pop_back();
             }
 
-            batch_counter++;
-            if(batch_counter == export_state->export_batch_size) {
-                break;
-            }
+            req->last_chunk_aggregate = true;
+            res->final = true;
         }
     } else {
         bool done;
@@ -1071,7 +1795,21 @@ bool get_export_documents(const std::shared_ptr<http_req>& req, const std::share
         }
     }
 
-    res->content_type_header = "text/plain; charset=utf-8";
+    if(export_state->compress) {
+        auto compress_op = compress_export_chunk(export_state, res->body, res->final);
+        if(!compress_op.ok()) {
+            res->set(compress_op.code(), compress_op.error());
+            req->last_chunk_aggregate = true;
+            res->final = true;
+            stream_response(req, res);
+            return false;
+        }
+
+        res->content_type_header = "application/gzip";
+    } else {
+        res->content_type_header = "text/plain; charset=utf-8";
+    }
+
     res->status_code = 200;
 
     stream_response(req, res);
@@ -1216,19 +1954,16 @@ bool post_import_documents(const std::shared_ptr<http_req>& req, const std::shar
         req->body = "";
     } else {
         if(!json_lines.empty()) {
-            // check if req->body had complete last record
-            bool complete_document;
-
-            try {
-                nlohmann::json document = nlohmann::json::parse(json_lines.back());
-                complete_document = document.is_object();
-            } catch(const std::exception& e) {
-                complete_document = false;
-            }
+            // check if req->body had complete last record: a validating pass is enough, without building the
+            // document, which is parsed again when it's indexed
+            const std::string& last_line = json_lines.back();
+            const size_t first_char_pos = last_line.find_first_not_of(" \t\r");
+            bool complete_document = first_char_pos != std::string::npos && last_line[first_char_pos] == '{' &&
+                                     nlohmann::json::accept(last_line);
 
             if(!complete_document) {
                 // eject partial record
-                req->body = json_lines.back();
+                req->body = std::move(json_lines.back());
                 json_lines.pop_back();
             } else {
                 req->body = "";
@@ -1241,7 +1976,7 @@ bool post_import_documents(const std::shared_ptr<http_req>& req, const std::shar
 
     // When only one partial record arrives as a chunk, an empty body is pushed to response stream
     bool single_partial_record_body = (json_lines.empty() && !req->body.empty());
-    std::stringstream response_stream;
+    std::string response_body;
 
     //LOG(INFO) << "single_partial_record_body: " << single_partial_record_body;
 
@@ -1258,15 +1993,21 @@ bool post_import_documents(const std::shared_ptr<http_req>& req, const std::shar
         //const std::string& import_summary_json = json_res->dump();
         //response_stream << import_summary_json << "\n";
 
+        size_t response_body_size = json_lines.size();
+        for (const auto& json_line: json_lines) {
+            response_body_size += json_line.size();
+        }
+        response_body.reserve(response_body_size);
+
         for (size_t i = 0; i < json_lines.size(); i++) {
             bool res_start = (res->status_code == 0) && (i == 0);
 
-            if(res_start) {
-                // indicates first import result to be streamed
-                response_stream << json_lines[i];
-            } else {
-                response_stream << "\n" << json_lines[i];
+            if(!res_start) {
+                // no separator before the first import result to be streamed
+                response_body += '\n';
             }
+
+            response_body += json_lines[i];
         }
 
         // Since we use `res->status_code == 0` for flagging `res_start`, we will only set this
@@ -1276,7 +2017,7 @@ bool post_import_documents(const std::shared_ptr<http_req>& req, const std::shar
     }
 
     res->content_type_header = "text/plain; charset=utf-8";
-    res->body = response_stream.str();
+    res->body = std::move(response_body);
 
     res->final.store(req->last_chunk_aggregate);
     stream_response(req, res);
@@ -1284,7 +2025,9 @@ bool post_import_documents(const std::shared_ptr<http_req>& req, const std::shar
     return true;
 }
 
-bool post_add_document(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+static bool parse_add_document_params(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res,
+                                      index_operation_t& operation, size_t& remote_embedding_timeout_ms,
+                                      size_t& remote_embedding_num_tries) {
     const char *ACTION = "action";
     const char *DIRTY_VALUES_PARAM = "dirty_values";
 
@@ -1302,20 +2045,10 @@ bool post_add_document(const std::shared_ptr<http_req>& req, const std::shared_p
         req->params[DIRTY_VALUES_PARAM] = "";  // set it empty as default will depend on whether schema is enabled
     }
 
+    operation = get_index_operation(req->params[ACTION]);
 
-    CollectionManager & collectionManager = CollectionManager::get_instance();
-    auto collection = collectionManager.get_collection(req->params["collection"]);
-
-    if(collection == nullptr) {
-        res->set_404();
-        return false;
-    }
-
-    const index_operation_t operation = get_index_operation(req->params[ACTION]);
-    const auto& dirty_values = collection->parse_dirty_values_option(req->params[DIRTY_VALUES_PARAM]);
-
-    size_t remote_embedding_timeout_ms = 60000;
-    size_t remote_embedding_num_tries = 2;
+    remote_embedding_timeout_ms = 60000;
+    remote_embedding_num_tries = 2;
 
     if(req->params.count("remote_embedding_timeout_ms") != 0) {
         remote_embedding_timeout_ms = std::stoul(req->params["remote_embedding_timeout_ms"]);
@@ -1325,17 +2058,17 @@ bool post_add_document(const std::shared_ptr<http_req>& req, const std::shared_p
         remote_embedding_num_tries = std::stoul(req->params["remote_embedding_num_tries"]);
     }
 
-    nlohmann::json document;
-    std::vector<std::string> json_lines = {req->body};
-    const nlohmann::json& inserted_doc_op = collection->add_many(json_lines, document, operation, "", dirty_values,
-                                                                 false, false, 200, remote_embedding_timeout_ms,
-                                                                 remote_embedding_num_tries);
+    return true;
+}
 
-    if(!inserted_doc_op["success"].get<bool>()) {
+// Sets the response of a single document write from the result line that `add_many` left for it.
+static bool set_add_document_res(bool success, const std::string& result_line, const nlohmann::json& document,
+                                 const std::shared_ptr<http_res>& res) {
+    if(!success) {
         nlohmann::json res_doc;
 
         try {
-            res_doc = nlohmann::json::parse(json_lines[0]);
+            res_doc = nlohmann::json::parse(result_line);
         } catch(const std::exception& e) {
             LOG(ERROR) << "JSON error: " << e.what();
             res->set_400("Bad JSON.");
@@ -1366,6 +2099,82 @@ bool post_add_document(const std::shared_ptr<http_req>& req, const std::shared_p
     return true;
 }
 
+bool post_add_document(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    index_operation_t operation;
+    size_t remote_embedding_timeout_ms, remote_embedding_num_tries;
+
+    if(!parse_add_document_params(req, res, operation, remote_embedding_timeout_ms, remote_embedding_num_tries)) {
+        return false;
+    }
+
+    CollectionManager & collectionManager = CollectionManager::get_instance();
+    auto collection = collectionManager.get_collection(req->params["collection"]);
+
+    if(collection == nullptr) {
+        res->set_404();
+        return false;
+    }
+
+    const auto& dirty_values = collection->parse_dirty_values_option(req->params["dirty_values"]);
+
+    nlohmann::json document;
+    std::vector<std::string> json_lines = {req->body};
+    const nlohmann::json& inserted_doc_op = collection->add_many(json_lines, document, operation, "", dirty_values,
+                                                                 false, false, 200, remote_embedding_timeout_ms,
+                                                                 remote_embedding_num_tries);
+
+    return set_add_document_res(inserted_doc_op["success"].get<bool>(), json_lines[0], document, res);
+}
+
+void add_coalesced_documents(const std::vector<std::shared_ptr<http_req>>& reqs,
+                             const std::vector<std::shared_ptr<http_res>>& res_vec) {
+    index_operation_t operation;
+    size_t remote_embedding_timeout_ms, remote_embedding_num_tries;
+
+    // the requests share the collection and the write parameters, so they pass or fail the checks together
+    const std::shared_ptr<http_req>& first_req = reqs.front();
+    bool params_ok = parse_add_document_params(first_req, res_vec.front(), operation, remote_embedding_timeout_ms,
+                                               remote_embedding_num_tries);
+
+    CollectionManager & collectionManager = CollectionManager::get_instance();
+    auto collection = collectionManager.get_collection(first_req->params["collection"]);
+
+    if(!params_ok || collection == nullptr) {
+        for(const auto& res: res_vec) {
+            if(!params_ok) {
+                res->set_body(res_vec.front()->status_code, res_vec.front()->body);
+            } else {
+                res->set_404();
+            }
+        }
+
+        return ;
+    }
+
+    const auto& dirty_values = collection->parse_dirty_values_option(first_req->params["dirty_values"]);
+
+    std::vector<std::string> json_lines;
+    json_lines.reserve(reqs.size());
+    for(const auto& req: reqs) {
+        json_lines.push_back(req->body);
+    }
+
+    nlohmann::json document;
+    collection->add_many(json_lines, document, operation, "", dirty_values, true, false, 200,
+                         remote_embedding_timeout_ms, remote_embedding_num_tries);
+
+    for(size_t i = 0; i < json_lines.size(); i++) {
+        nlohmann::json result = nlohmann::json::parse(json_lines[i], nullptr, false);
+        const bool success = !result.is_discarded() && result["success"].get<bool>();
+
+        if(success) {
+            Collection::remove_reference_helper_fields(result["document"]);
+        }
+
+        set_add_document_res(success, json_lines[i], success ? result["document"] : document, res_vec[i]);
+    }
+}
+
 bool patch_update_document(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     std::string doc_id = req->params["id"];
 
@@ -1428,6 +2237,29 @@ bool patch_update_documents(const std::shared_ptr<http_req>& req, const std::sha
     return update_op.ok();
 }
 
+bool post_numeric_updates(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    CollectionManager & collectionManager = CollectionManager::get_instance();
+    auto collection = collectionManager.get_collection(req->params["collection"]);
+    if(collection == nullptr) {
+        res->set_404();
+        return false;
+    }
+
+    std::vector<std::string> json_lines;
+    StringUtils::split(req->body, json_lines, "\n", false, false);
+
+    if(json_lines.empty()) {
+        res->set_400("The request body must have at least one update.");
+        return false;
+    }
+
+    collection->update_numeric_fields(json_lines);
+
+    res->content_type_header = "text/plain; charset=utf-8";
+    res->set_200(StringUtils::join(json_lines, "\n"));
+    return true;
+}
+
 bool get_fetch_document(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     std::string doc_id = req->params["id"];
 
@@ -1633,6 +2465,10 @@ bool del_remove_documents(const std::shared_ptr<http_req>& req, const std::share
             nlohmann::json response;
             response["num_deleted"] = deletion_state->num_removed;
 
+            if(deletion_state->num_removed >= MemoryArenas::PURGE_MIN_DELETED_DOCS) {
+                MemoryArenas::get_instance().request_purge();
+            }
+
             req->last_chunk_aggregate = true;
             res->body = response.dump();
             res->final = true;
@@ -1661,6 +2497,13 @@ bool get_aliases(const std::shared_ptr<http_req>& req, const std::shared_ptr<htt
         res_json["aliases"].push_back(symlink);
     }
 
+    for(const auto & sharded_alias: collectionManager.get_sharded_aliases()) {
+        nlohmann::json alias;
+        alias["name"] = sharded_alias.first;
+        alias["collection_names"] = sharded_alias.second;
+        res_json["aliases"].push_back(alias);
+    }
+
     res->set_200(res_json.dump());
     return true;
 }
@@ -1669,15 +2512,20 @@ bool get_alias(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_
     const std::string & alias = req->params["alias"];
     CollectionManager & collectionManager = CollectionManager::get_instance();
     Option<std::string> collection_name_op = collectionManager.resolve_symlink(alias);
-
-    if(!collection_name_op.ok()) {
-        res->set_404();
-        return false;
-    }
-
     nlohmann::json res_json;
     res_json["name"] = alias;
-    res_json["collection_name"] = collection_name_op.get();
+
+    if(collection_name_op.ok()) {
+        res_json["collection_name"] = collection_name_op.get();
+    } else {
+        const std::vector<std::string>& collection_names = collectionManager.get_sharded_alias(alias);
+        if(collection_names.empty()) {
+            res->set_404();
+            return false;
+        }
+
+        res_json["collection_names"] = collection_names;
+    }
 
     res->set_200(res_json.dump());
     return true;
@@ -1698,18 +2546,71 @@ bool put_upsert_alias(const std::shared_ptr<http_req>& req, const std::shared_pt
     const std::string & alias = req->params["alias"];
 
     const char* COLLECTION_NAME = "collection_name";
+    const char* COLLECTION_NAMES = "collection_names";
+
+    if(req_json.count(COLLECTION_NAMES) != 0) {
+        // a sharded alias, searched across all of its collections
+        if(!req_json[COLLECTION_NAMES].is_array()) {
+            res->set_400(std::string("Parameter `") + COLLECTION_NAMES + "` must be an array of strings.");
+            return false;
+        }
+
+        std::vector<std::string> collection_names;
+        for(const auto& collection_name: req_json[COLLECTION_NAMES]) {
+            if(!collection_name.is_string()) {
+                res->set_400(std::string("Parameter `") + COLLECTION_NAMES + "` must be an array of strings.");
+                return false;
+            }
+
+            collection_names.push_back(collection_name.get<std::string>());
+        }
+
+        Option<bool> sharded_op = collectionManager.upsert_sharded_alias(alias, collection_names);
+        if(!sharded_op.ok()) {
+            res->set(sharded_op.code(), sharded_op.error());
+            return false;
+        }
+
+        req_json["name"] = alias;
+        res->set_200(req_json.dump());
+        return true;
+    }
 
     if(req_json.count(COLLECTION_NAME) == 0) {
         res->set_400(std::string("Parameter `") + COLLECTION_NAME + "` is required.");
         return false;
     }
 
+    const char* DROP_PREVIOUS = "drop_previous";
+    if(req_json.count(DROP_PREVIOUS) != 0 && !req_json[DROP_PREVIOUS].is_boolean()) {
+        res->set_400(std::string("Parameter `") + DROP_PREVIOUS + "` must be a boolean.");
+        return false;
+    }
+
+    const bool drop_previous = req_json.value(DROP_PREVIOUS, false);
+
+    if(drop_previous && collectionManager.get_collection(req_json[COLLECTION_NAME].get<std::string>()) == nullptr) {
+        res->set_400("Collection `" + req_json[COLLECTION_NAME].get<std::string>() + "` not found.");
+        return false;
+    }
+
+    const Option<std::string>& previous_name_op = collectionManager.resolve_symlink(alias);
+
     Option<bool> success_op = collectionManager.upsert_symlink(alias, req_json[COLLECTION_NAME]);
     if(!success_op.ok()) {
         res->set_500(success_op.error());
         return false;
     }
 
+    if(drop_previous && previous_name_op.ok() && previous_name_op.get() != req_json[COLLECTION_NAME].get<std::string>()) {
+        // searches on the alias are already served by the new collection, and the old one is freed in the background
+        auto drop_op = collectionManager.drop_collection(previous_name_op.get());
+        if(!drop_op.ok() && drop_op.code() != 404) {
+            LOG(ERROR) << "Could not drop collection " << previous_name_op.get() << " after swapping alias "
+                       << alias << ": " << drop_op.error();
+        }
+    }
+
     req_json["name"] = alias;
     res->set_200(req_json.dump());
     return true;
@@ -1721,8 +2622,23 @@ bool del_alias(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_
 
     Option<std::string> collection_name_op = collectionManager.resolve_symlink(alias);
     if(!collection_name_op.ok()) {
-        res->set_404();
-        return false;
+        const std::vector<std::string>& collection_names = collectionManager.get_sharded_alias(alias);
+        if(collection_names.empty()) {
+            res->set_404();
+            return false;
+        }
+
+        Option<bool> delete_op = collectionManager.delete_sharded_alias(alias);
+        if(!delete_op.ok()) {
+            res->set_500(delete_op.error());
+            return false;
+        }
+
+        nlohmann::json res_json;
+        res_json["name"] = alias;
+        res_json["collection_names"] = collection_names;
+        res->set_200(res_json.dump());
+        return true;
     }
 
     Option<bool> delete_op = collectionManager.delete_symlink(alias);
@@ -2049,10 +2965,7 @@ bool post_config(const std::shared_ptr<http_req>& req, const std::shared_ptr<htt
 }
 
 bool post_clear_cache(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
-    {
-        std::unique_lock lock(mutex);
-        res_cache.clear();
-    }
+    res_cache.clear();
 
     nlohmann::json response;
     response["success"] = true;
@@ -2063,7 +2976,38 @@ bool post_clear_cache(const std::shared_ptr<http_req>& req, const std::shared_pt
 
 bool post_compact_db(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     CollectionManager& collectionManager = CollectionManager::get_instance();
-    rocksdb::Status status = collectionManager.get_store()->compact_all();
+
+    // compaction can be limited to the key ranges of some collections, e.g. those with many deletes
+    std::vector<std::pair<std::string, std::string>> ranges;
+    if(req->params.count("collections") != 0) {
+        std::vector<std::string> collection_names;
+        StringUtils::split(req->params["collections"], collection_names, ",");
+
+        for(const auto& collection_name: collection_names) {
+            auto collection = collectionManager.get_collection(collection_name);
+            if(collection == nullptr) {
+                res->set_404();
+                return false;
+            }
+
+            const std::string& collection_id = std::to_string(collection->get_collection_id());
+            ranges.emplace_back(collection_id + "_", collection_id + "`");
+        }
+    }
+
+    if(req->params.count("async") != 0 && req->params["async"] == "true") {
+        nlohmann::json response;
+        if(!collectionManager.get_store()->compact_ranges_async(ranges)) {
+            res->set_409("A compaction is already running.");
+            return false;
+        }
+
+        response["success"] = true;
+        res->set_200(response.dump());
+        return true;
+    }
+
+    rocksdb::Status status = collectionManager.get_store()->compact_ranges(ranges);
 
     nlohmann::json response;
     response["success"] = status.ok();
@@ -2089,6 +3033,26 @@ bool post_reset_peers(const std::shared_ptr<http_req>& req, const std::shared_pt
     return true;
 }
 
+bool get_housekeeping_tasks(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    nlohmann::json response;
+    response["tasks"] = HouseKeeper::get_instance().get_tasks_json();
+    res->set_200(response.dump());
+    return true;
+}
+
+bool post_cancel_housekeeping_task(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    auto cancel_op = HouseKeeper::get_instance().cancel_task(req->params["name"]);
+    if(!cancel_op.ok()) {
+        res->set(cancel_op.code(), cancel_op.error());
+        return false;
+    }
+
+    nlohmann::json response;
+    response["success"] = true;
+    res->set_200(response.dump());
+    return true;
+}
+
 bool get_synonyms(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     CollectionManager & collectionManager = CollectionManager::get_instance();
     auto collection = collectionManager.get_collection(req->params["collection"]);
@@ -2240,6 +3204,18 @@ bool del_synonym(const std::shared_ptr<http_req>& req, const std::shared_ptr<htt
     return true;
 }
 
+bool is_search_route(uint64_t route_hash) {
+    route_path* rpath;
+    bool found = server->get_route(route_hash, &rpath);
+    return found && (rpath->handler == get_search);
+}
+
+bool is_multi_search_route(uint64_t route_hash) {
+    route_path* rpath;
+    bool found = server->get_route(route_hash, &rpath);
+    return found && (rpath->handler == post_multi_search);
+}
+
 bool is_doc_import_route(uint64_t route_hash) {
     route_path* rpath;
     bool found = server->get_route(route_hash, &rpath);
@@ -2589,6 +3565,12 @@ bool get_limit_exceed_counts(const std::shared_ptr<http_req>& req, const std::sh
     return true;
 }
 
+bool get_limit_usage(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    RateLimitManager* rateLimitManager = RateLimitManager::getInstance();
+    res->set_200(rateLimitManager->get_usage_json().dump());
+    return true;
+}
+
 Option<std::pair<std::string,std::string>> get_api_key_and_ip(const std::string& metadata) {
     // format <length of api_key>:<api_key><ip>
     // length of api_key is a uint32_t
@@ -1,90 +1,115 @@
 #include "core_api_utils.h"
+#include "collection_manager.h"
 
 Option<bool> stateful_remove_docs(deletion_state_t* deletion_state, size_t batch_size, bool& done) {
-    bool removed = true;
     size_t batch_count = 0;
 
-    for(size_t i=0; i<deletion_state->index_ids.size(); i++) {
+    for(size_t i=0; i<deletion_state->index_ids.size() && batch_count < batch_size; i++) {
         std::pair<size_t, uint32_t*>& size_ids = deletion_state->index_ids[i];
         size_t ids_len = size_ids.first;
         uint32_t* ids = size_ids.second;
 
-        size_t start_index = deletion_state->offsets[i];
-        size_t batched_len = std::min(ids_len, (start_index+batch_size));
+        // the documents are removed in chunks, each of which holds the write locks of the collection only once
+        while(deletion_state->offsets[i] < ids_len && batch_count < batch_size) {
+            size_t start_index = deletion_state->offsets[i];
+            size_t chunk_len = std::min({ids_len - start_index, batch_size - batch_count, REMOVE_CHUNK_SIZE});
 
-        for(size_t j=start_index; j<batched_len; j++) {
-            Option<bool> remove_op = deletion_state->collection->remove_if_found(ids[j], true);
+            Option<size_t> remove_op = deletion_state->collection->remove_batch(ids + start_index, chunk_len, true);
 
             if(!remove_op.ok()) {
-                return remove_op;
-            }
-
-            removed = remove_op.get();
-            if(removed) {
-                deletion_state->num_removed++;
+                return Option<bool>(remove_op.code(), remove_op.error());
             }
 
-            deletion_state->offsets[i]++;
-            batch_count++;
-
-            if(batch_count == batch_size) {
-                goto END;
-            }
+            deletion_state->num_removed += remove_op.get();
+            deletion_state->offsets[i] += chunk_len;
+            batch_count += chunk_len;
         }
     }
 
-    END:
-
     done = true;
     for(size_t i=0; i<deletion_state->index_ids.size(); i++) {
         size_t current_offset = deletion_state->offsets[i];
         done = done && (current_offset == deletion_state->index_ids[i].first);
     }
 
-    return Option<bool>(removed);
+    return Option<bool>(true);
 }
 
-Option<bool> stateful_export_docs(export_state_t* export_state, size_t batch_size, bool& done) {
-    size_t batch_count = 0;
+void serialize_export_docs(size_t num_docs, size_t parallelism, std::string& res_body,
+                           const std::function<void(size_t, std::string&)>& serialize_doc) {
+    parallelism = std::max<size_t>(1, std::min(parallelism, num_docs));
+    const size_t partition_size = (num_docs + parallelism - 1) / parallelism;
 
-    export_state->res_body->clear();
+    auto serialize_partition = [&](size_t partition, std::string& body) {
+        const size_t end_index = std::min(num_docs, (partition + 1) * partition_size);
+        for(size_t i = partition * partition_size; i < end_index; i++) {
+            serialize_doc(i, body);
+        }
+    };
+
+    // the first partition is serialized by this thread, directly into the response body
+    std::vector<std::string> partition_bodies(parallelism - 1);
+    std::vector<std::unique_ptr<pool_task_t>> partition_tasks;
+    ThreadPool* thread_pool = CollectionManager::get_instance().get_thread_pool();
+
+    for(size_t partition = 1; partition < parallelism; partition++) {
+        if(thread_pool == nullptr) {
+            serialize_partition(partition, partition_bodies[partition - 1]);
+            continue;
+        }
+
+        partition_tasks.emplace_back(new pool_task_t(thread_pool, [&, partition]() {
+            serialize_partition(partition, partition_bodies[partition - 1]);
+        }));
+    }
+
+    serialize_partition(0, res_body);
+
+    for(auto& partition_task: partition_tasks) {
+        partition_task->wait();
+    }
+
+    for(const auto& partition_body: partition_bodies) {
+        res_body.append(partition_body);
+    }
+}
 
-    for(size_t i = 0; i < export_state->index_ids.size(); i++) {
+Option<bool> stateful_export_docs(export_state_t* export_state, size_t batch_size, bool& done) {
+    std::vector<uint32_t> batch_ids;
+
+    for(size_t i = 0; i < export_state->index_ids.size() && batch_ids.size() < batch_size; i++) {
         std::pair<size_t, uint32_t*>& size_ids = export_state->index_ids[i];
         size_t ids_len = size_ids.first;
         uint32_t* ids = size_ids.second;
 
-        size_t start_index = export_state->offsets[i];
-        size_t batched_len = std::min(ids_len, (start_index+batch_size));
-
-        for(size_t j = start_index; j < batched_len; j++) {
-            auto seq_id = ids[j];
-            nlohmann::json doc;
-            Option<bool> get_op = export_state->collection->get_document_from_store(seq_id, doc);
-
-            if(get_op.ok()) {
-                if(export_state->include_fields.empty() && export_state->exclude_fields.empty()) {
-                    export_state->res_body->append(doc.dump());
-                } else {
-                    Collection::remove_flat_fields(doc);
-                    Collection::remove_reference_helper_fields(doc);
-                    Collection::prune_doc(doc, export_state->include_fields, export_state->exclude_fields);
-                    export_state->res_body->append(doc.dump());
-                }
-
-                export_state->res_body->append("\n");
-            }
-
+        while(export_state->offsets[i] < ids_len && batch_ids.size() < batch_size) {
+            batch_ids.push_back(ids[export_state->offsets[i]]);
             export_state->offsets[i]++;
-            batch_count++;
-
-            if(batch_count == batch_size) {
-                goto END;
-            }
         }
     }
 
-    END:
+    export_state->res_body->clear();
+
+    serialize_export_docs(batch_ids.size(), export_state->parallelism, *export_state->res_body,
+                          [&](size_t i, std::string& body) {
+        nlohmann::json doc;
+        Option<bool> get_op = export_state->collection->get_document_from_store(batch_ids[i], doc);
+
+        if(!get_op.ok()) {
+            return ;
+        }
+
+        if(export_state->include_fields.empty() && export_state->exclude_fields.empty()) {
+            body.append(doc.dump());
+        } else {
+            Collection::remove_flat_fields(doc);
+            Collection::remove_reference_helper_fields(doc);
+            Collection::prune_doc(doc, export_state->include_fields, export_state->exclude_fields);
+            body.append(doc.dump());
+        }
+
+        body.append("\n");
+    });
 
     done = true;
     for(size_t i=0; i<export_state->index_ids.size(); i++) {
@@ -96,5 +121,28 @@ Option<bool> stateful_export_docs(export_state_t* export_state, size_t batch_siz
         export_state->res_body->pop_back();
     }
 
+    return Option<bool>(true);
+}
+
+Option<bool> compress_export_chunk(export_state_t* export_state, std::string& body, bool last_chunk) {
+    z_stream& zs = export_state->zs;
+    zs.next_in = reinterpret_cast<Bytef*>(body.data());
+    zs.avail_in = body.size();
+
+    std::string compressed_body;
+    char out_buffer[16384];
+
+    do {
+        zs.next_out = reinterpret_cast<Bytef*>(out_buffer);
+        zs.avail_out = sizeof(out_buffer);
+
+        if(deflate(&zs, last_chunk ? Z_FINISH : Z_NO_FLUSH) == Z_STREAM_ERROR) {
+            return Option<bool>(500, "Error while compressing the exported documents.");
+        }
+
+        compressed_body.append(out_buffer, sizeof(out_buffer) - zs.avail_out);
+    } while(zs.avail_out == 0);
+
+    body = std::move(compressed_body);
     return Option<bool>(true);
 }
\ No newline at end of file
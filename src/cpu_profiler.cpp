@@ -0,0 +1,181 @@
+#include "cpu_profiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <csignal>
+#include <map>
+#include <thread>
+#include <unordered_map>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <sys/time.h>
+#include "logger.h"
+
+std::atomic<bool> CpuProfiler::sampling = false;
+CpuProfiler::sample_t* CpuProfiler::samples = nullptr;
+size_t CpuProfiler::samples_capacity = 0;
+std::atomic<size_t> CpuProfiler::next_sample = 0;
+
+void CpuProfiler::on_sigprof(int sig) {
+    if(!sampling.load(std::memory_order_acquire)) {
+        return ;
+    }
+
+    const int saved_errno = errno;
+    const size_t sample_index = next_sample.fetch_add(1, std::memory_order_relaxed);
+
+    if(sample_index < samples_capacity) {
+        sample_t& sample = samples[sample_index];
+        sample.num_frames = backtrace(sample.frames, MAX_FRAMES);
+    }
+
+    errno = saved_errno;
+}
+
+std::string CpuProfiler::default_symbolizer(void* addr) {
+    Dl_info info;
+    if(dladdr(addr, &info) == 0 || info.dli_sname == nullptr) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%p", addr);
+        return buffer;
+    }
+
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+    std::string name = (status == 0 && demangled != nullptr) ? demangled : info.dli_sname;
+    free(demangled);
+    return name;
+}
+
+void CpuProfiler::set_symbolizer(const symbolizer_t& symbolizer) {
+    std::unique_lock lk(mutex);
+    this->symbolizer = symbolizer;
+}
+
+Option<std::string> CpuProfiler::profile(uint32_t seconds, uint32_t frequency) {
+    if(seconds == 0 || seconds > MAX_SECONDS) {
+        return Option<std::string>(400, "Parameter `seconds` must be between 1 and " +
+                                        std::to_string(MAX_SECONDS) + ".");
+    }
+
+    if(frequency == 0 || frequency > MAX_FREQUENCY) {
+        return Option<std::string>(400, "Parameter `frequency` must be between 1 and " +
+                                        std::to_string(MAX_FREQUENCY) + ".");
+    }
+
+    std::unique_lock lk(mutex, std::try_to_lock);
+    if(!lk.owns_lock()) {
+        return Option<std::string>(409, "A profile is already running.");
+    }
+
+    // the timer runs on the CPU time of all threads, so busy cores add up
+    const size_t num_cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+    samples_capacity = std::min<size_t>(MAX_SAMPLES, size_t(seconds) * frequency * num_cores);
+    std::vector<sample_t> sample_buffer(samples_capacity);
+    samples = sample_buffer.data();
+    next_sample = 0;
+
+    if(!handler_installed) {
+        // the first call of backtrace() loads the unwinder, which must not happen within the signal handler
+        void* frames[1];
+        backtrace(frames, 1);
+
+        // the handler stays installed after a profile, since a signal of the timer can still be pending then
+        struct sigaction action = {};
+        action.sa_handler = on_sigprof;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+
+        if(sigaction(SIGPROF, &action, nullptr) != 0) {
+            return Option<std::string>(500, "Could not install the profiling signal handler.");
+        }
+
+        handler_installed = true;
+    }
+
+    struct itimerval timer = {};
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = std::max<uint32_t>(1, 1000 * 1000 / frequency);
+    timer.it_value = timer.it_interval;
+
+    sampling.store(true, std::memory_order_release);
+
+    if(setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        sampling = false;
+        return Option<std::string>(500, "Could not start the profiling timer.");
+    }
+
+    LOG(INFO) << "Profiling the CPU for " << seconds << "s at " << frequency << "Hz.";
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    struct itimerval stop_timer = {};
+    setitimer(ITIMER_PROF, &stop_timer, nullptr);
+    sampling.store(false, std::memory_order_release);
+
+    // a handler that saw `sampling` before it was turned off could still be writing its sample
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    const size_t num_samples = std::min(next_sample.load(), samples_capacity);
+    if(next_sample.load() > samples_capacity) {
+        LOG(INFO) << "Dropped " << (next_sample.load() - samples_capacity) << " samples of the profile.";
+    }
+
+    // symbolize each address once: the first 2 frames are those of the signal handler
+    const size_t num_handler_frames = 2;
+    std::unordered_map<void*, std::string> symbols;
+    std::vector<std::vector<std::string>> stacks;
+
+    for(size_t i = 0; i < num_samples; i++) {
+        const sample_t& sample = samples[i];
+        std::vector<std::string> stack;
+
+        for(int f = num_handler_frames; f < sample.num_frames; f++) {
+            void* addr = sample.frames[f];
+            auto symbol_it = symbols.find(addr);
+            if(symbol_it == symbols.end()) {
+                symbol_it = symbols.emplace(addr, symbolizer ? symbolizer(addr) : default_symbolizer(addr)).first;
+            }
+
+            stack.push_back(symbol_it->second);
+        }
+
+        if(!stack.empty()) {
+            stacks.push_back(std::move(stack));
+        }
+    }
+
+    samples = nullptr;
+    samples_capacity = 0;
+
+    return Option<std::string>(fold_stacks(stacks));
+}
+
+std::string CpuProfiler::fold_stacks(const std::vector<std::vector<std::string>>& stacks) {
+    std::map<std::string, size_t> folded_counts;
+
+    for(const auto& stack: stacks) {
+        std::string folded;
+        for(auto frame_it = stack.rbegin(); frame_it != stack.rend(); ++frame_it) {
+            if(!folded.empty()) {
+                folded += ';';
+            }
+
+            // `;` separates the frames
+            std::string frame = *frame_it;
+            std::replace(frame.begin(), frame.end(), ';', ':');
+            folded += frame;
+        }
+
+        folded_counts[folded]++;
+    }
+
+    std::string result;
+    for(const auto& kv: folded_counts) {
+        result += kv.first + " " + std::to_string(kv.second) + "\n";
+    }
+
+    return result;
+}
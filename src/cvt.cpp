@@ -1,75 +1,499 @@
 #include <cvt.h>
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
-#include "logger.h"
+#include "levenshtein_automaton.h"
 
-bool CVTrie::add(const char *key, const uint8_t length, void *value) {
-    // If the key exists, augment the node, otherwise insert a new node
+void* CVTrie::value(const uint8_t* node) {
+    void* node_value;
+    std::memcpy(&node_value, node + HEADER_SIZE + prefix_len(node), sizeof(node_value));
+    return node_value;
+}
 
-    if(root == nullptr) {
-        // Trie is empty, so add a single leaf node:
-        // [0|PTRLEAF][3][f][o][o]
+const uint8_t* CVTrie::chars(const uint8_t* node) {
+    return node + HEADER_SIZE + prefix_len(node) + (has_value(node) ? sizeof(void*) : 0);
+}
 
-        uint8_t* block = new uint8_t[8 + 1 + length];
+uint8_t* CVTrie::child(const uint8_t* node, size_t index) {
+    uint8_t* child_node;
+    std::memcpy(&child_node, chars(node) + num_children(node) + index * sizeof(void*), sizeof(child_node));
+    return child_node;
+}
 
-        void* node = tag_ptr(value, 0, LEAF);
+void CVTrie::set_child(uint8_t* node, size_t index, uint8_t* child_node) {
+    uint8_t* slot = const_cast<uint8_t*>(chars(node)) + num_children(node) + index * sizeof(void*);
+    std::memcpy(slot, &child_node, sizeof(child_node));
+}
 
-        std::memcpy(block, &node, sizeof(void*));
-        std::memcpy(block+sizeof(void*), &length, 1);
-        std::memcpy(block+sizeof(void*)+1, key, length);
+size_t CVTrie::find_child(const uint8_t* node, uint8_t c) {
+    const size_t n = num_children(node);
+    const uint8_t* node_chars = chars(node);
 
-        root = block;
-        return true;
+    for(size_t i = 0; i < n; i++) {
+        if(node_chars[i] == c) {
+            return i;
+        }
+
+        if(node_chars[i] > c) {
+            break;
+        }
     }
 
-    uint8_t node_type = get_node_type(root);
+    return n;
+}
 
-    if(node_type == LEAF) {
-        // Compare new key with child key to identify common prefix
-        // e.g. welcome vs welding (or) we vs welcome (or) welcome vs foobar
+size_t CVTrie::block_size(const uint8_t* node) {
+    return HEADER_SIZE + prefix_len(node) + (has_value(node) ? sizeof(void*) : 0) +
+           num_children(node) * (1 + sizeof(void*));
+}
+
+CVTrie::node_view_t CVTrie::unpack(const uint8_t* node) {
+    node_view_t view;
+    view.has_value = has_value(node);
+    view.value = view.has_value ? value(node) : nullptr;
+    view.prefix.assign((const char*) prefix(node), prefix_len(node));
+
+    const size_t n = num_children(node);
+    view.chars.assign(chars(node), chars(node) + n);
+    for(size_t i = 0; i < n; i++) {
+        view.children.push_back(child(node, i));
     }
 
-    /*size_t num_siblings = 1;
-    size_t key_index = 0;
+    return view;
+}
 
-    while(true) {
-        // for each sibling
-        for(auto sindex = 0; sindex < num_siblings; sindex++) {
-            unsigned char c = key[key_index];
+uint8_t* CVTrie::pack(const node_view_t& view) {
+    const size_t n = view.chars.size();
+    const size_t size = HEADER_SIZE + view.prefix.size() + (view.has_value ? sizeof(void*) : 0) +
+                        n * (1 + sizeof(void*));
+
+    uint8_t* node = (uint8_t*) malloc(size);
+    node[0] = view.has_value ? HAS_VALUE : 0;
+    node[1] = uint8_t(view.prefix.size());
+    const uint16_t num = n;
+    std::memcpy(node + 2, &num, sizeof(num));
 
+    uint8_t* pos = node + HEADER_SIZE;
+    std::memcpy(pos, view.prefix.data(), view.prefix.size());
+    pos += view.prefix.size();
+
+    if(view.has_value) {
+        std::memcpy(pos, &view.value, sizeof(void*));
+        pos += sizeof(void*);
+    }
+
+    std::memcpy(pos, view.chars.data(), n);
+    pos += n;
+
+    std::memcpy(pos, view.children.data(), n * sizeof(void*));
+    return node;
+}
+
+uint8_t* CVTrie::new_chain(const uint8_t* key, size_t length, void* value) {
+    node_view_t view;
+
+    if(length <= MAX_PREFIX_LEN) {
+        view.has_value = true;
+        view.value = value;
+        view.prefix.assign((const char*) key, length);
+    } else {
+        view.prefix.assign((const char*) key, MAX_PREFIX_LEN);
+        view.chars.push_back(key[MAX_PREFIX_LEN]);
+        view.children.push_back(new_chain(key + MAX_PREFIX_LEN + 1, length - MAX_PREFIX_LEN - 1, value));
+    }
+
+    return pack(view);
+}
+
+uint8_t* CVTrie::merge_with_child(uint8_t* node) {
+    if(has_value(node) || num_children(node) != 1) {
+        return node;
+    }
+
+    uint8_t* child_node = child(node, 0);
+    if(prefix_len(node) + 1 + prefix_len(child_node) > MAX_PREFIX_LEN) {
+        return node;
+    }
+
+    node_view_t view = unpack(child_node);
+    view.prefix = std::string((const char*) prefix(node), prefix_len(node)) + char(chars(node)[0]) + view.prefix;
+
+    free(node);
+    free(child_node);
+    return pack(view);
+}
+
+void CVTrie::destroy(uint8_t* node) {
+    if(node == nullptr) {
+        return ;
+    }
+
+    for(size_t i = 0; i < num_children(node); i++) {
+        destroy(child(node, i));
+    }
+
+    free(node);
+}
+
+CVTrie::~CVTrie() {
+    destroy(root);
+}
 
+void CVTrie::replace_in_parent(const std::vector<std::pair<uint8_t*, size_t>>& path, uint8_t* node) {
+    if(path.empty()) {
+        root = node;
+    } else {
+        set_child(path.back().first, path.back().second, node);
+    }
+}
+
+void* CVTrie::find(const char* key, uint32_t length) const {
+    const uint8_t* node = root;
+    const auto* key_bytes = (const uint8_t*) key;
+    size_t pos = 0;
+
+    while(node != nullptr) {
+        const size_t plen = prefix_len(node);
+        if(length - pos < plen || std::memcmp(prefix(node), key_bytes + pos, plen) != 0) {
+            return nullptr;
         }
-    }*/
 
-    return true;
+        pos += plen;
+
+        if(pos == length) {
+            return has_value(node) ? value(node) : nullptr;
+        }
+
+        const size_t child_index = find_child(node, key_bytes[pos]);
+        if(child_index == num_children(node)) {
+            return nullptr;
+        }
+
+        node = child(node, child_index);
+        pos++;
+    }
+
+    return nullptr;
 }
 
-void *CVTrie::find(const char *key, const uint8_t length) {
-    size_t key_index = 0;
-    void* curr = nullptr;
-    std::memcpy(&curr, root, sizeof curr);
+bool CVTrie::add(const char* key, uint32_t length, void* value) {
+    const auto* key_bytes = (const uint8_t*) key;
+
+    if(root == nullptr) {
+        root = new_chain(key_bytes, length, value);
+        num_keys++;
+        return true;
+    }
+
+    // parent and child index of every node on the way down
+    std::vector<std::pair<uint8_t*, size_t>> path;
+    uint8_t* node = root;
+    size_t pos = 0;
 
     while(true) {
-        uint8_t node_type = get_node_type(curr);
-        if(node_type == LEAF) {
-            size_t key_len = *(uint8_t*)(root+sizeof(void*));
+        const size_t plen = prefix_len(node);
+        size_t common = 0;
+        while(common < plen && pos + common < length && prefix(node)[common] == key_bytes[pos + common]) {
+            common++;
+        }
 
-            if(key_index+key_len != length) {
-                return nullptr;
-            }
+        if(common < plen) {
+            // split the path of the node where the key diverges from it, e.g. adding `tea` on `to`
+            node_view_t lower = unpack(node);
+            const uint8_t split_char = lower.prefix[common];
+            lower.prefix = lower.prefix.substr(common + 1);
 
-            for(size_t i=0; i<key_len; i++) {
-                uint8_t this_char = *(uint8_t *) (root + sizeof(void *) + 1 + i);
-                if(key[key_index++] != this_char) {
-                    return nullptr;
+            node_view_t upper;
+            upper.prefix.assign((const char*) prefix(node), common);
+
+            uint8_t* lower_node = pack(lower);
+
+            if(pos + common == length) {
+                upper.has_value = true;
+                upper.value = value;
+                upper.chars.push_back(split_char);
+                upper.children.push_back(lower_node);
+            } else {
+                const uint8_t c = key_bytes[pos + common];
+                uint8_t* new_node = new_chain(key_bytes + pos + common + 1, length - pos - common - 1, value);
+
+                if(c < split_char) {
+                    upper.chars = {c, split_char};
+                    upper.children = {new_node, lower_node};
+                } else {
+                    upper.chars = {split_char, c};
+                    upper.children = {lower_node, new_node};
                 }
             }
 
-            void* leaf = get_ptr(curr);
-            return leaf;
+            free(node);
+            replace_in_parent(path, pack(upper));
+            num_keys++;
+            return true;
+        }
+
+        pos += plen;
+
+        if(pos == length) {
+            if(has_value(node)) {
+                std::memcpy(node + HEADER_SIZE + plen, &value, sizeof(value));
+                return false;
+            }
+
+            node_view_t view = unpack(node);
+            view.has_value = true;
+            view.value = value;
+
+            free(node);
+            replace_in_parent(path, pack(view));
+            num_keys++;
+            return true;
+        }
+
+        const uint8_t c = key_bytes[pos];
+        const size_t child_index = find_child(node, c);
+
+        if(child_index == num_children(node)) {
+            node_view_t view = unpack(node);
+            size_t slot = 0;
+            while(slot < view.chars.size() && view.chars[slot] < c) {
+                slot++;
+            }
+
+            view.chars.insert(view.chars.begin() + slot, c);
+            view.children.insert(view.children.begin() + slot, new_chain(key_bytes + pos + 1, length - pos - 1, value));
+
+            free(node);
+            replace_in_parent(path, pack(view));
+            num_keys++;
+            return true;
         }
 
-        break;
+        path.emplace_back(node, child_index);
+        node = child(node, child_index);
+        pos++;
     }
+}
 
-    return nullptr;
-}
\ No newline at end of file
+void* CVTrie::remove(const char* key, uint32_t length) {
+    const auto* key_bytes = (const uint8_t*) key;
+    std::vector<std::pair<uint8_t*, size_t>> path;
+    uint8_t* node = root;
+    size_t pos = 0;
+
+    while(true) {
+        if(node == nullptr) {
+            return nullptr;
+        }
+
+        const size_t plen = prefix_len(node);
+        if(length - pos < plen || std::memcmp(prefix(node), key_bytes + pos, plen) != 0) {
+            return nullptr;
+        }
+
+        pos += plen;
+
+        if(pos == length) {
+            break;
+        }
+
+        const size_t child_index = find_child(node, key_bytes[pos]);
+        if(child_index == num_children(node)) {
+            return nullptr;
+        }
+
+        path.emplace_back(node, child_index);
+        node = child(node, child_index);
+        pos++;
+    }
+
+    if(!has_value(node)) {
+        return nullptr;
+    }
+
+    void* removed_value = value(node);
+    num_keys--;
+
+    if(num_children(node) != 0) {
+        node_view_t view = unpack(node);
+        view.has_value = false;
+        view.value = nullptr;
+
+        free(node);
+        replace_in_parent(path, merge_with_child(pack(view)));
+        return removed_value;
+    }
+
+    free(node);
+
+    // drop the node from its parent, which may then have to be merged with its remaining child, or be dropped too
+    // when it is left empty: a node without a value has children, unless it is an unmerged link of a long path
+    while(!path.empty()) {
+        uint8_t* parent = path.back().first;
+        const size_t child_index = path.back().second;
+        path.pop_back();
+
+        node_view_t view = unpack(parent);
+        view.chars.erase(view.chars.begin() + child_index);
+        view.children.erase(view.children.begin() + child_index);
+        free(parent);
+
+        if(view.has_value || !view.chars.empty()) {
+            replace_in_parent(path, merge_with_child(pack(view)));
+            return removed_value;
+        }
+    }
+
+    root = nullptr;
+    return removed_value;
+}
+
+bool CVTrie::iterate(const uint8_t* node, std::string& key, const cvt_callback& callback) {
+    const size_t key_len = key.size();
+    key.append((const char*) prefix(node), prefix_len(node));
+
+    if(has_value(node) && !callback(key, value(node))) {
+        return false;
+    }
+
+    for(size_t i = 0; i < num_children(node); i++) {
+        key.push_back(char(chars(node)[i]));
+        if(!iterate(child(node, i), key, callback)) {
+            return false;
+        }
+        key.pop_back();
+    }
+
+    key.resize(key_len);
+    return true;
+}
+
+void CVTrie::iter_prefix(const char* prefix_key, uint32_t length, const cvt_callback& callback) const {
+    const auto* prefix_bytes = (const uint8_t*) prefix_key;
+    const uint8_t* node = root;
+    size_t pos = 0;
+    std::string key;
+
+    while(node != nullptr) {
+        const size_t plen = prefix_len(node);
+        const size_t cmp_len = std::min<size_t>(plen, length - pos);
+
+        if(std::memcmp(prefix(node), prefix_bytes + pos, cmp_len) != 0) {
+            return ;
+        }
+
+        if(pos + plen >= length) {
+            // the rest of the prefix ends within the path of the node
+            iterate(node, key, callback);
+            return ;
+        }
+
+        key.append((const char*) prefix(node), plen);
+        pos += plen;
+
+        const size_t child_index = find_child(node, prefix_bytes[pos]);
+        if(child_index == num_children(node)) {
+            return ;
+        }
+
+        key.push_back(char(prefix_bytes[pos]));
+        node = child(node, child_index);
+        pos++;
+    }
+}
+
+bool CVTrie::fuzzy_walk(const uint8_t* node, std::string& key, levenshtein_automaton_t& automaton,
+                        uint32_t state, size_t max_words, std::vector<std::pair<std::string, void*>>& results) {
+    auto collect = [&results, max_words](const std::string& match_key, void* match_value) {
+        results.emplace_back(match_key, match_value);
+        return results.size() < max_words;
+    };
+
+    const size_t key_len = key.size();
+
+    for(size_t i = 0; i < prefix_len(node); i++) {
+        const auto action = automaton.step(state, prefix(node)[i]);
+
+        if(action == levenshtein_automaton_t::ACCEPT) {
+            // every key below matches
+            key.resize(key_len);
+            return iterate(node, key, collect);
+        }
+
+        if(action == levenshtein_automaton_t::REJECT) {
+            key.resize(key_len);
+            return true;
+        }
+
+        key.push_back(char(prefix(node)[i]));
+    }
+
+    if(has_value(node)) {
+        uint32_t end_state = state;
+        if(automaton.step(end_state, '\0') == levenshtein_automaton_t::ACCEPT && !collect(key, value(node))) {
+            return false;
+        }
+    }
+
+    for(size_t i = 0; i < num_children(node); i++) {
+        const uint8_t c = chars(node)[i];
+        uint32_t child_state = state;
+        const auto action = automaton.step(child_state, c);
+
+        if(action == levenshtein_automaton_t::REJECT) {
+            continue;
+        }
+
+        key.push_back(char(c));
+
+        const bool go_on = (action == levenshtein_automaton_t::ACCEPT) ?
+                           iterate(child(node, i), key, collect) :
+                           fuzzy_walk(child(node, i), key, automaton, child_state, max_words, results);
+        if(!go_on) {
+            return false;
+        }
+
+        key.pop_back();
+    }
+
+    key.resize(key_len);
+    return true;
+}
+
+void CVTrie::fuzzy_search(const char* term, uint32_t term_len, int min_cost, int max_cost, bool prefix,
+                          size_t max_words, std::vector<std::pair<std::string, void*>>& results) const {
+    if(root == nullptr || max_words == 0) {
+        return ;
+    }
+
+    // like the keys of ART, a whole term ends with its null char, which the walk steps on at the end of a key
+    std::string automaton_term(term, term_len);
+    if(!prefix) {
+        automaton_term.push_back('\0');
+    }
+
+    levenshtein_automaton_t automaton((const unsigned char*) automaton_term.data(), automaton_term.size(),
+                                      min_cost, max_cost, prefix);
+    std::string key;
+    fuzzy_walk(root, key, automaton, levenshtein_automaton_t::INITIAL_STATE, max_words, results);
+}
+
+size_t CVTrie::memory_used() const {
+    size_t bytes = 0;
+    std::vector<const uint8_t*> nodes;
+    if(root != nullptr) {
+        nodes.push_back(root);
+    }
+
+    while(!nodes.empty()) {
+        const uint8_t* node = nodes.back();
+        nodes.pop_back();
+        bytes += block_size(node);
+
+        for(size_t i = 0; i < num_children(node); i++) {
+            nodes.push_back(child(node, i));
+        }
+    }
+
+    return bytes;
+}
@@ -0,0 +1,239 @@
+#include "doc_id_index.h"
+#include <mutex>
+#include "string_utils.h"
+
+doc_id_index_t::mode_t doc_id_index_t::parse_mode(const std::string& mode) {
+    if(mode == "map") {
+        return MAP;
+    }
+
+    if(mode == "bloom") {
+        return BLOOM;
+    }
+
+    return OFF;
+}
+
+uint64_t doc_id_index_t::hash_id(const std::string& doc_id) {
+    return StringUtils::hash_wy(doc_id.data(), doc_id.size());
+}
+
+size_t doc_id_index_t::find_slot(const std::string& doc_id, uint64_t hash) const {
+    if(slots.empty()) {
+        return SIZE_MAX;
+    }
+
+    const size_t mask = slots.size() - 1;
+
+    for(size_t i = hash & mask; ; i = (i + 1) & mask) {
+        const slot_t& slot = slots[i];
+
+        if(slot.id_len == EMPTY_SLOT) {
+            return SIZE_MAX;
+        }
+
+        if(slot.id_len != DELETED_SLOT && slot.hash == hash && slot.id_len == doc_id.size() &&
+           id_arena.compare(slot.id_offset, slot.id_len, doc_id) == 0) {
+            return i;
+        }
+    }
+}
+
+void doc_id_index_t::insert_slot(uint64_t hash, uint64_t id_offset, uint32_t id_len, uint32_t seq_id) {
+    const size_t mask = slots.size() - 1;
+    size_t i = hash & mask;
+
+    while(slots[i].id_len != EMPTY_SLOT && slots[i].id_len != DELETED_SLOT) {
+        i = (i + 1) & mask;
+    }
+
+    if(slots[i].id_len == DELETED_SLOT) {
+        num_deleted_slots--;
+    }
+
+    slots[i].hash = hash;
+    slots[i].id_offset = id_offset;
+    slots[i].id_len = id_len;
+    slots[i].seq_id = seq_id;
+}
+
+void doc_id_index_t::rebuild(size_t num_slots) {
+    std::vector<slot_t> old_slots(num_slots);
+    old_slots.swap(slots);
+
+    std::string prev_id_arena;
+    prev_id_arena.swap(id_arena);
+    id_arena.reserve(prev_id_arena.size() - id_arena_garbage);
+
+    id_arena_garbage = 0;
+    num_deleted_slots = 0;
+
+    for(const auto& slot: old_slots) {
+        if(slot.id_len == EMPTY_SLOT || slot.id_len == DELETED_SLOT) {
+            continue;
+        }
+
+        const uint64_t id_offset = id_arena.size();
+        id_arena.append(prev_id_arena, slot.id_offset, slot.id_len);
+        insert_slot(slot.hash, id_offset, slot.id_len, slot.seq_id);
+    }
+}
+
+bool doc_id_index_t::bloom_contains(const bloom_layer_t& layer, uint64_t hash) {
+    const size_t num_bits = layer.bits.size() * 64;
+    const uint64_t hash1 = hash & UINT32_MAX;
+    const uint64_t hash2 = (hash >> 32) | 1;
+
+    for(size_t i = 0; i < BLOOM_NUM_HASHES; i++) {
+        const size_t bit = (hash1 + i * hash2) % num_bits;
+        if((layer.bits[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void doc_id_index_t::bloom_add(uint64_t hash) {
+    for(const auto& layer: bloom_layers) {
+        if(bloom_contains(layer, hash)) {
+            return ;
+        }
+    }
+
+    if(bloom_layers.empty() || bloom_layers.back().num_ids >= bloom_layers.back().capacity) {
+        // the false positive rate of a filter grows beyond its capacity, so the ids go on in a larger one
+        bloom_layer_t layer;
+        layer.capacity = bloom_layers.empty() ? MIN_BLOOM_CAPACITY : bloom_layers.back().capacity * 2;
+        layer.bits.resize((layer.capacity * BLOOM_BITS_PER_ID + 63) / 64, 0);
+        bloom_layers.push_back(std::move(layer));
+    }
+
+    bloom_layer_t& layer = bloom_layers.back();
+    const size_t num_bits = layer.bits.size() * 64;
+    const uint64_t hash1 = hash & UINT32_MAX;
+    const uint64_t hash2 = (hash >> 32) | 1;
+
+    for(size_t i = 0; i < BLOOM_NUM_HASHES; i++) {
+        const size_t bit = (hash1 + i * hash2) % num_bits;
+        layer.bits[bit / 64] |= (uint64_t(1) << (bit % 64));
+    }
+
+    layer.num_ids++;
+}
+
+void doc_id_index_t::add(const std::string& doc_id, uint32_t seq_id) {
+    if(mode == OFF) {
+        return ;
+    }
+
+    const uint64_t hash = hash_id(doc_id);
+    std::unique_lock lock(mutex);
+
+    if(mode == BLOOM) {
+        bloom_add(hash);
+        return ;
+    }
+
+    const size_t slot_index = find_slot(doc_id, hash);
+    if(slot_index != SIZE_MAX) {
+        slots[slot_index].seq_id = seq_id;
+        return ;
+    }
+
+    // the table is kept at most 70% full, counting the slots of deleted ids which still take part in probing
+    if((num_ids + num_deleted_slots + 1) * 10 > slots.size() * 7) {
+        const bool mostly_deleted = (num_deleted_slots > num_ids);
+        rebuild(slots.empty() ? 1024 : (mostly_deleted ? slots.size() : slots.size() * 2));
+    }
+
+    const uint64_t id_offset = id_arena.size();
+    id_arena.append(doc_id);
+    insert_slot(hash, id_offset, doc_id.size(), seq_id);
+    num_ids++;
+}
+
+void doc_id_index_t::remove(const std::string& doc_id) {
+    if(mode != MAP) {
+        return ;
+    }
+
+    const uint64_t hash = hash_id(doc_id);
+    std::unique_lock lock(mutex);
+
+    const size_t slot_index = find_slot(doc_id, hash);
+    if(slot_index == SIZE_MAX) {
+        return ;
+    }
+
+    id_arena_garbage += slots[slot_index].id_len;
+    slots[slot_index].id_len = DELETED_SLOT;
+    num_deleted_slots++;
+    num_ids--;
+
+    if(id_arena_garbage > id_arena.size() / 2 && id_arena.size() > 1024 * 1024) {
+        rebuild(slots.size());
+    }
+}
+
+doc_id_index_t::lookup_t doc_id_index_t::find(const std::string& doc_id, uint32_t& seq_id) const {
+    if(mode == OFF) {
+        return UNKNOWN;
+    }
+
+    const uint64_t hash = hash_id(doc_id);
+    std::shared_lock lock(mutex);
+
+    if(mode == BLOOM) {
+        for(const auto& layer: bloom_layers) {
+            if(bloom_contains(layer, hash)) {
+                return UNKNOWN;
+            }
+        }
+
+        return NOT_FOUND;
+    }
+
+    const size_t slot_index = find_slot(doc_id, hash);
+    if(slot_index == SIZE_MAX) {
+        return NOT_FOUND;
+    }
+
+    seq_id = slots[slot_index].seq_id;
+    return FOUND;
+}
+
+void doc_id_index_t::clear() {
+    std::unique_lock lock(mutex);
+    id_arena = std::string();
+    id_arena_garbage = 0;
+    slots = std::vector<slot_t>();
+    num_ids = 0;
+    num_deleted_slots = 0;
+    bloom_layers.clear();
+}
+
+size_t doc_id_index_t::size() const {
+    std::shared_lock lock(mutex);
+
+    if(mode == BLOOM) {
+        size_t num_bloom_ids = 0;
+        for(const auto& layer: bloom_layers) {
+            num_bloom_ids += layer.num_ids;
+        }
+        return num_bloom_ids;
+    }
+
+    return num_ids;
+}
+
+size_t doc_id_index_t::memory_used() const {
+    std::shared_lock lock(mutex);
+    size_t memory = id_arena.capacity() + slots.capacity() * sizeof(slot_t);
+
+    for(const auto& layer: bloom_layers) {
+        memory += layer.bits.capacity() * sizeof(uint64_t);
+    }
+
+    return memory;
+}
@@ -64,18 +64,34 @@ Option<bool> EmbedderManager::validate_and_init_remote_model(const nlohmann::jso
 
 Option<bool> EmbedderManager::validate_and_init_local_model(const nlohmann::json& model_config, size_t& num_dims) {
     const std::string& model_name = model_config["model_name"].get<std::string>();
+
+    auto options_op = local_model_options_t::parse(model_config);
+    if(!options_op.ok()) {
+        return Option<bool>(options_op.code(), options_op.error());
+    }
+
+    const auto& options = options_op.get();
+
+    if(options.execution_provider == "cuda") {
+        auto providers = Ort::GetAvailableProviders();
+        if(std::find(providers.begin(), providers.end(), "CUDAExecutionProvider") == providers.end()) {
+            return Option<bool>(400, "Execution provider `cuda` is not available.");
+        }
+    }
+
     Option<bool> public_model_op = EmbedderManager::get_instance().init_public_model(model_name);
 
     if(!public_model_op.ok()) {
         return public_model_op;
     }
 
-    std::string abs_path = EmbedderManager::get_absolute_model_path(
-    EmbedderManager::get_model_name_without_namespace(model_name));
+    const auto& model_name_without_namespace = get_model_name_without_namespace(model_name);
+    std::string abs_path = options.quantized ? get_absolute_quantized_model_path(model_name_without_namespace) :
+                           get_absolute_model_path(model_name_without_namespace);
 
     if(!std::filesystem::exists(abs_path)) {
         LOG(ERROR) << "Model file not found: " << abs_path;
-        return Option<bool>(400, "Model file not found");
+        return Option<bool>(400, options.quantized ? "Quantized model file not found" : "Model file not found");
     }
 
     bool is_public_model = public_model_op.get();
@@ -117,7 +133,6 @@ Option<bool> EmbedderManager::validate_and_init_local_model(const nlohmann::json
         return Option<bool>(true);
     }
 
-    const auto& model_name_without_namespace = get_model_name_without_namespace(model_name);
     const auto& free_memory = SystemMetrics::get_memory_free_bytes();
     const auto& model_file_size = std::filesystem::file_size(abs_path);
     
@@ -127,7 +142,7 @@ Option<bool> EmbedderManager::validate_and_init_local_model(const nlohmann::json
         return Option<bool>(400, "Memory required to load the model exceeds free memory available.");
     }
 
-    const std::shared_ptr<TextEmbedder>& embedder = std::make_shared<TextEmbedder>(model_name_without_namespace);
+    const std::shared_ptr<TextEmbedder>& embedder = std::make_shared<TextEmbedder>(model_name_without_namespace, options);
 
     auto validate_op = embedder->validate();
     if(!validate_op.ok()) {
@@ -257,12 +272,32 @@ const std::string& EmbedderManager::get_model_dir() {
     return model_dir;
 }
 
+void EmbedderManager::set_query_batch_window_ms(uint32_t window_ms) {
+    query_batch_window_ms = window_ms;
+}
+
+std::chrono::microseconds EmbedderManager::get_query_batch_window() {
+    return std::chrono::milliseconds(query_batch_window_ms.load());
+}
+
+void EmbedderManager::set_remote_embedding_concurrency(size_t concurrency) {
+    remote_embedding_concurrency = std::max<size_t>(concurrency, 1);
+}
+
+size_t EmbedderManager::get_remote_embedding_concurrency() {
+    return remote_embedding_concurrency;
+}
+
 EmbedderManager::~EmbedderManager() {
 }
 
 const std::string EmbedderManager::get_absolute_model_path(const std::string& model_name) {
     return get_model_subdir(model_name) + "/model.onnx";
 }
+const std::string EmbedderManager::get_absolute_quantized_model_path(const std::string& model_name) {
+    return get_model_subdir(model_name) + "/model_quantized.onnx";
+}
+
 const std::string EmbedderManager::get_absolute_vocab_path(const std::string& model_name, const std::string& vocab_file_name) {
     return get_model_subdir(model_name) + "/" + vocab_file_name;
 }
@@ -0,0 +1,64 @@
+#include "embedding_batcher.h"
+
+embedding_batcher_t::embedding_batcher_t(batch_func_t batch_func): batch_func(std::move(batch_func)) {
+
+}
+
+embedding_res_t embedding_batcher_t::embed(const std::string& text, std::chrono::microseconds window) {
+    request_t request(text);
+
+    std::unique_lock lock(mutex);
+    pending.push_back(&request);
+
+    if(pending.size() >= MAX_BATCH_SIZE) {
+        // a leader waiting for its window can run a full batch right away
+        cv.notify_all();
+    }
+
+    while(!request.done) {
+        if(running) {
+            cv.wait(lock);
+            continue;
+        }
+
+        running = true;
+
+        if(window.count() > 0) {
+            cv.wait_for(lock, window, [&]() { return pending.size() >= MAX_BATCH_SIZE; });
+        }
+
+        std::vector<request_t*> batch;
+        std::vector<std::string> texts;
+
+        while(!pending.empty() && batch.size() < MAX_BATCH_SIZE) {
+            batch.push_back(pending.front());
+            texts.push_back(pending.front()->text);
+            pending.pop_front();
+        }
+
+        lock.unlock();
+        auto results = batch_func(texts);
+        lock.lock();
+
+        for(size_t i = 0; i < batch.size(); i++) {
+            if(i < results.size()) {
+                batch[i]->result = std::move(results[i]);
+            } else {
+                batch[i]->result = embedding_res_t(500, nlohmann::json({{"error", "Failed to embed the query."}}));
+            }
+
+            batch[i]->done = true;
+        }
+
+        num_batches++;
+        running = false;
+        cv.notify_all();
+    }
+
+    return std::move(request.result);
+}
+
+size_t embedding_batcher_t::get_num_batches() {
+    std::unique_lock lock(mutex);
+    return num_batches;
+}
@@ -0,0 +1,86 @@
+#include "embedding_cache.h"
+
+std::atomic<size_t> embedding_cache_t::max_entries = embedding_cache_t::DEFAULT_MAX_ENTRIES;
+
+std::atomic<uint64_t> embedding_cache_t::hits = 0;
+std::atomic<uint64_t> embedding_cache_t::misses = 0;
+std::atomic<uint64_t> embedding_cache_t::evictions = 0;
+std::atomic<uint64_t> embedding_cache_t::num_entries = 0;
+
+embedding_cache_t::~embedding_cache_t() {
+    clear();
+}
+
+void embedding_cache_t::erase(std::list<std::pair<std::string, std::vector<float>>>::iterator it) {
+    entry_index.erase(it->first);
+    entries.erase(it);
+    num_entries--;
+}
+
+bool embedding_cache_t::get(const std::string& text, std::vector<float>& embedding) {
+    if (max_entries == 0) {
+        return false;
+    }
+
+    std::unique_lock lock(mutex);
+
+    auto hit_it = entry_index.find(text);
+    if (hit_it == entry_index.end()) {
+        misses++;
+        return false;
+    }
+
+    // move to the front
+    entries.splice(entries.begin(), entries, hit_it->second);
+    hits++;
+    embedding = hit_it->second->second;
+    return true;
+}
+
+void embedding_cache_t::insert(const std::string& text, const std::vector<float>& embedding) {
+    const size_t entries_limit = max_entries;
+
+    if (entries_limit == 0) {
+        return;
+    }
+
+    std::unique_lock lock(mutex);
+
+    auto existing_it = entry_index.find(text);
+    if (existing_it != entry_index.end()) {
+        erase(existing_it->second);
+    }
+
+    entries.emplace_front(text, embedding);
+    entry_index.emplace(text, entries.begin());
+    num_entries++;
+
+    while (entries.size() > entries_limit) {
+        erase(std::prev(entries.end()));
+        evictions++;
+    }
+}
+
+void embedding_cache_t::clear() {
+    std::unique_lock lock(mutex);
+    num_entries -= entries.size();
+    entries.clear();
+    entry_index.clear();
+}
+
+size_t embedding_cache_t::size() const {
+    std::unique_lock lock(mutex);
+    return entries.size();
+}
+
+void embedding_cache_t::set_max_entries(size_t max_entries) {
+    embedding_cache_t::max_entries = max_entries;
+}
+
+void embedding_cache_t::get_metrics(nlohmann::json& result) {
+    result["typesense_embedding_cache_hits"] = std::to_string(hits);
+    result["typesense_embedding_cache_misses"] = std::to_string(misses);
+    result["typesense_embedding_cache_evictions"] = std::to_string(evictions);
+    result["typesense_embedding_cache_entries"] = std::to_string(num_entries);
+    result["typesense_embedding_cache_max_entries_per_model"] = std::to_string(max_entries);
+}
@@ -0,0 +1,75 @@
+#include "eval_bitmap_cache.h"
+
+id_bitmap_t::id_bitmap_t(const uint32_t* ids, size_t num_ids): num_ids(num_ids) {
+    if(num_ids == 0) {
+        return ;
+    }
+
+    words.resize(ids[num_ids - 1] / 64 + 1, 0);
+
+    for(size_t i = 0; i < num_ids; i++) {
+        words[ids[i] / 64] |= (uint64_t(1) << (ids[i] % 64));
+    }
+}
+
+eval_bitmap_cache_t::eval_bitmap_cache_t(size_t max_entries, size_t max_bytes):
+        max_entries(max_entries), max_bytes(max_bytes) {
+
+}
+
+void eval_bitmap_cache_t::erase(std::list<std::pair<std::string, entry_t>>::iterator it) {
+    num_bytes -= it->second.bitmap->num_bytes();
+    entry_index.erase(it->first);
+    entries.erase(it);
+}
+
+eval_bitmap_cache_t::bitmap_t eval_bitmap_cache_t::get(const std::string& key, uint64_t write_generation) {
+    std::unique_lock lock(mutex);
+
+    auto hit_it = entry_index.find(key);
+    if(hit_it == entry_index.end()) {
+        return nullptr;
+    }
+
+    if(hit_it->second->second.write_generation != write_generation) {
+        erase(hit_it->second);
+        return nullptr;
+    }
+
+    // move to the front
+    entries.splice(entries.begin(), entries, hit_it->second);
+    return hit_it->second->second.bitmap;
+}
+
+void eval_bitmap_cache_t::insert(const std::string& key, uint64_t write_generation, bitmap_t bitmap) {
+    if(key.empty() || bitmap == nullptr || bitmap->num_bytes() > max_bytes) {
+        return ;
+    }
+
+    std::unique_lock lock(mutex);
+
+    auto existing_it = entry_index.find(key);
+    if(existing_it != entry_index.end()) {
+        erase(existing_it->second);
+    }
+
+    num_bytes += bitmap->num_bytes();
+    entries.emplace_front(key, entry_t{std::move(bitmap), write_generation});
+    entry_index.emplace(key, entries.begin());
+
+    while(entries.size() > max_entries || num_bytes > max_bytes) {
+        erase(std::prev(entries.end()));
+    }
+}
+
+void eval_bitmap_cache_t::clear() {
+    std::unique_lock lock(mutex);
+    entries.clear();
+    entry_index.clear();
+    num_bytes = 0;
+}
+
+size_t eval_bitmap_cache_t::size() const {
+    std::unique_lock lock(mutex);
+    return entries.size();
+}
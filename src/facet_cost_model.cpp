@@ -0,0 +1,97 @@
+#include "facet_cost_model.h"
+#include <algorithm>
+
+size_t facet_cost_model_t::get_bucket(size_t num_results) {
+    size_t bucket = 0;
+    while(num_results > 1 && bucket + 1 < NUM_BUCKETS) {
+        num_results >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+bool facet_cost_model_t::choose(const std::string& field_name, size_t num_results, bool heuristic_use_value_index,
+                                basis_t& basis) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto& bucket = field_buckets[field_name][get_bucket(num_results)];
+    bucket.num_choices++;
+
+    const bool hash_known = bucket.num_samples[0] >= MIN_SAMPLES;
+    const bool value_known = bucket.num_samples[1] >= MIN_SAMPLES;
+
+    if(!hash_known || !value_known) {
+        if((bucket.num_choices % EXPLORE_INTERVAL) == 0) {
+            basis = EXPLORATION;
+            // try the strategy that lacks samples, favouring the one the heuristic does not pick
+            return heuristic_use_value_index ? hash_known : !value_known;
+        }
+
+        basis = HEURISTIC;
+        return heuristic_use_value_index;
+    }
+
+    const bool value_is_cheaper = bucket.costs_us[1] < bucket.costs_us[0];
+    const double best_cost = std::max(value_is_cheaper ? bucket.costs_us[1] : bucket.costs_us[0], 1.0);
+    const double other_cost = value_is_cheaper ? bucket.costs_us[0] : bucket.costs_us[1];
+
+    if((bucket.num_choices % REEXPLORE_INTERVAL) == 0 && other_cost < best_cost * MAX_REEXPLORE_COST_RATIO) {
+        basis = EXPLORATION;
+        return !value_is_cheaper;
+    }
+
+    basis = MEASURED;
+    return value_is_cheaper;
+}
+
+void facet_cost_model_t::record(const std::string& field_name, size_t num_results, bool used_value_index,
+                                uint64_t duration_us) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto& bucket = field_buckets[field_name][get_bucket(num_results)];
+
+    auto& cost_us = bucket.costs_us[used_value_index];
+    auto& num_samples = bucket.num_samples[used_value_index];
+
+    if(num_samples == 0) {
+        cost_us = duration_us;
+    } else {
+        cost_us += COST_WEIGHT * (double(duration_us) - cost_us);
+    }
+
+    if(num_samples < UINT32_MAX) {
+        num_samples++;
+    }
+}
+
+bool facet_cost_model_t::get_cost_us(const std::string& field_name, size_t num_results, bool value_index,
+                                     double& cost_us) const {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = field_buckets.find(field_name);
+    if(it == field_buckets.end()) {
+        return false;
+    }
+
+    const auto& bucket = it->second[get_bucket(num_results)];
+    if(bucket.num_samples[value_index] < MIN_SAMPLES) {
+        return false;
+    }
+
+    cost_us = bucket.costs_us[value_index];
+    return true;
+}
+
+void facet_cost_model_t::remove_field(const std::string& field_name) {
+    std::unique_lock<std::mutex> lock(mutex);
+    field_buckets.erase(field_name);
+}
+
+const char* facet_cost_model_t::basis_name(basis_t basis) {
+    switch(basis) {
+        case MEASURED:
+            return "measured";
+        case EXPLORATION:
+            return "exploration";
+        default:
+            return "heuristic";
+    }
+}
@@ -29,6 +29,7 @@ void facet_index_t::insert(const std::string& field_name,
         auto seq_id = seq_id_fvalues.first;
         std::vector<uint32_t> real_facet_ids;
         real_facet_ids.reserve(seq_id_fvalues.second.size());
+        uint16_t ordinal = 0;
 
         for(const auto& fvalue: seq_id_fvalues.second) {
             uint32_t facet_id = fvalue.facet_id;
@@ -46,6 +47,10 @@ void facet_index_t::insert(const std::string& field_name,
 
             real_facet_ids.push_back(facet_id);
 
+            if(fvalue_index_it != fvalue_index.end()) {
+                ordinal = fvalue_index_it->second.ordinal;
+            }
+
             auto seq_ids_it = fvalue_to_seq_ids.find(fvalue);
             if(seq_ids_it == fvalue_to_seq_ids.end()) {
                 continue;
@@ -58,8 +63,22 @@ void facet_index_t::insert(const std::string& field_name,
                 facet_id_seq_ids_t fis;
                 fis.facet_id = facet_id;
 
+                if(facet_index.has_ordinal_index) {
+                    if(!facet_index.free_ordinals.empty()) {
+                        fis.ordinal = facet_index.free_ordinals.back();
+                        facet_index.free_ordinals.pop_back();
+                    } else if(facet_index.num_ordinals < MAX_ORDINALS) {
+                        fis.ordinal = ++facet_index.num_ordinals;
+                    } else {
+                        drop_ordinal_index(facet_index);
+                    }
+
+                    ordinal = fis.ordinal;
+                }
+
                 if(facet_index.has_value_index) {
                     fis.seq_ids = ids_t::create(seq_ids);
+                    sketch_insert(fis, seq_ids);
                     auto new_count = ids_t::num_ids(fis.seq_ids);
                     auto& count_map = facet_index.count_map;
                     auto count_map_it = count_map.lower_bound(new_count);
@@ -86,11 +105,14 @@ void facet_index_t::insert(const std::string& field_name,
                 }
 
                 fvalue_index.emplace(fvalue.facet_value, fis);
+                invalidate_value_token_index(facet_index, value_token_index_mutex);
             } else if(facet_index.has_value_index) {
                 for(const auto id : seq_ids) {
                     ids_t::upsert(fvalue_index_it->second.seq_ids, id);
                 }
 
+                sketch_insert(fvalue_index_it->second, seq_ids);
+
                 auto facet_count_it = fvalue_index_it->second.facet_count_it;
 
                 if(facet_count_it->facet_id == facet_id) {
@@ -113,6 +135,134 @@ void facet_index_t::insert(const std::string& field_name,
         if(facet_index.has_hash_index && fhash_index != nullptr) {
             fhash_index->upsert(seq_id, real_facet_ids);
         }
+
+        if(facet_index.has_ordinal_index) {
+            if(seq_id_fvalues.second.size() > 1) {
+                drop_ordinal_index(facet_index);
+            } else {
+                set_seq_id_ordinal(facet_index, seq_id, ordinal);
+            }
+        }
+
+        if(facet_index.has_facet_id_column) {
+            if(real_facet_ids.size() > 1) {
+                drop_facet_id_column(facet_index);
+            } else {
+                set_seq_id_facet_id(facet_index, seq_id, real_facet_ids.empty() ? NO_FACET_ID : real_facet_ids[0]);
+            }
+        }
+    }
+}
+
+void facet_index_t::drop_ordinal_index(facet_doc_ids_list_t& facet_index) {
+    std::vector<uint16_t>().swap(facet_index.seq_id_ordinals);
+    std::vector<uint16_t>().swap(facet_index.free_ordinals);
+    facet_index.num_ordinals = 0;
+    facet_index.has_ordinal_index = false;
+}
+
+void facet_index_t::drop_facet_id_column(facet_doc_ids_list_t& facet_index) {
+    std::vector<uint32_t>().swap(facet_index.seq_id_facet_ids);
+    facet_index.has_facet_id_column = false;
+}
+
+void facet_index_t::set_seq_id_facet_id(facet_doc_ids_list_t& facet_index, uint32_t seq_id, uint32_t facet_id) {
+    auto& facet_ids = facet_index.seq_id_facet_ids;
+
+    if(seq_id >= facet_ids.size()) {
+        if(facet_id == NO_FACET_ID) {
+            return;
+        }
+
+        facet_ids.resize(std::max<size_t>(size_t(seq_id) + 1, facet_ids.size() + facet_ids.size() / 2), NO_FACET_ID);
+    }
+
+    facet_ids[seq_id] = facet_id;
+}
+
+void facet_index_t::sketch_insert(facet_id_seq_ids_t& facet_id_seq_ids, const std::vector<uint32_t>& seq_ids) {
+    if(facet_id_seq_ids.sketch != nullptr) {
+        for(auto seq_id: seq_ids) {
+            facet_id_seq_ids.sketch->insert(seq_id);
+        }
+
+        return;
+    }
+
+    if(ids_t::num_ids(facet_id_seq_ids.seq_ids) > facet_value_sketch_t::SAMPLE_SIZE) {
+        std::vector<uint32_t> all_seq_ids;
+        ids_t::uncompress(facet_id_seq_ids.seq_ids, all_seq_ids);
+        facet_id_seq_ids.sketch = new facet_value_sketch_t();
+        facet_id_seq_ids.sketch->build(all_seq_ids);
+    }
+}
+
+void facet_index_t::sketch_erase(facet_id_seq_ids_t& facet_id_seq_ids, uint32_t seq_id) {
+    if(facet_id_seq_ids.sketch == nullptr) {
+        return;
+    }
+
+    if(ids_t::num_ids(facet_id_seq_ids.seq_ids) <= facet_value_sketch_t::SAMPLE_SIZE) {
+        // few enough ids to be counted exactly
+        delete facet_id_seq_ids.sketch;
+        facet_id_seq_ids.sketch = nullptr;
+        return;
+    }
+
+    if(facet_id_seq_ids.sketch->erase(seq_id)) {
+        std::vector<uint32_t> all_seq_ids;
+        ids_t::uncompress(facet_id_seq_ids.seq_ids, all_seq_ids);
+        facet_id_seq_ids.sketch->build(all_seq_ids);
+    }
+}
+
+void facet_index_t::set_seq_id_ordinal(facet_doc_ids_list_t& facet_index, uint32_t seq_id, uint16_t ordinal) {
+    auto& ordinals = facet_index.seq_id_ordinals;
+
+    if(seq_id >= ordinals.size()) {
+        if(ordinal == 0) {
+            return;
+        }
+
+        // seq_ids are mostly handed out in increasing order, so leave room for the next ones
+        ordinals.resize(std::max<size_t>(size_t(seq_id) + 1, ordinals.size() + ordinals.size() / 2), 0);
+    }
+
+    ordinals[seq_id] = ordinal;
+}
+
+void facet_index_t::count_ordinals(const facet_doc_ids_list_t& facet_index, const uint32_t* result_ids,
+                                   size_t result_ids_len, std::vector<uint32_t>& ordinal_counts) {
+    const auto& ordinals = facet_index.seq_id_ordinals;
+    const size_t num_counts = size_t(facet_index.num_ordinals) + 1;
+
+    // result ids are sorted, so the ones past the end of the column are at the end
+    const size_t len = std::lower_bound(result_ids, result_ids + result_ids_len, ordinals.size()) - result_ids;
+
+    // A low cardinality field has the same value on consecutive ids often: four sets of counts keep the
+    // increments of neighbouring ids from waiting on each other.
+    std::vector<uint32_t> counts(num_counts * 4, 0);
+    uint32_t* counts0 = &counts[0];
+    uint32_t* counts1 = counts0 + num_counts;
+    uint32_t* counts2 = counts1 + num_counts;
+    uint32_t* counts3 = counts2 + num_counts;
+    const uint16_t* column = ordinals.data();
+
+    size_t i = 0;
+    for(; i + 4 <= len; i += 4) {
+        counts0[column[result_ids[i]]]++;
+        counts1[column[result_ids[i + 1]]]++;
+        counts2[column[result_ids[i + 2]]]++;
+        counts3[column[result_ids[i + 3]]]++;
+    }
+
+    for(; i < len; i++) {
+        counts0[column[result_ids[i]]]++;
+    }
+
+    ordinal_counts.resize(num_counts);
+    for(size_t j = 0; j < num_counts; j++) {
+        ordinal_counts[j] = counts0[j] + counts1[j] + counts2[j] + counts3[j];
     }
 }
 
@@ -273,6 +423,7 @@ void facet_index_t::remove(const nlohmann::json& doc, const field& afield, const
         void*& ids = fvalue_it->second.seq_ids;
         if(ids && ids_t::contains(ids, seq_id)) {
             ids_t::erase(ids, seq_id);
+            sketch_erase(fvalue_it->second, seq_id);
             auto& count_list = facet_field_it->second.counts;
             auto curr = fvalue_it->second.facet_count_it;
             auto old_count = curr->count;
@@ -287,6 +438,10 @@ void facet_index_t::remove(const nlohmann::json& doc, const field& afield, const
                 ids_t::destroy_list(ids);
                 dead_fvalues.push_back(fvalue_it->first);
 
+                if(facet_field_it->second.has_ordinal_index && fvalue_it->second.ordinal != 0) {
+                    facet_field_it->second.free_ordinals.push_back(fvalue_it->second.ordinal);
+                }
+
                 //remove from int64 lookup map first
                 auto& fhash_int64_map = facet_field_it->second.fhash_to_int64_map;
                 uint32_t fhash = fvalue_it->second.facet_id;
@@ -302,8 +457,20 @@ void facet_index_t::remove(const nlohmann::json& doc, const field& afield, const
         facet_index_map.erase(dead_fvalue);
     }
 
+    if(!dead_fvalues.empty()) {
+        invalidate_value_token_index(facet_field_it->second, value_token_index_mutex);
+    }
+
     auto& seq_id_hashes = facet_field_it->second.seq_id_hashes;
     seq_id_hashes->erase(seq_id);
+
+    if(facet_field_it->second.has_ordinal_index) {
+        set_seq_id_ordinal(facet_field_it->second, seq_id, 0);
+    }
+
+    if(facet_field_it->second.has_facet_id_column) {
+        set_seq_id_facet_id(facet_field_it->second, seq_id, NO_FACET_ID);
+    }
 }
 
 size_t facet_index_t::get_facet_count(const std::string& field_name) {
@@ -317,6 +484,79 @@ size_t facet_index_t::get_facet_count(const std::string& field_name) {
 }
 
 //returns the count of matching seq_ids from result array
+void facet_index_t::invalidate_value_token_index(facet_doc_ids_list_t& facet_index, std::mutex& mutex) {
+    std::unique_lock lock(mutex);
+    facet_index.value_token_index = nullptr;
+}
+
+std::shared_ptr<const facet_index_t::value_token_index_t>
+facet_index_t::get_value_token_index(facet_doc_ids_list_t& facet_index, const field& facet_field,
+                                     const std::vector<char>& symbols_to_index,
+                                     const std::vector<char>& token_separators) {
+    std::unique_lock lock(value_token_index_mutex);
+
+    if(facet_index.value_token_index != nullptr) {
+        return facet_index.value_token_index;
+    }
+
+    auto token_index = std::make_shared<value_token_index_t>();
+    std::vector<std::string> tokens;
+
+    for(const auto& fvalue_kv: facet_index.fvalue_seq_ids) {
+        const std::string* fvalue = &fvalue_kv.first;
+
+        if(facet_field.is_string()) {
+            tokens.clear();
+            Tokenizer(*fvalue, true, false, facet_field.locale, symbols_to_index, token_separators).tokenize(tokens);
+            for(const auto& token: tokens) {
+                auto& token_values = token_index->token_values[token];
+                // a value that repeats a token is listed once for it
+                if(token_values.empty() || token_values.back() != fvalue) {
+                    token_values.push_back(fvalue);
+                }
+            }
+        } else {
+            token_index->token_values[*fvalue].push_back(fvalue);
+        }
+    }
+
+    facet_index.value_token_index = token_index;
+    return token_index;
+}
+
+void facet_index_t::get_prefixed_values(const value_token_index_t& token_index,
+                                        const std::vector<std::string>& searched_tokens,
+                                        std::vector<const std::string*>& values) {
+    values.clear();
+    std::vector<const std::string*> token_values, common_values;
+
+    for(size_t i = 0; i < searched_tokens.size(); i++) {
+        const auto& prefix = searched_tokens[i];
+        token_values.clear();
+
+        for(auto it = token_index.token_values.lower_bound(prefix);
+            it != token_index.token_values.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            token_values.insert(token_values.end(), it->second.begin(), it->second.end());
+        }
+
+        std::sort(token_values.begin(), token_values.end());
+        token_values.erase(std::unique(token_values.begin(), token_values.end()), token_values.end());
+
+        if(i == 0) {
+            values.swap(token_values);
+        } else {
+            common_values.clear();
+            std::set_intersection(values.begin(), values.end(), token_values.begin(), token_values.end(),
+                                  std::back_inserter(common_values));
+            values.swap(common_values);
+        }
+
+        if(values.empty()) {
+            return ;
+        }
+    }
+}
+
 size_t facet_index_t::intersect(facet& a_facet, const field& facet_field,
                                 bool has_facet_query,
                                 bool estimate_facets,
@@ -325,7 +565,8 @@ size_t facet_index_t::intersect(facet& a_facet, const field& facet_field,
                                 const std::vector<char>& symbols_to_index, const std::vector<char>& token_separators,
                                 const uint32_t* result_ids, size_t result_ids_len,
                                 size_t max_facet_count, std::map<std::string, docid_count_t>& found,
-                                bool is_wildcard_no_filter_query, const std::string& sort_order) {
+                                bool is_wildcard_no_filter_query, const std::string& sort_order,
+                                bool approximate) {
     //LOG (INFO) << "intersecting field " << field;
 
     const auto& facet_field_it = facet_field_map.find(a_facet.field_name);
@@ -343,54 +584,33 @@ size_t facet_index_t::intersect(facet& a_facet, const field& facet_field,
     size_t max_facets = is_wildcard_no_filter_query ? std::min((size_t)max_facet_count, counter_list.size()) :
                         std::min((size_t)2 * max_facet_count, counter_list.size());
 
+    // counts every value of a large result set in one pass instead of intersecting it with every value visited
+    std::vector<uint32_t> ordinal_counts;
+    const bool use_ordinal_counts = !is_wildcard_no_filter_query && !estimate_facets && !approximate &&
+                                    facet_field_it->second.has_ordinal_index &&
+                                    result_ids_len >= ORDINAL_COUNT_MIN_RESULTS;
+    if(use_ordinal_counts) {
+        count_ordinals(facet_field_it->second, result_ids, result_ids_len, ordinal_counts);
+    }
+
     auto intersect_fn = [&] (std::list<facet_count_t>::const_iterator facet_count_it) {
         uint32_t count = 0;
         uint32_t doc_id = 0;
-        if(has_facet_query) {
-            bool found_search_token = false;
-            auto facet_str = facet_count_it->facet_value;
-            std::vector<std::string> facet_tokens;
-            if(facet_field.is_string()) {
-                Tokenizer(facet_str, true, false, facet_field.locale,
-                          symbols_to_index, token_separators).tokenize(facet_tokens);
-            } else {
-                facet_tokens.push_back(facet_str);
-            }
-
-            for(const auto& searched_tokens : fvalue_searched_tokens) {
-                bool found_all_search_tokens = true;
-                for (const auto &searched_token: searched_tokens) {
-                    bool facet_tokens_found = false;
-                    for(const auto& token : facet_tokens) {
-                        if (token.compare(0, searched_token.size(), searched_token) == 0) {
-                            facet_tokens_found = true;
-                            break;
-                        }
-                    }
-                    if(!facet_tokens_found) {
-                        found_all_search_tokens = false;
-                    }
-                }
-
-                if (found_all_search_tokens) {
-                    a_facet.fvalue_tokens[facet_count_it->facet_value] = searched_tokens;
-                    found_search_token = true;
-                    break;
-                }
-            }
-
-            if(!found_search_token) {
-                return;
-            }
-        }
-
-        auto ids = facet_index_map.at(facet_count_it->facet_value).seq_ids;
+        uint32_t error_bound = 0;
+        const auto& facet_id_seq_ids = facet_index_map.at(facet_count_it->facet_value);
+        auto ids = facet_id_seq_ids.seq_ids;
         if (!ids) {
             return;
         }
 
         if (is_wildcard_no_filter_query) {
             count = facet_count_it->count;
+        } else if (approximate && facet_id_seq_ids.sketch != nullptr) {
+            const auto& sketch = facet_id_seq_ids.sketch;
+            count = facet_value_sketch_t::estimate(ids_t::num_ids(ids), sketch->size(),
+                                                    sketch->count_in(result_ids, result_ids_len), error_bound);
+        } else if (use_ordinal_counts) {
+            count = ordinal_counts[facet_id_seq_ids.ordinal];
         } else {
             auto val_count = ids_t::num_ids(ids);
             bool estimate_facet_count = (estimate_facets && val_count > 300);
@@ -399,11 +619,47 @@ size_t facet_index_t::intersect(facet& a_facet, const field& facet_field,
 
         if (count) {
             doc_id = ids_t::first_id(ids);
-            found[facet_count_it->facet_value] = {doc_id, count};
+            found[facet_count_it->facet_value] = {doc_id, count, error_bound};
         }
     };
 
-    if(sort_order.empty()) {
+    if(has_facet_query) {
+        // only the values that match the facet query are visited, in the order of the counts or of the values
+        auto token_index = get_value_token_index(facet_field_it->second, facet_field,
+                                                 symbols_to_index, token_separators);
+        std::map<std::string, const std::vector<std::string>*> matched_values;
+        std::vector<const std::string*> prefixed_values;
+
+        for(const auto& searched_tokens : fvalue_searched_tokens) {
+            get_prefixed_values(*token_index, searched_tokens, prefixed_values);
+            for(const auto fvalue: prefixed_values) {
+                // the first of the searched queries that matches a value is the one highlighted
+                matched_values.emplace(*fvalue, &searched_tokens);
+            }
+        }
+
+        std::vector<std::list<facet_count_t>::const_iterator> facet_count_its;
+        facet_count_its.reserve(matched_values.size());
+        for(const auto& matched_value: matched_values) {
+            facet_count_its.push_back(facet_index_map.at(matched_value.first).facet_count_it);
+        }
+
+        if(sort_order.empty()) {
+            std::stable_sort(facet_count_its.begin(), facet_count_its.end(), [](const auto& a, const auto& b) {
+                return a->count > b->count;
+            });
+        } else if(sort_order == "desc") {
+            std::reverse(facet_count_its.begin(), facet_count_its.end());
+        }
+
+        for(const auto& facet_count_it: facet_count_its) {
+            a_facet.fvalue_tokens[facet_count_it->facet_value] = *matched_values.at(facet_count_it->facet_value);
+            intersect_fn(facet_count_it);
+            if (found.size() == max_facets) {
+                break;
+            }
+        }
+    } else if(sort_order.empty()) {
         for (auto facet_count_it = counter_list.begin(); facet_count_it != counter_list.end();
              ++facet_count_it) {
             //LOG(INFO) << "checking ids in facet_value " << facet_count.facet_value << " having total count "
@@ -504,10 +760,12 @@ void facet_index_t::handle_index_change(const std::string& field_name, size_t to
             auto& fvalue_seq_ids = facet_index.fvalue_seq_ids;
             for(auto it = fvalue_seq_ids.begin(); it != fvalue_seq_ids.end(); ++it) {
                 ids_t::destroy_list(it->second.seq_ids);
+                delete it->second.sketch;
             }
             fvalue_seq_ids.clear();
             facet_index.counts.clear();
             facet_index.has_value_index = false;
+            drop_ordinal_index(facet_index);
         }
     }
 }
@@ -522,6 +780,11 @@ bool facet_index_t::has_value_index(const std::string &field_name) {
     return facet_index_it != facet_field_map.end() && facet_index_it->second.has_value_index;
 }
 
+bool facet_index_t::has_ordinal_index(const std::string &field_name) {
+    auto facet_index_it = facet_field_map.find(field_name);
+    return facet_index_it != facet_field_map.end() && facet_index_it->second.has_ordinal_index;
+}
+
 posting_list_t* facet_index_t::get_facet_hash_index(const std::string &field_name) {
     auto facet_index_it = facet_field_map.find(field_name);
     if(facet_index_it != facet_field_map.end()) {
@@ -530,6 +793,14 @@ posting_list_t* facet_index_t::get_facet_hash_index(const std::string &field_nam
     return nullptr;
 }
 
+const std::vector<uint32_t>* facet_index_t::get_facet_id_column(const std::string& field_name) {
+    auto facet_index_it = facet_field_map.find(field_name);
+    if(facet_index_it != facet_field_map.end() && facet_index_it->second.has_facet_id_column) {
+        return &facet_index_it->second.seq_id_facet_ids;
+    }
+    return nullptr;
+}
+
 const spp::sparse_hash_map<uint32_t , int64_t >& facet_index_t::get_fhash_int64_map(const std::string& field_name) {
     const auto facet_field_map_it = facet_field_map.find(field_name);
     if(facet_field_map_it == facet_field_map.end()) {
@@ -609,6 +880,7 @@ void facet_index_t::check_for_high_cardinality(const string& field_name, size_t
         facet_field_map_it->second.counts.clear();
         facet_field_map_it->second.count_map.clear();
         facet_field_map_it->second.has_value_index = false;
+        drop_ordinal_index(facet_field_map_it->second);
         //LOG(INFO) << "Dropped value index for field " << field_name;
     }
 }
@@ -0,0 +1,137 @@
+#include "facet_result_cache.h"
+#include "string_utils.h"
+
+facet_result_cache_t::facet_result_cache_t(size_t max_entries, size_t max_values):
+        max_entries(max_entries), max_values(max_values) {
+
+}
+
+static void append_length_prefixed(std::string& key, const std::string& value) {
+    key += std::to_string(value.size());
+    key += ':';
+    key += value;
+}
+
+std::string facet_result_cache_t::get_key(const std::vector<facet>& facets, const std::string& params,
+                                          const uint32_t* result_ids, size_t result_ids_len, bool all_documents) {
+    std::string key;
+    append_length_prefixed(key, params);
+
+    for (const auto& a_facet: facets) {
+        append_length_prefixed(key, a_facet.field_name);
+        append_length_prefixed(key, a_facet.sort_order);
+        append_length_prefixed(key, a_facet.sort_field);
+        key += a_facet.is_sort_by_alpha ? 'a' : '-';
+        key += a_facet.approximate ? 'e' : '-';
+        key += a_facet.is_range_query ? 'r' : '-';
+
+        for (const auto& range_kv: a_facet.facet_range_map) {
+            key += std::to_string(range_kv.first);
+            key += ',';
+            key += std::to_string(range_kv.second.lower_range);
+            key += ',';
+            append_length_prefixed(key, range_kv.second.range_label);
+        }
+
+        key += ';';
+    }
+
+    // the result set is not held, only its size, bounds and hash
+    key += std::to_string(result_ids_len);
+    if (all_documents) {
+        key += ":all";
+    } else if (result_ids_len != 0) {
+        key += ':';
+        key += std::to_string(result_ids[0]);
+        key += ':';
+        key += std::to_string(result_ids[result_ids_len - 1]);
+        key += ':';
+        key += std::to_string(StringUtils::hash_wy(result_ids, result_ids_len * sizeof(uint32_t)));
+    }
+
+    return key;
+}
+
+size_t facet_result_cache_t::num_facet_values(const std::vector<facet>& facets) {
+    size_t num_values = 0;
+
+    for (const auto& a_facet: facets) {
+        num_values += a_facet.result_map.size() + a_facet.value_result_map.size();
+    }
+
+    return num_values;
+}
+
+void facet_result_cache_t::copy_counts(const facet& from, facet& to) {
+    to.result_map = from.result_map;
+    to.value_result_map = from.value_result_map;
+    to.fvalue_tokens = from.fvalue_tokens;
+    to.hash_tokens = from.hash_tokens;
+    to.hash_groups = from.hash_groups;
+    to.stats = from.stats;
+    to.sampled = from.sampled;
+    to.is_intersected = from.is_intersected;
+    to.strategy_basis = from.strategy_basis;
+}
+
+void facet_result_cache_t::erase(std::list<std::pair<std::string, entry_t>>::iterator it) {
+    num_values -= it->second.num_values;
+    entry_index.erase(it->first);
+    entries.erase(it);
+}
+
+facet_result_cache_t::facets_t facet_result_cache_t::get(const std::string& key, uint64_t write_generation) {
+    std::unique_lock lock(mutex);
+
+    auto hit_it = entry_index.find(key);
+    if (hit_it == entry_index.end()) {
+        return nullptr;
+    }
+
+    if (hit_it->second->second.write_generation != write_generation) {
+        erase(hit_it->second);
+        return nullptr;
+    }
+
+    // move to the front
+    entries.splice(entries.begin(), entries, hit_it->second);
+    return hit_it->second->second.facets;
+}
+
+void facet_result_cache_t::insert(const std::string& key, uint64_t write_generation, facets_t facets) {
+    if (key.empty() || facets == nullptr) {
+        return;
+    }
+
+    const size_t facets_num_values = num_facet_values(*facets);
+    if (facets_num_values > max_values) {
+        return;
+    }
+
+    std::unique_lock lock(mutex);
+
+    auto existing_it = entry_index.find(key);
+    if (existing_it != entry_index.end()) {
+        erase(existing_it->second);
+    }
+
+    num_values += facets_num_values;
+    entries.emplace_front(key, entry_t{std::move(facets), write_generation, facets_num_values});
+    entry_index.emplace(key, entries.begin());
+
+    while (entries.size() > max_entries || num_values > max_values) {
+        erase(std::prev(entries.end()));
+    }
+}
+
+void facet_result_cache_t::clear() {
+    std::unique_lock lock(mutex);
+    entries.clear();
+    entry_index.clear();
+    num_values = 0;
+}
+
+size_t facet_result_cache_t::size() const {
+    std::unique_lock lock(mutex);
+    return entries.size();
+}
@@ -0,0 +1,85 @@
+#include "facet_value_sketch.h"
+#include <algorithm>
+#include <cmath>
+
+uint32_t facet_value_sketch_t::hash(uint32_t seq_id) {
+    // finalizer of murmur3: ids that are handed out in order get hashes that are not
+    uint32_t h = seq_id;
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+void facet_value_sketch_t::build(const std::vector<uint32_t>& seq_ids) {
+    samples.clear();
+    samples.reserve(std::min(seq_ids.size(), SAMPLE_SIZE + 1));
+
+    for(auto seq_id: seq_ids) {
+        insert(seq_id);
+    }
+}
+
+void facet_value_sketch_t::insert(uint32_t seq_id) {
+    const std::pair<uint32_t, uint32_t> sample(hash(seq_id), seq_id);
+
+    if(samples.size() == SAMPLE_SIZE && !(sample < samples.back())) {
+        return;
+    }
+
+    auto it = std::lower_bound(samples.begin(), samples.end(), sample);
+    if(it != samples.end() && *it == sample) {
+        return;
+    }
+
+    samples.insert(it, sample);
+
+    if(samples.size() > SAMPLE_SIZE) {
+        samples.pop_back();
+    }
+}
+
+bool facet_value_sketch_t::erase(uint32_t seq_id) {
+    const std::pair<uint32_t, uint32_t> sample(hash(seq_id), seq_id);
+
+    auto it = std::lower_bound(samples.begin(), samples.end(), sample);
+    if(it == samples.end() || *it != sample) {
+        return false;
+    }
+
+    samples.erase(it);
+    return true;
+}
+
+size_t facet_value_sketch_t::count_in(const uint32_t* result_ids, size_t result_ids_len) const {
+    size_t num_found = 0;
+
+    for(const auto& sample: samples) {
+        if(std::binary_search(result_ids, result_ids + result_ids_len, sample.second)) {
+            num_found++;
+        }
+    }
+
+    return num_found;
+}
+
+uint32_t facet_value_sketch_t::estimate(size_t num_ids, size_t num_samples, size_t num_sampled,
+                                        uint32_t& error_bound) {
+    if(num_samples == 0 || num_samples >= num_ids) {
+        error_bound = 0;
+        return num_sampled;
+    }
+
+    const double n = num_ids;
+    const double k = num_samples;
+    const double p = num_sampled / k;
+
+    // a sample that is all in or all out of the results still leaves room for the ids that were not sampled
+    const double p_var = (num_sampled + 0.5) / (k + 1);
+    const double std_error = n * std::sqrt(p_var * (1 - p_var) / k * (n - k) / (n - 1));
+
+    error_bound = uint32_t(std::ceil(1.96 * std_error));
+    return uint32_t(std::lround(n * p));
+}
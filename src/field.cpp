@@ -2,6 +2,8 @@
 #include "field.h"
 #include "magic_enum.hpp"
 #include "embedder_manager.h"
+#include "vector_quantizer.h"
+#include "vector_file.h"
 #include <stack>
 #include <collection_manager.h>
 #include <regex>
@@ -106,6 +108,21 @@ Option<bool> field::json_field_to_field(bool enable_nested_fields, nlohmann::jso
         field_json[fields::stem] = false;
     }
 
+    if(field_json.count(fields::exact_match_index) != 0) {
+        if(!field_json.at(fields::exact_match_index).is_boolean()) {
+            return Option<bool>(400, std::string("The `exact_match_index` property of the field `") +
+                                     field_json[fields::name].get<std::string>() + std::string("` should be a boolean."));
+        }
+
+        if(field_json[fields::exact_match_index] && field_json[fields::type] != field_types::STRING &&
+           field_json[fields::type] != field_types::STRING_ARRAY) {
+            return Option<bool>(400, std::string("The `exact_match_index` property is only allowed for string and "
+                                                 "string[] fields."));
+        }
+    } else {
+        field_json[fields::exact_match_index] = false;
+    }
+
     if (field_json.count(fields::range_index) != 0) {
         if (!field_json.at(fields::range_index).is_boolean()) {
             return Option<bool>(400, std::string("The `range_index` property of the field `") +
@@ -330,10 +347,41 @@ Option<bool> field::json_field_to_field(bool enable_nested_fields, nlohmann::jso
             return Option<bool>(400, "Property `" + fields::hnsw_params + ".M` must be a positive integer.");
         }
 
-        // remove unrelated properties except for m ef_construction and M
+        vector_quantization_t quantization;
+        if(field_json[fields::hnsw_params].count("quantization") != 0 &&
+           (!field_json[fields::hnsw_params]["quantization"].is_string() ||
+            !parse_vector_quantization(field_json[fields::hnsw_params]["quantization"].get<std::string>(), quantization))) {
+            return Option<bool>(400, "Property `" + fields::hnsw_params + ".quantization` must be one of `none`, `sq8`.");
+        }
+
+        vector_storage_t storage;
+        if(field_json[fields::hnsw_params].count("storage") != 0) {
+            if(!field_json[fields::hnsw_params]["storage"].is_string() ||
+               !parse_vector_storage(field_json[fields::hnsw_params]["storage"].get<std::string>(), storage)) {
+                return Option<bool>(400, "Property `" + fields::hnsw_params + ".storage` must be one of `memory`, `disk`.");
+            }
+
+            if(storage == disk_storage) {
+                // the graph holds the quantized vectors that are searched, the disk the float ones
+                if(field_json[fields::hnsw_params].count("quantization") == 0) {
+                    field_json[fields::hnsw_params]["quantization"] = "sq8";
+                } else if(field_json[fields::hnsw_params]["quantization"] == "none") {
+                    return Option<bool>(400, "Property `" + fields::hnsw_params + ".storage` can be `disk` only for "
+                                             "quantized vectors.");
+                }
+            }
+        }
+
+        if(field_json[fields::hnsw_params].count("vector_column") != 0 &&
+           !field_json[fields::hnsw_params]["vector_column"].is_boolean()) {
+            return Option<bool>(400, "Property `" + fields::hnsw_params + ".vector_column` must be a boolean.");
+        }
+
+        // remove unrelated properties except for m ef_construction, M, quantization, storage and vector_column
         auto it = field_json[fields::hnsw_params].begin();
         while(it != field_json[fields::hnsw_params].end()) {
-            if(it.key() != "max_elements" && it.key() != "ef_construction" && it.key() != "M" && it.key() != "ef") {
+            if(it.key() != "max_elements" && it.key() != "ef_construction" && it.key() != "M" && it.key() != "ef" &&
+               it.key() != "quantization" && it.key() != "storage" && it.key() != "vector_column") {
                 it = field_json[fields::hnsw_params].erase(it);
             } else {
                 ++it;
@@ -409,6 +457,8 @@ Option<bool> field::json_field_to_field(bool enable_nested_fields, nlohmann::jso
                   field_json[fields::store], field_json[fields::stem], field_json[fields::hnsw_params])
     );
 
+    the_fields.back().exact_match_index = field_json[fields::exact_match_index].get<bool>();
+
     if (!field_json[fields::reference].get<std::string>().empty()) {
         // Add a reference helper field in the schema. It stores the doc id of the document it references to reduce the
         // computation while searching.
@@ -422,6 +472,24 @@ Option<bool> field::json_field_to_field(bool enable_nested_fields, nlohmann::jso
     return Option<bool>(true);
 }
 
+// Dynamic field names are matched against every value of every nested object that is indexed, so their patterns are
+// compiled once per thread instead of once per match.
+static const std::regex& get_dynamic_field_regex(const std::string& pattern) {
+    static const size_t MAX_CACHED_PATTERNS = 1024;
+    thread_local std::unordered_map<std::string, std::regex> compiled_patterns;
+
+    auto pattern_it = compiled_patterns.find(pattern);
+    if(pattern_it != compiled_patterns.end()) {
+        return pattern_it->second;
+    }
+
+    if(compiled_patterns.size() >= MAX_CACHED_PATTERNS) {
+        compiled_patterns.clear();
+    }
+
+    return compiled_patterns.emplace(pattern, std::regex(pattern)).first->second;
+}
+
 bool field::flatten_obj(nlohmann::json& doc, nlohmann::json& value, bool has_array, bool has_obj_array,
                         bool is_update, const field& the_field, const std::string& flat_name,
                         const std::unordered_map<std::string, field>& dyn_fields,
@@ -464,8 +532,7 @@ bool field::flatten_obj(nlohmann::json& doc, nlohmann::json& value, bool has_arr
         }
 
         std::string detected_type;
-        bool found_dynamic_field = false;
-        field dyn_field(the_field.name, field_types::STRING, false);
+        const field* dyn_field = nullptr;
 
         for(auto dyn_field_it = dyn_fields.begin(); dyn_field_it != dyn_fields.end(); dyn_field_it++) {
             auto& dynamic_field = dyn_field_it->second;
@@ -474,14 +541,15 @@ bool field::flatten_obj(nlohmann::json& doc, nlohmann::json& value, bool has_arr
                 continue;
             }
 
-            if(std::regex_match(flat_name, std::regex(dynamic_field.name))) {
+            if(std::regex_match(flat_name, get_dynamic_field_regex(dynamic_field.name))) {
                 detected_type = dynamic_field.type;
-                found_dynamic_field = true;
-                dyn_field = dynamic_field;
+                dyn_field = &dynamic_field;
                 break;
             }
         }
 
+        const bool found_dynamic_field = (dyn_field != nullptr);
+
         if(!found_dynamic_field) {
             if(!field::get_type(value, detected_type)) {
                 return false;
@@ -499,7 +567,15 @@ bool field::flatten_obj(nlohmann::json& doc, nlohmann::json& value, bool has_arr
             doc[flat_name] = value;
         }
 
-        field flattened_field = found_dynamic_field ? dyn_field : the_field;
+        // every element of an array of objects flattens to the same field, which is only built again when the
+        // element changes its definition
+        auto flattened_it = flattened_fields.find(flat_name);
+        if(flattened_it != flattened_fields.end() && flattened_it->second.type == detected_type &&
+           flattened_it->second.nested_array == has_obj_array) {
+            return true;
+        }
+
+        field flattened_field = found_dynamic_field ? *dyn_field : the_field;
         flattened_field.name = flat_name;
         flattened_field.type = detected_type;
         flattened_field.optional = true;
@@ -508,7 +584,7 @@ bool field::flatten_obj(nlohmann::json& doc, nlohmann::json& value, bool has_arr
         int sort_op = flattened_field.sort ? 1 : -1;
         int infix_op = flattened_field.infix ? 1 : -1;
         flattened_field.set_computed_defaults(sort_op, infix_op);
-        flattened_fields[flat_name] = flattened_field;
+        flattened_fields[flat_name] = std::move(flattened_field);
     }
 
     return true;
@@ -531,7 +607,7 @@ Option<bool> field::flatten_field(nlohmann::json& doc, nlohmann::json& obj, cons
                 continue;
             }
 
-            if(std::regex_match(the_field.name, std::regex(dynamic_field.name))) {
+            if(std::regex_match(the_field.name, get_dynamic_field_regex(dynamic_field.name))) {
                 detected_type = obj.is_object() ? field_types::OBJECT : dynamic_field.type;
                 found_dynamic_field = true;
                 break;
@@ -584,11 +660,17 @@ Option<bool> field::flatten_field(nlohmann::json& doc, nlohmann::json& obj, cons
                     doc[the_field.name] = obj;
                 }
 
+                auto flattened_it = flattened_fields.find(the_field.name);
+                if(flattened_it != flattened_fields.end() && flattened_it->second.type == detected_type &&
+                   flattened_it->second.nested_array == has_obj_array) {
+                    return Option<bool>(true);
+                }
+
                 field flattened_field = the_field;
                 flattened_field.type = detected_type;
                 flattened_field.nested = (path_index > 1);
                 flattened_field.nested_array = has_obj_array;
-                flattened_fields[the_field.name] = flattened_field;
+                flattened_fields[the_field.name] = std::move(flattened_field);
             }
 
             return Option<bool>(true);
@@ -2,7 +2,9 @@
 #include <posting.h>
 #include <timsort.hpp>
 #include <stack>
+#include <mutex>
 #include "filter.h"
+#include "lru/lru.hpp"
 
 Option<bool> filter::validate_numerical_filter_value(field _field, const string &raw_value) {
     if(_field.is_int32() && !StringUtils::is_int32_t(raw_value)) {
@@ -649,10 +651,164 @@ Option<bool> toFilter(const std::string expression,
 }
 
 // https://stackoverflow.com/a/423914/11218270
+// Binds an expression whose value is a `{{name}}` placeholder, e.g. `brand:={{brands}}`, to `filter_params[name]`.
+// Array values are copied into the filter as they are, without splicing them into the expression and splitting it.
+Option<bool> toFilterWithParams(const std::string& expression,
+                                filter& filter_exp,
+                                const tsl::htrie_map<char, field>& search_schema,
+                                const Store* store,
+                                const std::string& doc_id_prefix,
+                                const nlohmann::json& filter_params) {
+    size_t found_index = expression.find(':');
+    if (found_index == std::string::npos) {
+        return Option<bool>(400, "Could not parse the filter query.");
+    }
+
+    std::string field_name = expression.substr(0, found_index);
+    StringUtils::trim(field_name);
+    std::string raw_value = expression.substr(found_index + 1);
+    StringUtils::trim(raw_value);
+
+    std::string op_str;
+    size_t value_index = 0;
+    while (value_index < raw_value.size() && (raw_value[value_index] == '=' || raw_value[value_index] == '!' ||
+                                              raw_value[value_index] == '<' || raw_value[value_index] == '>' ||
+                                              raw_value[value_index] == ' ')) {
+        if (raw_value[value_index] != ' ') {
+            op_str += raw_value[value_index];
+        }
+        value_index++;
+    }
+
+    const std::string placeholder = raw_value.substr(value_index);
+    if (placeholder.size() < 5 || placeholder.compare(0, 2, "{{") != 0 ||
+        placeholder.compare(placeholder.size() - 2, 2, "}}") != 0) {
+        return Option<bool>(400, "Error with filter field `" + field_name + "`: a filter parameter must be the "
+                                 "whole value, e.g. `" + field_name + ":={{name}}`.");
+    }
+
+    std::string param_name = placeholder.substr(2, placeholder.size() - 4);
+    StringUtils::trim(param_name);
+
+    const auto param_it = filter_params.find(param_name);
+    if (param_it == filter_params.end()) {
+        return Option<bool>(400, "Value of the filter parameter `" + param_name + "` is missing.");
+    }
+
+    const nlohmann::json& param = param_it.value();
+
+    if (!param.is_array()) {
+        std::string value_str;
+        if (param.is_string()) {
+            value_str = param.get<std::string>();
+        } else if (param.is_boolean()) {
+            value_str = param.get<bool>() ? "true" : "false";
+        } else if (param.is_number()) {
+            value_str = param.dump();
+        } else {
+            return Option<bool>(400, "Value of the filter parameter `" + param_name + "` must be a string, number, "
+                                     "boolean or an array.");
+        }
+
+        return toFilter(field_name + ":" + op_str + value_str, filter_exp, search_schema, store, doc_id_prefix);
+    }
+
+    if (!op_str.empty() && op_str != "=" && op_str != "!=" && (op_str != "!" || field_name == "id")) {
+        return Option<bool>(400, "Error with filter field `" + field_name + "`: an array filter parameter can only "
+                                 "be used with the `=` and `!=` operators.");
+    }
+
+    const bool is_not_equals = (op_str == "!=");
+
+    if (field_name == "id") {
+        filter_exp = {field_name, {}, {}};
+        filter_exp.apply_not_equals = is_not_equals;
+
+        std::string seq_id_str;
+        for (const auto& doc_id: param) {
+            if (!doc_id.is_string()) {
+                return Option<bool>(400, "Values of the filter parameter `" + param_name + "` must be strings.");
+            }
+
+            StoreStatus seq_id_status = store->get(doc_id_prefix + doc_id.get<std::string>(), seq_id_str);
+            if (seq_id_status != StoreStatus::FOUND) {
+                continue;
+            }
+
+            filter_exp.values.push_back(seq_id_str);
+            filter_exp.comparators.push_back(is_not_equals ? NOT_EQUALS : EQUALS);
+        }
+
+        return Option<bool>(true);
+    }
+
+    auto field_it = search_schema.find(field_name);
+    if (field_it == search_schema.end()) {
+        return Option<bool>(404, "Could not find a filter field named `" + field_name + "` in the schema.");
+    }
+
+    const field& _field = field_it.value();
+    filter_exp = {field_name, {}, {}};
+
+    if (op_str == "!" && !_field.is_string()) {
+        return Option<bool>(400, "Error with filter field `" + field_name + "`: an array filter parameter can only "
+                                 "be used with the `=` and `!=` operators.");
+    }
+
+    if (_field.is_integer() || _field.is_float()) {
+        for (const auto& value: param) {
+            if (!(_field.is_integer() ? value.is_number_integer() : value.is_number())) {
+                return Option<bool>(400, "Error with filter field `" + field_name + "`: values of the filter "
+                                         "parameter `" + param_name + "` must be " +
+                                         (_field.is_integer() ? "integers." : "numbers."));
+            }
+
+            filter_exp.values.push_back(value.dump());
+            filter_exp.comparators.push_back(EQUALS);
+        }
+
+        filter_exp.apply_not_equals = is_not_equals;
+    } else if (_field.is_bool()) {
+        for (const auto& value: param) {
+            if (!value.is_boolean()) {
+                return Option<bool>(400, "Values of filter field `" + field_name + "`: must be `true` or `false`.");
+            }
+
+            filter_exp.values.push_back(value.get<bool>() ? "1" : "0");
+            filter_exp.comparators.push_back(is_not_equals ? NOT_EQUALS : EQUALS);
+        }
+    } else if (_field.is_string()) {
+        if (param.empty()) {
+            return Option<bool>(400, "Error with filter field `" + field_name + "`: Filter value array cannot be "
+                                     "empty.");
+        }
+
+        for (const auto& value: param) {
+            if (!value.is_string()) {
+                return Option<bool>(400, "Error with filter field `" + field_name + "`: values of the filter "
+                                         "parameter `" + param_name + "` must be strings.");
+            }
+
+            filter_exp.values.push_back(value.get<std::string>());
+        }
+
+        NUM_COMPARATOR str_comparator = op_str.empty() || op_str == "!" ? CONTAINS :
+                                        (op_str == "=" ? EQUALS : NOT_EQUALS);
+        filter_exp.comparators.push_back(str_comparator);
+        filter_exp.apply_not_equals = (op_str == "!" || op_str == "!=");
+    } else {
+        return Option<bool>(400, "Error with filter field `" + field_name + "`: an array filter parameter is not "
+                                 "supported on this field type.");
+    }
+
+    return Option<bool>(true);
+}
+
 Option<bool> toParseTree(std::queue<std::string>& postfix, filter_node_t*& root,
                          const tsl::htrie_map<char, field>& search_schema,
                          const Store* store,
-                         const std::string& doc_id_prefix) {
+                         const std::string& doc_id_prefix,
+                         const nlohmann::json& filter_params) {
     std::stack<filter_node_t*> nodeStack;
     bool is_successful = true;
     std::string error_message;
@@ -703,7 +859,9 @@ Option<bool> toParseTree(std::queue<std::string>& postfix, filter_node_t*& root,
                 filter_exp = {expression.substr(parenthesis_index + 1, expression.size() - parenthesis_index - 2)};
                 filter_exp.referenced_collection_name = collection_name;
             } else {
-                Option<bool> toFilter_op = toFilter(expression, filter_exp, search_schema, store, doc_id_prefix);
+                Option<bool> toFilter_op = (expression.find("{{") != std::string::npos) ?
+                        toFilterWithParams(expression, filter_exp, search_schema, store, doc_id_prefix, filter_params) :
+                        toFilter(expression, filter_exp, search_schema, store, doc_id_prefix);
                 if (!toFilter_op.ok()) {
                     is_successful = false;
                     error_message = toFilter_op.error();
@@ -740,34 +898,69 @@ Option<bool> filter::parse_filter_query(const std::string& filter_query,
                                         const tsl::htrie_map<char, field>& search_schema,
                                         const Store* store,
                                         const std::string& doc_id_prefix,
-                                        filter_node_t*& root) {
+                                        filter_node_t*& root,
+                                        const nlohmann::json& filter_params) {
     auto _filter_query = filter_query;
     StringUtils::trim(_filter_query);
     if (_filter_query.empty()) {
         return Option<bool>(true);
     }
 
-    std::queue<std::string> tokens;
-    Option<bool> tokenize_op = StringUtils::tokenize_filter_query(filter_query, tokens);
-    if (!tokenize_op.ok()) {
-        return tokenize_op;
+    // postfix expressions of recently seen filters with `{{name}}` parameters, which are templates that are
+    // sent again and again with different parameter values
+    static LRU::Cache<std::string, std::shared_ptr<const std::vector<std::string>>> template_postfix_cache(256);
+    static std::mutex template_postfix_cache_mutex;
+
+    const bool is_template = (filter_query.find("{{") != std::string::npos);
+    std::shared_ptr<const std::vector<std::string>> template_postfix;
+
+    if (is_template) {
+        std::unique_lock lock(template_postfix_cache_mutex);
+        if (template_postfix_cache.contains(filter_query)) {
+            template_postfix = template_postfix_cache.lookup(filter_query);
+        }
     }
 
     std::queue<std::string> postfix;
-    Option<bool> toPostfix_op = toPostfix(tokens, postfix);
-    if (!toPostfix_op.ok()) {
-        return toPostfix_op;
-    }
 
-    if (postfix.size() > 100) {
-        return Option<bool>(400, "`filter_by` has too many operations.");
+    if (template_postfix != nullptr) {
+        for (const auto& expression: *template_postfix) {
+            postfix.push(expression);
+        }
+    } else {
+        std::queue<std::string> tokens;
+        Option<bool> tokenize_op = StringUtils::tokenize_filter_query(filter_query, tokens);
+        if (!tokenize_op.ok()) {
+            return tokenize_op;
+        }
+
+        Option<bool> toPostfix_op = toPostfix(tokens, postfix);
+        if (!toPostfix_op.ok()) {
+            return toPostfix_op;
+        }
+
+        if (postfix.size() > 100) {
+            return Option<bool>(400, "`filter_by` has too many operations.");
+        }
+
+        if (is_template) {
+            std::vector<std::string> expressions;
+            for (auto postfix_copy = postfix; !postfix_copy.empty(); postfix_copy.pop()) {
+                expressions.push_back(postfix_copy.front());
+            }
+
+            std::unique_lock lock(template_postfix_cache_mutex);
+            template_postfix_cache.insert(filter_query,
+                                          std::make_shared<const std::vector<std::string>>(std::move(expressions)));
+        }
     }
 
     Option<bool> toParseTree_op = toParseTree(postfix,
                                               root,
                                               search_schema,
                                               store,
-                                              doc_id_prefix);
+                                              doc_id_prefix,
+                                              filter_params);
     if (!toParseTree_op.ok()) {
         return toParseTree_op;
     }
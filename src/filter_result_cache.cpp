@@ -0,0 +1,138 @@
+#include "filter_result_cache.h"
+#include <algorithm>
+
+filter_result_cache_t::filter_result_cache_t(size_t max_entries, size_t max_ids):
+        max_entries(max_entries), max_ids(max_ids) {
+
+}
+
+static void append_length_prefixed(std::string& key, const std::string& value) {
+    key += std::to_string(value.size());
+    key += ':';
+    key += value;
+}
+
+std::string filter_result_cache_t::node_key(const filter_node_t* node, bool& is_cacheable) {
+    if (node == nullptr) {
+        is_cacheable = false;
+        return "";
+    }
+
+    if (node->isOperator) {
+        std::vector<std::string> operand_keys;
+        collect_operand_keys(node->left, node->filter_operator, operand_keys, is_cacheable);
+        collect_operand_keys(node->right, node->filter_operator, operand_keys, is_cacheable);
+
+        // AND and OR are commutative
+        std::sort(operand_keys.begin(), operand_keys.end());
+
+        std::string key = (node->filter_operator == AND) ? "&(" : "|(";
+        for (const auto& operand_key: operand_keys) {
+            append_length_prefixed(key, operand_key);
+        }
+        key += ')';
+
+        return key;
+    }
+
+    const filter& filter_exp = node->filter_exp;
+
+    if (!filter_exp.referenced_collection_name.empty()) {
+        // depends on the documents of another collection
+        is_cacheable = false;
+        return "";
+    }
+
+    std::string key = filter_exp.apply_not_equals ? "!" : "=";
+    append_length_prefixed(key, filter_exp.field_name);
+
+    for (const auto& comparator: filter_exp.comparators) {
+        key += std::to_string(comparator);
+        key += ',';
+    }
+
+    for (const auto& value: filter_exp.values) {
+        append_length_prefixed(key, value);
+    }
+
+    for (const auto& param: filter_exp.params) {
+        append_length_prefixed(key, param.dump());
+    }
+
+    return key;
+}
+
+void filter_result_cache_t::collect_operand_keys(const filter_node_t* node, FILTER_OPERATOR filter_operator,
+                                                 std::vector<std::string>& operand_keys, bool& is_cacheable) {
+    // operands of a chain of the same operator are flattened, so that `(a && b) && c` equals `a && (b && c)`
+    if (node != nullptr && node->isOperator && node->filter_operator == filter_operator) {
+        collect_operand_keys(node->left, filter_operator, operand_keys, is_cacheable);
+        collect_operand_keys(node->right, filter_operator, operand_keys, is_cacheable);
+        return;
+    }
+
+    operand_keys.push_back(node_key(node, is_cacheable));
+}
+
+std::string filter_result_cache_t::get_key(const filter_node_t* filter_node) {
+    bool is_cacheable = true;
+    std::string key = node_key(filter_node, is_cacheable);
+    return is_cacheable ? key : "";
+}
+
+void filter_result_cache_t::erase(std::list<std::pair<std::string, entry_t>>::iterator it) {
+    num_ids -= it->second.ids->size();
+    entry_index.erase(it->first);
+    entries.erase(it);
+}
+
+filter_result_cache_t::ids_t filter_result_cache_t::get(const std::string& key, uint64_t write_generation) {
+    std::unique_lock lock(mutex);
+
+    auto hit_it = entry_index.find(key);
+    if (hit_it == entry_index.end()) {
+        return nullptr;
+    }
+
+    if (hit_it->second->second.write_generation != write_generation) {
+        erase(hit_it->second);
+        return nullptr;
+    }
+
+    // move to the front
+    entries.splice(entries.begin(), entries, hit_it->second);
+    return hit_it->second->second.ids;
+}
+
+void filter_result_cache_t::insert(const std::string& key, uint64_t write_generation, ids_t ids) {
+    if (key.empty() || ids == nullptr || ids->size() > max_ids) {
+        return;
+    }
+
+    std::unique_lock lock(mutex);
+
+    auto existing_it = entry_index.find(key);
+    if (existing_it != entry_index.end()) {
+        erase(existing_it->second);
+    }
+
+    num_ids += ids->size();
+    entries.emplace_front(key, entry_t{std::move(ids), write_generation});
+    entry_index.emplace(key, entries.begin());
+
+    while (entries.size() > max_entries || num_ids > max_ids) {
+        erase(std::prev(entries.end()));
+    }
+}
+
+void filter_result_cache_t::clear() {
+    std::unique_lock lock(mutex);
+    entries.clear();
+    entry_index.clear();
+    num_ids = 0;
+}
+
+size_t filter_result_cache_t::size() const {
+    std::unique_lock lock(mutex);
+    return entries.size();
+}
@@ -4,6 +4,7 @@
 #include <s2/s2point.h>
 #include <s2/s2latlng.h>
 #include <s2/s2region_term_indexer.h>
+#include <s2/s2region_coverer.h>
 #include <s2/s2cap.h>
 #include <s2/s2earth.h>
 #include <s2/s2loop.h>
@@ -47,6 +48,11 @@ void filter_result_t::and_filter_results(const filter_result_t& a, const filter_
 
     result.docs = new uint32_t[std::min(lenA, lenB)];
 
+    if (a.coll_to_references == nullptr && b.coll_to_references == nullptr) {
+        result.count = ArrayUtils::and_simd(a.docs, lenA, b.docs, lenB, result.docs);
+        return;
+    }
+
     auto A = a.docs, B = b.docs, out = result.docs;
     const uint32_t *endA = A + lenA;
     const uint32_t *endB = B + lenB;
@@ -113,6 +119,27 @@ void filter_result_t::or_filter_results(const filter_result_t& a, const filter_r
     size_t indexA = 0, indexB = 0, res_index = 0, lenA = a.count, lenB = b.count;
     result.docs = new uint32_t[lenA + lenB];
 
+    const uint32_t min_id = std::min(a.docs[0], b.docs[0]);
+    const uint32_t max_id = std::max(a.docs[lenA - 1], b.docs[lenB - 1]);
+
+    if (a.coll_to_references == nullptr && b.coll_to_references == nullptr) {
+        // Dense results (e.g. from `in_stock:true`) are cheaper to union through a bitmap than through a merge.
+        res_index = (max_id - min_id < DENSE_UNION_MAX_RANGE_FACTOR * (lenA + lenB)) ?
+                    ArrayUtils::or_bitmap(a.docs, lenA, b.docs, lenB, result.docs) :
+                    ArrayUtils::or_simd(a.docs, lenA, b.docs, lenB, result.docs);
+        result.count = res_index;
+
+        if (res_index < lenA + lenB) {
+            // shrink fit
+            auto out = new uint32_t[res_index];
+            memcpy(out, result.docs, res_index * sizeof(uint32_t));
+            delete[] result.docs;
+            result.docs = out;
+        }
+
+        return;
+    }
+
     if (a.coll_to_references != nullptr || b.coll_to_references != nullptr) {
         result.coll_to_references = new std::map<std::string, reference_filter_result_t>[lenA + lenB] {};
     }
@@ -629,13 +656,24 @@ void filter_result_iterator_t::init() {
         return;
     }
 
+    if (load_cached_filter_result()) {
+        return;
+    }
+
     if (filter_node->isOperator) {
+        left_it = new filter_result_iterator_t(collection_name, index, filter_node->left);
+        right_it = new filter_result_iterator_t(collection_name, index, filter_node->right);
+
         if (filter_node->filter_operator == AND) {
             and_filter_iterators();
             approx_filter_ids_length = std::min(left_it->approx_filter_ids_length, right_it->approx_filter_ids_length);
         } else {
             or_filter_iterators();
-            approx_filter_ids_length = std::max(left_it->approx_filter_ids_length, right_it->approx_filter_ids_length);
+            // Either side might match ids not matched by the other.
+            approx_filter_ids_length = left_it->approx_filter_ids_length + right_it->approx_filter_ids_length;
+            if (index != nullptr && index->seq_ids != nullptr) {
+                approx_filter_ids_length = std::min<size_t>(approx_filter_ids_length, index->seq_ids->num_ids());
+            }
         }
 
         // Rearranging the subtree in hope to reduce computation if/when compute_iterators() is called.
@@ -1082,15 +1120,32 @@ void filter_result_iterator_t::init() {
                 continue;
             }
 
-            // `geo_result_ids` will contain all IDs that are within approximately within query radius
-            // we still need to do another round of exact filtering on them
+            // `geo_result_ids` will contain all IDs that are within approximately within query radius.
+            // IDs of points that fall inside a cell of the interior covering are certainly within the region,
+            // so only the IDs found in the boundary cells need another round of exact filtering.
+            std::vector<uint64_t> interior_cell_ids;
+            std::vector<S2CellId> interior_covering;
+            S2RegionCoverer coverer(options);
+            coverer.GetInteriorCovering(*query_region, &interior_covering);
+            for (const auto& cell: interior_covering) {
+                interior_cell_ids.push_back(cell.id());
+            }
+
+            std::vector<uint32_t> interior_geo_result_ids;
+            if (!interior_cell_ids.empty()) {
+                geo_range_index->search_geopoints(interior_cell_ids, interior_geo_result_ids);
+            }
 
             std::vector<uint32_t> exact_geo_result_ids;
+            std::vector<uint32_t> boundary_geo_result_ids;
+            std::set_difference(geo_result_ids.begin(), geo_result_ids.end(),
+                                interior_geo_result_ids.begin(), interior_geo_result_ids.end(),
+                                std::back_inserter(boundary_geo_result_ids));
 
             if (f.is_single_geopoint()) {
                 auto sort_field_index = index->sort_index.at(f.name);
 
-                for (auto result_id : geo_result_ids) {
+                for (auto result_id : boundary_geo_result_ids) {
                     // no need to check for existence of `result_id` because of indexer based pre-filtering above
                     int64_t lat_lng = sort_field_index->at(result_id);
                     S2LatLng s2_lat_lng;
@@ -1102,7 +1157,7 @@ void filter_result_iterator_t::init() {
             } else {
                 spp::sparse_hash_map<uint32_t, int64_t*>* geo_field_index = index->geo_array_index.at(f.name);
 
-                for (auto result_id : geo_result_ids) {
+                for (auto result_id : boundary_geo_result_ids) {
                     int64_t* lat_lngs = geo_field_index->at(result_id);
 
                     bool point_found = false;
@@ -1124,6 +1179,14 @@ void filter_result_iterator_t::init() {
                 }
             }
 
+            if (!interior_geo_result_ids.empty()) {
+                std::vector<uint32_t> boundary_matches;
+                boundary_matches.swap(exact_geo_result_ids);
+                std::set_union(interior_geo_result_ids.begin(), interior_geo_result_ids.end(),
+                               boundary_matches.begin(), boundary_matches.end(),
+                               std::back_inserter(exact_geo_result_ids));
+            }
+
             uint32_t* out = nullptr;
             filter_result.count = ArrayUtils::or_scalar(&exact_geo_result_ids[0], exact_geo_result_ids.size(),
                                                         filter_result.docs, filter_result.count, &out);
@@ -1212,7 +1275,7 @@ void filter_result_iterator_t::init() {
                 size_t max_candidates = 4;
                 size_t min_len_1typo = 0;
                 size_t min_len_2typo = 0;
-                std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> field_values{};
+                std::array<sort_column_t*, 3> field_values{};
                 const std::vector<size_t> geopoint_indices;
 
                 auto fuzzy_search_fields_op = index->fuzzy_search_fields(fq_fields, value_tokens, {}, text_match_type_t::max_score,
@@ -1506,7 +1569,7 @@ int filter_result_iterator_t::is_valid(uint32_t id) {
 }
 
 Option<bool> filter_result_iterator_t::init_status() {
-    if (filter_node != nullptr && filter_node->isOperator) {
+    if (filter_node != nullptr && filter_node->isOperator && left_it != nullptr) {
         auto left_status = left_it->init_status();
 
         return !left_status.ok() ? left_status : right_it->init_status();
@@ -1776,12 +1839,7 @@ filter_result_iterator_t::filter_result_iterator_t(const std::string& collection
         timeout_info = std::make_unique<filter_result_iterator_timeout_info>(search_begin, search_stop);
     }
 
-    // Generate the iterator tree and then initialize each node.
-    if (filter_node->isOperator) {
-        left_it = new filter_result_iterator_t(collection_name, index, filter_node->left);
-        right_it = new filter_result_iterator_t(collection_name, index, filter_node->right);
-    }
-
+    // Generate the iterator tree (unless the result is cached) and then initialize each node.
     init();
 
     if (!validity) {
@@ -1828,6 +1886,7 @@ filter_result_iterator_t& filter_result_iterator_t::operator=(filter_result_iter
     result_index = obj.result_index;
 
     filter_result = std::move(obj.filter_result);
+    cache_key = std::move(obj.cache_key);
 
     posting_list_iterators = std::move(obj.posting_list_iterators);
     expanded_plists = std::move(obj.expanded_plists);
@@ -2010,19 +2069,28 @@ void filter_result_iterator_t::compute_iterators() {
     }
 
     if (is_filter_result_initialized) {
+        cache_filter_result();
         return;
     }
 
     if (filter_node->isOperator) {
+        // `init()` places the subtree with the smaller estimate on the left.
         left_it->compute_iterators();
-        right_it->compute_iterators();
 
-        if (filter_node->filter_operator == AND) {
-            filter_result_t::and_filter_results(left_it->filter_result, right_it->filter_result, filter_result);
+        if (filter_node->filter_operator == AND && should_probe_right_subtree()) {
+            probe_right_subtree(left_it->filter_result, filter_result);
         } else {
-            filter_result_t::or_filter_results(left_it->filter_result, right_it->filter_result, filter_result);
+            right_it->compute_iterators();
+
+            if (filter_node->filter_operator == AND) {
+                filter_result_t::and_filter_results(left_it->filter_result, right_it->filter_result, filter_result);
+            } else {
+                filter_result_t::or_filter_results(left_it->filter_result, right_it->filter_result, filter_result);
+            }
         }
 
+        cache_filter_result();
+
         // In a complex filter query a sub-expression might not match any document while the full expression does match
         // at least one document. If the full expression doesn't match any document, we return early in the search.
         if (filter_result.count == 0) {
@@ -2075,6 +2143,19 @@ void filter_result_iterator_t::compute_iterators() {
         // aggregates IDs across array of filter values and reduces excessive ORing
         std::vector<uint32_t> f_id_buff;
 
+        // When the union is expected to cover a good share of the collection, the IDs are set in a bitmap of all the
+        // seq ids instead, which needs no sorting.
+        const uint32_t max_seq_id = index->seq_ids->num_ids() == 0 ? 0 : index->seq_ids->last_id();
+        const bool use_id_bitmap = posting_lists.size() > 1 &&
+                                   uint64_t(approx_filter_ids_length) * 32 >= uint64_t(max_seq_id) + 1;
+        std::vector<uint64_t> id_bitmap(use_id_bitmap ? (max_seq_id / 64 + 1) : 0, 0);
+
+        auto set_id_bits = [&](const uint32_t* ids, size_t ids_length) {
+            for (size_t i = 0; i < ids_length && ids[i] <= max_seq_id; i++) {
+                id_bitmap[ids[i] / 64] |= (uint64_t(1) << (ids[i] % 64));
+            }
+        };
+
         for (uint32_t i = 0; i < posting_lists.size(); i++) {
             auto& p_list = posting_lists[i];
             if (a_filter.comparators[0] == EQUALS || a_filter.comparators[0] == NOT_EQUALS) {
@@ -2099,6 +2180,11 @@ void filter_result_iterator_t::compute_iterators() {
                     continue;
                 }
 
+                if (use_id_bitmap) {
+                    set_id_bits(exact_str_ids, exact_str_ids_size);
+                    continue;
+                }
+
                 for (size_t ei = 0; ei < exact_str_ids_size; ei++) {
                     f_id_buff.push_back(exact_str_ids[ei]);
                 }
@@ -2109,6 +2195,12 @@ void filter_result_iterator_t::compute_iterators() {
                 if (f_id_buff.size() == before_size) {
                     continue;
                 }
+
+                if (use_id_bitmap) {
+                    set_id_bits(f_id_buff.data(), f_id_buff.size());
+                    f_id_buff.clear();
+                    continue;
+                }
             }
 
             if (f_id_buff.size() > 100000 || a_filter.values.size() == 1) {
@@ -2134,6 +2226,10 @@ void filter_result_iterator_t::compute_iterators() {
             std::vector<uint32_t>().swap(f_id_buff);  // clears out memory
         }
 
+        if (use_id_bitmap) {
+            or_ids_size = ArrayUtils::bitmap_to_array(id_bitmap.data(), id_bitmap.size(), 0, &or_ids);
+        }
+
         filter_result.docs = or_ids;
         filter_result.count = or_ids_size;
 
@@ -2142,6 +2238,8 @@ void filter_result_iterator_t::compute_iterators() {
         }
     }
 
+    cache_filter_result();
+
     if (filter_result.count == 0) {
         validity = invalid;
         return;
@@ -2153,6 +2251,117 @@ void filter_result_iterator_t::compute_iterators() {
     approx_filter_ids_length = filter_result.count;
 }
 
+nlohmann::json filter_result_iterator_t::get_plan() const {
+    nlohmann::json plan = nlohmann::json::object();
+    if (filter_node == nullptr) {
+        return plan;
+    }
+
+    if (filter_node->isOperator) {
+        plan["operator"] = (filter_node->filter_operator == AND) ? "AND" : "OR";
+    } else if (!filter_node->filter_exp.referenced_collection_name.empty()) {
+        plan["field"] = "$" + filter_node->filter_exp.referenced_collection_name;
+    } else {
+        plan["field"] = filter_node->filter_exp.field_name;
+    }
+
+    plan["approx_ids"] = approx_filter_ids_length;
+    plan["materialized"] = is_filter_result_initialized;
+
+    if (left_it != nullptr && right_it != nullptr) {
+        plan["children"] = nlohmann::json::array({left_it->get_plan(), right_it->get_plan()});
+    }
+
+    return plan;
+}
+
+static bool contains_reference_filter(const filter_node_t* filter_node) {
+    if (filter_node == nullptr) {
+        return false;
+    }
+
+    if (filter_node->isOperator) {
+        return contains_reference_filter(filter_node->left) || contains_reference_filter(filter_node->right);
+    }
+
+    return !filter_node->filter_exp.referenced_collection_name.empty();
+}
+
+bool filter_result_iterator_t::should_probe_right_subtree() const {
+    if (right_it->is_filter_result_initialized || right_it->validity != valid ||
+        left_it->filter_result.coll_to_references != nullptr || contains_reference_filter(right_it->filter_node)) {
+        return false;
+    }
+
+    // Materializing the right subtree costs about as much as the ids it matches, while probing it costs a `skip_to`
+    // per id of the left side.
+    return right_it->approx_filter_ids_length / lazy_and_min_ratio > left_it->filter_result.count;
+}
+
+void filter_result_iterator_t::probe_right_subtree(const filter_result_t& left_result, filter_result_t& result) {
+    result.count = 0;
+    if (left_result.count == 0) {
+        return;
+    }
+
+    result.docs = new uint32_t[left_result.count];
+    for (uint32_t i = 0; i < left_result.count && right_it->validity == valid; i++) {
+        const auto& id = left_result.docs[i];
+        right_it->skip_to(id);
+
+        if (right_it->validity == valid && right_it->seq_id == id) {
+            result.docs[result.count++] = id;
+        }
+    }
+}
+
+bool filter_result_iterator_t::load_cached_filter_result() {
+    if (index == nullptr) {
+        return false;
+    }
+
+    cache_key = filter_result_cache_t::get_key(filter_node);
+    if (cache_key.empty()) {
+        return false;
+    }
+
+    auto cached_ids = index->filter_result_cache.get(cache_key, index->write_generation);
+    if (cached_ids == nullptr) {
+        return false;
+    }
+
+    // no need to cache it again
+    cache_key.clear();
+
+    filter_result.count = cached_ids->size();
+    filter_result.docs = new uint32_t[filter_result.count];
+    std::copy(cached_ids->begin(), cached_ids->end(), filter_result.docs);
+
+    is_filter_result_initialized = true;
+    approx_filter_ids_length = filter_result.count;
+
+    if (filter_result.count == 0) {
+        validity = invalid;
+        return true;
+    }
+
+    result_index = 0;
+    seq_id = filter_result.docs[result_index];
+    return true;
+}
+
+void filter_result_iterator_t::cache_filter_result() {
+    // a timed out result may be partial and the references of joined documents are not cached
+    if (cache_key.empty() || validity == timed_out || filter_result.coll_to_references != nullptr) {
+        return;
+    }
+
+    auto ids = std::make_shared<std::vector<uint32_t>>(filter_result.docs,
+                                                       filter_result.docs + filter_result.count);
+    index->filter_result_cache.insert(cache_key, index->write_generation, std::move(ids));
+    cache_key.clear();
+}
+
 bool filter_result_iterator_t::is_timed_out() {
     if (validity == timed_out ||
         (++(timeout_info->function_call_counter) % function_call_modulo == 0 && (std::chrono::duration_cast<std::chrono::microseconds>(
@@ -0,0 +1,145 @@
+#include "gpu_vector_scorer.h"
+#include <dlfcn.h>
+#include <string>
+#include <vector>
+#include "logger.h"
+
+// values of the CUDA and cuBLAS enums that are used, so that their headers are not needed for the build
+static constexpr int CUDA_SUCCESS = 0;
+static constexpr int CUDA_MEMCPY_HOST_TO_DEVICE = 1;
+static constexpr int CUDA_MEMCPY_DEVICE_TO_HOST = 2;
+static constexpr int CUBLAS_STATUS_SUCCESS = 0;
+static constexpr int CUBLAS_OP_N = 0;
+static constexpr int CUBLAS_OP_T = 1;
+
+static void* open_library(const std::vector<std::string>& names) {
+    for(const auto& name: names) {
+        void* lib = dlopen(name.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if(lib != nullptr) {
+            return lib;
+        }
+    }
+
+    return nullptr;
+}
+
+Option<bool> GpuVectorScorer::init() {
+    std::unique_lock lock(mutex);
+
+    if(available) {
+        return Option<bool>(true);
+    }
+
+    cudart_lib = open_library({"libcudart.so", "libcudart.so.12", "libcudart.so.11.0"});
+    cublas_lib = open_library({"libcublas.so", "libcublas.so.12", "libcublas.so.11"});
+
+    if(cudart_lib == nullptr || cublas_lib == nullptr) {
+        return Option<bool>(404, "Could not load the CUDA runtime and cuBLAS libraries.");
+    }
+
+    cuda_malloc = reinterpret_cast<cuda_malloc_t>(dlsym(cudart_lib, "cudaMalloc"));
+    cuda_free = reinterpret_cast<cuda_free_t>(dlsym(cudart_lib, "cudaFree"));
+    cuda_memcpy = reinterpret_cast<cuda_memcpy_t>(dlsym(cudart_lib, "cudaMemcpy"));
+    auto cuda_get_device_count = reinterpret_cast<cuda_get_device_count_t>(dlsym(cudart_lib, "cudaGetDeviceCount"));
+    auto cublas_create = reinterpret_cast<cublas_create_t>(dlsym(cublas_lib, "cublasCreate_v2"));
+    cublas_destroy = reinterpret_cast<cublas_destroy_t>(dlsym(cublas_lib, "cublasDestroy_v2"));
+    cublas_sgemm = reinterpret_cast<cublas_sgemm_t>(dlsym(cublas_lib, "cublasSgemm_v2"));
+
+    if(cuda_malloc == nullptr || cuda_free == nullptr || cuda_memcpy == nullptr || cuda_get_device_count == nullptr ||
+       cublas_create == nullptr || cublas_destroy == nullptr || cublas_sgemm == nullptr) {
+        return Option<bool>(500, "Could not find the CUDA and cuBLAS functions.");
+    }
+
+    int num_devices = 0;
+    if(cuda_get_device_count(&num_devices) != CUDA_SUCCESS || num_devices == 0) {
+        return Option<bool>(404, "No CUDA device was found.");
+    }
+
+    if(cublas_create(&cublas_handle) != CUBLAS_STATUS_SUCCESS) {
+        cublas_handle = nullptr;
+        return Option<bool>(500, "Could not create a cuBLAS handle.");
+    }
+
+    available = true;
+    return Option<bool>(true);
+}
+
+bool GpuVectorScorer::reserve(float*& buffer, size_t& capacity, size_t size) {
+    if(size <= capacity) {
+        return true;
+    }
+
+    if(buffer != nullptr) {
+        cuda_free(buffer);
+        buffer = nullptr;
+        capacity = 0;
+    }
+
+    if(cuda_malloc(reinterpret_cast<void**>(&buffer), size * sizeof(float)) != CUDA_SUCCESS) {
+        buffer = nullptr;
+        return false;
+    }
+
+    capacity = size;
+    return true;
+}
+
+bool GpuVectorScorer::inner_products(const float* queries, size_t num_queries, const float* rows, size_t num_rows,
+                                     size_t num_dim, float* products) {
+    std::unique_lock lock(mutex);
+
+    if(!available) {
+        return false;
+    }
+
+    if(!reserve(device_queries, queries_capacity, num_queries * num_dim) ||
+       !reserve(device_rows, rows_capacity, num_rows * num_dim) ||
+       !reserve(device_products, products_capacity, num_queries * num_rows)) {
+        LOG(ERROR) << "Could not allocate the device memory of " << num_rows << " vectors.";
+        return false;
+    }
+
+    if(cuda_memcpy(device_queries, queries, num_queries * num_dim * sizeof(float),
+                   CUDA_MEMCPY_HOST_TO_DEVICE) != CUDA_SUCCESS ||
+       cuda_memcpy(device_rows, rows, num_rows * num_dim * sizeof(float), CUDA_MEMCPY_HOST_TO_DEVICE) != CUDA_SUCCESS) {
+        LOG(ERROR) << "Could not copy vectors to the device.";
+        return false;
+    }
+
+    // In column major order, the rows are a (num_dim x num_rows) matrix and the queries a (num_dim x num_queries)
+    // one, so that queries^T * rows is the (num_queries x num_rows) matrix of the products, laid out row by row.
+    const float alpha = 1.0f, beta = 0.0f;
+    if(cublas_sgemm(cublas_handle, CUBLAS_OP_T, CUBLAS_OP_N, num_queries, num_rows, num_dim, &alpha,
+                    device_queries, num_dim, device_rows, num_dim, &beta, device_products,
+                    num_queries) != CUBLAS_STATUS_SUCCESS) {
+        LOG(ERROR) << "Could not multiply vectors on the device.";
+        return false;
+    }
+
+    if(cuda_memcpy(products, device_products, num_queries * num_rows * sizeof(float),
+                   CUDA_MEMCPY_DEVICE_TO_HOST) != CUDA_SUCCESS) {
+        LOG(ERROR) << "Could not copy the products of vectors from the device.";
+        return false;
+    }
+
+    return true;
+}
+
+void GpuVectorScorer::dispose() {
+    std::unique_lock lock(mutex);
+
+    if(!available) {
+        return ;
+    }
+
+    available = false;
+
+    cuda_free(device_queries);
+    cuda_free(device_rows);
+    cuda_free(device_products);
+    device_queries = device_rows = device_products = nullptr;
+    queries_capacity = rows_capacity = products_capacity = 0;
+
+    cublas_destroy(cublas_handle);
+    cublas_handle = nullptr;
+}
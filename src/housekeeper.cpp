@@ -1,62 +1,214 @@
+#include <algorithm>
 #include <collection_manager.h>
 #include "housekeeper.h"
+#include "memory_arenas.h"
 
-void HouseKeeper::run() {
-    uint64_t prev_hnsw_repair_s = std::chrono::duration_cast<std::chrono::seconds>(
+static uint64_t get_now_s() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
             std::chrono::system_clock::now().time_since_epoch()).count();
+}
 
-    uint64_t prev_db_compaction_s = std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
+// Runs `fn` on the collections from the one where the previous run stopped, so that the collections at the end of
+// the list are not starved when runs keep stopping early. At least one collection is done in every run.
+static void for_each_collection(housekeeping_ctx_t& ctx, size_t& next_coll_index,
+                                const std::function<void(Collection*)>& fn) {
+    auto coll_names = CollectionManager::get_instance().get_collection_names();
+    if(next_coll_index >= coll_names.size()) {
+        next_coll_index = 0;
+    }
+
+    while(next_coll_index < coll_names.size()) {
+        auto coll = CollectionManager::get_instance().get_collection(coll_names[next_coll_index]);
+        if(coll != nullptr) {
+            fn(coll.get());
+        }
+
+        next_coll_index++;
+        ctx.set_progress(next_coll_index, coll_names.size());
+
+        if(next_coll_index < coll_names.size() && ctx.should_stop()) {
+            ctx.set_unfinished();
+            return ;
+        }
+    }
 
+    next_coll_index = 0;
+}
+
+static std::string priority_name(housekeeping_task_t::priority_t priority) {
+    switch(priority) {
+        case housekeeping_task_t::HIGH:
+            return "high";
+        case housekeeping_task_t::LOW:
+            return "low";
+        default:
+            return "normal";
+    }
+}
+
+void HouseKeeper::run() {
     while(!quit) {
         std::unique_lock lk(mutex);
-        cv.wait_for(lk, std::chrono::seconds(60), [&] { return quit.load(); });
+        cv.wait_for(lk, std::chrono::seconds(PASS_INTERVAL_S), [&] { return quit.load(); });
 
         if(quit) {
             lk.unlock();
             break;
         }
 
-        auto now_ts_seconds = std::chrono::duration_cast<std::chrono::seconds>(
-                std::chrono::system_clock::now().time_since_epoch()).count();
-
-        // perform compaction on underlying store if enabled
-        if(Config::get_instance().get_db_compaction_interval() > 0) {
-            if(now_ts_seconds - prev_db_compaction_s >= Config::get_instance().get_db_compaction_interval()) {
-                LOG(INFO) << "Starting DB compaction.";
-                CollectionManager::get_instance().get_store()->compact_all();
-                LOG(INFO) << "Finished DB compaction.";
-                prev_db_compaction_s = std::chrono::duration_cast<std::chrono::seconds>(
-                        std::chrono::system_clock::now().time_since_epoch()).count();
+        lk.unlock();
+        run_due_tasks(get_now_s(), Config::get_instance().get_housekeeping_budget_ms());
+    }
+}
+
+size_t HouseKeeper::run_due_tasks(uint64_t now_s, uint64_t budget_ms) {
+    std::vector<std::shared_ptr<housekeeping_task_t>> due_tasks;
+
+    {
+        std::unique_lock lock(tasks_mutex);
+        for(const auto& task: tasks) {
+            const uint32_t interval_s = task->get_interval_s();
+            if(interval_s != 0 && now_s >= task->last_run_s + interval_s) {
+                due_tasks.push_back(task);
             }
         }
 
-        /*if(now_ts_seconds - prev_hnsw_repair_s >= hnsw_repair_interval_s) {
-            // iterate through all collections and repair all hnsw graphs (if any)
-            auto coll_names = CollectionManager::get_instance().get_collection_names();
+        // tasks left over by the previous pass go first, so that low priority tasks are not starved, and then
+        // those that have waited the longest within a priority
+        std::stable_sort(due_tasks.begin(), due_tasks.end(), [](const auto& a, const auto& b) {
+            if(a->deferred != b->deferred) {
+                return a->deferred;
+            }
 
-            for(auto& coll_name: coll_names) {
-                auto coll = CollectionManager::get_instance().get_collection(coll_name);
-                if(coll == nullptr) {
-                    continue;
-                }
+            return a->priority < b->priority || (a->priority == b->priority && a->last_run_s < b->last_run_s);
+        });
+    }
 
-                coll->do_housekeeping();
-            }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(budget_ms);
+    size_t num_run = 0;
 
-            if(!coll_names.empty()) {
-                LOG(INFO) << "Ran housekeeping for " << coll_names.size() << " collections.";
-            }
+    for(const auto& task: due_tasks) {
+        if(quit) {
+            break;
+        }
 
-            //do housekeeping for authmanager
-            CollectionManager::get_instance().getAuthManager().do_housekeeping();
+        // the first due task always runs, so that a pass makes progress however small its budget
+        if(num_run != 0 && std::chrono::steady_clock::now() >= deadline) {
+            std::unique_lock lock(tasks_mutex);
+            task->num_deferred++;
+            task->deferred = true;
+            continue;
+        }
 
-            prev_hnsw_repair_s = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::system_clock::now().time_since_epoch()).count();
-        }*/
+        run_task(*task, now_s, deadline);
+        num_run++;
+    }
 
-        lk.unlock();
+    return num_run;
+}
+
+void HouseKeeper::run_task(housekeeping_task_t& task, uint64_t now_s, std::chrono::steady_clock::time_point deadline) {
+    {
+        std::unique_lock lock(tasks_mutex);
+        task.running = true;
+        task.deferred = false;
+        task.cancel_requested = false;
+        task.progress_done = task.progress_total = 0;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    housekeeping_ctx_t ctx(task, quit, deadline, tasks_mutex);
+
+    try {
+        task.run(ctx);
+    } catch(const std::exception& e) {
+        LOG(ERROR) << "Housekeeping task " << task.name << " failed: " << e.what();
+        ctx.set_result(std::string("Error: ") + e.what());
+    }
+
+    std::unique_lock lock(tasks_mutex);
+    task.running = false;
+
+    // a run that stopped with work left is not done: it's resumed first on the next pass
+    if(ctx.is_unfinished() && !task.cancel_requested) {
+        task.num_deferred++;
+        task.deferred = true;
+    } else {
+        task.last_run_s = now_s;
     }
+
+    task.last_duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::steady_clock::now() - start).count();
+    task.num_runs++;
+
+    if(task.cancel_requested) {
+        task.num_cancelled++;
+        task.cancel_requested = false;
+    }
+}
+
+void HouseKeeper::add_task(const std::shared_ptr<housekeeping_task_t>& task) {
+    std::unique_lock lock(tasks_mutex);
+    task->last_run_s = get_now_s();
+
+    for(auto& existing_task: tasks) {
+        if(existing_task->name == task->name) {
+            existing_task = task;
+            return ;
+        }
+    }
+
+    tasks.push_back(task);
+}
+
+void HouseKeeper::remove_task(const std::string& name) {
+    std::unique_lock lock(tasks_mutex);
+    tasks.erase(std::remove_if(tasks.begin(), tasks.end(), [&](const auto& task) {
+        return task->name == name;
+    }), tasks.end());
+}
+
+Option<bool> HouseKeeper::cancel_task(const std::string& name) {
+    std::unique_lock lock(tasks_mutex);
+
+    for(const auto& task: tasks) {
+        if(task->name != name) {
+            continue;
+        }
+
+        if(!task->running) {
+            return Option<bool>(409, "Task `" + name + "` is not running.");
+        }
+
+        task->cancel_requested = true;
+        return Option<bool>(true);
+    }
+
+    return Option<bool>(404, "Task `" + name + "` not found.");
+}
+
+nlohmann::json HouseKeeper::get_tasks_json() const {
+    nlohmann::json tasks_json = nlohmann::json::array();
+    std::unique_lock lock(tasks_mutex);
+
+    for(const auto& task: tasks) {
+        nlohmann::json task_json;
+        task_json["name"] = task->name;
+        task_json["priority"] = priority_name(task->priority);
+        task_json["interval_s"] = task->get_interval_s();
+        task_json["running"] = task->running;
+        task_json["last_run_at"] = task->last_run_s;
+        task_json["last_duration_ms"] = task->last_duration_ms;
+        task_json["num_runs"] = task->num_runs;
+        task_json["num_cancelled"] = task->num_cancelled;
+        task_json["num_deferred"] = task->num_deferred;
+        task_json["progress"]["done"] = task->progress_done;
+        task_json["progress"]["total"] = task->progress_total;
+        task_json["last_result"] = task->last_result;
+        tasks_json.push_back(task_json);
+    }
+
+    return tasks_json;
 }
 
 void HouseKeeper::stop() {
@@ -66,4 +218,85 @@ void HouseKeeper::stop() {
 
 void HouseKeeper::init(uint32_t interval_seconds) {
     this->hnsw_repair_interval_s = interval_seconds;
+
+    // unindex the documents deleted since the last run
+    auto purge_task = std::make_shared<housekeeping_task_t>();
+    purge_task->name = "purge_deleted_docs";
+    purge_task->priority = housekeeping_task_t::HIGH;
+    purge_task->get_interval_s = []() { return PASS_INTERVAL_S; };
+    purge_task->run = [next_coll_index = size_t(0)](housekeeping_ctx_t& ctx) mutable {
+        size_t num_purged = 0;
+        for_each_collection(ctx, next_coll_index, [&](Collection* coll) {
+            num_purged += coll->purge_deleted_docs();
+        });
+
+        if(num_purged != 0) {
+            LOG(INFO) << "Purged " << num_purged << " deleted documents from the indices.";
+        }
+
+        ctx.set_result("Purged " + std::to_string(num_purged) + " documents.");
+    };
+    add_task(purge_task);
+
+    auto eviction_task = std::make_shared<housekeeping_task_t>();
+    eviction_task->name = "evict_idle_collections";
+    eviction_task->get_interval_s = []() {
+        return Config::get_instance().get_collection_idle_eviction_secs() == 0 ? 0 : PASS_INTERVAL_S;
+    };
+    eviction_task->run = [](housekeeping_ctx_t& ctx) {
+        size_t num_evicted = CollectionManager::get_instance().evict_idle_collections(
+                Config::get_instance().get_collection_idle_eviction_secs(),
+                Config::get_instance().get_collection_restore_budget_ms());
+        if(num_evicted != 0) {
+            LOG(INFO) << "Evicted " << num_evicted << " idle collections from memory.";
+        }
+
+        ctx.set_result("Evicted " + std::to_string(num_evicted) + " collections.");
+    };
+    add_task(eviction_task);
+
+    // return the pages freed by large deletes, without waiting for them to decay
+    auto memory_purge_task = std::make_shared<housekeeping_task_t>();
+    memory_purge_task->name = "purge_freed_memory";
+    memory_purge_task->get_interval_s = []() { return PASS_INTERVAL_S; };
+    memory_purge_task->run = [](housekeeping_ctx_t& ctx) {
+        if(MemoryArenas::get_instance().purge_if_requested()) {
+            LOG(INFO) << "Purged the memory freed by deletes.";
+        }
+    };
+    add_task(memory_purge_task);
+
+    // rebuild vector graphs that are held up by deleted points
+    auto vector_compaction_task = std::make_shared<housekeeping_task_t>();
+    vector_compaction_task->name = "compact_vector_indices";
+    vector_compaction_task->priority = housekeeping_task_t::LOW;
+    vector_compaction_task->get_interval_s = [this]() { return hnsw_repair_interval_s.load(); };
+    vector_compaction_task->run = [next_coll_index = size_t(0)](housekeeping_ctx_t& ctx) mutable {
+        size_t num_compacted = 0;
+        for_each_collection(ctx, next_coll_index, [&](Collection* coll) {
+            num_compacted += coll->compact_vector_indices();
+        });
+
+        if(num_compacted != 0) {
+            LOG(INFO) << "Compacted " << num_compacted << " vector indices.";
+        }
+
+        ctx.set_result("Compacted " + std::to_string(num_compacted) + " vector indices.");
+    };
+    add_task(vector_compaction_task);
+
+    // perform compaction on underlying store if enabled
+    auto db_compaction_task = std::make_shared<housekeeping_task_t>();
+    db_compaction_task->name = "compact_db";
+    db_compaction_task->priority = housekeeping_task_t::LOW;
+    db_compaction_task->get_interval_s = []() {
+        return uint32_t(Config::get_instance().get_db_compaction_interval());
+    };
+    db_compaction_task->run = [](housekeeping_ctx_t& ctx) {
+        LOG(INFO) << "Starting DB compaction.";
+        rocksdb::Status status = CollectionManager::get_instance().get_store()->compact_all();
+        LOG(INFO) << "Finished DB compaction.";
+        ctx.set_result(status.ok() ? "Compacted the store." : status.ToString());
+    };
+    add_task(db_compaction_task);
 }
@@ -2,10 +2,24 @@
 #include "file_utils.h"
 #include "logger.h"
 #include <vector>
+#include <mutex>
 #include <json.hpp>
 
 std::string HttpClient::api_key = "";
 std::string HttpClient::ca_cert_path = "";
+CURLSH* HttpClient::share = nullptr;
+std::atomic<uint64_t> HttpClient::num_requests = 0;
+std::atomic<uint64_t> HttpClient::num_new_connections = 0;
+
+static std::mutex share_mutexes[CURL_LOCK_DATA_LAST];
+
+static void share_lock(CURL* curl, curl_lock_data data, curl_lock_access access, void* userptr) {
+    share_mutexes[data].lock();
+}
+
+static void share_unlock(CURL* curl, curl_lock_data data, void* userptr) {
+    share_mutexes[data].unlock();
+}
 
 struct client_state_t: public req_state_t {
     CURL* curl;
@@ -56,6 +70,7 @@ long HttpClient::post_response_stream(const std::string &url, const std::string
     curl_easy_setopt(curl, CURLOPT_POST, 1L);
     curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
     curl_easy_perform(curl);
+    record_connection(curl);
 
     long status_code = 0;
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status_code);
@@ -79,6 +94,7 @@ long HttpClient::post_response_async(const std::string &url, const std::shared_p
 
     curl_easy_setopt(curl, CURLOPT_POST, 1L);
     curl_easy_perform(curl);
+    record_connection(curl);
     curl_easy_cleanup(curl);
 
     curl_slist_free_all(chunk);
@@ -166,6 +182,48 @@ void HttpClient::init(const std::string &api_key) {
             break;
         }
     }
+
+    if(share == nullptr) {
+        share = curl_share_init();
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, share_lock);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+}
+
+void HttpClient::dispose() {
+    // the handles that used the share must have been cleaned up
+    if(share != nullptr) {
+        curl_share_cleanup(share);
+        share = nullptr;
+    }
+}
+
+void HttpClient::set_shared_options(CURL* curl) {
+    if(share != nullptr) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+}
+
+void HttpClient::record_connection(CURL* curl) {
+    long num_connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &num_connects);
+    num_requests++;
+    num_new_connections += num_connects;
+}
+
+void HttpClient::get_metrics(nlohmann::json& result) {
+    const uint64_t requests = num_requests;
+    const uint64_t new_connections = num_new_connections;
+
+    result["typesense_http_client_requests"] = std::to_string(requests);
+    result["typesense_http_client_new_connections"] = std::to_string(new_connections);
+    result["typesense_http_client_reused_connections"] =
+            std::to_string(requests > new_connections ? requests - new_connections : 0);
 }
 
 long HttpClient::perform_curl(CURL *curl, std::map<std::string, std::string>& res_headers, struct curl_slist *chunk,
@@ -178,6 +236,7 @@ long HttpClient::perform_curl(CURL *curl, std::map<std::string, std::string>& re
 
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
     CURLcode res = curl_easy_perform(curl);
+    record_connection(curl);
 
     if (res != CURLE_OK) {
         char* url = nullptr;
@@ -259,7 +318,7 @@ size_t HttpClient::curl_req_send_callback(char* buffer, size_t size, size_t nite
 
         HttpServer *server = req_res->server;
 
-        server->get_message_dispatcher()->send_message(HttpServer::REQUEST_PROCEED_MESSAGE, req_res);
+        server->get_message_dispatcher(req_res->req)->send_message(HttpServer::REQUEST_PROCEED_MESSAGE, req_res);
 
         if(!req_res->req->last_chunk_aggregate) {
             //LOG(INFO) << "Waiting for request body to be ready";
@@ -313,7 +372,8 @@ size_t HttpClient::curl_write_async(char *buffer, size_t size, size_t nmemb, voi
     req_res->res->wait();
 
     async_req_res_t* async_req_res = new async_req_res_t(req_res->req, req_res->res, true);
-    req_res->server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+    req_res->server->get_message_dispatcher(req_res->req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE,
+                                                                        async_req_res);
 
     // wait until response is sent
     //LOG(INFO) << "Response sent";
@@ -325,6 +385,11 @@ size_t HttpClient::curl_write_stream(char *buffer, size_t size, size_t nmemb, vo
     size_t res_size = size * nmemb;
     auto res = reinterpret_cast<async_stream_response_t*>(context);
     res->response_chunks.emplace_back(std::string(buffer, res_size));
+
+    if(res->on_chunk && !res->on_chunk(res->response_chunks.back())) {
+        return 0;
+    }
+
     return res_size;
 }
 
@@ -359,7 +424,8 @@ size_t HttpClient::curl_write_async_done(void *context, curl_socket_t item) {
     req_res->res->wait();
 
     async_req_res_t* async_req_res = new async_req_res_t(req_res->req, req_res->res, true);
-    req_res->server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+    req_res->server->get_message_dispatcher(req_res->req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE,
+                                                                        async_req_res);
 
     // Close the socket as we've overridden the close socket handler!
     close(item);
@@ -475,6 +541,10 @@ CURL *HttpClient::init_curl(const std::string& url, std::string& response, const
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, HttpClient::curl_write);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
 
+    // the async and stream handles are not shared, since they learn that a response is done from the closing of
+    // their own connection
+    set_shared_options(curl);
+
     return curl;
 }
 
@@ -34,6 +34,10 @@ std::string route_path::_get_action() {
         return "documents:" + resource_path;
     }
 
+    if(resource_path == "documents/numeric_updates") {
+        return "documents:update";
+    }
+
     // e.g /collections or /collections/:collection/foo or /collections/:collection
 
     if(http_method == "GET") {
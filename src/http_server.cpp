@@ -11,41 +11,50 @@
 #include "raft_server.h"
 #include "logger.h"
 #include "ratelimit_manager.h"
+#include "admission_controller.h"
+#include "system_metrics.h"
+#include "cached_resource_stat.h"
 
 HttpServer::HttpServer(const std::string & version, const std::string & listen_address,
                        uint32_t listen_port, const std::string & ssl_cert_path, const std::string & ssl_cert_key_path,
                        const uint64_t ssl_refresh_interval_ms, bool cors_enabled,
-                       const std::set<std::string>& cors_domains, ThreadPool* thread_pool):
+                       const std::set<std::string>& cors_domains, ThreadPool* thread_pool,
+                       size_t num_event_loops):
         SSL_REFRESH_INTERVAL_MS(ssl_refresh_interval_ms),
         exit_loop(false), version(version), listen_address(listen_address), listen_port(listen_port),
         ssl_cert_path(ssl_cert_path), ssl_cert_key_path(ssl_cert_key_path),
         cors_enabled(cors_enabled), cors_domains(cors_domains), thread_pool(thread_pool) {
-    accept_ctx = new h2o_accept_ctx_t();
     h2o_config_init(&config);
     hostconf = h2o_config_register_host(&config, h2o_iovec_init(H2O_STRLIT("default")), 65535);
     register_handler(hostconf, "/", catch_all_handler);
 
-    listener_socket = nullptr; // initialized later
-
     signal(SIGPIPE, SIG_IGN);
-    h2o_context_init(&ctx, h2o_evloop_create(), &config);
 
-    ctx.globalconf->server_name.base = nullptr;  // initialized later
+    config.server_name.base = nullptr;  // initialized later
+
+    for(size_t i = 0; i < std::max<size_t>(1, num_event_loops); i++) {
+        http_event_loop_t* event_loop = new http_event_loop_t();
+        event_loop->server = this;
+        h2o_context_init(&event_loop->ctx, h2o_evloop_create(), &config);
+
+        event_loop->message_dispatcher = new http_message_dispatcher;
+        event_loop->message_dispatcher->init(event_loop->ctx.loop);
 
-    message_dispatcher = new http_message_dispatcher;
-    message_dispatcher->init(ctx.loop);
+        // used during destructor
+        event_loop->ssl_refresh_timer.timer.expire_at = 0;
+        event_loop->accept_ctx.ssl_ctx = nullptr;
+
+        event_loops.push_back(event_loop);
+    }
 
     // used during destructor
-    ssl_refresh_timer.timer.expire_at = 0;
     metrics_refresh_timer.timer.expire_at = 0;
 
     meta_thread_pool = new ThreadPool(4);
-
-    accept_ctx->ssl_ctx = nullptr;
 }
 
 void HttpServer::on_accept(h2o_socket_t *listener, const char *err) {
-    HttpServer* http_server = reinterpret_cast<HttpServer*>(listener->data);
+    http_event_loop_t* event_loop = reinterpret_cast<http_event_loop_t*>(listener->data);
     h2o_socket_t *sock;
 
     if (err != NULL) {
@@ -56,7 +65,7 @@ void HttpServer::on_accept(h2o_socket_t *listener, const char *err) {
         return;
     }
 
-    h2o_accept(http_server->accept_ctx, sock);
+    h2o_accept(&event_loop->accept_ctx, sock);
 }
 
 void HttpServer::on_metrics_refresh_timeout(h2o_timer_t *entry) {
@@ -67,9 +76,22 @@ void HttpServer::on_metrics_refresh_timeout(h2o_timer_t *entry) {
 
     HttpServer *hs = static_cast<HttpServer*>(custom_timer->data);
 
+    // the system metrics are sampled on the meta thread pool, so that the event loop does not wait on the reads
+    // of `/proc` and of the disk stats
+    if(!hs->metrics_sampling.exchange(true)) {
+        hs->meta_thread_pool->enqueue([hs]() {
+            const Config& config = Config::get_instance();
+            SystemMetrics::sample(config.get_data_dir());
+            cached_resource_stat_t::get_instance().refresh(config.get_data_dir(),
+                                                           config.get_disk_used_max_percentage(),
+                                                           config.get_memory_used_max_percentage());
+            hs->metrics_sampling = false;
+        });
+    }
+
     // link the timer for the next cycle
     h2o_timer_link(
-        hs->ctx.loop,
+        hs->event_loops[0]->ctx.loop,
         AppMetrics::METRICS_REFRESH_INTERVAL_MS,
         &hs->metrics_refresh_timer.timer
     );
@@ -80,23 +102,26 @@ void HttpServer::on_ssl_refresh_timeout(h2o_timer_t *entry) {
 
     LOG(INFO) << "Refreshing SSL certs from disk.";
 
-    HttpServer *hs = static_cast<HttpServer*>(custom_timer->data);
-    SSL_CTX* old_ssl_ctx = hs->accept_ctx->ssl_ctx;
+    // every loop refreshes its own context, so that the context is not swapped under the other loops
+    http_event_loop_t* event_loop = static_cast<http_event_loop_t*>(custom_timer->data);
+    HttpServer *hs = event_loop->server;
+    SSL_CTX* old_ssl_ctx = event_loop->accept_ctx.ssl_ctx;
 
-    bool refresh_success = initialize_ssl_ctx(hs->ssl_cert_path.c_str(), hs->ssl_cert_key_path.c_str(), hs->accept_ctx);
+    bool refresh_success = initialize_ssl_ctx(hs->ssl_cert_path.c_str(), hs->ssl_cert_key_path.c_str(),
+                                              &event_loop->accept_ctx);
 
     if (refresh_success) {
         // delete the old SSL context but after some time, to allow existing connections to drain
         h2o_custom_timer_t* ssl_ctx_delete_timer = new h2o_custom_timer_t(old_ssl_ctx);
         h2o_timer_init(&ssl_ctx_delete_timer->timer, on_ssl_ctx_delete_timeout);
         uint64_t delete_lag = std::max<uint64_t>(60 * 1000, hs->SSL_REFRESH_INTERVAL_MS / 2);
-        h2o_timer_link(hs->ctx.loop, delete_lag, &ssl_ctx_delete_timer->timer);
+        h2o_timer_link(event_loop->ctx.loop, delete_lag, &ssl_ctx_delete_timer->timer);
     } else {
         LOG(ERROR) << "SSL cert refresh failed.";
     }
 
     // link the timer for the next cycle
-    h2o_timer_link(hs->ctx.loop, hs->SSL_REFRESH_INTERVAL_MS, &hs->ssl_refresh_timer.timer);
+    h2o_timer_link(event_loop->ctx.loop, hs->SSL_REFRESH_INTERVAL_MS, &event_loop->ssl_refresh_timer.timer);
 }
 
 void HttpServer::on_ssl_ctx_delete_timeout(h2o_timer_t *entry) {
@@ -108,87 +133,121 @@ void HttpServer::on_ssl_ctx_delete_timeout(h2o_timer_t *entry) {
     delete custom_timer;
 }
 
-int HttpServer::setup_ssl(const char *cert_file, const char *key_file) {
+int HttpServer::setup_ssl(http_event_loop_t* event_loop, const char *cert_file, const char *key_file) {
     // Set up a timer to refresh SSL config from disk. Also, initializing upfront so that destructor works
-    ssl_refresh_timer = h2o_custom_timer_t(this);
-    h2o_timer_init(&ssl_refresh_timer.timer, on_ssl_refresh_timeout);
-    h2o_timer_link(ctx.loop, SSL_REFRESH_INTERVAL_MS, &ssl_refresh_timer.timer);
+    event_loop->ssl_refresh_timer = h2o_custom_timer_t(event_loop);
+    h2o_timer_init(&event_loop->ssl_refresh_timer.timer, on_ssl_refresh_timeout);
+    h2o_timer_link(event_loop->ctx.loop, SSL_REFRESH_INTERVAL_MS, &event_loop->ssl_refresh_timer.timer);
 
-    LOG(INFO) << "SSL cert refresh interval: " << (SSL_REFRESH_INTERVAL_MS / 1000) << "s";
-
-    if(!initialize_ssl_ctx(cert_file, key_file, accept_ctx)) {
+    if(!initialize_ssl_ctx(cert_file, key_file, &event_loop->accept_ctx)) {
         return -1;
     }
 
     return 0;
 }
 
-int HttpServer::create_listener() {
+int HttpServer::create_listener(http_event_loop_t* event_loop) {
     struct sockaddr_in addr;
     int fd, reuseaddr_flag = 1;
 
     if(!ssl_cert_path.empty() && !ssl_cert_key_path.empty()) {
-        int ssl_setup_code = setup_ssl(ssl_cert_path.c_str(), ssl_cert_key_path.c_str());
+        int ssl_setup_code = setup_ssl(event_loop, ssl_cert_path.c_str(), ssl_cert_key_path.c_str());
         if(ssl_setup_code != 0) {
             return -1;
         }
     }
 
-    ctx.globalconf->server_name = h2o_strdup(nullptr, "", SIZE_MAX);
-    ctx.globalconf->http2.active_stream_window_size = ACTIVE_STREAM_WINDOW_SIZE;
-    ctx.globalconf->http2.idle_timeout = REQ_TIMEOUT_MS;
-    ctx.globalconf->max_request_entity_size = (size_t(10) * 1024 * 1024 * 1024); // 10 GB
-
-    ctx.globalconf->http1.req_timeout = REQ_TIMEOUT_MS;
-    ctx.globalconf->http1.req_io_timeout = REQ_TIMEOUT_MS;
-
-    accept_ctx->ctx = &ctx;
-    accept_ctx->hosts = config.hosts;
+    event_loop->accept_ctx.ctx = &event_loop->ctx;
+    event_loop->accept_ctx.hosts = config.hosts;
 
     memset(&addr, 0, sizeof(addr));
     addr.sin_family = AF_INET;
     addr.sin_port = htons(listen_port);
     inet_pton(AF_INET, listen_address.c_str(), &(addr.sin_addr));
 
+    // with many loops, every loop binds its own socket to the port and the kernel spreads the connections over them
+    const bool reuse_port = (event_loops.size() > 1);
+
     if ((fd = socket(AF_INET, SOCK_STREAM, 0)) == -1 ||
         setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuseaddr_flag, sizeof(reuseaddr_flag)) != 0 ||
+        (reuse_port && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &reuseaddr_flag, sizeof(reuseaddr_flag)) != 0) ||
         bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
         listen(fd, SOMAXCONN) != 0) {
         return -1;
     }
 
-    listener_socket = h2o_evloop_socket_create(ctx.loop, fd, H2O_SOCKET_FLAG_DONT_READ);
-    listener_socket->data = this;
-    h2o_socket_read_start(listener_socket, on_accept);
+    event_loop->listener_socket = h2o_evloop_socket_create(event_loop->ctx.loop, fd, H2O_SOCKET_FLAG_DONT_READ);
+    event_loop->listener_socket->data = event_loop;
+    h2o_socket_read_start(event_loop->listener_socket, on_accept);
 
     return 0;
 }
 
+void HttpServer::run_event_loop(http_event_loop_t* event_loop) {
+    while(!exit_loop) {
+        h2o_evloop_run(event_loop->ctx.loop, INT32_MAX);
+    }
+}
+
 int HttpServer::run(ReplicationState* replication_state) {
     this->replication_state = replication_state;
 
     metrics_refresh_timer = h2o_custom_timer_t(this);
     h2o_timer_init(&metrics_refresh_timer.timer, on_metrics_refresh_timeout);
-    h2o_timer_link(ctx.loop, AppMetrics::METRICS_REFRESH_INTERVAL_MS, &metrics_refresh_timer.timer);
+    h2o_timer_link(event_loops[0]->ctx.loop, AppMetrics::METRICS_REFRESH_INTERVAL_MS, &metrics_refresh_timer.timer);
 
-    if (create_listener() != 0) {
-        LOG(ERROR) << "Failed to listen on " << listen_address << ":" << listen_port << " - " << strerror(errno);
-        return 1;
-    } else {
-        LOG(INFO) << "Typesense has started listening on port " << listen_port;
+    config.server_name = h2o_strdup(nullptr, "", SIZE_MAX);
+    config.http2.active_stream_window_size = ACTIVE_STREAM_WINDOW_SIZE;
+    config.http2.idle_timeout = REQ_TIMEOUT_MS;
+    config.max_request_entity_size = (size_t(10) * 1024 * 1024 * 1024); // 10 GB
+
+    config.http1.req_timeout = REQ_TIMEOUT_MS;
+    config.http1.req_io_timeout = REQ_TIMEOUT_MS;
+
+    if(!ssl_cert_path.empty() && !ssl_cert_key_path.empty()) {
+        LOG(INFO) << "SSL cert refresh interval: " << (SSL_REFRESH_INTERVAL_MS / 1000) << "s";
     }
 
-    message_dispatcher->on(STOP_SERVER_MESSAGE, HttpServer::on_stop_server);
+    for(http_event_loop_t* event_loop: event_loops) {
+        if(create_listener(event_loop) != 0) {
+            LOG(ERROR) << "Failed to listen on " << listen_address << ":" << listen_port << " - " << strerror(errno);
+            return 1;
+        }
 
-    while(!exit_loop) {
-        h2o_evloop_run(ctx.loop, INT32_MAX);
+        event_loop->message_dispatcher->on(STOP_SERVER_MESSAGE, HttpServer::on_stop_server);
+    }
+
+    LOG(INFO) << "Typesense has started listening on port " << listen_port;
+
+    if(event_loops.size() > 1) {
+        LOG(INFO) << "Number of HTTP event loops: " << event_loops.size();
+    }
+
+    std::vector<std::thread> event_loop_threads;
+
+    for(size_t i = 1; i < event_loops.size(); i++) {
+        event_loop_threads.emplace_back(&HttpServer::run_event_loop, this, event_loops[i]);
+    }
+
+    run_event_loop(event_loops[0]);
+
+    for(auto& event_loop_thread: event_loop_threads) {
+        event_loop_thread.join();
     }
 
     return 0;
 }
 
 bool HttpServer::on_stop_server(void *data) {
-    // do nothing
+    // the listener is closed by the loop that it belongs to
+    http_event_loop_t* event_loop = static_cast<http_event_loop_t*>(data);
+
+    if(event_loop->listener_socket != nullptr) {
+        h2o_socket_read_stop(event_loop->listener_socket);
+        h2o_socket_close(event_loop->listener_socket);
+        event_loop->listener_socket = nullptr;
+    }
+
     return true;
 }
 
@@ -203,16 +262,13 @@ void HttpServer::clear_timeouts(const std::vector<h2o_timer_t*> & timers, bool t
 }
 
 void HttpServer::stop() {
-    if(listener_socket != nullptr) {
-        h2o_socket_read_stop(listener_socket);
-        h2o_socket_close(listener_socket);
-    }
-
-    // this will break the event loop
+    // this will break the event loops
     exit_loop = true;
 
-    // send a message to activate the idle event loop to exit, just in case
-    message_dispatcher->send_message(STOP_SERVER_MESSAGE, nullptr);
+    // send a message to activate the idle event loops to exit, which also closes their listeners
+    for(http_event_loop_t* event_loop: event_loops) {
+        event_loop->message_dispatcher->send_message(STOP_SERVER_MESSAGE, event_loop);
+    }
 }
 
 h2o_pathconf_t* HttpServer::register_handler(h2o_hostconf_t *hostconf, const char *path,
@@ -226,10 +282,14 @@ h2o_pathconf_t* HttpServer::register_handler(h2o_hostconf_t *hostconf, const cha
     // Enable streaming request body
     handler->super.supports_request_streaming = 1;
 
-    compress_args.min_size = 256;       // don't gzip less than this size
-    compress_args.brotli.quality = -1;  // disable, not widely supported
-    compress_args.gzip.quality = 1;     // fastest
-    h2o_compress_register(pathconf, &compress_args);
+    // responses are compressed with the encoding that the client prefers, gzip or brotli
+    const size_t compress_min_bytes = Config::get_instance().get_http_compress_min_bytes();
+    if(compress_min_bytes != 0) {
+        compress_args.min_size = compress_min_bytes;    // don't compress less than this size
+        compress_args.brotli.quality = 1;               // fastest
+        compress_args.gzip.quality = 1;                 // fastest
+        h2o_compress_register(pathconf, &compress_args);
+    }
 
     return pathconf;
 }
@@ -413,6 +473,29 @@ int HttpServer::catch_all_handler(h2o_handler_t *_h2o_handler, h2o_req_t *req) {
         query_map[http_req::USER_HEADER] = client_ip;
     }
 
+    ssize_t consistency_header_cursor = h2o_find_header_by_str(&req->headers, http_req::READ_CONSISTENCY_HEADER,
+                                                               strlen(http_req::READ_CONSISTENCY_HEADER), -1);
+
+    if(consistency_header_cursor != -1) {
+        h2o_iovec_t & slot = req->headers.entries[consistency_header_cursor].value;
+        query_map[http_req::READ_CONSISTENCY_HEADER] = std::string(slot.base, slot.len);
+    }
+
+    ssize_t priority_header_cursor = h2o_find_header_by_str(&req->headers, http_req::PRIORITY_HEADER,
+                                                            strlen(http_req::PRIORITY_HEADER), -1);
+
+    if(priority_header_cursor != -1) {
+        h2o_iovec_t & slot = req->headers.entries[priority_header_cursor].value;
+        query_map[http_req::PRIORITY_HEADER] = std::string(slot.base, slot.len);
+    }
+
+    ssize_t accept_header_cursor = h2o_find_header(&req->headers, H2O_TOKEN_ACCEPT, -1);
+
+    if(accept_header_cursor != -1) {
+        h2o_iovec_t & slot = req->headers.entries[accept_header_cursor].value;
+        query_map[http_req::ACCEPT_HEADER] = std::string(slot.base, slot.len);
+    }
+
     route_path *rpath = nullptr;
     uint64_t route_hash = h2o_handler->http_server->find_route(path_parts, http_method, &rpath);
 
@@ -427,9 +510,9 @@ int HttpServer::catch_all_handler(h2o_handler_t *_h2o_handler, h2o_req_t *req) {
     bool needs_readiness_check = (root_resource == "collections") ||
          !(
              root_resource == "health" || root_resource == "debug" || root_resource == "proxy" ||
-             root_resource == "stats.json" || root_resource == "metrics.json" ||
+             root_resource == "stats.json" || root_resource == "metrics.json" || root_resource == "metrics" ||
              root_resource == "sequence" || root_resource == "operations" ||
-             root_resource == "config" || root_resource == "status"
+             root_resource == "config" || root_resource == "status" || root_resource == "replication"
          );
 
     bool use_meta_thread_pool = (root_resource == "status");
@@ -441,7 +524,14 @@ int HttpServer::catch_all_handler(h2o_handler_t *_h2o_handler, h2o_req_t *req) {
         std::string message = "{ \"message\": \"Not Ready or Lagging\"}";
 
         if(read_op && !h2o_handler->http_server->get_replication_state()->is_read_caught_up()) {
-            return send_response(req, 503, message);
+            // reads of a single collection can be served once that collection is loaded
+            bool collection_ready = root_resource == "collections" && path_parts.size() > 1 &&
+                h2o_handler->http_server->get_replication_state()->is_collection_read_ready(
+                    StringUtils::url_decode(path_parts[1]));
+
+            if(!collection_ready) {
+                return send_response(req, 503, message);
+            }
         }
 
         else if(write_op && !h2o_handler->http_server->get_replication_state()->is_write_caught_up()) {
@@ -511,6 +601,8 @@ int HttpServer::catch_all_handler(h2o_handler_t *_h2o_handler, h2o_req_t *req) {
     std::shared_ptr<http_req> request = std::make_shared<http_req>(req, rpath->http_method, path_without_query,
                                                                    route_hash, query_map, embedded_params_vec,
                                                                    api_auth_key_sent, body, client_ip);
+    request->event_loop = H2O_STRUCT_FROM_MEMBER(http_event_loop_t, ctx, req->conn->ctx);
+    request->accepts_gzip = (h2o_get_compressible_types(&req->headers) & H2O_COMPRESSIBLE_GZIP) != 0;
 
     // add custom generator with a dispose function for cleaning up resources
     h2o_custom_generator_t* custom_gen = new h2o_custom_generator_t;
@@ -694,16 +786,64 @@ int HttpServer::process_request(const std::shared_ptr<http_req>& request, const
         return 0;
     }
 
-    auto message_dispatcher = handler->http_server->get_message_dispatcher();
+    // searches are admitted before they are queued, so that an overloaded server rejects them right away
+    AdmissionController& admission_controller = AdmissionController::get_instance();
+    const bool needs_admission = admission_controller.is_enabled() && rpath->action == "documents:search";
+
+    if(needs_admission) {
+        auto priority_it = request->params.find(http_req::PRIORITY_HEADER);
+        const bool high_priority = (priority_it != request->params.end() && priority_it->second == "high");
+
+        if(!admission_controller.try_admit(high_priority)) {
+            request->overloaded = true;
+            const std::string& retry_after = std::to_string(admission_controller.get_retry_after_s());
+            h2o_iovec_t retry_after_value = h2o_strdup(&request->_req->pool, retry_after.c_str(), SIZE_MAX);
+            h2o_add_header(&request->_req->pool, &request->_req->res.headers, H2O_TOKEN_RETRY_AFTER, nullptr,
+                           retry_after_value.base, retry_after_value.len);
+            std::string message = "{ \"message\": \"Server is overloaded, please retry later.\"}";
+            return send_response(request->_req, 503, message);
+        }
+    }
+
+    auto message_dispatcher = handler->http_server->get_message_dispatcher(request);
 
     auto thread_pool = use_meta_thread_pool ? handler->http_server->get_meta_thread_pool() :
                        handler->http_server->get_thread_pool();
 
+    auto replication_state = handler->http_server->get_replication_state();
+    auto consistency_it = request->params.find(http_req::READ_CONSISTENCY_HEADER);
+    const bool strong_read = (consistency_it != request->params.end() && consistency_it->second == "strong");
+
     // LOG(INFO) << "Before enqueue res: " << response
-    thread_pool->enqueue([rpath, message_dispatcher, request, response]() {
+    thread_pool->enqueue([rpath, message_dispatcher, request, response, replication_state, strong_read,
+                          needs_admission]() {
+        auto release_admission = [&request, needs_admission]() {
+            if(needs_admission) {
+                uint64_t now_ts = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+                AdmissionController::get_instance().release(now_ts - request->start_ts);
+            }
+        };
+
+        if(strong_read) {
+            // waits on this worker, not on the event loop
+            auto coll_it = request->params.find("collection");
+            auto read_index_op = replication_state->wait_for_read_index(ReplicationState::STRONG_READ_TIMEOUT_MS,
+                                                                        coll_it == request->params.end() ? "" :
+                                                                        coll_it->second);
+            if(!read_index_op.ok()) {
+                release_admission();
+                response->set(read_index_op.code(), read_index_op.error());
+                auto req_res = new async_req_res_t(request, response, true);
+                message_dispatcher->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+                return;
+            }
+        }
+
         // call the API handler
         //LOG(INFO) << "Wait for response " << response.get() << ", action: " << rpath->_get_action();
         (rpath->handler)(request, response);
+        release_admission();
 
         if(!rpath->async_res) {
             // lifecycle of non async res will be owned by stream responder
@@ -760,7 +900,7 @@ void HttpServer::defer_processing(const std::shared_ptr<http_req>& req, const st
         h2o_timer_unlink(&req->defer_timer.timer);
     }
 
-    h2o_timer_link(ctx.loop, timeout_ms, &req->defer_timer.timer);
+    h2o_timer_link(get_event_loop(req)->ctx.loop, timeout_ms, &req->defer_timer.timer);
 
     if(exit_loop) {
         // otherwise, replication thread could be stuck waiting on a future
@@ -771,7 +911,7 @@ void HttpServer::defer_processing(const std::shared_ptr<http_req>& req, const st
 }
 
 void HttpServer::send_message(const std::string & type, void* data) {
-    message_dispatcher->send_message(type, data);
+    event_loops[0]->message_dispatcher->send_message(type, data);
 }
 
 int HttpServer::send_response(h2o_req_t *req, int status_code, const std::string & message) {
@@ -833,6 +973,14 @@ void HttpServer::stream_response(stream_response_state_t& state) {
     if(start_of_res) {
         h2o_add_header(&req->pool, &req->res.headers, H2O_TOKEN_CONTENT_TYPE, NULL,
                        state.res_content_type.data(), state.res_content_type.size());
+
+        if(!state.res_content_encoding.empty()) {
+            // an encoded body is not compressed again by the compress filter
+            h2o_iovec_t content_encoding = h2o_strdup(&req->pool, state.res_content_encoding.c_str(), SIZE_MAX);
+            h2o_add_header(&req->pool, &req->res.headers, H2O_TOKEN_CONTENT_ENCODING, NULL,
+                           content_encoding.base, content_encoding.len);
+            h2o_set_header_token(&req->pool, &req->res.headers, H2O_TOKEN_VARY, H2O_STRLIT("accept-encoding"));
+        }
         req->res.status = (state.status == 0 && state.send_state != H2O_SEND_STATE_FINAL) ? 200 : state.status;
         req->res.reason = state.reason;
     }
@@ -916,45 +1064,53 @@ void HttpServer::del(const std::string & path, bool (*handler)(const std::shared
 }
 
 void HttpServer::on(const std::string & message, bool (*handler)(void*)) {
-    message_dispatcher->on(message, handler);
+    for(http_event_loop_t* event_loop: event_loops) {
+        event_loop->message_dispatcher->on(message, handler);
+    }
 }
 
 HttpServer::~HttpServer() {
-    delete message_dispatcher;
-
-    if(ssl_refresh_timer.timer.expire_at != 0) {
-        // avoid callback since it recreates timeout
-        clear_timeouts({&ssl_refresh_timer.timer}, false);
-    }
-
     if(metrics_refresh_timer.timer.expire_at != 0) {
         // avoid callback since it recreates timeout
         clear_timeouts({&metrics_refresh_timer.timer}, false);
     }
 
-    h2o_timerwheel_run(ctx.loop->_timeouts, 9999999999999);
+    for(http_event_loop_t* event_loop: event_loops) {
+        delete event_loop->message_dispatcher;
 
-    h2o_context_dispose(&ctx);
+        if(event_loop->ssl_refresh_timer.timer.expire_at != 0) {
+            // avoid callback since it recreates timeout
+            clear_timeouts({&event_loop->ssl_refresh_timer.timer}, false);
+        }
 
-    if(ctx.globalconf->server_name.base != nullptr) {
-        free(ctx.globalconf->server_name.base);
-        ctx.globalconf->server_name.base = nullptr;
+        h2o_timerwheel_run(event_loop->ctx.loop->_timeouts, 9999999999999);
+
+        h2o_context_dispose(&event_loop->ctx);
+
+        // Flaky, sometimes assertion on timeouts occur, preventing a clean shutdown
+        //h2o_evloop_destroy(event_loop->ctx.loop);
+
+        SSL_CTX_free(event_loop->accept_ctx.ssl_ctx);
+        delete event_loop;
     }
 
-    // Flaky, sometimes assertion on timeouts occur, preventing a clean shutdown
-    //h2o_evloop_destroy(ctx.loop);
+    if(config.server_name.base != nullptr) {
+        free(config.server_name.base);
+        config.server_name.base = nullptr;
+    }
 
     h2o_config_dispose(&config);
 
-    SSL_CTX_free(accept_ctx->ssl_ctx);
-    delete accept_ctx;
-
     meta_thread_pool->shutdown();
     delete meta_thread_pool;
 }
 
-http_message_dispatcher* HttpServer::get_message_dispatcher() const {
-    return message_dispatcher;
+http_message_dispatcher* HttpServer::get_message_dispatcher(const std::shared_ptr<http_req>& req) const {
+    return get_event_loop(req)->message_dispatcher;
+}
+
+http_event_loop_t* HttpServer::get_event_loop(const std::shared_ptr<http_req>& req) const {
+    return (req->event_loop != nullptr) ? req->event_loop : event_loops[0];
 }
 
 ReplicationState* HttpServer::get_replication_state() const {
@@ -1119,6 +1275,10 @@ int64_t HttpServer::get_num_queued_writes() {
     return replication_state->get_num_queued_writes();
 }
 
+void HttpServer::get_num_queued_writes(nlohmann::json& coll_queue_stats) {
+    replication_state->get_num_queued_writes(coll_queue_stats);
+}
+
 bool HttpServer::is_leader() const {
     return replication_state->is_leader();
 }
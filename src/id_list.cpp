@@ -146,6 +146,7 @@ void id_list_t::iterator_t::skip_to(uint32_t id) {
         return ;
     }
 
+    block_t* const last_end_block = end_block;
     reset_cache();
 
     const auto it = id_block_map->lower_bound(id);
@@ -153,7 +154,13 @@ void id_list_t::iterator_t::skip_to(uint32_t id) {
         return;
     }
 
+    if(last_end_block != nullptr && it->first >= last_end_block->ids.last()) {
+        // an iterator over a part of the list does not go past its end
+        return;
+    }
+
     curr_block = it->second;
+    end_block = last_end_block;
     curr_index = 0;
     ids = curr_block->ids.uncompress();
 
@@ -272,6 +272,16 @@ uint32_t ids_t::first_id(const void* obj) {
     }
 }
 
+uint32_t ids_t::last_id(const void* obj) {
+    if(IS_COMPACT_IDS(obj)) {
+        compact_id_list_t* list = COMPACT_IDS_PTR(obj);
+        return list->last_id();
+    } else {
+        id_list_t* list = (id_list_t*)(obj);
+        return list->last_id();
+    }
+}
+
 bool ids_t::contains(const void* obj, uint32_t id) {
     if(IS_COMPACT_IDS(obj)) {
         compact_id_list_t* list = COMPACT_IDS_PTR(obj);
@@ -406,6 +416,7 @@ void ids_t::block_intersector_t::split_lists(size_t concurrency,
             // construct partial iterators and intersect within them
 
             std::vector<id_list_t::iterator_t>& partial_its = partial_its_vec[window_index];
+            bool window_has_ids = true;
 
             for(size_t i = 0; i < this->id_lists.size(); i++) {
                 id_list_t::block_t* p_start_block = nullptr;
@@ -431,7 +442,17 @@ void ids_t::block_intersector_t::split_lists(size_t concurrency,
                     }
                 }
 
-                partial_its.emplace_back(p_start_block, p_end_block, nullptr, false);
+                if(p_start_block == nullptr) {
+                    // the list has no ids from the start of the window on
+                    window_has_ids = false;
+                    break;
+                }
+
+                partial_its.push_back(this->id_lists[i]->new_iterator(p_start_block, p_end_block));
+            }
+
+            if(!window_has_ids) {
+                partial_its.clear();
             }
 
             start_block = curr_block->next;
@@ -1,5 +1,65 @@
 #include "image_embedder.h"
+#include <algorithm>
+#include <condition_variable>
 #include "text_embedder_remote.h"
+#include "collection_manager.h"
+
+std::atomic<uint64_t> CLIPImageEmbedder::num_images_embedded = 0;
+std::atomic<uint64_t> CLIPImageEmbedder::num_images_failed = 0;
+std::atomic<uint64_t> CLIPImageEmbedder::process_time_us = 0;
+std::atomic<uint64_t> CLIPImageEmbedder::inference_time_us = 0;
+
+// images of a batch_embed() call, which are claimed one at a time by the calling thread and the helper tasks
+struct image_batch_t {
+    const std::vector<std::string>* inputs;
+    const size_t num_inputs;
+    std::atomic<size_t> next_input = 0;
+
+    std::vector<processed_image_t> images;
+    std::vector<embedding_res_t> errors;
+    std::vector<bool> failed;
+    std::vector<bool> processed;
+    std::atomic<uint64_t> process_time_us = 0;
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    image_batch_t(const std::vector<std::string>& inputs): inputs(&inputs), num_inputs(inputs.size()),
+                                                           images(inputs.size()), errors(inputs.size()),
+                                                           failed(inputs.size(), false),
+                                                           processed(inputs.size(), false) {
+
+    }
+
+    // processes the next unclaimed image, returns false when all of them are claimed
+    bool process_next(CLIPImageProcessor& image_processor) {
+        const size_t i = next_input++;
+        if(i >= num_inputs) {
+            return false;
+        }
+
+        auto begin = std::chrono::high_resolution_clock::now();
+        auto processed_image_op = image_processor.process_image((*inputs)[i]);
+        process_time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::high_resolution_clock::now() - begin).count();
+
+        {
+            std::unique_lock lock(mutex);
+            if(processed_image_op.ok()) {
+                images[i] = std::move(processed_image_op.get());
+            } else {
+                nlohmann::json error_json;
+                error_json["error"] = processed_image_op.error();
+                errors[i] = embedding_res_t(processed_image_op.code(), error_json);
+                failed[i] = true;
+            }
+
+            processed[i] = true;
+        }
+
+        cv.notify_all();
+        return true;
+    }
+};
 
 CLIPImageEmbedder::CLIPImageEmbedder(const std::shared_ptr<Ort::Session>& session, const std::shared_ptr<Ort::Env>& env, const std::string& model_path) : image_processor_(model_path), session_(session), env_(env) {
 }
@@ -30,7 +90,6 @@ embedding_res_t CLIPImageEmbedder::embed(const std::string& encoded_image) {
     std::vector<const char*> output_names = {"image_embeds"};
 
     // run inference
-    LOG(INFO) << "Running image embedder";
     auto output_tensors = session_->Run(Ort::RunOptions{nullptr}, input_names.data(), &input_tensor, 1, output_names.data(), output_names.size());
 
     // get output tensor
@@ -52,38 +111,80 @@ embedding_res_t CLIPImageEmbedder::embed(const std::string& encoded_image) {
 
 
 std::vector<embedding_res_t> CLIPImageEmbedder::batch_embed(const std::vector<std::string>& inputs) {
-    std::vector<processed_image_t> processed_images;
-    std::unordered_map<int, embedding_res_t> results;
-
-    int i = 0;
-    for (const auto& input : inputs) {
-        auto processed_image_op = image_processor_.process_image(input);
-
-        if (!processed_image_op.ok()) {
-            nlohmann::json error_json;
-            error_json["error"] = processed_image_op.error();
-            results[i] = embedding_res_t(processed_image_op.code(), error_json);
-            i++;
-            continue;
-        }
+    std::vector<embedding_res_t> output(inputs.size());
+    if(inputs.empty()) {
+        return output;
+    }
 
-        processed_images.push_back(processed_image_op.get());
-        i++;
+    // Helper tasks may only start after this call returns, by when every image is claimed, so the batch is shared
+    // with them.
+    auto batch = std::make_shared<image_batch_t>(inputs);
+    ThreadPool* thread_pool = CollectionManager::get_instance().get_thread_pool();
+
+    if(thread_pool != nullptr && inputs.size() > 1) {
+        const size_t num_helpers = std::min(thread_pool->num_threads(), inputs.size() - 1);
+        for(size_t i = 0; i < num_helpers; i++) {
+            thread_pool->enqueue([batch, this]() {
+                while(batch->process_next(image_processor_)) {}
+            });
+        }
     }
 
+    for(size_t batch_begin = 0; batch_begin < inputs.size(); batch_begin += INFERENCE_BATCH_SIZE) {
+        const size_t batch_end = std::min(batch_begin + INFERENCE_BATCH_SIZE, inputs.size());
+
+        // the calling thread processes images too, so that the batch gets done even when the pool is busy
+        while(batch->next_input < batch_end && batch->process_next(image_processor_)) {}
+
+        std::vector<processed_image_t> images;
+        std::vector<size_t> image_indices;
+
+        {
+            std::unique_lock lock(batch->mutex);
+            batch->cv.wait(lock, [&]() {
+                return std::all_of(batch->processed.begin() + batch_begin, batch->processed.begin() + batch_end,
+                                   [](bool processed) { return processed; });
+            });
+
+            for(size_t i = batch_begin; i < batch_end; i++) {
+                if(batch->failed[i]) {
+                    output[i] = batch->errors[i];
+                    num_images_failed++;
+                    continue;
+                }
 
-    // no valid images
-    if (processed_images.empty()) {
-        std::vector<embedding_res_t> result_vector(inputs.size());
-        for (int i = 0; i < inputs.size(); i++) {
-            result_vector[i] = results[i];
+                images.push_back(std::move(batch->images[i]));
+                image_indices.push_back(i);
+            }
         }
 
-        return result_vector;
+        if(images.empty()) {
+            continue;
+        }
+
+        auto begin = std::chrono::high_resolution_clock::now();
+        auto embeddings = run_inference(images);
+        inference_time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::high_resolution_clock::now() - begin).count();
+
+        for(size_t i = 0; i < image_indices.size(); i++) {
+            if(embeddings[i].success) {
+                num_images_embedded++;
+            } else {
+                num_images_failed++;
+            }
+
+            output[image_indices[i]] = std::move(embeddings[i]);
+        }
     }
 
+    process_time_us += batch->process_time_us;
+    return output;
+}
+
+std::vector<embedding_res_t> CLIPImageEmbedder::run_inference(std::vector<processed_image_t>& images) {
     // create input tensor
-    std::vector<int64_t> input_shape = {static_cast<int64_t>(processed_images.size()), 3, 224, 224};
+    std::vector<int64_t> input_shape = {static_cast<int64_t>(images.size()), 3, 224, 224};
     std::vector<const char*> input_names = {"input_ids", "pixel_values", "attention_mask"};
     std::vector<int64_t> dummy_input_ids_shape = {1,1};
     std::vector<int64_t> dummy_input_ids = {0};
@@ -93,10 +194,10 @@ std::vector<embedding_res_t> CLIPImageEmbedder::batch_embed(const std::vector<st
 
     // convert 2D vector to 1D vector
     std::vector<float> input_vector;
-    for (auto& image : processed_images) {
-        input_vector.reserve(input_vector.size() + image.size());
-        std::move(image.begin(), image.end(), std::back_inserter(input_vector));
-        image.clear();
+    input_vector.reserve(images.size() * images.front().size());
+    for (auto& image : images) {
+        input_vector.insert(input_vector.end(), image.begin(), image.end());
+        processed_image_t().swap(image);
     }
     std::vector<Ort::Value> input_tensors;
     input_tensors.push_back(Ort::Value::CreateTensor<int64_t>(memory_info, (int64_t*) dummy_input_ids.data(), dummy_input_ids.size(), dummy_input_ids_shape.data(), dummy_input_ids_shape.size()));
@@ -108,31 +209,34 @@ std::vector<embedding_res_t> CLIPImageEmbedder::batch_embed(const std::vector<st
 
 
     // run inference
-    LOG(INFO) << "Running image embedder";
-    auto output_tensors = session_->Run(Ort::RunOptions{nullptr}, input_names.data(), input_tensors.data(), input_tensors.size(), output_names.data(), output_names.size());
+    std::vector<Ort::Value> output_tensors;
+    try {
+        output_tensors = session_->Run(Ort::RunOptions{nullptr}, input_names.data(), input_tensors.data(), input_tensors.size(), output_names.data(), output_names.size());
+    } catch (const std::exception& e) {
+        LOG(ERROR) << "Error while running image embedder: " << e.what();
+        return std::vector<embedding_res_t>(images.size(), embedding_res_t(500, "Error while running image embedder"));
+    }
 
     // get output tensor
     auto output_tensor = output_tensors.front().GetTensorMutableData<float>();
     auto shape = output_tensors.front().GetTensorTypeAndShapeInfo().GetShape();
 
-    if (shape.size() != 2) {
-        return std::vector<embedding_res_t>(inputs.size(), embedding_res_t(400, "Invalid shape of output tensor"));
+    if (shape.size() != 2 || shape[0] != static_cast<int64_t>(images.size())) {
+        return std::vector<embedding_res_t>(images.size(), embedding_res_t(400, "Invalid shape of output tensor"));
     }
 
-    std::vector<embedding_res_t> output(inputs.size());
-    i = 0;
+    std::vector<embedding_res_t> output(images.size());
     for (int j = 0; j < shape[0]; j++) {
-        while (results.find(i) != results.end()) {
-            output[i] = results[i];
-            i++;
-        }
-        std::vector<float> output_vector;
-        for (int k = 0; k < shape[1]; k++) {
-            output_vector.push_back(output_tensor[j * shape[1] + k]);
-        }
-        output[i] = embedding_res_t(std::move(output_vector));
-        i++;
+        output[j] = embedding_res_t(std::vector<float>(output_tensor + j * shape[1], output_tensor + (j + 1) * shape[1]));
     }
 
     return output;
-}
\ No newline at end of file
+}
+
+void CLIPImageEmbedder::get_metrics(nlohmann::json& result) {
+    result["typesense_image_embedding_images_embedded"] = std::to_string(num_images_embedded);
+    result["typesense_image_embedding_images_failed"] = std::to_string(num_images_failed);
+    // summed over the threads that decode the images
+    result["typesense_image_embedding_process_time_ms"] = std::to_string(process_time_us / 1000);
+    result["typesense_image_embedding_inference_time_ms"] = std::to_string(inference_time_us / 1000);
+}
@@ -11,21 +11,15 @@ CLIPImageProcessor::CLIPImageProcessor(const std::string& model_path) {
 
 
 Option<processed_image_t> CLIPImageProcessor::process_image(const std::string& image_encoded) {
-    std::unique_lock<std::mutex> lock(mutex_);
-
     // Decode image
     auto image = StringUtils::base64_decode(image_encoded);
 
-    // convert string to byte array
-    std::vector<uint8_t> image_bytes(image.begin(), image.end());
-
-
-    // Create input tensor
-    int64_t input_tensor_size = image_bytes.size();
+    // Create input tensor over the decoded bytes
+    int64_t input_tensor_size = image.size();
     std::vector<int64_t> input_shape = {input_tensor_size};
     std::vector<const char*> input_names = {"image"};
     auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-    auto input_tensor = Ort::Value::CreateTensor<uint8_t>(memory_info, image_bytes.data(), image_bytes.size(), input_shape.data(), input_shape.size());
+    auto input_tensor = Ort::Value::CreateTensor<uint8_t>(memory_info, reinterpret_cast<uint8_t*>(image.data()), image.size(), input_shape.data(), input_shape.size());
 
     
     // Create output tensor
@@ -33,7 +27,6 @@ Option<processed_image_t> CLIPImageProcessor::process_image(const std::string& i
 
     // Run inference
     std::vector<Ort::Value> output_tensors;
-    LOG(INFO) << "Running image processor";
     try {
         output_tensors = session_->Run(Ort::RunOptions{nullptr}, input_names.data(), &input_tensor, 1, output_names.data(), output_names.size());
     } catch (...) {
@@ -49,19 +42,10 @@ Option<processed_image_t> CLIPImageProcessor::process_image(const std::string& i
         LOG(INFO) << "Output tensor shape is not 4D";
         return Option<processed_image_t>(400, "Error while processing image");
     }
-    processed_image_t output;
 
-    for (size_t i = 0; i < output_shape[0]; i++) {
-        for (size_t j = 0; j < output_shape[1]; j++) {
-            for (size_t k = 0; k < output_shape[2]; k++) {
-                for (size_t l = 0; l < output_shape[3]; l++) {
-                    output.push_back(output_tensor[i * output_shape[1] * output_shape[2] * output_shape[3] + j * output_shape[2] * output_shape[3] + k * output_shape[3] + l]);
-                }
-            }
-        }
-    }
-
-    LOG(INFO) << "Image processed";
+    // the tensor is laid out in row major order already
+    const size_t output_size = output_shape[0] * output_shape[1] * output_shape[2] * output_shape[3];
+    processed_image_t output(output_tensor, output_tensor + output_size);
 
     return Option<processed_image_t>(std::move(output));
-}
\ No newline at end of file
+}
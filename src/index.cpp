@@ -11,6 +11,7 @@
 #include <match_score.h>
 #include <string_utils.h>
 #include <tokenizer.h>
+#include <queue>
 #include <s2/s2point.h>
 #include <s2/s2latlng.h>
 #include <s2/s2region_term_indexer.h>
@@ -18,12 +19,16 @@
 #include <s2/s2loop.h>
 #include <posting.h>
 #include <thread_local_vars.h>
+#include "search_profile.h"
+#include "request_cost.h"
 #include <unordered_set>
 #include <or_iterator.h>
 #include <timsort.hpp>
 #include "logger.h"
 #include "validator.h"
 #include <collection_manager.h>
+#include "app_metrics.h"
+#include "gpu_vector_scorer.h"
 
 #define RETURN_CIRCUIT_BREAKER if((std::chrono::duration_cast<std::chrono::microseconds>( \
                   std::chrono::system_clock::now().time_since_epoch()).count() - search_begin_us) > search_stop_us) { \
@@ -44,19 +49,47 @@
                 }
 #define FACET_INDEX_THRESHOLD 1000000000
 
-spp::sparse_hash_map<uint32_t, int64_t, Hasher32> Index::text_match_sentinel_value;
-spp::sparse_hash_map<uint32_t, int64_t, Hasher32> Index::seq_id_sentinel_value;
-spp::sparse_hash_map<uint32_t, int64_t, Hasher32> Index::eval_sentinel_value;
-spp::sparse_hash_map<uint32_t, int64_t, Hasher32> Index::geo_sentinel_value;
-spp::sparse_hash_map<uint32_t, int64_t, Hasher32> Index::str_sentinel_value;
-spp::sparse_hash_map<uint32_t, int64_t, Hasher32> Index::vector_distance_sentinel_value;
-spp::sparse_hash_map<uint32_t, int64_t, Hasher32> Index::vector_query_sentinel_value;
+sort_column_t Index::text_match_sentinel_value;
+sort_column_t Index::seq_id_sentinel_value;
+sort_column_t Index::eval_sentinel_value;
+sort_column_t Index::geo_sentinel_value;
+sort_column_t Index::str_sentinel_value;
+sort_column_t Index::vector_distance_sentinel_value;
+sort_column_t Index::vector_query_sentinel_value;
+
+static hnsw_index_t* create_hnsw_index(const field& a_field) {
+    auto hnsw_index = new hnsw_index_t(a_field.num_dim, hnsw_index_t::INITIAL_CAPACITY, a_field.vec_dist,
+                                       a_field.hnsw_params["M"].get<uint32_t>(),
+                                       a_field.hnsw_params["ef_construction"].get<uint32_t>(),
+                                       hnsw_index_t::get_quantization(a_field.hnsw_params));
+
+    if(hnsw_index_t::get_storage(a_field.hnsw_params) == disk_storage) {
+        std::string dir_path = Config::get_instance().get_data_dir();
+        dir_path = dir_path.empty() ? "/tmp" : dir_path + "/vectors";
+
+        auto store_op = (directory_exists(dir_path) || create_directory(dir_path)) ?
+                        hnsw_index->store_full_vectors(dir_path) :
+                        Option<bool>(500, "Unable to create directory `" + dir_path + "`.");
+        if(!store_op.ok()) {
+            // candidates are then ranked on their quantized vectors
+            LOG(ERROR) << "Float vectors of field `" << a_field.name << "` are not kept: " << store_op.error();
+        }
+    }
+
+    if(hnsw_index_t::get_vector_column(a_field.hnsw_params)) {
+        hnsw_index->column = new vector_column_t(a_field.num_dim);
+    }
+
+    return hnsw_index;
+}
 
 Index::Index(const std::string& name, const uint32_t collection_id, const Store* store,
              SynonymIndex* synonym_index, ThreadPool* thread_pool,
              const tsl::htrie_map<char, field> & search_schema,
-             const std::vector<char>& symbols_to_index, const std::vector<char>& token_separators):
+             const std::vector<char>& symbols_to_index, const std::vector<char>& token_separators,
+             ThreadPool* indexing_thread_pool):
         name(name), collection_id(collection_id), store(store), synonym_index(synonym_index), thread_pool(thread_pool),
+        indexing_thread_pool(indexing_thread_pool == nullptr ? thread_pool : indexing_thread_pool),
         search_schema(search_schema),
         seq_ids(new id_list_t(256)), symbols_to_index(symbols_to_index), token_separators(token_separators) {
 
@@ -68,7 +101,7 @@ Index::Index(const std::string& name, const uint32_t collection_id, const Store*
         }
 
         if(a_field.num_dim > 0) {
-            auto hnsw_index = new hnsw_index_t(a_field.num_dim, 1024, a_field.vec_dist, a_field.hnsw_params["M"].get<uint32_t>(), a_field.hnsw_params["ef_construction"].get<uint32_t>());
+            auto hnsw_index = create_hnsw_index(a_field);
             vector_index.emplace(a_field.name, hnsw_index);
             continue;
         }
@@ -92,6 +125,10 @@ Index::Index(const std::string& name, const uint32_t collection_id, const Store*
             } else {
                 num_tree_t* num_tree = new num_tree_t;
                 numerical_index.emplace(a_field.name, num_tree);
+
+                if(a_field.facet && (a_field.is_integer() || a_field.is_float())) {
+                    numeric_facet_totals.emplace(a_field.name, facet_stats_t());
+                }
             }
         }
 
@@ -100,7 +137,7 @@ Index::Index(const std::string& name, const uint32_t collection_id, const Store*
                 adi_tree_t* tree = new adi_tree_t();
                 str_sort_index.emplace(a_field.name, tree);
             } else if(a_field.type != field_types::GEOPOINT_ARRAY) {
-                auto doc_to_score = new spp::sparse_hash_map<uint32_t, int64_t, Hasher32>();
+                auto doc_to_score = new sort_column_t();
                 sort_index.emplace(a_field.name, doc_to_score);
             }
         }
@@ -124,6 +161,14 @@ Index::Index(const std::string& name, const uint32_t collection_id, const Store*
             }
 
             infix_index.emplace(a_field.name, infix_sets);
+
+            if(trigram_index_t::is_enabled()) {
+                infix_trigram_index.emplace(a_field.name, new trigram_index_t());
+            }
+        }
+
+        if(a_field.exact_match_index && a_field.is_string()) {
+            exact_match_index.emplace(a_field.name, new exact_match_index_t());
         }
 
         if (a_field.is_reference_helper && a_field.is_array()) {
@@ -205,6 +250,20 @@ Index::~Index() {
 
     infix_index.clear();
 
+    for(auto& kv: infix_trigram_index) {
+        delete kv.second;
+        kv.second = nullptr;
+    }
+
+    infix_trigram_index.clear();
+
+    for(auto& kv: exact_match_index) {
+        delete kv.second;
+        kv.second = nullptr;
+    }
+
+    exact_match_index.clear();
+
     for(auto& name_tree: str_sort_index) {
         delete name_tree.second;
         name_tree.second = nullptr;
@@ -235,6 +294,109 @@ Index::~Index() {
     object_array_reference_index.clear();
 }
 
+bool Index::release_next_structure() {
+    if(!search_index.empty()) {
+        auto it = search_index.begin();
+        art_tree_destroy(it->second);
+        delete it->second;
+        search_index.erase(it);
+        return true;
+    }
+
+    if(!geo_range_index.empty()) {
+        auto it = geo_range_index.begin();
+        delete it->second;
+        geo_range_index.erase(it);
+        return true;
+    }
+
+    if(!geo_array_index.empty()) {
+        auto it = geo_array_index.begin();
+        for(auto& kv: *it->second) {
+            delete [] kv.second;
+        }
+
+        delete it->second;
+        geo_array_index.erase(it);
+        return true;
+    }
+
+    if(!numerical_index.empty()) {
+        auto it = numerical_index.begin();
+        delete it->second;
+        numerical_index.erase(it);
+        return true;
+    }
+
+    if(!range_index.empty()) {
+        auto it = range_index.begin();
+        delete it->second;
+        range_index.erase(it);
+        return true;
+    }
+
+    if(!sort_index.empty()) {
+        auto it = sort_index.begin();
+        delete it->second;
+        sort_index.erase(it);
+        return true;
+    }
+
+    if(!infix_index.empty()) {
+        auto it = infix_index.begin();
+        for(auto& infix_set: it->second) {
+            delete infix_set;
+        }
+
+        infix_index.erase(it);
+        return true;
+    }
+
+    if(!infix_trigram_index.empty()) {
+        auto it = infix_trigram_index.begin();
+        delete it->second;
+        infix_trigram_index.erase(it);
+        return true;
+    }
+
+    if(!exact_match_index.empty()) {
+        auto it = exact_match_index.begin();
+        delete it->second;
+        exact_match_index.erase(it);
+        return true;
+    }
+
+    if(!str_sort_index.empty()) {
+        auto it = str_sort_index.begin();
+        delete it->second;
+        str_sort_index.erase(it);
+        return true;
+    }
+
+    if(!vector_index.empty()) {
+        auto it = vector_index.begin();
+        delete it->second;
+        vector_index.erase(it);
+        return true;
+    }
+
+    if(!reference_index.empty()) {
+        auto it = reference_index.begin();
+        delete it->second;
+        reference_index.erase(it);
+        return true;
+    }
+
+    if(!object_array_reference_index.empty()) {
+        auto it = object_array_reference_index.begin();
+        delete it->second;
+        object_array_reference_index.erase(it);
+        return true;
+    }
+
+    return false;
+}
+
 int64_t Index::get_points_from_doc(const nlohmann::json &document, const std::string & default_sorting_field) {
     int64_t points = 0;
 
@@ -456,6 +618,12 @@ void Index::validate_and_preprocess(Index *index,
     // runs in a partitioned thread
     std::vector<index_record*> records_to_embed;
 
+    // the schema is compiled once for the batch, as it can't change while the batch is indexed
+    std::unique_ptr<validator_program_t> validator_program;
+    if(do_validation) {
+        validator_program = std::make_unique<validator_program_t>(search_schema, embedding_fields);
+    }
+
     for(size_t i = 0; i < batch_size; i++) {
         index_record& index_rec = iter_batch[batch_start_index + i];
 
@@ -474,6 +642,7 @@ void Index::validate_and_preprocess(Index *index,
             if(do_validation) {
                 Option<uint32_t> validation_op = validator_t::validate_index_in_memory(index_rec.doc, index_rec.seq_id,
                                                                           default_sorting_field,
+                                                                          *validator_program,
                                                                           search_schema,
                                                                           embedding_fields,
                                                                           index_rec.operation,
@@ -558,51 +727,46 @@ batch_memory_index(Index *index,
                                  const bool do_validation, const size_t remote_embedding_batch_size,
                                  const size_t remote_embedding_timeout_ms, const size_t remote_embedding_num_tries, const bool generate_embeddings, 
                                  const bool use_addition_fields, const tsl::htrie_map<char, field>& addition_fields) {
-    const size_t concurrency = 4;
-    const size_t num_threads = std::min(concurrency, iter_batch.size());
-    const size_t window_size = (num_threads == 0) ? 0 :
-                               (iter_batch.size() + num_threads - 1) / num_threads;  // rounds up
-    const auto& indexable_schema = use_addition_fields ? addition_fields : actual_search_schema;
-    
+    preprocess_batch(index, iter_batch, default_sorting_field, actual_search_schema, embedding_fields,
+                     fallback_field_type, token_separators, symbols_to_index, do_validation,
+                     remote_embedding_batch_size, remote_embedding_timeout_ms, remote_embedding_num_tries,
+                     generate_embeddings);
 
-    size_t num_indexed = 0;
-    size_t num_processed = 0;
-    std::mutex m_process;
-    std::condition_variable cv_process;
+    return index_preprocessed_batch(index, iter_batch, use_addition_fields ? addition_fields : actual_search_schema);
+}
 
-    size_t num_queued = 0;
-    size_t batch_index = 0;
+void Index::preprocess_batch(Index *index,
+                             std::vector<index_record>& iter_batch,
+                             const std::string& default_sorting_field,
+                             const tsl::htrie_map<char, field>& actual_search_schema,
+                             const tsl::htrie_map<char, field>& embedding_fields,
+                             const std::string& fallback_field_type,
+                             const std::vector<char>& token_separators,
+                             const std::vector<char>& symbols_to_index,
+                             const bool do_validation, const size_t remote_embedding_batch_size,
+                             const size_t remote_embedding_timeout_ms, const size_t remote_embedding_num_tries,
+                             const bool generate_embeddings) {
+    const size_t concurrency = std::max<size_t>(1, Config::get_instance().get_index_batch_concurrency());
 
     // local is need to propogate the thread local inside threads launched below
     auto local_write_log_index = write_log_index;
+    auto local_write_log_first_index = write_log_first_index;
 
-    for(size_t thread_id = 0; thread_id < num_threads && batch_index < iter_batch.size(); thread_id++) {
-        size_t batch_len = window_size;
-
-        if(batch_index + window_size > iter_batch.size()) {
-            batch_len = iter_batch.size() - batch_index;
-        }
-
-        num_queued++;
-
-        index->thread_pool->enqueue([&, batch_index, batch_len]() {
-            write_log_index = local_write_log_index;
-            validate_and_preprocess(index, iter_batch, batch_index, batch_len, default_sorting_field, actual_search_schema,
-                                    embedding_fields, fallback_field_type, token_separators, symbols_to_index, do_validation, remote_embedding_batch_size, remote_embedding_timeout_ms, remote_embedding_num_tries, generate_embeddings);
-
-            std::unique_lock<std::mutex> lock(m_process);
-            num_processed++;
-
-            cv_process.notify_one();
-        });
+    index->indexing_thread_pool->parallel_for(0, iter_batch.size(), concurrency, [&](size_t batch_index, size_t batch_end) {
+        write_log_index = local_write_log_index;
+        write_log_first_index = local_write_log_first_index;
+        validate_and_preprocess(index, iter_batch, batch_index, batch_end - batch_index, default_sorting_field, actual_search_schema,
+                                embedding_fields, fallback_field_type, token_separators, symbols_to_index, do_validation, remote_embedding_batch_size, remote_embedding_timeout_ms, remote_embedding_num_tries, generate_embeddings);
+    });
+}
 
-        batch_index += batch_len;
-    }
+size_t Index::index_preprocessed_batch(Index *index, std::vector<index_record>& iter_batch,
+                                       const tsl::htrie_map<char, field>& indexable_schema) {
+    size_t num_indexed = 0;
 
-    {
-        std::unique_lock<std::mutex> lock_process(m_process);
-        cv_process.wait(lock_process, [&](){ return num_processed == num_queued; });
-    }
+    // local is need to propogate the thread local inside threads launched below
+    auto local_write_log_index = write_log_index;
+    auto local_write_log_first_index = write_log_first_index;
 
     std::unordered_set<std::string> found_fields;
 
@@ -625,20 +789,29 @@ batch_memory_index(Index *index,
         }
     }
 
-    num_queued = num_processed = 0;
-    std::unique_lock ulock(index->mutex);
-
+    std::vector<std::string> indexable_fields;
     for(const auto& field_name: found_fields) {
         //LOG(INFO) << "field name: " << field_name;
         if(field_name != "id" && indexable_schema.count(field_name) == 0) {
             continue;
         }
 
-        num_queued++;
+        indexable_fields.push_back(field_name);
+    }
 
-        index->thread_pool->enqueue([&]() {
-            write_log_index = local_write_log_index;
+    const auto lock_wait_begin = std::chrono::steady_clock::now();
+    std::unique_lock ulock(index->mutex);
+    AppMetrics::get_instance().record_index_lock_wait(true, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - lock_wait_begin).count());
+    index->write_generation++;
+
+    // one field per task
+    index->indexing_thread_pool->parallel_for(0, indexable_fields.size(), indexable_fields.size(), [&](size_t begin, size_t end) {
+        write_log_index = local_write_log_index;
+        write_log_first_index = local_write_log_first_index;
 
+        for(size_t i = begin; i < end; i++) {
+            const std::string& field_name = indexable_fields[i];
             const field& f = (field_name == "id") ?
                              field("id", field_types::STRING, false) : indexable_schema.at(field_name);
             try {
@@ -649,17 +822,8 @@ batch_memory_index(Index *index,
                     record.index_failure(500, "Unhandled Typesense error in index batch, check logs for details.");
                 }
             }
-
-            std::unique_lock<std::mutex> lock(m_process);
-            num_processed++;
-            cv_process.notify_one();
-        });
-    }
-
-    {
-        std::unique_lock<std::mutex> lock_process(m_process);
-        cv_process.wait(lock_process, [&](){ return num_processed == num_queued; });
-    }
+        }
+    });
 
     return num_indexed;
 }
@@ -667,6 +831,9 @@ batch_memory_index(Index *index,
 void Index::index_field_in_memory(const field& afield, std::vector<index_record>& iter_batch) {
     // indexes a given field of all documents in the batch
 
+    // declared first, so that it also sees the temporaries below being freed
+    memory_accounting_scope_t memory_scope(memory_stats, get_memory_structure(afield));
+
     if(afield.name == "id") {
         for(const auto& record: iter_batch) {
             if(!record.indexed.ok()) {
@@ -686,6 +853,9 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
         return;
     }
 
+    // documents from this seq id on are indexed by the backfill of a background alter that adds the field
+    const uint32_t backfill_end = get_backfill_end(afield.name);
+
     // We have to handle both these edge cases:
     // a) `afield` might not exist in the document (optional field)
     // b) `afield` value could be empty
@@ -706,7 +876,7 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
         }
 
         for(const auto& record: iter_batch) {
-            if(!record.indexed.ok()) {
+            if(!record.indexed.ok() || record.seq_id >= backfill_end) {
                 // some records could have been invalidated upstream
                 continue;
             }
@@ -724,6 +894,8 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
             }
 
             if(afield.facet) {
+                update_numeric_facet_totals(document, afield, true);
+
                 if(afield.is_array()) {
                     const auto& field_values = document[afield.name];
                     for(size_t i = 0; i < field_values.size(); i++) {
@@ -806,14 +978,37 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
                 token_to_doc_offsets[token_offsets.first].emplace_back(seq_id, record.points, token_offsets.second);
 
                 if(afield.infix) {
+                    memory_accounting_scope_t infix_memory_scope(memory_stats, MEMORY_INFIX);
                     auto strhash = StringUtils::hash_wy(token_offsets.first.c_str(), token_offsets.first.size());
                     const auto& infix_sets = infix_index.at(afield.name);
                     infix_sets[strhash % 4]->insert(token_offsets.first);
+
+                    auto trigram_index_it = infix_trigram_index.find(afield.name);
+                    if(trigram_index_it != infix_trigram_index.end()) {
+                        trigram_index_it->second->insert(token_offsets.first);
+                    }
+                }
+            }
+
+            auto exact_match_index_it = exact_match_index.find(afield.name);
+            if(exact_match_index_it != exact_match_index.end()) {
+                std::vector<uint64_t> value_hashes;
+                get_exact_match_hashes(document, afield, symbols_to_index, token_separators, value_hashes);
+
+                for(uint64_t value_hash: value_hashes) {
+                    auto& value_ids = (*exact_match_index_it->second)[value_hash];
+                    auto id_it = std::lower_bound(value_ids.begin(), value_ids.end(), seq_id);
+                    if(id_it == value_ids.end() || *id_it != seq_id) {
+                        value_ids.insert(id_it, seq_id);
+                    }
                 }
             }
         }
 
-        facet_index_v4->insert(afield.name, fvalue_to_seq_ids, seq_id_to_fvalues, afield.is_string());
+        {
+            memory_accounting_scope_t facet_memory_scope(memory_stats, MEMORY_FACET);
+            facet_index_v4->insert(afield.name, fvalue_to_seq_ids, seq_id_to_fvalues, afield.is_string());
+        }
 
         auto tree_it = search_index.find(afield.faceted_name());
         if(tree_it == search_index.end()) {
@@ -822,72 +1017,89 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
 
         art_tree *t = tree_it->second;
 
+        std::vector<std::pair<std::string, std::vector<art_document>>> tokens_documents;
+        tokens_documents.reserve(token_to_doc_offsets.size());
         for(auto& token_to_doc: token_to_doc_offsets) {
-            const std::string& token = token_to_doc.first;
-            std::vector<art_document>& documents = token_to_doc.second;
-
-            const auto *key = (const unsigned char *) token.c_str();
-            int key_len = (int) token.length() + 1;  // for the terminating \0 char
-
-            //LOG(INFO) << "key: " << key << ", art_doc.id: " << art_doc.id;
-            art_inserts(t, key, key_len, max_score, documents);
+            tokens_documents.emplace_back(token_to_doc.first, std::move(token_to_doc.second));
         }
+
+        art_bulk_insert(t, tokens_documents, max_score);
     }
 
     if(!afield.is_string()) {
         if (afield.type == field_types::INT32) {
             auto num_tree = afield.range_index ? nullptr : numerical_index.at(afield.name);
+            std::vector<std::pair<int64_t, uint32_t>> num_values_ids;
             auto trie = afield.range_index ? range_index.at(afield.name) : nullptr;
-            iterate_and_index_numerical_field(iter_batch, afield, [&afield, num_tree, trie]
+            iterate_and_index_numerical_field(iter_batch, afield, [&afield, &num_values_ids, trie]
                     (const index_record& record, uint32_t seq_id) {
                 int32_t value = record.doc[afield.name].get<int32_t>();
                 if (afield.range_index) {
                     trie->insert(value, seq_id);
                 } else {
-                    num_tree->insert(value, seq_id);
+                    num_values_ids.emplace_back(value, seq_id);
                 }
             });
+
+            if (num_tree != nullptr) {
+                num_tree->insert_many(num_values_ids);
+            }
         }
 
         else if(afield.type == field_types::INT64) {
             auto num_tree = afield.range_index ? nullptr : numerical_index.at(afield.name);
+            std::vector<std::pair<int64_t, uint32_t>> num_values_ids;
             auto trie = afield.range_index ? range_index.at(afield.name) : nullptr;
-            iterate_and_index_numerical_field(iter_batch, afield, [&afield, num_tree, trie]
+            iterate_and_index_numerical_field(iter_batch, afield, [&afield, &num_values_ids, trie]
                     (const index_record& record, uint32_t seq_id) {
                 int64_t value = record.doc[afield.name].get<int64_t>();
                 if (afield.range_index) {
                     trie->insert(value, seq_id);
                 } else {
-                    num_tree->insert(value, seq_id);
+                    num_values_ids.emplace_back(value, seq_id);
                 }
             });
+
+            if (num_tree != nullptr) {
+                num_tree->insert_many(num_values_ids);
+            }
         }
 
         else if(afield.type == field_types::FLOAT) {
             auto num_tree = afield.range_index ? nullptr : numerical_index.at(afield.name);
+            std::vector<std::pair<int64_t, uint32_t>> num_values_ids;
             auto trie = afield.range_index ? range_index.at(afield.name) : nullptr;
-            iterate_and_index_numerical_field(iter_batch, afield, [&afield, num_tree, trie]
+            iterate_and_index_numerical_field(iter_batch, afield, [&afield, &num_values_ids, trie]
                     (const index_record& record, uint32_t seq_id) {
                 float fvalue = record.doc[afield.name].get<float>();
                 int64_t value = float_to_int64_t(fvalue);
                 if (afield.range_index) {
                     trie->insert(value, seq_id);
                 } else {
-                    num_tree->insert(value, seq_id);
+                    num_values_ids.emplace_back(value, seq_id);
                 }
             });
+
+            if (num_tree != nullptr) {
+                num_tree->insert_many(num_values_ids);
+            }
         } else if(afield.type == field_types::BOOL) {
             auto num_tree = afield.range_index ? nullptr : numerical_index.at(afield.name);
+            std::vector<std::pair<int64_t, uint32_t>> num_values_ids;
             auto trie = afield.range_index ? range_index.at(afield.name) : nullptr;
-            iterate_and_index_numerical_field(iter_batch, afield, [&afield, num_tree, trie]
+            iterate_and_index_numerical_field(iter_batch, afield, [&afield, &num_values_ids, trie]
                     (const index_record& record, uint32_t seq_id) {
                 bool value = record.doc[afield.name].get<bool>();
                 if (afield.range_index) {
                     trie->insert(value, seq_id);
                 } else {
-                    num_tree->insert(value, seq_id);
+                    num_values_ids.emplace_back(value, seq_id);
                 }
             });
+
+            if (num_tree != nullptr) {
+                num_tree->insert_many(num_values_ids);
+            }
         } else if(afield.type == field_types::GEOPOINT || afield.type == field_types::GEOPOINT_ARRAY) {
             auto geopoint_range_index = geo_range_index.at(afield.name);
 
@@ -949,82 +1161,62 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
         } else if(afield.is_array()) {
             // handle vector index first
             if(afield.type == field_types::FLOAT_ARRAY && afield.num_dim > 0) {
-                auto vec_index = vector_index[afield.name]->vecdex;
-                size_t curr_ele_count = vec_index->getCurrentElementCount();
-                if(curr_ele_count + iter_batch.size() > vec_index->getMaxElements()) {
-                    vec_index->resizeIndex((curr_ele_count + iter_batch.size()) * 1.3);
-                }
-
-                const size_t num_threads = std::min<size_t>(4, iter_batch.size());
-                const size_t window_size = (num_threads == 0) ? 0 :
-                                           (iter_batch.size() + num_threads - 1) / num_threads;  // rounds up
-                size_t num_processed = 0;
-                std::mutex m_process;
-                std::condition_variable cv_process;
-
-                size_t num_queued = 0;
-                size_t result_index = 0;
-
-                for(size_t thread_id = 0; thread_id < num_threads && result_index < iter_batch.size(); thread_id++) {
-                    size_t batch_len = window_size;
-
-                    if(result_index + window_size > iter_batch.size()) {
-                        batch_len = iter_batch.size() - result_index;
-                    }
-
-                    num_queued++;
-
-                    thread_pool->enqueue([thread_id, &afield, &vec_index, &records = iter_batch,
-                                          result_index, batch_len, &num_processed, &m_process, &cv_process]() {
-
-                        size_t batch_counter = 0;
-                        while(batch_counter < batch_len) {
-                            auto& record = records[result_index + batch_counter];
-                            if(record.doc.count(afield.name) == 0 || !record.indexed.ok()) {
-                                batch_counter++;
-                                continue;
-                            }
+                if(preloaded_vector_fields.count(afield.name) != 0) {
+                    // graph was restored from an index image that already contains these points
+                    return ;
+                }
+
+                auto vec_index = vector_index[afield.name];
+                size_t curr_ele_count = vec_index->vecdex->getCurrentElementCount();
+                if(curr_ele_count + iter_batch.size() > vec_index->vecdex->getMaxElements()) {
+                    vec_index->vecdex->resizeIndex((curr_ele_count + iter_batch.size()) * 1.3);
+                }
+
+                // the calling thread takes part, so this doesn't wait on a pool that is busy with this very batch;
+                // points are inserted under the locks of the nodes they link to, so every thread of the pool helps
+                const size_t num_chunks = std::max<size_t>(4, indexing_thread_pool->num_threads());
+                indexing_thread_pool->parallel_for(0, iter_batch.size(), num_chunks,
+                                                   [&afield, &vec_index, &records = iter_batch, &stats = memory_stats,
+                                                    backfill_end]
+                        (size_t begin, size_t end) {
+                    memory_accounting_scope_t vector_memory_scope(stats, MEMORY_VECTOR);
+                    for(size_t i = begin; i < end; i++) {
+                        auto& record = records[i];
+                        if(record.doc.count(afield.name) == 0 || !record.indexed.ok() ||
+                           record.seq_id >= backfill_end) {
+                            continue;
+                        }
 
-                            try {
-                                const std::vector<float>& float_vals = record.doc[afield.name].get<std::vector<float>>();
-                                if(float_vals.size() != afield.num_dim) {
-                                    record.index_failure(400, "Vector size mismatch.");
+                        try {
+                            const std::vector<float>& float_vals = record.doc[afield.name].get<std::vector<float>>();
+                            if(float_vals.size() != afield.num_dim) {
+                                record.index_failure(400, "Vector size mismatch.");
+                            } else {
+                                if(afield.vec_dist == cosine) {
+                                    std::vector<float> normalized_vals(afield.num_dim);
+                                    hnsw_index_t::normalize_vector(float_vals, normalized_vals);
+                                    vec_index->add_point(normalized_vals.data(), (size_t)record.seq_id);
                                 } else {
-                                    if(afield.vec_dist == cosine) {
-                                        std::vector<float> normalized_vals(afield.num_dim);
-                                        hnsw_index_t::normalize_vector(float_vals, normalized_vals);
-                                        vec_index->addPoint(normalized_vals.data(), (size_t)record.seq_id, true);
-                                    } else {
-                                        vec_index->addPoint(float_vals.data(), (size_t)record.seq_id, true);
-                                    }
+                                    vec_index->add_point(float_vals.data(), (size_t)record.seq_id);
                                 }
-                            } catch(const std::exception &e) {
-                                record.index_failure(400, e.what());
                             }
-
-                            batch_counter++;
+                        } catch(const std::exception &e) {
+                            record.index_failure(400, e.what());
                         }
+                    }
+                });
 
-                        std::unique_lock<std::mutex> lock(m_process);
-                        num_processed++;
-                        cv_process.notify_one();
-                    });
-
-                    result_index += batch_len;
-                }
-
-                std::unique_lock<std::mutex> lock_process(m_process);
-                cv_process.wait(lock_process, [&](){ return num_processed == num_queued; });
                 return;
             }
 
             // all other numerical arrays
             auto num_tree = afield.range_index ? nullptr : numerical_index.at(afield.name);
+            std::vector<std::pair<int64_t, uint32_t>> num_values_ids;
             auto trie = afield.range_index ? range_index.at(afield.name) : nullptr;
             auto reference = reference_index.count(afield.name) != 0 ? reference_index.at(afield.name) : nullptr;
             auto object_array_reference = object_array_reference_index.count(afield.name) != 0 ?
                                                                 object_array_reference_index.at(afield.name) : nullptr;
-            iterate_and_index_numerical_field(iter_batch, afield, [&afield, num_tree, trie, reference, object_array_reference]
+            iterate_and_index_numerical_field(iter_batch, afield, [&afield, &num_values_ids, trie, reference, object_array_reference]
                     (const index_record& record, uint32_t seq_id) {
                 for(size_t arr_i = 0; arr_i < record.doc[afield.name].size(); arr_i++) {
                     const auto& arr_value = record.doc[afield.name][arr_i];
@@ -1034,7 +1226,7 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
                         if (afield.range_index) {
                             trie->insert(value, seq_id);
                         } else {
-                            num_tree->insert(value, seq_id);
+                            num_values_ids.emplace_back(value, seq_id);
                         }
                     }
 
@@ -1049,7 +1241,7 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
                         if (afield.range_index) {
                             trie->insert(value, seq_id);
                         } else {
-                            num_tree->insert(value, seq_id);
+                            num_values_ids.emplace_back(value, seq_id);
                         }
                         if (reference != nullptr) {
                             reference->insert(seq_id, value);
@@ -1065,7 +1257,7 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
                         if (afield.range_index) {
                             trie->insert(value, seq_id);
                         } else {
-                            num_tree->insert(value, seq_id);
+                            num_values_ids.emplace_back(value, seq_id);
                         }
                     }
 
@@ -1074,15 +1266,20 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
                         if (afield.range_index) {
                             trie->insert(value, seq_id);
                         } else {
-                            num_tree->insert(value, seq_id);
+                            num_values_ids.emplace_back(value, seq_id);
                         }
                     }
                 }
             });
+
+            if (num_tree != nullptr) {
+                num_tree->insert_many(num_values_ids);
+            }
         }
 
         // add numerical values automatically into sort index if sorting is enabled
         if(afield.is_num_sortable() && afield.type != field_types::GEOPOINT_ARRAY) {
+            memory_accounting_scope_t sort_memory_scope(memory_stats, MEMORY_SORT);
             auto doc_to_score = sort_index.at(afield.name);
 
             bool is_integer = afield.is_integer();
@@ -1091,7 +1288,7 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
             bool is_geopoint = afield.is_geopoint();
 
             for(const auto& record: iter_batch) {
-                if(!record.indexed.ok()) {
+                if(!record.indexed.ok() || record.seq_id >= backfill_end) {
                     continue;
                 }
 
@@ -1117,10 +1314,13 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
             }
         }
     } else if(afield.is_str_sortable()) {
+        memory_accounting_scope_t str_sort_memory_scope(memory_stats, MEMORY_STRING_SORT);
         adi_tree_t* str_tree = str_sort_index.at(afield.name);
+        auto str_tokenizer_ptr = Tokenizer::acquire("", true, false, "", {' '});
+        Tokenizer& str_tokenizer = *str_tokenizer_ptr;
 
         for(const auto& record: iter_batch) {
-            if(!record.indexed.ok()) {
+            if(!record.indexed.ok() || record.seq_id >= backfill_end) {
                 continue;
             }
 
@@ -1132,7 +1332,6 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
             }
 
             std::string raw_str = document[afield.name].get<std::string>();
-            Tokenizer str_tokenizer("", true, false, "", {' '});
             str_tokenizer.tokenize(raw_str);
 
             if(!raw_str.empty()) {
@@ -1147,7 +1346,9 @@ void Index::tokenize_string(const std::string& text, const field& a_field,
                             const std::vector<char>& token_separators,
                             std::unordered_map<std::string, std::vector<uint32_t>>& token_to_offsets) {
 
-    Tokenizer tokenizer(text, true, !a_field.is_string(), a_field.locale, symbols_to_index, token_separators);
+    auto tokenizer_ptr = Tokenizer::acquire(text, true, !a_field.is_string(), a_field.locale,
+                                            symbols_to_index, token_separators);
+    Tokenizer& tokenizer = *tokenizer_ptr;
     std::string token;
     std::string last_token;
     size_t token_index = 0;
@@ -1186,11 +1387,22 @@ void Index::tokenize_string_array(const std::vector<std::string>& strings,
                                   const std::vector<char>& token_separators,
                                   std::unordered_map<std::string, std::vector<uint32_t>>& token_to_offsets) {
 
+    auto tokenizer_ptr = Tokenizer::acquire("", true, !a_field.is_string(), a_field.locale,
+                                            symbols_to_index, token_separators);
+    Tokenizer& tokenizer = *tokenizer_ptr;
+
+    // the values of a Japanese field are normalized together
+    const bool is_japanese = a_field.is_string() && a_field.locale == "ja";
+    std::vector<std::string> normalized_strings;
+    if(is_japanese) {
+        JapaneseLocalizer::get_instance().normalize_batch(strings, normalized_strings);
+    }
+
     for(size_t array_index = 0; array_index < strings.size(); array_index++) {
-        const std::string& str = strings[array_index];
+        const std::string& str = is_japanese ? normalized_strings[array_index] : strings[array_index];
         std::set<std::string> token_set;  // required to deal with repeating tokens
 
-        Tokenizer tokenizer(str, true, !a_field.is_string(), a_field.locale, symbols_to_index, token_separators);
+        tokenizer.init(str, is_japanese);
         std::string token, last_token;
         size_t token_index = 0;
 
@@ -1308,6 +1520,87 @@ void Index::compute_facet_stats(facet &a_facet, int64_t raw_value, const std::st
     }
 }
 
+void Index::get_numeric_facet_values(const nlohmann::json& document, const field& afield,
+                                     std::vector<double>& values) {
+    const auto& field_value = document[afield.name];
+
+    if(afield.is_array()) {
+        for(const auto& value: field_value) {
+            if(afield.is_float()) {
+                values.push_back(value.get<float>());
+            } else {
+                values.push_back(value.get<int64_t>());
+            }
+        }
+    } else if(afield.is_float()) {
+        // single floats are faceted on their stringified value
+        values.push_back(std::stof(StringUtils::float_to_str(field_value.get<float>())));
+    } else {
+        values.push_back(field_value.get<int64_t>());
+    }
+
+    // an array counts a value once, like the facet stats of a result set do
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+
+void Index::update_numeric_facet_totals(const nlohmann::json& document, const field& afield, bool is_insert) {
+    auto totals_it = numeric_facet_totals.find(afield.name);
+    if(totals_it == numeric_facet_totals.end() || document.count(afield.name) == 0 ||
+       document[afield.name].is_null()) {
+        return;
+    }
+
+    std::vector<double> values;
+    get_numeric_facet_values(document, afield, values);
+
+    auto& totals = totals_it->second;
+    for(auto value: values) {
+        if(is_insert) {
+            totals.fvsum += value;
+            totals.fvcount++;
+        } else {
+            totals.fvsum -= value;
+            totals.fvcount--;
+        }
+    }
+}
+
+void Index::add_numeric_facet_totals(std::vector<facet>& facets, const std::vector<facet_info_t>& facet_infos) const {
+    for(auto& a_facet: facets) {
+        const auto& facet_info = facet_infos[a_facet.orig_index];
+        if(!facet_info.use_stats_totals || a_facet.is_intersected) {
+            continue;
+        }
+
+        const auto& totals = numeric_facet_totals.at(a_facet.field_name);
+        int64_t min, max;
+        if(totals.fvcount == 0 || !numerical_index.at(a_facet.field_name)->get_min_max(min, max)) {
+            continue;
+        }
+
+        a_facet.stats.fvcount += totals.fvcount;
+        a_facet.stats.fvsum += totals.fvsum;
+
+        if(facet_info.facet_field.is_float()) {
+            float fmin = int64_t_to_float(min);
+            float fmax = int64_t_to_float(max);
+
+            if(!facet_info.facet_field.is_array()) {
+                // as faceted on, see `get_numeric_facet_values()`
+                fmin = std::stof(StringUtils::float_to_str(fmin));
+                fmax = std::stof(StringUtils::float_to_str(fmax));
+            }
+
+            a_facet.stats.fvmin = std::min<double>(a_facet.stats.fvmin, fmin);
+            a_facet.stats.fvmax = std::max<double>(a_facet.stats.fvmax, fmax);
+        } else {
+            a_facet.stats.fvmin = std::min<double>(a_facet.stats.fvmin, min);
+            a_facet.stats.fvmax = std::max<double>(a_facet.stats.fvmax, max);
+        }
+    }
+}
+
 int64_t Index::get_doc_val_from_sort_index(sort_index_iterator sort_index_it, uint32_t doc_seq_id) const {
 
     if(sort_index_it != sort_index.end()){
@@ -1332,8 +1625,10 @@ std::vector<group_by_field_it_t> Index::get_group_by_field_iterators(const std::
         auto facet_index = facet_index_v4->get_facet_hash_index(field_name);
         auto facet_index_it = is_reverse ? facet_index->new_rev_iterator() : facet_index->new_iterator();
 
-        group_by_field_it_t group_by_field_it_struct {field_name, std::move(facet_index_it),
-                                                      search_schema.at(field_name).is_array()};
+        const bool is_array = search_schema.at(field_name).is_array();
+        group_by_field_it_t group_by_field_it_struct {field_name, std::move(facet_index_it), is_array,
+                                                      is_array ? nullptr :
+                                                      facet_index_v4->get_facet_id_column(field_name)};
         group_by_field_it_vec.emplace_back(std::move(group_by_field_it_struct));
     }
     return group_by_field_it_vec;
@@ -1357,12 +1652,18 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
     size_t total_docs = seq_ids->num_ids();
     // assumed that facet fields have already been validated upstream
     for(auto& a_facet : facets) {
+        if(search_deadline_t::check_expired()) {
+            break;
+        }
+
         auto findex = a_facet.orig_index;
         const auto& facet_field = facet_infos[findex].facet_field;
         const bool use_facet_query = facet_infos[findex].use_facet_query;
         const auto& fquery_hashes = facet_infos[findex].hashes;
         const bool should_compute_stats = facet_infos[findex].should_compute_stats;
         const bool use_value_index = facet_infos[findex].use_value_index;
+        // hash based counting leaves the stats to `add_numeric_facet_totals()`
+        const bool compute_hash_stats = should_compute_stats && !facet_infos[findex].use_stats_totals;
 
         auto sort_index_it = sort_index.find(a_facet.field_name);
         auto facet_sort_index_it = sort_index.find(a_facet.sort_field);
@@ -1381,10 +1682,15 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
         bool facet_value_index_exists = facet_index_v4->has_value_index(facet_field.name);
 
 #ifdef TEST_BUILD
-        if(facet_index_type == VALUE) {
+        const bool intersect_value_index = (facet_index_type == VALUE) || facet_infos[findex].approximate;
 #else
-        if(facet_value_index_exists && use_value_index) {
+        const bool intersect_value_index = facet_value_index_exists && use_value_index;
 #endif
+
+        a_facet.strategy_basis = facet_infos[findex].strategy_basis;
+        const auto facet_begin = std::chrono::steady_clock::now();
+
+        if(intersect_value_index) {
             // LOG(INFO) << "Using intersection to find facets";
             a_facet.is_intersected = true;
 
@@ -1396,7 +1702,7 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
                                       facet_infos[findex].fvalue_searched_tokens,
                                       symbols_to_index, token_separators,
                                       result_ids, results_size, max_facet_count, facet_results,
-                                      is_wildcard_no_filter_query, sort_order);
+                                      is_wildcard_no_filter_query, sort_order, facet_infos[findex].approximate);
 
             for(const auto& kv : facet_results) {
                 //range facet processing
@@ -1418,6 +1724,7 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
                     facet_count_t& facet_count = a_facet.value_result_map[kv.first];
                     facet_count.count = kv.second.count;
                     facet_count.doc_id = kv.second.doc_id;
+                    facet_count.error_bound = kv.second.error_bound;
                 }
 
                 if(should_compute_stats) {
@@ -1429,8 +1736,12 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
             if(should_compute_stats) {
                 auto numerical_index_it = numerical_index.find(a_facet.field_name);
                 if(numerical_index_it != numerical_index.end()) {
-                    auto min_max_pair = numerical_index_it->second->get_min_max(result_ids,
-                                                                                results_size);
+                    std::pair<int64_t, int64_t> min_max_pair;
+                    if(results_size != total_docs ||
+                       !numerical_index_it->second->get_min_max(min_max_pair.first, min_max_pair.second)) {
+                        min_max_pair = numerical_index_it->second->get_min_max(result_ids, results_size);
+                    }
+
                     if(facet_field.is_float()) {
                         a_facet.stats.fvmin = int64_t_to_float(min_max_pair.first);
                         a_facet.stats.fvmax = int64_t_to_float(min_max_pair.second);
@@ -1461,6 +1772,11 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
             }
 
             for(size_t i = 0; i < results_size; i++) {
+                // check for search cutoff but only once every 2^12 docs to reduce overhead
+                if(((i + 1) % (1 << 12)) == 0 && search_deadline_t::check_expired()) {
+                    break;
+                }
+
                 // if sampling is enabled, we will skip a portion of the results to speed up things
                 if(estimate_facets) {
                     if(i % facet_sample_mod_value != 0) {
@@ -1490,7 +1806,7 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
                 if(group_limit) {
                     distinct_id = 1;
                     for(auto& kv : group_by_field_it_vec) {
-                        get_distinct_id(kv.it, doc_seq_id, kv.is_array, group_missing_values, distinct_id, false);
+                        get_distinct_id(kv, doc_seq_id, group_missing_values, distinct_id, false);
                     }
                 }
                 //LOG(INFO) << "facet_hash_count " << facet_hash_count;
@@ -1512,7 +1828,7 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
                         }
                     }
 
-                    if(should_compute_stats) {
+                    if(compute_hash_stats) {
                         int64_t val = fhash;
                         if(facet_field_is_int64) {
                             if(fhash_int64_map.find(fhash) != fhash_int64_map.end()) {
@@ -1560,6 +1876,14 @@ void Index::do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
                 }
             }
         }
+
+        if(facet_infos[findex].measure_cost) {
+            // hash batches run in parallel, so the time of a batch stands for the wall time of the strategy
+            auto duration_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - facet_begin).count();
+            facet_cost_model.record(facet_field.name, facet_infos[findex].num_results, intersect_value_index,
+                                    duration_us);
+        }
     }
 }
 
@@ -1606,10 +1930,11 @@ Option<bool> Index::search_all_candidates(const size_t num_search_fields,
                                           const size_t max_candidates,
                                           int syn_orig_num_tokens,
                                           const int* sort_order,
-                                          std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values,
+                                          std::array<sort_column_t*, 3>& field_values,
                                           const std::vector<size_t>& geopoint_indices,
                                           std::set<uint64>& query_hashes,
-                                          std::vector<uint32_t>& id_buff, const std::string& collection_name) const {
+                                          std::vector<uint32_t>& id_buff, const std::string& collection_name,
+                                          const size_t concurrency) const {
 
     /*if(!token_candidates_vec.empty()) {
         LOG(INFO) << "Prefix candidates size: " << token_candidates_vec.back().candidates.size();
@@ -1660,7 +1985,7 @@ Option<bool> Index::search_all_candidates(const size_t num_search_fields,
                                                              exclude_token_ids, exclude_token_ids_size, excluded_group_ids,
                                                              sort_order, field_values, geopoint_indices,
                                                              id_buff, all_result_ids, all_result_ids_len,
-                                                             collection_name);
+                                                             collection_name, concurrency);
         if (!search_across_fields_op.ok()) {
             return search_across_fields_op;
         }
@@ -1697,15 +2022,27 @@ Option<bool> Index::do_filtering_with_lock(filter_node_t* const filter_tree_root
         return Option(true);
     }
 
+    // documents that are deleted, but not purged yet, don't match
+    const std::vector<uint32_t>& deleted_ids = get_deleted_ids();
+
     if (filter_result_iterator.reference.empty()) {
         filter_result.count = filter_result_iterator.to_filter_id_array(filter_result.docs);
+
+        if (!deleted_ids.empty() && filter_result.count != 0) {
+            uint32_t* live_ids = new uint32_t[filter_result.count];
+            filter_result.count = ArrayUtils::exclude_simd(filter_result.docs, filter_result.count,
+                                                           deleted_ids.data(), deleted_ids.size(), live_ids);
+            delete [] filter_result.docs;
+            filter_result.docs = live_ids;
+        }
+
         return Option(true);
     }
 
-    uint32_t count = filter_result_iterator.approx_filter_ids_length, dummy;
+    uint32_t count = filter_result_iterator.approx_filter_ids_length, dummy = 0;
     auto ref_filter_result = new filter_result_t();
     std::unique_ptr<filter_result_t> ref_filter_result_guard(ref_filter_result);
-    filter_result_iterator.get_n_ids(count, dummy, nullptr, 0, ref_filter_result);
+    filter_result_iterator.get_n_ids(count, dummy, deleted_ids.data(), deleted_ids.size(), ref_filter_result);
 
     if (filter_result_iterator.validity == filter_result_iterator_t::timed_out) {
         return Option<bool>(true);
@@ -1785,10 +2122,11 @@ Option<bool> Index::do_reference_filtering_with_lock(filter_node_t* const filter
             for (uint32_t i = 0; i < count; i++) {
                 auto& reference_doc_id = reference_docs[i];
                 auto reference_doc_references = std::move(ref_filter_result->coll_to_references[i]);
-                if (ref_index.count(reference_doc_id) == 0) { // Reference field might be optional.
+                auto const doc_id_it = ref_index.find(reference_doc_id);
+                if (doc_id_it == ref_index.end()) { // Reference field might be optional.
                     continue;
                 }
-                auto doc_id = ref_index.at(reference_doc_id);
+                auto doc_id = doc_id_it->second;
 
                 id_pairs.emplace_back(std::make_pair(doc_id, new single_filter_result_t(reference_doc_id,
                                                                                         std::move(reference_doc_references),
@@ -1848,10 +2186,11 @@ Option<bool> Index::do_reference_filtering_with_lock(filter_node_t* const filter
 
         for (uint32_t i = 0; i < count; i++) {
             auto& reference_doc_id = reference_docs[i];
-            if (ref_index.count(reference_doc_id) == 0) { // Reference field might be optional.
+            auto const doc_id_it = ref_index.find(reference_doc_id);
+            if (doc_id_it == ref_index.end()) { // Reference field might be optional.
                 continue;
             }
-            auto doc_id = ref_index.at(reference_doc_id);
+            auto doc_id = doc_id_it->second;
 
             id_pairs.emplace_back(std::make_pair(doc_id, reference_doc_id));
             unique_doc_ids.insert(doc_id);
@@ -1920,24 +2259,18 @@ Option<bool> Index::do_reference_filtering_with_lock(filter_node_t* const filter
         std::vector<std::pair<uint32_t, single_filter_result_t*>> id_pairs;
         std::unordered_set<uint32_t> unique_doc_ids;
 
-        for (uint32_t i = 0; i < count; i++) {
+        ref_index.visit_ids_of_values(reference_docs, count, [&](size_t i, const std::vector<uint32_t>& doc_ids) {
             auto& reference_doc_id = reference_docs[i];
             auto reference_doc_references = std::move(ref_filter_result->coll_to_references[i]);
-            size_t doc_ids_len = 0;
-            uint32_t* doc_ids = nullptr;
-
-            ref_index.search(EQUALS, reference_doc_id, &doc_ids, doc_ids_len);
 
-            for (size_t j = 0; j < doc_ids_len; j++) {
-                auto doc_id = doc_ids[j];
+            for (const auto& doc_id: doc_ids) {
                 auto reference_doc_references_copy = reference_doc_references;
                 id_pairs.emplace_back(std::make_pair(doc_id, new single_filter_result_t(reference_doc_id,
                                                                                         std::move(reference_doc_references_copy),
                                                                                         false)));
                 unique_doc_ids.insert(doc_id);
             }
-            delete[] doc_ids;
-        }
+        });
 
         if (id_pairs.empty()) {
             return Option(true);
@@ -1988,20 +2321,14 @@ Option<bool> Index::do_reference_filtering_with_lock(filter_node_t* const filter
     std::vector<std::pair<uint32_t, uint32_t>> id_pairs;
     std::unordered_set<uint32_t> unique_doc_ids;
 
-    for (uint32_t i = 0; i < count; i++) {
+    ref_index.visit_ids_of_values(reference_docs, count, [&](size_t i, const std::vector<uint32_t>& doc_ids) {
         auto& reference_doc_id = reference_docs[i];
-        size_t doc_ids_len = 0;
-        uint32_t* doc_ids = nullptr;
 
-        ref_index.search(EQUALS, reference_doc_id, &doc_ids, doc_ids_len);
-
-        for (size_t j = 0; j < doc_ids_len; j++) {
-            auto doc_id = doc_ids[j];
+        for (const auto& doc_id: doc_ids) {
             id_pairs.emplace_back(std::make_pair(doc_id, reference_doc_id));
             unique_doc_ids.insert(doc_id);
         }
-        delete[] doc_ids;
-    }
+    });
 
     if (id_pairs.empty()) {
         return Option(true);
@@ -2073,25 +2400,18 @@ Option<filter_result_t> Index::do_filtering_with_reference_ids(const std::string
         std::vector<std::pair<uint32_t, single_filter_result_t*>> id_pairs;
         std::unordered_set<uint32_t> unique_doc_ids;
 
-        for (uint32_t i = 0; i < count; i++) {
+        num_tree->visit_ids_of_values(reference_docs, count, [&](size_t i, const std::vector<uint32_t>& doc_ids) {
             auto& reference_doc_id = reference_docs[i];
             auto reference_doc_references = std::move(ref_filter_result.coll_to_references[i]);
-            size_t doc_ids_len = 0;
-            uint32_t* doc_ids = nullptr;
 
-            num_tree->search(NUM_COMPARATOR::EQUALS, reference_doc_id, &doc_ids, doc_ids_len);
-
-            for (size_t j = 0; j < doc_ids_len; j++) {
-                auto doc_id = doc_ids[j];
+            for (const auto& doc_id: doc_ids) {
                 auto reference_doc_references_copy = reference_doc_references;
                 id_pairs.emplace_back(std::make_pair(doc_id, new single_filter_result_t(reference_doc_id,
                                                                                         std::move(reference_doc_references_copy),
                                                                                         false)));
                 unique_doc_ids.insert(doc_id);
             }
-
-            delete[] doc_ids;
-        }
+        });
 
         if (id_pairs.empty()) {
             return Option(filter_result);
@@ -2143,20 +2463,14 @@ Option<filter_result_t> Index::do_filtering_with_reference_ids(const std::string
     std::vector<std::pair<uint32_t, uint32_t>> id_pairs;
     std::unordered_set<uint32_t> unique_doc_ids;
 
-    for (uint32_t i = 0; i < count; i++) {
+    num_tree->visit_ids_of_values(reference_docs, count, [&](size_t i, const std::vector<uint32_t>& doc_ids) {
         auto& reference_doc_id = reference_docs[i];
-        size_t doc_ids_len = 0;
-        uint32_t* doc_ids = nullptr;
 
-        num_tree->search(NUM_COMPARATOR::EQUALS, reference_doc_id, &doc_ids, doc_ids_len);
-
-        for (size_t j = 0; j < doc_ids_len; j++) {
-            auto doc_id = doc_ids[j];
+        for (const auto& doc_id: doc_ids) {
             id_pairs.emplace_back(std::make_pair(doc_id, reference_doc_id));
             unique_doc_ids.insert(doc_id);
         }
-        delete[] doc_ids;
-    }
+    });
 
     if (id_pairs.empty()) {
         return Option(filter_result);
@@ -2567,7 +2881,7 @@ bool Index::check_for_overrides(const token_ordering& token_order, const string&
 
             uint32_t* filter_ids = nullptr;
             filter_result_iterator_t filter_result_it(filter_ids, 0);
-            std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> field_values{};
+            std::array<sort_column_t*, 3> field_values{};
             const std::vector<size_t> geopoint_indices;
             tsl::htrie_map<char, token_leaf> qtoken_set;
 
@@ -2643,6 +2957,31 @@ Option<bool> Index::search_infix(const std::string& query, const std::string& fi
                                                                    "search by specifying `\"infix\": true` in the schema.");
     }
 
+    auto search_tree = search_index.at(field_name);
+
+    auto trigram_index_it = infix_trigram_index.find(field_name);
+    if(trigram_index_it != infix_trigram_index.end()) {
+        std::vector<std::string> tokens;
+        if(trigram_index_it->second->search(query, max_extra_prefix, max_extra_suffix, tokens)) {
+            std::vector<void*> posting_lists;
+            for(const auto& token: tokens) {
+                art_leaf* l = (art_leaf *) art_search(search_tree, (const unsigned char *) token.c_str(),
+                                                      token.size()+1);
+                if(l != nullptr) {
+                    posting_lists.push_back(l->values);
+                }
+            }
+
+            if(!posting_lists.empty()) {
+                posting_t::merge(posting_lists, ids);
+            }
+
+            return Option<bool>(true);
+        }
+
+        // query is shorter than a trigram: scan the tokens
+    }
+
     auto infix_sets = infix_maps_it->second;
     std::vector<art_leaf*> leaves;
 
@@ -2650,14 +2989,13 @@ Option<bool> Index::search_infix(const std::string& query, const std::string& fi
     std::mutex m_process;
     std::condition_variable cv_process;
 
-    auto search_tree = search_index.at(field_name);
-
     const auto parent_search_begin = search_begin_us;
     const auto parent_search_stop_ms = search_stop_us;
     auto parent_search_cutoff = search_cutoff;
 
     for(auto infix_set: infix_sets) {
-        thread_pool->enqueue([infix_set, &leaves, search_tree, &query, max_extra_prefix, max_extra_suffix,
+        thread_pool->enqueue_with_priority(ThreadPool::HIGH_PRIORITY,
+                             [infix_set, &leaves, search_tree, &query, max_extra_prefix, max_extra_suffix,
                                      &num_processed, &m_process, &cv_process,
                                      &parent_search_begin, &parent_search_stop_ms, &parent_search_cutoff]() {
 
@@ -2743,7 +3081,12 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                    facet_index_type_t facet_index_type,
                    bool enable_typos_for_numerical_tokens,
                    bool enable_lazy_filter) const {
+    const auto lock_wait_begin = std::chrono::steady_clock::now();
     std::shared_lock lock(mutex);
+    AppMetrics::get_instance().record_index_lock_wait(false, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - lock_wait_begin).count());
+
+    search_profile_timer_t filter_timer("filter");
 
     auto filter_result_iterator = new filter_result_iterator_t(collection_name, this, filter_tree_root,
                                                                search_begin_us, search_stop_us);
@@ -2759,16 +3102,23 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
     }
 
 #ifdef TEST_BUILD
+    const bool materialize_filter = filter_result_iterator->approx_filter_ids_length > 20;
+#else
+    const bool materialize_filter = !enable_lazy_filter || filter_result_iterator->approx_filter_ids_length < 25'000;
+#endif
 
-    if (filter_result_iterator->approx_filter_ids_length > 20) {
-        filter_result_iterator->compute_iterators();
+    if (search_profile != nullptr && filter_tree_root != nullptr) {
+        auto filter_plan = filter_result_iterator->get_plan();
+        filter_plan["strategy"] = materialize_filter ? "materialized" : "lazy";
+        search_profile->set_filter_plan(std::move(filter_plan));
     }
-#else
 
-    if (!enable_lazy_filter || filter_result_iterator->approx_filter_ids_length < 25'000) {
+    if (materialize_filter) {
         filter_result_iterator->compute_iterators();
     }
-#endif
+
+    filter_timer.stop();
+    search_profile_timer_t matching_timer("matching");
 
     size_t fetch_size = offset + per_page;
 
@@ -2781,6 +3131,11 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                         group_missing_values, filter_curated_hits,
                         filter_result_iterator, curated_ids, included_ids_map,
                         included_ids_vec, excluded_group_ids);
+
+    // documents that are deleted, but not purged yet, are excluded like the hidden hits of an override
+    const std::vector<uint32_t>& deleted_ids = get_deleted_ids();
+    curated_ids.insert(deleted_ids.begin(), deleted_ids.end());
+
     filter_result_iterator->reset();
     search_cutoff = search_cutoff || filter_result_iterator->validity == filter_result_iterator_t::timed_out;
 
@@ -2799,7 +3154,7 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
     handle_exclusion(num_search_fields, field_query_tokens, the_fields, exclude_token_ids, exclude_token_ids_size);
 
     int sort_order[3];  // 1 or -1 based on DESC or ASC respectively
-    std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> field_values;
+    std::array<sort_column_t*, 3> field_values;
     std::vector<size_t> geopoint_indices;
     populate_sort_mapping(sort_order, geopoint_indices, sort_fields_std, field_values);
 
@@ -2817,6 +3172,11 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
     
     bool no_filters_provided = (filter_tree_root == nullptr && !filter_result_iterator->validity == filter_result_iterator_t::valid);
 
+    // The ids of all the matches are needed for facets, groups, curation and the fusion of a hybrid search. Without
+    // those, a wildcard search only counts the matches as it scores them.
+    const bool collect_result_ids = !facets.empty() || group_limit != 0 || !curated_ids.empty() ||
+                                    !vector_query.field_name.empty();
+
     // handle phrase searches
     if (!field_query_tokens[0].q_phrases.empty()) {
         auto do_phrase_search_op = do_phrase_search(num_search_fields, the_fields, field_query_tokens,
@@ -2861,7 +3221,7 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                 if (group_limit != 0) {
                     distinct_id = 1;
                     for(auto& kv : group_by_field_it_vec) {
-                        get_distinct_id(kv.it, seq_id, kv.is_array, group_missing_values, distinct_id, true);
+                        get_distinct_id(kv, seq_id, group_missing_values, distinct_id, true);
                     }
                     if(excluded_group_ids.count(distinct_id) != 0) {
                        continue;
@@ -2872,15 +3232,22 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                 scores[0] = seq_id;
                 int64_t match_score_index = -1;
 
-                result_ids.push_back(seq_id);
                 KV kv(searched_queries.size(), seq_id, distinct_id, match_score_index, scores);
+                if (topster->has_search_after && !topster->is_after_cursor(&kv)) {
+                    // documents up to a `search_after` cursor are not part of the page
+                    it.previous();
+                    continue;
+                }
+
+                result_ids.push_back(seq_id);
                 int ret = topster->add(&kv);
 
                 if(group_limit != 0 && ret < 2) {
                     groups_processed[distinct_id]++;
                 }
 
-                if (result_ids.size() == fetch_size) {
+                // documents arrive in the order of the sort, so the top groups are settled once they are full
+                if (group_limit != 0 ? topster->are_top_groups_full(fetch_size) : result_ids.size() == fetch_size) {
                     break;
                 }
 
@@ -2891,14 +3258,33 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
             goto process_search_results;
         }
 
+        if(no_filters_provided && facets.empty() && curated_ids.empty() && vector_query.field_name.empty() &&
+           group_limit == 0 && excluded_result_ids_size == 0 && fetch_size != 0 && !topster->has_search_after &&
+           sort_fields_std.size() == 1 && sort_fields_std[0].order == sort_field_const::asc &&
+           sort_fields_std[0].reference_collection_name.empty() &&
+           geopoint_indices.size() == 1 && geopoint_indices[0] == 0 && field_values[0] != nullptr &&
+           field_values[0]->size() >= fetch_size) {
+            // only a page of the documents nearest to the reference point is needed, and documents without
+            // a location can't make it into that page
+            auto nearest_op = search_nearest_geopoints(sort_fields_std, sort_order, field_values, geopoint_indices,
+                                                       fetch_size, topster, searched_queries.size(),
+                                                       collection_name);
+            if(!nearest_op.ok()) {
+                return nearest_op;
+            }
+
+            all_result_ids_len = seq_ids->num_ids();
+            goto process_search_results;
+        }
+
         collate_included_ids({}, included_ids_map, curated_topster, searched_queries);
 
         if (!vector_query.field_name.empty()) {
             auto k = vector_query.k == 0 ? std::max<size_t>(vector_query.k, fetch_size) : vector_query.k;
 
             if(vector_query.query_doc_given) {
-                // since we will omit the query doc from results
-                k++;
+                // since we will omit the query docs from results
+                k += 1 + vector_query.extra_seq_ids.size();
             }
 
             VectorFilterFunctor filterFunctor(filter_result_iterator, excluded_result_ids, excluded_result_ids_size);
@@ -2906,51 +3292,127 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
 
             std::vector<std::pair<float, single_filter_result_t>> dist_results;
 
+            const size_t num_query_vectors = vector_query.num_query_vectors();
+            std::vector<std::vector<float>> normalized_qs(num_query_vectors);
+            std::vector<const float*> query_values(num_query_vectors);
+
+            for(size_t q = 0; q < num_query_vectors; q++) {
+                const auto& values = vector_query.get_query_vector(q);
+                if(field_vector_index->distance_type == cosine) {
+                    normalized_qs[q].resize(values.size());
+                    hnsw_index_t::normalize_vector(values, normalized_qs[q]);
+                }
+
+                query_values[q] = normalized_qs[q].empty() ? values.data() : normalized_qs[q].data();
+            }
+
+            // an explicit cutoff is honoured, otherwise a filter is scored flat when that's cheaper than a walk
+            size_t flat_search_cutoff = vector_query.flat_search_cutoff;
+            size_t ef = vector_query.ef;
+            bool auto_flat_search = false;
+
+            if(!no_filters_provided && !vector_query.flat_search_cutoff_given) {
+                const size_t num_filtered = filter_result_iterator->approx_filter_ids_length;
+                auto_flat_search = field_vector_index->prefer_flat_search(num_filtered, k, vector_query.ef);
+                flat_search_cutoff = auto_flat_search ? UINT32_MAX : 0;
+                ef = field_vector_index->get_filtered_ef(num_filtered, k, vector_query.ef);
+            }
+
+            // the filtered ids are scored in batches, which are offloaded to the GPU when they are large enough
+            constexpr size_t CPU_BATCH_SIZE = 256;
+            const size_t batch_size = GpuVectorScorer::get_instance().is_available() ? GpuVectorScorer::BATCH_SIZE :
+                                      CPU_BATCH_SIZE;
+            std::vector<uint32_t> batch_ids;
+            std::vector<single_filter_result_t> batch_results;
+            std::vector<float> batch_distances;
+            size_t num_processed = 0;
+
             uint32_t filter_id_count = 0;
             while (!no_filters_provided &&
-                    filter_id_count < vector_query.flat_search_cutoff && filter_result_iterator->validity == filter_result_iterator_t::valid) {
-                auto& seq_id = filter_result_iterator->seq_id;
-                auto filter_result = single_filter_result_t(seq_id, std::move(filter_result_iterator->reference));
-                filter_result_iterator->next();
-                std::vector<float> values;
-
-                try {
-                    values = field_vector_index->vecdex->getDataByLabel<float>(seq_id);
-                } catch(...) {
-                    // likely not found
-                    continue;
-                }
+                    filter_id_count < flat_search_cutoff && filter_result_iterator->validity == filter_result_iterator_t::valid) {
+                const size_t batch_limit = std::min<size_t>(batch_size, flat_search_cutoff - filter_id_count);
+                while(batch_ids.size() < batch_limit &&
+                      filter_result_iterator->validity == filter_result_iterator_t::valid) {
+                    auto& seq_id = filter_result_iterator->seq_id;
+                    batch_ids.push_back(seq_id);
+                    batch_results.emplace_back(seq_id, std::move(filter_result_iterator->reference));
+                    filter_result_iterator->next();
+                }
+
+                // a document is as near as the nearest of the query vectors
+                field_vector_index->flat_distances(query_values.data(), num_query_vectors, batch_ids.data(),
+                                                   batch_ids.size(), batch_distances);
+
+                for(size_t i = 0; i < batch_ids.size(); i++) {
+                    if(batch_distances[i] == std::numeric_limits<float>::infinity()) {
+                        // likely not found
+                        continue;
+                    }
 
-                float dist;
-                if(field_vector_index->distance_type == cosine) {
-                    std::vector<float> normalized_q(vector_query.values.size());
-                    hnsw_index_t::normalize_vector(vector_query.values, normalized_q);
-                    dist = field_vector_index->space->get_dist_func()(normalized_q.data(), values.data(),
-                                                                      &field_vector_index->num_dim);
-                } else {
-                    dist = field_vector_index->space->get_dist_func()(vector_query.values.data(), values.data(),
-                                                                      &field_vector_index->num_dim);
+                    dist_results.emplace_back(batch_distances[i], std::move(batch_results[i]));
+                    filter_id_count++;
                 }
 
-                dist_results.emplace_back(dist, filter_result);
-                filter_id_count++;
+                const size_t prev_num_processed = num_processed;
+                num_processed += batch_ids.size();
+                batch_ids.clear();
+                batch_results.clear();
+
+                // check for search cutoff but only once every 2^12 docs to reduce overhead
+                if((prev_num_processed >> 12) != (num_processed >> 12) && search_deadline_t::check_expired()) {
+                    break;
+                }
             }
             filter_result_iterator->reset();
             search_cutoff = search_cutoff || filter_result_iterator->validity == filter_result_iterator_t::timed_out;
 
+            if(auto_flat_search && dist_results.size() > k) {
+                // as many results as a walk would find
+                std::nth_element(dist_results.begin(), dist_results.begin() + k, dist_results.end(),
+                                 [](const auto& a, const auto& b) { return a.first < b.first; });
+                dist_results.resize(k);
+            }
+
             if(no_filters_provided ||
-                (filter_id_count >= vector_query.flat_search_cutoff && filter_result_iterator->validity == filter_result_iterator_t::valid)) {
+                (filter_id_count >= flat_search_cutoff && filter_result_iterator->validity == filter_result_iterator_t::valid)) {
                 dist_results.clear();
 
                 VectorFilterFunctor filterFunctor(filter_result_iterator);
 
-                std::vector<std::pair<float, size_t>> pairs;
-                if(field_vector_index->distance_type == cosine) {
-                    std::vector<float> normalized_q(vector_query.values.size());
-                    hnsw_index_t::normalize_vector(vector_query.values, normalized_q);
-                    pairs = field_vector_index->vecdex->searchKnnCloserFirst(normalized_q.data(), k, vector_query.ef, &filterFunctor);
-                } else {
-                    pairs = field_vector_index->vecdex->searchKnnCloserFirst(vector_query.values.data(), k, vector_query.ef, &filterFunctor);
+                if(num_query_vectors > 1 && !no_filters_provided &&
+                   !filter_result_iterator->_get_is_filter_result_initialized()) {
+                    // evaluated once for the walks of all the query vectors
+                    filter_result_iterator->compute_iterators();
+                }
+
+                std::vector<std::pair<float, size_t>> pairs = field_vector_index->search_knn(query_values[0], k, ef,
+                                                                                              &filterFunctor);
+
+                if(num_query_vectors > 1) {
+                    // the walks share the visited lists of the graph, and a document found by several of them keeps
+                    // its nearest distance
+                    std::unordered_map<size_t, size_t> pair_indices;
+                    for(size_t p = 0; p < pairs.size(); p++) {
+                        pair_indices.emplace(pairs[p].second, p);
+                    }
+
+                    for(size_t q = 1; q < num_query_vectors; q++) {
+                        for(const auto& pair: field_vector_index->search_knn(query_values[q], k, ef, &filterFunctor)) {
+                            auto index_it = pair_indices.find(pair.second);
+                            if(index_it == pair_indices.end()) {
+                                pair_indices.emplace(pair.second, pairs.size());
+                                pairs.push_back(pair);
+                            } else if(pair.first < pairs[index_it->second].first) {
+                                pairs[index_it->second].first = pair.first;
+                            }
+                        }
+                    }
+
+                    if(pairs.size() > k) {
+                        std::nth_element(pairs.begin(), pairs.begin() + k, pairs.end(),
+                                         [](const auto& a, const auto& b) { return a.first < b.first; });
+                        pairs.resize(k);
+                    }
                 }
 
                 std::sort(pairs.begin(), pairs.end(), [](auto& x, auto& y) {
@@ -2983,8 +3445,6 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
             }
 
             std::vector<uint32_t> nearest_ids;
-            std::vector<uint32_t> eval_filter_indexes;
-
             std::vector<group_by_field_it_t> group_by_field_it_vec;
             if (group_limit != 0) {
                 group_by_field_it_vec = get_group_by_field_iterators(group_by_fields);
@@ -2994,7 +3454,7 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                 auto& seq_id = dist_result.second.seq_id;
                 auto references = std::move(dist_result.second.reference_filter_results);
 
-                if(vector_query.query_doc_given && vector_query.seq_id == seq_id) {
+                if(vector_query.is_query_doc(seq_id)) {
                     continue;
                 }
 
@@ -3002,7 +3462,7 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                 if (group_limit != 0) {
                     distinct_id = 1;
                     for(auto &kv : group_by_field_it_vec) {
-                        get_distinct_id(kv.it, seq_id, kv.is_array, group_missing_values, distinct_id);
+                        get_distinct_id(kv, seq_id, group_missing_values, distinct_id);
                     }
 
                     if(excluded_group_ids.count(distinct_id) != 0) {
@@ -3021,7 +3481,7 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                 int64_t match_score_index = -1;
 
                 auto compute_sort_scores_op = compute_sort_scores(sort_fields_std, sort_order, field_values,
-                                                                  geopoint_indices, seq_id, references, eval_filter_indexes,
+                                                                  geopoint_indices, seq_id, references,
                                                                   0, scores, match_score_index, vec_dist_score,
                                                                   collection_name);
                 if (!compute_sort_scores_op.ok()) {
@@ -3059,18 +3519,53 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                                                       excluded_result_ids, excluded_result_ids_size, excluded_group_ids,
                                                       all_result_ids, all_result_ids_len,
                                                       filter_result_iterator, concurrency,
-                                                      sort_order, field_values, geopoint_indices, collection_name);
+                                                      sort_order, field_values, geopoint_indices,
+                                                      collect_result_ids, collection_name);
             if (!search_wildcard_op.ok()) {
                 return search_wildcard_op;
             }
         }
 
-        uint32_t _all_result_ids_len = all_result_ids_len;
-        curate_filtered_ids(curated_ids, excluded_result_ids,
-                            excluded_result_ids_size, all_result_ids, _all_result_ids_len, curated_ids_sorted);
-        all_result_ids_len = _all_result_ids_len;
+        // a count without the result ids already leaves out the excluded ones
+        if (all_result_ids != nullptr || all_result_ids_len == 0) {
+            uint32_t _all_result_ids_len = all_result_ids_len;
+            curate_filtered_ids(curated_ids, excluded_result_ids,
+                                excluded_result_ids_size, all_result_ids, _all_result_ids_len, curated_ids_sorted);
+            all_result_ids_len = _all_result_ids_len;
+        }
     } else {
         // Non-wildcard
+
+        // The vector leg of a hybrid search doesn't depend on the text match until the two are fused, so it runs
+        // alongside the text search, on a filter iterator of its own. Phrases narrow the filter iterator that the
+        // vector leg would use, so those searches run it after the text search.
+        std::vector<std::pair<uint32_t, float>> hybrid_vec_results;
+        bool hybrid_vector_cutoff = false;
+        std::unique_ptr<filter_result_iterator_t> hybrid_filter_iterator;
+        // declared last, so that an early return waits for the task before what it refers to goes away
+        std::unique_ptr<pool_task_t> hybrid_vector_task;
+
+        const bool is_hybrid_search = !vector_query.field_name.empty() &&
+            std::any_of(sort_fields_std.begin(), sort_fields_std.end(), [](const sort_by& sort_field) {
+                return sort_field.name == sort_field_const::text_match;
+            });
+
+        if(is_hybrid_search && field_query_tokens[0].q_phrases.empty() && thread_pool != nullptr) {
+            hybrid_filter_iterator = std::make_unique<filter_result_iterator_t>(collection_name, this, filter_tree_root,
+                                                                                search_begin_us, search_stop_us);
+            if(hybrid_filter_iterator->init_status().ok()) {
+                if(materialize_filter) {
+                    hybrid_filter_iterator->compute_iterators();
+                }
+
+                hybrid_vector_task = std::make_unique<pool_task_t>(thread_pool, [&]() {
+                    hybrid_vector_search(vector_query, fetch_size, hybrid_filter_iterator.get(), no_filters_provided,
+                                         excluded_result_ids, excluded_result_ids_size, hybrid_vec_results,
+                                         hybrid_vector_cutoff);
+                }, ThreadPool::HIGH_PRIORITY);
+            }
+        }
+
         // In multi-field searches, a record can be matched across different fields, so we use this for aggregation
         //begin = std::chrono::high_resolution_clock::now();
 
@@ -3123,39 +3618,85 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
             }
         }
 
-        auto fuzzy_search_fields_op = fuzzy_search_fields(the_fields, field_query_tokens[0].q_include_tokens, {}, match_type,
-                                                          excluded_result_ids, excluded_result_ids_size,
-                                                          filter_result_iterator, curated_ids_sorted,
-                                                          excluded_group_ids, sort_fields_std, num_typos,
-                                                          searched_queries, qtoken_set, topster, groups_processed,
-                                                          all_result_ids, all_result_ids_len,
-                                                          group_limit, group_by_fields, group_missing_values, prioritize_exact_match,
-                                                          prioritize_token_position, prioritize_num_matching_fields,
-                                                          query_hashes, token_order, prefixes,
-                                                          typo_tokens_threshold, exhaustive_search,
-                                                          max_candidates, min_len_1typo, min_len_2typo,
-                                                          syn_orig_num_tokens, sort_order, field_values, geopoint_indices,
-                                                          collection_name, enable_typos_for_numerical_tokens);
-        if (!fuzzy_search_fields_op.ok()) {
-            return fuzzy_search_fields_op;
-        }
-
-        // try split/joining tokens if no results are found
-        if(split_join_tokens == always || (all_result_ids_len == 0 && split_join_tokens == fallback)) {
-            std::vector<std::vector<std::string>> space_resolved_queries;
+        // Splitting and joining the tokens of the query only reads the index, so when the query is likely to find no
+        // results, its alternatives are resolved alongside the first pass, and cancelled if that pass finds some.
+        std::vector<std::vector<std::string>> space_resolved_queries;
+        std::atomic<bool> space_resolution_cancelled = false;
 
+        auto resolve_space_in_fields = [&](const std::atomic<bool>* cancelled) {
             for (size_t i = 0; i < num_search_fields; i++) {
                 std::vector<std::string> orig_q_include_tokens;
                 for(auto& q_include_token: field_query_tokens[i].q_include_tokens) {
                     orig_q_include_tokens.push_back(q_include_token.value);
                 }
 
-                resolve_space_as_typos(orig_q_include_tokens, the_fields[i].name,space_resolved_queries);
+                resolve_space_as_typos(orig_q_include_tokens, the_fields[i].name, space_resolved_queries, cancelled);
 
                 if (!space_resolved_queries.empty()) {
                     break;
                 }
             }
+        };
+
+        std::unique_ptr<pool_task_t> space_resolution_task;
+
+        if(thread_pool != nullptr && (split_join_tokens == always ||
+           (split_join_tokens == fallback &&
+            likely_sparse_results(field_query_tokens[0].q_include_tokens, the_fields[0].name, 1)))) {
+            space_resolution_task = std::make_unique<pool_task_t>(thread_pool, [&]() {
+                resolve_space_in_fields(&space_resolution_cancelled);
+            }, ThreadPool::HIGH_PRIORITY);
+        }
+
+        // A query that equals whole values of the fields with an exact match index is answered with one lookup, and
+        // when that finds enough results, the fuzzy search is skipped like the typo corrections of a search would be.
+        auto exact_match_op = search_exact_match_index(num_search_fields, the_fields, match_type,
+                                                       field_query_tokens[0].q_include_tokens, sort_fields_std,
+                                                       searched_queries, qtoken_set, group_limit, group_by_fields,
+                                                       group_missing_values, prioritize_exact_match,
+                                                       prioritize_token_position, prioritize_num_matching_fields,
+                                                       topster, filter_result_iterator,
+                                                       excluded_result_ids, excluded_result_ids_size,
+                                                       sort_order, field_values, geopoint_indices,
+                                                       curated_ids_sorted, excluded_group_ids,
+                                                       all_result_ids, all_result_ids_len, groups_processed,
+                                                       collection_name);
+        if (!exact_match_op.ok()) {
+            space_resolution_cancelled = true;
+            return exact_match_op;
+        }
+
+        const size_t exact_results_count = group_limit != 0 ? groups_processed.size() : all_result_ids_len;
+        const bool exact_match_found = (exact_results_count != 0 && !exhaustive_search &&
+                                        exact_results_count >= typo_tokens_threshold);
+
+        if(!exact_match_found) {
+            auto fuzzy_search_fields_op = fuzzy_search_fields(the_fields, field_query_tokens[0].q_include_tokens, {}, match_type,
+                                                              excluded_result_ids, excluded_result_ids_size,
+                                                              filter_result_iterator, curated_ids_sorted,
+                                                              excluded_group_ids, sort_fields_std, num_typos,
+                                                              searched_queries, qtoken_set, topster, groups_processed,
+                                                              all_result_ids, all_result_ids_len,
+                                                              group_limit, group_by_fields, group_missing_values, prioritize_exact_match,
+                                                              prioritize_token_position, prioritize_num_matching_fields,
+                                                              query_hashes, token_order, prefixes,
+                                                              typo_tokens_threshold, exhaustive_search,
+                                                              max_candidates, min_len_1typo, min_len_2typo,
+                                                              syn_orig_num_tokens, sort_order, field_values, geopoint_indices,
+                                                              collection_name, enable_typos_for_numerical_tokens, concurrency);
+            if (!fuzzy_search_fields_op.ok()) {
+                space_resolution_cancelled = true;
+                return fuzzy_search_fields_op;
+            }
+        }
+
+        // try split/joining tokens if no results are found
+        if(split_join_tokens == always || (all_result_ids_len == 0 && split_join_tokens == fallback)) {
+            if(space_resolution_task != nullptr) {
+                space_resolution_task->wait();
+            } else {
+                resolve_space_in_fields(nullptr);
+            }
 
             // only one query is resolved for now, so just use that
             if (!space_resolved_queries.empty()) {
@@ -3181,11 +3722,14 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                                                                   prefixes, typo_tokens_threshold, exhaustive_search,
                                                                   max_candidates, min_len_1typo, min_len_2typo,
                                                                   syn_orig_num_tokens, sort_order, field_values, geopoint_indices,
-                                                                  collection_name);
+                                                                  collection_name, true, concurrency);
                 if (!fuzzy_search_fields_op.ok()) {
                     return fuzzy_search_fields_op;
                 }
             }
+        } else if(space_resolution_task != nullptr) {
+            space_resolution_cancelled = true;
+            space_resolution_task->wait();
         }
 
         // do synonym based searches
@@ -3285,7 +3829,7 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                                                                           token_order, prefixes, typo_tokens_threshold,
                                                                           exhaustive_search, max_candidates, min_len_1typo,
                                                                           min_len_2typo, -1, sort_order, field_values, geopoint_indices,
-                                                                          collection_name);
+                                                                          collection_name, true, concurrency);
                         if (!fuzzy_search_fields_op.ok()) {
                             return fuzzy_search_fields_op;
                         }
@@ -3329,38 +3873,16 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                 const float VECTOR_SEARCH_WEIGHT = vector_query.alpha;
                 const float TEXT_MATCH_WEIGHT = 1.0 - VECTOR_SEARCH_WEIGHT;
 
-                VectorFilterFunctor filterFunctor(filter_result_iterator, excluded_result_ids, excluded_result_ids_size);
-                auto& field_vector_index = vector_index.at(vector_query.field_name);
-
-                std::vector<std::pair<float, size_t>> dist_labels;
-                // use k as 100 by default for ensuring results stability in pagination
-                size_t default_k = 100;
-                auto k = vector_query.k == 0 ? std::max<size_t>(fetch_size, default_k) : vector_query.k;
-                if(field_vector_index->distance_type == cosine) {
-                    std::vector<float> normalized_q(vector_query.values.size());
-                    hnsw_index_t::normalize_vector(vector_query.values, normalized_q);
-                    dist_labels = field_vector_index->vecdex->searchKnnCloserFirst(normalized_q.data(), k, vector_query.ef, &filterFunctor);
-                } else {
-                    dist_labels = field_vector_index->vecdex->searchKnnCloserFirst(vector_query.values.data(), k, vector_query.ef, &filterFunctor);
-                }
-                filter_result_iterator->reset();
-                search_cutoff = search_cutoff || filter_result_iterator->validity == filter_result_iterator_t::timed_out;
-
                 std::vector<std::pair<uint32_t,float>> vec_results;
-                for (const auto& dist_label : dist_labels) {
-                    uint32_t seq_id = dist_label.second;
-
-                    auto vec_dist_score = (field_vector_index->distance_type == cosine) ? std::abs(dist_label.first) :
-                                            dist_label.first;
-                    if(vec_dist_score > vector_query.distance_threshold) {
-                        continue;
-                    }
-                    vec_results.emplace_back(seq_id, vec_dist_score);
+                if(hybrid_vector_task != nullptr) {
+                    hybrid_vector_task->wait();
+                    hybrid_vector_task.reset();
+                    vec_results = std::move(hybrid_vec_results);
+                    search_cutoff = search_cutoff || hybrid_vector_cutoff;
+                } else {
+                    hybrid_vector_search(vector_query, fetch_size, filter_result_iterator, no_filters_provided,
+                                         excluded_result_ids, excluded_result_ids_size, vec_results, search_cutoff);
                 }
-                
-                std::sort(vec_results.begin(), vec_results.end(), [](const auto& a, const auto& b) {
-                    return a.second < b.second;
-                });
 
                 std::vector<KV*> kvs;
                 if(group_limit != 0) {
@@ -3370,9 +3892,14 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                         }
                     }
                     
-                    std::sort(kvs.begin(), kvs.end(), Topster::is_greater);
+                    if(thread_pool != nullptr && concurrency > 1) {
+                        thread_pool->parallel_sort(kvs.begin(), kvs.end(), Topster::is_greater, concurrency,
+                                                   ThreadPool::HIGH_PRIORITY);
+                    } else {
+                        std::sort(kvs.begin(), kvs.end(), Topster::is_greater);
+                    }
                 } else {
-                    topster->sort();
+                    topster->sort(thread_pool, concurrency);
                 }
 
                 
@@ -3392,8 +3919,6 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                 }
 
                 std::vector<uint32_t> vec_search_ids;  // list of IDs found only in vector search
-                std::vector<uint32_t> eval_filter_indexes;
-
                 std::vector<group_by_field_it_t> group_by_field_it_vec;
                 if (group_limit != 0) {
                     group_by_field_it_vec = get_group_by_field_iterators(group_by_fields);
@@ -3439,7 +3964,7 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                         int64_t scores[3] = {0};
 
                         auto compute_sort_scores_op = compute_sort_scores(sort_fields_std, sort_order, field_values,
-                                                                          geopoint_indices, seq_id, references, eval_filter_indexes,
+                                                                          geopoint_indices, seq_id, references,
                                                                           match_score, scores, match_score_index,
                                                                           vec_result.second, collection_name);
                         if (!compute_sort_scores_op.ok()) {
@@ -3460,7 +3985,7 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                         int64_t match_score_index = -1;
 
                         auto compute_sort_scores_op = compute_sort_scores(sort_fields_std, sort_order, field_values,
-                                                                          geopoint_indices, seq_id, references, eval_filter_indexes,
+                                                                          geopoint_indices, seq_id, references,
                                                                           match_score, scores, match_score_index,
                                                                           vec_result.second, collection_name);
                         if (!compute_sort_scores_op.ok()) {
@@ -3472,7 +3997,7 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                             distinct_id = 1;
 
                             for(auto& kv : group_by_field_it_vec) {
-                                get_distinct_id(kv.it, seq_id, kv.is_array, group_missing_values, distinct_id);
+                                get_distinct_id(kv, seq_id, group_missing_values, distinct_id);
                             }
 
                             if(excluded_group_ids.count(distinct_id) != 0) {
@@ -3513,6 +4038,9 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
 
     process_search_results:
 
+    matching_timer.stop();
+    search_profile_timer_t facets_timer("facets");
+
     delete [] exclude_token_ids;
     delete [] excluded_result_ids;
 
@@ -3520,7 +4048,29 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
                             all_result_ids_len > facet_sample_threshold);
     bool is_wildcard_no_filter_query = is_wildcard_non_phrase_query && no_filters_provided;
 
-    if(!facets.empty()) {
+    // counts of a facet query depend on the query of the facet values as well, so they are not cached
+    std::string facet_cache_key;
+    facet_result_cache_t::facets_t cached_facets = nullptr;
+
+    if(!facets.empty() && facet_query.query.empty()) {
+        const std::string facet_params = std::to_string(max_facet_values) + ":" + std::to_string(group_limit) + ":" +
+                                         StringUtils::join(group_by_fields, ",") + ":" +
+                                         std::to_string(group_missing_values) + ":" +
+                                         std::to_string(estimate_facets ? facet_sample_percent : 100) + ":" +
+                                         std::to_string(is_wildcard_no_filter_query) + ":" +
+                                         std::to_string(facet_index_type);
+        // the results of a wildcard query are often every document, which needs no hashing to be told apart
+        const bool all_documents = (all_result_ids_len == seq_ids->num_ids());
+        facet_cache_key = facet_result_cache_t::get_key(facets, facet_params, all_result_ids, all_result_ids_len,
+                                                        all_documents);
+        cached_facets = facet_result_cache.get(facet_cache_key, write_generation);
+    }
+
+    if(cached_facets != nullptr) {
+        for(size_t i = 0; i < facets.size(); i++) {
+            facet_result_cache_t::copy_counts((*cached_facets)[i], facets[i]);
+        }
+    } else if(!facets.empty()) {
         const size_t num_threads = std::min(concurrency, all_result_ids_len);
 
         const size_t window_size = (num_threads == 0) ? 0 :
@@ -3541,7 +4091,7 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
         for(size_t i = 0; i < facets.size(); i++) {
             const auto& this_facet = facets[i];
 #ifdef TEST_BUILD
-            if(facet_index_type == VALUE) {
+            if(facet_index_type == VALUE || facet_infos[i].approximate) {
 #else
             if(facet_infos[i].use_value_index) {
 #endif
@@ -3564,9 +4114,10 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
         size_t num_queued = 0;
         size_t result_index = 0;
 
-        const auto parent_search_begin = search_begin_us;
-        const auto parent_search_stop_ms = search_stop_us;
+        const auto parent_deadline = search_deadline_t::current();
         auto parent_search_cutoff = search_cutoff;
+        const auto parent_search_profile = search_profile;
+        const auto parent_request_cost = request_cost;
 
         //auto beginF = std::chrono::high_resolution_clock::now();
 
@@ -3584,15 +4135,17 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
             uint32_t* batch_result_ids = all_result_ids + result_index;
             num_queued++;
 
-            thread_pool->enqueue([this, thread_id, &facets, &facet_batches, &facet_query, group_limit, group_by_fields,
+            thread_pool->enqueue_with_priority(ThreadPool::HIGH_PRIORITY,
+                                 [this, thread_id, &facets, &facet_batches, &facet_query, group_limit, group_by_fields,
                                          batch_result_ids, batch_res_len, &facet_infos, max_facet_values,
                                          is_wildcard_no_filter_query, estimate_facets,
                                          facet_sample_percent, group_missing_values,
-                                         &parent_search_begin, &parent_search_stop_ms, &parent_search_cutoff,
+                                         parent_deadline, &parent_search_cutoff,
+                                         parent_search_profile, parent_request_cost,
                                          &num_processed, &m_process, &cv_process, facet_index_type]() {
-                search_begin_us = parent_search_begin;
-                search_stop_us = parent_search_stop_ms;
-                search_cutoff = false;
+                search_deadline_scope_t deadline_scope(parent_deadline);
+                search_profile_scope_t profile_scope(parent_search_profile);
+                request_cost_scope_t cost_scope(parent_request_cost);
 
                 auto fq = facet_query;
                 do_facets(facet_batches[thread_id], fq, estimate_facets, facet_sample_percent,
@@ -3624,15 +4177,17 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
 
             num_queued++;
 
-            thread_pool->enqueue([this, thread_id, &facets, &value_facets, &facet_query, group_limit, group_by_fields,
+            thread_pool->enqueue_with_priority(ThreadPool::HIGH_PRIORITY,
+                                 [this, thread_id, &facets, &value_facets, &facet_query, group_limit, group_by_fields,
                                          all_result_ids, all_result_ids_len, &facet_infos, max_facet_values,
                                          is_wildcard_no_filter_query, estimate_facets,
                                          facet_sample_percent, group_missing_values,
-                                         &parent_search_begin, &parent_search_stop_ms, &parent_search_cutoff,
+                                         parent_deadline, &parent_search_cutoff,
+                                         parent_search_profile, parent_request_cost,
                                          &num_processed, &m_process, &cv_process, facet_index_type]() {
-                search_begin_us = parent_search_begin;
-                search_stop_us = parent_search_stop_ms;
-                search_cutoff = false;
+                search_deadline_scope_t deadline_scope(parent_deadline);
+                search_profile_scope_t profile_scope(parent_search_profile);
+                request_cost_scope_t cost_scope(parent_request_cost);
 
                 auto fq = facet_query;
 
@@ -3676,6 +4231,13 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
             }
         }
 
+        add_numeric_facet_totals(facets, facet_infos);
+
+        if(!facet_cache_key.empty() && !search_cutoff) {
+            facet_result_cache.insert(facet_cache_key, write_generation,
+                                      std::make_shared<const std::vector<facet>>(facets));
+        }
+
         /*long long int timeMillisF = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::high_resolution_clock::now() - beginF).count();
         LOG(INFO) << "Time for faceting: " << timeMillisF;*/
@@ -3690,6 +4252,7 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
               facet_infos, group_limit, group_by_fields, group_missing_values, &included_ids_vec[0], 
               included_ids_vec.size(), max_facet_values, is_wildcard_no_filter_query,
               facet_index_type);
+    add_numeric_facet_totals(facets, facet_infos);
 
     all_result_ids_len += curated_topster->size;
 
@@ -3720,6 +4283,7 @@ Option<bool> Index::search(std::vector<query_tokens_t>& field_query_tokens, cons
 
 void Index::aggregate_facet(const size_t group_limit, facet& this_facet, facet& acc_facet) const {
     acc_facet.is_intersected = this_facet.is_intersected;
+    acc_facet.strategy_basis = this_facet.strategy_basis;
     acc_facet.is_sort_by_alpha = this_facet.is_sort_by_alpha;
     acc_facet.sort_order = this_facet.sort_order;
     acc_facet.sort_field = this_facet.sort_field;
@@ -3761,6 +4325,7 @@ void Index::aggregate_facet(const size_t group_limit, facet& this_facet, facet&
         }
 
         acc_facet.value_result_map[facet_kv.first].count = count;
+        acc_facet.value_result_map[facet_kv.first].error_bound += facet_kv.second.error_bound;
 
         acc_facet.value_result_map[facet_kv.first].doc_id = facet_kv.second.doc_id;
         acc_facet.value_result_map[facet_kv.first].array_pos = facet_kv.second.array_pos;
@@ -3800,7 +4365,7 @@ void Index::process_curated_ids(const std::vector<std::pair<uint32_t, uint32_t>>
         for(auto seq_id: included_ids_vec) {
             uint64_t distinct_id = 1;
             for(auto& kv : group_by_field_it_vec) {
-                get_distinct_id(kv.it, seq_id, kv.is_array, group_missing_values, distinct_id);
+                get_distinct_id(kv, seq_id, group_missing_values, distinct_id);
             }
 
             excluded_group_ids.emplace(distinct_id);
@@ -3902,10 +4467,11 @@ Option<bool> Index::fuzzy_search_fields(const std::vector<search_field_t>& the_f
                                         size_t min_len_2typo,
                                         int syn_orig_num_tokens,
                                         const int* sort_order,
-                                        std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values,
+                                        std::array<sort_column_t*, 3>& field_values,
                                         const std::vector<size_t>& geopoint_indices,
                                         const std::string& collection_name,
-                                        bool enable_typos_for_numerical_tokens) const {
+                                        bool enable_typos_for_numerical_tokens,
+                                        const size_t concurrency) const {
 
     // NOTE: `query_tokens` preserve original tokens, while `search_tokens` could be a result of dropped tokens
 
@@ -3935,6 +4501,74 @@ Option<bool> Index::fuzzy_search_fields(const std::vector<search_field_t>& the_f
 
     const size_t num_search_fields = std::min(the_fields.size(), (size_t) FIELD_LIMIT_NUM);
 
+    // Traversals for typo costs are the expensive ones, so the first time a token has to be searched with typos, all
+    // tokens are searched in all fields at all costs above 0 at once.
+    std::vector<std::vector<std::vector<std::vector<const art_node*>>>> typo_nodes;
+    bool typo_nodes_searched = false;
+
+    // entries can leave the typo candidate cache while this search is using their nodes
+    std::vector<typo_candidate_cache_t::candidates_t> searched_candidates;
+
+    // Nodes matched by the token at `cost` in the tree `tree_name` of the field, from the typo candidate cache or
+    // else from a traversal of the tree.
+    auto get_fuzzy_nodes = [&](size_t field_id, const std::string& tree_name, size_t token_index, int cost,
+                               bool prefix_search, int token_len) -> const std::vector<const art_node*>& {
+        const std::string& token = query_tokens[token_index].value;
+        const std::string cache_key = typo_candidate_cache_t::get_key(tree_name, token, cost, prefix_search);
+
+        auto candidates = typo_candidate_cache.get(cache_key, write_generation);
+
+        if(candidates == nullptr && prefix_search) {
+            // resumes from the walk of the previous keystroke, when it is still cached
+            typo_candidate_cache_t::candidates_t prev_candidates;
+            if(token.size() > 1) {
+                const std::string prev_keystroke_token = token.substr(0, token.size() - 1);
+                prev_candidates = typo_candidate_cache.get(
+                        typo_candidate_cache_t::get_key(tree_name, prev_keystroke_token, cost, true),
+                        write_generation);
+            }
+
+            auto prefix_candidates = std::make_shared<typo_candidates_t>();
+            art_fuzzy_search_prefix(search_index.at(tree_name), (const unsigned char *) token.c_str(), token_len,
+                                    cost, prev_candidates ? &prev_candidates->frontier : nullptr,
+                                    prefix_candidates->nodes, prefix_candidates->frontier);
+            candidates = std::move(prefix_candidates);
+        }
+
+        if(candidates == nullptr && cost != 0) {
+            if(!typo_nodes_searched) {
+                fuzzy_search_typo_nodes(the_fields, num_search_fields, query_tokens, token_to_costs, concurrency,
+                                        typo_nodes);
+                typo_nodes_searched = true;
+            }
+
+            // batch traversed the tree of `faceted_name()`
+            const auto& token_nodes = typo_nodes[field_id][token_index];
+            if(search_schema.at(the_fields[field_id].name).faceted_name() == tree_name &&
+               size_t(cost) <= token_nodes.size()) {
+                auto typo_candidates = std::make_shared<typo_candidates_t>();
+                typo_candidates->nodes = token_nodes[cost - 1];
+                candidates = std::move(typo_candidates);
+            }
+        }
+
+        if(candidates == nullptr) {
+            std::vector<std::vector<std::vector<const art_node*>>> query_nodes;
+            art_fuzzy_search_batch(search_index.at(tree_name),
+                                   {art_fuzzy_query_t{(const unsigned char *) token.c_str(), token_len,
+                                                      cost, cost, prefix_search}},
+                                   query_nodes);
+
+            auto query_candidates = std::make_shared<typo_candidates_t>();
+            query_candidates->nodes = std::move(query_nodes[0][0]);
+            candidates = std::move(query_candidates);
+        }
+
+        typo_candidate_cache.insert(cache_key, write_generation, candidates);
+        searched_candidates.push_back(candidates);
+        return candidates->nodes;
+    };
+
     auto product = []( long long a, std::vector<int>& b ) { return a*b.size(); };
     long long n = 0;
     long long int N = token_to_costs.size() > 30 ? 1 :
@@ -3966,8 +4600,9 @@ Option<bool> Index::fuzzy_search_fields(const std::vector<search_field_t>& the_f
             const std::string token_cost_hash = token + std::to_string(costs[token_index]);
 
             std::vector<std::string> leaf_tokens;
+            const bool is_cached_cost = token_cost_cache.count(token_cost_hash) != 0;
 
-            if(token_cost_cache.count(token_cost_hash) != 0) {
+            if(is_cached_cost) {
                 leaf_tokens = token_cost_cache[token_cost_hash];
             } else {
                 //auto begin = std::chrono::high_resolution_clock::now();
@@ -4027,10 +4662,12 @@ Option<bool> Index::fuzzy_search_fields(const std::vector<search_field_t>& the_f
                     const auto& prev_token = last_token ? token_candidates_vec.back().candidates[0] : "";
 
                     std::vector<art_leaf*> field_leaves;
-                    art_fuzzy_search_i(search_index.at(search_field.faceted_name()),
-                                       (const unsigned char *) token.c_str(), token_len,
-                                     costs[token_index], costs[token_index], max_candidates, token_order, prefix_search,
-                                     last_token, prev_token, filter_result_iterator, field_leaves, unique_tokens);
+                    const auto& field_nodes = get_fuzzy_nodes(field_id, search_field.faceted_name(), token_index,
+                                                              costs[token_index], prefix_search, token_len);
+                    art_fuzzy_search_nodes(search_index.at(search_field.faceted_name()), field_nodes,
+                                           (const unsigned char *) token.c_str(), token_len,
+                                           costs[token_index], max_candidates, token_order, prefix_search,
+                                           last_token, prev_token, filter_result_iterator, field_leaves, unique_tokens);
                     filter_result_iterator->reset();
                     if (filter_result_iterator->validity == filter_result_iterator_t::timed_out) {
                         search_cutoff = true;
@@ -4088,9 +4725,12 @@ Option<bool> Index::fuzzy_search_fields(const std::vector<search_field_t>& the_f
                         }
 
                         std::vector<art_leaf*> field_leaves;
-                        art_fuzzy_search_i(search_index.at(the_field.name), (const unsigned char *) token.c_str(), token_len,
-                                         costs[token_index], costs[token_index], max_candidates, token_order, prefix_search,
-                                         false, "", filter_result_iterator, field_leaves, unique_tokens);
+                        const auto& field_nodes = get_fuzzy_nodes(field_id, the_field.name, token_index,
+                                                                  costs[token_index], prefix_search, token_len);
+                        art_fuzzy_search_nodes(search_index.at(the_field.name), field_nodes,
+                                               (const unsigned char *) token.c_str(), token_len,
+                                               costs[token_index], max_candidates, token_order, prefix_search,
+                                               false, "", filter_result_iterator, field_leaves, unique_tokens);
                         filter_result_iterator->reset();
                         if (filter_result_iterator->validity == filter_result_iterator_t::timed_out) {
                             search_cutoff = true;
@@ -4119,6 +4759,10 @@ Option<bool> Index::fuzzy_search_fields(const std::vector<search_field_t>& the_f
 
             token_done:
 
+            if(search_profile != nullptr && !is_cached_cost) {
+                search_profile->add_typo_candidates(costs[token_index], leaf_tokens.size());
+            }
+
             if(!leaf_tokens.empty()) {
                 //log_leaves(costs[token_index], token, leaves);
                 token_candidates_vec.push_back(tok_candidates{query_tokens[token_index], costs[token_index],
@@ -4159,7 +4803,7 @@ Option<bool> Index::fuzzy_search_fields(const std::vector<search_field_t>& the_f
                                                                   num_typos, prefixes, prioritize_exact_match, prioritize_token_position,
                                                                   prioritize_num_matching_fields, exhaustive_search, max_candidates,
                                                                   syn_orig_num_tokens, sort_order, field_values, geopoint_indices,
-                                                                  query_hashes, id_buff, collection_name);
+                                                                  query_hashes, id_buff, collection_name, concurrency);
             if (!search_all_candidates_op.ok()) {
                 return search_all_candidates_op;
             }
@@ -4190,6 +4834,75 @@ Option<bool> Index::fuzzy_search_fields(const std::vector<search_field_t>& the_f
     return Option<bool>(true);
 }
 
+void Index::fuzzy_search_typo_nodes(const std::vector<search_field_t>& the_fields, const size_t num_search_fields,
+                                    const std::vector<token_t>& query_tokens,
+                                    const std::vector<std::vector<int>>& token_to_costs,
+                                    const size_t concurrency,
+                                    std::vector<std::vector<std::vector<std::vector<const art_node*>>>>& typo_nodes) const {
+    typo_nodes.clear();
+    typo_nodes.resize(num_search_fields);
+
+    auto search_field_typo_nodes = [&](size_t field_id) {
+        const auto& the_field = the_fields[field_id];
+        const auto& search_field = search_schema.at(the_field.name);
+
+        int64_t field_num_typos = the_field.num_typos;
+        auto& locale = search_field.locale;
+        if(locale != "" && (locale == "zh" || locale == "ko" || locale == "ja")) {
+            // disable fuzzy trie traversal for CJK locales
+            field_num_typos = 0;
+        }
+
+        std::vector<art_fuzzy_query_t> queries;
+
+        for(size_t token_index = 0; token_index < query_tokens.size(); token_index++) {
+            const std::string& token = query_tokens[token_index].value;
+            const bool prefix_search = the_field.prefix && query_tokens[token_index].is_prefix_searched;
+            const int token_len = prefix_search ? (int) token.length() : (int) token.length() + 1;
+
+            if(prefix_search) {
+                // searched on their own, so that the walk of the next keystroke can resume from theirs
+                queries.push_back(art_fuzzy_query_t{(const unsigned char *) token.c_str(), token_len,
+                                                    1, 0, prefix_search});
+                continue;
+            }
+
+            const int64_t token_max_cost = token_to_costs[token_index].empty() ? 0 :
+                                           *std::max_element(token_to_costs[token_index].begin(),
+                                                             token_to_costs[token_index].end());
+            const int max_cost = std::min(token_max_cost, field_num_typos);
+
+            queries.push_back(art_fuzzy_query_t{(const unsigned char *) token.c_str(), token_len,
+                                                1, max_cost, prefix_search});
+        }
+
+        art_fuzzy_search_batch(search_index.at(search_field.faceted_name()), queries, typo_nodes[field_id]);
+    };
+
+    if(thread_pool == nullptr || concurrency <= 1 || num_search_fields <= 1) {
+        for(size_t field_id = 0; field_id < num_search_fields; field_id++) {
+            search_field_typo_nodes(field_id);
+        }
+
+        return ;
+    }
+
+    const auto parent_deadline = search_deadline_t::current();
+    const auto parent_request_cost = request_cost;
+    std::atomic<bool> tasks_cutoff = false;
+
+    thread_pool->parallel_for(0, num_search_fields, std::min(concurrency, num_search_fields),
+                              [&](size_t begin, size_t end) {
+        search_deadline_scope_t deadline_scope(parent_deadline, &tasks_cutoff);
+        request_cost_scope_t cost_scope(parent_request_cost);
+        for(size_t field_id = begin; field_id < end; field_id++) {
+            search_field_typo_nodes(field_id);
+        }
+    }, ThreadPool::HIGH_PRIORITY);
+
+    search_cutoff = search_cutoff || tasks_cutoff;
+}
+
 void Index::popular_fields_of_token(const spp::sparse_hash_map<std::string, art_tree*>& search_index,
                                     const std::string& previous_token,
                                     const std::vector<search_field_t>& the_fields,
@@ -4327,11 +5040,12 @@ Option<bool> Index::search_across_fields(const std::vector<token_t>& query_token
                                          const uint32_t* exclude_token_ids, size_t exclude_token_ids_size,
                                          const std::unordered_set<uint32_t>& excluded_group_ids,
                                          const int* sort_order,
-                                         std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values,
+                                         std::array<sort_column_t*, 3>& field_values,
                                          const std::vector<size_t>& geopoint_indices,
                                          std::vector<uint32_t>& id_buff,
                                          uint32_t*& all_result_ids, size_t& all_result_ids_len,
-                                         const std::string& collection_name) const {
+                                         const std::string& collection_name,
+                                         const size_t concurrency) const {
 
     std::vector<art_leaf*> query_suggestion;
 
@@ -4341,12 +5055,16 @@ Option<bool> Index::search_across_fields(const std::vector<token_t>& query_token
     // used to track plists that must be destructed once done
     std::vector<posting_list_t*> expanded_dropped_plists;
 
+    // posting list and field id of every field iterator, so that iterators can be re-created for parallel scoring
+    std::vector<std::vector<std::pair<posting_list_t*, uint32_t>>> dropped_token_plists;
+
     for(auto& dropped_token: dropped_tokens) {
         auto& token = dropped_token.value;
         auto token_c_str = (const unsigned char*) token.c_str();
 
         // convert token from each field into an or_iterator
         std::vector<posting_list_t::iterator_t> its;
+        std::vector<std::pair<posting_list_t*, uint32_t>> plists;
 
         for(size_t i = 0; i < the_fields.size(); i++) {
             const std::string& field_name = the_fields[i].name;
@@ -4366,14 +5084,17 @@ Option<bool> Index::search_across_fields(const std::vector<token_t>& query_token
                 posting_list_t* full_posting_list = compact_posting_list->to_full_posting_list();
                 expanded_dropped_plists.push_back(full_posting_list);
                 its.push_back(full_posting_list->new_iterator(nullptr, nullptr, i)); // moved, not copied
+                plists.emplace_back(full_posting_list, i);
             } else {
                 posting_list_t* full_posting_list = (posting_list_t*)(leaf->values);
                 its.push_back(full_posting_list->new_iterator(nullptr, nullptr, i)); // moved, not copied
+                plists.emplace_back(full_posting_list, i);
             }
         }
 
         or_iterator_t token_fields(its);
         dropped_token_its.push_back(std::move(token_fields));
+        dropped_token_plists.push_back(std::move(plists));
     }
 
     // one iterator for each token, each underlying iterator contains results of token across multiple fields
@@ -4382,6 +5103,11 @@ Option<bool> Index::search_across_fields(const std::vector<token_t>& query_token
     // used to track plists that must be destructed once done
     std::vector<posting_list_t*> expanded_plists;
 
+    std::vector<std::vector<std::pair<posting_list_t*, uint32_t>>> token_plists;
+
+    // the token with the fewest documents bounds the number of candidates
+    size_t max_num_candidates = std::numeric_limits<size_t>::max();
+
     result_iter_state_t istate(exclude_token_ids, exclude_token_ids_size, filter_result_iterator);
 
     // for each token, find the posting lists across all query_by fields
@@ -4393,6 +5119,8 @@ Option<bool> Index::search_across_fields(const std::vector<token_t>& query_token
         auto token_c_str = (const unsigned char*) token_str.c_str();
         const size_t token_len = token_str.size() + 1;
         std::vector<posting_list_t::iterator_t> its;
+        std::vector<std::pair<posting_list_t*, uint32_t>> plists;
+        size_t token_num_ids = 0;
 
         for(size_t i = 0; i < num_search_fields; i++) {
             const std::string& field_name = the_fields[i].name;
@@ -4427,9 +5155,13 @@ Option<bool> Index::search_across_fields(const std::vector<token_t>& query_token
                 posting_list_t* full_posting_list = compact_posting_list->to_full_posting_list();
                 expanded_plists.push_back(full_posting_list);
                 its.push_back(full_posting_list->new_iterator(nullptr, nullptr, i)); // moved, not copied
+                plists.emplace_back(full_posting_list, i);
+                token_num_ids += full_posting_list->num_ids();
             } else {
                 posting_list_t* full_posting_list = (posting_list_t*)(leaf->values);
                 its.push_back(full_posting_list->new_iterator(nullptr, nullptr, i)); // moved, not copied
+                plists.emplace_back(full_posting_list, i);
+                token_num_ids += full_posting_list->num_ids();
             }
         }
 
@@ -4441,46 +5173,21 @@ Option<bool> Index::search_across_fields(const std::vector<token_t>& query_token
 
         or_iterator_t token_fields(its);
         token_its.push_back(std::move(token_fields));
+        token_plists.push_back(std::move(plists));
+        max_num_candidates = std::min(max_num_candidates, token_num_ids);
     }
 
     std::vector<uint32_t> result_ids;
-    std::vector<uint32_t> eval_filter_indexes;
     Option<bool> status(true);
 
     auto group_by_field_it_vec = get_group_by_field_iterators(group_by_fields);
 
-    or_iterator_t::intersect(token_its, istate,
-                             [&](single_filter_result_t& filter_result, const std::vector<or_iterator_t>& its) {
-        auto& seq_id = filter_result.seq_id;
-
-        if(topster == nullptr) {
-            result_ids.push_back(seq_id);
-            return ;
-        }
-
-        auto references = std::move(filter_result.reference_filter_results);
-        //LOG(INFO) << "seq_id: " << seq_id;
-        // Convert [token -> fields] orientation to [field -> tokens] orientation
-        std::vector<std::vector<posting_list_t::iterator_t>> field_to_tokens(num_search_fields);
-
-        for(size_t ti = 0; ti < its.size(); ti++) {
-            const or_iterator_t& token_fields_iters = its[ti];
-            const std::vector<posting_list_t::iterator_t>& field_iters = token_fields_iters.get_its();
-
-            for(size_t fi = 0; fi < field_iters.size(); fi++) {
-                const posting_list_t::iterator_t& field_iter = field_iters[fi];
-                if(field_iter.id() == seq_id) {
-                    // not all fields might contain a given token
-                    field_to_tokens[field_iter.get_field_id()].push_back(field_iter.clone());
-                }
-            }
-        }
-
-        size_t query_len = query_tokens.size();
-
-        // check if seq_id exists in any of the dropped_token iters
-        for(size_t ti = 0; ti < dropped_token_its.size(); ti++) {
-            or_iterator_t& token_fields_iters = dropped_token_its[ti];
+    // Adds the postings of the dropped tokens that the candidate also contains.
+    auto add_dropped_token_postings = [&](const uint32_t seq_id, std::vector<or_iterator_t>& candidate_dropped_token_its,
+                                          std::vector<std::vector<posting_list_t::iterator_t>>& field_to_tokens,
+                                          size_t& query_len) {
+        for(size_t ti = 0; ti < candidate_dropped_token_its.size(); ti++) {
+            or_iterator_t& token_fields_iters = candidate_dropped_token_its[ti];
             if(token_fields_iters.skip_to(seq_id) && token_fields_iters.id() == seq_id) {
                 query_len++;
                 const std::vector<posting_list_t::iterator_t>& field_iters = token_fields_iters.get_its();
@@ -4493,7 +5200,15 @@ Option<bool> Index::search_across_fields(const std::vector<token_t>& query_token
                 }
             }
         }
+    };
 
+    // Scores a candidate whose matching postings are in `field_to_tokens`. Returns false when the candidate
+    // belongs to an excluded group.
+    auto score_candidate = [&](const uint32_t seq_id, std::map<std::string, reference_filter_result_t>& references,
+                               const std::vector<std::vector<posting_list_t::iterator_t>>& field_to_tokens,
+                               size_t query_len, std::vector<group_by_field_it_t>& group_by_field_its,
+                               Topster* const candidate_topster,
+                               spp::sparse_hash_map<uint64_t, uint32_t>& candidate_groups_processed) -> Option<bool> {
         if(syn_orig_num_tokens != -1) {
             query_len = syn_orig_num_tokens;
         }
@@ -4540,12 +5255,12 @@ Option<bool> Index::search_across_fields(const std::vector<token_t>& query_token
         uint64_t distinct_id = seq_id;
         if(group_limit != 0) {
             distinct_id = 1;
-            for(auto& kv : group_by_field_it_vec) {
-                get_distinct_id(kv.it, seq_id, kv.is_array, group_missing_values, distinct_id);
+            for(auto& kv : group_by_field_its) {
+                get_distinct_id(kv, seq_id, group_missing_values, distinct_id);
             }
 
             if(excluded_group_ids.count(distinct_id) != 0) {
-               return;
+               return Option<bool>(false);
            }
         }
 
@@ -4553,11 +5268,10 @@ Option<bool> Index::search_across_fields(const std::vector<token_t>& query_token
         int64_t match_score_index = -1;
 
         auto compute_sort_scores_op = compute_sort_scores(sort_fields, sort_order, field_values, geopoint_indices,
-                                                          seq_id, references, eval_filter_indexes, best_field_match_score,
+                                                          seq_id, references, best_field_match_score,
                                                           scores, match_score_index, 0, collection_name);
         if (!compute_sort_scores_op.ok()) {
-            status = Option<bool>(compute_sort_scores_op.code(), compute_sort_scores_op.error());
-            return;
+            return Option<bool>(compute_sort_scores_op.code(), compute_sort_scores_op.error());
         }
 
         query_len = std::min<size_t>(15, query_len);
@@ -4608,78 +5322,337 @@ Option<bool> Index::search_across_fields(const std::vector<token_t>& query_token
             kv.text_match_score = aggregated_score;
         }
 
-        int ret = topster->add(&kv);
+        int ret = candidate_topster->add(&kv);
         if(group_limit != 0 && ret < 2) {
-            groups_processed[distinct_id]++;
+            candidate_groups_processed[distinct_id]++;
         }
-        result_ids.push_back(seq_id);
-    });
 
-    if (!status.ok()) {
-        for(posting_list_t* plist: expanded_plists) {
-            delete plist;
-        }
-        for(posting_list_t* plist: expanded_dropped_plists) {
-            delete plist;
+        return Option<bool>(true);
+    };
+
+    // When the text match decides the order, every candidate of these tokens scores at most `max_match_score`, so
+    // once the topster is full of better scores, the remaining candidates are only counted and not scored.
+    const bool prune_by_text_match = (topster != nullptr && group_limit == 0 && total_cost <= 255 &&
+                                      field_values[0] == &text_match_sentinel_value);
+    int64_t max_match_score = 0;
+
+    if(prune_by_text_match) {
+        size_t max_tokens = std::max<int>(query_tokens.size() + dropped_tokens.size(), syn_orig_num_tokens);
+        size_t max_field_weight = 0;
+        for(const auto& search_field: the_fields) {
+            max_field_weight = std::max<size_t>(max_field_weight, search_field.weight);
         }
-        return status;
+
+        max_match_score = max_text_match_score(match_type, total_cost, max_tokens, max_field_weight);
     }
 
-    id_buff.insert(id_buff.end(), result_ids.begin(), result_ids.end());
+    auto cannot_enter_topster = [&]() {
+        return prune_by_text_match && topster->size >= topster->MAX_SIZE &&
+               topster->kvs[0]->scores[0] > max_match_score;
+    };
 
-    if(id_buff.size() > 100000) {
-        // prevents too many ORs during exhaustive searching
-        gfx::timsort(id_buff.begin(), id_buff.end());
-        id_buff.erase(std::unique( id_buff.begin(), id_buff.end() ), id_buff.end());
+    // when the intersection is large, candidates are only collected here and scored in parallel afterwards
+    const bool parallel_scoring = (topster != nullptr && concurrency > 1 && thread_pool != nullptr &&
+                                   max_num_candidates != std::numeric_limits<size_t>::max() &&
+                                   max_num_candidates >= PARALLEL_SCORING_MIN_CANDIDATES);
+    std::vector<std::pair<uint32_t, std::map<std::string, reference_filter_result_t>>> candidates;
 
-        uint32_t* new_all_result_ids = nullptr;
-        all_result_ids_len = ArrayUtils::or_scalar(all_result_ids, all_result_ids_len, &id_buff[0],
-                                                   id_buff.size(), &new_all_result_ids);
-        delete[] all_result_ids;
-        all_result_ids = new_all_result_ids;
-        id_buff.clear();
-    }
+    or_iterator_t::intersect(token_its, istate,
+                             [&](single_filter_result_t& filter_result, const std::vector<or_iterator_t>& its) {
+        auto& seq_id = filter_result.seq_id;
 
-    if(!result_ids.empty()) {
-        searched_queries.push_back(query_suggestion);
-        for(const auto& qtoken: query_tokens) {
-            qtoken_set.insert(qtoken.value, token_leaf(nullptr, qtoken.root_len, qtoken.num_typos, qtoken.is_prefix_searched));
+        if(topster == nullptr || cannot_enter_topster()) {
+            result_ids.push_back(seq_id);
+            return ;
         }
-    }
 
-    for(posting_list_t* plist: expanded_plists) {
-        delete plist;
-    }
+        if(parallel_scoring) {
+            candidates.emplace_back(seq_id, std::move(filter_result.reference_filter_results));
+            return ;
+        }
 
-    for(posting_list_t* plist: expanded_dropped_plists) {
-        delete plist;
-    }
+        auto references = std::move(filter_result.reference_filter_results);
+        //LOG(INFO) << "seq_id: " << seq_id;
+        // Convert [token -> fields] orientation to [field -> tokens] orientation
+        std::vector<std::vector<posting_list_t::iterator_t>> field_to_tokens(num_search_fields);
 
-    return Option<bool>(true);
-}
+        for(size_t ti = 0; ti < its.size(); ti++) {
+            const or_iterator_t& token_fields_iters = its[ti];
+            const std::vector<posting_list_t::iterator_t>& field_iters = token_fields_iters.get_its();
 
-Option<bool> Index::compute_sort_scores(const std::vector<sort_by>& sort_fields, const int* sort_order,
-                                        std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> field_values,
-                                        const std::vector<size_t>& geopoint_indices,
-                                        uint32_t seq_id, const std::map<basic_string<char>, reference_filter_result_t>& references,
-                                        std::vector<uint32_t>& filter_indexes, int64_t max_field_match_score, int64_t* scores,
-                                        int64_t& match_score_index, float vector_distance,
-                                        const std::string& collection_name) const {
+            for(size_t fi = 0; fi < field_iters.size(); fi++) {
+                const posting_list_t::iterator_t& field_iter = field_iters[fi];
+                if(field_iter.id() == seq_id) {
+                    // not all fields might contain a given token
+                    field_to_tokens[field_iter.get_field_id()].push_back(field_iter.clone());
+                }
+            }
+        }
 
-    int64_t geopoint_distances[3];
+        size_t query_len = query_tokens.size();
+        add_dropped_token_postings(seq_id, dropped_token_its, field_to_tokens, query_len);
 
-    for(auto& i: geopoint_indices) {
-        auto geopoints = field_values[i];
-        int64_t dist = INT32_MAX;
+        auto score_op = score_candidate(seq_id, references, field_to_tokens, query_len, group_by_field_it_vec,
+                                        topster, groups_processed);
+        if(!score_op.ok()) {
+            status = Option<bool>(score_op.code(), score_op.error());
+            return ;
+        }
 
-        S2LatLng reference_lat_lng;
-        GeoPoint::unpack_lat_lng(sort_fields[i].geopoint, reference_lat_lng);
+        if(score_op.get()) {
+            result_ids.push_back(seq_id);
+        }
+    });
 
-        if(geopoints != nullptr) {
-            auto it = geopoints->find(seq_id);
+    if(status.ok() && !candidates.empty()) {
+        // Score contiguous ranges of the candidates on separate threads, each with its own topster. Since the
+        // posting list iterators are stateful, every range walks its own iterators from the start of the range.
+        const size_t min_range_size = 1000;
+        const size_t num_threads = std::min<size_t>(concurrency, (candidates.size() + min_range_size - 1) / min_range_size);
+        const size_t window_size = (candidates.size() + num_threads - 1) / num_threads;  // rounds up
 
-            if(it != geopoints->end()) {
-                int64_t packed_latlng = it->second;
+        std::vector<Topster*> topsters(num_threads, nullptr);
+        std::vector<spp::sparse_hash_map<uint64_t, uint32_t>> tgroups_processed(num_threads);
+        std::vector<std::vector<uint32_t>> tresult_ids(num_threads);
+        std::vector<Option<bool>> tstatuses(num_threads, Option<bool>(true));
+
+        auto score_range = [&](const size_t thread_id, const size_t begin, const size_t end) {
+            std::vector<std::vector<posting_list_t::iterator_t>> range_token_its(token_plists.size());
+            for(size_t ti = 0; ti < token_plists.size(); ti++) {
+                for(const auto& plist_field: token_plists[ti]) {
+                    range_token_its[ti].push_back(plist_field.first->new_iterator(nullptr, nullptr, plist_field.second));
+                }
+            }
+
+            std::vector<or_iterator_t> range_dropped_token_its;
+            for(const auto& plist_fields: dropped_token_plists) {
+                std::vector<posting_list_t::iterator_t> its;
+                for(const auto& plist_field: plist_fields) {
+                    its.push_back(plist_field.first->new_iterator(nullptr, nullptr, plist_field.second));
+                }
+
+                or_iterator_t token_fields(its);
+                range_dropped_token_its.push_back(std::move(token_fields));
+            }
+
+            auto range_group_by_field_it_vec = get_group_by_field_iterators(group_by_fields);
+            for(size_t i = begin; i < end; i++) {
+                // a range that runs past the deadline stops, and its cutoff is folded into that of the search
+                if(((i - begin + 1) % (1 << 12)) == 0 && search_deadline_t::check_expired()) {
+                    break;
+                }
+
+                const uint32_t seq_id = candidates[i].first;
+                std::vector<std::vector<posting_list_t::iterator_t>> field_to_tokens(num_search_fields);
+
+                for(auto& field_iters: range_token_its) {
+                    for(auto& field_iter: field_iters) {
+                        if(field_iter.valid()) {
+                            field_iter.skip_to(seq_id);
+                        }
+
+                        if(field_iter.valid() && field_iter.id() == seq_id) {
+                            // not all fields might contain a given token
+                            field_to_tokens[field_iter.get_field_id()].push_back(field_iter.clone());
+                        }
+                    }
+                }
+
+                size_t query_len = query_tokens.size();
+                add_dropped_token_postings(seq_id, range_dropped_token_its, field_to_tokens, query_len);
+
+                auto score_op = score_candidate(seq_id, candidates[i].second, field_to_tokens, query_len,
+                                                range_group_by_field_it_vec, topsters[thread_id],
+                                                tgroups_processed[thread_id]);
+                if(!score_op.ok()) {
+                    tstatuses[thread_id] = Option<bool>(score_op.code(), score_op.error());
+                    break;
+                }
+
+                if(score_op.get()) {
+                    tresult_ids[thread_id].push_back(seq_id);
+                }
+            }
+        };
+
+        size_t num_processed = 0;
+        size_t num_queued = 0;
+        std::mutex m_process;
+        std::condition_variable cv_process;
+
+        const auto parent_deadline = search_deadline_t::current();
+        const auto parent_search_profile = search_profile;
+        const auto parent_request_cost = request_cost;
+        std::atomic<bool> tasks_cutoff = false;
+
+        for(size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+            const size_t begin = thread_id * window_size;
+            const size_t end = std::min(begin + window_size, candidates.size());
+            if(begin >= end) {
+                break;
+            }
+
+            topsters[thread_id] = new Topster(topster->MAX_SIZE, topster->distinct);
+            topsters[thread_id]->copy_search_after(*topster);
+            num_queued++;
+
+            thread_pool->enqueue_with_priority(ThreadPool::HIGH_PRIORITY,
+                                 [&, thread_id, begin, end]() {
+                {
+                    // cutoff of the task must be folded in before the search is signalled
+                    search_deadline_scope_t deadline_scope(parent_deadline, &tasks_cutoff);
+                    search_profile_scope_t profile_scope(parent_search_profile);
+                    request_cost_scope_t cost_scope(parent_request_cost);
+                    score_range(thread_id, begin, end);
+                }
+
+                std::unique_lock<std::mutex> lock(m_process);
+                num_processed++;
+                cv_process.notify_one();
+            });
+        }
+
+        std::unique_lock<std::mutex> lock_process(m_process);
+        cv_process.wait(lock_process, [&](){ return num_processed == num_queued; });
+
+        // the hits of a range that was cut off are partial, which the response has to report
+        search_cutoff = search_cutoff || tasks_cutoff;
+
+        for(size_t thread_id = 0; thread_id < num_queued; thread_id++) {
+            if(status.ok() && !tstatuses[thread_id].ok()) {
+                status = Option<bool>(tstatuses[thread_id].code(), tstatuses[thread_id].error());
+            }
+
+            if(status.ok()) {
+                for(const auto& it : tgroups_processed[thread_id]) {
+                    groups_processed[it.first] += it.second;
+                }
+
+                aggregate_topster(topster, topsters[thread_id]);
+                result_ids.insert(result_ids.end(), tresult_ids[thread_id].begin(), tresult_ids[thread_id].end());
+            }
+
+            delete topsters[thread_id];
+        }
+    }
+
+    if (!status.ok()) {
+        for(posting_list_t* plist: expanded_plists) {
+            delete plist;
+        }
+        for(posting_list_t* plist: expanded_dropped_plists) {
+            delete plist;
+        }
+        return status;
+    }
+
+    id_buff.insert(id_buff.end(), result_ids.begin(), result_ids.end());
+
+    if(id_buff.size() > 100000) {
+        // prevents too many ORs during exhaustive searching
+        gfx::timsort(id_buff.begin(), id_buff.end());
+        id_buff.erase(std::unique( id_buff.begin(), id_buff.end() ), id_buff.end());
+
+        uint32_t* new_all_result_ids = nullptr;
+        all_result_ids_len = ArrayUtils::or_scalar(all_result_ids, all_result_ids_len, &id_buff[0],
+                                                   id_buff.size(), &new_all_result_ids);
+        delete[] all_result_ids;
+        all_result_ids = new_all_result_ids;
+        id_buff.clear();
+    }
+
+    if(!result_ids.empty()) {
+        searched_queries.push_back(query_suggestion);
+        for(const auto& qtoken: query_tokens) {
+            qtoken_set.insert(qtoken.value, token_leaf(nullptr, qtoken.root_len, qtoken.num_typos, qtoken.is_prefix_searched));
+        }
+    }
+
+    for(posting_list_t* plist: expanded_plists) {
+        delete plist;
+    }
+
+    for(posting_list_t* plist: expanded_dropped_plists) {
+        delete plist;
+    }
+
+    return Option<bool>(true);
+}
+
+Option<bool> Index::search_nearest_geopoints(const std::vector<sort_by>& sort_fields, const int* sort_order,
+                                             const std::array<sort_column_t*, 3>& field_values,
+                                             const std::vector<size_t>& geopoint_indices, size_t fetch_size,
+                                             Topster* topster, size_t num_searched_queries,
+                                             const std::string& collection_name) const {
+    const auto& sort_field = sort_fields[0];
+    S2LatLng reference_lat_lng;
+    GeoPoint::unpack_lat_lng(sort_field.geopoint, reference_lat_lng);
+
+    // distances of the nearest `fetch_size` documents seen so far, farthest on top
+    std::priority_queue<int64_t> nearest_distances;
+    Option<bool> status(true);
+
+    auto visit_cell = [&](const S1ChordAngle& cell_distance, const std::vector<uint32_t>& ids) {
+        // the stored coordinates are rounded, so a point can lie slightly outside of its cell
+        int64_t min_distance = std::max<int64_t>(0, GeoPoint::distance(cell_distance.ToAngle()) - 1);
+        if(min_distance < sort_field.exclude_radius) {
+            min_distance = 0;
+        }
+
+        if(nearest_distances.size() == fetch_size && min_distance > nearest_distances.top()) {
+            // neither this cell nor the ones after it can have a nearer document
+            return false;
+        }
+
+        for(auto seq_id: ids) {
+            int64_t scores[3] = {0};
+            int64_t match_score_index = -1;
+
+            status = compute_sort_scores(sort_fields, sort_order, field_values, geopoint_indices, seq_id, {},
+                                         0, scores, match_score_index, 0, collection_name);
+            if(!status.ok()) {
+                return false;
+            }
+
+            KV kv(num_searched_queries, seq_id, seq_id, match_score_index, scores);
+            topster->add(&kv);
+
+            // ascending sort negates the distance
+            nearest_distances.push(-scores[0]);
+            if(nearest_distances.size() > fetch_size) {
+                nearest_distances.pop();
+            }
+        }
+
+        return true;
+    };
+
+    geo_range_index.at(sort_field.name)->search_nearest_geopoints(reference_lat_lng.ToPoint(), visit_cell);
+    return status;
+}
+
+Option<bool> Index::compute_sort_scores(const std::vector<sort_by>& sort_fields, const int* sort_order,
+                                        std::array<sort_column_t*, 3> field_values,
+                                        const std::vector<size_t>& geopoint_indices,
+                                        uint32_t seq_id, const std::map<basic_string<char>, reference_filter_result_t>& references,
+                                        int64_t max_field_match_score, int64_t* scores,
+                                        int64_t& match_score_index, float vector_distance,
+                                        const std::string& collection_name) const {
+
+    int64_t geopoint_distances[3];
+
+    for(auto& i: geopoint_indices) {
+        auto geopoints = field_values[i];
+        int64_t dist = INT32_MAX;
+
+        S2LatLng reference_lat_lng;
+        GeoPoint::unpack_lat_lng(sort_fields[i].geopoint, reference_lat_lng);
+
+        if(geopoints != nullptr) {
+            auto it = geopoints->find(seq_id);
+
+            if(it != geopoints->end()) {
+                int64_t packed_latlng = it->second;
                 S2LatLng s2_lat_lng;
                 GeoPoint::unpack_lat_lng(packed_latlng, s2_lat_lng);
                 dist = GeoPoint::distance(s2_lat_lng, reference_lat_lng);
@@ -4839,38 +5812,22 @@ Option<bool> Index::compute_sort_scores(const std::vector<sort_by>& sort_fields,
                 }
             }
         } else if(field_values[0] == &eval_sentinel_value) {
-            auto const& count = sort_fields[0].eval_expressions.size();
-            if (filter_indexes.empty()) {
-                filter_indexes = std::vector<uint32_t>(count, 0);
-            }
-
-            bool found = false;
-            uint32_t index = 0;
             auto const& eval = sort_fields[0].eval;
-            for (; index < count; index++) {
-                auto& filter_index = filter_indexes[index];
-                auto const& eval_ids = eval.eval_ids_vec[index];
-                auto const& eval_ids_count = eval.eval_ids_count_vec[index];
-                if (filter_index == 0 || filter_index < eval_ids_count) {
-                    // Returns iterator to the first element that is >= to value or last if no such element is found.
-                    filter_index = std::lower_bound(eval_ids + filter_index, eval_ids + eval_ids_count, seq_id) -
-                                                            eval_ids;
-
-                    if (filter_index < eval_ids_count && eval_ids[filter_index] == seq_id) {
-                        filter_index++;
-                        found = true;
-                        break;
-                    }
+            scores[0] = 0;
+
+            // the score of the first expression that matches the document
+            for (size_t index = 0; index < eval.eval_bitmaps.size(); index++) {
+                if (eval.eval_bitmaps[index]->contains(seq_id)) {
+                    scores[0] = eval.scores[index];
+                    break;
                 }
             }
-
-            scores[0] = found ? eval.scores[index] : 0;
         } else if(field_values[0] == &vector_distance_sentinel_value) {
             scores[0] = float_to_int64_t(vector_distance);
         } else if(field_values[0] == &vector_query_sentinel_value) {
             scores[0] = float_to_int64_t(2.0f);
             try {
-                const auto& values = sort_fields[0].vector_query.vector_index->vecdex->getDataByLabel<float>(seq_id);
+                const auto& values = sort_fields[0].vector_query.vector_index->get_vector(seq_id);
                 const auto& dist_func = sort_fields[0].vector_query.vector_index->space->get_dist_func();
                 float dist = dist_func(sort_fields[0].vector_query.query.values.data(), values.data(), &sort_fields[0].vector_query.vector_index->num_dim);
                 
@@ -5014,38 +5971,22 @@ Option<bool> Index::compute_sort_scores(const std::vector<sort_by>& sort_fields,
                 }
             }
         } else if(field_values[1] == &eval_sentinel_value) {
-            auto const& count = sort_fields[1].eval_expressions.size();
-            if (filter_indexes.empty()) {
-                filter_indexes = std::vector<uint32_t>(count, 0);
-            }
-
-            bool found = false;
-            uint32_t index = 0;
             auto const& eval = sort_fields[1].eval;
-            for (; index < count; index++) {
-                auto& filter_index = filter_indexes[index];
-                auto const& eval_ids = eval.eval_ids_vec[index];
-                auto const& eval_ids_count = eval.eval_ids_count_vec[index];
-                if (filter_index == 0 || filter_index < eval_ids_count) {
-                    // Returns iterator to the first element that is >= to value or last if no such element is found.
-                    filter_index = std::lower_bound(eval_ids + filter_index, eval_ids + eval_ids_count, seq_id) -
-                                   eval_ids;
-
-                    if (filter_index < eval_ids_count && eval_ids[filter_index] == seq_id) {
-                        filter_index++;
-                        found = true;
-                        break;
-                    }
+            scores[1] = 0;
+
+            // the score of the first expression that matches the document
+            for (size_t index = 0; index < eval.eval_bitmaps.size(); index++) {
+                if (eval.eval_bitmaps[index]->contains(seq_id)) {
+                    scores[1] = eval.scores[index];
+                    break;
                 }
             }
-
-            scores[1] = found ? eval.scores[index] : 0;
         }  else if(field_values[1] == &vector_distance_sentinel_value) {
             scores[1] = float_to_int64_t(vector_distance);
         } else if(field_values[1] == &vector_query_sentinel_value) {
             scores[1] = float_to_int64_t(2.0f);
             try {
-                const auto& values = sort_fields[1].vector_query.vector_index->vecdex->getDataByLabel<float>(seq_id);
+                const auto& values = sort_fields[1].vector_query.vector_index->get_vector(seq_id);
                 const auto& dist_func = sort_fields[1].vector_query.vector_index->space->get_dist_func();
                 float dist = dist_func(sort_fields[1].vector_query.query.values.data(), values.data(), &sort_fields[1].vector_query.vector_index->num_dim);
                 
@@ -5186,38 +6127,22 @@ Option<bool> Index::compute_sort_scores(const std::vector<sort_by>& sort_fields,
                 }
             }
         } else if(field_values[2] == &eval_sentinel_value) {
-            auto const& count = sort_fields[2].eval_expressions.size();
-            if (filter_indexes.empty()) {
-                filter_indexes = std::vector<uint32_t>(count, 0);
-            }
-
-            bool found = false;
-            uint32_t index = 0;
             auto const& eval = sort_fields[2].eval;
-            for (; index < count; index++) {
-                auto& filter_index = filter_indexes[index];
-                auto const& eval_ids = eval.eval_ids_vec[index];
-                auto const& eval_ids_count = eval.eval_ids_count_vec[index];
-                if (filter_index == 0 || filter_index < eval_ids_count) {
-                    // Returns iterator to the first element that is >= to value or last if no such element is found.
-                    filter_index = std::lower_bound(eval_ids + filter_index, eval_ids + eval_ids_count, seq_id) -
-                                   eval_ids;
-
-                    if (filter_index < eval_ids_count && eval_ids[filter_index] == seq_id) {
-                        filter_index++;
-                        found = true;
-                        break;
-                    }
+            scores[2] = 0;
+
+            // the score of the first expression that matches the document
+            for (size_t index = 0; index < eval.eval_bitmaps.size(); index++) {
+                if (eval.eval_bitmaps[index]->contains(seq_id)) {
+                    scores[2] = eval.scores[index];
+                    break;
                 }
             }
-
-            scores[2] = found ? eval.scores[index] : 0;
         } else if(field_values[2] == &vector_distance_sentinel_value) {
             scores[2] = float_to_int64_t(vector_distance);
         } else if(field_values[2] == &vector_query_sentinel_value) {
             scores[2] = float_to_int64_t(2.0f);
             try {
-                const auto& values = sort_fields[2].vector_query.vector_index->vecdex->getDataByLabel<float>(seq_id);
+                const auto& values = sort_fields[2].vector_query.vector_index->get_vector(seq_id);
                 const auto& dist_func = sort_fields[2].vector_query.vector_index->space->get_dist_func();
                 float dist = dist_func(sort_fields[2].vector_query.query.values.data(), values.data(), &sort_fields[2].vector_query.vector_index->num_dim);
                 
@@ -5251,7 +6176,7 @@ Option<bool> Index::do_phrase_search(const size_t num_search_fields, const std::
                                      const bool group_missing_values,
                                      Topster* actual_topster,
                                      const int sort_order[3],
-                                     std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> field_values,
+                                     std::array<sort_column_t*, 3> field_values,
                                      const std::vector<size_t>& geopoint_indices,
                                      const std::vector<uint32_t>& curated_ids_sorted,
                                      filter_result_iterator_t*& filter_result_iterator,
@@ -5371,8 +6296,6 @@ Option<bool> Index::do_phrase_search(const size_t num_search_fields, const std::
     all_result_ids_len = filter_result_iterator->to_filter_id_array(all_result_ids);
     filter_result_iterator->reset();
 
-    std::vector<uint32_t> eval_filter_indexes;
-
     std::vector<group_by_field_it_t> group_by_field_it_vec;
     if (group_limit != 0) {
         group_by_field_it_vec = get_group_by_field_iterators(group_by_fields);
@@ -5388,7 +6311,7 @@ Option<bool> Index::do_phrase_search(const size_t num_search_fields, const std::
         int64_t match_score_index = -1;
 
         auto compute_sort_scores_op = compute_sort_scores(sort_fields, sort_order, field_values, geopoint_indices,
-                                                          seq_id, references, eval_filter_indexes, match_score, scores,
+                                                          seq_id, references, match_score, scores,
                                                           match_score_index, 0, collection_name);
         if (!compute_sort_scores_op.ok()) {
             return compute_sort_scores_op;
@@ -5398,7 +6321,7 @@ Option<bool> Index::do_phrase_search(const size_t num_search_fields, const std::
         if(group_limit != 0) {
             distinct_id = 1;
             for(auto& kv : group_by_field_it_vec) {
-                get_distinct_id(kv.it, seq_id, kv.is_array, group_missing_values, distinct_id);
+                get_distinct_id(kv, seq_id, group_missing_values, distinct_id);
             }
 
             if(excluded_group_ids.count(distinct_id) != 0) {
@@ -5452,7 +6375,7 @@ Option<bool> Index::do_synonym_search(const std::vector<search_field_t>& the_fie
                                       filter_result_iterator_t* const filter_result_iterator,
                                       std::set<uint64>& query_hashes,
                                       const int* sort_order,
-                                      std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values,
+                                      std::array<sort_column_t*, 3>& field_values,
                                       const std::vector<size_t>& geopoint_indices,
                                       tsl::htrie_map<char, token_leaf>& qtoken_set,
                                       const std::string& collection_name) const {
@@ -5471,7 +6394,7 @@ Option<bool> Index::do_synonym_search(const std::vector<search_field_t>& the_fie
                                                           token_order, prefixes, typo_tokens_threshold, exhaustive_search,
                                                           max_candidates, min_len_1typo, min_len_2typo,
                                                           syn_orig_num_tokens, sort_order, field_values, geopoint_indices,
-                                                          collection_name);
+                                                          collection_name, true, concurrency);
         if (!fuzzy_search_fields_op.ok()) {
             return fuzzy_search_fields_op;
         }
@@ -5492,7 +6415,7 @@ Option<bool> Index::do_infix_search(const size_t num_search_fields, const std::v
                                     const std::vector<token_t>& query_tokens, Topster* actual_topster,
                                     filter_result_iterator_t* const filter_result_iterator,
                                     const int sort_order[3],
-                                    std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> field_values,
+                                    std::array<sort_column_t*, 3> field_values,
                                     const std::vector<size_t>& geopoint_indices,
                                     const std::vector<uint32_t>& curated_ids_sorted,
                                     const std::unordered_set<uint32_t>& excluded_group_ids,
@@ -5546,7 +6469,6 @@ Option<bool> Index::do_infix_search(const size_t num_search_fields, const std::v
                 }
 
                 bool field_is_array = search_schema.at(the_fields[field_id].name).is_array();
-                std::vector<uint32_t> eval_filter_indexes;
                 for(size_t i = 0; i < raw_infix_ids_length; i++) {
                     auto seq_id = raw_infix_ids[i];
                     std::map<std::string, reference_filter_result_t> references;
@@ -5563,7 +6485,7 @@ Option<bool> Index::do_infix_search(const size_t num_search_fields, const std::v
 
                     auto compute_sort_scores_op = compute_sort_scores(sort_fields, sort_order, field_values,
                                                                       geopoint_indices, seq_id, references,
-                                                                      eval_filter_indexes, 100, scores, match_score_index,
+                                                                      100, scores, match_score_index,
                                                                       0, collection_name);
                     if (!compute_sort_scores_op.ok()) {
                         return compute_sort_scores_op;
@@ -5573,7 +6495,7 @@ Option<bool> Index::do_infix_search(const size_t num_search_fields, const std::v
                     if(group_limit != 0) {
                         distinct_id = 1;
                         for(auto& kv : group_by_field_it_vec) {
-                            get_distinct_id(kv.it, seq_id, kv.is_array, group_missing_values, distinct_id);
+                            get_distinct_id(kv, seq_id, group_missing_values, distinct_id);
                         }
 
                         if(excluded_group_ids.count(distinct_id) != 0) {
@@ -5612,6 +6534,197 @@ Option<bool> Index::do_infix_search(const size_t num_search_fields, const std::v
     return Option<bool>(true);
 }
 
+Option<bool> Index::search_exact_match_index(const size_t num_search_fields,
+                                             const std::vector<search_field_t>& the_fields,
+                                             const text_match_type_t match_type,
+                                             const std::vector<token_t>& query_tokens,
+                                             const std::vector<sort_by>& sort_fields,
+                                             std::vector<std::vector<art_leaf*>>& searched_queries,
+                                             tsl::htrie_map<char, token_leaf>& qtoken_set,
+                                             const size_t group_limit,
+                                             const std::vector<std::string>& group_by_fields,
+                                             const bool group_missing_values,
+                                             const bool prioritize_exact_match,
+                                             const bool prioritize_token_position,
+                                             const bool prioritize_num_matching_fields,
+                                             Topster* actual_topster,
+                                             filter_result_iterator_t* const filter_result_iterator,
+                                             const uint32_t* exclude_token_ids, size_t exclude_token_ids_size,
+                                             const int sort_order[3],
+                                             std::array<sort_column_t*, 3> field_values,
+                                             const std::vector<size_t>& geopoint_indices,
+                                             const std::vector<uint32_t>& curated_ids_sorted,
+                                             const std::unordered_set<uint32_t>& excluded_group_ids,
+                                             uint32_t*& all_result_ids, size_t& all_result_ids_len,
+                                             spp::sparse_hash_map<uint64_t, uint32_t>& groups_processed,
+                                             const std::string& collection_name) const {
+    if(exact_match_index.empty() || query_tokens.empty()) {
+        return Option<bool>(true);
+    }
+
+    std::vector<std::string> tokens;
+    for(const auto& query_token: query_tokens) {
+        tokens.push_back(query_token.value);
+    }
+
+    const uint64_t value_hash = exact_match_hash(tokens);
+
+    struct exact_hit_t {
+        int64_t field_weight = 0;
+        uint32_t num_matching_fields = 0;
+    };
+
+    // seq_id => the best matching field
+    std::map<uint32_t, exact_hit_t> exact_hits;
+
+    for(size_t field_id = 0; field_id < num_search_fields; field_id++) {
+        auto exact_match_index_it = exact_match_index.find(the_fields[field_id].name);
+        if(exact_match_index_it == exact_match_index.end()) {
+            continue;
+        }
+
+        auto value_it = exact_match_index_it->second->find(value_hash);
+        if(value_it == exact_match_index_it->second->end()) {
+            continue;
+        }
+
+        // every field scores the same match, so the field of the largest weight is the best
+        for(const uint32_t seq_id: value_it->second) {
+            auto& exact_hit = exact_hits[seq_id];
+            exact_hit.field_weight = std::max<int64_t>(exact_hit.field_weight, the_fields[field_id].weight);
+            exact_hit.num_matching_fields++;
+        }
+    }
+
+    if(exact_hits.empty()) {
+        return Option<bool>(true);
+    }
+
+    std::vector<uint32_t> exact_ids;
+    exact_ids.reserve(exact_hits.size());
+    for(const auto& exact_hit: exact_hits) {
+        exact_ids.push_back(exact_hit.first);
+    }
+
+    if(!curated_ids_sorted.empty()) {
+        uint32_t* ids = nullptr;
+        const size_t ids_len = ArrayUtils::exclude_scalar(&exact_ids[0], exact_ids.size(), &curated_ids_sorted[0],
+                                                          curated_ids_sorted.size(), &ids);
+        exact_ids.assign(ids, ids + ids_len);
+        delete [] ids;
+    }
+
+    if(exclude_token_ids_size != 0 && !exact_ids.empty()) {
+        uint32_t* ids = nullptr;
+        const size_t ids_len = ArrayUtils::exclude_scalar(&exact_ids[0], exact_ids.size(), exclude_token_ids,
+                                                          exclude_token_ids_size, &ids);
+        exact_ids.assign(ids, ids + ids_len);
+        delete [] ids;
+    }
+
+    filter_result_t filtered_exact_ids;
+
+    if(filter_result_iterator->validity == filter_result_iterator_t::valid && !exact_ids.empty()) {
+        filter_result_iterator->and_scalar(&exact_ids[0], exact_ids.size(), filtered_exact_ids);
+        filter_result_iterator->reset();
+    } else if(!exact_ids.empty()) {
+        filtered_exact_ids.count = exact_ids.size();
+        filtered_exact_ids.docs = new uint32_t[exact_ids.size()];
+        std::copy(exact_ids.begin(), exact_ids.end(), filtered_exact_ids.docs);
+    }
+
+    if(filtered_exact_ids.count == 0) {
+        return Option<bool>(true);
+    }
+
+    std::vector<group_by_field_it_t> group_by_field_it_vec;
+    if(group_limit != 0) {
+        group_by_field_it_vec = get_group_by_field_iterators(group_by_fields);
+    }
+
+    // a verbatim match of every query token in the field, from its first position
+    const size_t num_tokens = std::min<size_t>(query_tokens.size(), 255);
+    const int64_t field_match_score = Match(num_tokens, num_tokens - 1, prioritize_token_position ? 0 : 255,
+                                            prioritize_exact_match).get_match_score(0, num_tokens);
+    const size_t query_len = std::min<size_t>(15, query_tokens.size());
+
+    for(size_t i = 0; i < filtered_exact_ids.count; i++) {
+        const uint32_t seq_id = filtered_exact_ids.docs[i];
+        std::map<std::string, reference_filter_result_t> references;
+        if(filtered_exact_ids.coll_to_references != nullptr) {
+            references = std::move(filtered_exact_ids.coll_to_references[i]);
+        }
+
+        uint64_t distinct_id = seq_id;
+        if(group_limit != 0) {
+            distinct_id = 1;
+            for(auto& kv : group_by_field_it_vec) {
+                get_distinct_id(kv, seq_id, group_missing_values, distinct_id);
+            }
+
+            if(excluded_group_ids.count(distinct_id) != 0) {
+                continue;
+            }
+        }
+
+        int64_t scores[3] = {0};
+        int64_t match_score_index = -1;
+
+        auto compute_sort_scores_op = compute_sort_scores(sort_fields, sort_order, field_values, geopoint_indices,
+                                                          seq_id, references, field_match_score,
+                                                          scores, match_score_index, 0, collection_name);
+        if(!compute_sort_scores_op.ok()) {
+            return compute_sort_scores_op;
+        }
+
+        // aggregated like the candidates of a fuzzy search, so that either can replace the other in the topster
+        const exact_hit_t& exact_hit = exact_hits[seq_id];
+        const auto max_field_weight = std::min<size_t>(FIELD_MAX_WEIGHT, exact_hit.field_weight);
+        const size_t num_matching_fields = prioritize_num_matching_fields ?
+                                           std::min<size_t>(7, exact_hit.num_matching_fields) : 0;
+
+        uint64_t aggregated_score = match_type == max_score ?
+                                    ((int64_t(query_len) << 59) |
+                                     (int64_t(field_match_score) << 11) |
+                                     (int64_t(max_field_weight) << 3) |
+                                     (int64_t(num_matching_fields) << 0))
+                                    :
+                                    ((int64_t(query_len) << 59) |
+                                     (int64_t(max_field_weight) << 51) |
+                                     (int64_t(field_match_score) << 3) |
+                                     (int64_t(num_matching_fields) << 0));
+
+        KV kv(searched_queries.size(), seq_id, distinct_id, match_score_index, scores, std::move(references));
+
+        if(match_score_index != -1) {
+            kv.scores[match_score_index] = aggregated_score;
+            kv.text_match_score = aggregated_score;
+        }
+
+        int ret = actual_topster->add(&kv);
+        if(group_limit != 0 && ret < 2) {
+            groups_processed[distinct_id]++;
+        }
+
+        if(((i + 1) % (1 << 12)) == 0) {
+            BREAK_CIRCUIT_BREAKER
+        }
+    }
+
+    uint32_t* new_all_result_ids = nullptr;
+    all_result_ids_len = ArrayUtils::or_scalar(all_result_ids, all_result_ids_len, filtered_exact_ids.docs,
+                                               filtered_exact_ids.count, &new_all_result_ids);
+    delete[] all_result_ids;
+    all_result_ids = new_all_result_ids;
+
+    searched_queries.push_back({});
+    for(const auto& query_token: query_tokens) {
+        qtoken_set.insert(query_token.value, token_leaf(nullptr, query_token.root_len, 0, false));
+    }
+
+    return Option<bool>(true);
+}
+
 void Index::handle_exclusion(const size_t num_search_fields, std::vector<query_tokens_t>& field_query_tokens,
                              const std::vector<search_field_t>& search_fields, uint32_t*& exclude_token_ids,
                              size_t& exclude_token_ids_size) const {
@@ -5698,7 +6811,43 @@ void Index::compute_facet_infos(const std::vector<facet>& facets, facet_query_t&
 
         bool facet_value_index_exists = facet_index_v4->has_value_index(facet_field.name);
 
-        if(a_facet.field_name == facet_query.field_name && !facet_query.query.empty()) {
+        // the heuristic is kept for the cases that only one of the strategies handles well regardless of cost
+        facet_infos[findex].num_results = all_result_ids_len;
+        facet_infos[findex].approximate = a_facet.approximate && (group_limit == 0) && a_facet.sort_field.empty() &&
+                                          facet_value_index_exists;
+        facet_infos[findex].measure_cost = !facet_infos[findex].approximate &&
+                                           (group_limit == 0) && a_facet.sort_field.empty() &&
+                                           !is_wildcard_no_filter_query && !a_facet.is_sort_by_alpha &&
+                                           facet_value_index_exists &&
+                                           facet_index_v4->has_hash_index(facet_field.name);
+
+        facet_cost_model_t::basis_t strategy_basis = facet_cost_model_t::HEURISTIC;
+        if(facet_infos[findex].measure_cost) {
+            facet_infos[findex].use_value_index = facet_cost_model.choose(facet_field.name, all_result_ids_len,
+                                                                          facet_infos[findex].use_value_index,
+                                                                          strategy_basis);
+        }
+
+        facet_infos[findex].strategy_basis = facet_cost_model_t::basis_name(strategy_basis);
+
+        if(facet_infos[findex].approximate) {
+            // the samples are of the value index
+            facet_infos[findex].use_value_index = true;
+            facet_infos[findex].strategy_basis = "approximate";
+        }
+
+#ifdef TEST_BUILD
+        const bool hash_facets = (facet_index_type != VALUE) && !facet_infos[findex].approximate;
+#else
+        const bool hash_facets = !(facet_value_index_exists && facet_infos[findex].use_value_index);
+#endif
+
+        // results are a subset of all the documents, so the same count means the same set
+        facet_infos[findex].use_stats_totals = facet_infos[findex].should_compute_stats && hash_facets &&
+                                               all_result_ids_len == total_docs &&
+                                               numeric_facet_totals.count(facet_field.name) != 0;
+
+        if(a_facet.field_name == facet_query.field_name && !facet_query.query.empty()) {
             facet_infos[findex].use_facet_query = true;
 
             if (facet_field.is_bool()) {
@@ -5741,7 +6890,7 @@ void Index::compute_facet_infos(const std::vector<facet>& facets, facet_query_t&
             std::copy(all_result_ids, all_result_ids + all_result_ids_len, filter_ids);
             filter_result_iterator_t filter_result_it(filter_ids, all_result_ids_len);
             tsl::htrie_map<char, token_leaf> qtoken_set;
-            std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> field_values{};
+            std::array<sort_column_t*, 3> field_values{};
             const std::vector<size_t> geopoint_indices;
 
             auto fuzzy_search_fields_op = fuzzy_search_fields(fq_fields, qtokens, {}, text_match_type_t::max_score, nullptr, 0,
@@ -5773,7 +6922,7 @@ void Index::compute_facet_infos(const std::vector<facet>& facets, facet_query_t&
                 //LOG(INFO) << "si: " << si << ", field_result_ids_len: " << field_result_ids_len;
 
 #ifdef TEST_BUILD
-                if(facet_index_type == VALUE) {
+                if(facet_index_type == VALUE || facet_infos[findex].approximate) {
 #else
                 if(facet_value_index_exists && facet_infos[findex].use_value_index) {
 #endif
@@ -5858,24 +7007,192 @@ void Index::curate_filtered_ids(const std::set<uint32_t>& curated_ids,
                                 const uint32_t* exclude_token_ids, size_t exclude_token_ids_size,
                                 uint32_t*& filter_ids, uint32_t& filter_ids_length,
                                 const std::vector<uint32_t>& curated_ids_sorted) const {
+    if(filter_ids_length == 0) {
+        return ;
+    }
+
     if(!curated_ids.empty()) {
-        uint32_t *excluded_result_ids = nullptr;
-        filter_ids_length = ArrayUtils::exclude_scalar(filter_ids, filter_ids_length, &curated_ids_sorted[0],
-                                                       curated_ids_sorted.size(), &excluded_result_ids);
+        uint32_t *excluded_result_ids = new uint32_t[filter_ids_length];
+        filter_ids_length = ArrayUtils::exclude_simd(filter_ids, filter_ids_length, &curated_ids_sorted[0],
+                                                     curated_ids_sorted.size(), excluded_result_ids);
         delete [] filter_ids;
         filter_ids = excluded_result_ids;
     }
 
     // Exclude document IDs associated with excluded tokens from the result set
     if(exclude_token_ids_size != 0) {
-        uint32_t *excluded_result_ids = nullptr;
-        filter_ids_length = ArrayUtils::exclude_scalar(filter_ids, filter_ids_length, exclude_token_ids,
-                                                       exclude_token_ids_size, &excluded_result_ids);
+        uint32_t *excluded_result_ids = new uint32_t[filter_ids_length];
+        filter_ids_length = ArrayUtils::exclude_simd(filter_ids, filter_ids_length, exclude_token_ids,
+                                                     exclude_token_ids_size, excluded_result_ids);
         delete[] filter_ids;
         filter_ids = excluded_result_ids;
     }
 }
 
+static bool has_reference_filter(filter_node_t const* const filter_tree_root) {
+    if (filter_tree_root == nullptr) {
+        return false;
+    }
+
+    if (!filter_tree_root->isOperator) {
+        return !filter_tree_root->filter_exp.referenced_collection_name.empty();
+    }
+
+    return has_reference_filter(filter_tree_root->left) || has_reference_filter(filter_tree_root->right);
+}
+
+Option<bool> Index::search_wildcard_in_sort_order(filter_node_t const* const& filter_tree_root,
+                                                  const std::vector<sort_by>& sort_fields, Topster* topster,
+                                                  std::vector<std::vector<art_leaf*>>& searched_queries,
+                                                  const size_t group_limit, const uint32_t* exclude_token_ids,
+                                                  size_t exclude_token_ids_size,
+                                                  uint32_t*& all_result_ids, size_t& all_result_ids_len,
+                                                  filter_result_iterator_t* const filter_result_iterator,
+                                                  const int* sort_order,
+                                                  std::array<sort_column_t*, 3>& field_values,
+                                                  const std::vector<size_t>& geopoint_indices,
+                                                  const std::string& collection_name, bool& walked) const {
+    walked = false;
+
+    // Only a plain numerical first sort field has its values in the same order as its scores. Missing values
+    // put first, groups and joins need every match to be looked at, so those are scored as usual.
+    if (sort_fields.empty() || group_limit != 0 || !sort_fields[0].reference_collection_name.empty() ||
+        sort_fields[0].missing_values == sort_by::missing_values_t::first ||
+        filter_result_iterator->validity != filter_result_iterator_t::valid ||
+        std::find(geopoint_indices.begin(), geopoint_indices.end(), 0) != geopoint_indices.end()) {
+        return Option<bool>(true);
+    }
+
+    const auto& sort_field_name = sort_fields[0].name;
+    auto sort_index_it = sort_index.find(sort_field_name);
+    auto num_tree_it = numerical_index.find(sort_field_name);
+    if (sort_index_it == sort_index.end() || field_values[0] != sort_index_it->second ||
+        num_tree_it == numerical_index.end() || has_reference_filter(filter_tree_root)) {
+        return Option<bool>(true);
+    }
+
+    // With the matches spread evenly across the values, about `K * num_docs / num_matches` documents are visited
+    // before K matches are found. That has to be well below the number of matches for the walk to pay off.
+    const size_t num_docs = seq_ids->num_ids();
+    const size_t approx_num_matches = filter_result_iterator->approx_filter_ids_length;
+    const size_t k = topster->MAX_SIZE;
+    if (approx_num_matches < WILDCARD_SORT_ORDER_MIN_MATCHES ||
+        k * num_docs * WILDCARD_SORT_ORDER_MIN_GAIN >= approx_num_matches * approx_num_matches) {
+        return Option<bool>(true);
+    }
+
+    walked = true;
+
+    // all the matches are needed anyway for facets and the found count
+    all_result_ids_len = filter_result_iterator->to_filter_id_array(all_result_ids);
+    search_cutoff = search_cutoff || filter_result_iterator->validity == filter_result_iterator_t::timed_out;
+
+    const uint32_t* result_ids_begin = all_result_ids;
+    const uint32_t* result_ids_end = all_result_ids + all_result_ids_len;
+    const uint32_t* exclude_token_ids_end = exclude_token_ids + exclude_token_ids_size;
+
+    searched_queries.push_back({});
+
+    Topster sorted_topster(topster->MAX_SIZE, topster->distinct);
+    sorted_topster.copy_search_after(*topster);
+    std::vector<posting_list_t::iterator_t> plists;
+    const std::map<std::string, reference_filter_result_t> references;
+    Option<bool> compute_sort_scores_op(true);
+    size_t num_found = 0;
+
+    auto add_hit = [&](const uint32_t seq_id) {
+        int64_t match_score = 0;
+        score_results2(sort_fields, (uint16_t) searched_queries.size(), 0, false, 0,
+                       match_score, seq_id, sort_order, false, false, false, 1, -1, plists);
+
+        int64_t scores[3] = {0};
+        int64_t match_score_index = -1;
+
+        compute_sort_scores_op = compute_sort_scores(sort_fields, sort_order, field_values, geopoint_indices,
+                                                     seq_id, references, 100, scores,
+                                                     match_score_index, 0, collection_name);
+        if (!compute_sort_scores_op.ok()) {
+            return false;
+        }
+
+        KV kv(searched_queries.size(), seq_id, seq_id, match_score_index, scores);
+        if(sorted_topster.has_search_after && !sorted_topster.is_after_cursor(&kv)) {
+            // the hits up to the cursor do not count towards the K that end the walk
+            return true;
+        }
+
+        sorted_topster.add(&kv);
+        num_found++;
+        return true;
+    };
+
+    // An ascending sort negates the value, which leaves INT64_MIN where missing values go, so it's left for last.
+    const bool is_asc = (sort_order[0] == -1);
+    size_t num_visited = 0;
+    bool too_many_ties = false;
+
+    num_tree_it->second->visit_values_in_order(!is_asc, [&](int64_t value, const std::vector<uint32_t>& ids) {
+        if (is_asc && value == INT64_MIN) {
+            return true;
+        }
+
+        if (ids.size() > k) {
+            // every id of a value has to be scored on the later sort fields, which is no cheaper than the usual path
+            too_many_ties = true;
+            return false;
+        }
+
+        for (const uint32_t seq_id: ids) {
+            if (std::binary_search(result_ids_begin, result_ids_end, seq_id) &&
+                !std::binary_search(exclude_token_ids, exclude_token_ids_end, seq_id) && !add_hit(seq_id)) {
+                return false;
+            }
+
+            if (((++num_visited) % (1 << 12)) == 0 && search_deadline_t::check_expired()) {
+                return false;
+            }
+        }
+
+        // rest of the ids of a value are still added, as they might tie with the last hit on the later sort fields
+        return num_found < k;
+    });
+
+    if (too_many_ties) {
+        searched_queries.pop_back();
+        delete [] all_result_ids;
+        all_result_ids = nullptr;
+        all_result_ids_len = 0;
+        filter_result_iterator->reset();
+        walked = false;
+        return Option<bool>(true);
+    }
+
+    if (compute_sort_scores_op.ok() && num_found < k && !search_cutoff) {
+        // the documents that the walk did not reach all get the same (lowest) score on the first sort field
+        for (size_t i = 0; i < all_result_ids_len; i++) {
+            const uint32_t seq_id = all_result_ids[i];
+            auto value_it = field_values[0]->find(seq_id);
+            const bool walked_past = (value_it == field_values[0]->end()) || (is_asc && value_it->second == INT64_MIN);
+
+            if (walked_past && !std::binary_search(exclude_token_ids, exclude_token_ids_end, seq_id) &&
+                !add_hit(seq_id)) {
+                break;
+            }
+
+            if (((i + 1) % (1 << 12)) == 0 && search_deadline_t::check_expired()) {
+                break;
+            }
+        }
+    }
+
+    if (!compute_sort_scores_op.ok()) {
+        return compute_sort_scores_op;
+    }
+
+    aggregate_topster(topster, &sorted_topster);
+    return Option<bool>(true);
+}
+
 Option<bool> Index::search_wildcard(filter_node_t const* const& filter_tree_root,
                                     const std::map<size_t, std::map<size_t, uint32_t>>& included_ids_map,
                                     const std::vector<sort_by>& sort_fields, Topster* topster, Topster* curated_topster,
@@ -5890,11 +7207,23 @@ Option<bool> Index::search_wildcard(filter_node_t const* const& filter_tree_root
                                     filter_result_iterator_t* const filter_result_iterator,
                                     const size_t concurrency,
                                     const int* sort_order,
-                                    std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values,
+                                    std::array<sort_column_t*, 3>& field_values,
                                     const std::vector<size_t>& geopoint_indices,
+                                    const bool collect_result_ids,
                                     const std::string& collection_name) const {
 
     filter_result_iterator->compute_iterators();
+
+    bool walked_in_sort_order = false;
+    auto sort_order_op = search_wildcard_in_sort_order(filter_tree_root, sort_fields, topster, searched_queries,
+                                                       group_limit, exclude_token_ids, exclude_token_ids_size,
+                                                       all_result_ids, all_result_ids_len, filter_result_iterator,
+                                                       sort_order, field_values, geopoint_indices, collection_name,
+                                                       walked_in_sort_order);
+    if (!sort_order_op.ok() || walked_in_sort_order) {
+        return sort_order_op;
+    }
+
     auto const& approx_filter_ids_length = filter_result_iterator->approx_filter_ids_length;
 
     uint32_t token_bits = 0;
@@ -5916,11 +7245,13 @@ Option<bool> Index::search_wildcard(filter_node_t const* const& filter_tree_root
 
     size_t num_queued = 0;
 
-    const auto parent_search_begin = search_begin_us;
-    const auto parent_search_stop_ms = search_stop_us;
+    const auto parent_deadline = search_deadline_t::current();
     auto parent_search_cutoff = search_cutoff;
+    const auto parent_search_profile = search_profile;
+    const auto parent_request_cost = request_cost;
     uint32_t excluded_result_index = 0;
     Option<bool>* compute_sort_score_statuses[num_threads];
+    size_t num_batched_ids = 0;
 
     for(size_t thread_id = 0; thread_id < num_threads &&
                                     filter_result_iterator->validity == filter_result_iterator_t::valid; thread_id++) {
@@ -5932,13 +7263,17 @@ Option<bool> Index::search_wildcard(filter_node_t const* const& filter_tree_root
             break;
         }
         num_queued++;
+        num_batched_ids += batch_result->count;
 
         searched_queries.push_back({});
 
         topsters[thread_id] = new Topster(topster->MAX_SIZE, topster->distinct);
+        topsters[thread_id]->copy_search_after(*topster);
         auto& compute_sort_score_status = compute_sort_score_statuses[thread_id] = nullptr;
 
-        thread_pool->enqueue([this, &parent_search_begin, &parent_search_stop_ms, &parent_search_cutoff,
+        thread_pool->enqueue_with_priority(ThreadPool::HIGH_PRIORITY,
+                             [this, parent_deadline, &parent_search_cutoff,
+                              parent_search_profile, parent_request_cost,
                               thread_id, &sort_fields, &searched_queries,
                               &group_limit, &group_by_fields, group_missing_values, 
                               &topsters, &tgroups_processed, &excluded_group_ids,
@@ -5948,11 +7283,9 @@ Option<bool> Index::search_wildcard(filter_node_t const* const& filter_tree_root
                               &num_processed, &m_process, &cv_process, &compute_sort_score_status, collection_name]() {
             std::unique_ptr<filter_result_t> batch_result_guard(batch_result);
 
-            search_begin_us = parent_search_begin;
-            search_stop_us = parent_search_stop_ms;
-            search_cutoff = false;
-
-            std::vector<uint32_t> filter_indexes;
+            search_deadline_scope_t deadline_scope(parent_deadline);
+            search_profile_scope_t profile_scope(parent_search_profile);
+            request_cost_scope_t cost_scope(parent_request_cost);
 
             std::vector<group_by_field_it_t> group_by_field_it_vec;
             if (group_limit != 0) {
@@ -5975,7 +7308,7 @@ Option<bool> Index::search_wildcard(filter_node_t const* const& filter_tree_root
                 int64_t match_score_index = -1;
 
                 auto compute_sort_scores_op = compute_sort_scores(sort_fields, sort_order, field_values, geopoint_indices,
-                                                                  seq_id, references, filter_indexes, 100, scores,
+                                                                  seq_id, references, 100, scores,
                                                                   match_score_index, 0, collection_name);
                 if (!compute_sort_scores_op.ok()) {
                     compute_sort_score_status = new Option<bool>(compute_sort_scores_op.code(), compute_sort_scores_op.error());
@@ -5986,7 +7319,7 @@ Option<bool> Index::search_wildcard(filter_node_t const* const& filter_tree_root
                 if(group_limit != 0) {
                     distinct_id = 1;
                     for(auto& kv : group_by_field_it_vec) {
-                        get_distinct_id(kv.it, seq_id, kv.is_array, group_missing_values, distinct_id);
+                        get_distinct_id(kv, seq_id, group_missing_values, distinct_id);
                     }
 
                     if(excluded_group_ids.count(distinct_id) != 0) {
@@ -6006,6 +7339,9 @@ Option<bool> Index::search_wildcard(filter_node_t const* const& filter_tree_root
                 }
             }
 
+            // the batches are sorted side by side, so that they are merged below only as far as they can enter
+            topsters[thread_id]->sort();
+
             std::unique_lock<std::mutex> lock(m_process);
             num_processed++;
             parent_search_cutoff = parent_search_cutoff || search_cutoff;
@@ -6036,7 +7372,20 @@ Option<bool> Index::search_wildcard(filter_node_t const* const& filter_tree_root
         for(const auto& it : tgroups_processed[thread_id]) {
             groups_processed[it.first]+= it.second;
         }
-        aggregate_topster(topster, topsters[thread_id]);
+        if(topster->distinct) {
+            aggregate_topster(topster, topsters[thread_id]);
+        } else {
+            for(uint32_t i = 0; i < topsters[thread_id]->size; i++) {
+                KV* kv = topsters[thread_id]->getKV(i);
+                if(topster->size >= topster->MAX_SIZE && Topster::is_smaller(kv, topster->kvs[0])) {
+                    // nor can any of the hits after it in the batch
+                    break;
+                }
+
+                topster->add(kv);
+            }
+        }
+
         delete topsters[thread_id];
     }
 
@@ -6044,6 +7393,13 @@ Option<bool> Index::search_wildcard(filter_node_t const* const& filter_tree_root
             std::chrono::high_resolution_clock::now() - beginF).count();
     LOG(INFO) << "Time for raw scoring: " << timeMillisF;*/
 
+    if (!collect_result_ids && filter_result_iterator->validity == filter_result_iterator_t::invalid) {
+        // Only the number of matches is needed, which the batches add up to. The batches leave out the ids of the
+        // excluded tokens, as the result ids would once they are curated.
+        all_result_ids_len = num_batched_ids;
+        return Option<bool>(true);
+    }
+
     filter_result_iterator->reset();
     if (filter_result_iterator->validity == filter_result_iterator_t::timed_out) {
         auto partial_result = new filter_result_t();
@@ -6064,7 +7420,7 @@ Option<bool> Index::search_wildcard(filter_node_t const* const& filter_tree_root
 
 void Index::populate_sort_mapping(int* sort_order, std::vector<size_t>& geopoint_indices,
                                   std::vector<sort_by>& sort_fields_std,
-                                  std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values) const {
+                                  std::array<sort_column_t*, 3>& field_values) const {
     for (size_t i = 0; i < sort_fields_std.size(); i++) {
         if (!sort_fields_std[i].reference_collection_name.empty()) {
             auto& cm = CollectionManager::get_instance();
@@ -6075,7 +7431,7 @@ void Index::populate_sort_mapping(int* sort_order, std::vector<size_t>& geopoint
             std::vector<sort_by> ref_sort_fields_std;
             ref_sort_fields_std.emplace_back(sort_fields_std[i]);
             ref_sort_fields_std.front().reference_collection_name.clear();
-            std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> ref_field_values;
+            std::array<sort_column_t*, 3> ref_field_values;
             ref_collection->reference_populate_sort_mapping(ref_sort_order, ref_geopoint_indices,
                                                             ref_sort_fields_std, ref_field_values);
 
@@ -6105,17 +7461,33 @@ void Index::populate_sort_mapping(int* sort_order, std::vector<size_t>& geopoint
             auto& eval_exp = sort_fields_std[i].eval;
             auto count = sort_fields_std[i].eval_expressions.size();
             for (uint32_t j = 0; j < count; j++) {
-                auto filter_result_iterator = filter_result_iterator_t("", this, &eval_exp.filter_trees[j],
-                                                                       search_begin_us, search_stop_us);
-                auto filter_init_op = filter_result_iterator.init_status();
-                if (!filter_init_op.ok()) {
-                    return;
+                const std::string cache_key = filter_result_cache_t::get_key(&eval_exp.filter_trees[j]);
+                const uint64_t eval_write_generation = write_generation;
+
+                auto eval_bitmap = cache_key.empty() ? nullptr :
+                                   eval_bitmap_cache.get(cache_key, eval_write_generation);
+
+                if (eval_bitmap == nullptr) {
+                    auto filter_result_iterator = filter_result_iterator_t("", this, &eval_exp.filter_trees[j],
+                                                                           search_begin_us, search_stop_us);
+                    auto filter_init_op = filter_result_iterator.init_status();
+                    if (!filter_init_op.ok()) {
+                        return;
+                    }
+
+                    uint32_t* eval_ids = nullptr;
+                    auto eval_ids_count = filter_result_iterator.to_filter_id_array(eval_ids);
+                    std::unique_ptr<uint32_t[]> eval_ids_guard(eval_ids);
+
+                    eval_bitmap = std::make_shared<const id_bitmap_t>(eval_ids, eval_ids_count);
+
+                    // a timed out filter may not have matched all of its documents
+                    if (filter_result_iterator.validity != filter_result_iterator_t::timed_out) {
+                        eval_bitmap_cache.insert(cache_key, eval_write_generation, eval_bitmap);
+                    }
                 }
-                uint32_t* eval_ids = nullptr;
-                auto eval_ids_count = filter_result_iterator.to_filter_id_array(eval_ids);
 
-                eval_exp.eval_ids_vec.push_back(eval_ids);
-                eval_exp.eval_ids_count_vec.push_back(eval_ids_count);
+                eval_exp.eval_bitmaps.push_back(std::move(eval_bitmap));
             }
         } else if(sort_fields_std[i].name == sort_field_const::vector_distance) {
             field_values[i] = &vector_distance_sentinel_value;
@@ -6140,7 +7512,7 @@ void Index::populate_sort_mapping(int* sort_order, std::vector<size_t>& geopoint
 
 void Index::populate_sort_mapping_with_lock(int* sort_order, std::vector<size_t>& geopoint_indices,
                                             std::vector<sort_by>& sort_fields_std,
-                                            std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3>& field_values) const {
+                                            std::array<sort_column_t*, 3>& field_values) const {
     std::shared_lock lock(mutex);
     populate_sort_mapping(sort_order, geopoint_indices, sort_fields_std, field_values);
 }
@@ -6179,6 +7551,19 @@ void Index::log_leaves(const int cost, const std::string &token, const std::vect
     }
 }
 
+uint64_t Index::max_text_match_score(const text_match_type_t match_type, const uint32_t total_cost,
+                                     const size_t max_tokens, const size_t max_field_weight) {
+    // layouts are those of `score_results2()` and of the aggregation in `search_across_fields()`
+    const uint64_t words = std::min<size_t>(255, max_tokens);
+    const uint64_t field_match_score = (words << 40) | (words << 32) | (uint64_t(255 - total_cost) << 24) | 0xFFFFFF;
+
+    const uint64_t query_len = std::min<size_t>(15, max_tokens);
+    const uint64_t field_weight = std::min<size_t>(FIELD_MAX_WEIGHT, max_field_weight);
+
+    return match_type == max_score ? ((query_len << 59) | (field_match_score << 11) | (field_weight << 3) | 7) :
+                                     ((query_len << 59) | (field_weight << 51) | (field_match_score << 3) | 7);
+}
+
 int64_t Index::score_results2(const std::vector<sort_by> & sort_fields, const uint16_t & query_index,
                               const size_t field_id,
                               const bool field_is_array,
@@ -6222,6 +7607,13 @@ int64_t Index::score_results2(const std::vector<sort_by> & sort_fields, const ui
                   << ", offset_score: " << offset_score
                   << ", match_score: " << match_score;*/
 
+    } else if(std::none_of(sort_fields.begin(), sort_fields.end(), [](const sort_by& sort_field) {
+                  return sort_field.name == sort_field_const::text_match;
+              })) {
+        // The positions of the tokens only order the hits by `_text_match`, so they are not decoded when it is not
+        // sorted on, and the tokens are scored as if they were adjacent.
+        const size_t num_tokens = posting_lists.size();
+        match_score = Match(num_tokens, num_tokens - 1, 255).get_match_score(total_cost, num_tokens);
     } else {
         std::map<size_t, std::vector<token_positions_t>> array_token_positions;
         posting_list_t::get_offsets(posting_lists, array_token_positions);
@@ -6294,7 +7686,7 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
                           const std::vector<art_leaf *> &query_suggestion,
                           spp::sparse_hash_map<uint64_t, uint32_t>& groups_processed,
                           const uint32_t seq_id, const int sort_order[3],
-                          std::array<spp::sparse_hash_map<uint32_t, int64_t, Hasher32>*, 3> field_values,
+                          std::array<sort_column_t*, 3> field_values,
                           const std::vector<size_t>& geopoint_indices,
                           const size_t group_limit, const std::vector<std::string>& group_by_fields,
                           const bool group_missing_values,
@@ -6494,7 +7886,7 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
         auto group_by_field_it_vec = get_group_by_field_iterators(group_by_fields);
 
         for(auto& kv : group_by_field_it_vec) {
-            get_distinct_id(kv.it, seq_id, kv.is_array, group_missing_values, distinct_id);
+            get_distinct_id(kv, seq_id, group_missing_values, distinct_id);
         }
     }
 
@@ -6509,8 +7901,24 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
     //LOG(INFO) << "Time taken for results iteration: " << timeNanos << "ms";
 }
 
-void Index::get_distinct_id(posting_list_t::iterator_t& facet_index_it, const uint32_t seq_id, const bool is_array,
+void Index::get_distinct_id(group_by_field_it_t& group_by_field_it, const uint32_t seq_id,
                             const bool group_missing_values, uint64_t& distinct_id, bool is_reverse) const {
+    if (group_by_field_it.facet_ids != nullptr) {
+        const auto& facet_ids = *group_by_field_it.facet_ids;
+        if (seq_id < facet_ids.size() && facet_ids[seq_id] != facet_index_t::NO_FACET_ID) {
+            distinct_id = StringUtils::hash_combine(distinct_id, facet_ids[seq_id]);
+        }
+
+        if (distinct_id == 1 && !group_missing_values) {
+            distinct_id = seq_id;
+        }
+
+        return;
+    }
+
+    auto& facet_index_it = group_by_field_it.it;
+    const bool is_array = group_by_field_it.is_array;
+
     if (!facet_index_it.valid()) {
         if (!group_missing_values) {
             distinct_id = seq_id;
@@ -6666,6 +8074,8 @@ void Index::remove_field(uint32_t seq_id, const nlohmann::json& document, const
         return;
     }
 
+    memory_accounting_scope_t memory_scope(memory_stats, get_memory_structure(search_field));
+
     // Go through all the field names and find the keys+values so that they can be removed from in-memory index
     if(search_field.type == field_types::STRING_ARRAY || search_field.type == field_types::STRING) {
         std::vector<std::string> tokens;
@@ -6684,13 +8094,42 @@ void Index::remove_field(uint32_t seq_id, const nlohmann::json& document, const
                     posting_t::destroy_list(values);
 
                     if(search_field.infix) {
+                        memory_accounting_scope_t infix_memory_scope(memory_stats, MEMORY_INFIX);
                         auto strhash = StringUtils::hash_wy(key, token.size());
                         const auto& infix_sets = infix_index.at(search_field.name);
                         infix_sets[strhash % 4]->erase(token);
+
+                        auto trigram_index_it = infix_trigram_index.find(search_field.name);
+                        if(trigram_index_it != infix_trigram_index.end()) {
+                            trigram_index_it->second->erase(token);
+                        }
                     }
                 }
             }
         }
+
+        auto exact_match_index_it = exact_match_index.find(search_field.name);
+        if(exact_match_index_it != exact_match_index.end()) {
+            std::vector<uint64_t> value_hashes;
+            get_exact_match_hashes(document, search_field, symbols_to_index, token_separators, value_hashes);
+
+            for(uint64_t value_hash: value_hashes) {
+                auto value_it = exact_match_index_it->second->find(value_hash);
+                if(value_it == exact_match_index_it->second->end()) {
+                    continue;
+                }
+
+                auto& value_ids = value_it->second;
+                auto id_it = std::lower_bound(value_ids.begin(), value_ids.end(), seq_id);
+                if(id_it != value_ids.end() && *id_it == seq_id) {
+                    value_ids.erase(id_it);
+                }
+
+                if(value_ids.empty()) {
+                    exact_match_index_it->second->erase(value_it);
+                }
+            }
+        }
     } else if(search_field.is_int32()) {
         const std::vector<int32_t>& values = search_field.is_single_integer() ?
                                              std::vector<int32_t>{document[field_name].get<int32_t>()} :
@@ -6728,7 +8167,7 @@ void Index::remove_field(uint32_t seq_id, const nlohmann::json& document, const
     } else if(search_field.num_dim) {
         if(!is_update) {
             // since vector index supports upsert natively, we should not attempt to delete for update
-            vector_index[search_field.name]->vecdex->markDelete(seq_id);
+            vector_index[search_field.name]->remove_point(seq_id);
         }
     } else if(search_field.is_float()) {
         const std::vector<float>& values = search_field.is_single_float() ?
@@ -6796,22 +8235,204 @@ void Index::remove_field(uint32_t seq_id, const nlohmann::json& document, const
     }
 
     // remove facets
-    facet_index_v4->remove(document, search_field, seq_id);
+    {
+        memory_accounting_scope_t facet_memory_scope(memory_stats, MEMORY_FACET);
+        facet_index_v4->remove(document, search_field, seq_id);
+    }
+
+    if(search_field.facet) {
+        update_numeric_facet_totals(document, search_field, false);
+    }
 
     // remove sort field
     if(sort_index.count(field_name) != 0) {
+        memory_accounting_scope_t sort_memory_scope(memory_stats, MEMORY_SORT);
         sort_index[field_name]->erase(seq_id);
     }
 
     if(str_sort_index.count(field_name) != 0) {
+        memory_accounting_scope_t str_sort_memory_scope(memory_stats, MEMORY_STRING_SORT);
         str_sort_index[field_name]->remove(seq_id);
     }
 }
 
 Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & document,
                                const std::vector<field>& del_fields, const bool is_update) {
+    const auto lock_wait_begin = std::chrono::steady_clock::now();
+    std::unique_lock lock(mutex);
+    AppMetrics::get_instance().record_index_lock_wait(true, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - lock_wait_begin).count());
+    write_generation++;
+
+    remove_unsafe(seq_id, document, del_fields, is_update);
+    return Option<uint32_t>(seq_id);
+}
+
+void Index::remove_batch(const std::vector<std::pair<uint32_t, nlohmann::json>>& seq_id_docs) {
+    const auto lock_wait_begin = std::chrono::steady_clock::now();
+    std::unique_lock lock(mutex);
+    AppMetrics::get_instance().record_index_lock_wait(true, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - lock_wait_begin).count());
+    write_generation++;
+
+    for(const auto& seq_id_doc: seq_id_docs) {
+        remove_unsafe(seq_id_doc.first, seq_id_doc.second, {}, false);
+    }
+}
+
+void Index::update_numeric_values(std::vector<numeric_doc_update_t>& doc_updates) {
+    const auto lock_wait_begin = std::chrono::steady_clock::now();
+    std::unique_lock lock(mutex);
+    AppMetrics::get_instance().record_index_lock_wait(true, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - lock_wait_begin).count());
+    write_generation++;
+
+    for(auto& doc_update: doc_updates) {
+        // new values of all the fields are computed before any of them is changed
+        nlohmann::json new_values = nlohmann::json::object();
+
+        for(const auto& update: doc_update.updates) {
+            auto field_it = search_schema.find(update.field_name);
+            auto sort_it = sort_index.find(update.field_name);
+
+            const bool is_numeric = field_it != search_schema.end() &&
+                                    (field_it.value().type == field_types::INT32 ||
+                                     field_it.value().type == field_types::INT64 ||
+                                     field_it.value().type == field_types::FLOAT);
+
+            if(!is_numeric || sort_it == sort_index.end() || field_it.value().nested || field_it.value().facet) {
+                doc_update.result = Option<nlohmann::json>(400, "Field `" + update.field_name + "` must be a "
+                                                                "non-facet int32, int64 or float field with "
+                                                                "sorting enabled.");
+                break;
+            }
+
+            const auto& the_field = field_it.value();
+            const auto value_it = sort_it->second->find(doc_update.seq_id);
+            const bool has_value = (value_it != sort_it->second->end());
+
+            if(the_field.is_float()) {
+                if(!update.value.is_number()) {
+                    doc_update.result = Option<nlohmann::json>(400, "Field `" + update.field_name +
+                                                                    "` must be a float.");
+                    break;
+                }
+
+                if(update.is_increment) {
+                    const float old_value = has_value ? int64_t_to_float(value_it->second) : 0;
+                    new_values[update.field_name] = old_value + update.value.get<float>();
+                } else {
+                    new_values[update.field_name] = update.value;
+                }
+
+                continue;
+            }
+
+            if(!update.value.is_number_integer()) {
+                doc_update.result = Option<nlohmann::json>(400, "Field `" + update.field_name + "` must be an " +
+                                                                the_field.type + ".");
+                break;
+            }
+
+            int64_t value = update.value.get<int64_t>();
+            if(update.is_increment && has_value && __builtin_add_overflow(value, value_it->second, &value)) {
+                doc_update.result = Option<nlohmann::json>(400, "Field `" + update.field_name + "` overflows.");
+                break;
+            }
+
+            if(the_field.type == field_types::INT32 && (value < INT32_MIN || value > INT32_MAX)) {
+                doc_update.result = Option<nlohmann::json>(400, "Field `" + update.field_name + "` overflows.");
+                break;
+            }
+
+            new_values[update.field_name] = value;
+        }
+
+        if(!doc_update.result.ok()) {
+            continue;
+        }
+
+        for(const auto& item: new_values.items()) {
+            const auto& the_field = search_schema.at(item.key());
+            const int64_t value = the_field.is_float() ? float_to_int64_t(item.value().get<float>()) :
+                                                         item.value().get<int64_t>();
+
+            memory_accounting_scope_t memory_scope(memory_stats, get_memory_structure(the_field));
+            sort_column_t* sort_column = sort_index.at(the_field.name);
+            const auto value_it = sort_column->find(doc_update.seq_id);
+
+            if(value_it != sort_column->end()) {
+                if(the_field.range_index) {
+                    range_index.at(the_field.name)->remove(value_it->second, doc_update.seq_id);
+                } else {
+                    numerical_index.at(the_field.name)->remove(value_it->second, doc_update.seq_id);
+                }
+
+                sort_column->erase(doc_update.seq_id);
+            }
+
+            if(the_field.range_index) {
+                range_index.at(the_field.name)->insert(value, doc_update.seq_id);
+            } else {
+                numerical_index.at(the_field.name)->insert(value, doc_update.seq_id);
+            }
+
+            sort_column->emplace(doc_update.seq_id, value);
+        }
+
+        doc_update.result = Option<nlohmann::json>(new_values);
+    }
+}
+
+void Index::mark_deleted(const uint32_t seq_id, const nlohmann::json& document) {
+    std::unique_lock lock(deleted_mutex);
+    deleted_docs.emplace(seq_id, document);
+}
+
+size_t Index::purge_deleted() {
+    if(num_deleted() == 0) {
+        return 0;
+    }
+
+    const auto lock_wait_begin = std::chrono::steady_clock::now();
     std::unique_lock lock(mutex);
+    AppMetrics::get_instance().record_index_lock_wait(true, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - lock_wait_begin).count());
+    write_generation++;
+
+    // searches can't see the documents until the locks are released, by when they are unindexed
+    std::map<uint32_t, nlohmann::json> purged_docs;
+    {
+        std::unique_lock deleted_lock(deleted_mutex);
+        purged_docs.swap(deleted_docs);
+    }
+
+    for(const auto& seq_id_doc: purged_docs) {
+        remove_unsafe(seq_id_doc.first, seq_id_doc.second, {}, false);
+    }
+
+    return purged_docs.size();
+}
+
+size_t Index::num_deleted() const {
+    std::shared_lock lock(deleted_mutex);
+    return deleted_docs.size();
+}
+
+std::vector<uint32_t> Index::get_deleted_ids() const {
+    std::shared_lock lock(deleted_mutex);
+
+    std::vector<uint32_t> deleted_ids;
+    deleted_ids.reserve(deleted_docs.size());
+    for(const auto& seq_id_doc: deleted_docs) {
+        deleted_ids.push_back(seq_id_doc.first);
+    }
 
+    return deleted_ids;
+}
+
+void Index::remove_unsafe(const uint32_t seq_id, const nlohmann::json& document,
+                          const std::vector<field>& del_fields, const bool is_update) {
     // The exception during removal is mostly because of an edge case with auto schema detection:
     // Value indexed as Type T but later if field is dropped and reindexed in another type X,
     // the on-disk data will differ from the newly detected type on schema. We've to log the error,
@@ -6819,7 +8440,7 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
 
     if(!del_fields.empty()) {
         for(auto& the_field: del_fields) {
-            if(!document.contains(the_field.name)) {
+            if(!document.contains(the_field.name) || seq_id >= get_backfill_end(the_field.name)) {
                 // could be an optional field
                 continue;
             }
@@ -6834,6 +8455,11 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
     } else {
         for(auto it = document.begin(); it != document.end(); ++it) {
             const std::string& field_name = it.key();
+            if(seq_id >= get_backfill_end(field_name)) {
+                // not indexed yet by the backfill of a background alter
+                continue;
+            }
+
             try {
                 remove_field(seq_id, document, field_name, is_update);
             } catch(const std::exception& e) {
@@ -6844,10 +8470,9 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
     }
 
     if(!is_update) {
+        memory_accounting_scope_t ids_memory_scope(memory_stats, MEMORY_IDS);
         seq_ids->erase(seq_id);
     }
-
-    return Option<uint32_t>(seq_id);
 }
 
 void Index::tokenize_string_field(const nlohmann::json& document, const field& search_field,
@@ -6867,6 +8492,74 @@ void Index::tokenize_string_field(const nlohmann::json& document, const field& s
     }
 }
 
+uint64_t Index::exact_match_hash(const std::vector<std::string>& tokens) {
+    std::string value;
+    for(const auto& token: tokens) {
+        if(!value.empty()) {
+            value += ' ';
+        }
+
+        value += token;
+    }
+
+    return StringUtils::hash_wy(value.c_str(), value.size());
+}
+
+void Index::get_exact_match_hashes(const nlohmann::json& document, const field& a_field,
+                                   const std::vector<char>& symbols_to_index,
+                                   const std::vector<char>& token_separators,
+                                   std::vector<uint64_t>& hashes) {
+    auto field_it = document.find(a_field.name);
+    if(field_it == document.end()) {
+        return ;
+    }
+
+    std::vector<std::string> values;
+    if(field_it->is_string()) {
+        values.push_back(field_it->get<std::string>());
+    } else if(field_it->is_array()) {
+        for(const auto& value: *field_it) {
+            if(value.is_string()) {
+                values.push_back(value.get<std::string>());
+            }
+        }
+    }
+
+    for(const auto& value: values) {
+        // tokens are normalized as they are for the search index
+        auto tokenizer_ptr = Tokenizer::acquire(value, true, false, a_field.locale, symbols_to_index, token_separators);
+        Tokenizer& tokenizer = *tokenizer_ptr;
+        std::vector<std::string> tokens;
+        std::string token;
+        size_t token_index = 0;
+
+        while(tokenizer.next(token, token_index)) {
+            if(token.empty()) {
+                continue;
+            }
+
+            if(token.size() > 100) {
+                token.erase(100);
+            }
+
+            if(a_field.is_stem() && a_field.get_stemmer()) {
+                token = a_field.get_stemmer()->stem(token);
+            }
+
+            tokens.push_back(token);
+        }
+
+        if(tokens.empty()) {
+            continue;
+        }
+
+        const uint64_t value_hash = exact_match_hash(tokens);
+        if(std::find(hashes.begin(), hashes.end(), value_hash) == hashes.end()) {
+            hashes.push_back(value_hash);
+        }
+    }
+}
+
 art_leaf* Index::get_token_leaf(const std::string & field_name, const unsigned char* token, uint32_t token_len) {
     std::shared_lock lock(mutex);
     const art_tree *t = search_index.at(field_name);
@@ -6889,7 +8582,362 @@ const spp::sparse_hash_map<std::string, array_mapped_infix_t>& Index::_get_infix
     return infix_index;
 };
 
-const spp::sparse_hash_map<std::string, hnsw_index_t*>& Index::_get_vector_index() const {
+const spp::sparse_hash_map<std::string, trigram_index_t*>& Index::_get_infix_trigram_index() const {
+    return infix_trigram_index;
+}
+
+Option<bool> hnsw_index_t::store_full_vectors(const std::string& dir_path) {
+    if(quantized_space == nullptr) {
+        return Option<bool>(400, "Only the float vectors of a quantized graph can be kept on disk.");
+    }
+
+    auto file = new vector_file_t(num_dim);
+    auto open_op = file->open(dir_path);
+    if(!open_op.ok()) {
+        delete file;
+        return open_op;
+    }
+
+    delete full_vectors;
+    full_vectors = file;
+    return Option<bool>(true);
+}
+
+void hnsw_index_t::add_point(const float* values, size_t seq_id) {
+    num_writes++;
+
+    if(column != nullptr) {
+        column->put(seq_id, values);
+    }
+
+    if(quantized_space == nullptr) {
+        vecdex->addPoint(values, seq_id, true);
+        return;
+    }
+
+    std::vector<uint8_t> record;
+    quantized_space->encode(values, record);
+    vecdex->addPoint(record.data(), seq_id, true);
+
+    if(full_vectors != nullptr && !full_vectors->put(seq_id, values)) {
+        LOG(ERROR) << "Unable to write the float vector of " << seq_id << " to its vector file.";
+    }
+}
+
+void hnsw_index_t::remove_point(size_t seq_id) {
+    num_writes++;
+    vecdex->markDelete(seq_id);
+
+    if(full_vectors != nullptr) {
+        full_vectors->remove(seq_id);
+    }
+
+    if(column != nullptr) {
+        column->remove(seq_id);
+    }
+}
+
+bool hnsw_index_t::needs_compaction() const {
+    const size_t num_deleted = vecdex->getDeletedCount();
+    return num_deleted >= MIN_COMPACTION_DELETED &&
+           num_deleted >= COMPACTION_DELETED_FRACTION * vecdex->getCurrentElementCount();
+}
+
+hnswlib::HierarchicalNSW<float>* hnsw_index_t::build_compacted_graph(ThreadPool* thread_pool) const {
+    std::vector<hnswlib::tableint> live_ids;
+    const size_t num_elements = vecdex->getCurrentElementCount();
+
+    for(size_t internal_id = 0; internal_id < num_elements; internal_id++) {
+        if(!vecdex->isMarkedDeleted(internal_id)) {
+            live_ids.push_back(internal_id);
+        }
+    }
+
+    const size_t init_size = std::max<size_t>(INITIAL_CAPACITY, live_ids.size() * 1.3);
+    auto graph = new hnswlib::HierarchicalNSW<float>(graph_space(), init_size, vecdex->M_,
+                                                     vecdex->ef_construction_, 100, true);
+    graph->setEf(vecdex->ef_);
+
+    const size_t num_chunks = std::max<size_t>(1, thread_pool->num_threads());
+    thread_pool->parallel_for(0, live_ids.size(), num_chunks, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            graph->addPoint(vecdex->getDataByInternalId(live_ids[i]), vecdex->getExternalLabel(live_ids[i]));
+        }
+    });
+
+    return graph;
+}
+
+std::vector<float> hnsw_index_t::get_vector(size_t seq_id) const {
+    std::vector<float> values;
+    if(column != nullptr && column->get(seq_id, values)) {
+        return values;
+    }
+
+    if(quantized_space == nullptr) {
+        return vecdex->getDataByLabel<float>(seq_id);
+    }
+
+    if(full_vectors != nullptr && full_vectors->get(seq_id, values)) {
+        return values;
+    }
+
+    quantized_space->decode(vecdex->getDataByLabel<uint8_t>(seq_id).data(), values);
+    return values;
+}
+
+std::vector<std::pair<float, size_t>> hnsw_index_t::search_knn(const float* query, size_t k, size_t ef,
+                                                               hnswlib::BaseFilterFunctor* filter) const {
+    if(quantized_space == nullptr) {
+        return vecdex->searchKnnCloserFirst(query, k, ef, filter);
+    }
+
+    std::vector<uint8_t> query_record;
+    quantized_space->encode(query, query_record);
+
+    auto candidates = vecdex->searchKnnCloserFirst(query_record.data(), k * RERANK_FACTOR, ef, filter);
+
+    std::vector<float> values;
+    for(auto& candidate: candidates) {
+        if((column == nullptr || !column->get(candidate.second, values)) &&
+           (full_vectors == nullptr || !full_vectors->get(candidate.second, values))) {
+            quantized_space->decode(vecdex->getDataByLabel<uint8_t>(candidate.second).data(), values);
+        }
+
+        candidate.first = space->get_dist_func()(query, values.data(), &num_dim);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first || (a.first == b.first && a.second < b.second);
+    });
+
+    if(candidates.size() > k) {
+        candidates.resize(k);
+    }
+
+    return candidates;
+}
+
+void hnsw_index_t::flat_distances(const float* const* queries, size_t num_queries, const uint32_t* seq_ids,
+                                  size_t num_ids, std::vector<float>& distances) const {
+    distances.assign(num_ids, std::numeric_limits<float>::infinity());
+
+    auto& gpu_scorer = GpuVectorScorer::get_instance();
+    if(column != nullptr && gpu_scorer.should_offload(num_queries, num_ids, num_dim)) {
+        std::vector<float> rows;
+        std::vector<size_t> row_indices;
+        column->gather(seq_ids, num_ids, rows, row_indices);
+
+        std::vector<float> packed_queries;
+        packed_queries.reserve(num_queries * num_dim);
+        for(size_t q = 0; q < num_queries; q++) {
+            packed_queries.insert(packed_queries.end(), queries[q], queries[q] + num_dim);
+        }
+
+        std::vector<float> products(num_queries * row_indices.size());
+        if(gpu_scorer.inner_products(packed_queries.data(), num_queries, rows.data(), row_indices.size(), num_dim,
+                                     products.data())) {
+            for(size_t r = 0; r < row_indices.size(); r++) {
+                const float* row_products = products.data() + r * num_queries;
+                // distance of the inner product space
+                distances[row_indices[r]] = 1.0f - *std::max_element(row_products, row_products + num_queries);
+            }
+
+            return;
+        }
+    }
+
+    if(column != nullptr) {
+        column->min_distances(queries, num_queries, seq_ids, num_ids, space->get_dist_func(), &num_dim,
+                              distances.data());
+        return;
+    }
+
+    std::vector<float> values;
+    for(size_t i = 0; i < num_ids; i++) {
+        try {
+            values = get_vector(seq_ids[i]);
+        } catch(...) {
+            // likely not found
+            continue;
+        }
+
+        for(size_t q = 0; q < num_queries; q++) {
+            distances[i] = std::min(distances[i], space->get_dist_func()(queries[q], values.data(), &num_dim));
+        }
+    }
+}
+
+bool hnsw_index_t::prefer_flat_search(size_t num_filtered, size_t k, size_t ef) const {
+    const size_t num_points = vecdex->getCurrentElementCount() - vecdex->getDeletedCount();
+    if(num_filtered >= num_points) {
+        return false;
+    }
+
+    // num_filtered < (ef / (num_filtered / num_points)) * M
+    return double(num_filtered) * num_filtered < double(get_filtered_ef(num_filtered, k, ef)) * vecdex->M_ * num_points;
+}
+
+size_t hnsw_index_t::get_filtered_ef(size_t num_filtered, size_t k, size_t ef) const {
+    const size_t num_points = vecdex->getCurrentElementCount() - vecdex->getDeletedCount();
+    const size_t base_ef = std::max(ef, k);
+
+    if(num_filtered == 0 || num_filtered >= num_points) {
+        return ef;
+    }
+
+    const double filtered_ef = std::ceil(double(base_ef) * num_points / num_filtered);
+    return std::max(ef, size_t(std::min(filtered_ef, double(base_ef * MAX_FILTERED_EF_FACTOR))));
+}
+
+void Index::hybrid_vector_search(const vector_query_t& vector_query, const size_t fetch_size,
+                                 filter_result_iterator_t* filter_result_iterator, const bool no_filters_provided,
+                                 const uint32_t* excluded_result_ids, const size_t excluded_result_ids_size,
+                                 std::vector<std::pair<uint32_t, float>>& vec_results, bool& search_cutoff) const {
+    VectorFilterFunctor filterFunctor(filter_result_iterator, excluded_result_ids, excluded_result_ids_size);
+    auto& field_vector_index = vector_index.at(vector_query.field_name);
+
+    std::vector<std::pair<float, size_t>> dist_labels;
+    // use k as 100 by default for ensuring results stability in pagination
+    size_t default_k = 100;
+    auto k = vector_query.k == 0 ? std::max<size_t>(fetch_size, default_k) : vector_query.k;
+
+    size_t ef = vector_query.ef;
+    bool flat_search = false;
+
+    if(!no_filters_provided) {
+        const size_t num_filtered = filter_result_iterator->approx_filter_ids_length;
+        flat_search = vector_query.flat_search_cutoff_given ?
+                      num_filtered < vector_query.flat_search_cutoff :
+                      field_vector_index->prefer_flat_search(num_filtered, k, vector_query.ef);
+        ef = field_vector_index->get_filtered_ef(num_filtered, k, vector_query.ef);
+    }
+
+    const size_t num_query_vectors = vector_query.num_query_vectors();
+    if(num_query_vectors > 1 && !flat_search && !no_filters_provided &&
+       !filter_result_iterator->_get_is_filter_result_initialized()) {
+        // evaluated once for the searches of all the query vectors
+        filter_result_iterator->compute_iterators();
+    }
+
+    std::vector<std::vector<float>> normalized_qs(num_query_vectors);
+    std::vector<const float*> query_values(num_query_vectors);
+
+    for(size_t q = 0; q < num_query_vectors; q++) {
+        const auto& values = vector_query.get_query_vector(q);
+        if(field_vector_index->distance_type == cosine) {
+            normalized_qs[q].resize(values.size());
+            hnsw_index_t::normalize_vector(values, normalized_qs[q]);
+        }
+
+        query_values[q] = normalized_qs[q].empty() ? values.data() : normalized_qs[q].data();
+    }
+
+    if(flat_search) {
+        // every filtered point is scored against all the query vectors at once
+        dist_labels = flat_search_knn(field_vector_index, query_values, k, filter_result_iterator,
+                                      excluded_result_ids, excluded_result_ids_size);
+        filter_result_iterator->reset();
+    }
+
+    // a document found for several query vectors keeps its nearest distance
+    std::unordered_map<size_t, size_t> label_indices;
+
+    for(size_t q = 0; q < num_query_vectors && !flat_search; q++) {
+        auto q_dist_labels = field_vector_index->search_knn(query_values[q], k, ef, &filterFunctor);
+        filter_result_iterator->reset();
+
+        if(num_query_vectors == 1) {
+            dist_labels = std::move(q_dist_labels);
+            break;
+        }
+
+        for(const auto& dist_label: q_dist_labels) {
+            auto index_it = label_indices.find(dist_label.second);
+            if(index_it == label_indices.end()) {
+                label_indices.emplace(dist_label.second, dist_labels.size());
+                dist_labels.push_back(dist_label);
+            } else if(dist_label.first < dist_labels[index_it->second].first) {
+                dist_labels[index_it->second].first = dist_label.first;
+            }
+        }
+    }
+
+    if(dist_labels.size() > k) {
+        std::nth_element(dist_labels.begin(), dist_labels.begin() + k, dist_labels.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        dist_labels.resize(k);
+    }
+    search_cutoff = search_cutoff || filter_result_iterator->validity == filter_result_iterator_t::timed_out;
+
+    for (const auto& dist_label : dist_labels) {
+        uint32_t seq_id = dist_label.second;
+
+        auto vec_dist_score = (field_vector_index->distance_type == cosine) ? std::abs(dist_label.first) :
+                                dist_label.first;
+        if(vec_dist_score > vector_query.distance_threshold) {
+            continue;
+        }
+        vec_results.emplace_back(seq_id, vec_dist_score);
+    }
+    
+    std::sort(vec_results.begin(), vec_results.end(), [](const auto& a, const auto& b) {
+        return a.second < b.second;
+    });
+}
+
+std::vector<std::pair<float, size_t>> Index::flat_search_knn(const hnsw_index_t* field_vector_index,
+                                                             const std::vector<const float*>& queries,
+                                                             size_t k, filter_result_iterator_t* filter_result_iterator,
+                                                             const uint32_t* excluded_ids,
+                                                             size_t excluded_ids_length) const {
+    std::vector<std::pair<float, size_t>> dist_labels;
+
+    // ids are scored in batches, so that the rows of the ids ahead can be prefetched, or so that a batch is worth
+    // copying to the GPU
+    constexpr size_t CPU_BATCH_SIZE = 256;
+    const size_t batch_size = GpuVectorScorer::get_instance().is_available() ? GpuVectorScorer::BATCH_SIZE :
+                              CPU_BATCH_SIZE;
+    std::vector<uint32_t> batch_ids;
+    std::vector<float> distances;
+
+    auto score_batch = [&]() {
+        field_vector_index->flat_distances(queries.data(), queries.size(), batch_ids.data(), batch_ids.size(),
+                                           distances);
+        for(size_t i = 0; i < batch_ids.size(); i++) {
+            if(distances[i] != std::numeric_limits<float>::infinity()) {
+                dist_labels.emplace_back(distances[i], batch_ids[i]);
+            }
+        }
+
+        batch_ids.clear();
+    };
+
+    for(; filter_result_iterator->validity == filter_result_iterator_t::valid; filter_result_iterator->next()) {
+        const uint32_t seq_id = filter_result_iterator->seq_id;
+
+        if(excluded_ids_length > 0 && std::binary_search(excluded_ids, excluded_ids + excluded_ids_length, seq_id)) {
+            continue;
+        }
+
+        batch_ids.push_back(seq_id);
+        if(batch_ids.size() == batch_size) {
+            score_batch();
+        }
+    }
+
+    score_batch();
+
+    if(dist_labels.size() > k) {
+        std::nth_element(dist_labels.begin(), dist_labels.begin() + k, dist_labels.end());
+        dist_labels.resize(k);
+    }
+
+    std::sort(dist_labels.begin(), dist_labels.end());
+    return dist_labels;
+}
+
+const spp::sparse_hash_map<std::string, hnsw_index_t*>& Index::_get_vector_index() const {
     return vector_index;
 }
 
@@ -6897,25 +8945,34 @@ facet_index_t* Index::_get_facet_index() const {
     return facet_index_v4;
 }
 
+const facet_result_cache_t& Index::_get_facet_result_cache() const {
+    return facet_result_cache;
+}
+
 void Index::refresh_schemas(const std::vector<field>& new_fields, const std::vector<field>& del_fields) {
     std::unique_lock lock(mutex);
+    write_generation++;
 
     for(const auto & new_field: new_fields) {
         if(!new_field.index || new_field.is_dynamic()) {
             continue;
         }
 
+        memory_accounting_scope_t memory_scope(memory_stats, get_memory_structure(new_field));
+
         search_schema.emplace(new_field.name, new_field);
 
         if(new_field.type == field_types::FLOAT_ARRAY && new_field.num_dim > 0) {
-            auto hnsw_index = new hnsw_index_t(new_field.num_dim, 1024, new_field.vec_dist, new_field.hnsw_params["M"].get<uint32_t>(), new_field.hnsw_params["ef_construction"].get<uint32_t>());
+            auto hnsw_index = create_hnsw_index(new_field);
             vector_index.emplace(new_field.name, hnsw_index);
             continue;
         }
 
         if(new_field.is_sortable()) {
+            memory_accounting_scope_t sort_memory_scope(memory_stats, new_field.is_num_sortable() ? MEMORY_SORT :
+                                                                      MEMORY_STRING_SORT);
             if(new_field.is_num_sortable()) {
-                auto doc_to_score = new spp::sparse_hash_map<uint32_t, int64_t, Hasher32>();
+                auto doc_to_score = new sort_column_t();
                 sort_index.emplace(new_field.name, doc_to_score);
             } else if(new_field.is_str_sortable()) {
                 str_sort_index.emplace(new_field.name, new adi_tree_t);
@@ -6941,12 +8998,16 @@ void Index::refresh_schemas(const std::vector<field>& new_fields, const std::vec
                 } else {
                     num_tree_t* num_tree = new num_tree_t;
                     numerical_index.emplace(new_field.name, num_tree);
+
+                    if(new_field.facet && (new_field.is_integer() || new_field.is_float())) {
+                        numeric_facet_totals.emplace(new_field.name, facet_stats_t());
+                    }
                 }
             }
         }
 
         if(new_field.is_facet()) {
-
+            memory_accounting_scope_t facet_memory_scope(memory_stats, MEMORY_FACET);
             initialize_facet_indexes(new_field);
 
             // initialize for non-string facet fields
@@ -6958,12 +9019,21 @@ void Index::refresh_schemas(const std::vector<field>& new_fields, const std::vec
         }
 
         if(new_field.infix) {
+            memory_accounting_scope_t infix_memory_scope(memory_stats, MEMORY_INFIX);
             array_mapped_infix_t infix_sets(ARRAY_INFIX_DIM);
             for(auto& infix_set: infix_sets) {
                 infix_set = new tsl::htrie_set<char>();
             }
 
             infix_index.emplace(new_field.name, infix_sets);
+
+            if(trigram_index_t::is_enabled()) {
+                infix_trigram_index.emplace(new_field.name, new trigram_index_t());
+            }
+        }
+
+        if(new_field.exact_match_index && new_field.is_string()) {
+            exact_match_index.emplace(new_field.name, new exact_match_index_t());
         }
     }
 
@@ -6979,6 +9049,8 @@ void Index::refresh_schemas(const std::vector<field>& new_fields, const std::vec
             continue;
         }
 
+        memory_accounting_scope_t memory_scope(memory_stats, get_memory_structure(del_field));
+
         if(del_field.is_string() || field_types::is_string_or_array(del_field.type)) {
             art_tree_destroy(search_index[del_field.name]);
             delete search_index[del_field.name];
@@ -7002,10 +9074,13 @@ void Index::refresh_schemas(const std::vector<field>& new_fields, const std::vec
             } else {
                 delete numerical_index[del_field.name];
                 numerical_index.erase(del_field.name);
+                numeric_facet_totals.erase(del_field.name);
             }
         }
 
         if(del_field.is_sortable()) {
+            memory_accounting_scope_t sort_memory_scope(memory_stats, del_field.is_num_sortable() ? MEMORY_SORT :
+                                                                      MEMORY_STRING_SORT);
             if(del_field.is_num_sortable()) {
                 delete sort_index[del_field.name];
                 sort_index.erase(del_field.name);
@@ -7016,7 +9091,9 @@ void Index::refresh_schemas(const std::vector<field>& new_fields, const std::vec
         }
 
         if(del_field.is_facet()) {
+            memory_accounting_scope_t facet_memory_scope(memory_stats, MEMORY_FACET);
             facet_index_v4->erase(del_field.name);
+            facet_cost_model.remove_field(del_field.name);
 
             if(!del_field.is_string()) {
                 art_tree_destroy(search_index[del_field.faceted_name()]);
@@ -7026,12 +9103,25 @@ void Index::refresh_schemas(const std::vector<field>& new_fields, const std::vec
         }
 
         if(del_field.infix) {
+            memory_accounting_scope_t infix_memory_scope(memory_stats, MEMORY_INFIX);
             auto& infix_set = infix_index[del_field.name];
             for(size_t i = 0; i < infix_set.size(); i++) {
                 delete infix_set[i];
             }
 
             infix_index.erase(del_field.name);
+
+            auto trigram_index_it = infix_trigram_index.find(del_field.name);
+            if(trigram_index_it != infix_trigram_index.end()) {
+                delete trigram_index_it->second;
+                infix_trigram_index.erase(trigram_index_it);
+            }
+        }
+
+        auto exact_match_index_it = exact_match_index.find(del_field.name);
+        if(exact_match_index_it != exact_match_index.end()) {
+            delete exact_match_index_it->second;
+            exact_match_index.erase(exact_match_index_it);
         }
 
         if(del_field.num_dim) {
@@ -7042,6 +9132,37 @@ void Index::refresh_schemas(const std::vector<field>& new_fields, const std::vec
     }
 }
 
+uint32_t Index::get_backfill_end(const std::string& field_name) const {
+    if(backfill_fields.empty() || backfill_fields.count(field_name) == 0) {
+        return UINT32_MAX;
+    }
+
+    return backfill_end;
+}
+
+void Index::start_backfill(const std::vector<field>& new_fields) {
+    refresh_schemas(new_fields, {});
+
+    std::unique_lock lock(mutex);
+
+    backfill_end = 0;
+    for(const auto& new_field: new_fields) {
+        backfill_fields.insert(new_field.name);
+    }
+}
+
+void Index::set_backfill_end(uint32_t seq_id) {
+    backfill_end = seq_id;
+}
+
+void Index::finish_backfill() {
+    std::unique_lock lock(mutex);
+
+    backfill_fields.clear();
+    backfill_end = 0;
+    write_generation++;
+}
+
 void Index::handle_doc_ops(const tsl::htrie_map<char, field>& search_schema,
                            nlohmann::json& update_doc, const nlohmann::json& old_doc) {
 
@@ -7147,6 +9268,34 @@ size_t Index::num_seq_ids() const {
     return seq_ids->num_ids();
 }
 
+const index_memory_stats_t& Index::get_memory_stats() const {
+    return memory_stats;
+}
+
+memory_structure_t Index::get_memory_structure(const field& afield) {
+    if(afield.name == "id") {
+        return MEMORY_IDS;
+    }
+
+    if(afield.is_reference_helper) {
+        return MEMORY_REFERENCE;
+    }
+
+    if(afield.is_string()) {
+        return MEMORY_TEXT;
+    }
+
+    if(afield.is_geopoint()) {
+        return MEMORY_GEO;
+    }
+
+    if(afield.num_dim > 0) {
+        return MEMORY_VECTOR;
+    }
+
+    return MEMORY_NUMERIC;
+}
+
 Option<bool> Index::seq_ids_outside_top_k(const std::string& field_name, size_t k,
                                           std::vector<uint32_t>& outside_seq_ids) {
     std::shared_lock lock(mutex);
@@ -7165,8 +9314,35 @@ Option<bool> Index::seq_ids_outside_top_k(const std::string& field_name, size_t
     return Option<bool>(400, "Field `" + field_name + "` not found in numerical index.");
 }
 
+bool Index::likely_sparse_results(const std::vector<token_t>& tokens, const std::string& field_name,
+                                  size_t min_results) const {
+    auto tree_it = search_index.find(field_name);
+
+    if(tree_it == search_index.end()) {
+        return false;
+    }
+
+    for(const auto& token: tokens) {
+        if(token.is_prefix_searched) {
+            // the completions of a prefix are not known from the token itself
+            continue;
+        }
+
+        art_leaf* leaf = (art_leaf *) art_search(tree_it->second, (const unsigned char*) token.value.c_str(),
+                                                 token.value.length()+1);
+
+        // a document has to match every token, barring typos, so the rarest token bounds the results
+        if(leaf == nullptr || posting_t::num_ids(leaf->values) < min_results) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void Index::resolve_space_as_typos(std::vector<std::string>& qtokens, const string& field_name,
-                                   std::vector<std::vector<std::string>>& resolved_queries) const {
+                                   std::vector<std::vector<std::string>>& resolved_queries,
+                                   const std::atomic<bool>* cancelled) const {
 
     auto tree_it = search_index.find(field_name);
 
@@ -7206,6 +9382,10 @@ void Index::resolve_space_as_typos(std::vector<std::string>& qtokens, const stri
         // b) join 2 adjacent tokens in a sliding window (provided they are atleast 2 tokens in size)
 
         for(size_t i = 0; i < qtokens_size-1 && qtokens_size > 2; i++) {
+            if(cancelled != nullptr && cancelled->load()) {
+                return ;
+            }
+
             std::vector<std::string> candidate_tokens;
 
             for(size_t j = 0; j < i; j++) {
@@ -7240,6 +9420,10 @@ void Index::resolve_space_as_typos(std::vector<std::string>& qtokens, const stri
 
     // concats did not work, we will try splitting individual tokens
     for(size_t i = 0; i < qtokens_size; i++) {
+        if(cancelled != nullptr && cancelled->load()) {
+            return ;
+        }
+
         std::vector<std::string> candidate_tokens;
 
         for(size_t j = 0; j < i; j++) {
@@ -7464,6 +9648,147 @@ void Index::repair_hnsw_index() {
     }
 }
 
+size_t Index::compact_vector_indices() {
+    std::vector<std::string> vector_fields;
+
+    std::shared_lock read_lock(mutex);
+
+    for(auto& vec_kv: vector_index) {
+        if(vec_kv.second->needs_compaction()) {
+            vector_fields.push_back(vec_kv.first);
+        }
+    }
+
+    read_lock.unlock();
+
+    size_t num_compacted = 0;
+
+    for(const auto& vector_field: vector_fields) {
+        // searches go on while the graph is built, but writes wait for it
+        read_lock.lock();
+
+        auto vec_index_it = vector_index.find(vector_field);
+        if(vec_index_it == vector_index.end()) {
+            read_lock.unlock();
+            continue;
+        }
+
+        hnsw_index_t* vec_index = vec_index_it->second;
+        auto old_graph = vec_index->vecdex;
+        const uint64_t num_writes = vec_index->num_writes;
+        const size_t num_deleted = old_graph->getDeletedCount();
+
+        auto compacted_graph = vec_index->build_compacted_graph(indexing_thread_pool);
+        read_lock.unlock();
+
+        std::unique_lock write_lock(mutex);
+        vec_index_it = vector_index.find(vector_field);
+
+        if(vec_index_it == vector_index.end() || vec_index_it->second != vec_index ||
+           vec_index->vecdex != old_graph || vec_index->num_writes != num_writes) {
+            // written to between the build and the swap: left to the next round
+            delete compacted_graph;
+            continue;
+        }
+
+        {
+            // a repair of the old graph might still be running
+            std::unique_lock repair_lock(vec_index->repair_m);
+            vec_index->vecdex = compacted_graph;
+        }
+
+        delete old_graph;
+        num_compacted++;
+
+        LOG(INFO) << "Compacted vector index of field " << vector_field << ", removed " << num_deleted
+                  << " deleted points.";
+    }
+
+    return num_compacted;
+}
+
+Option<bool> Index::save_vector_index_images(const std::string& image_dir, const std::string& file_prefix,
+                                             nlohmann::json& vector_images) const {
+    std::shared_lock lock(mutex);
+
+    size_t field_num = 0;
+    for(auto& vec_kv: vector_index) {
+        if(vec_kv.second->full_vectors != nullptr) {
+            // its float vectors are in a scratch file that does not outlive the process, so the graph is built again
+            // from the documents instead
+            continue;
+        }
+
+        // field names can contain characters that are not safe for a file name
+        const std::string file_name = file_prefix + "_" + std::to_string(field_num++) + ".hnsw";
+        std::unique_lock repair_lock(vec_kv.second->repair_m);
+
+        try {
+            vec_kv.second->vecdex->saveIndex(image_dir + "/" + file_name);
+        } catch(const std::exception& e) {
+            return Option<bool>(500, "Unable to save vector index of field `" + vec_kv.first + "`: " + e.what());
+        }
+
+        vector_images[vec_kv.first] = file_name;
+    }
+
+    return Option<bool>(true);
+}
+
+Option<bool> Index::load_vector_index_images(const std::string& image_dir, const nlohmann::json& vector_images) {
+    std::unique_lock lock(mutex);
+
+    for(auto it = vector_images.begin(); it != vector_images.end(); ++it) {
+        auto vec_index_it = vector_index.find(it.key());
+        if(vec_index_it == vector_index.end() || !it.value().is_string()) {
+            continue;
+        }
+
+        hnsw_index_t* hnsw_index = vec_index_it->second;
+        const std::string& image_path = image_dir + "/" + it.value().get<std::string>();
+        hnswlib::HierarchicalNSW<float>* loaded_vecdex = nullptr;
+
+        try {
+            loaded_vecdex = new hnswlib::HierarchicalNSW<float>(hnsw_index->graph_space(), image_path, false, 0, true);
+        } catch(const std::exception& e) {
+            return Option<bool>(500, "Unable to load vector index of field `" + it.key() + "`: " + e.what());
+        }
+
+        if(loaded_vecdex->data_size_ != hnsw_index->graph_space()->get_data_size()) {
+            delete loaded_vecdex;
+            return Option<bool>(400, "Dimensions or quantization of vector index image of field `" + it.key() +
+                                     "` do not match the schema.");
+        }
+
+        std::unique_lock repair_lock(hnsw_index->repair_m);
+        delete hnsw_index->vecdex;
+        hnsw_index->vecdex = loaded_vecdex;
+        preloaded_vector_fields.insert(it.key());
+    }
+
+    return Option<bool>(true);
+}
+
+void Index::clear_preloaded_vector_fields() {
+    std::unique_lock lock(mutex);
+    preloaded_vector_fields.clear();
+}
+
+void Index::reserve_vector_capacity(size_t num_points) {
+    std::unique_lock lock(mutex);
+
+    for(auto& vec_kv: vector_index) {
+        if(preloaded_vector_fields.count(vec_kv.first) != 0) {
+            continue;
+        }
+
+        auto vecdex = vec_kv.second->vecdex;
+        if(vecdex->getMaxElements() < num_points) {
+            vecdex->resizeIndex(num_points);
+        }
+    }
+}
+
 int64_t Index::reference_string_sort_score(const string &field_name, const uint32_t &seq_id) const {
     std::shared_lock lock(mutex);
     return str_sort_index.at(field_name)->rank(seq_id);
@@ -3,7 +3,9 @@
 #include "string_utils.h"
 #include "logger.h"
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <unordered_map>
 
 extern "C" {
     #include "libkakasi.h"
@@ -47,6 +49,79 @@ char* JapaneseLocalizer::normalize(const std::string& text) {
     return kakasi_do((char *)text.c_str());
 }
 
+static thread_local std::unordered_map<std::string, std::string> cached_normalizations;
+
+bool JapaneseLocalizer::get_cached(const std::string& text, std::string& normalized) {
+    if(text.size() > MAX_CACHED_TEXT_SIZE) {
+        return false;
+    }
+
+    auto it = cached_normalizations.find(text);
+    if(it == cached_normalizations.end()) {
+        return false;
+    }
+
+    normalized = it->second;
+    return true;
+}
+
+void JapaneseLocalizer::cache(const std::string& text, const std::string& normalized) {
+    if(text.size() > MAX_CACHED_TEXT_SIZE) {
+        return ;
+    }
+
+    if(cached_normalizations.size() >= MAX_CACHED_NORMALIZATIONS) {
+        cached_normalizations.clear();
+    }
+
+    cached_normalizations.emplace(text, normalized);
+}
+
+void JapaneseLocalizer::normalize_uncached(const std::string& text, std::string& normalized) {
+    char* normalized_text = kakasi_do((char *)text.c_str());
+    normalized.assign(normalized_text, strlen(normalized_text));
+    free(normalized_text);
+}
+
+void JapaneseLocalizer::normalize(const std::string& text, std::string& normalized) {
+    if(get_cached(text, normalized)) {
+        return ;
+    }
+
+    {
+        std::unique_lock lk(m);
+        normalize_uncached(text, normalized);
+    }
+
+    cache(text, normalized);
+}
+
+void JapaneseLocalizer::normalize_batch(const std::vector<std::string>& texts, std::vector<std::string>& normalized) {
+    normalized.resize(texts.size());
+    std::vector<size_t> uncached_indices;
+
+    for(size_t i = 0; i < texts.size(); i++) {
+        if(!get_cached(texts[i], normalized[i])) {
+            uncached_indices.push_back(i);
+        }
+    }
+
+    if(uncached_indices.empty()) {
+        return ;
+    }
+
+    {
+        std::unique_lock lk(m);
+        for(size_t i: uncached_indices) {
+            normalize_uncached(texts[i], normalized[i]);
+        }
+    }
+
+    for(size_t i: uncached_indices) {
+        cache(texts[i], normalized[i]);
+    }
+}
+
 JapaneseLocalizer::JapaneseLocalizer() {
     init();
 }
@@ -0,0 +1,64 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+
+size_t latency_histogram_t::bucket_index(uint64_t value) {
+    if(value < SUB_BUCKETS) {
+        return value;
+    }
+
+    const size_t msb = 63 - __builtin_clzll(value);
+    if(msb >= MAX_VALUE_BITS) {
+        return NUM_BUCKETS - 1;
+    }
+
+    // the top `SUB_BUCKET_BITS + 1` bits of the value pick the bucket
+    const size_t shift = msb - SUB_BUCKET_BITS;
+    return (shift << SUB_BUCKET_BITS) + (value >> shift);
+}
+
+uint64_t latency_histogram_t::bucket_upper_bound(size_t index) {
+    if(index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+
+    const size_t shift = (index >> SUB_BUCKET_BITS) - 1;
+    const uint64_t sub_bucket = index - (shift << SUB_BUCKET_BITS);
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+uint64_t latency_histogram_t::value_at_percentile(const std::vector<uint64_t>& bucket_counts, double percentile) {
+    uint64_t total = 0;
+    for(const auto count: bucket_counts) {
+        total += count;
+    }
+
+    if(total == 0) {
+        return 0;
+    }
+
+    const uint64_t rank = std::max<uint64_t>(1, std::ceil(total * percentile / 100));
+    uint64_t seen = 0;
+
+    for(size_t i = 0; i < bucket_counts.size(); i++) {
+        seen += bucket_counts[i];
+        if(seen >= rank) {
+            return bucket_upper_bound(i);
+        }
+    }
+
+    return bucket_upper_bound(bucket_counts.size() - 1);
+}
+
+void latency_histogram_t::record(uint64_t value) {
+    counts[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    total_count.fetch_add(1, std::memory_order_relaxed);
+    total_sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+void latency_histogram_t::snapshot(std::vector<uint64_t>& bucket_counts) const {
+    bucket_counts.resize(NUM_BUCKETS);
+    for(size_t i = 0; i < NUM_BUCKETS; i++) {
+        bucket_counts[i] = counts[i].load(std::memory_order_relaxed);
+    }
+}
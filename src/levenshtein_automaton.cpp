@@ -0,0 +1,278 @@
+#include "levenshtein_automaton.h"
+#include <algorithm>
+#include <cstring>
+
+static inline void levenshtein_dist(const int depth, const unsigned char p, const unsigned char c,
+                                    const unsigned char* term, const int term_len,
+                                    const int* irow, const int* jrow, int* krow, const int cost_cap) {
+    krow[0] = std::min(jrow[0] + 1, cost_cap);
+
+    // Calculate levenshtein distance incrementally (term => b, column => j, c => a[i], p => a[i-1], irow => d[i-1]):
+    // https://en.wikipedia.org/wiki/Damerau%E2%80%93Levenshtein_distance#Optimal_string_alignment_distance
+
+    for(int column=1; column<=term_len; column++) {
+        int cost = (c == term[column-1]) ? 0 : 1;  // column-1 used because of zero-based char array
+
+        int delete_cost = jrow[column] + 1;
+        int insert_cost = krow[column - 1] + 1;
+        int substitution_cost = jrow[column - 1] + cost;
+
+        krow[column] = std::min(std::min(std::min(insert_cost, delete_cost), substitution_cost), cost_cap);
+
+        if(depth > 1 && column > 1 && c == term[column-1-1] && p == term[column-1]) {
+            krow[column] = std::min(krow[column], irow[column-2] + 1);
+        }
+    }
+}
+
+// -1: return without adding, 0 : continue iteration, 1: return after adding
+static inline int fuzzy_search_state(const bool prefix, int key_index, unsigned char p, unsigned char c,
+                                     const unsigned char* query, const int query_len,
+                                     const int* cost_row, int min_cost, int max_cost) {
+
+    // There are 2 scenarios:
+    // a) key_len < query_len: "pltninum" (query) on "pst" (key)
+    // b) query_len < key_len: "pst" (query) on "pltninum" (key)
+
+    bool last_key_char = (c == '\0');
+    int key_len = last_key_char ? key_index : key_index + 1;
+
+    if(last_key_char) {
+        // Last char, so have to return 1 or -1
+        if(cost_row[query_len] >= min_cost && cost_row[query_len] <= max_cost) {
+            return 1;
+        }
+
+        // Special case used to match q=strawberries on key=strawberry (query_len > key_len)
+        // but limit to larger keys to prevent eager matches
+        if(key_len > 5 && query_len > key_len && (query_len - key_len) <= max_cost &&
+           cost_row[key_len] >= min_cost && cost_row[key_len] <= max_cost-1) {
+            return 1;
+        }
+
+        return -1;
+    }
+
+    // `key_len` can't exceed `query_len` since length of `cost_row` is `query_len + 1`
+    int cost = cost_row[std::min(key_len, query_len)];
+
+    if(key_len >= query_len && prefix) {
+        // Case b)
+        // For prefix queries
+        // - we can return early if key_len reaches query_len and cost is within bounds.
+        // - might have to iterate past prefix query length to catch trailing typos.
+        if(cost >= min_cost && cost <= max_cost) {
+            return 1;
+        }
+    }
+
+    /*
+        Terminate the search early or continue iterating on the key?
+        We have to account for the case that `cost` could momentarily exceed max_cost but resolve later.
+        In such cases, we will compare characters in the query with p and/or c to decide.
+    */
+
+    if(cost <= max_cost) {
+        return 0;
+    }
+
+    if(cost == 2 || cost == 3) {
+        /*
+            [1 letter extra]
+            exam ple
+            exZa mple
+
+            [1 letter missing]
+            exam ple
+            exmp le
+
+            [1 letter missing + transpose]
+            dacrycystal gia
+            dacrcyystlg ia
+        */
+        bool letter_more = (key_index+1 < query_len && query[key_index+1] == c);
+        bool letter_less = (key_index > 0 && query[key_index-1] == c);
+        if(letter_more || letter_less) {
+            return 0;
+        }
+    }
+
+    if(cost == 3 || cost == 4) {
+        /*
+            [2 letter extra]
+            exam ple
+            eTxT ample
+
+            abbviat ion
+            abbrevi ation
+        */
+
+        bool extra_matching_letters = (key_index + 1 < query_len && p == query[key_index + 1] &&
+                                       key_index + 2 < query_len && c == query[key_index + 2]);
+
+        if(extra_matching_letters) {
+            return 0;
+        }
+
+        /*
+            [2 letter missing]
+            exam ple
+            expl e
+       */
+
+        bool two_letter_less = (key_index > 1 && query[key_index-2] == c);
+        if(two_letter_less) {
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+levenshtein_automaton_t::levenshtein_automaton_t(const unsigned char* term, int term_len, int min_cost, int max_cost,
+                                                 bool prefix):
+        term((const char*) term, term_len), min_cost(min_cost), max_cost(max_cost), prefix(prefix),
+        cost_cap(std::max(max_cost, 4) + 1) {
+
+    // fuzzy_search_state() tells apart costs of up to 4, and cost_cap + 1 has to fit in a row value
+    memset(char_classes, OTHER_CLASS, sizeof(char_classes));
+    class_chars = {0, '\0'};
+
+    for(int i = 0; i < term_len; i++) {
+        if(term[i] != '\0' && char_classes[term[i]] == OTHER_CLASS) {
+            char_classes[term[i]] = class_chars.size();
+            class_chars.push_back(term[i]);
+        }
+    }
+
+    // the term has at most 255 distinct chars, so some non-null char stands for all the chars not in it
+    for(int c = 1; c < 256; c++) {
+        if(char_classes[c] == OTHER_CLASS) {
+            class_chars[OTHER_CLASS] = c;
+            break;
+        }
+    }
+
+    char_classes[0] = NULL_CLASS;
+
+    std::vector<int> initial_row(term_len + 1);
+    for(int i = 0; i <= term_len; i++) {
+        initial_row[i] = std::min(i, cost_cap);
+    }
+
+    add_state(0, NULL_CLASS, initial_row.data(), initial_row.data());
+}
+
+uint32_t levenshtein_automaton_t::add_state(int depth, uint8_t prev_class, const int* prev_row, const int* row) {
+    const size_t columns = term.size() + 1;
+
+    std::string key;
+    key.reserve(sizeof(depth) + 1 + 2 * columns);
+    key.append((const char*) &depth, sizeof(depth));
+    key.push_back((char) prev_class);
+    for(size_t i = 0; i < columns; i++) {
+        key.push_back((char) prev_row[i]);
+    }
+    for(size_t i = 0; i < columns; i++) {
+        key.push_back((char) row[i]);
+    }
+
+    auto it = state_ids.find(key);
+    if(it != state_ids.end()) {
+        return it->second;
+    }
+
+    const uint32_t state = state_depths.size();
+    state_ids.emplace(std::move(key), state);
+
+    state_depths.push_back(depth);
+    state_prev_classes.push_back(prev_class);
+    for(size_t i = 0; i < columns; i++) {
+        state_rows.push_back(prev_row[i]);
+    }
+    for(size_t i = 0; i < columns; i++) {
+        state_rows.push_back(row[i]);
+    }
+
+    transitions.resize(transitions.size() + class_chars.size(), NOT_COMPUTED);
+    end_actions.push_back(NOT_COMPUTED);
+
+    return state;
+}
+
+int32_t levenshtein_automaton_t::compute_transition(uint32_t state, uint8_t char_class) {
+    const int term_len = term.size();
+    const int columns = term_len + 1;
+    const auto* query = (const unsigned char*) term.data();
+
+    const int depth = state_depths[state];
+    const unsigned char p = class_chars[state_prev_classes[state]];
+    const unsigned char c = class_chars[char_class];
+
+    int irow[columns], jrow[columns], krow[columns];
+    const uint8_t* rows = &state_rows[size_t(state) * 2 * columns];
+    for(int i = 0; i < columns; i++) {
+        irow[i] = rows[i];
+        jrow[i] = rows[columns + i];
+    }
+
+    const int* prev_row = irow;
+    const int* row = jrow;
+
+    if(!prefix || c != '\0') {
+        levenshtein_dist(depth, p, c, query, term_len, irow, jrow, krow, cost_cap);
+        prev_row = jrow;
+        row = krow;
+    }
+
+    const int action = fuzzy_search_state(prefix, depth, p, c, query, term_len, row, min_cost, max_cost);
+    if(action == 1) {
+        return ACCEPTED;
+    }
+
+    if(action == -1) {
+        return REJECTED;
+    }
+
+    return add_state(depth + 1, char_class, prev_row, row);
+}
+
+levenshtein_automaton_t::action_t levenshtein_automaton_t::step(uint32_t& state, unsigned char c) {
+    const uint8_t char_class = char_classes[c];
+    const size_t index = size_t(state) * class_chars.size() + char_class;
+
+    int32_t next = transitions[index];
+    if(next == NOT_COMPUTED) {
+        // computing the transition can add a state, which resizes `transitions`
+        next = compute_transition(state, char_class);
+        transitions[index] = next;
+    }
+
+    if(next == ACCEPTED) {
+        return ACCEPT;
+    }
+
+    if(next == REJECTED) {
+        return REJECT;
+    }
+
+    state = next;
+    return CONTINUE;
+}
+
+levenshtein_automaton_t::action_t levenshtein_automaton_t::end(uint32_t state) {
+    if(end_actions[state] == NOT_COMPUTED) {
+        const int columns = term.size() + 1;
+        const uint8_t* rows = &state_rows[size_t(state) * 2 * columns + columns];
+        int row[columns];
+        for(int i = 0; i < columns; i++) {
+            row[i] = rows[i];
+        }
+
+        end_actions[state] = fuzzy_search_state(prefix, state_depths[state], '\0', '\0',
+                                                (const unsigned char*) term.data(), term.size(), row,
+                                                min_cost, max_cost);
+    }
+
+    return action_t(end_actions[state]);
+}
@@ -5,12 +5,24 @@
 #include <numeric>
 #include <chrono>
 #include <art.h>
+#include <cvt.h>
 #include <unordered_map>
 #include <queue>
 #include <ctime>
+#include <iomanip>
+#include <random>
 #include "collection.h"
 #include "string_utils.h"
 #include "collection_manager.h"
+#include "posting.h"
+#include "posting_list.h"
+#include "array_utils.h"
+#include "topster.h"
+#include "embedder_manager.h"
+#include "filter.h"
+#include "filter_result_iterator.h"
+#include "tokenizer.h"
+#include "memory_accounting.h"
 
 using namespace std;
 
@@ -169,6 +181,889 @@ void benchmark_reactjs_pages(char* file_path) {
     std::cout << "Results total: " << results_total << std::endl;
 }
 
+void benchmark_intersection() {
+    // two common terms: each matches the given fraction of a 5M document collection
+    const uint32_t num_docs = 5000000;
+    const std::vector<std::pair<double, double>> densities = {{0.5, 0.5}, {0.2, 0.05}, {0.01, 0.3}};
+    const size_t num_runs = 10;
+
+    for(const auto& density: densities) {
+        posting_list_t p1(256), p2(256);
+        std::vector<uint32_t> ids1, ids2;
+
+        for(uint32_t id = 0; id < num_docs; id++) {
+            if(double(rand()) / RAND_MAX < density.first) {
+                ids1.push_back(id);
+                p1.upsert(id, {0});
+            }
+
+            if(double(rand()) / RAND_MAX < density.second) {
+                ids2.push_back(id);
+                p2.upsert(id, {0});
+            }
+        }
+
+        uint64_t results_total = 0; // to prevent no-op optimization!
+
+        // arrays only
+        auto begin = std::chrono::high_resolution_clock::now();
+        for(size_t run = 0; run < num_runs; run++) {
+            uint32_t* out = nullptr;
+            results_total += ArrayUtils::and_scalar(ids1.data(), ids1.size(), ids2.data(), ids2.size(), &out);
+            delete [] out;
+        }
+        long long int scalar_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+
+        std::vector<uint32_t> out(std::min(ids1.size(), ids2.size()));
+        begin = std::chrono::high_resolution_clock::now();
+        for(size_t run = 0; run < num_runs; run++) {
+            results_total += ArrayUtils::and_simd(ids1.data(), ids1.size(), ids2.data(), ids2.size(), out.data());
+        }
+        long long int simd_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+
+        // posting lists: iterator based intersection vs. block-wise intersection
+        begin = std::chrono::high_resolution_clock::now();
+        for(size_t run = 0; run < num_runs; run++) {
+            std::vector<posting_list_t::iterator_t> its;
+            its.push_back(p1.new_iterator());
+            its.push_back(p2.new_iterator());
+            while(!posting_list_t::at_end2(its)) {
+                if(posting_list_t::equals2(its)) {
+                    results_total++;
+                    posting_list_t::advance_all2(its);
+                } else {
+                    posting_list_t::advance_non_largest2(its);
+                }
+            }
+        }
+        long long int iterator_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+
+        begin = std::chrono::high_resolution_clock::now();
+        for(size_t run = 0; run < num_runs; run++) {
+            std::vector<uint32_t> result_ids;
+            posting_list_t::intersect({&p1, &p2}, result_ids);
+            results_total += result_ids.size();
+        }
+        long long int block_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+
+        std::cout << "Densities: " << density.first << ", " << density.second
+                  << ", ids: " << ids1.size() << ", " << ids2.size() << std::endl;
+        std::cout << "  and_scalar: " << scalar_micros / num_runs << "us, and_simd: " << simd_micros / num_runs
+                  << "us" << std::endl;
+        std::cout << "  iterators: " << iterator_micros / num_runs << "us, block-wise: " << block_micros / num_runs
+                  << "us" << std::endl;
+        std::cout << "  results total: " << results_total << std::endl;
+    }
+}
+
+void benchmark_topster() {
+    // the churn of a per-query topster: most added documents displace the current minimum
+    const std::vector<size_t> capacities = {10, 250, 10000};
+    const size_t num_adds = 1000000;
+    const size_t num_runs = 10;
+
+    for(auto capacity: capacities) {
+        uint64_t results_total = 0; // to prevent no-op optimization!
+
+        // kv map with the default allocator
+        auto begin = std::chrono::high_resolution_clock::now();
+        for(size_t run = 0; run < num_runs; run++) {
+            std::unordered_map<uint64_t, KV*> kv_map;
+            for(uint64_t seq_id = 0; seq_id < num_adds; seq_id++) {
+                if(kv_map.size() >= capacity) {
+                    kv_map.erase(seq_id - capacity);
+                }
+                kv_map.emplace(seq_id, nullptr);
+            }
+            results_total += kv_map.size();
+        }
+        long long int default_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+
+        // kv map that recycles its nodes from a pool, as the topster does
+        begin = std::chrono::high_resolution_clock::now();
+        for(size_t run = 0; run < num_runs; run++) {
+            node_pool_t<> pool;
+            Topster::kv_map_allocator_t allocator(&pool);
+            std::unordered_map<uint64_t, KV*, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                               Topster::kv_map_allocator_t> kv_map(0, std::hash<uint64_t>(),
+                                                                   std::equal_to<uint64_t>(), allocator);
+            for(uint64_t seq_id = 0; seq_id < num_adds; seq_id++) {
+                if(kv_map.size() >= capacity) {
+                    kv_map.erase(seq_id - capacity);
+                }
+                kv_map.emplace(seq_id, nullptr);
+            }
+            results_total += kv_map.size();
+        }
+        long long int pool_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+
+        // end to end topster adds
+        begin = std::chrono::high_resolution_clock::now();
+        for(size_t run = 0; run < num_runs; run++) {
+            Topster topster(capacity);
+            for(uint64_t seq_id = 0; seq_id < num_adds; seq_id++) {
+                int64_t scores[3] = {int64_t(seq_id), 0, 0};
+                KV kv(0, seq_id, seq_id, 0, scores);
+                topster.add(&kv);
+            }
+            results_total += topster.size;
+        }
+        long long int topster_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+
+        std::cout << "Capacity: " << capacity << std::endl;
+        std::cout << "  default allocator: " << default_micros / num_runs << "us, pool: "
+                  << pool_micros / num_runs << "us, topster adds: " << topster_micros / num_runs << "us" << std::endl;
+        std::cout << "  results total: " << results_total << std::endl;
+    }
+}
+
+void benchmark_embedding(const std::string& model_name, const std::string& model_dir) {
+    // embeddings per second of a local model with the session options of each configuration
+    EmbedderManager::set_model_dir(model_dir);
+
+    size_t num_dims = 0;
+    auto init_op = EmbedderManager::get_instance().validate_and_init_local_model({{"model_name", model_name}}, num_dims);
+    if(!init_op.ok()) {
+        std::cout << "Could not load model " << model_name << ": " << init_op.error() << std::endl;
+        return;
+    }
+
+    std::vector<std::string> texts;
+    for(size_t i = 0; i < 256; i++) {
+        texts.push_back("The quick brown fox " + std::to_string(i) + " jumps over the lazy dog near the river bank");
+    }
+
+    const auto& model_name_without_namespace = EmbedderManager::get_model_name_without_namespace(model_name);
+    const bool has_quantized_model = std::filesystem::exists(
+            EmbedderManager::get_absolute_quantized_model_path(model_name_without_namespace));
+
+    std::vector<nlohmann::json> configs = {
+        {{"model_name", model_name}},
+        {{"model_name", model_name}, {"intra_op_threads", 1}},
+        {{"model_name", model_name}, {"intra_op_threads", 2}},
+        {{"model_name", model_name}, {"intra_op_threads", 4}},
+        {{"model_name", model_name}, {"execution_provider", "cpu"}},
+    };
+
+    if(has_quantized_model) {
+        configs.push_back({{"model_name", model_name}, {"quantized", true}});
+        configs.push_back({{"model_name", model_name}, {"quantized", true}, {"intra_op_threads", 1}});
+    }
+
+    for(const auto& config: configs) {
+        auto options_op = local_model_options_t::parse(config);
+        TextEmbedder embedder(model_name_without_namespace, options_op.get());
+
+        // the first run allocates the arenas of the session
+        embedder.batch_embed(std::vector<std::string>(texts.begin(), texts.begin() + 8));
+
+        auto begin = std::chrono::high_resolution_clock::now();
+        auto embeddings = embedder.batch_embed(texts);
+        long long int micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - begin).count();
+
+        std::cout << config.dump() << ": " << (texts.size() * 1000000.0 / std::max<long long int>(micros, 1))
+                  << " embeddings/sec, failed: "
+                  << std::count_if(embeddings.begin(), embeddings.end(), [](const auto& res) { return !res.success; })
+                  << std::endl;
+    }
+}
+
+// A suite of benchmarks over generated data, whose results can be compared between releases. Every case is run
+// until it has taken at least `MIN_CASE_TIME_MS`, and the median time of its runs is reported. All data comes from a
+// generator seeded with `--seed`, so that two runs with the same seed measure the same work.
+class benchmark_suite_t {
+private:
+    static constexpr size_t MIN_CASE_RUNS = 5;
+    static constexpr size_t MAX_CASE_RUNS = 1000;
+    static constexpr long long int MIN_CASE_TIME_MS = 500;
+
+    std::string name_filter;
+    nlohmann::json results = nlohmann::json::array();
+
+public:
+    const uint64_t seed;
+    std::mt19937_64 rng;
+    uint64_t results_total = 0; // to prevent no-op optimization!
+
+    benchmark_suite_t(uint64_t seed, const std::string& name_filter): name_filter(name_filter), seed(seed), rng(seed) {
+
+    }
+
+    // whether the cases of that name are run, for cases whose data is expensive to set up
+    bool selects(const std::string& name) const {
+        return name_filter.empty() || name.find(name_filter) != std::string::npos;
+    }
+
+    // times `func`, which does `ops_per_run` operations on every call
+    template<class F>
+    void run(const std::string& name, size_t ops_per_run, F&& func) {
+        if(!selects(name)) {
+            return ;
+        }
+
+        // warm up
+        func();
+
+        std::vector<long long int> run_nanos;
+        long long int total_nanos = 0;
+
+        while(run_nanos.size() < MAX_CASE_RUNS &&
+              (run_nanos.size() < MIN_CASE_RUNS || total_nanos < MIN_CASE_TIME_MS * 1000 * 1000)) {
+            auto begin = std::chrono::high_resolution_clock::now();
+            func();
+            long long int nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::high_resolution_clock::now() - begin).count();
+            run_nanos.push_back(nanos);
+            total_nanos += nanos;
+        }
+
+        std::sort(run_nanos.begin(), run_nanos.end());
+        const double median_nanos = run_nanos[run_nanos.size() / 2];
+        const double nanos_per_op = median_nanos / std::max<size_t>(ops_per_run, 1);
+
+        nlohmann::json result;
+        result["name"] = name;
+        result["iterations"] = run_nanos.size();
+        result["real_time"] = nanos_per_op;
+        result["min_time"] = double(run_nanos.front()) / std::max<size_t>(ops_per_run, 1);
+        result["max_time"] = double(run_nanos.back()) / std::max<size_t>(ops_per_run, 1);
+        result["time_unit"] = "ns";
+        result["items_per_second"] = nanos_per_op == 0 ? 0 : 1e9 / nanos_per_op;
+        results.push_back(result);
+
+        std::cout << std::left << std::setw(48) << name << std::right << std::setw(14) << std::fixed
+                  << std::setprecision(1) << nanos_per_op << " ns/op" << std::setw(8) << run_nanos.size()
+                  << " runs" << std::endl;
+    }
+
+    // records a value that is measured once instead of timed, e.g. the memory held by a structure
+    void report(const std::string& name, const std::string& counter, double value) {
+        if(!selects(name)) {
+            return ;
+        }
+
+        nlohmann::json result;
+        result["name"] = name;
+        result["iterations"] = 1;
+        result[counter] = value;
+        results.push_back(result);
+
+        std::cout << std::left << std::setw(48) << name << std::right << std::setw(14) << std::fixed
+                  << std::setprecision(1) << value << " " << counter << std::endl;
+    }
+
+    // words of random letters, so that fuzzy searches have neighbours to find
+    std::vector<std::string> generate_words(size_t num_words) {
+        std::uniform_int_distribution<size_t> len_dist(3, 10);
+        std::uniform_int_distribution<int> char_dist('a', 'z');
+        std::vector<std::string> words;
+
+        for(size_t i = 0; i < num_words; i++) {
+            std::string word(len_dist(rng), 'a');
+            for(auto& c: word) {
+                c = char(char_dist(rng));
+            }
+            words.push_back(word);
+        }
+
+        return words;
+    }
+
+    // picks the first words far more often than the rest, like the words of natural text
+    const std::string& skewed_word(const std::vector<std::string>& words) {
+        const double u = std::uniform_real_distribution<double>(0, 1)(rng);
+        return words[std::min<size_t>(words.size() - 1, size_t(words.size() * u * u * u))];
+    }
+
+    nlohmann::json to_json() const {
+        nlohmann::json json;
+        json["context"]["seed"] = seed;
+        json["context"]["date"] = std::time(nullptr);
+        json["benchmarks"] = results;
+        return json;
+    }
+};
+
+void benchmark_posting_lists(benchmark_suite_t& suite) {
+    const uint32_t num_docs = 1000000;
+    std::uniform_real_distribution<double> dist(0, 1);
+
+    for(const auto& density: std::vector<std::pair<double, double>>{{0.5, 0.5}, {0.2, 0.01}}) {
+        posting_list_t p1(256), p2(256);
+        std::vector<uint32_t> ids2;
+
+        for(uint32_t id = 0; id < num_docs; id++) {
+            if(dist(suite.rng) < density.first) {
+                p1.upsert(id, {0});
+            }
+
+            if(dist(suite.rng) < density.second) {
+                ids2.push_back(id);
+                p2.upsert(id, {0});
+            }
+        }
+
+        const std::string suffix = "/" + std::to_string(p1.num_ids()) + "x" + std::to_string(p2.num_ids());
+
+        suite.run("posting_list/intersect" + suffix, 1, [&]() {
+            std::vector<uint32_t> result_ids;
+            posting_list_t::intersect({&p1, &p2}, result_ids);
+            suite.results_total += result_ids.size();
+        });
+
+        suite.run("posting_list/skip_to" + suffix, ids2.size(), [&]() {
+            auto it = p1.new_iterator();
+            for(auto id: ids2) {
+                it.skip_to(id);
+                if(!it.valid()) {
+                    break;
+                }
+                suite.results_total += (it.id() == id);
+            }
+        });
+    }
+}
+
+void benchmark_array_ops(benchmark_suite_t& suite) {
+    const uint32_t num_docs = 1000000;
+    std::uniform_real_distribution<double> dist(0, 1);
+
+    // similar sizes, and a few of sizes that differ by 20x to 1000x, as when a selective filter meets a common term
+    for(const auto& density: std::vector<std::pair<double, double>>{{0.5, 0.5}, {0.2, 0.01}, {0.5, 0.0005}}) {
+        std::vector<uint32_t> ids1, ids2;
+
+        for(uint32_t id = 0; id < num_docs; id++) {
+            if(dist(suite.rng) < density.first) {
+                ids1.push_back(id);
+            }
+
+            if(dist(suite.rng) < density.second) {
+                ids2.push_back(id);
+            }
+        }
+
+        const std::string suffix = "/" + std::to_string(ids1.size()) + "x" + std::to_string(ids2.size());
+        std::vector<uint32_t> out(ids1.size() + ids2.size());
+
+        suite.run("array_utils/and_scalar" + suffix, 1, [&]() {
+            uint32_t* results = nullptr;
+            suite.results_total += ArrayUtils::and_scalar(ids1.data(), ids1.size(), ids2.data(), ids2.size(),
+                                                          &results);
+            delete [] results;
+        });
+
+        suite.run("array_utils/and_simd" + suffix, 1, [&]() {
+            suite.results_total += ArrayUtils::and_simd(ids1.data(), ids1.size(), ids2.data(), ids2.size(),
+                                                        out.data());
+        });
+
+        suite.run("array_utils/or_scalar" + suffix, 1, [&]() {
+            uint32_t* results = nullptr;
+            suite.results_total += ArrayUtils::or_scalar(ids1.data(), ids1.size(), ids2.data(), ids2.size(),
+                                                         &results);
+            delete [] results;
+        });
+
+        suite.run("array_utils/or_simd" + suffix, 1, [&]() {
+            suite.results_total += ArrayUtils::or_simd(ids1.data(), ids1.size(), ids2.data(), ids2.size(),
+                                                       out.data());
+        });
+
+        suite.run("array_utils/exclude_scalar" + suffix, 1, [&]() {
+            uint32_t* results = nullptr;
+            suite.results_total += ArrayUtils::exclude_scalar(ids1.data(), ids1.size(), ids2.data(), ids2.size(),
+                                                              &results);
+            delete [] results;
+        });
+
+        suite.run("array_utils/exclude_simd" + suffix, 1, [&]() {
+            suite.results_total += ArrayUtils::exclude_simd(ids1.data(), ids1.size(), ids2.data(), ids2.size(),
+                                                            out.data());
+        });
+    }
+}
+
+void benchmark_art_fuzzy_search(benchmark_suite_t& suite) {
+    art_tree t;
+    art_tree_init(&t);
+
+    const auto& words = suite.generate_words(100000);
+    for(size_t i = 0; i < words.size(); i++) {
+        art_document doc(i, i, {0});
+        art_insert(&t, (const unsigned char*) words[i].c_str(), words[i].size() + 1, &doc);
+    }
+
+    std::vector<std::string> queries;
+    for(size_t i = 0; i < 1000; i++) {
+        queries.push_back(suite.skewed_word(words));
+    }
+
+    for(int max_cost: {0, 1, 2}) {
+        suite.run("art/fuzzy_search/typos:" + std::to_string(max_cost), queries.size(), [&]() {
+            for(const auto& query: queries) {
+                std::vector<art_leaf*> leaves;
+                std::set<std::string> exclude_leaves;
+                art_fuzzy_search(&t, (const unsigned char*) query.c_str(), query.size() + 1, 0, max_cost, 10, FREQUENCY,
+                                 false, false, "", nullptr, 0, leaves, exclude_leaves);
+                suite.results_total += leaves.size();
+            }
+        });
+    }
+
+    suite.run("art/prefix_search", queries.size(), [&]() {
+        for(const auto& query: queries) {
+            std::vector<art_leaf*> leaves;
+            std::set<std::string> exclude_leaves;
+            const size_t prefix_len = std::min<size_t>(3, query.size());
+            art_fuzzy_search(&t, (const unsigned char*) query.c_str(), prefix_len, 0, 0, 10, FREQUENCY,
+                             true, true, "", nullptr, 0, leaves, exclude_leaves);
+            suite.results_total += leaves.size();
+        }
+    });
+
+    art_tree_destroy(&t);
+}
+
+// The same tokens, each with a posting list of a single document, in ART and in CVTrie.
+void benchmark_cvt(benchmark_suite_t& suite) {
+    const auto& words = suite.generate_words(100000);
+
+    std::vector<std::string> queries;
+    for(size_t i = 0; i < 1000; i++) {
+        queries.push_back(suite.skewed_word(words));
+    }
+
+    art_tree t;
+    art_tree_init(&t);
+    CVTrie trie;
+
+    const int64_t art_begin_bytes = memory_accounting_scope_t::thread_net_allocated();
+    for(size_t i = 0; i < words.size(); i++) {
+        art_document doc(i, i, {0});
+        art_insert(&t, (const unsigned char*) words[i].c_str(), words[i].size() + 1, &doc);
+    }
+    const int64_t art_bytes = memory_accounting_scope_t::thread_net_allocated() - art_begin_bytes;
+
+    const int64_t cvt_begin_bytes = memory_accounting_scope_t::thread_net_allocated();
+    for(size_t i = 0; i < words.size(); i++) {
+        uint32_t ids[1] = {uint32_t(i)};
+        uint32_t offset_index[1] = {0};
+        uint32_t offsets[1] = {0};
+        void* list = SET_COMPACT_POSTING(compact_posting_list_t::create(1, ids, offset_index, 1, offsets));
+
+        void* prev_list = trie.find(words[i].c_str(), words[i].size());
+        if(prev_list != nullptr) {
+            posting_t::destroy_list(prev_list);
+        }
+
+        trie.add(words[i].c_str(), words[i].size(), list);
+    }
+    const int64_t cvt_bytes = memory_accounting_scope_t::thread_net_allocated() - cvt_begin_bytes;
+
+    // the allocation counters of jemalloc are not available in every build
+    if(art_bytes > 0) {
+        suite.report("dictionary/art/memory", "bytes_per_key", double(art_bytes) / art_size(&t));
+        suite.report("dictionary/cvt/memory", "bytes_per_key", double(cvt_bytes) / trie.size());
+    }
+    suite.report("dictionary/cvt/memory_nodes", "bytes_per_key", double(trie.memory_used()) / trie.size());
+
+    suite.run("dictionary/art/find", queries.size(), [&]() {
+        for(const auto& query: queries) {
+            suite.results_total += art_search(&t, (const unsigned char*) query.c_str(), query.size() + 1) != nullptr;
+        }
+    });
+
+    suite.run("dictionary/cvt/find", queries.size(), [&]() {
+        for(const auto& query: queries) {
+            suite.results_total += trie.find(query.c_str(), query.size()) != nullptr;
+        }
+    });
+
+    suite.run("dictionary/art/prefix_iter", queries.size(), [&]() {
+        for(const auto& query: queries) {
+            const size_t prefix_len = std::min<size_t>(3, query.size());
+            art_iter_prefix(&t, (const unsigned char*) query.c_str(), prefix_len,
+                            [](void* data, const unsigned char* key, uint32_t key_len, void* value) {
+                                (*(uint64_t*) data)++;
+                                return 0;
+                            }, &suite.results_total);
+        }
+    });
+
+    suite.run("dictionary/cvt/prefix_iter", queries.size(), [&]() {
+        for(const auto& query: queries) {
+            const size_t prefix_len = std::min<size_t>(3, query.size());
+            trie.iter_prefix(query.c_str(), prefix_len, [&suite](const std::string& key, void* value) {
+                suite.results_total++;
+                return true;
+            });
+        }
+    });
+
+    for(int max_cost: {1, 2}) {
+        suite.run("dictionary/art/fuzzy/typos:" + std::to_string(max_cost), queries.size(), [&]() {
+            for(const auto& query: queries) {
+                std::vector<art_leaf*> leaves;
+                std::set<std::string> exclude_leaves;
+                art_fuzzy_search(&t, (const unsigned char*) query.c_str(), query.size() + 1, 0, max_cost, 100,
+                                 FREQUENCY, false, false, "", nullptr, 0, leaves, exclude_leaves);
+                suite.results_total += leaves.size();
+            }
+        });
+
+        suite.run("dictionary/cvt/fuzzy/typos:" + std::to_string(max_cost), queries.size(), [&]() {
+            for(const auto& query: queries) {
+                std::vector<std::pair<std::string, void*>> results;
+                trie.fuzzy_search(query.c_str(), query.size(), 0, max_cost, false, 100, results);
+                suite.results_total += results.size();
+            }
+        });
+    }
+
+    trie.iter_prefix("", 0, [](const std::string& key, void* value) {
+        posting_t::destroy_list(value);
+        return true;
+    });
+
+    art_tree_destroy(&t);
+}
+
+void benchmark_suite_topster(benchmark_suite_t& suite) {
+    const size_t num_adds = 100000;
+    std::vector<int64_t> scores(num_adds);
+    for(auto& score: scores) {
+        score = suite.rng() % 1000000;
+    }
+
+    for(size_t capacity: {10, 250}) {
+        suite.run("topster/add/capacity:" + std::to_string(capacity), num_adds, [&]() {
+            Topster topster(capacity);
+            for(uint64_t seq_id = 0; seq_id < num_adds; seq_id++) {
+                int64_t kv_scores[3] = {scores[seq_id], 0, 0};
+                KV kv(0, seq_id, seq_id, 0, kv_scores);
+                topster.add(&kv);
+            }
+            topster.sort();
+            suite.results_total += topster.size;
+        });
+    }
+}
+
+void benchmark_tokenization(benchmark_suite_t& suite) {
+    const auto& words = suite.generate_words(10000);
+    std::vector<std::string> texts;
+    for(size_t i = 0; i < 1000; i++) {
+        std::string text;
+        for(size_t j = 0; j < 20; j++) {
+            text += (j == 0 ? "" : (j % 7 == 0 ? ", " : " ")) + suite.skewed_word(words);
+        }
+        texts.push_back(text);
+    }
+
+    suite.run("tokenizer/tokenize", texts.size(), [&]() {
+        for(const auto& text: texts) {
+            std::vector<std::string> tokens;
+            Tokenizer(text, true, false).tokenize(tokens);
+            suite.results_total += tokens.size();
+        }
+    });
+}
+
+void benchmark_hnsw(benchmark_suite_t& suite) {
+    const size_t num_dim = 64;
+    const size_t num_points = 20000;
+    std::normal_distribution<float> dist(0, 1);
+
+    auto random_vector = [&]() {
+        std::vector<float> values(num_dim), normalized_values(num_dim);
+        for(auto& value: values) {
+            value = dist(suite.rng);
+        }
+        hnsw_index_t::normalize_vector(values, normalized_values);
+        return normalized_values;
+    };
+
+    hnsw_index_t vector_index(num_dim, num_points, cosine);
+    for(size_t i = 0; i < num_points; i++) {
+        vector_index.add_point(random_vector().data(), i);
+    }
+
+    std::vector<std::vector<float>> queries;
+    for(size_t i = 0; i < 200; i++) {
+        queries.push_back(random_vector());
+    }
+
+    for(size_t ef: {10, 100}) {
+        suite.run("hnsw/search_knn/ef:" + std::to_string(ef), queries.size(), [&]() {
+            for(const auto& query: queries) {
+                suite.results_total += vector_index.search_knn(query.data(), 10, ef, nullptr).size();
+            }
+        });
+    }
+}
+
+void benchmark_collection(benchmark_suite_t& suite, size_t num_docs) {
+    system("rm -rf /tmp/typesense-benchmark && mkdir -p /tmp/typesense-benchmark");
+
+    Store *store = new Store("/tmp/typesense-benchmark");
+    CollectionManager & collectionManager = CollectionManager::get_instance();
+    std::atomic<bool> quit = false;
+    collectionManager.init(store, 1, "abcd", quit);
+    collectionManager.load(100, 100);
+
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("tags", field_types::STRING_ARRAY, true),
+                                 field("brand", field_types::STRING, true),
+                                 field("points", field_types::INT32, true),
+                                 field("price", field_types::FLOAT, true)};
+
+    Collection* collection = collectionManager.create_collection("benchmark", 4, fields, "points").get();
+
+    const auto& words = suite.generate_words(20000);
+    const auto& tags = suite.generate_words(200);
+    const auto& brands = suite.generate_words(50);
+
+    std::vector<std::string> docs;
+    for(size_t i = 0; i < num_docs; i++) {
+        nlohmann::json doc;
+        std::string title;
+        for(size_t j = 0; j < 8; j++) {
+            title += (j == 0 ? "" : " ") + suite.skewed_word(words);
+        }
+
+        doc["id"] = std::to_string(i);
+        doc["title"] = title;
+        doc["tags"] = {suite.skewed_word(tags), suite.skewed_word(tags)};
+        doc["brand"] = suite.skewed_word(brands);
+        doc["points"] = int32_t(suite.rng() % 1000);
+        doc["price"] = float(suite.rng() % 100000) / 100;
+        docs.push_back(doc.dump());
+    }
+
+    nlohmann::json document;
+    auto begin = std::chrono::high_resolution_clock::now();
+    collection->add_many(docs, document, index_operation_t::CREATE);
+    long long int index_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - begin).count();
+    std::cout << "Indexed " << num_docs << " documents in " << index_micros / 1000 << "ms" << std::endl;
+
+    std::vector<std::string> queries;
+    for(size_t i = 0; i < 100; i++) {
+        queries.push_back(suite.skewed_word(words) + " " + suite.skewed_word(words));
+    }
+
+    const std::string doc_id_prefix = std::to_string(collection->get_collection_id()) + "_" +
+                                      Collection::DOC_ID_PREFIX + "_";
+
+    for(const std::string& filter_query: {std::string("points:>500"),
+                                          "points:>500 && brand:=" + brands[0],
+                                          "tags:=[" + tags[0] + "," + tags[1] + "] || price:<100"}) {
+        filter_node_t* filter_tree_root = nullptr;
+        auto filter_op = filter::parse_filter_query(filter_query, collection->get_schema(), store, doc_id_prefix,
+                                                    filter_tree_root);
+        if(!filter_op.ok()) {
+            std::cout << "Could not parse filter " << filter_query << ": " << filter_op.error() << std::endl;
+            continue;
+        }
+
+        suite.run("filter_iterator/" + filter_query, 1, [&]() {
+            filter_result_iterator_t iter(collection->get_name(), collection->_get_index(), filter_tree_root);
+            while(iter.validity == filter_result_iterator_t::valid) {
+                suite.results_total++;
+                iter.next();
+            }
+        });
+
+        delete filter_tree_root;
+    }
+
+    const std::vector<sort_by> sort_fields = {sort_by("points", "DESC")};
+
+    suite.run("collection/search/text", queries.size(), [&]() {
+        for(const auto& query: queries) {
+            auto results_op = collection->search(query, {"title"}, "", {}, sort_fields, {2}, 10, 1, FREQUENCY,
+                                                 {true});
+            suite.results_total += results_op.ok() ? results_op.get()["found"].get<size_t>() : 0;
+        }
+    });
+
+    suite.run("collection/search/text_filter", queries.size(), [&]() {
+        for(const auto& query: queries) {
+            auto results_op = collection->search(query, {"title"}, "points:>500", {}, sort_fields, {2}, 10, 1,
+                                                 FREQUENCY, {true});
+            suite.results_total += results_op.ok() ? results_op.get()["found"].get<size_t>() : 0;
+        }
+    });
+
+    // do_facets over a part of the collection and over all of it
+    suite.run("collection/search/text_facets", queries.size(), [&]() {
+        for(const auto& query: queries) {
+            auto results_op = collection->search(query, {"title"}, "", {"tags", "brand"}, sort_fields, {2}, 10, 1,
+                                                 FREQUENCY, {true});
+            suite.results_total += results_op.ok() ? results_op.get()["found"].get<size_t>() : 0;
+        }
+    });
+
+    suite.run("collection/search/wildcard_facets", 10, [&]() {
+        for(size_t i = 0; i < 10; i++) {
+            auto results_op = collection->search("*", {}, "", {"tags", "brand", "points"}, sort_fields, {0}, 10,
+                                                 1, FREQUENCY, {false});
+            suite.results_total += results_op.ok() ? results_op.get()["found"].get<size_t>() : 0;
+        }
+    });
+
+    collectionManager.dispose();
+    delete store;
+}
+
+// Memory held by each of many collections with a few documents, as in a deployment with a collection per tenant.
+// Only what this thread allocates is counted: all of the creation of a collection, including the memtable of the
+// store, but not the part of indexing that runs on the indexing pool.
+void benchmark_tiny_collections(benchmark_suite_t& suite, size_t num_collections) {
+    if(!suite.selects("collections/tiny")) {
+        return ;
+    }
+
+    system("rm -rf /tmp/typesense-benchmark-tenants && mkdir -p /tmp/typesense-benchmark-tenants");
+
+    Store *store = new Store("/tmp/typesense-benchmark-tenants");
+    CollectionManager & collectionManager = CollectionManager::get_instance();
+    std::atomic<bool> quit = false;
+    collectionManager.init(store, 1, "abcd", quit);
+    collectionManager.load(100, 100);
+
+    const size_t num_docs = 10;
+    const size_t num_dim = 384;
+    const auto& words = suite.generate_words(1000);
+    std::normal_distribution<float> dist(0, 1);
+
+    nlohmann::json fields = R"([
+        {"name": "title", "type": "string"},
+        {"name": "tags", "type": "string[]", "facet": true},
+        {"name": "points", "type": "int32"}
+    ])"_json;
+
+    nlohmann::json vector_fields = fields;
+    vector_fields.push_back({{"name", "embedding"}, {"type", "float[]"}, {"num_dim", num_dim}});
+
+    // graphs are larger than the rest, so fewer of those collections are created
+    for(const auto& name_fields: std::vector<std::pair<std::string, nlohmann::json>>{{"text", fields},
+                                                                                     {"vector", vector_fields}}) {
+        const bool has_vectors = (name_fields.first == "vector");
+        const size_t num_tenants = has_vectors ? std::min<size_t>(num_collections, 1000) : num_collections;
+        std::vector<Collection*> collections;
+
+        int64_t begin_bytes = memory_accounting_scope_t::thread_net_allocated();
+
+        for(size_t i = 0; i < num_tenants; i++) {
+            nlohmann::json schema;
+            schema["name"] = name_fields.first + "_tenant_" + std::to_string(i);
+            schema["fields"] = name_fields.second;
+
+            auto create_op = CollectionManager::create_collection(schema);
+            if(!create_op.ok()) {
+                std::cout << "Could not create collection: " << create_op.error() << std::endl;
+                break;
+            }
+
+            collections.push_back(create_op.get());
+        }
+
+        const int64_t empty_bytes = memory_accounting_scope_t::thread_net_allocated() - begin_bytes;
+        begin_bytes = memory_accounting_scope_t::thread_net_allocated();
+
+        for(Collection* collection: collections) {
+            for(size_t i = 0; i < num_docs; i++) {
+                nlohmann::json doc;
+                doc["title"] = suite.skewed_word(words) + " " + suite.skewed_word(words);
+                doc["tags"] = {suite.skewed_word(words)};
+                doc["points"] = int32_t(suite.rng() % 1000);
+
+                if(has_vectors) {
+                    std::vector<float> values(num_dim);
+                    for(auto& value: values) {
+                        value = dist(suite.rng);
+                    }
+                    doc["embedding"] = values;
+                }
+
+                collection->add(doc.dump());
+            }
+        }
+
+        const int64_t docs_bytes = memory_accounting_scope_t::thread_net_allocated() - begin_bytes;
+        const double count = std::max<size_t>(collections.size(), 1);
+
+        suite.report("collections/tiny/" + name_fields.first + "/empty", "bytes_per_collection",
+                     empty_bytes / count);
+        suite.report("collections/tiny/" + name_fields.first + "/docs:" + std::to_string(num_docs),
+                     "bytes_per_collection", (empty_bytes + docs_bytes) / count);
+    }
+
+    collectionManager.dispose();
+    delete store;
+}
+
+// usage: benchmark suite [--seed=N] [--filter=name_part] [--docs=N] [--collections=N] [--json=out_path]
+int run_benchmark_suite(int argc, char* argv[]) {
+    uint64_t seed = 42;
+    size_t num_docs = 100000;
+    size_t num_collections = 100000;
+    std::string name_filter, json_path;
+
+    for(int i = 2; i < argc; i++) {
+        const std::string arg = argv[i];
+        const std::string value = arg.find('=') == std::string::npos ? "" : arg.substr(arg.find('=') + 1);
+
+        if(arg.rfind("--seed=", 0) == 0) {
+            seed = std::stoull(value);
+        } else if(arg.rfind("--filter=", 0) == 0) {
+            name_filter = value;
+        } else if(arg.rfind("--docs=", 0) == 0) {
+            num_docs = std::stoull(value);
+        } else if(arg.rfind("--collections=", 0) == 0) {
+            num_collections = std::stoull(value);
+        } else if(arg.rfind("--json=", 0) == 0) {
+            json_path = value;
+        } else {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    benchmark_suite_t suite(seed, name_filter);
+
+    benchmark_posting_lists(suite);
+    benchmark_array_ops(suite);
+    benchmark_art_fuzzy_search(suite);
+    benchmark_cvt(suite);
+    benchmark_suite_topster(suite);
+    benchmark_tokenization(suite);
+    benchmark_hnsw(suite);
+    benchmark_collection(suite, num_docs);
+    benchmark_tiny_collections(suite, num_collections);
+
+    std::cout << "Results total: " << suite.results_total << std::endl;
+
+    if(!json_path.empty()) {
+        nlohmann::json json = suite.to_json();
+        json["context"]["num_docs"] = num_docs;
+        json["context"]["num_collections"] = num_collections;
+        std::ofstream outfile(json_path);
+        outfile << json.dump(2) << std::endl;
+    }
+
+    return 0;
+}
+
 void generate_word_freq() {
     std::ifstream infile("/tmp/unigram_freq.jsonl");
     std::ofstream outfile("/tmp/eng_words.jsonl", std::ios_base::app);
@@ -190,7 +1085,26 @@ void generate_word_freq() {
 }
 
 int main(int argc, char* argv[]) {
+    if(argc > 1 && std::string(argv[1]) == "suite") {
+        return run_benchmark_suite(argc, argv);
+    }
+
     srand(time(NULL));
+
+    if(argc > 1 && std::string(argv[1]) == "intersection") {
+        benchmark_intersection();
+        return 0;
+    }
+
+    if(argc > 1 && std::string(argv[1]) == "topster") {
+        benchmark_topster();
+        return 0;
+    }
+
+    if(argc > 2 && std::string(argv[1]) == "embedding") {
+        benchmark_embedding(argv[2], argc > 3 ? argv[3] : "/tmp/typesense-models");
+        return 0;
+    }
 //    system("rm -rf /tmp/typesense-data && mkdir -p /tmp/typesense-data");
 
 //    benchmark_hn_titles(argv[1]);
@@ -0,0 +1,174 @@
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <curl/curl.h>
+#include "cmdline.h"
+#include "http_client.h"
+#include "query_replay.h"
+
+// Replays search logs, or a JSONL of requests, against a node.
+//
+// In the closed loop mode, each of `concurrency` clients sends its next request as soon as the previous one returns,
+// so the rate adapts to how fast the node is. In the open loop mode, requests are sent at `rate` per second whatever
+// the latency is, and the latency of a request is measured from the time it was due, so that the time spent waiting
+// on a busy client counts towards it like it would for real traffic.
+
+int main(int argc, char* argv[]) {
+    cmdline::parser options;
+    options.set_program_name("./replay");
+    options.add<std::string>("url", '\0', "Base URL of the node, e.g. http://localhost:8108", true);
+    options.add<std::string>("api-key", 'a', "API key sent with every request.", true);
+    options.add<std::string>("file", 'f', "Search log or JSONL of requests to replay.", true);
+    options.add<std::string>("mode", '\0', "`closed` or `open` loop.", false, "closed",
+                             cmdline::oneof<std::string>("closed", "open"));
+    options.add<uint32_t>("concurrency", 'c', "Number of concurrent clients.", false, 8);
+    options.add<double>("rate", 'r', "Requests per second in the open loop mode.", false, 100);
+    options.add<uint32_t>("duration", 'd', "Seconds to replay for, looping over the requests. Once when 0.", false, 0);
+    options.add<uint32_t>("timeout-ms", '\0', "Timeout of a request.", false, 10000);
+    options.add<uint32_t>("report-interval", '\0', "Seconds between progress reports.", false, 10);
+    options.add<std::string>("json", '\0', "Path to write the final report to as JSON.", false, "");
+    options.parse_check(argc, argv);
+
+    const std::string base_url = options.get<std::string>("url");
+    const bool open_loop = options.get<std::string>("mode") == "open";
+    const size_t concurrency = std::max<uint32_t>(1, options.get<uint32_t>("concurrency"));
+    const double rate = options.get<double>("rate");
+    const uint32_t duration_s = options.get<uint32_t>("duration");
+    const long timeout_ms = options.get<uint32_t>("timeout-ms");
+
+    if(open_loop && rate <= 0) {
+        std::cerr << "Rate must be greater than 0 in the open loop mode." << std::endl;
+        return 1;
+    }
+
+    std::vector<replay_request_t> requests;
+    size_t num_skipped_lines = 0;
+
+    std::ifstream infile(options.get<std::string>("file"));
+    if(!infile.is_open()) {
+        std::cerr << "Could not open " << options.get<std::string>("file") << std::endl;
+        return 1;
+    }
+
+    std::string line;
+    while(std::getline(infile, line)) {
+        auto request_op = query_replay_t::parse_line(line);
+        if(request_op.ok()) {
+            requests.push_back(request_op.get());
+        } else {
+            num_skipped_lines++;
+        }
+    }
+    infile.close();
+
+    if(requests.empty()) {
+        std::cerr << "No requests found." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Replaying " << requests.size() << " requests (skipped " << num_skipped_lines << " lines) in the "
+              << (open_loop ? "open" : "closed") << " loop mode with " << concurrency << " clients." << std::endl;
+
+    curl_global_init(CURL_GLOBAL_SSL);
+
+    const std::unordered_map<std::string, std::string> headers = {
+        {"X-TYPESENSE-API-KEY", options.get<std::string>("api-key")},
+        {"Content-Type", "application/json"}
+    };
+
+    replay_stats_t stats;
+    std::atomic<size_t> next_request = 0;
+    std::atomic<bool> done = false;
+
+    const auto begin = std::chrono::steady_clock::now();
+    const auto end = begin + std::chrono::seconds(duration_s);
+
+    auto client = [&]() {
+        while(!done) {
+            const size_t request_index = next_request++;
+            if(duration_s == 0 && request_index >= requests.size()) {
+                break;
+            }
+
+            auto due = std::chrono::steady_clock::now();
+
+            if(open_loop) {
+                due = begin + std::chrono::microseconds(uint64_t(request_index * 1000 * 1000 / rate));
+                std::this_thread::sleep_until(due);
+            }
+
+            if(duration_s != 0 && std::chrono::steady_clock::now() >= end) {
+                break;
+            }
+
+            const auto& request = requests[request_index % requests.size()];
+            const std::string url = base_url + request.path;
+
+            std::string response;
+            std::map<std::string, std::string> res_headers;
+            long status_code;
+
+            if(request.method == "POST") {
+                status_code = HttpClient::post_response(url, request.body, response, res_headers, headers,
+                                                        timeout_ms);
+            } else {
+                status_code = HttpClient::get_response(url, response, res_headers, headers, timeout_ms);
+            }
+
+            const uint64_t latency_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - due).count();
+            stats.add(status_code, latency_us);
+        }
+    };
+
+    std::vector<std::thread> clients;
+    for(size_t i = 0; i < concurrency; i++) {
+        clients.emplace_back(client);
+    }
+
+    // progress reports
+    std::thread reporter([&]() {
+        const auto report_interval = std::chrono::seconds(
+                std::max<uint32_t>(1, options.get<uint32_t>("report-interval")));
+        auto next_report = std::chrono::steady_clock::now() + report_interval;
+
+        while(!done) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if(std::chrono::steady_clock::now() >= next_report && !done) {
+                const double elapsed_s = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - begin).count();
+                std::cout << stats.to_json(elapsed_s).dump() << std::endl;
+                next_report += report_interval;
+            }
+        }
+    });
+
+    for(auto& client_thread: clients) {
+        client_thread.join();
+    }
+
+    done = true;
+    reporter.join();
+
+    const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    nlohmann::json report = stats.to_json(elapsed_s);
+    report["mode"] = open_loop ? "open" : "closed";
+    report["concurrency"] = concurrency;
+    if(open_loop) {
+        report["target_qps"] = rate;
+    }
+
+    std::cout << report.dump(2) << std::endl;
+
+    const std::string& json_path = options.get<std::string>("json");
+    if(!json_path.empty()) {
+        std::ofstream outfile(json_path);
+        outfile << report.dump(2) << std::endl;
+    }
+
+    curl_global_cleanup();
+    return 0;
+}
@@ -1,7 +1,12 @@
 #include "typesense_server_utils.h"
 #include "core_api.h"
 #include "tsconfig.h"
+#include "typo_candidate_cache.h"
+#include "embedding_cache.h"
+#include "stemmer_manager.h"
+#include "trigram_index.h"
 #include "stackprinter.h"
+#include "cpu_profiler.h"
 #include "backward.hpp"
 #include "butil/at_exit.h"
 
@@ -20,7 +25,7 @@ extern "C" {
 void master_server_routes() {
     // collection operations
     // NOTE: placing this first to score an immediate hit on O(N) route search
-    server->get("/collections/:collection/documents/search", get_search);
+    server->get("/collections/:collection/documents/search", get_search, false, true);
     server->post("/multi_search", post_multi_search);
 
     // document management
@@ -30,6 +35,7 @@ void master_server_routes() {
 
     server->post("/collections/:collection/documents/import", post_import_documents, true, true);
     server->get("/collections/:collection/documents/export", get_export_documents, false, true);
+    server->post("/collections/:collection/documents/numeric_updates", post_numeric_updates);
 
     server->get("/collections/:collection/documents/:id", get_fetch_document);
     server->patch("/collections/:collection/documents/:id", patch_update_document);
@@ -83,18 +89,28 @@ void master_server_routes() {
 
     // meta
     server->get("/metrics.json", get_metrics_json);
+    server->get("/metrics", get_metrics_prometheus);
     server->get("/stats.json", get_stats_json);
+    server->get("/stats/searches", get_search_fingerprint_stats);
     server->get("/debug", get_debug);
+    server->get("/debug/pprof/profile", get_debug_cpu_profile);
     server->get("/health", get_health);
     server->get("/health_with_rusage", get_health_with_resource_usage);
     server->post("/health", post_health);
     server->get("/status", get_status);
 
+    server->get("/replication/log", get_replication_log);
+    server->get("/replication/snapshot", get_replication_snapshot);
+    server->get("/replication/snapshot/file", get_replication_snapshot_file);
+    server->get("/replication/changes", get_replication_changes);
+
     server->post("/operations/snapshot", post_snapshot, false, true);
     server->post("/operations/vote", post_vote, false, false);
     server->post("/operations/cache/clear", post_clear_cache, false, false);
     server->post("/operations/db/compact", post_compact_db, false, false);
     server->post("/operations/reset_peers", post_reset_peers, false, false);
+    server->get("/operations/housekeeping/tasks", get_housekeeping_tasks);
+    server->post("/operations/housekeeping/tasks/:name/cancel", post_cancel_housekeeping_task, false, false);
     
     server->post("/conversations/models", post_conversation_model);
     server->get("/conversations/models", get_conversation_models);
@@ -109,6 +125,7 @@ void master_server_routes() {
     server->get("/limits", get_rate_limits);
     server->get("/limits/active", get_active_throttles);
     server->get("/limits/exceeds", get_limit_exceed_counts);
+    server->get("/limits/usage", get_limit_usage);
     server->get("/limits/:id", get_rate_limit);
     server->post("/limits", post_rate_limit);
     server->put("/limits/:id", put_rate_limit);
@@ -191,13 +208,25 @@ int main(int argc, char **argv) {
 #elif __linux__
     backward::SignalHandling sh;
     sh._callback = crash_callback;
+
+    // resolves the functions of the CPU profiles from the debug info of the binary
+    CpuProfiler::get_instance().set_symbolizer([](void* addr) {
+        static backward::TraceResolver resolver;
+        backward::ResolvedTrace trace = resolver.resolve(backward::ResolvedTrace(backward::Trace(addr, 0)));
+        return trace.object_function;
+    });
 #endif
 
     // we can install new signal handlers only after overriding above
     signal(SIGINT, catch_interrupt);
     signal(SIGTERM, catch_interrupt);
 
-    init_api(config.get_cache_num_entries());
+    init_api(config.get_cache_num_entries(), config.get_cache_max_memory_mb() * 1024 * 1024,
+             config.get_cache_compress_min_bytes());
+    typo_candidate_cache_t::set_max_entries(config.get_typo_cache_num_entries());
+    embedding_cache_t::set_max_entries(config.get_embedding_cache_num_entries());
+    Stemmer::set_max_entries(config.get_stem_cache_num_entries());
+    trigram_index_t::set_enabled(config.get_enable_infix_trigram_index());
 
     return run_server(config, TYPESENSE_VERSION, &master_server_routes);
 }
\ No newline at end of file
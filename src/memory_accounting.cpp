@@ -0,0 +1,115 @@
+#include "memory_accounting.h"
+#include <algorithm>
+
+#ifndef ASAN_BUILD
+#include "jemalloc.h"
+
+#ifdef __APPLE__
+#define impl_mallctl je_mallctl
+#else
+#define impl_mallctl mallctl
+#endif
+#endif
+
+thread_local memory_accounting_scope_t* memory_accounting_scope_t::current = nullptr;
+
+const char* index_memory_stats_t::get_name(memory_structure_t structure) {
+    switch(structure) {
+        case MEMORY_TEXT:
+            return "text";
+        case MEMORY_FACET:
+            return "facet";
+        case MEMORY_NUMERIC:
+            return "numeric";
+        case MEMORY_SORT:
+            return "sort";
+        case MEMORY_STRING_SORT:
+            return "string_sort";
+        case MEMORY_INFIX:
+            return "infix";
+        case MEMORY_GEO:
+            return "geo";
+        case MEMORY_VECTOR:
+            return "vector";
+        case MEMORY_REFERENCE:
+            return "reference";
+        case MEMORY_IDS:
+            return "ids";
+        default:
+            return "unknown";
+    }
+}
+
+int64_t index_memory_stats_t::get(memory_structure_t structure) const {
+    // deltas of frees that race with allocations on other threads can briefly take a structure below zero
+    return std::max<int64_t>(0, bytes[structure].load(std::memory_order_relaxed));
+}
+
+int64_t index_memory_stats_t::total() const {
+    int64_t total_bytes = 0;
+    for(size_t i = 0; i < NUM_MEMORY_STRUCTURES; i++) {
+        total_bytes += get(memory_structure_t(i));
+    }
+
+    return total_bytes;
+}
+
+void index_memory_stats_t::clear() {
+    for(auto& structure_bytes: bytes) {
+        structure_bytes = 0;
+    }
+}
+
+nlohmann::json index_memory_stats_t::to_json() const {
+    nlohmann::json json;
+    for(size_t i = 0; i < NUM_MEMORY_STRUCTURES; i++) {
+        json[get_name(memory_structure_t(i))] = get(memory_structure_t(i));
+    }
+
+    json["total"] = total();
+    return json;
+}
+
+int64_t memory_accounting_scope_t::thread_net_allocated() {
+#ifndef ASAN_BUILD
+    // jemalloc hands out pointers to the counters of the calling thread, so they are looked up only once per thread
+    thread_local uint64_t* allocated_p = nullptr;
+    thread_local uint64_t* deallocated_p = nullptr;
+    thread_local bool looked_up = false;
+
+    if(!looked_up) {
+        looked_up = true;
+        size_t sz = sizeof(uint64_t*);
+        if(impl_mallctl("thread.allocatedp", &allocated_p, &sz, nullptr, 0) != 0 ||
+           impl_mallctl("thread.deallocatedp", &deallocated_p, &sz, nullptr, 0) != 0) {
+            allocated_p = nullptr;
+            deallocated_p = nullptr;
+        }
+    }
+
+    if(allocated_p == nullptr || deallocated_p == nullptr) {
+        return 0;
+    }
+
+    return int64_t(*allocated_p) - int64_t(*deallocated_p);
+#else
+    return 0;
+#endif
+}
+
+memory_accounting_scope_t::memory_accounting_scope_t(index_memory_stats_t& stats, memory_structure_t structure):
+        stats(stats), structure(structure), begin_bytes(thread_net_allocated()), parent(current) {
+    current = this;
+}
+
+memory_accounting_scope_t::~memory_accounting_scope_t() {
+    const int64_t delta = thread_net_allocated() - begin_bytes;
+    stats.add(structure, delta);
+
+    if(parent != nullptr) {
+        // the parent must not account this memory again
+        parent->begin_bytes += delta;
+    }
+
+    current = parent;
+}
@@ -0,0 +1,138 @@
+#include "memory_arenas.h"
+#include <string>
+#include <sys/types.h>
+#include "logger.h"
+
+#ifndef ASAN_BUILD
+#include "jemalloc.h"
+
+#ifdef __APPLE__
+#define impl_mallctl je_mallctl
+#else
+#define impl_mallctl mallctl
+#endif
+#endif
+
+const char* MemoryArenas::get_name(subsystem_t subsystem) {
+    switch(subsystem) {
+        case INDEXING:
+            return "indexing";
+        case SEARCH:
+            return "search";
+        default:
+            return "unknown";
+    }
+}
+
+bool MemoryArenas::init(bool create_arenas, int64_t dirty_decay_ms, int64_t muzzy_decay_ms) {
+#ifndef ASAN_BUILD
+    ssize_t dirty_decay = dirty_decay_ms;
+    ssize_t muzzy_decay = muzzy_decay_ms;
+
+    // defaults of the arenas that are created from now on
+    if(impl_mallctl("arenas.dirty_decay_ms", nullptr, nullptr, &dirty_decay, sizeof(ssize_t)) != 0 ||
+       impl_mallctl("arenas.muzzy_decay_ms", nullptr, nullptr, &muzzy_decay, sizeof(ssize_t)) != 0) {
+        LOG(ERROR) << "Could not set the decay times of the allocator.";
+        return false;
+    }
+
+    // arenas that already exist
+    unsigned narenas = 0;
+    size_t sz = sizeof(unsigned);
+    impl_mallctl("arenas.narenas", &narenas, &sz, nullptr, 0);
+
+    for(unsigned i = 0; i < narenas; i++) {
+        const std::string arena_prefix = "arena." + std::to_string(i) + ".";
+        impl_mallctl((arena_prefix + "dirty_decay_ms").c_str(), nullptr, nullptr, &dirty_decay, sizeof(ssize_t));
+        impl_mallctl((arena_prefix + "muzzy_decay_ms").c_str(), nullptr, nullptr, &muzzy_decay, sizeof(ssize_t));
+    }
+
+    if(!create_arenas) {
+        return true;
+    }
+
+    for(size_t i = 0; i < NUM_SUBSYSTEMS; i++) {
+        unsigned arena_id = 0;
+        sz = sizeof(unsigned);
+        if(impl_mallctl("arenas.create", &arena_id, &sz, nullptr, 0) != 0) {
+            LOG(ERROR) << "Could not create an arena for " << get_name(subsystem_t(i)) << ".";
+            return false;
+        }
+
+        arena_ids[i] = arena_id;
+    }
+
+    enabled = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void MemoryArenas::bind_thread(subsystem_t subsystem) const {
+    if(!enabled) {
+        return ;
+    }
+
+#ifndef ASAN_BUILD
+    unsigned arena_id = arena_ids[subsystem];
+    impl_mallctl("thread.arena", nullptr, nullptr, &arena_id, sizeof(unsigned));
+#endif
+}
+
+void MemoryArenas::request_purge() {
+    purge_requested = true;
+}
+
+bool MemoryArenas::purge_if_requested() {
+    if(!purge_requested.exchange(false)) {
+        return false;
+    }
+
+    purge();
+    return true;
+}
+
+void MemoryArenas::purge() {
+#ifndef ASAN_BUILD
+    const std::string purge_key = "arena." + std::to_string(MALLCTL_ARENAS_ALL) + ".purge";
+    impl_mallctl(purge_key.c_str(), nullptr, nullptr, nullptr, 0);
+#endif
+}
+
+void MemoryArenas::get_metrics(nlohmann::json& result) const {
+    size_t dirty_bytes = 0, muzzy_bytes = 0;
+
+#ifndef ASAN_BUILD
+    uint64_t epoch = 1;
+    size_t sz = sizeof(uint64_t);
+    impl_mallctl("epoch", &epoch, &sz, &epoch, sz);
+
+    size_t page_size = 0;
+    sz = sizeof(size_t);
+    impl_mallctl("arenas.page", &page_size, &sz, nullptr, 0);
+
+    auto get_pages = [&sz](const std::string& arena, const char* stat) {
+        size_t num_pages = 0;
+        sz = sizeof(size_t);
+        impl_mallctl(("stats.arenas." + arena + "." + stat).c_str(), &num_pages, &sz, nullptr, 0);
+        return num_pages;
+    };
+
+    const std::string all_arenas = std::to_string(MALLCTL_ARENAS_ALL);
+    dirty_bytes = get_pages(all_arenas, "pdirty") * page_size;
+    muzzy_bytes = get_pages(all_arenas, "pmuzzy") * page_size;
+
+    if(enabled) {
+        for(size_t i = 0; i < NUM_SUBSYSTEMS; i++) {
+            const std::string arena = std::to_string(arena_ids[i]);
+            const std::string metric_prefix = std::string("typesense_memory_") + get_name(subsystem_t(i)) + "_arena_";
+            result[metric_prefix + "active_bytes"] = std::to_string(get_pages(arena, "pactive") * page_size);
+            result[metric_prefix + "dirty_bytes"] = std::to_string(get_pages(arena, "pdirty") * page_size);
+        }
+    }
+#endif
+
+    result["typesense_memory_dirty_bytes"] = std::to_string(dirty_bytes);
+    result["typesense_memory_muzzy_bytes"] = std::to_string(muzzy_bytes);
+}
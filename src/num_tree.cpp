@@ -3,15 +3,64 @@
 #include "timsort.hpp"
 
 void num_tree_t::insert(int64_t value, uint32_t id, bool is_facet) {
-    if (int64map.count(value) == 0) {
+    auto it = int64map.find(value);
+    if (it == int64map.end()) {
         int64map.emplace(value, SET_COMPACT_IDS(compact_id_list_t::create(1, {id})));
-    } else {
-        auto ids = int64map[value];
-        if (!ids_t::contains(ids, id)) {
-            ids_t::upsert(ids, id);
-            int64map[value] = ids;
+    } else if (!ids_t::contains(it->second, id)) {
+        ids_t::upsert(it->second, id);
+    }
+}
+
+void num_tree_t::insert_many(std::vector<std::pair<int64_t, uint32_t>>& values_ids) {
+    std::sort(values_ids.begin(), values_ids.end());
+    values_ids.erase(std::unique(values_ids.begin(), values_ids.end()), values_ids.end());
+
+    std::vector<std::pair<int64_t, void*>> new_values;
+    std::vector<uint32_t> ids;
+
+    for (size_t i = 0; i < values_ids.size();) {
+        const int64_t value = values_ids[i].first;
+        size_t value_end = i;
+        while (value_end < values_ids.size() && values_ids[value_end].first == value) {
+            value_end++;
         }
+
+        auto it = int64map.find(value);
+        if (it == int64map.end()) {
+            ids.clear();
+            for (size_t j = i; j < value_end; j++) {
+                ids.push_back(values_ids[j].second);
+            }
+
+            new_values.emplace_back(value, ids_t::create(ids));
+        } else {
+            for (size_t j = i; j < value_end; j++) {
+                if (!ids_t::contains(it->second, values_ids[j].second)) {
+                    ids_t::upsert(it->second, values_ids[j].second);
+                }
+            }
+        }
+
+        i = value_end;
     }
+
+    if (new_values.size() * 4 < int64map.size()) {
+        for (auto& value_ids: new_values) {
+            int64map.emplace(value_ids.first, value_ids.second);
+        }
+
+        return ;
+    }
+
+    // merging into the existing values and loading the tree from scratch is cheaper than inserting one by one
+    std::vector<std::pair<int64_t, void*>> all_values;
+    all_values.reserve(int64map.size() + new_values.size());
+    std::merge(int64map.begin(), int64map.end(), new_values.begin(), new_values.end(), std::back_inserter(all_values),
+               [](const std::pair<int64_t, void*>& a, const std::pair<int64_t, void*>& b) {
+                   return a.first < b.first;
+               });
+
+    int64map.bulk_load(std::move(all_values));
 }
 
 void num_tree_t::range_inclusive_search(int64_t start, int64_t end, uint32_t** ids, size_t& ids_len) {
@@ -239,15 +288,13 @@ uint32_t num_tree_t::approx_search_count(NUM_COMPARATOR comparator, int64_t valu
 }
 
 void num_tree_t::remove(uint64_t value, uint32_t id) {
-    if(int64map.count(value) != 0) {
-        void* arr = int64map[value];
-        ids_t::erase(arr, id);
+    auto it = int64map.find(value);
+    if(it != int64map.end()) {
+        ids_t::erase(it->second, id);
 
-        if(ids_t::num_ids(arr) == 0) {
-            ids_t::destroy_list(arr);
+        if(ids_t::num_ids(it->second) == 0) {
+            ids_t::destroy_list(it->second);
             int64map.erase(value);
-        } else {
-            int64map[value] = arr;
         }
     }
 }
@@ -344,6 +391,72 @@ void num_tree_t::seq_ids_outside_top_k(size_t k, std::vector<uint32_t> &seq_ids)
     }
 }
 
+void num_tree_t::visit_values_in_order(bool descending,
+                                       const std::function<bool(int64_t, const std::vector<uint32_t>&)>& visit_value) {
+    std::vector<uint32_t> ids;
+
+    auto visit = [&](std::pair<int64_t, void*>& value_ids) {
+        ids.clear();
+        ids_t::uncompress(value_ids.second, ids);
+        return visit_value(value_ids.first, ids);
+    };
+
+    if(descending) {
+        for(auto iter = int64map.rbegin(); iter != int64map.rend(); ++iter) {
+            if(!visit(*iter)) {
+                return ;
+            }
+        }
+    } else {
+        for(auto iter = int64map.begin(); iter != int64map.end(); ++iter) {
+            if(!visit(*iter)) {
+                return ;
+            }
+        }
+    }
+}
+
+void num_tree_t::visit_ids_of_values(const uint32_t* values, size_t values_len,
+                                     const std::function<void(size_t, const std::vector<uint32_t>&)>& visit_ids) {
+    if(values_len == 0 || int64map.empty()) {
+        return ;
+    }
+
+    std::vector<uint32_t> ids;
+
+    // a lookup costs about log2 of the number of values in the tree, while the ordered pass visits every one of them
+    const size_t lookup_cost = values_len * (64 - __builtin_clzll(int64map.size()));
+
+    if(lookup_cost < int64map.size()) {
+        for(size_t i = 0; i < values_len; i++) {
+            const auto& it = int64map.find(values[i]);
+            if(it == int64map.end()) {
+                continue;
+            }
+
+            ids.clear();
+            ids_t::uncompress(it->second, ids);
+            visit_ids(i, ids);
+        }
+
+        return ;
+    }
+
+    size_t i = 0;
+    for(auto it = int64map.lower_bound(values[0]); it != int64map.end() && i < values_len; ++it) {
+        while(i < values_len && values[i] < it->first) {
+            i++;
+        }
+
+        if(i < values_len && values[i] == it->first) {
+            ids.clear();
+            ids_t::uncompress(it->second, ids);
+            visit_ids(i, ids);
+            i++;
+        }
+    }
+}
+
 std::pair<int64_t, int64_t> num_tree_t::get_min_max(const uint32_t* result_ids, size_t result_ids_len) {
     int64_t min, max;
     //first traverse from top to find min
@@ -365,6 +478,16 @@ std::pair<int64_t, int64_t> num_tree_t::get_min_max(const uint32_t* result_ids,
     return std::make_pair(min, max);
 }
 
+bool num_tree_t::get_min_max(int64_t& min, int64_t& max) const {
+    if(int64map.empty()) {
+        return false;
+    }
+
+    min = int64map.begin()->first;
+    max = int64map.rbegin()->first;
+    return true;
+}
+
 size_t num_tree_t::size() {
     return int64map.size();
 }
@@ -1,5 +1,8 @@
 #include <timsort.hpp>
 #include <set>
+#include <queue>
+#include <s2/s2cell.h>
+#include <s2/s2cell_id.h>
 #include "numeric_range_trie.h"
 #include "array_utils.h"
 
@@ -55,6 +58,16 @@ void NumericTrie::delete_geopoint(const uint64_t& cell_id, uint32_t id) {
     positive_trie->delete_geopoint(cell_id, id, max_level);
 }
 
+void NumericTrie::search_nearest_geopoints(const S2Point& point,
+                                           const std::function<bool(const S1ChordAngle&,
+                                                                    const std::vector<uint32_t>&)>& visit_cell) {
+    if (positive_trie == nullptr) {
+        return;
+    }
+
+    positive_trie->search_nearest_geopoints(point, max_level, visit_cell);
+}
+
 void NumericTrie::search_range(const int64_t& low, const bool& low_inclusive,
                                const int64_t& high, const bool& high_inclusive,
                                uint32_t*& ids, uint32_t& ids_length) {
@@ -614,6 +627,56 @@ void NumericTrie::Node::search_geopoints(const std::vector<uint64_t>& cell_ids,
     geo_result_ids.erase(unique(geo_result_ids.begin(), geo_result_ids.end()), geo_result_ids.end());
 }
 
+void NumericTrie::Node::search_nearest_geopoints(const S2Point& point, const char& max_level,
+                                                 const std::function<bool(const S1ChordAngle&,
+                                                                          const std::vector<uint32_t>&)>& visit_cell) {
+    struct cell_t {
+        S1ChordAngle distance;
+        Node* node;
+        uint64_t prefix;
+        char level;
+    };
+
+    auto is_farther = [](const cell_t& a, const cell_t& b) { return b.distance < a.distance; };
+    std::priority_queue<cell_t, std::vector<cell_t>, decltype(is_farther)> cells(is_farther);
+    cells.push({S1ChordAngle::Zero(), this, 0, 0});
+
+    std::vector<uint32_t> ids;
+
+    while (!cells.empty()) {
+        auto cell = cells.top();
+        cells.pop();
+
+        if (cell.level == max_level || cell.node->children == nullptr) {
+            ids.clear();
+            ids_t::uncompress(cell.node->seq_ids, ids);
+
+            if (!visit_cell(cell.distance, ids)) {
+                return;
+            }
+
+            continue;
+        }
+
+        // A node holds the cell ids sharing its top `8 * level` bits, all of which lie within the S2 cell of the
+        // deepest level that is fully determined by those bits.
+        const char child_level = cell.level + 1;
+        const int shift = 8 * (8 - child_level);
+        const int s2_level = (8 * child_level - S2CellId::kFaceBits) / 2;
+
+        for (auto i = 0; i < EXPANSE; i++) {
+            Node* child = cell.node->children[i];
+            if (child == nullptr) {
+                continue;
+            }
+
+            uint64_t prefix = cell.prefix | (uint64_t(i) << shift);
+            auto s2_cell = S2Cell(S2CellId(prefix | 1).parent(s2_level));
+            cells.push({s2_cell.GetDistance(point), child, prefix, child_level});
+        }
+    }
+}
+
 void NumericTrie::Node::delete_geopoint(const uint64_t& cell_id, uint32_t id, const char& max_level) {
     char level = 1;
     Node* root = this;
@@ -658,20 +721,7 @@ void NumericTrie::Node::search_less_than(const int64_t& value, const char& max_l
     std::vector<NumericTrie::Node*> matches;
     search_less_than_helper(value, level, max_level, matches);
 
-    std::vector<uint32_t> consolidated_ids;
-    for (auto const& match: matches) {
-        ids_t::uncompress(match->seq_ids, consolidated_ids);
-    }
-
-    gfx::timsort(consolidated_ids.begin(), consolidated_ids.end());
-    consolidated_ids.erase(unique(consolidated_ids.begin(), consolidated_ids.end()), consolidated_ids.end());
-
-    uint32_t* out = nullptr;
-    ids_length = ArrayUtils::or_scalar(&consolidated_ids[0], consolidated_ids.size(),
-                                       ids, ids_length, &out);
-
-    delete [] ids;
-    ids = out;
+    merge_ids(matches, ids, ids_length);
 }
 
 void NumericTrie::Node::search_less_than(const int64_t& value, const char& max_level, std::vector<Node*>& matches) {
@@ -711,20 +761,7 @@ void NumericTrie::Node::search_range(const int64_t& low, const int64_t& high, co
     search_range_helper(low, high >= indexable_limit(max_level) ? indexable_limit(max_level) : high,
                         max_level, matches);
 
-    std::vector<uint32_t> consolidated_ids;
-    for (auto const& match: matches) {
-        ids_t::uncompress(match->seq_ids, consolidated_ids);
-    }
-
-    gfx::timsort(consolidated_ids.begin(), consolidated_ids.end());
-    consolidated_ids.erase(unique(consolidated_ids.begin(), consolidated_ids.end()), consolidated_ids.end());
-
-    uint32_t* out = nullptr;
-    ids_length = ArrayUtils::or_scalar(&consolidated_ids[0], consolidated_ids.size(),
-                                       ids, ids_length, &out);
-
-    delete [] ids;
-    ids = out;
+    merge_ids(matches, ids, ids_length);
 }
 
 void NumericTrie::Node::search_range(const int64_t& low, const int64_t& high, const char& max_level,
@@ -796,20 +833,7 @@ void NumericTrie::Node::search_greater_than(const int64_t& value, const char& ma
     std::vector<NumericTrie::Node*> matches;
     search_greater_than_helper(value, level, max_level, matches);
 
-    std::vector<uint32_t> consolidated_ids;
-    for (auto const& match: matches) {
-        ids_t::uncompress(match->seq_ids, consolidated_ids);
-    }
-
-    gfx::timsort(consolidated_ids.begin(), consolidated_ids.end());
-    consolidated_ids.erase(unique(consolidated_ids.begin(), consolidated_ids.end()), consolidated_ids.end());
-
-    uint32_t* out = nullptr;
-    ids_length = ArrayUtils::or_scalar(&consolidated_ids[0], consolidated_ids.size(),
-                                       ids, ids_length, &out);
-
-    delete [] ids;
-    ids = out;
+    merge_ids(matches, ids, ids_length);
 }
 
 void NumericTrie::Node::search_greater_than(const int64_t& value, const char& max_level, std::vector<Node*>& matches) {
@@ -944,82 +968,185 @@ void NumericTrie::Node::get_all_ids(std::vector<uint32_t>& result) {
     ids_t::uncompress(seq_ids, result);
 }
 
-void NumericTrie::iterator_t::reset() {
-    for (auto& match: matches) {
-        match->index = 0;
+void NumericTrie::Node::merge_ids(const std::vector<Node*>& matches, uint32_t*& ids, uint32_t& ids_length) {
+    size_t total_ids = 0;
+    uint32_t min_id = UINT32_MAX, max_id = 0;
+
+    for (auto const& match: matches) {
+        auto const num_ids = ids_t::num_ids(match->seq_ids);
+        if (num_ids == 0) {
+            continue;
+        }
+
+        total_ids += num_ids;
+        min_id = std::min(min_id, ids_t::first_id(match->seq_ids));
+        max_id = std::max(max_id, ids_t::last_id(match->seq_ids));
     }
 
-    is_valid = true;
-    set_seq_id();
-}
+    if (total_ids == 0) {
+        return;
+    }
 
-void NumericTrie::iterator_t::skip_to(uint32_t id) {
-    for (auto& match: matches) {
-        ArrayUtils::skip_index_to_id(match->index, match->ids, match->ids_length, id);
+    uint32_t* merged_ids = nullptr;
+    uint32_t merged_ids_length = 0;
+    const uint64_t span = uint64_t(max_id) - min_id + 1;
+
+    // A bitmap of the span takes no more memory than the ids themselves.
+    if (total_ids * 32 >= span) {
+        std::vector<uint64_t> bitmap((span + 63) / 64, 0);
+
+        for (auto const& match: matches) {
+            if (IS_COMPACT_IDS(match->seq_ids)) {
+                auto const list = COMPACT_IDS_PTR(match->seq_ids);
+                for (size_t i = 0; i < list->length; i++) {
+                    auto const offset = list->ids[i] - min_id;
+                    bitmap[offset / 64] |= (uint64_t(1) << (offset % 64));
+                }
+            } else {
+                auto it = ((id_list_t*) match->seq_ids)->new_iterator();
+                for (; it.valid(); it.next()) {
+                    auto const offset = it.id() - min_id;
+                    bitmap[offset / 64] |= (uint64_t(1) << (offset % 64));
+                }
+            }
+        }
+
+        merged_ids_length = ArrayUtils::bitmap_to_array(bitmap.data(), bitmap.size(), min_id, &merged_ids);
+    } else {
+        merged_ids = new uint32_t[total_ids];
+        for (iterator_t it(matches); it.is_valid; it.next()) {
+            merged_ids[merged_ids_length++] = it.seq_id;
+        }
     }
 
-    set_seq_id();
+    if (ids_length == 0) {
+        delete [] ids;
+        ids = merged_ids;
+        ids_length = merged_ids_length;
+        return;
+    }
+
+    uint32_t* out = nullptr;
+    ids_length = ArrayUtils::or_scalar(merged_ids, merged_ids_length, ids, ids_length, &out);
+
+    delete [] merged_ids;
+    delete [] ids;
+    ids = out;
 }
 
-void NumericTrie::iterator_t::next() {
-    // Advance all the matches at seq_id.
-    for (auto& match: matches) {
-        if (match->index < match->ids_length && match->ids[match->index] == seq_id) {
-            match->index++;
+NumericTrie::iterator_t::iterator_t(const std::vector<Node*>& matches) {
+    std::vector<void*> raw_id_lists;
+    for (auto const& match: matches) {
+        if (ids_t::num_ids(match->get_seq_ids()) > 0) {
+            raw_id_lists.push_back(match->get_seq_ids());
         }
     }
 
-    set_seq_id();
+    ids_t::to_expanded_id_lists(raw_id_lists, id_lists, expanded_id_lists);
+    reset();
 }
 
-NumericTrie::iterator_t::iterator_t(std::vector<Node*>& node_matches) {
-    for (auto const& node_match: node_matches) {
-        uint32_t* ids = nullptr;
-        uint32_t ids_length;
-        node_match->get_all_ids(ids, ids_length);
-        if (ids_length > 0) {
-            matches.emplace_back(new match_state(ids, ids_length));
+NumericTrie::iterator_t::iterator_t(NumericTrie::iterator_t&& rhs) noexcept {
+    id_lists = std::move(rhs.id_lists);
+    expanded_id_lists = std::move(rhs.expanded_id_lists);
+    its = std::move(rhs.its);
+    heap = std::move(rhs.heap);
+    seq_id = rhs.seq_id;
+    is_valid = rhs.is_valid;
+
+    rhs.expanded_id_lists.clear();
+}
+
+void NumericTrie::iterator_t::reset() {
+    its.clear();
+    its.reserve(id_lists.size());
+
+    for (auto const& id_list: id_lists) {
+        its.push_back(id_list->new_iterator());
+    }
+
+    build_heap();
+}
+
+void NumericTrie::iterator_t::build_heap() {
+    heap.clear();
+    for (uint32_t i = 0; i < its.size(); i++) {
+        if (its[i].valid()) {
+            heap.push_back(i);
         }
     }
 
+    std::make_heap(heap.begin(), heap.end(), [&](const uint32_t& a, const uint32_t& b) {
+        return its[a].id() > its[b].id();
+    });
+
     set_seq_id();
 }
 
 void NumericTrie::iterator_t::set_seq_id() {
-    // Find the lowest id of all the matches and update the seq_id.
-    bool one_is_valid = false;
-    uint32_t lowest_id = UINT32_MAX;
+    is_valid = !heap.empty();
+    if (is_valid) {
+        seq_id = its[heap.front()].id();
+    }
+}
 
-    for (auto& match: matches) {
-        if (match->index < match->ids_length) {
-            one_is_valid = true;
+void NumericTrie::iterator_t::skip_to(uint32_t id) {
+    if (!is_valid || seq_id >= id) {
+        return;
+    }
 
-            if (match->ids[match->index] < lowest_id) {
-                lowest_id = match->ids[match->index];
-            }
+    for (auto const& index: heap) {
+        if (its[index].id() < id) {
+            its[index].skip_to(id);
         }
     }
 
-    if (one_is_valid) {
-        seq_id = lowest_id;
+    build_heap();
+}
+
+void NumericTrie::iterator_t::next() {
+    if (!is_valid) {
+        return;
+    }
+
+    auto const greater_id = [&](const uint32_t& a, const uint32_t& b) {
+        return its[a].id() > its[b].id();
+    };
+
+    // Advance all the lists at seq_id, since an id can be in more than one list for array fields.
+    const uint32_t current_id = seq_id;
+    while (!heap.empty() && its[heap.front()].id() == current_id) {
+        std::pop_heap(heap.begin(), heap.end(), greater_id);
+        auto const index = heap.back();
+        its[index].next();
+
+        if (its[index].valid()) {
+            std::push_heap(heap.begin(), heap.end(), greater_id);
+        } else {
+            heap.pop_back();
+        }
     }
 
-    is_valid = one_is_valid;
+    set_seq_id();
 }
 
 NumericTrie::iterator_t& NumericTrie::iterator_t::operator=(NumericTrie::iterator_t&& obj) noexcept {
     if (&obj == this)
         return *this;
 
-    for (auto& match: matches) {
-        delete match;
+    for (auto& expanded_id_list: expanded_id_lists) {
+        delete expanded_id_list;
     }
-    matches.clear();
 
-    matches = std::move(obj.matches);
+    id_lists = std::move(obj.id_lists);
+    expanded_id_lists = std::move(obj.expanded_id_lists);
+    its = std::move(obj.its);
+    heap = std::move(obj.heap);
     seq_id = obj.seq_id;
     is_valid = obj.is_valid;
 
+    obj.expanded_id_lists.clear();
+
     return *this;
 }
 
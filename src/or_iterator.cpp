@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "or_iterator.h"
 #include "filter.h"
 
@@ -96,78 +97,49 @@ bool or_iterator_t::valid() const {
     return !its.empty();
 }
 
-bool or_iterator_t::next() {
-    size_t num_lists = its.size();
+bool or_iterator_t::greater_id(const posting_list_t::iterator_t& a, const posting_list_t::iterator_t& b) {
+    return a.id() > b.id();
+}
 
-    switch (num_lists) {
-        case 0:
-            break;
-        case 2:
-            if(!posting_list_t::all_ended2(its)) {
-                advance_smallest();
-            }
-            break;
-        default:
-            if(!posting_list_t::all_ended(its)) {
-                advance_smallest();
-            }
-            break;
-    }
+template<class T>
+void or_iterator_t::advance_top(T advance) {
+    std::pop_heap(its.begin(), its.end(), greater_id);
+    auto& it = its.back();
+    advance(it);
 
-    return !its.empty();
+    if(it.valid()) {
+        std::push_heap(its.begin(), its.end(), greater_id);
+    } else {
+        it.reset_cache();
+        its.pop_back();
+    }
 }
 
-void or_iterator_t::advance_smallest() {
-    // we will advance the smallest value and point current_index to next smallest value across the lists
-    auto smallest_value = its[curr_index].id();
-    curr_index = 0;
+bool or_iterator_t::next() {
+    if(its.empty()) {
+        return false;
+    }
 
-    for(int i = 0; i < int(its.size()); i++) {
-        if(its[i].id() == smallest_value) {
-            its[i].next();
-        }
+    // advance all the iterators on the smallest id
+    const uint32_t smallest_value = its.front().id();
 
-        if(!its[i].valid()) {
-            its[i].reset_cache();
-            its.erase(its.cbegin() + i);
-            i--;
-        }
+    while(!its.empty() && its.front().id() == smallest_value) {
+        advance_top([](posting_list_t::iterator_t& it) { it.next(); });
     }
 
-    uint32_t new_smallest_value = UINT32_MAX;
-    for(int i = 0; i < int(its.size()); i++) {
-        if(its[i].id() < new_smallest_value) {
-            curr_index = i;
-            new_smallest_value = its[i].id();
-        }
-    }
+    return !its.empty();
 }
 
 bool or_iterator_t::skip_to(uint32_t id) {
-    auto current_value = UINT32_MAX;
-    curr_index = 0;
-
-    for(size_t i = 0; i < its.size(); i++) {
-        auto& it = its[i];
-        it.skip_to(id);
-
-        if(!it.valid()) {
-            its[i].reset_cache();
-            its.erase(its.begin() + i);
-            i--;
-        } else {
-            if(it.id() < current_value) {
-                curr_index = i;
-                current_value = it.id();
-            }
-        }
+    while(!its.empty() && its.front().id() < id) {
+        advance_top([id](posting_list_t::iterator_t& it) { it.skip_to(id); });
     }
 
     return !its.empty();
 }
 
 uint32_t or_iterator_t::id() const {
-    return its[curr_index].id();
+    return its.front().id();
 }
 
 bool or_iterator_t::take_id(result_iter_state_t& istate, uint32_t id, bool& is_excluded) {
@@ -276,23 +248,23 @@ bool or_iterator_t::take_id(result_iter_state_t& istate, uint32_t id, bool& is_e
 }
 
 or_iterator_t::or_iterator_t(std::vector<posting_list_t::iterator_t>& its): its(std::move(its)) {
-    curr_index = 0;
-
-    for(size_t i = 1; i < this->its.size(); i++) {
-        if(this->its[i].id() < this->its[curr_index].id()) {
-            curr_index = i;
+    for(size_t i = 0; i < this->its.size(); i++) {
+        if(!this->its[i].valid()) {
+            this->its[i].reset_cache();
+            this->its.erase(this->its.begin() + i);
+            i--;
         }
     }
+
+    std::make_heap(this->its.begin(), this->its.end(), greater_id);
 }
 
 or_iterator_t::or_iterator_t(or_iterator_t&& rhs) noexcept {
     its = std::move(rhs.its);
-    curr_index = rhs.curr_index;
 }
 
 or_iterator_t& or_iterator_t::operator=(or_iterator_t&& rhs) noexcept {
     its = std::move(rhs.its);
-    curr_index = rhs.curr_index;
     return *this;
 }
 
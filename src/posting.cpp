@@ -287,6 +287,36 @@ void posting_t::upsert(void*& obj, uint32_t id, const std::vector<uint32_t>& off
     list->upsert(id, offsets);
 }
 
+void posting_t::upsert_many(void*& obj, std::vector<id_offsets_t>& postings) {
+    std::stable_sort(postings.begin(), postings.end(), [](const id_offsets_t& a, const id_offsets_t& b) {
+        return a.first < b.first;
+    });
+
+    // keep the last posting of a repeated ID
+    size_t num_unique = 0;
+    for(size_t i = 0; i < postings.size(); i++) {
+        if(i + 1 < postings.size() && postings[i].first == postings[i + 1].first) {
+            continue;
+        }
+
+        postings[num_unique++] = postings[i];
+    }
+
+    postings.resize(num_unique);
+
+    // a compact list takes few postings, which are cheaper to add one by one
+    size_t posting_index = 0;
+    while(posting_index < postings.size() && IS_COMPACT_POSTING(obj)) {
+        upsert(obj, postings[posting_index].first, *postings[posting_index].second);
+        posting_index++;
+    }
+
+    if(posting_index < postings.size()) {
+        posting_list_t* list = (posting_list_t*)(obj);
+        list->upsert_sorted(postings.data() + posting_index, postings.size() - posting_index);
+    }
+}
+
 void posting_t::erase(void*& obj, uint32_t id) {
     if(IS_COMPACT_POSTING(obj)) {
         compact_posting_list_t* list = COMPACT_POSTING_PTR(obj);
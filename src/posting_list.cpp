@@ -1,8 +1,21 @@
 #include "posting_list.h"
+#include <algorithm>
 #include <bitset>
 #include "for.h"
 #include "array_utils.h"
 #include "filter_result_iterator.h"
+#include "search_profile.h"
+#include "request_cost.h"
+
+static inline void count_decompressed_block(uint32_t num_bytes) {
+    if(search_profile != nullptr) {
+        search_profile->num_blocks_decompressed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if(request_cost != nullptr) {
+        request_cost->posting_bytes_scanned.fetch_add(num_bytes, std::memory_order_relaxed);
+    }
+}
 
 /* block_t operations */
 
@@ -497,6 +510,139 @@ void posting_list_t::upsert(const uint32_t id, const std::vector<uint32_t>& offs
     }
 }
 
+void posting_list_t::load_block(posting_list_t::block_t* block, const uint32_t* ids, const uint32_t* offset_index,
+                                uint32_t num_ids, const uint32_t* offsets, uint32_t offsets_begin,
+                                uint32_t offsets_end) {
+    block->ids.load(ids, num_ids);
+
+    // offset indices of the block are relative to its first offset
+    std::vector<uint32_t> block_offset_index(num_ids);
+    for(size_t i = 0; i < num_ids; i++) {
+        block_offset_index[i] = offset_index[i] - offsets_begin;
+    }
+
+    block->offset_index.load(block_offset_index.data(), num_ids);
+
+    uint32_t min = 0, max = 0;
+    if(offsets_end > offsets_begin) {
+        min = max = offsets[offsets_begin];
+    }
+
+    for(size_t i = offsets_begin; i < offsets_end; i++) {
+        min = std::min(min, offsets[i]);
+        max = std::max(max, offsets[i]);
+    }
+
+    block->offsets.load(offsets + offsets_begin, offsets_end - offsets_begin, min, max);
+}
+
+void posting_list_t::upsert_sorted(const id_offsets_t* postings, const size_t num_postings) {
+    size_t posting_index = 0;
+
+    while(posting_index < num_postings) {
+        // locate the block of the next posting, like upsert() does
+        block_t* upsert_block;
+        last_id_t before_upsert_last_id;
+
+        if(id_block_map.empty()) {
+            upsert_block = &root_block;
+            before_upsert_last_id = UINT32_MAX;
+        } else {
+            const auto it = id_block_map.lower_bound(postings[posting_index].first);
+            upsert_block = (it == id_block_map.end()) ? id_block_map.rbegin()->second : it->second;
+            before_upsert_last_id = upsert_block->ids.last();
+        }
+
+        // the block takes the postings up to its last ID, or all of them when it is the last block
+        size_t group_end = posting_index + 1;
+        if(upsert_block->next == nullptr) {
+            group_end = num_postings;
+        } else {
+            while(group_end < num_postings && postings[group_end].first <= before_upsert_last_id) {
+                group_end++;
+            }
+        }
+
+        const uint32_t block_size = upsert_block->size();
+        const uint32_t block_offsets_size = upsert_block->offsets.getLength();
+        const bool is_append = (upsert_block->next == nullptr) &&
+                               (block_size == 0 || postings[posting_index].first > upsert_block->ids.last());
+
+        uint32_t* block_ids = upsert_block->ids.uncompress();
+        uint32_t* block_offset_index = upsert_block->offset_index.uncompress();
+        uint32_t* block_offsets = upsert_block->offsets.uncompress();
+
+        std::vector<uint32_t> merged_ids, merged_offset_index, merged_offsets;
+        merged_ids.reserve(block_size + (group_end - posting_index));
+        merged_offset_index.reserve(merged_ids.capacity());
+        merged_offsets.reserve(block_offsets_size);
+
+        size_t block_index = 0;
+
+        while(block_index < block_size || posting_index < group_end) {
+            if(posting_index == group_end ||
+               (block_index < block_size && block_ids[block_index] < postings[posting_index].first)) {
+                const uint32_t offsets_begin = block_offset_index[block_index];
+                const uint32_t offsets_end = (block_index + 1 < block_size) ? block_offset_index[block_index + 1] :
+                                             block_offsets_size;
+
+                merged_ids.push_back(block_ids[block_index]);
+                merged_offset_index.push_back(merged_offsets.size());
+                merged_offsets.insert(merged_offsets.end(), block_offsets + offsets_begin, block_offsets + offsets_end);
+                block_index++;
+                continue;
+            }
+
+            // an existing ID gets the offsets of the posting
+            if(block_index < block_size && block_ids[block_index] == postings[posting_index].first) {
+                block_index++;
+            } else {
+                ids_length++;
+            }
+
+            const std::vector<uint32_t>& offsets = *postings[posting_index].second;
+            merged_ids.push_back(postings[posting_index].first);
+            merged_offset_index.push_back(merged_offsets.size());
+            merged_offsets.insert(merged_offsets.end(), offsets.begin(), offsets.end());
+            posting_index++;
+        }
+
+        delete [] block_ids;
+        delete [] block_offset_index;
+        delete [] block_offsets;
+
+        // Appended IDs fill up their blocks, as consecutive upserts would, while the IDs of a block that overflows
+        // in the middle of the list are spread evenly over the new blocks.
+        const size_t num_merged = merged_ids.size();
+        const size_t num_blocks = (num_merged + BLOCK_MAX_ELEMENTS - 1) / BLOCK_MAX_ELEMENTS;
+        const size_t ids_per_block = is_append ? BLOCK_MAX_ELEMENTS : (num_merged + num_blocks - 1) / num_blocks;
+
+        id_block_map.erase(before_upsert_last_id);
+
+        block_t* block = upsert_block;
+        block_t* next_block = upsert_block->next;
+
+        for(size_t begin = 0; begin < num_merged; begin += ids_per_block) {
+            const size_t end = std::min(num_merged, begin + ids_per_block);
+            const uint32_t offsets_end = (end < num_merged) ? merged_offset_index[end] : merged_offsets.size();
+
+            if(block != upsert_block) {
+                block->next = next_block;
+                upsert_block->next = block;
+                upsert_block = block;
+            }
+
+            load_block(block, merged_ids.data() + begin, merged_offset_index.data() + begin, end - begin,
+                       merged_offsets.data(), merged_offset_index[begin], offsets_end);
+            id_block_map.emplace(merged_ids[end - 1], block);
+
+            block = new block_t;
+        }
+
+        delete block;
+    }
+}
+
 void posting_list_t::dump() {
     auto it = new_iterator();
 
@@ -508,14 +654,14 @@ void posting_list_t::dump() {
         auto index = it.index();
         while(index < it.block()->size()) {
             ids_str += std::to_string(it.ids[index]) + ", ";
-            offset_index_str += std::to_string(it.offset_index[index]) + ", ";
+            offset_index_str += std::to_string(it.get_offset_index()[index]) + ", ";
             index++;
         }
 
-        auto last_offset_index = it.offset_index[it.block()->size()-1];
+        auto last_offset_index = it.get_offset_index()[it.block()->size()-1];
 
         for(size_t j = 0; j <= last_offset_index; j++) {
-            offsets_str += std::to_string(it.offsets[j]) + ", ";
+            offsets_str += std::to_string(it.get_offsets()[j]) + ", ";
         }
 
         it.set_index(it.block()->size()-1);
@@ -721,38 +867,66 @@ void posting_list_t::intersect(const std::vector<posting_list_t*>& posting_lists
         return ;
     }
 
-    auto its = std::vector<posting_list_t::iterator_t>();
-    its.reserve(posting_lists.size());
+    // Only the IDs of the blocks are needed here, so instead of iterators (which also decompress offsets), the
+    // shortest list is decompressed and then intersected block by block with each of the other lists.
+    std::vector<posting_list_t*> sorted_lists = posting_lists;
+    std::sort(sorted_lists.begin(), sorted_lists.end(), [](const posting_list_t* a, const posting_list_t* b) {
+        return a->ids_length < b->ids_length;
+    });
 
-    for(const auto& posting_list: posting_lists) {
-        its.push_back(posting_list->new_iterator());
+    std::vector<uint32_t> curr_ids;
+    curr_ids.reserve(sorted_lists[0]->ids_length);
+
+    for(block_t* block = &sorted_lists[0]->root_block; block != nullptr; block = block->next) {
+        const uint32_t block_size = block->size();
+        if(block_size == 0) {
+            continue;
+        }
+
+        count_decompressed_block(block->ids.getSizeInBytes());
+        uint32_t* block_ids = block->ids.uncompress();
+        curr_ids.insert(curr_ids.end(), block_ids, block_ids + block_size);
+        delete [] block_ids;
     }
 
-    size_t num_lists = its.size();
+    std::vector<uint32_t> next_ids;
 
-    switch (num_lists) {
-        case 2:
-            while(!at_end2(its)) {
-                if(equals2(its)) {
-                    //LOG(INFO) << its[0].id();
-                    result_ids.push_back(its[0].id());
-                    advance_all2(its);
-                } else {
-                    advance_non_largest2(its);
-                }
+    for(size_t i = 1; i < sorted_lists.size() && !curr_ids.empty(); i++) {
+        const auto& id_block_map = sorted_lists[i]->id_block_map;
+        next_ids.resize(curr_ids.size());
+        size_t next_ids_len = 0;
+        size_t curr_index = 0;
+
+        while(curr_index < curr_ids.size()) {
+            // skips blocks which cannot contain the remaining IDs
+            const auto block_it = id_block_map.lower_bound(curr_ids[curr_index]);
+            if(block_it == id_block_map.end()) {
+                break;
             }
-            break;
-        default:
-            while(!at_end(its)) {
-                if(equals(its)) {
-                    //LOG(INFO) << its[0].id();
-                    result_ids.push_back(its[0].id());
-                    advance_all(its);
-                } else {
-                    advance_non_largest(its);
-                }
+
+            block_t* block = block_it->second;
+            const uint32_t block_size = block->size();
+            const uint32_t block_last_id = block_it->first;
+
+            const size_t curr_end = std::upper_bound(curr_ids.begin() + curr_index, curr_ids.end(),
+                                                     block_last_id) - curr_ids.begin();
+
+            if(block_size != 0) {
+                count_decompressed_block(block->ids.getSizeInBytes());
+                uint32_t* block_ids = block->ids.uncompress();
+                next_ids_len += ArrayUtils::and_simd(curr_ids.data() + curr_index, curr_end - curr_index,
+                                                     block_ids, block_size, next_ids.data() + next_ids_len);
+                delete [] block_ids;
             }
+
+            curr_index = curr_end;
+        }
+
+        next_ids.resize(next_ids_len);
+        curr_ids.swap(next_ids);
     }
+
+    result_ids.insert(result_ids.end(), curr_ids.begin(), curr_ids.end());
 }
 
 void posting_list_t::intersect(std::vector<posting_list_t::iterator_t>& posting_list_iterators, bool& is_valid) {
@@ -816,11 +990,11 @@ void posting_list_t::get_offsets(iterator_t& iter, std::vector<uint32_t>& positi
         return;
     }
 
-    uint32_t* offsets = iter.offsets;
-    uint32_t start_offset = iter.offset_index[curr_index];
+    const uint32_t* offsets = iter.get_offsets();
+    uint32_t start_offset = iter.get_offset_index()[curr_index];
     uint32_t end_offset = (curr_index == curr_block->size() - 1) ?
                             curr_block->offsets.getLength() :
-                            iter.offset_index[curr_index + 1];
+                            iter.get_offset_index()[curr_index + 1];
 
     while(start_offset < end_offset) {
         int pos = offsets[start_offset];
@@ -852,12 +1026,12 @@ bool posting_list_t::get_offsets(const std::vector<iterator_t>& its,
             continue;
         }
 
-        uint32_t* offsets = its[j].offsets;
+        const uint32_t* offsets = its[j].get_offsets();
 
-        uint32_t start_offset = its[j].offset_index[curr_index];
+        uint32_t start_offset = its[j].get_offset_index()[curr_index];
         uint32_t end_offset = (curr_index == curr_block->size() - 1) ?
                               curr_block->offsets.getLength() :
-                              its[j].offset_index[curr_index + 1];
+                              its[j].get_offset_index()[curr_index + 1];
 
         std::vector<uint16_t> positions;
         int prev_pos = -1;
@@ -923,8 +1097,8 @@ bool posting_list_t::is_single_token_verbatim_match(const posting_list_t::iterat
         return false;
     }
 
-    uint32_t* offsets = it.offsets;
-    uint32_t start_offset = it.offset_index[curr_index];
+    const uint32_t* offsets = it.get_offsets();
+    uint32_t start_offset = it.get_offset_index()[curr_index];
 
     if(!field_is_array && offsets[start_offset] != 1) {
         // allows us to skip other computes fast
@@ -933,7 +1107,7 @@ bool posting_list_t::is_single_token_verbatim_match(const posting_list_t::iterat
 
     uint32_t end_offset = (curr_index == curr_block->size() - 1) ?
                           curr_block->offsets.getLength() :
-                          it.offset_index[curr_index + 1];
+                          it.get_offset_index()[curr_index + 1];
 
     if(field_is_array) {
        int prev_pos = -1;
@@ -1144,12 +1318,12 @@ void posting_list_t::get_exact_matches(std::vector<iterator_t>& its, const bool
                         break;
                     }
 
-                    uint32_t* offsets = it.offsets;
+                    const uint32_t* offsets = it.get_offsets();
 
-                    uint32_t start_offset_index = it.offset_index[curr_index];
+                    uint32_t start_offset_index = it.get_offset_index()[curr_index];
                     uint32_t end_offset_index = (curr_index == curr_block->size() - 1) ?
                                                 curr_block->offsets.getLength() :
-                                                it.offset_index[curr_index + 1];
+                                                it.get_offset_index()[curr_index + 1];
 
                     if(j == its.size()-1) {
                         // check if the last query token is the last offset
@@ -1216,11 +1390,11 @@ void posting_list_t::get_exact_matches(std::vector<iterator_t>& its, const bool
                         break;
                     }
 
-                    uint32_t* offsets = it.offsets;
-                    uint32_t start_offset_index = it.offset_index[curr_index];
+                    const uint32_t* offsets = it.get_offsets();
+                    uint32_t start_offset_index = it.get_offset_index()[curr_index];
                     uint32_t end_offset_index = (curr_index == curr_block->size() - 1) ?
                                                 curr_block->offsets.getLength() :
-                                                it.offset_index[curr_index + 1];
+                                                it.get_offset_index()[curr_index + 1];
 
                     int prev_pos = -1;
                     bool has_atleast_one_last_token = false;
@@ -1309,12 +1483,12 @@ bool posting_list_t::has_exact_match(std::vector<posting_list_t::iterator_t>& po
                     return false;
                 }
 
-                uint32_t* offsets = it.offsets;
+                const uint32_t* offsets = it.get_offsets();
 
-                uint32_t start_offset_index = it.offset_index[curr_index];
+                uint32_t start_offset_index = it.get_offset_index()[curr_index];
                 uint32_t end_offset_index = (curr_index == curr_block->size() - 1) ?
                                             curr_block->offsets.getLength() :
-                                            it.offset_index[curr_index + 1];
+                                            it.get_offset_index()[curr_index + 1];
 
                 if(i == posting_list_iterators.size() - 1) {
                     // check if the last query token is the last offset
@@ -1362,11 +1536,11 @@ bool posting_list_t::has_exact_match(std::vector<posting_list_t::iterator_t>& po
                     return false;
                 }
 
-                uint32_t* offsets = it.offsets;
-                uint32_t start_offset_index = it.offset_index[curr_index];
+                const uint32_t* offsets = it.get_offsets();
+                uint32_t start_offset_index = it.get_offset_index()[curr_index];
                 uint32_t end_offset_index = (curr_index == curr_block->size() - 1) ?
                                             curr_block->offsets.getLength() :
-                                            it.offset_index[curr_index + 1];
+                                            it.get_offset_index()[curr_index + 1];
 
                 int prev_pos = -1;
                 bool has_atleast_one_last_token = false;
@@ -1538,11 +1712,11 @@ void posting_list_t::get_matching_array_indices(uint32_t id, std::vector<iterato
             return;
         }
 
-        uint32_t* offsets = it.offsets;
-        uint32_t start_offset_index = it.offset_index[curr_index];
+        const uint32_t* offsets = it.get_offsets();
+        uint32_t start_offset_index = it.get_offset_index()[curr_index];
         uint32_t end_offset_index = (curr_index == curr_block->size() - 1) ?
                                     curr_block->offsets.getLength() :
-                                    it.offset_index[curr_index + 1];
+                                    it.get_offset_index()[curr_index + 1];
 
         int prev_pos = -1;
         while(start_offset_index < end_offset_index) {
@@ -1597,7 +1771,7 @@ bool posting_list_t::all_ended2(const std::vector<posting_list_t::iterator_t>& i
 size_t posting_list_t::get_last_offset(const posting_list_t::iterator_t& it, bool field_is_array) {
     block_t* curr_block = it.block();
     uint32_t curr_index = it.index();
-    uint32_t* offsets = it.offsets;
+    const uint32_t* offsets = it.get_offsets();
 
     if(curr_block == nullptr || curr_index == UINT32_MAX) {
         return 0;
@@ -1605,10 +1779,10 @@ size_t posting_list_t::get_last_offset(const posting_list_t::iterator_t& it, boo
 
     uint32_t end_offset = (curr_index == curr_block->size() - 1) ?
                           curr_block->offsets.getLength() :
-                          it.offset_index[curr_index + 1];
+                          it.get_offset_index()[curr_index + 1];
 
     if(field_is_array) {
-        uint32_t start_offset = it.offset_index[curr_index];
+        uint32_t start_offset = it.get_offset_index()[curr_index];
         int prev_pos = -1;
         size_t max_offset = 0;
 
@@ -1657,9 +1831,8 @@ posting_list_t::iterator_t::iterator_t(const std::map<last_id_t, block_t*>* id_b
         auto_destroy(auto_destroy), field_id(field_id) {
 
     if(curr_block != end_block) {
+        count_decompressed_block(curr_block->ids.getSizeInBytes());
         ids = curr_block->ids.uncompress();
-        offset_index = curr_block->offset_index.uncompress();
-        offsets = curr_block->offsets.uncompress();
 
         if(reverse) {
             curr_index = curr_block->ids.getLength()-1;
@@ -1684,9 +1857,8 @@ void posting_list_t::iterator_t::next() {
         ids = offset_index = offsets = nullptr;
 
         if(curr_block != end_block) {
+            count_decompressed_block(curr_block->ids.getSizeInBytes());
             ids = curr_block->ids.uncompress();
-            offset_index = curr_block->offset_index.uncompress();
-            offsets = curr_block->offsets.uncompress();
         }
     }
 }
@@ -1714,9 +1886,30 @@ uint32_t posting_list_t::iterator_t::id() const {
 }
 
 uint32_t posting_list_t::iterator_t::offset() const {
+    decompress_offsets();
     return offsets[offset_index[curr_index]];
 }
 
+void posting_list_t::iterator_t::decompress_offsets() const {
+    if(offset_index != nullptr || curr_block == nullptr || curr_block == end_block) {
+        return ;
+    }
+
+    count_decompressed_block(curr_block->offset_index.getSizeInBytes() + curr_block->offsets.getSizeInBytes());
+    offset_index = curr_block->offset_index.uncompress();
+    offsets = curr_block->offsets.uncompress();
+}
+
+const uint32_t* posting_list_t::iterator_t::get_offset_index() const {
+    decompress_offsets();
+    return offset_index;
+}
+
+const uint32_t* posting_list_t::iterator_t::get_offsets() const {
+    decompress_offsets();
+    return offsets;
+}
+
 uint32_t posting_list_t::iterator_t::index() const {
     return curr_index;
 }
@@ -1728,10 +1921,7 @@ posting_list_t::block_t* posting_list_t::iterator_t::block() const {
 void posting_list_t::iterator_t::skip_to(uint32_t id) {
     // first look to skip within current block
     if(id <= this->last_block_id()) {
-        while(curr_index < curr_block->size() && this->id() < id) {
-            curr_index++;
-        }
-
+        curr_index = std::lower_bound(ids + curr_index, ids + curr_block->size(), id) - ids;
         return ;
     }
 
@@ -1744,14 +1934,9 @@ void posting_list_t::iterator_t::skip_to(uint32_t id) {
     }
 
     curr_block = it->second;
-    curr_index = 0;
+    count_decompressed_block(curr_block->ids.getSizeInBytes());
     ids = curr_block->ids.uncompress();
-    offset_index = curr_block->offset_index.uncompress();
-    offsets = curr_block->offsets.uncompress();
-
-    while(curr_index < curr_block->size() && this->id() < id) {
-        curr_index++;
-    }
+    curr_index = std::lower_bound(ids, ids + curr_block->size(), id) - ids;
 
     if(curr_index == curr_block->size()) {
         reset_cache();
@@ -1778,9 +1963,8 @@ void posting_list_t::iterator_t::skip_to_rev(uint32_t id) {
 
     curr_block = it->second;
     curr_index = curr_block->size()-1;
+    count_decompressed_block(curr_block->ids.getSizeInBytes());
     ids = curr_block->ids.uncompress();
-    offset_index = curr_block->offset_index.uncompress();
-    offsets = curr_block->offsets.uncompress();
 
     while(curr_index > 0 && this->id() > id) {
         curr_index--;
@@ -1852,6 +2036,9 @@ void posting_list_t::iterator_t::set_index(uint32_t index) {
 }
 
 posting_list_t::iterator_t posting_list_t::iterator_t::clone() const {
+    // the clone does not own any buffers, so the offsets of the current block must be owned by this iterator
+    decompress_offsets();
+
     posting_list_t::iterator_t it(nullptr, nullptr, nullptr);
     it.id_block_map = id_block_map;
     it.curr_block = curr_block;
@@ -4,7 +4,68 @@
 #include <mutex>
 #include "string_utils.h"
 
-QueryAnalytics::QueryAnalytics(size_t k) : k(k), max_size(k * 2) {
+space_saving_sketch_t::space_saving_sketch_t(size_t capacity): capacity(capacity) {
+
+}
+
+void space_saving_sketch_t::add(const std::string& key, uint32_t count) {
+    if(capacity == 0) {
+        return ;
+    }
+
+    auto it = counters.find(key);
+
+    if(it != counters.end()) {
+        min_counts.erase({it->second.count, key});
+        it->second.count += count;
+        min_counts.emplace(it->second.count, key);
+        return ;
+    }
+
+    uint32_t error = 0;
+
+    if(counters.size() >= capacity) {
+        // evict the key with the smallest count: the new key takes over its count
+        auto min_it = min_counts.begin();
+        error = min_it->first;
+        counters.erase(min_it->second);
+        min_counts.erase(min_it);
+    }
+
+    counters.emplace(key, counter_t{error + count, error});
+    min_counts.emplace(error + count, key);
+}
+
+void space_saving_sketch_t::merge(const space_saving_sketch_t& other) {
+    for(const auto& kv: other.counters) {
+        add(kv.first, kv.second.count);
+    }
+}
+
+std::vector<std::pair<std::string, uint32_t>> space_saving_sketch_t::top(size_t k) const {
+    std::vector<std::pair<std::string, uint32_t>> top_keys;
+
+    for(auto it = min_counts.rbegin(); it != min_counts.rend() && top_keys.size() < k; ++it) {
+        top_keys.emplace_back(it->second, it->first);
+    }
+
+    return top_keys;
+}
+
+const std::unordered_map<std::string, space_saving_sketch_t::counter_t>& space_saving_sketch_t::get_counters() const {
+    return counters;
+}
+
+size_t space_saving_sketch_t::size() const {
+    return counters.size();
+}
+
+void space_saving_sketch_t::clear() {
+    counters.clear();
+    min_counts.clear();
+}
+
+QueryAnalytics::QueryAnalytics(size_t k) : k(k), max_size(k * 2), top_k_sketch(k * 2) {
 
 }
 
@@ -37,6 +98,12 @@ void QueryAnalytics::add(const std::string& key, const std::string& expanded_key
             return ;
         }
 
+        if(enable_top_k_sketch) {
+            top_k_sketch.add(key);
+            lmutex.unlock();
+            return ;
+        }
+
         auto it = local_counts.find(key);
 
         if(it != local_counts.end()) {
@@ -53,6 +120,22 @@ void QueryAnalytics::add(const std::string& key, const std::string& expanded_key
 void QueryAnalytics::serialize_as_docs(std::string& docs) {
     std::shared_lock lk(lmutex);
 
+    if(enable_top_k_sketch) {
+        for(const auto& kv: top_k_sketch.get_counters()) {
+            nlohmann::json doc;
+            doc["id"] = std::to_string(StringUtils::hash_wy(kv.first.c_str(), kv.first.size()));
+            doc["q"] = kv.first;
+            doc["$operations"]["increment"]["count"] = kv.second.count;
+            docs += doc.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore) + "\n";
+        }
+
+        if(!docs.empty()) {
+            docs.pop_back();
+        }
+
+        return ;
+    }
+
     std::string key_buffer;
     for(auto it = local_counts.begin(); it != local_counts.end(); ++it) {
         it.key(key_buffer);
@@ -71,6 +154,7 @@ void QueryAnalytics::serialize_as_docs(std::string& docs) {
 void QueryAnalytics::reset_local_counts() {
     std::unique_lock lk(lmutex);
     local_counts.clear();
+    top_k_sketch.clear();
 }
 
 size_t QueryAnalytics::get_k() {
@@ -117,9 +201,22 @@ std::unordered_map<std::string, std::vector<QueryAnalytics::QWithTimestamp>> Que
 
 tsl::htrie_map<char, uint32_t> QueryAnalytics::get_local_counts() {
     std::unique_lock lk(lmutex);
+
+    if(enable_top_k_sketch) {
+        tsl::htrie_map<char, uint32_t> sketch_counts;
+        for(const auto& kv: top_k_sketch.get_counters()) {
+            sketch_counts.emplace(kv.first, kv.second.count);
+        }
+        return sketch_counts;
+    }
+
     return local_counts;
 }
 
 void QueryAnalytics::set_expand_query(bool expand_query) {
     this->expand_query = expand_query;
 }
+
+void QueryAnalytics::set_enable_top_k_sketch(bool enable_top_k_sketch) {
+    this->enable_top_k_sketch = enable_top_k_sketch;
+}
@@ -0,0 +1,168 @@
+#include "query_replay.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include "string_utils.h"
+
+Option<replay_request_t> query_replay_t::parse_line(const std::string& line) {
+    replay_request_t request;
+
+    const size_t event_pos = line.find(SEARCH_LOG_EVENT);
+    if(event_pos != std::string::npos) {
+        // e.g. event=search_request, client_ip=127.0.0.1, endpoint=GET /collections/c/documents/search?q=a&, body=
+        const std::string endpoint_key = ", endpoint=";
+        const std::string body_key = ", body=";
+
+        const size_t endpoint_pos = line.find(endpoint_key, event_pos);
+        if(endpoint_pos == std::string::npos) {
+            return Option<replay_request_t>(400, "Search log line has no endpoint.");
+        }
+
+        const size_t endpoint_begin = endpoint_pos + endpoint_key.size();
+        const size_t body_pos = line.find(body_key, endpoint_begin);
+        const std::string endpoint = line.substr(endpoint_begin, body_pos == std::string::npos ? std::string::npos :
+                                                                 body_pos - endpoint_begin);
+        if(body_pos != std::string::npos) {
+            request.body = line.substr(body_pos + body_key.size());
+        }
+
+        const size_t space_pos = endpoint.find(' ');
+        if(space_pos == std::string::npos) {
+            return Option<replay_request_t>(400, "Search log line has no method.");
+        }
+
+        request.method = endpoint.substr(0, space_pos);
+        const std::string path_with_query = endpoint.substr(space_pos + 1);
+
+        // parameters are logged as they were decoded, so they have to be encoded again
+        const size_t query_pos = path_with_query.find('?');
+        request.path = path_with_query.substr(0, query_pos);
+
+        if(query_pos != std::string::npos) {
+            std::vector<std::string> params;
+            StringUtils::split(path_with_query.substr(query_pos + 1), params, "&");
+
+            std::string query_string;
+            for(const auto& param: params) {
+                const size_t eq_pos = param.find('=');
+                if(eq_pos == std::string::npos) {
+                    continue;
+                }
+
+                query_string += query_string.empty() ? "?" : "&";
+                query_string += url_encode(param.substr(0, eq_pos)) + "=" + url_encode(param.substr(eq_pos + 1));
+            }
+
+            request.path += query_string;
+        }
+
+        return Option<replay_request_t>(request);
+    }
+
+    nlohmann::json json;
+    try {
+        json = nlohmann::json::parse(line);
+    } catch(const std::exception& e) {
+        return Option<replay_request_t>(400, "Line is neither a search log line nor JSON.");
+    }
+
+    if(!json.is_object() || !json.contains("path") || !json["path"].is_string()) {
+        return Option<replay_request_t>(400, "Request must be an object with a `path`.");
+    }
+
+    request.path = json["path"].get<std::string>();
+
+    if(json.contains("params")) {
+        if(!json["params"].is_object()) {
+            return Option<replay_request_t>(400, "`params` must be an object.");
+        }
+
+        bool has_query = request.path.find('?') != std::string::npos;
+        for(const auto& item: json["params"].items()) {
+            const std::string value = item.value().is_string() ? item.value().get<std::string>() :
+                                      item.value().dump();
+            request.path += has_query ? "&" : "?";
+            request.path += url_encode(item.key()) + "=" + url_encode(value);
+            has_query = true;
+        }
+    }
+
+    if(json.contains("body")) {
+        request.body = json["body"].is_string() ? json["body"].get<std::string>() : json["body"].dump();
+    }
+
+    if(json.contains("method") && json["method"].is_string()) {
+        request.method = json["method"].get<std::string>();
+    } else {
+        request.method = request.body.empty() ? "GET" : "POST";
+    }
+
+    return Option<replay_request_t>(request);
+}
+
+std::string query_replay_t::url_encode(const std::string& text) {
+    static const char* hex_chars = "0123456789ABCDEF";
+    std::string encoded;
+
+    for(unsigned char c: text) {
+        if(std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            encoded += char(c);
+        } else {
+            encoded += '%';
+            encoded += hex_chars[c >> 4];
+            encoded += hex_chars[c & 15];
+        }
+    }
+
+    return encoded;
+}
+
+void replay_stats_t::add(long status_code, uint64_t latency_us) {
+    std::unique_lock lk(mutex);
+    latencies_us.push_back(latency_us);
+    status_counts[status_code]++;
+
+    if(status_code < 200 || status_code >= 300) {
+        num_errors++;
+    }
+}
+
+size_t replay_stats_t::size() const {
+    std::unique_lock lk(mutex);
+    return latencies_us.size();
+}
+
+uint64_t replay_stats_t::get_percentile(const std::vector<uint64_t>& sorted_values, double percentile) {
+    if(sorted_values.empty()) {
+        return 0;
+    }
+
+    // nearest rank
+    const size_t rank = std::ceil(percentile / 100 * sorted_values.size());
+    return sorted_values[std::min(sorted_values.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+nlohmann::json replay_stats_t::to_json(double elapsed_s) const {
+    std::unique_lock lk(mutex);
+
+    std::vector<uint64_t> sorted_latencies = latencies_us;
+    std::sort(sorted_latencies.begin(), sorted_latencies.end());
+
+    nlohmann::json json;
+    json["num_requests"] = sorted_latencies.size();
+    json["num_errors"] = num_errors;
+    json["elapsed_s"] = elapsed_s;
+    json["qps"] = elapsed_s > 0 ? sorted_latencies.size() / elapsed_s : 0;
+
+    for(const auto& kv: status_counts) {
+        json["status_codes"][std::to_string(kv.first)] = kv.second;
+    }
+
+    json["latency_ms"]["p50"] = get_percentile(sorted_latencies, 50) / 1000.0;
+    json["latency_ms"]["p90"] = get_percentile(sorted_latencies, 90) / 1000.0;
+    json["latency_ms"]["p99"] = get_percentile(sorted_latencies, 99) / 1000.0;
+    json["latency_ms"]["p99.9"] = get_percentile(sorted_latencies, 99.9) / 1000.0;
+    json["latency_ms"]["max"] = get_percentile(sorted_latencies, 100) / 1000.0;
+
+    return json;
+}
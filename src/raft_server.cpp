@@ -1,8 +1,11 @@
 #include "store.h"
 #include "raft_server.h"
 #include <butil/files/file_enumerator.h>
+#include <braft/local_file_meta.pb.h>
 #include <thread>
 #include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <string_utils.h>
 #include <file_utils.h>
 #include <collection_manager.h>
@@ -10,6 +13,8 @@
 #include "rocksdb/utilities/checkpoint.h"
 #include "thread_local_vars.h"
 #include "core_api.h"
+#include "search_warmup.h"
+#include "app_metrics.h"
 
 namespace braft {
     DECLARE_int32(raft_do_snapshot_min_index_gap);
@@ -27,6 +32,11 @@ void ReplicationClosure::Run() {
     std::unique_ptr<ReplicationClosure> self_guard(this);
 }
 
+void WriteBatchClosure::Run() {
+    // as with `ReplicationClosure`, the responses are sent once the writes are indexed
+    std::unique_ptr<WriteBatchClosure> self_guard(this);
+}
+
 // State machine implementation
 
 int ReplicationState::start(const butil::EndPoint & peering_endpoint, const int api_port,
@@ -135,6 +145,14 @@ int ReplicationState::start(const butil::EndPoint & peering_endpoint, const int
 
     std::unique_lock lock(node_mutex);
     this->node = node;
+    lock.unlock();
+
+    if(config->get_write_batch_window_us() != 0 && !write_batch_thread.joinable()) {
+        LOG(INFO) << "Coalescing writes arriving within " << config->get_write_batch_window_us()
+                  << "us into a single log entry, up to " << config->get_write_batch_max_bytes() << " bytes.";
+        write_batch_thread = std::thread(&ReplicationState::write_batch_loop, this);
+    }
+
     return 0;
 }
 
@@ -254,14 +272,14 @@ void ReplicationState::write(const std::shared_ptr<http_req>& request, const std
                           std::string(magic_enum::enum_name(resource_check)));
         response->final = true;
         auto req_res = new async_req_res_t(request, response, true);
-        return message_dispatcher->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+        return get_message_dispatcher(request)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
     }
 
     if(config->get_skip_writes() && request->path_without_query != "/config") {
         response->set_422("Skipping writes.");
         response->final = true;
         auto req_res = new async_req_res_t(request, response, true);
-        return message_dispatcher->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+        return get_message_dispatcher(request)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
     }
 
     route_path* rpath = nullptr;
@@ -272,7 +290,7 @@ void ReplicationState::write(const std::shared_ptr<http_req>& request, const std
             response->set_422("Another collection update operation is in progress.");
             response->final = true;
             auto req_res = new async_req_res_t(request, response, true);
-            return message_dispatcher->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+            return get_message_dispatcher(request)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
         }
 
         set_alter_in_progress(true);
@@ -280,6 +298,11 @@ void ReplicationState::write(const std::shared_ptr<http_req>& request, const std
 
     std::shared_lock lock(node_mutex);
 
+    if(is_learner()) {
+        // forwarded to the voter that the learner follows, which forwards it to the leader in turn
+        return write_to_leader(request, response);
+    }
+
     if(!node) {
         return ;
     }
@@ -297,41 +320,228 @@ void ReplicationState::write(const std::shared_ptr<http_req>& request, const std
             response->set_422(res.error());
             response->final = true;
             auto req_res = new async_req_res_t(request, response, true);
-            return message_dispatcher->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+            return get_message_dispatcher(request)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
         }
     }
 
     // Serialize request to replicated WAL so that all the nodes in the group receive it as well.
     // NOTE: actual write must be done only on the `on_apply` method to maintain consistency.
+    std::string serialized_req = request->to_json();
 
+    if(config->get_write_batch_window_us() != 0) {
+        std::unique_lock batch_lock(write_batch_mutex);
+
+        if(write_batch_bytes + serialized_req.size() > config->get_write_batch_max_bytes()) {
+            flush_write_batch();
+        }
+
+        if(serialized_req.size() < config->get_write_batch_max_bytes()) {
+            write_batch.emplace_back(request, response);
+            write_batch_bytes += serialized_req.size();
+            write_batch_data.push_back(std::move(serialized_req));
+            pending_writes++;
+
+            if(write_batch.size() == 1) {
+                write_batch_cv.notify_one();
+            }
+
+            return ;
+        }
+
+        // too large to be batched: applied right away, after the writes that arrived before it
+        apply_write(serialized_req, new ReplicationClosure(request, response));
+        pending_writes++;
+        return ;
+    }
+
+    apply_write(serialized_req, new ReplicationClosure(request, response));
+    pending_writes++;
+}
+
+void ReplicationState::apply_write(const std::string& serialized_req, braft::Closure* done) {
     butil::IOBufBuilder bufBuilder;
-    bufBuilder << request->to_json();
 
-    //LOG(INFO) << "write() pre request ref count " << request.use_count();
+    const size_t compression_min_bytes = config->get_log_compression_min_bytes();
+    std::string compressed_req;
+
+    if(compression_min_bytes != 0 && serialized_req.size() >= compression_min_bytes &&
+       compress_log_entry(serialized_req, compressed_req)) {
+        bufBuilder << compressed_req;
+    } else {
+        bufBuilder << serialized_req;
+    }
 
     // Apply this log as a braft::Task
 
     braft::Task task;
     task.data = &bufBuilder.buf();
     // This callback would be invoked when the task actually executes or fails
-    task.done = new ReplicationClosure(request, response);
-
-    //LOG(INFO) << "write() post request ref count " << request.use_count();
+    task.done = done;
 
     // To avoid ABA problem
     task.expected_term = leader_term.load(butil::memory_order_relaxed);
 
-    //LOG(INFO) << ":::" << "body size before apply: " << request->body.size();
-
     // Now the task is applied to the group
     node->apply(task);
+}
 
-    pending_writes++;
+void ReplicationState::flush_write_batch() {
+    // caller holds `node_mutex` as well
+    if(write_batch.empty()) {
+        return ;
+    }
+
+    if(node == nullptr || !node->is_leader()) {
+        // leadership was lost while the writes were waiting
+        for(const auto& req_res: write_batch) {
+            if(node == nullptr) {
+                req_res.second->set_503("Not Ready or Lagging");
+                req_res.second->final = true;
+                auto async_req_res = new async_req_res_t(req_res.first, req_res.second, true);
+                get_message_dispatcher(req_res.first)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+            } else {
+                write_to_leader(req_res.first, req_res.second);
+            }
+
+            pending_writes--;
+        }
+    } else if(write_batch.size() == 1) {
+        apply_write(write_batch_data.front(), new ReplicationClosure(write_batch.front().first,
+                                                                     write_batch.front().second));
+    } else {
+        apply_write(encode_write_batch(write_batch_data), new WriteBatchClosure(std::move(write_batch)));
+    }
+
+    write_batch.clear();
+    write_batch_data.clear();
+    write_batch_bytes = 0;
+}
+
+void ReplicationState::write_batch_loop() {
+    const auto window = std::chrono::microseconds(config->get_write_batch_window_us());
+    std::unique_lock batch_lock(write_batch_mutex);
+
+    while(true) {
+        write_batch_cv.wait(batch_lock, [&]() { return write_batch_quit || !write_batch.empty(); });
+
+        if(write_batch.empty()) {
+            return ;
+        }
+
+        // the writes that arrive within the window join the batch
+        write_batch_cv.wait_for(batch_lock, window, [&]() { return write_batch_quit; });
+        batch_lock.unlock();
+
+        {
+            // `node_mutex` is taken before `write_batch_mutex`, as in `write()`
+            std::shared_lock lock(node_mutex);
+            std::unique_lock flush_lock(write_batch_mutex);
+            flush_write_batch();
+        }
+
+        batch_lock.lock();
+    }
+}
+
+std::string ReplicationState::encode_write_batch(const std::vector<std::string>& serialized_reqs) {
+    size_t size = WRITE_BATCH_MAGIC_SIZE;
+    for(const auto& serialized_req: serialized_reqs) {
+        size += sizeof(uint32_t) + serialized_req.size();
+    }
+
+    std::string data;
+    data.reserve(size);
+    data.append(WRITE_BATCH_MAGIC, WRITE_BATCH_MAGIC_SIZE);
+
+    for(const auto& serialized_req: serialized_reqs) {
+        data += StringUtils::serialize_uint32_t(serialized_req.size());
+        data += serialized_req;
+    }
+
+    return data;
+}
+
+bool ReplicationState::compress_log_entry(const std::string& data, std::string& compressed_data) {
+    uLongf compressed_size = compressBound(data.size());
+    compressed_data.resize(LOG_COMPRESSION_MAGIC_SIZE + sizeof(uint32_t) + compressed_size);
+
+    if(compress2(reinterpret_cast<Bytef*>(&compressed_data[LOG_COMPRESSION_MAGIC_SIZE + sizeof(uint32_t)]),
+                 &compressed_size, reinterpret_cast<const Bytef*>(data.data()), data.size(),
+                 Z_BEST_SPEED) != Z_OK) {
+        return false;
+    }
+
+    compressed_data.resize(LOG_COMPRESSION_MAGIC_SIZE + sizeof(uint32_t) + compressed_size);
+
+    if(compressed_data.size() >= data.size()) {
+        // not worth it: the entry is appended as it is
+        return false;
+    }
+
+    compressed_data.replace(0, LOG_COMPRESSION_MAGIC_SIZE, LOG_COMPRESSION_MAGIC, LOG_COMPRESSION_MAGIC_SIZE);
+    compressed_data.replace(LOG_COMPRESSION_MAGIC_SIZE, sizeof(uint32_t), StringUtils::serialize_uint32_t(data.size()));
+    return true;
+}
+
+Option<bool> ReplicationState::decompress_log_entry(const std::string& data, std::string& uncompressed_data) {
+    if(data.size() < LOG_COMPRESSION_MAGIC_SIZE ||
+       data.compare(0, LOG_COMPRESSION_MAGIC_SIZE, LOG_COMPRESSION_MAGIC) != 0) {
+        return Option<bool>(false);
+    }
+
+    const size_t header_size = LOG_COMPRESSION_MAGIC_SIZE + sizeof(uint32_t);
+    if(data.size() < header_size) {
+        return Option<bool>(400, "Truncated compressed log entry.");
+    }
+
+    uLongf uncompressed_size = StringUtils::deserialize_uint32_t(data.substr(LOG_COMPRESSION_MAGIC_SIZE,
+                                                                             sizeof(uint32_t)));
+    uncompressed_data.resize(uncompressed_size);
+
+    const uLongf expected_size = uncompressed_size;
+    if(uncompress(reinterpret_cast<Bytef*>(&uncompressed_data[0]), &uncompressed_size,
+                  reinterpret_cast<const Bytef*>(data.data() + header_size), data.size() - header_size) != Z_OK ||
+       uncompressed_size != expected_size) {
+        return Option<bool>(400, "Unable to decompress log entry.");
+    }
+
+    return Option<bool>(true);
+}
+
+bool ReplicationState::decode_write_batch(const std::string& data, std::vector<std::string>& serialized_reqs) {
+    if(data.size() < WRITE_BATCH_MAGIC_SIZE || data.compare(0, WRITE_BATCH_MAGIC_SIZE, WRITE_BATCH_MAGIC) != 0) {
+        return false;
+    }
+
+    size_t offset = WRITE_BATCH_MAGIC_SIZE;
+
+    while(offset + sizeof(uint32_t) <= data.size()) {
+        const uint32_t size = StringUtils::deserialize_uint32_t(data.substr(offset, sizeof(uint32_t)));
+        offset += sizeof(uint32_t);
+
+        if(offset + size > data.size()) {
+            return false;
+        }
+
+        serialized_reqs.emplace_back(data, offset, size);
+        offset += size;
+    }
+
+    return offset == data.size();
 }
 
 void ReplicationState::write_to_leader(const std::shared_ptr<http_req>& request, const std::shared_ptr<http_res>& response) {
     // no lock on `node` needed as caller uses the lock
-    if(!node || node->leader_id().is_empty()) {
+    std::string leader_addr;
+
+    if(is_learner()) {
+        std::lock_guard learner_lock(learner_mutex);
+        leader_addr = learner_source;
+    } else if(node && !node->leader_id().is_empty()) {
+        leader_addr = node->leader_id().to_string();
+    }
+
+    if(leader_addr.empty()) {
         // Handle no leader scenario
         LOG(ERROR) << "Rejecting write: could not find a leader.";
 
@@ -345,7 +555,7 @@ void ReplicationState::write_to_leader(const std::shared_ptr<http_req>& request,
 
         response->set_500("Could not find a leader.");
         auto req_res = new async_req_res_t(request, response, true);
-        return message_dispatcher->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+        return get_message_dispatcher(request)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
     }
 
     if (response->proxied_stream) {
@@ -355,7 +565,6 @@ void ReplicationState::write_to_leader(const std::shared_ptr<http_req>& request,
         return ;
     }
 
-    const std::string & leader_addr = node->leader_id().to_string();
     //LOG(INFO) << "Redirecting write to leader at: " << leader_addr;
 
     h2o_custom_generator_t* custom_generator = reinterpret_cast<h2o_custom_generator_t *>(response->generator.load());
@@ -366,60 +575,226 @@ void ReplicationState::write_to_leader(const std::shared_ptr<http_req>& request,
     const std::string& scheme = std::string(raw_req->scheme->name.base, raw_req->scheme->name.len);
     const std::string url = get_node_url_path(leader_addr, path, scheme);
 
+    if(is_batchable_forward(request->http_method, path, request->body)) {
+        std::unique_lock lock(forward_batch_mutex);
+        auto batch_it = forward_batches.find(url);
+
+        if(batch_it != forward_batches.end() && batch_it->second.size() < FORWARD_BATCH_MAX_WRITES) {
+            // goes out with the next batch, once the forward in flight returns
+            batch_it->second.emplace_back(request, response);
+            return ;
+        }
+
+        if(batch_it == forward_batches.end()) {
+            forward_batches.emplace(url, std::vector<std::pair<std::shared_ptr<http_req>, std::shared_ptr<http_res>>>());
+            lock.unlock();
+
+            thread_pool->enqueue([request, response, server, path, url, this]() {
+                forward_write(request, response, server, path, url);
+                forward_write_batches(url, server, path);
+            });
+
+            return ;
+        }
+    }
+
     thread_pool->enqueue([request, response, server, path, url, this]() {
-        pending_writes++;
+        forward_write(request, response, server, path, url);
+    });
+}
 
-        std::map<std::string, std::string> res_headers;
+void ReplicationState::forward_write(const std::shared_ptr<http_req>& request, const std::shared_ptr<http_res>& response,
+                                     HttpServer* server, const std::string& path, const std::string& url) {
+    pending_writes++;
+    const uint64_t start_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    std::map<std::string, std::string> res_headers;
 
-        if(request->http_method == "POST") {
-            std::vector<std::string> path_parts;
-            StringUtils::split(path, path_parts, "/");
+    if(request->http_method == "POST") {
+        std::vector<std::string> path_parts;
+        StringUtils::split(path, path_parts, "/");
 
-            if(path_parts.back().rfind("import", 0) == 0) {
-                // imports are handled asynchronously
-                response->proxied_stream = true;
-                long status = HttpClient::post_response_async(url, request, response, server, true);
+        if(path_parts.back().rfind("import", 0) == 0) {
+            // imports are handled asynchronously
+            response->proxied_stream = true;
+            long status = HttpClient::post_response_async(url, request, response, server, true);
 
-                if(status == 500) {
-                    response->content_type_header = res_headers["content-type"];
-                    response->set_500("");
-                } else {
-                    return ;
-                }
-            } else {
-                std::string api_res;
-                long status = HttpClient::post_response(url, request->body, api_res, res_headers, {}, 0, true);
+            if(status == 500) {
                 response->content_type_header = res_headers["content-type"];
-                response->set_body(status, api_res);
+                response->set_500("");
+            } else {
+                return ;
             }
-        } else if(request->http_method == "PUT") {
-            std::string api_res;
-            long status = HttpClient::put_response(url, request->body, api_res, res_headers, 0, true);
-            response->content_type_header = res_headers["content-type"];
-            response->set_body(status, api_res);
-        } else if(request->http_method == "DELETE") {
-            std::string api_res;
-            // timeout: 0 since delete can take a long time
-            long status = HttpClient::delete_response(url, api_res, res_headers, 0, true);
-            response->content_type_header = res_headers["content-type"];
-            response->set_body(status, api_res);
-        } else if(request->http_method == "PATCH") {
+        } else {
             std::string api_res;
-            route_path* rpath = nullptr;
-            bool route_found = server->get_route(request->route_hash, &rpath);
-            long status = HttpClient::patch_response(url, request->body, api_res, res_headers, 0, true);
+            long status = HttpClient::post_response(url, request->body, api_res, res_headers, {}, 0, true);
             response->content_type_header = res_headers["content-type"];
             response->set_body(status, api_res);
+        }
+    } else if(request->http_method == "PUT") {
+        std::string api_res;
+        long status = HttpClient::put_response(url, request->body, api_res, res_headers, 0, true);
+        response->content_type_header = res_headers["content-type"];
+        response->set_body(status, api_res);
+    } else if(request->http_method == "DELETE") {
+        std::string api_res;
+        // timeout: 0 since delete can take a long time
+        long status = HttpClient::delete_response(url, api_res, res_headers, 0, true);
+        response->content_type_header = res_headers["content-type"];
+        response->set_body(status, api_res);
+    } else if(request->http_method == "PATCH") {
+        std::string api_res;
+        long status = HttpClient::patch_response(url, request->body, api_res, res_headers, 0, true);
+        response->content_type_header = res_headers["content-type"];
+        response->set_body(status, api_res);
+    } else {
+        const std::string& err = "Forwarding for http method not implemented: " + request->http_method;
+        LOG(ERROR) << err;
+        response->set_500(err);
+    }
+
+    const uint64_t end_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    AppMetrics::get_instance().record_forwarded_write(end_us - start_us);
+
+    auto req_res = new async_req_res_t(request, response, true);
+    get_message_dispatcher(request)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+    pending_writes--;
+}
+
+void ReplicationState::forward_write_batches(const std::string& url, HttpServer* server, const std::string& path) {
+    const std::string batch_url = get_forward_batch_url(url);
+
+    while(true) {
+        std::vector<std::pair<std::shared_ptr<http_req>, std::shared_ptr<http_res>>> batch;
+
+        {
+            std::unique_lock lock(forward_batch_mutex);
+            auto batch_it = forward_batches.find(url);
+            if(batch_it->second.empty()) {
+                forward_batches.erase(batch_it);
+                return ;
+            }
+
+            batch = std::move(batch_it->second);
+            batch_it->second.clear();
+        }
+
+        if(batch.size() == 1) {
+            forward_write(batch.front().first, batch.front().second, server, path, url);
+            continue;
+        }
+
+        pending_writes += batch.size();
+        const uint64_t start_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        std::string batch_body;
+        for(const auto& req_res: batch) {
+            if(!batch_body.empty()) {
+                batch_body += '\n';
+            }
+            batch_body += req_res.first->body;
+        }
+
+        std::string api_res;
+        std::map<std::string, std::string> res_headers;
+        long status = HttpClient::post_response(batch_url, batch_body, api_res, res_headers, {}, 0, true);
+
+        std::vector<std::pair<long, std::string>> results;
+        const bool batch_ok = (status == 200 && split_forward_batch_response(api_res, batch.size(), results));
+
+        const uint64_t end_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        for(size_t i = 0; i < batch.size(); i++) {
+            const auto& request = batch[i].first;
+            const auto& response = batch[i].second;
+
+            if(!batch_ok) {
+                // e.g. the collection is missing: the writes are forwarded one by one, so that each of them gets
+                // the very error that it would have got on its own
+                forward_write(request, response, server, path, url);
+                pending_writes--;
+                continue;
+            }
+
+            AppMetrics::get_instance().record_forwarded_write(end_us - start_us);
+            response->content_type_header = "application/json; charset=utf-8";
+            response->set_body(results[i].first, results[i].second);
+
+            auto req_res = new async_req_res_t(request, response, true);
+            get_message_dispatcher(request)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+            pending_writes--;
+        }
+    }
+}
+
+bool ReplicationState::is_batchable_forward(const std::string& method, const std::string& path,
+                                            const std::string& body) {
+    if(method != "POST" || body.empty() || body.find('\n') != std::string::npos ||
+       (body.size() > 1 && 31 == (int)body[0] && -117 == (int)body[1])) {
+        // a gzipped body or one with several lines can't be a line of an import
+        return false;
+    }
+
+    std::vector<std::string> path_parts;
+    StringUtils::split(path.substr(0, path.find('?')), path_parts, "/");
+
+    // POST /collections/:collection/documents
+    return path_parts.size() == 3 && path_parts[0] == "collections" && path_parts[2] == "documents";
+}
+
+std::string ReplicationState::get_forward_batch_url(const std::string& url) {
+    const size_t query_pos = url.find('?');
+    if(query_pos == std::string::npos) {
+        return url + "/import?return_doc=true";
+    }
+
+    // the parameters of a single document write are those of an import as well
+    return url.substr(0, query_pos) + "/import" + url.substr(query_pos) + "&return_doc=true";
+}
+
+bool ReplicationState::split_forward_batch_response(const std::string& import_res, size_t num_writes,
+                                                    std::vector<std::pair<long, std::string>>& results) {
+    std::vector<std::string> lines;
+    StringUtils::split(import_res, lines, "\n");
+
+    if(lines.size() != num_writes) {
+        return false;
+    }
+
+    for(const auto& line: lines) {
+        nlohmann::json result = nlohmann::json::parse(line, nullptr, false);
+        if(!result.is_object() || !result.contains("success")) {
+            return false;
+        }
+
+        if(result["success"].get<bool>()) {
+            nlohmann::json& document = result["document"];
+            Collection::remove_reference_helper_fields(document);
+            results.emplace_back(201, document.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore));
+            continue;
+        }
+
+        // same as the error of a single document write
+        nlohmann::json error_res = nlohmann::json::object();
+        if(result.contains("embedding_error")) {
+            error_res["embedding_error"] = result["embedding_error"];
+        }
+
+        const std::string error = result.value("error", "");
+        if(!error.empty()) {
+            error_res["message"] = error;
         } else {
-            const std::string& err = "Forwarding for http method not implemented: " + request->http_method;
-            LOG(ERROR) << err;
-            response->set_500(err);
+            error_res["error"] = error;
         }
 
-        auto req_res = new async_req_res_t(request, response, true);
-        message_dispatcher->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
-        pending_writes--;
-    });
+        results.emplace_back(result.value("code", 400), error_res.dump());
+    }
+
+    return true;
 }
 
 std::string ReplicationState::get_node_url_path(const std::string& node_addr, const std::string& path,
@@ -442,37 +817,212 @@ void ReplicationState::on_apply(braft::Iterator& iter) {
 
         //LOG(INFO) << "Apply entry";
 
-        const std::shared_ptr<http_req>& request_generated = iter.done() ?
-                         dynamic_cast<ReplicationClosure*>(iter.done())->get_request() : std::make_shared<http_req>();
+        if(config->get_learner_feed_max_bytes() != 0) {
+            record_log_feed_entry(iter.index(), iter.data().to_string());
+        }
 
-        //LOG(INFO) << "Post assignment " << request_generated.get() << ", use count: " << request_generated.use_count();
+        auto batch_closure = iter.done() ? dynamic_cast<WriteBatchClosure*>(iter.done()) : nullptr;
+        if(batch_closure != nullptr) {
+            for(const auto& req_res: batch_closure->get_req_res()) {
+                req_res.first->log_index = iter.index();
+                batched_indexer->enqueue(req_res.first, req_res.second);
+                pending_writes--;
+            }
 
-        const std::shared_ptr<http_res>& response_generated = iter.done() ?
-                dynamic_cast<ReplicationClosure*>(iter.done())->get_response() : std::make_shared<http_res>(nullptr);
+            continue;
+        }
 
         if(!iter.done()) {
             // indicates log serialized request
-            request_generated->load_from_json(iter.data().to_string());
+            enqueue_log_entry(iter.index(), iter.data().to_string());
+            continue;
         }
 
+        const std::shared_ptr<http_req>& request_generated = dynamic_cast<ReplicationClosure*>(iter.done())->get_request();
+
+        //LOG(INFO) << "Post assignment " << request_generated.get() << ", use count: " << request_generated.use_count();
+
+        const std::shared_ptr<http_res>& response_generated = dynamic_cast<ReplicationClosure*>(iter.done())->get_response();
+
         request_generated->log_index = iter.index();
 
         // To avoid blocking the serial Raft write thread persist the log entry in local storage.
         // Actual operations will be done in collection-sharded batch indexing threads.
 
-        batched_indexer->enqueue(request_generated, response_generated);
+        batched_indexer->enqueue(request_generated, response_generated);
+
+        pending_writes--;
+        //LOG(INFO) << "pending_writes: " << pending_writes;
+    }
+}
+
+void ReplicationState::enqueue_log_entry(const int64_t index, const std::string& data) {
+    const std::string* entry_data = &data;
+
+    std::string uncompressed_data;
+    auto decompress_op = decompress_log_entry(data, uncompressed_data);
+    if(!decompress_op.ok()) {
+        LOG(ERROR) << "Skipping log entry at index " << index << ": " << decompress_op.error();
+        return ;
+    }
+
+    if(decompress_op.get()) {
+        entry_data = &uncompressed_data;
+    }
+
+    std::vector<std::string> serialized_reqs;
+    if(decode_write_batch(*entry_data, serialized_reqs)) {
+        // writes coalesced by the leader share the index of their log entry
+        for(const auto& serialized_req: serialized_reqs) {
+            auto request = std::make_shared<http_req>();
+            request->load_from_json(serialized_req);
+            request->log_index = index;
+            batched_indexer->enqueue(request, std::make_shared<http_res>(nullptr));
+        }
+
+        return ;
+    }
+
+    auto request = std::make_shared<http_req>();
+    request->load_from_json(*entry_data);
+    request->log_index = index;
+    batched_indexer->enqueue(request, std::make_shared<http_res>(nullptr));
+}
+
+void ReplicationState::record_log_feed_entry(const int64_t index, std::string&& data) {
+    std::lock_guard lock(log_feed_mutex);
+
+    if(log_feed_first_index == 0 || index <= log_feed_last_index) {
+        // first entry, or the log was replayed from a snapshot that was loaded
+        log_feed.clear();
+        log_feed_bytes = 0;
+        log_feed_first_index = index;
+    }
+
+    log_feed_bytes += data.size();
+    log_feed.emplace_back(index, std::move(data));
+    log_feed_last_index = index;
+
+    while(log_feed_bytes > config->get_learner_feed_max_bytes() && log_feed.size() > 1) {
+        log_feed_bytes -= log_feed.front().second.size();
+        log_feed.pop_front();
+        log_feed_first_index = log_feed.front().first;
+    }
+
+    log_feed_cv.notify_all();
+}
+
+bool ReplicationState::log_feed_has_gap(const int64_t after_index, const int64_t known_applied_index) const {
+    // nothing was applied since the node started or loaded a snapshot
+    return (log_feed_first_index == 0) ? (after_index < known_applied_index) : (after_index + 1 < log_feed_first_index);
+}
+
+void ReplicationState::get_log_feed_entries(const int64_t after_index, const size_t max_bytes,
+                                            std::vector<std::pair<int64_t, std::string>>& entries) const {
+    auto entry_it = std::upper_bound(log_feed.begin(), log_feed.end(), after_index,
+                                     [](int64_t index, const std::pair<int64_t, std::string>& entry) {
+                                         return index < entry.first;
+                                     });
+
+    size_t num_bytes = 0;
+
+    while(entry_it != log_feed.end() && (entries.empty() || num_bytes + entry_it->second.size() <= max_bytes)) {
+        num_bytes += entry_it->second.size();
+        entries.push_back(*entry_it);
+        ++entry_it;
+    }
+}
+
+Option<bool> ReplicationState::wait_for_read_index(const uint64_t timeout_ms, const std::string& collection) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    std::shared_lock lock(node_mutex);
+    if(node == nullptr) {
+        return Option<bool>(503, "Not Ready or Lagging");
+    }
+
+    int64_t read_index = 0;
+
+    if(node->is_leader()) {
+        braft::NodeStatus n_status;
+        node->get_status(&n_status);
+        lock.unlock();
+        read_index = n_status.committed_index;
+    } else {
+        if(node->leader_id().is_empty()) {
+            return Option<bool>(503, "Could not find a leader to serve a strong read.");
+        }
+
+        const std::string leader_addr = node->leader_id().to_string();
+        lock.unlock();
+
+        const std::string protocol = api_uses_ssl ? "https" : "http";
+        std::string url = get_node_url_path(leader_addr, "/status", protocol);
+
+        std::string api_res;
+        std::map<std::string, std::string> res_headers;
+        long status_code = HttpClient::get_response(url, api_res, res_headers, {}, timeout_ms, true);
+
+        nlohmann::json leader_status = nlohmann::json::parse(api_res, nullptr, false);
+        if(status_code != 200 || leader_status.is_discarded() || !leader_status.is_object() ||
+           leader_status.value("state", "") != "LEADER" || !leader_status.contains("committed_index")) {
+            LOG(ERROR) << "Could not get the committed index of the leader for a strong read, status code: "
+                       << status_code;
+            return Option<bool>(503, "Could not get the committed index of the leader for a strong read.");
+        }
+
+        read_index = leader_status["committed_index"].get<int64_t>();
+    }
+
+    while(true) {
+        lock.lock();
+        if(node == nullptr) {
+            return Option<bool>(503, "Not Ready or Lagging");
+        }
+
+        braft::NodeStatus n_status;
+        node->get_status(&n_status);
+        lock.unlock();
+
+        if(n_status.known_applied_index >= read_index) {
+            break;
+        }
 
-        if(iter.done()) {
-            pending_writes--;
-            //LOG(INFO) << "pending_writes: " << pending_writes;
+        if(std::chrono::steady_clock::now() >= deadline) {
+            return Option<bool>(503, "Timed out waiting to catch up with the leader for a strong read.");
         }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(READ_INDEX_POLL_INTERVAL_MS));
     }
+
+    // applied entries are indexed by the batched indexer, in parallel across the collections
+    const auto now = std::chrono::steady_clock::now();
+    const uint64_t remaining_ms = (now >= deadline) ? 0 :
+                                  std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+
+    if(!batched_indexer->wait_until_indexed(read_index, remaining_ms, collection)) {
+        return Option<bool>(503, "Timed out waiting to catch up with the leader for a strong read.");
+    }
+
+    return Option<bool>(true);
 }
 
-void ReplicationState::read(const std::shared_ptr<http_res>& response) {
-    // NOT USED:
-    // For consistency, reads to followers could be rejected.
-    // Currently, we don't do implement reads via raft.
+// SST files are given a checksum of their identity, so that a follower that installs the snapshot copies only the
+// files that it doesn't already have in its last snapshot, or in the partial copy of an interrupted download. Other
+// files change between snapshots and are always copied.
+static int add_db_snapshot_file(braft::SnapshotWriter* writer, const std::string& file_name,
+                                const butil::FilePath& file, const std::map<std::string, std::string>& sst_file_ids) {
+    const std::string base_name = file.BaseName().value();
+    auto file_id_it = sst_file_ids.find(base_name);
+    int64_t file_size = 0;
+
+    if(file_id_it == sst_file_ids.end() || !butil::GetFileSize(file, &file_size)) {
+        return writer->add_file(file_name);
+    }
+
+    braft::LocalFileMeta file_meta;
+    file_meta.set_checksum("sst:" + file_id_it->second + ":" + base_name + ":" + std::to_string(file_size));
+    return writer->add_file(file_name, &file_meta);
 }
 
 void* ReplicationState::save_snapshot(void* arg) {
@@ -486,7 +1036,7 @@ void* ReplicationState::save_snapshot(void* arg) {
 
     for (butil::FilePath file = dir_enum.Next(); !file.empty(); file = dir_enum.Next()) {
         std::string file_name = std::string(db_snapshot_name) + "/" + file.BaseName().value();
-        if (sa->writer->add_file(file_name) != 0) {
+        if (add_db_snapshot_file(sa->writer, file_name, file, sa->db_sst_file_ids) != 0) {
             sa->done->status().set_error(EIO, "Fail to add file to writer.");
             sa->replication_state->snapshot_in_progress = false;
             return nullptr;
@@ -499,7 +1049,7 @@ void* ReplicationState::save_snapshot(void* arg) {
                                                  butil::FileEnumerator::FILES);
         for (butil::FilePath file = analytics_dir_enum.Next(); !file.empty(); file = analytics_dir_enum.Next()) {
             auto file_name = std::string(analytics_db_snapshot_name) + "/" + file.BaseName().value();
-            if (sa->writer->add_file(file_name) != 0) {
+            if (add_db_snapshot_file(sa->writer, file_name, file, sa->analytics_db_sst_file_ids) != 0) {
                 sa->done->status().set_error(EIO, "Fail to add analytics file to writer.");
                 sa->replication_state->snapshot_in_progress = false;
                 return nullptr;
@@ -507,6 +1057,19 @@ void* ReplicationState::save_snapshot(void* arg) {
         }
     }
 
+    if(!sa->index_image_path.empty()) {
+        butil::FileEnumerator image_dir_enum(butil::FilePath(sa->index_image_path), false,
+                                             butil::FileEnumerator::FILES);
+        for (butil::FilePath file = image_dir_enum.Next(); !file.empty(); file = image_dir_enum.Next()) {
+            auto file_name = std::string(index_image_name) + "/" + file.BaseName().value();
+            if (sa->writer->add_file(file_name) != 0) {
+                sa->done->status().set_error(EIO, "Fail to add index image file to writer.");
+                sa->replication_state->snapshot_in_progress = false;
+                return nullptr;
+            }
+        }
+    }
+
     const std::string& temp_snapshot_dir = sa->writer->get_path();
 
     sa->done->Run();
@@ -555,6 +1118,9 @@ void ReplicationState::on_snapshot_save(braft::SnapshotWriter* writer, braft::Cl
     snapshot_in_progress = true;
     std::string db_snapshot_path = writer->get_path() + "/" + db_snapshot_name;
     std::string analytics_db_snapshot_path = writer->get_path() + "/" + analytics_db_snapshot_name;
+    std::string index_image_path;
+    std::map<std::string, std::string> db_sst_file_ids;
+    std::map<std::string, std::string> analytics_db_sst_file_ids;
 
     {
         // grab batch indexer lock so that we can take a clean snapshot
@@ -578,6 +1144,9 @@ void ReplicationState::on_snapshot_save(braft::SnapshotWriter* writer, braft::Cl
             done->status().set_error(EIO, "Checkpoint creation failure.");
         }
 
+        // files of the checkpoint that are compacted away before this are left without an identity
+        store->get_sst_file_ids(db_sst_file_ids);
+
         if(analytics_store) {
             analytics_store->insert(BATCHED_INDEXER_STATE_KEY, batch_index_state.dump());
             rocksdb::Checkpoint* checkpoint2 = nullptr;
@@ -588,6 +1157,20 @@ void ReplicationState::on_snapshot_save(braft::SnapshotWriter* writer, braft::Cl
                 LOG(ERROR) << "AnalyticsStore : Failure during checkpoint creation, msg:" << status.ToString();
                 done->status().set_error(EIO, "AnalyticsStore : Checkpoint creation failure.");
             }
+
+            analytics_store->get_sst_file_ids(analytics_db_sst_file_ids);
+        }
+
+        if(config->get_enable_index_image()) {
+            // image must be written while writes are paused so that it matches the checkpoint exactly
+            index_image_path = writer->get_path() + "/" + index_image_name;
+            auto image_op = CollectionManager::get_instance().save_index_images(index_image_path);
+            if(!image_op.ok()) {
+                // an incomplete image is not fatal: collections are then rebuilt from the store
+                LOG(ERROR) << "Failure during index image creation, msg: " << image_op.error();
+                delete_path(index_image_path);
+                index_image_path.clear();
+            }
         }
     }
 
@@ -596,12 +1179,16 @@ void ReplicationState::on_snapshot_save(braft::SnapshotWriter* writer, braft::Cl
     arg->writer = writer;
     arg->state_dir_path = raft_dir_path;
     arg->db_snapshot_path = db_snapshot_path;
+    arg->db_sst_file_ids = std::move(db_sst_file_ids);
     arg->done = done;
 
     if(analytics_store) {
         arg->analytics_db_snapshot_path = analytics_db_snapshot_path;
+        arg->analytics_db_sst_file_ids = std::move(analytics_db_sst_file_ids);
     }
 
+    arg->index_image_path = index_image_path;
+
     if(!ext_snapshot_path.empty()) {
         arg->ext_snapshot_path = ext_snapshot_path;
         ext_snapshot_path = "";
@@ -646,12 +1233,24 @@ int ReplicationState::on_snapshot_load(braft::SnapshotReader* reader) {
 
     LOG(INFO) << "on_snapshot_load";
 
+    {
+        // entries up to the snapshot are not applied by this node, so the feed has to start after it
+        std::lock_guard feed_lock(log_feed_mutex);
+        log_feed.clear();
+        log_feed_bytes = 0;
+        log_feed_first_index = 0;
+    }
+
+    // Load snapshot from leader, replacing the running StateMachine
+    return load_snapshot(reader->get_path());
+}
+
+int ReplicationState::load_snapshot(const std::string& snapshot_dir_path) {
     // ensures that reads and writes are rejected, as `store->reload()` unique locks the DB handle
     read_caught_up = false;
     write_caught_up = false;
 
-    // Load snapshot from leader, replacing the running StateMachine
-    std::string snapshot_path = reader->get_path();
+    std::string snapshot_path = snapshot_dir_path;
 
     if(analytics_store) {
         snapshot_path.append(std::string("/") + analytics_db_snapshot_name);
@@ -662,7 +1261,7 @@ int ReplicationState::on_snapshot_load(braft::SnapshotReader* reader) {
         }
     }
 
-    snapshot_path = reader->get_path();
+    snapshot_path = snapshot_dir_path;
     snapshot_path.append(std::string("/") + db_snapshot_name);
 
     int reload_store = store->reload(true, snapshot_path);
@@ -670,7 +1269,14 @@ int ReplicationState::on_snapshot_load(braft::SnapshotReader* reader) {
         return reload_store;
     }
 
+    // index images are taken along with the db checkpoint, so they can be used to skip parts of the rebuild
+    const std::string& index_image_path = snapshot_dir_path + "/" + index_image_name;
+    if(directory_exists(index_image_path)) {
+        CollectionManager::get_instance().set_index_image_dir(index_image_path);
+    }
+
     bool init_db_status = init_db();
+    CollectionManager::get_instance().set_index_image_dir("");
 
     return init_db_status;
 }
@@ -832,12 +1438,11 @@ void ReplicationState::refresh_catchup_status(bool log_msg) {
 
 ReplicationState::ReplicationState(HttpServer* server, BatchedIndexer* batched_indexer,
                                    Store *store, Store* analytics_store, ThreadPool* thread_pool,
-                                   http_message_dispatcher *message_dispatcher,
                                    bool api_uses_ssl, const Config* config,
                                    size_t num_collections_parallel_load, size_t num_documents_parallel_load):
         node(nullptr), leader_term(-1), server(server), batched_indexer(batched_indexer),
         store(store), analytics_store(analytics_store),
-        thread_pool(thread_pool), message_dispatcher(message_dispatcher), api_uses_ssl(api_uses_ssl),
+        thread_pool(thread_pool), api_uses_ssl(api_uses_ssl),
         config(config),
         num_collections_parallel_load(num_collections_parallel_load),
         num_documents_parallel_load(num_documents_parallel_load),
@@ -847,9 +1452,492 @@ ReplicationState::ReplicationState(HttpServer* server, BatchedIndexer* batched_i
 
 }
 
+std::string ReplicationState::encode_log_feed(const int64_t committed_index,
+                                              const std::vector<std::pair<int64_t, std::string>>& entries) {
+    size_t size = sizeof(uint64_t);
+    for(const auto& entry: entries) {
+        size += sizeof(uint64_t) + sizeof(uint32_t) + entry.second.size();
+    }
+
+    std::string feed;
+    feed.reserve(size);
+    feed += StringUtils::serialize_uint64_t(committed_index);
+
+    for(const auto& entry: entries) {
+        feed += StringUtils::serialize_uint64_t(entry.first);
+        feed += StringUtils::serialize_uint32_t(entry.second.size());
+        feed += entry.second;
+    }
+
+    return feed;
+}
+
+static int64_t deserialize_int64_t(const std::string& data, size_t offset) {
+    const uint64_t high = StringUtils::deserialize_uint32_t(data.substr(offset, sizeof(uint32_t)));
+    const uint64_t low = StringUtils::deserialize_uint32_t(data.substr(offset + sizeof(uint32_t), sizeof(uint32_t)));
+    return int64_t((high << 32) | low);
+}
+
+bool ReplicationState::decode_log_feed(const std::string& feed, int64_t& committed_index,
+                                       std::vector<std::pair<int64_t, std::string>>& entries) {
+    if(feed.size() < sizeof(uint64_t)) {
+        return false;
+    }
+
+    committed_index = deserialize_int64_t(feed, 0);
+    size_t offset = sizeof(uint64_t);
+
+    while(offset + sizeof(uint64_t) + sizeof(uint32_t) <= feed.size()) {
+        const int64_t index = deserialize_int64_t(feed, offset);
+        offset += sizeof(uint64_t);
+
+        const uint32_t size = StringUtils::deserialize_uint32_t(feed.substr(offset, sizeof(uint32_t)));
+        offset += sizeof(uint32_t);
+
+        if(offset + size > feed.size()) {
+            return false;
+        }
+
+        entries.emplace_back(index, feed.substr(offset, size));
+        offset += size;
+    }
+
+    return offset == feed.size();
+}
+
+Option<bool> ReplicationState::get_learner_log_entries(const int64_t after_index, std::string& feed) {
+    if(config->get_learner_feed_max_bytes() == 0) {
+        return Option<bool>(503, "Learners are not served by this node: `learner-feed-max-bytes` is not set.");
+    }
+
+    std::shared_lock lock(node_mutex);
+    if(node == nullptr) {
+        return Option<bool>(503, "Not Ready or Lagging");
+    }
+
+    braft::NodeStatus n_status;
+    node->get_status(&n_status);
+    lock.unlock();
+
+    std::vector<std::pair<int64_t, std::string>> entries;
+
+    {
+        std::lock_guard feed_lock(log_feed_mutex);
+
+        if(log_feed_has_gap(after_index, n_status.known_applied_index)) {
+            return Option<bool>(409, "Entries after index " + std::to_string(after_index) +
+                                     " are no longer kept: the learner has to bootstrap from a snapshot.");
+        }
+
+        get_log_feed_entries(after_index, LEARNER_PULL_MAX_BYTES, entries);
+    }
+
+    feed = encode_log_feed(n_status.committed_index, entries);
+    return Option<bool>(true);
+}
+
+Option<nlohmann::json> ReplicationState::get_changes(const int64_t after_index, const uint64_t wait_ms) {
+    if(config->get_learner_feed_max_bytes() == 0) {
+        return Option<nlohmann::json>(503, "Changes are not served by this node: `learner-feed-max-bytes` is "
+                                           "not set.");
+    }
+
+    std::shared_lock lock(node_mutex);
+    if(node == nullptr) {
+        return Option<nlohmann::json>(503, "Not Ready or Lagging");
+    }
+
+    braft::NodeStatus n_status;
+    node->get_status(&n_status);
+    lock.unlock();
+
+    std::vector<std::pair<int64_t, std::string>> entries;
+
+    {
+        std::unique_lock feed_lock(log_feed_mutex);
+
+        log_feed_cv.wait_for(feed_lock, std::chrono::milliseconds(std::min(wait_ms, CHANGES_MAX_WAIT_MS)), [&]() {
+            return shutting_down || log_feed_last_index > after_index;
+        });
+
+        if(log_feed_has_gap(after_index, n_status.known_applied_index)) {
+            return Option<nlohmann::json>(409, "Changes after index " + std::to_string(after_index) +
+                                               " are no longer kept: the cluster has to be synced again.");
+        }
+
+        get_log_feed_entries(after_index, LEARNER_PULL_MAX_BYTES, entries);
+    }
+
+    nlohmann::json result;
+    result["changes"] = nlohmann::json::array();
+    result["last_index"] = entries.empty() ? after_index : entries.back().first;
+
+    for(const auto& entry: entries) {
+        append_changes(entry.first, entry.second, result["changes"]);
+    }
+
+    return Option<nlohmann::json>(result);
+}
+
+void ReplicationState::append_changes(const int64_t index, const std::string& data, nlohmann::json& changes) {
+    const std::string* entry_data = &data;
+
+    std::string uncompressed_data;
+    auto decompress_op = decompress_log_entry(data, uncompressed_data);
+    if(!decompress_op.ok()) {
+        LOG(ERROR) << "Skipping log entry at index " << index << ": " << decompress_op.error();
+        return ;
+    }
+
+    if(decompress_op.get()) {
+        entry_data = &uncompressed_data;
+    }
+
+    std::vector<std::string> serialized_reqs;
+    if(!decode_write_batch(*entry_data, serialized_reqs)) {
+        serialized_reqs.push_back(*entry_data);
+    }
+
+    for(const auto& serialized_req: serialized_reqs) {
+        nlohmann::json content = nlohmann::json::parse(serialized_req, nullptr, false);
+        if(content.is_discarded() || !content.is_object() || !content.contains("route_hash")) {
+            LOG(ERROR) << "Skipping a write of the log entry at index " << index << ": it could not be parsed.";
+            continue;
+        }
+
+        route_path* rpath = nullptr;
+        if(!server->get_route(content["route_hash"].get<uint64_t>(), &rpath)) {
+            LOG(ERROR) << "Skipping a write of the log entry at index " << index << ": its route was not found.";
+            continue;
+        }
+
+        nlohmann::json params = content.value("params", nlohmann::json::object());
+        params.erase(http_req::AUTH_HEADER);
+
+        // path parameters are kept among the parameters of the request
+        std::string path;
+        for(const auto& path_part: rpath->path_parts) {
+            if(!path_part.empty() && path_part[0] == ':') {
+                path += "/" + params.value(path_part.substr(1), std::string());
+                params.erase(path_part.substr(1));
+            } else {
+                path += "/" + path_part;
+            }
+        }
+
+        nlohmann::json change;
+        change["index"] = index;
+        change["method"] = rpath->http_method;
+        change["path"] = path;
+        change["params"] = params;
+        change["body"] = content.value("body", std::string());
+        change["request_id"] = content.value("start_ts", uint64_t(0));
+        change["first_chunk"] = content.value("first_chunk_aggregate", true);
+        change["last_chunk"] = content.value("last_chunk_aggregate", false);
+        changes.push_back(std::move(change));
+    }
+}
+
+// name of the latest snapshot in `snapshot_dir`, which braft names after the index of its last entry
+static std::string get_latest_snapshot_name(const std::string& snapshot_dir, int64_t& snapshot_index) {
+    std::string latest_name;
+    snapshot_index = 0;
+
+    std::error_code ec;
+    for(const auto& entry: std::filesystem::directory_iterator(snapshot_dir, ec)) {
+        const std::string name = entry.path().filename().string();
+        const std::string prefix = "snapshot_";
+
+        if(!entry.is_directory() || name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+           !StringUtils::is_uint64_t(name.substr(prefix.size()))) {
+            continue;
+        }
+
+        const int64_t index = std::stoll(name.substr(prefix.size()));
+        if(index > snapshot_index) {
+            snapshot_index = index;
+            latest_name = name;
+        }
+    }
+
+    return latest_name;
+}
+
+Option<nlohmann::json> ReplicationState::get_learner_snapshot_manifest() {
+    if(config->get_learner_feed_max_bytes() == 0) {
+        return Option<nlohmann::json>(503, "Learners are not served by this node: `learner-feed-max-bytes` is "
+                                           "not set.");
+    }
+
+    std::shared_lock lock(node_mutex);
+    if(node == nullptr) {
+        return Option<nlohmann::json>(503, "Not Ready or Lagging");
+    }
+
+    braft::NodeStatus n_status;
+    node->get_status(&n_status);
+    lock.unlock();
+
+    const std::string snapshot_dir = raft_dir_path + "/" + snapshot_dir_name;
+    int64_t snapshot_index = 0;
+    const std::string snapshot_name = get_latest_snapshot_name(snapshot_dir, snapshot_index);
+
+    bool is_followed_by_feed;
+
+    {
+        std::lock_guard feed_lock(log_feed_mutex);
+        is_followed_by_feed = (log_feed_first_index == 0) ? (snapshot_index >= n_status.known_applied_index) :
+                              (snapshot_index + 1 >= log_feed_first_index);
+    }
+
+    if(snapshot_name.empty() || !is_followed_by_feed) {
+        // the entries after the latest snapshot are no longer kept, so a new one is taken for the learner
+        const auto current_ts = std::time(nullptr);
+        if(!snapshot_in_progress && current_ts - last_snapshot_ts >= LEARNER_SNAPSHOT_MIN_INTERVAL_S) {
+            LOG(INFO) << "Triggering a snapshot for a learner, latest snapshot index: " << snapshot_index;
+            last_snapshot_ts = current_ts;
+            lock.lock();
+            if(node != nullptr) {
+                node->snapshot(new TimedSnapshotClosure(this));
+            }
+        }
+
+        return Option<nlohmann::json>(503, "A snapshot is being taken for the learner.");
+    }
+
+    nlohmann::json manifest;
+    manifest["name"] = snapshot_name;
+    manifest["index"] = snapshot_index;
+    manifest["files"] = nlohmann::json::array();
+
+    const std::filesystem::path snapshot_path = snapshot_dir + "/" + snapshot_name;
+    std::error_code ec;
+
+    for(const auto& entry: std::filesystem::recursive_directory_iterator(snapshot_path, ec)) {
+        if(!entry.is_regular_file()) {
+            continue;
+        }
+
+        nlohmann::json file;
+        file["path"] = std::filesystem::relative(entry.path(), snapshot_path).string();
+        file["size"] = entry.file_size();
+        manifest["files"].push_back(file);
+    }
+
+    if(ec) {
+        return Option<nlohmann::json>(500, "Could not list the files of snapshot " + snapshot_name + ": " +
+                                           ec.message());
+    }
+
+    return Option<nlohmann::json>(manifest);
+}
+
+Option<bool> ReplicationState::read_learner_snapshot_file(const std::string& snapshot_name,
+                                                          const std::string& file_path, const size_t offset,
+                                                          std::string& chunk) {
+    // only the files of a snapshot can be read
+    const bool is_snapshot_name = snapshot_name.rfind("snapshot_", 0) == 0 &&
+                                  snapshot_name.find('/') == std::string::npos && snapshot_name.find("..") == std::string::npos;
+    const bool is_relative_path = !file_path.empty() && file_path[0] != '/' &&
+                                  file_path.find("..") == std::string::npos;
+
+    if(!is_snapshot_name || !is_relative_path) {
+        return Option<bool>(400, "Invalid snapshot file.");
+    }
+
+    const std::string path = raft_dir_path + "/" + snapshot_dir_name + "/" + snapshot_name + "/" + file_path;
+    std::ifstream file(path, std::ios::binary);
+
+    if(!file.is_open()) {
+        // the snapshot was replaced by a newer one
+        return Option<bool>(404, "Snapshot file not found.");
+    }
+
+    file.seekg(offset);
+    chunk.resize(LEARNER_SNAPSHOT_CHUNK_BYTES);
+    file.read(&chunk[0], chunk.size());
+    chunk.resize(file.gcount());
+
+    return Option<bool>(true);
+}
+
+int ReplicationState::start_learner(const std::string& raft_dir) {
+    this->raft_dir_path = raft_dir;
+    this->read_caught_up = false;
+    this->write_caught_up = false;
+
+    // the state of a learner is not kept across restarts: it bootstraps from a snapshot of a voter again
+    int reload_store = store->reload(true, "");
+    if(reload_store != 0) {
+        return reload_store;
+    }
+
+    return init_db();
+}
+
+Option<bool> ReplicationState::bootstrap_learner(const std::string& source_addr) {
+    const std::string protocol = api_uses_ssl ? "https" : "http";
+
+    std::string api_res;
+    std::map<std::string, std::string> res_headers;
+    long status_code = HttpClient::get_response(get_node_url_path(source_addr, "/replication/snapshot", protocol),
+                                                api_res, res_headers, {}, 10*1000, true);
+
+    nlohmann::json manifest = nlohmann::json::parse(api_res, nullptr, false);
+    if(status_code != 200 || manifest.is_discarded() || !manifest.is_object() ||
+       !manifest.contains("name") || !manifest.contains("index") || !manifest["files"].is_array()) {
+        return Option<bool>(status_code == 503 ? 503 : 500, "Could not get a snapshot from " + source_addr +
+                                                            ", status code: " + std::to_string(status_code));
+    }
+
+    const std::string snapshot_name = manifest["name"].get<std::string>();
+    const std::string learner_snapshot_dir = raft_dir_path + "/" + learner_snapshot_dir_name;
+    LOG(INFO) << "Learner is downloading snapshot " << snapshot_name << " from " << source_addr;
+
+    delete_path(learner_snapshot_dir);
+
+    for(const auto& file: manifest["files"]) {
+        const std::string file_path = file["path"].get<std::string>();
+        const size_t file_size = file["size"].get<size_t>();
+        const std::filesystem::path local_path = learner_snapshot_dir + "/" + file_path;
+
+        std::error_code ec;
+        std::filesystem::create_directories(local_path.parent_path(), ec);
+        std::ofstream out(local_path, std::ios::binary | std::ios::trunc);
+
+        size_t offset = 0;
+
+        do {
+            const std::string path = "/replication/snapshot/file?name=" + snapshot_name + "&path=" + file_path +
+                                     "&offset=" + std::to_string(offset);
+            std::string chunk;
+            status_code = HttpClient::get_response(get_node_url_path(source_addr, path, protocol), chunk,
+                                                   res_headers, {}, 60*1000, true);
+
+            if(status_code != 200 || (chunk.empty() && offset < file_size) || shutting_down) {
+                return Option<bool>(500, "Could not download " + file_path + " of snapshot " + snapshot_name +
+                                         ", status code: " + std::to_string(status_code));
+            }
+
+            out.write(chunk.data(), chunk.size());
+            offset += chunk.size();
+        } while(offset < file_size);
+
+        if(!out.good()) {
+            return Option<bool>(500, "Could not write " + local_path.string());
+        }
+    }
+
+    LOG(INFO) << "Learner is loading snapshot " << snapshot_name;
+
+    if(load_snapshot(learner_snapshot_dir) != 0) {
+        return Option<bool>(500, "Could not load snapshot " + snapshot_name);
+    }
+
+    learner_applied_index = manifest["index"].get<int64_t>();
+    LOG(INFO) << "Learner loaded snapshot " << snapshot_name << ", index: " << learner_applied_index;
+
+    return Option<bool>(true);
+}
+
+void ReplicationState::follow_voters(const std::string& nodes) {
+    std::vector<std::string> voters;
+    StringUtils::split(nodes, voters, ",");
+
+    if(voters.empty()) {
+        read_caught_up = false;
+        return ;
+    }
+
+    std::string source_addr;
+
+    {
+        std::lock_guard lock(learner_mutex);
+        if(std::find(voters.begin(), voters.end(), learner_source) == voters.end()) {
+            learner_source = voters[learner_source_pos++ % voters.size()];
+            LOG(INFO) << "Learner is following " << learner_source;
+        }
+
+        source_addr = learner_source;
+    }
+
+    auto switch_source = [&]() {
+        std::lock_guard lock(learner_mutex);
+        learner_source.clear();
+    };
+
+    if(learner_applied_index == 0) {
+        read_caught_up = false;
+        auto bootstrap_op = bootstrap_learner(source_addr);
+
+        if(!bootstrap_op.ok()) {
+            LOG(ERROR) << bootstrap_op.error();
+            if(bootstrap_op.code() != 503) {
+                switch_source();
+            }
+
+            return ;
+        }
+    }
+
+    const std::string protocol = api_uses_ssl ? "https" : "http";
+
+    while(!shutting_down) {
+        const std::string path = "/replication/log?after_index=" + std::to_string(learner_applied_index);
+        std::string feed;
+        std::map<std::string, std::string> res_headers;
+        long status_code = HttpClient::get_response(get_node_url_path(source_addr, path, protocol), feed,
+                                                    res_headers, {}, 10*1000, true);
+
+        if(status_code == 409) {
+            LOG(WARNING) << "Learner fell behind the entries kept by " << source_addr << ", bootstrapping again.";
+            learner_applied_index = 0;
+            read_caught_up = false;
+            return ;
+        }
+
+        int64_t committed_index = 0;
+        std::vector<std::pair<int64_t, std::string>> entries;
+
+        if(status_code != 200 || !decode_log_feed(feed, committed_index, entries)) {
+            LOG(ERROR) << "Learner could not pull entries from " << source_addr << ", status code: " << status_code;
+            read_caught_up = write_caught_up = false;
+            switch_source();
+            return ;
+        }
+
+        for(const auto& entry: entries) {
+            enqueue_log_entry(entry.first, entry.second);
+            learner_applied_index = entry.first;
+        }
+
+        // writes are forwarded to the voter
+        write_caught_up = true;
+
+        // lag behind the voter, in addition to the writes that are queued for indexing, as on a follower
+        learner_lag = std::max<int64_t>(0, committed_index - learner_applied_index);
+        const int64_t healthy_read_lag = config->get_healthy_read_lag();
+        read_caught_up = learner_lag <= healthy_read_lag && batched_indexer->get_queued_writes() <= healthy_read_lag;
+
+        if(entries.empty() || feed.size() < LEARNER_PULL_MAX_BYTES / 2) {
+            // caught up with the voter
+            break;
+        }
+    }
+}
+
 bool ReplicationState::is_alive() const {
-    // for general health check we will only care about the `read_caught_up` threshold
-    return read_caught_up;
+    // for general health check we will only care about the `read_caught_up` threshold and the warm-up that follows it
+    return read_caught_up && SearchWarmup::get_instance().is_done();
+}
+
+bool ReplicationState::is_collection_read_ready(const std::string& collection_name) const {
+    if(read_caught_up) {
+        return true;
+    }
+
+    auto& cm = CollectionManager::get_instance();
+    return cm.is_loading_collections() && cm.is_collection_loaded(collection_name);
 }
 
 uint64_t ReplicationState::node_state() const {
@@ -870,14 +1958,14 @@ void ReplicationState::do_snapshot(const std::string& snapshot_path, const std::
     if(node == nullptr) {
         res->set_500("Could not trigger a snapshot, as node is not initialized.");
         auto req_res = new async_req_res_t(req, res, true);
-        get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+        get_message_dispatcher(req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
         return ;
     }
 
     if(snapshot_in_progress) {
         res->set_409("Another snapshot is in progress.");
         auto req_res = new async_req_res_t(req, res, true);
-        get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+        get_message_dispatcher(req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
         return ;
     }
 
@@ -961,8 +2049,8 @@ bool ReplicationState::reset_peers() {
     return false;
 }
 
-http_message_dispatcher* ReplicationState::get_message_dispatcher() const {
-    return message_dispatcher;
+http_message_dispatcher* ReplicationState::get_message_dispatcher(const std::shared_ptr<http_req>& req) const {
+    return server->get_message_dispatcher(req);
 }
 
 Store* ReplicationState::get_store() {
@@ -980,6 +2068,16 @@ void ReplicationState::shutdown() {
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
     }
 
+    if(write_batch_thread.joinable()) {
+        {
+            std::lock_guard batch_lock(write_batch_mutex);
+            write_batch_quit = true;
+        }
+
+        write_batch_cv.notify_one();
+        write_batch_thread.join();
+    }
+
     LOG(INFO) << "Replication state shutdown, store sequence: " << store->get_latest_seq_number();
     std::unique_lock lock(node_mutex);
 
@@ -1011,6 +2109,10 @@ int64_t ReplicationState::get_num_queued_writes() {
     return batched_indexer->get_queued_writes();
 }
 
+void ReplicationState::get_num_queued_writes(nlohmann::json& coll_queue_stats) {
+    batched_indexer->get_queued_writes(coll_queue_stats);
+}
+
 bool ReplicationState::is_leader() {
     std::shared_lock lock(node_mutex);
 
@@ -1024,6 +2126,14 @@ bool ReplicationState::is_leader() {
 nlohmann::json ReplicationState::get_status() {
     nlohmann::json status;
 
+    if(is_learner()) {
+        status["state"] = "LEARNER";
+        status["committed_index"] = learner_applied_index.load();
+        status["queued_writes"] = batched_indexer->get_queued_writes();
+        status["replication_lag"] = learner_lag.load();
+        return status;
+    }
+
     std::shared_lock lock(node_mutex);
     if(!node) {
         // `node` is not yet initialized (probably loading snapshot)
@@ -1178,7 +2288,7 @@ void OnDemandSnapshotClosure::Run() {
     res->body = response.dump();
 
     auto req_res = new async_req_res_t(req, res, true);
-    replication_state->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
+    replication_state->get_message_dispatcher(req)->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, req_res);
 
     // wait for response to be sent
     res->wait();
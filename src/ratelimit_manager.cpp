@@ -1,6 +1,7 @@
 #include "ratelimit_manager.h"
 #include "string_utils.h"
 #include "logger.h"
+#include <algorithm>
 #include <iterator>
 
 RateLimitManager * RateLimitManager::getInstance() {
@@ -17,39 +18,39 @@ void RateLimitManager::temp_ban_entity(const rate_limit_entity_t& entity, const
 }
 
 bool RateLimitManager::is_rate_limited(const rate_limit_entity_t& api_key_entity, const rate_limit_entity_t& ip_entity) {
-    // lock mutex
-    std::unique_lock<std::shared_mutex>lock(rate_limit_mutex);
-    std::vector<rate_limit_rule_t*> rules_bucket;
-
-    // get wildcard rules
-    fill_bucket(WILDCARD_IP, api_key_entity, rules_bucket);
-    fill_bucket(WILDCARD_API_KEY, ip_entity, rules_bucket);
+    {
+        std::shared_lock<std::shared_mutex> lock(rate_limit_mutex);
+        auto check = check_rate_limit(api_key_entity, ip_entity, false);
+        if(check != rate_limit_check_t::needs_exclusive_lock) {
+            return check == rate_limit_check_t::limited;
+        }
+    }
 
-    // get rules for the IP entity
-    fill_bucket(ip_entity, api_key_entity, rules_bucket);
+    std::unique_lock<std::shared_mutex> lock(rate_limit_mutex);
+    return check_rate_limit(api_key_entity, ip_entity, true) == rate_limit_check_t::limited;
+}
 
-    // get rules for the API key entity
-    fill_bucket(api_key_entity, ip_entity, rules_bucket);
+RateLimitManager::request_counter_shard_t& RateLimitManager::get_request_counter_shard(const std::string& key) {
+    return request_counter_shards[std::hash<std::string>{}(key) % NUM_REQUEST_COUNTER_SHARDS];
+}
 
-    if(rules_bucket.empty()) {
-        return false;
+RateLimitManager::rate_limit_check_t RateLimitManager::check_rate_limit(const rate_limit_entity_t& api_key_entity,
+                                                                        const rate_limit_entity_t& ip_entity,
+                                                                        const bool exclusive) {
+    auto top_rule = get_top_rule(api_key_entity, ip_entity);
+    if(top_rule == nullptr) {
+        return rate_limit_check_t::allowed;
     }
 
-    // sort rules_bucket by priority in ascending order
-    std::sort(rules_bucket.begin(), rules_bucket.end(), [](rate_limit_rule_t* rule1, rate_limit_rule_t* rule2) {
-        return rule1->priority < rule2->priority;
-    });
-
-    // get the rule with the highest priority
-    auto& rule = *rules_bucket.front();
+    auto& rule = *top_rule;
     // get key for throttling if exists
     auto throttle_key = get_throttle_key(ip_entity, api_key_entity);
 
     if(rule.action == RateLimitAction::block) {
-        return true;
+        return rate_limit_check_t::limited;
     }
     else if(rule.action == RateLimitAction::allow) {
-        return false;
+        return rate_limit_check_t::allowed;
     }
 
     // check if any throttle exists and still valid
@@ -57,7 +58,10 @@ bool RateLimitManager::is_rate_limited(const rate_limit_entity_t& api_key_entity
         auto key = throttle_key.get();
         // Check ifban duration is not over
         if(throttled_entities.at(key).throttling_to > get_current_time()) {
-            return true;
+            return rate_limit_check_t::limited;
+        }
+        if(!exclusive) {
+            return rate_limit_check_t::needs_exclusive_lock;
         }
         // Remove ban from DB store
         std::string ban_key = std::string(BANS_PREFIX) + "_" + std::to_string(throttled_entities.at(key).status_id);
@@ -66,41 +70,35 @@ bool RateLimitManager::is_rate_limited(const rate_limit_entity_t& api_key_entity
         throttled_entities.erase(key);
         rate_limit_exceeds.erase(key);
         // Reset request counts
-        auto& request_counts = rate_limit_request_counts.lookup(key);
-        request_counts.reset();
+        auto& throttle_shard = get_request_counter_shard(key);
+        {
+            std::unique_lock<std::mutex> shard_lock(throttle_shard.mutex);
+            if(throttle_shard.counters.contains(key)) {
+                throttle_shard.counters.lookup(key).reset();
+            }
+        }
         // Get next throttle key if exists
         throttle_key = get_throttle_key(ip_entity, api_key_entity);
     }
 
     // get request counter key according to rule type
     auto request_counter_key = get_request_counter_key(rule, ip_entity, api_key_entity);
-    
-    if(!rate_limit_request_counts.contains(request_counter_key)){
-        rate_limit_request_counts.insert(request_counter_key, request_counter_t{});
-    }
-    auto& request_counts = rate_limit_request_counts.lookup(request_counter_key);
-    // Check iflast reset time was more than 1 minute ago
-    if(request_counts.last_reset_time_minute <= get_current_time() - 60) {
-        request_counts.previous_requests_count_minute = request_counts.current_requests_count_minute;
-        request_counts.current_requests_count_minute = 0;
-        if(request_counts.last_reset_time_minute <= get_current_time() - 120) {
-            request_counts.previous_requests_count_minute = 0;
-        }
-        request_counts.last_reset_time_minute = get_current_time();
-    }
-    // Check iflast reset time was more than 1 hour ago
-    if(request_counts.last_reset_time_hour <= get_current_time() - 3600) {
-        request_counts.previous_requests_count_hour = request_counts.current_requests_count_hour;
-        request_counts.current_requests_count_hour = 0;
-        if(request_counts.last_reset_time_hour <= get_current_time() - 7200) {
-            request_counts.previous_requests_count_hour = 0;
-        }
-        request_counts.last_reset_time_hour = get_current_time();
+
+    auto& shard = get_request_counter_shard(request_counter_key);
+    std::unique_lock<std::mutex> shard_lock(shard.mutex);
+
+    if(!shard.counters.contains(request_counter_key)){
+        shard.counters.insert(request_counter_key, request_counter_t{});
     }
+    auto& request_counts = shard.counters.lookup(request_counter_key);
+    roll_over_request_counts(request_counts);
     // Check if request count is over the limit
     auto current_rate_for_minute = (60 - (get_current_time() - request_counts.last_reset_time_minute)) / 60  * request_counts.previous_requests_count_minute;
     current_rate_for_minute += request_counts.current_requests_count_minute;
     if(rule.max_requests.minute_threshold >= 0 && current_rate_for_minute >= rule.max_requests.minute_threshold) {
+        if(!exclusive) {
+            return rate_limit_check_t::needs_exclusive_lock;
+        }
         bool auto_ban_is_enabled = (rule.auto_ban_1m_threshold > 0 && rule.auto_ban_1m_duration_hours > 0);
         // If key is not in exceed map that means, it is a new exceed, not a continued exceed
         if(rate_limit_exceeds.count(request_counter_key) == 0) {
@@ -110,34 +108,230 @@ bool RateLimitManager::is_rate_limited(const rate_limit_entity_t& api_key_entity
             // else it is a continued exceed, so just increment the request count
             rate_limit_exceeds[request_counter_key].request_count++;
         }
+        const auto threshold_exceed_count_minute = request_counts.threshold_exceed_count_minute;
+        // banning resets the counters of the banned entity, which can be in the same shard
+        shard_lock.unlock();
         // If auto ban is enabled, check if threshold is exceeded
         if(auto_ban_is_enabled) {
-            if(request_counts.threshold_exceed_count_minute > rule.auto_ban_1m_threshold) {
+            if(threshold_exceed_count_minute > rule.auto_ban_1m_threshold) {
                 temp_ban_entity_wrapped(request_counter_key.substr(0, request_counter_key.find("_")) == ".*" ? WILDCARD_API_KEY : api_key_entity, rule.auto_ban_1m_duration_hours, (request_counter_key.substr((request_counter_key.find("_") + 1)) == ".*" && !rule.apply_limit_per_entity) ? nullptr : &ip_entity);
             }
         } 
-        return true;
+        return rate_limit_check_t::limited;
     }
     auto current_rate_for_hour = (3600 - (get_current_time() - request_counts.last_reset_time_hour)) / 3600  * request_counts.previous_requests_count_hour;
     current_rate_for_hour += request_counts.current_requests_count_hour;
     if(rule.max_requests.hour_threshold >= 0 && current_rate_for_hour >= rule.max_requests.hour_threshold) {
+        if(!exclusive) {
+            return rate_limit_check_t::needs_exclusive_lock;
+        }
         if(rate_limit_exceeds.count(request_counter_key) == 0) {
             rate_limit_exceeds.insert({request_counter_key, rate_limit_exceed_t{last_throttle_id++, request_counter_key, 1}});
         } else {
             rate_limit_exceeds[request_counter_key].request_count++;
         }
-        return true;
+        return rate_limit_check_t::limited;
+    }
+    // The cost of a request is known only once it is done, so requests are throttled after the ones before them
+    // have used up the budget
+    if(is_cost_exceeded(rule, request_counts)) {
+        if(!exclusive) {
+            return rate_limit_check_t::needs_exclusive_lock;
+        }
+        if(rate_limit_exceeds.count(request_counter_key) == 0) {
+            rate_limit_exceeds.insert({request_counter_key, rate_limit_exceed_t{last_throttle_id++, request_counter_key, 1}});
+        } else {
+            rate_limit_exceeds[request_counter_key].request_count++;
+        }
+        return rate_limit_check_t::limited;
     }
-    // Increment request counts
-    request_counts.current_requests_count_minute++;
-    request_counts.current_requests_count_hour++;
     // If key is in exceed map that means, it is no longer exceed, so remove it from the map
     if(rate_limit_exceeds.count(request_counter_key) > 0) {
+        if(!exclusive) {
+            return rate_limit_check_t::needs_exclusive_lock;
+        }
         rate_limit_exceeds.erase(request_counter_key);
     }
+    // Increment request counts
+    request_counts.current_requests_count_minute++;
+    request_counts.current_requests_count_hour++;
+    return rate_limit_check_t::allowed;
+}
+
+rate_limit_rule_t* RateLimitManager::get_top_rule(const rate_limit_entity_t& api_key_entity,
+                                                  const rate_limit_entity_t& ip_entity) {
+    std::vector<rate_limit_rule_t*> rules_bucket;
+
+    // get wildcard rules
+    fill_bucket(WILDCARD_IP, api_key_entity, rules_bucket);
+    fill_bucket(WILDCARD_API_KEY, ip_entity, rules_bucket);
+
+    // get rules for the IP entity
+    fill_bucket(ip_entity, api_key_entity, rules_bucket);
+
+    // get rules for the API key entity
+    fill_bucket(api_key_entity, ip_entity, rules_bucket);
+
+    if(rules_bucket.empty()) {
+        return nullptr;
+    }
+
+    // get the rule with the highest priority, which is the lowest value
+    return *std::min_element(rules_bucket.begin(), rules_bucket.end(), [](rate_limit_rule_t* rule1, rate_limit_rule_t* rule2) {
+        return rule1->priority < rule2->priority;
+    });
+}
+
+void RateLimitManager::roll_over_request_counts(request_counter_t& request_counts) {
+    // Check iflast reset time was more than 1 minute ago
+    if(request_counts.last_reset_time_minute <= get_current_time() - 60) {
+        request_counts.previous_requests_count_minute = request_counts.current_requests_count_minute;
+        request_counts.current_requests_count_minute = 0;
+        request_counts.previous_cpu_us_minute = request_counts.current_cpu_us_minute;
+        request_counts.current_cpu_us_minute = 0;
+        request_counts.previous_bytes_scanned_minute = request_counts.current_bytes_scanned_minute;
+        request_counts.current_bytes_scanned_minute = 0;
+        if(request_counts.last_reset_time_minute <= get_current_time() - 120) {
+            request_counts.previous_requests_count_minute = 0;
+            request_counts.previous_cpu_us_minute = 0;
+            request_counts.previous_bytes_scanned_minute = 0;
+        }
+        request_counts.last_reset_time_minute = get_current_time();
+    }
+    // Check iflast reset time was more than 1 hour ago
+    if(request_counts.last_reset_time_hour <= get_current_time() - 3600) {
+        request_counts.previous_requests_count_hour = request_counts.current_requests_count_hour;
+        request_counts.current_requests_count_hour = 0;
+        request_counts.previous_cpu_us_hour = request_counts.current_cpu_us_hour;
+        request_counts.current_cpu_us_hour = 0;
+        request_counts.previous_bytes_scanned_hour = request_counts.current_bytes_scanned_hour;
+        request_counts.current_bytes_scanned_hour = 0;
+        if(request_counts.last_reset_time_hour <= get_current_time() - 7200) {
+            request_counts.previous_requests_count_hour = 0;
+            request_counts.previous_cpu_us_hour = 0;
+            request_counts.previous_bytes_scanned_hour = 0;
+        }
+        request_counts.last_reset_time_hour = get_current_time();
+    }
+}
+
+// Cost of a sliding window, where the cost of the previous period is weighed by how much of it is still in the window
+static uint64_t get_window_cost(const uint64_t current_cost, const uint64_t previous_cost,
+                                const time_t elapsed, const time_t window) {
+    if(elapsed >= window) {
+        return current_cost;
+    }
+
+    return current_cost + previous_cost * (window - elapsed) / window;
+}
+
+bool RateLimitManager::is_cost_exceeded(const rate_limit_rule_t& rule, const request_counter_t& request_counts) {
+    const auto& max_cost = rule.max_cost;
+    if(max_cost.empty()) {
+        return false;
+    }
+
+    const time_t elapsed_minute = get_current_time() - request_counts.last_reset_time_minute;
+    const time_t elapsed_hour = get_current_time() - request_counts.last_reset_time_hour;
+
+    if(max_cost.cpu_ms_minute_threshold >= 0 &&
+       get_window_cost(request_counts.current_cpu_us_minute, request_counts.previous_cpu_us_minute,
+                       elapsed_minute, 60) >= uint64_t(max_cost.cpu_ms_minute_threshold) * 1000) {
+        return true;
+    }
+    if(max_cost.cpu_ms_hour_threshold >= 0 &&
+       get_window_cost(request_counts.current_cpu_us_hour, request_counts.previous_cpu_us_hour,
+                       elapsed_hour, 3600) >= uint64_t(max_cost.cpu_ms_hour_threshold) * 1000) {
+        return true;
+    }
+    if(max_cost.bytes_scanned_minute_threshold >= 0 &&
+       get_window_cost(request_counts.current_bytes_scanned_minute, request_counts.previous_bytes_scanned_minute,
+                       elapsed_minute, 60) >= uint64_t(max_cost.bytes_scanned_minute_threshold)) {
+        return true;
+    }
+    if(max_cost.bytes_scanned_hour_threshold >= 0 &&
+       get_window_cost(request_counts.current_bytes_scanned_hour, request_counts.previous_bytes_scanned_hour,
+                       elapsed_hour, 3600) >= uint64_t(max_cost.bytes_scanned_hour_threshold)) {
+        return true;
+    }
+
     return false;
 }
 
+void RateLimitManager::add_request_cost(const rate_limit_entity_t& api_key_entity, const rate_limit_entity_t& ip_entity,
+                                        const std::string& collection, const request_cost_t& cost) {
+    {
+        std::unique_lock<std::mutex> usages_lock(request_usages_mutex);
+        const std::string usage_key = std::to_string(api_key_entity.entity_id.size()) + ":" +
+                                      api_key_entity.entity_id + collection;
+        auto usage_it = request_usages.find(usage_key);
+        if(usage_it == request_usages.end()) {
+            request_usage_t usage;
+            usage.api_key = api_key_entity.entity_id;
+            usage.collection = collection;
+            usage.add(cost);
+            request_usages.insert(usage_key, usage);
+        } else {
+            usage_it->second.add(cost);
+        }
+    }
+
+    std::shared_lock<std::shared_mutex> lock(rate_limit_mutex);
+    auto rule = get_top_rule(api_key_entity, ip_entity);
+    if(rule == nullptr || rule->action != RateLimitAction::throttle || rule->max_cost.empty()) {
+        return ;
+    }
+
+    auto request_counter_key = get_request_counter_key(*rule, ip_entity, api_key_entity);
+    auto& shard = get_request_counter_shard(request_counter_key);
+    std::unique_lock<std::mutex> shard_lock(shard.mutex);
+
+    if(!shard.counters.contains(request_counter_key)) {
+        shard.counters.insert(request_counter_key, request_counter_t{});
+    }
+    auto& request_counts = shard.counters.lookup(request_counter_key);
+    roll_over_request_counts(request_counts);
+
+    const uint64_t cpu_us = cost.cpu_us.load(std::memory_order_relaxed);
+    const uint64_t bytes_scanned = cost.bytes_scanned();
+    request_counts.current_cpu_us_minute += cpu_us;
+    request_counts.current_cpu_us_hour += cpu_us;
+    request_counts.current_bytes_scanned_minute += bytes_scanned;
+    request_counts.current_bytes_scanned_hour += bytes_scanned;
+}
+
+const nlohmann::json RateLimitManager::get_usage_json() {
+    std::unique_lock<std::mutex> usages_lock(request_usages_mutex);
+    nlohmann::json usages_json = nlohmann::json::array();
+    for(auto it = request_usages.begin(); it != request_usages.end(); ++it) {
+        usages_json.push_back(it->second.to_json());
+    }
+    return usages_json;
+}
+
+void request_usage_t::add(const request_cost_t& cost) {
+    num_requests++;
+    cpu_us += cost.cpu_us.load(std::memory_order_relaxed);
+    posting_bytes_scanned += cost.posting_bytes_scanned.load(std::memory_order_relaxed);
+    num_docs_hydrated += cost.num_docs_hydrated.load(std::memory_order_relaxed);
+    doc_bytes_hydrated += cost.doc_bytes_hydrated.load(std::memory_order_relaxed);
+    max_peak_scratch_bytes = std::max<uint64_t>(max_peak_scratch_bytes,
+                                                cost.peak_scratch_bytes.load(std::memory_order_relaxed));
+}
+
+const nlohmann::json request_usage_t::to_json() const {
+    nlohmann::json usage;
+    usage["api_key"] = api_key;
+    usage["collection"] = collection;
+    usage["num_requests"] = num_requests;
+    usage["cpu_us"] = cpu_us;
+    usage["posting_bytes_scanned"] = posting_bytes_scanned;
+    usage["num_docs_hydrated"] = num_docs_hydrated;
+    usage["doc_bytes_hydrated"] = doc_bytes_hydrated;
+    usage["max_peak_scratch_bytes"] = max_peak_scratch_bytes;
+    return usage;
+}
+
 Option<nlohmann::json> RateLimitManager::find_rule_by_id(const uint64_t id) {
     std::shared_lock<std::shared_mutex> lock(rate_limit_mutex);
     if(rule_store.count(id) > 0) {
@@ -220,7 +414,14 @@ const std::vector<rate_limit_status_t> RateLimitManager::get_banned_entities(con
 
 void RateLimitManager::clear_all() {
     std::unique_lock<std::shared_mutex> lock(rate_limit_mutex);
-    rate_limit_request_counts.clear();
+    for(auto& shard: request_counter_shards) {
+        std::unique_lock<std::mutex> shard_lock(shard.mutex);
+        shard.counters.clear();
+    }
+    {
+        std::unique_lock<std::mutex> usages_lock(request_usages_mutex);
+        request_usages.clear();
+    }
     rate_limit_entities.clear();
     throttled_entities.clear();
     rate_limit_exceeds.clear();
@@ -243,10 +444,12 @@ void RateLimitManager::temp_ban_entity_wrapped(const rate_limit_entity_t& entity
     store->insert(ban_key, status.to_json().dump());
     throttled_entities.insert({key, status});
     last_ban_id++;
-    if(rate_limit_request_counts.contains(key)){
+    auto& shard = get_request_counter_shard(key);
+    std::unique_lock<std::mutex> shard_lock(shard.mutex);
+    if(shard.counters.contains(key)){
         // Reset counters for the given entity
-        rate_limit_request_counts.lookup(key).current_requests_count_minute = 0;
-        rate_limit_request_counts.lookup(key).current_requests_count_hour = 0;
+        shard.counters.lookup(key).current_requests_count_minute = 0;
+        shard.counters.lookup(key).current_requests_count_hour = 0;
     }
 }
 
@@ -279,6 +482,18 @@ const nlohmann::json rate_limit_rule_t::to_json() const {
     if(max_requests.hour_threshold >= 0) {
         rule["max_requests"]["hour_threshold"] = max_requests.hour_threshold;
     }
+    if(max_cost.cpu_ms_minute_threshold >= 0) {
+        rule["max_cpu_ms_1m"] = max_cost.cpu_ms_minute_threshold;
+    }
+    if(max_cost.cpu_ms_hour_threshold >= 0) {
+        rule["max_cpu_ms_1h"] = max_cost.cpu_ms_hour_threshold;
+    }
+    if(max_cost.bytes_scanned_minute_threshold >= 0) {
+        rule["max_bytes_scanned_1m"] = max_cost.bytes_scanned_minute_threshold;
+    }
+    if(max_cost.bytes_scanned_hour_threshold >= 0) {
+        rule["max_bytes_scanned_1h"] = max_cost.bytes_scanned_hour_threshold;
+    }
     if(auto_ban_1m_threshold >= 0) {
         rule["auto_ban_1m_threshold"] = auto_ban_1m_threshold;
     }
@@ -421,8 +636,19 @@ Option<bool> RateLimitManager::is_valid_rule(const nlohmann::json &rule_json) {
     } else if(rule_json["action"] == "block") {
         return Option<bool>(true);
     } else if(rule_json["action"] == "throttle") {
-        if(rule_json.count("max_requests_1m") == 0 && rule_json.count("max_requests_1h") == 0) {
-            return Option<bool>(400, "At least  one of `max_requests_1m` or `max_requests_1h` is required.");
+        bool has_max_cost = false;
+        for(const auto& max_cost_param: {"max_cpu_ms_1m", "max_cpu_ms_1h", "max_bytes_scanned_1m", "max_bytes_scanned_1h"}) {
+            if(rule_json.count(max_cost_param) == 0) {
+                continue;
+            }
+            if(!rule_json[max_cost_param].is_number_integer() || rule_json[max_cost_param].get<int64_t>() <= 0) {
+                return Option<bool>(400, std::string("Parameter `") + max_cost_param + "` must be a positive integer.");
+            }
+            has_max_cost = true;
+        }
+        if(rule_json.count("max_requests_1m") == 0 && rule_json.count("max_requests_1h") == 0 && !has_max_cost) {
+            return Option<bool>(400, "At least one of `max_requests_1m`, `max_requests_1h`, `max_cpu_ms_1m`, "
+                                     "`max_cpu_ms_1h`, `max_bytes_scanned_1m` or `max_bytes_scanned_1h` is required.");
         }
         if(rule_json.count("max_requests_1m") > 0 && !rule_json["max_requests_1m"].is_number_integer()) {
             return Option<bool>(400, "Parameter `max_requests_1m` must be an integer.");
@@ -468,6 +694,18 @@ Option<rate_limit_rule_t> RateLimitManager::parse_rule(const nlohmann::json &rul
     if(rule_json.count("max_requests_1h") > 0) {
         new_rule.max_requests.hour_threshold = rule_json["max_requests_1h"];
     }
+    if(rule_json.count("max_cpu_ms_1m") > 0) {
+        new_rule.max_cost.cpu_ms_minute_threshold = rule_json["max_cpu_ms_1m"];
+    }
+    if(rule_json.count("max_cpu_ms_1h") > 0) {
+        new_rule.max_cost.cpu_ms_hour_threshold = rule_json["max_cpu_ms_1h"];
+    }
+    if(rule_json.count("max_bytes_scanned_1m") > 0) {
+        new_rule.max_cost.bytes_scanned_minute_threshold = rule_json["max_bytes_scanned_1m"];
+    }
+    if(rule_json.count("max_bytes_scanned_1h") > 0) {
+        new_rule.max_cost.bytes_scanned_hour_threshold = rule_json["max_bytes_scanned_1h"];
+    }
     if(rule_json.count("auto_ban_1m_threshold") > 0 && rule_json.count("auto_ban_1m_duration_hours") > 0) {
         new_rule.auto_ban_1m_threshold = rule_json["auto_ban_1m_threshold"];
         new_rule.auto_ban_1m_duration_hours = rule_json["auto_ban_1m_duration_hours"];
@@ -701,7 +939,11 @@ bool RateLimitManager::delete_throttle_by_id(const uint32_t id) {
     if(!flag) {
         return false;
     }
-    rate_limit_request_counts.erase(iterator->first);
+    {
+        auto& shard = get_request_counter_shard(iterator->first);
+        std::unique_lock<std::mutex> shard_lock(shard.mutex);
+        shard.counters.erase(iterator->first);
+    }
     rate_limit_exceeds.erase(iterator);
     return true;
 }
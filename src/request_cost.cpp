@@ -0,0 +1,109 @@
+#include "request_cost.h"
+#include <algorithm>
+#include <ctime>
+#include "memory_accounting.h"
+
+#ifndef ASAN_BUILD
+#include "jemalloc.h"
+
+#ifdef __APPLE__
+#define impl_mallctl je_mallctl
+#else
+#define impl_mallctl mallctl
+#endif
+#endif
+
+thread_local request_cost_scope_t* request_cost_scope_t::measuring_scope = nullptr;
+
+// bytes allocated minus bytes freed by this thread when its peak was last reset
+static thread_local int64_t peak_reset_net_bytes = 0;
+
+// the peak of the bytes allocated minus the bytes freed by this thread since the last reset, which jemalloc tracks
+static void reset_thread_peak() {
+    peak_reset_net_bytes = memory_accounting_scope_t::thread_net_allocated();
+#ifndef ASAN_BUILD
+    impl_mallctl("thread.peak.reset", nullptr, nullptr, nullptr, 0);
+#endif
+}
+
+static uint64_t read_thread_peak() {
+#ifndef ASAN_BUILD
+    uint64_t peak = 0;
+    size_t sz = sizeof(peak);
+    if(impl_mallctl("thread.peak.read", &peak, &sz, nullptr, 0) != 0) {
+        return 0;
+    }
+
+    return peak;
+#else
+    return 0;
+#endif
+}
+
+// the most that the bytes allocated minus the bytes freed by this thread have been since the last reset
+static int64_t get_thread_peak_net_bytes() {
+    return peak_reset_net_bytes + int64_t(read_thread_peak());
+}
+
+void request_cost_t::update_peak_scratch_bytes(uint64_t num_bytes) {
+    uint64_t prev_bytes = peak_scratch_bytes.load(std::memory_order_relaxed);
+    while(num_bytes > prev_bytes &&
+          !peak_scratch_bytes.compare_exchange_weak(prev_bytes, num_bytes, std::memory_order_relaxed)) {
+
+    }
+}
+
+nlohmann::json request_cost_t::to_json() const {
+    nlohmann::json json;
+    json["cpu_us"] = cpu_us.load(std::memory_order_relaxed);
+    json["posting_bytes_scanned"] = posting_bytes_scanned.load(std::memory_order_relaxed);
+    json["num_docs_hydrated"] = num_docs_hydrated.load(std::memory_order_relaxed);
+    json["doc_bytes_hydrated"] = doc_bytes_hydrated.load(std::memory_order_relaxed);
+    json["peak_scratch_bytes"] = peak_scratch_bytes.load(std::memory_order_relaxed);
+    return json;
+}
+
+uint64_t request_cost_scope_t::thread_cpu_us() {
+    timespec ts{};
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+
+    return uint64_t(ts.tv_sec) * 1000 * 1000 + ts.tv_nsec / 1000;
+}
+
+request_cost_scope_t::request_cost_scope_t(request_cost_t* cost): prev_cost(request_cost) {
+    if(cost != nullptr && cost != prev_cost) {
+        measured_cost = cost;
+        begin_cpu_us = thread_cpu_us();
+
+        // the peak of the outer scope so far, since the reset below starts the peak of the thread over
+        outer_scope = measuring_scope;
+        if(outer_scope != nullptr) {
+            outer_scope->peak_net_bytes = std::max(outer_scope->peak_net_bytes, get_thread_peak_net_bytes());
+        }
+
+        reset_thread_peak();
+        begin_net_bytes = peak_net_bytes = peak_reset_net_bytes;
+        measuring_scope = this;
+    }
+
+    request_cost = cost;
+}
+
+request_cost_scope_t::~request_cost_scope_t() {
+    if(measured_cost != nullptr) {
+        measured_cost->cpu_us.fetch_add(thread_cpu_us() - begin_cpu_us, std::memory_order_relaxed);
+
+        peak_net_bytes = std::max(peak_net_bytes, get_thread_peak_net_bytes());
+        measured_cost->update_peak_scratch_bytes(uint64_t(std::max<int64_t>(0, peak_net_bytes - begin_net_bytes)));
+
+        if(outer_scope != nullptr) {
+            outer_scope->peak_net_bytes = std::max(outer_scope->peak_net_bytes, peak_net_bytes);
+        }
+
+        measuring_scope = outer_scope;
+    }
+
+    request_cost = prev_cost;
+}
@@ -0,0 +1,230 @@
+#include "response_cache.h"
+#include "zlib.h"
+#include "logger.h"
+
+response_cache_t::response_cache_t(size_t num_shards) {
+    num_shards = std::max<size_t>(num_shards, 1);
+    for(size_t i = 0; i < num_shards; i++) {
+        shards.emplace_back(std::make_unique<shard_t>());
+    }
+}
+
+void response_cache_t::shard_t::erase(std::list<std::pair<uint64_t, cached_res_t>>::iterator it) {
+    mem_bytes -= entry_size(it->second);
+    entry_index.erase(it->first);
+    entries.erase(it);
+}
+
+void response_cache_t::shard_t::evict() {
+    // the entry that was just inserted is always kept, even when it alone exceeds the memory budget
+    while(entries.size() > 1 && (entries.size() > max_entries || (max_bytes != 0 && mem_bytes > max_bytes))) {
+        erase(std::prev(entries.end()));
+        evictions++;
+    }
+}
+
+size_t response_cache_t::entry_size(const cached_res_t& value) {
+    size_t size = sizeof(cached_res_t) + value.body.size() + value.content_type_header.size();
+    for(const auto& collection_generation: value.collection_generations) {
+        size += sizeof(collection_generation) + collection_generation.first.size();
+    }
+
+    return size;
+}
+
+bool response_cache_t::compress(cached_res_t& value) {
+    // gzip format, so that the body can be sent as it is to a client that accepts the gzip encoding
+    z_stream stream{};
+    if(deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, GZIP_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+
+    std::string compressed_body(deflateBound(&stream, value.body.size()), '\0');
+    stream.next_in = (Bytef*) value.body.data();
+    stream.avail_in = value.body.size();
+    stream.next_out = (Bytef*) compressed_body.data();
+    stream.avail_out = compressed_body.size();
+
+    int ret = deflate(&stream, Z_FINISH);
+    const size_t compressed_size = stream.total_out;
+    deflateEnd(&stream);
+
+    if(ret != Z_STREAM_END || compressed_size >= value.body.size()) {
+        return false;
+    }
+
+    compressed_body.resize(compressed_size);
+    value.uncompressed_size = value.body.size();
+    value.body = std::move(compressed_body);
+    value.compressed = true;
+    return true;
+}
+
+bool response_cache_t::decompress(cached_res_t& value) {
+    z_stream stream{};
+    if(inflateInit2(&stream, GZIP_WINDOW_BITS) != Z_OK) {
+        return false;
+    }
+
+    std::string body(value.uncompressed_size, '\0');
+    stream.next_in = (Bytef*) value.body.data();
+    stream.avail_in = value.body.size();
+    stream.next_out = (Bytef*) body.data();
+    stream.avail_out = body.size();
+
+    int ret = inflate(&stream, Z_FINISH);
+    const size_t uncompressed_size = stream.total_out;
+    inflateEnd(&stream);
+
+    if(ret != Z_STREAM_END || uncompressed_size != value.uncompressed_size) {
+        LOG(ERROR) << "Failed to decompress cached response, hash: " << value.hash << ", error: " << ret;
+        return false;
+    }
+
+    value.body = std::move(body);
+    value.compressed = false;
+    return true;
+}
+
+void response_cache_t::capacity(size_t max_entries, size_t max_bytes) {
+    // round up, so that the total capacity is never lower than what was asked for
+    const size_t shard_max_entries = std::max<size_t>((max_entries + shards.size() - 1) / shards.size(), 1);
+    const size_t shard_max_bytes = (max_bytes + shards.size() - 1) / shards.size();
+
+    for(auto& shard: shards) {
+        std::unique_lock lock(shard->mutex);
+        shard->max_entries = shard_max_entries;
+        shard->max_bytes = shard_max_bytes;
+        shard->evict();
+    }
+}
+
+void response_cache_t::set_compress_min_bytes(size_t min_bytes) {
+    compress_min_bytes = min_bytes;
+}
+
+bool response_cache_t::get(uint64_t hash, cached_res_t& value,
+                           const std::function<bool(const cached_res_t&)>& is_fresh, bool keep_compressed) {
+    shard_t& shard = get_shard(hash);
+
+    {
+        std::unique_lock lock(shard.mutex);
+        auto hit_it = shard.entry_index.find(hash);
+        if(hit_it == shard.entry_index.end()) {
+            shard.misses++;
+            return false;
+        }
+
+        // move to the front
+        shard.entries.splice(shard.entries.begin(), shard.entries, hit_it->second);
+        value = hit_it->second->second;
+    }
+
+    if(is_fresh(value) && (!value.compressed || keep_compressed || decompress(value))) {
+        shard.hits++;
+        return true;
+    }
+
+    shard.misses++;
+    shard.invalidations++;
+
+    // erase only if a newer response has not already replaced the stale one
+    std::unique_lock lock(shard.mutex);
+    auto hit_it = shard.entry_index.find(hash);
+    if(hit_it != shard.entry_index.end() && hit_it->second->second.created_at == value.created_at) {
+        shard.erase(hit_it->second);
+    }
+
+    return false;
+}
+
+void response_cache_t::insert(uint64_t hash, cached_res_t value) {
+    const size_t min_bytes = compress_min_bytes;
+    if(min_bytes != 0 && value.body.size() >= min_bytes) {
+        // done outside of the shard lock
+        compress(value);
+    }
+
+    shard_t& shard = get_shard(hash);
+    std::unique_lock lock(shard.mutex);
+
+    auto existing_it = shard.entry_index.find(hash);
+    if(existing_it != shard.entry_index.end()) {
+        shard.erase(existing_it->second);
+    }
+
+    shard.mem_bytes += entry_size(value);
+    shard.entries.emplace_front(hash, std::move(value));
+    shard.entry_index.emplace(hash, shard.entries.begin());
+
+    shard.evict();
+}
+
+void response_cache_t::clear() {
+    for(auto& shard: shards) {
+        std::unique_lock lock(shard->mutex);
+        shard->entries.clear();
+        shard->entry_index.clear();
+        shard->mem_bytes = 0;
+    }
+}
+
+size_t response_cache_t::size() const {
+    size_t num_entries = 0;
+
+    for(auto& shard: shards) {
+        std::unique_lock lock(shard->mutex);
+        num_entries += shard->entries.size();
+    }
+
+    return num_entries;
+}
+
+size_t response_cache_t::mem_bytes() const {
+    size_t num_bytes = 0;
+
+    for(auto& shard: shards) {
+        std::unique_lock lock(shard->mutex);
+        num_bytes += shard->mem_bytes;
+    }
+
+    return num_bytes;
+}
+
+void response_cache_t::get_metrics(nlohmann::json& result) const {
+    uint64_t total_hits = 0, total_misses = 0, total_evictions = 0, total_invalidations = 0, total_entries = 0,
+             total_bytes = 0;
+
+    for(size_t i = 0; i < shards.size(); i++) {
+        const auto& shard = shards[i];
+        size_t num_entries, num_bytes;
+
+        {
+            std::unique_lock lock(shard->mutex);
+            num_entries = shard->entries.size();
+            num_bytes = shard->mem_bytes;
+        }
+
+        const std::string& shard_id = std::to_string(i + 1);
+        result["typesense_cache_shard" + shard_id + "_hits"] = std::to_string(shard->hits);
+        result["typesense_cache_shard" + shard_id + "_misses"] = std::to_string(shard->misses);
+        result["typesense_cache_shard" + shard_id + "_evictions"] = std::to_string(shard->evictions);
+        result["typesense_cache_shard" + shard_id + "_invalidations"] = std::to_string(shard->invalidations);
+        result["typesense_cache_shard" + shard_id + "_entries"] = std::to_string(num_entries);
+        result["typesense_cache_shard" + shard_id + "_memory_bytes"] = std::to_string(num_bytes);
+
+        total_hits += shard->hits;
+        total_misses += shard->misses;
+        total_evictions += shard->evictions;
+        total_invalidations += shard->invalidations;
+        total_entries += num_entries;
+        total_bytes += num_bytes;
+    }
+
+    result["typesense_cache_hits"] = std::to_string(total_hits);
+    result["typesense_cache_misses"] = std::to_string(total_misses);
+    result["typesense_cache_evictions"] = std::to_string(total_evictions);
+    result["typesense_cache_invalidations"] = std::to_string(total_invalidations);
+    result["typesense_cache_entries"] = std::to_string(total_entries);
+    result["typesense_cache_memory_bytes"] = std::to_string(total_bytes);
+}
@@ -0,0 +1,79 @@
+#include "search_profile.h"
+#include <algorithm>
+
+void search_profile_t::add_phase_duration(const std::string& phase, uint64_t duration_us) {
+    std::unique_lock lock(mutex);
+
+    for(auto& phase_duration: phase_durations_us) {
+        if(phase_duration.first == phase) {
+            phase_duration.second += duration_us;
+            return ;
+        }
+    }
+
+    phase_durations_us.emplace_back(phase, duration_us);
+}
+
+void search_profile_t::add_typo_candidates(uint32_t cost, size_t num_candidates) {
+    std::unique_lock lock(mutex);
+    typo_candidates[cost] += num_candidates;
+}
+
+void search_profile_t::set_filter_plan(nlohmann::json plan) {
+    std::unique_lock lock(mutex);
+    filter_plan = std::move(plan);
+}
+
+void search_profile_t::set_facet_strategy(const std::string& field_name, const std::string& strategy,
+                                          const std::string& basis) {
+    std::unique_lock lock(mutex);
+    facet_strategies[field_name] = strategy;
+
+    if(!basis.empty()) {
+        facet_strategy_bases[field_name] = basis;
+    }
+}
+
+void search_profile_t::add_intersection_split(size_t num_partitions, size_t num_workers, double imbalance) {
+    std::unique_lock lock(mutex);
+    num_intersection_splits++;
+    num_intersection_partitions += num_partitions;
+    max_intersection_workers = std::max(max_intersection_workers, num_workers);
+    max_intersection_imbalance = std::max(max_intersection_imbalance, imbalance);
+}
+
+nlohmann::json search_profile_t::to_json() const {
+    std::unique_lock lock(mutex);
+
+    nlohmann::json profile = nlohmann::json::object();
+
+    profile["phases_us"] = nlohmann::json::object();
+    for(const auto& phase_duration: phase_durations_us) {
+        profile["phases_us"][phase_duration.first] = phase_duration.second;
+    }
+
+    profile["typo_candidates"] = nlohmann::json::object();
+    for(const auto& kv: typo_candidates) {
+        profile["typo_candidates"][std::to_string(kv.first)] = kv.second;
+    }
+
+    profile["posting_blocks_decompressed"] = num_blocks_decompressed.load();
+
+    if(!filter_plan.is_null()) {
+        profile["filter_plan"] = filter_plan;
+    }
+
+    profile["facet_strategies"] = facet_strategies;
+    profile["facet_strategy_bases"] = facet_strategy_bases;
+
+    if(num_intersection_splits != 0) {
+        profile["intersection_splits"] = {
+            {"count", num_intersection_splits},
+            {"partitions", num_intersection_partitions},
+            {"max_workers", max_intersection_workers},
+            {"max_imbalance", max_intersection_imbalance}
+        };
+    }
+
+    return profile;
+}
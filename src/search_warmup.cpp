@@ -0,0 +1,101 @@
+#include "search_warmup.h"
+#include <chrono>
+#include "collection_manager.h"
+#include "logger.h"
+#include "slow_search_log.h"
+#include "thread_local_vars.h"
+
+void SearchWarmup::init(Store* meta_store, size_t time_budget_ms) {
+    this->meta_store = meta_store;
+    this->time_budget_ms = time_budget_ms;
+    done = (time_budget_ms == 0);
+}
+
+void SearchWarmup::start() {
+    if(done || started.exchange(true)) {
+        return ;
+    }
+
+    warmup_thread = std::thread([this]() {
+        replay_searches();
+        done = true;
+    });
+}
+
+void SearchWarmup::replay_searches() {
+    const auto begin = std::chrono::steady_clock::now();
+    auto elapsed_ms = [&begin]() -> size_t {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+    };
+
+    std::string searches_str;
+    if(meta_store->get(SEARCHES_KEY, searches_str) != StoreStatus::FOUND) {
+        return ;
+    }
+
+    nlohmann::json searches = nlohmann::json::parse(searches_str, nullptr, false);
+    if(searches.is_discarded() || !searches.is_array()) {
+        LOG(ERROR) << "Could not parse the searches of the warm-up.";
+        return ;
+    }
+
+    is_warmup_search = true;
+    size_t num_replayed = 0;
+
+    for(const auto& search: searches) {
+        if(quit || elapsed_ms() >= time_budget_ms) {
+            break;
+        }
+
+        if(!search.is_object() || !search.contains("collection") || !search["collection"].is_string() ||
+           !search.contains("params") || !search["params"].is_object()) {
+            continue;
+        }
+
+        std::map<std::string, std::string> req_params;
+        for(const auto& param: search["params"].items()) {
+            if(param.value().is_string()) {
+                req_params[param.key()] = param.value().get<std::string>();
+            }
+        }
+
+        req_params["collection"] = search["collection"].get<std::string>();
+        // a search can't take longer than what is left of the budget
+        req_params["search_cutoff_ms"] = std::to_string(time_budget_ms - elapsed_ms());
+
+        nlohmann::json embedded_params;
+        nlohmann::json search_result;
+        const uint64_t start_ts = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+
+        if(CollectionManager::get_instance().do_search(req_params, embedded_params, search_result, start_ts).ok()) {
+            num_replayed++;
+        }
+    }
+
+    is_warmup_search = false;
+
+    LOG(INFO) << "Warm-up replayed " << num_replayed << " of " << searches.size() << " searches in "
+              << elapsed_ms() << " ms.";
+}
+
+void SearchWarmup::persist_searches() {
+    if(meta_store == nullptr || !done) {
+        return ;
+    }
+
+    nlohmann::json searches = SlowSearchLog::get_instance().get_frequent_searches(MAX_SEARCHES);
+    if(searches.empty()) {
+        // e.g. right after a start, when the searches of the last run are still worth keeping
+        return ;
+    }
+
+    meta_store->insert(SEARCHES_KEY, searches.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore));
+}
+
+void SearchWarmup::stop() {
+    quit = true;
+    if(warmup_thread.joinable()) {
+        warmup_thread.join();
+    }
+}
@@ -0,0 +1,405 @@
+#include "shard_merger.h"
+#include <algorithm>
+#include <unordered_map>
+#include "string_utils.h"
+
+std::vector<shard_merger_t::sort_key_t> shard_merger_t::get_sort_keys(const std::vector<sort_by>& sort_fields,
+                                                                      const bool is_wildcard_query,
+                                                                      const bool is_vector_query,
+                                                                      const std::string& default_sorting_field) {
+    // same defaults as `Collection::validate_and_standardize_sort_fields()`
+    std::vector<std::pair<std::string, std::string>> name_orders;
+    for(const auto& sort_field: sort_fields) {
+        const std::string& name = sort_field.eval_expressions.empty() ? sort_field.name : sort_field_const::eval;
+        name_orders.emplace_back(name, sort_field.order);
+    }
+
+    if(name_orders.empty()) {
+        if(!is_wildcard_query) {
+            name_orders.emplace_back(sort_field_const::text_match, sort_field_const::desc);
+        }
+
+        if(is_vector_query) {
+            name_orders.emplace_back(sort_field_const::vector_distance, sort_field_const::asc);
+        }
+
+        if(!default_sorting_field.empty()) {
+            name_orders.emplace_back(default_sorting_field, sort_field_const::desc);
+        } else {
+            name_orders.emplace_back(sort_field_const::seq_id, sort_field_const::desc);
+        }
+    }
+
+    bool found_match_score = false;
+    bool found_vector_distance = false;
+    for(const auto& name_order: name_orders) {
+        found_match_score = found_match_score || name_order.first == sort_field_const::text_match;
+        found_vector_distance = found_vector_distance || name_order.first == sort_field_const::vector_distance;
+    }
+
+    if(!found_match_score && !is_wildcard_query && name_orders.size() < 3) {
+        name_orders.emplace_back(sort_field_const::text_match, sort_field_const::desc);
+    }
+
+    if(!found_vector_distance && is_vector_query && is_wildcard_query && name_orders.size() < 3) {
+        name_orders.emplace_back(sort_field_const::vector_distance, sort_field_const::asc);
+    }
+
+    std::vector<sort_key_t> keys;
+
+    for(const auto& name_order: name_orders) {
+        const std::string& name = name_order.first;
+        std::string order = name_order.second;
+        StringUtils::toupper(order);
+        const bool desc = (order == sort_field_const::desc);
+
+        if(name == sort_field_const::text_match) {
+            keys.push_back({TEXT_MATCH, "", desc});
+        } else if(name == sort_field_const::vector_distance) {
+            keys.push_back({VECTOR_DISTANCE, "", desc});
+        } else if(name.empty() || name[0] == '$' || name[0] == '_') {
+            // `_eval()`, `_seq_id`, `_group_found` and reference fields
+            keys.push_back({UNSORTED, name, desc});
+        } else {
+            // drops the parameters of geo points and of missing values
+            std::string field_name = name.substr(0, name.find('('));
+            StringUtils::trim(field_name);
+            keys.push_back({FIELD_VALUE, field_name, desc});
+        }
+    }
+
+    return keys;
+}
+
+const nlohmann::json* shard_merger_t::get_sort_value(const nlohmann::json& hit, const sort_key_t& key) {
+    switch(key.kind) {
+        case TEXT_MATCH: {
+            auto info_it = hit.find("hybrid_search_info");
+            if(info_it != hit.end() && info_it->is_object() && info_it->contains("rank_fusion_score")) {
+                return &info_it->at("rank_fusion_score");
+            }
+
+            auto text_match_it = hit.find("text_match");
+            return text_match_it != hit.end() ? &(*text_match_it) : nullptr;
+        }
+        case VECTOR_DISTANCE: {
+            auto distance_it = hit.find("vector_distance");
+            return distance_it != hit.end() ? &(*distance_it) : nullptr;
+        }
+        case FIELD_VALUE: {
+            auto geo_it = hit.find("geo_distance_meters");
+            if(geo_it != hit.end() && geo_it->is_object() && geo_it->contains(key.field_name)) {
+                return &geo_it->at(key.field_name);
+            }
+
+            auto doc_it = hit.find("document");
+            if(doc_it == hit.end() || !doc_it->is_object()) {
+                return nullptr;
+            }
+
+            auto value_it = doc_it->find(key.field_name);
+            if(value_it != doc_it->end()) {
+                return &(*value_it);
+            }
+
+            // field of a nested object
+            std::vector<std::string> parts;
+            StringUtils::split(key.field_name, parts, ".");
+
+            const nlohmann::json* value = &(*doc_it);
+            for(const auto& part: parts) {
+                if(!value->is_object() || !value->contains(part)) {
+                    return nullptr;
+                }
+
+                value = &value->at(part);
+            }
+
+            return value;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+static int compare_values(const nlohmann::json& a, const nlohmann::json& b) {
+    if(a.is_number_unsigned() && b.is_number_unsigned()) {
+        const auto x = a.get<uint64_t>(), y = b.get<uint64_t>();
+        return (x < y) ? -1 : (x > y);
+    }
+
+    if(a.is_number_integer() && b.is_number_integer()) {
+        const auto x = a.get<int64_t>(), y = b.get<int64_t>();
+        return (x < y) ? -1 : (x > y);
+    }
+
+    if(a.is_number() && b.is_number()) {
+        const auto x = a.get<double>(), y = b.get<double>();
+        return (x < y) ? -1 : (x > y);
+    }
+
+    if(a.is_string() && b.is_string()) {
+        return a.get_ref<const std::string&>().compare(b.get_ref<const std::string&>());
+    }
+
+    if(a.is_boolean() && b.is_boolean()) {
+        return int(a.get<bool>()) - int(b.get<bool>());
+    }
+
+    return 0;
+}
+
+int shard_merger_t::compare_hits(const nlohmann::json& a, const nlohmann::json& b,
+                                 const std::vector<sort_key_t>& keys) {
+    for(const auto& key: keys) {
+        if(key.kind == UNSORTED) {
+            continue;
+        }
+
+        const nlohmann::json* a_value = get_sort_value(a, key);
+        const nlohmann::json* b_value = get_sort_value(b, key);
+
+        // hits without a value come last, whatever the order
+        if(a_value == nullptr || b_value == nullptr) {
+            if(a_value != b_value) {
+                return a_value == nullptr ? 1 : -1;
+            }
+
+            continue;
+        }
+
+        int cmp = compare_values(*a_value, *b_value);
+        if(cmp != 0) {
+            return key.desc ? -cmp : cmp;
+        }
+    }
+
+    return 0;
+}
+
+void shard_merger_t::merge_facet_counts(const std::vector<nlohmann::json>& shard_results,
+                                        const size_t max_facet_values, nlohmann::json& facet_counts) {
+    struct merged_facet_t {
+        nlohmann::json facet;
+        std::vector<nlohmann::json> counts;
+        std::unordered_map<std::string, size_t> value_indices;
+
+        bool has_stats = false;
+        double min = 0, max = 0, sum = 0;
+        double num_values = 0;
+    };
+
+    std::vector<merged_facet_t> merged_facets;
+    std::unordered_map<std::string, size_t> facet_indices;
+
+    for(const auto& shard_result: shard_results) {
+        auto facets_it = shard_result.find("facet_counts");
+        if(facets_it == shard_result.end() || !facets_it->is_array()) {
+            continue;
+        }
+
+        for(const auto& facet: *facets_it) {
+            const std::string& field_name = facet.value("field_name", "");
+            auto facet_index_it = facet_indices.find(field_name);
+
+            if(facet_index_it == facet_indices.end()) {
+                facet_index_it = facet_indices.emplace(field_name, merged_facets.size()).first;
+                merged_facets.emplace_back();
+                merged_facets.back().facet = facet;
+                merged_facets.back().facet.erase("counts");
+                merged_facets.back().facet.erase("stats");
+            }
+
+            auto& merged_facet = merged_facets[facet_index_it->second];
+
+            if(facet.value("sampled", false)) {
+                merged_facet.facet["sampled"] = true;
+            }
+
+            if(facet.contains("counts") && facet["counts"].is_array()) {
+                for(const auto& count: facet["counts"]) {
+                    const std::string& value = count.value("value", "");
+                    auto value_it = merged_facet.value_indices.find(value);
+
+                    if(value_it == merged_facet.value_indices.end()) {
+                        merged_facet.value_indices.emplace(value, merged_facet.counts.size());
+                        merged_facet.counts.push_back(count);
+                        continue;
+                    }
+
+                    auto& merged_count = merged_facet.counts[value_it->second];
+                    merged_count["count"] = merged_count.value("count", uint64_t(0)) + count.value("count", uint64_t(0));
+
+                    if(count.contains("count_error")) {
+                        merged_count["count_error"] = merged_count.value("count_error", uint64_t(0)) +
+                                                      count["count_error"].get<uint64_t>();
+                    }
+                }
+            }
+
+            auto stats_it = facet.find("stats");
+            if(stats_it != facet.end() && stats_it->is_object() && stats_it->contains("min")) {
+                const double min = stats_it->value("min", 0.0);
+                const double max = stats_it->value("max", 0.0);
+                const double sum = stats_it->value("sum", 0.0);
+                const double avg = stats_it->value("avg", 0.0);
+
+                merged_facet.min = merged_facet.has_stats ? std::min(merged_facet.min, min) : min;
+                merged_facet.max = merged_facet.has_stats ? std::max(merged_facet.max, max) : max;
+                merged_facet.sum += sum;
+                // the number of values of each shard is only known through their average
+                merged_facet.num_values += (avg != 0) ? (sum / avg) : 0;
+                merged_facet.has_stats = true;
+            }
+        }
+    }
+
+    facet_counts = nlohmann::json::array();
+
+    for(auto& merged_facet: merged_facets) {
+        std::stable_sort(merged_facet.counts.begin(), merged_facet.counts.end(),
+                         [](const nlohmann::json& a, const nlohmann::json& b) {
+            return a.value("count", uint64_t(0)) > b.value("count", uint64_t(0));
+        });
+
+        if(merged_facet.counts.size() > max_facet_values) {
+            merged_facet.counts.resize(max_facet_values);
+        }
+
+        nlohmann::json& facet = merged_facet.facet;
+        facet["counts"] = merged_facet.counts;
+        facet["stats"] = nlohmann::json::object();
+
+        if(merged_facet.has_stats) {
+            facet["stats"]["min"] = merged_facet.min;
+            facet["stats"]["max"] = merged_facet.max;
+            facet["stats"]["sum"] = merged_facet.sum;
+            facet["stats"]["avg"] = (merged_facet.num_values != 0) ? (merged_facet.sum / merged_facet.num_values) : 0;
+        }
+
+        facet["stats"]["total_values"] = merged_facet.counts.size();
+        facet_counts.push_back(std::move(facet));
+    }
+}
+
+nlohmann::json shard_merger_t::merge(const std::vector<nlohmann::json>& shard_results,
+                                     const std::vector<sort_key_t>& sort_keys,
+                                     const size_t offset, const size_t limit,
+                                     const size_t max_facet_values, const size_t group_limit) {
+    nlohmann::json result = nlohmann::json::object();
+    if(shard_results.empty()) {
+        return result;
+    }
+
+    const auto hit_compare = [&sort_keys](const nlohmann::json& a, const nlohmann::json& b) {
+        return compare_hits(a, b, sort_keys) < 0;
+    };
+
+    size_t found = 0;
+    size_t found_docs = 0;
+    size_t out_of = 0;
+    bool has_out_of = false;
+    bool search_cutoff = false;
+
+    for(const auto& shard_result: shard_results) {
+        found += shard_result.value("found", size_t(0));
+        found_docs += shard_result.value("found_docs", size_t(0));
+        search_cutoff = search_cutoff || shard_result.value("search_cutoff", false);
+
+        if(shard_result.contains("out_of")) {
+            has_out_of = true;
+            out_of += shard_result["out_of"].get<size_t>();
+        }
+    }
+
+    if(group_limit == 0) {
+        std::vector<nlohmann::json> hits;
+        for(const auto& shard_result: shard_results) {
+            if(shard_result.contains("hits") && shard_result["hits"].is_array()) {
+                hits.insert(hits.end(), shard_result["hits"].begin(), shard_result["hits"].end());
+            }
+        }
+
+        std::stable_sort(hits.begin(), hits.end(), hit_compare);
+
+        result["found"] = found;
+        result["hits"] = nlohmann::json::array();
+        for(size_t i = offset; i < hits.size() && i < offset + limit; i++) {
+            result["hits"].push_back(std::move(hits[i]));
+        }
+    } else {
+        // groups of the same key from different shards are merged into one
+        std::vector<nlohmann::json> groups;
+        std::unordered_map<std::string, size_t> group_indices;
+        size_t num_merged_groups = 0;
+
+        for(const auto& shard_result: shard_results) {
+            if(!shard_result.contains("grouped_hits") || !shard_result["grouped_hits"].is_array()) {
+                continue;
+            }
+
+            for(const auto& group: shard_result["grouped_hits"]) {
+                const std::string& group_key = group.value("group_key", nlohmann::json::array()).dump();
+                auto group_it = group_indices.find(group_key);
+
+                if(group_it == group_indices.end()) {
+                    group_indices.emplace(group_key, groups.size());
+                    groups.push_back(group);
+                    continue;
+                }
+
+                auto& merged_group = groups[group_it->second];
+                for(const auto& hit: group.value("hits", nlohmann::json::array())) {
+                    merged_group["hits"].push_back(hit);
+                }
+
+                if(group.contains("found")) {
+                    merged_group["found"] = merged_group.value("found", size_t(0)) + group["found"].get<size_t>();
+                }
+
+                num_merged_groups++;
+            }
+        }
+
+        for(auto& group: groups) {
+            auto& hits = group["hits"];
+            std::stable_sort(hits.begin(), hits.end(), hit_compare);
+            if(hits.size() > group_limit) {
+                hits.erase(hits.begin() + group_limit, hits.end());
+            }
+        }
+
+        std::stable_sort(groups.begin(), groups.end(), [&](const nlohmann::json& a, const nlohmann::json& b) {
+            if(a["hits"].empty() || b["hits"].empty()) {
+                return !a["hits"].empty() && b["hits"].empty();
+            }
+
+            return hit_compare(a["hits"][0], b["hits"][0]);
+        });
+
+        // groups that are spread over shards are counted once, as far as the fetched groups tell
+        result["found"] = found - std::min(found, num_merged_groups);
+        result["found_docs"] = found_docs;
+        result["grouped_hits"] = nlohmann::json::array();
+        for(size_t i = offset; i < groups.size() && i < offset + limit; i++) {
+            result["grouped_hits"].push_back(std::move(groups[i]));
+        }
+    }
+
+    if(has_out_of) {
+        result["out_of"] = out_of;
+    }
+
+    merge_facet_counts(shard_results, max_facet_values, result["facet_counts"]);
+    result["search_cutoff"] = search_cutoff;
+
+    if(shard_results.front().contains("request_params")) {
+        result["request_params"] = shard_results.front()["request_params"];
+    }
+
+    if(shard_results.front().contains("metadata")) {
+        result["metadata"] = shard_results.front()["metadata"];
+    }
+
+    return result;
+}
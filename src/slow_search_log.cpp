@@ -0,0 +1,278 @@
+#include "slow_search_log.h"
+#include <algorithm>
+#include <mutex>
+#include <unordered_set>
+#include "string_utils.h"
+
+// parameters that decide how a search is processed, which are kept as they are in a fingerprint
+static const std::unordered_set<std::string> SHAPE_PARAMS = {
+    "query_by", "query_by_weights", "sort_by", "facet_by", "group_by", "group_limit", "include_fields",
+    "exclude_fields", "num_typos", "prefix", "infix", "text_match_type", "drop_tokens_threshold",
+    "typo_tokens_threshold", "drop_tokens_mode", "exhaustive_search", "prioritize_exact_match",
+    "prioritize_token_position", "split_join_tokens", "max_candidates", "max_facet_values", "enable_lazy_filter",
+    "enable_overrides", "preset", "stopwords", "use_cache", "search_cutoff_ms"
+};
+
+// parameters that do not describe the search itself
+static const std::unordered_set<std::string> IGNORED_PARAMS = {
+    "collection", "x-typesense-api-key", "x-typesense-user-id", "accept"
+};
+
+// returns the position just past the `close` that matches the `open` at `pos`, skipping over quoted text
+static size_t skip_enclosed(const std::string& text, size_t pos, char open, char close) {
+    int depth = 0;
+    bool in_quotes = false;
+
+    for(size_t i = pos; i < text.size(); i++) {
+        if(text[i] == '`') {
+            in_quotes = !in_quotes;
+        } else if(!in_quotes && text[i] == open) {
+            depth++;
+        } else if(!in_quotes && text[i] == close && --depth == 0) {
+            return i + 1;
+        }
+    }
+
+    return text.size();
+}
+
+std::string SlowSearchLog::normalize_filter(const std::string& filter_query) {
+    std::string normalized;
+    size_t i = 0;
+
+    while(i < filter_query.size()) {
+        const char c = filter_query[i++];
+        normalized += c;
+
+        if(c != ':') {
+            continue;
+        }
+
+        // operators of the value
+        while(i < filter_query.size() && (filter_query[i] == ' ' || filter_query[i] == '=' ||
+                                          filter_query[i] == '!' || filter_query[i] == '<' ||
+                                          filter_query[i] == '>')) {
+            normalized += filter_query[i++];
+        }
+
+        if(i == filter_query.size()) {
+            break;
+        }
+
+        if(filter_query[i] == '[') {
+            i = skip_enclosed(filter_query, i, '[', ']');
+            normalized += "[?]";
+        } else if(filter_query[i] == '(') {
+            // geo filter
+            i = skip_enclosed(filter_query, i, '(', ')');
+            normalized += "(?)";
+        } else if(filter_query[i] == '`') {
+            const size_t end_quote = filter_query.find('`', i + 1);
+            i = (end_quote == std::string::npos) ? filter_query.size() : end_quote + 1;
+            normalized += "?";
+        } else {
+            while(i < filter_query.size() && filter_query[i] != ' ' && filter_query[i] != ')' &&
+                  filter_query.compare(i, 2, "&&") != 0 && filter_query.compare(i, 2, "||") != 0) {
+                i++;
+            }
+            normalized += "?";
+        }
+    }
+
+    return normalized;
+}
+
+std::string SlowSearchLog::fingerprint(const std::map<std::string, std::string>& req_params) {
+    std::string fingerprint;
+
+    for(const auto& kv: req_params) {
+        const std::string& key = kv.first;
+        const std::string& value = kv.second;
+
+        if(IGNORED_PARAMS.count(key) != 0) {
+            continue;
+        }
+
+        std::string normalized;
+
+        if(SHAPE_PARAMS.count(key) != 0) {
+            normalized = value;
+        } else if(key == "q") {
+            normalized = (value == "*") ? "*" : "?";
+        } else if(key == "filter_by") {
+            normalized = normalize_filter(value);
+        } else if(key == "vector_query") {
+            // e.g. `embedding:([0.1, 0.2], k: 10)` => `embedding:(?)`
+            const size_t paren_pos = value.find('(');
+            normalized = value.substr(0, paren_pos) + "(?)";
+        } else if(key == "facet_query") {
+            normalized = value.substr(0, value.find(':')) + ":?";
+        } else {
+            normalized = "?";
+        }
+
+        if(!fingerprint.empty()) {
+            fingerprint += "&";
+        }
+
+        fingerprint += key + "=" + normalized;
+    }
+
+    return fingerprint;
+}
+
+uint64_t SlowSearchLog::fingerprint_id(const std::string& collection, const std::string& fingerprint) {
+    return StringUtils::hash_combine(StringUtils::hash_wy(collection.data(), collection.size()),
+                                     StringUtils::hash_wy(fingerprint.data(), fingerprint.size()));
+}
+
+void SlowSearchLog::record(const std::string& collection, const std::string& fingerprint, uint64_t latency_us,
+                           bool slow, const std::map<std::string, std::string>& req_params) {
+    const uint64_t id = fingerprint_id(collection, fingerprint);
+
+    auto record_latency = [&](fingerprint_stats_t& stats) {
+        stats.latencies_us.record(latency_us);
+        if(slow) {
+            stats.num_slow++;
+        }
+    };
+
+    {
+        // the histograms are updated without locking, so a shared lock is enough for a known fingerprint
+        std::shared_lock lock(mutex);
+        auto stats_it = fingerprint_stats.find(id);
+        if(stats_it != fingerprint_stats.end()) {
+            record_latency(*stats_it->second);
+            return ;
+        }
+    }
+
+    std::unique_lock lock(mutex);
+    auto stats_it = fingerprint_stats.find(id);
+
+    if(stats_it == fingerprint_stats.end()) {
+        if(fingerprint_stats.size() >= MAX_FINGERPRINTS) {
+            num_untracked++;
+            return ;
+        }
+
+        auto stats = std::make_unique<fingerprint_stats_t>();
+        stats->collection = collection;
+        stats->fingerprint = fingerprint;
+
+        for(const auto& kv: req_params) {
+            if(IGNORED_PARAMS.count(kv.first) == 0) {
+                stats->sample_params.emplace(kv.first, kv.second);
+            }
+        }
+
+        stats_it = fingerprint_stats.emplace(id, std::move(stats)).first;
+    }
+
+    record_latency(*stats_it->second);
+}
+
+nlohmann::json SlowSearchLog::slow_search_record(const std::string& collection, const std::string& fingerprint,
+                                                 uint64_t time_ms, const nlohmann::json& result,
+                                                 const nlohmann::json& profile) {
+    nlohmann::json record;
+    record["collection"] = collection;
+    record["fingerprint"] = fingerprint;
+    record["fingerprint_id"] = std::to_string(fingerprint_id(collection, fingerprint));
+    record["time_ms"] = time_ms;
+
+    record["found"] = result.value("found", 0);
+    record["out_of"] = result.value("out_of", 0);
+
+    if(result.contains("grouped_hits")) {
+        record["num_hits"] = result["grouped_hits"].size();
+    } else if(result.contains("hits")) {
+        record["num_hits"] = result["hits"].size();
+    }
+
+    record["search_cutoff"] = result.value("search_cutoff", false);
+
+    // phase timings, the number of candidates per typo cost and the filter plan
+    if(profile.is_object()) {
+        for(const auto& item: profile.items()) {
+            record[item.key()] = item.value();
+        }
+    }
+
+    return record;
+}
+
+nlohmann::json SlowSearchLog::get_stats(size_t limit) const {
+    std::vector<nlohmann::json> entries;
+    std::vector<uint64_t> bucket_counts;
+
+    {
+        std::shared_lock lock(mutex);
+
+        for(const auto& kv: fingerprint_stats) {
+            const auto& stats = kv.second;
+            stats->latencies_us.snapshot(bucket_counts);
+
+            nlohmann::json entry;
+            entry["fingerprint_id"] = std::to_string(kv.first);
+            entry["collection"] = stats->collection;
+            entry["fingerprint"] = stats->fingerprint;
+            entry["count"] = stats->latencies_us.count();
+            entry["slow_count"] = stats->num_slow.load();
+            entry["total_ms"] = stats->latencies_us.sum() / 1000.0;
+            entry["p50_ms"] = latency_histogram_t::value_at_percentile(bucket_counts, 50) / 1000.0;
+            entry["p99_ms"] = latency_histogram_t::value_at_percentile(bucket_counts, 99) / 1000.0;
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const nlohmann::json& a, const nlohmann::json& b) {
+        return a["total_ms"].get<double>() > b["total_ms"].get<double>();
+    });
+
+    if(entries.size() > limit) {
+        entries.resize(limit);
+    }
+
+    nlohmann::json stats;
+    stats["fingerprints"] = entries;
+    stats["untracked_searches"] = num_untracked.load();
+    return stats;
+}
+
+nlohmann::json SlowSearchLog::get_frequent_searches(size_t limit) const {
+    std::vector<std::pair<uint64_t, nlohmann::json>> searches;
+
+    {
+        std::shared_lock lock(mutex);
+
+        for(const auto& kv: fingerprint_stats) {
+            const auto& stats = kv.second;
+            if(stats->sample_params.empty()) {
+                continue;
+            }
+
+            nlohmann::json search;
+            search["collection"] = stats->collection;
+            search["params"] = stats->sample_params;
+            searches.emplace_back(stats->latencies_us.count(), std::move(search));
+        }
+    }
+
+    std::sort(searches.begin(), searches.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first;
+    });
+
+    nlohmann::json frequent_searches = nlohmann::json::array();
+    for(size_t i = 0; i < searches.size() && i < limit; i++) {
+        frequent_searches.push_back(std::move(searches[i].second));
+    }
+
+    return frequent_searches;
+}
+
+void SlowSearchLog::clear() {
+    std::unique_lock lock(mutex);
+    fingerprint_stats.clear();
+    num_untracked = 0;
+}
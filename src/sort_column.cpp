@@ -0,0 +1,124 @@
+#include "sort_column.h"
+#include <algorithm>
+
+void sort_column_t::store_dense_value(uint32_t seq_id, int64_t value) {
+    uint8_t* dest = dense_values.data() + size_t(seq_id) * dense_width;
+
+    switch(dense_width) {
+        case 1: {
+            *dest = uint8_t(int8_t(value));
+            break;
+        }
+        case 2: {
+            const int16_t v = value;
+            std::memcpy(dest, &v, sizeof(v));
+            break;
+        }
+        case 4: {
+            const int32_t v = value;
+            std::memcpy(dest, &v, sizeof(v));
+            break;
+        }
+        default: {
+            std::memcpy(dest, &value, sizeof(value));
+            break;
+        }
+    }
+}
+
+void sort_column_t::set_dense_value(uint32_t seq_id, int64_t value) {
+    if(seq_id >= dense_size) {
+        // seq_ids are mostly handed out in increasing order, so leave room for the next ones
+        dense_size = std::max<size_t>(size_t(seq_id) + 1, dense_size + dense_size / 2);
+        dense_values.resize(dense_size * dense_width, 0);
+        dense_present.resize((dense_size + 63) / 64, 0);
+    }
+
+    const size_t width = value_width(value);
+    if(width > dense_width) {
+        widen(width);
+    }
+
+    store_dense_value(seq_id, value);
+    dense_present[seq_id / 64] |= (uint64_t(1) << (seq_id % 64));
+}
+
+void sort_column_t::widen(size_t width) {
+    std::vector<int64_t> values(dense_size);
+    for(size_t seq_id = 0; seq_id < dense_size; seq_id++) {
+        values[seq_id] = get_dense_value(seq_id);
+    }
+
+    dense_width = width;
+    dense_values.assign(dense_size * dense_width, 0);
+
+    for(size_t seq_id = 0; seq_id < dense_size; seq_id++) {
+        store_dense_value(seq_id, values[seq_id]);
+    }
+}
+
+void sort_column_t::make_dense(uint32_t max_seq_id, size_t width) {
+    dense_size = size_t(max_seq_id) + 1;
+    dense_width = width;
+    dense_values.assign(dense_size * dense_width, 0);
+    dense_present.assign((dense_size + 63) / 64, 0);
+
+    for(const auto& kv: sparse_values) {
+        set_dense_value(kv.first, kv.second);
+    }
+
+    spp::sparse_hash_map<uint32_t, int64_t, hasher_t>().swap(sparse_values);
+    is_dense = true;
+}
+
+bool sort_column_t::emplace(uint32_t seq_id, int64_t value) {
+    if(is_dense) {
+        if(has_dense_value(seq_id)) {
+            return false;
+        }
+
+        set_dense_value(seq_id, value);
+        num_values++;
+        return true;
+    }
+
+    if(!sparse_values.emplace(seq_id, value).second) {
+        return false;
+    }
+
+    num_values++;
+
+    if(num_values >= MIN_DENSE_VALUES && (num_values & (num_values - 1)) == 0) {
+        // density is only checked when the count hits a power of two, to keep inserts cheap
+        uint32_t max_seq_id = 0;
+        size_t width = 1;
+        for(const auto& kv: sparse_values) {
+            max_seq_id = std::max(max_seq_id, kv.first);
+            width = std::max(width, value_width(kv.second));
+        }
+
+        const size_t dense_bytes = (size_t(max_seq_id) + 1) * width + (size_t(max_seq_id) + 1) / 8;
+        if(dense_bytes <= num_values * SPARSE_ENTRY_BYTES) {
+            make_dense(max_seq_id, width);
+        }
+    }
+
+    return true;
+}
+
+size_t sort_column_t::erase(uint32_t seq_id) {
+    if(is_dense) {
+        if(!has_dense_value(seq_id)) {
+            return 0;
+        }
+
+        dense_present[seq_id / 64] &= ~(uint64_t(1) << (seq_id % 64));
+        store_dense_value(seq_id, 0);
+        num_values--;
+        return 1;
+    }
+
+    const size_t num_erased = sparse_values.erase(seq_id);
+    num_values -= num_erased;
+    return num_erased;
+}
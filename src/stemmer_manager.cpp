@@ -1,27 +1,84 @@
+#include <algorithm>
 #include "stemmer_manager.h"
 
+std::atomic<size_t> Stemmer::max_entries = Stemmer::DEFAULT_MAX_ENTRIES;
 
-Stemmer::Stemmer(const char * language) {
-    this->stemmer = sb_stemmer_new(language, nullptr);
-    this->cache = LRU::Cache<std::string, std::string>(20);
+std::atomic<uint64_t> Stemmer::hits = 0;
+std::atomic<uint64_t> Stemmer::misses = 0;
+
+Stemmer::Stemmer(const char * language): language(language) {
+    const size_t num_entries = max_entries;
+    cache_enabled = (num_entries != 0);
+
+    if(cache_enabled) {
+        const size_t shard_entries = std::max<size_t>(1, num_entries / NUM_SHARDS);
+        for(auto& shard: shards) {
+            shard.cache = LRU::Cache<std::string, std::string>(shard_entries);
+        }
+    }
+
+    free_stemmers.push_back(sb_stemmer_new(language, nullptr));
 }
 
 Stemmer::~Stemmer() {
-    sb_stemmer_delete(stemmer);
+    for(auto stemmer: free_stemmers) {
+        sb_stemmer_delete(stemmer);
+    }
+}
+
+sb_stemmer* Stemmer::acquire_stemmer() {
+    {
+        std::unique_lock<std::mutex> lock(stemmers_mutex);
+        if(!free_stemmers.empty()) {
+            sb_stemmer* stemmer = free_stemmers.back();
+            free_stemmers.pop_back();
+            return stemmer;
+        }
+    }
+
+    return sb_stemmer_new(language.c_str(), nullptr);
+}
+
+void Stemmer::release_stemmer(sb_stemmer* stemmer) {
+    std::unique_lock<std::mutex> lock(stemmers_mutex);
+    free_stemmers.push_back(stemmer);
 }
 
 std::string Stemmer::stem(const std::string & word) {
-    std::unique_lock<std::mutex> lock(mutex);
-    std::string stemmed_word;
-    if (cache.contains(word)) {
-        return cache.lookup(word);
+    shard_t& shard = shards[std::hash<std::string>{}(word) % NUM_SHARDS];
+
+    if(cache_enabled) {
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        if(shard.cache.contains(word)) {
+            hits++;
+            return shard.cache.lookup(word);
+        }
     }
+
+    sb_stemmer* stemmer = acquire_stemmer();
     auto stemmed = sb_stemmer_stem(stemmer, reinterpret_cast<const sb_symbol*>(word.c_str()), word.length());
-    stemmed_word = std::string(reinterpret_cast<const char*>(stemmed));
-    cache.insert(word, stemmed_word);
+    std::string stemmed_word = std::string(reinterpret_cast<const char*>(stemmed));
+    release_stemmer(stemmer);
+
+    if(cache_enabled) {
+        misses++;
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        shard.cache.insert(word, stemmed_word);
+    }
+
     return stemmed_word;
 }
 
+void Stemmer::set_max_entries(size_t max_entries) {
+    Stemmer::max_entries = max_entries;
+}
+
+void Stemmer::get_metrics(nlohmann::json& result) {
+    result["typesense_stem_cache_hits"] = std::to_string(hits);
+    result["typesense_stem_cache_misses"] = std::to_string(misses);
+    result["typesense_stem_cache_max_entries_per_language"] = std::to_string(max_entries);
+}
+
 StemmerManager::~StemmerManager() {
     delete_all_stemmers();
 }
@@ -30,16 +87,18 @@ std::shared_ptr<Stemmer> StemmerManager::get_stemmer(const std::string& language
     std::unique_lock<std::mutex> lock(mutex);
     // use english as default language
     const std::string language_ = language.empty() ? "english" : language;
-    if (stemmers.find(language_) == stemmers.end()) {
-        stemmers[language] = std::make_shared<Stemmer>(language_.c_str());
+    auto stemmer_it = stemmers.find(language_);
+    if (stemmer_it == stemmers.end()) {
+        stemmer_it = stemmers.emplace(language_, std::make_shared<Stemmer>(language_.c_str())).first;
     }
-    return stemmers[language];
+    return stemmer_it->second;
 }
 
 void StemmerManager::delete_stemmer(const std::string& language) {
     std::unique_lock<std::mutex> lock(mutex);
-    if (stemmers.find(language) != stemmers.end()) {
-        stemmers.erase(language);
+    const std::string language_ = language.empty() ? "english" : language;
+    if (stemmers.find(language_) != stemmers.end()) {
+        stemmers.erase(language_);
     }
 }
 
@@ -1,6 +1,32 @@
 #include "include/stopwords_manager.h"
 #include "include/tokenizer.h"
 
+compiled_stopwords_t::compiled_stopwords_t(const spp::sparse_hash_set<std::string>& stopwords) {
+    size_t num_slots = 2;
+    while(num_slots < stopwords.size() * 2) {
+        num_slots *= 2;
+    }
+
+    slots.resize(num_slots, 0);
+    slot_hashes.resize(num_slots, 0);
+    slot_mask = num_slots - 1;
+    offsets.reserve(stopwords.size() + 1);
+    offsets.push_back(0);
+
+    for(const auto& stopword: stopwords) {
+        const uint64_t hash = StringUtils::hash_wy(stopword.data(), stopword.size());
+        size_t slot = hash & slot_mask;
+        while(slots[slot] != 0) {
+            slot = (slot + 1) & slot_mask;
+        }
+
+        slots[slot] = offsets.size();
+        slot_hashes[slot] = uint32_t(hash);
+        words += stopword;
+        offsets.push_back(words.size());
+    }
+}
+
 void StopwordsManager::init(Store* _store) {
     store = _store;
 }
@@ -22,6 +48,17 @@ Option<bool> StopwordsManager::get_stopword(const std::string& stopword_name, st
     return Option<bool>(404, "Stopword `" + stopword_name +"` not found.");
 }
 
+std::shared_ptr<const compiled_stopwords_t> StopwordsManager::get_compiled_stopwords(const std::string& stopword_name) const {
+    std::shared_lock lock(mutex);
+
+    const auto& it = stopword_configs.find(stopword_name);
+    if(it == stopword_configs.end()) {
+        return nullptr;
+    }
+
+    return it->second.compiled_stopwords;
+}
+
 Option<bool> StopwordsManager::upsert_stopword(const std::string& stopword_name, const nlohmann::json& stopwords_json,
                                                bool write_to_store) {
     std::unique_lock lock(mutex);
@@ -69,7 +106,9 @@ Option<bool> StopwordsManager::upsert_stopword(const std::string& stopword_name,
         }
         tokens.clear();
     }
-    stopword_configs[stopword_name] = stopword_struct_t{stopword_name, stopwords_set, locale};
+    auto compiled_stopwords = std::make_shared<const compiled_stopwords_t>(stopwords_set);
+    stopword_configs[stopword_name] = stopword_struct_t{stopword_name, std::move(stopwords_set), locale,
+                                                        std::move(compiled_stopwords)};
     return Option<bool>(true);
 }
 
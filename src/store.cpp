@@ -0,0 +1,50 @@
+#include "store.h"
+#include "collection.h"
+
+bool StoreMergeOperator::merge_doc_patches(const rocksdb::Slice* existing_value,
+                                           const std::vector<rocksdb::Slice>& patches, std::string& new_value) {
+    const std::string existing = (existing_value == nullptr) ? "" : existing_value->ToString();
+    const bool is_msgpack = !existing.empty() && existing[0] == Collection::STORED_DOC_MSGPACK_MARKER;
+
+    try {
+        nlohmann::json document = existing.empty() ? nlohmann::json::object() :
+                                  Collection::parse_stored_document(existing);
+
+        for(const auto& patch: patches) {
+            document.merge_patch(nlohmann::json::parse(patch.data() + 1, patch.data() + patch.size()));
+        }
+
+        if(is_msgpack) {
+            new_value.assign(1, Collection::STORED_DOC_MSGPACK_MARKER);
+            nlohmann::json::to_msgpack(document, new_value);
+        } else {
+            new_value = document.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+        }
+    } catch(const std::exception& e) {
+        // failing the merge would fail every read of the key, so the stored document is kept as it is
+        LOG(ERROR) << "Could not apply the patches of a document: " << e.what();
+        new_value = existing;
+    }
+
+    return true;
+}
+
+bool StoreMergeOperator::FullMergeV2(const MergeOperationInput& merge_in, MergeOperationOutput* merge_out) const {
+    const auto& operands = merge_in.operand_list;
+
+    if(!operands.empty() && is_doc_patch(operands.front())) {
+        return merge_doc_patches(merge_in.existing_value, operands, merge_out->new_value);
+    }
+
+    uint64_t counter = 0;
+    if(merge_in.existing_value != nullptr) {
+        counter = StringUtils::deserialize_uint32_t(merge_in.existing_value->ToString());
+    }
+
+    for(const auto& operand: operands) {
+        counter += StringUtils::deserialize_uint32_t(operand.ToString());
+    }
+
+    merge_out->new_value = StringUtils::serialize_uint32_t(counter);
+    return true;
+}
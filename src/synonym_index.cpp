@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "synonym_index.h"
 
 
@@ -9,21 +10,46 @@ void SynonymIndex::synonym_reduction_internal(const std::vector<std::string>& to
 
     bool recursed = false;
 
-    for(size_t window_len = start_window_size; window_len > 0; window_len--) {
-        for(size_t start_index = start_index_pos; start_index+window_len-1 < tokens.size(); start_index++) {
-            std::vector<uint64_t> syn_hashes;
-            uint64_t syn_hash = 1;
+    std::vector<uint64_t> token_hashes(tokens.size());
+    for(size_t i = 0; i < tokens.size(); i++) {
+        token_hashes[i] = StringUtils::hash_wy(tokens[i].c_str(), tokens[i].size());
+    }
 
-            for(size_t i = start_index; i < start_index+window_len; i++) {
-                uint64_t token_hash = StringUtils::hash_wy(tokens[i].c_str(), tokens[i].size());
+    // windows of the tokens that are synonym keys: start index and hash of the window, by window length
+    const size_t max_window_len = std::min(start_window_size, tokens.size());
+    std::vector<std::vector<std::pair<size_t, uint64_t>>> key_windows(max_window_len + 1);
 
-                if(i == start_index) {
-                    syn_hash = token_hash;
-                } else {
-                    syn_hash = StringUtils::hash_combine(syn_hash, token_hash);
-                }
+    for(size_t start_index = 0; start_index < tokens.size(); start_index++) {
+        const key_trie_node_t* node = &key_trie;
+        uint64_t syn_hash = 1;
+
+        for(size_t i = start_index; i < start_index + max_window_len && i < tokens.size(); i++) {
+            const auto child_it = node->children.find(token_hashes[i]);
+            if(child_it == node->children.end()) {
+                break;
+            }
+
+            node = child_it->second.get();
+            syn_hash = (i == start_index) ? token_hashes[i] : StringUtils::hash_combine(syn_hash, token_hashes[i]);
+
+            if(node->is_key) {
+                key_windows[i - start_index + 1].emplace_back(start_index, syn_hash);
+            }
+        }
+    }
+
+    if(max_window_len < start_window_size) {
+        // longer windows do not fit in the tokens
+        start_index_pos = 0;
+    }
 
-                syn_hashes.push_back(token_hash);
+    for(size_t window_len = max_window_len; window_len > 0; window_len--) {
+        for(const auto& key_window: key_windows[window_len]) {
+            const size_t start_index = key_window.first;
+            const uint64_t syn_hash = key_window.second;
+
+            if(start_index < start_index_pos) {
+                continue;
             }
 
             const auto& syn_itr = synonym_index.find(syn_hash);
@@ -71,8 +97,8 @@ void SynonymIndex::synonym_reduction_internal(const std::vector<std::string>& to
                             processed_syn_hashes.emplace(h);
                         }
 
-                        for (uint64_t h: syn_hashes) {
-                            processed_syn_hashes.emplace(h);
+                        for (size_t i = start_index; i < start_index + window_len; i++) {
+                            processed_syn_hashes.emplace(token_hashes[i]);
                         }
 
                         recursed = true;
@@ -92,6 +118,49 @@ void SynonymIndex::synonym_reduction_internal(const std::vector<std::string>& to
     }
 }
 
+void SynonymIndex::add_key(const std::vector<std::string>& tokens) {
+    key_trie_node_t* node = &key_trie;
+
+    for(const auto& token: tokens) {
+        auto& child = node->children[StringUtils::hash_wy(token.c_str(), token.size())];
+        if(child == nullptr) {
+            child = std::make_unique<key_trie_node_t>();
+        }
+
+        node = child.get();
+    }
+
+    node->is_key = !tokens.empty();
+}
+
+void SynonymIndex::remove_key(const std::vector<std::string>& tokens) {
+    std::vector<std::pair<key_trie_node_t*, uint64_t>> path;
+    key_trie_node_t* node = &key_trie;
+
+    for(const auto& token: tokens) {
+        uint64_t token_hash = StringUtils::hash_wy(token.c_str(), token.size());
+        auto child_it = node->children.find(token_hash);
+        if(child_it == node->children.end()) {
+            return;
+        }
+
+        path.emplace_back(node, token_hash);
+        node = child_it->second.get();
+    }
+
+    node->is_key = false;
+
+    // prune the nodes that no longer lead to a key
+    for(auto path_it = path.rbegin(); path_it != path.rend(); ++path_it) {
+        auto& child = path_it->first->children[path_it->second];
+        if(child->is_key || !child->children.empty()) {
+            break;
+        }
+
+        path_it->first->children.erase(path_it->second);
+    }
+}
+
 void SynonymIndex::synonym_reduction(const std::vector<std::string>& tokens,
                                    std::vector<std::vector<std::string>>& results) const {
     std::shared_lock lock(mutex);
@@ -121,10 +190,12 @@ Option<bool> SynonymIndex::add_synonym(const std::string & collection_name, cons
     if(!synonym.root.empty()) {
         uint64_t root_hash = synonym_t::get_hash(synonym.root);
         synonym_index[root_hash].emplace_back(synonym.id);
+        add_key(synonym.root);
     } else {
         for(const auto & syn_tokens : synonym.synonyms) {
             uint64_t syn_hash = synonym_t::get_hash(syn_tokens);
             synonym_index[syn_hash].emplace_back(synonym.id);
+            add_key(syn_tokens);
         }
     }
 
@@ -165,10 +236,12 @@ Option<bool> SynonymIndex::remove_synonym(const std::string & collection_name, c
         if(!synonym.root.empty()) {
             uint64_t root_hash = synonym_t::get_hash(synonym.root);
             synonym_index.erase(root_hash);
+            remove_key(synonym.root);
         } else {
             for(const auto & syn_tokens : synonym.synonyms) {
                 uint64_t syn_hash = synonym_t::get_hash(syn_tokens);
                 synonym_index.erase(syn_hash);
+                remove_key(syn_tokens);
             }
         }
 
@@ -28,6 +28,76 @@
 uint64_t SystemMetrics::non_proc_mem_last_access = 0;
 uint64_t SystemMetrics::non_proc_mem_bytes = 0;
 
+std::mutex SystemMetrics::sample_mutex;
+std::vector<cpu_data_t> SystemMetrics::prev_cpu_data;
+std::mutex SystemMetrics::thread_pools_mutex;
+std::vector<SystemMetrics::thread_pool_sample_t> SystemMetrics::thread_pools;
+std::shared_ptr<const nlohmann::json> SystemMetrics::snapshot;
+std::atomic<float> SystemMetrics::cpu_active_percentage = -1;
+
+void SystemMetrics::sample(const std::string& data_dir_path) {
+    std::unique_lock lock(sample_mutex);
+
+    auto metrics = std::make_shared<nlohmann::json>();
+    SystemMetrics sys_metrics;
+    sys_metrics.get(data_dir_path, *metrics);
+    get_thread_pool_metrics(*metrics);
+
+    if(metrics->contains("system_cpu_active_percentage")) {
+        cpu_active_percentage = std::stof((*metrics)["system_cpu_active_percentage"].get<std::string>());
+    }
+
+    std::atomic_store(&snapshot, std::shared_ptr<const nlohmann::json>(std::move(metrics)));
+}
+
+void SystemMetrics::get_snapshot(const std::string& data_dir_path, nlohmann::json& result) {
+    auto last_snapshot = std::atomic_load(&snapshot);
+    if(last_snapshot == nullptr) {
+        sample(data_dir_path);
+        last_snapshot = std::atomic_load(&snapshot);
+    }
+
+    for(const auto& item: last_snapshot->items()) {
+        result[item.key()] = item.value();
+    }
+}
+
+void SystemMetrics::register_thread_pool(const std::string& name, ThreadPool* pool) {
+    std::unique_lock lock(thread_pools_mutex);
+    thread_pools.push_back({name, pool, pool->get_busy_time_us(), std::chrono::steady_clock::now()});
+}
+
+void SystemMetrics::unregister_thread_pools() {
+    std::unique_lock lock(thread_pools_mutex);
+    thread_pools.clear();
+}
+
+void SystemMetrics::get_thread_pool_metrics(nlohmann::json& result) {
+    std::unique_lock lock(thread_pools_mutex);
+    const auto now = std::chrono::steady_clock::now();
+
+    for(auto& pool_sample: thread_pools) {
+        const ThreadPool* pool = pool_sample.pool;
+        const std::string prefix = "typesense_thread_pool_" + pool_sample.name;
+        const uint64_t busy_time_us = pool->get_busy_time_us();
+        const uint64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                        now - pool_sample.prev_sampled_at).count();
+
+        // share of the time of the workers that was spent on tasks since the previous sample
+        const uint64_t capacity_us = elapsed_us * pool->num_threads();
+        const float utilization = (capacity_us == 0) ? 0 :
+                            std::min(100.0f, float(busy_time_us - pool_sample.prev_busy_time_us) * 100 / capacity_us);
+
+        result[prefix + "_threads"] = std::to_string(pool->num_threads());
+        result[prefix + "_busy_threads"] = std::to_string(pool->num_busy_threads());
+        result[prefix + "_pending_tasks"] = std::to_string(pool->num_pending_tasks());
+        result[prefix + "_utilization_percentage"] = format_dp(utilization);
+
+        pool_sample.prev_busy_time_us = busy_time_us;
+        pool_sample.prev_sampled_at = now;
+    }
+}
+
 void SystemMetrics::get(const std::string &data_dir_path, nlohmann::json &result) {
     // DISK METRICS
     struct statvfs st{};
@@ -81,7 +151,21 @@ void SystemMetrics::get(const std::string &data_dir_path, nlohmann::json &result
 #endif
     // CPU and Network metrics
 #if __linux__
-    const std::vector<cpu_stat_t>& cpu_stats = get_cpu_stats();
+    // the usage of the CPUs since the previous call, or over a short pause on the first one
+    if(prev_cpu_data.empty()) {
+        read_cpu_data(prev_cpu_data);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    std::vector<cpu_data_t> cpu_data_now;
+    read_cpu_data(cpu_data_now);
+
+    std::vector<cpu_stat_t> cpu_stats;
+    if(cpu_data_now.size() == prev_cpu_data.size()) {
+        cpu_stats = compute_cpu_stats(prev_cpu_data, cpu_data_now);
+    }
+
+    prev_cpu_data = std::move(cpu_data_now);
 
     for(size_t i = 0; i < cpu_stats.size(); i++) {
         std::string cpu_id = (i == 0) ? "" : std::to_string(i);
@@ -1,18 +1,59 @@
 #include "text_embedder.h"
 #include "embedder_manager.h"
+#include "field.h"
 #include "logger.h"
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <filesystem>
 #include <dlfcn.h>
+#include <thread>
 
-TextEmbedder::TextEmbedder(const std::string& model_name) {
+Option<local_model_options_t> local_model_options_t::parse(const nlohmann::json& model_config) {
+    local_model_options_t options;
+
+    for(const auto& threads_key: {fields::intra_op_threads, fields::inter_op_threads}) {
+        if(model_config.count(threads_key) == 0) {
+            continue;
+        }
+
+        if(!model_config[threads_key].is_number_unsigned()) {
+            return Option<local_model_options_t>(400, "Property `" + fields::embed + "." + fields::model_config + "." +
+                                                      threads_key + "` must be a non-negative integer.");
+        }
+
+        auto& threads = (threads_key == fields::intra_op_threads) ? options.intra_op_threads : options.inter_op_threads;
+        threads = model_config[threads_key].get<size_t>();
+    }
+
+    if(model_config.count(fields::execution_provider) != 0) {
+        if(!model_config[fields::execution_provider].is_string() ||
+           (model_config[fields::execution_provider] != "cpu" && model_config[fields::execution_provider] != "cuda")) {
+            return Option<local_model_options_t>(400, "Property `" + fields::embed + "." + fields::model_config + "." +
+                                                      fields::execution_provider + "` must be one of `cpu`, `cuda`.");
+        }
+
+        options.execution_provider = model_config[fields::execution_provider].get<std::string>();
+    }
+
+    if(model_config.count(fields::quantized) != 0) {
+        if(!model_config[fields::quantized].is_boolean()) {
+            return Option<local_model_options_t>(400, "Property `" + fields::embed + "." + fields::model_config + "." +
+                                                      fields::quantized + "` must be a boolean.");
+        }
+
+        options.quantized = model_config[fields::quantized].get<bool>();
+    }
+
+    return Option<local_model_options_t>(options);
+}
+
+TextEmbedder::TextEmbedder(const std::string& model_name, const local_model_options_t& options) {
     // create environment for local model
     Ort::SessionOptions session_options;
     auto providers = Ort::GetAvailableProviders();
     for(auto& provider : providers) {
-        if(provider == "CUDAExecutionProvider") {
+        if(provider == "CUDAExecutionProvider" && options.execution_provider != "cpu") {
 
             // check existence of shared lib
             void* handle = dlopen("libonnxruntime_providers_shared.so", RTLD_NOW | RTLD_GLOBAL);
@@ -28,11 +69,30 @@ TextEmbedder::TextEmbedder(const std::string& model_name) {
             session_options.AppendExecutionProvider_CUDA(cuda_options);
         }
     }
-    std::string abs_path = EmbedderManager::get_absolute_model_path(model_name);
+
+    if(options.intra_op_threads != 0) {
+        session_options.SetIntraOpNumThreads(options.intra_op_threads);
+    }
+
+    if(options.inter_op_threads != 0) {
+        // threads across operators are only used when independent operators run in parallel
+        session_options.SetInterOpNumThreads(options.inter_op_threads);
+        session_options.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
+    }
+
+    std::string abs_path = options.quantized ? EmbedderManager::get_absolute_quantized_model_path(model_name) :
+                           EmbedderManager::get_absolute_model_path(model_name);
     session_options.EnableOrtCustomOps();
     LOG(INFO) << "Loading model from disk: " << abs_path;
     env_ = std::make_shared<Ort::Env>();
     session_ = std::make_shared<Ort::Session>(*env_, abs_path.c_str(), session_options);
+    query_batcher_ = std::make_unique<embedding_batcher_t>([this](const std::vector<std::string>& texts) {
+        if(texts.size() == 1) {
+            return std::vector<embedding_res_t>{Embed(texts[0])};
+        }
+
+        return batch_embed(texts);
+    });
     std::ifstream config_file(EmbedderManager::get_absolute_config_path(model_name));
     nlohmann::json config;
     config_file >> config;
@@ -194,8 +254,25 @@ std::vector<embedding_res_t> TextEmbedder::batch_embed(const std::vector<std::st
     std::vector<embedding_res_t> outputs;
     if(!is_remote()) {
         std::lock_guard<std::mutex> lock(mutex_);
-        for(int i = 0; i < inputs.size(); i += 8) {
-            auto input_batch = std::vector<std::string>(inputs.begin() + i, inputs.begin() + std::min(i + 8, static_cast<int>(inputs.size())));
+
+        // inputs of similar token counts are batched together, so that a long input pads only few others
+        std::vector<encoded_input_t> encoded(inputs.size());
+        std::vector<size_t> order(inputs.size());
+        for(size_t i = 0; i < inputs.size(); i++) {
+            encoded[i] = tokenizer_->Encode(inputs[i]);
+            order[i] = i;
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return encoded[a].input_ids.size() < encoded[b].input_ids.size();
+        });
+
+        for(size_t i = 0; i < inputs.size(); i += 8) {
+            std::vector<const encoded_input_t*> input_batch;
+            for(size_t j = i; j < std::min(i + 8, inputs.size()); j++) {
+                input_batch.push_back(&encoded[order[j]]);
+            }
+
             auto encoded_inputs = batch_encode(input_batch);
             
             // create input tensor object from data values
@@ -294,22 +371,94 @@ std::vector<embedding_res_t> TextEmbedder::batch_embed(const std::vector<std::st
                 }
             }
         }
+
+        if(outputs.size() == inputs.size()) {
+            // back in the order of the inputs
+            std::vector<embedding_res_t> sorted_outputs = std::move(outputs);
+            outputs.assign(inputs.size(), embedding_res_t());
+            for(size_t i = 0; i < order.size(); i++) {
+                outputs[order[i]] = std::move(sorted_outputs[i]);
+            }
+        }
     } else {
-        outputs = std::move(remote_embedder_->batch_embed(inputs, remote_embedding_batch_size, remote_embedding_timeout_ms, remote_embedding_num_tries));
+        outputs = remote_batch_embed(inputs, remote_embedding_batch_size, remote_embedding_timeout_ms, remote_embedding_num_tries);
     }
     
     return outputs;
 }
 
+std::vector<embedding_res_t> TextEmbedder::remote_batch_embed(const std::vector<std::string>& inputs, const size_t remote_embedding_batch_size,
+                                                              const size_t remote_embedding_timeout_ms, const size_t remote_embedding_num_tries) {
+    const size_t batch_size = std::max<size_t>(remote_embedding_batch_size, 1);
+    const size_t num_batches = (inputs.size() + batch_size - 1) / batch_size;
+    const size_t num_workers = std::min(num_batches, EmbedderManager::get_remote_embedding_concurrency());
+
+    if(num_workers <= 1) {
+        return remote_embedder_->batch_embed(inputs, remote_embedding_batch_size, remote_embedding_timeout_ms, remote_embedding_num_tries);
+    }
+
+    // a few batches are sent at a time, so that a large import does not wait on each round trip in turn
+    std::vector<std::vector<embedding_res_t>> batch_outputs(num_batches);
+    std::atomic<size_t> next_batch = 0;
+
+    auto worker = [&]() {
+        for(size_t batch = next_batch++; batch < num_batches; batch = next_batch++) {
+            const size_t begin = batch * batch_size;
+            const size_t end = std::min(begin + batch_size, inputs.size());
+            const std::vector<std::string> batch_inputs(inputs.begin() + begin, inputs.begin() + end);
+            batch_outputs[batch] = remote_embedder_->batch_embed(batch_inputs, remote_embedding_batch_size,
+                                                                 remote_embedding_timeout_ms, remote_embedding_num_tries);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for(size_t i = 1; i < num_workers; i++) {
+        workers.emplace_back(worker);
+    }
+
+    worker();
+
+    for(auto& thread: workers) {
+        thread.join();
+    }
+
+    std::vector<embedding_res_t> outputs;
+    outputs.reserve(inputs.size());
+    for(auto& batch_output: batch_outputs) {
+        std::move(batch_output.begin(), batch_output.end(), std::back_inserter(outputs));
+    }
+
+    return outputs;
+}
+
+embedding_res_t TextEmbedder::embed_query(const std::string& text, const size_t remote_embedder_timeout_ms, const size_t remote_embedding_num_tries) {
+    std::vector<float> embedding;
+    if(query_cache_.get(text, embedding)) {
+        return embedding_res_t(embedding);
+    }
+
+    embedding_res_t res;
+    if(is_remote() || query_batcher_ == nullptr) {
+        res = Embed(text, remote_embedder_timeout_ms, remote_embedding_num_tries);
+    } else {
+        res = query_batcher_->embed(text, EmbedderManager::get_query_batch_window());
+    }
+
+    if(res.success) {
+        query_cache_.insert(text, res.embedding);
+    }
+
+    return res;
+}
+
 TextEmbedder::~TextEmbedder() { }
 
-batch_encoded_input_t TextEmbedder::batch_encode(const std::vector<std::string>& inputs) {
+batch_encoded_input_t TextEmbedder::batch_encode(const std::vector<const encoded_input_t*>& inputs) {
     batch_encoded_input_t encoded_inputs;
-    for(auto& input : inputs) {
-        auto encoded_input = tokenizer_->Encode(input);
-        encoded_inputs.input_ids.push_back(encoded_input.input_ids);
-        encoded_inputs.attention_mask.push_back(encoded_input.attention_mask);
-        encoded_inputs.token_type_ids.push_back(encoded_input.token_type_ids);
+    for(auto encoded_input : inputs) {
+        encoded_inputs.input_ids.push_back(encoded_input->input_ids);
+        encoded_inputs.attention_mask.push_back(encoded_input->attention_mask);
+        encoded_inputs.token_type_ids.push_back(encoded_input->token_type_ids);
     }
 
     // Pad inputs
@@ -2,6 +2,12 @@
 #include "thread_local_vars.h"
 
 thread_local int64_t write_log_index = 0;
+thread_local int64_t write_log_first_index = -1;
 thread_local uint64_t search_begin_us;
 thread_local uint64_t search_stop_us;
 thread_local bool search_cutoff = false;
+thread_local search_profile_t* search_profile = nullptr;
+thread_local request_cost_t* request_cost = nullptr;
+thread_local bool is_warmup_search = false;
+
+thread_local ref_doc_cache_t* ref_doc_cache = nullptr;
\ No newline at end of file
@@ -1,14 +1,24 @@
 #include <sstream>
 #include <algorithm>
+#include <unordered_map>
 #include <string_utils.h>
 #include "tokenizer.h"
 #include <unicode/uchar.h>
 
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <sse2neon.h>
+#endif
+
 Tokenizer::Tokenizer(const std::string& input, bool normalize, bool no_op, const std::string& locale,
                      const std::vector<char>& symbols_to_index,
                      const std::vector<char>& separators):
                      i(0), normalize(normalize), no_op(no_op), locale(locale) {
 
+    uint8_t index_symbols[256] = {};
+    uint8_t separator_symbols[256] = {};
+
     for(char c: symbols_to_index) {
         index_symbols[uint8_t(c)] = 1;
     }
@@ -17,6 +27,14 @@ Tokenizer::Tokenizer(const std::string& input, bool normalize, bool no_op, const
         separator_symbols[uint8_t(c)] = 1;
     }
 
+    for(size_t b = 0; b < 256; b++) {
+        const char c = char(b);
+        const bool is_alnum = is_ascii_char(c) && std::isalnum(c);
+        stream_modes[b] = (is_alnum || index_symbols[b] == 1) ? INDEX : (
+            (c == ' ' || c == '\n' || separator_symbols[b] == 1) ? SEPARATE : SKIP
+        );
+    }
+
     UErrorCode errcode = U_ZERO_ERROR;
 
     if(locale == "ko") {
@@ -33,13 +51,17 @@ Tokenizer::Tokenizer(const std::string& input, bool normalize, bool no_op, const
 }
 
 
-void Tokenizer::init(const std::string& input) {
+void Tokenizer::init(const std::string& input, bool is_normalized) {
     // init() can be called multiple times safely without leaking memory as we check for prior initialization
     if(normalized_text) {
         free(normalized_text);
         normalized_text = nullptr;
     }
 
+    i = 0;
+    token_counter = 0;
+    out.clear();
+
     if(locale == "zh") {
         UErrorCode translit_status = U_ZERO_ERROR;
         if(!transliterator) {
@@ -62,9 +84,9 @@ void Tokenizer::init(const std::string& input) {
     }
 
     else if(locale == "ja") {
-        if(normalize) {
-            normalized_text = JapaneseLocalizer::get_instance().normalize(input);
-            text = normalized_text;
+        if(normalize && !is_normalized) {
+            JapaneseLocalizer::get_instance().normalize(input, normalized_ja_text);
+            text = normalized_ja_text;
         } else {
             text = input;
         }
@@ -103,6 +125,58 @@ void Tokenizer::init(const std::string& input) {
     }
 }
 
+struct tokenizer_pool_t {
+    std::unordered_multimap<std::string, std::unique_ptr<Tokenizer>> tokenizers;
+};
+
+static thread_local tokenizer_pool_t tokenizer_pool;
+
+std::string Tokenizer::get_pool_key(bool normalize, bool no_op, const std::string& locale,
+                                    const std::vector<char>& symbols_to_index, const std::vector<char>& separators) {
+    std::string key;
+    key.reserve(locale.size() + symbols_to_index.size() + separators.size() + 4);
+    key += char(normalize);
+    key += char(no_op);
+    key += locale;
+    key += '\0';
+    key.append(symbols_to_index.begin(), symbols_to_index.end());
+    key += '\0';
+    key.append(separators.begin(), separators.end());
+    return key;
+}
+
+Tokenizer::pooled_ptr_t Tokenizer::acquire(const std::string& input, bool normalize, bool no_op,
+                                           const std::string& locale, const std::vector<char>& symbols_to_index,
+                                           const std::vector<char>& separators) {
+    std::string key = get_pool_key(normalize, no_op, locale, symbols_to_index, separators);
+    auto& tokenizers = tokenizer_pool.tokenizers;
+    auto it = tokenizers.find(key);
+
+    if(it == tokenizers.end()) {
+        auto tokenizer = new Tokenizer(input, normalize, no_op, locale, symbols_to_index, separators);
+        tokenizer->pool_key = std::move(key);
+        return pooled_ptr_t(tokenizer);
+    }
+
+    Tokenizer* tokenizer = it->second.release();
+    tokenizers.erase(it);
+    tokenizer->init(input);
+    return pooled_ptr_t(tokenizer);
+}
+
+void Tokenizer::pool_releaser_t::operator()(Tokenizer* tokenizer) const {
+    auto& tokenizers = tokenizer_pool.tokenizers;
+    if(tokenizers.size() >= MAX_POOLED_TOKENIZERS) {
+        delete tokenizer;
+        return;
+    }
+
+    // the pooled tokenizer must not keep pointing to the text of its last user
+    static const std::string empty_text;
+    tokenizer->init(empty_text);
+    tokenizers.emplace(tokenizer->pool_key, std::unique_ptr<Tokenizer>(tokenizer));
+}
+
 bool Tokenizer::belongs_to_general_punctuation_unicode_block(UChar c) {
     UBlockCode blockCode = ublock_getCode(c);
     return blockCode == UBLOCK_GENERAL_PUNCTUATION;
@@ -161,10 +235,9 @@ bool Tokenizer::next(std::string &token, size_t& token_index, size_t& start_inde
                 }
             } else if(normalize && locale == "ja") {
                 auto raw_text = unicode_text.tempSubStringBetween(start_pos, end_pos);
-                raw_text.toUTF8String(word);
-                char* normalized_word = JapaneseLocalizer::get_instance().normalize(word);
-                word.assign(normalized_word, strlen(normalized_word));
-                free(normalized_word);
+                std::string raw_word;
+                raw_text.toUTF8String(raw_word);
+                JapaneseLocalizer::get_instance().normalize(raw_word, word);
             } else {
                 unicode_text.tempSubStringBetween(start_pos, end_pos).foldCase().toUTF8String(word);
             }
@@ -256,6 +329,13 @@ bool Tokenizer::next(std::string &token, size_t& token_index, size_t& start_inde
                     start_index = i;
                 }
 
+                const size_t run_end = append_ascii_alnum_run(i);
+                if(run_end != i) {
+                    i = run_end;
+                    continue;
+                }
+
+                // symbol that is configured to be indexed
                 out += normalize ? char(std::tolower(text[i])) : text[i];
                 i++;
                 continue;
@@ -327,6 +407,49 @@ bool Tokenizer::next(std::string &token, size_t& token_index, size_t& start_inde
     return true;
 }
 
+size_t Tokenizer::append_ascii_alnum_run(size_t start) {
+    size_t i = start;
+
+#if defined(__x86_64__) || defined(__aarch64__)
+    // classify and lowercase 16 bytes at a time: non-ASCII bytes are negative as signed chars and so never
+    // fall inside the alphanumeric ranges
+    const __m128i digit_lo = _mm_set1_epi8('0' - 1);
+    const __m128i digit_hi = _mm_set1_epi8('9' + 1);
+    const __m128i alpha_lo = _mm_set1_epi8('a' - 1);
+    const __m128i alpha_hi = _mm_set1_epi8('z' + 1);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    alignas(16) char block_out[16];
+
+    while(i + 16 <= text.size()) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+        const __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(block, digit_lo), _mm_cmplt_epi8(block, digit_hi));
+        const __m128i folded = _mm_or_si128(block, case_bit);
+        const __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(folded, alpha_lo), _mm_cmplt_epi8(folded, alpha_hi));
+        const int alnum_mask = _mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha));
+
+        const __m128i lowered = normalize ?
+                                _mm_or_si128(_mm_and_si128(is_alpha, folded), _mm_andnot_si128(is_alpha, block)) :
+                                block;
+        _mm_store_si128(reinterpret_cast<__m128i*>(block_out), lowered);
+
+        const size_t run_len = (alnum_mask == 0xFFFF) ? 16 : __builtin_ctz(~alnum_mask);
+        out.append(block_out, run_len);
+        i += run_len;
+
+        if(run_len != 16) {
+            return i;
+        }
+    }
+#endif
+
+    while(i < text.size() && is_ascii_char(text[i]) && std::isalnum(text[i])) {
+        out += normalize ? char(std::tolower(text[i])) : text[i];
+        i++;
+    }
+
+    return i;
+}
+
 void Tokenizer::tokenize(std::vector<std::string> &tokens) {
     std::string token;
     size_t token_index;
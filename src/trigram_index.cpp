@@ -0,0 +1,115 @@
+#include "trigram_index.h"
+#include <algorithm>
+
+std::atomic<bool> trigram_index_t::enabled(false);
+
+trigram_index_t::~trigram_index_t() {
+    for(auto& kv: trigram_token_ids) {
+        ids_t::destroy_list(kv.second);
+    }
+}
+
+void trigram_index_t::get_trigrams(const std::string& token, std::vector<uint32_t>& trigrams) {
+    trigrams.clear();
+
+    for(size_t i = 0; i + TRIGRAM_LEN <= token.size(); i++) {
+        trigrams.push_back((uint32_t((unsigned char) token[i]) << 16) |
+                           (uint32_t((unsigned char) token[i + 1]) << 8) |
+                           uint32_t((unsigned char) token[i + 2]));
+    }
+
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+void trigram_index_t::insert(const std::string& token) {
+    if(token_ids.count(token) != 0) {
+        return;
+    }
+
+    const uint32_t token_id = next_token_id++;
+    token_ids.emplace(token, token_id);
+    id_tokens.emplace(token_id, token);
+
+    std::vector<uint32_t> trigrams;
+    get_trigrams(token, trigrams);
+
+    for(auto trigram: trigrams) {
+        auto it = trigram_token_ids.find(trigram);
+        if(it == trigram_token_ids.end()) {
+            trigram_token_ids.emplace(trigram, SET_COMPACT_IDS(compact_id_list_t::create(1, {token_id})));
+        } else {
+            ids_t::upsert(it->second, token_id);
+        }
+    }
+}
+
+void trigram_index_t::erase(const std::string& token) {
+    auto token_it = token_ids.find(token);
+    if(token_it == token_ids.end()) {
+        return;
+    }
+
+    const uint32_t token_id = token_it->second;
+    token_ids.erase(token_it);
+    id_tokens.erase(token_id);
+
+    std::vector<uint32_t> trigrams;
+    get_trigrams(token, trigrams);
+
+    for(auto trigram: trigrams) {
+        auto it = trigram_token_ids.find(trigram);
+        if(it == trigram_token_ids.end()) {
+            continue;
+        }
+
+        ids_t::erase(it->second, token_id);
+
+        if(ids_t::num_ids(it->second) == 0) {
+            ids_t::destroy_list(it->second);
+            trigram_token_ids.erase(it);
+        }
+    }
+}
+
+bool trigram_index_t::search(const std::string& query, size_t max_extra_prefix, size_t max_extra_suffix,
+                             std::vector<std::string>& tokens) const {
+    if(query.size() < TRIGRAM_LEN) {
+        return false;
+    }
+
+    std::vector<uint32_t> trigrams;
+    get_trigrams(query, trigrams);
+
+    std::vector<void*> id_lists;
+    for(auto trigram: trigrams) {
+        auto it = trigram_token_ids.find(trigram);
+        if(it == trigram_token_ids.end()) {
+            // no token has every trigram of the query
+            return true;
+        }
+
+        id_lists.push_back(it->second);
+    }
+
+    // the shortest list first, so that the intersection is driven by it
+    std::sort(id_lists.begin(), id_lists.end(), [](const void* a, const void* b) {
+        return ids_t::num_ids(a) < ids_t::num_ids(b);
+    });
+
+    std::vector<uint32_t> candidate_ids;
+    ids_t::intersect(id_lists, candidate_ids);
+
+    for(auto token_id: candidate_ids) {
+        const std::string& token = id_tokens.at(token_id);
+
+        // having all the trigrams of the query does not make the query a substring of the token
+        auto start_index = token.find(query);
+        if(start_index != std::string::npos && start_index <= max_extra_prefix &&
+           (token.size() - (start_index + query.size())) <= max_extra_suffix) {
+            tokens.push_back(token);
+        }
+    }
+
+    return true;
+}
@@ -202,6 +202,34 @@ void Config::load_config_env() {
         this->log_slow_searches_time_ms = std::stoi(get_env("TYPESENSE_LOG_SLOW_SEARCHES_TIME_MS"));
     }
 
+    if(!get_env("TYPESENSE_SEARCH_WARMUP_TIME_MS").empty()) {
+        this->search_warmup_time_ms = std::stoi(get_env("TYPESENSE_SEARCH_WARMUP_TIME_MS"));
+    }
+
+    if(!get_env("TYPESENSE_COLLECTION_IDLE_EVICTION_SECS").empty()) {
+        this->collection_idle_eviction_secs = std::stoi(get_env("TYPESENSE_COLLECTION_IDLE_EVICTION_SECS"));
+    }
+
+    if(!get_env("TYPESENSE_COLLECTION_RESTORE_BUDGET_MS").empty()) {
+        this->collection_restore_budget_ms = std::stoi(get_env("TYPESENSE_COLLECTION_RESTORE_BUDGET_MS"));
+    }
+
+    if(!get_env("TYPESENSE_HOT_COLLECTIONS").empty()) {
+        this->hot_collections = get_env("TYPESENSE_HOT_COLLECTIONS");
+    }
+
+    if(!get_env("TYPESENSE_DOC_ID_INDEX").empty()) {
+        this->doc_id_index = get_env("TYPESENSE_DOC_ID_INDEX");
+    }
+
+    if(!get_env("TYPESENSE_VOICE_QUERY_PARALLELISM").empty()) {
+        this->voice_query_parallelism = std::stoi(get_env("TYPESENSE_VOICE_QUERY_PARALLELISM"));
+    }
+
+    if(!get_env("TYPESENSE_VOICE_QUERY_MAX_AUDIO_SECS").empty()) {
+        this->voice_query_max_audio_secs = std::stoi(get_env("TYPESENSE_VOICE_QUERY_MAX_AUDIO_SECS"));
+    }
+
     if(!get_env("TYPESENSE_NUM_COLLECTIONS_PARALLEL_LOAD").empty()) {
         this->num_collections_parallel_load = std::stoi(get_env("TYPESENSE_NUM_COLLECTIONS_PARALLEL_LOAD"));
     }
@@ -214,6 +242,38 @@ void Config::load_config_env() {
         this->cache_num_entries = std::stoi(get_env("TYPESENSE_CACHE_NUM_ENTRIES"));
     }
 
+    if(!get_env("TYPESENSE_CACHE_MAX_MEMORY_MB").empty()) {
+        this->cache_max_memory_mb = std::stoi(get_env("TYPESENSE_CACHE_MAX_MEMORY_MB"));
+    }
+
+    if(!get_env("TYPESENSE_CACHE_COMPRESS_MIN_BYTES").empty()) {
+        this->cache_compress_min_bytes = std::stoi(get_env("TYPESENSE_CACHE_COMPRESS_MIN_BYTES"));
+    }
+
+    if(!get_env("TYPESENSE_HTTP_COMPRESS_MIN_BYTES").empty()) {
+        this->http_compress_min_bytes = std::stoi(get_env("TYPESENSE_HTTP_COMPRESS_MIN_BYTES"));
+    }
+
+    if(!get_env("TYPESENSE_TYPO_CACHE_NUM_ENTRIES").empty()) {
+        this->typo_cache_num_entries = std::stoi(get_env("TYPESENSE_TYPO_CACHE_NUM_ENTRIES"));
+    }
+
+    if(!get_env("TYPESENSE_EMBEDDING_QUERY_BATCH_WINDOW_MS").empty()) {
+        this->embedding_query_batch_window_ms = std::stoi(get_env("TYPESENSE_EMBEDDING_QUERY_BATCH_WINDOW_MS"));
+    }
+
+    if(!get_env("TYPESENSE_EMBEDDING_CACHE_NUM_ENTRIES").empty()) {
+        this->embedding_cache_num_entries = std::stoi(get_env("TYPESENSE_EMBEDDING_CACHE_NUM_ENTRIES"));
+    }
+
+    if(!get_env("TYPESENSE_STEM_CACHE_NUM_ENTRIES").empty()) {
+        this->stem_cache_num_entries = std::stoi(get_env("TYPESENSE_STEM_CACHE_NUM_ENTRIES"));
+    }
+
+    if(!get_env("TYPESENSE_REMOTE_EMBEDDING_CONCURRENCY").empty()) {
+        this->remote_embedding_concurrency = std::stoi(get_env("TYPESENSE_REMOTE_EMBEDDING_CONCURRENCY"));
+    }
+
     if(!get_env("TYPESENSE_ANALYTICS_FLUSH_INTERVAL").empty()) {
         this->analytics_flush_interval = std::stoi(get_env("TYPESENSE_ANALYTICS_FLUSH_INTERVAL"));
     }
@@ -222,14 +282,70 @@ void Config::load_config_env() {
         this->housekeeping_interval = std::stoi(get_env("TYPESENSE_HOUSEKEEPING_INTERVAL"));
     }
 
+    if(!get_env("TYPESENSE_HOUSEKEEPING_BUDGET_MS").empty()) {
+        this->housekeeping_budget_ms = std::stoi(get_env("TYPESENSE_HOUSEKEEPING_BUDGET_MS"));
+    }
+
     if(!get_env("TYPESENSE_DB_COMPACTION_INTERVAL").empty()) {
         this->db_compaction_interval = std::stoi(get_env("TYPESENSE_DB_COMPACTION_INTERVAL"));
     }
 
+    if(!get_env("TYPESENSE_DB_BLOCK_CACHE_MB").empty()) {
+        this->db_block_cache_mb = std::stoi(get_env("TYPESENSE_DB_BLOCK_CACHE_MB"));
+    }
+
+    if(!get_env("TYPESENSE_DB_BLOOM_BITS_PER_KEY").empty()) {
+        this->db_bloom_bits_per_key = std::stoi(get_env("TYPESENSE_DB_BLOOM_BITS_PER_KEY"));
+    }
+
+    if(!get_env("TYPESENSE_DB_ROW_CACHE_MB").empty()) {
+        this->db_row_cache_mb = std::stoi(get_env("TYPESENSE_DB_ROW_CACHE_MB"));
+    }
+
+    this->db_compaction_direct_io = ("TRUE" == get_env("TYPESENSE_DB_COMPACTION_DIRECT_IO"));
+
+    if(!get_env("TYPESENSE_DB_COMPACTION_RATE_LIMIT_MB").empty()) {
+        this->db_compaction_rate_limit_mb = std::stoi(get_env("TYPESENSE_DB_COMPACTION_RATE_LIMIT_MB"));
+    }
+
     if(!get_env("TYPESENSE_THREAD_POOL_SIZE").empty()) {
         this->thread_pool_size = std::stoi(get_env("TYPESENSE_THREAD_POOL_SIZE"));
     }
 
+    if(!get_env("TYPESENSE_NUM_HTTP_EVENT_LOOPS").empty()) {
+        this->num_http_event_loops = std::stoi(get_env("TYPESENSE_NUM_HTTP_EVENT_LOOPS"));
+    }
+
+    if(!get_env("TYPESENSE_INDEXING_THREAD_POOL_SIZE").empty()) {
+        this->indexing_thread_pool_size = std::stoi(get_env("TYPESENSE_INDEXING_THREAD_POOL_SIZE"));
+    }
+
+    if(!get_env("TYPESENSE_INDEX_BATCH_CONCURRENCY").empty()) {
+        this->index_batch_concurrency = std::stoi(get_env("TYPESENSE_INDEX_BATCH_CONCURRENCY"));
+    }
+
+    if(!get_env("TYPESENSE_MULTI_SEARCH_CONCURRENCY").empty()) {
+        this->multi_search_concurrency = std::stoi(get_env("TYPESENSE_MULTI_SEARCH_CONCURRENCY"));
+    }
+
+    if(!get_env("TYPESENSE_HITS_PARALLEL_THRESHOLD").empty()) {
+        this->hits_parallel_threshold = std::stoi(get_env("TYPESENSE_HITS_PARALLEL_THRESHOLD"));
+    }
+
+    if(!get_env("TYPESENSE_SEARCH_DEGRADATION_LOAD_PERCENT").empty()) {
+        this->search_degradation_load_percent = std::stoi(get_env("TYPESENSE_SEARCH_DEGRADATION_LOAD_PERCENT"));
+    }
+
+    if(!get_env("TYPESENSE_MEMORY_DIRTY_DECAY_MS").empty()) {
+        this->memory_dirty_decay_ms = std::stoi(get_env("TYPESENSE_MEMORY_DIRTY_DECAY_MS"));
+    }
+
+    if(!get_env("TYPESENSE_MEMORY_MUZZY_DECAY_MS").empty()) {
+        this->memory_muzzy_decay_ms = std::stoi(get_env("TYPESENSE_MEMORY_MUZZY_DECAY_MS"));
+    }
+
+    this->indexing_cpu_affinity = get_env("TYPESENSE_INDEXING_CPU_AFFINITY");
+
     if(!get_env("TYPESENSE_SSL_REFRESH_INTERVAL_SECONDS").empty()) {
         this->ssl_refresh_interval_seconds = std::stoi(get_env("TYPESENSE_SSL_REFRESH_INTERVAL_SECONDS"));
     }
@@ -238,9 +354,33 @@ void Config::load_config_env() {
         this->snapshot_max_byte_count_per_rpc = std::stoi(get_env("TYPESENSE_SNAPSHOT_MAX_BYTE_COUNT_PER_RPC"));
     }
 
+    if(!get_env("TYPESENSE_WRITE_BATCH_WINDOW_US").empty()) {
+        this->write_batch_window_us = std::stoul(get_env("TYPESENSE_WRITE_BATCH_WINDOW_US"));
+    }
+
+    if(!get_env("TYPESENSE_WRITE_BATCH_MAX_BYTES").empty()) {
+        this->write_batch_max_bytes = std::stoul(get_env("TYPESENSE_WRITE_BATCH_MAX_BYTES"));
+    }
+
+    if(!get_env("TYPESENSE_LOG_COMPRESSION_MIN_BYTES").empty()) {
+        this->log_compression_min_bytes = std::stoul(get_env("TYPESENSE_LOG_COMPRESSION_MIN_BYTES"));
+    }
+
+    this->learner = ("TRUE" == get_env("TYPESENSE_LEARNER"));
+
+    if(!get_env("TYPESENSE_LEARNER_FEED_MAX_BYTES").empty()) {
+        this->learner_feed_max_bytes = std::stoul(get_env("TYPESENSE_LEARNER_FEED_MAX_BYTES"));
+    }
+
+    if(!get_env("TYPESENSE_QUEUED_REQUEST_MEMORY_MAX_BYTES").empty()) {
+        this->queued_request_memory_max_bytes = std::stoul(get_env("TYPESENSE_QUEUED_REQUEST_MEMORY_MAX_BYTES"));
+    }
+
     this->enable_access_logging = ("TRUE" == get_env("TYPESENSE_ENABLE_ACCESS_LOGGING"));
     this->enable_search_analytics = ("TRUE" == get_env("TYPESENSE_ENABLE_SEARCH_ANALYTICS"));
     this->enable_search_logging = ("TRUE" == get_env("TYPESENSE_ENABLE_SEARCH_LOGGING"));
+    this->enable_search_admission_control = ("TRUE" == get_env("TYPESENSE_ENABLE_SEARCH_ADMISSION_CONTROL"));
+    this->enable_memory_arenas = ("TRUE" == get_env("TYPESENSE_ENABLE_MEMORY_ARENAS"));
 
     if(!get_env("TYPESENSE_DISK_USED_MAX_PERCENTAGE").empty()) {
         this->disk_used_max_percentage = std::stoi(get_env("TYPESENSE_DISK_USED_MAX_PERCENTAGE"));
@@ -252,6 +392,10 @@ void Config::load_config_env() {
 
     this->skip_writes = ("TRUE" == get_env("TYPESENSE_SKIP_WRITES"));
     this->enable_lazy_filter = ("TRUE" == get_env("TYPESENSE_ENABLE_LAZY_FILTER"));
+    this->enable_infix_trigram_index = ("TRUE" == get_env("TYPESENSE_ENABLE_INFIX_TRIGRAM_INDEX"));
+    this->enable_index_image = ("TRUE" == get_env("TYPESENSE_ENABLE_INDEX_IMAGE"));
+    this->enable_deferred_deletes = ("TRUE" == get_env("TYPESENSE_ENABLE_DEFERRED_DELETES"));
+    this->enable_vector_gpu_scoring = ("TRUE" == get_env("TYPESENSE_ENABLE_VECTOR_GPU_SCORING"));
     this->reset_peers_on_error = ("TRUE" == get_env("TYPESENSE_RESET_PEERS_ON_ERROR"));
 }
 
@@ -367,6 +511,33 @@ void Config::load_config_file(cmdline::parser& options) {
         this->snapshot_max_byte_count_per_rpc = (int) reader.GetInteger("server", "snapshot-max-byte-count-per-rpc", 4194304);
     }
 
+    if(reader.Exists("server", "write-batch-window-us")) {
+        this->write_batch_window_us = (uint32_t) reader.GetInteger("server", "write-batch-window-us", 0);
+    }
+
+    if(reader.Exists("server", "write-batch-max-bytes")) {
+        this->write_batch_max_bytes = (uint32_t) reader.GetInteger("server", "write-batch-max-bytes", 1048576);
+    }
+
+    if(reader.Exists("server", "log-compression-min-bytes")) {
+        this->log_compression_min_bytes = (uint32_t) reader.GetInteger("server", "log-compression-min-bytes", 0);
+    }
+
+    if(reader.Exists("server", "learner")) {
+        auto learner_str = reader.Get("server", "learner", "false");
+        this->learner = (learner_str == "true");
+    }
+
+    if(reader.Exists("server", "learner-feed-max-bytes")) {
+        this->learner_feed_max_bytes = (uint32_t) reader.GetInteger("server", "learner-feed-max-bytes", 0);
+    }
+
+    if(reader.Exists("server", "queued-request-memory-max-bytes")) {
+        this->queued_request_memory_max_bytes = (uint32_t) reader.GetInteger("server",
+                                                                             "queued-request-memory-max-bytes",
+                                                                             1048576);
+    }
+
     if(reader.Exists("server", "healthy-read-lag")) {
         this->healthy_read_lag = (size_t) reader.GetInteger("server", "healthy-read-lag", 1000);
     }
@@ -383,6 +554,34 @@ void Config::load_config_file(cmdline::parser& options) {
         this->log_slow_searches_time_ms = (int) reader.GetInteger("server", "log-slow-searches-time-ms", 30*1000);
     }
 
+    if(reader.Exists("server", "search-warmup-time-ms")) {
+        this->search_warmup_time_ms = (int) reader.GetInteger("server", "search-warmup-time-ms", 0);
+    }
+
+    if(reader.Exists("server", "collection-idle-eviction-secs")) {
+        this->collection_idle_eviction_secs = (int) reader.GetInteger("server", "collection-idle-eviction-secs", 0);
+    }
+
+    if(reader.Exists("server", "collection-restore-budget-ms")) {
+        this->collection_restore_budget_ms = (int) reader.GetInteger("server", "collection-restore-budget-ms", 1000);
+    }
+
+    if(reader.Exists("server", "hot-collections")) {
+        this->hot_collections = reader.Get("server", "hot-collections", "");
+    }
+
+    if(reader.Exists("server", "doc-id-index")) {
+        this->doc_id_index = reader.Get("server", "doc-id-index", "off");
+    }
+
+    if(reader.Exists("server", "voice-query-parallelism")) {
+        this->voice_query_parallelism = (int) reader.GetInteger("server", "voice-query-parallelism", 2);
+    }
+
+    if(reader.Exists("server", "voice-query-max-audio-secs")) {
+        this->voice_query_max_audio_secs = (int) reader.GetInteger("server", "voice-query-max-audio-secs", 30);
+    }
+
     if(reader.Exists("server", "num-collections-parallel-load")) {
         this->num_collections_parallel_load = (int) reader.GetInteger("server", "num-collections-parallel-load", 0);
     }
@@ -395,6 +594,38 @@ void Config::load_config_file(cmdline::parser& options) {
         this->cache_num_entries = (int) reader.GetInteger("server", "cache-num-entries", 1000);
     }
 
+    if(reader.Exists("server", "cache-max-memory-mb")) {
+        this->cache_max_memory_mb = (int) reader.GetInteger("server", "cache-max-memory-mb", 0);
+    }
+
+    if(reader.Exists("server", "cache-compress-min-bytes")) {
+        this->cache_compress_min_bytes = (int) reader.GetInteger("server", "cache-compress-min-bytes", 0);
+    }
+
+    if(reader.Exists("server", "http-compress-min-bytes")) {
+        this->http_compress_min_bytes = (int) reader.GetInteger("server", "http-compress-min-bytes", 256);
+    }
+
+    if(reader.Exists("server", "typo-cache-num-entries")) {
+        this->typo_cache_num_entries = (int) reader.GetInteger("server", "typo-cache-num-entries", 1024);
+    }
+
+    if(reader.Exists("server", "embedding-query-batch-window-ms")) {
+        this->embedding_query_batch_window_ms = (int) reader.GetInteger("server", "embedding-query-batch-window-ms", 0);
+    }
+
+    if(reader.Exists("server", "embedding-cache-num-entries")) {
+        this->embedding_cache_num_entries = (int) reader.GetInteger("server", "embedding-cache-num-entries", 1000);
+    }
+
+    if(reader.Exists("server", "stem-cache-num-entries")) {
+        this->stem_cache_num_entries = (int) reader.GetInteger("server", "stem-cache-num-entries", 64 * 1024);
+    }
+
+    if(reader.Exists("server", "remote-embedding-concurrency")) {
+        this->remote_embedding_concurrency = (int) reader.GetInteger("server", "remote-embedding-concurrency", 4);
+    }
+
     if(reader.Exists("server", "analytics-flush-interval")) {
         this->analytics_flush_interval = (int) reader.GetInteger("server", "analytics-flush-interval", 3600);
     }
@@ -403,14 +634,75 @@ void Config::load_config_file(cmdline::parser& options) {
         this->housekeeping_interval = (int) reader.GetInteger("server", "housekeeping-interval", 1800);
     }
 
+    if(reader.Exists("server", "housekeeping-budget-ms")) {
+        this->housekeeping_budget_ms = (int) reader.GetInteger("server", "housekeeping-budget-ms", 10000);
+    }
+
     if(reader.Exists("server", "db-compaction-interval")) {
         this->db_compaction_interval = (int) reader.GetInteger("server", "db-compaction-interval", 0);
     }
 
+    if(reader.Exists("server", "db-block-cache-mb")) {
+        this->db_block_cache_mb = (int) reader.GetInteger("server", "db-block-cache-mb", 0);
+    }
+
+    if(reader.Exists("server", "db-bloom-bits-per-key")) {
+        this->db_bloom_bits_per_key = (int) reader.GetInteger("server", "db-bloom-bits-per-key", 10);
+    }
+
+    if(reader.Exists("server", "db-row-cache-mb")) {
+        this->db_row_cache_mb = (int) reader.GetInteger("server", "db-row-cache-mb", 0);
+    }
+
+    if(reader.Exists("server", "db-compaction-direct-io")) {
+        auto db_compaction_direct_io_str = reader.Get("server", "db-compaction-direct-io", "false");
+        this->db_compaction_direct_io = (db_compaction_direct_io_str == "true");
+    }
+
+    if(reader.Exists("server", "db-compaction-rate-limit-mb")) {
+        this->db_compaction_rate_limit_mb = (int) reader.GetInteger("server", "db-compaction-rate-limit-mb", 0);
+    }
+
     if(reader.Exists("server", "thread-pool-size")) {
         this->thread_pool_size = (int) reader.GetInteger("server", "thread-pool-size", 0);
     }
 
+    if(reader.Exists("server", "num-http-event-loops")) {
+        this->num_http_event_loops = (int) reader.GetInteger("server", "num-http-event-loops", 1);
+    }
+
+    if(reader.Exists("server", "indexing-thread-pool-size")) {
+        this->indexing_thread_pool_size = (int) reader.GetInteger("server", "indexing-thread-pool-size", 0);
+    }
+
+    if(reader.Exists("server", "index-batch-concurrency")) {
+        this->index_batch_concurrency = (int) reader.GetInteger("server", "index-batch-concurrency", 4);
+    }
+
+    if(reader.Exists("server", "multi-search-concurrency")) {
+        this->multi_search_concurrency = (int) reader.GetInteger("server", "multi-search-concurrency", 4);
+    }
+
+    if(reader.Exists("server", "hits-parallel-threshold")) {
+        this->hits_parallel_threshold = (int) reader.GetInteger("server", "hits-parallel-threshold", 64);
+    }
+
+    if(reader.Exists("server", "search-degradation-load-percent")) {
+        this->search_degradation_load_percent = (int) reader.GetInteger("server", "search-degradation-load-percent", 0);
+    }
+
+    if(reader.Exists("server", "memory-dirty-decay-ms")) {
+        this->memory_dirty_decay_ms = (int) reader.GetInteger("server", "memory-dirty-decay-ms", 10000);
+    }
+
+    if(reader.Exists("server", "memory-muzzy-decay-ms")) {
+        this->memory_muzzy_decay_ms = (int) reader.GetInteger("server", "memory-muzzy-decay-ms", 0);
+    }
+
+    if(reader.Exists("server", "indexing-cpu-affinity")) {
+        this->indexing_cpu_affinity = reader.Get("server", "indexing-cpu-affinity", "");
+    }
+
     if(reader.Exists("server", "ssl-refresh-interval-seconds")) {
         this->ssl_refresh_interval_seconds = (int) reader.GetInteger("server", "ssl-refresh-interval-seconds", 8 * 60 * 60);
     }
@@ -430,6 +722,16 @@ void Config::load_config_file(cmdline::parser& options) {
         this->enable_search_logging = (enable_search_logging_str == "true");
     }
 
+    if(reader.Exists("server", "enable-search-admission-control")) {
+        auto enable_search_admission_control_str = reader.Get("server", "enable-search-admission-control", "false");
+        this->enable_search_admission_control = (enable_search_admission_control_str == "true");
+    }
+
+    if(reader.Exists("server", "enable-memory-arenas")) {
+        auto enable_memory_arenas_str = reader.Get("server", "enable-memory-arenas", "false");
+        this->enable_memory_arenas = (enable_memory_arenas_str == "true");
+    }
+
     if(reader.Exists("server", "disk-used-max-percentage")) {
         this->disk_used_max_percentage = (int) reader.GetInteger("server", "disk-used-max-percentage", 100);
     }
@@ -443,6 +745,26 @@ void Config::load_config_file(cmdline::parser& options) {
         this->enable_lazy_filter = (enable_lazy_filter_str == "true");
     }
 
+    if(reader.Exists("server", "enable-infix-trigram-index")) {
+        auto enable_infix_trigram_index_str = reader.Get("server", "enable-infix-trigram-index", "false");
+        this->enable_infix_trigram_index = (enable_infix_trigram_index_str == "true");
+    }
+
+    if(reader.Exists("server", "enable-index-image")) {
+        auto enable_index_image_str = reader.Get("server", "enable-index-image", "false");
+        this->enable_index_image = (enable_index_image_str == "true");
+    }
+
+    if(reader.Exists("server", "enable-deferred-deletes")) {
+        auto enable_deferred_deletes_str = reader.Get("server", "enable-deferred-deletes", "false");
+        this->enable_deferred_deletes = (enable_deferred_deletes_str == "true");
+    }
+
+    if(reader.Exists("server", "enable-vector-gpu-scoring")) {
+        auto enable_vector_gpu_scoring_str = reader.Get("server", "enable-vector-gpu-scoring", "false");
+        this->enable_vector_gpu_scoring = (enable_vector_gpu_scoring_str == "true");
+    }
+
     if(reader.Exists("server", "skip-writes")) {
         auto skip_writes_str = reader.Get("server", "skip-writes", "false");
         this->skip_writes = (skip_writes_str == "true");
@@ -545,6 +867,30 @@ void Config::load_config_cmd_args(cmdline::parser& options)  {
         this->snapshot_max_byte_count_per_rpc = options.get<int>("snapshot-max-byte-count-per-rpc");
     }
 
+    if(options.exist("write-batch-window-us")) {
+        this->write_batch_window_us = options.get<uint32_t>("write-batch-window-us");
+    }
+
+    if(options.exist("write-batch-max-bytes")) {
+        this->write_batch_max_bytes = options.get<uint32_t>("write-batch-max-bytes");
+    }
+
+    if(options.exist("log-compression-min-bytes")) {
+        this->log_compression_min_bytes = options.get<uint32_t>("log-compression-min-bytes");
+    }
+
+    if(options.exist("learner")) {
+        this->learner = options.get<bool>("learner");
+    }
+
+    if(options.exist("learner-feed-max-bytes")) {
+        this->learner_feed_max_bytes = options.get<uint32_t>("learner-feed-max-bytes");
+    }
+
+    if(options.exist("queued-request-memory-max-bytes")) {
+        this->queued_request_memory_max_bytes = options.get<uint32_t>("queued-request-memory-max-bytes");
+    }
+
     if(options.exist("healthy-read-lag")) {
         this->healthy_read_lag = options.get<size_t>("healthy-read-lag");
     }
@@ -561,6 +907,34 @@ void Config::load_config_cmd_args(cmdline::parser& options)  {
         this->log_slow_searches_time_ms = options.get<int>("log-slow-searches-time-ms");
     }
 
+    if(options.exist("search-warmup-time-ms")) {
+        this->search_warmup_time_ms = options.get<uint32_t>("search-warmup-time-ms");
+    }
+
+    if(options.exist("collection-idle-eviction-secs")) {
+        this->collection_idle_eviction_secs = options.get<uint32_t>("collection-idle-eviction-secs");
+    }
+
+    if(options.exist("collection-restore-budget-ms")) {
+        this->collection_restore_budget_ms = options.get<uint32_t>("collection-restore-budget-ms");
+    }
+
+    if(options.exist("hot-collections")) {
+        this->hot_collections = options.get<std::string>("hot-collections");
+    }
+
+    if(options.exist("doc-id-index")) {
+        this->doc_id_index = options.get<std::string>("doc-id-index");
+    }
+
+    if(options.exist("voice-query-parallelism")) {
+        this->voice_query_parallelism = options.get<uint32_t>("voice-query-parallelism");
+    }
+
+    if(options.exist("voice-query-max-audio-secs")) {
+        this->voice_query_max_audio_secs = options.get<uint32_t>("voice-query-max-audio-secs");
+    }
+
     if(options.exist("num-collections-parallel-load")) {
         this->num_collections_parallel_load = options.get<uint32_t>("num-collections-parallel-load");
     }
@@ -573,6 +947,38 @@ void Config::load_config_cmd_args(cmdline::parser& options)  {
         this->cache_num_entries = options.get<uint32_t>("cache-num-entries");
     }
 
+    if(options.exist("cache-max-memory-mb")) {
+        this->cache_max_memory_mb = options.get<uint32_t>("cache-max-memory-mb");
+    }
+
+    if(options.exist("cache-compress-min-bytes")) {
+        this->cache_compress_min_bytes = options.get<uint32_t>("cache-compress-min-bytes");
+    }
+
+    if(options.exist("http-compress-min-bytes")) {
+        this->http_compress_min_bytes = options.get<uint32_t>("http-compress-min-bytes");
+    }
+
+    if(options.exist("typo-cache-num-entries")) {
+        this->typo_cache_num_entries = options.get<uint32_t>("typo-cache-num-entries");
+    }
+
+    if(options.exist("embedding-query-batch-window-ms")) {
+        this->embedding_query_batch_window_ms = options.get<uint32_t>("embedding-query-batch-window-ms");
+    }
+
+    if(options.exist("embedding-cache-num-entries")) {
+        this->embedding_cache_num_entries = options.get<uint32_t>("embedding-cache-num-entries");
+    }
+
+    if(options.exist("stem-cache-num-entries")) {
+        this->stem_cache_num_entries = options.get<uint32_t>("stem-cache-num-entries");
+    }
+
+    if(options.exist("remote-embedding-concurrency")) {
+        this->remote_embedding_concurrency = options.get<uint32_t>("remote-embedding-concurrency");
+    }
+
     if(options.exist("analytics-flush-interval")) {
         this->analytics_flush_interval = options.get<uint32_t>("analytics-flush-interval");
     }
@@ -581,14 +987,74 @@ void Config::load_config_cmd_args(cmdline::parser& options)  {
         this->housekeeping_interval = options.get<uint32_t>("housekeeping-interval");
     }
 
+    if(options.exist("housekeeping-budget-ms")) {
+        this->housekeeping_budget_ms = options.get<uint32_t>("housekeeping-budget-ms");
+    }
+
     if(options.exist("db-compaction-interval")) {
         this->db_compaction_interval = options.get<uint32_t>("db-compaction-interval");
     }
 
+    if(options.exist("db-block-cache-mb")) {
+        this->db_block_cache_mb = options.get<uint32_t>("db-block-cache-mb");
+    }
+
+    if(options.exist("db-bloom-bits-per-key")) {
+        this->db_bloom_bits_per_key = options.get<uint32_t>("db-bloom-bits-per-key");
+    }
+
+    if(options.exist("db-row-cache-mb")) {
+        this->db_row_cache_mb = options.get<uint32_t>("db-row-cache-mb");
+    }
+
+    if(options.exist("db-compaction-direct-io")) {
+        this->db_compaction_direct_io = options.get<bool>("db-compaction-direct-io");
+    }
+
+    if(options.exist("db-compaction-rate-limit-mb")) {
+        this->db_compaction_rate_limit_mb = options.get<uint32_t>("db-compaction-rate-limit-mb");
+    }
+
     if(options.exist("thread-pool-size")) {
         this->thread_pool_size = options.get<uint32_t>("thread-pool-size");
     }
 
+    if(options.exist("num-http-event-loops")) {
+        this->num_http_event_loops = options.get<uint32_t>("num-http-event-loops");
+    }
+
+    if(options.exist("indexing-thread-pool-size")) {
+        this->indexing_thread_pool_size = options.get<uint32_t>("indexing-thread-pool-size");
+    }
+
+    if(options.exist("index-batch-concurrency")) {
+        this->index_batch_concurrency = options.get<uint32_t>("index-batch-concurrency");
+    }
+
+    if(options.exist("multi-search-concurrency")) {
+        this->multi_search_concurrency = options.get<uint32_t>("multi-search-concurrency");
+    }
+
+    if(options.exist("hits-parallel-threshold")) {
+        this->hits_parallel_threshold = options.get<uint32_t>("hits-parallel-threshold");
+    }
+
+    if(options.exist("search-degradation-load-percent")) {
+        this->search_degradation_load_percent = options.get<uint32_t>("search-degradation-load-percent");
+    }
+
+    if(options.exist("memory-dirty-decay-ms")) {
+        this->memory_dirty_decay_ms = options.get<int>("memory-dirty-decay-ms");
+    }
+
+    if(options.exist("memory-muzzy-decay-ms")) {
+        this->memory_muzzy_decay_ms = options.get<int>("memory-muzzy-decay-ms");
+    }
+
+    if(options.exist("indexing-cpu-affinity")) {
+        this->indexing_cpu_affinity = options.get<std::string>("indexing-cpu-affinity");
+    }
+
     if(options.exist("ssl-refresh-interval-seconds")) {
         this->ssl_refresh_interval_seconds = options.get<uint32_t>("ssl-refresh-interval-seconds");
     }
@@ -621,8 +1087,32 @@ void Config::load_config_cmd_args(cmdline::parser& options)  {
         this->enable_lazy_filter = options.get<bool>("enable-lazy-filter");
     }
 
+    if(options.exist("enable-infix-trigram-index")) {
+        this->enable_infix_trigram_index = options.get<bool>("enable-infix-trigram-index");
+    }
+
     if(options.exist("enable-search-logging")) {
         this->enable_search_logging = options.get<bool>("enable-search-logging");
     }
+
+    if(options.exist("enable-search-admission-control")) {
+        this->enable_search_admission_control = options.get<bool>("enable-search-admission-control");
+    }
+
+    if(options.exist("enable-memory-arenas")) {
+        this->enable_memory_arenas = options.get<bool>("enable-memory-arenas");
+    }
+
+    if(options.exist("enable-index-image")) {
+        this->enable_index_image = options.get<bool>("enable-index-image");
+    }
+
+    if(options.exist("enable-deferred-deletes")) {
+        this->enable_deferred_deletes = options.get<bool>("enable-deferred-deletes");
+    }
+
+    if(options.exist("enable-vector-gpu-scoring")) {
+        this->enable_vector_gpu_scoring = options.get<bool>("enable-vector-gpu-scoring");
+    }
 }
 
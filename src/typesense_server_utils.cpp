@@ -15,6 +15,8 @@
 #include <ifaddrs.h>
 #include "analytics_manager.h"
 #include "housekeeper.h"
+#include "admission_controller.h"
+#include "memory_arenas.h"
 
 #include "core_api.h"
 #include "ratelimit_manager.h"
@@ -26,6 +28,9 @@
 #include "conversation_manager.h"
 #include "conversation_model_manager.h"
 #include "vq_model_manager.h"
+#include "search_warmup.h"
+#include "gpu_vector_scorer.h"
+#include "system_metrics.h"
 
 #ifndef ASAN_BUILD
 #include "jemalloc.h"
@@ -87,6 +92,12 @@ void init_cmdline_options(cmdline::parser & options, int argc, char **argv) {
     options.add<float>("max-memory-ratio", '\0', "Maximum fraction of system memory to be used.", false, 1.0f);
     options.add<int>("snapshot-interval-seconds", '\0', "Frequency of replication log snapshots.", false, 3600);
     options.add<int>("snapshot-max-byte-count-per-rpc", '\0', "Maximum snapshot file size in bytes transferred for each RPC.", false, 4194304);
+    options.add<uint32_t>("write-batch-window-us", '\0', "Writes arriving within this many microseconds are coalesced into a single replication log entry (0 disables it).", false, 0);
+    options.add<uint32_t>("write-batch-max-bytes", '\0', "Maximum size in bytes of the writes coalesced into a single replication log entry.", false, 1048576);
+    options.add<uint32_t>("log-compression-min-bytes", '\0', "Replication log entries of at least this many bytes are compressed (0 disables it).", false, 0);
+    options.add<bool>("learner", '\0', "Follow the nodes of --nodes as a non-voting read replica.", false, false);
+    options.add<uint32_t>("learner-feed-max-bytes", '\0', "Bytes of the applied replication log entries that are kept for learners and change streams to follow (0 disables it).", false, 0);
+    options.add<uint32_t>("queued-request-memory-max-bytes", '\0', "Writes up to this size are held in memory while they wait to be indexed, larger ones are spilled to disk (0 spills every write).", false, 1048576);
     options.add<size_t>("healthy-read-lag", '\0', "Reads are rejected if the updates lag behind this threshold.", false, 1000);
     options.add<size_t>("healthy-write-lag", '\0', "Writes are rejected if the updates lag behind this threshold.", false, 500);
     options.add<int>("log-slow-requests-time-ms", '\0', "When >= 0, requests that take longer than this duration are logged.", false, -1);
@@ -95,6 +106,15 @@ void init_cmdline_options(cmdline::parser & options, int argc, char **argv) {
     options.add<uint32_t>("num-documents-parallel-load", '\0', "Number of documents per collection that are indexed in parallel during start up.", false, 1000);
 
     options.add<uint32_t>("thread-pool-size", '\0', "Number of threads used for handling concurrent requests.", false, 4);
+    options.add<uint32_t>("num-http-event-loops", '\0', "Number of event loops that accept and parse HTTP requests, each listening on the API port.", false, 1);
+    options.add<uint32_t>("multi-search-concurrency", '\0', "Maximum number of the searches of a multi search request that run in parallel.", false, 4);
+    options.add<uint32_t>("hits-parallel-threshold", '\0', "Minimum number of hits on a page for the documents of the hits to be prepared in parallel, never when 0.", false, 64);
+    options.add<uint32_t>("search-degradation-load-percent", '\0', "Percentage of the admission control limit of concurrent searches, beyond which searches drop expensive features (facet sampling, fewer candidates, 1 typo, no infix) instead of timing out. Never when 0.", false, 0);
+    options.add<int>("memory-dirty-decay-ms", '\0', "Time after which freed memory pages are returned to the OS. Never when -1.", false, 10000);
+    options.add<int>("memory-muzzy-decay-ms", '\0', "Time after which memory pages that were returned lazily are fully returned to the OS. Never when -1.", false, 0);
+    options.add<uint32_t>("indexing-thread-pool-size", '\0', "When > 0, in-memory indexing runs on its own pool of these many threads instead of sharing the search threads.", false, 0);
+    options.add<std::string>("indexing-cpu-affinity", '\0', "CPU cores that the indexing threads are pinned to, e.g. `0-3,8`.", false, "");
+    options.add<uint32_t>("index-batch-concurrency", '\0', "Number of threads that validate and tokenize the documents of an import batch.", false, 4);
 
     options.add<std::string>("log-dir", '\0', "Path to the log directory.", false, "");
 
@@ -102,6 +122,8 @@ void init_cmdline_options(cmdline::parser & options, int argc, char **argv) {
 
     options.add<bool>("enable-access-logging", '\0', "Enable access logging.", false, false);
     options.add<bool>("enable-search-logging", '\0', "Enable search logging.", false, false);
+    options.add<bool>("enable-search-admission-control", '\0', "Reject searches early with a 503 when the server is overloaded, by adapting the number of concurrent searches to their latency.", false, false);
+    options.add<bool>("enable-memory-arenas", '\0', "Allocate the memory of indexing and of searches from separate allocator arenas, to reduce fragmentation after large deletes.", false, false);
     options.add<bool>("enable-search-analytics", '\0', "Enable search analytics.", false, false);
     options.add<int>("disk-used-max-percentage", '\0', "Reject writes when used disk space exceeds this percentage. Default: 100 (never reject).", false, 100);
     options.add<int>("memory-used-max-percentage", '\0', "Reject writes when memory usage exceeds this percentage. Default: 100 (never reject).", false, 100);
@@ -109,11 +131,36 @@ void init_cmdline_options(cmdline::parser & options, int argc, char **argv) {
     options.add<bool>("reset-peers-on-error", '\0', "Reset node's peers on clustering error. Default: false.", false, false);
 
     options.add<int>("log-slow-searches-time-ms", '\0', "When >= 0, searches that take longer than this duration are logged.", false, 30*1000);
+    options.add<uint32_t>("search-warmup-time-ms", '\0', "Time spent on replaying the most frequent searches of the last run before a started node reports healthy, none when 0.", false, 0);
+    options.add<uint32_t>("collection-idle-eviction-secs", '\0', "Collections that are not looked up for this long are evicted from memory and loaded again on their next lookup, none when 0.", false, 0);
+    options.add<uint32_t>("collection-restore-budget-ms", '\0', "Only collections that were loaded within this time are evicted when idle.", false, 1000);
+    options.add<std::string>("hot-collections", '\0', "Comma separated names of the collections that are loaded first on start up, before the largest ones.", false, "");
+    options.add<std::string>("doc-id-index", '\0', "In-memory index of document ids: `off`, `map` for resolving ids without reading the store, or `bloom` for skipping the reads of new ids.", false, "off");
+    options.add<uint32_t>("voice-query-parallelism", '\0', "Number of voice queries that a voice query model transcribes at the same time.", false, 2);
+    options.add<uint32_t>("voice-query-max-audio-secs", '\0', "Voice queries longer than this duration are rejected.", false, 30);
     options.add<int>("cache-num-entries", '\0', "Number of entries to cache.", false, 1000);
+    options.add<uint32_t>("cache-max-memory-mb", '\0', "When > 0, the cache is also limited by the memory used by cached responses (in MB).", false, 0);
+    options.add<uint32_t>("cache-compress-min-bytes", '\0', "When > 0, cached responses of at least this size are stored compressed.", false, 0);
+    options.add<uint32_t>("http-compress-min-bytes", '\0', "Responses of at least this size are compressed with gzip or brotli when the client accepts it. Never when 0.", false, 256);
+    options.add<uint32_t>("typo-cache-num-entries", '\0', "Number of fuzzy search results of tokens to cache per collection. 0 disables the cache.", false, 1024);
+    options.add<uint32_t>("embedding-query-batch-window-ms", '\0', "Time to collect the query embeddings of concurrent searches into one batch of a local model (in milliseconds).", false, 0);
+    options.add<uint32_t>("embedding-cache-num-entries", '\0', "Number of embeddings of search queries to cache per model. 0 disables the cache.", false, 1000);
+    options.add<uint32_t>("stem-cache-num-entries", '\0', "Number of stems of words to cache per stemming language. 0 disables the cache.", false, 64 * 1024);
+    options.add<uint32_t>("remote-embedding-concurrency", '\0', "Number of batches of documents sent to a remote embedding model at a time while indexing.", false, 4);
     options.add<uint32_t>("analytics-flush-interval", '\0', "Frequency of persisting analytics data to disk (in seconds).", false, 3600);
     options.add<uint32_t>("housekeeping-interval", '\0', "Frequency of housekeeping background job (in seconds).", false, 1800);
+    options.add<uint32_t>("housekeeping-budget-ms", '\0', "Time that a pass of the housekeeper may spend on its tasks before the rest wait for the next pass (in milliseconds).", false, 10000);
     options.add<bool>("enable-lazy-filter", '\0', "Filter clause will be evaluated lazily.", false, false);
+    options.add<bool>("enable-infix-trigram-index", '\0', "Index the trigrams of the tokens of infix fields, so that infix searches do not scan every token.", false, false);
     options.add<uint32_t>("db-compaction-interval", '\0', "Frequency of RocksDB compaction (in seconds).", false, 604800);
+    options.add<uint32_t>("db-block-cache-mb", '\0', "When > 0, size of the RocksDB block cache shared by the stores (in MB).", false, 0);
+    options.add<uint32_t>("db-bloom-bits-per-key", '\0', "Bits per key of the RocksDB bloom filters, disabled when 0.", false, 10);
+    options.add<uint32_t>("db-row-cache-mb", '\0', "When > 0, size of the RocksDB row cache of each store (in MB).", false, 0);
+    options.add<bool>("db-compaction-direct-io", '\0', "Use direct I/O for RocksDB flushes and compactions.", false, false);
+    options.add<uint32_t>("db-compaction-rate-limit-mb", '\0', "When > 0, I/O budget of RocksDB flushes and compactions (in MB/s).", false, 0);
+    options.add<bool>("enable-index-image", '\0', "Persist vector indices with each snapshot to speed up restarts.", false, false);
+    options.add<bool>("enable-deferred-deletes", '\0', "Exclude documents deleted by id from searches and unindex them in batches later.", false, false);
+    options.add<bool>("enable-vector-gpu-scoring", '\0', "Score large flat vector searches on a CUDA device through cuBLAS, when one is found.", false, false);
 
     // DEPRECATED
     options.add<std::string>("listen-address", 'h', "[DEPRECATED: use `api-address`] Address to which Typesense API service binds.", false, "0.0.0.0");
@@ -161,6 +208,39 @@ int init_root_logger(Config & config, const std::string & server_version) {
     return 0;
 }
 
+// parses a list of CPU cores like `0-3,8`
+bool parse_cpu_list(const std::string& cpu_list, std::vector<size_t>& cpu_ids) {
+    std::vector<std::string> parts;
+    StringUtils::split(cpu_list, parts, ",");
+
+    for(const auto& part: parts) {
+        std::vector<std::string> bounds;
+        StringUtils::split(part, bounds, "-");
+
+        if(bounds.empty() || bounds.size() > 2) {
+            return false;
+        }
+
+        for(const auto& bound: bounds) {
+            if(!StringUtils::is_uint32_t(bound)) {
+                return false;
+            }
+        }
+
+        const size_t first_id = std::stoul(bounds.front());
+        const size_t last_id = std::stoul(bounds.back());
+        if(first_id > last_id || last_id >= 64 * 1024) {
+            return false;
+        }
+
+        for(size_t cpu_id = first_id; cpu_id <= last_id; cpu_id++) {
+            cpu_ids.push_back(cpu_id);
+        }
+    }
+
+    return !cpu_ids.empty();
+}
+
 bool is_private_ip(uint32_t ip) {
     uint8_t b1, b2;
     b1 = (uint8_t) (ip >> 24);
@@ -315,6 +395,15 @@ int start_raft_server(ReplicationState& replication_state, const std::string& st
             // update node catch up status periodically, take care of logging too verbosely
             bool log_msg = (raft_counter % 9 == 0);
             replication_state.refresh_catchup_status(log_msg);
+
+            if(replication_state.is_read_caught_up()) {
+                // the collections are loaded by now
+                SearchWarmup::get_instance().start();
+            }
+        }
+
+        if(raft_counter % 60 == 0) {
+            SearchWarmup::get_instance().persist_searches();
         }
 
         raft_counter++;
@@ -323,6 +412,9 @@ int start_raft_server(ReplicationState& replication_state, const std::string& st
 
     LOG(INFO) << "Typesense peering service is going to quit.";
 
+    SearchWarmup::get_instance().stop();
+    SearchWarmup::get_instance().persist_searches();
+
     // Stop application before server
     replication_state.shutdown();
 
@@ -337,6 +429,58 @@ int start_raft_server(ReplicationState& replication_state, const std::string& st
     return 0;
 }
 
+int start_learner(ReplicationState& replication_state, const std::string& state_dir,
+                  const std::string& path_to_nodes) {
+    if(path_to_nodes.empty()) {
+        LOG(ERROR) << "A learner needs the --nodes of the cluster that it follows.";
+        exit(-1);
+    }
+
+    if(replication_state.start_learner(state_dir) != 0) {
+        LOG(ERROR) << "Failed to start learner";
+        exit(-1);
+    }
+
+    LOG(INFO) << "Typesense is running as a learner of the nodes in " << path_to_nodes;
+
+    std::string nodes_config;
+    size_t learner_counter = 0;
+
+    while (!brpc::IsAskedToQuit() && !quit_raft_service.load()) {
+        if(learner_counter % 10 == 0) {
+            // the voters are refreshed periodically to follow changes in cluster membership
+            const Option<std::string> & refreshed_nodes_op = Config::fetch_nodes_config(path_to_nodes);
+            if(!refreshed_nodes_op.ok()) {
+                LOG(WARNING) << "Error while refreshing peer configuration: " << refreshed_nodes_op.error();
+            } else {
+                nodes_config = ReplicationState::resolve_node_hosts(refreshed_nodes_op.get());
+            }
+        }
+
+        replication_state.follow_voters(nodes_config);
+
+        if(replication_state.is_read_caught_up()) {
+            SearchWarmup::get_instance().start();
+        }
+
+        if(learner_counter % 60 == 0) {
+            SearchWarmup::get_instance().persist_searches();
+        }
+
+        learner_counter++;
+        sleep(1);
+    }
+
+    LOG(INFO) << "Typesense learner is going to quit.";
+
+    SearchWarmup::get_instance().stop();
+    SearchWarmup::get_instance().persist_searches();
+
+    replication_state.shutdown();
+
+    return 0;
+}
+
 int run_server(const Config & config, const std::string & version, void (*master_server_routes)()) {
     LOG(INFO) << "Starting Typesense " << version << std::flush;
 #ifndef ASAN_BUILD
@@ -352,6 +496,12 @@ int run_server(const Config & config, const std::string & version, void (*master
 #elif __linux__
         mallctl("background_thread", nullptr, nullptr, &background_thread, sizeof(bool));
 #endif
+
+        if(MemoryArenas::get_instance().init(config.get_enable_memory_arenas(), config.get_memory_dirty_decay_ms(),
+                                             config.get_memory_muzzy_decay_ms()) &&
+           config.get_enable_memory_arenas()) {
+            LOG(INFO) << "Indexing and searches allocate from separate arenas.";
+        }
     } else {
         LOG(WARNING) << "Typesense is NOT using jemalloc.";
     }
@@ -394,14 +544,56 @@ int run_server(const Config & config, const std::string & version, void (*master
 
     LOG(INFO) << "Thread pool size: " << num_threads;
     ThreadPool app_thread_pool(num_threads);
-    ThreadPool server_thread_pool(num_threads);
+
+    if(config.get_enable_search_admission_control()) {
+        // searches can always keep all of the server threads busy
+        AdmissionController::get_instance().init(num_threads, num_threads * 16);
+    }
+    ThreadPool server_thread_pool(num_threads, [] {
+        MemoryArenas::get_instance().bind_thread(MemoryArenas::SEARCH);
+    });
     ThreadPool replication_thread_pool(num_threads);
 
+    // a dedicated pool for in-memory indexing caps the CPU that a bulk import can take away from searches
+    std::unique_ptr<ThreadPool> indexing_thread_pool = nullptr;
+    if(config.get_indexing_thread_pool_size() != 0) {
+        LOG(INFO) << "Indexing thread pool size: " << config.get_indexing_thread_pool_size();
+        indexing_thread_pool = std::make_unique<ThreadPool>(config.get_indexing_thread_pool_size(), [] {
+            MemoryArenas::get_instance().bind_thread(MemoryArenas::INDEXING);
+        });
+    }
+
+    const std::string& indexing_cpu_affinity = config.get_indexing_cpu_affinity();
+    if(!indexing_cpu_affinity.empty()) {
+        std::vector<size_t> cpu_ids;
+        if(indexing_thread_pool == nullptr) {
+            LOG(ERROR) << "Ignoring `indexing-cpu-affinity` since `indexing-thread-pool-size` is not set.";
+        } else if(!parse_cpu_list(indexing_cpu_affinity, cpu_ids) ||
+                  !indexing_thread_pool->set_cpu_affinity(cpu_ids)) {
+            LOG(ERROR) << "Could not pin indexing threads to CPU cores: " << indexing_cpu_affinity;
+        } else {
+            LOG(INFO) << "Indexing threads are pinned to CPU cores: " << indexing_cpu_affinity;
+        }
+    }
+
+    store_tuning_t store_tuning;
+    if(config.get_db_block_cache_mb() != 0) {
+        // a part of the cache is reserved for the index and filter blocks
+        store_tuning.block_cache = rocksdb::NewLRUCache(config.get_db_block_cache_mb() * 1024 * 1024, -1, false, 0.2);
+    }
+    store_tuning.bloom_bits_per_key = config.get_db_bloom_bits_per_key();
+    store_tuning.row_cache_mb = config.get_db_row_cache_mb();
+    store_tuning.direct_io_for_compaction = config.get_db_compaction_direct_io();
+    if(config.get_db_compaction_rate_limit_mb() != 0) {
+        store_tuning.rate_limiter.reset(rocksdb::NewGenericRateLimiter(
+                config.get_db_compaction_rate_limit_mb() * 1024 * 1024));
+    }
+
     // primary DB used for storing the documents: we will not use WAL since Raft provides that
-    Store store(db_dir, 24*60*60, 1024, true);
+    Store store(db_dir, 24*60*60, 1024, true, store_tuning);
 
     // meta DB for storing house keeping things
-    Store meta_store(meta_dir, 24*60*60, 1024, false);
+    Store meta_store(meta_dir, 24*60*60, 1024, false, store_tuning);
 
     //analytics DB for storing query click events
     std::unique_ptr<Store> analytics_store = nullptr;
@@ -421,11 +613,20 @@ int run_server(const Config & config, const std::string & version, void (*master
         config.get_ssl_refresh_interval_seconds() * 1000,
         config.get_enable_cors(),
         config.get_cors_domains(),
-        &server_thread_pool
+        &server_thread_pool,
+        config.get_num_http_event_loops()
     );
 
     server->set_auth_handler(handle_authentication);
 
+    SystemMetrics::register_thread_pool("http", &server_thread_pool);
+    SystemMetrics::register_thread_pool("collection", &app_thread_pool);
+    SystemMetrics::register_thread_pool("replication", &replication_thread_pool);
+    SystemMetrics::register_thread_pool("meta", server->get_meta_thread_pool());
+    if(indexing_thread_pool != nullptr) {
+        SystemMetrics::register_thread_pool("indexing", indexing_thread_pool.get());
+    }
+
     server->on(HttpServer::STREAM_RESPONSE_MESSAGE, HttpServer::on_stream_response_message);
     server->on(HttpServer::REQUEST_PROCEED_MESSAGE, HttpServer::on_request_proceed_message);
     server->on(HttpServer::DEFER_PROCESSING_MESSAGE, HttpServer::on_deferred_processing_message);
@@ -437,7 +638,7 @@ int run_server(const Config & config, const std::string & version, void (*master
 
     CollectionManager & collectionManager = CollectionManager::get_instance();
     collectionManager.init(&store, &app_thread_pool, config.get_max_memory_ratio(),
-                           config.get_api_key(), quit_raft_service);
+                           config.get_api_key(), quit_raft_service, indexing_thread_pool.get());
 
     StopwordsManager& stopwordsManager = StopwordsManager::get_instance();
     stopwordsManager.init(&store);
@@ -448,7 +649,34 @@ int run_server(const Config & config, const std::string & version, void (*master
     if(!rate_limit_manager_init.ok()) {
         LOG(INFO) << "Failed to initialize rate limit manager: " << rate_limit_manager_init.error();
     }
+
+    SearchWarmup::get_instance().init(&meta_store, config.get_search_warmup_time_ms());
+
+    if(config.get_collection_idle_eviction_secs() != 0) {
+        // images of the collections evicted by an earlier run are stale
+        const std::string evicted_image_dir = config.get_data_dir() + "/evicted_images";
+        delete_path(evicted_image_dir);
+        if(create_directory(evicted_image_dir)) {
+            collectionManager.set_evicted_image_dir(evicted_image_dir);
+        }
+    }
+
+    std::vector<std::string> hot_collections;
+    StringUtils::split(config.get_hot_collections(), hot_collections, ",");
+    collectionManager.set_hot_collections(hot_collections);
+
+    if(config.get_enable_vector_gpu_scoring()) {
+        auto gpu_init_op = GpuVectorScorer::get_instance().init();
+        if(gpu_init_op.ok()) {
+            LOG(INFO) << "Flat vector searches will be scored on the GPU.";
+        } else {
+            LOG(ERROR) << "Flat vector searches will be scored on the CPU: " << gpu_init_op.error();
+        }
+    }
+
     EmbedderManager::set_model_dir(config.get_data_dir() + "/models");
+    EmbedderManager::set_query_batch_window_ms(config.get_embedding_query_batch_window_ms());
+    EmbedderManager::set_remote_embedding_concurrency(config.get_remote_embedding_concurrency());
 
     auto conversations_init = ConversationManager::get_instance().init(&store);
 
@@ -469,14 +697,14 @@ int run_server(const Config & config, const std::string & version, void (*master
     // first we start the peering service
 
     ReplicationState replication_state(server, batch_indexer, &store, analytics_store.get(),
-                                       &replication_thread_pool, server->get_message_dispatcher(),
-                                       ssl_enabled,
+                                       &replication_thread_pool, ssl_enabled,
                                        &config,
                                        num_collections_parallel_load,
                                        config.get_num_documents_parallel_load());
 
     std::thread raft_thread([&replication_state, &config, &state_dir,
-                             &app_thread_pool, &server_thread_pool, &replication_thread_pool, batch_indexer]() {
+                             &app_thread_pool, &server_thread_pool, &replication_thread_pool,
+                             &indexing_thread_pool, batch_indexer]() {
 
         std::thread batch_indexing_thread([batch_indexer]() {
             batch_indexer->run();
@@ -499,14 +727,19 @@ int run_server(const Config & config, const std::string & version, void (*master
         RemoteEmbedder::init(&replication_state);
 
         std::string path_to_nodes = config.get_nodes();
-        start_raft_server(replication_state, state_dir, path_to_nodes,
-                          config.get_peering_address(),
-                          config.get_peering_port(),
-                          config.get_peering_subnet(),
-                          config.get_api_port(),
-                          config.get_snapshot_interval_seconds(),
-                          config.get_snapshot_max_byte_count_per_rpc(),
-                          config.get_reset_peers_on_error());
+
+        if(config.get_learner()) {
+            start_learner(replication_state, state_dir, path_to_nodes);
+        } else {
+            start_raft_server(replication_state, state_dir, path_to_nodes,
+                              config.get_peering_address(),
+                              config.get_peering_port(),
+                              config.get_peering_subnet(),
+                              config.get_api_port(),
+                              config.get_snapshot_interval_seconds(),
+                              config.get_snapshot_max_byte_count_per_rpc(),
+                              config.get_reset_peers_on_error());
+        }
 
         LOG(INFO) << "Shutting down batch indexer...";
         batch_indexer->stop();
@@ -530,6 +763,8 @@ int run_server(const Config & config, const std::string & version, void (*master
         HouseKeeper::get_instance().stop();
         housekeeping_thread.join();
 
+        SystemMetrics::unregister_thread_pools();
+
         LOG(INFO) << "Shutting down server_thread_pool";
 
         server_thread_pool.shutdown();
@@ -538,6 +773,11 @@ int run_server(const Config & config, const std::string & version, void (*master
 
         app_thread_pool.shutdown();
 
+        if(indexing_thread_pool != nullptr) {
+            LOG(INFO) << "Shutting down indexing_thread_pool.";
+            indexing_thread_pool->shutdown();
+        }
+
         LOG(INFO) << "Shutting down replication_thread_pool.";
         replication_thread_pool.shutdown();
 
@@ -559,8 +799,11 @@ int run_server(const Config & config, const std::string & version, void (*master
 
     delete batch_indexer;
 
+    GpuVectorScorer::get_instance().dispose();
+
     LOG(INFO) << "CURL clean up";
 
+    httpClient.dispose();
     curl_global_cleanup();
 
     LOG(INFO) << "Deleting server";
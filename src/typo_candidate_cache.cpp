@@ -0,0 +1,102 @@
+#include "typo_candidate_cache.h"
+
+std::atomic<size_t> typo_candidate_cache_t::max_entries = typo_candidate_cache_t::DEFAULT_MAX_ENTRIES;
+
+std::atomic<uint64_t> typo_candidate_cache_t::hits = 0;
+std::atomic<uint64_t> typo_candidate_cache_t::misses = 0;
+std::atomic<uint64_t> typo_candidate_cache_t::invalidations = 0;
+std::atomic<uint64_t> typo_candidate_cache_t::evictions = 0;
+std::atomic<uint64_t> typo_candidate_cache_t::num_entries = 0;
+
+typo_candidate_cache_t::~typo_candidate_cache_t() {
+    clear();
+}
+
+std::string typo_candidate_cache_t::get_key(const std::string& field_name, const std::string& token,
+                                            int cost, bool prefix) {
+    std::string key = std::to_string(field_name.size());
+    key += ':';
+    key += field_name;
+    key += std::to_string(cost);
+    key += prefix ? 'p' : 'e';
+    key += token;
+    return key;
+}
+
+void typo_candidate_cache_t::erase(std::list<std::pair<std::string, entry_t>>::iterator it) {
+    entry_index.erase(it->first);
+    entries.erase(it);
+    num_entries--;
+}
+
+typo_candidate_cache_t::candidates_t typo_candidate_cache_t::get(const std::string& key, uint64_t write_generation) {
+    std::unique_lock lock(mutex);
+
+    auto hit_it = entry_index.find(key);
+    if (hit_it == entry_index.end()) {
+        misses++;
+        return nullptr;
+    }
+
+    if (hit_it->second->second.write_generation != write_generation) {
+        erase(hit_it->second);
+        invalidations++;
+        misses++;
+        return nullptr;
+    }
+
+    // move to the front
+    entries.splice(entries.begin(), entries, hit_it->second);
+    hits++;
+    return hit_it->second->second.candidates;
+}
+
+void typo_candidate_cache_t::insert(const std::string& key, uint64_t write_generation, candidates_t candidates) {
+    const size_t entries_limit = max_entries;
+
+    if (entries_limit == 0 || candidates == nullptr || candidates->nodes.size() > MAX_ENTRY_NODES ||
+        candidates->frontier.entries.size() > MAX_ENTRY_NODES) {
+        return;
+    }
+
+    std::unique_lock lock(mutex);
+
+    auto existing_it = entry_index.find(key);
+    if (existing_it != entry_index.end()) {
+        erase(existing_it->second);
+    }
+
+    entries.emplace_front(key, entry_t{std::move(candidates), write_generation});
+    entry_index.emplace(key, entries.begin());
+    num_entries++;
+
+    while (entries.size() > entries_limit) {
+        erase(std::prev(entries.end()));
+        evictions++;
+    }
+}
+
+void typo_candidate_cache_t::clear() {
+    std::unique_lock lock(mutex);
+    num_entries -= entries.size();
+    entries.clear();
+    entry_index.clear();
+}
+
+size_t typo_candidate_cache_t::size() const {
+    std::unique_lock lock(mutex);
+    return entries.size();
+}
+
+void typo_candidate_cache_t::set_max_entries(size_t max_entries) {
+    typo_candidate_cache_t::max_entries = max_entries;
+}
+
+void typo_candidate_cache_t::get_metrics(nlohmann::json& result) {
+    result["typesense_typo_cache_hits"] = std::to_string(hits);
+    result["typesense_typo_cache_misses"] = std::to_string(misses);
+    result["typesense_typo_cache_invalidations"] = std::to_string(invalidations);
+    result["typesense_typo_cache_evictions"] = std::to_string(evictions);
+    result["typesense_typo_cache_entries"] = std::to_string(num_entries);
+    result["typesense_typo_cache_max_entries_per_collection"] = std::to_string(max_entries);
+}
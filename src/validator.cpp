@@ -1,16 +1,61 @@
 #include "validator.h"
+#include <unordered_map>
 #include "field.h"
 
+coerce_type_t validator_t::get_coerce_type(const field& a_field) {
+    static const std::unordered_map<std::string, coerce_type_t> coerce_types = {
+        {field_types::STRING, coerce_type_t::STRING},
+        {field_types::INT32, coerce_type_t::INT32},
+        {field_types::INT64, coerce_type_t::INT64},
+        {field_types::FLOAT, coerce_type_t::FLOAT},
+        {field_types::BOOL, coerce_type_t::BOOL},
+        {field_types::GEOPOINT, coerce_type_t::GEOPOINT},
+        {field_types::STRING_ARRAY, coerce_type_t::STRING_ARRAY},
+        {field_types::INT32_ARRAY, coerce_type_t::INT32_ARRAY},
+        {field_types::INT64_ARRAY, coerce_type_t::INT64_ARRAY},
+        {field_types::FLOAT_ARRAY, coerce_type_t::FLOAT_ARRAY},
+        {field_types::BOOL_ARRAY, coerce_type_t::BOOL_ARRAY},
+        {field_types::GEOPOINT_ARRAY, coerce_type_t::GEOPOINT_ARRAY},
+    };
+
+    auto coerce_type_it = coerce_types.find(a_field.type);
+    if(coerce_type_it != coerce_types.end()) {
+        return coerce_type_it->second;
+    }
+
+    return a_field.is_array() ? coerce_type_t::OTHER_ARRAY : coerce_type_t::OTHER;
+}
+
+validator_program_t::validator_program_t(const tsl::htrie_map<char, field>& search_schema,
+                                         const tsl::htrie_map<char, field>& embedding_fields) {
+    for(const auto& a_field: search_schema) {
+        // embedding fields are validated apart, see `validate_embed_fields()`
+        if(a_field.name == "id" || a_field.is_object() || embedding_fields.count(a_field.name) > 0) {
+            continue;
+        }
+
+        bool is_auto_embedding = a_field.type == field_types::FLOAT_ARRAY && a_field.embed.count(fields::from) > 0;
+        checks.push_back({&a_field, validator_t::get_coerce_type(a_field), is_auto_embedding});
+    }
+}
+
 Option<uint32_t> validator_t::coerce_element(const field& a_field, nlohmann::json& document,
                                        nlohmann::json& doc_ele,
                                        const std::string& fallback_field_type,
                                        const DIRTY_VALUES& dirty_values) {
+    return coerce_element(a_field, get_coerce_type(a_field), document, doc_ele, fallback_field_type, dirty_values);
+}
+
+Option<uint32_t> validator_t::coerce_element(const field& a_field, const coerce_type_t type, nlohmann::json& document,
+                                       nlohmann::json& doc_ele,
+                                       const std::string& fallback_field_type,
+                                       const DIRTY_VALUES& dirty_values) {
 
     const std::string& field_name = a_field.name;
     bool array_ele_erased = false;
     nlohmann::json::iterator dummy_iter;
 
-    if(a_field.type == field_types::STRING) {
+    if(type == coerce_type_t::STRING) {
         if(!doc_ele.is_string()) {
             Option<uint32_t> coerce_op = coerce_string(dirty_values, fallback_field_type, a_field, document,
                                                        field_name, dummy_iter, false, array_ele_erased);
@@ -18,21 +63,21 @@ Option<uint32_t> validator_t::coerce_element(const field& a_field, nlohmann::jso
                 return coerce_op;
             }
         }
-    } else if(a_field.type == field_types::INT32) {
+    } else if(type == coerce_type_t::INT32) {
         if(!doc_ele.is_number_integer()) {
             Option<uint32_t> coerce_op = coerce_int32_t(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
             if(!coerce_op.ok()) {
                 return coerce_op;
             }
         }
-    } else if(a_field.type == field_types::INT64) {
+    } else if(type == coerce_type_t::INT64) {
         if(!doc_ele.is_number_integer()) {
             Option<uint32_t> coerce_op = coerce_int64_t(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
             if(!coerce_op.ok()) {
                 return coerce_op;
             }
         }
-    } else if(a_field.type == field_types::FLOAT) {
+    } else if(type == coerce_type_t::FLOAT) {
         if(!doc_ele.is_number()) {
             // using `is_number` allows integer to be passed to a float field
             Option<uint32_t> coerce_op = coerce_float(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
@@ -40,14 +85,14 @@ Option<uint32_t> validator_t::coerce_element(const field& a_field, nlohmann::jso
                 return coerce_op;
             }
         }
-    } else if(a_field.type == field_types::BOOL) {
+    } else if(type == coerce_type_t::BOOL) {
         if(!doc_ele.is_boolean()) {
             Option<uint32_t> coerce_op = coerce_bool(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
             if(!coerce_op.ok()) {
                 return coerce_op;
             }
         }
-    } else if(a_field.type == field_types::GEOPOINT) {
+    } else if(type == coerce_type_t::GEOPOINT) {
         if(!doc_ele.is_array() || doc_ele.size() != 2) {
             return Option<>(400, "Field `" + field_name  + "` must be a 2 element array: [lat, lng].");
         }
@@ -61,9 +106,9 @@ Option<uint32_t> validator_t::coerce_element(const field& a_field, nlohmann::jso
                 return coerce_op;
             }
         }
-    } else if(a_field.is_array()) {
+    } else if(type != coerce_type_t::OTHER) {
         if(!doc_ele.is_array()) {
-            bool is_auto_embedding = a_field.type == field_types::FLOAT_ARRAY && a_field.embed.count(fields::from) > 0;
+            bool is_auto_embedding = type == coerce_type_t::FLOAT_ARRAY && a_field.embed.count(fields::from) > 0;
             if((a_field.optional && (dirty_values == DIRTY_VALUES::DROP ||
                                     dirty_values == DIRTY_VALUES::COERCE_OR_DROP)) || is_auto_embedding) {
                 document.erase(field_name);
@@ -77,7 +122,7 @@ Option<uint32_t> validator_t::coerce_element(const field& a_field, nlohmann::jso
 
         // have to differentiate the geopoint[] type of a nested array object's geopoint[] vs a simple nested field
         // geopoint[] type of an array of objects field won't be an array of array
-        if(a_field.nested && a_field.type == field_types::GEOPOINT_ARRAY && it != doc_ele.end() && it->is_number()) {
+        if(a_field.nested && type == coerce_type_t::GEOPOINT_ARRAY && it != doc_ele.end() && it->is_number()) {
             if(!doc_ele.empty() && doc_ele.size() % 2 != 0) {
                 return Option<>(400, "Nested field `" + field_name  + "` does not contain valid geopoint values.");
             }
@@ -101,7 +146,7 @@ Option<uint32_t> validator_t::coerce_element(const field& a_field, nlohmann::jso
             return Option<uint32_t>(200);
         }
 
-        if(a_field.type == field_types::FLOAT_ARRAY && a_field.num_dim != 0 && a_field.num_dim != doc_ele.size()) {
+        if(type == coerce_type_t::FLOAT_ARRAY && a_field.num_dim != 0 && a_field.num_dim != doc_ele.size()) {
             return Option<uint32_t>(400, "Field `" + a_field.name + "` must have " +
                                     std::to_string(a_field.num_dim)  + " dimensions.");
         }
@@ -110,33 +155,33 @@ Option<uint32_t> validator_t::coerce_element(const field& a_field, nlohmann::jso
             nlohmann::json& item = it.value();
             array_ele_erased = false;
 
-            if (a_field.type == field_types::STRING_ARRAY && !item.is_string()) {
+            if (type == coerce_type_t::STRING_ARRAY && !item.is_string()) {
                 Option<uint32_t> coerce_op = coerce_string(dirty_values, fallback_field_type, a_field, document, field_name, it, true, array_ele_erased);
                 if (!coerce_op.ok()) {
                     return coerce_op;
                 }
-            } else if (a_field.type == field_types::INT32_ARRAY && !item.is_number_integer()) {
+            } else if (type == coerce_type_t::INT32_ARRAY && !item.is_number_integer()) {
                 Option<uint32_t> coerce_op = coerce_int32_t(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
                 if (!coerce_op.ok()) {
                     return coerce_op;
                 }
-            } else if (a_field.type == field_types::INT64_ARRAY && !item.is_number_integer()) {
+            } else if (type == coerce_type_t::INT64_ARRAY && !item.is_number_integer()) {
                 Option<uint32_t> coerce_op = coerce_int64_t(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
                 if (!coerce_op.ok()) {
                     return coerce_op;
                 }
-            } else if (a_field.type == field_types::FLOAT_ARRAY && !item.is_number()) {
+            } else if (type == coerce_type_t::FLOAT_ARRAY && !item.is_number()) {
                 // we check for `is_number` to allow whole numbers to be passed into float fields
                 Option<uint32_t> coerce_op = coerce_float(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
                 if (!coerce_op.ok()) {
                     return coerce_op;
                 }
-            } else if (a_field.type == field_types::BOOL_ARRAY && !item.is_boolean()) {
+            } else if (type == coerce_type_t::BOOL_ARRAY && !item.is_boolean()) {
                 Option<uint32_t> coerce_op = coerce_bool(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
                 if (!coerce_op.ok()) {
                     return coerce_op;
                 }
-            } else if (a_field.type == field_types::GEOPOINT_ARRAY) {
+            } else if (type == coerce_type_t::GEOPOINT_ARRAY) {
                 if(!item.is_array() || item.size() != 2) {
                     return Option<>(400, "Field `" + field_name  + "` must contain 2 element arrays: [ [lat, lng],... ].");
                 }
@@ -627,6 +672,21 @@ Option<uint32_t> validator_t::validate_index_in_memory(nlohmann::json& document,
                                                  const bool is_update,
                                                  const std::string& fallback_field_type,
                                                  const DIRTY_VALUES& dirty_values, const bool validate_embedding_fields) {
+    const validator_program_t program(search_schema, embedding_fields);
+    return validate_index_in_memory(document, seq_id, default_sorting_field, program, search_schema,
+                                    embedding_fields, op, is_update, fallback_field_type, dirty_values,
+                                    validate_embedding_fields);
+}
+
+Option<uint32_t> validator_t::validate_index_in_memory(nlohmann::json& document, uint32_t seq_id,
+                                                 const std::string & default_sorting_field,
+                                                 const validator_program_t& program,
+                                                 const tsl::htrie_map<char, field> & search_schema,
+                                                 const tsl::htrie_map<char, field> & embedding_fields,
+                                                 const index_operation_t op,
+                                                 const bool is_update,
+                                                 const std::string& fallback_field_type,
+                                                 const DIRTY_VALUES& dirty_values, const bool validate_embedding_fields) {
 
     bool missing_default_sort_field = (!default_sorting_field.empty() && document.count(default_sorting_field) == 0);
 
@@ -635,41 +695,36 @@ Option<uint32_t> validator_t::validate_index_in_memory(nlohmann::json& document,
                                                                   "but is not found in the document.");
     }
 
-    for(const auto& a_field: search_schema) {
-        const std::string& field_name = a_field.name;
-
-        // ignore embedding fields, they will be validated later
-        if(embedding_fields.count(field_name) > 0) {
-            continue;
-        }
+    const bool skip_missing = (op == UPDATE || (op == EMPLACE && is_update));
 
-        if(field_name == "id" || a_field.is_object()) {
-            continue;
-        }
+    for(const auto& check: program.checks) {
+        const field& a_field = *check.a_field;
+        const std::string& field_name = a_field.name;
 
-        if((a_field.optional || op == UPDATE || (op == EMPLACE && is_update)) && document.count(field_name) == 0) {
-            continue;
-        }
+        // the value is looked up once, and coerced in place
+        auto doc_ele_it = document.find(field_name);
 
-        bool is_auto_embedding = a_field.type == field_types::FLOAT_ARRAY && a_field.embed.count(fields::from) > 0;
+        if(doc_ele_it == document.end()) {
+            if(a_field.optional || skip_missing || check.is_auto_embedding) {
+                continue;
+            }
 
-        if(document.count(field_name) == 0 && !is_auto_embedding) {
             return Option<>(400, "Field `" + field_name  + "` has been declared in the schema, "
                                                            "but is not found in the document.");
         }
 
-        nlohmann::json& doc_ele = document[field_name];
+        nlohmann::json& doc_ele = doc_ele_it.value();
 
         if(a_field.optional && doc_ele.is_null()) {
             // we will ignore `null` on an option field
             if(!is_update) {
                 // for updates, the erasure is done later since we need to keep the key for overwrite
-                document.erase(field_name);
+                document.erase(doc_ele_it);
             }
             continue;
         }
 
-        auto coerce_op = coerce_element(a_field, document, doc_ele, fallback_field_type, dirty_values);
+        auto coerce_op = coerce_element(a_field, check.type, document, doc_ele, fallback_field_type, dirty_values);
         if(!coerce_op.ok()) {
             return coerce_op;
         }
@@ -686,7 +741,6 @@ Option<uint32_t> validator_t::validate_index_in_memory(nlohmann::json& document,
     return Option<>(200);
 }
 
-
 Option<bool> validator_t::validate_embed_fields(const nlohmann::json& document, 
                                           const tsl::htrie_map<char, field>& embedding_fields, 
                                           const tsl::htrie_map<char, field> & search_schema,
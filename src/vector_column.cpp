@@ -0,0 +1,155 @@
+#include "vector_column.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+vector_column_t::vector_column_t(size_t num_dim):
+        num_dim(num_dim),
+        row_size((num_dim * sizeof(float) + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT) {
+
+}
+
+vector_column_t::~vector_column_t() {
+    std::free(data);
+}
+
+void vector_column_t::reserve(size_t min_capacity) {
+    if(min_capacity <= capacity) {
+        return;
+    }
+
+    size_t new_capacity = std::max(capacity, INITIAL_CAPACITY);
+    while(new_capacity < min_capacity) {
+        new_capacity *= 2;
+    }
+
+    // row_size is a multiple of the alignment, as aligned_alloc needs
+    auto new_data = static_cast<float*>(std::aligned_alloc(ROW_ALIGNMENT, std::max<size_t>(1, new_capacity * row_size)));
+    if(new_data == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    if(data != nullptr) {
+        std::memcpy(new_data, data, capacity * row_size);
+        std::free(data);
+    }
+
+    data = new_data;
+    capacity = new_capacity;
+    present.resize(new_capacity, false);
+}
+
+void vector_column_t::put(uint32_t seq_id, const float* values) {
+    std::unique_lock lock(mutex);
+
+    reserve(size_t(seq_id) + 1);
+
+    auto row = reinterpret_cast<char*>(data) + size_t(seq_id) * row_size;
+    std::memcpy(row, values, num_dim * sizeof(float));
+
+    if(!present[seq_id]) {
+        present[seq_id] = true;
+        num_vectors++;
+    }
+}
+
+bool vector_column_t::get(uint32_t seq_id, std::vector<float>& values) const {
+    std::shared_lock lock(mutex);
+
+    if(seq_id >= capacity || !present[seq_id]) {
+        return false;
+    }
+
+    auto row = reinterpret_cast<const float*>(reinterpret_cast<const char*>(data) + size_t(seq_id) * row_size);
+    values.assign(row, row + num_dim);
+    return true;
+}
+
+void vector_column_t::remove(uint32_t seq_id) {
+    std::unique_lock lock(mutex);
+
+    if(seq_id < capacity && present[seq_id]) {
+        present[seq_id] = false;
+        num_vectors--;
+    }
+}
+
+size_t vector_column_t::size() const {
+    std::shared_lock lock(mutex);
+    return num_vectors;
+}
+
+void vector_column_t::distances(const float* query, const uint32_t* seq_ids, size_t num_ids,
+                                hnswlib::DISTFUNC<float> dist_func, const void* dist_func_param,
+                                std::vector<std::pair<float, size_t>>& dist_labels) const {
+    std::shared_lock lock(mutex);
+
+    const auto base = reinterpret_cast<const char*>(data);
+
+    for(size_t i = 0; i < num_ids; i++) {
+        if(i + PREFETCH_DISTANCE < num_ids && seq_ids[i + PREFETCH_DISTANCE] < capacity) {
+            const char* ahead = base + size_t(seq_ids[i + PREFETCH_DISTANCE]) * row_size;
+            for(size_t offset = 0; offset < row_size; offset += ROW_ALIGNMENT) {
+                __builtin_prefetch(ahead + offset);
+            }
+        }
+
+        const uint32_t seq_id = seq_ids[i];
+        if(seq_id >= capacity || !present[seq_id]) {
+            continue;
+        }
+
+        dist_labels.emplace_back(dist_func(query, base + size_t(seq_id) * row_size, dist_func_param), seq_id);
+    }
+}
+
+void vector_column_t::min_distances(const float* const* queries, size_t num_queries, const uint32_t* seq_ids,
+                                    size_t num_ids, hnswlib::DISTFUNC<float> dist_func, const void* dist_func_param,
+                                    float* distances) const {
+    std::shared_lock lock(mutex);
+
+    const auto base = reinterpret_cast<const char*>(data);
+
+    for(size_t i = 0; i < num_ids; i++) {
+        if(i + PREFETCH_DISTANCE < num_ids && seq_ids[i + PREFETCH_DISTANCE] < capacity) {
+            const char* ahead = base + size_t(seq_ids[i + PREFETCH_DISTANCE]) * row_size;
+            for(size_t offset = 0; offset < row_size; offset += ROW_ALIGNMENT) {
+                __builtin_prefetch(ahead + offset);
+            }
+        }
+
+        const uint32_t seq_id = seq_ids[i];
+        if(seq_id >= capacity || !present[seq_id]) {
+            continue;
+        }
+
+        const char* row = base + size_t(seq_id) * row_size;
+        float distance = dist_func(queries[0], row, dist_func_param);
+        for(size_t q = 1; q < num_queries; q++) {
+            distance = std::min(distance, dist_func(queries[q], row, dist_func_param));
+        }
+
+        distances[i] = distance;
+    }
+}
+
+void vector_column_t::gather(const uint32_t* seq_ids, size_t num_ids, std::vector<float>& rows,
+                             std::vector<size_t>& row_indices) const {
+    std::shared_lock lock(mutex);
+
+    rows.reserve(rows.size() + num_ids * num_dim);
+    row_indices.reserve(row_indices.size() + num_ids);
+
+    for(size_t i = 0; i < num_ids; i++) {
+        const uint32_t seq_id = seq_ids[i];
+        if(seq_id >= capacity || !present[seq_id]) {
+            continue;
+        }
+
+        auto row = reinterpret_cast<const float*>(reinterpret_cast<const char*>(data) + size_t(seq_id) * row_size);
+        rows.insert(rows.end(), row, row + num_dim);
+        row_indices.push_back(i);
+    }
+}
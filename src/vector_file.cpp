@@ -0,0 +1,158 @@
+#include "vector_file.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+bool parse_vector_storage(const std::string& name, vector_storage_t& storage) {
+    if(name == "memory") {
+        storage = memory_storage;
+    } else if(name == "disk") {
+        storage = disk_storage;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+vector_file_t::vector_file_t(size_t num_dim): num_dim(num_dim), record_size(num_dim * sizeof(float)) {
+
+}
+
+vector_file_t::~vector_file_t() {
+    if(data != nullptr) {
+        munmap(data, capacity * record_size);
+    }
+
+    if(fd != -1) {
+        close(fd);
+    }
+}
+
+Option<bool> vector_file_t::open(const std::string& dir_path) {
+    static std::atomic<uint64_t> file_num = 0;
+
+    std::unique_lock lock(mutex);
+
+    const std::string file_path = dir_path + "/vectors_" + std::to_string(getpid()) + "_" +
+                                  std::to_string(file_num++) + ".vec";
+
+    fd = ::open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if(fd == -1) {
+        return Option<bool>(500, "Unable to create vector file `" + file_path + "`: " + strerror(errno));
+    }
+
+    // kept only as long as it is open
+    unlink(file_path.c_str());
+
+    if(!reserve(INITIAL_CAPACITY)) {
+        return Option<bool>(500, "Unable to map vector file `" + file_path + "`: " + strerror(errno));
+    }
+
+    return Option<bool>(true);
+}
+
+bool vector_file_t::reserve(size_t min_capacity) {
+    if(min_capacity <= capacity) {
+        return true;
+    }
+
+    if(record_size == 0) {
+        capacity = min_capacity;
+        return true;
+    }
+
+    size_t new_capacity = std::max(capacity, INITIAL_CAPACITY);
+    while(new_capacity < min_capacity) {
+        new_capacity *= 2;
+    }
+
+    if(ftruncate(fd, new_capacity * record_size) != 0) {
+        return false;
+    }
+
+    void* new_data = mmap(nullptr, new_capacity * record_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(new_data == MAP_FAILED) {
+        return false;
+    }
+
+    // vectors are read for the candidates of searches, which are all over the file
+    madvise(new_data, new_capacity * record_size, MADV_RANDOM);
+
+    if(data != nullptr) {
+        munmap(data, capacity * record_size);
+    }
+
+    data = static_cast<char*>(new_data);
+    capacity = new_capacity;
+    return true;
+}
+
+bool vector_file_t::put(uint32_t seq_id, const float* values) {
+    std::unique_lock lock(mutex);
+
+    if(fd == -1) {
+        return false;
+    }
+
+    uint32_t slot;
+    auto slot_it = slots.find(seq_id);
+
+    if(slot_it != slots.end()) {
+        slot = slot_it->second;
+    } else if(!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+        slots.emplace(seq_id, slot);
+    } else {
+        if(!reserve(num_slots + 1)) {
+            return false;
+        }
+
+        slot = num_slots++;
+        slots.emplace(seq_id, slot);
+    }
+
+    std::memcpy(data + size_t(slot) * record_size, values, record_size);
+    return true;
+}
+
+bool vector_file_t::get(uint32_t seq_id, std::vector<float>& values) const {
+    std::shared_lock lock(mutex);
+
+    auto slot_it = slots.find(seq_id);
+    if(slot_it == slots.end()) {
+        return false;
+    }
+
+    values.resize(num_dim);
+    std::memcpy(values.data(), data + size_t(slot_it->second) * record_size, record_size);
+    return true;
+}
+
+void vector_file_t::remove(uint32_t seq_id) {
+    std::unique_lock lock(mutex);
+
+    auto slot_it = slots.find(seq_id);
+    if(slot_it == slots.end()) {
+        return;
+    }
+
+    free_slots.push_back(slot_it->second);
+    slots.erase(slot_it);
+}
+
+size_t vector_file_t::size() const {
+    std::shared_lock lock(mutex);
+    return slots.size();
+}
+
+size_t vector_file_t::file_size() const {
+    std::shared_lock lock(mutex);
+    return capacity * record_size;
+}
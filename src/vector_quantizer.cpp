@@ -0,0 +1,209 @@
+#include "vector_quantizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+    struct sq8_meta_t {
+        float lower;
+        float scale;
+        float code_sum;
+    };
+
+    typedef uint32_t (*dot_codes_t)(const uint8_t*, const uint8_t*, size_t);
+
+#if defined(__x86_64__)
+    __attribute__((target("avx512bw")))
+    uint32_t dot_codes_avx512(const uint8_t* a, const uint8_t* b, size_t num_codes) {
+        __m512i acc = _mm512_setzero_si512();
+        size_t i = 0;
+
+        for(; i + 32 <= num_codes; i += 32) {
+            __m512i va = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*) (a + i)));
+            __m512i vb = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i*) (b + i)));
+            acc = _mm512_add_epi32(acc, _mm512_madd_epi16(va, vb));
+        }
+
+        alignas(64) uint32_t lanes[16];
+        _mm512_store_si512(lanes, acc);
+
+        uint32_t sum = 0;
+        for(auto lane: lanes) {
+            sum += lane;
+        }
+
+        for(; i < num_codes; i++) {
+            sum += uint32_t(a[i]) * b[i];
+        }
+
+        return sum;
+    }
+
+    __attribute__((target("avx2")))
+    uint32_t dot_codes_avx2(const uint8_t* a, const uint8_t* b, size_t num_codes) {
+        __m256i acc = _mm256_setzero_si256();
+        size_t i = 0;
+
+        for(; i + 16 <= num_codes; i += 16) {
+            __m256i va = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (a + i)));
+            __m256i vb = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (b + i)));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+        }
+
+        __m128i acc_128 = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        acc_128 = _mm_add_epi32(acc_128, _mm_shuffle_epi32(acc_128, _MM_SHUFFLE(1, 0, 3, 2)));
+        acc_128 = _mm_add_epi32(acc_128, _mm_shuffle_epi32(acc_128, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        uint32_t sum = _mm_cvtsi128_si32(acc_128);
+        for(; i < num_codes; i++) {
+            sum += uint32_t(a[i]) * b[i];
+        }
+
+        return sum;
+    }
+#elif defined(__aarch64__)
+    uint32_t dot_codes_neon(const uint8_t* a, const uint8_t* b, size_t num_codes) {
+        uint32x4_t acc = vdupq_n_u32(0);
+        size_t i = 0;
+
+        for(; i + 16 <= num_codes; i += 16) {
+            uint8x16_t va = vld1q_u8(a + i);
+            uint8x16_t vb = vld1q_u8(b + i);
+            acc = vpadalq_u16(acc, vmull_u8(vget_low_u8(va), vget_low_u8(vb)));
+            acc = vpadalq_u16(acc, vmull_high_u8(va, vb));
+        }
+
+        uint32_t sum = vaddvq_u32(acc);
+        for(; i < num_codes; i++) {
+            sum += uint32_t(a[i]) * b[i];
+        }
+
+        return sum;
+    }
+#endif
+
+    struct dot_codes_kernel_t {
+        dot_codes_t func = sq8_space_t::dot_codes_scalar;
+        const char* name = "scalar";
+
+        dot_codes_kernel_t() {
+#if defined(__x86_64__)
+            if(__builtin_cpu_supports("avx512bw")) {
+                func = dot_codes_avx512;
+                name = "avx512";
+            } else if(__builtin_cpu_supports("avx2")) {
+                func = dot_codes_avx2;
+                name = "avx2";
+            }
+#elif defined(__aarch64__)
+            func = dot_codes_neon;
+            name = "neon";
+#endif
+        }
+    };
+
+    const dot_codes_kernel_t& get_dot_codes_kernel() {
+        static const dot_codes_kernel_t kernel;
+        return kernel;
+    }
+}
+
+sq8_space_t::sq8_space_t(size_t num_dim) {
+    params.num_dim = num_dim;
+    params.meta_offset = (num_dim + 3) / 4 * 4;
+    params.record_size = params.meta_offset + sizeof(sq8_meta_t);
+}
+
+size_t sq8_space_t::get_data_size() {
+    return params.record_size;
+}
+
+hnswlib::DISTFUNC<float> sq8_space_t::get_dist_func() {
+    return distance;
+}
+
+void* sq8_space_t::get_dist_func_param() {
+    return &params;
+}
+
+void sq8_space_t::encode(const float* values, std::vector<uint8_t>& record) const {
+    record.assign(params.record_size, 0);
+
+    if(params.num_dim == 0) {
+        return;
+    }
+
+    const auto min_max = std::minmax_element(values, values + params.num_dim);
+    sq8_meta_t meta{*min_max.first, (*min_max.second - *min_max.first) / 255.0f, 0};
+
+    for(size_t i = 0; i < params.num_dim; i++) {
+        float code = (meta.scale == 0) ? 0 : std::round((values[i] - meta.lower) / meta.scale);
+        record[i] = uint8_t(std::min(255.0f, std::max(0.0f, code)));
+        meta.code_sum += record[i];
+    }
+
+    std::memcpy(record.data() + params.meta_offset, &meta, sizeof(meta));
+}
+
+void sq8_space_t::decode(const uint8_t* record, std::vector<float>& values) const {
+    sq8_meta_t meta;
+    std::memcpy(&meta, record + params.meta_offset, sizeof(meta));
+
+    values.resize(params.num_dim);
+    for(size_t i = 0; i < params.num_dim; i++) {
+        values[i] = meta.lower + meta.scale * record[i];
+    }
+}
+
+float sq8_space_t::distance(const void* a, const void* b, const void* params) {
+    const auto space_params = static_cast<const params_t*>(params);
+    const auto codes_a = static_cast<const uint8_t*>(a);
+    const auto codes_b = static_cast<const uint8_t*>(b);
+
+    sq8_meta_t meta_a, meta_b;
+    std::memcpy(&meta_a, codes_a + space_params->meta_offset, sizeof(meta_a));
+    std::memcpy(&meta_b, codes_b + space_params->meta_offset, sizeof(meta_b));
+
+    // sum of (lower_a + scale_a * code_a) * (lower_b + scale_b * code_b)
+    const float dot = space_params->num_dim * meta_a.lower * meta_b.lower +
+                      meta_a.lower * meta_b.scale * meta_b.code_sum +
+                      meta_b.lower * meta_a.scale * meta_a.code_sum +
+                      meta_a.scale * meta_b.scale * float(dot_codes(codes_a, codes_b, space_params->num_dim));
+
+    return 1.0f - dot;
+}
+
+uint32_t sq8_space_t::dot_codes(const uint8_t* a, const uint8_t* b, size_t num_codes) {
+    return get_dot_codes_kernel().func(a, b, num_codes);
+}
+
+uint32_t sq8_space_t::dot_codes_scalar(const uint8_t* a, const uint8_t* b, size_t num_codes) {
+    uint32_t sum = 0;
+    for(size_t i = 0; i < num_codes; i++) {
+        sum += uint32_t(a[i]) * b[i];
+    }
+
+    return sum;
+}
+
+const char* sq8_space_t::kernel_name() {
+    return get_dot_codes_kernel().name;
+}
+
+bool parse_vector_quantization(const std::string& name, vector_quantization_t& quantization) {
+    if(name == "none") {
+        quantization = no_quantization;
+    } else if(name == "sq8") {
+        quantization = sq8;
+    } else {
+        return false;
+    }
+
+    return true;
+}
@@ -47,28 +47,79 @@ Option<bool> VectorQueryOps::parse_vector_query_str(const std::string& vector_qu
 
             i++;
 
-            std::string values_str;
-            while(i < vector_query_str.size() && vector_query_str[i] != ']') {
-                values_str += vector_query_str[i];
+            while(i < vector_query_str.size() && vector_query_str[i] == ' ') {
                 i++;
             }
 
-            if(vector_query_str[i] != ']') {
+            std::vector<std::string> values_strs;
+
+            if(i < vector_query_str.size() && vector_query_str[i] == '[') {
+                // several query vectors: field_name([[0.34, 0.66], [0.12, 0.68]])
+                while(i < vector_query_str.size() && vector_query_str[i] != ']') {
+                    if(vector_query_str[i] == ' ' || vector_query_str[i] == ',') {
+                        i++;
+                        continue;
+                    }
+
+                    if(vector_query_str[i] != '[') {
+                        return Option<bool>(400, "Malformed vector query string.");
+                    }
+
+                    i++;
+
+                    std::string values_str;
+                    while(i < vector_query_str.size() && vector_query_str[i] != ']') {
+                        values_str += vector_query_str[i];
+                        i++;
+                    }
+
+                    if(i == vector_query_str.size()) {
+                        // missing closing "]"
+                        return Option<bool>(400, "Malformed vector query string.");
+                    }
+
+                    i++;
+                    values_strs.push_back(values_str);
+                }
+            } else {
+                std::string values_str;
+                while(i < vector_query_str.size() && vector_query_str[i] != ']') {
+                    values_str += vector_query_str[i];
+                    i++;
+                }
+
+                values_strs.push_back(values_str);
+            }
+
+            if(i == vector_query_str.size() || vector_query_str[i] != ']') {
                 // missing closing "]"
                 return Option<bool>(400, "Malformed vector query string.");
             }
 
             i++;
 
-            std::vector<std::string> svalues;
-            StringUtils::split(values_str, svalues, ",");
+            for(size_t j = 0; j < values_strs.size(); j++) {
+                std::vector<std::string> svalues;
+                StringUtils::split(values_strs[j], svalues, ",");
 
-            for(auto& svalue: svalues) {
-                if(!StringUtils::is_float(svalue)) {
-                    return Option<bool>(400, "Malformed vector query string: one of the vector values is not a float.");
+                std::vector<float> values;
+                for(auto& svalue: svalues) {
+                    if(!StringUtils::is_float(svalue)) {
+                        return Option<bool>(400, "Malformed vector query string: one of the vector values is not a float.");
+                    }
+
+                    values.push_back(std::stof(svalue));
+                }
+
+                if(values_strs.size() > 1 && values.empty()) {
+                    return Option<bool>(400, "Malformed vector query string: one of the query vectors is empty.");
                 }
 
-                vector_query.values.push_back(std::stof(svalue));
+                if(j == 0) {
+                    vector_query.values = std::move(values);
+                } else {
+                    vector_query.extra_values.push_back(std::move(values));
+                }
             }
 
             if(i == vector_query_str.size()-1) {
@@ -118,33 +169,55 @@ Option<bool> VectorQueryOps::parse_vector_query_str(const std::string& vector_qu
                                                  "and `id` parameter.");
                     }
 
-                    Option<uint32_t> id_op = coll->doc_id_to_seq_id(param_kv[1]);
-                    if(!id_op.ok()) {
-                        return Option<bool>(400, "Document id referenced in vector query is not found.");
+                    // several documents can be referenced: id: [doc_a, doc_b]
+                    std::vector<std::string> doc_ids;
+                    if(param_kv[1].front() == '[' && param_kv[1].back() == ']') {
+                        StringUtils::split(param_kv[1].substr(1, param_kv[1].size() - 2), doc_ids, ",");
+                    } else {
+                        doc_ids.push_back(param_kv[1]);
                     }
 
-                    nlohmann::json document;
-                    auto doc_op  = coll->get_document_from_store(id_op.get(), document);
-                    if(!doc_op.ok()) {
+                    if(doc_ids.empty()) {
                         return Option<bool>(400, "Document id referenced in vector query is not found.");
                     }
 
-                    if(!document.contains(vector_query.field_name) || !document[vector_query.field_name].is_array()) {
-                        return Option<bool>(400, "Document referenced in vector query does not contain a valid "
-                                                 "vector field.");
-                    }
+                    for(size_t j = 0; j < doc_ids.size(); j++) {
+                        Option<uint32_t> id_op = coll->doc_id_to_seq_id(doc_ids[j]);
+                        if(!id_op.ok()) {
+                            return Option<bool>(400, "Document id referenced in vector query is not found.");
+                        }
+
+                        nlohmann::json document;
+                        auto doc_op  = coll->get_document_from_store(id_op.get(), document);
+                        if(!doc_op.ok()) {
+                            return Option<bool>(400, "Document id referenced in vector query is not found.");
+                        }
 
-                    for(auto& fvalue: document[vector_query.field_name]) {
-                        if(!fvalue.is_number_float()) {
+                        if(!document.contains(vector_query.field_name) || !document[vector_query.field_name].is_array()) {
                             return Option<bool>(400, "Document referenced in vector query does not contain a valid "
                                                      "vector field.");
                         }
 
-                        vector_query.values.push_back(fvalue.get<float>());
+                        std::vector<float> values;
+                        for(auto& fvalue: document[vector_query.field_name]) {
+                            if(!fvalue.is_number_float()) {
+                                return Option<bool>(400, "Document referenced in vector query does not contain a valid "
+                                                         "vector field.");
+                            }
+
+                            values.push_back(fvalue.get<float>());
+                        }
+
+                        if(j == 0) {
+                            vector_query.values = std::move(values);
+                            vector_query.seq_id = id_op.get();
+                        } else {
+                            vector_query.extra_values.push_back(std::move(values));
+                            vector_query.extra_seq_ids.push_back(id_op.get());
+                        }
                     }
 
                     vector_query.query_doc_given = true;
-                    vector_query.seq_id = id_op.get();
                 }
 
                 if(param_kv[0] == "k") {
@@ -162,6 +235,7 @@ Option<bool> VectorQueryOps::parse_vector_query_str(const std::string& vector_qu
                     }
 
                     vector_query.flat_search_cutoff = std::stoi(param_kv[1]);
+                    vector_query.flat_search_cutoff_given = true;
                 }
 
                 if(param_kv[0] == "distance_threshold") {
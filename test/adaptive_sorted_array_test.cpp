@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "adaptive_sorted_array.h"
+#include "array_utils.h"
+#include <vector>
+#include <set>
+#include <random>
+
+TEST(AdaptiveSortedArrayTest, DenseIdsSwitchToBitmap) {
+    adaptive_sorted_array arr;
+
+    for(uint32_t i = 0; i < 256; i++) {
+        arr.append(1000 + i);
+    }
+
+    ASSERT_TRUE(arr.bitmap());
+    ASSERT_EQ(256, arr.getLength());
+    ASSERT_EQ(1000, arr.at(0));
+    ASSERT_EQ(1100, arr.at(100));
+    ASSERT_EQ(1255, arr.last());
+    ASSERT_EQ(10, arr.indexOf(1010));
+    ASSERT_EQ(256, arr.indexOf(999));
+    ASSERT_TRUE(arr.contains(1128));
+    ASSERT_FALSE(arr.contains(1256));
+
+    // a far away ID makes the set sparse again
+    arr.append(1000 * 1000);
+    ASSERT_FALSE(arr.bitmap());
+    ASSERT_EQ(257, arr.getLength());
+    ASSERT_EQ(1000 * 1000, arr.last());
+    ASSERT_TRUE(arr.contains(1128));
+
+    arr.remove_value(1000 * 1000);
+    ASSERT_EQ(1255, arr.last());
+
+    uint32_t* ids = arr.uncompress();
+    for(uint32_t i = 0; i < 256; i++) {
+        ASSERT_EQ(1000 + i, ids[i]);
+    }
+    delete [] ids;
+}
+
+TEST(AdaptiveSortedArrayTest, SparseIdsStayAsArray) {
+    std::vector<uint32_t> sparse_ids;
+    for(uint32_t i = 0; i < 256; i++) {
+        sparse_ids.push_back(i * 1000);
+    }
+
+    adaptive_sorted_array arr;
+    arr.load(sparse_ids.data(), sparse_ids.size());
+    ASSERT_FALSE(arr.bitmap());
+    ASSERT_EQ(255 * 1000, arr.last());
+
+    std::vector<uint32_t> dense_ids;
+    for(uint32_t i = 0; i < 256; i += 2) {
+        dense_ids.push_back(i);
+    }
+
+    arr.load(dense_ids.data(), dense_ids.size());
+    ASSERT_TRUE(arr.bitmap());
+    ASSERT_EQ(128, arr.getLength());
+
+    // shrinking below the minimum length goes back to an array
+    for(uint32_t i = 0; i < 100; i++) {
+        arr.remove_value(dense_ids[i]);
+    }
+
+    ASSERT_FALSE(arr.bitmap());
+    ASSERT_EQ(28, arr.getLength());
+    ASSERT_EQ(200, arr.at(0));
+}
+
+TEST(AdaptiveSortedArrayTest, RandomOperationsMatchSet) {
+    std::mt19937 rng(42);
+
+    for(size_t round = 0; round < 50; round++) {
+        adaptive_sorted_array arr;
+        std::set<uint32_t> expected;
+        const uint32_t range = (round % 2 == 0) ? 500 : 100 * 1000;
+
+        for(size_t op = 0; op < 1000; op++) {
+            uint32_t id = 5000 + rng() % range;
+
+            if(rng() % 4 != 0) {
+                if(!arr.contains(id)) {
+                    arr.append(id);
+                }
+                expected.insert(id);
+            } else {
+                arr.remove_value(id);
+                expected.erase(id);
+            }
+
+            ASSERT_EQ(expected.size(), arr.getLength());
+            ASSERT_EQ(expected.count(id) != 0, arr.contains(id));
+        }
+
+        uint32_t* ids = arr.uncompress();
+        size_t i = 0;
+        for(auto id: expected) {
+            ASSERT_EQ(id, ids[i++]);
+        }
+        delete [] ids;
+    }
+}
+
+TEST(AdaptiveSortedArrayTest, OrBitmapMatchesOrScalar) {
+    std::vector<uint32_t> a = {1, 3, 5, 64, 65, 200};
+    std::vector<uint32_t> b = {2, 3, 63, 64, 300};
+
+    uint32_t* expected = nullptr;
+    size_t expected_len = ArrayUtils::or_scalar(a.data(), a.size(), b.data(), b.size(), &expected);
+
+    std::vector<uint32_t> out(a.size() + b.size());
+    size_t out_len = ArrayUtils::or_bitmap(a.data(), a.size(), b.data(), b.size(), out.data());
+
+    ASSERT_EQ(expected_len, out_len);
+    for(size_t i = 0; i < out_len; i++) {
+        ASSERT_EQ(expected[i], out[i]);
+    }
+
+    delete [] expected;
+}
@@ -118,3 +118,41 @@ TEST_F(ADITreeTest, InsertDeleteManyElements) {
         tree.remove(i);
     }
 }
+
+TEST_F(ADITreeTest, RankArrayMatchesTreeWalk) {
+    adi_tree_t tree;
+    std::vector<std::string> keys = {"foo", "foobar", "alpha", "ant", "beta", "map", "map", "zeta", "b"};
+
+    for(size_t i = 0; i < keys.size(); i++) {
+        tree.index(i * 3, keys[i]);
+    }
+
+    // the first lookups walk the tree, until as many ranks as there are keys have been asked for
+    std::vector<size_t> walked_ranks;
+    for(size_t i = 0; i < keys.size(); i++) {
+        walked_ranks.push_back(tree.rank(i * 3));
+    }
+
+    for(size_t round = 0; round < 3; round++) {
+        for(size_t i = 0; i < keys.size(); i++) {
+            ASSERT_EQ(walked_ranks[i], tree.rank(i * 3));
+        }
+
+        ASSERT_EQ(INT64_MAX, tree.rank(1));
+        ASSERT_EQ(INT64_MAX, tree.rank(1000));
+    }
+
+    ASSERT_EQ(1, tree.rank(6));   // alpha
+    ASSERT_EQ(tree.rank(15), tree.rank(18));  // map
+
+    // writes invalidate the ranks
+    tree.remove(6);
+    tree.index(100, "aardvark");
+
+    for(size_t round = 0; round < 3; round++) {
+        ASSERT_EQ(1, tree.rank(100));
+        ASSERT_EQ(INT64_MAX, tree.rank(6));
+        ASSERT_EQ(2, tree.rank(9));   // ant
+        ASSERT_EQ(walked_ranks[1], tree.rank(3));  // foobar, which still has one key ranked before it
+    }
+}
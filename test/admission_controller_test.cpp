@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "admission_controller.h"
+
+class AdmissionControllerTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        AdmissionController::get_instance().init(4, 64);
+    }
+
+    virtual void TearDown() {
+        AdmissionController::get_instance().disable();
+    }
+};
+
+TEST_F(AdmissionControllerTest, RejectsSearchesBeyondLimit) {
+    auto& controller = AdmissionController::get_instance();
+    ASSERT_TRUE(controller.is_enabled());
+    ASSERT_EQ(4, controller.get_limit());
+
+    for(size_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(controller.try_admit(false));
+    }
+
+    ASSERT_FALSE(controller.try_admit(false));
+    ASSERT_EQ(4, controller.get_in_flight());
+
+    // high priority searches have a headroom beyond the limit
+    for(size_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(controller.try_admit(true));
+    }
+
+    ASSERT_FALSE(controller.try_admit(true));
+    ASSERT_EQ(8, controller.get_in_flight());
+    ASSERT_LE(1, controller.get_retry_after_s());
+
+    for(size_t i = 0; i < 8; i++) {
+        controller.release(1000);
+    }
+
+    ASSERT_EQ(0, controller.get_in_flight());
+    ASSERT_TRUE(controller.try_admit(false));
+    controller.release(1000);
+}
+
+TEST_F(AdmissionControllerTest, LimitAdaptsToLatency) {
+    auto& controller = AdmissionController::get_instance();
+
+    // steady latency: limit grows up to the maximum
+    for(size_t i = 0; i < 200; i++) {
+        ASSERT_TRUE(controller.try_admit(false));
+        controller.release(1000);
+    }
+
+    ASSERT_EQ(64, controller.get_limit());
+
+    // searches are queueing up: limit shrinks down to the minimum
+    for(size_t i = 0; i < 200; i++) {
+        ASSERT_TRUE(controller.try_admit(false));
+        controller.release(10 * 1000);
+    }
+
+    ASSERT_EQ(4, controller.get_limit());
+
+    // latency recovers
+    for(size_t i = 0; i < 200; i++) {
+        ASSERT_TRUE(controller.try_admit(false));
+        controller.release(1000);
+    }
+
+    ASSERT_EQ(64, controller.get_limit());
+}
+
+TEST_F(AdmissionControllerTest, DegradationLevel) {
+    // disabled
+    ASSERT_EQ(0, AdmissionController::get_degradation_level(100, 0, 0, 1000));
+
+    // levels are spread evenly from the threshold to 100%
+    ASSERT_EQ(0, AdmissionController::get_degradation_level(59, 60, 0, 1000));
+    ASSERT_EQ(1, AdmissionController::get_degradation_level(60, 60, 0, 1000));
+    ASSERT_EQ(2, AdmissionController::get_degradation_level(70, 60, 0, 1000));
+    ASSERT_EQ(3, AdmissionController::get_degradation_level(80, 60, 0, 1000));
+    ASSERT_EQ(4, AdmissionController::get_degradation_level(90, 60, 0, 1000));
+    ASSERT_EQ(4, AdmissionController::get_degradation_level(150, 60, 0, 1000));
+    ASSERT_EQ(4, AdmissionController::get_degradation_level(100, 100, 0, 1000));
+
+    // a search that has waited for half of its cutoff time takes every step
+    ASSERT_EQ(0, AdmissionController::get_degradation_level(0, 60, 499, 1000));
+    ASSERT_EQ(4, AdmissionController::get_degradation_level(0, 60, 500, 1000));
+
+    auto& controller = AdmissionController::get_instance();
+    ASSERT_EQ(0, controller.get_load_percent());
+    ASSERT_TRUE(controller.try_admit(false));
+    ASSERT_TRUE(controller.try_admit(false));
+    ASSERT_EQ(50, controller.get_load_percent());
+    controller.release(1000);
+    controller.release(1000);
+
+    controller.disable();
+    ASSERT_EQ(0, controller.get_load_percent());
+}
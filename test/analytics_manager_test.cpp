@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <string>
 #include <vector>
+#include <thread>
 #include <collection_manager.h>
 #include <analytics_manager.h>
 #include "collection.h"
@@ -107,6 +108,71 @@ TEST_F(AnalyticsManagerTest, AddSuggestion) {
     ASSERT_TRUE(analyticsManager.remove_rule("top_search_queries").ok());
 }
 
+TEST_F(AnalyticsManagerTest, AddSuggestionsConcurrently) {
+    nlohmann::json titles_schema = R"({
+            "name": "titles",
+            "fields": [
+                {"name": "title", "type": "string"}
+            ]
+        })"_json;
+
+    Collection* titles_coll = collectionManager.create_collection(titles_schema).get();
+
+    nlohmann::json suggestions_schema = R"({
+        "name": "top_queries",
+        "fields": [
+          {"name": "q", "type": "string" },
+          {"name": "count", "type": "int32" }
+        ]
+      })"_json;
+
+    Collection* suggestions_coll = collectionManager.create_collection(suggestions_schema).get();
+
+    nlohmann::json analytics_rule = R"({
+        "name": "top_search_queries",
+        "type": "popular_queries",
+        "params": {
+            "limit": 100,
+            "source": {
+                "collections": ["titles"]
+            },
+            "destination": {
+                "collection": "top_queries"
+            }
+        }
+    })"_json;
+
+    auto create_op = analyticsManager.create_rule(analytics_rule, false, true);
+    ASSERT_TRUE(create_op.ok());
+
+    const size_t num_threads = 8;
+    const size_t num_queries = 100;
+    std::vector<std::thread> threads;
+
+    for(size_t i = 0; i < num_threads; i++) {
+        threads.emplace_back([&, i]() {
+            for(size_t j = 0; j < num_queries; j++) {
+                analyticsManager.add_suggestion("titles", "q" + std::to_string(j), "q" + std::to_string(j),
+                                                true, std::to_string(i));
+            }
+        });
+    }
+
+    for(auto& thread: threads) {
+        thread.join();
+    }
+
+    auto popularQueries = analyticsManager.get_popular_queries();
+    auto userPrefixQueries = popularQueries["top_queries"]->get_user_prefix_queries();
+    ASSERT_EQ(num_threads, userPrefixQueries.size());
+
+    for(size_t i = 0; i < num_threads; i++) {
+        ASSERT_EQ(num_queries, userPrefixQueries[std::to_string(i)].size());
+    }
+
+    ASSERT_TRUE(analyticsManager.remove_rule("top_search_queries").ok());
+}
+
 TEST_F(AnalyticsManagerTest, AddSuggestionWithExpandedQuery) {
     nlohmann::json titles_schema = R"({
             "name": "titles",
@@ -43,3 +43,72 @@ TEST_F(AppMetricsTest, StatefulRemoveDocs) {
     ASSERT_EQ(result["rps"]["GET /collections"].get<double>(), 0.2);
     ASSERT_EQ(result["rps"]["GET /operations/vote"].get<double>(), 0.1);
 }
+
+TEST_F(AppMetricsTest, LatencyPercentiles) {
+    for(uint64_t i = 1; i <= 1000; i++) {
+        metrics.record_latency(AppMetrics::SEARCH_LABEL, "coll_latency", i * 1000);
+    }
+
+    metrics.record_latency(AppMetrics::IMPORT_LABEL, "", 5000);
+
+    // percentiles are of the last complete window
+    nlohmann::json result;
+    metrics.get_latency_percentiles(result);
+    ASSERT_EQ(0, result["latency_percentiles_ms"]["collections"]["coll_latency"]["search"]["count"].get<size_t>());
+
+    metrics.window_reset();
+
+    result.clear();
+    metrics.get_latency_percentiles(result);
+
+    const auto& search_percentiles = result["latency_percentiles_ms"]["collections"]["coll_latency"]["search"];
+    ASSERT_EQ(1000, search_percentiles["count"].get<size_t>());
+    ASSERT_NEAR(500, search_percentiles["p50"].get<double>(), 500 / 32.0);
+    ASSERT_NEAR(900, search_percentiles["p90"].get<double>(), 900 / 32.0);
+    ASSERT_NEAR(990, search_percentiles["p99"].get<double>(), 990 / 32.0);
+    ASSERT_NEAR(999, search_percentiles["p999"].get<double>(), 999 / 32.0);
+
+    ASSERT_LE(1000, result["latency_percentiles_ms"]["search"]["count"].get<size_t>());
+    ASSERT_EQ(0, result["latency_percentiles_ms"]["collections"]["coll_latency"].count("import"));
+
+    std::string prometheus_metrics;
+    metrics.get_prometheus_metrics(prometheus_metrics);
+
+    ASSERT_NE(std::string::npos, prometheus_metrics.find("# TYPE typesense_request_latency_seconds histogram"));
+    ASSERT_NE(std::string::npos, prometheus_metrics.find(
+            "typesense_collection_request_latency_seconds_bucket{endpoint=\"search\",collection=\"coll_latency\","
+            "le=\"+Inf\"} 1000\n"));
+    ASSERT_NE(std::string::npos, prometheus_metrics.find(
+            "typesense_collection_request_latency_seconds_count{endpoint=\"search\",collection=\"coll_latency\"} 1000\n"));
+}
+
+TEST_F(AppMetricsTest, WriteQueueMetrics) {
+    nlohmann::json coll_queue_stats = R"({
+        "products": {"queue_depth": 12, "oldest_wait_ms": 2500},
+        "": {"queue_depth": 1, "oldest_wait_ms": 0}
+    })"_json;
+
+    std::string prometheus_metrics;
+    AppMetrics::append_write_queue_metrics(coll_queue_stats, prometheus_metrics);
+
+    ASSERT_NE(std::string::npos, prometheus_metrics.find("# TYPE typesense_write_queue_depth gauge\n"));
+    ASSERT_NE(std::string::npos, prometheus_metrics.find("typesense_write_queue_depth{collection=\"products\"} 12\n"));
+    ASSERT_NE(std::string::npos, prometheus_metrics.find("typesense_write_queue_depth{collection=\"\"} 1\n"));
+    ASSERT_NE(std::string::npos, prometheus_metrics.find(
+            "typesense_write_queue_oldest_wait_seconds{collection=\"products\"} 2.500000\n"));
+}
+
+TEST_F(AppMetricsTest, IndexLockWaitMetrics) {
+    metrics.record_index_lock_wait(true, 2000);
+    metrics.record_index_lock_wait(false, 10);
+
+    std::string prometheus_metrics;
+    metrics.get_prometheus_metrics(prometheus_metrics);
+
+    ASSERT_NE(std::string::npos, prometheus_metrics.find("# TYPE typesense_index_lock_wait_seconds histogram\n"));
+    ASSERT_NE(std::string::npos, prometheus_metrics.find("typesense_index_lock_wait_seconds_count{mode=\"write\"}"));
+    ASSERT_NE(std::string::npos, prometheus_metrics.find("typesense_index_lock_wait_seconds_count{mode=\"read\"}"));
+
+    // lock waits are not reported as the latency of an endpoint
+    ASSERT_EQ(std::string::npos, prometheus_metrics.find("endpoint=\"index_write_lock_wait\""));
+}
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <vector>
 #include "array_utils.h"
 #include "logger.h"
 
@@ -34,6 +35,112 @@ TEST(SortedArrayTest, AndScalar) {
     delete [] arr2;
 }
 
+TEST(SortedArrayTest, AndSimdMatchesAndScalar) {
+    srand(1);
+
+    for(size_t run = 0; run < 500; run++) {
+        // sizes that are not multiples of the vector width exercise the scalar tail
+        const size_t len1 = rand() % 300;
+        const size_t len2 = rand() % 300;
+        const uint32_t gap = 1 + rand() % 4;
+
+        std::vector<uint32_t> arr1, arr2;
+        uint32_t val1 = rand() % 10, val2 = rand() % 10;
+
+        for(size_t i = 0; i < len1; i++) {
+            arr1.push_back(val1);
+            val1 += 1 + rand() % gap;
+        }
+
+        for(size_t i = 0; i < len2; i++) {
+            arr2.push_back(val2);
+            val2 += 1 + rand() % gap;
+        }
+
+        uint32_t* expected = nullptr;
+        size_t expected_size = ArrayUtils::and_scalar(arr1.data(), arr1.size(), arr2.data(), arr2.size(), &expected);
+
+        std::vector<uint32_t> results(std::min(len1, len2));
+        size_t results_size = ArrayUtils::and_simd(arr1.data(), arr1.size(), arr2.data(), arr2.size(), results.data());
+
+        ASSERT_EQ(expected_size, results_size);
+        for(size_t i = 0; i < results_size; i++) {
+            ASSERT_EQ(expected[i], results[i]);
+        }
+
+        delete [] expected;
+    }
+}
+
+// sorted arrays of unique values, of sizes that sometimes differ enough for the galloping routines
+static void random_sorted_arrays(std::vector<uint32_t>& arr1, std::vector<uint32_t>& arr2) {
+    const size_t len1 = (rand() % 4 == 0) ? rand() % 3000 : rand() % 300;
+    const size_t len2 = rand() % 300;
+    const uint32_t gap = 1 + rand() % 4;
+
+    uint32_t val1 = rand() % 10, val2 = rand() % 10;
+
+    for(size_t i = 0; i < len1; i++) {
+        arr1.push_back(val1);
+        val1 += 1 + rand() % gap;
+    }
+
+    for(size_t i = 0; i < len2; i++) {
+        arr2.push_back(val2);
+        val2 += 1 + rand() % gap;
+    }
+
+    if(rand() % 2 == 0) {
+        arr1.swap(arr2);
+    }
+}
+
+TEST(SortedArrayTest, OrSimdMatchesOrScalar) {
+    srand(1);
+
+    for(size_t run = 0; run < 500; run++) {
+        std::vector<uint32_t> arr1, arr2;
+        random_sorted_arrays(arr1, arr2);
+
+        uint32_t* expected = nullptr;
+        size_t expected_size = ArrayUtils::or_scalar(arr1.data(), arr1.size(), arr2.data(), arr2.size(), &expected);
+
+        std::vector<uint32_t> results(arr1.size() + arr2.size());
+        size_t results_size = ArrayUtils::or_simd(arr1.data(), arr1.size(), arr2.data(), arr2.size(), results.data());
+
+        ASSERT_EQ(expected_size, results_size);
+        for(size_t i = 0; i < results_size; i++) {
+            ASSERT_EQ(expected[i], results[i]);
+        }
+
+        delete [] expected;
+    }
+}
+
+TEST(SortedArrayTest, ExcludeSimdMatchesExcludeScalar) {
+    srand(1);
+
+    for(size_t run = 0; run < 500; run++) {
+        std::vector<uint32_t> arr1, arr2;
+        random_sorted_arrays(arr1, arr2);
+
+        uint32_t* expected = nullptr;
+        size_t expected_size = ArrayUtils::exclude_scalar(arr1.data(), arr1.size(), arr2.data(), arr2.size(),
+                                                          &expected);
+
+        std::vector<uint32_t> results(arr1.size());
+        size_t results_size = ArrayUtils::exclude_simd(arr1.data(), arr1.size(), arr2.data(), arr2.size(),
+                                                       results.data());
+
+        ASSERT_EQ(expected_size, results_size);
+        for(size_t i = 0; i < results_size; i++) {
+            ASSERT_EQ(expected[i], results[i]);
+        }
+
+        delete [] expected;
+    }
+}
+
 TEST(SortedArrayTest, OrScalarMergeShouldRemoveDuplicates) {
     const size_t size1 = 9;
     uint32_t *arr1 = new uint32_t[size1];
@@ -214,4 +321,21 @@ TEST(SortedArrayTest, SkipToID) {
     found = ArrayUtils::skip_index_to_id(index, array.data(), array.size(), 30);
     ASSERT_FALSE(found);
     ASSERT_EQ(12, index);
-}
\ No newline at end of file
+}
+
+TEST(SortedArrayTest, BitmapToArray) {
+    std::vector<uint64_t> words = {0x8000000000000001ULL, 0, 0x6ULL};
+
+    uint32_t* results = nullptr;
+    size_t results_size = ArrayUtils::bitmap_to_array(words.data(), words.size(), 100, &results);
+
+    ASSERT_EQ(4, results_size);
+    std::vector<uint32_t> expected = {100, 163, 229, 230};
+    ASSERT_EQ(expected, std::vector<uint32_t>(results, results + results_size));
+    delete[] results;
+
+    words = {0, 0};
+    results_size = ArrayUtils::bitmap_to_array(words.data(), words.size(), 0, &results);
+    ASSERT_EQ(0, results_size);
+    delete[] results;
+}
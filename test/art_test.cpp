@@ -7,6 +7,7 @@
 #include <art.h>
 #include <chrono>
 #include <posting.h>
+#include "filter_result_iterator.h"
 
 #define words_file_path (std::string(ROOT_DIR) + std::string("external/libart/tests/words.txt")).c_str()
 #define uuid_file_path (std::string(ROOT_DIR) + std::string("external/libart/tests/uuid.txt")).c_str()
@@ -1789,4 +1790,228 @@ TEST(ArtTest, test_encode_float_positive_negative) {
 
     res = art_tree_destroy(&t);
     ASSERT_TRUE(res == 0);
-}
\ No newline at end of file
+}
+
+TEST(ArtTest, test_art_reinsert_after_delete_reuses_nodes) {
+    art_tree t;
+    int res = art_tree_init(&t);
+    ASSERT_TRUE(res == 0);
+
+    // keys of every leaf size class, plus ones long enough to be allocated outside of the pool
+    std::vector<std::string> keys;
+    for(size_t i = 0; i < 2000; i++) {
+        keys.push_back(std::to_string(i) + std::string(i % 120, 'a' + (i % 26)));
+    }
+
+    for(size_t round = 0; round < 3; round++) {
+        for(size_t i = 0; i < keys.size(); i++) {
+            art_document document = get_document(i);
+            ASSERT_TRUE(NULL == art_insert(&t, (const unsigned char*)keys[i].c_str(), keys[i].size() + 1, &document));
+        }
+
+        ASSERT_EQ(keys.size(), art_size(&t));
+
+        for(size_t i = 0; i < keys.size(); i++) {
+            art_leaf* l = (art_leaf *) art_search(&t, (const unsigned char*)keys[i].c_str(), keys[i].size() + 1);
+            ASSERT_NE(nullptr, l);
+            ASSERT_EQ(i, posting_t::first_id(l->values));
+        }
+
+        // odd keys stay around for the last round, so that the tree is destroyed with nodes of every type
+        for(size_t i = 0; i < keys.size(); i++) {
+            if(round == 2 && i % 2 == 1) {
+                continue;
+            }
+
+            void* values = art_delete(&t, (const unsigned char*)keys[i].c_str(), keys[i].size() + 1);
+            ASSERT_NE(nullptr, values);
+            posting_t::destroy_list(values);
+        }
+    }
+
+    ASSERT_EQ(keys.size() / 2, art_size(&t));
+
+    res = art_tree_destroy(&t);
+    ASSERT_TRUE(res == 0);
+}
+
+TEST(ArtTest, test_art_bulk_insert_matches_incremental_inserts) {
+    art_tree bulk_t, t;
+    ASSERT_EQ(0, art_tree_init(&bulk_t));
+    ASSERT_EQ(0, art_tree_init(&t));
+
+    std::vector<std::string> words;
+    char buf[512];
+    FILE *f = fopen(words_file_path, "r");
+    while (fgets(buf, sizeof buf, f)) {
+        buf[strlen(buf) - 1] = '\0';
+        words.emplace_back(buf);
+    }
+    fclose(f);
+
+    // first half builds the empty tree bottom-up, second half goes into the existing tree
+    const size_t half = words.size() / 2;
+    for (size_t part = 0; part < 2; part++) {
+        std::vector<std::pair<std::string, std::vector<art_document>>> keys_documents;
+        for (size_t i = part * half; i < (part == 0 ? half : words.size()); i++) {
+            std::vector<art_document> documents = {art_document(i, i, {0}), art_document(i + 1, i, {1})};
+            keys_documents.emplace_back(words[i], documents);
+
+            for (auto& document: documents) {
+                art_insert(&t, (const unsigned char*) words[i].c_str(), words[i].size() + 1, &document);
+            }
+        }
+
+        std::reverse(keys_documents.begin(), keys_documents.end());
+        art_bulk_insert(&bulk_t, keys_documents, words.size());
+    }
+
+    ASSERT_EQ(art_size(&t), art_size(&bulk_t));
+
+    for (size_t i = 0; i < words.size(); i++) {
+        art_leaf* l = (art_leaf *) art_search(&bulk_t, (const unsigned char*) words[i].c_str(), words[i].size() + 1);
+        ASSERT_NE(nullptr, l);
+        ASSERT_EQ(2, posting_t::num_ids(l->values));
+        ASSERT_EQ(i, posting_t::first_id(l->values));
+    }
+
+    for (const char* term: {"implement", "zebra", "aple", "mous"}) {
+        std::vector<art_leaf*> leaves, bulk_leaves;
+        exclude_leaves.clear();
+        art_fuzzy_search(&t, (const unsigned char *) term, strlen(term), 0, 1, 100000, MAX_SCORE, true, false, "",
+                         nullptr, 0, leaves, exclude_leaves);
+        exclude_leaves.clear();
+        art_fuzzy_search(&bulk_t, (const unsigned char *) term, strlen(term), 0, 1, 100000, MAX_SCORE, true, false, "",
+                         nullptr, 0, bulk_leaves, exclude_leaves);
+
+        // node scores depend on the order of insertion, so only the matched keys are compared
+        std::set<std::string> keys, bulk_keys;
+        for (auto leaf: leaves) {
+            keys.emplace((const char*) leaf->key, leaf->key_len);
+        }
+        for (auto leaf: bulk_leaves) {
+            bulk_keys.emplace((const char*) leaf->key, leaf->key_len);
+        }
+
+        ASSERT_FALSE(keys.empty());
+        ASSERT_EQ(keys, bulk_keys);
+    }
+
+    ASSERT_EQ(0, art_tree_destroy(&bulk_t));
+    ASSERT_EQ(0, art_tree_destroy(&t));
+}
+
+TEST(ArtTest, test_art_fuzzy_search_batch_matches_single_searches) {
+    art_tree t;
+    ASSERT_EQ(0, art_tree_init(&t));
+
+    char buf[512];
+    FILE *f = fopen(words_file_path, "r");
+    uint32_t num_words = 0;
+    while (fgets(buf, sizeof buf, f)) {
+        buf[strlen(buf) - 1] = '\0';
+        art_document document = get_document(num_words++);
+        art_insert(&t, (const unsigned char*) buf, strlen(buf) + 1, &document);
+    }
+    fclose(f);
+
+    auto all_ids_iterator = [num_words]() {
+        auto ids = new uint32_t[num_words];
+        for (uint32_t i = 0; i < num_words; i++) {
+            ids[i] = i;
+        }
+        return std::make_unique<filter_result_iterator_t>(ids, num_words);
+    };
+
+    const std::vector<std::pair<std::string, bool>> tokens = {
+        {"implement", false}, {"aple", false}, {"mous", true}, {"zebr", true}, {"x", false}
+    };
+
+    std::vector<art_fuzzy_query_t> queries;
+    for (const auto& token: tokens) {
+        const int token_len = token.second ? token.first.size() : token.first.size() + 1;
+        queries.push_back(art_fuzzy_query_t{(const unsigned char*) token.first.c_str(), token_len, 0, 2,
+                                            token.second});
+    }
+
+    std::vector<std::vector<std::vector<const art_node*>>> nodes;
+    art_fuzzy_search_batch(&t, queries, nodes);
+    ASSERT_EQ(tokens.size(), nodes.size());
+
+    size_t num_leaves = 0;
+
+    for (size_t i = 0; i < queries.size(); i++) {
+        const auto& query = queries[i];
+        ASSERT_EQ(3, nodes[i].size());
+
+        for (int cost = 0; cost <= 2; cost++) {
+            std::vector<art_leaf*> leaves, batch_leaves;
+            std::set<std::string> token_exclude_leaves, batch_exclude_leaves;
+
+            auto filter_it = all_ids_iterator();
+            art_fuzzy_search_i(&t, query.term, query.term_len, cost, cost, 100000, MAX_SCORE, query.prefix,
+                               false, "", filter_it.get(), leaves, token_exclude_leaves);
+
+            auto batch_filter_it = all_ids_iterator();
+            art_fuzzy_search_nodes(&t, nodes[i][cost], query.term, query.term_len, cost, 100000, MAX_SCORE,
+                                   query.prefix, false, "", batch_filter_it.get(), batch_leaves,
+                                   batch_exclude_leaves);
+
+            ASSERT_EQ(leaves, batch_leaves);
+            num_leaves += leaves.size();
+        }
+    }
+
+    ASSERT_GT(num_leaves, 0);
+
+    ASSERT_EQ(0, art_tree_destroy(&t));
+}
+
+TEST(ArtTest, test_art_fuzzy_search_prefix_resumes_from_frontier) {
+    art_tree t;
+    ASSERT_EQ(0, art_tree_init(&t));
+
+    char buf[512];
+    FILE *f = fopen(words_file_path, "r");
+    uint32_t num_words = 0;
+    while (fgets(buf, sizeof buf, f)) {
+        buf[strlen(buf) - 1] = '\0';
+        art_document document = get_document(num_words++);
+        art_insert(&t, (const unsigned char*) buf, strlen(buf) + 1, &document);
+    }
+    fclose(f);
+
+    size_t num_nodes = 0;
+
+    for (const std::string word: {"implementation", "strawberries", "abbreviation", "mouse", "pltinum"}) {
+        for (int cost = 0; cost <= 2; cost++) {
+            art_fuzzy_frontier_t prev_frontier;
+
+            for (size_t len = 1; len <= word.size(); len++) {
+                const std::string term = word.substr(0, len);
+
+                std::vector<std::vector<std::vector<const art_node*>>> nodes;
+                art_fuzzy_search_batch(&t, {art_fuzzy_query_t{(const unsigned char*) term.c_str(), (int) len,
+                                                              cost, cost, true}}, nodes);
+
+                std::vector<const art_node*> resumed_nodes, root_nodes;
+                art_fuzzy_frontier_t frontier, root_frontier;
+                art_fuzzy_search_prefix(&t, (const unsigned char*) term.c_str(), len, cost,
+                                        (len == 1) ? nullptr : &prev_frontier, resumed_nodes, frontier);
+                art_fuzzy_search_prefix(&t, (const unsigned char*) term.c_str(), len, cost, nullptr,
+                                        root_nodes, root_frontier);
+
+                ASSERT_EQ(nodes[0][0], resumed_nodes);
+                ASSERT_EQ(nodes[0][0], root_nodes);
+                ASSERT_EQ(root_frontier.entries.size(), frontier.entries.size());
+
+                num_nodes += resumed_nodes.size();
+                prev_frontier = std::move(frontier);
+            }
+        }
+    }
+
+    ASSERT_GT(num_nodes, 0);
+
+    ASSERT_EQ(0, art_tree_destroy(&t));
+}
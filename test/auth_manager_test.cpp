@@ -272,6 +272,7 @@ TEST_F(AuthManagerTest, GenerationOfAPIAction) {
     route_path rpath_doc_delete = route_path("DELETE", {"collections", ":collection", "documents", ":id"}, nullptr, false, false);
     route_path rpath_override_upsert = route_path("PUT", {"collections", ":collection", "overrides", ":id"}, nullptr, false, false);
     route_path rpath_doc_patch = route_path("PATCH", {"collections", ":collection", "documents", ":id"}, nullptr, false, false);
+    route_path rpath_numeric_updates = route_path("POST", {"collections", ":collection", "documents", "numeric_updates"}, nullptr, false, false);
     route_path rpath_analytics_rules_list = route_path("GET", {"analytics", "rules"}, nullptr, false, false);
     route_path rpath_analytics_rules_get = route_path("GET", {"analytics", "rules", ":id"}, nullptr, false, false);
     route_path rpath_analytics_rules_put = route_path("PUT", {"analytics", "rules", ":id"}, nullptr, false, false);
@@ -289,6 +290,7 @@ TEST_F(AuthManagerTest, GenerationOfAPIAction) {
     ASSERT_STREQ("documents:delete", rpath_doc_delete._get_action().c_str());
     ASSERT_STREQ("overrides:upsert", rpath_override_upsert._get_action().c_str());
     ASSERT_STREQ("documents:update", rpath_doc_patch._get_action().c_str());
+    ASSERT_STREQ("documents:update", rpath_numeric_updates._get_action().c_str());
     ASSERT_STREQ("analytics/rules:list", rpath_analytics_rules_list._get_action().c_str());
     ASSERT_STREQ("analytics/rules:get", rpath_analytics_rules_get._get_action().c_str());
     ASSERT_STREQ("analytics/rules:upsert", rpath_analytics_rules_put._get_action().c_str());
@@ -514,4 +516,34 @@ TEST_F(AuthManagerTest, AutoDeleteKeysOnExpiry) {
     keys = list_op.get();
     ASSERT_EQ(1, keys.size());
     ASSERT_EQ("abcd", keys[0].value);
-}
\ No newline at end of file
+}
+
+TEST_F(AuthManagerTest, VerifiedScopedKeyIsRejectedAfterParentKeyRemoval) {
+    std::map<std::string, std::string> params;
+    std::vector<nlohmann::json> embedded_params(1);
+
+    api_key_t key_search_coll1("KeyVal", "test key", {"documents:search"}, {"coll1"}, FUTURE_TS);
+    auth_manager.create_key(key_search_coll1);
+
+    std::string scoped_key = StringUtils::base64_encode(
+      R"(IvjqWNZ5M5ElcvbMoXj45BxkQrZG4ZKEaNQoRioCx2s=KeyV{"filter_by": "user_id:1080"})"
+    );
+
+    // the second authentication uses the verified key
+    for(size_t i = 0; i < 2; i++) {
+        embedded_params[0] = nlohmann::json::object();
+        ASSERT_TRUE(auth_manager.authenticate("documents:search", {collection_key_t("coll1", scoped_key)}, params,
+                                              embedded_params));
+        ASSERT_EQ("user_id:1080", embedded_params[0]["filter_by"].get<std::string>());
+
+        // scope of the parent key is still enforced
+        ASSERT_FALSE(auth_manager.authenticate("documents:search", {collection_key_t("coll2", scoped_key)}, params,
+                                               embedded_params));
+        ASSERT_FALSE(auth_manager.authenticate("documents:create", {collection_key_t("coll1", scoped_key)}, params,
+                                               embedded_params));
+    }
+
+    ASSERT_TRUE(auth_manager.remove_key(key_search_coll1.id).ok());
+    ASSERT_FALSE(auth_manager.authenticate("documents:search", {collection_key_t("coll1", scoped_key)}, params,
+                                           embedded_params));
+}
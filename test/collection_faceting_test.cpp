@@ -3083,3 +3083,185 @@ TEST_F(CollectionFacetingTest, FacetingWithCoercedString) {
     ASSERT_EQ(3, results["facet_counts"][0]["counts"].size());
     ASSERT_EQ(1, results["facet_counts"][0]["counts"][0]["count"]);
 }
+
+TEST_F(CollectionFacetingTest, FacetStatsOfAllDocumentsFollowWrites) {
+    nlohmann::json schema = R"({
+            "name": "coll1",
+            "fields": [
+                {"name": "points", "type": "int32", "facet": true},
+                {"name": "prices", "type": "float[]", "facet": true}
+            ]
+        })"_json;
+
+    Collection* coll1 = collectionManager.create_collection(schema).get();
+
+    for(size_t i = 0; i < 100; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["points"] = int32_t(i % 10) - 3;
+        // a value repeated in an array counts once
+        doc["prices"] = {i * 0.5, i * 0.5, 100.0};
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    for(size_t i = 0; i < 100; i += 7) {
+        ASSERT_TRUE(coll1->remove(std::to_string(i)).ok());
+    }
+
+    double points_sum = 0, prices_sum = 0;
+    size_t num_docs = 0;
+    for(size_t i = 0; i < 100; i++) {
+        if(i % 7 != 0) {
+            points_sum += int32_t(i % 10) - 3;
+            prices_sum += i * 0.5;
+            num_docs++;
+        }
+    }
+
+    // a value common to all documents is one value of each of them
+    prices_sum += 100.0 * num_docs;
+
+    auto results = coll1->search("*", {}, "", {"points", "prices"}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(num_docs, results["found"].get<size_t>());
+
+    const auto& points_stats = results["facet_counts"][0]["stats"];
+    ASSERT_FLOAT_EQ(-3, points_stats["min"].get<double>());
+    ASSERT_FLOAT_EQ(6, points_stats["max"].get<double>());
+    ASSERT_FLOAT_EQ(points_sum, points_stats["sum"].get<double>());
+    ASSERT_FLOAT_EQ(points_sum / num_docs, points_stats["avg"].get<double>());
+
+    const auto& prices_stats = results["facet_counts"][1]["stats"];
+    ASSERT_FLOAT_EQ(0.5, prices_stats["min"].get<double>());
+    ASSERT_FLOAT_EQ(100, prices_stats["max"].get<double>());
+    ASSERT_FLOAT_EQ(prices_sum, prices_stats["sum"].get<double>());
+    ASSERT_FLOAT_EQ(prices_sum / (num_docs * 2), prices_stats["avg"].get<double>());
+
+    // stats of a result set that does not have every document are computed over it
+    double filtered_points_sum = 0;
+    size_t num_filtered_docs = 0;
+    for(size_t i = 0; i < 100; i++) {
+        if(i % 7 != 0 && int32_t(i % 10) - 3 >= 0) {
+            filtered_points_sum += int32_t(i % 10) - 3;
+            num_filtered_docs++;
+        }
+    }
+
+    results = coll1->search("*", {}, "points:>= 0", {"points", "prices"}, {}, {0}, 10, 1, FREQUENCY,
+                            {false}).get();
+    ASSERT_EQ(num_filtered_docs, results["found"].get<size_t>());
+    ASSERT_FLOAT_EQ(0, results["facet_counts"][0]["stats"]["min"].get<double>());
+    ASSERT_FLOAT_EQ(filtered_points_sum, results["facet_counts"][0]["stats"]["sum"].get<double>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionFacetingTest, LaterPagesReuseFacetCounts) {
+    nlohmann::json schema = R"({
+            "name": "coll1",
+            "fields": [
+                {"name": "title", "type": "string"},
+                {"name": "tags", "type": "string[]", "facet": true},
+                {"name": "points", "type": "int32", "facet": true}
+            ]
+        })"_json;
+
+    Collection* coll1 = collectionManager.create_collection(schema).get();
+
+    for(size_t i = 0; i < 30; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "shoe " + std::to_string(i);
+        doc["tags"] = {"tag" + std::to_string(i % 3), "common"};
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    const auto& facet_result_cache = coll1->_get_index()->_get_facet_result_cache();
+
+    auto page_1 = coll1->search("shoe", {"title"}, "points:< 20", {"tags", "points"}, {}, {0}, 5, 1, FREQUENCY,
+                                {false}).get();
+    ASSERT_EQ(20, page_1["found"].get<size_t>());
+    ASSERT_EQ(1, facet_result_cache.size());
+
+    auto page_2 = coll1->search("shoe", {"title"}, "points:< 20", {"tags", "points"}, {}, {0}, 5, 2, FREQUENCY,
+                                {false}).get();
+    ASSERT_EQ(1, facet_result_cache.size());
+    ASSERT_NE(page_1["hits"][0]["document"]["id"], page_2["hits"][0]["document"]["id"]);
+    ASSERT_EQ(page_1["facet_counts"], page_2["facet_counts"]);
+    ASSERT_EQ(20, page_2["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+    ASSERT_EQ("common", page_2["facet_counts"][0]["counts"][0]["value"].get<std::string>());
+
+    // a write makes the counts stale
+    nlohmann::json doc;
+    doc["id"] = "30";
+    doc["title"] = "shoe 30";
+    doc["tags"] = {"common"};
+    doc["points"] = 1;
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    auto page_3 = coll1->search("shoe", {"title"}, "points:< 20", {"tags", "points"}, {}, {0}, 5, 3, FREQUENCY,
+                                {false}).get();
+    ASSERT_EQ(21, page_3["found"].get<size_t>());
+    ASSERT_EQ(21, page_3["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+
+    // counts of a facet query are not cached
+    auto facet_query_results = coll1->search("shoe", {"title"}, "points:< 20", {"tags"}, {}, {0}, 5, 1, FREQUENCY,
+                                             {false}, 1, spp::sparse_hash_set<std::string>(),
+                                             spp::sparse_hash_set<std::string>(), 10, "tags: comm").get();
+    ASSERT_EQ(1, facet_query_results["facet_counts"][0]["counts"].size());
+    ASSERT_EQ(21, facet_query_results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionFacetingTest, FacetQueryOfValueIndexFollowsWrites) {
+    std::vector<field> fields = {
+            field("brand", field_types::STRING, true),
+    };
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields).get();
+    std::vector<std::string> brands = {"Samsung", "Samsonite", "Sony", "Apple", "Sam's Club"};
+
+    for(size_t i = 0; i < brands.size(); i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["brand"] = brands[i];
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    auto search = [&](const std::string& facet_query) {
+        return coll1->search("*", {},
+                             "", {"brand"}, {}, {0}, 1, 1, FREQUENCY, {true}, 1, spp::sparse_hash_set<std::string>(),
+                             spp::sparse_hash_set<std::string>(), 10, facet_query, 30, 4, "", 20, {}, {}, {}, 0,
+                             "<mark>", "</mark>", {}, 1000, true, false, true, "", false, 6000 * 1000, 4, 7, fallback,
+                             4, {off}, 3, 3, 2, 2, false, "", true, 0, max_score, 100, 0, 4294967295UL, VALUE).get();
+    };
+
+    auto results = search("brand:sams");
+    ASSERT_EQ(2, results["facet_counts"][0]["counts"].size());
+    std::set<std::string> values;
+    for(const auto& count: results["facet_counts"][0]["counts"]) {
+        values.insert(count["value"].get<std::string>());
+    }
+    ASSERT_EQ(std::set<std::string>({"Samsung", "Samsonite"}), values);
+
+    // values added and removed after a facet query are found by the next one
+    nlohmann::json doc;
+    doc["id"] = "5";
+    doc["brand"] = "Samsara";
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    ASSERT_TRUE(coll1->remove("1").ok());
+
+    results = search("brand:sams");
+    values.clear();
+    for(const auto& count: results["facet_counts"][0]["counts"]) {
+        values.insert(count["value"].get<std::string>());
+    }
+    ASSERT_EQ(std::set<std::string>({"Samsung", "Samsara"}), values);
+
+    results = search("brand:club sam");
+    ASSERT_EQ(1, results["facet_counts"][0]["counts"].size());
+    ASSERT_EQ("Sam's Club", results["facet_counts"][0]["counts"][0]["value"]);
+
+    collectionManager.drop_collection("coll1");
+}
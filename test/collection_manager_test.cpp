@@ -261,6 +261,7 @@ TEST_F(CollectionManagerTest, CollectionCreation) {
           "id":0,
           "name":"collection1",
           "num_memory_shards":4,
+          "storage_format":"json",
           "symbols_to_index":[
             "+"
           ],
@@ -934,6 +935,117 @@ TEST_F(CollectionManagerTest, RestoreNestedDocsOnRestart) {
     collectionManager2.drop_collection("coll1");
 }
 
+TEST_F(CollectionManagerTest, RestoreVectorIndexFromImage) {
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+          {"name": "title", "type": "string"},
+          {"name": "vec", "type": "float[]", "num_dim": 4}
+        ]
+    })"_json;
+
+    auto op = collectionManager.create_collection(schema);
+    ASSERT_TRUE(op.ok());
+    Collection* coll1 = op.get();
+
+    std::vector<std::vector<float>> values = {
+        {0.851758, 0.909671, 0.823431, 0.372063},
+        {0.97826, 0.933157, 0.39557, 0.306488},
+        {0.230606, 0.634397, 0.514009, 0.399594}
+    };
+
+    for(size_t i = 0; i < values.size(); i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["vec"] = values[i];
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    std::string image_dir = "/tmp/typesense_test/coll_manager_index_image";
+    system(("rm -rf " + image_dir).c_str());
+
+    ASSERT_TRUE(collectionManager.save_index_images(image_dir).ok());
+    ASSERT_TRUE(file_exists(image_dir + "/" + CollectionManager::INDEX_IMAGE_META_FILE));
+
+    // restore from the store along with the image
+    CollectionManager& collectionManager2 = CollectionManager::get_instance();
+    collectionManager2.init(store, 1.0, "auth_key", quit);
+    collectionManager2.set_index_image_dir(image_dir);
+    auto load_op = collectionManager2.load(8, 1000);
+    collectionManager2.set_index_image_dir("");
+
+    ASSERT_TRUE(load_op.ok());
+
+    auto restored_coll = collectionManager2.get_collection("coll1").get();
+    ASSERT_NE(nullptr, restored_coll);
+    ASSERT_EQ(3, restored_coll->get_num_documents());
+
+    const auto& vector_index = restored_coll->_get_index()->_get_vector_index();
+    ASSERT_EQ(3, vector_index.at("vec")->vecdex->getCurrentElementCount());
+
+    auto results = restored_coll->search("*", {}, "", {}, {}, {0}, 10, 1, FREQUENCY, {true},
+                                         Index::DROP_TOKENS_THRESHOLD, spp::sparse_hash_set<std::string>(),
+                                         spp::sparse_hash_set<std::string>(), 10, "", 30, 5,
+                                         "", 10, {}, {}, {}, 0,
+                                         "<mark>", "</mark>", {}, 1000, true, false, true, "", false, 6000 * 1000,
+                                         4, 7, fallback, 4, {off}, 32767, 32767, 2, false, true,
+                                         "vec:([0.96826, 0.94, 0.39557, 0.306488], flat_search_cutoff: 0)").get();
+
+    ASSERT_EQ(3, results["found"].get<size_t>());
+    ASSERT_EQ("1", results["hits"][0]["document"]["id"].get<std::string>());
+
+    // points indexed after the restore must go into the restored graph
+    nlohmann::json doc;
+    doc["id"] = "3";
+    doc["title"] = "Title 3";
+    doc["vec"] = std::vector<float>{0.1, 0.2, 0.3, 0.4};
+    ASSERT_TRUE(restored_coll->add(doc.dump()).ok());
+    ASSERT_EQ(4, vector_index.at("vec")->vecdex->getCurrentElementCount());
+
+    collectionManager.drop_collection("coll1");
+    collectionManager2.drop_collection("coll1");
+}
+
+TEST_F(CollectionManagerTest, WriteGenerationAdvancesOnWrites) {
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+          {"name": "title", "type": "string"}
+        ]
+    })"_json;
+
+    auto op = collectionManager.create_collection(schema);
+    ASSERT_TRUE(op.ok());
+    Collection* coll1 = op.get();
+
+    uint64_t generation = collectionManager.get_collection_write_generation("coll1");
+    ASSERT_NE(0, generation);
+    ASSERT_EQ(0, collectionManager.get_collection_write_generation("unknown"));
+
+    nlohmann::json doc;
+    doc["id"] = "0";
+    doc["title"] = "Title 0";
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    ASSERT_LT(generation, collectionManager.get_collection_write_generation("coll1"));
+    generation = collectionManager.get_collection_write_generation("coll1");
+
+    // reads do not change the generation
+    ASSERT_TRUE(coll1->search("title", {"title"}, "", {}, {}, {0}).ok());
+    ASSERT_EQ(generation, collectionManager.get_collection_write_generation("coll1"));
+
+    ASSERT_TRUE(coll1->remove("0").ok());
+    ASSERT_LT(generation, collectionManager.get_collection_write_generation("coll1"));
+    generation = collectionManager.get_collection_write_generation("coll1");
+
+    // a re-created collection never repeats an older generation
+    collectionManager.drop_collection("coll1");
+    ASSERT_EQ(0, collectionManager.get_collection_write_generation("coll1"));
+    ASSERT_TRUE(collectionManager.create_collection(schema).ok());
+    ASSERT_LT(generation, collectionManager.get_collection_write_generation("coll1"));
+}
+
 TEST_F(CollectionManagerTest, RestoreCoercedDocValuesOnRestart) {
     nlohmann::json schema = R"({
         "name": "coll1",
@@ -983,6 +1095,124 @@ TEST_F(CollectionManagerTest, RestoreCoercedDocValuesOnRestart) {
     collectionManager2.drop_collection("coll1");
 }
 
+TEST_F(CollectionManagerTest, MsgpackStorageFormat) {
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "storage_format": "msgpack",
+        "fields": [
+          {"name": "title", "type": "string" },
+          {"name": "points", "type": "int32" }
+        ]
+    })"_json;
+
+    auto op = collectionManager.create_collection(schema);
+    ASSERT_TRUE(op.ok());
+    Collection* coll1 = op.get();
+    ASSERT_EQ("msgpack", coll1->get_summary_json()["storage_format"].get<std::string>());
+
+    auto doc1 = R"({"id": "0", "title": "The Godfather", "points": 100})"_json;
+    auto doc2 = R"({"id": "1", "title": "The Shawshank Redemption", "points": 200})"_json;
+
+    ASSERT_TRUE(coll1->add(doc1.dump()).ok());
+    ASSERT_TRUE(coll1->add(doc2.dump()).ok());
+
+    const std::string seq_id_key_0 = coll1->get_seq_id_collection_prefix() + "_" + StringUtils::serialize_uint32_t(0);
+    std::string stored_doc;
+    ASSERT_EQ(StoreStatus::FOUND, store->get(seq_id_key_0, stored_doc));
+    ASSERT_EQ(Collection::STORED_DOC_MSGPACK_MARKER, stored_doc[0]);
+    ASSERT_EQ(doc1, Collection::parse_stored_document(stored_doc));
+
+    // a document written as JSON, before the format of the collection was switched, must remain readable
+    ASSERT_TRUE(store->insert(seq_id_key_0, doc1.dump()));
+    ASSERT_EQ(doc1, coll1->get("0").get());
+    ASSERT_EQ(doc2, coll1->get("1").get());
+
+    // create a new collection manager to ensure that it restores both kinds of records from the store
+    CollectionManager& collectionManager2 = CollectionManager::get_instance();
+    collectionManager2.init(store, 1.0, "auth_key", quit);
+    auto load_op = collectionManager2.load(8, 1000);
+    ASSERT_TRUE(load_op.ok());
+
+    auto restored_coll = collectionManager2.get_collection("coll1").get();
+    ASSERT_NE(nullptr, restored_coll);
+    ASSERT_EQ("msgpack", restored_coll->get_storage_format());
+
+    auto res_op = restored_coll->search("the", {"title"}, "", {}, {}, {0}, 10, 1, token_ordering::FREQUENCY, {true});
+    ASSERT_TRUE(res_op.ok());
+    ASSERT_EQ(2, res_op.get()["found"].get<size_t>());
+    ASSERT_EQ("The Shawshank Redemption", res_op.get()["hits"][0]["document"]["title"].get<std::string>());
+    ASSERT_EQ("The Godfather", res_op.get()["hits"][1]["document"]["title"].get<std::string>());
+
+    collectionManager2.drop_collection("coll1");
+
+    schema["storage_format"] = "bson";
+    op = collectionManager.create_collection(schema);
+    ASSERT_FALSE(op.ok());
+    ASSERT_EQ("`storage_format` should be either `json` or `msgpack`.", op.error());
+}
+
+TEST_F(CollectionManagerTest, ProjectedDocumentFetch) {
+    auto doc = R"({
+        "id": "0",
+        "title": "The Godfather",
+        "vec": [0.1, 0.2, [0.3]],
+        "person": {"name": "Vito", "address": {"city": "Corleone"}},
+        "points": 100
+    })"_json;
+
+    doc_projection_t projection;
+    projection.include_names.insert("id");
+    projection.include_names.insert("person.name");
+
+    std::string msgpack_doc(1, Collection::STORED_DOC_MSGPACK_MARKER);
+    nlohmann::json::to_msgpack(doc, msgpack_doc);
+
+    for(const std::string& stored_doc: {doc.dump(), msgpack_doc}) {
+        auto projected_doc = Collection::parse_stored_document(stored_doc, &projection);
+        ASSERT_EQ(2, projected_doc.size());
+        ASSERT_EQ("0", projected_doc["id"].get<std::string>());
+        ASSERT_EQ(doc["person"], projected_doc["person"]);
+    }
+
+    projection = doc_projection_t();
+    projection.exclude_names.insert("vec");
+
+    auto projected_doc = Collection::parse_stored_document(doc.dump(), &projection);
+    doc.erase("vec");
+    ASSERT_EQ(doc, projected_doc);
+
+    ASSERT_THROW(Collection::parse_stored_document("{\"id\": ", &projection), nlohmann::json::parse_error);
+
+    // projected search hits match the pruned documents
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+          {"name": "title", "type": "string" },
+          {"name": "points", "type": "int32" }
+        ]
+    })"_json;
+
+    auto op = collectionManager.create_collection(schema);
+    ASSERT_TRUE(op.ok());
+    Collection* coll1 = op.get();
+    ASSERT_TRUE(coll1->add(R"({"id": "0", "title": "The Godfather", "points": 100})").ok());
+
+    auto res_op = coll1->search("godfather", {"title"}, "", {}, {}, {0}, 10, 1, token_ordering::FREQUENCY, {true},
+                                Index::DROP_TOKENS_THRESHOLD, {"points"});
+    ASSERT_TRUE(res_op.ok());
+    auto res = res_op.get();
+    ASSERT_EQ(1, res["hits"].size());
+    ASSERT_EQ(R"({"id":"0","points":100})", res["hits"][0]["document"].dump());
+
+    res_op = coll1->search("godfather", {"title"}, "", {}, {}, {0}, 10, 1, token_ordering::FREQUENCY, {true},
+                           Index::DROP_TOKENS_THRESHOLD, {}, {"title"});
+    ASSERT_TRUE(res_op.ok());
+    res = res_op.get();
+    ASSERT_EQ(R"({"id":"0","points":100})", res["hits"][0]["document"].dump());
+
+    collectionManager.drop_collection("coll1");
+}
+
 TEST_F(CollectionManagerTest, DropCollectionCleanly) {
     std::ifstream infile(std::string(ROOT_DIR)+"test/multi_field_documents.jsonl");
     std::string json_line;
@@ -1184,6 +1414,12 @@ TEST_F(CollectionManagerTest, LoadMultipleCollections) {
 
     ASSERT_EQ(100, cmanager.get_collections().get().size());
 
+    // load states are kept only while the collections are loading
+    ASSERT_FALSE(cmanager.is_loading_collections());
+    ASSERT_TRUE(cmanager.get_collection_load_states().empty());
+    ASSERT_TRUE(cmanager.is_collection_loaded("collection42"));
+    ASSERT_FALSE(cmanager.is_collection_loaded("collection100"));
+
     for(size_t i = 0; i < 100; i++) {
         collectionManager.drop_collection("collection" + std::to_string(i));
     }
@@ -1420,6 +1656,174 @@ TEST_F(CollectionManagerTest, CloneCollection) {
     ASSERT_EQ('?', coll2->get_token_separators().at(1));
 }
 
+TEST_F(CollectionManagerTest, CloneCollectionWithDocuments) {
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+            {"name": "title", "type": "string"},
+            {"name": "points", "type": "int32"}
+        ]
+    })"_json;
+
+    auto create_op = collectionManager.create_collection(schema);
+    ASSERT_TRUE(create_op.ok());
+    auto coll1 = create_op.get();
+
+    for(size_t i = 0; i < 5; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    ASSERT_TRUE(coll1->remove("2").ok());
+
+    nlohmann::json req = R"({"name": "coll2", "copy_documents": "yes"})"_json;
+    auto clone_op = collectionManager.clone_collection("coll1", req);
+    ASSERT_FALSE(clone_op.ok());
+    ASSERT_EQ("The `copy_documents` value must be a boolean.", clone_op.error());
+
+    req = R"({"name": "coll2", "copy_documents": true})"_json;
+    clone_op = collectionManager.clone_collection("coll1", req);
+    ASSERT_TRUE(clone_op.ok());
+
+    auto coll2 = clone_op.get();
+    ASSERT_EQ(4, coll2->get_num_documents());
+    ASSERT_EQ("Title 3", coll2->get("3").get()["title"].get<std::string>());
+    ASSERT_EQ(404, coll2->get("2").code());
+
+    auto res = coll2->search("title", {"title"}, "points:>1", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(2, res["found"].get<size_t>());
+
+    // the clone diverges from its source
+    nlohmann::json doc;
+    doc["id"] = "5";
+    doc["title"] = "Title 5";
+    doc["points"] = 5;
+    ASSERT_TRUE(coll2->add(doc.dump()).ok());
+    ASSERT_TRUE(coll2->remove("0").ok());
+
+    ASSERT_EQ(4, coll2->get_num_documents());
+    ASSERT_EQ(4, coll1->get_num_documents());
+    ASSERT_EQ("Title 0", coll1->get("0").get()["title"].get<std::string>());
+    ASSERT_EQ(404, coll1->get("5").code());
+}
+
+TEST_F(CollectionManagerTest, DropCollectionInBackground) {
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+            {"name": "title", "type": "string", "infix": true},
+            {"name": "tags", "type": "string[]", "facet": true, "sort": true},
+            {"name": "points", "type": "int32"},
+            {"name": "rating", "type": "float", "range_index": true},
+            {"name": "location", "type": "geopoint"}
+        ]
+    })"_json;
+
+    for(size_t round = 0; round < 2; round++) {
+        auto create_op = collectionManager.create_collection(schema);
+        ASSERT_TRUE(create_op.ok());
+        auto coll1 = create_op.get();
+
+        for(size_t i = 0; i < 10; i++) {
+            nlohmann::json doc;
+            doc["title"] = "Title " + std::to_string(i);
+            doc["tags"] = {"tag" + std::to_string(i % 3)};
+            doc["points"] = i;
+            doc["rating"] = i * 0.5;
+            doc["location"] = {48.85, 2.35};
+            ASSERT_TRUE(coll1->add(doc.dump()).ok());
+        }
+
+        auto res = coll1->search("title", {"title"}, "", {"tags"}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+        ASSERT_EQ(10, res["found"].get<size_t>());
+
+        ASSERT_TRUE(collectionManager.drop_collection("coll1").ok());
+        ASSERT_TRUE(collectionManager.get_collection("coll1") == nullptr);
+    }
+
+    collectionManager.wait_for_drops();
+
+    // only the collection of the fixture is left
+    ASSERT_EQ(1, collectionManager.get_collections().get().size());
+}
+
+TEST_F(CollectionManagerTest, EvictIdleCollections) {
+    // to prevent fixture tear down from running as we are fudging with CollectionManager singleton
+    collectionManager.dispose();
+    delete store;
+    store = nullptr;
+
+    std::string state_dir_path = "/tmp/typesense_test/cmanager_eviction_test_db";
+    system(("rm -rf "+state_dir_path+" && mkdir -p "+state_dir_path).c_str());
+    Store *new_store = new Store(state_dir_path);
+    collectionManager.init(new_store, 1.0, "auth_key", quit);
+    collectionManager.load(8, 1000);
+
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+            {"name": "title", "type": "string"},
+            {"name": "points", "type": "int32"}
+        ]
+    })"_json;
+
+    auto coll1 = collectionManager.create_collection(schema).get();
+    for(size_t i = 0; i < 5; i++) {
+        nlohmann::json doc;
+        doc["title"] = "Title " + std::to_string(i);
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    ASSERT_TRUE(collectionManager.upsert_symlink("alias1", "coll1").ok());
+
+    // only collections that were loaded from the store, and so have a known load time, are evicted
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    ASSERT_EQ(0, collectionManager.evict_idle_collections(1, 1000));
+
+    collectionManager.dispose();
+    delete new_store;
+
+    new_store = new Store(state_dir_path);
+    collectionManager.init(new_store, 1.0, "auth_key", quit);
+    collectionManager.load(8, 1000);
+
+    ASSERT_EQ(0, collectionManager.evict_idle_collections(10, 1000));
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    ASSERT_EQ(1, collectionManager.evict_idle_collections(1, 1000));
+
+    ASSERT_TRUE(collectionManager.is_collection_evicted("coll1"));
+    ASSERT_TRUE(collectionManager.is_collection_loaded("coll1"));
+    ASSERT_TRUE(collectionManager.get_collection_names().empty());
+
+    auto summaries = collectionManager.get_collection_summaries().get();
+    ASSERT_EQ(1, summaries.size());
+    ASSERT_EQ("coll1", summaries[0]["name"].get<std::string>());
+    ASSERT_EQ(5, summaries[0]["num_documents"].get<size_t>());
+
+    // the first lookup, through the alias, loads the collection again
+    auto coll = collectionManager.get_collection("alias1");
+    ASSERT_NE(nullptr, coll.get());
+    ASSERT_FALSE(collectionManager.is_collection_evicted("coll1"));
+
+    auto res = coll->search("*", {"title"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(5, res["found"].get<size_t>());
+    coll.unlock();
+
+    // an evicted collection is dropped like any other
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    ASSERT_EQ(1, collectionManager.evict_idle_collections(1, 1000));
+    ASSERT_TRUE(collectionManager.drop_collection("coll1").ok());
+    ASSERT_FALSE(collectionManager.is_collection_evicted("coll1"));
+    ASSERT_EQ(nullptr, collectionManager.get_collection("coll1").get());
+
+    collectionManager.dispose();
+    delete new_store;
+}
+
 TEST_F(CollectionManagerTest, GetReferenceCollectionNames) {
     std::string filter_query = "";
     CollectionManager::ref_include_collection_names_t* ref_includes = nullptr;
@@ -1907,6 +2311,7 @@ TEST_F(CollectionManagerTest, CollectionCreationWithMetadata) {
             },
             "name":"collection_meta",
             "num_memory_shards":4,
+            "storage_format":"json",
             "symbols_to_index":[],
             "token_separators":[]
     })"_json;
@@ -2030,4 +2435,110 @@ TEST_F(CollectionManagerTest, CollectionPagination) {
     collection_op = collectionManager.get_collections(limit, offset);
     ASSERT_FALSE(collection_op.ok());
     ASSERT_EQ("Invalid offset param.", collection_op.error());
-}
\ No newline at end of file
+}
+
+TEST_F(CollectionManagerTest, SearchProfile) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("tags", field_types::STRING_ARRAY, true),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 10; i++) {
+        nlohmann::json doc;
+        doc["title"] = "The Adventures of Tom Sawyer " + std::to_string(i);
+        doc["tags"] = {(i % 2 == 0) ? "gold" : "silver"};
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    std::map<std::string, std::string> req_params;
+    req_params["collection"] = "coll1";
+    req_params["q"] = "sawyr";
+    req_params["query_by"] = "title";
+    req_params["filter_by"] = "points: > 2 && tags: gold";
+    req_params["facet_by"] = "tags";
+
+    nlohmann::json embedded_params;
+    std::string json_res;
+    auto now_ts = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // not profiled by default
+    auto search_op = collectionManager.do_search(req_params, embedded_params, json_res, now_ts);
+    ASSERT_TRUE(search_op.ok());
+    nlohmann::json res_obj = nlohmann::json::parse(json_res);
+    ASSERT_EQ(3, res_obj["found"].get<size_t>());
+    ASSERT_EQ(0, res_obj.count("profile"));
+
+    req_params["profile"] = "true";
+    search_op = collectionManager.do_search(req_params, embedded_params, json_res, now_ts);
+    ASSERT_TRUE(search_op.ok());
+    res_obj = nlohmann::json::parse(json_res);
+    ASSERT_EQ(3, res_obj["found"].get<size_t>());
+    ASSERT_EQ(1, res_obj.count("profile"));
+
+    const auto& profile = res_obj["profile"];
+    for(const auto& phase: {"parse", "filter", "matching", "facets", "hits", "highlight", "facet_counts",
+                            "serialization"}) {
+        ASSERT_EQ(1, profile["phases_us"].count(phase)) << phase;
+    }
+
+    // the query token has a typo
+    ASSERT_EQ(1, profile["typo_candidates"].count("1"));
+    ASSERT_LT(0, profile["typo_candidates"]["1"].get<size_t>());
+    ASSERT_LT(0, profile["posting_blocks_decompressed"].get<size_t>());
+
+    ASSERT_EQ("AND", profile["filter_plan"]["operator"]);
+    ASSERT_EQ("lazy", profile["filter_plan"]["strategy"]);
+    ASSERT_EQ(2, profile["filter_plan"]["children"].size());
+
+    ASSERT_EQ(1, profile["facet_strategies"].count("tags"));
+    ASSERT_EQ(1, profile["facet_strategy_bases"].count("tags"));
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionManagerTest, SearchResultsAsJsonObject) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 5; i++) {
+        nlohmann::json doc;
+        doc["title"] = "The Adventures of Tom Sawyer " + std::to_string(i);
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    std::map<std::string, std::string> req_params = {
+        {"collection", "coll1"},
+        {"q", "sawyer"},
+        {"query_by", "title"},
+        {"exclude_fields", "search_time_ms"},
+    };
+
+    nlohmann::json embedded_params;
+    auto now_ts = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    nlohmann::json res_obj;
+    auto search_op = collectionManager.do_search(req_params, embedded_params, res_obj, now_ts);
+    ASSERT_TRUE(search_op.ok());
+    ASSERT_EQ(5, res_obj["found"].get<size_t>());
+    ASSERT_EQ("4", res_obj["hits"][0]["document"]["id"]);
+
+    // same results as the serialized ones
+    std::string json_res;
+    search_op = collectionManager.do_search(req_params, embedded_params, json_res, now_ts);
+    ASSERT_TRUE(search_op.ok());
+    ASSERT_EQ(nlohmann::json::parse(json_res), res_obj);
+
+    req_params["collection"] = "unknown";
+    search_op = collectionManager.do_search(req_params, embedded_params, res_obj, now_ts);
+    ASSERT_FALSE(search_op.ok());
+    ASSERT_EQ(404, search_op.code());
+
+    collectionManager.drop_collection("coll1");
+}
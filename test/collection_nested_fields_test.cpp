@@ -327,6 +327,34 @@ TEST_F(CollectionNestedFieldsTest, FlattenStoredDoc) {
     ASSERT_EQ(1, stored_doc.count("details.year"));
 }
 
+TEST_F(CollectionNestedFieldsTest, FlattenArrayOfObjectsWithMixedTypes) {
+    auto doc = R"({
+        "details": [{"name": "foo", "year": 2000}, {"name": "bar", "year": 2001.5}, {"name": "baz", "year": 2002}]
+    })"_json;
+
+    std::vector<field> nested_fields = {
+        field("details", field_types::OBJECT_ARRAY, false)
+    };
+
+    std::vector<field> flattened_fields;
+    auto flatten_op = field::flatten_doc(doc, get_nested_map(nested_fields), {}, false, flattened_fields);
+    ASSERT_TRUE(flatten_op.ok());
+
+    ASSERT_EQ(3, doc["details.name"].size());
+    ASSERT_EQ(3, doc["details.year"].size());
+    ASSERT_EQ(2, flattened_fields.size());
+
+    // the definition of the field follows the type of the last element, which is detected again as it changes
+    for(const auto& flattened_field: flattened_fields) {
+        if(flattened_field.name == "details.year") {
+            ASSERT_EQ(field_types::INT64_ARRAY, flattened_field.type);
+        } else {
+            ASSERT_EQ(field_types::STRING_ARRAY, flattened_field.type);
+        }
+        ASSERT_TRUE(flattened_field.nested_array);
+    }
+}
+
 TEST_F(CollectionNestedFieldsTest, CompactNestedFields) {
     auto stored_doc = R"({
       "company_name": "Acme Corp",
@@ -2894,3 +2894,85 @@ TEST_F(CollectionOptimizedFacetingTest, RangeFacetRangeLabelWithSpace) {
     ASSERT_EQ(1, (int) results["facet_counts"][0]["counts"][0]["count"]);
     ASSERT_EQ("small tvs with display size", results["facet_counts"][0]["counts"][0]["value"]);
 }
+
+TEST_F(CollectionOptimizedFacetingTest, ApproximateFacetCounts) {
+    nlohmann::json schema = R"({
+            "name": "coll1",
+            "fields": [
+                {"name": "color", "type": "string", "facet": true},
+                {"name": "points", "type": "int32"}
+            ]
+        })"_json;
+
+    Collection* coll1 = collectionManager.create_collection(schema).get();
+
+    std::mt19937 gen(137723);
+    std::uniform_int_distribution<> distr(1, 100);
+
+    std::map<std::string, size_t> expected_counts;
+
+    for(size_t i = 0; i < 3000; i++) {
+        nlohmann::json doc;
+        auto n = distr(gen);
+        doc["color"] = (n <= 60) ? "red" : (n <= 95) ? "blue" : "green";
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+        if(i < 1500 && i % 10 != 1) {
+            expected_counts[doc["color"].get<std::string>()]++;
+        }
+    }
+
+    // remove some of the documents, sampled ones included
+    for(size_t i = 1; i < 3000; i += 10) {
+        ASSERT_TRUE(coll1->remove(std::to_string(i)).ok());
+    }
+
+    std::map<std::string, std::string> req_params;
+    req_params["collection"] = "coll1";
+    req_params["q"] = "*";
+    req_params["filter_by"] = "points: < 1500";
+    req_params["facet_by"] = "color";
+    req_params["approximate_facets"] = "true";
+
+    nlohmann::json embedded_params;
+    std::string json_res;
+    auto now_ts = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    auto search_op = collectionManager.do_search(req_params, embedded_params, json_res, now_ts);
+    ASSERT_TRUE(search_op.ok());
+    auto res = nlohmann::json::parse(json_res);
+
+    ASSERT_EQ(1350, res["found"].get<size_t>());
+    ASSERT_EQ(1, res["facet_counts"].size());
+    ASSERT_TRUE(res["facet_counts"][0]["approximate"].get<bool>());
+    ASSERT_EQ(3, res["facet_counts"][0]["counts"].size());
+
+    for(const auto& count: res["facet_counts"][0]["counts"]) {
+        const auto& value = count["value"].get<std::string>();
+        const auto estimate = count["count"].get<int64_t>();
+        const auto error = count["count_error"].get<int64_t>();
+        // the bound is of a 95% confidence interval, so allow for an unlucky sample
+        ASSERT_LE(std::abs(estimate - int64_t(expected_counts[value])), 2 * error) << value;
+
+        if(value == "green") {
+            // too few documents to be sampled, so counted exactly
+            ASSERT_EQ(0, error);
+        } else {
+            ASSERT_LT(0, error);
+        }
+    }
+
+    // exact counts without the parameter
+    req_params.erase("approximate_facets");
+    search_op = collectionManager.do_search(req_params, embedded_params, json_res, now_ts);
+    ASSERT_TRUE(search_op.ok());
+    res = nlohmann::json::parse(json_res);
+
+    ASSERT_EQ(0, res["facet_counts"][0].count("approximate"));
+    for(const auto& count: res["facet_counts"][0]["counts"]) {
+        ASSERT_EQ(expected_counts[count["value"].get<std::string>()], count["count"].get<size_t>());
+        ASSERT_EQ(0, count.count("count_error"));
+    }
+}
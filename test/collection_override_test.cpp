@@ -4223,3 +4223,56 @@ TEST_F(CollectionOverrideTest, RetrieveOverideByID) {
     auto op = coll2->get_override("override1");
     ASSERT_TRUE(op.ok());
 }
+
+TEST_F(CollectionOverrideTest, OnlyOverridesMatchingQueryAreApplied) {
+    for(size_t i = 0; i < 100; i++) {
+        nlohmann::json override_json = {
+            {"id", "exact-" + std::to_string(i)},
+            {"rule", {{"query", "term" + std::to_string(i)}, {"match", override_t::MATCH_EXACT}}},
+            {"includes", {{{"id", "1"}, {"position", 1}}}}
+        };
+
+        override_t override;
+        ASSERT_TRUE(override_t::parse(override_json, "", override).ok());
+        coll_mul_fields->add_override(override);
+    }
+
+    nlohmann::json override_json = {
+        {"id", "pin-0"},
+        {"rule", {{"query", "will"}, {"match", override_t::MATCH_EXACT}}},
+        {"includes", {{{"id", "0"}, {"position", 1}}}}
+    };
+
+    override_t override;
+    ASSERT_TRUE(override_t::parse(override_json, "", override).ok());
+    coll_mul_fields->add_override(override);
+
+    auto results = coll_mul_fields->search("will", {"title"}, "", {}, {}, {0}, 10).get();
+    ASSERT_EQ("0", results["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_TRUE(results["hits"][0]["curated"].get<bool>());
+
+    // an upserted override matches on its new rule only
+    override_json["rule"]["query"] = "smith";
+    override_json["rule"]["match"] = override_t::MATCH_CONTAINS;
+    ASSERT_TRUE(override_t::parse(override_json, "", override).ok());
+    coll_mul_fields->add_override(override);
+
+    results = coll_mul_fields->search("will", {"title"}, "", {}, {}, {0}, 10).get();
+    for(const auto& hit: results["hits"]) {
+        ASSERT_EQ(0, hit.count("curated"));
+    }
+
+    results = coll_mul_fields->search("will smith", {"title"}, "", {}, {}, {0}, 10).get();
+    ASSERT_EQ("0", results["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_TRUE(results["hits"][0]["curated"].get<bool>());
+
+    results = coll_mul_fields->search("term42", {"title"}, "", {}, {}, {0}, 10).get();
+    ASSERT_EQ(1, results["hits"].size());
+    ASSERT_EQ("1", results["hits"][0]["document"]["id"].get<std::string>());
+
+    coll_mul_fields->remove_override("pin-0");
+    results = coll_mul_fields->search("will smith", {"title"}, "", {}, {}, {0}, 10).get();
+    for(const auto& hit: results["hits"]) {
+        ASSERT_EQ(0, hit.count("curated"));
+    }
+}
@@ -256,6 +256,67 @@ TEST_F(CollectionSchemaChangeTest, AddNewFieldsToCollection) {
     collectionManager.drop_collection("coll1");
 }
 
+TEST_F(CollectionSchemaChangeTest, AddNewFieldsInBackground) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 10; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["category"] = (i % 2 == 0) ? "even" : "odd";
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    auto schema_changes = R"({
+        "fields": [
+            {"name": "category", "type": "string", "facet": true}
+        ]
+    })"_json;
+
+    std::atomic<bool> done = false;
+    auto alter_op = coll1->alter_in_background(schema_changes, 0, [&done]() { done = true; });
+    ASSERT_TRUE(alter_op.ok());
+
+    // a document written during the backfill is indexed on the new field too
+    nlohmann::json doc;
+    doc["id"] = "10";
+    doc["title"] = "Title 10";
+    doc["category"] = "even";
+    doc["points"] = 10;
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    while(!done) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    ASSERT_TRUE(coll1->get_alter_status().is_null());
+    ASSERT_EQ(0, coll1->get_summary_json().count("alter_backfill"));
+
+    auto results = coll1->search("*", {}, "category:even", {"category"}, sort_fields, {0}, 20, 1, FREQUENCY,
+                                 {true}).get();
+    ASSERT_EQ(6, results["found"].get<size_t>());
+    ASSERT_EQ(1, results["facet_counts"][0]["counts"].size());
+    ASSERT_EQ(6, results["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+
+    // only additions can be altered in the background
+    schema_changes = R"({
+        "fields": [
+            {"name": "category", "drop": true}
+        ]
+    })"_json;
+
+    alter_op = coll1->alter_in_background(schema_changes, 0, nullptr);
+    ASSERT_FALSE(alter_op.ok());
+    ASSERT_EQ(400, alter_op.code());
+    ASSERT_EQ("Only the addition of fields can be altered in the background.", alter_op.error());
+
+    collectionManager.drop_collection("coll1");
+}
+
 TEST_F(CollectionSchemaChangeTest, DropFieldsFromCollection) {
     std::vector<field> fields = {field(".*", field_types::AUTO, false),
                                  field("title", field_types::STRING, false, false, true, "", 1, 1),
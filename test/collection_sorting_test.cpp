@@ -976,6 +976,57 @@ TEST_F(CollectionSortingTest, GeoPointSortingWithPrecision) {
     collectionManager.drop_collection("coll1");
 }
 
+TEST_F(CollectionSortingTest, GeoPointSortingNearestPage) {
+    std::vector<field> fields = {field("loc", field_types::GEOPOINT, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    const double ref_lat = 32.24348, ref_lng = 77.1893;
+    S2LatLng ref_lat_lng;
+    GeoPoint::unpack_lat_lng(GeoPoint::pack_lat_lng(ref_lat, ref_lng), ref_lat_lng);
+
+    // points scattered up to a few hundred km away from the reference point
+    std::vector<int64_t> distances;
+    uint32_t rand_state = 42;
+    auto next_rand = [&rand_state]() {
+        rand_state = rand_state * 1103515245 + 12345;
+        return double((rand_state >> 8) % 100000) / 100000;
+    };
+
+    for(size_t i = 0; i < 2000; i++) {
+        double lat = ref_lat - 2 + (next_rand() * 4);
+        double lng = ref_lng - 2 + (next_rand() * 4);
+
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["loc"] = {lat, lng};
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+        S2LatLng lat_lng;
+        GeoPoint::unpack_lat_lng(GeoPoint::pack_lat_lng(lat, lng), lat_lng);
+        distances.push_back(GeoPoint::distance(lat_lng, ref_lat_lng));
+    }
+
+    std::sort(distances.begin(), distances.end());
+
+    std::vector<sort_by> geo_sort_fields = { sort_by("loc(32.24348, 77.1893)", "ASC") };
+
+    for(size_t page: {1, 3}) {
+        auto results = coll1->search("*", {}, "", {}, geo_sort_fields, {0}, 10, page, FREQUENCY).get();
+        ASSERT_EQ(2000, results["found"].get<size_t>());
+        ASSERT_EQ(10, results["hits"].size());
+
+        for(size_t i = 0; i < 10; i++) {
+            ASSERT_EQ(distances[(page - 1) * 10 + i],
+                      results["hits"][i]["geo_distance_meters"]["loc"].get<int64_t>());
+        }
+    }
+
+    collectionManager.drop_collection("coll1");
+}
+
 TEST_F(CollectionSortingTest, GeoPointAsOptionalField) {
     Collection* coll1;
 
@@ -2637,4 +2688,259 @@ TEST_F(CollectionSortingTest, TestVectorQueryQsSorting) {
     ASSERT_EQ(2, results["hits"].size());
     ASSERT_EQ("0", results["hits"][0]["document"]["id"]);
     ASSERT_EQ("1", results["hits"][1]["document"]["id"]);
-}
\ No newline at end of file
+}
+
+TEST_F(CollectionSortingTest, WildcardNumericalSortWalksValuesInOrder) {
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+            {"name": "points", "type": "int32", "optional": true},
+            {"name": "bonus", "type": "int32", "optional": true},
+            {"name": "rank", "type": "int32"},
+            {"name": "tier", "type": "int32"}
+        ]
+    })"_json;
+
+    Collection* coll1 = collectionManager.create_collection(schema).get();
+
+    // enough matches for the values of `points` to be walked in sort order, with plenty of ties and missing values
+    const size_t num_docs = 12000;
+    for(size_t i = 0; i < num_docs; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["rank"] = i;
+        doc["tier"] = i % 3;
+        if(i % 10 != 0) {
+            doc["points"] = (i * 7) % 300;
+        }
+        if(i % 100 == 1) {
+            doc["bonus"] = i % 7;
+        }
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    auto expected_ids = [&](bool desc, size_t min_rank) {
+        std::vector<size_t> ids;
+        for(size_t i = min_rank; i < num_docs; i++) {
+            ids.push_back(i);
+        }
+
+        std::stable_sort(ids.begin(), ids.end(), [&](size_t a, size_t b) {
+            const bool a_missing = (a % 10 == 0), b_missing = (b % 10 == 0);
+            if(a_missing != b_missing) {
+                return b_missing;
+            }
+
+            if(a_missing) {
+                return false;
+            }
+
+            const int64_t a_points = (a * 7) % 300, b_points = (b * 7) % 300;
+            return desc ? (a_points > b_points) : (a_points < b_points);
+        });
+
+        return ids;
+    };
+
+    for(const std::string& order: {"DESC", "ASC"}) {
+        for(size_t min_rank: {0, 100}) {
+            std::vector<sort_by> sort_fields = {sort_by("points", order), sort_by("rank", "ASC")};
+            const std::string filter = (min_rank == 0) ? "" : "rank:>=" + std::to_string(min_rank);
+            auto expected = expected_ids(order == "DESC", min_rank);
+
+            for(size_t page: {1, 3}) {
+                auto results = coll1->search("*", {}, filter, {}, sort_fields, {0}, 10, page, FREQUENCY, {false}).get();
+                ASSERT_EQ(num_docs - min_rank, results["found"].get<size_t>());
+                ASSERT_EQ(10, results["hits"].size());
+
+                for(size_t i = 0; i < 10; i++) {
+                    ASSERT_EQ(std::to_string(expected[(page - 1) * 10 + i]),
+                              results["hits"][i]["document"]["id"].get<std::string>());
+                }
+            }
+        }
+    }
+
+    // fewer documents with a value than hits asked for: the missing ones follow, ordered on `rank`
+    auto results = coll1->search("*", {}, "", {}, {sort_by("bonus", "DESC"), sort_by("rank", "ASC")},
+                                 {0}, 250, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(250, results["hits"].size());
+
+    std::vector<size_t> ids;
+    for(size_t i = 0; i < num_docs; i++) {
+        ids.push_back(i);
+    }
+
+    std::stable_sort(ids.begin(), ids.end(), [](size_t a, size_t b) {
+        const int64_t a_bonus = (a % 100 == 1) ? int64_t(a % 7) : -1, b_bonus = (b % 100 == 1) ? int64_t(b % 7) : -1;
+        return a_bonus > b_bonus;
+    });
+
+    for(size_t i = 0; i < 250; i++) {
+        ASSERT_EQ(std::to_string(ids[i]), results["hits"][i]["document"]["id"].get<std::string>());
+    }
+
+    // a value that ties more documents than the hits kept is scored the usual way
+    results = coll1->search("*", {}, "", {}, {sort_by("tier", "DESC"), sort_by("rank", "ASC")},
+                            {0}, 10, 2, FREQUENCY, {false}).get();
+    ASSERT_EQ(num_docs, results["found"].get<size_t>());
+    ASSERT_EQ(10, results["hits"].size());
+
+    for(size_t i = 0; i < 10; i++) {
+        ASSERT_EQ(std::to_string((10 + i) * 3 + 2), results["hits"][i]["document"]["id"].get<std::string>());
+    }
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionSortingTest, SearchAfterPagesMatchOffsetPages) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 100; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["points"] = i % 10;  // ties are broken by the seq id
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    nlohmann::json embedded_params;
+    std::map<std::string, std::string> req_params;
+    req_params["collection"] = "coll1";
+    req_params["q"] = "*";
+    req_params["sort_by"] = "points:desc";
+    req_params["per_page"] = "10";
+
+    auto now_ts = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::string search_after;
+
+    for(size_t page = 1; page <= 10; page++) {
+        nlohmann::json offset_res;
+        req_params["page"] = std::to_string(page);
+        ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, offset_res, now_ts).ok());
+        req_params.erase("page");
+
+        nlohmann::json cursor_res;
+        if(!search_after.empty()) {
+            req_params["search_after"] = search_after;
+        }
+
+        ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, cursor_res, now_ts).ok());
+        ASSERT_EQ(100, cursor_res["found"].get<size_t>());
+        ASSERT_EQ(10, cursor_res["hits"].size());
+
+        for(size_t i = 0; i < 10; i++) {
+            ASSERT_EQ(offset_res["hits"][i]["document"]["id"], cursor_res["hits"][i]["document"]["id"]);
+        }
+
+        search_after = cursor_res["next_search_after"].get<std::string>();
+    }
+
+    // past the last page
+    nlohmann::json res;
+    req_params["search_after"] = search_after;
+    ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, res, now_ts).ok());
+    ASSERT_EQ(0, res["hits"].size());
+    ASSERT_EQ(0, res.count("next_search_after"));
+
+    req_params["search_after"] = "bm90IGEgY3Vyc29y";
+    auto search_op = collectionManager.do_search(req_params, embedded_params, res, now_ts);
+    ASSERT_FALSE(search_op.ok());
+    ASSERT_EQ("Parameter `search_after` is malformed.", search_op.error());
+
+    req_params["search_after"] = search_after;
+    req_params["page"] = "2";
+    search_op = collectionManager.do_search(req_params, embedded_params, res, now_ts);
+    ASSERT_FALSE(search_op.ok());
+    ASSERT_EQ("Parameter `search_after` can not be used with `page` or `offset`.", search_op.error());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionSortingTest, RankedHitsAreReusedAcrossPages) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 30; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    std::vector<sort_by> sort_fields = {sort_by("points", "DESC")};
+
+    auto results = coll1->search("title", {"title"}, "points:>5", {}, sort_fields, {0}, 20, 1).get();
+    ASSERT_EQ(24, results["found"].get<size_t>());
+    ASSERT_EQ(20, results["hits"].size());
+
+    // a smaller page of the same search, with other fields, is served from the hits ranked above
+    results = coll1->search("title", {"title"}, "points:>5", {}, sort_fields, {0}, 5, 2, FREQUENCY, {true},
+                            Index::DROP_TOKENS_THRESHOLD, {"points"}).get();
+    ASSERT_EQ(24, results["found"].get<size_t>());
+    ASSERT_EQ(5, results["hits"].size());
+    ASSERT_EQ(0, results["hits"][0]["document"].count("title"));
+    ASSERT_EQ(24, results["hits"][0]["document"]["points"].get<size_t>());
+    ASSERT_EQ(20, results["hits"][4]["document"]["points"].get<size_t>());
+
+    // a write ranks the hits afresh
+    nlohmann::json doc;
+    doc["id"] = "30";
+    doc["title"] = "Title 30";
+    doc["points"] = 30;
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    results = coll1->search("title", {"title"}, "points:>5", {}, sort_fields, {0}, 5, 1).get();
+    ASSERT_EQ(25, results["found"].get<size_t>());
+    ASSERT_EQ("30", results["hits"][0]["document"]["id"].get<std::string>());
+
+    // as does a different filter
+    results = coll1->search("title", {"title"}, "points:>25", {}, sort_fields, {0}, 5, 1).get();
+    ASSERT_EQ(5, results["found"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionSortingTest, ProximityIsNotScoredWithoutTextMatchSort) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),
+                                 field("rank", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    std::vector<std::string> titles = {"Mong Spencer", "Mong foo bar baz Spencer"};
+    for(size_t i = 0; i < titles.size(); i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = titles[i];
+        doc["points"] = 100;
+        doc["rank"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    std::vector<sort_by> sort_fields = {sort_by("points", "DESC"), sort_by("rank", "DESC"),
+                                        sort_by("_seq_id", "DESC")};
+
+    auto results = coll1->search("mong spencer", {"title"}, "", {}, sort_fields, {0}, 10, 1).get();
+    ASSERT_EQ(2, results["hits"].size());
+    ASSERT_EQ("1", results["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_EQ(results["hits"][0]["text_match"].get<size_t>(), results["hits"][1]["text_match"].get<size_t>());
+
+    // the proximity is scored when the hits are sorted on it
+    sort_fields = {sort_by("_text_match", "DESC"), sort_by("rank", "DESC")};
+
+    results = coll1->search("mong spencer", {"title"}, "", {}, sort_fields, {0}, 10, 1).get();
+    ASSERT_EQ(2, results["hits"].size());
+    ASSERT_EQ("0", results["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_GT(results["hits"][0]["text_match"].get<size_t>(), results["hits"][1]["text_match"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+}
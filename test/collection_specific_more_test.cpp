@@ -1613,6 +1613,40 @@ TEST_F(CollectionSpecificMoreTest, HighlightWordWithSymbols) {
               res["hits"][0]["highlight"]["title"]["snippet"].get<std::string>());
 }
 
+TEST_F(CollectionSpecificMoreTest, HighlightTextTokenizedBefore) {
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+            {"name": "title", "type": "string"}
+        ]
+    })"_json;
+
+    Collection *coll1 = collectionManager.create_collection(schema).get();
+
+    // the documents share the text, so all but the first highlight walk the tokens of an earlier one
+    for(size_t i = 0; i < 2; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "The quick brown fox and dog jump over the lazy cat";
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    for(size_t round = 0; round < 2; round++) {
+        auto res = coll1->search("fox", {"title"}, "", {}, {}, {0}).get();
+        ASSERT_EQ(2, res["hits"].size());
+
+        for(size_t i = 0; i < 2; i++) {
+            ASSERT_EQ("The quick brown <mark>fox</mark> and dog jump over the lazy cat",
+                      res["hits"][i]["highlight"]["title"]["snippet"].get<std::string>());
+        }
+
+        res = coll1->search("lazy ca", {"title"}, "", {}, {}, {0}).get();
+        ASSERT_EQ(2, res["hits"].size());
+        ASSERT_EQ("The quick brown fox and dog jump over the <mark>lazy</mark> <mark>ca</mark>t",
+                  res["hits"][0]["highlight"]["title"]["snippet"].get<std::string>());
+    }
+}
+
 TEST_F(CollectionSpecificMoreTest, HighlightObjectShouldBeEmptyWhenNoHighlightFieldFound) {
     nlohmann::json schema = R"({
         "name": "coll1",
@@ -3012,4 +3046,239 @@ TEST_F(CollectionSpecificMoreTest, TestFieldStore) {
     ASSERT_EQ(1, res.get()["hits"].size());
     ASSERT_EQ("store", res.get()["hits"][0]["document"]["word_to_store"].get<std::string>());
     ASSERT_TRUE(res.get()["hits"][0]["document"].count("word_not_to_store") == 0);
-}
\ No newline at end of file
+}
+
+TEST_F(CollectionSpecificMoreTest, ParallelScoringOfLargeIntersection) {
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+          {"name": "title", "type": "string"},
+          {"name": "points", "type": "int32"}
+        ]
+    })"_json;
+
+    Collection* coll1 = collectionManager.create_collection(schema).get();
+
+    // large enough for the candidates to be scored across threads
+    const size_t num_docs = Index::PARALLEL_SCORING_MIN_CANDIDATES + 5000;
+    std::vector<std::string> json_lines;
+
+    for(size_t i = 0; i < num_docs; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        // every 100th document contains the tokens next to each other
+        doc["title"] = (i % 100 == 0) ? "alpha beta gamma" : "alpha gamma beta";
+        doc["points"] = i;
+        json_lines.push_back(doc.dump());
+    }
+
+    nlohmann::json document;
+    auto import_res = coll1->add_many(json_lines, document);
+    ASSERT_TRUE(import_res["success"].get<bool>());
+
+    std::vector<sort_by> sort_fields = {sort_by("_text_match", "DESC"), sort_by("points", "DESC")};
+    auto results = coll1->search("alpha beta", {"title"}, "", {}, sort_fields, {0}, 10, 1, FREQUENCY, {false}).get();
+
+    ASSERT_EQ(num_docs, results["found"].get<size_t>());
+    ASSERT_EQ(10, results["hits"].size());
+
+    // best text matches first, and within them, highest points
+    size_t expected_id = ((num_docs - 1) / 100) * 100;
+    for(size_t i = 0; i < results["hits"].size(); i++) {
+        ASSERT_EQ(std::to_string(expected_id), results["hits"][i]["document"]["id"].get<std::string>());
+        expected_id -= 100;
+    }
+
+    // excluded documents are excluded across all the scoring threads
+    results = coll1->search("alpha beta", {"title"}, "", {}, sort_fields, {0}, 10, 1, FREQUENCY, {false}, 0,
+                            spp::sparse_hash_set<std::string>(),
+                            spp::sparse_hash_set<std::string>(), 10, "", 30, 4, "", 20, "", "24900").get();
+
+    ASSERT_EQ(num_docs - 1, results["found"].get<size_t>());
+    ASSERT_EQ("24800", results["hits"][0]["document"]["id"].get<std::string>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionSpecificMoreTest, TotalHitsOfWildcardSearch) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("tags", field_types::STRING_ARRAY, true),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 1000; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = (i % 10 == 0) ? "excluded title" : "title";
+        doc["tags"] = {(i % 2 == 0) ? "even" : "odd"};
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    nlohmann::json embedded_params;
+    std::map<std::string, std::string> req_params;
+    req_params["collection"] = "coll1";
+    req_params["q"] = "*";
+    req_params["filter_by"] = "points:>=100";
+
+    auto now_ts = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // the matches are counted as they are scored, with and without facets that need their ids
+    for(const std::string& facet_by: {"", "tags"}) {
+        req_params["facet_by"] = facet_by;
+
+        nlohmann::json res;
+        ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, res, now_ts).ok());
+        ASSERT_EQ(900, res["found"].get<size_t>());
+
+        req_params["q"] = "-excluded";
+        req_params["query_by"] = "title";
+        ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, res, now_ts).ok());
+        ASSERT_EQ(810, res["found"].get<size_t>());
+
+        req_params["q"] = "*";
+        req_params.erase("query_by");
+    }
+
+    req_params.erase("facet_by");
+
+    nlohmann::json res;
+    req_params["total_hits"] = "approx";
+    ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, res, now_ts).ok());
+    ASSERT_EQ(900, res["found"].get<size_t>());
+
+    req_params["total_hits"] = "none";
+    ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, res, now_ts).ok());
+    ASSERT_EQ(0, res.count("found"));
+    ASSERT_EQ(10, res["hits"].size());
+
+    req_params["total_hits"] = "some";
+    auto search_op = collectionManager.do_search(req_params, embedded_params, res, now_ts);
+    ASSERT_FALSE(search_op.ok());
+    ASSERT_EQ("Parameter `total_hits` must be one of `exact`, `approx` or `none`.", search_op.error());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionSpecificMoreTest, TypoMatchesAreCountedWhenTopsterIsFull) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 30; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = (i < 20) ? "running shoes" : "runnig shoes";
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    nlohmann::json embedded_params;
+    std::map<std::string, std::string> req_params;
+    req_params["collection"] = "coll1";
+    req_params["q"] = "running shoes";
+    req_params["query_by"] = "title";
+    req_params["per_page"] = "5";
+    req_params["typo_tokens_threshold"] = "100";
+
+    auto now_ts = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // the typo matches can't beat the exact ones that fill the page, but are still found
+    nlohmann::json res;
+    ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, res, now_ts).ok());
+    ASSERT_EQ(30, res["found"].get<size_t>());
+    ASSERT_EQ(5, res["hits"].size());
+
+    for(const auto& hit: res["hits"]) {
+        ASSERT_LT(std::stoi(hit["document"]["id"].get<std::string>()), 20);
+    }
+
+    // they are scored when the text match does not decide the order
+    req_params["sort_by"] = "points:desc";
+    ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, res, now_ts).ok());
+    ASSERT_EQ(30, res["found"].get<size_t>());
+    ASSERT_EQ("29", res["hits"][0]["document"]["id"].get<std::string>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionSpecificMoreTest, ExactMatchIndex) {
+    auto schema = R"({
+        "name": "coll1",
+        "fields": [
+            {"name": "title", "type": "string", "exact_match_index": true},
+            {"name": "points", "type": "int32"}
+        ]
+    })"_json;
+
+    auto coll_op = collectionManager.create_collection(schema);
+    ASSERT_TRUE(coll_op.ok());
+    Collection* coll1 = coll_op.get();
+    ASSERT_TRUE(coll1->get_summary_json()["fields"][0]["exact_match_index"].get<bool>());
+
+    std::vector<std::string> titles = {"Nike Air Max", "Nike Air Max 90", "nike  AIR max", "Nike Air"};
+    for(size_t i = 0; i < titles.size(); i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = titles[i];
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    nlohmann::json embedded_params;
+    std::map<std::string, std::string> req_params;
+    req_params["collection"] = "coll1";
+    req_params["q"] = "nike air max";
+    req_params["query_by"] = "title";
+    req_params["sort_by"] = "points:desc";
+
+    auto now_ts = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // only the documents whose whole title is the query are found, since they reach the typo tokens threshold
+    nlohmann::json res;
+    ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, res, now_ts).ok());
+    ASSERT_EQ(2, res["found"].get<size_t>());
+    ASSERT_EQ("2", res["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_EQ("0", res["hits"][1]["document"]["id"].get<std::string>());
+    ASSERT_NE(std::string::npos, res["hits"][1]["highlight"]["title"]["snippet"].get<std::string>().find("<mark>Nike</mark>"));
+
+    req_params["typo_tokens_threshold"] = "3";
+    ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, res, now_ts).ok());
+    ASSERT_EQ(3, res["found"].get<size_t>());
+
+    req_params["typo_tokens_threshold"] = "1";
+    req_params["filter_by"] = "points:<2";
+    ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, res, now_ts).ok());
+    ASSERT_EQ(1, res["found"].get<size_t>());
+    ASSERT_EQ("0", res["hits"][0]["document"]["id"].get<std::string>());
+
+    // values that are updated or deleted leave the index
+    nlohmann::json doc_update;
+    doc_update["id"] = "0";
+    doc_update["title"] = "Nike Air Force";
+    ASSERT_TRUE(coll1->add(doc_update.dump(), UPDATE).ok());
+    ASSERT_TRUE(coll1->remove("2").ok());
+
+    req_params.erase("filter_by");
+    ASSERT_TRUE(collectionManager.do_search(req_params, embedded_params, res, now_ts).ok());
+    ASSERT_EQ(1, res["found"].get<size_t>());
+    ASSERT_EQ("1", res["hits"][0]["document"]["id"].get<std::string>());
+
+    schema = R"({
+        "name": "coll2",
+        "fields": [
+            {"name": "points", "type": "int32", "exact_match_index": true}
+        ]
+    })"_json;
+
+    coll_op = collectionManager.create_collection(schema);
+    ASSERT_FALSE(coll_op.ok());
+    ASSERT_EQ("The `exact_match_index` property is only allowed for string and string[] fields.", coll_op.error());
+
+    collectionManager.drop_collection("coll1");
+}
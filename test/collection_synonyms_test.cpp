@@ -1187,4 +1187,36 @@ TEST_F(CollectionSynonymsTest, SynonymWithStemming) {
     ASSERT_EQ(2, res["found"].get<uint32_t>());
 
     collectionManager.drop_collection("coll1");
-}
\ No newline at end of file
+}
+
+TEST_F(CollectionSynonymsTest, SynonymReductionWithKeysSharingPrefixes) {
+    std::vector<std::vector<std::string>> results;
+
+    coll_mul_fields->add_synonym(R"({"id": "nyc-1", "root": "new york", "synonyms": ["nyc"]})"_json);
+    coll_mul_fields->add_synonym(R"({"id": "nyc-2", "root": "new york city", "synonyms": ["big apple"]})"_json);
+
+    // the longest window that is a key is replaced first
+    coll_mul_fields->synonym_reduction({"hotels", "new", "york", "city"}, results);
+    ASSERT_EQ(2, results.size());
+    ASSERT_EQ(std::vector<std::string>({"hotels", "big", "apple"}), results[0]);
+    ASSERT_EQ(std::vector<std::string>({"hotels", "nyc", "city"}), results[1]);
+
+    results.clear();
+    coll_mul_fields->synonym_reduction({"new", "york", "hotels"}, results);
+    ASSERT_EQ(1, results.size());
+    ASSERT_EQ(std::vector<std::string>({"nyc", "hotels"}), results[0]);
+
+    // removing the longer key leaves the shorter one that it extends
+    ASSERT_TRUE(coll_mul_fields->remove_synonym("nyc-2").ok());
+
+    results.clear();
+    coll_mul_fields->synonym_reduction({"hotels", "new", "york", "city"}, results);
+    ASSERT_EQ(1, results.size());
+    ASSERT_EQ(std::vector<std::string>({"hotels", "nyc", "city"}), results[0]);
+
+    ASSERT_TRUE(coll_mul_fields->remove_synonym("nyc-1").ok());
+
+    results.clear();
+    coll_mul_fields->synonym_reduction({"new", "york", "hotels"}, results);
+    ASSERT_EQ(0, results.size());
+}
@@ -2765,6 +2765,117 @@ TEST_F(CollectionTest, UpdateDocumentUnIndexedField) {
     collectionManager.drop_collection("coll1");
 }
 
+TEST_F(CollectionTest, PartialUpdateIsMergedIntoStoredDocument) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),
+                                 field("tags", field_types::STRING_ARRAY, false, true)};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 3; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["points"] = i;
+        doc["tags"] = {"foo"};
+        doc["meta"] = {{"color", "red"}, {"size", 10}};
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    nlohmann::json update_doc;
+    update_doc["id"] = "0";
+    update_doc["points"] = 100;
+    update_doc["meta"] = {{"size", 12}};
+    ASSERT_TRUE(coll1->add(update_doc.dump(), UPDATE).ok());
+
+    auto doc = coll1->get("0").get();
+    ASSERT_EQ(100, doc["points"].get<int32_t>());
+    ASSERT_EQ("Title 0", doc["title"].get<std::string>());
+    ASSERT_EQ(nlohmann::json::parse(R"({"color":"red","size":12})"), doc["meta"]);
+
+    auto res = coll1->search("*", {}, "", {}, {sort_by("points", "DESC")}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(3, res["found"].get<size_t>());
+    ASSERT_EQ("0", res["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_EQ(100, res["hits"][0]["document"]["points"].get<int32_t>());
+
+    // a null value removes the field
+    update_doc = nlohmann::json::object();
+    update_doc["id"] = "0";
+    update_doc["tags"] = nullptr;
+    ASSERT_TRUE(coll1->add(update_doc.dump(), UPDATE).ok());
+
+    doc = coll1->get("0").get();
+    ASSERT_EQ(0, doc.count("tags"));
+    ASSERT_EQ(100, doc["points"].get<int32_t>());
+
+    res = coll1->search("*", {}, "tags:foo", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(2, res["found"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionTest, NumericUpdatesInPlace) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),
+                                 field("views", field_types::INT64, false, true),
+                                 field("price", field_types::FLOAT, false),
+                                 field("stock", field_types::INT32, true)};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 3; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["points"] = i;
+        doc["price"] = 9.5;
+        doc["stock"] = 10;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    std::vector<std::string> json_lines = {
+        R"({"id": "0", "increment": {"points": 10, "views": 3}, "set": {"price": 4.25}})",
+        R"({"id": "1", "increment": {"points": 2147483647}})",
+        R"({"id": "2", "set": {"stock": 5}})",
+        R"({"id": "3", "set": {"points": 5}})",
+        R"({"id": "0", "increment": {"views": 2}})",
+    };
+
+    auto summary = coll1->update_numeric_fields(json_lines);
+    ASSERT_FALSE(summary["success"].get<bool>());
+    ASSERT_EQ(2, summary["num_updated"].get<size_t>());
+
+    ASSERT_EQ(R"({"success":true,"values":{"points":10,"price":4.25,"views":3}})", json_lines[0]);
+    ASSERT_EQ("Field `points` overflows.", nlohmann::json::parse(json_lines[1])["error"].get<std::string>());
+    ASSERT_EQ(400, nlohmann::json::parse(json_lines[2])["code"].get<size_t>());
+    ASSERT_EQ(404, nlohmann::json::parse(json_lines[3])["code"].get<size_t>());
+    ASSERT_EQ(R"({"success":true,"values":{"views":5}})", json_lines[4]);
+
+    auto doc = coll1->get("0").get();
+    ASSERT_EQ(10, doc["points"].get<int32_t>());
+    ASSERT_EQ(5, doc["views"].get<int64_t>());
+    ASSERT_FLOAT_EQ(4.25, doc["price"].get<float>());
+    ASSERT_EQ("Title 0", doc["title"].get<std::string>());
+
+    // a failed update leaves the document as it was
+    doc = coll1->get("1").get();
+    ASSERT_EQ(1, doc["points"].get<int32_t>());
+
+    auto res = coll1->search("*", {}, "points:>5", {}, {sort_by("points", "DESC")}, {0}, 10, 1, FREQUENCY,
+                             {false}).get();
+    ASSERT_EQ(1, res["found"].get<size_t>());
+    ASSERT_EQ("0", res["hits"][0]["document"]["id"].get<std::string>());
+
+    res = coll1->search("*", {}, "points:<5", {}, {sort_by("price", "ASC")}, {0}, 10, 1, FREQUENCY,
+                        {false}).get();
+    ASSERT_EQ(2, res["found"].get<size_t>());
+
+    res = coll1->search("*", {}, "", {}, {sort_by("price", "ASC")}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ("0", res["hits"][0]["document"]["id"].get<std::string>());
+
+    collectionManager.drop_collection("coll1");
+}
+
 TEST_F(CollectionTest, SearchHighlightFieldFully) {
     Collection *coll1;
 
@@ -3123,6 +3234,101 @@ TEST_F(CollectionTest, RemoveIfFound) {
     collectionManager.drop_collection("coll1");
 }
 
+TEST_F(CollectionTest, RemoveBatch) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("description", field_types::STRING, false, true, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 4, fields, "points").get();
+
+    for(size_t i = 0; i < 10; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["description"] = "Not indexed";
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    // the missing document is skipped
+    std::vector<uint32_t> seq_ids = {0, 2, 4, 100};
+    auto remove_op = coll1->remove_batch(seq_ids.data(), seq_ids.size());
+    ASSERT_TRUE(remove_op.ok());
+    ASSERT_EQ(3, remove_op.get());
+    ASSERT_EQ(7, coll1->get_num_documents());
+
+    ASSERT_EQ(404, coll1->get("2").code());
+    ASSERT_TRUE(coll1->get("3").ok());
+
+    auto res = coll1->search("title", {"title"}, "", {}, {}, {0}).get();
+    ASSERT_EQ(7, res["found"].get<size_t>());
+
+    res = coll1->search("*", {}, "points:<5", {}, {}, {0}).get();
+    ASSERT_EQ(2, res["found"].get<size_t>());
+
+    // a removed document can be added again
+    nlohmann::json doc;
+    doc["id"] = "2";
+    doc["title"] = "Title 2";
+    doc["description"] = "Not indexed";
+    doc["points"] = 2;
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    res = coll1->search("*", {}, "points:<5", {}, {}, {0}).get();
+    ASSERT_EQ(3, res["found"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionTest, DeferredDeletes) {
+    Config::get_instance().set_enable_deferred_deletes(true);
+
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("tags", field_types::STRING_ARRAY, true),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 4, fields, "points").get();
+
+    for(size_t i = 0; i < 10; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = "Title " + std::to_string(i);
+        doc["tags"] = {(i % 2 == 0) ? "even" : "odd"};
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    ASSERT_TRUE(coll1->remove("2").ok());
+    ASSERT_TRUE(coll1->remove_if_found(4).get());
+
+    // the documents are still indexed, but are not found
+    ASSERT_EQ(10, coll1->_get_index()->num_seq_ids());
+    ASSERT_EQ(8, coll1->get_num_documents());
+    ASSERT_EQ(404, coll1->get("2").code());
+
+    auto res = coll1->search("title", {"title"}, "", {"tags"}, {}, {0}).get();
+    ASSERT_EQ(8, res["found"].get<size_t>());
+    ASSERT_EQ("even", res["facet_counts"][0]["counts"][1]["value"].get<std::string>());
+    ASSERT_EQ(3, res["facet_counts"][0]["counts"][1]["count"].get<size_t>());
+
+    res = coll1->search("*", {}, "points:<5", {}, {}, {0}).get();
+    ASSERT_EQ(3, res["found"].get<size_t>());
+
+    filter_result_t filter_result;
+    ASSERT_TRUE(coll1->get_filter_ids("points:<5", filter_result).ok());
+    ASSERT_EQ(3, filter_result.count);
+
+    ASSERT_EQ(2, coll1->purge_deleted_docs());
+    ASSERT_EQ(8, coll1->_get_index()->num_seq_ids());
+    ASSERT_EQ(0, coll1->purge_deleted_docs());
+
+    res = coll1->search("*", {}, "points:<5", {}, {}, {0}).get();
+    ASSERT_EQ(3, res["found"].get<size_t>());
+
+    Config::get_instance().set_enable_deferred_deletes(false);
+    collectionManager.drop_collection("coll1");
+}
+
 TEST_F(CollectionTest, CreateCollectionInvalidFieldType) {
     std::vector<field> fields = {field("title", "blah", true),
                                  field("points", "int", false)};
@@ -5,6 +5,7 @@
 #include "collection.h"
 #include <cstdlib>
 #include <ctime>
+#include <random>
 #include "conversation_manager.h"
 #include "conversation_model_manager.h"
 #include "index.h"
@@ -253,6 +254,501 @@ TEST_F(CollectionVectorTest, VectorDistanceConfig) {
     ASSERT_EQ("ip", coll_summary["fields"][2]["vec_dist"].get<std::string>());
 }
 
+TEST_F(CollectionVectorTest, QuantizedVectorQuerying) {
+    nlohmann::json schema = R"({
+        "name": "coll_float",
+        "fields": [
+            {"name": "points", "type": "int32"},
+            {"name": "vec", "type": "float[]", "num_dim": 32}
+        ]
+    })"_json;
+
+    Collection* coll_float = collectionManager.create_collection(schema).get();
+
+    schema["name"] = "coll_sq8";
+    schema["fields"][1]["hnsw_params"] = R"({"quantization": "sq8"})"_json;
+    Collection* coll_sq8 = collectionManager.create_collection(schema).get();
+
+    auto coll_summary = coll_sq8->get_summary_json();
+    ASSERT_EQ("sq8", coll_summary["fields"][1]["hnsw_params"]["quantization"].get<std::string>());
+    ASSERT_NE(nullptr, coll_sq8->_get_index()->_get_vector_index().at("vec")->quantized_space);
+    ASSERT_EQ(nullptr, coll_float->_get_index()->_get_vector_index().at("vec")->quantized_space);
+
+    std::mt19937 rng(100);
+    std::normal_distribution<float> value_dist(0, 1);
+
+    for(size_t i = 0; i < 500; i++) {
+        std::vector<float> values(32);
+        for(auto& value: values) {
+            value = value_dist(rng);
+        }
+
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["points"] = i;
+        doc["vec"] = values;
+        ASSERT_TRUE(coll_float->add(doc.dump()).ok());
+        ASSERT_TRUE(coll_sq8->add(doc.dump()).ok());
+    }
+
+    std::vector<float> query(32);
+    for(auto& value: query) {
+        value = value_dist(rng);
+    }
+
+    const std::string vector_query = "vec:(" + nlohmann::json(query).dump() + ", k: 10)";
+
+    auto search = [&](Collection* coll, const std::string& filter) {
+        return coll->search("*", {}, filter, {}, {}, {0}, 10, 1, FREQUENCY, {true}, Index::DROP_TOKENS_THRESHOLD,
+                            spp::sparse_hash_set<std::string>(),
+                            spp::sparse_hash_set<std::string>(), 10, "", 30, 5,
+                            "", 10, {}, {}, {}, 0,
+                            "<mark>", "</mark>", {}, 1000, true, false, true, "", false, 6000 * 1000, 4, 7, fallback,
+                            4, {off}, 32767, 32767, 2,
+                            false, true, vector_query).get();
+    };
+
+    auto float_results = search(coll_float, "");
+    auto sq8_results = search(coll_sq8, "");
+    ASSERT_EQ(10, sq8_results["hits"].size());
+
+    std::map<std::string, float> float_distances;
+    for(const auto& hit: float_results["hits"]) {
+        float_distances[hit["document"]["id"].get<std::string>()] = hit["vector_distance"].get<float>();
+    }
+
+    size_t num_common = 0;
+    for(const auto& hit: sq8_results["hits"]) {
+        auto it = float_distances.find(hit["document"]["id"].get<std::string>());
+        if(it != float_distances.end()) {
+            num_common++;
+            ASSERT_NEAR(it->second, hit["vector_distance"].get<float>(), 0.01);
+        }
+    }
+
+    ASSERT_GE(num_common, 8);
+
+    // flat search over the filtered documents decodes the vectors too
+    float_results = search(coll_float, "points:< 50");
+    sq8_results = search(coll_sq8, "points:< 50");
+    ASSERT_EQ(float_results["hits"][0]["document"]["id"], sq8_results["hits"][0]["document"]["id"]);
+
+    schema["name"] = "coll_invalid";
+    schema["fields"][1]["hnsw_params"] = R"({"quantization": "int4"})"_json;
+    auto create_op = collectionManager.create_collection(schema);
+    ASSERT_FALSE(create_op.ok());
+    ASSERT_EQ("Property `hnsw_params.quantization` must be one of `none`, `sq8`.", create_op.error());
+}
+
+TEST_F(CollectionVectorTest, DiskResidentFullVectors) {
+    nlohmann::json schema = R"({
+        "name": "coll_float",
+        "fields": [
+            {"name": "vec", "type": "float[]", "num_dim": 16}
+        ]
+    })"_json;
+
+    Collection* coll_float = collectionManager.create_collection(schema).get();
+
+    schema["name"] = "coll_disk";
+    schema["fields"][0]["hnsw_params"] = R"({"storage": "disk"})"_json;
+    Collection* coll_disk = collectionManager.create_collection(schema).get();
+
+    // vectors kept on disk are quantized in the graph
+    auto coll_summary = coll_disk->get_summary_json();
+    ASSERT_EQ("disk", coll_summary["fields"][0]["hnsw_params"]["storage"].get<std::string>());
+    ASSERT_EQ("sq8", coll_summary["fields"][0]["hnsw_params"]["quantization"].get<std::string>());
+
+    auto vec_index = coll_disk->_get_index()->_get_vector_index().at("vec");
+    ASSERT_NE(nullptr, vec_index->quantized_space);
+    ASSERT_NE(nullptr, vec_index->full_vectors);
+
+    std::mt19937 rng(5);
+    std::normal_distribution<float> value_dist(0, 1);
+
+    for(size_t i = 0; i < 200; i++) {
+        std::vector<float> values(16);
+        for(auto& value: values) {
+            value = value_dist(rng);
+        }
+
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["vec"] = values;
+        ASSERT_TRUE(coll_float->add(doc.dump()).ok());
+        ASSERT_TRUE(coll_disk->add(doc.dump()).ok());
+    }
+
+    ASSERT_EQ(200, vec_index->full_vectors->size());
+
+    std::vector<float> query(16);
+    for(auto& value: query) {
+        value = value_dist(rng);
+    }
+
+    const std::string vector_query = "vec:(" + nlohmann::json(query).dump() + ", k: 5)";
+
+    auto search = [&](Collection* coll) {
+        return coll->search("*", {}, "", {}, {}, {0}, 10, 1, FREQUENCY, {true}, Index::DROP_TOKENS_THRESHOLD,
+                            spp::sparse_hash_set<std::string>(),
+                            spp::sparse_hash_set<std::string>(), 10, "", 30, 5,
+                            "", 10, {}, {}, {}, 0,
+                            "<mark>", "</mark>", {}, 1000, true, false, true, "", false, 6000 * 1000, 4, 7, fallback,
+                            4, {off}, 32767, 32767, 2,
+                            false, true, vector_query).get();
+    };
+
+    auto float_results = search(coll_float);
+    auto disk_results = search(coll_disk);
+    ASSERT_EQ(5, disk_results["hits"].size());
+
+    // candidates are ranked on their float vectors
+    ASSERT_EQ(float_results["hits"][0]["document"]["id"], disk_results["hits"][0]["document"]["id"]);
+    ASSERT_FLOAT_EQ(float_results["hits"][0]["vector_distance"].get<float>(),
+                    disk_results["hits"][0]["vector_distance"].get<float>());
+
+    const std::string nearest_id = disk_results["hits"][0]["document"]["id"].get<std::string>();
+    ASSERT_TRUE(coll_disk->remove(nearest_id).ok());
+    ASSERT_EQ(199, vec_index->full_vectors->size());
+
+    disk_results = search(coll_disk);
+    ASSERT_NE(nearest_id, disk_results["hits"][0]["document"]["id"].get<std::string>());
+
+    schema["name"] = "coll_invalid";
+    schema["fields"][0]["hnsw_params"] = R"({"storage": "disk", "quantization": "none"})"_json;
+    auto create_op = collectionManager.create_collection(schema);
+    ASSERT_FALSE(create_op.ok());
+    ASSERT_EQ("Property `hnsw_params.storage` can be `disk` only for quantized vectors.", create_op.error());
+}
+
+TEST_F(CollectionVectorTest, GraphIsSizedForStoredDocumentsOnLoad) {
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+            {"name": "vec", "type": "float[]", "num_dim": 4}
+        ]
+    })"_json;
+
+    Collection* coll1 = collectionManager.create_collection(schema).get();
+
+    std::mt19937 rng(47);
+    std::uniform_real_distribution<> distrib;
+
+    std::vector<std::string> docs;
+    for(size_t i = 0; i < 1500; i++) {
+        nlohmann::json doc;
+        doc["vec"] = std::vector<float>{float(distrib(rng)), float(distrib(rng)), float(distrib(rng)), float(distrib(rng))};
+        docs.push_back(doc.dump());
+    }
+
+    nlohmann::json doc;
+    coll1->add_many(docs, doc);
+    ASSERT_EQ(1500, coll1->get_num_documents());
+
+    collectionManager.dispose();
+    delete store;
+
+    store = new Store("/tmp/typesense_test/collection_vector_search");
+    collectionManager.init(store, 1.0, "auth_key", quit);
+    ASSERT_TRUE(collectionManager.load(8, 1000).ok());
+
+    // the graph is sized up front instead of being grown batch by batch
+    coll1 = collectionManager.get_collection("coll1").get();
+    ASSERT_EQ(1500, coll1->get_num_documents());
+    ASSERT_EQ(1500, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getMaxElements());
+    ASSERT_EQ(1500, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getCurrentElementCount());
+}
+
+TEST_F(CollectionVectorTest, CompactGraphOfDeletedPoints) {
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+            {"name": "vec", "type": "float[]", "num_dim": 4}
+        ]
+    })"_json;
+
+    Collection* coll1 = collectionManager.create_collection(schema).get();
+
+    std::mt19937 rng(47);
+    std::uniform_real_distribution<> distrib;
+
+    std::vector<std::string> docs;
+    for(size_t i = 0; i < 3000; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["vec"] = std::vector<float>{float(distrib(rng)), float(distrib(rng)), float(distrib(rng)), float(distrib(rng))};
+        docs.push_back(doc.dump());
+    }
+
+    nlohmann::json doc;
+    coll1->add_many(docs, doc);
+
+    for(size_t i = 0; i < 3000; i += 2) {
+        ASSERT_TRUE(coll1->remove(std::to_string(i)).ok());
+        if(i == 500) {
+            // too few deleted points to be worth a rebuild
+            ASSERT_EQ(0, coll1->compact_vector_indices());
+        }
+    }
+
+    auto vec_index = coll1->_get_index()->_get_vector_index().at("vec");
+    ASSERT_EQ(1500, vec_index->vecdex->getDeletedCount());
+
+    ASSERT_EQ(1, coll1->compact_vector_indices());
+    vec_index = coll1->_get_index()->_get_vector_index().at("vec");
+    ASSERT_EQ(0, vec_index->vecdex->getDeletedCount());
+    ASSERT_EQ(1500, vec_index->vecdex->getCurrentElementCount());
+    ASSERT_EQ(0, coll1->compact_vector_indices());
+
+    // only live documents are found, and vectors are those of their documents
+    auto results = coll1->search("*", {}, "", {}, {}, {0}, 250, 1, FREQUENCY, {true}, Index::DROP_TOKENS_THRESHOLD,
+                                 spp::sparse_hash_set<std::string>(),
+                                 spp::sparse_hash_set<std::string>(), 10, "", 30, 5,
+                                 "", 10, {}, {}, {}, 0,
+                                 "<mark>", "</mark>", {}, 1000, true, false, true, "", false, 6000 * 1000, 4, 7, fallback,
+                                 4, {off}, 32767, 32767, 2,
+                                 false, true, "vec:([], id: 1, k: 250)").get();
+
+    ASSERT_EQ(250, results["hits"].size());
+    for(const auto& hit: results["hits"]) {
+        ASSERT_EQ(1, std::stoi(hit["document"]["id"].get<std::string>()) % 2);
+    }
+
+    std::vector<float> normalized_vec(4);
+    hnsw_index_t::normalize_vector(nlohmann::json::parse(docs[1])["vec"].get<std::vector<float>>(), normalized_vec);
+    ASSERT_EQ(normalized_vec, vec_index->get_vector(1));
+
+    // the compacted graph takes writes
+    ASSERT_TRUE(coll1->add(docs[0]).ok());
+    ASSERT_EQ(1501, vec_index->vecdex->getCurrentElementCount());
+}
+
+TEST_F(CollectionVectorTest, SeveralQueryVectors) {
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+            {"name": "points", "type": "int32"},
+            {"name": "vec", "type": "float[]", "num_dim": 2}
+        ]
+    })"_json;
+
+    Collection* coll1 = collectionManager.create_collection(schema).get();
+
+    std::vector<std::vector<float>> values = {
+        {1, 0}, {0.98, 0.2}, {0, 1}, {0.2, 0.98}, {-1, 0}
+    };
+
+    for(size_t i = 0; i < values.size(); i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["points"] = i;
+        doc["vec"] = values[i];
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    // a document is scored on the nearest of the query vectors
+    for(const std::string& filter: {"", "points:<4"}) {
+        auto results = coll1->search("*", {}, filter, {}, {}, {0}, 10, 1, FREQUENCY, {true}, Index::DROP_TOKENS_THRESHOLD,
+                                     spp::sparse_hash_set<std::string>(),
+                                     spp::sparse_hash_set<std::string>(), 10, "", 30, 5,
+                                     "", 10, {}, {}, {}, 0,
+                                     "<mark>", "</mark>", {}, 1000, true, false, true, "", false, 6000 * 1000, 4, 7, fallback,
+                                     4, {off}, 32767, 32767, 2,
+                                     false, true, "vec:([[1, 0], [0, 1]], k: 4)").get();
+
+        ASSERT_EQ(4, results["hits"].size());
+        std::set<std::string> ids;
+        for(const auto& hit: results["hits"]) {
+            ids.insert(hit["document"]["id"].get<std::string>());
+            ASSERT_GT(0.05, hit["vector_distance"].get<float>());
+        }
+
+        ASSERT_EQ(std::set<std::string>({"0", "1", "2", "3"}), ids);
+    }
+
+    // the referenced documents are omitted from results
+    auto results = coll1->search("*", {}, "", {}, {}, {0}, 10, 1, FREQUENCY, {true}, Index::DROP_TOKENS_THRESHOLD,
+                                 spp::sparse_hash_set<std::string>(),
+                                 spp::sparse_hash_set<std::string>(), 10, "", 30, 5,
+                                 "", 10, {}, {}, {}, 0,
+                                 "<mark>", "</mark>", {}, 1000, true, false, true, "", false, 6000 * 1000, 4, 7, fallback,
+                                 4, {off}, 32767, 32767, 2,
+                                 false, true, "vec:([], id: [0, 2], k: 2)").get();
+
+    ASSERT_EQ(2, results["hits"].size());
+    std::set<std::string> ids;
+    for(const auto& hit: results["hits"]) {
+        ids.insert(hit["document"]["id"].get<std::string>());
+    }
+
+    ASSERT_EQ(std::set<std::string>({"1", "3"}), ids);
+
+    auto res_op = coll1->search("*", {}, "", {}, {}, {0}, 10, 1, FREQUENCY, {true}, Index::DROP_TOKENS_THRESHOLD,
+                                spp::sparse_hash_set<std::string>(),
+                                spp::sparse_hash_set<std::string>(), 10, "", 30, 5,
+                                "", 10, {}, {}, {}, 0,
+                                "<mark>", "</mark>", {}, 1000, true, false, true, "", false, 6000 * 1000, 4, 7, fallback,
+                                4, {off}, 32767, 32767, 2,
+                                false, true, "vec:([[1, 0], [0, 1, 0]])");
+
+    ASSERT_FALSE(res_op.ok());
+    ASSERT_EQ("Query field `vec` must have 2 dimensions.", res_op.error());
+}
+
+TEST_F(CollectionVectorTest, FlatSearchOnVectorColumn) {
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+            {"name": "points", "type": "int32"},
+            {"name": "vec", "type": "float[]", "num_dim": 4, "hnsw_params": {"vector_column": true}}
+        ]
+    })"_json;
+
+    Collection* coll1 = collectionManager.create_collection(schema).get();
+    ASSERT_TRUE(coll1->get_summary_json()["fields"][1]["hnsw_params"]["vector_column"].get<bool>());
+
+    auto vec_index = coll1->_get_index()->_get_vector_index().at("vec");
+    ASSERT_NE(nullptr, vec_index->column);
+
+    std::mt19937 rng(50);
+    std::uniform_real_distribution<> distrib;
+
+    for(size_t i = 0; i < 500; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["points"] = i;
+        doc["vec"] = std::vector<float>{float(distrib(rng)), float(distrib(rng)), float(distrib(rng)), float(distrib(rng))};
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    ASSERT_TRUE(coll1->remove("7").ok());
+    ASSERT_EQ(499, vec_index->column->size());
+
+    // the flat search over the column finds what an exhaustive walk does
+    auto search = [&](const std::string& vector_query) {
+        return coll1->search("*", {}, "points:<300", {}, {}, {0}, 10, 1, FREQUENCY, {true}, Index::DROP_TOKENS_THRESHOLD,
+                             spp::sparse_hash_set<std::string>(),
+                             spp::sparse_hash_set<std::string>(), 10, "", 30, 5,
+                             "", 10, {}, {}, {}, 0,
+                             "<mark>", "</mark>", {}, 1000, true, false, true, "", false, 6000 * 1000, 4, 7, fallback,
+                             4, {off}, 32767, 32767, 2,
+                             false, true, vector_query).get();
+    };
+
+    auto flat_results = search("vec:([0.5, 0.1, 0.9, 0.3], k: 10, flat_search_cutoff: 1000)");
+    auto graph_results = search("vec:([0.5, 0.1, 0.9, 0.3], k: 10, flat_search_cutoff: 0, ef: 500)");
+
+    ASSERT_EQ(10, flat_results["hits"].size());
+    ASSERT_EQ(graph_results["hits"].size(), flat_results["hits"].size());
+
+    for(size_t i = 0; i < flat_results["hits"].size(); i++) {
+        ASSERT_EQ(graph_results["hits"][i]["document"]["id"], flat_results["hits"][i]["document"]["id"]);
+        ASSERT_NE("7", flat_results["hits"][i]["document"]["id"].get<std::string>());
+    }
+
+    schema = R"({
+        "name": "coll2",
+        "fields": [
+            {"name": "vec", "type": "float[]", "num_dim": 4, "hnsw_params": {"vector_column": 1}}
+        ]
+    })"_json;
+
+    auto coll_op = collectionManager.create_collection(schema);
+    ASSERT_FALSE(coll_op.ok());
+    ASSERT_EQ("Property `hnsw_params.vector_column` must be a boolean.", coll_op.error());
+}
+
+TEST_F(CollectionVectorTest, FilteredSearchAdaptsToSelectivity) {
+    hnsw_index_t hnsw_index(8, 1024, cosine);
+
+    std::mt19937 rng(3);
+    std::normal_distribution<float> value_dist(0, 1);
+
+    for(size_t i = 0; i < 1000; i++) {
+        std::vector<float> values(8);
+        for(auto& value: values) {
+            value = value_dist(rng);
+        }
+
+        hnsw_index.add_point(values.data(), i);
+    }
+
+    // a few points are cheaper to score than to find in the graph
+    ASSERT_TRUE(hnsw_index.prefer_flat_search(10, 10, 10));
+    ASSERT_FALSE(hnsw_index.prefer_flat_search(900, 10, 10));
+    ASSERT_FALSE(hnsw_index.prefer_flat_search(1000, 10, 10));
+
+    // walks that keep fewer points look at more of them, up to a limit
+    ASSERT_EQ(10, hnsw_index.get_filtered_ef(1000, 10, 10));
+    ASSERT_EQ(100, hnsw_index.get_filtered_ef(100, 10, 10));
+    ASSERT_EQ(10 * hnsw_index_t::MAX_FILTERED_EF_FACTOR, hnsw_index.get_filtered_ef(1, 10, 10));
+    ASSERT_EQ(40, hnsw_index.get_filtered_ef(500, 10, 20));
+
+    nlohmann::json schema = R"({
+        "name": "coll1",
+        "fields": [
+            {"name": "points", "type": "int32"},
+            {"name": "vec", "type": "float[]", "num_dim": 8}
+        ]
+    })"_json;
+
+    Collection* coll1 = collectionManager.create_collection(schema).get();
+
+    std::vector<std::vector<float>> vectors;
+    for(size_t i = 0; i < 500; i++) {
+        std::vector<float> values(8);
+        for(auto& value: values) {
+            value = value_dist(rng);
+        }
+
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["points"] = i;
+        doc["vec"] = values;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+        vectors.push_back(values);
+    }
+
+    std::vector<float> query(8);
+    for(auto& value: query) {
+        value = value_dist(rng);
+    }
+
+    std::vector<float> normalized_query(8);
+    hnsw_index_t::normalize_vector(query, normalized_query);
+
+    // nearest of the filtered documents, by brute force
+    std::vector<std::pair<float, size_t>> expected;
+    for(size_t i = 0; i < 12; i++) {
+        std::vector<float> normalized(8);
+        hnsw_index_t::normalize_vector(vectors[i], normalized);
+
+        float dot = 0;
+        for(size_t j = 0; j < 8; j++) {
+            dot += normalized[j] * normalized_query[j];
+        }
+
+        expected.emplace_back(1 - dot, i);
+    }
+
+    std::sort(expected.begin(), expected.end());
+
+    auto results = coll1->search("*", {}, "points:< 12", {}, {}, {0}, 10, 1, FREQUENCY, {true}, Index::DROP_TOKENS_THRESHOLD,
+                                 spp::sparse_hash_set<std::string>(),
+                                 spp::sparse_hash_set<std::string>(), 10, "", 30, 5,
+                                 "", 10, {}, {}, {}, 0,
+                                 "<mark>", "</mark>", {}, 1000, true, false, true, "", false, 6000 * 1000, 4, 7, fallback,
+                                 4, {off}, 32767, 32767, 2,
+                                 false, true, "vec:(" + nlohmann::json(query).dump() + ", k: 5)").get();
+
+    // as many results as a walk finds, which are the exact nearest ones
+    ASSERT_EQ(5, results["hits"].size());
+    for(size_t i = 0; i < 5; i++) {
+        ASSERT_EQ(std::to_string(expected[i].second), results["hits"][i]["document"]["id"].get<std::string>());
+        ASSERT_NEAR(expected[i].first, results["hits"][i]["vector_distance"].get<float>(), 1e-5);
+    }
+}
+
 TEST_F(CollectionVectorTest, VectorUnchangedUpsert) {
     nlohmann::json schema = R"({
             "name": "coll1",
@@ -934,7 +1430,8 @@ TEST_F(CollectionVectorTest, VectorSearchTestDeletion) {
         ASSERT_TRUE(coll1->add(doc.dump()).ok());
     }
 
-    ASSERT_EQ(1024, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getMaxElements());
+    // the graph has grown from its initial capacity by a fraction of its size
+    ASSERT_EQ(22, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getMaxElements());
     ASSERT_EQ(20, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getCurrentElementCount());
     ASSERT_EQ(0, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getDeletedCount());
 
@@ -944,7 +1441,7 @@ TEST_F(CollectionVectorTest, VectorSearchTestDeletion) {
         ASSERT_TRUE(coll1->remove(std::to_string(i)).ok());
     }
 
-    ASSERT_EQ(1024, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getMaxElements());
+    ASSERT_EQ(22, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getMaxElements());
     ASSERT_EQ(20, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getCurrentElementCount());
     ASSERT_EQ(20, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getDeletedCount());
 
@@ -963,16 +1460,16 @@ TEST_F(CollectionVectorTest, VectorSearchTestDeletion) {
         ASSERT_TRUE(coll1->add(doc.dump()).ok());
     }
 
-    ASSERT_EQ(1024, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getMaxElements());
+    ASSERT_EQ(22, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getMaxElements());
     ASSERT_EQ(20, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getCurrentElementCount());
     ASSERT_EQ(0, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getDeletedCount());
 
-    // delete those docs again and ensure that while reindexing till 1024 live docs, max count is not changed
+    // delete those docs again and ensure that the deleted points are replaced before the graph grows again
     for (size_t i = 0; i < num_docs; i++) {
         ASSERT_TRUE(coll1->remove(std::to_string(i + num_docs)).ok());
     }
 
-    ASSERT_EQ(1024, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getMaxElements());
+    ASSERT_EQ(22, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getMaxElements());
     ASSERT_EQ(20, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getCurrentElementCount());
     ASSERT_EQ(20, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getDeletedCount());
 
@@ -995,7 +1492,7 @@ TEST_F(CollectionVectorTest, VectorSearchTestDeletion) {
         ASSERT_TRUE(add_op.ok());
     }
 
-    ASSERT_EQ(1024, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getMaxElements());
+    ASSERT_EQ(1271, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getMaxElements());
     ASSERT_EQ(1014, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getCurrentElementCount());
     ASSERT_EQ(0, coll1->_get_index()->_get_vector_index().at("vec")->vecdex->getDeletedCount());
 }
@@ -3857,6 +4354,52 @@ TEST_F(CollectionVectorTest, TestInvalidVoiceQuery) {
     ASSERT_EQ("Invalid audio format. Please provide a 16-bit 16kHz wav file.", results.error());
 }
 
+class CountingVQModel : public VQModel {
+public:
+    size_t num_calls = 0;
+
+    CountingVQModel(): VQModel("counting") {}
+
+protected:
+    Option<std::string> transcribe_audio(const std::string& audio_base64) override {
+        num_calls++;
+        if(audio_base64 == "invalid") {
+            return Option<std::string>(400, "Invalid audio format. Please provide a 16-bit 16kHz wav file.");
+        }
+
+        return Option<std::string>("text of " + audio_base64);
+    }
+};
+
+TEST_F(CollectionVectorTest, TestVoiceQueryTranscriptionCache) {
+    CountingVQModel model;
+
+    auto transcribe_op = model.transcribe("audio1");
+    ASSERT_TRUE(transcribe_op.ok());
+    ASSERT_EQ("text of audio1", transcribe_op.get());
+
+    transcribe_op = model.transcribe("audio1");
+    ASSERT_TRUE(transcribe_op.ok());
+    ASSERT_EQ("text of audio1", transcribe_op.get());
+    ASSERT_EQ(1, model.num_calls);
+
+    transcribe_op = model.transcribe("audio2");
+    ASSERT_TRUE(transcribe_op.ok());
+    ASSERT_EQ("text of audio2", transcribe_op.get());
+    ASSERT_EQ(2, model.num_calls);
+
+    // failures are not cached
+    ASSERT_FALSE(model.transcribe("invalid").ok());
+    ASSERT_FALSE(model.transcribe("invalid").ok());
+    ASSERT_EQ(4, model.num_calls);
+
+    VQModel::metrics_t metrics;
+    model.add_metrics(metrics);
+    ASSERT_EQ(1, metrics.cache_hits);
+    ASSERT_EQ(0, metrics.queued);
+    ASSERT_EQ(0, metrics.running);
+}
+
 TEST_F(CollectionVectorTest, TestInvalidHNSWParams) {
     nlohmann::json schema_json = R"({
         "name": "test",
@@ -4421,6 +4964,39 @@ TEST_F(CollectionVectorTest, TestCFModelResponseParsing) {
     ASSERT_EQ("00,\n\"publishDateYear\": 2011,\n\"title\": \"SOPA\",\n\"topics\": [\n\"Links to xkcd.com\",\n\"April fools' comics\",\n\"Interactive comics\",\n\"Comics with animation\",\n\"Dynamic comics\",\n\"Comics with audio\"\n ],\n\"transcript\": \" \"\n},\n{\n\"altTitle\": \"I'm currently getting totally blacked out.\",\n\"id\": \"1006\",\n\"imageUrl\": \"https://imgs.xkcd.com/comics/blackout.png\",\n\"publishDateDay\": 18,\n\"publishDateMonth\": 1,\n\"publishDateTimestamp\": 1326866400,\n\"publishDateYear\": 2011,\n\"title\": \"Blackout\",\n\"topics\": [\n\"Links to xkcd.com\",\n\"April fools' comics\",\n\"Interactive comics\",\n\"Comics with animation\",\n\"Dynamic comics\",\n\"Comics with audio\"\n ],\n\"", parsed_string.get());
 }
 
+TEST_F(CollectionVectorTest, TestParseStreamEventsAcrossChunks) {
+    std::string buffer;
+    std::vector<std::string> data;
+    auto on_data = [&](const std::string& event_data) {
+        data.push_back(event_data);
+        return true;
+    };
+
+    // events are split at arbitrary points by the chunks of the response
+    ASSERT_TRUE(ConversationModel::parse_stream_events(buffer, "data: {\"response\":\"Hel", on_data));
+    ASSERT_TRUE(data.empty());
+
+    ASSERT_TRUE(ConversationModel::parse_stream_events(buffer, "lo\"}\n\ndata: {\"response\":\" there\"}\r\n\r\n", on_data));
+    ASSERT_EQ(2, data.size());
+    ASSERT_EQ("{\"response\":\"Hello\"}", data[0]);
+    ASSERT_EQ("{\"response\":\" there\"}", data[1]);
+
+    ASSERT_TRUE(ConversationModel::parse_stream_events(buffer, ": keep-alive\n\ndata: [DONE]\n\n", on_data));
+    ASSERT_EQ(2, data.size());
+    ASSERT_TRUE(buffer.empty());
+
+    // the stream is stopped by the receiver
+    data.clear();
+    auto stop_on_data = [&](const std::string& event_data) {
+        data.push_back(event_data);
+        return false;
+    };
+
+    ASSERT_FALSE(ConversationModel::parse_stream_events(buffer, "data: 1\n\ndata: 2\n\n", stop_on_data));
+    ASSERT_EQ(1, data.size());
+    ASSERT_EQ("1", data[0]);
+}
+
 TEST_F(CollectionVectorTest, TestInvalidOpenAIURL) {
     nlohmann::json schema_json = R"({
         "name": "test",
@@ -150,6 +150,70 @@ TEST_F(ConversationTest, TruncateConversationInvalidLimit) {
     ASSERT_EQ(truncated.error(), "Limit must be positive integer");
 }
 
+TEST_F(ConversationTest, TruncateConversationMatchesPoppingMessages) {
+    nlohmann::json conversation = nlohmann::json::array();
+    for(int i = 0; i < 50; i++) {
+        nlohmann::json message = nlohmann::json::object();
+        message[i % 2 == 0 ? "user" : "assistant"] = std::string(i % 7 + 1, 'a') + "\"\n";
+        conversation.push_back(message);
+    }
+
+    for(size_t limit: {1, 2, 3, 20, 21, 22, 23, 100, 357, 1000, 10000}) {
+        nlohmann::json popped = conversation;
+        bool popped_ok = true;
+        while(popped.dump(0).size() > limit) {
+            if(popped.empty()) {
+                popped_ok = false;
+                break;
+            }
+            popped.erase(0);
+        }
+
+        auto truncated = ConversationManager::get_instance().truncate_conversation(conversation, limit);
+        ASSERT_EQ(popped_ok, truncated.ok());
+        if(popped_ok) {
+            ASSERT_EQ(popped, truncated.get());
+        }
+    }
+}
+
+TEST_F(ConversationTest, GetConversationWindow) {
+    nlohmann::json conversation = nlohmann::json::array();
+    nlohmann::json message = nlohmann::json::object();
+    message["user"] = "Hello";
+    conversation.push_back(message);
+    auto create_res = ConversationManager::get_instance().create_conversation(conversation);
+    ASSERT_TRUE(create_res.ok());
+    std::string conversation_id = create_res.get();
+
+    for(int i = 0; i < 20; i++) {
+        nlohmann::json messages = nlohmann::json::array();
+        messages.push_back(nlohmann::json::object({{"user", "Question " + std::to_string(i)}}));
+        messages.push_back(nlohmann::json::object({{"assistant", "Answer " + std::to_string(i)}}));
+        ASSERT_TRUE(ConversationManager::get_instance().append_conversation(conversation_id, messages).ok());
+    }
+
+    auto full_conversation = ConversationManager::get_instance().get_conversation(conversation_id).get()["conversation"];
+    ASSERT_EQ(41, full_conversation.size());
+
+    for(size_t limit: {2, 50, 200, 100000}) {
+        auto window = ConversationManager::get_instance().get_conversation_window(conversation_id, limit);
+        ASSERT_TRUE(window.ok());
+        ASSERT_EQ(ConversationManager::get_instance().truncate_conversation(full_conversation, limit).get(), window.get());
+    }
+
+    auto window = ConversationManager::get_instance().get_conversation_window(conversation_id, 100000);
+    ASSERT_EQ(41, window.get().size());
+    ASSERT_EQ("Answer 19", window.get()[40]["assistant"]);
+
+    window = ConversationManager::get_instance().get_conversation_window(conversation_id, 2);
+    ASSERT_EQ(0, window.get().size());
+
+    auto invalid_window = ConversationManager::get_instance().get_conversation_window("qwerty", 100);
+    ASSERT_FALSE(invalid_window.ok());
+    ASSERT_EQ(404, invalid_window.code());
+}
+
 TEST_F(ConversationTest, TestConversationExpire) {
     nlohmann::json conversation = nlohmann::json::array();
     nlohmann::json message = nlohmann::json::object();
@@ -1603,6 +1603,7 @@ TEST_F(CoreAPIUtilsTest, CollectionsPagination) {
           ],
           "name":"cp2",
           "num_documents":0,
+          "storage_format":"json",
           "symbols_to_index":[],
           "token_separators":[]
         }
@@ -1758,4 +1759,392 @@ TEST_F(CoreAPIUtilsTest, SynonymsPagination) {
     get_collections(req, resp);
     ASSERT_EQ(400, resp->status_code);
     ASSERT_EQ("{\"message\": \"Limit param should be unsigned integer.\"}", resp->body);
-}
\ No newline at end of file
+}
+
+TEST_F(CoreAPIUtilsTest, CoalescedDocumentWrites) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll_coalesced", 1, fields, "points").get();
+    ASSERT_NE(nullptr, coll1);
+
+    std::vector<std::string> bodies = {
+        R"({"id": "0", "title": "Title 0", "points": 0})",
+        R"({"id": "1", "title": "Title 1", "points": 1})",
+        R"({"id": "0", "title": "Title 0 again", "points": 2})",
+        R"({"id": "2", "title": "Title 2"})",
+        R"({"id": "3", "title": )",
+    };
+
+    std::vector<std::shared_ptr<http_req>> reqs;
+    std::vector<std::shared_ptr<http_res>> res_vec;
+
+    for(const auto& body: bodies) {
+        std::shared_ptr<http_req> req = std::make_shared<http_req>();
+        req->params["collection"] = "coll_coalesced";
+        req->body = body;
+        reqs.push_back(req);
+        res_vec.push_back(std::make_shared<http_res>(nullptr));
+    }
+
+    add_coalesced_documents(reqs, res_vec);
+
+    ASSERT_EQ(201, res_vec[0]->status_code);
+    ASSERT_EQ(R"({"id":"0","points":0,"title":"Title 0"})", res_vec[0]->body);
+    ASSERT_EQ(201, res_vec[1]->status_code);
+    ASSERT_EQ(R"({"id":"1","points":1,"title":"Title 1"})", res_vec[1]->body);
+
+    // the responses match those of the requests being written one by one
+    ASSERT_EQ(409, res_vec[2]->status_code);
+    ASSERT_EQ(R"({"message":"A document with id 0 already exists."})", res_vec[2]->body);
+    ASSERT_EQ(400, res_vec[3]->status_code);
+    ASSERT_EQ(R"({"message":"Field `points` has been declared as a default sorting field, but is not found in the document."})",
+              res_vec[3]->body);
+    ASSERT_EQ(400, res_vec[4]->status_code);
+
+    ASSERT_EQ(2, coll1->get_num_documents());
+    ASSERT_EQ("Title 0", coll1->get("0").get()["title"].get<std::string>());
+
+    // a missing collection fails every request
+    for(auto& req: reqs) {
+        req->params["collection"] = "coll_missing";
+    }
+
+    add_coalesced_documents(reqs, res_vec);
+
+    for(const auto& res: res_vec) {
+        ASSERT_EQ(404, res->status_code);
+    }
+
+    collectionManager.drop_collection("coll_coalesced");
+}
+
+TEST_F(CoreAPIUtilsTest, SearchResultsAsMessagePack) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    nlohmann::json doc;
+    doc["title"] = "The Adventures of Tom Sawyer";
+    doc["points"] = 10;
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    std::shared_ptr<http_req> req = std::make_shared<http_req>();
+    std::shared_ptr<http_res> res = std::make_shared<http_res>(nullptr);
+    req->params["collection"] = "coll1";
+    req->params["q"] = "sawyer";
+    req->params["query_by"] = "title";
+    req->embedded_params_vec.push_back(nlohmann::json::object());
+
+    ASSERT_TRUE(get_search(req, res));
+    ASSERT_EQ("application/json; charset=utf-8", res->content_type_header);
+    ASSERT_EQ(1, nlohmann::json::parse(res->body)["found"].get<size_t>());
+
+    req->params[http_req::ACCEPT_HEADER] = "application/msgpack";
+    res = std::make_shared<http_res>(nullptr);
+
+    ASSERT_TRUE(get_search(req, res));
+    ASSERT_EQ("application/msgpack", res->content_type_header);
+
+    auto res_json = nlohmann::json::from_msgpack(res->body);
+    ASSERT_EQ(1, res_json["found"].get<size_t>());
+    ASSERT_EQ("The Adventures of Tom Sawyer", res_json["hits"][0]["document"]["title"]);
+
+    // multi search results are encoded the same way
+    req->params.clear();
+    req->params[http_req::ACCEPT_HEADER] = "application/msgpack";
+    req->body = R"({"searches":[{"collection":"coll1","q":"sawyer","query_by":"title"}]})";
+    res = std::make_shared<http_res>(nullptr);
+
+    post_multi_search(req, res);
+    ASSERT_EQ("application/msgpack", res->content_type_header);
+    res_json = nlohmann::json::from_msgpack(res->body);
+    ASSERT_EQ(1, res_json["results"][0]["found"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CoreAPIUtilsTest, MultiSearchResultsInOrder) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 20; i++) {
+        nlohmann::json doc;
+        doc["title"] = "Title " + std::to_string(i);
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    std::shared_ptr<http_req> req = std::make_shared<http_req>();
+    std::shared_ptr<http_res> res = std::make_shared<http_res>(nullptr);
+
+    // more searches than run at the same time, with a failing search in between
+    nlohmann::json body;
+    body["searches"] = nlohmann::json::array();
+    for(size_t i = 0; i < 10; i++) {
+        nlohmann::json search;
+        search["collection"] = (i == 5) ? "unknown" : "coll1";
+        search["q"] = "*";
+        search["filter_by"] = "points:>=" + std::to_string(i);
+        body["searches"].push_back(search);
+        req->embedded_params_vec.push_back(nlohmann::json::object());
+    }
+
+    req->body = body.dump();
+    post_multi_search(req, res);
+
+    auto res_json = nlohmann::json::parse(res->body);
+    ASSERT_EQ(10, res_json["results"].size());
+
+    for(size_t i = 0; i < 10; i++) {
+        if(i == 5) {
+            ASSERT_EQ(404, res_json["results"][i]["code"].get<size_t>());
+            continue;
+        }
+
+        ASSERT_EQ(20 - i, res_json["results"][i]["found"].get<size_t>());
+    }
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CoreAPIUtilsTest, MultiSearchSharesSearchesDifferingInFacets) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("brand", field_types::STRING, true),
+                                 field("color", field_types::STRING, true),
+                                 field("points", field_types::INT32, true),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 20; i++) {
+        nlohmann::json doc;
+        doc["title"] = "Shoe " + std::to_string(i);
+        doc["brand"] = (i % 2 == 0) ? "nike" : "puma";
+        doc["color"] = (i % 4 == 0) ? "red" : "blue";
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    std::shared_ptr<http_req> req = std::make_shared<http_req>();
+    std::shared_ptr<http_res> res = std::make_shared<http_res>(nullptr);
+
+    req->body = R"({"searches":[
+        {"collection":"coll1", "q":"shoe", "query_by":"title", "filter_by":"points:>=4", "per_page": 5},
+        {"collection":"coll1", "q":"shoe", "query_by":"title", "filter_by":"points:>=4", "per_page": 0,
+         "facet_by": "brand"},
+        {"collection":"coll1", "q":"shoe", "query_by":"title", "filter_by":"points:>=4", "per_page": 0,
+         "facet_by": "color, points(low:[0, 10], high:[10, 20])"},
+        {"collection":"coll1", "q":"shoe", "query_by":"title", "filter_by":"points:>=4", "page": 2,
+         "facet_by": "brand"}
+    ]})";
+
+    for(size_t i = 0; i < 4; i++) {
+        req->embedded_params_vec.push_back(nlohmann::json::object());
+    }
+
+    post_multi_search(req, res);
+
+    auto res_json = nlohmann::json::parse(res->body);
+    ASSERT_EQ(4, res_json["results"].size());
+
+    const auto& hits_result = res_json["results"][0];
+    ASSERT_EQ(16, hits_result["found"].get<size_t>());
+    ASSERT_EQ(5, hits_result["hits"].size());
+    ASSERT_EQ(5, hits_result["request_params"]["per_page"].get<size_t>());
+    ASSERT_EQ(0, hits_result["facet_counts"].size());
+
+    const auto& brand_result = res_json["results"][1];
+    ASSERT_EQ(16, brand_result["found"].get<size_t>());
+    ASSERT_EQ(0, brand_result["hits"].size());
+    ASSERT_EQ(1, brand_result["facet_counts"].size());
+    ASSERT_EQ("brand", brand_result["facet_counts"][0]["field_name"]);
+    ASSERT_EQ(8, brand_result["facet_counts"][0]["counts"][0]["count"].get<size_t>());
+
+    const auto& color_result = res_json["results"][2];
+    ASSERT_EQ(2, color_result["facet_counts"].size());
+    ASSERT_EQ("color", color_result["facet_counts"][0]["field_name"]);
+    ASSERT_EQ("points", color_result["facet_counts"][1]["field_name"]);
+
+    // a later page is searched on its own
+    const auto& page_result = res_json["results"][3];
+    ASSERT_EQ(2, page_result["page"].get<size_t>());
+    ASSERT_EQ(6, page_result["hits"].size());
+    ASSERT_EQ(1, page_result["facet_counts"].size());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CoreAPIUtilsTest, SearchHitsStreamedInBatches) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 250; i++) {
+        nlohmann::json doc;
+        doc["title"] = "Title " + std::to_string(i);
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    std::shared_ptr<http_req> req = std::make_shared<http_req>();
+    std::shared_ptr<http_res> res = std::make_shared<http_res>(nullptr);
+    req->params["collection"] = "coll1";
+    req->params["q"] = "*";
+    req->params["per_page"] = "250";
+    req->embedded_params_vec.push_back(nlohmann::json::object());
+
+    // every call of the handler sends the next batch of hits
+    std::string body;
+    size_t num_chunks = 0;
+
+    while(true) {
+        ASSERT_TRUE(get_search(req, res));
+        body += res->body;
+        num_chunks++;
+
+        if(res->final) {
+            break;
+        }
+    }
+
+    ASSERT_EQ(3, num_chunks);
+
+    auto res_json = nlohmann::json::parse(body);
+    ASSERT_EQ(250, res_json["found"].get<size_t>());
+    ASSERT_EQ(250, res_json["hits"].size());
+    ASSERT_EQ("Title 249", res_json["hits"][0]["document"]["title"]);
+    ASSERT_EQ("Title 0", res_json["hits"][249]["document"]["title"]);
+    ASSERT_EQ(1, res_json["page"].get<size_t>());
+
+    // a page that fits in a single batch is sent whole
+    req = std::make_shared<http_req>();
+    res = std::make_shared<http_res>(nullptr);
+    req->params["collection"] = "coll1";
+    req->params["q"] = "*";
+    req->params["per_page"] = "100";
+    req->embedded_params_vec.push_back(nlohmann::json::object());
+
+    ASSERT_TRUE(get_search(req, res));
+    ASSERT_TRUE(res->final);
+    ASSERT_EQ(100, nlohmann::json::parse(res->body)["hits"].size());
+
+    collectionManager.drop_collection("coll1");
+}
+
+static std::string gunzip(const std::string& compressed) {
+    z_stream zs = {};
+    inflateInit2(&zs, 15 + 16);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    zs.avail_in = compressed.size();
+
+    std::string uncompressed;
+    char out_buffer[16384];
+    int ret;
+
+    do {
+        zs.next_out = reinterpret_cast<Bytef*>(out_buffer);
+        zs.avail_out = sizeof(out_buffer);
+        ret = inflate(&zs, Z_NO_FLUSH);
+        uncompressed.append(out_buffer, sizeof(out_buffer) - zs.avail_out);
+    } while(ret == Z_OK);
+
+    inflateEnd(&zs);
+    return uncompressed;
+}
+
+TEST_F(CoreAPIUtilsTest, ParallelCompressedExport) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    for(size_t i = 0; i < 250; i++) {
+        nlohmann::json doc;
+        doc["title"] = "Title " + std::to_string(i);
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    auto export_docs = [&](const std::map<std::string, std::string>& params) {
+        std::shared_ptr<http_req> req = std::make_shared<http_req>();
+        std::shared_ptr<http_res> res = std::make_shared<http_res>(nullptr);
+        req->params = params;
+        req->params["collection"] = "coll1";
+
+        // every call of the handler sends the next batch of documents
+        std::string body;
+        do {
+            get_export_documents(req, res);
+            body += res->body;
+        } while(!res->final);
+
+        return body;
+    };
+
+    const std::string& plain_export = export_docs({{"batch_size", "100"}});
+
+    std::vector<std::string> lines;
+    StringUtils::split(plain_export, lines, "\n");
+    ASSERT_EQ(250, lines.size());
+    ASSERT_EQ("Title 0", nlohmann::json::parse(lines[0])["title"]);
+    ASSERT_EQ("Title 249", nlohmann::json::parse(lines[249])["title"]);
+
+    ASSERT_EQ(plain_export, export_docs({{"batch_size", "100"}, {"parallelism", "4"}}));
+    ASSERT_EQ(plain_export, gunzip(export_docs({{"batch_size", "100"}, {"parallelism", "4"}, {"compress", "true"}})));
+
+    // filtered export
+    const std::string& filtered_export = export_docs({{"batch_size", "30"}, {"filter_by", "points:<100"}});
+    lines.clear();
+    StringUtils::split(filtered_export, lines, "\n");
+    ASSERT_EQ(100, lines.size());
+
+    ASSERT_EQ(filtered_export, gunzip(export_docs({{"batch_size", "30"}, {"filter_by", "points:<100"},
+                                                   {"parallelism", "3"}, {"compress", "true"}})));
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CoreAPIUtilsTest, SwapAliasDropsPreviousCollection) {
+    std::vector<field> fields = {field("title", field_types::STRING, false)};
+
+    for(const std::string& coll_name: {"products_v1", "products_v2"}) {
+        auto coll = collectionManager.create_collection(coll_name, 1, fields).get();
+        nlohmann::json doc;
+        doc["title"] = "Title of " + coll_name;
+        ASSERT_TRUE(coll->add(doc.dump()).ok());
+    }
+
+    ASSERT_TRUE(collectionManager.upsert_symlink("products", "products_v1").ok());
+
+    std::shared_ptr<http_req> req = std::make_shared<http_req>();
+    std::shared_ptr<http_res> res = std::make_shared<http_res>(nullptr);
+    req->params["alias"] = "products";
+
+    req->body = R"({"collection_name": "products_v2", "drop_previous": "true"})";
+    ASSERT_FALSE(put_upsert_alias(req, res));
+    ASSERT_EQ(400, res->status_code);
+
+    req->body = R"({"collection_name": "products_v3", "drop_previous": true})";
+    ASSERT_FALSE(put_upsert_alias(req, res));
+    ASSERT_EQ(400, res->status_code);
+    ASSERT_EQ("products_v1", collectionManager.resolve_symlink("products").get());
+
+    req->body = R"({"collection_name": "products_v2", "drop_previous": true})";
+    ASSERT_TRUE(put_upsert_alias(req, res));
+    ASSERT_EQ(200, res->status_code);
+
+    ASSERT_EQ("products_v2", collectionManager.resolve_symlink("products").get());
+    ASSERT_TRUE(collectionManager.get_collection("products_v1") == nullptr);
+    ASSERT_FALSE(collectionManager.get_collection("products_v2") == nullptr);
+
+    // the dropped collection is deleted in the background, but its name can be reused right away
+    auto coll_op = collectionManager.create_collection("products_v1", 1, fields);
+    ASSERT_TRUE(coll_op.ok());
+    ASSERT_EQ(0, coll_op.get()->get_num_documents());
+
+    collectionManager.wait_for_drops();
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "cpu_profiler.h"
+
+TEST(CpuProfilerTest, FoldStacks) {
+    // frames are captured from the leaf
+    std::vector<std::vector<std::string>> stacks = {
+        {"search", "handle", "main"},
+        {"search", "handle", "main"},
+        {"index", "handle", "main"},
+        {"f(a;b)", "main"},
+    };
+
+    ASSERT_EQ("main;f(a:b) 1\n"
+              "main;handle;index 1\n"
+              "main;handle;search 2\n", CpuProfiler::fold_stacks(stacks));
+}
+
+TEST(CpuProfilerTest, ProfileBusyThread) {
+    auto profile_op = CpuProfiler::get_instance().profile(0, 100);
+    ASSERT_FALSE(profile_op.ok());
+    ASSERT_EQ(400, profile_op.code());
+
+    profile_op = CpuProfiler::get_instance().profile(1, 5000);
+    ASSERT_FALSE(profile_op.ok());
+    ASSERT_EQ(400, profile_op.code());
+
+    std::atomic<bool> quit = false;
+    std::atomic<uint64_t> sum = 0;
+    std::thread busy_thread([&]() {
+        uint64_t local_sum = 0;
+        while(!quit) {
+            local_sum++;
+        }
+        sum = local_sum;
+    });
+
+    profile_op = CpuProfiler::get_instance().profile(1, 500);
+    quit = true;
+    busy_thread.join();
+
+    ASSERT_TRUE(profile_op.ok());
+    ASSERT_FALSE(profile_op.get().empty());
+
+    // every line ends with a count
+    const std::string& profile = profile_op.get();
+    ASSERT_EQ('\n', profile.back());
+    ASSERT_TRUE(isdigit(profile[profile.size() - 2]));
+}
@@ -1,61 +1,186 @@
 #include <gtest/gtest.h>
 #include <cvt.h>
+#include <map>
+#include <random>
+
+static std::vector<std::string> prefix_keys(const CVTrie& trie, const std::string& prefix) {
+    std::vector<std::string> keys;
+    trie.iter_prefix(prefix.c_str(), prefix.size(), [&keys](const std::string& key, void* value) {
+        keys.push_back(key);
+        return true;
+    });
+    return keys;
+}
 
-/*
-TEST(CVTTest, TaggedPointers) {
-    CVTrie trie;
-    uint8_t* bytes = new uint8_t[3];
-    bytes[0] = 0;
-    bytes[1] = 1;
-    bytes[2] = 2;
+static std::vector<std::string> fuzzy_keys(const CVTrie& trie, const std::string& term, int max_cost, bool prefix,
+                                           size_t max_words = 100) {
+    std::vector<std::pair<std::string, void*>> results;
+    trie.fuzzy_search(term.c_str(), term.size(), 0, max_cost, prefix, max_words, results);
 
-    // LEAF
+    std::vector<std::string> keys;
+    for(const auto& result: results) {
+        keys.push_back(result.first);
+    }
+    return keys;
+}
 
-    void* leaf_tagged_ptr = trie.tag_ptr(bytes, 100, LEAF);
-    ASSERT_EQ(LEAF, trie.get_node_type(leaf_tagged_ptr));
-    ASSERT_EQ(100, trie.get_offset(leaf_tagged_ptr));
+TEST(CVTTest, AddFindRemove) {
+    CVTrie trie;
+    std::vector<std::string> keys = {"ates", "at", "as", "but", "tok", "too", "a", "tea"};
+    std::vector<size_t> values(keys.size());
 
-    uint8_t* leaf_data = static_cast<uint8_t *>(trie.get_ptr(leaf_tagged_ptr));
+    ASSERT_EQ(nullptr, trie.find("foo", 3));
+    ASSERT_EQ(nullptr, trie.remove("foo", 3));
 
-    ASSERT_EQ(0, leaf_data[0]);
-    ASSERT_EQ(1, leaf_data[1]);
-    ASSERT_EQ(2, leaf_data[2]);
+    for(size_t i = 0; i < keys.size(); i++) {
+        values[i] = i;
+        ASSERT_TRUE(trie.add(keys[i].c_str(), keys[i].size(), &values[i]));
+    }
 
-    // INTERNAL
+    ASSERT_EQ(keys.size(), trie.size());
 
-    void* internal_tagged_ptr = trie.tag_ptr(bytes, 100, INTERNAL);
-    ASSERT_EQ(INTERNAL, trie.get_node_type(internal_tagged_ptr));
-    ASSERT_EQ(100, trie.get_offset(internal_tagged_ptr));
+    for(size_t i = 0; i < keys.size(); i++) {
+        ASSERT_EQ(&values[i], trie.find(keys[i].c_str(), keys[i].size()));
+    }
 
-    uint8_t* internal_data = static_cast<uint8_t *>(trie.get_ptr(internal_tagged_ptr));
+    ASSERT_EQ(nullptr, trie.find("t", 1));
+    ASSERT_EQ(nullptr, trie.find("ate", 3));
+    ASSERT_EQ(nullptr, trie.find("atess", 5));
+    ASSERT_EQ(nullptr, trie.find("", 0));
 
-    ASSERT_EQ(0, internal_data[0]);
-    ASSERT_EQ(1, internal_data[1]);
-    ASSERT_EQ(2, internal_data[2]);
+    // replaces the value
+    size_t other_value = 100;
+    ASSERT_FALSE(trie.add("at", 2, &other_value));
+    ASSERT_EQ(&other_value, trie.find("at", 2));
+    ASSERT_EQ(keys.size(), trie.size());
 
-    // COMPRESSED
+    ASSERT_EQ(&other_value, trie.remove("at", 2));
+    ASSERT_EQ(nullptr, trie.find("at", 2));
+    ASSERT_EQ(&values[0], trie.find("ates", 4));
 
-    void* compressed_tagged_ptr = trie.tag_ptr(bytes, 100, COMPRESSED);
-    ASSERT_EQ(COMPRESSED, trie.get_node_type(compressed_tagged_ptr));
-    ASSERT_EQ(100, trie.get_offset(compressed_tagged_ptr));
+    ASSERT_EQ(&values[3], trie.remove("but", 3));
+    ASSERT_EQ(nullptr, trie.remove("but", 3));
+    ASSERT_EQ(nullptr, trie.remove("t", 1));
+    ASSERT_EQ(keys.size() - 2, trie.size());
 
-    uint8_t* compressed_data = static_cast<uint8_t *>(trie.get_ptr(compressed_tagged_ptr));
+    for(const auto& key: keys) {
+        trie.remove(key.c_str(), key.size());
+    }
 
-    ASSERT_EQ(0, compressed_data[0]);
-    ASSERT_EQ(1, compressed_data[1]);
-    ASSERT_EQ(2, compressed_data[2]);
+    ASSERT_EQ(0, trie.size());
+    ASSERT_EQ(0, trie.memory_used());
+}
 
-    delete [] bytes;
+TEST(CVTTest, LongKeys) {
+    CVTrie trie;
+    const std::string long_key(700, 'x');
+    const std::string other_long_key = long_key + "y";
+    size_t value = 1, other_value = 2;
+
+    ASSERT_TRUE(trie.add(long_key.c_str(), long_key.size(), &value));
+    ASSERT_TRUE(trie.add(other_long_key.c_str(), other_long_key.size(), &other_value));
+    ASSERT_EQ(&value, trie.find(long_key.c_str(), long_key.size()));
+    ASSERT_EQ(&other_value, trie.find(other_long_key.c_str(), other_long_key.size()));
+    ASSERT_EQ(nullptr, trie.find(long_key.c_str(), 300));
+
+    ASSERT_EQ(&value, trie.remove(long_key.c_str(), long_key.size()));
+    ASSERT_EQ(&other_value, trie.find(other_long_key.c_str(), other_long_key.size()));
+    ASSERT_EQ(&other_value, trie.remove(other_long_key.c_str(), other_long_key.size()));
+    ASSERT_EQ(0, trie.memory_used());
 }
 
-TEST(CVTTest, AddSingleLeaf) {
+TEST(CVTTest, PrefixIteration) {
     CVTrie trie;
+    size_t value = 0;
+
+    for(const std::string key: {"tok", "ates", "too", "as", "at", "but", "toolbox", "tool"}) {
+        trie.add(key.c_str(), key.size(), &value);
+    }
+
+    ASSERT_EQ(std::vector<std::string>({"as", "at", "ates", "but", "tok", "too", "tool", "toolbox"}),
+              prefix_keys(trie, ""));
+    ASSERT_EQ(std::vector<std::string>({"as", "at", "ates"}), prefix_keys(trie, "a"));
+    ASSERT_EQ(std::vector<std::string>({"tok", "too", "tool", "toolbox"}), prefix_keys(trie, "to"));
+    ASSERT_EQ(std::vector<std::string>({"tool", "toolbox"}), prefix_keys(trie, "tool"));
+    ASSERT_EQ(std::vector<std::string>({"toolbox"}), prefix_keys(trie, "toolb"));
+    ASSERT_TRUE(prefix_keys(trie, "toolboxes").empty());
+    ASSERT_TRUE(prefix_keys(trie, "x").empty());
+
+    // stops when the callback returns false
+    size_t num_calls = 0;
+    trie.iter_prefix("", 0, [&num_calls](const std::string& key, void* value) {
+        return ++num_calls < 2;
+    });
+    ASSERT_EQ(2, num_calls);
+}
 
-    cvt_leaf_t leaf{108};
-    ASSERT_TRUE(trie.add("foo", 3, &leaf));
+TEST(CVTTest, FuzzySearch) {
+    CVTrie trie;
+    size_t value = 0;
 
-    ASSERT_EQ(&leaf, trie.find("foo", 3));
-    ASSERT_EQ(nullptr, trie.find("foooo", 5));
-    ASSERT_EQ(nullptr, trie.find("f", 1));
+    for(const std::string key: {"platinum", "plastic", "plate", "play", "rocket", "pocket", "locket", "lock"}) {
+        trie.add(key.c_str(), key.size(), &value);
+    }
+
+    ASSERT_EQ(std::vector<std::string>({"rocket"}), fuzzy_keys(trie, "rocket", 0, false));
+    ASSERT_EQ(std::vector<std::string>({"locket", "pocket", "rocket"}), fuzzy_keys(trie, "rocket", 1, false));
+    ASSERT_EQ(std::vector<std::string>({"platinum"}), fuzzy_keys(trie, "pltinum", 1, false));
+    ASSERT_EQ(std::vector<std::string>({"platinum"}), fuzzy_keys(trie, "palitnum", 2, false));
+    ASSERT_TRUE(fuzzy_keys(trie, "xyzxyz", 2, false).empty());
+
+    ASSERT_EQ(std::vector<std::string>({"plastic", "plate", "platinum", "play"}), fuzzy_keys(trie, "pla", 0, true));
+    ASSERT_EQ(std::vector<std::string>({"plate", "platinum"}), fuzzy_keys(trie, "plat", 0, true));
+    ASSERT_EQ(std::vector<std::string>({"lock", "locket"}), fuzzy_keys(trie, "lokc", 1, true));
+
+    ASSERT_EQ(2, fuzzy_keys(trie, "pla", 0, true, 2).size());
+}
+
+TEST(CVTTest, RandomOperationsMatchMap) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> len_dist(1, 8);
+    std::uniform_int_distribution<int> char_dist('a', 'e');
+
+    CVTrie trie;
+    std::map<std::string, size_t> expected;
+    std::vector<size_t> values(5000);
+
+    for(size_t i = 0; i < values.size(); i++) {
+        std::string key(len_dist(rng), 'a');
+        for(auto& c: key) {
+            c = char(char_dist(rng));
+        }
+
+        values[i] = i;
+
+        if(rng() % 3 == 0) {
+            void* removed = trie.remove(key.c_str(), key.size());
+            auto expected_it = expected.find(key);
+            if(expected_it == expected.end()) {
+                ASSERT_EQ(nullptr, removed);
+            } else {
+                ASSERT_EQ(&values[expected_it->second], removed);
+                expected.erase(expected_it);
+            }
+        } else {
+            ASSERT_EQ(expected.count(key) == 0, trie.add(key.c_str(), key.size(), &values[i]));
+            expected[key] = i;
+        }
+    }
+
+    ASSERT_EQ(expected.size(), trie.size());
+
+    std::vector<std::string> expected_keys;
+    for(const auto& kv: expected) {
+        expected_keys.push_back(kv.first);
+        ASSERT_EQ(&values[kv.second], trie.find(kv.first.c_str(), kv.first.size()));
+    }
+
+    ASSERT_EQ(expected_keys, prefix_keys(trie, ""));
+
+    for(const auto& kv: expected) {
+        ASSERT_EQ(&values[kv.second], trie.remove(kv.first.c_str(), kv.first.size()));
+    }
+
+    ASSERT_EQ(0, trie.size());
+    ASSERT_EQ(0, trie.memory_used());
 }
- */
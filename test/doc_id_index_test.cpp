@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "doc_id_index.h"
+
+TEST(DocIdIndexTest, MapFindsAddedAndRemovedIds) {
+    doc_id_index_t doc_ids(doc_id_index_t::MAP);
+    uint32_t seq_id = 0;
+
+    for(uint32_t i = 0; i < 100000; i++) {
+        doc_ids.add("doc" + std::to_string(i), i);
+    }
+
+    ASSERT_EQ(100000, doc_ids.size());
+
+    for(uint32_t i = 0; i < 100000; i++) {
+        ASSERT_EQ(doc_id_index_t::FOUND, doc_ids.find("doc" + std::to_string(i), seq_id));
+        ASSERT_EQ(i, seq_id);
+    }
+
+    ASSERT_EQ(doc_id_index_t::NOT_FOUND, doc_ids.find("doc100000", seq_id));
+
+    // removing most ids compacts the table
+    for(uint32_t i = 0; i < 90000; i++) {
+        doc_ids.remove("doc" + std::to_string(i));
+    }
+
+    ASSERT_EQ(10000, doc_ids.size());
+
+    for(uint32_t i = 0; i < 100000; i++) {
+        auto lookup = doc_ids.find("doc" + std::to_string(i), seq_id);
+        if(i < 90000) {
+            ASSERT_EQ(doc_id_index_t::NOT_FOUND, lookup);
+        } else {
+            ASSERT_EQ(doc_id_index_t::FOUND, lookup);
+            ASSERT_EQ(i, seq_id);
+        }
+    }
+
+    // adding an id again points it to the new sequence id
+    doc_ids.add("doc99999", 123);
+    ASSERT_EQ(doc_id_index_t::FOUND, doc_ids.find("doc99999", seq_id));
+    ASSERT_EQ(123, seq_id);
+    ASSERT_EQ(10000, doc_ids.size());
+
+    doc_ids.clear();
+    ASSERT_EQ(0, doc_ids.size());
+    ASSERT_EQ(doc_id_index_t::NOT_FOUND, doc_ids.find("doc99999", seq_id));
+}
+
+TEST(DocIdIndexTest, BloomTellsNewIds) {
+    doc_id_index_t doc_ids(doc_id_index_t::BLOOM);
+    uint32_t seq_id = 0;
+
+    for(uint32_t i = 0; i < 300000; i++) {
+        doc_ids.add("doc" + std::to_string(i), i);
+    }
+
+    // ids that were added are never taken as new
+    for(uint32_t i = 0; i < 300000; i++) {
+        ASSERT_EQ(doc_id_index_t::UNKNOWN, doc_ids.find("doc" + std::to_string(i), seq_id));
+    }
+
+    size_t num_false_positives = 0;
+    for(uint32_t i = 0; i < 100000; i++) {
+        if(doc_ids.find("new" + std::to_string(i), seq_id) == doc_id_index_t::UNKNOWN) {
+            num_false_positives++;
+        }
+    }
+
+    ASSERT_LT(num_false_positives, 5000);
+}
+
+TEST(DocIdIndexTest, OffKnowsNothing) {
+    doc_id_index_t doc_ids(doc_id_index_t::parse_mode("unknown"));
+    uint32_t seq_id = 0;
+
+    ASSERT_EQ(doc_id_index_t::OFF, doc_ids.get_mode());
+    doc_ids.add("doc0", 0);
+    ASSERT_EQ(doc_id_index_t::UNKNOWN, doc_ids.find("doc0", seq_id));
+    ASSERT_EQ(doc_id_index_t::UNKNOWN, doc_ids.find("doc1", seq_id));
+
+    ASSERT_EQ(doc_id_index_t::MAP, doc_id_index_t::parse_mode("map"));
+    ASSERT_EQ(doc_id_index_t::BLOOM, doc_id_index_t::parse_mode("bloom"));
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include "embedding_batcher.h"
+
+TEST(EmbeddingBatcherTest, SingleQueryRunsAlone) {
+    std::vector<size_t> batch_sizes;
+    embedding_batcher_t batcher([&](const std::vector<std::string>& texts) {
+        batch_sizes.push_back(texts.size());
+        return std::vector<embedding_res_t>{embedding_res_t(std::vector<float>{float(texts[0].size())})};
+    });
+
+    auto res = batcher.embed("hello", std::chrono::microseconds(0));
+    ASSERT_TRUE(res.success);
+    ASSERT_EQ(std::vector<float>{5}, res.embedding);
+    ASSERT_EQ(std::vector<size_t>{1}, batch_sizes);
+}
+
+TEST(EmbeddingBatcherTest, ConcurrentQueriesAreBatched) {
+    std::atomic<size_t> num_texts = 0;
+    embedding_batcher_t batcher([&](const std::vector<std::string>& texts) {
+        num_texts += texts.size();
+        std::vector<embedding_res_t> results;
+        for(const auto& text: texts) {
+            results.emplace_back(std::vector<float>{float(std::stoi(text))});
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return results;
+    });
+
+    const size_t num_threads = 16;
+    std::vector<std::thread> threads;
+    std::vector<embedding_res_t> results(num_threads);
+
+    for(size_t i = 0; i < num_threads; i++) {
+        threads.emplace_back([&, i]() {
+            results[i] = batcher.embed(std::to_string(i), std::chrono::milliseconds(20));
+        });
+    }
+
+    for(auto& thread: threads) {
+        thread.join();
+    }
+
+    // each query gets its own result back
+    for(size_t i = 0; i < num_threads; i++) {
+        ASSERT_TRUE(results[i].success);
+        ASSERT_EQ(std::vector<float>{float(i)}, results[i].embedding);
+    }
+
+    ASSERT_EQ(num_threads, num_texts);
+    ASSERT_LT(batcher.get_num_batches(), num_threads);
+}
+
+TEST(EmbeddingBatcherTest, MissingResultsAreErrors) {
+    embedding_batcher_t batcher([](const std::vector<std::string>& texts) {
+        return std::vector<embedding_res_t>{};
+    });
+
+    auto res = batcher.embed("hello", std::chrono::microseconds(0));
+    ASSERT_FALSE(res.success);
+    ASSERT_EQ(500, res.status_code);
+    ASSERT_EQ("Failed to embed the query.", res.error["error"].get<std::string>());
+}
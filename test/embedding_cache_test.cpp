@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include "embedding_cache.h"
+
+class EmbeddingCacheTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        embedding_cache_t::set_max_entries(embedding_cache_t::DEFAULT_MAX_ENTRIES);
+    }
+};
+
+TEST_F(EmbeddingCacheTest, CachedEmbeddingsAreReturned) {
+    embedding_cache_t cache;
+    std::vector<float> embedding;
+
+    ASSERT_FALSE(cache.get("query: shoes", embedding));
+
+    cache.insert("query: shoes", {0.1, 0.2});
+    ASSERT_EQ(1, cache.size());
+    ASSERT_TRUE(cache.get("query: shoes", embedding));
+    ASSERT_EQ(std::vector<float>({0.1, 0.2}), embedding);
+
+    // texts are not normalized: a different prefix or case is another query to the model
+    ASSERT_FALSE(cache.get("shoes", embedding));
+    ASSERT_FALSE(cache.get("query: Shoes", embedding));
+
+    nlohmann::json metrics;
+    embedding_cache_t::get_metrics(metrics);
+    ASSERT_EQ(1, metrics.count("typesense_embedding_cache_hits"));
+    ASSERT_EQ(1, metrics.count("typesense_embedding_cache_misses"));
+
+    cache.clear();
+    ASSERT_EQ(0, cache.size());
+    ASSERT_FALSE(cache.get("query: shoes", embedding));
+}
+
+TEST_F(EmbeddingCacheTest, LeastRecentlyUsedEntriesAreEvicted) {
+    embedding_cache_t::set_max_entries(2);
+    embedding_cache_t cache;
+    std::vector<float> embedding;
+
+    cache.insert("a", {1});
+    cache.insert("b", {2});
+    ASSERT_TRUE(cache.get("a", embedding));
+
+    cache.insert("c", {3});
+    ASSERT_EQ(2, cache.size());
+    ASSERT_TRUE(cache.get("a", embedding));
+    ASSERT_FALSE(cache.get("b", embedding));
+    ASSERT_TRUE(cache.get("c", embedding));
+
+    // re-inserting replaces the embedding
+    cache.insert("c", {4});
+    ASSERT_TRUE(cache.get("c", embedding));
+    ASSERT_EQ(std::vector<float>({4}), embedding);
+    ASSERT_EQ(2, cache.size());
+
+    embedding_cache_t::set_max_entries(0);
+    cache.insert("d", {5});
+    ASSERT_FALSE(cache.get("d", embedding));
+    ASSERT_FALSE(cache.get("a", embedding));
+}
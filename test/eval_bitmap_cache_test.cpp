@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "eval_bitmap_cache.h"
+
+static eval_bitmap_cache_t::bitmap_t make_bitmap(const std::vector<uint32_t>& ids) {
+    return std::make_shared<const id_bitmap_t>(ids.data(), ids.size());
+}
+
+TEST(EvalBitmapCacheTest, BitmapHoldsItsIds) {
+    const std::vector<uint32_t> ids = {0, 3, 63, 64, 1000};
+    const auto bitmap = make_bitmap(ids);
+
+    ASSERT_EQ(5, bitmap->num_ids);
+    ASSERT_EQ(16, bitmap->words.size());
+
+    for(uint32_t seq_id = 0; seq_id < 2000; seq_id++) {
+        const bool is_id = std::find(ids.begin(), ids.end(), seq_id) != ids.end();
+        ASSERT_EQ(is_id, bitmap->contains(seq_id));
+    }
+
+    const auto empty_bitmap = make_bitmap({});
+    ASSERT_FALSE(empty_bitmap->contains(0));
+    ASSERT_EQ(0, empty_bitmap->num_bytes());
+}
+
+TEST(EvalBitmapCacheTest, EntriesOfOlderGenerationsAreNotReturned) {
+    eval_bitmap_cache_t cache;
+
+    ASSERT_EQ(nullptr, cache.get("brand:nike", 1));
+
+    auto bitmap = make_bitmap({1, 2, 3});
+    cache.insert("brand:nike", 1, bitmap);
+    ASSERT_EQ(1, cache.size());
+    ASSERT_EQ(bitmap, cache.get("brand:nike", 1));
+
+    // written to since
+    ASSERT_EQ(nullptr, cache.get("brand:nike", 2));
+    ASSERT_EQ(0, cache.size());
+
+    // not cacheable
+    cache.insert("", 1, bitmap);
+    ASSERT_EQ(0, cache.size());
+}
+
+TEST(EvalBitmapCacheTest, EntriesAreBoundedInNumberAndBytes) {
+    // room for two bitmaps of ids below 64
+    eval_bitmap_cache_t cache(2, 16);
+
+    cache.insert("a", 1, make_bitmap({1}));
+    cache.insert("b", 1, make_bitmap({2}));
+    ASSERT_NE(nullptr, cache.get("a", 1));
+
+    cache.insert("c", 1, make_bitmap({3}));
+    ASSERT_EQ(2, cache.size());
+    ASSERT_NE(nullptr, cache.get("a", 1));
+    ASSERT_EQ(nullptr, cache.get("b", 1));
+    ASSERT_NE(nullptr, cache.get("c", 1));
+
+    // too many bytes to be held
+    cache.insert("d", 1, make_bitmap({1000}));
+    ASSERT_EQ(nullptr, cache.get("d", 1));
+
+    // evicts the others to make room
+    cache.insert("e", 1, make_bitmap({127}));
+    ASSERT_EQ(1, cache.size());
+    ASSERT_NE(nullptr, cache.get("e", 1));
+}
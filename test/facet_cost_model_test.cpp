@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "facet_cost_model.h"
+
+TEST(FacetCostModelTest, HeuristicUntilBothStrategiesAreMeasured) {
+    facet_cost_model_t cost_model;
+    facet_cost_model_t::basis_t basis;
+
+    size_t num_explorations = 0;
+
+    for(size_t i = 0; i < 2 * facet_cost_model_t::EXPLORE_INTERVAL; i++) {
+        bool use_value_index = cost_model.choose("tags", 5000, false, basis);
+        if(basis == facet_cost_model_t::EXPLORATION) {
+            // the heuristic picks hash, so the value index is the one explored
+            ASSERT_TRUE(use_value_index);
+            num_explorations++;
+        } else {
+            ASSERT_EQ(facet_cost_model_t::HEURISTIC, basis);
+            ASSERT_FALSE(use_value_index);
+        }
+    }
+
+    ASSERT_EQ(2, num_explorations);
+
+    double cost_us;
+    ASSERT_FALSE(cost_model.get_cost_us("tags", 5000, true, cost_us));
+}
+
+TEST(FacetCostModelTest, PicksTheCheaperStrategy) {
+    facet_cost_model_t cost_model;
+    facet_cost_model_t::basis_t basis;
+
+    for(size_t i = 0; i < facet_cost_model_t::MIN_SAMPLES; i++) {
+        cost_model.record("tags", 5000, false, 900);
+        cost_model.record("tags", 5000, true, 100);
+    }
+
+    double cost_us;
+    ASSERT_TRUE(cost_model.get_cost_us("tags", 5000, false, cost_us));
+    ASSERT_EQ(900, cost_us);
+
+    // results of about the same size share the costs
+    ASSERT_TRUE(cost_model.get_cost_us("tags", 4100, true, cost_us));
+    ASSERT_EQ(100, cost_us);
+
+    // other sizes and fields are not measured yet
+    ASSERT_FALSE(cost_model.get_cost_us("tags", 100, true, cost_us));
+    ASSERT_FALSE(cost_model.get_cost_us("brand", 5000, true, cost_us));
+
+    // hash is more than 4x slower, so it is never explored again
+    for(size_t i = 0; i < 2 * facet_cost_model_t::REEXPLORE_INTERVAL; i++) {
+        ASSERT_TRUE(cost_model.choose("tags", 5000, false, basis));
+        ASSERT_EQ(facet_cost_model_t::MEASURED, basis);
+    }
+
+    // as hash gets cheaper, it is picked instead
+    for(size_t i = 0; i < 20; i++) {
+        cost_model.record("tags", 5000, false, 10);
+    }
+
+    ASSERT_FALSE(cost_model.choose("tags", 5000, true, basis));
+    ASSERT_EQ(facet_cost_model_t::MEASURED, basis);
+
+    size_t num_explorations = 0;
+    for(size_t i = 0; i < facet_cost_model_t::REEXPLORE_INTERVAL; i++) {
+        bool use_value_index = cost_model.choose("tags", 5000, true, basis);
+        if(basis == facet_cost_model_t::EXPLORATION) {
+            ASSERT_TRUE(use_value_index);
+            num_explorations++;
+        }
+    }
+
+    // the value index costs 100us against about 20us, too slow to be explored again
+    ASSERT_EQ(0, num_explorations);
+
+    cost_model.remove_field("tags");
+    ASSERT_FALSE(cost_model.get_cost_us("tags", 5000, false, cost_us));
+}
+
+TEST(FacetCostModelTest, ReexploresCloseStrategies) {
+    facet_cost_model_t cost_model;
+    facet_cost_model_t::basis_t basis;
+
+    for(size_t i = 0; i < facet_cost_model_t::MIN_SAMPLES; i++) {
+        cost_model.record("tags", 5000, false, 150);
+        cost_model.record("tags", 5000, true, 100);
+    }
+
+    size_t num_explorations = 0;
+    for(size_t i = 0; i < 2 * facet_cost_model_t::REEXPLORE_INTERVAL; i++) {
+        bool use_value_index = cost_model.choose("tags", 5000, false, basis);
+        if(basis == facet_cost_model_t::EXPLORATION) {
+            ASSERT_FALSE(use_value_index);
+            num_explorations++;
+        } else {
+            ASSERT_EQ(facet_cost_model_t::MEASURED, basis);
+            ASSERT_TRUE(use_value_index);
+        }
+    }
+
+    ASSERT_EQ(2, num_explorations);
+}
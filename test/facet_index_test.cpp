@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <set>
 #include "facet_index.h"
 
 TEST(FacetIndexTest, FacetValueDeletionString) {
@@ -630,3 +631,236 @@ TEST(FacetIndexTest, DecrementSingleCount) {
     ASSERT_EQ(std::next(count_list.begin(), 2), count_map[5]);
     ASSERT_EQ(std::next(count_list.begin(), 3), count_map[4]);
 }
+
+TEST(FacetIndexTest, OrdinalCountsMatchIntersection) {
+    facet_index_t findex;
+    findex.initialize("brand");
+
+    std::unordered_map<facet_value_id_t, std::vector<uint32_t>, facet_value_id_t::Hash> fvalue_to_seq_ids;
+    std::unordered_map<uint32_t, std::vector<facet_value_id_t>> seq_id_to_fvalues;
+
+    const size_t num_docs = 6000;
+    const size_t num_brands = 20;
+
+    for(uint32_t seq_id = 0; seq_id < num_docs; seq_id++) {
+        if(seq_id % 7 == 0) {
+            // document without a value
+            continue;
+        }
+
+        facet_value_id_t brand("brand_" + std::to_string((seq_id * seq_id) % num_brands));
+        fvalue_to_seq_ids[brand].push_back(seq_id);
+        seq_id_to_fvalues[seq_id] = {brand};
+    }
+
+    findex.insert("brand", fvalue_to_seq_ids, seq_id_to_fvalues, true);
+    ASSERT_TRUE(findex.has_ordinal_index("brand"));
+
+    field brandf("brand", field_types::STRING, true);
+
+    // values that lose all their documents free their ordinals
+    for(uint32_t seq_id = 0; seq_id < num_docs; seq_id++) {
+        if(seq_id % 7 != 0 && (seq_id * seq_id) % num_brands == 1) {
+            nlohmann::json doc;
+            doc["brand"] = "brand_1";
+            findex.remove(doc, brandf, seq_id);
+        }
+    }
+
+    ASSERT_FALSE(findex.facet_value_exists("brand", "brand_1"));
+
+    fvalue_to_seq_ids.clear();
+    seq_id_to_fvalues.clear();
+    facet_value_id_t new_brand("new_brand");
+    for(uint32_t seq_id = num_docs; seq_id < num_docs + 500; seq_id++) {
+        fvalue_to_seq_ids[new_brand].push_back(seq_id);
+        seq_id_to_fvalues[seq_id] = {new_brand};
+    }
+
+    findex.insert("brand", fvalue_to_seq_ids, seq_id_to_fvalues, true);
+    ASSERT_TRUE(findex.has_ordinal_index("brand"));
+
+    std::vector<uint32_t> result_ids;
+    std::map<std::string, uint32_t> expected_counts;
+    for(uint32_t seq_id = 0; seq_id < num_docs + 500; seq_id += 3) {
+        result_ids.push_back(seq_id);
+
+        if(seq_id >= num_docs) {
+            expected_counts["new_brand"]++;
+        } else if(seq_id % 7 != 0 && (seq_id * seq_id) % num_brands != 1) {
+            expected_counts["brand_" + std::to_string((seq_id * seq_id) % num_brands)]++;
+        }
+    }
+
+    ASSERT_GE(result_ids.size(), 1024);
+
+    facet a_facet("brand", 0);
+    std::map<std::string, docid_count_t> found;
+    findex.intersect(a_facet, brandf, false, false, 1, {}, {}, {}, &result_ids[0], result_ids.size(),
+                     100, found, false);
+
+    ASSERT_EQ(expected_counts.size(), found.size());
+    for(const auto& kv: expected_counts) {
+        ASSERT_EQ(1, found.count(kv.first));
+        ASSERT_EQ(kv.second, found[kv.first].count);
+    }
+
+    // a document with several values drops the ordinal column
+    fvalue_to_seq_ids.clear();
+    seq_id_to_fvalues.clear();
+    facet_value_id_t brand_0("brand_0");
+    facet_value_id_t brand_2("brand_2");
+    fvalue_to_seq_ids[brand_0] = {num_docs + 500};
+    fvalue_to_seq_ids[brand_2] = {num_docs + 500};
+    seq_id_to_fvalues[num_docs + 500] = {brand_0, brand_2};
+
+    findex.insert("brand", fvalue_to_seq_ids, seq_id_to_fvalues, true);
+    ASSERT_FALSE(findex.has_ordinal_index("brand"));
+
+    result_ids.push_back(num_docs + 500);
+    expected_counts["brand_0"]++;
+    expected_counts["brand_2"]++;
+
+    found.clear();
+    findex.intersect(a_facet, brandf, false, false, 1, {}, {}, {}, &result_ids[0], result_ids.size(),
+                     100, found, false);
+
+    ASSERT_EQ(expected_counts.size(), found.size());
+    for(const auto& kv: expected_counts) {
+        ASSERT_EQ(kv.second, found[kv.first].count);
+    }
+}
+
+TEST(FacetIndexTest, FacetIdColumnMatchesHashIndex) {
+    facet_index_t findex;
+    findex.initialize("brand");
+
+    std::unordered_map<facet_value_id_t, std::vector<uint32_t>, facet_value_id_t::Hash> fvalue_to_seq_ids;
+    std::unordered_map<uint32_t, std::vector<facet_value_id_t>> seq_id_to_fvalues;
+
+    for(uint32_t seq_id = 0; seq_id < 100; seq_id++) {
+        if(seq_id % 5 == 0) {
+            continue;
+        }
+
+        facet_value_id_t brand("brand_" + std::to_string(seq_id % 3));
+        fvalue_to_seq_ids[brand].push_back(seq_id);
+        seq_id_to_fvalues[seq_id] = {brand};
+    }
+
+    findex.insert("brand", fvalue_to_seq_ids, seq_id_to_fvalues, true);
+
+    auto facet_ids = findex.get_facet_id_column("brand");
+    ASSERT_NE(nullptr, facet_ids);
+
+    auto it = findex.get_facet_hash_index("brand")->new_iterator();
+    for(uint32_t seq_id = 0; seq_id < 100; seq_id++) {
+        if(seq_id % 5 == 0) {
+            ASSERT_EQ(facet_index_t::NO_FACET_ID, (*facet_ids)[seq_id]);
+            continue;
+        }
+
+        it.skip_to(seq_id);
+        ASSERT_EQ(seq_id, it.id());
+        ASSERT_EQ(it.offset(), (*facet_ids)[seq_id]);
+    }
+
+    field brandf("brand", field_types::STRING, true);
+    nlohmann::json doc;
+    doc["brand"] = "brand_1";
+    findex.remove(doc, brandf, 1);
+    ASSERT_EQ(facet_index_t::NO_FACET_ID, (*facet_ids)[1]);
+
+    // a document with several values drops the column
+    fvalue_to_seq_ids.clear();
+    seq_id_to_fvalues.clear();
+    facet_value_id_t brand_0("brand_0");
+    facet_value_id_t brand_2("brand_2");
+    fvalue_to_seq_ids[brand_0] = {100};
+    fvalue_to_seq_ids[brand_2] = {100};
+    seq_id_to_fvalues[100] = {brand_0, brand_2};
+
+    findex.insert("brand", fvalue_to_seq_ids, seq_id_to_fvalues, true);
+    ASSERT_EQ(nullptr, findex.get_facet_id_column("brand"));
+}
+
+TEST(FacetIndexTest, ApproximateCountsFromSketches) {
+    facet_index_t findex;
+    findex.initialize("brand");
+
+    std::unordered_map<facet_value_id_t, std::vector<uint32_t>, facet_value_id_t::Hash> fvalue_to_seq_ids;
+    std::unordered_map<uint32_t, std::vector<facet_value_id_t>> seq_id_to_fvalues;
+
+    const size_t num_docs = 20000;
+    const size_t num_brands = 8;
+
+    auto get_brand = [&](uint32_t seq_id) {
+        // the last brand is too rare to be sampled
+        return seq_id % 100 == 0 ? "brand_rare" : "brand_" + std::to_string((seq_id * 7 + seq_id / 3) % num_brands);
+    };
+
+    for(uint32_t seq_id = 0; seq_id < num_docs; seq_id++) {
+        facet_value_id_t brand(get_brand(seq_id));
+        fvalue_to_seq_ids[brand].push_back(seq_id);
+        seq_id_to_fvalues[seq_id] = {brand};
+    }
+
+    findex.insert("brand", fvalue_to_seq_ids, seq_id_to_fvalues, true);
+
+    field brandf("brand", field_types::STRING, true);
+
+    // removing ids, sampled ones included, keeps the samples to the smallest hashes of the ids that are left
+    std::set<uint32_t> removed_ids;
+    for(uint32_t seq_id = 0; seq_id < num_docs; seq_id += 3) {
+        nlohmann::json doc;
+        doc["brand"] = get_brand(seq_id);
+        findex.remove(doc, brandf, seq_id);
+        removed_ids.insert(seq_id);
+    }
+
+    std::vector<uint32_t> all_ids;
+    for(uint32_t seq_id = 0; seq_id < num_docs; seq_id++) {
+        if(removed_ids.count(seq_id) == 0) {
+            all_ids.push_back(seq_id);
+        }
+    }
+
+    facet a_facet("brand", 0);
+    std::map<std::string, docid_count_t> found;
+
+    // with all the ids in the results, every sampled id is found and the counts are exact
+    findex.intersect(a_facet, brandf, false, false, 1, {}, {}, {}, &all_ids[0], all_ids.size(),
+                     100, found, false, "", true);
+
+    ASSERT_EQ(num_brands + 1, found.size());
+    for(const auto& kv: found) {
+        ASSERT_EQ(findex.facet_val_num_ids("brand", kv.first), kv.second.count) << kv.first;
+    }
+
+    std::vector<uint32_t> result_ids;
+    std::map<std::string, uint32_t> expected_counts;
+    for(auto seq_id: all_ids) {
+        if(seq_id < num_docs / 2 || seq_id % 5 == 0) {
+            result_ids.push_back(seq_id);
+            expected_counts[get_brand(seq_id)]++;
+        }
+    }
+
+    found.clear();
+    findex.intersect(a_facet, brandf, false, false, 1, {}, {}, {}, &result_ids[0], result_ids.size(),
+                     100, found, false, "", true);
+
+    ASSERT_EQ(expected_counts.size(), found.size());
+    for(const auto& kv: expected_counts) {
+        ASSERT_EQ(1, found.count(kv.first));
+        const auto& estimate = found[kv.first];
+
+        if(kv.first == "brand_rare") {
+            ASSERT_EQ(kv.second, estimate.count);
+            ASSERT_EQ(0, estimate.error_bound);
+        } else {
+            ASSERT_LT(0, estimate.error_bound);
+            ASSERT_LE(std::abs(int64_t(estimate.count) - int64_t(kv.second)), estimate.error_bound) << kv.first;
+        }
+    }
+}
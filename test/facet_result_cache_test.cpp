@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "facet_result_cache.h"
+
+static facet_result_cache_t::facets_t make_facets(const std::string& field_name, size_t num_values) {
+    std::vector<facet> facets;
+    facets.emplace_back(field_name, 0);
+
+    for(size_t i = 0; i < num_values; i++) {
+        facets[0].result_map[i].count = i + 1;
+    }
+
+    return std::make_shared<const std::vector<facet>>(facets);
+}
+
+TEST(FacetResultCacheTest, KeysTellSpecsParamsAndResultSetsApart) {
+    const std::vector<uint32_t> ids = {1, 4, 7, 9};
+    const std::vector<uint32_t> other_ids = {1, 4, 8, 9};
+
+    std::vector<facet> facets;
+    facets.emplace_back("tags", 0);
+
+    const auto key = facet_result_cache_t::get_key(facets, "10", ids.data(), ids.size());
+    ASSERT_EQ(key, facet_result_cache_t::get_key(facets, "10", ids.data(), ids.size()));
+    ASSERT_NE(key, facet_result_cache_t::get_key(facets, "20", ids.data(), ids.size()));
+    ASSERT_NE(key, facet_result_cache_t::get_key(facets, "10", other_ids.data(), other_ids.size()));
+    ASSERT_NE(key, facet_result_cache_t::get_key(facets, "10", ids.data(), ids.size() - 1));
+
+    std::vector<facet> sorted_facets;
+    sorted_facets.emplace_back("tags", 0, std::map<int64_t, range_specs_t>{}, false, true, "asc");
+    ASSERT_NE(key, facet_result_cache_t::get_key(sorted_facets, "10", ids.data(), ids.size()));
+
+    std::vector<facet> other_facets;
+    other_facets.emplace_back("brand", 0);
+    ASSERT_NE(key, facet_result_cache_t::get_key(other_facets, "10", ids.data(), ids.size()));
+
+    // all the documents are keyed by their count, without their ids
+    const auto all_key = facet_result_cache_t::get_key(facets, "10", ids.data(), ids.size(), true);
+    ASSERT_NE(key, all_key);
+    ASSERT_EQ(all_key, facet_result_cache_t::get_key(facets, "10", other_ids.data(), other_ids.size(), true));
+    ASSERT_NE(all_key, facet_result_cache_t::get_key(facets, "10", ids.data(), ids.size() - 1, true));
+}
+
+TEST(FacetResultCacheTest, EntriesOfOlderGenerationsAreNotReturned) {
+    facet_result_cache_t cache;
+    const std::vector<uint32_t> ids = {1, 2, 3};
+
+    std::vector<facet> facets;
+    facets.emplace_back("tags", 0);
+    const auto key = facet_result_cache_t::get_key(facets, "", ids.data(), ids.size());
+
+    ASSERT_EQ(nullptr, cache.get(key, 1));
+
+    auto cached_facets = make_facets("tags", 3);
+    cache.insert(key, 1, cached_facets);
+    ASSERT_EQ(1, cache.size());
+    ASSERT_EQ(cached_facets, cache.get(key, 1));
+
+    facet_result_cache_t::copy_counts((*cached_facets)[0], facets[0]);
+    ASSERT_EQ(3, facets[0].result_map.size());
+    ASSERT_EQ(2, facets[0].result_map[1].count);
+
+    // written to since
+    ASSERT_EQ(nullptr, cache.get(key, 2));
+    ASSERT_EQ(0, cache.size());
+}
+
+TEST(FacetResultCacheTest, EntriesAreBoundedInNumberAndValues) {
+    facet_result_cache_t cache(2, 10);
+
+    cache.insert("a", 1, make_facets("tags", 2));
+    cache.insert("b", 1, make_facets("tags", 2));
+    ASSERT_NE(nullptr, cache.get("a", 1));
+
+    cache.insert("c", 1, make_facets("tags", 2));
+    ASSERT_EQ(2, cache.size());
+    ASSERT_NE(nullptr, cache.get("a", 1));
+    ASSERT_EQ(nullptr, cache.get("b", 1));
+    ASSERT_NE(nullptr, cache.get("c", 1));
+
+    // too many values to be held
+    cache.insert("d", 1, make_facets("tags", 11));
+    ASSERT_EQ(nullptr, cache.get("d", 1));
+
+    // evicts the others to make room
+    cache.insert("e", 1, make_facets("tags", 9));
+    ASSERT_EQ(1, cache.size());
+    ASSERT_NE(nullptr, cache.get("e", 1));
+}
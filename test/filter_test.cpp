@@ -863,3 +863,198 @@ TEST_F(FilterTest, FilterTreeIteratorTimeout) {
     ASSERT_EQ(count, result->count); // With `override_timeout` true, we should get result.
     delete result;
 }
+
+TEST_F(FilterTest, FilterResultCache) {
+    nlohmann::json schema =
+            R"({
+                "name": "Collection",
+                "fields": [
+                    {"name": "name", "type": "string"},
+                    {"name": "age", "type": "int32"},
+                    {"name": "tags", "type": "string[]"}
+                ]
+            })"_json;
+
+    Collection* coll = collectionManager.create_collection(schema).get();
+
+    for (size_t i = 0; i < 10; i++) {
+        nlohmann::json doc;
+        doc["name"] = "Name " + std::to_string(i);
+        doc["age"] = i * 10;
+        doc["tags"] = (i % 2 == 0) ? std::vector<std::string>{"gold"} : std::vector<std::string>{"silver"};
+        ASSERT_TRUE(coll->add(doc.dump()).ok());
+    }
+
+    const std::string doc_id_prefix = std::to_string(coll->get_collection_id()) + "_" + Collection::DOC_ID_PREFIX + "_";
+
+    filter_node_t* filter_tree_root = nullptr;
+    auto filter_op = filter::parse_filter_query("tags: gold && age: > 20", coll->get_schema(), store, doc_id_prefix,
+                                                filter_tree_root);
+    ASSERT_TRUE(filter_op.ok());
+    std::unique_ptr<filter_node_t> filter_tree_guard(filter_tree_root);
+
+    filter_node_t* reordered_tree_root = nullptr;
+    filter_op = filter::parse_filter_query("age: > 20 && tags: gold", coll->get_schema(), store, doc_id_prefix,
+                                           reordered_tree_root);
+    ASSERT_TRUE(filter_op.ok());
+    std::unique_ptr<filter_node_t> reordered_tree_guard(reordered_tree_root);
+
+    auto key = filter_result_cache_t::get_key(filter_tree_root);
+    ASSERT_FALSE(key.empty());
+    ASSERT_EQ(key, filter_result_cache_t::get_key(reordered_tree_root));
+
+    auto iter_compute_test = filter_result_iterator_t(coll->get_name(), coll->_get_index(), filter_tree_root);
+    ASSERT_TRUE(iter_compute_test.init_status().ok());
+    iter_compute_test.compute_iterators();
+
+    // the materialized result is reused by an equivalent filter
+    auto iter_cached_test = filter_result_iterator_t(coll->get_name(), coll->_get_index(), reordered_tree_root);
+    ASSERT_TRUE(iter_cached_test.init_status().ok());
+    ASSERT_TRUE(iter_cached_test._get_is_filter_result_initialized());
+
+    std::vector<uint32_t> expected = {4, 6, 8};
+    for (auto const& i : expected) {
+        ASSERT_EQ(filter_result_iterator_t::valid, iter_cached_test.validity);
+        ASSERT_EQ(i, iter_cached_test.seq_id);
+        iter_cached_test.next();
+    }
+    ASSERT_EQ(filter_result_iterator_t::invalid, iter_cached_test.validity);
+
+    // a write invalidates the cached result
+    nlohmann::json doc;
+    doc["name"] = "Name 10";
+    doc["age"] = 100;
+    doc["tags"] = std::vector<std::string>{"gold"};
+    ASSERT_TRUE(coll->add(doc.dump()).ok());
+
+    auto iter_invalidated_test = filter_result_iterator_t(coll->get_name(), coll->_get_index(), filter_tree_root);
+    ASSERT_TRUE(iter_invalidated_test.init_status().ok());
+    iter_invalidated_test.compute_iterators();
+
+    expected = {4, 6, 8, 10};
+    for (auto const& i : expected) {
+        ASSERT_EQ(filter_result_iterator_t::valid, iter_invalidated_test.validity);
+        ASSERT_EQ(i, iter_invalidated_test.seq_id);
+        iter_invalidated_test.next();
+    }
+    ASSERT_EQ(filter_result_iterator_t::invalid, iter_invalidated_test.validity);
+}
+
+TEST_F(FilterTest, SelectiveAndProbesLargerSubtree) {
+    nlohmann::json schema =
+            R"({
+                "name": "Collection",
+                "fields": [
+                    {"name": "age", "type": "int32"},
+                    {"name": "tags", "type": "string[]"}
+                ]
+            })"_json;
+
+    Collection* coll = collectionManager.create_collection(schema).get();
+
+    for (size_t i = 0; i < 100; i++) {
+        nlohmann::json doc;
+        doc["age"] = i;
+        doc["tags"] = (i % 10 == 0) ? std::vector<std::string>{"silver"} : std::vector<std::string>{"gold"};
+        ASSERT_TRUE(coll->add(doc.dump()).ok());
+    }
+
+    const std::string doc_id_prefix = std::to_string(coll->get_collection_id()) + "_" + Collection::DOC_ID_PREFIX + "_";
+
+    filter_node_t* filter_tree_root = nullptr;
+    auto filter_op = filter::parse_filter_query("tags: gold && age: [10, 11, 55, 90, 99]", coll->get_schema(), store,
+                                                doc_id_prefix, filter_tree_root);
+    ASSERT_TRUE(filter_op.ok());
+    std::unique_ptr<filter_node_t> filter_tree_guard(filter_tree_root);
+
+    auto iter_and_test = filter_result_iterator_t(coll->get_name(), coll->_get_index(), filter_tree_root);
+    ASSERT_TRUE(iter_and_test.init_status().ok());
+    ASSERT_FALSE(iter_and_test._get_is_filter_result_initialized());
+    iter_and_test.compute_iterators();
+    ASSERT_TRUE(iter_and_test._get_is_filter_result_initialized());
+
+    std::vector<uint32_t> expected = {11, 55, 99};
+    for (auto const& i : expected) {
+        ASSERT_EQ(filter_result_iterator_t::valid, iter_and_test.validity);
+        ASSERT_EQ(i, iter_and_test.seq_id);
+        iter_and_test.next();
+    }
+    ASSERT_EQ(filter_result_iterator_t::invalid, iter_and_test.validity);
+
+    filter_node_t* or_tree_root = nullptr;
+    filter_op = filter::parse_filter_query("tags: gold || tags: silver", coll->get_schema(), store, doc_id_prefix,
+                                           or_tree_root);
+    ASSERT_TRUE(filter_op.ok());
+    std::unique_ptr<filter_node_t> or_tree_guard(or_tree_root);
+
+    // the estimate of an OR is an upper-bound of the ids matched by either side
+    auto iter_or_test = filter_result_iterator_t(coll->get_name(), coll->_get_index(), or_tree_root);
+    ASSERT_TRUE(iter_or_test.init_status().ok());
+    ASSERT_EQ(100, iter_or_test.approx_filter_ids_length);
+}
+
+TEST_F(FilterTest, FilterParams) {
+    nlohmann::json schema =
+            R"({
+                "name": "Collection",
+                "fields": [
+                    {"name": "age", "type": "int32"},
+                    {"name": "tags", "type": "string[]"}
+                ]
+            })"_json;
+
+    Collection* coll = collectionManager.create_collection(schema).get();
+
+    for (size_t i = 0; i < 100; i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["age"] = i;
+        doc["tags"] = (i % 10 == 0) ? std::vector<std::string>{"silver"} : std::vector<std::string>{"gold"};
+        ASSERT_TRUE(coll->add(doc.dump()).ok());
+    }
+
+    const std::string doc_id_prefix = std::to_string(coll->get_collection_id()) + "_" + Collection::DOC_ID_PREFIX + "_";
+    const std::string filter_template = "tags:={{tags}} && (age:{{ages}} || id:!={{ids}}) && age:<{{max_age}}";
+
+    auto filter_params = R"({"tags": ["silver"], "ages": [10, 20, 35], "ids": ["10", "30"], "max_age": 50})"_json;
+
+    // bound twice, the second time from the parsed template
+    for (size_t i = 0; i < 2; i++) {
+        filter_node_t* filter_tree_root = nullptr;
+        auto filter_op = filter::parse_filter_query(filter_template, coll->get_schema(), store, doc_id_prefix,
+                                                    filter_tree_root, filter_params);
+        ASSERT_TRUE(filter_op.ok());
+        std::unique_ptr<filter_node_t> filter_tree_guard(filter_tree_root);
+
+        auto iter_test = filter_result_iterator_t(coll->get_name(), coll->_get_index(), filter_tree_root);
+        ASSERT_TRUE(iter_test.init_status().ok());
+
+        std::vector<uint32_t> expected = {0, 10, 20, 40};
+        for (auto const& seq_id : expected) {
+            ASSERT_EQ(filter_result_iterator_t::valid, iter_test.validity);
+            ASSERT_EQ(seq_id, iter_test.seq_id);
+            iter_test.next();
+        }
+        ASSERT_EQ(filter_result_iterator_t::invalid, iter_test.validity);
+    }
+
+    filter_node_t* filter_tree_root = nullptr;
+    filter_params = R"({"tags": ["silver"], "ages": [10], "ids": ["10"]})"_json;
+    auto filter_op = filter::parse_filter_query(filter_template, coll->get_schema(), store, doc_id_prefix,
+                                                filter_tree_root, filter_params);
+    ASSERT_FALSE(filter_op.ok());
+    ASSERT_EQ("Value of the filter parameter `max_age` is missing.", filter_op.error());
+
+    filter_params = R"({"tags": ["silver"], "ages": ["10"], "ids": ["10"], "max_age": 50})"_json;
+    filter_op = filter::parse_filter_query(filter_template, coll->get_schema(), store, doc_id_prefix,
+                                           filter_tree_root, filter_params);
+    ASSERT_FALSE(filter_op.ok());
+    ASSERT_EQ("Error with filter field `age`: values of the filter parameter `ages` must be integers.",
+              filter_op.error());
+
+    filter_op = filter::parse_filter_query("age:>{{ages}}", coll->get_schema(), store, doc_id_prefix,
+                                           filter_tree_root, filter_params);
+    ASSERT_FALSE(filter_op.ok());
+    ASSERT_EQ("Error with filter field `age`: an array filter parameter can only be used with the `=` and `!=` "
+              "operators.", filter_op.error());
+}
@@ -5,6 +5,9 @@
 #include <algorithm>
 #include <collection_manager.h>
 #include "collection.h"
+#include <s2/s2cap.h>
+#include <s2/s2loop.h>
+#include <s2/s2earth.h>
 
 class GeoFilteringTest : public ::testing::Test {
 protected:
@@ -607,3 +610,56 @@ TEST_F(GeoFilteringTest, GeoPointFilteringWithNonSortableLocationField) {
     ASSERT_EQ(1, results["found"].get<size_t>());
     ASSERT_EQ(1, results["hits"].size());
 }
+
+TEST_F(GeoFilteringTest, GeoFilteringInteriorAndBoundaryCells) {
+    std::vector<field> fields = {field("loc", field_types::GEOPOINT, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    // a grid of points around the query center: most of them fall inside interior cells of the
+    // query region while the ones near the edge must still be verified exactly
+    S2Point center = S2LatLng::FromDegrees(48.85, 2.35).ToPoint();
+    S2Cap cap(center, S1Angle::Radians(S2Earth::MetersToRadians(5000)));
+
+    S2Loop polygon({S2LatLng::FromDegrees(48.80, 2.30).ToPoint(), S2LatLng::FromDegrees(48.80, 2.40).ToPoint(),
+                    S2LatLng::FromDegrees(48.90, 2.40).ToPoint(), S2LatLng::FromDegrees(48.90, 2.30).ToPoint()});
+    polygon.Normalize();
+
+    size_t expected_in_cap = 0, expected_in_polygon = 0;
+    size_t id = 0;
+
+    for(int i = -30; i <= 30; i++) {
+        for(int j = -30; j <= 30; j++) {
+            double lat = 48.85 + (i * 0.002);
+            double lng = 2.35 + (j * 0.003);
+
+            nlohmann::json doc;
+            doc["id"] = std::to_string(id++);
+            doc["loc"] = {lat, lng};
+            doc["points"] = i;
+            ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+            int64_t packed_lat_lng = GeoPoint::pack_lat_lng(lat, lng);
+            S2LatLng s2_lat_lng;
+            GeoPoint::unpack_lat_lng(packed_lat_lng, s2_lat_lng);
+            expected_in_cap += cap.Contains(s2_lat_lng.ToPoint());
+            expected_in_polygon += polygon.Contains(s2_lat_lng.ToPoint());
+        }
+    }
+
+    ASSERT_LT(0, expected_in_cap);
+    ASSERT_GT(id, expected_in_cap);
+    ASSERT_LT(0, expected_in_polygon);
+    ASSERT_GT(id, expected_in_polygon);
+
+    auto results = coll1->search("*", {}, "loc: ([48.85, 2.35], radius: 5 km)",
+                                 {}, {}, {0}, 10, 1, FREQUENCY).get();
+    ASSERT_EQ(expected_in_cap, results["found"].get<size_t>());
+
+    results = coll1->search("*", {}, "loc: (48.80, 2.30, 48.80, 2.40, 48.90, 2.40, 48.90, 2.30)",
+                            {}, {}, {0}, 10, 1, FREQUENCY).get();
+    ASSERT_EQ(expected_in_polygon, results["found"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+}
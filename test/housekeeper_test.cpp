@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "housekeeper.h"
+
+static std::shared_ptr<housekeeping_task_t> make_task(const std::string& name, housekeeping_task_t::priority_t priority,
+                                                      uint32_t interval_s, std::vector<std::string>& run_order,
+                                                      uint64_t sleep_ms = 0) {
+    auto task = std::make_shared<housekeeping_task_t>();
+    task->name = name;
+    task->priority = priority;
+    task->get_interval_s = [interval_s]() { return interval_s; };
+    task->run = [name, &run_order, sleep_ms](housekeeping_ctx_t& ctx) {
+        run_order.push_back(name);
+        if(sleep_ms != 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+        }
+        ctx.set_progress(1, 1);
+    };
+    return task;
+}
+
+TEST(HouseKeeperTest, RunsDueTasksByPriority) {
+    auto& housekeeper = HouseKeeper::get_instance();
+    std::vector<std::string> run_order;
+
+    housekeeper.add_task(make_task("hk_low", housekeeping_task_t::LOW, 60, run_order));
+    housekeeper.add_task(make_task("hk_high", housekeeping_task_t::HIGH, 60, run_order));
+    housekeeper.add_task(make_task("hk_disabled", housekeeping_task_t::HIGH, 0, run_order));
+    housekeeper.add_task(make_task("hk_hourly", housekeeping_task_t::NORMAL, 3600, run_order));
+
+    const uint64_t now_s = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // nothing is due before its interval has passed
+    ASSERT_EQ(0, housekeeper.run_due_tasks(now_s, 1000));
+
+    ASSERT_EQ(2, housekeeper.run_due_tasks(now_s + 60, 1000));
+    ASSERT_EQ((std::vector<std::string>{"hk_high", "hk_low"}), run_order);
+
+    // the tasks run again once their interval has passed since their last run
+    ASSERT_EQ(0, housekeeper.run_due_tasks(now_s + 90, 1000));
+    ASSERT_EQ(3, housekeeper.run_due_tasks(now_s + 3600, 1000));
+
+    auto tasks_json = housekeeper.get_tasks_json();
+    for(const auto& task_json: tasks_json) {
+        if(task_json["name"] == "hk_high") {
+            ASSERT_EQ(2, task_json["num_runs"].get<size_t>());
+            ASSERT_EQ("high", task_json["priority"]);
+            ASSERT_EQ(1, task_json["progress"]["done"].get<size_t>());
+            ASSERT_FALSE(task_json["running"].get<bool>());
+        } else if(task_json["name"] == "hk_disabled") {
+            ASSERT_EQ(0, task_json["num_runs"].get<size_t>());
+        }
+    }
+
+    for(const auto& name: {"hk_low", "hk_high", "hk_disabled", "hk_hourly"}) {
+        housekeeper.remove_task(name);
+    }
+}
+
+TEST(HouseKeeperTest, DefersTasksBeyondBudget) {
+    auto& housekeeper = HouseKeeper::get_instance();
+    std::vector<std::string> run_order;
+
+    housekeeper.add_task(make_task("hk_slow", housekeeping_task_t::HIGH, 60, run_order, 20));
+    housekeeper.add_task(make_task("hk_low", housekeeping_task_t::LOW, 60, run_order));
+
+    const uint64_t now_s = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // the first task runs even though it spends the whole budget, and the other waits for the next pass
+    ASSERT_EQ(1, housekeeper.run_due_tasks(now_s + 60, 10));
+    ASSERT_EQ((std::vector<std::string>{"hk_slow"}), run_order);
+
+    // where it goes ahead of the task of a higher priority
+    ASSERT_EQ(2, housekeeper.run_due_tasks(now_s + 120, 10));
+    ASSERT_EQ((std::vector<std::string>{"hk_slow", "hk_low", "hk_slow"}), run_order);
+
+    housekeeper.remove_task("hk_slow");
+    housekeeper.remove_task("hk_low");
+}
+
+TEST(HouseKeeperTest, CancelTask) {
+    auto& housekeeper = HouseKeeper::get_instance();
+
+    ASSERT_EQ(404, housekeeper.cancel_task("hk_unknown").code());
+
+    std::atomic<bool> started = false;
+    size_t num_steps = 0;
+
+    auto task = std::make_shared<housekeeping_task_t>();
+    task->name = "hk_cancellable";
+    task->get_interval_s = []() { return 60; };
+    task->run = [&](housekeeping_ctx_t& ctx) {
+        started = true;
+        while(!ctx.should_stop()) {
+            num_steps++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+    housekeeper.add_task(task);
+
+    ASSERT_EQ(409, housekeeper.cancel_task("hk_cancellable").code());
+
+    const uint64_t now_s = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::thread pass_thread([&]() {
+        housekeeper.run_due_tasks(now_s + 60, 60 * 1000);
+    });
+
+    while(!started) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ASSERT_TRUE(housekeeper.cancel_task("hk_cancellable").ok());
+    pass_thread.join();
+
+    ASSERT_EQ(1, task->num_cancelled);
+    ASSERT_FALSE(task->running);
+
+    housekeeper.remove_task("hk_cancellable");
+}
+
+TEST(HouseKeeperTest, ResumesUnfinishedTaskOnNextPass) {
+    auto& housekeeper = HouseKeeper::get_instance();
+    size_t num_done = 0;
+
+    auto task = std::make_shared<housekeeping_task_t>();
+    task->name = "hk_resumable";
+    task->get_interval_s = []() { return 3600; };
+    task->run = [&](housekeeping_ctx_t& ctx) {
+        do {
+            num_done++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        } while(num_done < 3 && !ctx.should_stop());
+
+        if(num_done < 3) {
+            ctx.set_unfinished();
+        }
+    };
+    housekeeper.add_task(task);
+
+    const uint64_t now_s = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // the budget runs out after each unit of work, so that the task stops with work left
+    ASSERT_EQ(1, housekeeper.run_due_tasks(now_s + 3600, 1));
+    ASSERT_EQ(1, num_done);
+    ASSERT_TRUE(task->deferred);
+
+    // it's resumed on the next passes, well before its interval has passed again, until it's done
+    ASSERT_EQ(1, housekeeper.run_due_tasks(now_s + 3660, 1));
+    ASSERT_EQ(2, num_done);
+    ASSERT_EQ(1, housekeeper.run_due_tasks(now_s + 3720, 1));
+    ASSERT_EQ(3, num_done);
+    ASSERT_FALSE(task->deferred);
+    ASSERT_EQ(now_s + 3720, task->last_run_s);
+
+    // and then waits for its interval
+    ASSERT_EQ(0, housekeeper.run_due_tasks(now_s + 3780, 1));
+    ASSERT_EQ(3, task->num_runs);
+    ASSERT_EQ(2, task->num_deferred);
+
+    housekeeper.remove_task("hk_resumable");
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <id_list.h>
+#include "ids_t.h"
 #include "logger.h"
 
 TEST(IdListTest, IdListIteratorTest) {
@@ -50,3 +51,66 @@ TEST(IdListTest, IdListIntersectionTest) {
 
     delete [] res_ids;
 }
+
+TEST(IdListTest, PartialIteratorStopsAtItsEnd) {
+    id_list_t id_list(2);
+    for(size_t i = 0; i < 10; i++) {
+        id_list.upsert(i*2);
+    }
+
+    // blocks of [0, 2] and [4, 6]
+    auto iter = id_list.new_iterator(id_list.get_root(), id_list.block_of(8));
+    iter.skip_to(4);
+    ASSERT_TRUE(iter.valid());
+    ASSERT_EQ(4, iter.id());
+
+    iter.skip_to(10);
+    ASSERT_FALSE(iter.valid());
+}
+
+TEST(IdListTest, ParallelBlockIntersection) {
+    ThreadPool pool(4);
+
+    std::vector<uint32_t> ids1, ids2, ids3;
+    for(uint32_t i = 0; i < 100000; i++) {
+        ids1.push_back(i * 2);
+        if(i % 3 == 0) {
+            ids2.push_back(i * 2);
+        }
+
+        // ends half way through the others, and makes them skewed
+        if(i < 25000) {
+            ids3.push_back(i * 4);
+        }
+    }
+
+    std::vector<void*> raw_id_lists = {ids_t::create(ids1), ids_t::create(ids2), ids_t::create(ids3)};
+
+    std::vector<uint32_t> expected_ids;
+    ids_t::intersect(raw_id_lists, expected_ids);
+
+    for(size_t concurrency: {1, 2, 4}) {
+        id_list_t::result_iter_state_t iter_state;
+        std::vector<std::vector<uint32_t>> worker_ids(concurrency);
+
+        ids_t::block_intersector_t(raw_id_lists, iter_state, &pool).intersect([&](auto id, auto& its, size_t index) {
+            worker_ids[index].push_back(id);
+        }, concurrency);
+
+        std::vector<uint32_t> ids;
+        for(const auto& ids_of_worker: worker_ids) {
+            // a worker takes its partitions in order
+            ASSERT_TRUE(std::is_sorted(ids_of_worker.begin(), ids_of_worker.end()));
+            ids.insert(ids.end(), ids_of_worker.begin(), ids_of_worker.end());
+        }
+
+        std::sort(ids.begin(), ids.end());
+        ASSERT_EQ(expected_ids, ids);
+    }
+
+    for(auto raw_id_list: raw_id_lists) {
+        ids_t::destroy_list(raw_id_list);
+    }
+
+    pool.shutdown();
+}
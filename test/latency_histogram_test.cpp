@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "latency_histogram.h"
+
+TEST(LatencyHistogramTest, BucketsBoundTheRelativeError) {
+    for(uint64_t value = 0; value < (uint64_t(1) << latency_histogram_t::MAX_VALUE_BITS);
+        value = (value < 1000) ? value + 1 : value + value / 100) {
+        const size_t index = latency_histogram_t::bucket_index(value);
+        ASSERT_LT(index, latency_histogram_t::NUM_BUCKETS);
+
+        const uint64_t upper_bound = latency_histogram_t::bucket_upper_bound(index);
+        ASSERT_LE(value, upper_bound);
+        ASSERT_LE(upper_bound - value, value / latency_histogram_t::SUB_BUCKETS);
+
+        if(index != 0) {
+            ASSERT_LT(latency_histogram_t::bucket_upper_bound(index - 1), value);
+        }
+    }
+
+    ASSERT_EQ(latency_histogram_t::NUM_BUCKETS - 1, latency_histogram_t::bucket_index(UINT64_MAX));
+}
+
+TEST(LatencyHistogramTest, ConcurrentRecordsAndPercentiles) {
+    latency_histogram_t histogram;
+    std::vector<std::thread> threads;
+
+    for(size_t thread_id = 0; thread_id < 4; thread_id++) {
+        threads.emplace_back([&histogram]() {
+            for(uint64_t i = 1; i <= 10000; i++) {
+                histogram.record(i);
+            }
+        });
+    }
+
+    for(auto& thread: threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(40000, histogram.count());
+    ASSERT_EQ(4 * (uint64_t(10000) * 10001 / 2), histogram.sum());
+
+    std::vector<uint64_t> bucket_counts;
+    histogram.snapshot(bucket_counts);
+
+    ASSERT_NEAR(5000, latency_histogram_t::value_at_percentile(bucket_counts, 50), 5000 / 32);
+    ASSERT_NEAR(9900, latency_histogram_t::value_at_percentile(bucket_counts, 99), 9900 / 32);
+    ASSERT_EQ(0, latency_histogram_t::value_at_percentile(std::vector<uint64_t>(10), 99));
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "levenshtein_automaton.h"
+
+// walks the key along with its terminating '\0', as the keys of the ART are stored
+static levenshtein_automaton_t::action_t walk(levenshtein_automaton_t& automaton, const std::string& key) {
+    uint32_t state = levenshtein_automaton_t::INITIAL_STATE;
+
+    for(size_t i = 0; i <= key.size(); i++) {
+        auto action = automaton.step(state, (unsigned char) key.c_str()[i]);
+        if(action != levenshtein_automaton_t::CONTINUE) {
+            return action;
+        }
+    }
+
+    return levenshtein_automaton_t::REJECT;
+}
+
+// like the callers of `art_fuzzy_search`, a term is matched along with its '\0' unless it is a prefix
+static levenshtein_automaton_t make_automaton(const std::string& term, int min_cost, int max_cost, bool prefix) {
+    const int term_len = prefix ? term.size() : term.size() + 1;
+    return levenshtein_automaton_t((const unsigned char*) term.c_str(), term_len, min_cost, max_cost, prefix);
+}
+
+TEST(LevenshteinAutomatonTest, MatchesWithinCost) {
+    const std::string term = "pltinum";
+    auto automaton = make_automaton(term, 0, 1, false);
+
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(automaton, "platinum"));
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(automaton, "pltinum"));
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(automaton, "pltinux"));
+    ASSERT_EQ(levenshtein_automaton_t::REJECT, walk(automaton, "plutonium"));
+    ASSERT_EQ(levenshtein_automaton_t::REJECT, walk(automaton, "pl"));
+
+    auto typo_automaton = make_automaton(term, 1, 1, false);
+    ASSERT_EQ(levenshtein_automaton_t::REJECT, walk(typo_automaton, "pltinum"));
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(typo_automaton, "platinum"));
+}
+
+TEST(LevenshteinAutomatonTest, TranspositionCostsOne) {
+    const std::string term = "exmaple";
+    auto automaton = make_automaton(term, 0, 1, false);
+
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(automaton, "example"));
+    ASSERT_EQ(levenshtein_automaton_t::REJECT, walk(automaton, "exampel"));
+}
+
+TEST(LevenshteinAutomatonTest, PrefixMatchesLongerKeys) {
+    const std::string term = "plat";
+    auto automaton = make_automaton(term, 0, 0, true);
+
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(automaton, "platinum"));
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(automaton, "plat"));
+    ASSERT_EQ(levenshtein_automaton_t::REJECT, walk(automaton, "plot"));
+    ASSERT_EQ(levenshtein_automaton_t::REJECT, walk(automaton, "pla"));
+
+    auto exact_automaton = make_automaton(term, 0, 0, false);
+    ASSERT_EQ(levenshtein_automaton_t::REJECT, walk(exact_automaton, "platinum"));
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(exact_automaton, "plat"));
+}
+
+TEST(LevenshteinAutomatonTest, EndOfKeyInsideWalk) {
+    // a key that ends right after a state, without its '\0' being walked
+    const std::string term = "raspberries";
+    auto automaton = make_automaton(term, 0, 2, true);
+
+    uint32_t state = levenshtein_automaton_t::INITIAL_STATE;
+    for(char c: std::string("raspberry")) {
+        ASSERT_EQ(levenshtein_automaton_t::CONTINUE, automaton.step(state, c));
+    }
+
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, automaton.end(state));
+}
+
+TEST(LevenshteinAutomatonTest, KeysShareStates) {
+    const std::string term = "strawberry";
+    auto automaton = make_automaton(term, 0, 2, false);
+
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(automaton, "strawberry"));
+    const size_t num_states = automaton.num_states();
+
+    // chars that are not in the term all walk the same transitions
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(automaton, "strawberrx"));
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(automaton, "strawberrq"));
+    walk(automaton, "strawberrx");
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(automaton, "strawberry"));
+
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(automaton, "strawbery"));
+    const size_t num_states_after_typo = automaton.num_states();
+    ASSERT_EQ(levenshtein_automaton_t::ACCEPT, walk(automaton, "strawbery"));
+    ASSERT_EQ(num_states_after_typo, automaton.num_states());
+    ASSERT_LE(num_states, num_states_after_typo);
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include "memory_accounting.h"
+
+TEST(MemoryAccountingTest, StatsToJson) {
+    index_memory_stats_t stats;
+    stats.add(MEMORY_TEXT, 1000);
+    stats.add(MEMORY_FACET, 200);
+    stats.add(MEMORY_FACET, -50);
+
+    // a structure never goes below zero
+    stats.add(MEMORY_SORT, -10);
+
+    ASSERT_EQ(1000, stats.get(MEMORY_TEXT));
+    ASSERT_EQ(150, stats.get(MEMORY_FACET));
+    ASSERT_EQ(0, stats.get(MEMORY_SORT));
+    ASSERT_EQ(1150, stats.total());
+
+    nlohmann::json json = stats.to_json();
+    ASSERT_EQ(1000, json["text"].get<int64_t>());
+    ASSERT_EQ(150, json["facet"].get<int64_t>());
+    ASSERT_EQ(0, json["vector"].get<int64_t>());
+    ASSERT_EQ(1150, json["total"].get<int64_t>());
+
+    stats.clear();
+    ASSERT_EQ(0, stats.total());
+}
+
+TEST(MemoryAccountingTest, NestedScopesAccountOnce) {
+    if(memory_accounting_scope_t::thread_net_allocated() == 0) {
+        // allocation counters are not available, e.g. on ASAN builds
+        return ;
+    }
+
+    index_memory_stats_t stats;
+    std::unique_ptr<char[]> text_bytes, facet_bytes;
+
+    {
+        memory_accounting_scope_t text_scope(stats, MEMORY_TEXT);
+        text_bytes.reset(new char[64 * 1024]);
+
+        {
+            memory_accounting_scope_t facet_scope(stats, MEMORY_FACET);
+            facet_bytes.reset(new char[32 * 1024]);
+        }
+
+        // temporaries net out
+        std::unique_ptr<char[]> temp_bytes(new char[128 * 1024]);
+    }
+
+    ASSERT_GE(stats.get(MEMORY_TEXT), 64 * 1024);
+    ASSERT_LT(stats.get(MEMORY_TEXT), 64 * 1024 + 32 * 1024);
+    ASSERT_GE(stats.get(MEMORY_FACET), 32 * 1024);
+    ASSERT_LT(stats.get(MEMORY_FACET), 64 * 1024);
+
+    {
+        memory_accounting_scope_t facet_scope(stats, MEMORY_FACET);
+        facet_bytes.reset();
+    }
+
+    ASSERT_LT(stats.get(MEMORY_FACET), 1024);
+}
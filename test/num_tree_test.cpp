@@ -168,3 +168,109 @@ TEST(NumTreeTest, Iterator) {
     iterator.skip_to(100);
     ASSERT_FALSE(iterator.is_valid);
 }
+
+TEST(NumTreeTest, VisitValuesInOrder) {
+    num_tree_t tree;
+    tree.insert(10, 3);
+    tree.insert(-5, 1);
+    tree.insert(10, 1);
+    tree.insert(20, 2);
+
+    std::vector<int64_t> values;
+    std::vector<std::vector<uint32_t>> value_ids;
+    tree.visit_values_in_order(true, [&](int64_t value, const std::vector<uint32_t>& ids) {
+        values.push_back(value);
+        value_ids.push_back(ids);
+        return true;
+    });
+
+    ASSERT_EQ((std::vector<int64_t>{20, 10, -5}), values);
+    ASSERT_EQ((std::vector<uint32_t>{1, 3}), value_ids[1]);
+
+    values.clear();
+    tree.visit_values_in_order(false, [&](int64_t value, const std::vector<uint32_t>& ids) {
+        values.push_back(value);
+        return value < 10;
+    });
+
+    ASSERT_EQ((std::vector<int64_t>{-5, 10}), values);
+}
+
+TEST(NumTreeTest, InsertMany) {
+    num_tree_t tree;
+    tree.insert(5, 100);
+
+    std::vector<std::pair<int64_t, uint32_t>> values_ids;
+    for (uint32_t i = 0; i < 1000; i++) {
+        values_ids.emplace_back(i % 10, i);
+    }
+    values_ids.emplace_back(5, 100);
+
+    tree.insert_many(values_ids);
+    ASSERT_EQ(10, tree.size());
+
+    uint32_t* ids = nullptr;
+    size_t ids_len = 0;
+    tree.search(EQUALS, 5, &ids, ids_len);
+    ASSERT_EQ(101, ids_len);
+    delete [] ids;
+
+    // few new values are inserted into the existing tree
+    values_ids = {{3, 2000}, {1000, 2001}};
+    tree.insert_many(values_ids);
+    ASSERT_EQ(11, tree.size());
+
+    ids = nullptr;
+    ids_len = 0;
+    tree.search(GREATER_THAN_EQUALS, 9, &ids, ids_len);
+    ASSERT_EQ(101, ids_len);
+    ASSERT_EQ(2001, ids[ids_len - 1]);
+    delete [] ids;
+
+    ids = nullptr;
+    ids_len = 0;
+    tree.range_inclusive_search(3, 3, &ids, ids_len);
+    ASSERT_EQ(101, ids_len);
+    delete [] ids;
+}
+
+TEST(NumTreeTest, VisitIdsOfValues) {
+    num_tree_t tree;
+    for(uint32_t value = 0; value < 1000; value += 2) {
+        tree.insert(value, value + 1);
+        tree.insert(value, value + 2);
+    }
+
+    std::vector<std::pair<size_t, std::vector<uint32_t>>> visited;
+    auto visit_ids = [&](size_t value_index, const std::vector<uint32_t>& ids) {
+        visited.emplace_back(value_index, ids);
+    };
+
+    // few values are looked up
+    std::vector<uint32_t> values = {3, 4, 998, 1200};
+    tree.visit_ids_of_values(values.data(), values.size(), visit_ids);
+
+    ASSERT_EQ(2, visited.size());
+    ASSERT_EQ(1, visited[0].first);
+    ASSERT_EQ(std::vector<uint32_t>({5, 6}), visited[0].second);
+    ASSERT_EQ(2, visited[1].first);
+    ASSERT_EQ(std::vector<uint32_t>({999, 1000}), visited[1].second);
+
+    // many values are merged with the tree
+    values.clear();
+    for(uint32_t value = 1; value < 1000; value += 3) {
+        values.push_back(value);
+    }
+
+    visited.clear();
+    tree.visit_ids_of_values(values.data(), values.size(), visit_ids);
+
+    ASSERT_EQ(166, visited.size());
+    ASSERT_EQ(1, visited[0].first);
+    ASSERT_EQ(std::vector<uint32_t>({5, 6}), visited[0].second);
+
+    for(const auto& value_ids: visited) {
+        ASSERT_EQ(0, values[value_ids.first] % 2);
+        ASSERT_EQ(values[value_ids.first] + 1, value_ids.second[0]);
+    }
+}
@@ -639,6 +639,93 @@ TEST_F(NumericRangeTrieTest, IterateSearchEqualTo) {
     ASSERT_EQ(false, iterator.is_valid);
 }
 
+TEST_F(NumericRangeTrieTest, IterateSearchRangeMatchesArraySearch) {
+    auto trie = new NumericTrie();
+    std::unique_ptr<NumericTrie> trie_guard(trie);
+    std::map<uint32_t, std::vector<int64_t>> values;
+
+    // Dense ids with values spread over many nodes, and a few of them with multiple values.
+    for (uint32_t seq_id = 0; seq_id < 5000; seq_id++) {
+        values[seq_id].push_back((int64_t(seq_id) * 7919) % 200000 - 100000);
+        if (seq_id % 10 == 0) {
+            values[seq_id].push_back(int64_t(seq_id) * 3);
+        }
+    }
+
+    // Sparse ids.
+    for (uint32_t seq_id = 100000; seq_id < 10000000; seq_id += 99991) {
+        values[seq_id].push_back(seq_id % 1000);
+    }
+
+    for (auto const& kv: values) {
+        for (auto const& value: kv.second) {
+            trie->insert(value, kv.first);
+        }
+    }
+
+    std::vector<std::pair<int64_t, int64_t>> ranges = {
+            {-100000, 100000},
+            {-50000, -1},
+            {0, 999},
+            {500, 20000},
+            {-1, 0},
+            {12345, 12345},
+    };
+
+    for (auto const& range: ranges) {
+        std::vector<uint32_t> expected;
+        for (auto const& kv: values) {
+            for (auto const& value: kv.second) {
+                if (value >= range.first && value <= range.second) {
+                    expected.push_back(kv.first);
+                    break;
+                }
+            }
+        }
+
+        uint32_t* ids = nullptr;
+        uint32_t ids_length = 0;
+        trie->search_range(range.first, true, range.second, true, ids, ids_length);
+        ASSERT_EQ(expected, std::vector<uint32_t>(ids, ids + ids_length));
+        reset(ids, ids_length);
+
+        auto iterator = trie->search_range(range.first, true, range.second, true);
+        std::vector<uint32_t> iterated;
+        for (; iterator.is_valid; iterator.next()) {
+            iterated.push_back(iterator.seq_id);
+        }
+        ASSERT_EQ(expected, iterated);
+
+        if (expected.empty()) {
+            continue;
+        }
+
+        iterator.reset();
+        auto const target = expected[expected.size() / 2] + 1;
+        iterator.skip_to(target);
+
+        auto expected_it = std::lower_bound(expected.begin(), expected.end(), target);
+        if (expected_it == expected.end()) {
+            ASSERT_FALSE(iterator.is_valid);
+        } else {
+            ASSERT_TRUE(iterator.is_valid);
+            ASSERT_EQ(*expected_it, iterator.seq_id);
+        }
+    }
+
+    uint32_t* ids = nullptr;
+    uint32_t ids_length = 0;
+    trie->search_greater_than(0, true, ids, ids_length);
+
+    auto iterator = trie->search_greater_than(0, true);
+    std::vector<uint32_t> iterated;
+    for (; iterator.is_valid; iterator.next()) {
+        iterated.push_back(iterator.seq_id);
+    }
+    ASSERT_EQ(std::vector<uint32_t>(ids, ids + ids_length), iterated);
+    reset(ids, ids_length);
+}
+
 TEST_F(NumericRangeTrieTest, MultivalueData) {
     auto trie = new NumericTrie();
     std::unique_ptr<NumericTrie> trie_guard(trie);
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <set>
 #include <or_iterator.h>
 #include <posting_list.h>
 #include <posting.h>
@@ -328,3 +329,52 @@ TEST(OrIteratorTest, ContainsAtLeastOne) {
 
     delete filter_iterator;
 }
+
+TEST(OrIteratorTest, NextAndSkipToAcrossManyLists) {
+    std::vector<uint32_t> offsets = {0};
+    std::vector<posting_list_t*> postings;
+    std::set<uint32_t> expected_ids;
+
+    // an empty list and lists that share ids
+    for(size_t i = 0; i < 40; i++) {
+        postings.push_back(new posting_list_t(4));
+        for(uint32_t id = i; i != 0 && id < 1000; id += (i * 7)) {
+            postings.back()->upsert(id, offsets);
+            expected_ids.insert(id);
+        }
+    }
+
+    std::vector<posting_list_t::iterator_t> pits;
+    for(auto& posting_list: postings) {
+        pits.push_back(posting_list->new_iterator());
+    }
+
+    or_iterator_t or_it(pits);
+    std::vector<uint32_t> results;
+
+    while(or_it.valid()) {
+        results.push_back(or_it.id());
+        or_it.next();
+    }
+
+    ASSERT_EQ(std::vector<uint32_t>(expected_ids.begin(), expected_ids.end()), results);
+
+    pits.clear();
+    for(auto& posting_list: postings) {
+        pits.push_back(posting_list->new_iterator());
+    }
+
+    or_iterator_t skip_it(pits);
+    ASSERT_TRUE(skip_it.skip_to(500));
+    ASSERT_EQ(*expected_ids.lower_bound(500), skip_it.id());
+
+    ASSERT_TRUE(skip_it.skip_to(997));
+    ASSERT_EQ(*expected_ids.lower_bound(997), skip_it.id());
+
+    ASSERT_FALSE(skip_it.skip_to(1000));
+    ASSERT_FALSE(skip_it.valid());
+
+    for(auto p: postings) {
+        delete p;
+    }
+}
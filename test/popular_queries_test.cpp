@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "query_analytics.h"
 #include "logger.h"
+#include <algorithm>
 
 class PopularQueriesTest : public ::testing::Test {
 protected:
@@ -85,3 +86,70 @@ TEST_F(PopularQueriesTest, PrefixQueryCompaction) {
     ASSERT_EQ(1, local_counts.count("bar"));
     ASSERT_EQ(1, local_counts["bar"]);
 }
+
+TEST_F(PopularQueriesTest, TopKSketchRetainsHeavyHitters) {
+    space_saving_sketch_t sketch(3);
+
+    // heavy hitters arrive after the summary is already full of rare keys
+    sketch.add("a");
+    sketch.add("b");
+    sketch.add("c");
+
+    for(size_t i = 0; i < 10; i++) {
+        sketch.add("hot");
+        sketch.add("rare" + std::to_string(i));
+    }
+
+    for(size_t i = 0; i < 5; i++) {
+        sketch.add("warm");
+    }
+
+    for(size_t i = 0; i < 10; i++) {
+        sketch.add("hot");
+    }
+
+    ASSERT_EQ(3, sketch.size());
+
+    auto top_keys = sketch.top(2);
+    ASSERT_EQ(2, top_keys.size());
+    ASSERT_EQ("hot", top_keys[0].first);
+    ASSERT_EQ("warm", top_keys[1].first);
+
+    // counts are never under-estimated
+    ASSERT_LE(20, top_keys[0].second);
+    ASSERT_LE(5, top_keys[1].second);
+
+    space_saving_sketch_t other(3);
+    for(size_t i = 0; i < 20; i++) {
+        other.add("warm");
+    }
+
+    sketch.merge(other);
+    top_keys = sketch.top(1);
+    ASSERT_EQ("warm", top_keys[0].first);
+    ASSERT_LE(25, top_keys[0].second);
+    ASSERT_EQ(3, sketch.top(10).size());
+    ASSERT_EQ(3, sketch.size());
+}
+
+TEST_F(PopularQueriesTest, TopKSketchBoundsLocalCounts) {
+    QueryAnalytics pq(2);
+    pq.set_enable_top_k_sketch(true);
+
+    for(size_t i = 0; i < 100; i++) {
+        pq.add("foo", "foo", false, "0");
+        pq.add("q" + std::to_string(i), "q" + std::to_string(i), false, "0");
+    }
+
+    auto local_counts = pq.get_local_counts();
+    ASSERT_EQ(4, local_counts.size());
+    ASSERT_EQ(1, local_counts.count("foo"));
+    ASSERT_LE(100, local_counts["foo"]);
+
+    std::string docs;
+    pq.serialize_as_docs(docs);
+    ASSERT_EQ(3, std::count(docs.begin(), docs.end(), '\n'));
+
+    pq.reset_local_counts();
+    ASSERT_EQ(0, pq.get_local_counts().size());
+}
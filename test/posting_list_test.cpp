@@ -822,6 +822,44 @@ TEST_F(PostingListTest, IntersectionSkipBlocks) {
     delete [] final_results;
 }
 
+TEST_F(PostingListTest, IteratorSkipAndLazyOffsets) {
+    posting_list_t list(4);
+
+    for(uint32_t id = 0; id < 40; id += 2) {
+        std::vector<uint32_t> offsets = {id + 1, id + 2};
+        list.upsert(id, offsets);
+    }
+
+    auto it = list.new_iterator();
+
+    // within the first block
+    it.skip_to(3);
+    ASSERT_TRUE(it.valid());
+    ASSERT_EQ(4, it.id());
+    ASSERT_EQ(5, it.offset());
+
+    // across blocks, without reading any offsets of the skipped blocks
+    it.skip_to(21);
+    ASSERT_TRUE(it.valid());
+    ASSERT_EQ(22, it.id());
+
+    auto cloned_it = it.clone();
+    ASSERT_EQ(23, cloned_it.offset());
+    ASSERT_EQ(24, posting_list_t::get_last_offset(it, false));
+
+    it.next();
+    ASSERT_EQ(24, it.id());
+    ASSERT_EQ(25, it.offset());
+
+    it.skip_to(38);
+    ASSERT_TRUE(it.valid());
+    ASSERT_EQ(38, it.id());
+    ASSERT_EQ(39, it.offset());
+
+    it.skip_to(39);
+    ASSERT_FALSE(it.valid());
+}
+
 TEST_F(PostingListTest, PostingListContainsAtleastOne) {
     // when posting list is larger than target IDs
     posting_list_t p1(100);
@@ -997,6 +1035,79 @@ TEST_F(PostingListTest, PostingListSplitBlock) {
     }
 }
 
+TEST_F(PostingListTest, UpsertSortedBatches) {
+    posting_list_t pl(5);
+
+    // appends fill up their blocks: [0..8], then [10, 12] on the last block
+    std::vector<std::vector<uint32_t>> offsets = {{0}, {1, 2}, {3}, {4}, {5, 6, 7}};
+    std::vector<id_offsets_t> postings;
+    for(uint32_t i = 0; i < 7; i++) {
+        postings.emplace_back(i * 2, &offsets[i % offsets.size()]);
+    }
+
+    pl.upsert_sorted(postings.data(), postings.size());
+
+    ASSERT_EQ(7, pl.num_ids());
+    ASSERT_EQ(2, pl.num_blocks());
+    ASSERT_EQ(5, pl.get_root()->size());
+    ASSERT_EQ(2, pl.get_root()->next->size());
+
+    // a batch that updates and inserts in the middle splits the first block evenly
+    std::vector<uint32_t> new_offsets = {9, 10};
+    postings = {{1, &new_offsets}, {2, &new_offsets}, {3, &new_offsets}, {5, &new_offsets}, {13, &new_offsets}};
+    pl.upsert_sorted(postings.data(), postings.size());
+
+    ASSERT_EQ(11, pl.num_ids());
+    ASSERT_EQ(3, pl.num_blocks());
+    ASSERT_EQ(4, pl.get_root()->size());
+    ASSERT_EQ(4, pl.get_root()->next->size());
+    ASSERT_EQ(3, pl.get_root()->next->next->size());
+
+    std::vector<uint32_t> expected_ids = {0, 1, 2, 3, 4, 5, 6, 8, 10, 12, 13};
+    std::map<uint32_t, std::vector<uint32_t>> expected_offsets = {
+        {0, {0}}, {2, {9, 10}}, {4, {3}}, {6, {4}}, {8, {5, 6, 7}}, {10, {0}}, {12, {1, 2}}
+    };
+
+    auto it = pl.new_iterator();
+    for(size_t i = 0; i < expected_ids.size(); i++, it.next()) {
+        ASSERT_TRUE(it.valid());
+        ASSERT_EQ(expected_ids[i], it.id());
+
+        std::vector<uint32_t> positions;
+        posting_list_t::get_offsets(it, positions);
+        auto expected_it = expected_offsets.find(it.id());
+        ASSERT_EQ(expected_it == expected_offsets.end() ? new_offsets : expected_it->second, positions);
+    }
+
+    ASSERT_FALSE(it.valid());
+
+    for(auto block_it = pl.id_block_map.begin(); block_it != pl.id_block_map.end(); block_it++) {
+        ASSERT_EQ(block_it->first, block_it->second->ids.last());
+    }
+
+    // a compact list is converted once it outgrows its capacity, and the last posting of a repeated ID wins
+    void* obj = SET_COMPACT_POSTING(compact_posting_list_t::create(0, {}, {}, 0, {}));
+    std::vector<uint32_t> token_offsets = {0, 1, 2};
+    std::vector<uint32_t> repeated_offsets = {7};
+    postings.clear();
+    for(uint32_t i = 0; i < 100; i++) {
+        postings.emplace_back(99 - i, &token_offsets);
+    }
+    postings.emplace_back(50, &repeated_offsets);
+
+    posting_t::upsert_many(obj, postings);
+    ASSERT_FALSE(IS_COMPACT_POSTING(obj));
+    ASSERT_EQ(100, posting_t::num_ids(obj));
+
+    auto list_it = ((posting_list_t*) obj)->new_iterator();
+    list_it.skip_to(50);
+    std::vector<uint32_t> positions;
+    posting_list_t::get_offsets(list_it, positions);
+    ASSERT_EQ(repeated_offsets, positions);
+
+    posting_t::destroy_list(obj);
+}
+
 TEST_F(PostingListTest, CompactPostingListUpsertAppends) {
     uint32_t ids[] = {0, 1000, 1002};
     uint32_t offset_index[] = {0, 3, 6};
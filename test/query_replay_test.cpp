@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include "query_replay.h"
+
+TEST(QueryReplayTest, ParseSearchLogLine) {
+    const std::string line = "I20241015 10:00:00.000000 1234 http_server.cpp:526] event=search_request, "
+                             "client_ip=127.0.0.1, endpoint=GET /collections/books/documents/search?"
+                             "q=the lord&query_by=title&filter_by=year:>2000&, body=";
+
+    auto request_op = query_replay_t::parse_line(line);
+    ASSERT_TRUE(request_op.ok());
+    ASSERT_EQ("GET", request_op.get().method);
+    ASSERT_EQ("/collections/books/documents/search?q=the%20lord&query_by=title&filter_by=year%3A%3E2000",
+              request_op.get().path);
+    ASSERT_EQ("", request_op.get().body);
+
+    const std::string multi_search_line = "event=search_request, client_ip=127.0.0.1, endpoint=POST /multi_search?"
+                                          "query_by=title&, body={\"searches\": [{\"collection\": \"books\"}]}";
+
+    request_op = query_replay_t::parse_line(multi_search_line);
+    ASSERT_TRUE(request_op.ok());
+    ASSERT_EQ("POST", request_op.get().method);
+    ASSERT_EQ("/multi_search?query_by=title", request_op.get().path);
+    ASSERT_EQ("{\"searches\": [{\"collection\": \"books\"}]}", request_op.get().body);
+
+    // other lines of the log
+    request_op = query_replay_t::parse_line("I20241015 10:00:00.000000 1234 raft_server.cpp:10] Term: 2");
+    ASSERT_FALSE(request_op.ok());
+}
+
+TEST(QueryReplayTest, ParseJsonLine) {
+    auto request_op = query_replay_t::parse_line(
+            R"({"path": "/collections/books/documents/search", "params": {"q": "a&b", "per_page": 5}})");
+    ASSERT_TRUE(request_op.ok());
+    ASSERT_EQ("GET", request_op.get().method);
+    ASSERT_EQ("/collections/books/documents/search?per_page=5&q=a%26b", request_op.get().path);
+
+    request_op = query_replay_t::parse_line(R"({"path": "/multi_search", "body": {"searches": []}})");
+    ASSERT_TRUE(request_op.ok());
+    ASSERT_EQ("POST", request_op.get().method);
+    ASSERT_EQ(R"({"searches":[]})", request_op.get().body);
+
+    request_op = query_replay_t::parse_line(R"({"params": {"q": "a"}})");
+    ASSERT_FALSE(request_op.ok());
+    ASSERT_EQ("Request must be an object with a `path`.", request_op.error());
+}
+
+TEST(QueryReplayTest, StatsPercentiles) {
+    replay_stats_t stats;
+    for(uint64_t i = 1; i <= 100; i++) {
+        stats.add(i % 10 == 0 ? 503 : 200, i * 1000);
+    }
+    stats.add(0, 200 * 1000);
+
+    auto json = stats.to_json(2);
+    ASSERT_EQ(101, json["num_requests"].get<size_t>());
+    ASSERT_EQ(11, json["num_errors"].get<size_t>());
+    ASSERT_EQ(90, json["status_codes"]["200"].get<size_t>());
+    ASSERT_EQ(10, json["status_codes"]["503"].get<size_t>());
+    ASSERT_EQ(1, json["status_codes"]["0"].get<size_t>());
+    ASSERT_DOUBLE_EQ(50.5, json["qps"].get<double>());
+    ASSERT_DOUBLE_EQ(51, json["latency_ms"]["p50"].get<double>());
+    ASSERT_DOUBLE_EQ(100, json["latency_ms"]["p99"].get<double>());
+    ASSERT_DOUBLE_EQ(200, json["latency_ms"]["max"].get<double>());
+}
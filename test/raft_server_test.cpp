@@ -16,4 +16,109 @@ TEST(RaftServerTest, ResolveNodesConfigWithHostNames) {
     ASSERT_EQ("",
               ReplicationState::resolve_node_hosts("typesense-node-2.typesense-service.typesense-"
                                                    "namespace.svc.cluster.local:6107:6108"));
-}
\ No newline at end of file
+}
+
+TEST(RaftServerTest, EncodeAndDecodeWriteBatch) {
+    std::vector<std::string> serialized_reqs = {R"({"body":"{\"id\":\"0\"}"})", "", R"({"body":"{\"id\":\"1\"}"})"};
+    const std::string data = ReplicationState::encode_write_batch(serialized_reqs);
+
+    std::vector<std::string> decoded_reqs;
+    ASSERT_TRUE(ReplicationState::decode_write_batch(data, decoded_reqs));
+    ASSERT_EQ(serialized_reqs, decoded_reqs);
+
+    // a single serialized request is not a batch
+    decoded_reqs.clear();
+    ASSERT_FALSE(ReplicationState::decode_write_batch(serialized_reqs[0], decoded_reqs));
+
+    // truncated entry
+    decoded_reqs.clear();
+    ASSERT_FALSE(ReplicationState::decode_write_batch(data.substr(0, data.size() - 1), decoded_reqs));
+}
+
+TEST(RaftServerTest, CompressAndDecompressLogEntry) {
+    std::string data;
+    for(size_t i = 0; i < 1000; i++) {
+        data += R"({"id": ")" + std::to_string(i) + R"(", "title": "the quick brown fox jumps over the lazy dog"})" "\n";
+    }
+
+    std::string compressed_data;
+    ASSERT_TRUE(ReplicationState::compress_log_entry(data, compressed_data));
+    ASSERT_LT(compressed_data.size() * 4, data.size());
+
+    std::string uncompressed_data;
+    auto decompress_op = ReplicationState::decompress_log_entry(compressed_data, uncompressed_data);
+    ASSERT_TRUE(decompress_op.ok());
+    ASSERT_TRUE(decompress_op.get());
+    ASSERT_EQ(data, uncompressed_data);
+
+    // entries that were appended as they are
+    decompress_op = ReplicationState::decompress_log_entry(data, uncompressed_data);
+    ASSERT_TRUE(decompress_op.ok());
+    ASSERT_FALSE(decompress_op.get());
+
+    // too small to get any smaller
+    ASSERT_FALSE(ReplicationState::compress_log_entry("{}", compressed_data));
+
+    decompress_op = ReplicationState::decompress_log_entry(compressed_data.substr(0, compressed_data.size() / 2),
+                                                           uncompressed_data);
+    ASSERT_FALSE(decompress_op.ok());
+}
+
+TEST(RaftServerTest, EncodeAndDecodeLogFeed) {
+    std::vector<std::pair<int64_t, std::string>> entries = {
+        {41, R"({"body":"{\"id\":\"0\"}"})"}, {43, ""}, {int64_t(1) << 40, std::string("\x02TZL\x00\x01", 6)}
+    };
+
+    const std::string feed = ReplicationState::encode_log_feed(int64_t(1) << 41, entries);
+
+    int64_t committed_index = 0;
+    std::vector<std::pair<int64_t, std::string>> decoded_entries;
+    ASSERT_TRUE(ReplicationState::decode_log_feed(feed, committed_index, decoded_entries));
+    ASSERT_EQ(int64_t(1) << 41, committed_index);
+    ASSERT_EQ(entries, decoded_entries);
+
+    // no entries after the index of the learner
+    decoded_entries.clear();
+    ASSERT_TRUE(ReplicationState::decode_log_feed(ReplicationState::encode_log_feed(7, {}), committed_index,
+                                                  decoded_entries));
+    ASSERT_EQ(7, committed_index);
+    ASSERT_TRUE(decoded_entries.empty());
+
+    // truncated feed
+    decoded_entries.clear();
+    ASSERT_FALSE(ReplicationState::decode_log_feed(feed.substr(0, feed.size() - 1), committed_index,
+                                                   decoded_entries));
+    ASSERT_FALSE(ReplicationState::decode_log_feed("", committed_index, decoded_entries));
+}
+
+TEST(RaftServerTest, BatchForwardedWrites) {
+    ASSERT_TRUE(ReplicationState::is_batchable_forward("POST", "/collections/coll1/documents", R"({"id": "0"})"));
+    ASSERT_TRUE(ReplicationState::is_batchable_forward("POST", "/collections/coll1/documents?action=upsert",
+                                                       R"({"id": "0"})"));
+    ASSERT_FALSE(ReplicationState::is_batchable_forward("PUT", "/collections/coll1/documents", R"({"id": "0"})"));
+    ASSERT_FALSE(ReplicationState::is_batchable_forward("POST", "/collections/coll1/documents/import",
+                                                        R"({"id": "0"})"));
+    ASSERT_FALSE(ReplicationState::is_batchable_forward("POST", "/collections", R"({"name": "coll1"})"));
+    ASSERT_FALSE(ReplicationState::is_batchable_forward("POST", "/collections/coll1/documents",
+                                                        "{\"id\": \"0\"}\n{\"id\": \"1\"}"));
+    ASSERT_FALSE(ReplicationState::is_batchable_forward("POST", "/collections/coll1/documents", ""));
+
+    ASSERT_EQ("http://localhost:8108/collections/coll1/documents/import?return_doc=true",
+              ReplicationState::get_forward_batch_url("http://localhost:8108/collections/coll1/documents"));
+    ASSERT_EQ("http://localhost:8108/collections/coll1/documents/import?action=upsert&return_doc=true",
+              ReplicationState::get_forward_batch_url("http://localhost:8108/collections/coll1/documents?action=upsert"));
+
+    std::vector<std::pair<long, std::string>> results;
+    const std::string import_res = R"({"document":{"id":"0","title":"foo"},"success":true})" "\n"
+                                   R"({"code":409,"document":"{\"id\": \"1\"}","error":"A document with id 1 already exists.","success":false})";
+
+    ASSERT_FALSE(ReplicationState::split_forward_batch_response(import_res, 3, results));
+
+    results.clear();
+    ASSERT_TRUE(ReplicationState::split_forward_batch_response(import_res, 2, results));
+    ASSERT_EQ(2, results.size());
+    ASSERT_EQ(201, results[0].first);
+    ASSERT_EQ(R"({"id":"0","title":"foo"})", results[0].second);
+    ASSERT_EQ(409, results[1].first);
+    ASSERT_EQ(R"({"message":"A document with id 1 already exists."})", results[1].second);
+}
@@ -700,7 +700,8 @@ TEST_F(RateLimitManagerTest, TestInvalidRules) {
 
     EXPECT_FALSE(res.ok());
     EXPECT_EQ(400, res.code());
-    EXPECT_EQ("At least  one of `max_requests_1m` or `max_requests_1h` is required.", res.error());
+    EXPECT_EQ("At least one of `max_requests_1m`, `max_requests_1h`, `max_cpu_ms_1m`, `max_cpu_ms_1h`, "
+              "`max_bytes_scanned_1m` or `max_bytes_scanned_1h` is required.", res.error());
 
     res = manager->add_rule({
         {"action", "throttle"},
@@ -817,3 +818,127 @@ TEST_F(RateLimitManagerTest, TestOneToManyFillTest) {
 
     EXPECT_FALSE(manager->is_rate_limited({RateLimitedEntityType::api_key, "test1"}, {RateLimitedEntityType::ip, "0.0.0.1"}));
 }
+
+TEST_F(RateLimitManagerTest, TestConcurrentRequestsAreCountedExactly) {
+    manager->add_rule({
+        {"action", "throttle"},
+        {"api_keys", nlohmann::json::array({"test"})},
+        {"max_requests_1m", 100},
+        {"max_requests_1h", 1000}
+    });
+
+    std::atomic<size_t> num_allowed = 0;
+    std::vector<std::thread> threads;
+
+    for(size_t t = 0; t < 8; t++) {
+        threads.emplace_back([&]() {
+            for(size_t i = 0; i < 50; i++) {
+                if(!manager->is_rate_limited({RateLimitedEntityType::api_key, "test"},
+                                             {RateLimitedEntityType::ip, "0.0.0.1"})) {
+                    num_allowed++;
+                }
+            }
+        });
+    }
+
+    for(auto& thread: threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(100, num_allowed);
+    EXPECT_FALSE(manager->get_exceeded_entities_json().empty());
+}
+
+TEST_F(RateLimitManagerTest, TestThrottleOnRequestCost) {
+    auto res = manager->add_rule({
+        {"action", "throttle"},
+        {"api_keys", nlohmann::json::array({"test"})},
+        {"max_cpu_ms_1m", 10},
+        {"max_bytes_scanned_1h", 1000}
+    });
+
+    ASSERT_TRUE(res.ok());
+    ASSERT_EQ(10, res.get()["rule"]["max_cpu_ms_1m"].get<int64_t>());
+    ASSERT_EQ(1000, res.get()["rule"]["max_bytes_scanned_1h"].get<int64_t>());
+
+    res = manager->add_rule({
+        {"action", "throttle"},
+        {"api_keys", nlohmann::json::array({"test"})},
+        {"max_cpu_ms_1m", -1}
+    });
+
+    ASSERT_FALSE(res.ok());
+    ASSERT_EQ("Parameter `max_cpu_ms_1m` must be a positive integer.", res.error());
+
+    res = manager->add_rule({
+        {"action", "throttle"},
+        {"api_keys", nlohmann::json::array({"test"})},
+        {"max_bytes_scanned_1h", 0}
+    });
+
+    ASSERT_FALSE(res.ok());
+    ASSERT_EQ("Parameter `max_bytes_scanned_1h` must be a positive integer.", res.error());
+
+    const rate_limit_entity_t api_key_entity{RateLimitedEntityType::api_key, "test"};
+    const rate_limit_entity_t ip_entity{RateLimitedEntityType::ip, "0.0.0.1"};
+
+    request_cost_t cost;
+    cost.cpu_us = 6000;
+    cost.add_doc_hydrated(100);
+
+    // the budget is spent only by the requests that are done
+    EXPECT_FALSE(manager->is_rate_limited(api_key_entity, ip_entity));
+    manager->add_request_cost(api_key_entity, ip_entity, "coll1", cost);
+    EXPECT_FALSE(manager->is_rate_limited(api_key_entity, ip_entity));
+    manager->add_request_cost(api_key_entity, ip_entity, "coll1", cost);
+    EXPECT_TRUE(manager->is_rate_limited(api_key_entity, ip_entity));
+
+    // other API keys are not affected
+    EXPECT_FALSE(manager->is_rate_limited({RateLimitedEntityType::api_key, "test1"}, ip_entity));
+
+    changeBaseTimestamp(120);
+    EXPECT_FALSE(manager->is_rate_limited(api_key_entity, ip_entity));
+
+    // the bytes scanned are budgeted per hour
+    request_cost_t scan_cost;
+    scan_cost.posting_bytes_scanned = 1000;
+    manager->add_request_cost(api_key_entity, ip_entity, "coll2", scan_cost);
+    EXPECT_TRUE(manager->is_rate_limited(api_key_entity, ip_entity));
+
+    auto usage_json = manager->get_usage_json();
+    ASSERT_EQ(2, usage_json.size());
+
+    for(const auto& usage: usage_json) {
+        ASSERT_EQ("test", usage["api_key"]);
+        if(usage["collection"] == "coll1") {
+            ASSERT_EQ(2, usage["num_requests"].get<size_t>());
+            ASSERT_EQ(12000, usage["cpu_us"].get<size_t>());
+            ASSERT_EQ(2, usage["num_docs_hydrated"].get<size_t>());
+            ASSERT_EQ(200, usage["doc_bytes_hydrated"].get<size_t>());
+        } else {
+            ASSERT_EQ(1, usage["num_requests"].get<size_t>());
+            ASSERT_EQ(1000, usage["posting_bytes_scanned"].get<size_t>());
+        }
+    }
+}
+
+TEST_F(RateLimitManagerTest, TestRequestCostScope) {
+    request_cost_t cost;
+
+    {
+        request_cost_scope_t cost_scope(&cost);
+        ASSERT_EQ(&cost, request_cost);
+
+        // a nested scope of the same cost, as of a task run on the thread of the search, is not measured again
+        request_cost_scope_t nested_scope(&cost);
+
+        const uint64_t begin_cpu_us = request_cost_scope_t::thread_cpu_us();
+        while(request_cost_scope_t::thread_cpu_us() - begin_cpu_us < 2000) {
+
+        }
+    }
+
+    ASSERT_EQ(nullptr, request_cost);
+    ASSERT_LE(2000, cost.cpu_us.load());
+    ASSERT_GT(4000, cost.cpu_us.load());
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include "response_cache.h"
+#include "zlib.h"
+
+class ResponseCacheTest : public ::testing::Test {
+protected:
+    cached_res_t make_response(uint64_t hash, const std::string& body) {
+        cached_res_t res;
+        res.load(200, "application/json", body, std::chrono::high_resolution_clock::now(), 60, hash);
+        return res;
+    }
+
+    static bool always_fresh(const cached_res_t&) {
+        return true;
+    }
+};
+
+TEST_F(ResponseCacheTest, GetAndInsertAcrossShards) {
+    response_cache_t cache(4);
+    cache.capacity(100);
+
+    for(uint64_t hash = 0; hash < 8; hash++) {
+        cache.insert(hash, make_response(hash, "body" + std::to_string(hash)));
+    }
+
+    ASSERT_EQ(8, cache.size());
+
+    cached_res_t value;
+    for(uint64_t hash = 0; hash < 8; hash++) {
+        ASSERT_TRUE(cache.get(hash, value, always_fresh));
+        ASSERT_EQ("body" + std::to_string(hash), value.body);
+    }
+
+    ASSERT_FALSE(cache.get(100, value, always_fresh));
+
+    nlohmann::json metrics;
+    cache.get_metrics(metrics);
+    ASSERT_EQ("8", metrics["typesense_cache_hits"].get<std::string>());
+    ASSERT_EQ("1", metrics["typesense_cache_misses"].get<std::string>());
+    ASSERT_EQ("8", metrics["typesense_cache_entries"].get<std::string>());
+    ASSERT_EQ("2", metrics["typesense_cache_shard1_entries"].get<std::string>());
+
+    cache.clear();
+    ASSERT_EQ(0, cache.size());
+    ASSERT_FALSE(cache.get(1, value, always_fresh));
+}
+
+TEST_F(ResponseCacheTest, EvictionsAndInvalidations) {
+    response_cache_t cache(2);
+    cache.capacity(4);
+
+    // even hashes land on the first shard, which holds 2 entries
+    cache.insert(0, make_response(0, "a"));
+    cache.insert(2, make_response(2, "b"));
+    cache.insert(4, make_response(4, "c"));
+
+    cached_res_t value;
+    ASSERT_FALSE(cache.get(0, value, always_fresh));
+    ASSERT_TRUE(cache.get(4, value, always_fresh));
+
+    // a stale entry is evicted
+    ASSERT_FALSE(cache.get(2, value, [](const cached_res_t&) { return false; }));
+    ASSERT_FALSE(cache.get(2, value, always_fresh));
+
+    nlohmann::json metrics;
+    cache.get_metrics(metrics);
+    ASSERT_EQ("1", metrics["typesense_cache_shard1_evictions"].get<std::string>());
+    ASSERT_EQ("1", metrics["typesense_cache_shard1_invalidations"].get<std::string>());
+    ASSERT_EQ("0", metrics["typesense_cache_shard2_evictions"].get<std::string>());
+    ASSERT_EQ("1", metrics["typesense_cache_entries"].get<std::string>());
+}
+
+TEST_F(ResponseCacheTest, MemoryBudget) {
+    response_cache_t cache(1);
+    cache.capacity(100, 3 * (sizeof(cached_res_t) + 1024 + 16));
+
+    for(uint64_t hash = 0; hash < 5; hash++) {
+        cache.insert(hash, make_response(hash, std::string(1024, 'a')));
+    }
+
+    // only the 3 most recently inserted responses fit
+    ASSERT_EQ(3, cache.size());
+    ASSERT_GE(3 * (sizeof(cached_res_t) + 1024 + 16), cache.mem_bytes());
+
+    cached_res_t value;
+    ASSERT_FALSE(cache.get(1, value, always_fresh));
+    ASSERT_TRUE(cache.get(2, value, always_fresh));
+
+    // a response larger than the budget is still cached on its own
+    cache.insert(10, make_response(10, std::string(8192, 'b')));
+    ASSERT_EQ(1, cache.size());
+    ASSERT_TRUE(cache.get(10, value, always_fresh));
+
+    cache.clear();
+    ASSERT_EQ(0, cache.mem_bytes());
+}
+
+TEST_F(ResponseCacheTest, CompressLargeBodies) {
+    response_cache_t cache(1);
+    cache.capacity(100);
+    cache.set_compress_min_bytes(1024);
+
+    std::string large_body;
+    for(size_t i = 0; i < 200; i++) {
+        large_body += R"({"document": {"id": ")" + std::to_string(i) + R"(", "title": "The quick brown fox"}},)";
+    }
+
+    cache.insert(1, make_response(1, large_body));
+    cache.insert(2, make_response(2, "small"));
+
+    // the large body is held compressed
+    ASSERT_LT(cache.mem_bytes(), 2 * sizeof(cached_res_t) + large_body.size());
+
+    cached_res_t value;
+    ASSERT_TRUE(cache.get(1, value, always_fresh));
+    ASSERT_FALSE(value.compressed);
+    ASSERT_EQ(large_body, value.body);
+
+    ASSERT_TRUE(cache.get(2, value, always_fresh));
+    ASSERT_EQ("small", value.body);
+}
+
+TEST_F(ResponseCacheTest, KeepCompressedBodyAsGzip) {
+    response_cache_t cache(1);
+    cache.capacity(100);
+    cache.set_compress_min_bytes(1024);
+
+    std::string large_body;
+    for(size_t i = 0; i < 200; i++) {
+        large_body += R"({"document": {"id": ")" + std::to_string(i) + R"(", "title": "The quick brown fox"}},)";
+    }
+
+    cache.insert(1, make_response(1, large_body));
+    cache.insert(2, make_response(2, "small"));
+
+    cached_res_t value;
+    ASSERT_TRUE(cache.get(1, value, always_fresh, true));
+    ASSERT_TRUE(value.compressed);
+    ASSERT_EQ(large_body.size(), value.uncompressed_size);
+
+    // the body can be sent with the gzip encoding
+    ASSERT_EQ('\x1f', value.body[0]);
+    ASSERT_EQ('\x8b', value.body[1]);
+
+    z_stream stream{};
+    ASSERT_EQ(Z_OK, inflateInit2(&stream, 15 + 16));
+    std::string body(value.uncompressed_size, '\0');
+    stream.next_in = (Bytef*) value.body.data();
+    stream.avail_in = value.body.size();
+    stream.next_out = (Bytef*) body.data();
+    stream.avail_out = body.size();
+    ASSERT_EQ(Z_STREAM_END, inflate(&stream, Z_FINISH));
+    inflateEnd(&stream);
+    ASSERT_EQ(large_body, body);
+
+    // a small body is never compressed
+    ASSERT_TRUE(cache.get(2, value, always_fresh, true));
+    ASSERT_FALSE(value.compressed);
+    ASSERT_EQ("small", value.body);
+}
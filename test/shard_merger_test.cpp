@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "shard_merger.h"
+
+static nlohmann::json make_hit(const std::string& id, uint64_t text_match, int64_t points) {
+    nlohmann::json hit;
+    hit["document"]["id"] = id;
+    hit["document"]["points"] = points;
+    hit["text_match"] = text_match;
+    return hit;
+}
+
+TEST(ShardMergerTest, DefaultSortKeys) {
+    auto keys = shard_merger_t::get_sort_keys({}, false, false, "points");
+    ASSERT_EQ(2, keys.size());
+    ASSERT_EQ(shard_merger_t::TEXT_MATCH, keys[0].kind);
+    ASSERT_TRUE(keys[0].desc);
+    ASSERT_EQ(shard_merger_t::FIELD_VALUE, keys[1].kind);
+    ASSERT_EQ("points", keys[1].field_name);
+
+    keys = shard_merger_t::get_sort_keys({}, true, false, "");
+    ASSERT_EQ(1, keys.size());
+    ASSERT_EQ(shard_merger_t::UNSORTED, keys[0].kind);
+
+    std::vector<sort_by> sort_fields = {sort_by("location(48.85, 2.34)", "asc")};
+    keys = shard_merger_t::get_sort_keys(sort_fields, false, false, "points");
+    ASSERT_EQ(2, keys.size());
+    ASSERT_EQ(shard_merger_t::FIELD_VALUE, keys[0].kind);
+    ASSERT_EQ("location", keys[0].field_name);
+    ASSERT_FALSE(keys[0].desc);
+    ASSERT_EQ(shard_merger_t::TEXT_MATCH, keys[1].kind);
+}
+
+TEST(ShardMergerTest, MergeHitsAndFacets) {
+    nlohmann::json shard_0, shard_1;
+    shard_0["found"] = 3;
+    shard_0["out_of"] = 10;
+    shard_0["hits"] = {make_hit("0", 100, 5), make_hit("1", 80, 9), make_hit("2", 50, 1)};
+    shard_0["facet_counts"] = R"([{"field_name": "tags", "sampled": false,
+        "counts": [{"value": "a", "count": 3}, {"value": "b", "count": 1}],
+        "stats": {"total_values": 2}}])"_json;
+
+    shard_1["found"] = 2;
+    shard_1["out_of"] = 12;
+    shard_1["hits"] = {make_hit("3", 90, 2), make_hit("4", 80, 10)};
+    shard_1["facet_counts"] = R"([{"field_name": "tags", "sampled": false,
+        "counts": [{"value": "b", "count": 4}, {"value": "c", "count": 2}],
+        "stats": {"total_values": 2}}])"_json;
+
+    auto keys = shard_merger_t::get_sort_keys({}, false, false, "points");
+    nlohmann::json result = shard_merger_t::merge({shard_0, shard_1}, keys, 1, 3, 2, 0);
+
+    ASSERT_EQ(5, result["found"].get<size_t>());
+    ASSERT_EQ(22, result["out_of"].get<size_t>());
+
+    // the tie on text match is broken on points
+    ASSERT_EQ(3, result["hits"].size());
+    ASSERT_EQ("3", result["hits"][0]["document"]["id"]);
+    ASSERT_EQ("4", result["hits"][1]["document"]["id"]);
+    ASSERT_EQ("1", result["hits"][2]["document"]["id"]);
+
+    ASSERT_EQ(1, result["facet_counts"].size());
+    auto& counts = result["facet_counts"][0]["counts"];
+    ASSERT_EQ(2, counts.size());
+    ASSERT_EQ("b", counts[0]["value"]);
+    ASSERT_EQ(5, counts[0]["count"].get<size_t>());
+    ASSERT_EQ("a", counts[1]["value"]);
+    ASSERT_EQ(3, counts[1]["count"].get<size_t>());
+}
+
+TEST(ShardMergerTest, MergeGroups) {
+    nlohmann::json shard_0, shard_1;
+    shard_0["found"] = 2;
+    shard_0["found_docs"] = 3;
+    shard_0["grouped_hits"] = nlohmann::json::array();
+    shard_0["grouped_hits"].push_back({{"group_key", {"x"}}, {"found", 2},
+                                       {"hits", {make_hit("0", 100, 1), make_hit("1", 60, 1)}}});
+    shard_0["grouped_hits"].push_back({{"group_key", {"y"}}, {"found", 1}, {"hits", {make_hit("2", 70, 1)}}});
+
+    shard_1["found"] = 1;
+    shard_1["found_docs"] = 1;
+    shard_1["grouped_hits"] = nlohmann::json::array();
+    shard_1["grouped_hits"].push_back({{"group_key", {"x"}}, {"found", 1}, {"hits", {make_hit("3", 90, 1)}}});
+
+    auto keys = shard_merger_t::get_sort_keys({}, false, false, "");
+    nlohmann::json result = shard_merger_t::merge({shard_0, shard_1}, keys, 0, 10, 10, 2);
+
+    ASSERT_EQ(2, result["found"].get<size_t>());
+    ASSERT_EQ(4, result["found_docs"].get<size_t>());
+    ASSERT_EQ(2, result["grouped_hits"].size());
+
+    auto& group_x = result["grouped_hits"][0];
+    ASSERT_EQ("x", group_x["group_key"][0]);
+    ASSERT_EQ(3, group_x["found"].get<size_t>());
+    ASSERT_EQ(2, group_x["hits"].size());
+    ASSERT_EQ("0", group_x["hits"][0]["document"]["id"]);
+    ASSERT_EQ("3", group_x["hits"][1]["document"]["id"]);
+
+    ASSERT_EQ("y", result["grouped_hits"][1]["group_key"][0]);
+}
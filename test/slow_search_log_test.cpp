@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "slow_search_log.h"
+
+TEST(SlowSearchLogTest, NormalizeFilter) {
+    ASSERT_EQ("price:>? && tags:[?]", SlowSearchLog::normalize_filter("price:>100 && tags:[a, `b,c`]"));
+    ASSERT_EQ("(price:>=? || title:=?) && in_stock:?",
+              SlowSearchLog::normalize_filter("(price:>=10.5 || title:=`The Lord`) && in_stock:true"));
+    ASSERT_EQ("tags:!=[?]", SlowSearchLog::normalize_filter("tags:!=[x,y]"));
+    ASSERT_EQ("location:(?)", SlowSearchLog::normalize_filter("location:(48.90, 2.33, 5 km)"));
+    ASSERT_EQ("$authors(name:?) && year: ?", SlowSearchLog::normalize_filter("$authors(name:foo) && year: 2020"));
+    ASSERT_EQ("year:?", SlowSearchLog::normalize_filter("year:2020"));
+    ASSERT_EQ("year:", SlowSearchLog::normalize_filter("year:"));
+}
+
+TEST(SlowSearchLogTest, Fingerprint) {
+    std::map<std::string, std::string> params = {
+        {"collection", "books"}, {"q", "lord of the rings"}, {"query_by", "title"},
+        {"filter_by", "year:>2000"}, {"page", "3"}, {"x-typesense-api-key", "abcd"},
+        {"vector_query", "embedding:([0.1, 0.2], k: 10)"}
+    };
+
+    ASSERT_EQ("filter_by=year:>?&page=?&q=?&query_by=title&vector_query=embedding:(?)",
+              SlowSearchLog::fingerprint(params));
+
+    // the same shape with other literals
+    auto other_params = params;
+    other_params["q"] = "hobbit";
+    other_params["filter_by"] = "year:>1950";
+    other_params["page"] = "1";
+    ASSERT_EQ(SlowSearchLog::fingerprint(params), SlowSearchLog::fingerprint(other_params));
+
+    other_params["q"] = "*";
+    ASSERT_NE(SlowSearchLog::fingerprint(params), SlowSearchLog::fingerprint(other_params));
+}
+
+TEST(SlowSearchLogTest, FingerprintStats) {
+    auto& slow_search_log = SlowSearchLog::get_instance();
+    slow_search_log.clear();
+
+    for(size_t i = 1; i <= 100; i++) {
+        slow_search_log.record("books", "q=?&query_by=title", i * 1000, i > 95);
+    }
+    slow_search_log.record("books", "q=*", 500 * 1000, true);
+
+    auto stats = slow_search_log.get_stats(10);
+    ASSERT_EQ(2, stats["fingerprints"].size());
+    ASSERT_EQ(0, stats["untracked_searches"].get<size_t>());
+
+    // ordered by total time
+    const auto& top = stats["fingerprints"][0];
+    ASSERT_EQ("q=?&query_by=title", top["fingerprint"].get<std::string>());
+    ASSERT_EQ("books", top["collection"].get<std::string>());
+    ASSERT_EQ(100, top["count"].get<size_t>());
+    ASSERT_EQ(5, top["slow_count"].get<size_t>());
+    ASSERT_NEAR(50, top["p50_ms"].get<double>(), 2);
+    ASSERT_NEAR(99, top["p99_ms"].get<double>(), 4);
+
+    ASSERT_EQ(1, slow_search_log.get_stats(1)["fingerprints"].size());
+
+    nlohmann::json result = {{"found", 42}, {"out_of", 1000}, {"hits", {1, 2, 3}}, {"search_cutoff", false}};
+    nlohmann::json profile = {{"phases_us", {{"matching", 1200}}}, {"typo_candidates", {{"0", 12}}}};
+    auto record = SlowSearchLog::slow_search_record("books", "q=*", 1500, result, profile);
+    ASSERT_EQ(42, record["found"].get<size_t>());
+    ASSERT_EQ(3, record["num_hits"].get<size_t>());
+    ASSERT_EQ(1500, record["time_ms"].get<size_t>());
+    ASSERT_EQ(1200, record["phases_us"]["matching"].get<size_t>());
+    ASSERT_EQ(12, record["typo_candidates"]["0"].get<size_t>());
+
+    slow_search_log.clear();
+}
+
+TEST(SlowSearchLogTest, FrequentSearches) {
+    auto& slow_search_log = SlowSearchLog::get_instance();
+    slow_search_log.clear();
+
+    std::map<std::string, std::string> params = {{"collection", "books"}, {"q", "harry"}, {"query_by", "title"},
+                                                 {"x-typesense-api-key", "abcd"}};
+    std::map<std::string, std::string> other_params = {{"collection", "books"}, {"q", "*"}};
+
+    slow_search_log.record("books", SlowSearchLog::fingerprint(other_params), 1000, false, other_params);
+    for(size_t i = 0; i < 3; i++) {
+        slow_search_log.record("books", SlowSearchLog::fingerprint(params), 1000, false, params);
+    }
+
+    // the sample is the first search of a fingerprint
+    params["q"] = "potter";
+    slow_search_log.record("books", SlowSearchLog::fingerprint(params), 1000, false, params);
+
+    auto searches = slow_search_log.get_frequent_searches(10);
+    ASSERT_EQ(2, searches.size());
+    ASSERT_EQ("books", searches[0]["collection"].get<std::string>());
+    ASSERT_EQ(2, searches[0]["params"].size());
+    ASSERT_EQ("harry", searches[0]["params"]["q"].get<std::string>());
+    ASSERT_EQ("title", searches[0]["params"]["query_by"].get<std::string>());
+    ASSERT_EQ("*", searches[1]["params"]["q"].get<std::string>());
+
+    ASSERT_EQ(1, slow_search_log.get_frequent_searches(1).size());
+
+    slow_search_log.clear();
+}
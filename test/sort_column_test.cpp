@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include "sort_column.h"
+
+TEST(SortColumnTest, SparseValuesStayInHashMap) {
+    sort_column_t column;
+
+    for(uint32_t i = 0; i < 2048; i++) {
+        ASSERT_TRUE(column.emplace(i * 1000, -int64_t(i)));
+    }
+
+    ASSERT_FALSE(column.dense());
+    ASSERT_EQ(2048, column.size());
+    ASSERT_EQ(-5, column.at(5000));
+    ASSERT_EQ(1, column.count(5000));
+    ASSERT_EQ(0, column.count(5001));
+    ASSERT_TRUE(column.find(5001) == column.end());
+    ASSERT_THROW(column.at(5001), std::out_of_range);
+}
+
+TEST(SortColumnTest, DenseValuesMoveToArray) {
+    sort_column_t column;
+
+    for(uint32_t seq_id = 0; seq_id < 5000; seq_id++) {
+        if(seq_id % 3 != 0) {
+            column.emplace(seq_id, seq_id * 10);
+        }
+    }
+
+    ASSERT_TRUE(column.dense());
+    ASSERT_EQ(3333, column.size());
+
+    auto it = column.find(7);
+    ASSERT_TRUE(it != column.end());
+    ASSERT_EQ(7, it->first);
+    ASSERT_EQ(70, it->second);
+
+    ASSERT_TRUE(column.find(9) == column.end());
+    ASSERT_TRUE(column.find(1000 * 1000) == column.end());
+    ASSERT_THROW(column.at(9), std::out_of_range);
+
+    // existing value is not overwritten
+    ASSERT_FALSE(column.emplace(7, 1));
+    ASSERT_EQ(70, column.at(7));
+
+    ASSERT_EQ(1, column.erase(7));
+    ASSERT_EQ(0, column.erase(7));
+    ASSERT_EQ(0, column.count(7));
+    ASSERT_TRUE(column.emplace(7, 1));
+    ASSERT_EQ(1, column.at(7));
+
+    // grows past the current end
+    ASSERT_TRUE(column.emplace(100 * 1000, INT64_MIN));
+    ASSERT_EQ(INT64_MIN, column.at(100 * 1000));
+    ASSERT_EQ(3334, column.size());
+}
+
+TEST(SortColumnTest, RandomOperationsMatchMap) {
+    std::mt19937 rng(42);
+
+    for(size_t round = 0; round < 10; round++) {
+        sort_column_t column;
+        std::map<uint32_t, int64_t> expected;
+        const uint32_t range = (round % 2 == 0) ? 3000 : 1000 * 1000;
+
+        for(size_t op = 0; op < 20000; op++) {
+            const uint32_t seq_id = rng() % range;
+            const int64_t value = int64_t(rng()) - INT32_MAX;
+
+            if(rng() % 4 != 0) {
+                ASSERT_EQ(expected.emplace(seq_id, value).second, column.emplace(seq_id, value));
+            } else {
+                ASSERT_EQ(expected.erase(seq_id), column.erase(seq_id));
+            }
+        }
+
+        ASSERT_EQ(round % 2 == 0, column.dense());
+        ASSERT_EQ(expected.size(), column.size());
+
+        for(uint32_t seq_id = 0; seq_id < std::min<uint32_t>(range, 5000); seq_id++) {
+            auto expected_it = expected.find(seq_id);
+            auto it = column.find(seq_id);
+            ASSERT_EQ(expected_it == expected.end(), it == column.end());
+            if(expected_it != expected.end()) {
+                ASSERT_EQ(expected_it->second, it->second);
+            }
+        }
+    }
+}
+
+TEST(SortColumnTest, DenseValuesArePackedToTheirWidth) {
+    sort_column_t column;
+
+    for(uint32_t seq_id = 0; seq_id < 2048; seq_id++) {
+        column.emplace(seq_id, seq_id % 2);
+    }
+
+    ASSERT_TRUE(column.dense());
+    ASSERT_EQ(1, column.width());
+
+    ASSERT_TRUE(column.emplace(3000, -1000));
+    ASSERT_EQ(2, column.width());
+
+    ASSERT_TRUE(column.emplace(3001, INT32_MIN));
+    ASSERT_EQ(4, column.width());
+
+    ASSERT_TRUE(column.emplace(3002, int64_t(INT32_MAX) + 1));
+    ASSERT_EQ(8, column.width());
+
+    // values are kept across the widening
+    for(uint32_t seq_id = 0; seq_id < 2048; seq_id++) {
+        ASSERT_EQ(seq_id % 2, column.at(seq_id));
+    }
+
+    ASSERT_EQ(-1000, column.at(3000));
+    ASSERT_EQ(INT32_MIN, column.at(3001));
+    ASSERT_EQ(int64_t(INT32_MAX) + 1, column.at(3002));
+    ASSERT_EQ(0, column.count(2999));
+}
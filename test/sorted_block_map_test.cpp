@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include "sorted_block_map.h"
+
+TEST(SortedBlockMapTest, InsertFindAndIterate) {
+    sorted_block_map_t<int64_t, uint32_t, 8> map;
+    ASSERT_TRUE(map.empty());
+    ASSERT_TRUE(map.begin() == map.end());
+    ASSERT_TRUE(map.rbegin() == map.rend());
+
+    for(int64_t i = 100; i > 0; i--) {
+        ASSERT_TRUE(map.emplace(i * 2, i).second);
+    }
+
+    ASSERT_EQ(100, map.size());
+    ASSERT_FALSE(map.emplace(10, 0).second);
+    ASSERT_EQ(5, map.find(10)->second);
+    ASSERT_TRUE(map.find(11) == map.end());
+    ASSERT_EQ(12, map.lower_bound(11)->first);
+    ASSERT_TRUE(map.lower_bound(201) == map.end());
+    ASSERT_EQ(1, map.count(200));
+
+    int64_t expected_key = 2;
+    for(auto& kv: map) {
+        ASSERT_EQ(expected_key, kv.first);
+        expected_key += 2;
+    }
+
+    expected_key = 200;
+    for(auto it = map.rbegin(); it != map.rend(); ++it) {
+        ASSERT_EQ(expected_key, it->first);
+        expected_key -= 2;
+    }
+
+    map.find(4)->second = 1000;
+    ASSERT_EQ(1000, map.find(4)->second);
+}
+
+TEST(SortedBlockMapTest, BulkLoad) {
+    sorted_block_map_t<int64_t, uint32_t, 8> map;
+    map.emplace(1, 1);
+
+    std::vector<std::pair<int64_t, uint32_t>> entries;
+    for(int64_t i = 0; i < 50; i++) {
+        entries.emplace_back(i * 3, i);
+    }
+
+    map.bulk_load(std::move(entries));
+    ASSERT_EQ(50, map.size());
+    ASSERT_TRUE(map.find(1) == map.end());
+    ASSERT_EQ(7, map.find(21)->second);
+
+    ASSERT_TRUE(map.emplace(22, 100).second);
+    ASSERT_EQ(22, (++map.find(21))->first);
+    ASSERT_EQ(1, map.erase(22));
+    ASSERT_EQ(0, map.erase(22));
+    ASSERT_EQ(50, map.size());
+}
+
+TEST(SortedBlockMapTest, RandomOperationsMatchStdMap) {
+    std::mt19937 rng(42);
+    sorted_block_map_t<int64_t, uint32_t, 16> map;
+    std::map<int64_t, uint32_t> expected;
+
+    for(size_t op = 0; op < 50000; op++) {
+        const int64_t key = int64_t(rng() % 2000) - 1000;
+
+        if(rng() % 3 != 0) {
+            const uint32_t value = rng();
+            ASSERT_EQ(expected.emplace(key, value).second, map.emplace(key, value).second);
+        } else {
+            ASSERT_EQ(expected.erase(key), map.erase(key));
+        }
+
+        if(op % 1000 == 0) {
+            ASSERT_EQ(expected.size(), map.size());
+            auto it = map.begin();
+            for(const auto& kv: expected) {
+                ASSERT_TRUE(it != map.end());
+                ASSERT_EQ(kv.first, it->first);
+                ASSERT_EQ(kv.second, it->second);
+                ++it;
+            }
+            ASSERT_TRUE(it == map.end());
+
+            auto expected_it = expected.lower_bound(key);
+            auto lb_it = map.lower_bound(key);
+            ASSERT_EQ(expected_it == expected.end(), lb_it == map.end());
+            if(expected_it != expected.end()) {
+                ASSERT_EQ(expected_it->first, lb_it->first);
+            }
+        }
+    }
+
+    // remove everything
+    for(const auto& kv: expected) {
+        ASSERT_EQ(1, map.erase(kv.first));
+    }
+
+    ASSERT_TRUE(map.empty());
+    ASSERT_TRUE(map.begin() == map.end());
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "stemmer_manager.h"
+
+class StemmerManagerTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        Stemmer::set_max_entries(Stemmer::DEFAULT_MAX_ENTRIES);
+        StemmerManager::get_instance().delete_all_stemmers();
+    }
+};
+
+TEST_F(StemmerManagerTest, CachedStemsAreReturned) {
+    auto stemmer = StemmerManager::get_instance().get_stemmer("english");
+
+    nlohmann::json metrics;
+    Stemmer::get_metrics(metrics);
+    const uint64_t hits = std::stoull(metrics["typesense_stem_cache_hits"].get<std::string>());
+    const uint64_t misses = std::stoull(metrics["typesense_stem_cache_misses"].get<std::string>());
+
+    ASSERT_EQ("run", stemmer->stem("running"));
+    ASSERT_EQ("run", stemmer->stem("running"));
+    ASSERT_EQ("jump", stemmer->stem("jumps"));
+
+    Stemmer::get_metrics(metrics);
+    ASSERT_EQ(hits + 1, std::stoull(metrics["typesense_stem_cache_hits"].get<std::string>()));
+    ASSERT_EQ(misses + 2, std::stoull(metrics["typesense_stem_cache_misses"].get<std::string>()));
+
+    // english is the default language
+    ASSERT_EQ(stemmer, StemmerManager::get_instance().get_stemmer(""));
+}
+
+TEST_F(StemmerManagerTest, ConcurrentStemming) {
+    Stemmer::set_max_entries(0);
+    auto stemmer = StemmerManager::get_instance().get_stemmer("english");
+
+    std::vector<std::thread> threads;
+    std::atomic<size_t> num_mismatches = 0;
+
+    for(size_t t = 0; t < 4; t++) {
+        threads.emplace_back([&]() {
+            for(size_t i = 0; i < 1000; i++) {
+                if(stemmer->stem("connections") != "connect" || stemmer->stem("running") != "run") {
+                    num_mismatches++;
+                }
+            }
+        });
+    }
+
+    for(auto& thread: threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(0, num_mismatches);
+}
@@ -102,6 +102,32 @@ TEST_F(StopwordsManagerTest, GetStopword) {
     ASSERT_EQ(4, stopwordStruct.stopwords.size()); //as United States will be tokenized and counted 2 stopwords
 }
 
+TEST_F(StopwordsManagerTest, GetCompiledStopwords) {
+    auto stopwords = R"({"stopwords": ["India", "United States", "Japan"], "locale": "en"})"_json;
+    ASSERT_TRUE(stopwordsManager.upsert_stopword("country", stopwords).ok());
+
+    auto compiled_stopwords = stopwordsManager.get_compiled_stopwords("country");
+    ASSERT_NE(nullptr, compiled_stopwords);
+    ASSERT_EQ(4, compiled_stopwords->size());
+
+    for(const auto& token: {"india", "united", "states", "japan"}) {
+        ASSERT_TRUE(compiled_stopwords->contains(token));
+    }
+
+    for(const auto& token: {"", "indi", "indias", "china", "India"}) {
+        ASSERT_FALSE(compiled_stopwords->contains(token));
+    }
+
+    ASSERT_EQ(nullptr, stopwordsManager.get_compiled_stopwords("continents"));
+
+    // a search holding the compiled set of a config keeps it when the config is updated
+    stopwords = R"({"stopwords": ["China"], "locale": "en"})"_json;
+    ASSERT_TRUE(stopwordsManager.upsert_stopword("country", stopwords).ok());
+    ASSERT_TRUE(compiled_stopwords->contains("japan"));
+    ASSERT_FALSE(stopwordsManager.get_compiled_stopwords("country")->contains("japan"));
+    ASSERT_TRUE(stopwordsManager.get_compiled_stopwords("country")->contains("china"));
+}
+
 TEST_F(StopwordsManagerTest, DeleteStopword) {
     auto stopwords1 = R"(
                 {"stopwords": ["america", "europe"], "locale": "en"}
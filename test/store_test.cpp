@@ -165,4 +165,162 @@ TEST(StoreTest, Contains) {
     ASSERT_EQ(true, primary_store.contains("foo4"));
     ASSERT_EQ(false, primary_store.contains("foo"));
     ASSERT_EQ(false, primary_store.contains("foo5"));
-}
\ No newline at end of file
+}
+
+TEST(StoreTest, MultiGet) {
+    std::string primary_store_path = "/tmp/typesense_test/primary_store_test";
+    LOG(INFO) << "Truncating and creating: " << primary_store_path;
+    system(("rm -rf "+primary_store_path+" && mkdir -p "+primary_store_path).c_str());
+
+    Store primary_store(primary_store_path, 0, 0, true);  // disable WAL
+    primary_store.insert("foo1", "bar1");
+    primary_store.insert("foo2", "bar2");
+
+    std::vector<std::string> values;
+    std::vector<StoreStatus> statuses;
+    primary_store.multi_get({"foo2", "foo3", "foo1"}, values, statuses);
+
+    ASSERT_EQ(3, statuses.size());
+    ASSERT_EQ(StoreStatus::FOUND, statuses[0]);
+    ASSERT_EQ("bar2", values[0]);
+    ASSERT_EQ(StoreStatus::NOT_FOUND, statuses[1]);
+    ASSERT_EQ(StoreStatus::FOUND, statuses[2]);
+    ASSERT_EQ("bar1", values[2]);
+}
+
+TEST(StoreTest, MergeDocumentPatches) {
+    std::string primary_store_path = "/tmp/typesense_test/primary_store_test";
+    LOG(INFO) << "Truncating and creating: " << primary_store_path;
+    system(("rm -rf "+primary_store_path+" && mkdir -p "+primary_store_path).c_str());
+
+    Store primary_store(primary_store_path, 0, 0, true);  // disable WAL
+    primary_store.insert("doc1", R"({"id":"1","points":10,"tags":["a"],"meta":{"x":1,"y":2}})");
+
+    std::string msgpack_doc(1, '\0');
+    nlohmann::json::to_msgpack(nlohmann::json::parse(R"({"id":"2","points":20})"), msgpack_doc);
+    primary_store.insert("doc2", msgpack_doc);
+
+    rocksdb::WriteBatch batch;
+    batch.Merge("doc1", StoreMergeOperator::doc_patch_operand(R"({"points":11,"meta":{"y":null}})"));
+    batch.Merge("doc1", StoreMergeOperator::doc_patch_operand(R"({"tags":["a","b"]})"));
+    batch.Merge("doc2", StoreMergeOperator::doc_patch_operand(R"({"points":21})"));
+    ASSERT_TRUE(primary_store.batch_write(batch));
+
+    std::string value;
+    ASSERT_EQ(StoreStatus::FOUND, primary_store.get("doc1", value));
+    ASSERT_EQ(nlohmann::json::parse(R"({"id":"1","points":11,"tags":["a","b"],"meta":{"x":1}})"),
+              nlohmann::json::parse(value));
+
+    // the format of the stored document is kept
+    ASSERT_EQ(StoreStatus::FOUND, primary_store.get("doc2", value));
+    ASSERT_EQ('\0', value[0]);
+    ASSERT_EQ(21, nlohmann::json::from_msgpack(value.begin() + 1, value.end())["points"].get<int>());
+
+    // counters are merged as before
+    primary_store.increment("counter", 5);
+    primary_store.increment("counter", 7);
+    ASSERT_EQ(StoreStatus::FOUND, primary_store.get("counter", value));
+    ASSERT_EQ(12, StringUtils::deserialize_uint32_t(value));
+}
+
+TEST(StoreTest, SharedBlockCacheAndFilters) {
+    std::string primary_store_path = "/tmp/typesense_test/primary_store_test";
+    std::string meta_store_path = "/tmp/typesense_test/meta_store_test";
+    system(("rm -rf "+primary_store_path+" "+meta_store_path+" && mkdir -p "+primary_store_path+" "+
+            meta_store_path).c_str());
+
+    store_tuning_t tuning;
+    tuning.block_cache = rocksdb::NewLRUCache(8 * 1024 * 1024);
+    tuning.bloom_bits_per_key = 10;
+    tuning.row_cache_mb = 1;
+
+    Store primary_store(primary_store_path, 0, 0, true, tuning);
+    Store meta_store(meta_store_path, 0, 0, false, tuning);
+
+    primary_store.insert("foo1", "bar1");
+    meta_store.insert("foo2", "bar2");
+    primary_store.flush();
+    meta_store.flush();
+
+    std::string value;
+    ASSERT_EQ(StoreStatus::FOUND, primary_store.get("foo1", value));
+    ASSERT_EQ("bar1", value);
+    ASSERT_EQ(StoreStatus::FOUND, meta_store.get("foo2", value));
+    ASSERT_EQ("bar2", value);
+
+    ASSERT_TRUE(primary_store.contains("foo1"));
+    ASSERT_FALSE(primary_store.contains("foo2"));
+
+    // both stores read their blocks through the shared cache
+    ASSERT_GT(tuning.block_cache->GetUsage(), 0);
+}
+
+TEST(StoreTest, CompactRanges) {
+    std::string primary_store_path = "/tmp/typesense_test/primary_store_test";
+    LOG(INFO) << "Truncating and creating: " << primary_store_path;
+    system(("rm -rf "+primary_store_path+" && mkdir -p "+primary_store_path).c_str());
+
+    store_tuning_t tuning;
+    tuning.rate_limiter.reset(rocksdb::NewGenericRateLimiter(64 * 1024 * 1024));
+    Store primary_store(primary_store_path, 0, 0, true, tuning);
+
+    for(size_t i = 0; i < 100; i++) {
+        primary_store.insert("0_" + std::to_string(i), "bar");
+        primary_store.insert("1_" + std::to_string(i), "bar");
+    }
+
+    primary_store.flush();
+
+    ASSERT_TRUE(primary_store.compact_ranges({{"0_", "0`"}, {"1_", "1`"}}).ok());
+
+    auto progress = primary_store.get_compaction_progress();
+    ASSERT_FALSE(progress.running);
+    ASSERT_EQ(2, progress.ranges_compacted);
+    ASSERT_EQ(2, progress.ranges_total);
+    ASSERT_NE(0, progress.started_at_s);
+
+    ASSERT_TRUE(primary_store.compact_ranges_async({}));
+
+    while(primary_store.get_compaction_progress().running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    progress = primary_store.get_compaction_progress();
+    ASSERT_EQ(1, progress.ranges_compacted);
+    ASSERT_EQ(1, progress.ranges_total);
+
+    std::string value;
+    ASSERT_EQ(StoreStatus::FOUND, primary_store.get("1_99", value));
+}
+
+TEST(StoreTest, SstFileIds) {
+    std::string store_path = "/tmp/typesense_test/sst_file_ids_store_test";
+    system(("rm -rf "+store_path+" && mkdir -p "+store_path).c_str());
+
+    std::map<std::string, std::string> file_ids;
+
+    {
+        Store store(store_path, 24*60*60, 1024, false);
+        store.get_sst_file_ids(file_ids);
+        ASSERT_TRUE(file_ids.empty());
+
+        store.insert("foo1", "bar1");
+        store.flush();
+        store.insert("foo2", "bar2");
+        store.flush();
+
+        store.get_sst_file_ids(file_ids);
+        ASSERT_EQ(2, file_ids.size());
+
+        for(const auto& kv: file_ids) {
+            ASSERT_TRUE(StringUtils::ends_with(kv.first, ".sst"));
+            ASSERT_FALSE(kv.second.empty());
+        }
+    }
+
+    // files keep the identity of the session that wrote them
+    Store store(store_path, 24*60*60, 1024, false);
+    std::map<std::string, std::string> reopened_file_ids;
+    store.get_sst_file_ids(reopened_file_ids);
+    ASSERT_EQ(file_ids, reopened_file_ids);
+}
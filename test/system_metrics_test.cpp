@@ -7,4 +7,29 @@ TEST(SystemMetricsTest, ParsingNetworkStats) {
     SystemMetrics::linux_get_network_data(proc_net_dev_path, received_bytes, sent_bytes);
     ASSERT_EQ(324278716, received_bytes);
     ASSERT_EQ(93933882, sent_bytes);
-}
\ No newline at end of file
+}
+
+TEST(SystemMetricsTest, SnapshotIncludesThreadPools) {
+    ThreadPool pool(2);
+    SystemMetrics::register_thread_pool("test", &pool);
+
+    pool.enqueue([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }).get();
+
+    SystemMetrics::sample("/tmp");
+
+    nlohmann::json result;
+    SystemMetrics::get_snapshot("/tmp", result);
+    SystemMetrics::unregister_thread_pools();
+    pool.shutdown();
+
+    ASSERT_EQ("2", result["typesense_thread_pool_test_threads"].get<std::string>());
+    ASSERT_EQ("0", result["typesense_thread_pool_test_pending_tasks"].get<std::string>());
+    ASSERT_TRUE(result.contains("typesense_thread_pool_test_utilization_percentage"));
+    ASSERT_TRUE(result.contains("system_memory_total_bytes"));
+#if __linux__
+    ASSERT_TRUE(result.contains("system_cpu_active_percentage"));
+    ASSERT_LE(0, SystemMetrics::get_cpu_active_percentage());
+#endif
+}
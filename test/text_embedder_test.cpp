@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+#include "text_embedder.h"
+
+TEST(TextEmbedderTest, ParseLocalModelOptions) {
+    auto options_op = local_model_options_t::parse({{"model_name", "ts/e5-small"}});
+    ASSERT_TRUE(options_op.ok());
+    ASSERT_EQ(0, options_op.get().intra_op_threads);
+    ASSERT_EQ(0, options_op.get().inter_op_threads);
+    ASSERT_EQ("", options_op.get().execution_provider);
+    ASSERT_FALSE(options_op.get().quantized);
+
+    options_op = local_model_options_t::parse({{"model_name", "ts/e5-small"}, {"intra_op_threads", 2},
+                                               {"inter_op_threads", 1}, {"execution_provider", "cpu"},
+                                               {"quantized", true}});
+    ASSERT_TRUE(options_op.ok());
+    ASSERT_EQ(2, options_op.get().intra_op_threads);
+    ASSERT_EQ(1, options_op.get().inter_op_threads);
+    ASSERT_EQ("cpu", options_op.get().execution_provider);
+    ASSERT_TRUE(options_op.get().quantized);
+
+    options_op = local_model_options_t::parse({{"model_name", "ts/e5-small"}, {"intra_op_threads", -1}});
+    ASSERT_FALSE(options_op.ok());
+    ASSERT_EQ("Property `embed.model_config.intra_op_threads` must be a non-negative integer.", options_op.error());
+
+    options_op = local_model_options_t::parse({{"model_name", "ts/e5-small"}, {"execution_provider", "tpu"}});
+    ASSERT_FALSE(options_op.ok());
+    ASSERT_EQ("Property `embed.model_config.execution_provider` must be one of `cpu`, `cuda`.", options_op.error());
+
+    options_op = local_model_options_t::parse({{"model_name", "ts/e5-small"}, {"quantized", "yes"}});
+    ASSERT_FALSE(options_op.ok());
+    ASSERT_EQ("Property `embed.model_config.quantized` must be a boolean.", options_op.error());
+}
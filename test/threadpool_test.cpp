@@ -0,0 +1,231 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include "threadpool.h"
+#include "thread_local_vars.h"
+
+TEST(ThreadPoolTest, EnqueueReturnsResults) {
+    ThreadPool pool(4);
+    std::vector<std::future<size_t>> futures;
+
+    for(size_t i = 0; i < 1000; i++) {
+        futures.push_back(pool.enqueue([i]() { return i * 2; }));
+    }
+
+    size_t sum = 0;
+    for(auto& future: futures) {
+        sum += future.get();
+    }
+
+    ASSERT_EQ(999 * 1000, sum);
+
+    auto high_future = pool.enqueue_with_priority(ThreadPool::HIGH_PRIORITY, [](int a, int b) { return a + b; }, 2, 3);
+    ASSERT_EQ(5, high_future.get());
+
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, ParallelForCoversRange) {
+    ThreadPool pool(4);
+    std::vector<int> counts(10 * 1000, 0);
+
+    pool.parallel_for(0, counts.size(), 7, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            counts[i]++;
+        }
+    });
+
+    for(auto count: counts) {
+        ASSERT_EQ(1, count);
+    }
+
+    // empty range and more chunks than items
+    size_t num_calls = 0;
+    pool.parallel_for(5, 5, 4, [&](size_t, size_t) { num_calls++; });
+    ASSERT_EQ(0, num_calls);
+
+    std::atomic<size_t> num_items = 0;
+    pool.parallel_for(0, 3, 16, [&](size_t begin, size_t end) { num_items += (end - begin); });
+    ASSERT_EQ(3, num_items);
+
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, ParallelSortIsStable) {
+    ThreadPool pool(4);
+
+    // (key, original position) pairs with many equal keys, so that a reordering of equal keys shows
+    std::vector<std::pair<uint32_t, uint32_t>> values;
+    for(uint32_t i = 0; i < 100 * 1000; i++) {
+        values.emplace_back((i * 7919) % 1000, i);
+    }
+
+    auto by_key = [](const auto& a, const auto& b) { return a.first < b.first; };
+
+    auto expected = values;
+    std::stable_sort(expected.begin(), expected.end(), by_key);
+
+    pool.parallel_sort(values.begin(), values.end(), by_key, 7);
+    ASSERT_EQ(expected, values);
+
+    // a range below the threshold is sorted on the calling thread
+    std::vector<int> small_values = {5, 3, 9, 1};
+    pool.parallel_sort(small_values.begin(), small_values.end(), std::less<int>(), 4);
+    ASSERT_EQ((std::vector<int>{1, 3, 5, 9}), small_values);
+
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, NestedParallelForDoesNotDeadlock) {
+    // every worker is busy with an outer chunk, so the inner chunks must be run by the waiting threads themselves
+    ThreadPool pool(2);
+    std::atomic<size_t> num_items = 0;
+
+    auto future = pool.enqueue([&]() {
+        pool.parallel_for(0, 100, 8, [&](size_t begin, size_t end) {
+            pool.parallel_for(begin, end, 4, [&](size_t inner_begin, size_t inner_end) {
+                num_items += (inner_end - inner_begin);
+            });
+        });
+    });
+
+    future.get();
+    ASSERT_EQ(100, num_items);
+
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, ParallelForRethrows) {
+    ThreadPool pool(2);
+
+    ASSERT_THROW(pool.parallel_for(0, 10, 3, [](size_t begin, size_t) {
+        if(begin == 0) {
+            throw std::runtime_error("failed");
+        }
+    }), std::runtime_error);
+
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, PoolTaskRunsOnceAndRethrows) {
+    ThreadPool pool(1);
+    std::atomic<size_t> num_runs = 0;
+
+    pool_task_t task(&pool, [&]() { num_runs++; });
+    task.wait();
+    task.wait();
+    ASSERT_EQ(1, num_runs);
+
+    // the only worker is busy, so the waiting thread runs the task itself
+    std::atomic<bool> release = false;
+    auto blocker = pool.enqueue([&]() { while(!release) { std::this_thread::yield(); } });
+
+    pool_task_t inline_task(&pool, [&]() { num_runs++; });
+    inline_task.wait();
+    ASSERT_EQ(2, num_runs);
+
+    pool_task_t failing_task(&pool, []() { throw std::runtime_error("failed"); });
+    ASSERT_THROW(failing_task.wait(), std::runtime_error);
+
+    release = true;
+    blocker.get();
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, SearchDeadlineIsCarriedIntoTasks) {
+    ThreadPool pool(4);
+
+    const uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    search_begin_us = now_us;
+    search_stop_us = 60 * 1000 * 1000;
+    search_cutoff = false;
+
+    // deadline is not yet past
+    std::atomic<bool> tasks_cutoff = false;
+    std::atomic<size_t> num_expired = 0;
+    auto deadline = search_deadline_t::current();
+
+    pool.parallel_for(0, 16, 16, [&](size_t, size_t) {
+        search_deadline_scope_t deadline_scope(deadline, &tasks_cutoff);
+        if(search_deadline_t::check_expired()) {
+            num_expired++;
+        }
+    });
+
+    ASSERT_EQ(0, num_expired);
+    ASSERT_FALSE(tasks_cutoff);
+    ASSERT_FALSE(search_cutoff);
+
+    // deadline is past: every task sees it and the cutoff reaches the search
+    search_begin_us = now_us - 2000;
+    search_stop_us = 1000;
+    deadline = search_deadline_t::current();
+
+    pool.parallel_for(0, 16, 16, [&](size_t, size_t) {
+        search_deadline_scope_t deadline_scope(deadline, &tasks_cutoff);
+        if(search_deadline_t::check_expired()) {
+            num_expired++;
+        }
+    });
+
+    ASSERT_EQ(16, num_expired);
+    ASSERT_TRUE(tasks_cutoff);
+
+    // state of the calling thread is restored after the tasks that it ran itself
+    ASSERT_FALSE(search_cutoff);
+    ASSERT_EQ(now_us - 2000, search_begin_us);
+    ASSERT_EQ(1000, search_stop_us);
+
+    pool.shutdown();
+}
+
+TEST(ThreadPoolTest, ThreadInitRunsOnEveryWorker) {
+    static thread_local bool initialized = false;
+    std::atomic<size_t> num_inits = 0;
+
+    ThreadPool pool(4, [&num_inits]() {
+        initialized = true;
+        num_inits++;
+    });
+
+    std::vector<std::future<bool>> futures;
+    for(size_t i = 0; i < 100; i++) {
+        futures.push_back(pool.enqueue([]() { return initialized; }));
+    }
+
+    for(auto& future: futures) {
+        ASSERT_TRUE(future.get());
+    }
+
+    pool.shutdown();
+    ASSERT_EQ(4, num_inits.load());
+}
+
+TEST(ThreadPoolTest, TracksBusyWorkers) {
+    ThreadPool pool(2);
+    ASSERT_EQ(0, pool.num_busy_threads());
+
+    std::promise<void> started, release;
+    auto release_future = release.get_future().share();
+
+    auto future = pool.enqueue([&started, release_future]() {
+        started.set_value();
+        release_future.wait();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    });
+
+    started.get_future().wait();
+    ASSERT_EQ(1, pool.num_busy_threads());
+    ASSERT_EQ(0, pool.num_pending_tasks());
+
+    release.set_value();
+    future.get();
+    pool.shutdown();
+
+    // the busy time of a task is added once it returns, and the workers are joined by now
+    ASSERT_EQ(0, pool.num_busy_threads());
+    ASSERT_LE(5000, pool.get_busy_time_us());
+}
@@ -414,3 +414,84 @@ TEST(TokenizerTest, ShouldTokenizeWithDifferentSymbolConfigs) {
     ASSERT_EQ(1, tokens.size());
     ASSERT_EQ("ความเห", tokens[0]);
 }
+
+TEST(TokenizerTest, ShouldTokenizeLongASCIIRuns) {
+    // words that span and end inside blocks of 16 bytes, with symbols and non-ASCII characters in between
+    const std::string text = "ThisIsAVeryLongASCIIWordOf40Characters12 Short c++Code "
+                             "MixedCaseWordFollowedByÉclair0123456789ABCDEFGHIJ_Tail";
+
+    std::vector<std::string> tokens;
+    Tokenizer(text, true, false, "", {'+'}, {}).tokenize(tokens);
+    ASSERT_EQ(4, tokens.size());
+    ASSERT_EQ("thisisaverylongasciiwordof40characters12", tokens[0]);
+    ASSERT_EQ("short", tokens[1]);
+    ASSERT_EQ("c++code", tokens[2]);
+    ASSERT_EQ("mixedcasewordfollowedbyeclair0123456789abcdefghijtail", tokens[3]);
+
+    tokens.clear();
+    Tokenizer(text, false, false, "", {}, {'_'}).tokenize(tokens);
+    ASSERT_EQ(5, tokens.size());
+    ASSERT_EQ("ThisIsAVeryLongASCIIWordOf40Characters12", tokens[0]);
+    ASSERT_EQ("cCode", tokens[2]);
+    ASSERT_EQ("MixedCaseWordFollowedByÉclair0123456789ABCDEFGHIJ", tokens[3]);
+    ASSERT_EQ("Tail", tokens[4]);
+}
+
+TEST(TokenizerTest, ShouldReusePooledTokenizers) {
+    const std::string text1 = "The Quick-Brown fox";
+    const std::string text2 = "jumps";
+
+    Tokenizer* released_tokenizer = nullptr;
+
+    {
+        auto tokenizer = Tokenizer::acquire(text1, true, false, "", {}, {'-'});
+        std::vector<std::string> tokens;
+        tokenizer->tokenize(tokens);
+        ASSERT_EQ(4, tokens.size());
+        ASSERT_EQ("brown", tokens[2]);
+        released_tokenizer = tokenizer.get();
+    }
+
+    // tokenizers with the same settings are reused, starting afresh on the new text
+    auto tokenizer = Tokenizer::acquire(text2, true, false, "", {}, {'-'});
+    ASSERT_EQ(released_tokenizer, tokenizer.get());
+
+    std::string token;
+    size_t token_index = 0;
+    ASSERT_TRUE(tokenizer->next(token, token_index));
+    ASSERT_EQ("jumps", token);
+    ASSERT_EQ(0, token_index);
+    ASSERT_FALSE(tokenizer->next(token, token_index));
+
+    // a tokenizer that is in use is never handed out again, nor one with other settings
+    auto other_tokenizer = Tokenizer::acquire(text1, true, false, "", {}, {'-'});
+    ASSERT_NE(tokenizer.get(), other_tokenizer.get());
+
+    auto hyphen_tokenizer = Tokenizer::acquire(text1, true, false, "", {'-'}, {});
+    std::vector<std::string> tokens;
+    hyphen_tokenizer->tokenize(tokens);
+    ASSERT_EQ(3, tokens.size());
+    ASSERT_EQ("quick-brown", tokens[1]);
+}
+
+TEST(TokenizerTest, ShouldTokenizeBatchNormalizedJapaneseText) {
+    const std::vector<std::string> texts = {"怠惰な犬", "ア退屈であ", "怠惰な犬", "dog"};
+    std::vector<std::string> normalized_texts;
+    JapaneseLocalizer::get_instance().normalize_batch(texts, normalized_texts);
+    ASSERT_EQ(texts.size(), normalized_texts.size());
+
+    for(size_t i = 0; i < texts.size(); i++) {
+        std::string normalized;
+        JapaneseLocalizer::get_instance().normalize(texts[i], normalized);
+        ASSERT_EQ(normalized, normalized_texts[i]);
+
+        // tokens of a normalized text are the same as those of the text
+        std::vector<std::string> tokens, batch_tokens;
+        Tokenizer(texts[i], true, false, "ja").tokenize(tokens);
+
+        Tokenizer tokenizer("", true, false, "ja");
+        tokenizer.init(normalized_texts[i], true);
+        tokenizer.tokenize(batch_tokens);
+        ASSERT_EQ(tokens, batch_tokens);
+    }
+}
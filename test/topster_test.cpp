@@ -235,4 +235,131 @@ TEST(TopsterTest, DistinctIntValues) {
             EXPECT_EQ(9, dist_topster.group_kv_map[dist_topster.getDistinctKeyAt(i)]->getKV(1)->scores[0]);
         }
     }
-}
\ No newline at end of file
+}
+
+TEST(TopsterTest, TopGroupsFullWhenAddedInSortOrder) {
+    Topster dist_topster(2, 2);
+
+    // hits in descending order of score: group key => score
+    std::vector<std::pair<uint64_t, int64_t>> hits = {{1, 100}, {2, 90}, {1, 80}, {3, 70}, {2, 60}, {3, 50}};
+    std::vector<bool> expected_full = {false, false, false, false, true, true};
+
+    for(size_t i = 0; i < hits.size(); i++) {
+        int64_t scores[3] = {hits[i].second, 0, 0};
+        KV kv(0, i, hits[i].first, 0, scores);
+        dist_topster.add(&kv);
+        ASSERT_EQ(expected_full[i], dist_topster.are_top_groups_full(2));
+    }
+
+    ASSERT_FALSE(dist_topster.are_top_groups_full(4));
+}
+
+TEST(TopsterTest, KVMapNodesAreRecycled) {
+    node_pool_t<> pool;
+    Topster::kv_map_allocator_t allocator(&pool);
+    std::unordered_map<uint64_t, KV*, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                       Topster::kv_map_allocator_t> kv_map(0, std::hash<uint64_t>(), std::equal_to<uint64_t>(),
+                                                           allocator);
+
+    for(uint64_t seq_id = 0; seq_id < 10000; seq_id++) {
+        if(kv_map.size() >= 100) {
+            kv_map.erase(seq_id - 100);
+        }
+        kv_map.emplace(seq_id, nullptr);
+    }
+
+    ASSERT_EQ(100, kv_map.size());
+    for(uint64_t seq_id = 9900; seq_id < 10000; seq_id++) {
+        ASSERT_EQ(1, kv_map.count(seq_id));
+    }
+
+    // a topster that displaces its entries over and over still holds the right ones
+    Topster topster(10);
+    for(uint64_t seq_id = 0; seq_id < 10000; seq_id++) {
+        int64_t scores[3] = {int64_t(seq_id), 0, 0};
+        KV kv(0, seq_id, seq_id, 0, scores);
+        topster.add(&kv);
+    }
+
+    topster.sort();
+    ASSERT_EQ(10, topster.size);
+    ASSERT_EQ(10, topster.kv_map.size());
+    for(uint32_t i = 0; i < topster.size; i++) {
+        ASSERT_EQ(9999 - i, topster.getKeyAt(i));
+    }
+
+    // group topsters share the pool of their parent
+    Topster grouped_topster(5, 2);
+    for(uint64_t seq_id = 0; seq_id < 1000; seq_id++) {
+        int64_t scores[3] = {int64_t(seq_id), 0, 0};
+        KV kv(0, seq_id, seq_id % 10, 0, scores);
+        grouped_topster.add(&kv);
+    }
+
+    ASSERT_EQ(10, grouped_topster.group_kv_map.size());
+    for(const auto& group_kv: grouped_topster.group_kv_map) {
+        ASSERT_EQ(2, group_kv.second->size);
+        ASSERT_EQ(grouped_topster.kv_pool, group_kv.second->kv_pool);
+    }
+}
+
+TEST(TopsterTest, ReferenceFilterResultsOnlyForJoinedHits) {
+    Topster topster(5);
+
+    for(uint64_t seq_id = 0; seq_id < 10; seq_id++) {
+        int64_t scores[3] = {int64_t(seq_id), 0, 0};
+        KV::reference_filter_results_t references;
+
+        if(seq_id % 2 == 0) {
+            references["authors"] = reference_filter_result_t(1, new uint32_t[1]{uint32_t(seq_id * 10)});
+        }
+
+        KV kv(0, seq_id, seq_id, 0, scores, std::move(references));
+        ASSERT_EQ(seq_id % 2 == 0, kv.reference_filter_results != nullptr);
+        topster.add(&kv);
+    }
+
+    topster.sort();
+    ASSERT_EQ(5, topster.size);
+
+    for(uint32_t i = 0; i < topster.size; i++) {
+        const KV* kv = topster.getKV(i);
+        ASSERT_EQ(9 - i, kv->key);
+
+        const auto& references = kv->get_reference_filter_results();
+        if(kv->key % 2 == 0) {
+            ASSERT_EQ(1, references.size());
+            ASSERT_EQ(1, references.at("authors").count);
+            ASSERT_EQ(kv->key * 10, references.at("authors").docs[0]);
+        } else {
+            ASSERT_EQ(nullptr, kv->reference_filter_results);
+            ASSERT_TRUE(references.empty());
+        }
+    }
+}
+
+TEST(TopsterTest, SearchAfterKeepsOnlyHitsBelowCursor) {
+    // hits that tie on the score are ordered by their key
+    int64_t cursor_scores[3] = {5, 0, 0};
+
+    Topster topster(3);
+    topster.set_search_after(cursor_scores, 4);
+
+    Topster thread_topster(3);
+    thread_topster.copy_search_after(topster);
+
+    for(uint64_t seq_id = 0; seq_id < 10; seq_id++) {
+        int64_t scores[3] = {int64_t(seq_id / 2 * 2 + 1), 0, 0};  // 1, 1, 3, 3, 5, 5, 7, 7, 9, 9
+        KV kv(0, seq_id, seq_id, 0, scores);
+        thread_topster.add(&kv);
+    }
+
+    Index::aggregate_topster(&topster, &thread_topster);
+    topster.sort();
+
+    ASSERT_EQ(3, topster.size);
+    std::vector<uint64_t> expected_keys = {3, 2, 1};
+    for(uint32_t i = 0; i < topster.size; i++) {
+        ASSERT_EQ(expected_keys[i], topster.getKeyAt(i));
+    }
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <set>
+#include "trigram_index.h"
+
+TEST(TrigramIndexTest, InsertSearchAndErase) {
+    trigram_index_t index;
+    index.insert("yhd3342d78912");
+    index.insert("yhd3342d78912");
+    index.insert("suzukigsx");
+    index.insert("aaaa");
+
+    ASSERT_EQ(3, index.size());
+
+    std::vector<std::string> tokens;
+    ASSERT_TRUE(index.search("342d78", 100, 100, tokens));
+    ASSERT_EQ(std::vector<std::string>{"yhd3342d78912"}, tokens);
+
+    // extra prefix and suffix are limited
+    tokens.clear();
+    ASSERT_TRUE(index.search("342d78", 3, 100, tokens));
+    ASSERT_TRUE(tokens.empty());
+
+    tokens.clear();
+    ASSERT_TRUE(index.search("342d78", 4, 3, tokens));
+    ASSERT_EQ(1, tokens.size());
+
+    tokens.clear();
+    ASSERT_TRUE(index.search("342d78", 4, 2, tokens));
+    ASSERT_TRUE(tokens.empty());
+
+    // all trigrams of the query are in the token, but the query is not
+    tokens.clear();
+    index.insert("abcxbcd");
+    ASSERT_TRUE(index.search("abcd", 100, 100, tokens));
+    ASSERT_TRUE(tokens.empty());
+
+    // a repeated trigram
+    tokens.clear();
+    ASSERT_TRUE(index.search("aaa", 100, 100, tokens));
+    ASSERT_EQ(std::vector<std::string>{"aaaa"}, tokens);
+
+    // too short for the index
+    tokens.clear();
+    ASSERT_FALSE(index.search("gs", 100, 100, tokens));
+
+    index.erase("yhd3342d78912");
+    index.erase("yhd3342d78912");
+    ASSERT_EQ(3, index.size());
+
+    tokens.clear();
+    ASSERT_TRUE(index.search("342d78", 100, 100, tokens));
+    ASSERT_TRUE(tokens.empty());
+
+    index.erase("suzukigsx");
+    index.erase("aaaa");
+    index.erase("abcxbcd");
+    ASSERT_EQ(0, index.size());
+    ASSERT_EQ(0, index.num_trigrams());
+}
+
+TEST(TrigramIndexTest, SearchMatchesScan) {
+    std::mt19937 rng(42);
+    const std::string alphabet = "abcd";
+
+    trigram_index_t index;
+    std::set<std::string> tokens;
+
+    for(size_t i = 0; i < 5000; i++) {
+        std::string token;
+        const size_t len = 1 + rng() % 12;
+        for(size_t j = 0; j < len; j++) {
+            token += alphabet[rng() % alphabet.size()];
+        }
+
+        if(rng() % 4 == 0 && !tokens.empty()) {
+            // erase a token, most of the time one that is in the index
+            auto it = tokens.lower_bound(token);
+            if(it != tokens.end()) {
+                token = *it;
+            }
+
+            index.erase(token);
+            tokens.erase(token);
+        } else {
+            index.insert(token);
+            tokens.insert(token);
+        }
+    }
+
+    ASSERT_EQ(tokens.size(), index.size());
+
+    for(size_t i = 0; i < 200; i++) {
+        std::string query;
+        const size_t len = 3 + rng() % 5;
+        for(size_t j = 0; j < len; j++) {
+            query += alphabet[rng() % alphabet.size()];
+        }
+
+        const size_t max_extra_prefix = rng() % 6;
+        const size_t max_extra_suffix = rng() % 6;
+
+        std::vector<std::string> expected;
+        for(const auto& token: tokens) {
+            auto start_index = token.find(query);
+            if(start_index != std::string::npos && start_index <= max_extra_prefix &&
+               (token.size() - (start_index + query.size())) <= max_extra_suffix) {
+                expected.push_back(token);
+            }
+        }
+
+        std::vector<std::string> found;
+        ASSERT_TRUE(index.search(query, max_extra_prefix, max_extra_suffix, found));
+        std::sort(found.begin(), found.end());
+
+        ASSERT_EQ(expected, found);
+    }
+}
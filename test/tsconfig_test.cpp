@@ -210,3 +210,98 @@ TEST(ConfigTest, CorsDefaults) {
     ASSERT_EQ(true, config3.get_enable_cors());
     ASSERT_EQ(1, config3.get_cors_domains().size());
 }
+
+TEST(ConfigTest, IndexingThreadPoolOptions) {
+    cmdline::parser options;
+
+    std::vector<std::string> args = {
+        "./typesense-server",
+        "--data-dir=/tmp/data",
+        "--api-key=abcd",
+        "--indexing-thread-pool-size=4",
+        "--indexing-cpu-affinity=0-1,6",
+        "--multi-search-concurrency=2",
+    };
+
+    std::vector<char*> argv = get_argv(args);
+
+    init_cmdline_options(options, argv.size() - 1, argv.data());
+    options.parse(argv.size() - 1, argv.data());
+
+    ConfigImpl config;
+    ASSERT_EQ(0, config.get_indexing_thread_pool_size());
+    ASSERT_EQ(4, config.get_multi_search_concurrency());
+
+    config.load_config_cmd_args(options);
+
+    ASSERT_EQ(4, config.get_indexing_thread_pool_size());
+    ASSERT_EQ(2, config.get_multi_search_concurrency());
+    ASSERT_EQ("0-1,6", config.get_indexing_cpu_affinity());
+
+    std::vector<size_t> cpu_ids;
+    ASSERT_TRUE(parse_cpu_list(config.get_indexing_cpu_affinity(), cpu_ids));
+    ASSERT_EQ((std::vector<size_t>{0, 1, 6}), cpu_ids);
+
+    cpu_ids.clear();
+    ASSERT_FALSE(parse_cpu_list("3-1", cpu_ids));
+
+    cpu_ids.clear();
+    ASSERT_FALSE(parse_cpu_list("a,b", cpu_ids));
+
+    cpu_ids.clear();
+    ASSERT_FALSE(parse_cpu_list("", cpu_ids));
+}
+
+TEST(ConfigTest, DbTuningOptions) {
+    cmdline::parser options;
+
+    std::vector<std::string> args = {
+        "./typesense-server",
+        "--data-dir=/tmp/data",
+        "--api-key=abcd",
+        "--db-block-cache-mb=512",
+        "--db-bloom-bits-per-key=0",
+        "--db-row-cache-mb=64",
+        "--db-compaction-direct-io=true",
+    };
+
+    std::vector<char*> argv = get_argv(args);
+
+    init_cmdline_options(options, argv.size() - 1, argv.data());
+    options.parse(argv.size() - 1, argv.data());
+
+    ConfigImpl config;
+    ASSERT_EQ(0, config.get_db_block_cache_mb());
+    ASSERT_EQ(10, config.get_db_bloom_bits_per_key());
+    ASSERT_EQ(0, config.get_db_row_cache_mb());
+    ASSERT_FALSE(config.get_db_compaction_direct_io());
+
+    config.load_config_cmd_args(options);
+
+    ASSERT_EQ(512, config.get_db_block_cache_mb());
+    ASSERT_EQ(0, config.get_db_bloom_bits_per_key());
+    ASSERT_EQ(64, config.get_db_row_cache_mb());
+    ASSERT_TRUE(config.get_db_compaction_direct_io());
+}
+
+TEST(ConfigTest, HitsParallelThreshold) {
+    cmdline::parser options;
+
+    std::vector<std::string> args = {
+        "./typesense-server",
+        "--data-dir=/tmp/data",
+        "--api-key=abcd",
+        "--hits-parallel-threshold=0",
+    };
+
+    std::vector<char*> argv = get_argv(args);
+
+    init_cmdline_options(options, argv.size() - 1, argv.data());
+    options.parse(argv.size() - 1, argv.data());
+
+    ConfigImpl config;
+    ASSERT_EQ(64, config.get_hits_parallel_threshold());
+
+    config.load_config_cmd_args(options);
+    ASSERT_EQ(0, config.get_hits_parallel_threshold());
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "typo_candidate_cache.h"
+
+class TypoCandidateCacheTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        typo_candidate_cache_t::set_max_entries(typo_candidate_cache_t::DEFAULT_MAX_ENTRIES);
+    }
+
+    static typo_candidate_cache_t::candidates_t make_nodes(size_t num_nodes) {
+        auto candidates = std::make_shared<typo_candidates_t>();
+        for(size_t i = 0; i < num_nodes; i++) {
+            candidates->nodes.push_back(reinterpret_cast<const art_node*>(16 * (i + 1)));
+        }
+
+        return candidates;
+    }
+};
+
+TEST_F(TypoCandidateCacheTest, KeysTellFieldsTokensCostsAndPrefixesApart) {
+    const auto key = typo_candidate_cache_t::get_key("title", "iph", 1, true);
+
+    ASSERT_EQ(key, typo_candidate_cache_t::get_key("title", "iph", 1, true));
+    ASSERT_NE(key, typo_candidate_cache_t::get_key("title", "iph", 1, false));
+    ASSERT_NE(key, typo_candidate_cache_t::get_key("title", "iph", 2, true));
+    ASSERT_NE(key, typo_candidate_cache_t::get_key("title", "ipho", 1, true));
+    ASSERT_NE(key, typo_candidate_cache_t::get_key("name", "iph", 1, true));
+    ASSERT_NE(typo_candidate_cache_t::get_key("ab", "c", 0, true), typo_candidate_cache_t::get_key("a", "bc", 0, true));
+}
+
+TEST_F(TypoCandidateCacheTest, EntriesOfOlderGenerationsAreNotReturned) {
+    typo_candidate_cache_t cache;
+    const auto key = typo_candidate_cache_t::get_key("title", "iph", 0, true);
+
+    ASSERT_EQ(nullptr, cache.get(key, 1));
+
+    auto nodes = make_nodes(3);
+    cache.insert(key, 1, nodes);
+    ASSERT_EQ(1, cache.size());
+    ASSERT_EQ(nodes, cache.get(key, 1));
+
+    // written to since
+    ASSERT_EQ(nullptr, cache.get(key, 2));
+    ASSERT_EQ(0, cache.size());
+
+    // too large to be held
+    cache.insert(key, 2, make_nodes(typo_candidate_cache_t::MAX_ENTRY_NODES + 1));
+    ASSERT_EQ(nullptr, cache.get(key, 2));
+}
+
+TEST_F(TypoCandidateCacheTest, LeastRecentlyUsedEntryIsEvicted) {
+    typo_candidate_cache_t::set_max_entries(2);
+    typo_candidate_cache_t cache;
+
+    const auto key_a = typo_candidate_cache_t::get_key("title", "a", 0, false);
+    const auto key_b = typo_candidate_cache_t::get_key("title", "b", 0, false);
+    const auto key_c = typo_candidate_cache_t::get_key("title", "c", 0, false);
+
+    cache.insert(key_a, 1, make_nodes(1));
+    cache.insert(key_b, 1, make_nodes(1));
+    ASSERT_NE(nullptr, cache.get(key_a, 1));
+
+    cache.insert(key_c, 1, make_nodes(1));
+    ASSERT_EQ(2, cache.size());
+    ASSERT_NE(nullptr, cache.get(key_a, 1));
+    ASSERT_EQ(nullptr, cache.get(key_b, 1));
+    ASSERT_NE(nullptr, cache.get(key_c, 1));
+
+    nlohmann::json metrics;
+    typo_candidate_cache_t::get_metrics(metrics);
+    ASSERT_EQ("2", metrics["typesense_typo_cache_max_entries_per_collection"].get<std::string>());
+    ASSERT_LE(2, std::stoull(metrics["typesense_typo_cache_entries"].get<std::string>()));
+    ASSERT_LE(1, std::stoull(metrics["typesense_typo_cache_evictions"].get<std::string>()));
+
+    typo_candidate_cache_t::set_max_entries(0);
+    cache.clear();
+    cache.insert(key_a, 1, make_nodes(1));
+    ASSERT_EQ(0, cache.size());
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include "vector_column.h"
+
+static float dot_distance(const void* a, const void* b, const void* params) {
+    const auto num_dim = *static_cast<const size_t*>(params);
+    float dot = 0;
+    for(size_t i = 0; i < num_dim; i++) {
+        dot += static_cast<const float*>(a)[i] * static_cast<const float*>(b)[i];
+    }
+
+    return 1.0f - dot;
+}
+
+TEST(VectorColumnTest, PutGetAndRemoveVectors) {
+    vector_column_t column(3);
+
+    std::vector<float> values;
+    ASSERT_FALSE(column.get(0, values));
+
+    for(uint32_t seq_id = 0; seq_id < 3000; seq_id += 2) {
+        const float vec[3] = {float(seq_id), seq_id + 0.5f, -float(seq_id)};
+        column.put(seq_id, vec);
+    }
+
+    ASSERT_EQ(1500, column.size());
+    ASSERT_TRUE(column.get(2500, values));
+    ASSERT_EQ(std::vector<float>({2500, 2500.5, -2500}), values);
+    ASSERT_FALSE(column.get(2501, values));
+    ASSERT_FALSE(column.get(100000, values));
+
+    // replaced in place
+    const float updated[3] = {1, 2, 3};
+    column.put(2500, updated);
+    ASSERT_TRUE(column.get(2500, values));
+    ASSERT_EQ(std::vector<float>({1, 2, 3}), values);
+    ASSERT_EQ(1500, column.size());
+
+    column.remove(10);
+    column.remove(11);
+    ASSERT_FALSE(column.get(10, values));
+    ASSERT_EQ(1499, column.size());
+}
+
+TEST(VectorColumnTest, DistancesOfIds) {
+    const size_t num_dim = 20;
+    vector_column_t column(num_dim);
+
+    for(uint32_t seq_id = 0; seq_id < 100; seq_id++) {
+        std::vector<float> vec(num_dim, 0);
+        vec[seq_id % num_dim] = 1;
+        column.put(seq_id, vec.data());
+    }
+
+    column.remove(40);
+
+    std::vector<float> query(num_dim, 0);
+    query[0] = 1;
+
+    std::vector<uint32_t> seq_ids = {0, 1, 20, 40, 60, 99, 5000};
+    std::vector<std::pair<float, size_t>> dist_labels;
+    column.distances(query.data(), seq_ids.data(), seq_ids.size(), dot_distance, &num_dim, dist_labels);
+
+    // ids without a vector are skipped
+    std::vector<std::pair<float, size_t>> expected = {{0, 0}, {1, 1}, {0, 20}, {0, 60}, {1, 99}};
+    ASSERT_EQ(expected, dist_labels);
+}
+
+TEST(VectorColumnTest, MinDistancesAndGatherOfIds) {
+    const size_t num_dim = 20;
+    vector_column_t column(num_dim);
+
+    for(uint32_t seq_id = 0; seq_id < 100; seq_id++) {
+        std::vector<float> vec(num_dim, 0);
+        vec[seq_id % num_dim] = 1;
+        column.put(seq_id, vec.data());
+    }
+
+    column.remove(40);
+
+    std::vector<float> query_a(num_dim, 0), query_b(num_dim, 0);
+    query_a[0] = 1;
+    query_b[1] = 1;
+    const float* queries[2] = {query_a.data(), query_b.data()};
+
+    std::vector<uint32_t> seq_ids = {0, 1, 2, 40, 61, 5000};
+    std::vector<float> distances(seq_ids.size(), -1);
+    column.min_distances(queries, 2, seq_ids.data(), seq_ids.size(), dot_distance, &num_dim, distances.data());
+
+    // the entries of the ids without a vector are left as they are
+    ASSERT_EQ(std::vector<float>({0, 0, 1, -1, 0, -1}), distances);
+
+    std::vector<float> rows;
+    std::vector<size_t> row_indices;
+    column.gather(seq_ids.data(), seq_ids.size(), rows, row_indices);
+
+    ASSERT_EQ(std::vector<size_t>({0, 1, 2, 4}), row_indices);
+    ASSERT_EQ(4 * num_dim, rows.size());
+    ASSERT_EQ(1, rows[0]);
+    ASSERT_EQ(1, rows[num_dim + 1]);
+    ASSERT_EQ(1, rows[2 * num_dim + 2]);
+    ASSERT_EQ(1, rows[3 * num_dim + 1]);
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "vector_file.h"
+
+TEST(VectorFileTest, PutGetAndRemoveVectors) {
+    vector_file_t file(3);
+    ASSERT_TRUE(file.open(std::filesystem::temp_directory_path().string()).ok());
+    ASSERT_EQ(vector_file_t::INITIAL_CAPACITY * 3 * sizeof(float), file.file_size());
+
+    std::vector<float> values;
+    ASSERT_FALSE(file.get(0, values));
+
+    for(uint32_t seq_id = 0; seq_id < 3000; seq_id++) {
+        const float vec[3] = {float(seq_id), seq_id + 0.5f, -float(seq_id)};
+        ASSERT_TRUE(file.put(seq_id, vec));
+    }
+
+    // grows as vectors are put
+    ASSERT_EQ(3000, file.size());
+    ASSERT_EQ(4096 * 3 * sizeof(float), file.file_size());
+
+    ASSERT_TRUE(file.get(2500, values));
+    ASSERT_EQ(std::vector<float>({2500, 2500.5, -2500}), values);
+
+    // replaced in place
+    const float updated[3] = {1, 2, 3};
+    ASSERT_TRUE(file.put(2500, updated));
+    ASSERT_TRUE(file.get(2500, values));
+    ASSERT_EQ(std::vector<float>({1, 2, 3}), values);
+    ASSERT_EQ(3000, file.size());
+
+    file.remove(10);
+    ASSERT_FALSE(file.get(10, values));
+    ASSERT_EQ(2999, file.size());
+
+    // the slot of a removed vector is reused
+    const float vec[3] = {7, 8, 9};
+    ASSERT_TRUE(file.put(5000, vec));
+    ASSERT_TRUE(file.get(5000, values));
+    ASSERT_EQ(std::vector<float>({7, 8, 9}), values);
+    ASSERT_TRUE(file.get(11, values));
+    ASSERT_EQ(std::vector<float>({11, 11.5, -11}), values);
+    ASSERT_EQ(4096 * 3 * sizeof(float), file.file_size());
+}
+
+TEST(VectorFileTest, InvalidDirectory) {
+    vector_file_t file(3);
+    ASSERT_FALSE(file.open("/dev/null/vectors").ok());
+
+    const float vec[3] = {1, 2, 3};
+    ASSERT_FALSE(file.put(0, vec));
+
+    vector_storage_t storage;
+    ASSERT_TRUE(parse_vector_storage("disk", storage));
+    ASSERT_EQ(disk_storage, storage);
+    ASSERT_FALSE(parse_vector_storage("ssd", storage));
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include "vector_quantizer.h"
+
+static float inner_product_distance(const std::vector<float>& a, const std::vector<float>& b) {
+    float dot = 0;
+    for(size_t i = 0; i < a.size(); i++) {
+        dot += a[i] * b[i];
+    }
+
+    return 1.0f - dot;
+}
+
+TEST(VectorQuantizerTest, KernelsMatchScalarProducts) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> code_dist(0, 255);
+
+    // sizes that exercise the vector loops and their tails
+    for(size_t num_codes: {0, 1, 15, 16, 17, 31, 32, 33, 100, 768, 1537}) {
+        std::vector<uint8_t> a(num_codes), b(num_codes);
+        for(size_t i = 0; i < num_codes; i++) {
+            a[i] = code_dist(rng);
+            b[i] = code_dist(rng);
+        }
+
+        ASSERT_EQ(sq8_space_t::dot_codes_scalar(a.data(), b.data(), num_codes),
+                  sq8_space_t::dot_codes(a.data(), b.data(), num_codes)) << sq8_space_t::kernel_name();
+    }
+
+    std::vector<uint8_t> max_codes(4096, 255);
+    ASSERT_EQ(4096u * 255 * 255, sq8_space_t::dot_codes(max_codes.data(), max_codes.data(), max_codes.size()));
+}
+
+TEST(VectorQuantizerTest, DistancesOfCodesFollowFloatDistances) {
+    const size_t num_dim = 77;
+    sq8_space_t space(num_dim);
+    ASSERT_EQ(80 + 3 * sizeof(float), space.get_data_size());
+
+    std::mt19937 rng(7);
+    std::normal_distribution<float> value_dist(0, 1);
+
+    auto make_vector = [&]() {
+        std::vector<float> values(num_dim);
+        float norm = 0;
+        for(auto& value: values) {
+            value = value_dist(rng);
+            norm += value * value;
+        }
+
+        for(auto& value: values) {
+            value /= std::sqrt(norm);
+        }
+
+        return values;
+    };
+
+    for(size_t i = 0; i < 50; i++) {
+        const auto a = make_vector();
+        const auto b = make_vector();
+
+        std::vector<uint8_t> record_a, record_b;
+        space.encode(a.data(), record_a);
+        space.encode(b.data(), record_b);
+        ASSERT_EQ(space.get_data_size(), record_a.size());
+
+        std::vector<float> decoded;
+        space.decode(record_a.data(), decoded);
+        ASSERT_EQ(num_dim, decoded.size());
+
+        for(size_t j = 0; j < num_dim; j++) {
+            // half of a step of the range of the vector
+            ASSERT_NEAR(a[j], decoded[j], 0.01);
+        }
+
+        ASSERT_NEAR(inner_product_distance(a, b),
+                    sq8_space_t::distance(record_a.data(), record_b.data(), space.get_dist_func_param()), 0.02);
+    }
+
+    // a vector of a single value has no range
+    std::vector<float> constant(num_dim, 0.5f);
+    std::vector<uint8_t> record;
+    space.encode(constant.data(), record);
+
+    std::vector<float> decoded;
+    space.decode(record.data(), decoded);
+    ASSERT_EQ(constant, decoded);
+}
+
+TEST(VectorQuantizerTest, ParseQuantization) {
+    vector_quantization_t quantization;
+
+    ASSERT_TRUE(parse_vector_quantization("sq8", quantization));
+    ASSERT_EQ(sq8, quantization);
+
+    ASSERT_TRUE(parse_vector_quantization("none", quantization));
+    ASSERT_EQ(no_quantization, quantization);
+
+    ASSERT_FALSE(parse_vector_quantization("pq", quantization));
+}
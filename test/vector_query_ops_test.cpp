@@ -74,3 +74,36 @@ TEST_F(VectorQueryOpsTest, ParseVectorQueryString) {
     ASSERT_FALSE(parsed.ok());
     ASSERT_EQ("Malformed vector query string.", parsed.error());
 }
+
+TEST_F(VectorQueryOpsTest, ParseSeveralQueryVectors) {
+    vector_query_t vector_query;
+    auto parsed = VectorQueryOps::parse_vector_query_str("vec:([[0.34, 0.66], [0.12, 0.68], [1, 0]], k: 10)",
+                                                         vector_query, false, nullptr, false);
+    ASSERT_TRUE(parsed.ok());
+    ASSERT_EQ("vec", vector_query.field_name);
+    ASSERT_EQ(10, vector_query.k);
+    ASSERT_EQ(3, vector_query.num_query_vectors());
+    ASSERT_EQ(std::vector<float>({0.34, 0.66}), vector_query.get_query_vector(0));
+    ASSERT_EQ(std::vector<float>({0.12, 0.68}), vector_query.get_query_vector(1));
+    ASSERT_EQ(std::vector<float>({1, 0}), vector_query.get_query_vector(2));
+
+    vector_query._reset();
+    parsed = VectorQueryOps::parse_vector_query_str("vec:([[0.34, 0.66]])", vector_query, false, nullptr, false);
+    ASSERT_TRUE(parsed.ok());
+    ASSERT_EQ(1, vector_query.num_query_vectors());
+
+    vector_query._reset();
+    parsed = VectorQueryOps::parse_vector_query_str("vec:([[0.34, 0.66], []])", vector_query, false, nullptr, false);
+    ASSERT_FALSE(parsed.ok());
+    ASSERT_EQ("Malformed vector query string: one of the query vectors is empty.", parsed.error());
+
+    vector_query._reset();
+    parsed = VectorQueryOps::parse_vector_query_str("vec:([[0.34, 0.66], 0.12])", vector_query, false, nullptr, false);
+    ASSERT_FALSE(parsed.ok());
+    ASSERT_EQ("Malformed vector query string.", parsed.error());
+
+    vector_query._reset();
+    parsed = VectorQueryOps::parse_vector_query_str("vec:([[0.34, 0.66], [0.12", vector_query, false, nullptr, false);
+    ASSERT_FALSE(parsed.ok());
+    ASSERT_EQ("Malformed vector query string.", parsed.error());
+}